@@ -0,0 +1,35 @@
+struct VSOut
+{
+    float4 position : SV_POSITION;
+    float4 color : COLOR;
+};
+
+cbuffer UniformBuffer : register(b0)
+{
+    float4 tint;
+};
+
+[[vk::push_constant]]
+struct PushConstants
+{
+    float4 offset;
+} constants;
+
+VSOut vs_main(uint vertexId : SV_VertexID)
+{
+    const float2 positions[] = {
+        {  0.0, -0.5 },
+        {  0.5,  0.5 },
+        { -0.5,  0.5 }
+    };
+
+    VSOut output;
+    output.position = float4(positions[vertexId % 3], 0.0, 1.0) + constants.offset;
+    output.color = tint;
+    return output;
+}
+
+float4 ps_main(VSOut input) : SV_TARGET
+{
+    return input.color;
+}
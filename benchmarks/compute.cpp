@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdlib>
+#include <fstream>
+
+using namespace sm;
+
+// Overhead per dispatch of the compute example's shader: the round trip of recording, submitting and waiting for one small
+// dispatch, waited on in different ways and on the graphics and async compute queues, and the sustained rate of chained
+// dispatches that each read the previous one's output behind a buffer_barrier().
+namespace
+{
+	constexpr std::uint32_t GRAPHICS_QUEUE = 0;
+	constexpr std::uint32_t COMPUTE_QUEUE = 1; // The graphics queue again on devices without a separate compute queue.
+	constexpr std::uint32_t ELEMENT_COUNT = 64; // One element per group.
+
+	struct BenchContext
+	{
+		gfx::DeviceHandle device{};
+		gfx::PipelineHandle pipeline{};
+		std::array<gfx::BufferHandle, 2> buffers{};
+		std::array<gfx::DescriptorSetHandle, 2> descriptorSets{}; // Set i reads buffers[i] and writes the other.
+		std::array<gfx::CommandListHandle, 2> commandLists{};	  // By queue.
+	} s_bench{};
+
+	auto read_shader_file(const char* filename) -> std::vector<char>
+	{
+		if (std::ifstream file{ filename, std::ios::binary | std::ios::ate })
+		{
+			const std::streamsize fileSize = file.tellg();
+			file.seekg(0);
+			std::vector<char> shaderBinary(fileSize);
+			file.read(shaderBinary.data(), fileSize);
+			return shaderBinary;
+		}
+
+		GFX_LOG_ERR_FMT("gfx_bench_compute - Failed to read shader file: {}", filename);
+		return {};
+	}
+
+	bool create_bench_context()
+	{
+		gfx::ComputePipelineInfo pipelineInfo{
+			.shaderCode = read_shader_file("compute.spv"),
+			.descriptorSets = {
+				gfx::DescriptorSetInfo{ .bindings = {
+											{ gfx::DescriptorType::eStorageBuffer, 1, gfx::ShaderStageFlags_Compute },
+											{ gfx::DescriptorType::eStorageBuffer, 1, gfx::ShaderStageFlags_Compute },
+										} },
+			},
+		};
+		if (!gfx::create_compute_pipeline(s_bench.pipeline, s_bench.device, pipelineInfo))
+		{
+			return false;
+		}
+
+		for (auto& bufferHandle : s_bench.buffers)
+		{
+			if (!gfx::create_buffer(bufferHandle, s_bench.device, { .type = gfx::BufferType::eStorage, .size = sizeof(std::int32_t) * ELEMENT_COUNT, .memory = gfx::BufferMemory::eGpuOnly }))
+			{
+				return false;
+			}
+		}
+		for (std::uint32_t i = 0; i < 2; ++i)
+		{
+			if (!gfx::create_descriptor_set_from_pipeline(s_bench.descriptorSets[i], s_bench.pipeline, 0))
+			{
+				return false;
+			}
+			gfx::bind_buffer_to_descriptor_set(s_bench.descriptorSets[i], 0, s_bench.buffers[i]);
+			gfx::bind_buffer_to_descriptor_set(s_bench.descriptorSets[i], 1, s_bench.buffers[1 - i]);
+		}
+
+		return gfx::create_command_list(s_bench.commandLists[GRAPHICS_QUEUE], s_bench.device, GRAPHICS_QUEUE) &&
+			   gfx::create_command_list(s_bench.commandLists[COMPUTE_QUEUE], s_bench.device, COMPUTE_QUEUE);
+	}
+
+	void destroy_bench_context()
+	{
+		gfx::wait_for_device_idle(s_bench.device);
+		for (const auto commandListHandle : s_bench.commandLists)
+		{
+			gfx::destroy_command_list(s_bench.device, commandListHandle);
+		}
+		for (std::uint32_t i = 0; i < 2; ++i)
+		{
+			gfx::destroy_descriptor_set(s_bench.descriptorSets[i]);
+			gfx::destroy_buffer(s_bench.buffers[i]);
+		}
+		gfx::destroy_pipeline(s_bench.pipeline);
+	}
+
+	/**
+	 * @brief Record dispatchCount dispatches, each reading what the one before wrote, and submit them.
+	 */
+	auto submit_dispatches(std::uint32_t queueIndex, std::uint32_t dispatchCount) -> gfx::SyncPoint
+	{
+		const auto commandListHandle = s_bench.commandLists[queueIndex];
+		gfx::reset(commandListHandle);
+		gfx::begin(commandListHandle);
+		gfx::bind_pipeline(commandListHandle, s_bench.pipeline);
+		for (std::uint32_t i = 0; i < dispatchCount; ++i)
+		{
+			if (i != 0)
+			{
+				gfx::buffer_barrier(commandListHandle, s_bench.buffers[i % 2], gfx::PipelineStageFlags_ComputeShader, gfx::PipelineStageFlags_ComputeShader);
+			}
+			gfx::bind_descriptor_sets(commandListHandle, 0, { &s_bench.descriptorSets[i % 2], 1 });
+			gfx::dispatch(commandListHandle, ELEMENT_COUNT, 1, 1);
+		}
+		gfx::end(commandListHandle);
+		return gfx::submit_command_list({ .commandList = commandListHandle });
+	}
+
+	enum class WaitMode
+	{
+		eSyncPoint,	 // Blocking wait on the submission's timeline semaphore value.
+		ePoll,		 // Spinning on is_sync_point_complete(), trading a core for wake-up latency.
+		eDeviceIdle, // vkDeviceWaitIdle(), the coarse wait of code without per-submission sync.
+	};
+
+	void wait(gfx::SyncPoint syncPoint, WaitMode waitMode)
+	{
+		switch (waitMode)
+		{
+			case WaitMode::eSyncPoint:
+				gfx::wait_on_sync_point(syncPoint);
+				break;
+			case WaitMode::ePoll:
+				while (!gfx::is_sync_point_complete(syncPoint))
+				{
+				}
+				break;
+			case WaitMode::eDeviceIdle:
+				gfx::wait_for_device_idle(s_bench.device);
+				break;
+		}
+	}
+
+	// Arguments: queue index, WaitMode.
+	void BM_dispatch_latency(benchmark::State& state)
+	{
+		const auto queueIndex = std::uint32_t(state.range(0));
+		const auto waitMode = WaitMode(state.range(1));
+		for (auto _ : state)
+		{
+			wait(submit_dispatches(queueIndex, 1), waitMode);
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+	BENCHMARK(BM_dispatch_latency)
+		->ArgNames({ "queue", "wait" })
+		->ArgsProduct({ { GRAPHICS_QUEUE, COMPUTE_QUEUE }, { int(WaitMode::eSyncPoint), int(WaitMode::ePoll), int(WaitMode::eDeviceIdle) } })
+		->UseRealTime();
+
+	// Arguments: queue index, chained dispatches per submission.
+	void BM_dispatch_throughput(benchmark::State& state)
+	{
+		const auto queueIndex = std::uint32_t(state.range(0));
+		const auto dispatchCount = std::uint32_t(state.range(1));
+		for (auto _ : state)
+		{
+			gfx::wait_on_sync_point(submit_dispatches(queueIndex, dispatchCount));
+		}
+		state.SetItemsProcessed(std::int64_t(state.iterations()) * dispatchCount);
+	}
+	BENCHMARK(BM_dispatch_throughput)
+		->ArgNames({ "queue", "dispatches" })
+		->ArgsProduct({ { GRAPHICS_QUEUE, COMPUTE_QUEUE }, { 16, 256, 4096 } })
+		->UseRealTime();
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+	{
+		return EXIT_FAILURE;
+	}
+
+	gfx::set_error_callback([](const char* msg) { GFX_LOG_ERR(msg); });
+
+	gfx::AppInfo appInfo{ .appName = "gfx_bench_compute", .headless = true, .debugLevel = gfx::DebugLevel::eOff };
+	if (!gfx::initialise(appInfo))
+	{
+		return EXIT_FAILURE;
+	}
+
+	gfx::DeviceInfo deviceInfo{
+		.deviceFlags = gfx::DeviceFlags_PreferDiscrete,
+		.queueFlags = { gfx::QueueFlags_Graphics, gfx::QueueFlags_Compute },
+	};
+	int result = EXIT_FAILURE;
+	if (gfx::create_device(s_bench.device, deviceInfo))
+	{
+		if (create_bench_context())
+		{
+			benchmark::RunSpecifiedBenchmarks();
+			result = EXIT_SUCCESS;
+		}
+		destroy_bench_context();
+		gfx::destroy_device(s_bench.device);
+	}
+
+	benchmark::Shutdown();
+	gfx::shutdown();
+
+	return result;
+}
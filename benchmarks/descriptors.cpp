@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+using namespace sm;
+
+// CPU cost per draw of each way of giving a draw its own descriptors: an object uniform (a range of one large buffer) and
+// a material uniform (one of MATERIAL_COUNT ranges of another). Every iteration records OBJECT_COUNT draws, each with the
+// strategy's writes and binds, into a command list that is never submitted; "per_draw" is the time per draw.
+// Each benchmark runs on a device with descriptor pools (descriptor_buffer:0) and one storing sets in a descriptor
+// buffer (descriptor_buffer:1), where supported. Strategies a device cannot do are skipped.
+namespace
+{
+	constexpr std::uint32_t OBJECT_COUNT = 1024;
+	constexpr std::uint32_t MATERIAL_COUNT = 16;
+	constexpr std::uint32_t UNIFORM_STRIDE = 256; // Covers any minUniformBufferOffsetAlignment.
+	constexpr std::uint32_t TARGET_SIZE = 64;
+
+	struct BenchDevice
+	{
+		bool valid{ false };
+		gfx::DeviceHandle device{};
+		gfx::CommandListHandle commandList{};
+		gfx::TextureHandle renderTarget{};
+		gfx::BufferHandle objectBuffer{};	// OBJECT_COUNT ranges of UNIFORM_STRIDE.
+		gfx::BufferHandle materialBuffer{}; // MATERIAL_COUNT ranges of UNIFORM_STRIDE.
+		std::vector<gfx::BufferHandle> objectStorageBuffers{}; // One per object, for the bindless heap.
+		std::vector<std::uint32_t> objectBindlessIndices{};
+
+		gfx::DescriptorSetInfo setInfo{};
+		gfx::PipelineHandle pipeline{};
+		gfx::PipelineHandle dynamicPipeline{}; // Invalid where dynamic descriptors are unavailable.
+		gfx::DescriptorSetHandle dynamicSet{};
+		gfx::PipelineHandle pushPipeline{}; // Invalid without VK_KHR_push_descriptor.
+		gfx::PipelineHandle bindlessPipeline{}; // Invalid without a bindless heap.
+
+		std::vector<gfx::DescriptorSetHandle> frameSets{}; // Persistent sets created during a frame, destroyed after it.
+	};
+	std::array<BenchDevice, 2> s_devices{}; // By descriptor_buffer argument.
+
+	auto read_shader_file(const char* filename) -> std::vector<std::uint32_t>
+	{
+		if (std::ifstream file{ filename, std::ios::binary | std::ios::ate })
+		{
+			const std::streamsize fileSize = file.tellg();
+			file.seekg(0);
+			std::vector<std::uint32_t> shaderBinary(fileSize / sizeof(std::uint32_t));
+			file.read(reinterpret_cast<char*>(shaderBinary.data()), fileSize);
+			return shaderBinary;
+		}
+
+		GFX_LOG_ERR_FMT("gfx_bench_descriptors - Failed to read shader file: {}", filename);
+		return {};
+	}
+
+	auto make_pipeline_info(const char* vertFilename, const char* fragFilename, const gfx::DescriptorSetInfo& setInfo) -> gfx::GraphicsPipelineInfo
+	{
+		return {
+			.vertexCode = read_shader_file(vertFilename),
+			.fragmentCode = read_shader_file(fragFilename),
+			.descriptorSets = { setInfo },
+			.depthTest = false,
+			.colorAttachments = { gfx::Format::eRGBA8 },
+			.debugName = "gfx_bench_descriptors",
+		};
+	}
+
+	bool create_bench_device(BenchDevice& bench, bool descriptorBuffer)
+	{
+		gfx::DeviceInfo deviceInfo{
+			.deviceFlags = gfx::DeviceFlags_PreferDiscrete,
+			.queueFlags = { gfx::QueueFlags_Graphics },
+			.bindlessTextureCount = 16,
+			.bindlessSamplerCount = 16,
+			.bindlessStorageBufferCount = OBJECT_COUNT,
+			.descriptorBufferSize = descriptorBuffer ? 64ull * 1024 * 1024 : 0,
+		};
+		if (!gfx::create_device(bench.device, deviceInfo))
+		{
+			return false;
+		}
+		bench.valid = true;
+
+		gfx::TextureInfo renderTargetInfo{
+			.usage = gfx::TextureUsage::eColorAttachment,
+			.type = gfx::TextureType::e2D,
+			.width = TARGET_SIZE,
+			.height = TARGET_SIZE,
+			.format = gfx::Format::eRGBA8,
+		};
+		if (!gfx::create_command_list(bench.commandList, bench.device, 0) ||
+			!gfx::create_texture(bench.renderTarget, bench.device, renderTargetInfo) ||
+			!gfx::create_buffer(bench.objectBuffer, bench.device, { .type = gfx::BufferType::eUniform, .size = std::uint64_t(UNIFORM_STRIDE) * OBJECT_COUNT }) ||
+			!gfx::create_buffer(bench.materialBuffer, bench.device, { .type = gfx::BufferType::eUniform, .size = std::uint64_t(UNIFORM_STRIDE) * MATERIAL_COUNT }))
+		{
+			return false;
+		}
+
+		bench.setInfo = { .bindings = {
+							  { gfx::DescriptorType::eUniformBuffer, 1, gfx::ShaderStageFlags_Vertex },
+							  { gfx::DescriptorType::eUniformBuffer, 1, gfx::ShaderStageFlags_Vertex },
+						  } };
+		if (!gfx::create_graphics_pipeline(bench.pipeline, bench.device, make_pipeline_info("descriptors.vert.spv", "descriptors.frag.spv", bench.setInfo)))
+		{
+			return false;
+		}
+
+		// The optional strategies, failing quietly on devices without them.
+		const gfx::DescriptorSetInfo dynamicSetInfo{ .bindings = {
+														 { gfx::DescriptorType::eUniformBufferDynamic, 1, gfx::ShaderStageFlags_Vertex },
+														 { gfx::DescriptorType::eUniformBufferDynamic, 1, gfx::ShaderStageFlags_Vertex },
+													 } };
+		if (!descriptorBuffer && gfx::create_graphics_pipeline(bench.dynamicPipeline, bench.device, make_pipeline_info("descriptors.vert.spv", "descriptors.frag.spv", dynamicSetInfo)) &&
+			gfx::create_descriptor_set_from_pipeline(bench.dynamicSet, bench.dynamicPipeline, 0))
+		{
+			gfx::bind_buffer_to_descriptor_set(bench.dynamicSet, 0, bench.objectBuffer, 0, UNIFORM_STRIDE);
+			gfx::bind_buffer_to_descriptor_set(bench.dynamicSet, 1, bench.materialBuffer, 0, UNIFORM_STRIDE);
+		}
+
+		auto pushSetInfo = bench.setInfo;
+		pushSetInfo.push = true;
+		gfx::create_graphics_pipeline(bench.pushPipeline, bench.device, make_pipeline_info("descriptors.vert.spv", "descriptors.frag.spv", pushSetInfo));
+
+		if (std::uint64_t(gfx::get_bindless_heap(bench.device)) != 0)
+		{
+			auto bindlessInfo = make_pipeline_info("descriptors_bindless.vert.spv", "descriptors_bindless.frag.spv", { .bindlessHeap = true });
+			bindlessInfo.constantBlock = { sizeof(std::uint32_t), gfx::ShaderStageFlags_Vertex };
+			bench.objectStorageBuffers.resize(OBJECT_COUNT);
+			bench.objectBindlessIndices.resize(OBJECT_COUNT);
+			for (std::uint32_t i = 0; i < OBJECT_COUNT; ++i)
+			{
+				if (!gfx::create_buffer(bench.objectStorageBuffers[i], bench.device, { .type = gfx::BufferType::eStorage, .size = sizeof(float) * 8 }))
+				{
+					return false;
+				}
+				bench.objectBindlessIndices[i] = gfx::get_buffer_bindless_index(bench.objectStorageBuffers[i]);
+			}
+			gfx::create_graphics_pipeline(bench.bindlessPipeline, bench.device, bindlessInfo);
+		}
+		return true;
+	}
+
+	void destroy_bench_device(BenchDevice& bench)
+	{
+		if (!bench.valid)
+		{
+			return;
+		}
+
+		gfx::wait_for_device_idle(bench.device);
+		for (const auto pipelineHandle : { bench.bindlessPipeline, bench.pushPipeline, bench.dynamicPipeline, bench.pipeline })
+		{
+			if (std::uint64_t(pipelineHandle) != 0)
+			{
+				gfx::destroy_pipeline(pipelineHandle);
+			}
+		}
+		if (std::uint64_t(bench.dynamicSet) != 0)
+		{
+			gfx::destroy_descriptor_set(bench.dynamicSet);
+		}
+		for (const auto bufferHandle : bench.objectStorageBuffers)
+		{
+			gfx::destroy_buffer(bufferHandle);
+		}
+		for (const auto bufferHandle : { bench.materialBuffer, bench.objectBuffer })
+		{
+			if (std::uint64_t(bufferHandle) != 0)
+			{
+				gfx::destroy_buffer(bufferHandle);
+			}
+		}
+		if (std::uint64_t(bench.renderTarget) != 0)
+		{
+			gfx::destroy_texture(bench.renderTarget);
+		}
+		if (std::uint64_t(bench.commandList) != 0)
+		{
+			gfx::destroy_command_list(bench.device, bench.commandList);
+		}
+		gfx::destroy_device(bench.device);
+		bench = {};
+	}
+
+	auto make_writes(const BenchDevice& bench, std::uint32_t object) -> std::array<gfx::DescriptorWrite, 2>
+	{
+		return { {
+			{ .binding = 0, .bufferHandle = bench.objectBuffer, .offset = std::uint64_t(object) * UNIFORM_STRIDE, .range = UNIFORM_STRIDE },
+			{ .binding = 1, .bufferHandle = bench.materialBuffer, .offset = std::uint64_t(object % MATERIAL_COUNT) * UNIFORM_STRIDE, .range = UNIFORM_STRIDE },
+		} };
+	}
+
+	/**
+	 * @brief Time recording OBJECT_COUNT draws per iteration, bound by pipelineHandle and record_draw(bench, commandList, i).
+	 * Each iteration is a frame of its own, so transient sets are reclaimed and persistent ones created during it destroyed.
+	 * Beginning and ending the frame, command list and render pass is left out of the timings.
+	 */
+	template <typename RecordFunc>
+	void record_draws(benchmark::State& state, gfx::PipelineHandle BenchDevice::*pipeline, RecordFunc&& record_draw)
+	{
+		auto& bench = s_devices[state.range(0)];
+		if (!bench.valid || std::uint64_t(bench.*pipeline) == 0)
+		{
+			state.SkipWithError("Not supported by the device");
+			return;
+		}
+
+		const auto commandListHandle = bench.commandList;
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			gfx::begin_frame(bench.device);
+			gfx::reset(commandListHandle);
+			gfx::begin(commandListHandle);
+			gfx::transition_texture(commandListHandle, bench.renderTarget, gfx::TextureState::eRenderTarget);
+			gfx::begin_render_pass(commandListHandle, { .colorAttachments = { bench.renderTarget } });
+			gfx::set_viewport(commandListHandle, 0, 0, TARGET_SIZE, TARGET_SIZE);
+			gfx::set_scissor(commandListHandle, 0, 0, TARGET_SIZE, TARGET_SIZE);
+			gfx::bind_pipeline(commandListHandle, bench.*pipeline);
+			state.ResumeTiming();
+
+			for (std::uint32_t i = 0; i < OBJECT_COUNT; ++i)
+			{
+				record_draw(bench, commandListHandle, i);
+				gfx::draw(commandListHandle, 3, 1, 0, 0);
+			}
+			for (const auto descriptorSetHandle : bench.frameSets)
+			{
+				gfx::destroy_descriptor_set(descriptorSetHandle);
+			}
+			bench.frameSets.clear();
+
+			state.PauseTiming();
+			gfx::end_render_pass(commandListHandle);
+			gfx::end(commandListHandle);
+			gfx::end_frame(bench.device);
+			state.ResumeTiming();
+		}
+		state.SetItemsProcessed(std::int64_t(state.iterations()) * OBJECT_COUNT);
+		state.counters["per_draw"] = benchmark::Counter(double(OBJECT_COUNT), benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+	}
+
+	// A persistent set per object per frame, written a binding at a time: what the examples do.
+	void BM_create_set_per_object(benchmark::State& state)
+	{
+		record_draws(state, &BenchDevice::pipeline, [](BenchDevice& bench, gfx::CommandListHandle commandListHandle, std::uint32_t i) {
+			gfx::DescriptorSetHandle descriptorSetHandle{};
+			gfx::create_descriptor_set_from_pipeline(descriptorSetHandle, bench.pipeline, 0);
+			gfx::bind_buffer_to_descriptor_set(descriptorSetHandle, 0, bench.objectBuffer, std::uint64_t(i) * UNIFORM_STRIDE, UNIFORM_STRIDE);
+			gfx::bind_buffer_to_descriptor_set(descriptorSetHandle, 1, bench.materialBuffer, std::uint64_t(i % MATERIAL_COUNT) * UNIFORM_STRIDE, UNIFORM_STRIDE);
+			gfx::bind_descriptor_sets(commandListHandle, 0, { &descriptorSetHandle, 1 });
+			bench.frameSets.push_back(descriptorSetHandle);
+		});
+	}
+	BENCHMARK(BM_create_set_per_object)->ArgName("descriptor_buffer")->DenseRange(0, 1);
+
+	// A transient set per object, written a binding at a time.
+	void BM_transient_set_per_binding(benchmark::State& state)
+	{
+		record_draws(state, &BenchDevice::pipeline, [](BenchDevice& bench, gfx::CommandListHandle commandListHandle, std::uint32_t i) {
+			gfx::DescriptorSetHandle descriptorSetHandle{};
+			gfx::create_transient_descriptor_set(descriptorSetHandle, bench.device, bench.setInfo);
+			gfx::bind_buffer_to_descriptor_set(descriptorSetHandle, 0, bench.objectBuffer, std::uint64_t(i) * UNIFORM_STRIDE, UNIFORM_STRIDE);
+			gfx::bind_buffer_to_descriptor_set(descriptorSetHandle, 1, bench.materialBuffer, std::uint64_t(i % MATERIAL_COUNT) * UNIFORM_STRIDE, UNIFORM_STRIDE);
+			gfx::bind_descriptor_sets(commandListHandle, 0, { &descriptorSetHandle, 1 });
+		});
+	}
+	BENCHMARK(BM_transient_set_per_binding)->ArgName("descriptor_buffer")->DenseRange(0, 1);
+
+	// A transient set per object, written in one update_descriptor_set(), which covering the set uses an update template.
+	void BM_transient_set_batched(benchmark::State& state)
+	{
+		record_draws(state, &BenchDevice::pipeline, [](BenchDevice& bench, gfx::CommandListHandle commandListHandle, std::uint32_t i) {
+			gfx::DescriptorSetHandle descriptorSetHandle{};
+			gfx::create_transient_descriptor_set(descriptorSetHandle, bench.device, bench.setInfo);
+			const auto writes = make_writes(bench, i);
+			gfx::update_descriptor_set(descriptorSetHandle, writes);
+			gfx::bind_descriptor_sets(commandListHandle, 0, { &descriptorSetHandle, 1 });
+		});
+	}
+	BENCHMARK(BM_transient_set_batched)->ArgName("descriptor_buffer")->DenseRange(0, 1);
+
+	// get_cached_descriptor_set(), which after the first frame finds every object's set already written.
+	void BM_cached_set(benchmark::State& state)
+	{
+		record_draws(state, &BenchDevice::pipeline, [](BenchDevice& bench, gfx::CommandListHandle commandListHandle, std::uint32_t i) {
+			gfx::DescriptorSetHandle descriptorSetHandle{};
+			const auto writes = make_writes(bench, i);
+			gfx::get_cached_descriptor_set(descriptorSetHandle, bench.device, bench.setInfo, writes);
+			gfx::bind_descriptor_sets(commandListHandle, 0, { &descriptorSetHandle, 1 });
+		});
+	}
+	BENCHMARK(BM_cached_set)->ArgName("descriptor_buffer")->DenseRange(0, 1);
+
+	// push_descriptors() of both bindings, with no set at all.
+	void BM_push_descriptors(benchmark::State& state)
+	{
+		record_draws(state, &BenchDevice::pushPipeline, [](BenchDevice& bench, gfx::CommandListHandle commandListHandle, std::uint32_t i) {
+			const auto writes = make_writes(bench, i);
+			gfx::push_descriptors(commandListHandle, 0, writes);
+		});
+	}
+	BENCHMARK(BM_push_descriptors)->ArgName("descriptor_buffer")->DenseRange(0, 1);
+
+	// One set of dynamic uniform buffers, rebound with each object's offsets.
+	void BM_dynamic_offsets(benchmark::State& state)
+	{
+		record_draws(state, &BenchDevice::dynamicPipeline, [](BenchDevice& bench, gfx::CommandListHandle commandListHandle, std::uint32_t i) {
+			const std::array<std::uint32_t, 2> dynamicOffsets{ i * UNIFORM_STRIDE, (i % MATERIAL_COUNT) * UNIFORM_STRIDE };
+			gfx::bind_descriptor_sets(commandListHandle, 0, { &bench.dynamicSet, 1 }, dynamicOffsets);
+		});
+	}
+	BENCHMARK(BM_dynamic_offsets)->ArgName("descriptor_buffer")->DenseRange(0, 1);
+
+	// The bindless heap, bound once per frame as it would be, and each object's storage buffer index as a constant.
+	void BM_bindless(benchmark::State& state)
+	{
+		record_draws(state, &BenchDevice::bindlessPipeline, [](BenchDevice& bench, gfx::CommandListHandle commandListHandle, std::uint32_t i) {
+			if (i == 0)
+			{
+				const auto heapHandle = gfx::get_bindless_heap(bench.device);
+				gfx::bind_descriptor_sets(commandListHandle, 0, { &heapHandle, 1 });
+			}
+			gfx::set_constants(commandListHandle, gfx::ShaderStageFlags_Vertex, 0, sizeof(std::uint32_t), &bench.objectBindlessIndices[i]);
+		});
+	}
+	BENCHMARK(BM_bindless)->ArgName("descriptor_buffer")->DenseRange(0, 1);
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+	{
+		return EXIT_FAILURE;
+	}
+
+	gfx::set_error_callback([](const char* msg) { GFX_LOG_ERR(msg); });
+
+	gfx::AppInfo appInfo{ .appName = "gfx_bench_descriptors", .headless = true, .debugLevel = gfx::DebugLevel::eOff };
+	if (!gfx::initialise(appInfo))
+	{
+		return EXIT_FAILURE;
+	}
+
+	int result = EXIT_FAILURE;
+	if (create_bench_device(s_devices[0], false))
+	{
+		// Without descriptor buffer support the device falls back to pools, and its results match the first's.
+		create_bench_device(s_devices[1], true);
+		benchmark::RunSpecifiedBenchmarks();
+		result = EXIT_SUCCESS;
+	}
+	for (auto& bench : s_devices)
+	{
+		destroy_bench_device(bench);
+	}
+
+	benchmark::Shutdown();
+	gfx::shutdown();
+
+	return result;
+}
@@ -0,0 +1,36 @@
+struct VSOut
+{
+    float4 position : SV_POSITION;
+    float4 color : COLOR;
+};
+
+[[vk::binding(0, 0)]]
+cbuffer ObjectData
+{
+    float4 offset;
+};
+
+[[vk::binding(1, 0)]]
+cbuffer MaterialData
+{
+    float4 color;
+};
+
+VSOut vs_main(uint vertexId : SV_VertexID)
+{
+    const float2 positions[] = {
+        {  0.0, -0.5 },
+        {  0.5,  0.5 },
+        { -0.5,  0.5 }
+    };
+
+    VSOut output;
+    output.position = float4(positions[vertexId % 3], 0.0, 1.0) + offset;
+    output.color = color;
+    return output;
+}
+
+float4 ps_main(VSOut input) : SV_TARGET
+{
+    return input.color;
+}
@@ -0,0 +1,41 @@
+struct VSOut
+{
+    float4 position : SV_POSITION;
+    float4 color : COLOR;
+};
+
+struct ObjectData
+{
+    float4 offset;
+    float4 color;
+};
+
+// The storage buffer array of the device's bindless heap, see gfx::BindlessStorageBufferBinding.
+[[vk::binding(2, 0)]] StructuredBuffer<ObjectData> Objects[];
+
+[[vk::push_constant]]
+struct PushConstants
+{
+    uint objectIndex;
+} constants;
+
+VSOut vs_main(uint vertexId : SV_VertexID)
+{
+    const float2 positions[] = {
+        {  0.0, -0.5 },
+        {  0.5,  0.5 },
+        { -0.5,  0.5 }
+    };
+
+    const ObjectData object = Objects[constants.objectIndex][0];
+
+    VSOut output;
+    output.position = float4(positions[vertexId % 3], 0.0, 1.0) + object.offset;
+    output.color = object.color;
+    return output;
+}
+
+float4 ps_main(VSOut input) : SV_TARGET
+{
+    return input.color;
+}
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdlib>
+#include <fstream>
+
+using namespace sm;
+
+namespace
+{
+	constexpr std::uint32_t COMMANDS_PER_ITERATION = 1024; // Recorded between resets, so command buffer growth is amortised the same way as in a frame.
+	constexpr std::uint32_t TARGET_SIZE = 64;
+
+	struct BenchContext
+	{
+		bool hasDevice{ false };
+		gfx::DeviceHandle device{};
+		gfx::CommandListHandle commandList{};
+		gfx::PipelineHandle pipeline{};
+		gfx::DescriptorSetHandle descriptorSet{};
+		gfx::BufferHandle uniformBuffer{};
+		gfx::BufferHandle indexBuffer{};
+		gfx::TextureHandle renderTarget{};
+		gfx::TextureHandle texture{};
+	} s_bench{};
+
+	auto read_shader_file(const char* filename) -> std::vector<std::uint32_t>
+	{
+		if (std::ifstream file{ filename, std::ios::binary | std::ios::ate })
+		{
+			const std::streamsize fileSize = file.tellg();
+			file.seekg(0);
+			std::vector<std::uint32_t> shaderBinary(fileSize / sizeof(std::uint32_t));
+			file.read(reinterpret_cast<char*>(shaderBinary.data()), fileSize);
+			return shaderBinary;
+		}
+
+		GFX_LOG_ERR_FMT("gfx_bench - Failed to read shader file: {}", filename);
+		return {};
+	}
+
+	bool create_bench_context()
+	{
+		gfx::DeviceInfo deviceInfo{
+			.deviceFlags = gfx::DeviceFlags_PreferDiscrete,
+			.queueFlags = { gfx::QueueFlags_Graphics },
+		};
+		if (!gfx::create_device(s_bench.device, deviceInfo))
+		{
+			return false;
+		}
+		s_bench.hasDevice = true;
+
+		if (!gfx::create_command_list(s_bench.commandList, s_bench.device, 0))
+		{
+			return false;
+		}
+
+		const auto vertShaderBinary = read_shader_file("bench.vert.spv");
+		const auto fragShaderBinary = read_shader_file("bench.frag.spv");
+		gfx::GraphicsPipelineInfo pipelineInfo{
+			.vertexCode = vertShaderBinary,
+			.fragmentCode = fragShaderBinary,
+			.descriptorSets = {
+				gfx::DescriptorSetInfo{ .bindings = {
+											{ gfx::DescriptorType::eUniformBuffer, 1, gfx::ShaderStageFlags_Vertex },
+										} },
+			},
+			.constantBlock = { sizeof(float) * 4, gfx::ShaderStageFlags_Vertex },
+			.depthTest = false,
+			.colorAttachments = { gfx::Format::eRGBA8 },
+			.debugName = "gfx_bench",
+		};
+		if (!gfx::create_graphics_pipeline(s_bench.pipeline, s_bench.device, pipelineInfo))
+		{
+			return false;
+		}
+
+		if (!gfx::create_buffer(s_bench.uniformBuffer, s_bench.device, { .type = gfx::BufferType::eUniform, .size = sizeof(float) * 4 }))
+		{
+			return false;
+		}
+		if (!gfx::create_buffer(s_bench.indexBuffer, s_bench.device, { .type = gfx::BufferType::eIndex, .size = sizeof(std::uint32_t) * 3 }))
+		{
+			return false;
+		}
+		if (!gfx::create_descriptor_set(s_bench.descriptorSet, s_bench.device, pipelineInfo.descriptorSets[0]))
+		{
+			return false;
+		}
+		gfx::bind_buffer_to_descriptor_set(s_bench.descriptorSet, 0, s_bench.uniformBuffer);
+
+		gfx::TextureInfo renderTargetInfo{
+			.usage = gfx::TextureUsage::eColorAttachment,
+			.type = gfx::TextureType::e2D,
+			.width = TARGET_SIZE,
+			.height = TARGET_SIZE,
+			.format = gfx::Format::eRGBA8,
+		};
+		if (!gfx::create_texture(s_bench.renderTarget, s_bench.device, renderTargetInfo))
+		{
+			return false;
+		}
+		gfx::TextureInfo textureInfo{
+			.usage = gfx::TextureUsage::eTexture,
+			.type = gfx::TextureType::e2D,
+			.width = TARGET_SIZE,
+			.height = TARGET_SIZE,
+			.format = gfx::Format::eRGBA8,
+		};
+		return gfx::create_texture(s_bench.texture, s_bench.device, textureInfo);
+	}
+
+	void destroy_bench_context()
+	{
+		if (!s_bench.hasDevice)
+		{
+			return;
+		}
+
+		gfx::wait_for_device_idle(s_bench.device);
+		gfx::destroy_texture(s_bench.texture);
+		gfx::destroy_texture(s_bench.renderTarget);
+		gfx::destroy_descriptor_set(s_bench.descriptorSet);
+		gfx::destroy_buffer(s_bench.indexBuffer);
+		gfx::destroy_buffer(s_bench.uniformBuffer);
+		gfx::destroy_pipeline(s_bench.pipeline);
+		gfx::destroy_command_list(s_bench.device, s_bench.commandList);
+		gfx::destroy_device(s_bench.device);
+		s_bench = {};
+	}
+
+	// The command list is never submitted, only the CPU cost of recording into it is measured.
+	void begin_recording(bool inRenderPass)
+	{
+		gfx::reset(s_bench.commandList);
+		gfx::begin(s_bench.commandList);
+		if (!inRenderPass)
+		{
+			return;
+		}
+
+		gfx::transition_texture(s_bench.commandList, s_bench.renderTarget, gfx::TextureState::eRenderTarget);
+		gfx::begin_render_pass(s_bench.commandList, { .colorAttachments = { s_bench.renderTarget } });
+		gfx::set_viewport(s_bench.commandList, 0, 0, TARGET_SIZE, TARGET_SIZE);
+		gfx::set_scissor(s_bench.commandList, 0, 0, TARGET_SIZE, TARGET_SIZE);
+		gfx::bind_pipeline(s_bench.commandList, s_bench.pipeline);
+		gfx::bind_descriptor_sets(s_bench.commandList, 0, { &s_bench.descriptorSet, 1 });
+		gfx::bind_index_buffer(s_bench.commandList, s_bench.indexBuffer, gfx::IndexType::eUInt32);
+	}
+
+	void end_recording(bool inRenderPass)
+	{
+		if (inRenderPass)
+		{
+			gfx::end_render_pass(s_bench.commandList);
+		}
+		gfx::end(s_bench.commandList);
+	}
+
+	/**
+	 * @brief Time COMMANDS_PER_ITERATION calls of record(i) per iteration. Resetting and beginning the command list (and its
+	 * render pass) is left out of the timings.
+	 */
+	template <typename RecordFunc>
+	void record_commands(benchmark::State& state, bool inRenderPass, RecordFunc&& record)
+	{
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			begin_recording(inRenderPass);
+			state.ResumeTiming();
+
+			for (std::uint32_t i = 0; i < COMMANDS_PER_ITERATION; ++i)
+			{
+				record(i);
+			}
+
+			state.PauseTiming();
+			end_recording(inRenderPass);
+			state.ResumeTiming();
+		}
+		state.SetItemsProcessed(std::int64_t(state.iterations()) * COMMANDS_PER_ITERATION);
+	}
+
+	void BM_draw(benchmark::State& state)
+	{
+		record_commands(state, true, [](std::uint32_t i) { gfx::draw(s_bench.commandList, 3, 1, 0, i); });
+	}
+	BENCHMARK(BM_draw);
+
+	void BM_draw_indexed(benchmark::State& state)
+	{
+		record_commands(state, true, [](std::uint32_t i) { gfx::draw_indexed(s_bench.commandList, 3, 1, 0, 0, i); });
+	}
+	BENCHMARK(BM_draw_indexed);
+
+	void BM_bind_pipeline(benchmark::State& state)
+	{
+		record_commands(state, true, [](std::uint32_t) { gfx::bind_pipeline(s_bench.commandList, s_bench.pipeline); });
+	}
+	BENCHMARK(BM_bind_pipeline);
+
+	void BM_bind_descriptor_sets(benchmark::State& state)
+	{
+		record_commands(state, true, [](std::uint32_t) { gfx::bind_descriptor_sets(s_bench.commandList, 0, { &s_bench.descriptorSet, 1 }); });
+	}
+	BENCHMARK(BM_bind_descriptor_sets);
+
+	void BM_set_constants(benchmark::State& state)
+	{
+		record_commands(state, true, [](std::uint32_t i) {
+			const std::array<float, 4> offset{ float(i), 0.0f, 0.0f, 0.0f };
+			gfx::set_constants(s_bench.commandList, gfx::ShaderStageFlags_Vertex, 0, sizeof(offset), offset.data());
+		});
+	}
+	BENCHMARK(BM_set_constants);
+
+	void BM_transition_texture(benchmark::State& state)
+	{
+		// Alternates so every call is a real transition, its barrier flushed with the rest when the command list ends.
+		record_commands(state, false, [](std::uint32_t i) {
+			gfx::transition_texture(s_bench.commandList, s_bench.texture, (i % 2) == 0 ? gfx::TextureState::eUploadDst : gfx::TextureState::eShaderRead);
+		});
+	}
+	BENCHMARK(BM_transition_texture);
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+	{
+		return EXIT_FAILURE;
+	}
+
+	gfx::set_error_callback([](const char* msg) { GFX_LOG_ERR(msg); });
+
+	// Validation would dominate the timings.
+	gfx::AppInfo appInfo{ .appName = "gfx_bench", .headless = true, .debugLevel = gfx::DebugLevel::eOff };
+	if (!gfx::initialise(appInfo))
+	{
+		return EXIT_FAILURE;
+	}
+
+	int result = EXIT_FAILURE;
+	if (create_bench_context())
+	{
+		benchmark::RunSpecifiedBenchmarks();
+		result = EXIT_SUCCESS;
+	}
+
+	destroy_bench_context();
+	benchmark::Shutdown();
+	gfx::shutdown();
+
+	return result;
+}
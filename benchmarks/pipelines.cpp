@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Time to create pipelineCount graphics pipeline variants of the model_rendering example's shaders:
+// - cold:  on a new device with no pipeline cache file.
+// - warm:  on a new device loading the cache file the cold device saved.
+// - link:  variants differing only in their fragment output state, after one variant has compiled the shader parts. With
+//          VK_EXT_graphics_pipeline_library this is the fast-link time, otherwise each is a full compile.
+// - async: create_graphics_pipeline_async() on new devices with 1, 2, 4... worker threads, until every pipeline is ready.
+// Drivers keep their own shader caches on disk, which make "cold" runs after the first warm; disable them for cold numbers
+// (e.g. MESA_SHADER_CACHE_DISABLE=true, __GL_SHADER_DISK_CACHE=0).
+// Usage: gfx_bench_pipelines [pipelineCount=64]
+
+using namespace sm;
+
+namespace
+{
+	constexpr const char* PIPELINE_CACHE_PATH = "gfx_bench_pipelines.cache";
+
+	auto read_shader_file(const char* filename) -> std::vector<std::uint32_t>
+	{
+		if (std::ifstream file{ filename, std::ios::binary | std::ios::ate })
+		{
+			const std::streamsize fileSize = file.tellg();
+			file.seekg(0);
+			std::vector<std::uint32_t> shaderBinary(fileSize / sizeof(std::uint32_t));
+			file.read(reinterpret_cast<char*>(shaderBinary.data()), fileSize);
+			return shaderBinary;
+		}
+
+		GFX_LOG_ERR_FMT("gfx_bench_pipelines - Failed to read shader file: {}", filename);
+		return {};
+	}
+
+	auto make_base_pipeline_info() -> gfx::GraphicsPipelineInfo
+	{
+		return {
+			.vertexCode = read_shader_file("model.vert.spv"),
+			.fragmentCode = read_shader_file("model.frag.spv"),
+			.vertexInputBindings = {
+				{ "Vertex", { { "Position", 0, gfx::Format::eRGB32 }, { "Normal", 1, gfx::Format::eRGB32 } } },
+			},
+			.descriptorSets = {
+				gfx::DescriptorSetInfo{ .bindings = {
+											{ gfx::DescriptorType::eUniformBuffer, 1, gfx::ShaderStageFlags_Vertex },
+										} },
+			},
+			.constantBlock = { sizeof(float) * 16, gfx::ShaderStageFlags_Vertex },
+			.depthTest = true,
+			.colorAttachments = { gfx::Format::eRGBA8 },
+			.depthAttachmentFormat = gfx::Format::eDepth16,
+		};
+	}
+
+	// Distinct in their rasterization and depth state, and in a (shader-unused) specialization constant past the first 24.
+	auto make_compile_variants(std::uint32_t count) -> std::vector<gfx::GraphicsPipelineInfo>
+	{
+		constexpr std::array cullModes{ gfx::CullMode::eNone, gfx::CullMode::eFront, gfx::CullMode::eBack };
+		constexpr std::array compareOps{ gfx::CompareOp::eLess, gfx::CompareOp::eLessOrEqual, gfx::CompareOp::eGreater, gfx::CompareOp::eGreaterOrEqual };
+
+		const auto baseInfo = make_base_pipeline_info();
+		std::vector<gfx::GraphicsPipelineInfo> variants(count, baseInfo);
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			auto& info = variants[i];
+			info.cullMode = cullModes[i % 3];
+			info.frontFace = (i / 3) % 2 == 0 ? gfx::FrontFace::eClockwise : gfx::FrontFace::eCounterClockwise;
+			info.depthCompareOp = compareOps[(i / 6) % 4];
+			info.fragmentSpecializationConstants = { { 0, i / 24 } };
+		}
+		return variants;
+	}
+
+	// Distinct only in their blend state, so they share every part but the fragment output interface. At most 120.
+	auto make_link_variants(std::uint32_t count) -> std::vector<gfx::GraphicsPipelineInfo>
+	{
+		constexpr std::array srcFactors{ gfx::BlendFactor::eOne, gfx::BlendFactor::eSrcAlpha, gfx::BlendFactor::eSrcColor, gfx::BlendFactor::eDstColor };
+
+		const auto baseInfo = make_base_pipeline_info();
+		std::vector<gfx::GraphicsPipelineInfo> variants(std::min(count, 120u), baseInfo);
+		for (std::uint32_t i = 0; i < variants.size(); ++i)
+		{
+			variants[i].colorBlendStates = { gfx::BlendState{
+				.blendEnable = (i / 60) % 2 == 1,
+				.srcColorFactor = srcFactors[(i / 15) % 4],
+				.colorWriteMask = 1 + i % 15,
+			} };
+		}
+		return variants;
+	}
+
+	struct BenchDevice
+	{
+		gfx::DeviceHandle deviceHandle{};
+		bool valid{ false };
+
+		BenchDevice(const char* pipelineCachePath, std::uint32_t workerThreadCount)
+		{
+			gfx::DeviceInfo deviceInfo{
+				.deviceFlags = gfx::DeviceFlags_PreferDiscrete,
+				.queueFlags = { gfx::QueueFlags_Graphics },
+				.pipelineCachePath = pipelineCachePath,
+				.workerThreadCount = workerThreadCount,
+			};
+			valid = gfx::create_device(deviceHandle, deviceInfo);
+		}
+		~BenchDevice()
+		{
+			if (valid)
+			{
+				gfx::destroy_device(deviceHandle); // Saves the pipeline cache, once background compiles have finished.
+			}
+		}
+	};
+
+	/**
+	 * @return Milliseconds until every pipeline was created, and for async ones, ready.
+	 */
+	auto create_pipelines(gfx::DeviceHandle deviceHandle, const std::vector<gfx::GraphicsPipelineInfo>& variants, bool async) -> double
+	{
+		std::vector<gfx::PipelineHandle> pipelineHandles(variants.size());
+
+		const auto start = std::chrono::steady_clock::now();
+		for (std::uint32_t i = 0; i < variants.size(); ++i)
+		{
+			const bool created = async ? gfx::create_graphics_pipeline_async(pipelineHandles[i], deviceHandle, variants[i])
+									   : gfx::create_graphics_pipeline(pipelineHandles[i], deviceHandle, variants[i]);
+			if (!created)
+			{
+				return -1.0;
+			}
+		}
+		for (const auto pipelineHandle : pipelineHandles)
+		{
+			while (!gfx::is_pipeline_ready(pipelineHandle))
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+			}
+		}
+		const auto totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		for (const auto pipelineHandle : pipelineHandles)
+		{
+			gfx::destroy_pipeline(pipelineHandle);
+		}
+		return totalMs;
+	}
+
+	void report(const char* phase, std::uint32_t threadCount, std::size_t pipelineCount, double totalMs)
+	{
+		std::cout << phase;
+		if (threadCount != 0)
+		{
+			std::cout << " (" << threadCount << " threads)";
+		}
+		if (totalMs < 0.0)
+		{
+			std::cout << ": failed" << std::endl;
+			return;
+		}
+		std::cout << ": " << pipelineCount << " pipelines in " << totalMs << " ms, " << (totalMs / double(pipelineCount)) << " ms each" << std::endl;
+	}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	const std::uint32_t pipelineCount = argc > 1 ? std::max(1, std::atoi(argv[1])) : 64;
+
+	gfx::set_error_callback([](const char* msg) { GFX_LOG_ERR(msg); });
+
+	gfx::AppInfo appInfo{ .appName = "gfx_bench_pipelines", .headless = true, .debugLevel = gfx::DebugLevel::eOff };
+	if (!gfx::initialise(appInfo))
+	{
+		return EXIT_FAILURE;
+	}
+
+	const auto compileVariants = make_compile_variants(pipelineCount);
+	if (compileVariants.front().vertexCode.empty() || compileVariants.front().fragmentCode.empty())
+	{
+		gfx::shutdown();
+		return EXIT_FAILURE;
+	}
+	const auto linkVariants = make_link_variants(pipelineCount);
+
+	std::error_code error{};
+	std::filesystem::remove(PIPELINE_CACHE_PATH, error);
+	{
+		BenchDevice device(PIPELINE_CACHE_PATH, 0);
+		if (device.valid)
+		{
+			report("cold", 0, compileVariants.size(), create_pipelines(device.deviceHandle, compileVariants, false));
+		}
+	}
+	{
+		BenchDevice device(PIPELINE_CACHE_PATH, 0);
+		if (device.valid)
+		{
+			report("warm", 0, compileVariants.size(), create_pipelines(device.deviceHandle, compileVariants, false));
+		}
+	}
+	{
+		BenchDevice device("", 0);
+		if (device.valid)
+		{
+			gfx::PipelineHandle partsPipelineHandle{};
+			if (gfx::create_graphics_pipeline(partsPipelineHandle, device.deviceHandle, make_base_pipeline_info()))
+			{
+				report("link", 0, linkVariants.size(), create_pipelines(device.deviceHandle, linkVariants, false));
+				gfx::destroy_pipeline(partsPipelineHandle);
+			}
+		}
+	}
+	const auto maxThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	for (std::uint32_t threadCount = 1; threadCount <= maxThreadCount; threadCount *= 2)
+	{
+		BenchDevice device("", threadCount);
+		if (device.valid)
+		{
+			report("async", threadCount, compileVariants.size(), create_pipelines(device.deviceHandle, compileVariants, true));
+		}
+	}
+	std::filesystem::remove(PIPELINE_CACHE_PATH, error);
+
+	gfx::shutdown();
+	return EXIT_SUCCESS;
+}
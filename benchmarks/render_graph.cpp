@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx.hpp"
+#include "gfx/gfx_render_graph.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace sm;
+
+// CPU cost of the render graph as it grows, on synthetic graphs of 10 to 500 passes. Each pass renders to one of a pool of
+// transient textures and reads up to three others written before it, picked at random from a fixed seed, so the graphs
+// have long dependency chains, render passes shared by consecutive passes, culled passes and aliased transient textures.
+// The passes record nothing themselves, leaving the graph's own work: planning, transitions and render pass bookkeeping.
+namespace
+{
+	constexpr std::uint32_t GRAPHICS_QUEUE = 0;
+	constexpr std::uint32_t TARGET_SIZE = 64;
+	constexpr std::uint32_t MAX_READS_PER_PASS = 3;
+
+	struct BenchContext
+	{
+		gfx::DeviceHandle device{};
+		gfx::CommandListHandle commandList{};
+	} s_bench{};
+
+	/**
+	 * @brief Declare a synthetic graph of passCount passes. Graphs of the same size but another seed differ in structure,
+	 * so compile() has to plan them again.
+	 */
+	void declare_graph(gfx::RenderGraph& renderGraph, std::uint32_t passCount, std::uint32_t seed)
+	{
+		const gfx::TextureInfo textureInfo{
+			.usage = gfx::TextureUsage::eColorAttachment,
+			.type = gfx::TextureType::e2D,
+			.width = TARGET_SIZE,
+			.height = TARGET_SIZE,
+			.format = gfx::Format::eRGBA8,
+		};
+		const auto textureCount = std::max(4u, passCount / 4);
+		std::vector<gfx::RenderGraphTexture> textures(textureCount);
+		for (auto& texture : textures)
+		{
+			texture = renderGraph.add_transient_texture(textureInfo);
+		}
+
+		std::mt19937 random{ seed };
+		std::vector<std::uint32_t> writtenTextures{}; // Indices into textures, in the order they were first written.
+		std::uint32_t target{ 0 };
+		for (std::uint32_t i = 0; i < passCount; ++i)
+		{
+			auto& pass = renderGraph.add_graphics_pass("pass");
+			target = random() % textureCount;
+			pass.add_color_attachment(textures[target]);
+
+			const auto readCount = writtenTextures.empty() ? 0 : random() % (MAX_READS_PER_PASS + 1);
+			for (std::uint32_t read = 0; read < readCount; ++read)
+			{
+				const auto source = writtenTextures[random() % writtenTextures.size()];
+				if (source != target)
+				{
+					pass.read(textures[source]);
+				}
+			}
+			pass.on_execute([](gfx::CommandListHandle) {});
+
+			if (std::find(writtenTextures.begin(), writtenTextures.end(), target) == writtenTextures.end())
+			{
+				writtenTextures.push_back(target);
+			}
+		}
+		renderGraph.export_texture(textures[target]);
+	}
+
+	// Arguments: pass count. Declaring the graph is not timed.
+	void BM_compile(benchmark::State& state)
+	{
+		const auto passCount = std::uint32_t(state.range(0));
+		gfx::RenderGraph renderGraph(s_bench.device);
+		std::uint32_t seed{ 0 };
+		for (auto _ : state)
+		{
+			// Alternating between two graphs defeats the reuse of an unchanged plan. The frame frees the transient
+			// textures the previous compile() replaced.
+			state.PauseTiming();
+			gfx::begin_frame(s_bench.device);
+			renderGraph.reset();
+			declare_graph(renderGraph, passCount, seed++ % 2);
+			state.ResumeTiming();
+
+			if (!renderGraph.compile())
+			{
+				state.SkipWithError("Failed to compile the render graph");
+			}
+
+			state.PauseTiming();
+			gfx::end_frame(s_bench.device);
+			state.ResumeTiming();
+		}
+		state.SetItemsProcessed(std::int64_t(state.iterations()) * passCount);
+	}
+	BENCHMARK(BM_compile)->RangeMultiplier(2)->Range(10, 500);
+
+	// Arguments: pass count. The per-frame path: declaring the same graph again and compile() reusing its plan.
+	void BM_redeclare(benchmark::State& state)
+	{
+		const auto passCount = std::uint32_t(state.range(0));
+		gfx::RenderGraph renderGraph(s_bench.device);
+		declare_graph(renderGraph, passCount, 0);
+		renderGraph.compile();
+		for (auto _ : state)
+		{
+			renderGraph.reset();
+			declare_graph(renderGraph, passCount, 0);
+			renderGraph.compile();
+		}
+		state.SetItemsProcessed(std::int64_t(state.iterations()) * passCount);
+	}
+	BENCHMARK(BM_redeclare)->RangeMultiplier(2)->Range(10, 500);
+
+	// Arguments: pass count. execute() into one command list, which is never submitted.
+	void BM_execute(benchmark::State& state)
+	{
+		const auto passCount = std::uint32_t(state.range(0));
+		gfx::RenderGraph renderGraph(s_bench.device);
+		declare_graph(renderGraph, passCount, 0);
+		if (!renderGraph.compile())
+		{
+			state.SkipWithError("Failed to compile the render graph");
+		}
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			gfx::reset(s_bench.commandList);
+			gfx::begin(s_bench.commandList);
+			state.ResumeTiming();
+
+			renderGraph.execute(s_bench.commandList);
+
+			state.PauseTiming();
+			gfx::end(s_bench.commandList);
+			state.ResumeTiming();
+		}
+		state.SetItemsProcessed(std::int64_t(state.iterations()) * passCount);
+	}
+	BENCHMARK(BM_execute)->RangeMultiplier(2)->Range(10, 500);
+
+	// Arguments: pass count, recording threads (0 records on the calling thread). execute_parallel() recording and
+	// submitting a frame; waiting for an earlier frame in begin_frame() is not timed.
+	void BM_execute_parallel(benchmark::State& state)
+	{
+		const auto passCount = std::uint32_t(state.range(0));
+		gfx::RenderGraph renderGraph(s_bench.device);
+		renderGraph.set_recording_threads(std::uint32_t(state.range(1)));
+		declare_graph(renderGraph, passCount, 0);
+		if (!renderGraph.compile())
+		{
+			state.SkipWithError("Failed to compile the render graph");
+		}
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			gfx::begin_frame(s_bench.device);
+			state.ResumeTiming();
+
+			renderGraph.execute_parallel(GRAPHICS_QUEUE);
+
+			state.PauseTiming();
+			gfx::end_frame(s_bench.device);
+			state.ResumeTiming();
+		}
+		gfx::wait_for_device_idle(s_bench.device);
+		state.SetItemsProcessed(std::int64_t(state.iterations()) * passCount);
+	}
+	BENCHMARK(BM_execute_parallel)
+		->ArgNames({ "passes", "threads" })
+		->ArgsProduct({ { 10, 50, 100, 500 }, { 0, 1, 2, 4, 8 } })
+		->UseRealTime();
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+	{
+		return EXIT_FAILURE;
+	}
+
+	gfx::set_error_callback([](const char* msg) { GFX_LOG_ERR(msg); });
+
+	gfx::AppInfo appInfo{ .appName = "gfx_bench_render_graph", .headless = true, .debugLevel = gfx::DebugLevel::eOff };
+	if (!gfx::initialise(appInfo))
+	{
+		return EXIT_FAILURE;
+	}
+
+	gfx::DeviceInfo deviceInfo{
+		.deviceFlags = gfx::DeviceFlags_PreferDiscrete,
+		.queueFlags = { gfx::QueueFlags_Graphics },
+	};
+	int result = EXIT_FAILURE;
+	if (gfx::create_device(s_bench.device, deviceInfo))
+	{
+		if (gfx::create_command_list(s_bench.commandList, s_bench.device, GRAPHICS_QUEUE))
+		{
+			benchmark::RunSpecifiedBenchmarks();
+			result = EXIT_SUCCESS;
+			gfx::wait_for_device_idle(s_bench.device);
+			gfx::destroy_command_list(s_bench.device, s_bench.commandList);
+		}
+		gfx::destroy_device(s_bench.device);
+	}
+
+	benchmark::Shutdown();
+	gfx::shutdown();
+
+	return result;
+}
@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace sm;
+
+// Upload throughput (bytes_per_second) and latency (time per iteration, real time as it waits on the GPU) of each way of
+// getting data from the CPU to a buffer or texture. Every iteration uploads once and waits for it to be usable on the
+// graphics queue, so the time is the latency a loading screen or streamer would see for that size.
+namespace
+{
+	constexpr std::uint32_t GRAPHICS_QUEUE = 0;
+	constexpr std::uint32_t TRANSFER_QUEUE = 1;
+	constexpr std::uint64_t UPLOAD_RING_SIZE = 256ull * 1024 * 1024;
+
+	struct BenchContext
+	{
+		gfx::DeviceHandle device{};
+		gfx::CommandListHandle commandList{};
+		std::vector<std::byte> sourceData{}; // Large enough for the biggest upload.
+	} s_bench{};
+
+	auto create_buffer(gfx::BufferType type, gfx::BufferMemory memory, std::uint64_t size) -> gfx::BufferHandle
+	{
+		gfx::BufferHandle bufferHandle{};
+		gfx::create_buffer(bufferHandle, s_bench.device, { .type = type, .size = size, .memory = memory, .debugName = "gfx_bench_upload" });
+		return bufferHandle;
+	}
+
+	auto create_texture(std::uint32_t size) -> gfx::TextureHandle
+	{
+		gfx::TextureInfo textureInfo{
+			.usage = gfx::TextureUsage::eTexture,
+			.type = gfx::TextureType::e2D,
+			.width = size,
+			.height = size,
+			.format = gfx::Format::eRGBA8,
+		};
+		gfx::TextureHandle textureHandle{};
+		gfx::create_texture(textureHandle, s_bench.device, textureInfo);
+		return textureHandle;
+	}
+
+	auto texture_bytes(std::uint32_t size) -> std::uint64_t { return std::uint64_t(size) * size * 4; }
+
+	void set_counters(benchmark::State& state, std::uint64_t bytes)
+	{
+		state.SetBytesProcessed(std::int64_t(state.iterations() * bytes));
+		state.counters["bytes"] = double(bytes);
+	}
+
+#pragma region Buffers
+
+	// memcpy into an eUpload staging buffer and copy_buffer() on the graphics queue.
+	void BM_buffer_staging_copy(benchmark::State& state)
+	{
+		const auto bytes = std::uint64_t(state.range(0));
+		const auto stagingBufferHandle = create_buffer(gfx::BufferType::eUpload, gfx::BufferMemory::eUpload, bytes);
+		const auto bufferHandle = create_buffer(gfx::BufferType::eStorage, gfx::BufferMemory::eGpuOnly, bytes);
+		auto* stagingPtr = gfx::get_mapped_pointer(stagingBufferHandle);
+		for (auto _ : state)
+		{
+			std::memcpy(stagingPtr, s_bench.sourceData.data(), bytes);
+			gfx::flush_buffer_range(stagingBufferHandle);
+
+			gfx::reset(s_bench.commandList);
+			gfx::begin(s_bench.commandList);
+			const gfx::BufferCopyRegion region{ .size = bytes };
+			gfx::copy_buffer(s_bench.commandList, stagingBufferHandle, bufferHandle, { &region, 1 });
+			gfx::end(s_bench.commandList);
+			gfx::wait_on_sync_point(gfx::submit_command_list({ .commandList = s_bench.commandList }));
+		}
+		set_counters(state, bytes);
+		gfx::destroy_buffer(bufferHandle);
+		gfx::destroy_buffer(stagingBufferHandle);
+	}
+	BENCHMARK(BM_buffer_staging_copy)->RangeMultiplier(4)->Range(64 << 10, 64 << 20)->UseRealTime();
+
+	// upload_buffer(), which stages internally for buffers the CPU cannot reach.
+	void BM_buffer_upload_buffer(benchmark::State& state)
+	{
+		const auto bytes = std::uint64_t(state.range(0));
+		const auto bufferHandle = create_buffer(gfx::BufferType::eStorage, gfx::BufferMemory::eGpuOnly, bytes);
+		for (auto _ : state)
+		{
+			gfx::wait_on_sync_point(gfx::upload_buffer(bufferHandle, s_bench.sourceData.data(), bytes, 0, GRAPHICS_QUEUE));
+		}
+		set_counters(state, bytes);
+		gfx::destroy_buffer(bufferHandle);
+	}
+	BENCHMARK(BM_buffer_upload_buffer)->RangeMultiplier(4)->Range(64 << 10, 64 << 20)->UseRealTime();
+
+	// queue_buffer_upload() into the staging ring, flush_uploads() copying on the transfer queue and handing over to graphics.
+	void BM_buffer_transfer_queue(benchmark::State& state)
+	{
+		const auto bytes = std::uint64_t(state.range(0));
+		const auto bufferHandle = create_buffer(gfx::BufferType::eStorage, gfx::BufferMemory::eGpuOnly, bytes);
+		for (auto _ : state)
+		{
+			if (!gfx::queue_buffer_upload(bufferHandle, s_bench.sourceData.data(), bytes))
+			{
+				state.SkipWithError("The upload ring is too small");
+				break;
+			}
+			gfx::wait_on_sync_point(gfx::flush_uploads(s_bench.device, GRAPHICS_QUEUE));
+		}
+		set_counters(state, bytes);
+		gfx::destroy_buffer(bufferHandle);
+	}
+	BENCHMARK(BM_buffer_transfer_queue)->RangeMultiplier(4)->Range(64 << 10, 64 << 20)->UseRealTime();
+
+	// memcpy straight into an eDynamic buffer, which is device local where the CPU can reach it (resizable BAR, or the
+	// 256MiB window without it) and host memory otherwise. Visible to the next submission, so there is nothing to wait on.
+	void BM_buffer_direct_write(benchmark::State& state)
+	{
+		const auto bytes = std::uint64_t(state.range(0));
+		const auto bufferHandle = create_buffer(gfx::BufferType::eStorage, gfx::BufferMemory::eDynamic, bytes);
+		auto* bufferPtr = gfx::get_mapped_pointer(bufferHandle);
+		if (bufferPtr == nullptr)
+		{
+			state.SkipWithError("Failed to create a mapped eDynamic buffer");
+		}
+		for (auto _ : state)
+		{
+			std::memcpy(bufferPtr, s_bench.sourceData.data(), bytes);
+			gfx::flush_buffer_range(bufferHandle);
+		}
+		set_counters(state, bytes);
+		gfx::destroy_buffer(bufferHandle);
+	}
+	BENCHMARK(BM_buffer_direct_write)->RangeMultiplier(4)->Range(64 << 10, 64 << 20)->UseRealTime();
+
+#pragma endregion
+
+#pragma region Textures
+
+	// memcpy into an eUpload staging buffer and copy_buffer_to_texture() on the graphics queue.
+	void BM_texture_staging_copy(benchmark::State& state)
+	{
+		const auto size = std::uint32_t(state.range(0));
+		const auto bytes = texture_bytes(size);
+		const auto stagingBufferHandle = create_buffer(gfx::BufferType::eUpload, gfx::BufferMemory::eUpload, bytes);
+		const auto textureHandle = create_texture(size);
+		auto* stagingPtr = gfx::get_mapped_pointer(stagingBufferHandle);
+		for (auto _ : state)
+		{
+			std::memcpy(stagingPtr, s_bench.sourceData.data(), bytes);
+			gfx::flush_buffer_range(stagingBufferHandle);
+
+			gfx::reset(s_bench.commandList);
+			gfx::begin(s_bench.commandList);
+			gfx::transition_texture(s_bench.commandList, textureHandle, gfx::TextureState::eUploadDst);
+			gfx::copy_buffer_to_texture(s_bench.commandList, stagingBufferHandle, textureHandle);
+			gfx::transition_texture(s_bench.commandList, textureHandle, gfx::TextureState::eShaderRead);
+			gfx::end(s_bench.commandList);
+			gfx::wait_on_sync_point(gfx::submit_command_list({ .commandList = s_bench.commandList }));
+		}
+		set_counters(state, bytes);
+		gfx::destroy_texture(textureHandle);
+		gfx::destroy_buffer(stagingBufferHandle);
+	}
+	BENCHMARK(BM_texture_staging_copy)->RangeMultiplier(2)->Range(256, 4096)->UseRealTime();
+
+	// queue_texture_upload() and flush_uploads() on the transfer queue, into a texture in use so host image copy is skipped.
+	void BM_texture_transfer_queue(benchmark::State& state)
+	{
+		const auto size = std::uint32_t(state.range(0));
+		const auto bytes = texture_bytes(size);
+		const auto textureHandle = create_texture(size);
+		gfx::wait_on_sync_point(gfx::upload_texture(textureHandle, s_bench.sourceData.data(), bytes, GRAPHICS_QUEUE));
+		for (auto _ : state)
+		{
+			if (!gfx::queue_texture_upload(textureHandle, s_bench.sourceData.data(), bytes))
+			{
+				state.SkipWithError("The upload ring is too small");
+				break;
+			}
+			gfx::wait_on_sync_point(gfx::flush_uploads(s_bench.device, GRAPHICS_QUEUE));
+		}
+		set_counters(state, bytes);
+		gfx::destroy_texture(textureHandle);
+	}
+	BENCHMARK(BM_texture_transfer_queue)->RangeMultiplier(2)->Range(256, 4096)->UseRealTime();
+
+	// upload_texture() into a texture that was never used, which VK_EXT_host_image_copy writes on the CPU where the device
+	// reports it is optimal, and which otherwise stages like BM_texture_staging_copy. Creating the texture is not timed.
+	void BM_texture_host_image_copy(benchmark::State& state)
+	{
+		const auto size = std::uint32_t(state.range(0));
+		const auto bytes = texture_bytes(size);
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			const auto textureHandle = create_texture(size);
+			state.ResumeTiming();
+
+			gfx::wait_on_sync_point(gfx::upload_texture(textureHandle, s_bench.sourceData.data(), bytes, GRAPHICS_QUEUE));
+
+			state.PauseTiming();
+			gfx::destroy_texture(textureHandle);
+			state.ResumeTiming();
+		}
+		set_counters(state, bytes);
+	}
+	BENCHMARK(BM_texture_host_image_copy)->RangeMultiplier(2)->Range(256, 4096)->UseRealTime();
+
+#pragma endregion
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+	{
+		return EXIT_FAILURE;
+	}
+
+	gfx::set_error_callback([](const char* msg) { GFX_LOG_ERR(msg); });
+
+	gfx::AppInfo appInfo{ .appName = "gfx_bench_upload", .headless = true, .debugLevel = gfx::DebugLevel::eOff };
+	if (!gfx::initialise(appInfo))
+	{
+		return EXIT_FAILURE;
+	}
+
+	gfx::DeviceInfo deviceInfo{
+		.deviceFlags = gfx::DeviceFlags_PreferDiscrete,
+		.queueFlags = { gfx::QueueFlags_Graphics, gfx::QueueFlags_Transfer },
+		.uploadBufferSize = UPLOAD_RING_SIZE,
+		.uploadQueueIndex = TRANSFER_QUEUE,
+	};
+	int result = EXIT_FAILURE;
+	if (gfx::create_device(s_bench.device, deviceInfo))
+	{
+		s_bench.sourceData.resize(std::max<std::uint64_t>(64 << 20, texture_bytes(4096)), std::byte{ 0x5a });
+		if (gfx::create_command_list(s_bench.commandList, s_bench.device, GRAPHICS_QUEUE))
+		{
+			benchmark::RunSpecifiedBenchmarks();
+			result = EXIT_SUCCESS;
+			gfx::wait_for_device_idle(s_bench.device);
+			gfx::destroy_command_list(s_bench.device, s_bench.commandList);
+		}
+		gfx::destroy_device(s_bench.device);
+	}
+
+	benchmark::Shutdown();
+	gfx::shutdown();
+
+	return result;
+}
@@ -31,7 +31,7 @@ int main()
 		GFX_ASSERT(false, "");
 	});
 
-	gfx::AppInfo appInfo{ "compute App" };
+	gfx::AppInfo appInfo{ .appName = "compute App", .headless = true };
 	if (!gfx::initialise(appInfo))
 	{
 		throw std::runtime_error("Failed to initialise GFX!");
@@ -39,7 +39,8 @@ int main()
 
 	gfx::DeviceInfo device_info{
 		.deviceFlags = gfx::DeviceFlags_PreferDiscrete,
-		.queueFlags = { gfx::QueueFlags_Graphics },
+		.queueFlags = { gfx::QueueFlags_Compute },
+		.computeOnly = true, // No window or rendering, so startup skips both.
 	};
 	gfx::DeviceHandle deviceHandle{};
 	if (!gfx::create_device(deviceHandle, device_info))
@@ -65,18 +66,25 @@ int main()
 
 	gfx::BufferHandle inBufferHandle{};
 	gfx::BufferHandle outBufferHandle{};
+	gfx::BufferHandle readbackBufferHandle{};
 	gfx::BufferInfo bufferInfo{
 		.type = gfx::BufferType::eStorage,
 		.size = sizeof(int) * 10,
+		.memory = gfx::BufferMemory::eDynamic,
 	};
 	if (!gfx::create_buffer(inBufferHandle, deviceHandle, bufferInfo))
 	{
 		throw std::runtime_error("Failed to create GFX buffer!");
 	}
+	bufferInfo.memory = gfx::BufferMemory::eGpuOnly; // Only the GPU writes the results, which are read back with read_buffer().
 	if (!gfx::create_buffer(outBufferHandle, deviceHandle, bufferInfo))
 	{
 		throw std::runtime_error("Failed to create GFX buffer!");
 	}
+	if (!gfx::create_buffer(readbackBufferHandle, deviceHandle, { .type = gfx::BufferType::eReadback, .size = bufferInfo.size }))
+	{
+		throw std::runtime_error("Failed to create GFX buffer!");
+	}
 	std::int32_t* inBufferPtr{ nullptr };
 	if (gfx::map_buffer(inBufferHandle, reinterpret_cast<void*&>(inBufferPtr)))
 	{
@@ -96,7 +104,7 @@ int main()
 	gfx::bind_buffer_to_descriptor_set(descriptorSetHandle, 1, outBufferHandle);
 
 	gfx::CommandListHandle commandListHandle{};
-	if (!gfx::create_command_list(commandListHandle, deviceHandle, 0))
+	if (!gfx::create_command_list(commandListHandle, deviceHandle, 0, gfx::CommandListFlags_OneTimeSubmit))
 	{
 		throw std::runtime_error("Failed to create GFX command list!");
 	}
@@ -106,16 +114,14 @@ int main()
 	gfx::bind_pipeline(commandListHandle, pipelineHandle);
 	gfx::bind_descriptor_set(commandListHandle, descriptorSetHandle);
 	gfx::dispatch(commandListHandle, 10, 1, 1);
+	const auto readbackHandle = gfx::read_buffer(commandListHandle, outBufferHandle, readbackBufferHandle, { .size = bufferInfo.size });
 	gfx::end(commandListHandle);
 
 	gfx::SubmitInfo submitInfo{
 		.commandList = commandListHandle,
 		.waitSemaphoreHandle = {}
 	};
-	gfx::FenceHandle fenceHandle;
-	gfx::submit_command_list(submitInfo, &fenceHandle, nullptr);
-
-	gfx::wait_on_fence(fenceHandle);
+	gfx::submit_command_list(submitInfo);
 
 	if (gfx::map_buffer(inBufferHandle, reinterpret_cast<void*&>(inBufferPtr)))
 	{
@@ -126,19 +132,21 @@ int main()
 		std::cout << std::endl;
 		gfx::unmap_buffer(inBufferHandle);
 	}
-	std::int32_t* outBufferPtr{ nullptr };
-	if (gfx::map_buffer(outBufferHandle, reinterpret_cast<void*&>(outBufferPtr)))
+	// A renderer would poll once per frame instead, picking the results up a few frames later.
+	const void* outData{ nullptr };
+	if (gfx::resolve_readback(readbackHandle, outData, gfx::INFINITE_TIMEOUT))
 	{
+		const auto* outBufferPtr = static_cast<const std::int32_t*>(outData);
 		for (auto i = 0; i < 10; ++i)
 		{
 			std::cout << outBufferPtr[i] << " ";
 		}
 		std::cout << std::endl;
-		gfx::unmap_buffer(outBufferHandle);
 	}
 
 	gfx::destroy_buffer(inBufferHandle);
 	gfx::destroy_buffer(outBufferHandle);
+	gfx::destroy_buffer(readbackBufferHandle);
 
 	gfx::destroy_device(deviceHandle);
 	gfx::shutdown();
@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx.hpp"
+
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_float4.hpp>
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <utility>
+
+// Headless draw-call throughput stress test. Each frame draws the bunny drawCount times, each draw a small run of its
+// triangles so the GPU keeps up and the CPU cost of recording dominates. Three workloads change state at different rates:
+// - constants:   one pipeline and descriptor set, set_constants() per draw.
+// - descriptors: bind_descriptor_sets() and set_constants() per draw.
+// - pipelines:   bind_pipeline() and set_constants() per draw.
+// Usage: gfx_example_draw_stress [frames=100] [drawCounts=10000,100000,1000000...]
+
+using namespace sm;
+
+auto read_shader_file(const char* filename) -> std::vector<std::uint32_t>
+{
+	if (std::ifstream file{ filename, std::ios::binary | std::ios::ate })
+	{
+		const std::streamsize fileSize = file.tellg();
+		file.seekg(0);
+		std::vector<std::uint32_t> shaderBinary(fileSize / sizeof(std::uint32_t));
+		file.read(reinterpret_cast<char*>(shaderBinary.data()), fileSize);
+		return shaderBinary;
+	}
+
+	GFX_LOG_ERR_FMT("Example - draw_stress - Failed to read shader file: {}", filename);
+	return {};
+}
+
+struct Vertex
+{
+	glm::vec3 pos;
+	glm::vec3 normal;
+};
+
+bool read_obj_model(const std::string& filename, std::vector<Vertex>& outVertices, std::vector<std::uint32_t>& outTriangles)
+{
+	tinyobj::ObjReaderConfig readerConfig{};
+	readerConfig.triangulate = true;
+	tinyobj::ObjReader reader{};
+	if (!reader.ParseFromFile(filename, readerConfig))
+	{
+		if (!reader.Error().empty())
+		{
+			std::cerr << reader.Error() << std::endl;
+		}
+		return false;
+	}
+
+	const auto& attrib = reader.GetAttrib();
+	for (const auto& shape : reader.GetShapes())
+	{
+		for (const auto& index : shape.mesh.indices)
+		{
+			outTriangles.push_back(std::uint32_t(outVertices.size()));
+			auto& vertex = outVertices.emplace_back();
+			vertex.pos = { attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1], attrib.vertices[3 * index.vertex_index + 2] };
+			if (index.normal_index >= 0)
+			{
+				vertex.normal = { attrib.normals[3 * index.normal_index + 0], attrib.normals[3 * index.normal_index + 1], attrib.normals[3 * index.normal_index + 2] };
+			}
+		}
+	}
+
+	return true;
+}
+
+struct UniformData
+{
+	glm::mat4 viewProjMat;
+	glm::vec4 tint;
+};
+
+enum class Workload
+{
+	eConstants,
+	eDescriptors,
+	ePipelines,
+};
+
+constexpr std::uint32_t TARGET_SIZE = 256;
+constexpr std::uint32_t TRIANGLES_PER_DRAW = 32;
+constexpr std::uint32_t DESCRIPTOR_SET_COUNT = 64;
+constexpr std::uint32_t PIPELINE_COUNT = 8;
+constexpr std::uint32_t MODEL_MATRIX_COUNT = 4096; // Cycled through, so building them is not part of the measured work.
+constexpr std::uint32_t WARMUP_FRAMES = 10;
+
+struct Scene
+{
+	gfx::DeviceHandle deviceHandle{};
+	gfx::TextureHandle colorTextureHandle{};
+	gfx::TextureHandle depthTextureHandle{};
+	std::vector<gfx::PipelineHandle> pipelineHandles{};
+	std::vector<gfx::BufferHandle> uniformBufferHandles{};
+	std::vector<gfx::DescriptorSetHandle> descriptorSetHandles{};
+	gfx::BufferHandle vertexBufferHandle{};
+	gfx::BufferHandle indexBufferHandle{};
+	std::uint32_t indexCount{ 0 };
+	std::vector<glm::mat4> modelMatrices{};
+};
+
+bool create_scene(Scene& scene)
+{
+	gfx::TextureInfo colorTextureInfo{
+		.usage = gfx::TextureUsage::eColorAttachment,
+		.type = gfx::TextureType::e2D,
+		.width = TARGET_SIZE,
+		.height = TARGET_SIZE,
+		.format = gfx::Format::eRGBA8,
+	};
+	gfx::TextureInfo depthTextureInfo{
+		.usage = gfx::TextureUsage::eDepthStencilAttachment,
+		.type = gfx::TextureType::e2D,
+		.width = TARGET_SIZE,
+		.height = TARGET_SIZE,
+		.format = gfx::Format::eDepth16,
+		.memory = gfx::TextureMemory::eTransient,
+	};
+	if (!gfx::create_texture(scene.colorTextureHandle, scene.deviceHandle, colorTextureInfo) || !gfx::create_texture(scene.depthTextureHandle, scene.deviceHandle, depthTextureInfo))
+	{
+		return false;
+	}
+
+	const auto vertShaderBinary = read_shader_file("stress.vert.spv");
+	const auto fragShaderBinary = read_shader_file("stress.frag.spv");
+	gfx::GraphicsPipelineInfo pipelineInfo{
+		.vertexCode = vertShaderBinary,
+		.fragmentCode = fragShaderBinary,
+		.vertexInputBindings = {
+			{ "Vertex", { { "Position", 0, gfx::Format::eRGB32 }, { "Normal", 1, gfx::Format::eRGB32 } } },
+		},
+		.descriptorSets = {
+			gfx::DescriptorSetInfo{ .bindings = {
+										{ gfx::DescriptorType::eUniformBuffer, 1, gfx::ShaderStageFlags_Vertex },
+									} },
+		},
+		.constantBlock = { sizeof(glm::mat4), gfx::ShaderStageFlags_Vertex },
+		.depthTest = true,
+		.colorAttachments = { gfx::Format::eRGBA8 },
+		.depthAttachmentFormat = gfx::Format::eDepth16,
+	};
+	for (std::uint32_t i = 0; i < PIPELINE_COUNT; ++i)
+	{
+		pipelineInfo.fragmentSpecializationConstants = { { 0, std::bit_cast<std::uint32_t>(1.0f - float(i) / PIPELINE_COUNT) } };
+		if (!gfx::create_graphics_pipeline(scene.pipelineHandles.emplace_back(), scene.deviceHandle, pipelineInfo))
+		{
+			return false;
+		}
+	}
+
+	const auto projMat = glm::perspectiveLH(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+	const auto viewMat = glm::lookAtLH(glm::vec3(0, 4, -12), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+	for (std::uint32_t i = 0; i < DESCRIPTOR_SET_COUNT; ++i)
+	{
+		auto& uniformBufferHandle = scene.uniformBufferHandles.emplace_back();
+		if (!gfx::create_buffer(uniformBufferHandle, scene.deviceHandle, { .type = gfx::BufferType::eUniform, .size = sizeof(UniformData) }))
+		{
+			return false;
+		}
+		const UniformData uniformData{
+			.viewProjMat = projMat * viewMat,
+			.tint = { float(i % 4) / 3.0f, float(i / 4 % 4) / 3.0f, float(i / 16) / 3.0f, 1.0f },
+		};
+		void* bufferPtr{ nullptr };
+		if (gfx::map_buffer(uniformBufferHandle, bufferPtr))
+		{
+			std::memcpy(bufferPtr, &uniformData, sizeof(UniformData));
+			gfx::unmap_buffer(uniformBufferHandle);
+		}
+
+		auto& descriptorSetHandle = scene.descriptorSetHandles.emplace_back();
+		if (!gfx::create_descriptor_set_from_pipeline(descriptorSetHandle, scene.pipelineHandles[0], 0))
+		{
+			return false;
+		}
+		gfx::bind_buffer_to_descriptor_set(descriptorSetHandle, 0, uniformBufferHandle);
+	}
+
+	std::vector<Vertex> vertices{};
+	std::vector<std::uint32_t> triangles{};
+	if (!read_obj_model("./stanford-bunny.obj", vertices, triangles) || triangles.size() < TRIANGLES_PER_DRAW * 3)
+	{
+		return false;
+	}
+	scene.indexCount = std::uint32_t(triangles.size());
+
+	if (!gfx::create_buffer(scene.vertexBufferHandle, scene.deviceHandle, { .type = gfx::BufferType::eVertex, .size = sizeof(Vertex) * vertices.size() }) ||
+		!gfx::create_buffer(scene.indexBufferHandle, scene.deviceHandle, { .type = gfx::BufferType::eIndex, .size = sizeof(std::uint32_t) * triangles.size() }))
+	{
+		return false;
+	}
+	gfx::upload_buffer(scene.vertexBufferHandle, vertices.data(), sizeof(Vertex) * vertices.size());
+	gfx::upload_buffer(scene.indexBufferHandle, triangles.data(), sizeof(std::uint32_t) * triangles.size());
+
+	// A grid of small bunnies in front of the camera.
+	for (std::uint32_t i = 0; i < MODEL_MATRIX_COUNT; ++i)
+	{
+		const glm::vec3 position{ float(i % 64) / 4.0f - 8.0f, float(i / 64) / 8.0f - 4.0f, 0.0f };
+		scene.modelMatrices.push_back(glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(2.0f)));
+	}
+
+	return true;
+}
+
+void destroy_scene(Scene& scene)
+{
+	gfx::wait_for_device_idle(scene.deviceHandle);
+	gfx::destroy_buffer(scene.indexBufferHandle);
+	gfx::destroy_buffer(scene.vertexBufferHandle);
+	for (std::uint32_t i = 0; i < scene.descriptorSetHandles.size(); ++i)
+	{
+		gfx::destroy_descriptor_set(scene.descriptorSetHandles[i]);
+		gfx::destroy_buffer(scene.uniformBufferHandles[i]);
+	}
+	for (const auto pipelineHandle : scene.pipelineHandles)
+	{
+		gfx::destroy_pipeline(pipelineHandle);
+	}
+	gfx::destroy_texture(scene.depthTextureHandle);
+	gfx::destroy_texture(scene.colorTextureHandle);
+}
+
+/**
+ * @return CPU milliseconds spent recording and submitting the frame, which excludes begin_frame() waiting on the GPU.
+ */
+auto record_frame(const Scene& scene, Workload workload, std::uint32_t drawCount) -> double
+{
+	gfx::begin_frame(scene.deviceHandle);
+	const auto start = std::chrono::steady_clock::now();
+
+	gfx::CommandListHandle commandListHandle{};
+	if (!gfx::create_transient_command_list(commandListHandle, scene.deviceHandle, 0))
+	{
+		throw std::runtime_error("Failed to create GFX command list!");
+	}
+	gfx::begin(commandListHandle);
+
+	gfx::transition_texture(commandListHandle, scene.colorTextureHandle, gfx::TextureState::eRenderTarget);
+
+	gfx::RenderPassInfo renderPassInfo{
+		.colorAttachments = { scene.colorTextureHandle },
+		.depthAttachment = scene.depthTextureHandle,
+		.clearColor = { 0.392f, 0.584f, 0.929f, 1.0f }, // Cornflower Blue
+	};
+	gfx::begin_render_pass(commandListHandle, renderPassInfo);
+	{
+		gfx::set_viewport(commandListHandle, 0, 0, TARGET_SIZE, TARGET_SIZE);
+		gfx::set_scissor(commandListHandle, 0, 0, TARGET_SIZE, TARGET_SIZE);
+
+		gfx::bind_pipeline(commandListHandle, scene.pipelineHandles[0]);
+		gfx::bind_descriptor_sets(commandListHandle, 0, { &scene.descriptorSetHandles[0], 1 });
+		gfx::bind_index_buffer(commandListHandle, scene.indexBufferHandle, gfx::IndexType::eUInt32);
+		gfx::bind_vertex_buffers(commandListHandle, 0, { &scene.vertexBufferHandle, 1 });
+
+		const std::uint32_t drawIndexCount = TRIANGLES_PER_DRAW * 3;
+		const std::uint32_t drawRunCount = scene.indexCount / drawIndexCount;
+		for (std::uint32_t i = 0; i < drawCount; ++i)
+		{
+			if (workload == Workload::ePipelines)
+			{
+				gfx::bind_pipeline(commandListHandle, scene.pipelineHandles[i % PIPELINE_COUNT]);
+			}
+			else if (workload == Workload::eDescriptors)
+			{
+				gfx::bind_descriptor_sets(commandListHandle, 0, { &scene.descriptorSetHandles[i % DESCRIPTOR_SET_COUNT], 1 });
+			}
+			gfx::set_constants(commandListHandle, gfx::ShaderStageFlags_Vertex, 0, sizeof(glm::mat4), glm::value_ptr(scene.modelMatrices[i % MODEL_MATRIX_COUNT]));
+			gfx::draw_indexed(commandListHandle, drawIndexCount, 1, (i % drawRunCount) * drawIndexCount, 0, 0);
+		}
+	}
+	gfx::end_render_pass(commandListHandle);
+
+	gfx::end(commandListHandle);
+
+	gfx::SubmitInfo submitInfo{
+		.commandList = commandListHandle,
+	};
+	gfx::submit_command_list(submitInfo);
+
+	const auto cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	gfx::end_frame(scene.deviceHandle);
+	return cpuMs;
+}
+
+int main(int argc, char** argv)
+{
+	const std::uint32_t frameCount = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100;
+	std::vector<std::uint32_t> drawCounts{};
+	for (int i = 2; i < argc; ++i)
+	{
+		drawCounts.push_back(std::max(1, std::atoi(argv[i])));
+	}
+	if (drawCounts.empty())
+	{
+		drawCounts = { 10'000, 100'000, 1'000'000 };
+	}
+
+	gfx::set_error_callback([](const char* msg) {
+		GFX_LOG_ERR(msg);
+		GFX_ASSERT(false, "");
+	});
+
+	// Validation would dominate the timings.
+	gfx::AppInfo appInfo{ .appName = "Draw Stress App", .headless = true, .debugLevel = gfx::DebugLevel::eOff };
+	if (!gfx::initialise(appInfo))
+	{
+		throw std::runtime_error("Failed to initialise GFX!");
+	}
+
+	gfx::DeviceInfo device_info{
+		.deviceFlags = gfx::DeviceFlags_PreferDiscrete,
+		.queueFlags = { gfx::QueueFlags_Graphics },
+	};
+	Scene scene{};
+	if (!gfx::create_device(scene.deviceHandle, device_info))
+	{
+		throw std::runtime_error("Failed to create GFX device!");
+	}
+	if (!create_scene(scene))
+	{
+		throw std::runtime_error("Failed to create the draw stress scene!");
+	}
+
+	constexpr std::pair<Workload, const char*> workloads[] = {
+		{ Workload::eConstants, "constants" },
+		{ Workload::eDescriptors, "descriptors" },
+		{ Workload::ePipelines, "pipelines" },
+	};
+	for (const auto drawCount : drawCounts)
+	{
+		for (const auto& [workload, workloadName] : workloads)
+		{
+			for (std::uint32_t i = 0; i < WARMUP_FRAMES; ++i)
+			{
+				record_frame(scene, workload, drawCount);
+			}
+
+			double totalCpuMs{ 0.0 };
+			double maxCpuMs{ 0.0 };
+			const auto start = std::chrono::steady_clock::now();
+			for (std::uint32_t i = 0; i < frameCount; ++i)
+			{
+				const auto cpuMs = record_frame(scene, workload, drawCount);
+				totalCpuMs += cpuMs;
+				maxCpuMs = std::max(maxCpuMs, cpuMs);
+			}
+			const auto frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frameCount;
+
+			const auto avgCpuMs = totalCpuMs / frameCount;
+			std::cout << workloadName << " x" << drawCount << ": " << avgCpuMs << " CPU ms/frame (max " << maxCpuMs << "), "
+					  << (double(drawCount) / avgCpuMs * 1000.0) << " draws/s recorded, " << frameMs << " ms/frame overall" << std::endl;
+		}
+	}
+
+	destroy_scene(scene);
+
+	gfx::destroy_device(scene.deviceHandle);
+	gfx::shutdown();
+}
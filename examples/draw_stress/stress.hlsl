@@ -0,0 +1,48 @@
+struct VSIn
+{
+    float3 position : POSITION;
+    float3 normal : NORMAL;
+};
+
+struct VSOut
+{
+    float4 pos : SV_POSITION;
+    float3 worldNormal : NORMAL;
+    float4 color : COLOR;
+};
+
+struct UniformBufferData
+{
+    float4x4 viewProjMat;
+    float4 tint;
+};
+cbuffer UniformBuffer : register(b0)
+{
+    UniformBufferData ubo;
+};
+
+[[vk::push_constant]]
+struct PushConstants
+{
+    float4x4 modelMat;
+} constants;
+
+// Varied per pipeline, so the pipelines of the pipeline-change mode are distinct.
+[[vk::constant_id(0)]] const float shade = 1.0;
+
+VSOut vs_main(VSIn input)
+{
+    float4 worldPos = mul(constants.modelMat, float4(input.position, 1.0));
+
+    VSOut output;
+    output.pos = mul(ubo.viewProjMat, worldPos);
+    output.worldNormal = normalize(mul(constants.modelMat, float4(input.normal, 0.0)).xyz);
+    output.color = ubo.tint;
+    return output;
+}
+
+float4 ps_main(VSOut input) : SV_TARGET
+{
+    const float diffuse = max(dot(normalize(input.worldNormal), normalize(float3(3, 2, -1))), 0.0);
+    return float4(input.color.rgb * (0.1 + diffuse) * shade, 1.0);
+}
@@ -94,26 +94,29 @@ int main()
 		throw std::runtime_error("Failed to create GFX graphics pipeline!");
 	}
 
-	gfx::CommandListHandle commandListHandle{};
-	if (!gfx::create_command_list(commandListHandle, deviceHandle, 0))
-	{
-		throw std::runtime_error("Failed to create GFX command list!");
-	}
-
 	while (glfwWindowShouldClose(window) == 0)
 	{
 		glfwPollEvents();
 
-		gfx::reset(commandListHandle);
-		gfx::begin(commandListHandle);
+		gfx::begin_frame(deviceHandle);
 
 		gfx::TextureHandle swapChainImageHandle{};
 		if (!gfx::get_swap_chain_image(swapChainImageHandle, swapChainHandle))
 		{
-			throw std::runtime_error("Failed to get SwapChain image handle!");
+			// No image this frame (eg. the window is minimised), presenting retries the acquire.
+			gfx::present_swap_chain(swapChainHandle, 0, nullptr);
+			gfx::end_frame(deviceHandle);
+			continue;
+		}
+
+		gfx::CommandListHandle commandListHandle{};
+		if (!gfx::create_transient_command_list(commandListHandle, deviceHandle, 0))
+		{
+			throw std::runtime_error("Failed to create GFX command list!");
 		}
+		gfx::begin(commandListHandle);
 
-		gfx::transition_texture(commandListHandle, swapChainImageHandle, gfx::TextureState::eUndefined, gfx::TextureState::eRenderTarget);
+		gfx::transition_texture(commandListHandle, swapChainImageHandle, gfx::TextureState::eRenderTarget);
 
 		gfx::RenderPassInfo renderPassInfo{
 			.colorAttachments = { swapChainImageHandle },
@@ -130,20 +133,20 @@ int main()
 		}
 		gfx::end_render_pass(commandListHandle);
 
-		gfx::transition_texture(commandListHandle, swapChainImageHandle, gfx::TextureState::eRenderTarget, gfx::TextureState::ePresent);
+		gfx::transition_texture(commandListHandle, swapChainImageHandle, gfx::TextureState::ePresent);
 
 		gfx::end(commandListHandle);
 
 		gfx::SubmitInfo submitInfo{
 			.commandList = commandListHandle,
-			.waitSemaphoreHandle = {}
+			.waitSemaphoreHandle = {},
+			.swapChainHandle = swapChainHandle,
 		};
-		gfx::FenceHandle fenceHandle;
-		gfx::submit_command_list(submitInfo, &fenceHandle, nullptr);
-
-		gfx::wait_on_fence(fenceHandle);
+		gfx::submit_command_list(submitInfo);
 
 		gfx::present_swap_chain(swapChainHandle, 0, nullptr);
+
+		gfx::end_frame(deviceHandle);
 	}
 
 	gfx::destroy_swap_chain(swapChainHandle);
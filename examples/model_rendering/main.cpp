@@ -3,6 +3,7 @@
  */
 
 #include "gfx/gfx.hpp"
+#include "gfx/gfx_mesh.hpp"
 
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
@@ -176,6 +177,7 @@ int main()
 		.width = WINDOW_WIDTH,
 		.height = WINDOW_HEIGHT,
 		.format = gfx::Format::eDepth16,
+		.memory = gfx::TextureMemory::eTransient,
 	};
 	gfx::TextureHandle depthTextureHandle{};
 	if (!gfx::create_texture(depthTextureHandle, deviceHandle, depthTextureInfo))
@@ -235,54 +237,35 @@ int main()
 	gfx::bind_buffer_to_descriptor_set(descriptorSetHandle, 0, uniformBufferHandle);
 
 #pragma region Vertex/Index Buffers
-	std::vector<Vertex> vertices{};
-	std::vector<std::uint32_t> triangles{};
-	if (!read_obj_model("./stanford-bunny.obj", vertices, triangles))
+	// The OBJ is only parsed on the first run, later runs map the baked mesh.
+	gfx::MeshFile meshFile{};
+	if (!meshFile.open("./stanford-bunny.mesh"))
 	{
-		throw std::runtime_error("Failed to load OBJ model!");
+		std::vector<Vertex> vertices{};
+		std::vector<std::uint32_t> triangles{};
+		if (!read_obj_model("./stanford-bunny.obj", vertices, triangles))
+		{
+			throw std::runtime_error("Failed to load OBJ model!");
+		}
+		vertices.resize(gfx::optimize_mesh(vertices.data(), sizeof(Vertex), vertices.size(), triangles));
+		if (!gfx::write_mesh_file("./stanford-bunny.mesh", vertices.data(), sizeof(Vertex), vertices.size(), triangles) || !meshFile.open("./stanford-bunny.mesh"))
+		{
+			throw std::runtime_error("Failed to bake mesh file!");
+		}
 	}
 
-	gfx::BufferInfo vertexBufferInfo{
-		.type = gfx::BufferType::eVertex,
-		.size = sizeof(Vertex) * vertices.size(),
-	};
 	gfx::BufferHandle vertexBufferHandle{};
-	if (!gfx::create_buffer(vertexBufferHandle, deviceHandle, vertexBufferInfo))
-	{
-		throw std::runtime_error("Failed to create GFX vertex buffer!");
-	}
-
-	void* vertexBufferPtr{ nullptr };
-	if (gfx::map_buffer(vertexBufferHandle, vertexBufferPtr))
-	{
-		std::memcpy(vertexBufferPtr, vertices.data(), vertexBufferInfo.size);
-		gfx::unmap_buffer(vertexBufferHandle);
-	}
-
-	gfx::BufferInfo indexBufferInfo{
-		.type = gfx::BufferType::eIndex,
-		.size = sizeof(std::uint32_t) * triangles.size(),
-	};
 	gfx::BufferHandle indexBufferHandle{};
-	if (!gfx::create_buffer(indexBufferHandle, deviceHandle, indexBufferInfo))
+	gfx::SyncPoint uploadSyncPoint{};
+	if (!meshFile.upload(vertexBufferHandle, indexBufferHandle, uploadSyncPoint, deviceHandle))
 	{
-		throw std::runtime_error("Failed to create GFX index buffer!");
-	}
-
-	void* indexBufferPtr{ nullptr };
-	if (gfx::map_buffer(indexBufferHandle, indexBufferPtr))
-	{
-		std::memcpy(indexBufferPtr, triangles.data(), indexBufferInfo.size);
-		gfx::unmap_buffer(indexBufferHandle);
+		throw std::runtime_error("Failed to upload GFX mesh buffers!");
 	}
+	const auto indexType = meshFile.get_header().indexType;
+	const auto indexCount = meshFile.get_header().indexCount;
+	meshFile.close();
 #pragma endregion
 
-	gfx::CommandListHandle commandListHandle{};
-	if (!gfx::create_command_list(commandListHandle, deviceHandle, 0))
-	{
-		throw std::runtime_error("Failed to create GFX command list!");
-	}
-
 	double lastFrameTime = glfwGetTime();
 	glm::mat4 modelMat = glm::mat4(1.0f);
 	modelMat = glm::scale(modelMat, glm::vec3(8, 8, 8));
@@ -296,16 +279,25 @@ int main()
 
 		modelMat = glm::rotate(modelMat, glm::radians(45.0f) * deltaTime, glm::vec3(0, 1, 0));
 
-		gfx::reset(commandListHandle);
-		gfx::begin(commandListHandle);
+		gfx::begin_frame(deviceHandle);
 
 		gfx::TextureHandle swapChainImageHandle{};
 		if (!gfx::get_swap_chain_image(swapChainImageHandle, swapChainHandle))
 		{
-			throw std::runtime_error("Failed to get SwapChain image handle!");
+			// No image this frame (eg. the window is minimised), presenting retries the acquire.
+			gfx::present_swap_chain(swapChainHandle, 0, nullptr);
+			gfx::end_frame(deviceHandle);
+			continue;
 		}
 
-		gfx::transition_texture(commandListHandle, swapChainImageHandle, gfx::TextureState::eUndefined, gfx::TextureState::eRenderTarget);
+		gfx::CommandListHandle commandListHandle{};
+		if (!gfx::create_transient_command_list(commandListHandle, deviceHandle, 0))
+		{
+			throw std::runtime_error("Failed to create GFX command list!");
+		}
+		gfx::begin(commandListHandle);
+
+		gfx::transition_texture(commandListHandle, swapChainImageHandle, gfx::TextureState::eRenderTarget);
 
 		gfx::RenderPassInfo renderPassInfo{
 			.colorAttachments = { swapChainImageHandle },
@@ -321,27 +313,27 @@ int main()
 			gfx::bind_descriptor_set(commandListHandle, descriptorSetHandle);
 			gfx::set_constants(commandListHandle, gfx::ShaderStageFlags_Vertex, 0, sizeof(glm::mat4), glm::value_ptr(modelMat));
 
-			gfx::bind_index_buffer(commandListHandle, indexBufferHandle, gfx::IndexType::eUInt32);
+			gfx::bind_index_buffer(commandListHandle, indexBufferHandle, indexType);
 			gfx::bind_vertex_buffer(commandListHandle, vertexBufferHandle);
 
-			gfx::draw_indexed(commandListHandle, triangles.size(), 1, 0, 0, 0);
+			gfx::draw_indexed(commandListHandle, indexCount, 1, 0, 0, 0);
 		}
 		gfx::end_render_pass(commandListHandle);
 
-		gfx::transition_texture(commandListHandle, swapChainImageHandle, gfx::TextureState::eRenderTarget, gfx::TextureState::ePresent);
+		gfx::transition_texture(commandListHandle, swapChainImageHandle, gfx::TextureState::ePresent);
 
 		gfx::end(commandListHandle);
 
 		gfx::SubmitInfo submitInfo{
 			.commandList = commandListHandle,
-			.waitSemaphoreHandle = {}
+			.waitSemaphoreHandle = {},
+			.swapChainHandle = swapChainHandle,
 		};
-		gfx::FenceHandle fenceHandle;
-		gfx::submit_command_list(submitInfo, &fenceHandle, nullptr);
-
-		gfx::wait_on_fence(fenceHandle);
+		gfx::submit_command_list(submitInfo);
 
 		gfx::present_swap_chain(swapChainHandle, 0, nullptr);
+
+		gfx::end_frame(deviceHandle);
 	}
 
 	gfx::destroy_swap_chain(swapChainHandle);
@@ -125,11 +125,11 @@ int main()
 		.projMat = glm::perspectiveLH(glm::radians(60.0f), WINDOW_ASPECT_RATIO, 0.1f, 100.0f),
 		.viewMat = glm::lookAtLH(glm::vec3(-1, 2, -2), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0)),
 	};
-	void* bufferPtr{ nullptr };
-	if (gfx::map_buffer(uniformBufferHandle, bufferPtr))
+	// Uniform buffers are persistently mapped, so writing them needs no map/unmap.
+	if (void* bufferPtr = gfx::get_mapped_pointer(uniformBufferHandle); bufferPtr != nullptr)
 	{
 		std::memcpy(bufferPtr, &uniformData, sizeof(UniformData));
-		gfx::unmap_buffer(uniformBufferHandle);
+		gfx::flush_buffer_range(uniformBufferHandle);
 	}
 
 	gfx::DescriptorSetHandle descriptorSetHandle{};
@@ -139,12 +139,6 @@ int main()
 	}
 	gfx::bind_buffer_to_descriptor_set(descriptorSetHandle, 0, uniformBufferHandle);
 
-	gfx::CommandListHandle commandListHandle{};
-	if (!gfx::create_command_list(commandListHandle, deviceHandle, 0))
-	{
-		throw std::runtime_error("Failed to create GFX command list!");
-	}
-
 	double lastFrameTime = glfwGetTime();
 	glm::mat4 modelMat = glm::mat4(1.0f);
 	while (glfwWindowShouldClose(window) == 0)
@@ -157,16 +151,25 @@ int main()
 
 		modelMat = glm::rotate(modelMat, glm::radians(45.0f) * deltaTime, glm::vec3(0, 1, 0));
 
-		gfx::reset(commandListHandle);
-		gfx::begin(commandListHandle);
+		gfx::begin_frame(deviceHandle);
 
 		gfx::TextureHandle swapChainImageHandle{};
 		if (!gfx::get_swap_chain_image(swapChainImageHandle, swapChainHandle))
 		{
-			throw std::runtime_error("Failed to get SwapChain image handle!");
+			// No image this frame (eg. the window is minimised), presenting retries the acquire.
+			gfx::present_swap_chain(swapChainHandle, 0, nullptr);
+			gfx::end_frame(deviceHandle);
+			continue;
+		}
+
+		gfx::CommandListHandle commandListHandle{};
+		if (!gfx::create_transient_command_list(commandListHandle, deviceHandle, 0))
+		{
+			throw std::runtime_error("Failed to create GFX command list!");
 		}
+		gfx::begin(commandListHandle);
 
-		gfx::transition_texture(commandListHandle, swapChainImageHandle, gfx::TextureState::eUndefined, gfx::TextureState::eRenderTarget);
+		gfx::transition_texture(commandListHandle, swapChainImageHandle, gfx::TextureState::eRenderTarget);
 
 		gfx::RenderPassInfo renderPassInfo{
 			.colorAttachments = { swapChainImageHandle },
@@ -186,20 +189,20 @@ int main()
 		}
 		gfx::end_render_pass(commandListHandle);
 
-		gfx::transition_texture(commandListHandle, swapChainImageHandle, gfx::TextureState::eRenderTarget, gfx::TextureState::ePresent);
+		gfx::transition_texture(commandListHandle, swapChainImageHandle, gfx::TextureState::ePresent);
 
 		gfx::end(commandListHandle);
 
 		gfx::SubmitInfo submitInfo{
 			.commandList = commandListHandle,
-			.waitSemaphoreHandle = {}
+			.waitSemaphoreHandle = {},
+			.swapChainHandle = swapChainHandle,
 		};
-		gfx::FenceHandle fenceHandle;
-		gfx::submit_command_list(submitInfo, &fenceHandle, nullptr);
-
-		gfx::wait_on_fence(fenceHandle);
+		gfx::submit_command_list(submitInfo);
 
 		gfx::present_swap_chain(swapChainHandle, 0, nullptr);
+
+		gfx::end_frame(deviceHandle);
 	}
 
 	gfx::destroy_swap_chain(swapChainHandle);
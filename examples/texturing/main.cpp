@@ -3,6 +3,7 @@
  */
 
 #include "gfx/gfx.hpp"
+#include "gfx/gfx_asset.hpp"
 
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
@@ -28,6 +29,8 @@
 
 #include <iostream>
 #include <fstream>
+#include <optional>
+#include <thread>
 
 using namespace sm;
 
@@ -118,25 +121,138 @@ bool read_obj_model(const std::string& filename, std::vector<Vertex>& outVertice
 	return true;
 }
 
-bool read_texture(const std::string& filename, std::vector<std::uint8_t>& outPixelData, std::int32_t& outWidth, std::int32_t& outHeight)
+bool read_texture_size(const std::string& filename, std::int32_t& outWidth, std::int32_t& outHeight)
 {
-	stbi_set_flip_vertically_on_load(true);
+	std::int32_t comp{};
+	return stbi_info(filename.c_str(), &outWidth, &outHeight, &comp) != 0;
+}
 
+// Decodes as RGBA8 into dst, e.g. an upload's slice of the staging ring, which must be exactly the image's size.
+bool read_texture(const std::string& filename, void* dst, std::uint64_t size)
+{
+	std::int32_t width{};
+	std::int32_t height{};
 	std::int32_t comp{};
-	auto* data = stbi_load(filename.c_str(), &outWidth, &outHeight, &comp, 4);
+	auto* data = stbi_load(filename.c_str(), &width, &height, &comp, 4);
 	if (data == nullptr)
 	{
-		outWidth = 0;
-		outHeight = 0;
 		return false;
 	}
 
-	const std::uint64_t dataSize = outWidth * outHeight * 4;
-	outPixelData.resize(dataSize);
-	std::memcpy(outPixelData.data(), data, dataSize);
+	const std::uint64_t dataSize = width * height * 4;
+	if (dataSize == size)
+	{
+		std::memcpy(dst, data, dataSize);
+	}
 
 	stbi_image_free(data);
-	return true;
+	return dataSize == size;
+}
+
+struct Ktx2Texture
+{
+	gfx::Format format{};
+	std::uint32_t width{};
+	std::uint32_t height{};
+	std::vector<std::vector<std::uint8_t>> levels; // Tightly packed, largest first.
+};
+
+auto convert_vk_format_to_format(std::uint32_t vkFormat) -> std::optional<gfx::Format>
+{
+	// VkFormat values, KTX2 stores them as is.
+	switch (vkFormat)
+	{
+		case 37: return gfx::Format::eRGBA8;
+		case 133: return gfx::Format::eBC1;
+		case 134: return gfx::Format::eBC1Srgb;
+		case 137: return gfx::Format::eBC3;
+		case 138: return gfx::Format::eBC3Srgb;
+		case 139: return gfx::Format::eBC4;
+		case 141: return gfx::Format::eBC5;
+		case 143: return gfx::Format::eBC6H;
+		case 145: return gfx::Format::eBC7;
+		case 146: return gfx::Format::eBC7Srgb;
+		case 147: return gfx::Format::eETC2RGB8;
+		case 151: return gfx::Format::eETC2RGBA8;
+		case 157: return gfx::Format::eASTC4x4;
+		case 158: return gfx::Format::eASTC4x4Srgb;
+		default: return std::nullopt;
+	}
+}
+
+/**
+ * @brief Read a single 2D image with its mip chain from a KTX2 file, with the levels already in a GPU format.
+ * Supercompressed files (Basis Universal, Zstandard) need a transcoder first, e.g. basisu or ktx transcode.
+ */
+bool read_ktx2_texture(const std::string& filename, Ktx2Texture& outTexture)
+{
+	std::ifstream file{ filename, std::ios::binary };
+	if (!file)
+	{
+		return false;
+	}
+
+	constexpr std::uint8_t IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	struct Header
+	{
+		std::uint8_t identifier[12];
+		std::uint32_t vkFormat;
+		std::uint32_t typeSize;
+		std::uint32_t pixelWidth;
+		std::uint32_t pixelHeight;
+		std::uint32_t pixelDepth;
+		std::uint32_t layerCount;
+		std::uint32_t faceCount;
+		std::uint32_t levelCount;
+		std::uint32_t supercompressionScheme;
+		std::uint32_t dfdByteOffset;
+		std::uint32_t dfdByteLength;
+		std::uint32_t kvdByteOffset;
+		std::uint32_t kvdByteLength;
+		std::uint64_t sgdByteOffset;
+		std::uint64_t sgdByteLength;
+	};
+	struct LevelIndex
+	{
+		std::uint64_t byteOffset;
+		std::uint64_t byteLength;
+		std::uint64_t uncompressedByteLength;
+	};
+
+	Header header{};
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.identifier, IDENTIFIER, sizeof(IDENTIFIER)) != 0)
+	{
+		GFX_LOG_ERR_FMT("Example - texturing - Not a KTX2 file: {}", filename);
+		return false;
+	}
+	if (header.supercompressionScheme != 0)
+	{
+		GFX_LOG_ERR_FMT("Example - texturing - Supercompressed KTX2 files must be transcoded first: {}", filename);
+		return false;
+	}
+	const auto format = convert_vk_format_to_format(header.vkFormat);
+	if (!format || header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1)
+	{
+		GFX_LOG_ERR_FMT("Example - texturing - Unsupported KTX2 format or layout: {}", filename);
+		return false;
+	}
+
+	const auto levelCount = std::max(header.levelCount, 1u);
+	std::vector<LevelIndex> levelIndices(levelCount);
+	file.read(reinterpret_cast<char*>(levelIndices.data()), sizeof(LevelIndex) * levelCount);
+
+	outTexture.format = *format;
+	outTexture.width = header.pixelWidth;
+	outTexture.height = header.pixelHeight;
+	outTexture.levels.resize(levelCount);
+	for (auto level = 0u; level < levelCount; ++level)
+	{
+		auto& data = outTexture.levels[level];
+		data.resize(levelIndices[level].byteLength);
+		file.seekg(std::streamoff(levelIndices[level].byteOffset));
+		file.read(reinterpret_cast<char*>(data.data()), std::streamsize(data.size()));
+	}
+	return bool(file);
 }
 
 struct UniformData
@@ -171,6 +287,7 @@ int main()
 	gfx::DeviceInfo device_info{
 		.deviceFlags = gfx::DeviceFlags_PreferDiscrete,
 		.queueFlags = { gfx::QueueFlags_Graphics },
+		.uploadBufferSize = 32 * 1024 * 1024,
 	};
 	gfx::DeviceHandle deviceHandle{};
 	if (!gfx::create_device(deviceHandle, device_info))
@@ -200,6 +317,7 @@ int main()
 		.width = WINDOW_WIDTH,
 		.height = WINDOW_HEIGHT,
 		.format = gfx::Format::eDepth16,
+		.memory = gfx::TextureMemory::eTransient,
 	};
 	gfx::TextureHandle depthTextureHandle{};
 	if (!gfx::create_texture(depthTextureHandle, deviceHandle, depthTextureInfo))
@@ -279,12 +397,7 @@ int main()
 		throw std::runtime_error("Failed to create GFX vertex buffer!");
 	}
 
-	void* vertexBufferPtr{ nullptr };
-	if (gfx::map_buffer(vertexBufferHandle, vertexBufferPtr))
-	{
-		std::memcpy(vertexBufferPtr, vertices.data(), vertexBufferInfo.size);
-		gfx::unmap_buffer(vertexBufferHandle);
-	}
+	gfx::upload_buffer(vertexBufferHandle, vertices.data(), vertexBufferInfo.size);
 
 	gfx::BufferInfo indexBufferInfo{
 		.type = gfx::BufferType::eIndex,
@@ -296,32 +409,35 @@ int main()
 		throw std::runtime_error("Failed to create GFX index buffer!");
 	}
 
-	void* indexBufferPtr{ nullptr };
-	if (gfx::map_buffer(indexBufferHandle, indexBufferPtr))
-	{
-		std::memcpy(indexBufferPtr, triangles.data(), indexBufferInfo.size);
-		gfx::unmap_buffer(indexBufferHandle);
-	}
+	gfx::upload_buffer(indexBufferHandle, triangles.data(), indexBufferInfo.size);
 
 #pragma endregion
 
 #pragma region Texture
 
-	std::vector<std::uint8_t> pixels{};
-	std::int32_t width{};
-	std::int32_t height{};
-	if (!read_texture("./viking_room.png", pixels, width, height))
+	// Prefer a block-compressed version with its mip chain, which is uploaded as is at a fraction of the size.
+	Ktx2Texture ktxTexture{};
+	const bool isKtx2 = read_ktx2_texture("./viking_room.ktx2", ktxTexture);
+	if (!isKtx2)
 	{
-		throw std::runtime_error("Failed to read texture!");
+		std::int32_t width{};
+		std::int32_t height{};
+		if (!read_texture_size("./viking_room.png", width, height))
+		{
+			throw std::runtime_error("Failed to read texture!");
+		}
+		ktxTexture.format = gfx::Format::eRGBA8;
+		ktxTexture.width = static_cast<std::uint32_t>(width);
+		ktxTexture.height = static_cast<std::uint32_t>(height);
 	}
 
 	gfx::TextureInfo textureInfo{
 		.usage = gfx::TextureUsage::eTexture,
 		.type = gfx::TextureType::e2D,
-		.width = static_cast<std::uint32_t>(width),
-		.height = static_cast<std::uint32_t>(height),
-		.format = gfx::Format::eRGBA8,
-		.mipLevels = 1,
+		.width = ktxTexture.width,
+		.height = ktxTexture.height,
+		.format = ktxTexture.format,
+		.mipLevels = isKtx2 ? static_cast<std::uint32_t>(ktxTexture.levels.size()) : 1u,
 	};
 	gfx::TextureHandle textureHandle{};
 	if (!gfx::create_texture(textureHandle, deviceHandle, textureInfo))
@@ -329,55 +445,36 @@ int main()
 		throw std::runtime_error("Failed to create GFX texture!");
 	}
 
-	// Create & Submit command list to upload texture data
+	// Staged into the device's upload ring and copied by one batched submission, without blocking.
+	for (std::uint32_t level = 0; level < ktxTexture.levels.size(); ++level)
 	{
-		// Create staging buffer
-		gfx::BufferInfo stagingBufferInfo{
-			.type = gfx::BufferType::eUpload,
-			.size = sizeof(std::uint8_t) * pixels.size(),
-		};
-		gfx::BufferHandle stagingBufferHandle{};
-		if (!gfx::create_buffer(stagingBufferHandle, deviceHandle, stagingBufferInfo))
-		{
-			throw std::runtime_error("Failed to create GFX staging buffer!");
-		}
-
-		void* stagingBufferPtr{ nullptr };
-		if (gfx::map_buffer(stagingBufferHandle, stagingBufferPtr))
+		const auto& data = ktxTexture.levels[level];
+		if (!gfx::queue_texture_upload(textureHandle, data.data(), sizeof(std::uint8_t) * data.size(), level))
 		{
-			std::memcpy(stagingBufferPtr, pixels.data(), stagingBufferInfo.size);
-			gfx::unmap_buffer(stagingBufferHandle);
+			throw std::runtime_error("Failed to queue GFX texture upload!");
 		}
+	}
+	gfx::flush_uploads(deviceHandle, 0);
 
-		gfx::CommandListHandle uploadCommandListHandle{};
-		if (!gfx::create_command_list(uploadCommandListHandle, deviceHandle, 0))
-		{
-			throw std::runtime_error("Failed to create GFX upload command list!");
-		}
-
-		gfx::begin(uploadCommandListHandle);
-
-		gfx::transition_texture(uploadCommandListHandle, textureHandle, gfx::TextureState::eUndefined, gfx::TextureState::eUploadDst);
-		gfx::copy_buffer_to_texture(uploadCommandListHandle, stagingBufferHandle, textureHandle);
-		gfx::transition_texture(uploadCommandListHandle, textureHandle, gfx::TextureState::eUploadDst, gfx::TextureState::eShaderRead);
-
-		gfx::end(uploadCommandListHandle);
-
-		gfx::SubmitInfo submitInfo{
-			.commandList = uploadCommandListHandle,
-			.waitSemaphoreHandle = {}
-		};
-		gfx::FenceHandle fenceHandle;
-		gfx::submit_command_list(submitInfo, &fenceHandle, nullptr);
-
-		gfx::wait_on_fence(fenceHandle);
-		gfx::destroy_command_list(deviceHandle, uploadCommandListHandle);
-		gfx::destroy_buffer(stagingBufferHandle);
+	// A PNG is decoded on a worker thread, straight into its slice of the upload ring. A level's worth of textures would be
+	// loaded the same way, decoding in parallel while this thread only hands out staging space.
+	gfx::AssetLoader assetLoader(deviceHandle);
+	if (!isKtx2)
+	{
+		stbi_set_flip_vertically_on_load(true);
+		assetLoader.load_texture(textureHandle, 0, [](void* dst, std::uint64_t size) { return read_texture("./viking_room.png", dst, size); });
+	}
+	while (assetLoader.get_pending_count() > 0)
+	{
+		assetLoader.update(0);
+		std::this_thread::yield();
 	}
 
 	gfx::SamplerInfo samplerInfo{
 		.addressMode = gfx::SamplerAddressMode::eRepeat,
 		.filterMode = gfx::SamplerFilterMode::eLinear,
+		.mipFilterMode = gfx::SamplerFilterMode::eLinear,
+		.maxAnisotropy = 8.0f,
 	};
 	gfx::SamplerHandle samplerHandle{};
 	if (!gfx::create_sampler(samplerHandle, deviceHandle, samplerInfo))
@@ -389,12 +486,6 @@ int main()
 
 #pragma endregion
 
-	gfx::CommandListHandle commandListHandle{};
-	if (!gfx::create_command_list(commandListHandle, deviceHandle, 0))
-	{
-		throw std::runtime_error("Failed to create GFX command list!");
-	}
-
 	glm::mat4 modelMat = glm::mat4(1.0f);
 	modelMat = glm::scale(modelMat, glm::vec3(1.5f, 1.5f, 1.5f));
 	while (glfwWindowShouldClose(window) == 0)
@@ -402,16 +493,25 @@ int main()
 
 		glfwPollEvents();
 
-		gfx::reset(commandListHandle);
-		gfx::begin(commandListHandle);
+		gfx::begin_frame(deviceHandle);
 
 		gfx::TextureHandle swapChainImageHandle{};
 		if (!gfx::get_swap_chain_image(swapChainImageHandle, swapChainHandle))
 		{
-			throw std::runtime_error("Failed to get SwapChain image handle!");
+			// No image this frame (eg. the window is minimised), presenting retries the acquire.
+			gfx::present_swap_chain(swapChainHandle, 0, nullptr);
+			gfx::end_frame(deviceHandle);
+			continue;
 		}
 
-		gfx::transition_texture(commandListHandle, swapChainImageHandle, gfx::TextureState::eUndefined, gfx::TextureState::eRenderTarget);
+		gfx::CommandListHandle commandListHandle{};
+		if (!gfx::create_transient_command_list(commandListHandle, deviceHandle, 0))
+		{
+			throw std::runtime_error("Failed to create GFX command list!");
+		}
+		gfx::begin(commandListHandle);
+
+		gfx::transition_texture(commandListHandle, swapChainImageHandle, gfx::TextureState::eRenderTarget);
 
 		gfx::RenderPassInfo renderPassInfo{
 			.colorAttachments = { swapChainImageHandle },
@@ -434,20 +534,20 @@ int main()
 		}
 		gfx::end_render_pass(commandListHandle);
 
-		gfx::transition_texture(commandListHandle, swapChainImageHandle, gfx::TextureState::eRenderTarget, gfx::TextureState::ePresent);
+		gfx::transition_texture(commandListHandle, swapChainImageHandle, gfx::TextureState::ePresent);
 
 		gfx::end(commandListHandle);
 
 		gfx::SubmitInfo submitInfo{
 			.commandList = commandListHandle,
-			.waitSemaphoreHandle = {}
+			.waitSemaphoreHandle = {},
+			.swapChainHandle = swapChainHandle,
 		};
-		gfx::FenceHandle fenceHandle;
-		gfx::submit_command_list(submitInfo, &fenceHandle, nullptr);
-
-		gfx::wait_on_fence(fenceHandle);
+		gfx::submit_command_list(submitInfo);
 
 		gfx::present_swap_chain(swapChainHandle, 0, nullptr);
+
+		gfx::end_frame(deviceHandle);
 	}
 
 	gfx::destroy_swap_chain(swapChainHandle);
@@ -8,7 +8,10 @@
 #include <array>
 #include <cstdint>
 #include <functional>
+#include <span>
+#include <string>
 #include <string_view>
+#include <vector>
 
 #ifndef GFX_UNUSED
 	#define GFX_UNUSED(_x) (void)(_x)
@@ -32,17 +35,58 @@
 	#endif
 #endif
 
+// Defined by the gfx_DISABLE_VALIDATION CMake option for non-Debug builds.
+#if defined(GFX_DISABLE_VALIDATION)
+	#define GFX_VALIDATION_ENABLED 0
+#else
+	#define GFX_VALIDATION_ENABLED 1
+#endif
+
+// Defined by the gfx_ENABLE_FRAME_STATS CMake option.
+#if defined(GFX_ENABLE_FRAME_STATS)
+	#define GFX_FRAME_STATS_ENABLED 1
+#else
+	#define GFX_FRAME_STATS_ENABLED 0
+#endif
+
+// Defined by the gfx_ENABLE_CAPTURE CMake option.
+#if defined(GFX_ENABLE_CAPTURE)
+	#define GFX_CAPTURE_ENABLED 1
+#else
+	#define GFX_CAPTURE_ENABLED 0
+#endif
+
+// Defined by the gfx_ENABLE_TRACY CMake option. Zones are named by string literals.
+#if defined(GFX_ENABLE_TRACY)
+	#include <tracy/Tracy.hpp>
+	#define GFX_TRACY_ENABLED 1
+	#define GFX_PROFILE_ZONE(_name) ZoneScopedN(_name)
+#else
+	#define GFX_TRACY_ENABLED 0
+	#define GFX_PROFILE_ZONE(_name) ((void)0)
+#endif
+
 #ifndef GFX_ASSERT
-	#define GFX_ASSERT(_expr, _msg) \
-		do                          \
-		{                           \
-			if (!(_expr))           \
-			{                       \
-				GFX_LOG_ERR(_msg);  \
-				GFX_DEBUG_BREAK();  \
-			}                       \
-		}                           \
-		while (false)
+	#if GFX_VALIDATION_ENABLED
+		#define GFX_ASSERT(_expr, _msg) \
+			do                          \
+			{                           \
+				if (!(_expr))           \
+				{                       \
+					GFX_LOG_ERR(_msg);  \
+					GFX_DEBUG_BREAK();  \
+				}                       \
+			}                           \
+			while (false)
+	#else
+		// The expression is never evaluated, but still counts as a use of any variables it names.
+		#define GFX_ASSERT(_expr, _msg) \
+			do                          \
+			{                           \
+				(void)sizeof(_expr);    \
+			}                           \
+			while (false)
+	#endif
 #endif
 
 #define GFX_DISABLE_COPY(_className)        \
@@ -78,6 +122,20 @@
 
 #define CAST_HANDLE_TO_INT(_handle) static_cast<std::uint32_t>(_handle)
 
+// The Vulkan Video std structs of vk_video/vulkan_video_codec_*std*.h, taken by the video decoding functions.
+struct StdVideoH264SequenceParameterSet;
+struct StdVideoH264PictureParameterSet;
+struct StdVideoDecodeH264PictureInfo;
+struct StdVideoDecodeH264ReferenceInfo;
+struct StdVideoH265VideoParameterSet;
+struct StdVideoH265SequenceParameterSet;
+struct StdVideoH265PictureParameterSet;
+struct StdVideoDecodeH265PictureInfo;
+struct StdVideoDecodeH265ReferenceInfo;
+struct StdVideoAV1SequenceHeader;
+struct StdVideoDecodeAV1PictureInfo;
+struct StdVideoDecodeAV1ReferenceInfo;
+
 namespace sm
 {
 	template <class T>
@@ -94,7 +152,6 @@ namespace sm::gfx
 	GFX_DEFINE_HANDLE(DeviceHandle);
 	GFX_DEFINE_HANDLE(ResourceHandle);
 	GFX_DEFINE_RESOURCE_HANDLE(CommandListHandle);
-	GFX_DEFINE_RESOURCE_HANDLE(FenceHandle);
 	GFX_DEFINE_RESOURCE_HANDLE(SemaphoreHandle);
 	GFX_DEFINE_RESOURCE_HANDLE(PipelineHandle);
 	GFX_DEFINE_RESOURCE_HANDLE(DescriptorSetHandle);
@@ -102,14 +159,36 @@ namespace sm::gfx
 	GFX_DEFINE_RESOURCE_HANDLE(TextureHandle);
 	GFX_DEFINE_RESOURCE_HANDLE(SamplerHandle);
 	GFX_DEFINE_RESOURCE_HANDLE(SwapChainHandle);
+	GFX_DEFINE_RESOURCE_HANDLE(BundleHandle);
+	GFX_DEFINE_RESOURCE_HANDLE(BufferArenaHandle);
+	GFX_DEFINE_RESOURCE_HANDLE(ReadbackHandle);
+	GFX_DEFINE_RESOURCE_HANDLE(AccelerationStructureHandle);
+	GFX_DEFINE_RESOURCE_HANDLE(MemoryHeapHandle);
+	GFX_DEFINE_RESOURCE_HANDLE(VideoDecoderHandle);
 
+	// May be called at any time, from any thread. The callback itself can be called from any thread gfx calls are made on.
 	void set_error_callback(std::function<void(const char* msg)> callback);
 
+	enum class DebugLevel
+	{
+		eOff,						// No layers or debug extensions, nothing is paid per Vulkan call.
+		eLabels,					// Only VK_EXT_debug_utils, for markers and object names in debuggers and GPU profilers.
+		eValidation,				// eLabels and the Khronos validation layer.
+		eSynchronizationValidation, // eValidation with synchronization validation, which slows it further.
+		eGpuAssisted,				// eValidation with GPU-assisted validation of shader accesses, the slowest.
+	};
 	struct AppInfo
 	{
 		std::string appName;
 		std::string engineName;
+		bool headless{ false }; // Skip the window system extensions. Only headless swap chains can be created. See DeviceInfo::computeOnly.
+		// Validation levels fall back to eLabels where the validation layer is not installed.
+		DebugLevel debugLevel{ DebugLevel::eValidation };
 	};
+	/**
+	 * Every other call is safe from any thread between initialise() and shutdown(), with no global lock. The two of them must
+	 * not overlap any other call, and a device must not be used while destroy_device() destroys it.
+	 */
 	bool initialise(const AppInfo& appInfo);
 	void shutdown();
 
@@ -119,17 +198,464 @@ namespace sm::gfx
 	constexpr std::uint32_t QueueFlags_Graphics = 1u << 0u;
 	constexpr std::uint32_t QueueFlags_Compute = 1u << 1u;
 	constexpr std::uint32_t QueueFlags_Transfer = 1u << 2u;
+	constexpr std::uint32_t QueueFlags_SparseBinding = 1u << 3u; // For bind_sparse_buffer_pages() and bind_sparse_texture_tiles().
+	constexpr std::uint32_t QueueFlags_VideoDecode = 1u << 4u;	 // For decode_video_frame(), with DeviceFeatureFlags_VideoDecode.
+
+	// Optional device features, for DeviceInfo::requestedFeatures and requiredFeatures. Those marked as enabled where supported
+	// are on regardless, listing them only makes them required.
+	constexpr std::uint32_t DeviceFeatureFlags_MultiDrawIndirect = 1u << 0u;   // Enabled where supported.
+	constexpr std::uint32_t DeviceFeatureFlags_DrawIndirectCount = 1u << 1u;   // Enabled where supported.
+	constexpr std::uint32_t DeviceFeatureFlags_SamplerAnisotropy = 1u << 2u;   // Enabled where supported.
+	constexpr std::uint32_t DeviceFeatureFlags_ImageCubeArray = 1u << 3u;	   // Enabled where supported.
+	constexpr std::uint32_t DeviceFeatureFlags_BufferDeviceAddress = 1u << 4u; // Enabled where supported.
+	constexpr std::uint32_t DeviceFeatureFlags_SparseBuffers = 1u << 5u;	   // Enabled where supported.
+	constexpr std::uint32_t DeviceFeatureFlags_SparseTextures = 1u << 6u;	   // Enabled where supported.
+	constexpr std::uint32_t DeviceFeatureFlags_MeshShader = 1u << 7u;		   // Enabled where supported.
+	constexpr std::uint32_t DeviceFeatureFlags_ShaderInt16 = 1u << 8u;
+	constexpr std::uint32_t DeviceFeatureFlags_ShaderInt64 = 1u << 9u;
+	constexpr std::uint32_t DeviceFeatureFlags_ShaderFloat16 = 1u << 10u;
+	constexpr std::uint32_t DeviceFeatureFlags_ShaderInt8 = 1u << 11u;
+	constexpr std::uint32_t DeviceFeatureFlags_Storage16Bit = 1u << 12u; // 16-bit types in uniform and storage buffers and push constants.
+	constexpr std::uint32_t DeviceFeatureFlags_Storage8Bit = 1u << 13u;	 // 8-bit types in uniform and storage buffers.
+	constexpr std::uint32_t DeviceFeatureFlags_ScalarBlockLayout = 1u << 14u;
+	constexpr std::uint32_t DeviceFeatureFlags_ShaderDrawParameters = 1u << 15u; // SV_StartVertexLocation and SV_StartInstanceLocation.
+	constexpr std::uint32_t DeviceFeatureFlags_SubgroupSizeControl = 1u << 16u;
+	constexpr std::uint32_t DeviceFeatureFlags_IndependentBlend = 1u << 17u; // colorBlendStates differing between attachments.
+	constexpr std::uint32_t DeviceFeatureFlags_FragmentStoresAndAtomics = 1u << 18u;
+	constexpr std::uint32_t DeviceFeatureFlags_VertexPipelineStoresAndAtomics = 1u << 19u;
+	constexpr std::uint32_t DeviceFeatureFlags_StorageImageWriteWithoutFormat = 1u << 20u;
+	constexpr std::uint32_t DeviceFeatureFlags_VertexAttributeDivisor = 1u << 21u; // Enabled where supported. VertexBinding::divisor other than 1.
+	constexpr std::uint32_t DeviceFeatureFlags_Multiview = 1u << 22u;			   // Enabled where supported. RenderPassInfo::viewMask and GraphicsPipelineInfo::viewMask.
+	constexpr std::uint32_t DeviceFeatureFlags_ShadingRate = 1u << 23u;			   // Enabled where supported. set_shading_rate() and RenderPassInfo::shadingRateAttachment.
+	constexpr std::uint32_t DeviceFeatureFlags_ConditionalRendering = 1u << 24u;  // Enabled where supported. begin_conditional() and BufferInfo::predicate.
+	constexpr std::uint32_t DeviceFeatureFlags_RayQuery = 1u << 25u;			   // Acceleration structures, traced with ray queries from any shader stage.
+	constexpr std::uint32_t DeviceFeatureFlags_LocalRead = 1u << 26u;			   // Enabled where supported. RenderPassInfo::localRead and DescriptorType::eInputAttachment.
+	constexpr std::uint32_t DeviceFeatureFlags_InlineUniformBlock = 1u << 27u;	   // Enabled where supported. DescriptorType::eInlineUniformBlock.
+	constexpr std::uint32_t DeviceFeatureFlags_ExternalMemory = 1u << 28u;	   // Memory and semaphores shared with other processes and APIs, see export_buffer_memory().
+	constexpr std::uint32_t DeviceFeatureFlags_VideoDecode = 1u << 29u;		   // Hardware video decoding into textures, see create_video_decoder().
+
+	/**
+	 * @brief System-wide scheduling priority of a queue relative to other processes (VK_EXT_global_priority).
+	 * Ignored when unsupported. eHigh and eRealtime may need elevated privileges, the device falls back to eDefault if denied.
+	 */
+	enum class QueueGlobalPriority
+	{
+		eDefault,
+		eLow,
+		eMedium,
+		eHigh,
+		eRealtime,
+	};
+
+	/**
+	 * @brief Runs gfx's background work on an engine's own job system, so gfx does not start threads competing with it: async
+	 * pipeline compilation, optimising fast-linked pipelines, translating deferred command lists and, given to a render
+	 * graph, recording its passes. Implementations must be thread safe.
+	 */
+	class TaskScheduler
+	{
+	public:
+		virtual ~TaskScheduler() = default;
+
+		/**
+		 * @brief Run the task once, on any thread. It must not depend on the enqueuing thread to make progress, as that thread
+		 * may block until the task is done, so run it inline if there is no other thread to run it on.
+		 */
+		virtual void enqueue(std::function<void()>&& task) = 0;
+		// Tasks that can run at once, which parallel work is split into.
+		virtual auto get_thread_count() const -> std::uint32_t = 0;
+	};
 
 	struct DeviceInfo
 	{
 		std::uint32_t deviceFlags;			   // Properties used to help choose a device
 		std::vector<std::uint32_t> queueFlags; // The wanted queue types (The indices of the queues will be used for queue-related operations)
+		std::vector<float> queuePriorities;	   // Priority in [0, 1] of each wanted queue relative to others in its family. Missing entries default to 1.
+		std::vector<QueueGlobalPriority> queueGlobalPriorities; // Global priority of each wanted queue. Queues sharing a family use the highest.
+		std::uint32_t framesInFlight{ 2 };	   // Number of frames the CPU can record ahead. Each gets its own command pools.
+		bool threadedSubmission{ false };	   // Submit and present on a dedicated thread, so the calling thread never blocks in the driver.
+		std::uint64_t transientBufferSize{ 0 }; // Bytes per frame in flight available to allocate_transient(). 0 disables it.
+		std::uint64_t uploadBufferSize{ 0 };	// Size of the staging ring used by queue_buffer_upload()/queue_texture_upload(). 0 disables it.
+		std::uint32_t uploadQueueIndex{ 0 };	// Queue those uploads are copied on, ideally a transfer queue.
+		std::uint32_t bindlessTextureCount{ 0 };	   // Slots in each array of the bindless heap (see get_bindless_heap()).
+		std::uint32_t bindlessSamplerCount{ 0 };	   // All 0 creates no heap, and values are clamped to the device limits.
+		std::uint32_t bindlessStorageBufferCount{ 0 };
+		/**
+		 * Bytes of descriptor memory to store every descriptor set in with VK_EXT_descriptor_buffer, where supported, so writing
+		 * descriptors is a memory copy and binding sets only sets offsets. Half is for persistent sets and the bindless heap, the
+		 * rest is split between frames in flight for transient sets. Dynamic descriptor types are unavailable with it, and
+		 * uniform and storage buffers get device addresses. 0 keeps descriptor pools.
+		 */
+		std::uint64_t descriptorBufferSize{ 0 };
+		/**
+		 * File the device's pipeline cache is loaded from, and saved to when the device is destroyed, so pipelines compiled by
+		 * an earlier run skip the driver compiler. A file written by another device or driver is ignored. Empty keeps the
+		 * cache in memory only.
+		 */
+		std::string pipelineCachePath{};
+		/**
+		 * File every distinct pipeline the device creates is recorded to, adding to those recorded by earlier runs, for
+		 * prewarm_pipelines() to compile ahead of use. Empty records nothing. Typically set in development and QA builds, whose
+		 * manifest ships with the game.
+		 */
+		std::string pipelineManifestPath{};
+		/**
+		 * Back graphics pipelines with VK_EXT_shader_object where supported. Creating one then only compiles its shaders, one
+		 * per stage, and binding it binds them and sets every piece of its state dynamically, so there is no pipeline compile.
+		 */
+		bool shaderObjects{ false };
+		/**
+		 * Timestamp scopes each frame in flight can record with begin_gpu_scope(). 0 disables them. Needs the hostQueryReset feature.
+		 * With the gfx_ENABLE_TRACY CMake option, calibrated scopes are also sent to Tracy as GPU zones.
+		 */
+		std::uint32_t gpuScopesPerFrame{ 0 };
+		/**
+		 * Queries of each type each frame in flight can record with begin_gpu_query(). 0 disables them. Needs the hostQueryReset
+		 * feature, and pipeline statistics the pipelineStatisticsQuery feature.
+		 */
+		std::uint32_t gpuQueriesPerFrame{ 0 };
+		// Threads compiling async pipelines, optimising fast-linked ones and translating deferred command lists. 0 uses half the hardware threads.
+		std::uint32_t workerThreadCount{ 0 };
+		// Runs that work instead of gfx's own worker threads, which are then never started. Must outlive the device.
+		// Only threadedSubmission still starts its thread, as submissions must stay in order on one thread.
+		TaskScheduler* taskScheduler{ nullptr };
+		std::uint32_t requestedFeatures{ 0 }; // DeviceFeatureFlags_ to enable where the device supports them.
+		std::uint32_t requiredFeatures{ 0 };  // DeviceFeatureFlags_ without which create_device() fails.
+		/**
+		 * Create the device over every GPU of the chosen one's device group (linked GPUs of one vendor), for alternate or split
+		 * frame rendering. Command lists run on all of them unless SubmitBatch::deviceMask or set_device_mask() picks some,
+		 * and each GPU gets its own instance of device local memory, so resources are per GPU. Falls back to the one GPU
+		 * when it is not part of a larger group.
+		 */
+		bool deviceGroup{ false };
+		/**
+		 * For compute and transfer work only, e.g. GPGPU workers without a display. Startup skips the rendering extensions
+		 * and their feature queries, and, like AppInfo::headless, the swap chain ones. Queues cannot ask for
+		 * QueueFlags_Graphics, and graphics pipelines, render passes and swap chains cannot be created.
+		 */
+		bool computeOnly{ false };
 	};
 
 	bool create_device(DeviceHandle& outDeviceHandle, const DeviceInfo& deviceInfo);
 	void destroy_device(DeviceHandle deviceHandle);
 
+	struct AsyncInitialiseResult
+	{
+		DeviceHandle deviceHandle{}; // Invalid if initialisation failed.
+		std::vector<PipelineHandle> prewarmedPipelines{}; // See prewarm_pipelines().
+	};
+	/**
+	 * @brief Run initialise() and create_device(), which together take hundreds of milliseconds, on a background thread, so
+	 * the application can create its window and start loading files meanwhile. Nothing else but set_error_callback() may be
+	 * called until wait_for_initialise() has returned true.
+	 * @param prewarmManifestPath If set, prewarm_pipelines() starts on the same thread as soon as the device is created.
+	 */
+	bool initialise_async(const AppInfo& appInfo, const DeviceInfo& deviceInfo, std::string prewarmManifestPath = {});
+	/**
+	 * @brief Poll (timeout 0) or wait for initialise_async().
+	 * @return False while it is still running. Once true, initialisation has finished, successfully if the device handle is valid.
+	 */
+	bool wait_for_initialise(AsyncInitialiseResult& outResult, std::uint64_t timeoutNs);
+
 	void wait_for_device_idle(DeviceHandle deviceHandle);
+	/**
+	 * @brief Write the pipeline cache to DeviceInfo::pipelineCachePath now, eg. after loading a level, rather than only when the device is destroyed.
+	 */
+	bool save_pipeline_cache(DeviceHandle deviceHandle);
+
+	enum class DeviceType
+	{
+		eOther,
+		eIntegrated,
+		eDiscrete,
+		eVirtual,
+		eCpu,
+	};
+	constexpr std::uint32_t SubgroupOperationFlags_Basic = 1u << 0u;
+	constexpr std::uint32_t SubgroupOperationFlags_Vote = 1u << 1u;
+	constexpr std::uint32_t SubgroupOperationFlags_Arithmetic = 1u << 2u;
+	constexpr std::uint32_t SubgroupOperationFlags_Ballot = 1u << 3u;
+	constexpr std::uint32_t SubgroupOperationFlags_Shuffle = 1u << 4u;
+	constexpr std::uint32_t SubgroupOperationFlags_ShuffleRelative = 1u << 5u;
+	constexpr std::uint32_t SubgroupOperationFlags_Clustered = 1u << 6u;
+	constexpr std::uint32_t SubgroupOperationFlags_Quad = 1u << 7u;
+	struct DeviceMemoryHeap
+	{
+		std::uint64_t size{ 0 };
+		bool deviceLocal{ false };
+		bool hostVisible{ false }; // Has a memory type the CPU can map.
+	};
+	struct DeviceQueueProperties
+	{
+		std::uint32_t queueFlags{ 0 }; // QueueFlags_ of the queue's family, which can be more than were asked for.
+		std::uint32_t queueFamily{ 0 };
+		std::uint32_t timestampValidBits{ 0 }; // 0 if the queue cannot write timestamps.
+	};
+	struct DeviceProperties
+	{
+		std::string deviceName{};
+		DeviceType deviceType{ DeviceType::eOther };
+		std::uint32_t vendorId{ 0 };
+		std::uint32_t deviceId{ 0 };
+		std::uint32_t driverVersion{ 0 }; // Encoded by the vendor's own scheme.
+		std::uint32_t apiVersion{ 0 };	  // VK_MAKE_API_VERSION encoded.
+		std::uint32_t deviceGroupSize{ 1 }; // GPUs the device spans, see DeviceInfo::deviceGroup. Device masks have a bit per GPU.
+
+		// Limits.
+		std::uint32_t maxImageDimension2D{ 0 };
+		std::uint32_t maxImageDimension3D{ 0 };
+		std::uint32_t maxImageArrayLayers{ 0 };
+		std::uint32_t maxColorAttachments{ 0 };
+		std::uint32_t maxPushConstantsSize{ 0 };
+		std::uint32_t maxInlineUniformBlockSize{ 0 }; // 0 without DeviceFeatureFlags_InlineUniformBlock.
+		std::uint32_t maxBoundDescriptorSets{ 0 };
+		std::uint32_t maxUniformBufferRange{ 0 };
+		std::uint32_t maxStorageBufferRange{ 0 };
+		std::uint64_t minUniformBufferOffsetAlignment{ 0 };
+		std::uint64_t minStorageBufferOffsetAlignment{ 0 };
+		std::uint64_t optimalBufferCopyOffsetAlignment{ 0 };
+		std::uint64_t nonCoherentAtomSize{ 0 }; // Granularity of flush_buffer_range() on non-coherent memory.
+		std::array<std::uint32_t, 3> maxComputeWorkGroupCount{};
+		std::array<std::uint32_t, 3> maxComputeWorkGroupSize{};
+		std::uint32_t maxComputeWorkGroupInvocations{ 0 };
+		std::uint32_t maxComputeSharedMemorySize{ 0 };
+		std::uint32_t maxDrawIndirectCount{ 0 };
+		std::uint32_t maxMultiviewViewCount{ 0 }; // Highest view a RenderPassInfo::viewMask can render, plus one.
+		std::array<std::uint32_t, 2> shadingRateTexelSize{}; // Pixels covered by each texel of a shading rate attachment, 0 without DeviceFeatureFlags_ShadingRate.
+		bool shadingRateCombiners{ false };					 // ShadingRateCombiner::eMin and eMax are supported.
+		float maxSamplerAnisotropy{ 0.0f }; // 0 without the samplerAnisotropy feature.
+
+		// Subgroups, e.g. to size workgroups in multiples of subgroupSize.
+		std::uint32_t subgroupSize{ 0 }; // What compute shaders get unless they ask for a size in [minSubgroupSize, maxSubgroupSize].
+		std::uint32_t minSubgroupSize{ 0 };
+		std::uint32_t maxSubgroupSize{ 0 };
+		std::uint32_t requiredSubgroupSizeStages{ 0 }; // ShaderStageFlags_ that can ask for a subgroup size.
+		std::uint32_t subgroupStages{ 0 };	   // ShaderStageFlags_ supporting subgroup operations.
+		std::uint32_t subgroupOperations{ 0 }; // SubgroupOperationFlags_
+
+		// Memory.
+		std::vector<DeviceMemoryHeap> memoryHeaps{};
+		bool unifiedMemory{ false }; // All device local memory is host visible, so eGpuOnly buffers are mapped and their uploads written in place rather than staged.
+		bool resizableBar{ false };	 // Device local memory the CPU can map is larger than the 256MiB window, so BufferMemory::eDynamic buffers of any size are device local.
+		std::uint64_t uploadBufferSize{ 0 }; // DeviceInfo::uploadBufferSize. Queued uploads must be smaller.
+
+		// Timestamps.
+		float timestampPeriod{ 0.0f }; // Nanoseconds per tick.
+		bool calibratedTimestamps{ false }; // GPU scope times are on the CPU's clock, see GpuScopeTimings::calibrated.
+
+		std::vector<DeviceQueueProperties> queues{}; // By queue index.
+
+		// Optional features, enabled where the device supports them (and DeviceInfo asks for them, where it has a field for it).
+		std::uint32_t enabledFeatures{ 0 }; // DeviceFeatureFlags_ granted, requested or enabled where supported.
+		bool multiDrawIndirect{ false };
+		bool drawIndirectCount{ false };
+		bool imageCubeArray{ false };
+		bool bufferDeviceAddress{ false };
+		bool sparseBuffers{ false };
+		bool sparseTextures{ false };
+		bool bindless{ false };
+		bool descriptorBuffer{ false };
+		bool pushDescriptors{ false };
+		bool dynamicBlendState{ false };
+		bool graphicsPipelineLibrary{ false };
+		bool shaderObjects{ false };
+		bool meshShader{ false };
+		bool hostImageCopy{ false };
+		bool memoryBudget{ false };
+		bool memoryPriority{ false }; // BufferInfo::memoryPriority and TextureInfo::memoryPriority are honoured.
+		bool pageableMemory{ false }; // set_memory_priority() works.
+		bool pipelineStatistics{ false };
+		bool presentWait{ false };
+		bool lowLatency{ false };
+		bool antiLag{ false };
+
+		std::vector<std::string> enabledExtensions{};
+	};
+	/**
+	 * @brief Get what the device was created with: the physical device picked, its limits, subgroup and memory properties,
+	 * its queues and the optional features and extensions enabled, e.g. to choose workgroup sizes and upload paths at runtime.
+	 */
+	bool get_device_properties(DeviceProperties& outDeviceProperties, DeviceHandle deviceHandle);
+	/**
+	 * @brief DeviceInfo::taskScheduler, or gfx's own worker threads, for applications without a job system of their own.
+	 */
+	auto get_task_scheduler(DeviceHandle deviceHandle) -> TaskScheduler*;
+
+	/**
+	 * @brief Advance the device to its next frame in flight.
+	 * Command lists are allocated from per-thread command pools for the current frame, so any thread can record in parallel.
+	 * Blocks until the GPU has finished the last submissions made during the frame being reused, then recycles its
+	 * transient command lists. Must not be called while other threads are recording.
+	 * The CPU only blocks once it is framesInFlight frames ahead of the GPU.
+	 */
+	void begin_frame(DeviceHandle deviceHandle);
+	/**
+	 * @brief Close the current frame. Everything submitted since begin_frame() is what the frame's reuse will wait on.
+	 */
+	void end_frame(DeviceHandle deviceHandle);
+
+	struct TransientAllocation
+	{
+		void* ptr{ nullptr };
+		BufferHandle bufferHandle{}; // A BufferType::eTransient buffer shared by every allocation.
+		std::uint64_t offset{ 0 };	 // From the start of bufferHandle, e.g. the dynamic offset to bind it with.
+	};
+	/**
+	 * @brief Sub-allocate CPU written data (per-draw constants, vertices) from the current frame's part of a persistently mapped ring buffer.
+	 * Valid until begin_frame() reuses this frame, which reclaims the whole part at once. Thread safe.
+	 * @param alignment 0 uses the device's minimum uniform buffer offset alignment.
+	 * @return A null ptr if the frame's transientBufferSize is exhausted.
+	 */
+	auto allocate_transient(DeviceHandle deviceHandle, std::uint64_t size, std::uint64_t alignment = 0) -> TransientAllocation;
+
+	struct DefragmentationInfo
+	{
+		std::uint32_t queueIndex{ 0 };		// Queue the moved resources are used on, the copies are recorded on it too.
+		std::uint64_t maxBytesPerPass{ 0 }; // Bounds the copy work of a pass. 0 for no limit.
+		std::uint32_t maxMovesPerPass{ 0 }; // 0 for no limit.
+	};
+	/**
+	 * @brief Start compacting device memory with VMA's incremental defragmentation, driven by step_defragmentation().
+	 * Only buffers the host cannot see and sampled textures (in TextureState::eShaderRead) are moved, storage resources and
+	 * attachments stay put. Moved resources keep their handles, but should only be used on DefragmentationInfo::queueIndex
+	 * and not be uploaded to or copied into until defragmentation ends, as a write landing while its pass is in flight is lost.
+	 */
+	bool begin_defragmentation(DeviceHandle deviceHandle, const DefragmentationInfo& defragmentationInfo);
+	/**
+	 * @brief Advance defragmentation, call once per frame between frames like begin_frame().
+	 * A pass submits its copies, the first call to find them complete swaps in the moved objects and rewrites the descriptor
+	 * sets they are bound to, and a later call releases the old memory once the GPU no longer uses it.
+	 * Rewriting a descriptor set waits for the queues to drain, as descriptor sets cannot be updated while in use.
+	 * @return True while defragmentation still has work to do.
+	 */
+	bool step_defragmentation(DeviceHandle deviceHandle);
+	/**
+	 * @brief Stop defragmentation early. Blocks until the pass in flight, if any, has completed.
+	 */
+	void end_defragmentation(DeviceHandle deviceHandle);
+
+	struct MemoryHeapStats
+	{
+		bool deviceLocal{ false };
+		std::uint64_t size{ 0 };
+		std::uint64_t usage{ 0 };  // Bytes the process uses of the heap, including other APIs' and the driver's own allocations.
+		std::uint64_t budget{ 0 }; // Bytes the process can use before allocations start failing or spilling into slower memory.
+		std::uint64_t blockBytes{ 0 };		// Device memory allocated by this device from the heap,
+		std::uint64_t allocationBytes{ 0 }; // and the part of it occupied by resources.
+		std::uint32_t allocationCount{ 0 };
+	};
+	struct MemoryStats
+	{
+		std::vector<MemoryHeapStats> heaps;
+		bool budgetFromDriver{ false }; // VK_EXT_memory_budget is supported. Otherwise usage and budget are estimated from the heap sizes.
+		std::uint64_t bufferBytes{ 0 };
+		std::uint32_t bufferCount{ 0 };
+		std::uint64_t textureBytes{ 0 }; // Swap chain images are not included, the swap chain owns their memory.
+		std::uint32_t textureCount{ 0 };
+	};
+	/**
+	 * @brief Query per-heap usage and budget, and the totals of live buffers and textures.
+	 * The driver's budget is refreshed once per begin_frame(), usage also follows this device's allocations as they happen.
+	 */
+	bool get_memory_stats(MemoryStats& outMemoryStats, DeviceHandle deviceHandle);
+	/**
+	 * @brief Write a JSON report of the device's memory to path: the totals of get_memory_stats() under "gfx", and VMA's
+	 * detailed statistics under "vma". Its map lists every live allocation, named after the buffer or texture that owns it
+	 * (by type, then debugName), so resources that were never destroyed show up by name.
+	 */
+	bool dump_memory_report(DeviceHandle deviceHandle, std::string_view path);
+	/**
+	 * @brief Change the memory priority (see BufferInfo::memoryPriority) of a resource with its own allocation, e.g. to demote
+	 * a level's assets once it is left behind. Needs DeviceProperties::pageableMemory.
+	 * @return False if unsupported, or if the resource shares its allocation and so keeps its priority.
+	 */
+	bool set_memory_priority(BufferHandle bufferHandle, float memoryPriority);
+	bool set_memory_priority(TextureHandle textureHandle, float memoryPriority);
+
+	struct GpuScope
+	{
+		std::string name;
+		std::uint32_t depth{ 0 }; // Scopes already open on the command list when it began.
+		std::uint64_t beginNs{ 0 };
+		std::uint64_t endNs{ 0 };
+	};
+	struct GpuScopeTimings
+	{
+		std::vector<GpuScope> scopes; // In the order they began on the CPU. Scopes whose command list was never submitted are left out.
+		std::uint32_t frameNumber{ 0 }; // Of the frame they were recorded in, counting begin_frame() calls.
+		/**
+		 * Times are on the CPU's std::chrono::steady_clock (its time_since_epoch()), calibrated with VK_EXT_calibrated_timestamps.
+		 * Without it, times only compare with each other.
+		 */
+		bool calibrated{ false };
+	};
+	/**
+	 * @brief Get the timings of the scopes recorded in the latest frame to be resolved. A frame's scopes are resolved by the
+	 * begin_frame() reusing it, once its submissions have completed, so reading them never waits on the GPU. They are
+	 * framesInFlight frames behind.
+	 */
+	bool get_gpu_scope_timings(GpuScopeTimings& outTimings, DeviceHandle deviceHandle);
+
+	enum class GpuQueryType
+	{
+		eOcclusion,			 // Samples passing the depth and stencil tests.
+		ePipelineStatistics, // Invocations and primitives of the graphics and compute stages.
+	};
+	struct GpuQuery
+	{
+		std::string name;
+		GpuQueryType type{ GpuQueryType::eOcclusion };
+		std::uint64_t samplesPassed{ 0 }; // eOcclusion. Exact where occlusionQueryPrecise is supported, otherwise only 0 or not.
+		// ePipelineStatistics.
+		std::uint64_t inputAssemblyVertices{ 0 };
+		std::uint64_t vertexShaderInvocations{ 0 };
+		std::uint64_t clippingInvocations{ 0 }; // Primitives reaching the clipping stage,
+		std::uint64_t clippingPrimitives{ 0 };	// and those leaving it to be rasterized.
+		std::uint64_t fragmentShaderInvocations{ 0 };
+		std::uint64_t computeShaderInvocations{ 0 };
+	};
+	struct GpuQueryResults
+	{
+		std::vector<GpuQuery> queries; // In the order they began on the CPU. Queries whose command list was never submitted are left out.
+		std::uint32_t frameNumber{ 0 }; // Of the frame they were recorded in, counting begin_frame() calls.
+	};
+	/**
+	 * @brief Get the results of the queries recorded in the latest frame to be resolved, which like get_gpu_scope_timings()
+	 * never waits on the GPU.
+	 */
+	bool get_gpu_query_results(GpuQueryResults& outResults, DeviceHandle deviceHandle);
+
+	struct FrameStats
+	{
+		std::uint32_t frameNumber{ 0 }; // Of the frame counted, counting begin_frame() calls.
+		std::uint64_t draws{ 0 };
+		std::uint64_t dispatches{ 0 };
+		std::uint64_t pipelineBinds{ 0 };
+		std::uint64_t descriptorBinds{ 0 }; // Descriptor set binds, pushes and descriptor buffer offsets.
+		std::uint64_t barriers{ 0 };		// Image and buffer barriers, not the pipelineBarrier2() calls batching them.
+		std::uint64_t submits{ 0 };
+		std::uint64_t descriptorWrites{ 0 };
+		std::uint64_t uploadBytes{ 0 };
+		std::uint64_t resourcesCreated{ 0 }; // Buffers, textures, samplers, pipelines and descriptor sets.
+	};
+	/**
+	 * @brief Get what the CPU recorded and created during the previous frame, up to the latest begin_frame(). Commands are
+	 * counted when their command list ends, or for deferred ones when translated. Needs the gfx_ENABLE_FRAME_STATS CMake
+	 * option, and otherwise returns false.
+	 */
+	bool get_frame_stats(FrameStats& outStats, DeviceHandle deviceHandle);
+
+	/**
+	 * @brief Record the device's calls into a capture, which end_capture() writes to path for the gfx_replay tool (see
+	 * CaptureReplay in gfx_capture.hpp) to replay headlessly, e.g. to benchmark a frame without the application.
+	 * Begin before creating the resources the frames use: calls before the first begin_frame() are replayed once as setup,
+	 * and the frames up to the last end_frame() are looped. Resource creation, uploads, descriptor writes, submits, presents
+	 * and the command list functions of the primary API are captured, CommandRecorder, bundles, render graphs and sync points
+	 * are not. Writes to mapped memory are captured when it is unmapped or flushed, and persistent mappings before each submit.
+	 * Must not be called while other threads are recording. Needs the gfx_ENABLE_CAPTURE CMake option, and otherwise returns false.
+	 */
+	bool begin_capture(DeviceHandle deviceHandle, std::string_view path);
+	bool end_capture(DeviceHandle deviceHandle);
 
 #pragma region Device Resources
 
@@ -148,86 +674,623 @@ namespace sm::gfx
 		eDepth24Stencil8,
 		eDepth32,
 		eDepth32Stencil8,
+		// Block-compressed, sampled only. Uploads hold whole blocks, rows of 4x4 texel blocks tightly packed.
+		eBC1, // RGB(A), 8 bytes per block.
+		eBC1Srgb,
+		eBC3, // RGBA, 16 bytes per block.
+		eBC3Srgb,
+		eBC4,  // R, 8 bytes per block.
+		eBC5,  // RG, 16 bytes per block, e.g. normal maps.
+		eBC6H, // Unsigned HDR RGB, 16 bytes per block.
+		eBC7,  // RGBA, 16 bytes per block.
+		eBC7Srgb,
+		eETC2RGB8,	// 8 bytes per block, mostly mobile.
+		eETC2RGBA8, // 16 bytes per block, mostly mobile.
+		eASTC4x4,	// 16 bytes per block, mostly mobile.
+		eASTC4x4Srgb,
+		// Compact vertex attributes, half or less the size of floats. Also usable as texture formats.
+		eRG16Float,
+		eRGBA16Float,
+		eRG16Snorm, // -1 to 1, eg. octahedral normals.
+		eRGBA16Snorm,
+		eRG16Unorm, // 0 to 1, eg. texture coordinates in a known range.
+		eRGBA16Unorm,
+		eRG8Snorm,
+		eRGBA8Snorm,
+		eRGB10A2Unorm, // 10 bits each of RGB and 2 of A, packed into 32 bits from the least significant bit.
+		eRGB10A2Snorm, // Packed like eRGB10A2Unorm, eg. normals and tangent signs. Optional as a vertex format.
+		eR8Uint,	   // Unsigned integer, eg. the texels of a shading rate attachment.
+		eR16Unorm,	   // 0 to 1, eg. the luma of decoded video above 8 bits.
 	};
+	/**
+	 * @brief Bytes of one tightly packed level of a 2D texture, in whole texel blocks for compressed formats.
+	 */
+	auto get_texture_level_size(Format format, std::uint32_t width, std::uint32_t height) -> std::uint64_t;
+	/**
+	 * @brief Bytes of one vertex attribute of a format, as vertex input bindings pack them.
+	 */
+	auto get_vertex_format_size(Format format) -> std::uint32_t;
+	/**
+	 * @brief Whether the device can read a format as a vertex attribute. All but eRGB10A2Snorm always can.
+	 */
+	bool is_vertex_format_supported(DeviceHandle deviceHandle, Format format);
 
-	void wait_on_fence(FenceHandle fenceHandle);
+	/**
+	 * @brief A point on a queue's submission timeline, returned by submit_command_list().
+	 * A default constructed SyncPoint is always complete.
+	 */
+	struct SyncPoint
+	{
+		DeviceHandle deviceHandle{};
+		std::uint32_t queueIndex{ 0 };
+		std::uint64_t value{ 0 };
+	};
+	constexpr std::uint64_t INFINITE_TIMEOUT = ~0ull;
+	constexpr std::uint64_t WHOLE_SIZE = ~0ull; // The rest of a buffer, from the given offset.
+
+	/**
+	 * @brief Block until the GPU has finished all work up to and including the sync point, or the timeout has elapsed.
+	 * @return True if the sync point has completed.
+	 */
+	bool wait_on_sync_point(SyncPoint syncPoint, std::uint64_t timeoutNs = INFINITE_TIMEOUT);
+	/**
+	 * @brief Block until all (or any) of the sync points have completed, or the timeout has elapsed. The sync points must belong to one device.
+	 * A timeout of 0 polls without blocking.
+	 * @return True if the wait was satisfied.
+	 */
+	bool wait_on_sync_points(std::span<const SyncPoint> syncPoints, bool waitAll, std::uint64_t timeoutNs = INFINITE_TIMEOUT);
+	bool is_sync_point_complete(SyncPoint syncPoint);
 
 	void destroy_semaphore(SemaphoreHandle semaphoreHandle);
 
-	constexpr std::uint32_t CommandListFlags_FireAndForget = 1u << 0u; // Once a command list been submitted, it can no longer be reused, and it will be automatically freed (once safe to do so).
+	constexpr std::uint32_t CommandListFlags_FireAndForget = 1u << 0u;	  // Once a command list been submitted, it can no longer be reused, and it will be automatically freed (once safe to do so). Implies OneTimeSubmit.
+	constexpr std::uint32_t CommandListFlags_OneTimeSubmit = 1u << 1u;	  // Each recording will only be submitted once, which lets the driver optimise for it.
+	constexpr std::uint32_t CommandListFlags_SimultaneousUse = 1u << 2u; // The command list may be resubmitted (or executed) while a previous submission is still pending.
+	constexpr std::uint32_t CommandListFlags_Deferred = 1u << 3u;		  // Recording writes a compact command stream, which end() hands to a worker thread to translate to Vulkan. Primary command lists only.
 
-	bool create_command_list(CommandListHandle& outCommandListHandle, DeviceHandle deviceHandle, std::uint32_t queueIndex);
+	/**
+	 * @param flags CommandListFlags_*
+	 */
+	bool create_command_list(CommandListHandle& outCommandListHandle, DeviceHandle deviceHandle, std::uint32_t queueIndex, std::uint32_t flags = 0);
+	/**
+	 * @brief Create a secondary command list, which records part of a render pass and is run by a primary with execute_commands().
+	 * Secondary command lists cannot be submitted directly.
+	 */
+	bool create_secondary_command_list(CommandListHandle& outCommandListHandle, DeviceHandle deviceHandle, std::uint32_t queueIndex, std::uint32_t flags = 0);
+	/**
+	 * @brief Create a command list that is only valid for the current frame.
+	 * Transient command lists come from per-frame pools that are reset in one go by the begin_frame() that reuses the frame,
+	 * after which the handle is no longer valid. They do not need to be destroyed and cannot be reset individually.
+	 * Transient command lists are always recorded as OneTimeSubmit.
+	 */
+	bool create_transient_command_list(CommandListHandle& outCommandListHandle, DeviceHandle deviceHandle, std::uint32_t queueIndex);
 	void destroy_command_list(DeviceHandle deviceHandle, CommandListHandle commandListHandle);
 
+	constexpr std::uint32_t PipelineStageFlags_DrawIndirect = 1u << 0u;
+	constexpr std::uint32_t PipelineStageFlags_VertexInput = 1u << 1u;
+	constexpr std::uint32_t PipelineStageFlags_VertexShader = 1u << 2u;
+	constexpr std::uint32_t PipelineStageFlags_FragmentShader = 1u << 3u;
+	constexpr std::uint32_t PipelineStageFlags_DepthStencilAttachment = 1u << 4u; // Early and late fragment tests.
+	constexpr std::uint32_t PipelineStageFlags_ColorAttachmentOutput = 1u << 5u;
+	constexpr std::uint32_t PipelineStageFlags_ComputeShader = 1u << 6u;
+	constexpr std::uint32_t PipelineStageFlags_Transfer = 1u << 7u;
+	constexpr std::uint32_t PipelineStageFlags_AllCommands = 1u << 8u;
+	constexpr std::uint32_t PipelineStageFlags_Host = 1u << 9u; // Barriers only, e.g. before reading a readback buffer on the CPU.
+	constexpr std::uint32_t PipelineStageFlags_ConditionalRendering = 1u << 10u; // Reading begin_conditional()'s predicate.
+
+	// Memory accesses a barrier orders, see buffer_barrier() and memory_barrier().
+	constexpr std::uint32_t AccessFlags_IndirectCommandRead = 1u << 0u; // Indirect draw and dispatch arguments and counts.
+	constexpr std::uint32_t AccessFlags_IndexRead = 1u << 1u;
+	constexpr std::uint32_t AccessFlags_VertexAttributeRead = 1u << 2u;
+	constexpr std::uint32_t AccessFlags_UniformRead = 1u << 3u;
+	constexpr std::uint32_t AccessFlags_ShaderRead = 1u << 4u;	// Sampled, storage buffer and storage texture reads.
+	constexpr std::uint32_t AccessFlags_ShaderWrite = 1u << 5u; // Storage buffer and storage texture writes.
+	constexpr std::uint32_t AccessFlags_TransferRead = 1u << 6u;
+	constexpr std::uint32_t AccessFlags_TransferWrite = 1u << 7u;
+	constexpr std::uint32_t AccessFlags_HostRead = 1u << 8u;
+	constexpr std::uint32_t AccessFlags_HostWrite = 1u << 9u;
+	constexpr std::uint32_t AccessFlags_MemoryRead = 1u << 10u; // Any read.
+	constexpr std::uint32_t AccessFlags_MemoryWrite = 1u << 11u; // Any write.
+	constexpr std::uint32_t AccessFlags_ConditionalRenderingRead = 1u << 12u;
+
+	/**
+	 * @brief A semaphore for a submission to wait on. Only the given pipeline stages wait, so earlier stages of the submission can overlap the work that signals it.
+	 */
+	struct SemaphoreWait
+	{
+		SemaphoreHandle semaphoreHandle;
+		std::uint32_t stages{ PipelineStageFlags_AllCommands }; // PipelineStageFlags_*
+	};
+
 	struct SubmitInfo
 	{
 		CommandListHandle commandList;
 		SemaphoreHandle waitSemaphoreHandle;
+		std::uint32_t waitStages{ PipelineStageFlags_AllCommands }; // PipelineStageFlags_* that wait on waitSemaphoreHandle and waitSyncPoint.
+		SyncPoint waitSyncPoint{};									// A submission, e.g. on an async compute queue, to wait for on the GPU.
+		SwapChainHandle swapChainHandle;							// If set, the command list renders to the swap chain's current image, see SubmitBatch.
+		std::uint32_t deviceMask{ 0 };								// See SubmitBatch::deviceMask.
+	};
+	/**
+	 * @return The sync point the submission will signal once it has completed on the GPU, or a complete SyncPoint on failure.
+	 * With DeviceInfo::threadedSubmission a failure is only found on the submission thread, after the sync point was returned.
+	 * It is reported as a lost device, after which nothing more is submitted and the device has to be created again.
+	 */
+	auto submit_command_list(const SubmitInfo& submitInfo, SemaphoreHandle* outSemaphoreHandle = nullptr) -> SyncPoint;
+
+	struct SubmitBatch
+	{
+		std::span<const CommandListHandle> commandLists;
+		std::span<const SemaphoreWait> waitSemaphores;
+		std::span<const SyncPoint> waitSyncPoints; // Submissions (on other queues) the batch waits for on the GPU.
+		/**
+		 * PipelineStageFlags_* that wait on waitSyncPoints, the stages before them overlap the work waited for. E.g. graphics
+		 * work reading the output of an async compute submission in fragment shaders waits at PipelineStageFlags_FragmentShader,
+		 * so its shadow and depth passes run alongside the compute work.
+		 */
+		std::uint32_t waitSyncPointStages{ PipelineStageFlags_AllCommands };
+		SemaphoreHandle* outSignalSemaphoreHandle{ nullptr }; // If set, receives a semaphore signalled once the batch has completed.
+		/**
+		 * If set, the batch renders to the swap chain's current image. The batch waits for the image to be acquired and
+		 * present_swap_chain() waits for the batch, all on the GPU.
+		 */
+		SwapChainHandle swapChainHandle;
+		/**
+		 * GPUs of a device group the command lists run on, bit i for GPU i, e.g. alternating between 1 << 0 and 1 << 1 each
+		 * frame. 0 runs them on all. Waits and signals happen on the first GPU.
+		 */
+		std::uint32_t deviceMask{ 0 };
 	};
-	void submit_command_list(const SubmitInfo& submitInfo, FenceHandle* outFenceHandle, SemaphoreHandle* outSemaphoreHandle);
+	/**
+	 * @brief Submit several batches of command lists to one queue in a single queue submission, which is far cheaper than one submit per command list.
+	 * Batches start in order, and all command lists must have been created for queueIndex.
+	 * @return The sync point signalled once every batch has completed.
+	 */
+	auto submit_command_lists(DeviceHandle deviceHandle, std::uint32_t queueIndex, std::span<const SubmitBatch> batches) -> SyncPoint;
 
 	enum class DescriptorType
 	{
 		eStorageBuffer,
 		eUniformBuffer,
+		eUniformBufferDynamic, // Offset given when binding the set, e.g. for allocate_transient() data.
+		eStorageBufferDynamic, // Offset given when binding the set, e.g. for per-draw ranges of one large storage buffer.
 		eTexture,
+		// A color attachment of the current render pass, read by the fragment shader at its own pixel with subpassLoad().
+		// Color attachment i is input_attachment_index i. Needs DeviceFeatureFlags_LocalRead and a RenderPassInfo::localRead
+		// pass. Written without a sampler.
+		eInputAttachment,
+		// Constants stored in the set itself, read like a uniform buffer but without one. count is the size in bytes, a multiple
+		// of 4 up to DeviceProperties::maxInlineUniformBlockSize. Needs DeviceFeatureFlags_InlineUniformBlock, and cannot be in
+		// push sets or be reflected, as SPIR-V declares it like a uniform buffer. Written with write_inline_uniform_block().
+		eInlineUniformBlock,
+		// A texture read and written by shaders without a sampler (RWTexture2D etc.), e.g. by compute post-processing. Written
+		// with a TextureUsage::eStorage texture whose view is a single mip level, in TextureState::eStorage when used.
+		eStorageTexture,
 	};
 	constexpr std::uint32_t ShaderStageFlags_Compute = 1u << 0u;
 	constexpr std::uint32_t ShaderStageFlags_Vertex = 1u << 1u;
 	constexpr std::uint32_t ShaderStageFlags_Fragment = 1u << 2u;
+	constexpr std::uint32_t ShaderStageFlags_Task = 1u << 3u; // Mesh pipelines only.
+	constexpr std::uint32_t ShaderStageFlags_Mesh = 1u << 4u; // Mesh pipelines only.
 	struct DescriptorBindingInfo
 	{
 		DescriptorType type;
 		std::uint32_t count;
 		std::uint32_t shaderStages;
+
+		bool operator==(const DescriptorBindingInfo&) const = default;
 	};
 	struct DescriptorSetInfo
 	{
 		std::vector<DescriptorBindingInfo> bindings{};
+		bool bindlessHeap{ false }; // The set is the device's bindless heap, bindings are ignored. Only for pipelines.
+		bool push{ false };			// Never allocated, its descriptors are written with push_descriptors() instead. Only for pipelines.
+
+		bool operator==(const DescriptorSetInfo&) const = default;
 	};
 	struct PipelineConstantBlock
 	{
 		std::uint32_t size;
 		std::uint32_t shaderStages;
+
+		bool operator==(const PipelineConstantBlock&) const = default;
+	};
+	/**
+	 * @brief Value of a shader's `layout(constant_id = id)` constant, fixed when the pipeline is compiled so the driver can
+	 * fold it and strip dead branches. 32-bit constants only: bool, int, uint and float given by their bits (std::bit_cast).
+	 */
+	struct SpecializationConstant
+	{
+		std::uint32_t id;
+		std::uint32_t value;
+
+		bool operator==(const SpecializationConstant&) const = default;
+	};
+	/**
+	 * @brief 64-bit FNV-1a over the words of SPIR-V. Unlike std::hash it is the same in every build, so it can be stored, eg.
+	 * in a shader archive. Shader modules and pipelines are cached by it.
+	 */
+	constexpr auto hash_shader_code(std::span<const std::uint32_t> code) -> std::uint64_t
+	{
+		std::uint64_t hash{ 0xCBF29CE484222325ull };
+		for (const auto word : code)
+		{
+			hash = (hash ^ word) * 0x100000001B3ull;
+		}
+		return hash;
+	}
+	/**
+	 * @brief The SPIR-V of a pipeline stage. Either owns its code, or is a view of code that outlives every pipeline created
+	 * with it, eg. in a ShaderArchive, which is then never copied, nor hashed again when given its hash.
+	 */
+	class ShaderCode
+	{
+	public:
+		ShaderCode() = default;
+		ShaderCode(std::vector<std::uint32_t> words) : m_owned(std::move(words)) {}
+		// Copied, eg. from a file read as bytes. Its size must be a multiple of 4.
+		ShaderCode(const std::vector<char>& bytes);
+		// A view. contentHash is hash_shader_code() of the code, or 0 to compute it when needed.
+		ShaderCode(std::span<const std::uint32_t> words, std::uint64_t contentHash = 0) : m_view(words), m_contentHash(contentHash) {}
+
+		auto get_words() const -> std::span<const std::uint32_t> { return is_view() ? m_view : std::span<const std::uint32_t>(m_owned); }
+		auto data() const -> const std::uint32_t* { return get_words().data(); }
+		auto size() const -> std::size_t { return get_words().size(); } // In words.
+		bool empty() const { return get_words().empty(); }
+		auto begin() const { return get_words().begin(); }
+		auto end() const { return get_words().end(); }
+
+		bool is_view() const { return m_view.data() != nullptr; }
+		auto get_content_hash() const -> std::uint64_t { return m_contentHash != 0 ? m_contentHash : hash_shader_code(get_words()); }
+		// A copy owning its code, to keep past the lifetime of a view.
+		auto to_owned() const -> ShaderCode { return is_view() ? ShaderCode(std::vector(m_view.begin(), m_view.end())) : *this; }
+
+		bool operator==(const ShaderCode& other) const;
+
+	private:
+		std::vector<std::uint32_t> m_owned;
+		std::span<const std::uint32_t> m_view;
+		std::uint64_t m_contentHash{ 0 }; // Only given to views.
 	};
+	// Pipeline layouts can be left to reflection of the shaders' SPIR-V: sets left empty (no bindings, not bindlessHeap or push),
+	// and sets past the end of descriptorSets, get the bindings the shaders declare, each with only the stages that use it.
+	// A constant block of size 0 gets the largest push constant block of the shaders. Dynamic buffer types, separate samplers
+	// and runtime sized arrays cannot be reflected, so sets with them must be declared.
 	struct ComputePipelineInfo
 	{
-		std::vector<char> shaderCode;
+		ShaderCode shaderCode;
 		std::vector<DescriptorSetInfo> descriptorSets;
 		PipelineConstantBlock constantBlock;
+		std::vector<SpecializationConstant> specializationConstants{};
+		std::string entryPoint{ "Main" }; // Of shaderCode, which may hold several.
+		// Subgroup size control, both needing DeviceFeatureFlags_SubgroupSizeControl. A requiredSubgroupSize of 0 leaves the
+		// size to the driver, otherwise it is a power of two in [minSubgroupSize, maxSubgroupSize] of DeviceProperties, eg. for
+		// shaders tuned to one width. requireFullSubgroups makes every subgroup of a workgroup full, which needs the
+		// workgroup's x size to be a multiple of the subgroup size.
+		std::uint32_t requiredSubgroupSize{ 0 };
+		bool requireFullSubgroups{ false };
+		std::string debugName{}; // Shown in debuggers and GPU profilers, as are those of the other infos.
+
+		bool operator==(const ComputePipelineInfo&) const = default;
 	};
 	bool create_compute_pipeline(PipelineHandle& outPipelineHandle, DeviceHandle deviceHandle, const ComputePipelineInfo& computePipelineInfo);
+	constexpr std::uint32_t PACKED_VERTEX_OFFSET = ~0u; // Straight after the binding's previous attribute.
 	struct VertexAttribute
 	{
 		std::string name{};
 		std::uint32_t location{};
 		Format format{};
+		std::uint32_t offset{ PACKED_VERTEX_OFFSET }; // Bytes from the start of each vertex.
+
+		bool operator==(const VertexAttribute&) const = default;
+	};
+	enum class VertexInputRate
+	{
+		eVertex,   // The binding's attributes advance per vertex.
+		eInstance, // And per instance, eg. transforms and colours for hardware instancing with draw_indexed()'s instanceCount.
 	};
 	struct VertexBinding
 	{
 		std::string name{};
 		std::vector<VertexAttribute> attributes{};
+		// Bytes between vertices, eg. those of an interleaved buffer the attributes are only some of. 0 ends each vertex after its last attribute.
+		std::uint32_t stride{ 0 };
+		VertexInputRate inputRate{ VertexInputRate::eVertex };
+		// For eInstance, the instances that share each element. 0 gives every instance the first. Other than 1 needs DeviceFeatureFlags_VertexAttributeDivisor.
+		std::uint32_t divisor{ 1 };
+
+		bool operator==(const VertexBinding&) const = default;
+	};
+	enum class PrimitiveTopology
+	{
+		eTriangleList,
+		eTriangleStrip,
+		eLineList,
+		eLineStrip,
+		ePointList,
+	};
+	enum class CullMode
+	{
+		eNone,
+		eFront,
+		eBack,
+		eFrontAndBack,
+	};
+	enum class FrontFace
+	{
+		eClockwise,
+		eCounterClockwise,
+	};
+	enum class CompareOp
+	{
+		eNever,
+		eLess,
+		eEqual,
+		eLessOrEqual,
+		eGreater,
+		eNotEqual,
+		eGreaterOrEqual,
+		eAlways,
+	};
+	enum class StencilOp
+	{
+		eKeep,
+		eZero,
+		eReplace,
+		eIncrementAndClamp,
+		eDecrementAndClamp,
+		eInvert,
+		eIncrementAndWrap,
+		eDecrementAndWrap,
+	};
+	struct StencilState
+	{
+		StencilOp failOp{ StencilOp::eKeep };
+		StencilOp passOp{ StencilOp::eKeep };
+		StencilOp depthFailOp{ StencilOp::eKeep };
+		CompareOp compareOp{ CompareOp::eAlways };
+		std::uint32_t compareMask{ 0xFF };
+		std::uint32_t writeMask{ 0xFF };
+		std::uint32_t reference{ 0 };
+
+		bool operator==(const StencilState&) const = default;
 	};
+	enum class BlendFactor
+	{
+		eZero,
+		eOne,
+		eSrcColor,
+		eOneMinusSrcColor,
+		eDstColor,
+		eOneMinusDstColor,
+		eSrcAlpha,
+		eOneMinusSrcAlpha,
+		eDstAlpha,
+		eOneMinusDstAlpha,
+	};
+	enum class BlendOp
+	{
+		eAdd,
+		eSubtract,
+		eReverseSubtract,
+		eMin,
+		eMax,
+	};
+	constexpr std::uint32_t ColorComponentFlags_R = 1u << 0u;
+	constexpr std::uint32_t ColorComponentFlags_G = 1u << 1u;
+	constexpr std::uint32_t ColorComponentFlags_B = 1u << 2u;
+	constexpr std::uint32_t ColorComponentFlags_A = 1u << 3u;
+	constexpr std::uint32_t ColorComponentFlags_All = ColorComponentFlags_R | ColorComponentFlags_G | ColorComponentFlags_B | ColorComponentFlags_A;
+	/**
+	 * @brief Blending of one color attachment. The default writes it opaquely, with blending disabled.
+	 */
+	struct BlendState
+	{
+		bool blendEnable{ false };
+		BlendFactor srcColorFactor{ BlendFactor::eOne };
+		BlendFactor dstColorFactor{ BlendFactor::eZero };
+		BlendOp colorOp{ BlendOp::eAdd };
+		BlendFactor srcAlphaFactor{ BlendFactor::eOne };
+		BlendFactor dstAlphaFactor{ BlendFactor::eZero };
+		BlendOp alphaOp{ BlendOp::eAdd };
+		std::uint32_t colorWriteMask{ ColorComponentFlags_All };
+
+		bool operator==(const BlendState&) const = default;
+	};
+	// Straight alpha "over" blending, e.g. for UI and transparent geometry.
+	constexpr BlendState BlendState_Alpha{ true, BlendFactor::eSrcAlpha, BlendFactor::eOneMinusSrcAlpha, BlendOp::eAdd, BlendFactor::eOne, BlendFactor::eOneMinusSrcAlpha, BlendOp::eAdd };
+	// State left out of the pipeline and set on the command list instead, so one pipeline serves every combination of it.
+	// The pipeline's own values for it are ignored, and it must be set after binding the pipeline and before drawing.
+	constexpr std::uint32_t DynamicStateFlags_CullMode = 1u << 0u;	// set_cull_mode()
+	constexpr std::uint32_t DynamicStateFlags_FrontFace = 1u << 1u; // set_front_face()
+	constexpr std::uint32_t DynamicStateFlags_Topology = 1u << 2u;	// set_primitive_topology(), within the class (triangles, lines or points) of topology
+	constexpr std::uint32_t DynamicStateFlags_Depth = 1u << 3u;		// set_depth_state()
+	constexpr std::uint32_t DynamicStateFlags_Stencil = 1u << 4u;	// set_stencil_state()
+	constexpr std::uint32_t DynamicStateFlags_Blend = 1u << 5u;		// set_blend_states(), only where VK_EXT_extended_dynamic_state3 is supported
+	constexpr std::uint32_t DynamicStateFlags_ShadingRate = 1u << 6u; // set_shading_rate(), needs DeviceFeatureFlags_ShadingRate. Otherwise 1x1, or the pass's shading rate attachment.
 	struct GraphicsPipelineInfo
 	{
-		std::vector<std::uint32_t> vertexCode;
-		std::vector<std::uint32_t> fragmentCode;
+		ShaderCode vertexCode;
+		ShaderCode fragmentCode; // Empty for a depth-only pipeline, eg. for a z-prepass or shadow map, which may have no colorAttachments.
+		std::vector<SpecializationConstant> vertexSpecializationConstants{};
+		std::vector<SpecializationConstant> fragmentSpecializationConstants{};
 		std::vector<VertexBinding> vertexInputBindings{};
 		std::vector<DescriptorSetInfo> descriptorSets;
 		PipelineConstantBlock constantBlock;
 
+		PrimitiveTopology topology{ PrimitiveTopology::eTriangleList };
+		CullMode cullMode{ CullMode::eNone };
+		FrontFace frontFace{ FrontFace::eClockwise };
+
 		bool depthTest;
+		bool depthWrite{ true }; // Only with depthTest.
+		CompareOp depthCompareOp{ CompareOp::eLessOrEqual };
+		bool stencilTest{ false }; // Needs a depthAttachmentFormat with a stencil aspect.
+		StencilState stencilFront{};
+		StencilState stencilBack{};
 
 		std::vector<gfx::Format> colorAttachments{};
+		std::vector<BlendState> colorBlendStates{}; // By color attachment, attachments without one are written opaquely.
+
+		std::uint32_t dynamicStates{ 0 }; // DynamicStateFlags_
 		gfx::Format depthAttachmentFormat{ gfx::Format::eUndefined };
+		std::uint32_t sampleCount{ 1 }; // Must match the TextureInfo::sampleCount of the attachments it renders to.
+		std::uint32_t viewMask{ 0 };	// Must match the RenderPassInfo::viewMask of the passes it is used in.
+
+		std::string debugName{};
+
+		bool operator==(const GraphicsPipelineInfo&) const = default;
 	};
+	// Creating a pipeline identical to a live one, debugName included, returns the same handle rather than compiling it again.
+	// If that one is still compiling from a create_*_pipeline_async() or prewarm_pipelines(), this waits for it to finish.
+	// Every create must still be matched by a destroy_pipeline(), the pipeline is destroyed with the last.
 	bool create_graphics_pipeline(PipelineHandle& outPipelineHandle, DeviceHandle deviceHandle, const GraphicsPipelineInfo& graphicsPipelineInfo);
+	/**
+	 * @brief A graphics pipeline whose geometry comes from an optional task shader and a mesh shader (VK_EXT_mesh_shader)
+	 * rather than from vertex input, drawn with draw_mesh_tasks(). The fragment shader, layout and fixed function state are
+	 * taken from state; its vertex stage, vertex input bindings and topology (static or dynamic) are ignored.
+	 */
+	struct MeshPipelineInfo
+	{
+		ShaderCode taskCode{}; // Optional.
+		ShaderCode meshCode;
+		std::vector<SpecializationConstant> taskSpecializationConstants{};
+		std::vector<SpecializationConstant> meshSpecializationConstants{};
+		GraphicsPipelineInfo state;
+		std::string debugName{};
+
+		bool operator==(const MeshPipelineInfo&) const = default;
+	};
+	/**
+	 * @brief Fails if the device does not support task and mesh shaders. Pipelines are shared like graphics pipelines.
+	 */
+	bool create_mesh_pipeline(PipelineHandle& outPipelineHandle, DeviceHandle deviceHandle, const MeshPipelineInfo& meshPipelineInfo);
+	/**
+	 * @brief Compile a pipeline on the device's worker threads rather than the calling thread, so new materials do not hitch.
+	 * The handle can be used straight away. Until is_pipeline_ready(), binding it binds placeholderHandle instead, which
+	 * should share its descriptor sets and constants, and fails if there is no placeholder. A shared pipeline (see
+	 * create_graphics_pipeline()) that is still compiling keeps the placeholder of the create that started it, this one's is ignored.
+	 */
+	bool create_compute_pipeline_async(PipelineHandle& outPipelineHandle, DeviceHandle deviceHandle, const ComputePipelineInfo& computePipelineInfo, PipelineHandle placeholderHandle = {});
+	bool create_graphics_pipeline_async(PipelineHandle& outPipelineHandle, DeviceHandle deviceHandle, const GraphicsPipelineInfo& graphicsPipelineInfo, PipelineHandle placeholderHandle = {});
+	/**
+	 * @return Whether the pipeline has finished compiling. Always true for pipelines not created asynchronously.
+	 */
+	bool is_pipeline_ready(PipelineHandle pipelineHandle);
+	/**
+	 * @brief Create every pipeline of a manifest recorded with DeviceInfo::pipelineManifestPath, compute and graphics ones
+	 * with create_*_pipeline_async() so they compile in parallel on the worker threads, eg. behind a loading screen. Mesh
+	 * pipelines have no async variant and compile on the calling thread, so call it from a background thread if there are any.
+	 * While the returned pipelines are alive, creating an identical one takes another reference to it rather than compiling,
+	 * and their compiles fill the pipeline cache for the next run either way. Poll is_pipeline_ready() on them for progress,
+	 * and destroy them once the pipelines the application creates itself hold their references.
+	 * @return False if the manifest cannot be read. Pipelines that fail to create are left out.
+	 */
+	bool prewarm_pipelines(std::vector<PipelineHandle>& outPipelineHandles, DeviceHandle deviceHandle, const char* manifestPath);
 	void destroy_pipeline(PipelineHandle pipelineHandle);
 
+	/**
+	 * @brief What tune_compute_workgroup_size() measures: a shader whose workgroup x size is a specialization constant, eg.
+	 * HLSL's `[numthreads(WorkgroupSize, 1, 1)]` with `[[vk::constant_id(0)]] const uint WorkgroupSize = 64;`.
+	 */
+	struct ComputeTuningInfo
+	{
+		ComputePipelineInfo pipelineInfo; // Gets the workgroup size constant for each candidate.
+		std::uint32_t workgroupSizeConstantId{ 0 };
+		std::vector<std::uint32_t> candidates{ 32, 64, 128, 256, 512, 1024 }; // Those past the device's limits are skipped.
+		std::uint32_t queueIndex{ 0 };
+		std::uint32_t iterations{ 5 }; // Submissions timed per candidate, the fastest counting.
+		// Record the representative work with the candidate's pipeline bound, eg. bind its sets and dispatch the group count
+		// covering the same elements for the given workgroup size. Recorded once per iteration.
+		std::function<void(CommandListHandle commandListHandle, std::uint32_t workgroupSize)> record;
+	};
+	/**
+	 * @brief Find the fastest workgroup size of a compute shader on this device, by timing each candidate's pipeline on the
+	 * queue from submission to completion, waiting for the device in between. The result is cached by the device, keyed by
+	 * the pipeline info and candidates, so asking again costs nothing and record is not called.
+	 * Create the pipeline with the chosen size as its workgroupSizeConstantId constant.
+	 */
+	bool tune_compute_workgroup_size(std::uint32_t& outWorkgroupSize, DeviceHandle deviceHandle, const ComputeTuningInfo& tuningInfo);
+
+	// Descriptor sets come from pools the device chains as they fill up. Persistent sets live until destroy_descriptor_set().
 	bool create_descriptor_set(DescriptorSetHandle& outDescriptorSetHandle, DeviceHandle deviceHandle, const DescriptorSetInfo& setInfo);
 	bool create_descriptor_set_from_pipeline(DescriptorSetHandle& outDescriptorSetHandle, PipelineHandle pipelineHandle, std::uint32_t set);
-	void bind_buffer_to_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, BufferHandle bufferHandle);
+	/**
+	 * @brief Destroy a persistent set once the GPU is done with it. Its pool or descriptor buffer memory is reused by the next set
+	 * created with the same layout. Transient sets go with their frame, and the bindless heap with the device.
+	 */
+	void destroy_descriptor_set(DescriptorSetHandle descriptorSetHandle);
+	/**
+	 * @brief Create a descriptor set that is only valid for the current frame, e.g. for per-pass bindings written each frame.
+	 * Like transient command lists, the begin_frame() that reuses the frame resets all of them in one go, which is much
+	 * cheaper than freeing sets one by one, and the handle is no longer valid afterwards.
+	 */
+	bool create_transient_descriptor_set(DescriptorSetHandle& outDescriptorSetHandle, DeviceHandle deviceHandle, const DescriptorSetInfo& setInfo);
+
+	// Bindings of the bindless heap, as shaders declare them, eg. `layout(set = N, binding = 0) uniform texture2D textures[];`.
+	// Textures of other types are reached by declaring binding 0 again with that type.
+	constexpr std::uint32_t BINDLESS_TEXTURE_BINDING = 0;		  // Sampled images, the default view of every eTexture texture.
+	constexpr std::uint32_t BINDLESS_SAMPLER_BINDING = 1;		  // Every sampler.
+	constexpr std::uint32_t BINDLESS_STORAGE_BUFFER_BINDING = 2; // The whole of every buffer usable as a storage buffer.
+	constexpr std::uint32_t INVALID_BINDLESS_INDEX = ~0u;
+	/**
+	 * @brief Get the device's bindless heap, a single descriptor set holding large arrays of every texture, sampler and storage
+	 * buffer, which shaders index into instead of having a set bound per material or draw.
+	 * Resources are written to the heap when created, and their slot is reused once they are destroyed and the GPU is done with
+	 * them, so creating resources never waits on or invalidates recorded work. Bind it like any other set, with pipelines
+	 * declaring it as a DescriptorSetInfo with bindlessHeap set.
+	 * @return An invalid handle if DeviceInfo asked for no heap, or the device does not support descriptor indexing.
+	 */
+	auto get_bindless_heap(DeviceHandle deviceHandle) -> DescriptorSetHandle;
+	/**
+	 * @brief Index of a resource within its array of the bindless heap, stable for as long as the resource lives.
+	 * @return INVALID_BINDLESS_INDEX if the resource is not in the heap, eg. because it is not used as a texture or storage buffer, or the array was full.
+	 */
+	auto get_texture_bindless_index(TextureHandle textureHandle) -> std::uint32_t;
+	auto get_sampler_bindless_index(SamplerHandle samplerHandle) -> std::uint32_t;
+	auto get_buffer_bindless_index(BufferHandle bufferHandle) -> std::uint32_t;
+	/**
+	 * The descriptor is written as the type the set's layout declares for the binding, so one buffer can back both plain and
+	 * dynamic descriptors. Fails if the buffer's type lacks the usage that type needs (eg. a uniform buffer in a storage binding).
+	 * @param offset, range The part of the buffer to bind. Dynamic buffers should bind the size of one block, the offset is added when binding the set.
+	 */
+	void bind_buffer_to_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, BufferHandle bufferHandle, std::uint64_t offset = 0, std::uint64_t range = WHOLE_SIZE);
 	void bind_texture_to_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, TextureHandle textureHandle, SamplerHandle samplerHandle);
+	/**
+	 * @brief One descriptor of a set. Buffer bindings use bufferHandle, offset and range, texture bindings the rest.
+	 */
+	struct DescriptorWrite
+	{
+		std::uint32_t binding{ 0 };
+		std::uint32_t arrayElement{ 0 };
+		BufferHandle bufferHandle{};
+		std::uint64_t offset{ 0 };
+		std::uint64_t range{ WHOLE_SIZE };
+		TextureHandle textureHandle{};
+		std::uint32_t viewIndex{ 0 }; // See create_texture_view().
+		SamplerHandle samplerHandle{};
+
+		bool operator==(const DescriptorWrite&) const = default;
+	};
+	/**
+	 * @brief Write several descriptors of a set at once, eg. every texture of a material, in one driver call instead of one per
+	 * binding. Writes covering element 0 of every binding of the set exactly once use a descriptor update template.
+	 * Like the bind functions, the written resources are rebound if they are moved, and bundles using the set are invalidated.
+	 */
+	void update_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::span<const DescriptorWrite> writes);
+	/**
+	 * @brief Write constants into an eInlineUniformBlock binding, e.g. the parameters of a material, which then need neither a
+	 * uniform buffer of their own nor a descriptor pointing at one. Like update_descriptor_set(), bundles using the set are invalidated.
+	 * @param offset, size In bytes within the block, multiples of 4.
+	 */
+	void write_inline_uniform_block(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, std::uint32_t offset, std::uint32_t size, const void* data);
+	/**
+	 * @brief Get a persistent set holding exactly the given writes, shared by every caller asking for the same layout and writes,
+	 * so systems that build identical sets every frame reuse one instead. The set must not be written to.
+	 * Sets that go unused for a few frames, or reference a destroyed resource, are evicted and later reused for other content,
+	 * so ask for the set again in each frame it is used rather than keeping the handle.
+	 */
+	bool get_cached_descriptor_set(DescriptorSetHandle& outDescriptorSetHandle, DeviceHandle deviceHandle, const DescriptorSetInfo& setInfo, std::span<const DescriptorWrite> writes);
 
 	enum class BufferType
 	{
@@ -235,29 +1298,155 @@ namespace sm::gfx
 		eIndex,
 		eUniform,
 		eStorage,
-		eUpload, // Used for uploading/copying data to GPU using command lists.
+		eUpload,   // Used for uploading/copying data to GPU using command lists.
+		eIndirect, // Draw arguments (and counts) for indirect draws, or group counts for dispatch_indirect(). Also usable as a storage buffer, so they can be written on the GPU.
+		eTransient, // Backs allocate_transient(). Usable as any of the above, and bound to eUniformBufferDynamic descriptors.
+		eReadback,	// Destination of read_buffer() and copy_texture_to_buffer(). Defaults to BufferMemory::eReadback.
+	};
+	/**
+	 * @brief Of memory allocated without a priority. When the device local heap is oversubscribed, the driver moves
+	 * lower priority memory out to system memory first (VK_EXT_memory_priority).
+	 */
+	constexpr float DEFAULT_MEMORY_PRIORITY = 0.5f;
+	/**
+	 * @brief Whether a buffer or texture gets a memory allocation of its own rather than a range of a shared block. Drivers
+	 * can compress and place render targets better in one, at the cost of an allocation per resource.
+	 */
+	enum class DedicatedAllocation
+	{
+		eAuto,	 // As eNever, plus attachments of at least 1024x1024 texels and buffers of at least 32MiB.
+		eAlways,
+		eNever,	 // Only where the driver prefers or requires it (VK_KHR_dedicated_allocation).
+	};
+	/**
+	 * @brief Where a buffer's memory lives and how the CPU reaches it.
+	 */
+	enum class BufferMemory
+	{
+		eDefault,  // eUpload for BufferType::eUpload, eDynamic for uniform buffers, otherwise eGpuOnly.
+		eGpuOnly,  // Device local and not mappable (except with DeviceProperties::unifiedMemory). Filled with upload_buffer() or written on the GPU.
+		eUpload,   // Written once by the CPU and read once by the GPU, e.g. staging. Persistently mapped, as are eReadback and eDynamic.
+		eReadback, // Written by the GPU and read by the CPU, from cached host memory.
+		eDynamic,  // Rewritten by the CPU and read by the GPU directly. Device local where the CPU can reach it, otherwise host memory.
 	};
 	struct BufferInfo
 	{
 		BufferType type;
 		std::uint64_t size;
+		BufferMemory memory{ BufferMemory::eDefault };
+		bool deviceAddress{ false }; // Allow get_buffer_device_address(), e.g. for vertex pulling through pointers in push constants.
+		bool sparse{ false };		 // Created without memory, pages are made resident with bind_sparse_buffer_pages(). Always eGpuOnly.
+		bool predicate{ false };	 // Usable by begin_conditional(). Needs DeviceFeatureFlags_ConditionalRendering.
+		bool accelerationStructureInput{ false }; // Vertices and indices of AccelerationStructureGeometry, implies deviceAddress. Needs DeviceFeatureFlags_RayQuery.
+		DedicatedAllocation dedicatedAllocation{ DedicatedAllocation::eAuto };
+		// In [0, 1], e.g. 1 for geometry drawn every frame. Any other than DEFAULT_MEMORY_PRIORITY gets a dedicated allocation
+		// where DeviceProperties::memoryPriority is supported, as priorities are per allocation. Ignored by sparse buffers.
+		float memoryPriority{ DEFAULT_MEMORY_PRIORITY };
+		std::string debugName{}; // Shown in debuggers and GPU profilers (RenderDoc, Nsight, RGP).
 	};
 	bool create_buffer(BufferHandle& outBufferHandle, DeviceHandle deviceHandle, const BufferInfo& bufferInfo);
+	/**
+	 * @brief Create many buffers with a single device lookup and table reservation.
+	 * @param outBufferHandles Must be at least as large as bufferInfos.
+	 */
+	bool create_buffers(std::span<BufferHandle> outBufferHandles, DeviceHandle deviceHandle, std::span<const BufferInfo> bufferInfos);
 	void destroy_buffer(BufferHandle bufferHandle);
+
+	/**
+	 * @brief A few large buffers that many small ranges (e.g. meshes) are sub-allocated from, so they share allocations and bindings.
+	 */
+	struct BufferArenaInfo
+	{
+		BufferType type;
+		BufferMemory memory{ BufferMemory::eDefault };
+		std::uint64_t blockSize{ 64ull * 1024 * 1024 }; // Size of each buffer, another is created once the existing ones are full.
+		bool deviceAddress{ false }; // See BufferInfo::deviceAddress. Add BufferAllocation::offset to the buffer's address.
+	};
+	struct BufferAllocation
+	{
+		BufferHandle bufferHandle{}; // The arena buffer holding the range, bind it with offset.
+		std::uint64_t offset{ 0 };
+		std::uint64_t size{ 0 };
+		std::uint64_t allocationId{ 0 }; // Opaque, identifies the range to free_buffer_allocation().
+	};
+	bool create_buffer_arena(BufferArenaHandle& outBufferArenaHandle, DeviceHandle deviceHandle, const BufferArenaInfo& bufferArenaInfo);
+	/**
+	 * @brief Destroy the arena's buffers once the GPU is done with them. Outstanding allocations become invalid.
+	 */
+	void destroy_buffer_arena(BufferArenaHandle bufferArenaHandle);
+	/**
+	 * @param alignment Must be a power of two. Vertex ranges bound with offsets only need their attribute alignment.
+	 */
+	bool allocate_from_buffer_arena(BufferAllocation& outAllocation, BufferArenaHandle bufferArenaHandle, std::uint64_t size, std::uint64_t alignment = 16);
+	/**
+	 * @brief Return a range to the arena. It is reusable immediately, so only free ranges the GPU is done with.
+	 */
+	void free_buffer_allocation(BufferArenaHandle bufferArenaHandle, const BufferAllocation& allocation);
+	/**
+	 * @brief Map a buffer the CPU can reach. Fails for BufferMemory::eGpuOnly buffers, use upload_buffer() for those.
+	 * Persistently mapped buffers return their mapping and unmap_buffer() leaves it mapped.
+	 */
 	bool map_buffer(BufferHandle bufferHandle, void*& outBufferPtr);
 	void unmap_buffer(BufferHandle bufferHandle);
+	/**
+	 * @brief The persistent mapping of an eUpload, eReadback or eDynamic buffer, which stays valid until the buffer is destroyed.
+	 * @return nullptr if the buffer is not persistently mapped.
+	 */
+	auto get_mapped_pointer(BufferHandle bufferHandle) -> void*;
+	/**
+	 * @brief The GPU address of a buffer created with BufferInfo::deviceAddress, valid until the buffer is destroyed.
+	 * Such buffers are never moved by defragmentation, so addresses stored in other buffers stay valid.
+	 * @return 0 if the buffer is unknown or was created without deviceAddress.
+	 */
+	auto get_buffer_device_address(BufferHandle bufferHandle) -> std::uint64_t;
+	/**
+	 * @brief Make CPU writes visible to the GPU. Only needed when the memory is not host coherent, otherwise it does nothing.
+	 */
+	void flush_buffer_range(BufferHandle bufferHandle, std::uint64_t offset = 0, std::uint64_t size = WHOLE_SIZE);
+	/**
+	 * @brief Make GPU writes visible to the CPU, after waiting for them. Only needed when the memory is not host coherent.
+	 */
+	void invalidate_buffer_range(BufferHandle bufferHandle, std::uint64_t offset = 0, std::uint64_t size = WHOLE_SIZE);
+	/**
+	 * @brief Copy data into a buffer. Buffers the CPU can reach are written directly, others through a staging buffer and a copy on the queue.
+	 * @return Reached once the copy has finished. Later work on the same queue is ordered after it, other queues should wait for it.
+	 */
+	auto upload_buffer(BufferHandle bufferHandle, const void* data, std::uint64_t size, std::uint64_t offset = 0, std::uint32_t queueIndex = 0) -> SyncPoint;
+	/**
+	 * @brief Copy data into the staging ring, for an upload batched by the next flush_uploads(). Never blocks.
+	 * With DeviceProperties::unifiedMemory, buffers other than sparse ones are mapped and written in place instead, immediately
+	 * rather than at the next flush_uploads(), and visible to work submitted after this returns. Like a staged upload, the
+	 * range must not be in use by the GPU.
+	 * Requires DeviceInfo::uploadBufferSize.
+	 * @return False if the ring has no room until earlier uploads complete, try again after a later flush.
+	 */
+	bool queue_buffer_upload(BufferHandle bufferHandle, const void* data, std::uint64_t size, std::uint64_t offset = 0);
 
 	enum class TextureType
 	{
-		e1D,
+		e1D, // Height and depth must be 1.
 		e2D,
 		e3D,
+		eCube, // Six square 2D faces, sampled by direction. Faces are array layers in +X, -X, +Y, -Y, +Z, -Z order.
 	};
 	enum class TextureUsage
 	{
 		eTexture,
 		eColorAttachment,
 		eDepthStencilAttachment,
+		eShadingRate, // A RenderPassInfo::shadingRateAttachment, eR8Uint and 2D. Uploaded like eTexture.
+		eStorage,	  // Written by shaders through DescriptorType::eStorageTexture. Also sampled and uploaded like eTexture.
+	};
+	/**
+	 * @brief Where a texture's memory lives.
+	 */
+	enum class TextureMemory
+	{
+		eDeviceLocal, // Fastest for the GPU.
+		eHostVisible, // Same as eDeviceLocal. Textures are optimally tiled and only written through staging, so host memory would
+					  // only slow sampling, and on integrated GPUs device local memory is host visible anyway.
+		eTransient,	  // Attachment contents that only live within a render pass (eg. depth, intermediate targets). Never stored,
+					  // and lazily allocated where supported, so tile-based GPUs keep it on chip.
 	};
 	struct TextureInfo
 	{
@@ -265,12 +1454,366 @@ namespace sm::gfx
 		TextureType type{};
 		std::uint32_t width{};
 		std::uint32_t height{};
+		// eRGB8 and eRGB32 textures the device cannot sample are created as RGBA instead. The upload functions still take RGB data
+		// and widen it with an opaque alpha; copy_buffer_to_texture() and readbacks see the RGBA texels.
 		Format format{};
-		std::uint32_t mipLevels{ 1 };
+		std::uint32_t depth{ 1 };	  // TextureType::e3D only.
+		std::uint32_t arrayLayers{ 1 }; // For TextureType::eCube, the number of cubes. More than one makes an array texture.
+		std::uint32_t mipLevels{ 1 };	// 0 for the full chain down to 1x1. Fill the levels past the first with generate_mipmaps().
+		TextureMemory memory{ TextureMemory::eDeviceLocal };
+		bool sparse{ false }; // 2D only. Created without memory, tiles are made resident with bind_sparse_texture_tiles().
+		bool mutableFormat{ false }; // Lets create_texture_view() reinterpret the format, e.g. an sRGB view of a UNORM texture.
+		// Samples per texel, a power of two. Multisampled textures are single level 2D attachments. Resolve them with
+		// RenderPassInfo::resolveAttachments and make them TextureMemory::eTransient, so on tile-based GPUs the samples
+		// never leave the chip and cost no memory.
+		std::uint32_t sampleCount{ 1 };
+		DedicatedAllocation dedicatedAllocation{ DedicatedAllocation::eAuto }; // Ignored by sparse and aliased textures.
+		// As BufferInfo::memoryPriority. Dedicated attachments left at the default get 1, so render targets are the last to
+		// be paged out, and streaming textures STREAMING_TEXTURE_MEMORY_PRIORITY.
+		float memoryPriority{ DEFAULT_MEMORY_PRIORITY };
+		std::string debugName{}; // Shown in debuggers and GPU profilers (RenderDoc, Nsight, RGP).
 	};
 	bool create_texture(TextureHandle& outTextureHandle, DeviceHandle deviceHandle, const TextureInfo& textureInfo);
+	/**
+	 * @brief Create many textures with a single device lookup and table reservation.
+	 * @param outTextureHandles Must be at least as large as textureInfos.
+	 */
+	bool create_textures(std::span<TextureHandle> outTextureHandles, DeviceHandle deviceHandle, std::span<const TextureInfo> textureInfos);
+	// Inclusive range of steps of some ordering, e.g. render graph passes, that a texture is used in.
+	struct TextureLifetime
+	{
+		std::uint32_t first;
+		std::uint32_t last;
+	};
+	/**
+	 * @brief Create textures in one shared allocation, with those whose lifetimes do not overlap placed in the same memory,
+	 * e.g. the render targets of passes that never need them at the same time. Sparse textures cannot be aliased.
+	 * Using a texture clobbers the others in its memory, so start each lifetime with acquire_aliased_texture().
+	 * The memory is freed with the last of the textures.
+	 * @param lifetimes One per texture.
+	 */
+	bool create_aliased_textures(std::span<TextureHandle> outTextureHandles, DeviceHandle deviceHandle, std::span<const TextureInfo> textureInfos, std::span<const TextureLifetime> lifetimes);
 	void destroy_texture(TextureHandle textureHandle);
 
+	// Memory heaps managed by the application, e.g. its own pools for particles or terrain. A heap is a single allocation,
+	// and buffers and textures are placed in it at offsets the application chooses, either its own or ranges allocated
+	// from the heap. Resources whose ranges overlap alias: writing one leaves the others' contents undefined, so start each
+	// use of an overlapping texture with acquire_aliased_texture().
+
+	enum class MemoryHeapType
+	{
+		eDeviceLocal, // For textures, and buffers the CPU never touches.
+		eUpload,	  // Host visible, coherent and persistently mapped, for buffers the CPU writes and the GPU reads.
+		eReadback,	  // As eUpload, cached where possible, for buffers the GPU writes and the CPU reads.
+	};
+	struct MemoryHeapInfo
+	{
+		std::uint64_t size;
+		MemoryHeapType type{ MemoryHeapType::eDeviceLocal };
+		float memoryPriority{ DEFAULT_MEMORY_PRIORITY }; // See BufferInfo::memoryPriority.
+		std::string debugName{};					   // Names the heap's allocation in dump_memory_report().
+	};
+	// What a resource needs from the range it is placed at.
+	struct PlacementRequirements
+	{
+		std::uint64_t size{ 0 };
+		std::uint64_t alignment{ 1 }; // The offset must be a multiple of it.
+	};
+	struct MemoryHeapAllocation
+	{
+		std::uint64_t offset{ 0 };
+		std::uint64_t size{ 0 };
+		std::uint64_t allocationId{ 0 }; // Opaque, identifies the range to free_memory_heap_allocation().
+	};
+	bool create_memory_heap(MemoryHeapHandle& outMemoryHeapHandle, DeviceHandle deviceHandle, const MemoryHeapInfo& memoryHeapInfo);
+	/**
+	 * @brief Release the heap. Its memory is freed once the resources placed in it are destroyed too, and its allocations become invalid.
+	 */
+	void destroy_memory_heap(MemoryHeapHandle memoryHeapHandle);
+	bool get_placement_requirements(PlacementRequirements& outRequirements, DeviceHandle deviceHandle, const BufferInfo& bufferInfo);
+	bool get_placement_requirements(PlacementRequirements& outRequirements, DeviceHandle deviceHandle, const TextureInfo& textureInfo);
+	/**
+	 * @brief Create a buffer in a heap's memory at offset. The heap's type decides where it lives, so BufferInfo::memory,
+	 * dedicatedAllocation and memoryPriority are ignored. Not sparse. Destroyed with destroy_buffer().
+	 */
+	bool create_buffer_placed(BufferHandle& outBufferHandle, MemoryHeapHandle memoryHeapHandle, std::uint64_t offset, const BufferInfo& bufferInfo);
+	/**
+	 * @brief Create a texture in a MemoryHeapType::eDeviceLocal heap's memory at offset. Not sparse. Destroyed with destroy_texture().
+	 */
+	bool create_texture_placed(TextureHandle& outTextureHandle, MemoryHeapHandle memoryHeapHandle, std::uint64_t offset, const TextureInfo& textureInfo);
+	/**
+	 * @brief Sub-allocate a range of the heap with VMA's virtual allocator, for applications that do not track offsets themselves.
+	 * @param alignment Must be a power of two, e.g. PlacementRequirements::alignment.
+	 */
+	bool allocate_from_memory_heap(MemoryHeapAllocation& outAllocation, MemoryHeapHandle memoryHeapHandle, std::uint64_t size, std::uint64_t alignment);
+	/**
+	 * @brief Return a range to the heap. It is reusable immediately, so only free ranges the GPU is done with.
+	 */
+	void free_memory_heap_allocation(MemoryHeapHandle memoryHeapHandle, const MemoryHeapAllocation& allocation);
+
+	// External memory and semaphores, for handing frames to another process (e.g. a capture and encode process) or API (e.g.
+	// CUDA, video encoders) without copies, synchronised on the GPU alone. Needs DeviceFeatureFlags_ExternalMemory, and both sides
+	// on the same GPU and driver. Handles are file descriptors on Linux and NT handles on Windows, passed between processes by the
+	// application, e.g. over a Unix domain socket or with DuplicateHandle().
+	//
+	//   Producer: create_texture_exportable(), export_texture_memory() and export_queue_timeline() once. Each frame, release
+	//             the texture to EXTERNAL_QUEUE_INDEX after rendering, submit, and send the SyncPoint::value to wait for.
+	//   Consumer: import_texture() with the producer's TextureInfo once. Each frame, wait for the value on the imported timeline,
+	//             acquire the texture from EXTERNAL_QUEUE_INDEX, read it, and release it back.
+	// Before rendering into it again the producer waits for the consumer's reads, e.g. with import_semaphore().
+#if defined(_WIN32)
+	using ExternalHandle = void*; // A Windows HANDLE.
+	constexpr ExternalHandle INVALID_EXTERNAL_HANDLE = nullptr;
+#else
+	using ExternalHandle = int; // A file descriptor.
+	constexpr ExternalHandle INVALID_EXTERNAL_HANDLE = -1;
+#endif
+
+	// For transfer_texture_ownership() and transfer_buffer_ownership(), the queues outside this device sharing external memory.
+	constexpr std::uint32_t EXTERNAL_QUEUE_INDEX = ~0u;
+
+	// A resource's memory, as exported by one device and imported by another.
+	struct ExternalMemory
+	{
+		ExternalHandle handle{ INVALID_EXTERNAL_HANDLE };
+		std::uint64_t size{ 0 };			// Of the whole allocation, which the import has to match.
+		std::uint32_t memoryTypeIndex{ 0 }; // Likewise.
+	};
+	/**
+	 * @brief Create a buffer in device local memory of its own, which export_buffer_memory() can share. Not sparse, and
+	 * BufferInfo::memory, dedicatedAllocation and memoryPriority are ignored. Destroyed with destroy_buffer().
+	 */
+	bool create_buffer_exportable(BufferHandle& outBufferHandle, DeviceHandle deviceHandle, const BufferInfo& bufferInfo);
+	/**
+	 * @brief As create_buffer_exportable(), for a non-sparse, non-transient texture. Destroyed with destroy_texture().
+	 */
+	bool create_texture_exportable(TextureHandle& outTextureHandle, DeviceHandle deviceHandle, const TextureInfo& textureInfo);
+	/**
+	 * @brief Export the memory of a buffer from create_buffer_exportable(). Each call makes a new handle, which the caller owns:
+	 * close it, or hand it to an import, once done with it. The memory lives until every importer and the buffer are gone.
+	 */
+	bool export_buffer_memory(ExternalMemory& outMemory, BufferHandle bufferHandle);
+	bool export_texture_memory(ExternalMemory& outMemory, TextureHandle textureHandle);
+	/**
+	 * @brief Create a buffer bound to memory exported by another device, e.g. in another process. bufferInfo must be the one
+	 * the exported buffer was created with. On Linux the file descriptor belongs to the buffer once this succeeds, on Windows
+	 * the caller still closes the handle. Destroyed with destroy_buffer().
+	 */
+	bool import_buffer(BufferHandle& outBufferHandle, DeviceHandle deviceHandle, const ExternalMemory& memory, const BufferInfo& bufferInfo);
+	/**
+	 * @brief As import_buffer(), for a texture. Starts in TextureState::eUndefined, acquire it with transfer_texture_ownership()
+	 * from EXTERNAL_QUEUE_INDEX, from the state the exporter released it in, to keep its contents. Destroyed with destroy_texture().
+	 */
+	bool import_texture(TextureHandle& outTextureHandle, DeviceHandle deviceHandle, const ExternalMemory& memory, const TextureInfo& textureInfo);
+	/**
+	 * @brief Export the timeline semaphore a queue signals with the values of its SyncPoints, for another process or API to import
+	 * as a timeline semaphore and wait on. Each call makes a new handle, which the caller owns.
+	 */
+	bool export_queue_timeline(ExternalHandle& outHandle, DeviceHandle deviceHandle, std::uint32_t queueIndex);
+	/**
+	 * @brief Import a binary semaphore payload signalled elsewhere, e.g. a sync file exported from another process's submission,
+	 * to be waited on once like any other SemaphoreHandle (SubmitInfo::waitSemaphoreHandle or SubmitBatch::waitSemaphores). On
+	 * Linux the handle is a sync file descriptor, which belongs to the semaphore once this succeeds. On Windows it is an NT handle
+	 * the caller still closes.
+	 */
+	bool import_semaphore(SemaphoreHandle& outSemaphoreHandle, DeviceHandle deviceHandle, ExternalHandle handle);
+
+	// Hardware video decoding (DeviceFeatureFlags_VideoDecode) on a queue created with QueueFlags_VideoDecode. Frames are
+	// decoded in video memory and copied on the GPU into textures shaders sample, so there is neither a CPU decode nor an upload
+	// per frame. gfx does not parse bitstreams: the application's demuxer and parser (e.g. FFmpeg's) fill in the std structs of
+	// the parameter sets and each picture, and find its slices or tiles, as the Vulkan Video decode chapters describe.
+	//
+	// Frames are 4:2:0 and land in two textures: the luma plane in an eR8 texture (eR16Unorm above 8 bits) of the frame's size,
+	// and the chroma plane, Cb in red and Cr in green, in an eRG8 (eRG16Unorm) texture of half its width and height, rounded up.
+	// Shaders convert them to RGB with the stream's matrix, e.g. for BT.709 in limited range:
+	//
+	//   float y = 1.1644 * (luma - 0.0627); float2 c = chroma - 0.5;
+	//   float3 rgb = float3(y + 1.7927 * c.y, y - 0.2132 * c.x - 0.5329 * c.y, y + 2.1124 * c.x);
+	enum class VideoCodec
+	{
+		eH264,
+		eH265,
+		eAV1,
+	};
+	struct VideoDecoderInfo
+	{
+		VideoCodec codec{};
+		std::uint32_t profile{ 0 }; // StdVideoH264ProfileIdc, StdVideoH265ProfileIdc or StdVideoAV1Profile of the stream.
+		std::uint32_t bitDepth{ 8 }; // 8 or 10.
+		std::uint32_t maxWidth{ 0 };
+		std::uint32_t maxHeight{ 0 };
+		std::uint32_t dpbSlotCount{ 17 }; // Pictures kept to be referenced, the most the stream references plus one for the frame decoded.
+		std::uint64_t maxBitstreamSize{ 4u << 20u }; // Bytes of the largest compressed frame.
+		std::uint32_t framesInFlight{ 3 };			 // Frames whose bitstream can be queued on the GPU at once.
+		std::uint32_t decodeQueueIndex{ 0 };		 // Created with QueueFlags_VideoDecode.
+		std::uint32_t outputQueueIndex{ 0 };		 // Copies frames into their textures, e.g. the graphics queue sampling them.
+	};
+	/**
+	 * @brief Create a decoder for one stream. Fails if the decode queue's family or the device cannot decode the codec, profile,
+	 * bit depth or size. Frames cannot be decoded until set_video_parameters() has been called.
+	 */
+	bool create_video_decoder(VideoDecoderHandle& outVideoDecoderHandle, DeviceHandle deviceHandle, const VideoDecoderInfo& decoderInfo);
+	void destroy_video_decoder(VideoDecoderHandle videoDecoderHandle);
+
+	// The parameter sets of the codec the decoder was created for. Pointer and count pairs, as the std structs are incomplete here.
+	struct VideoParameters
+	{
+		const StdVideoH264SequenceParameterSet* h264Sps{ nullptr };
+		std::uint32_t h264SpsCount{ 0 };
+		const StdVideoH264PictureParameterSet* h264Pps{ nullptr };
+		std::uint32_t h264PpsCount{ 0 };
+
+		const StdVideoH265VideoParameterSet* h265Vps{ nullptr };
+		std::uint32_t h265VpsCount{ 0 };
+		const StdVideoH265SequenceParameterSet* h265Sps{ nullptr };
+		std::uint32_t h265SpsCount{ 0 };
+		const StdVideoH265PictureParameterSet* h265Pps{ nullptr };
+		std::uint32_t h265PpsCount{ 0 };
+
+		const StdVideoAV1SequenceHeader* av1SequenceHeader{ nullptr };
+	};
+	/**
+	 * @brief Set the parameter sets later frames decode with, e.g. as the parser meets them. H.264 and H.265 sets are added to the
+	 * ones set before, replacing those with the same ids, while an AV1 sequence header replaces the last. Frames already decoding
+	 * keep the ones they were decoded with.
+	 */
+	bool set_video_parameters(VideoDecoderHandle videoDecoderHandle, const VideoParameters& parameters);
+
+	// A picture in a DPB slot, and the std reference info of the decoder's codec for it.
+	struct VideoReference
+	{
+		std::uint32_t dpbSlot{ 0 }; // Below VideoDecoderInfo::dpbSlotCount.
+		const StdVideoDecodeH264ReferenceInfo* h264ReferenceInfo{ nullptr };
+		const StdVideoDecodeH265ReferenceInfo* h265ReferenceInfo{ nullptr };
+		const StdVideoDecodeAV1ReferenceInfo* av1ReferenceInfo{ nullptr };
+	};
+	struct VideoFrameInfo
+	{
+		const void* bitstream{ nullptr }; // The frame's compressed data, copied before decode_video_frame() returns.
+		std::uint64_t bitstreamSize{ 0 };  // At most VideoDecoderInfo::maxBitstreamSize.
+		std::uint32_t width{ 0 };		   // The coded size of the frame, from its parameter sets.
+		std::uint32_t height{ 0 };
+
+		// The std picture info of the decoder's codec.
+		const StdVideoDecodeH264PictureInfo* h264PictureInfo{ nullptr };
+		const StdVideoDecodeH265PictureInfo* h265PictureInfo{ nullptr };
+		const StdVideoDecodeAV1PictureInfo* av1PictureInfo{ nullptr };
+		// Where each H.264 slice, H.265 slice segment or AV1 tile starts in the bitstream.
+		std::span<const std::uint32_t> sliceOffsets{};
+		std::span<const std::uint32_t> av1TileSizes{}; // Bytes of each tile.
+		std::uint32_t av1FrameHeaderOffset{ 0 };
+		// For each of the 7 AV1 reference names (LAST_FRAME to ALTREF_FRAME), the DPB slot it refers to, or -1.
+		std::array<std::int32_t, 7> av1ReferenceNameSlots{ -1, -1, -1, -1, -1, -1, -1 };
+
+		// The slot the frame is decoded into, reference or not, where later frames find it. Slots are the application's to
+		// assign, as the parser decides which pictures stay referenced.
+		VideoReference setupReference{};
+		std::span<const VideoReference> references{}; // The pictures the frame is predicted from.
+
+		// Receive the frame, ending up in TextureState::eShaderRead, unless unset for frames that are not shown. Sampled
+		// (TextureUsage::eTexture) 2D textures of the formats above, at least as large as the frame's planes.
+		TextureHandle lumaTexture{};
+		TextureHandle chromaTexture{};
+	};
+	/**
+	 * @brief Decode a frame on the decode queue, then copy it into its textures on the output queue. Neither waits on the CPU,
+	 * unless every frame in flight is still decoding. Frames must be decoded in the stream's decode order, from one thread.
+	 * @return Reached once the frame is in its textures, or decoded for frames that are not shown. Later work on the output queue
+	 * is ordered after it, other queues should wait for it. A default SyncPoint on failure.
+	 */
+	auto decode_video_frame(VideoDecoderHandle videoDecoderHandle, const VideoFrameInfo& frameInfo) -> SyncPoint;
+
+	// Mip streaming. A streaming texture only allocates the levels from its first resident mip down: its image is that
+	// part of the chain, so sampling is clamped to the resident levels without shader changes, and the memory of the
+	// finer levels is only spent while they are wanted.
+	// Feedback is application defined, e.g. shaders atomically min the mip level they sampled into a storage buffer read
+	// back with read_buffer(). Turn it into requests, fit them with fit_texture_streaming_budget(), then stream.
+	// Streaming textures are allocated below the default memory priority, so under memory pressure the driver pages them
+	// out before render targets and geometry.
+	constexpr float STREAMING_TEXTURE_MEMORY_PRIORITY = 0.25f;
+
+	/**
+	 * @brief Create a texture whose levels past firstResidentMip are streamed in and out later.
+	 * @param textureInfo Describes the whole chain. Only 2D or cube, sampled (TextureUsage::eTexture), non-sparse textures.
+	 * The resident levels are undefined until uploaded, with stream_texture_mips() or with queue_texture_upload(), whose
+	 * mip levels then count from the first resident one.
+	 */
+	bool create_streaming_texture(TextureHandle& outTextureHandle, DeviceHandle deviceHandle, const TextureInfo& textureInfo, std::uint32_t firstResidentMip);
+	/**
+	 * @return The finest resident level of the whole chain, 0 for textures that are not streamed.
+	 */
+	auto get_texture_first_resident_mip(TextureHandle textureHandle) -> std::uint32_t;
+	/**
+	 * @brief Make the levels from firstResidentMip down resident. Levels already resident are copied over on the GPU, levels
+	 * gained are uploaded from levelData, and levels no longer wanted are freed. The texture ends in TextureState::eShaderRead.
+	 * The handle keeps working: descriptor sets it is bound to, and its bindless heap slot, are rewritten without waiting for
+	 * the GPU, once the submissions in flight when streaming retire. Until then they keep sampling the previous levels, so
+	 * like update_descriptor_set() the sets should not be in use by submissions still executing at that point.
+	 * @param levelData One tightly packed level per gained level, finest first. Empty when only evicting.
+	 * @param queueIndex Should be the queue the texture is sampled on.
+	 * @return Reached once the new levels are usable.
+	 */
+	auto stream_texture_mips(TextureHandle textureHandle, std::uint32_t firstResidentMip, std::span<const std::span<const std::byte>> levelData, std::uint32_t queueIndex = 0) -> SyncPoint;
+
+	struct TextureStreamingRequest
+	{
+		TextureHandle textureHandle{};
+		std::uint32_t wantedMip{ 0 }; // Finest level feedback asked for. Coarsened in place to fit the budget.
+		float priority{ 1.0f };		  // Lower priorities lose detail first.
+	};
+	/**
+	 * @brief Coarsen wanted mips, lowest priority and then largest first, until every requested texture fits in budgetFraction of
+	 * the device local budget from get_memory_stats(), less what is used by everything else.
+	 * Textures are never coarsened past their smallest level.
+	 * With DeviceProperties::pageableMemory, the requested textures' memory priorities are also spread below
+	 * STREAMING_TEXTURE_MEMORY_PRIORITY by request priority, so the coldest are the first paged out.
+	 * @return Bytes the requested textures will use once streamed.
+	 */
+	auto fit_texture_streaming_budget(DeviceHandle deviceHandle, std::span<TextureStreamingRequest> requests, float budgetFraction = 0.8f) -> std::uint64_t;
+
+	// Sparse resources, for data sets larger than the memory budget. Only the pages or tiles in use are backed by memory,
+	// and binding runs on a queue that supports sparse binding, so streaming never stalls the queues that render.
+	// Shaders may access non-resident parts, but reads return undefined values.
+
+	struct SparseBufferBind
+	{
+		std::uint64_t offset{ 0 }; // A multiple of get_sparse_page_size().
+		std::uint64_t size{ 0 };   // Rounded up to whole pages.
+		bool resident{ true };	   // False evicts the pages, freeing their memory once the unbind has completed.
+	};
+	struct SparseTextureBind
+	{
+		std::uint32_t mipLevel{ 0 }; // Below SparseTextureProperties::mipTailFirstLevel.
+		std::uint32_t arrayLayer{ 0 };
+		std::uint32_t x{ 0 }; // Texel region, x and y multiples of the tile size. The region is rounded out to whole tiles.
+		std::uint32_t y{ 0 };
+		std::uint32_t width{ 0 };
+		std::uint32_t height{ 0 };
+		bool resident{ true };
+	};
+	struct SparseTextureProperties
+	{
+		std::uint32_t tileWidth{ 0 }; // In texels.
+		std::uint32_t tileHeight{ 0 };
+		std::uint32_t mipTailFirstLevel{ 0 }; // Levels from here on are packed together, made resident by the first bind and never evicted.
+	};
+	/**
+	 * @return The granularity of a sparse buffer's pages, or 0 if it is not sparse.
+	 */
+	auto get_sparse_page_size(BufferHandle bufferHandle) -> std::uint64_t;
+	bool get_sparse_texture_properties(SparseTextureProperties& outProperties, TextureHandle textureHandle);
+	/**
+	 * @brief Make pages resident or evict them. Pages already in the requested state are skipped.
+	 * @param queueIndex A queue that supports sparse binding, ideally one that does not render.
+	 * @param waitSyncPoints Work the bind waits for on the GPU, e.g. the last use of evicted pages on other queues.
+	 * @return Reached once the binds have completed. Work using the new pages on other queues must wait for it.
+	 */
+	auto bind_sparse_buffer_pages(BufferHandle bufferHandle, std::uint32_t queueIndex, std::span<const SparseBufferBind> binds, std::span<const SyncPoint> waitSyncPoints = {}) -> SyncPoint;
+	/**
+	 * @brief Like bind_sparse_buffer_pages(), for tiles of a sparse texture.
+	 */
+	auto bind_sparse_texture_tiles(TextureHandle textureHandle, std::uint32_t queueIndex, std::span<const SparseTextureBind> binds, std::span<const SyncPoint> waitSyncPoints = {}) -> SyncPoint;
+
 	enum class SamplerAddressMode
 	{
 		eRepeat,
@@ -281,24 +1824,150 @@ namespace sm::gfx
 		eLinear,
 		eNearest,
 	};
+	/**
+	 * @brief Comparison of depth samplers against the reference value, e.g. for shadow maps sampled with sampler2DShadow.
+	 */
+	enum class SamplerCompareOp
+	{
+		eNone, // Not a comparison sampler.
+		eNever,
+		eLess,
+		eEqual,
+		eLessOrEqual,
+		eGreater,
+		eNotEqual,
+		eGreaterOrEqual,
+		eAlways,
+	};
+	constexpr float LOD_CLAMP_NONE = 1000.0f; // No upper limit on the mip level sampled.
 	struct SamplerInfo
 	{
 		SamplerAddressMode addressMode;
 		SamplerFilterMode filterMode;
+		SamplerFilterMode mipFilterMode{ SamplerFilterMode::eNearest }; // Between mip levels, eLinear for trilinear filtering.
+		float maxAnisotropy{ 1.0f };									  // Above 1 enables anisotropic filtering, clamped to the device limit.
+		float mipLodBias{ 0.0f };
+		float minLod{ 0.0f };
+		float maxLod{ LOD_CLAMP_NONE };
+		SamplerCompareOp compareOp{ SamplerCompareOp::eNone };
+
+		bool operator==(const SamplerInfo&) const = default;
 	};
+	/**
+	 * @brief Samplers are shared: creating one identical to a live sampler returns the same handle, and each create_sampler()
+	 * needs its own destroy_sampler(). Drivers only support a few thousand samplers, so describe them rather than store them.
+	 */
 	bool create_sampler(SamplerHandle& outSamplerHandle, DeviceHandle deviceHandle, const SamplerInfo& samplerInfo);
 	void destroy_sampler(SamplerHandle samplerHandle);
 
+	/**
+	 * @brief How presented images are queued for display. Unsupported modes fall back towards eFifo, which is always available.
+	 */
+	enum class PresentMode
+	{
+		eLowestLatency, // Present immediately, which may tear. Falls back to eMailbox.
+		eMailbox,		// Newer images replace queued ones without tearing. The GPU keeps rendering at full rate.
+		eFifo,			// VSync. The GPU is throttled to the display rate.
+		eFifoRelaxed,	// VSync, but a frame that missed its refresh is shown immediately (and may tear) instead of waiting a whole refresh.
+	};
+
 	struct SwapChainInfo
 	{
 		void* platformDisplayHandle; // Windows=HINSTANCE
 		void* platformWindowHandle;	 // Windows=HWND
 		std::int32_t initialWidth;
 		std::int32_t initialHeight;
+		PresentMode presentMode{ PresentMode::eFifo };
+		std::uint32_t imageCount{ 0 }; // Wanted number of images, clamped to what the surface allows. 0 uses one more than the minimum.
+		bool imageCountMatchesFramesInFlight{ false }; // Use one image per frame in flight instead of imageCount, for the lowest latency.
+		bool lowLatency{ false };	   // Use the driver's low latency mode (VK_NV_low_latency2 or VK_AMD_anti_lag), see latency_sleep().
+		bool headless{ false };		   // Rotate offscreen RGBA8 textures instead of presenting to a window, the platform handles are ignored. imageCount 0 uses framesInFlight + 1.
 	};
 	bool create_swap_chain(SwapChainHandle& outSwapChainHandle, DeviceHandle deviceHandle, const SwapChainInfo& swapChainInfo);
 	void destroy_swap_chain(SwapChainHandle swapChainHandle);
-	void present_swap_chain(SwapChainHandle swapChainHandle, std::uint32_t queueIndex, SemaphoreHandle* waitSemaphore);
+	/**
+	 * @brief Resize the swap chain once its current image has been presented, without waiting for the GPU to go idle.
+	 * Image handles stay valid across the resize. Swap chains the surface reports as out of date or suboptimal are resized automatically.
+	 */
+	void resize_swap_chain(SwapChainHandle swapChainHandle, std::int32_t width, std::int32_t height);
+	/**
+	 * @brief Change the wanted number of images at runtime (0 uses one more than the surface's minimum).
+	 * Like resize_swap_chain() it applies once the current image has been presented, without waiting for the GPU to go idle.
+	 */
+	void set_swap_chain_image_count(SwapChainHandle swapChainHandle, std::uint32_t imageCount);
+	/**
+	 * @brief The number of images the swap chain actually has, which the surface's limits may have changed from the wanted count.
+	 */
+	auto get_swap_chain_image_count(SwapChainHandle swapChainHandle) -> std::uint32_t;
+	/**
+	 * @brief Switch the present mode at runtime. Recreates the swap chain, so waits for the GPU to go idle.
+	 */
+	void set_swap_chain_present_mode(SwapChainHandle swapChainHandle, PresentMode presentMode);
+	/**
+	 * @brief Queue the current image for display and acquire the next one.
+	 * Present each swap chain at most once between begin_frame() and end_frame(), the acquire semaphores are recycled per frame.
+	 * @param desiredPresentTimeNs With display timing support, the image is not shown before this time (see PresentTiming). 0 shows it as soon as possible.
+	 * @return The id of this present, increasing by one per present. Used with wait_for_swap_chain_present() and get_swap_chain_present_timings().
+	 */
+	auto present_swap_chain(SwapChainHandle swapChainHandle, std::uint32_t queueIndex, SemaphoreHandle* waitSemaphore, std::uint64_t desiredPresentTimeNs = 0) -> std::uint64_t;
+	/**
+	 * @brief present_swap_chain() for several swap chains of a device at once, e.g. an editor's viewports. They are queued with a
+	 * single present, so the driver and compositor synchronise once rather than per window. Up to 16 swap chains, each once.
+	 * @param outPresentIds Empty, or the id of each swap chain's present.
+	 */
+	bool present_swap_chains(std::span<const SwapChainHandle> swapChainHandles, std::uint32_t queueIndex, SemaphoreHandle* waitSemaphore, std::span<std::uint64_t> outPresentIds = {}, std::uint64_t desiredPresentTimeNs = 0);
+	/**
+	 * @brief Block until the present with the given id has reached the display (VK_KHR_present_wait).
+	 * Pace frames by waiting on the present from one or two frames ago before sampling input for the next.
+	 * @return False on timeout, or when present waits are not supported.
+	 */
+	bool wait_for_swap_chain_present(SwapChainHandle swapChainHandle, std::uint64_t presentId, std::uint64_t timeoutNs = INFINITE_TIMEOUT);
+
+	/**
+	 * @brief Points of a frame reported to the driver's low latency mode. Presents are marked automatically.
+	 */
+	enum class LatencyMarker
+	{
+		eSimulationStart,
+		eSimulationEnd,
+		eRenderSubmitStart, // Start of the CPU work recording and submitting the frame.
+		eRenderSubmitEnd,
+		eInputSample,
+	};
+	/**
+	 * @brief Block until the best time to start the next frame, so input is sampled as late as possible. Call before eSimulationStart.
+	 * Without driver support this falls back to keeping at most one frame queued ahead of the display (needs present waits).
+	 * Does nothing unless the swap chain was created with lowLatency.
+	 */
+	void latency_sleep(SwapChainHandle swapChainHandle);
+	/**
+	 * @brief Mark a point of the frame that will be presented next. Only used by VK_NV_low_latency2.
+	 */
+	void set_latency_marker(SwapChainHandle swapChainHandle, LatencyMarker marker);
+
+	/**
+	 * @brief When a past present reached the display (VK_GOOGLE_display_timing). Times are in nanoseconds of the presentation clock.
+	 */
+	struct PresentTiming
+	{
+		std::uint64_t presentId;
+		std::uint64_t desiredPresentTimeNs;
+		std::uint64_t actualPresentTimeNs;
+		std::uint64_t earliestPresentTimeNs; // The image could have been shown this early if it had been asked for.
+		std::uint64_t presentMarginNs;		 // How long before its deadline the image was ready.
+	};
+	/**
+	 * @brief Timings of presents that completed since the last call. Empty when display timing is not supported.
+	 */
+	bool get_swap_chain_present_timings(std::vector<PresentTiming>& outPresentTimings, SwapChainHandle swapChainHandle);
+	/**
+	 * @brief Duration of one display refresh, in nanoseconds. Fails when display timing is not supported.
+	 */
+	bool get_swap_chain_refresh_duration(std::uint64_t& outRefreshDurationNs, SwapChainHandle swapChainHandle);
+	/**
+	 * @brief The image to render this frame to.
+	 * @return False, with a null handle, when no image could be acquired (eg. the window is minimised). Skip rendering to it then.
+	 */
 	bool get_swap_chain_image(TextureHandle& outTextureHandle, SwapChainHandle swapChainHandle);
 
 #pragma endregion
@@ -310,46 +1979,797 @@ namespace sm::gfx
 	bool begin(CommandListHandle commandListHandle);
 	void end(CommandListHandle commandListHandle);
 
+	/**
+	 * @brief Time the commands recorded between the two with GPU timestamps, see get_gpu_scope_timings(). Scopes nest, and
+	 * each begun on a command list must be ended on it before it ends. Needs DeviceInfo::gpuScopesPerFrame, once a frame's
+	 * scopes run out further ones are not timed. The command list must be submitted in the frame it was recorded in.
+	 */
+	void begin_gpu_scope(CommandListHandle commandListHandle, std::string_view name);
+	void end_gpu_scope(CommandListHandle commandListHandle);
+	/**
+	 * @brief Count what the commands recorded between the two do, see get_gpu_query_results(). Only one query of each type can
+	 * be open on a command list at a time. Occlusion queries begin and end within one render pass, or outside of any.
+	 * Needs DeviceInfo::gpuQueriesPerFrame, and otherwise works like begin_gpu_scope().
+	 */
+	void begin_gpu_query(CommandListHandle commandListHandle, GpuQueryType type, std::string_view name);
+	void end_gpu_query(CommandListHandle commandListHandle, GpuQueryType type);
+	/**
+	 * @brief Label the commands recorded between the two with a VK_EXT_debug_utils marker, which debuggers and GPU profilers
+	 * (RenderDoc, Nsight, RGP) show them grouped under. Markers nest, any still pushed when the command list ends are popped.
+	 */
+	void push_marker(CommandListHandle commandListHandle, std::string_view name);
+	void pop_marker(CommandListHandle commandListHandle);
+
+	constexpr std::uint32_t MAX_COLOR_ATTACHMENTS = 8;
+	constexpr std::uint32_t MAX_BOUND_DESCRIPTOR_SETS = 8;
+	constexpr std::uint32_t MAX_DYNAMIC_OFFSETS = 8;
+	constexpr std::uint32_t MAX_PUSH_DESCRIPTORS = 32; // In a push set, across all of its bindings.
+	constexpr std::uint32_t MAX_VERTEX_BUFFER_BINDINGS = 16;
+
+	enum class LoadOp
+	{
+		eClear,
+		eLoad,
+		eDontCare, // The previous contents are not needed, so tile-based GPUs skip reading them in.
+	};
+	enum class StoreOp
+	{
+		eStore,
+		eDontCare, // The contents are not needed after the pass, so tile-based GPUs skip writing them out.
+	};
+
 	struct RenderPassInfo
 	{
-		std::vector<TextureHandle> colorAttachments;
+		std::array<TextureHandle, MAX_COLOR_ATTACHMENTS> colorAttachments{}; // Attachments up to the first null handle are used.
 		TextureHandle depthAttachment;
+		// View of each attachment from create_texture_view(), 0 for the default. Views must cover a single mip level and layer
+		// (or one layer per view, see viewMask) in the texture's format, the render area is their mip level's extent.
+		std::array<std::uint32_t, MAX_COLOR_ATTACHMENTS> colorAttachmentViews{};
+		std::uint32_t depthAttachmentView{ 0 };
+		// Single-sampled textures the multisampled color attachment at the same index is resolved into (averaged, or sample 0
+		// for integer formats) at the end of the pass, null for none. Written through their default view, in TextureState::eRenderTarget.
+		std::array<TextureHandle, MAX_COLOR_ATTACHMENTS> resolveAttachments{};
 		std::array<float, 4> clearColor{ 1.0f, 1.0f, 1.0f, 1.0f };
+		bool secondaryCommandLists{ false }; // The pass contents come from secondary command lists via execute_commands().
+		std::array<LoadOp, MAX_COLOR_ATTACHMENTS> colorLoadOps{};	  // eClear by default.
+		std::array<StoreOp, MAX_COLOR_ATTACHMENTS> colorStoreOps{}; // eStore by default. Transient textures are never stored.
+		LoadOp depthLoadOp{ LoadOp::eClear };
+		StoreOp depthStoreOp{ StoreOp::eDontCare };
+		// Area rendered as {x, y, width, height}. A zero width covers the first color attachment, or the depth attachment
+		// of a depth-only pass. Required for a pass without attachments.
+		std::array<std::uint32_t, 4> renderArea{};
+		// Multiview (DeviceFeatureFlags_Multiview): the draws are broadcast to each view whose bit is set, rendering into that
+		// layer of the attachments' views, which shaders tell apart by gl_ViewIndex. Eg. 0b11 for both eyes of a stereo pass, or
+		// 0b111111 for a cube shadow map, in one pass rather than one per layer. 0 renders the first layer once.
+		std::uint32_t viewMask{ 0 };
+		// Variable rate shading (DeviceFeatureFlags_ShadingRate): a TextureUsage::eShadingRate texture in TextureState::eShadingRate,
+		// each texel the ShadingRate of DeviceProperties::shadingRateTexelSize pixels, eg. coarser in the periphery or where
+		// motion blurred. Applies to pipelines without DynamicStateFlags_ShadingRate, see set_shading_rate() for the others.
+		TextureHandle shadingRateAttachment{};
+		// Local read (DeviceFeatureFlags_LocalRead): the color attachments, in TextureState::eLocalRead, can also be read as
+		// DescriptorType::eInputAttachment at the same pixel, eg. a deferred lighting pass reading the G-buffer it was just
+		// drawn into. Tile-based GPUs keep the G-buffer on chip rather than writing it out and sampling it in a second pass.
+		// The depth attachment cannot be read this way, write depth to a color attachment too where lighting needs it.
+		bool localRead{ false };
 	};
 	void begin_render_pass(CommandListHandle commandListHandle, const RenderPassInfo& renderPassInfo);
 	void end_render_pass(CommandListHandle commandListHandle);
 
+	/**
+	 * @brief Begin recording a secondary command list that continues the given render pass.
+	 * Viewport, scissor and pipeline state are not inherited, so they must be set in each secondary command list.
+	 */
+	bool begin_secondary(CommandListHandle commandListHandle, const RenderPassInfo& renderPassInfo);
+
+	/**
+	 * @brief Run secondary command lists inside the current render pass of the primary command list.
+	 * The render pass must have been begun with RenderPassInfo::secondaryCommandLists.
+	 */
+	void execute_commands(CommandListHandle commandListHandle, std::span<const CommandListHandle> secondaryCommandLists);
+
 	void set_viewport(CommandListHandle commandListHandle, float x, float y, float width, float height, float minDepth = 0.0f, float maxDepth = 1.0f);
 	void set_scissor(CommandListHandle commandListHandle, std::int32_t x, std::int32_t y, std::uint32_t width, std::uint32_t height);
 
+	// Dynamic pipeline state, for pipelines created with the matching DynamicStateFlags_. Set after binding the pipeline.
+	void set_cull_mode(CommandListHandle commandListHandle, CullMode cullMode);
+	void set_front_face(CommandListHandle commandListHandle, FrontFace frontFace);
+	void set_primitive_topology(CommandListHandle commandListHandle, PrimitiveTopology topology, bool primitiveRestart = false);
+	void set_depth_state(CommandListHandle commandListHandle, bool depthTest, bool depthWrite, CompareOp depthCompareOp);
+	void set_stencil_state(CommandListHandle commandListHandle, bool stencilTest, const StencilState& stencilFront, const StencilState& stencilBack);
+	/**
+	 * @brief Blend state of consecutive color attachments from firstAttachment. Fails where VK_EXT_extended_dynamic_state3 is not supported.
+	 */
+	void set_blend_states(CommandListHandle commandListHandle, std::uint32_t firstAttachment, std::span<const BlendState> blendStates);
+	/**
+	 * @brief Pixels shaded by one fragment shader invocation, width x height. The values are those of shading rate attachment
+	 * texels, (log2(width) << 2) | log2(height).
+	 */
+	enum class ShadingRate : std::uint8_t
+	{
+		e1x1 = 0,
+		e1x2 = 1,
+		e2x1 = 4,
+		e2x2 = 5,
+		e2x4 = 6,
+		e4x2 = 9,
+		e4x4 = 10,
+	};
+	// How a rate combines with the render pass's shading rate attachment. eMin and eMax need DeviceProperties::shadingRateCombiners.
+	enum class ShadingRateCombiner
+	{
+		eKeep,	  // The rate, ignoring the attachment.
+		eReplace, // The attachment's rate.
+		eMin,	  // The finer of the two.
+		eMax,	  // The coarser of the two.
+	};
+	/**
+	 * @brief Shading rate of the following draws, eg. coarser for distant or motion blurred objects.
+	 * Fails without DeviceFeatureFlags_ShadingRate.
+	 */
+	void set_shading_rate(CommandListHandle commandListHandle, ShadingRate shadingRate, ShadingRateCombiner attachmentCombiner = ShadingRateCombiner::eKeep);
+
+	/**
+	 * @brief Skip the draws and dispatches recorded until end_conditional() when the 32-bit value at offset in a
+	 * BufferInfo::predicate buffer is zero (non-zero if inverted), as read by the GPU when they execute. So work can be culled
+	 * by results written on the GPU, eg. by a visibility compute pass, without reading them back. The predicate is read at
+	 * PipelineStageFlags_ConditionalRendering with AccessFlags_ConditionalRenderingRead, writes to it need a barrier to that.
+	 * Copies and barriers are not skipped. Cannot be nested, and ends inside the render pass it began in, or outside any.
+	 * Fails without DeviceFeatureFlags_ConditionalRendering.
+	 * @param offset A multiple of 4.
+	 */
+	void begin_conditional(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset, bool inverted = false);
+	void end_conditional(CommandListHandle commandListHandle);
+
+	/**
+	 * @brief Make the attachment writes of the draws so far in a RenderPassInfo::localRead pass visible to the input
+	 * attachment reads of the following draws, at the same pixel only. Eg. between drawing the G-buffer and the lighting.
+	 */
+	void local_read_barrier(CommandListHandle commandListHandle);
+
 	void bind_pipeline(CommandListHandle commandListHandle, PipelineHandle pipelineHandle);
-	void bind_descriptor_sets(CommandListHandle commandListHandle, std::uint32_t firstSet, const std::vector<DescriptorSetHandle>& descriptorSets);
+	/**
+	 * @param descriptorSets At most MAX_BOUND_DESCRIPTOR_SETS.
+	 * @param dynamicOffsets One per dynamic descriptor in the sets, in binding order. At most MAX_DYNAMIC_OFFSETS.
+	 */
+	void bind_descriptor_sets(CommandListHandle commandListHandle, std::uint32_t firstSet, std::span<const DescriptorSetHandle> descriptorSets, std::span<const std::uint32_t> dynamicOffsets = {});
+	/**
+	 * @brief Write the descriptors of a set declared with DescriptorSetInfo::push straight into the command list, for
+	 * bindings that change every draw, without allocating, writing and binding a set each time.
+	 * Needs VK_KHR_push_descriptor, and the bound pipeline to have set as a push set. Only the written descriptors change.
+	 * @param writes At most MAX_PUSH_DESCRIPTORS.
+	 */
+	void push_descriptors(CommandListHandle commandListHandle, std::uint32_t set, std::span<const DescriptorWrite> writes);
 	void set_constants(CommandListHandle commandListHandle, std::uint32_t shaderStages, std::uint32_t offset, std::uint32_t size, const void* data);
 
 	void dispatch(CommandListHandle commandListHandle, std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ);
+	/**
+	 * @brief Dispatch groups numbered from a base group rather than 0, e.g. to split a large dispatch into parts or to
+	 * rerun only part of the grid. SV_GroupID/gl_WorkGroupID include the base.
+	 */
+	void dispatch_base(CommandListHandle commandListHandle, std::uint32_t baseGroupX, std::uint32_t baseGroupY, std::uint32_t baseGroupZ, std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ);
+	/**
+	 * @brief Restrict the commands recorded after this to the GPUs of a device group in deviceMask (bit i for GPU i), within
+	 * those the command list is submitted to. Split frame rendering gives each GPU its own part, e.g. with dispatch_base().
+	 */
+	void set_device_mask(CommandListHandle commandListHandle, std::uint32_t deviceMask);
+
+	// Layout of the group counts read by dispatch_indirect() (matches VkDispatchIndirectCommand).
+	struct DispatchIndirectCommand
+	{
+		std::uint32_t groupCountX;
+		std::uint32_t groupCountY;
+		std::uint32_t groupCountZ;
+	};
+	/**
+	 * @brief Dispatch using a DispatchIndirectCommand read from an BufferType::eIndirect buffer, so an earlier dispatch can size
+	 * the work (e.g. after compaction or culling) without a CPU readback. Compute shader writes to the buffer recorded earlier
+	 * on the command list are made visible to the read.
+	 * @param offset A multiple of 4.
+	 */
+	void dispatch_indirect(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset = 0);
 
 	enum class IndexType
 	{
 		eUInt16,
 		eUInt32,
 	};
-	void bind_index_buffer(CommandListHandle commandListHandle, BufferHandle bufferHandle, IndexType indexType);
-	void bind_vertex_buffers(CommandListHandle commandListHandle, std::uint32_t firstBinding, const std::vector<BufferHandle>& buffers);
+	/**
+	 * @param offset In bytes, e.g. of a BufferAllocation in a shared buffer.
+	 */
+	void bind_index_buffer(CommandListHandle commandListHandle, BufferHandle bufferHandle, IndexType indexType, std::uint64_t offset = 0);
+	/**
+	 * @param buffers At most MAX_VERTEX_BUFFER_BINDINGS.
+	 * @param offsets In bytes, one per buffer. Empty binds every buffer from its start.
+	 */
+	void bind_vertex_buffers(CommandListHandle commandListHandle, std::uint32_t firstBinding, std::span<const BufferHandle> buffers, std::span<const std::uint64_t> offsets = {});
 
 	void draw(CommandListHandle commandListHandle, std::uint32_t vertex_count, std::uint32_t instance_count, std::uint32_t first_vertex, std::uint32_t first_instance);
 	void draw_indexed(CommandListHandle commandListHandle, std::uint32_t index_count, std::uint32_t instance_count, std::uint32_t first_index, std::int32_t vertex_offset, std::uint32_t first_instance);
 
+	// Layouts of the draw arguments read by the indirect draws (match VkDrawIndirectCommand and VkDrawIndexedIndirectCommand).
+	struct DrawIndirectCommand
+	{
+		std::uint32_t vertexCount;
+		std::uint32_t instanceCount;
+		std::uint32_t firstVertex;
+		std::uint32_t firstInstance;
+	};
+	struct DrawIndexedIndirectCommand
+	{
+		std::uint32_t indexCount;
+		std::uint32_t instanceCount;
+		std::uint32_t firstIndex;
+		std::int32_t vertexOffset;
+		std::uint32_t firstInstance;
+	};
+
+	/**
+	 * @brief Draw using drawCount argument structs read from an BufferType::eIndirect buffer.
+	 * Without multi-draw indirect support, a drawCount greater than 1 is recorded as drawCount single draws, stride bytes apart.
+	 */
+	void draw_indirect(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride = sizeof(DrawIndirectCommand));
+	void draw_indexed_indirect(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride = sizeof(DrawIndexedIndirectCommand));
+	/**
+	 * @brief Like draw_indexed_indirect(), but the draw count is a std::uint32_t read from countBufferHandle (clamped to maxDrawCount).
+	 * Requires the device to support draw indirect count.
+	 */
+	void draw_indexed_indirect_count(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset, BufferHandle countBufferHandle, std::uint64_t countOffset, std::uint32_t maxDrawCount, std::uint32_t stride = sizeof(DrawIndexedIndirectCommand));
+
+	// Layout of the arguments read by draw_mesh_tasks_indirect() (matches VkDrawMeshTasksIndirectCommandEXT).
+	struct DrawMeshTasksIndirectCommand
+	{
+		std::uint32_t groupCountX;
+		std::uint32_t groupCountY;
+		std::uint32_t groupCountZ;
+	};
+	/**
+	 * @brief Launch task shader workgroups, or mesh shader workgroups if the bound mesh pipeline has no task shader.
+	 */
+	void draw_mesh_tasks(CommandListHandle commandListHandle, std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ);
+	/**
+	 * @brief Like draw_indirect(), with DrawMeshTasksIndirectCommand arguments.
+	 */
+	void draw_mesh_tasks_indirect(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride = sizeof(DrawMeshTasksIndirectCommand));
+	/**
+	 * @brief Like draw_indexed_indirect_count(), with DrawMeshTasksIndirectCommand arguments. Requires draw indirect count.
+	 */
+	void draw_mesh_tasks_indirect_count(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset, BufferHandle countBufferHandle, std::uint64_t countOffset, std::uint32_t maxDrawCount, std::uint32_t stride = sizeof(DrawMeshTasksIndirectCommand));
+
 	enum class TextureState : std::uint32_t
 	{
 		eUndefined,
-		eUploadDst, // Textures should be in this state when they are being uploaded to.
+		eUploadDst, // Textures should be in this state when they are being uploaded, copied, blitted or resolved to.
+		eCopySrc,	// Read by copy_texture_to_buffer(), copy_texture(), blit_texture() and resolve_texture().
 		eShaderRead,
 		eRenderTarget,
 		ePresent,
+		eShadingRate, // Read as a RenderPassInfo::shadingRateAttachment.
+		eLocalRead,	  // A color attachment of a RenderPassInfo::localRead pass, rendered to and read as an input attachment.
+		eStorage,	  // Read and written by compute and fragment shaders through DescriptorType::eStorageTexture.
 	};
 	void transition_texture(CommandListHandle commandListHandle, TextureHandle textureHandle, TextureState oldState, TextureState newState);
+	/**
+	 * @brief Like queue_buffer_upload(), for one mip level of a texture. The texture ends up in TextureState::eShaderRead.
+	 * @param data Every array layer (or cube face) of the level, one after the other, each with all of its depth slices.
+	 * @param size At least get_texture_level_size() of the level, times its depth and layer count.
+	 * Where VK_EXT_host_image_copy can write the texture at full speed, a level that has not been used yet is copied straight
+	 * from data (which may be a memory-mapped file) on the calling thread instead, and is ready once this returns.
+	 */
+	bool queue_texture_upload(TextureHandle textureHandle, const void* data, std::uint64_t size, std::uint32_t mipLevel = 0);
+	/**
+	 * @brief Copy data into the first mip level of a texture through a staging buffer, like upload_buffer().
+	 * data holds the whole level, tightly packed like queue_texture_upload(). The texture ends up in TextureState::eShaderRead.
+	 * Skips the staging buffer like queue_texture_upload(), when the host can write the level directly.
+	 * @return Reached once the copy has finished. Later work on the same queue is ordered after it, other queues should wait for it.
+	 */
+	auto upload_texture(TextureHandle textureHandle, const void* data, std::uint64_t size, std::uint32_t queueIndex = 0) -> SyncPoint;
+	/**
+	 * @brief Submit every queued upload in one submission on DeviceInfo::uploadQueueIndex, releasing the resources to dstQueueIndex.
+	 * For another queue, the matching acquire is submitted to dstQueueIndex and waits for the copies on the GPU only.
+	 * @return Reached once the resources are usable on dstQueueIndex. Later work on that queue is ordered after it.
+	 */
+	auto flush_uploads(DeviceHandle deviceHandle, std::uint32_t dstQueueIndex) -> SyncPoint;
+	/**
+	 * @brief Staging ring space for one queued upload, to be written in place, e.g. by a decoder on a worker thread, rather
+	 * than copied in from the caller's memory.
+	 */
+	struct UploadAllocation
+	{
+		void* data{ nullptr }; // size bytes, laid out like the data of queue_buffer_upload() or queue_texture_upload().
+		std::uint64_t size{ 0 };
+		BufferHandle bufferHandle{};   // Either a buffer
+		TextureHandle textureHandle{}; // or a texture.
+		std::uint64_t offset{ 0 };
+		std::uint32_t mipLevel{ 0 };
+		std::uint64_t stagingOffset{ 0 };
+	};
+	/**
+	 * @brief Reserve staging ring space for an upload like queue_buffer_upload(), then write it and pass it to commit_upload().
+	 * Flushes only submit committed uploads, so allocations can be written on any thread, for as long as that takes.
+	 * Never blocks. Every allocation must be committed or cancelled, as the ring reclaims no space past the oldest one.
+	 * Like queue_buffer_upload(), buffers the CPU can reach are handed out in place, so data points into the buffer itself,
+	 * which must outlive the allocation, and a cancelled allocation may leave the range partly written.
+	 * @return False if the ring has no room until earlier uploads complete. outAllocation.size is set either way.
+	 */
+	bool allocate_buffer_upload(UploadAllocation& outAllocation, BufferHandle bufferHandle, std::uint64_t size, std::uint64_t offset = 0);
+	/**
+	 * @brief Like allocate_buffer_upload(), for a whole mip level as queue_texture_upload() takes it. Always staged, as it is
+	 * written after this returns.
+	 */
+	bool allocate_texture_upload(UploadAllocation& outAllocation, TextureHandle textureHandle, std::uint32_t mipLevel = 0);
+	// Hand a written allocation to the next flush_uploads(). May be called from any thread.
+	void commit_upload(const UploadAllocation& allocation);
+	// Release an allocation without uploading it, e.g. when decoding into it failed. May be called from any thread.
+	void cancel_upload(const UploadAllocation& allocation);
+	/**
+	 * @brief Transition a texture from the state it was last transitioned to.
+	 * The previous state is tracked per subresource, and redundant transitions are skipped.
+	 */
+	void transition_texture(CommandListHandle commandListHandle, TextureHandle textureHandle, TextureState newState);
+
+	constexpr std::uint32_t REMAINING_SUBRESOURCES = ~0u; // Every mip level or array layer from the base one on.
+	struct TextureSubresourceRange
+	{
+		std::uint32_t baseMipLevel{ 0 };
+		std::uint32_t mipLevelCount{ REMAINING_SUBRESOURCES };
+		std::uint32_t baseArrayLayer{ 0 };
+		std::uint32_t arrayLayerCount{ REMAINING_SUBRESOURCES };
+
+		bool operator==(const TextureSubresourceRange&) const = default;
+	};
+	/**
+	 * @brief Like the tracked transition_texture(), for part of a texture, e.g. one mip level at a time while downsampling.
+	 * Subresources already in a different state each get their own barrier, consecutive mips sharing a state share one.
+	 * Depth/stencil textures transition both aspects.
+	 */
+	void transition_texture(CommandListHandle commandListHandle, TextureHandle textureHandle, TextureState newState, const TextureSubresourceRange& range);
+	/**
+	 * @brief Start the lifetime of a texture from create_aliased_textures() or create_texture_placed(): transition it from
+	 * TextureState::eUndefined, discarding its contents, after all earlier work on the queue, so the textures it shares
+	 * memory with are no longer being accessed.
+	 */
+	void acquire_aliased_texture(CommandListHandle commandListHandle, TextureHandle textureHandle, TextureState newState);
+	/**
+	 * @brief Split a tracked transition of a whole texture in two, so the commands recorded between the halves overlap it
+	 * rather than waiting at a full barrier. Begin it right after the last use in the old state, and end it right before the
+	 * first use in newState. Both halves go on the same command list, outside of render passes, and the texture must not be
+	 * used or transitioned in between. Every transition begun must be ended before the command list is.
+	 */
+	void begin_texture_transition(CommandListHandle commandListHandle, TextureHandle textureHandle, TextureState newState);
+	void end_texture_transition(CommandListHandle commandListHandle, TextureHandle textureHandle);
+
+	enum class TextureViewType
+	{
+		eDefault, // The texture's own type, arrayed when the range has more than one layer (or cube).
+		e1D,
+		e1DArray,
+		e2D,
+		e2DArray,
+		e3D,
+		eCube,
+		eCubeArray,
+	};
+	struct TextureViewInfo
+	{
+		Format format{ Format::eUndefined }; // eUndefined for the texture's format. Others need TextureInfo::mutableFormat and the same texel block size.
+		TextureViewType type{ TextureViewType::eDefault };
+		TextureSubresourceRange range{};
+
+		bool operator==(const TextureViewInfo&) const = default;
+	};
+	/**
+	 * @brief A view of part of a texture, or of the texture as another type or format.
+	 * View 0 is the texture's default view, which bind_texture_to_descriptor_set() and render passes use unless told otherwise.
+	 */
+	struct TextureViewHandle
+	{
+		TextureHandle textureHandle{};
+		std::uint32_t viewIndex{ 0 };
+	};
+	/**
+	 * @brief Get a view of a texture, e.g. a single mip level to render into, one face of a cube, or a 2D array as cubes.
+	 * Views are cached per texture, so asking for the same view again returns the same handle. They live as long as the
+	 * texture (defragmentation and mip streaming recreate them in place), views of a streaming texture count mips from its
+	 * first resident one, and ranges past the resident levels are clamped.
+	 * Create views up front: creating one while another thread records commands using the same texture is not safe.
+	 */
+	bool create_texture_view(TextureViewHandle& outTextureViewHandle, TextureHandle textureHandle, const TextureViewInfo& textureViewInfo);
+	void bind_texture_view_to_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, TextureViewHandle textureViewHandle, SamplerHandle samplerHandle);
+	/**
+	 * @brief Hand a texture over from one queue's family to another's, e.g. from a dedicated transfer queue to the graphics queue.
+	 * Record it with the same arguments on a command list of each queue: the source records the release, and the destination
+	 * the acquire. The acquiring submission must wait on the releasing one with a semaphore.
+	 * When both queues share a family it is a plain transition, recorded by the source only.
+	 * EXTERNAL_QUEUE_INDEX on either side hands external memory to or from another process or API, see import_texture().
+	 */
+	void transfer_texture_ownership(CommandListHandle commandListHandle, TextureHandle textureHandle, std::uint32_t srcQueueIndex, std::uint32_t dstQueueIndex, TextureState oldState, TextureState newState);
+	/**
+	 * @brief Hand a buffer over from one queue's family to another's, see transfer_texture_ownership().
+	 */
+	void transfer_buffer_ownership(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint32_t srcQueueIndex, std::uint32_t dstQueueIndex);
+	/**
+	 * @brief Make the writes srcStages (PipelineStageFlags_*) made to a buffer earlier on the command list visible to the
+	 * dstStages of later commands, e.g. between a dispatch and one reading its output. Batched with the other pending barriers.
+	 */
+	void buffer_barrier(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint32_t srcStages, std::uint32_t dstStages);
+	/**
+	 * @brief Make the srcAccess (AccessFlags_*) of srcStages to a range of a buffer visible to the dstAccess of dstStages,
+	 * e.g. AccessFlags_ShaderWrite of PipelineStageFlags_ComputeShader before the AccessFlags_IndirectCommandRead of
+	 * PipelineStageFlags_DrawIndirect, so a dispatch can write the arguments of a later indirect draw. Precise masks let
+	 * the driver wait and flush no more than needed. Batched with the other pending barriers.
+	 */
+	void buffer_barrier(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint32_t srcStages, std::uint32_t srcAccess, std::uint32_t dstStages, std::uint32_t dstAccess,
+						std::uint64_t offset = 0, std::uint64_t size = WHOLE_SIZE);
+	/**
+	 * @brief As buffer_barrier(), for every resource at once, e.g. after a dispatch writing many buffers. Cheaper than a
+	 * buffer barrier each, drivers flush and invalidate whole caches either way. Pending memory barriers merge into one.
+	 */
+	void memory_barrier(CommandListHandle commandListHandle, std::uint32_t srcStages, std::uint32_t srcAccess, std::uint32_t dstStages, std::uint32_t dstAccess);
 
 	void copy_buffer_to_texture(CommandListHandle commandListHandle, BufferHandle bufferHandle, TextureHandle textureHandle);
+	/**
+	 * @brief Fill every mip level past the first by blitting each one down from the level above, e.g. after uploading the first.
+	 * Uses linear filtering where the format supports it. Needs a graphics queue, and the texture ends in TextureState::eShaderRead.
+	 */
+	void generate_mipmaps(CommandListHandle commandListHandle, TextureHandle textureHandle);
+
+	// GPU-side transfers. The bytes they write are made visible to every later command, and to the host once the submission
+	// has been waited on, so no extra synchronisation is needed to consume them.
+
+	constexpr std::uint32_t MAX_COPY_REGIONS = 16;
+	struct BufferCopyRegion
+	{
+		std::uint64_t srcOffset{ 0 };
+		std::uint64_t dstOffset{ 0 };
+		std::uint64_t size{ 0 };
+	};
+	struct TextureCopyRegion
+	{
+		std::uint64_t bufferOffset{ 0 }; // Texels are tightly packed from here.
+		std::uint32_t mipLevel{ 0 };	 // The whole mip level is copied.
+		std::uint32_t baseArrayLayer{ 0 };
+		std::uint32_t layerCount{ 1 };
+	};
+	struct BufferTextureCopyRegion
+	{
+		std::uint64_t bufferOffset{ 0 };
+		std::uint32_t bufferRowLength{ 0 };	  // In texels, 0 for tightly packed rows of the copied width.
+		std::uint32_t bufferImageHeight{ 0 }; // In rows, 0 for tightly packed slices of the copied height.
+		std::uint32_t mipLevel{ 0 };
+		std::uint32_t baseArrayLayer{ 0 };
+		std::uint32_t layerCount{ 1 };
+		std::uint32_t x{ 0 }; // Texel offset into the level. Multiples of the texel block size for compressed formats.
+		std::uint32_t y{ 0 };
+		std::uint32_t z{ 0 };
+		std::uint32_t width{ 0 }; // 0 for the rest of the level. For compressed formats, multiples of the block size unless
+		std::uint32_t height{ 0 }; // the region ends at the edge of the level.
+		std::uint32_t depth{ 0 };
+	};
+	/**
+	 * @param regions At most MAX_COPY_REGIONS.
+	 */
+	void copy_buffer(CommandListHandle commandListHandle, BufferHandle srcBufferHandle, BufferHandle dstBufferHandle, std::span<const BufferCopyRegion> regions);
+	/**
+	 * @brief Copy texels into a buffer, e.g. for readback. The texture must be in TextureState::eCopySrc.
+	 * @param regions At most MAX_COPY_REGIONS.
+	 */
+	void copy_texture_to_buffer(CommandListHandle commandListHandle, TextureHandle srcTextureHandle, BufferHandle dstBufferHandle, std::span<const TextureCopyRegion> regions);
+	/**
+	 * @brief Copy parts of a buffer into parts of a texture, e.g. atlas tiles from one staging allocation.
+	 * The regions' subresources must be in TextureState::eUploadDst.
+	 * @param regions At most MAX_COPY_REGIONS.
+	 */
+	void copy_buffer_to_texture(CommandListHandle commandListHandle, BufferHandle srcBufferHandle, TextureHandle dstTextureHandle, std::span<const BufferTextureCopyRegion> regions);
+	struct BufferTextureCopy
+	{
+		TextureHandle textureHandle{};
+		std::span<const BufferTextureCopyRegion> regions; // At most MAX_COPY_REGIONS.
+	};
+	/**
+	 * @brief Copy one buffer into many textures, e.g. a whole material set staged in one allocation, behind a single barrier flush.
+	 * Nothing is recorded if any copy is invalid.
+	 */
+	void copy_buffer_to_textures(CommandListHandle commandListHandle, BufferHandle srcBufferHandle, std::span<const BufferTextureCopy> copies);
+	struct TextureRegionCopy
+	{
+		std::uint32_t srcMipLevel{ 0 };
+		std::uint32_t srcBaseArrayLayer{ 0 };
+		std::uint32_t dstMipLevel{ 0 };
+		std::uint32_t dstBaseArrayLayer{ 0 };
+		std::uint32_t layerCount{ 1 };
+		std::uint32_t srcX{ 0 }; // Texel offsets into the levels. Multiples of the texel block size for compressed formats.
+		std::uint32_t srcY{ 0 };
+		std::uint32_t srcZ{ 0 };
+		std::uint32_t dstX{ 0 };
+		std::uint32_t dstY{ 0 };
+		std::uint32_t dstZ{ 0 };
+		std::uint32_t width{ 0 }; // 0 for the rest of the source level.
+		std::uint32_t height{ 0 };
+		std::uint32_t depth{ 0 };
+	};
+	/**
+	 * @brief Copy texels between textures, or between subresources of one, e.g. a render target into a texture a later pass samples.
+	 * The formats must have the same texel block, and the textures the same sample count. The source's subresources must be in
+	 * TextureState::eCopySrc and the destination's in TextureState::eUploadDst. Transient textures cannot be copied.
+	 * @param regions At most MAX_COPY_REGIONS.
+	 */
+	void copy_texture(CommandListHandle commandListHandle, TextureHandle srcTextureHandle, TextureHandle dstTextureHandle, std::span<const TextureRegionCopy> regions);
+	struct TextureBlitRegion
+	{
+		std::uint32_t srcMipLevel{ 0 };
+		std::uint32_t srcBaseArrayLayer{ 0 };
+		std::uint32_t dstMipLevel{ 0 };
+		std::uint32_t dstBaseArrayLayer{ 0 };
+		std::uint32_t layerCount{ 1 };
+		// Opposite corners of each box, in texels of its level. An axis with both corners at 0 spans the whole level, so a zeroed
+		// box is the whole level, and swapping the corners of one box along an axis mirrors the blit along it.
+		std::array<std::uint32_t, 3> srcBegin{};
+		std::array<std::uint32_t, 3> srcEnd{};
+		std::array<std::uint32_t, 3> dstBegin{};
+		std::array<std::uint32_t, 3> dstEnd{};
+	};
+	/**
+	 * @brief Scale texels between textures, converting their format, e.g. to downsample a render target or copy it into the swap chain.
+	 * Both formats must support blits, depth formats only to themselves with nearest filtering, and linear filtering needs a
+	 * source format that supports it. Multisampled textures cannot be blitted, resolve them first. Needs a graphics queue.
+	 * The source's subresources must be in TextureState::eCopySrc and the destination's in TextureState::eUploadDst.
+	 * @param regions At most MAX_COPY_REGIONS.
+	 */
+	void blit_texture(CommandListHandle commandListHandle, TextureHandle srcTextureHandle, TextureHandle dstTextureHandle, std::span<const TextureBlitRegion> regions,
+					  SamplerFilterMode filterMode = SamplerFilterMode::eLinear);
+	/**
+	 * @brief Average the samples of a multisampled color texture into a single sampled texture of the same format, outside of a
+	 * render pass. Inside one RenderPassInfo::resolveAttachments is cheaper, as the samples never leave the tile. Needs a
+	 * graphics queue. The source's subresources must be in TextureState::eCopySrc and the destination's in TextureState::eUploadDst.
+	 * @param regions At most MAX_COPY_REGIONS.
+	 */
+	void resolve_texture(CommandListHandle commandListHandle, TextureHandle srcTextureHandle, TextureHandle dstTextureHandle, std::span<const TextureRegionCopy> regions);
+	/**
+	 * @brief Fill a range with a repeated 32-bit value, e.g. to clear a storage buffer. offset and size must be multiples of 4, or size WHOLE_SIZE.
+	 */
+	void fill_buffer(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t size, std::uint32_t value);
+	/**
+	 * @brief Write data recorded inline in the command list. At most MAX_UPDATE_BUFFER_SIZE bytes, offset and size must be multiples of 4.
+	 */
+	void update_buffer(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t size, const void* data);
+	constexpr std::uint64_t MAX_UPDATE_BUFFER_SIZE = 65536;
+	/**
+	 * @brief Copy a range into a BufferMemory::eReadback buffer for the CPU, like copy_buffer(). Only on primary command lists.
+	 * The readback completes with the command list's next submission, so results can be collected frames later without stalling.
+	 * Re-recording or destroying the command list before submitting it leaves the readback pending forever, destroy it instead.
+	 * @return Resolved with resolve_readback(), or an invalid handle on failure.
+	 */
+	auto read_buffer(CommandListHandle commandListHandle, BufferHandle srcBufferHandle, BufferHandle dstBufferHandle, const BufferCopyRegion& region) -> ReadbackHandle;
+	/**
+	 * @brief Poll for (or wait up to timeoutNs on) a readback. Once complete, the range is invalidated if the memory is not host
+	 * coherent and outData points at it in the destination's mapping. It stays valid until the range is written again.
+	 * @return False while pending. On success the handle is released.
+	 */
+	bool resolve_readback(ReadbackHandle readbackHandle, const void*& outData, std::uint64_t timeoutNs = 0);
+	/**
+	 * @brief Release a readback that will not be resolved. The copy itself still happens if it was submitted.
+	 */
+	void destroy_readback(ReadbackHandle readbackHandle);
+
+	// Ray tracing acceleration structures (DeviceFeatureFlags_RayQuery). Bottom levels hold the triangles of meshes, top levels
+	// instances of bottom levels placed in the world, which shaders trace with ray queries, eg. for shadows and ambient
+	// occlusion. Shaders reach a top level through its device address, passed in constants or a buffer:
+	//
+	//   layout(push_constant) uniform Constants { uint64_t scene; };
+	//   rayQueryInitializeEXT(rayQuery, accelerationStructureEXT(scene), gl_RayFlagsTerminateOnFirstHitEXT, 0xFF, origin, 0.01, direction, 1000.0);
+	enum class AccelerationStructureType
+	{
+		eBottomLevel,
+		eTopLevel,
+	};
+	/**
+	 * @brief Triangles of a bottom level, read from buffers created with BufferInfo::accelerationStructureInput.
+	 */
+	struct AccelerationStructureGeometry
+	{
+		BufferHandle vertexBufferHandle;
+		std::uint64_t vertexOffset{ 0 };
+		std::uint32_t vertexStride{ 12 };
+		std::uint32_t vertexCount{ 0 };
+		Format vertexFormat{ Format::eRGB32 }; // Of the positions, each the first attribute of its vertex.
+		BufferHandle indexBufferHandle{};	   // Null for unindexed triangles.
+		std::uint64_t indexOffset{ 0 };
+		IndexType indexType{ IndexType::eUInt32 };
+		std::uint32_t triangleCount{ 0 };
+		bool opaque{ true }; // Hits are committed straight away. Otherwise they are candidates the shader confirms, eg. after an alpha test.
+	};
+	struct AccelerationStructureInstance
+	{
+		std::array<float, 12> transform{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0 }; // Object to world, a row-major 3x4 matrix.
+		AccelerationStructureHandle bottomLevelHandle{};
+		std::uint32_t customIndex{ 0 }; // 24 bits, returned by rayQueryGetIntersectionInstanceCustomIndexEXT(), eg. to index per-instance data.
+		std::uint8_t mask{ 0xFF };		// Only rays whose cull mask shares a bit with it can hit it.
+		bool doubleSided{ false };		// Never culled as back facing.
+	};
+	struct AccelerationStructureInfo
+	{
+		AccelerationStructureType type;
+		std::vector<AccelerationStructureGeometry> geometries{}; // Bottom level, what it is built from unless a build gives its own.
+		std::uint32_t maxInstanceCount{ 0 };					 // Top level, the most instances a build can hold.
+		bool allowUpdate{ false };		// Can be refit with AccelerationStructureBuild::update, eg. skinned meshes or moving instances. Never compacted.
+		bool preferFastBuild{ false };	// Trade trace speed for build speed, eg. for levels rebuilt every frame.
+		bool compact{ true };			// Bottom level, compacted after each full build, typically to half its size or less.
+		std::string debugName{};		// Shown in debuggers and GPU profilers (RenderDoc, Nsight, RGP).
+	};
+	/**
+	 * @brief Sized for the info's geometries or instances, and empty until built.
+	 */
+	bool create_acceleration_structure(AccelerationStructureHandle& outAccelerationStructureHandle, DeviceHandle deviceHandle, const AccelerationStructureInfo& accelerationStructureInfo);
+	/**
+	 * @brief Destroy once the GPU is done with it. Top levels holding a destroyed bottom level must be rebuilt before they are traced.
+	 */
+	void destroy_acceleration_structure(AccelerationStructureHandle accelerationStructureHandle);
+	/**
+	 * @brief The address shaders trace a top level at. It never changes, unlike those of bottom levels, which move when compacted.
+	 * @return 0 if the handle is unknown.
+	 */
+	auto get_acceleration_structure_device_address(AccelerationStructureHandle accelerationStructureHandle) -> std::uint64_t;
+
+	struct AccelerationStructureBuild
+	{
+		AccelerationStructureHandle accelerationStructureHandle;
+		std::span<const AccelerationStructureGeometry> geometries{}; // Bottom level. Empty builds the geometries it was created with.
+		std::span<const AccelerationStructureInstance> instances{};	 // Top level, at most its maxInstanceCount.
+		bool update{ false }; // Refit the last build to moved vertices or instances, far cheaper than rebuilding. Same counts, needs allowUpdate.
+	};
+	/**
+	 * @brief Record many builds at once, eg. on an async compute queue: the bottom levels together, then the top levels, then
+	 * a barrier making them visible to ray queries and later builds. Outside render passes. Recording is serialised across threads.
+	 *
+	 * Scratch memory and top level instances are sub-allocated with allocate_transient(), so DeviceInfo::transientBufferSize
+	 * must fit a frame's builds. Builds that do not fit are dropped with an error.
+	 *
+	 * A compacted bottom level's size is queried by its build. The first call after the size is known, on any command list,
+	 * copies it into storage of that size and frees the original, and rebuilds the top levels holding it from their last
+	 * instances, as its address changes. Submit command lists building acceleration structures in the order they were recorded.
+	 */
+	void build_acceleration_structures(CommandListHandle commandListHandle, std::span<const AccelerationStructureBuild> builds);
+
+	class Device;
+	class CommandList;
+
+	/**
+	 * @brief Resolved handle to a command list for hot-path recording.
+	 *
+	 * The Device and CommandList are looked up once by begin_recording(), so each recorded command goes straight to the
+	 * command buffer instead of resolving the context, device and command list again. The bound pipeline is cached by the
+	 * command list itself. A recorder must not outlive the command list it was created from.
+	 */
+	class CommandRecorder
+	{
+	public:
+		CommandRecorder() = default;
+		/**
+		 * @param bundleHandle The bundle being recorded, which end() makes executable.
+		 */
+		explicit CommandRecorder(Device* device, CommandList* commandList, BundleHandle bundleHandle = {})
+			: m_device(device), m_commandList(commandList), m_bundleHandle(bundleHandle)
+		{
+		}
+		~CommandRecorder() = default;
+
+		bool is_valid() const { return m_device != nullptr && m_commandList != nullptr; }
+
+		void end();
+
+		void begin_gpu_scope(std::string_view name);
+		void end_gpu_scope();
+		void begin_gpu_query(GpuQueryType type, std::string_view name);
+		void end_gpu_query(GpuQueryType type);
+		void push_marker(std::string_view name);
+		void pop_marker();
+
+		void begin_render_pass(const RenderPassInfo& renderPassInfo);
+		void end_render_pass();
+
+		void set_viewport(float x, float y, float width, float height, float minDepth = 0.0f, float maxDepth = 1.0f);
+		void set_scissor(std::int32_t x, std::int32_t y, std::uint32_t width, std::uint32_t height);
+
+		void set_cull_mode(CullMode cullMode);
+		void set_front_face(FrontFace frontFace);
+		void set_primitive_topology(PrimitiveTopology topology, bool primitiveRestart = false);
+		void set_depth_state(bool depthTest, bool depthWrite, CompareOp depthCompareOp);
+		void set_stencil_state(bool stencilTest, const StencilState& stencilFront, const StencilState& stencilBack);
+		void set_blend_states(std::uint32_t firstAttachment, std::span<const BlendState> blendStates);
+		void set_shading_rate(ShadingRate shadingRate, ShadingRateCombiner attachmentCombiner = ShadingRateCombiner::eKeep);
+		void begin_conditional(BufferHandle bufferHandle, std::uint64_t offset, bool inverted = false);
+		void end_conditional();
+		void local_read_barrier();
+
+		void bind_pipeline(PipelineHandle pipelineHandle);
+		void bind_descriptor_sets(std::uint32_t firstSet, std::span<const DescriptorSetHandle> descriptorSets, std::span<const std::uint32_t> dynamicOffsets = {});
+		void push_descriptors(std::uint32_t set, std::span<const DescriptorWrite> writes);
+		void set_constants(std::uint32_t shaderStages, std::uint32_t offset, std::uint32_t size, const void* data);
+
+		void dispatch(std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ);
+		void dispatch_base(std::uint32_t baseGroupX, std::uint32_t baseGroupY, std::uint32_t baseGroupZ, std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ);
+		void set_device_mask(std::uint32_t deviceMask);
+		void dispatch_indirect(BufferHandle bufferHandle, std::uint64_t offset = 0);
+
+		void bind_index_buffer(BufferHandle bufferHandle, IndexType indexType, std::uint64_t offset = 0);
+		void bind_vertex_buffers(std::uint32_t firstBinding, std::span<const BufferHandle> buffers, std::span<const std::uint64_t> offsets = {});
+
+		void draw(std::uint32_t vertex_count, std::uint32_t instance_count, std::uint32_t first_vertex, std::uint32_t first_instance);
+		void draw_indexed(std::uint32_t index_count, std::uint32_t instance_count, std::uint32_t first_index, std::int32_t vertex_offset, std::uint32_t first_instance);
+		void draw_indirect(BufferHandle bufferHandle, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride = sizeof(DrawIndirectCommand));
+		void draw_indexed_indirect(BufferHandle bufferHandle, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride = sizeof(DrawIndexedIndirectCommand));
+		void draw_indexed_indirect_count(BufferHandle bufferHandle, std::uint64_t offset, BufferHandle countBufferHandle, std::uint64_t countOffset, std::uint32_t maxDrawCount, std::uint32_t stride = sizeof(DrawIndexedIndirectCommand));
+		void draw_mesh_tasks(std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ);
+		void draw_mesh_tasks_indirect(BufferHandle bufferHandle, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride = sizeof(DrawMeshTasksIndirectCommand));
+		void draw_mesh_tasks_indirect_count(BufferHandle bufferHandle, std::uint64_t offset, BufferHandle countBufferHandle, std::uint64_t countOffset, std::uint32_t maxDrawCount, std::uint32_t stride = sizeof(DrawMeshTasksIndirectCommand));
+
+		void transition_texture(TextureHandle textureHandle, TextureState oldState, TextureState newState);
+		void transition_texture(TextureHandle textureHandle, TextureState newState);
+		void transition_texture(TextureHandle textureHandle, TextureState newState, const TextureSubresourceRange& range);
+		void acquire_aliased_texture(TextureHandle textureHandle, TextureState newState);
+		void begin_texture_transition(TextureHandle textureHandle, TextureState newState);
+		void end_texture_transition(TextureHandle textureHandle);
+		void transfer_texture_ownership(TextureHandle textureHandle, std::uint32_t srcQueueIndex, std::uint32_t dstQueueIndex, TextureState oldState, TextureState newState);
+		void transfer_buffer_ownership(BufferHandle bufferHandle, std::uint32_t srcQueueIndex, std::uint32_t dstQueueIndex);
+		void buffer_barrier(BufferHandle bufferHandle, std::uint32_t srcStages, std::uint32_t dstStages);
+		void buffer_barrier(BufferHandle bufferHandle, std::uint32_t srcStages, std::uint32_t srcAccess, std::uint32_t dstStages, std::uint32_t dstAccess, std::uint64_t offset = 0, std::uint64_t size = WHOLE_SIZE);
+		void memory_barrier(std::uint32_t srcStages, std::uint32_t srcAccess, std::uint32_t dstStages, std::uint32_t dstAccess);
+
+		void copy_buffer_to_texture(BufferHandle bufferHandle, TextureHandle textureHandle);
+		void generate_mipmaps(TextureHandle textureHandle);
+		void copy_buffer(BufferHandle srcBufferHandle, BufferHandle dstBufferHandle, std::span<const BufferCopyRegion> regions);
+		void copy_texture_to_buffer(TextureHandle srcTextureHandle, BufferHandle dstBufferHandle, std::span<const TextureCopyRegion> regions);
+		void copy_buffer_to_texture(BufferHandle srcBufferHandle, TextureHandle dstTextureHandle, std::span<const BufferTextureCopyRegion> regions);
+		void copy_buffer_to_textures(BufferHandle srcBufferHandle, std::span<const BufferTextureCopy> copies);
+		void copy_texture(TextureHandle srcTextureHandle, TextureHandle dstTextureHandle, std::span<const TextureRegionCopy> regions);
+		void blit_texture(TextureHandle srcTextureHandle, TextureHandle dstTextureHandle, std::span<const TextureBlitRegion> regions, SamplerFilterMode filterMode = SamplerFilterMode::eLinear);
+		void resolve_texture(TextureHandle srcTextureHandle, TextureHandle dstTextureHandle, std::span<const TextureRegionCopy> regions);
+		void fill_buffer(BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t size, std::uint32_t value);
+		void update_buffer(BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t size, const void* data);
+		auto read_buffer(BufferHandle srcBufferHandle, BufferHandle dstBufferHandle, const BufferCopyRegion& region) -> ReadbackHandle;
+		void build_acceleration_structures(std::span<const AccelerationStructureBuild> builds);
+
+		void execute_commands(std::span<const CommandListHandle> secondaryCommandLists);
+		bool execute_bundle(BundleHandle bundleHandle);
+
+	private:
+		Device* m_device{ nullptr };
+		CommandList* m_commandList{ nullptr };
+		BundleHandle m_bundleHandle{};
+	};
+
+	/**
+	 * @brief Begin recording the command list and return a resolved recorder for it.
+	 * @return An invalid recorder if the command list could not be found.
+	 */
+	auto begin_recording(CommandListHandle commandListHandle) -> CommandRecorder;
+	/**
+	 * @brief Begin recording a secondary command list for the given render pass and return a resolved recorder for it.
+	 */
+	auto begin_secondary_recording(CommandListHandle commandListHandle, const RenderPassInfo& renderPassInfo) -> CommandRecorder;
+
+	/**
+	 * @brief Create a bundle, a pre-recorded sequence of commands (e.g. for static geometry) that is recorded once with
+	 * begin_bundle() and replayed into the render pass of any command list with execute_bundle().
+	 *
+	 * A bundle remembers the pipelines, buffers and descriptor sets it was recorded with. Destroying one of them, or a texture
+	 * or buffer written to one of those sets, or updating one of the sets, invalidates the bundle, and it must be re-recorded
+	 * before it can be executed again.
+	 */
+	bool create_bundle(BundleHandle& outBundleHandle, DeviceHandle deviceHandle, std::uint32_t queueIndex);
+	void destroy_bundle(BundleHandle bundleHandle);
+	/**
+	 * @brief (Re-)record the bundle for render passes with the given attachments, and return a recorder for it.
+	 * Re-recording is safe while submissions that executed the previous recording are still in flight. The bundle can be
+	 * executed once the recorder's end() succeeds.
+	 */
+	auto begin_bundle(BundleHandle bundleHandle, const RenderPassInfo& renderPassInfo) -> CommandRecorder;
+	bool is_bundle_valid(BundleHandle bundleHandle);
+	/**
+	 * @brief Replay a bundle inside the current render pass, which must have been begun with RenderPassInfo::secondaryCommandLists.
+	 * @return False if the bundle has been invalidated (or never recorded), in which case nothing is recorded.
+	 */
+	bool execute_bundle(CommandListHandle commandListHandle, BundleHandle bundleHandle);
 
 #pragma endregion
 
@@ -357,26 +2777,195 @@ namespace sm::gfx
 
 namespace std
 {
+	template <>
+	struct hash<sm::gfx::SamplerInfo>
+	{
+		std::size_t operator()(const sm::gfx::SamplerInfo& samplerInfo) const
+		{
+			std::size_t seed{};
+			sm::hash_combine(seed, samplerInfo.addressMode);
+			sm::hash_combine(seed, samplerInfo.filterMode);
+			sm::hash_combine(seed, samplerInfo.mipFilterMode);
+			sm::hash_combine(seed, samplerInfo.maxAnisotropy);
+			sm::hash_combine(seed, samplerInfo.mipLodBias);
+			sm::hash_combine(seed, samplerInfo.minLod);
+			sm::hash_combine(seed, samplerInfo.maxLod);
+			sm::hash_combine(seed, samplerInfo.compareOp);
+			return seed;
+		}
+	};
+
+	template <>
+	struct hash<sm::gfx::TextureInfo>
+	{
+		std::size_t operator()(const sm::gfx::TextureInfo& textureInfo) const
+		{
+			std::size_t seed{};
+			sm::hash_combine(seed, textureInfo.usage);
+			sm::hash_combine(seed, textureInfo.type);
+			sm::hash_combine(seed, textureInfo.width);
+			sm::hash_combine(seed, textureInfo.height);
+			sm::hash_combine(seed, textureInfo.format);
+			sm::hash_combine(seed, textureInfo.depth);
+			sm::hash_combine(seed, textureInfo.arrayLayers);
+			sm::hash_combine(seed, textureInfo.mipLevels);
+			sm::hash_combine(seed, textureInfo.memory);
+			sm::hash_combine(seed, textureInfo.sparse);
+			sm::hash_combine(seed, textureInfo.mutableFormat);
+			sm::hash_combine(seed, textureInfo.sampleCount);
+			return seed;
+		}
+	};
+
 	template <>
 	struct hash<sm::gfx::DescriptorSetInfo>
 	{
-		std::size_t operator()(const sm::gfx::DescriptorSetInfo& descriptorSetInfo)
+		std::size_t operator()(const sm::gfx::DescriptorSetInfo& descriptorSetInfo) const
 		{
 			using std::hash;
 			using std::size_t;
 
 			size_t seed{};
 			sm::hash_combine(seed, descriptorSetInfo.bindings.size());
+			sm::hash_combine(seed, descriptorSetInfo.bindlessHeap);
+			sm::hash_combine(seed, descriptorSetInfo.push);
 			for (const auto& binding : descriptorSetInfo.bindings)
 			{
 				sm::hash_combine(seed, binding.type);
 				sm::hash_combine(seed, binding.count);
+				sm::hash_combine(seed, binding.shaderStages);
 			}
 
 			return seed;
 		}
 	};
 
+	template <>
+	struct hash<sm::gfx::ShaderCode>
+	{
+		std::size_t operator()(const sm::gfx::ShaderCode& shaderCode) const { return std::size_t(shaderCode.get_content_hash()); }
+	};
+
+	template <>
+	struct hash<sm::gfx::ComputePipelineInfo>
+	{
+		std::size_t operator()(const sm::gfx::ComputePipelineInfo& computePipelineInfo) const
+		{
+			std::size_t seed{};
+			sm::hash_combine(seed, computePipelineInfo.shaderCode);
+			for (const auto& descriptorSet : computePipelineInfo.descriptorSets)
+			{
+				sm::hash_combine(seed, descriptorSet);
+			}
+			sm::hash_combine(seed, computePipelineInfo.constantBlock.size);
+			sm::hash_combine(seed, computePipelineInfo.constantBlock.shaderStages);
+			for (const auto& constant : computePipelineInfo.specializationConstants)
+			{
+				sm::hash_combine(seed, constant.id);
+				sm::hash_combine(seed, constant.value);
+			}
+			sm::hash_combine(seed, computePipelineInfo.entryPoint);
+			sm::hash_combine(seed, computePipelineInfo.requiredSubgroupSize);
+			sm::hash_combine(seed, computePipelineInfo.requireFullSubgroups);
+			return seed;
+		}
+	};
+
+	template <>
+	struct hash<sm::gfx::GraphicsPipelineInfo>
+	{
+		std::size_t operator()(const sm::gfx::GraphicsPipelineInfo& graphicsPipelineInfo) const
+		{
+			std::size_t seed{};
+			sm::hash_combine(seed, graphicsPipelineInfo.vertexCode);
+			sm::hash_combine(seed, graphicsPipelineInfo.fragmentCode);
+			for (const auto* constants : { &graphicsPipelineInfo.vertexSpecializationConstants, &graphicsPipelineInfo.fragmentSpecializationConstants })
+			{
+				for (const auto& constant : *constants)
+				{
+					sm::hash_combine(seed, constant.id);
+					sm::hash_combine(seed, constant.value);
+				}
+				sm::hash_combine(seed, constants->size());
+			}
+			for (const auto& binding : graphicsPipelineInfo.vertexInputBindings)
+			{
+				for (const auto& attribute : binding.attributes)
+				{
+					sm::hash_combine(seed, attribute.location);
+					sm::hash_combine(seed, attribute.format);
+					sm::hash_combine(seed, attribute.offset);
+				}
+				sm::hash_combine(seed, binding.stride);
+				sm::hash_combine(seed, binding.inputRate);
+				sm::hash_combine(seed, binding.divisor);
+			}
+			for (const auto& descriptorSet : graphicsPipelineInfo.descriptorSets)
+			{
+				sm::hash_combine(seed, descriptorSet);
+			}
+			sm::hash_combine(seed, graphicsPipelineInfo.constantBlock.size);
+			sm::hash_combine(seed, graphicsPipelineInfo.constantBlock.shaderStages);
+			sm::hash_combine(seed, graphicsPipelineInfo.topology);
+			sm::hash_combine(seed, graphicsPipelineInfo.cullMode);
+			sm::hash_combine(seed, graphicsPipelineInfo.frontFace);
+			sm::hash_combine(seed, graphicsPipelineInfo.depthTest);
+			sm::hash_combine(seed, graphicsPipelineInfo.depthWrite);
+			sm::hash_combine(seed, graphicsPipelineInfo.depthCompareOp);
+			sm::hash_combine(seed, graphicsPipelineInfo.stencilTest);
+			for (const auto& stencil : { graphicsPipelineInfo.stencilFront, graphicsPipelineInfo.stencilBack })
+			{
+				sm::hash_combine(seed, stencil.failOp);
+				sm::hash_combine(seed, stencil.passOp);
+				sm::hash_combine(seed, stencil.depthFailOp);
+				sm::hash_combine(seed, stencil.compareOp);
+				sm::hash_combine(seed, stencil.reference);
+			}
+			for (const auto format : graphicsPipelineInfo.colorAttachments)
+			{
+				sm::hash_combine(seed, format);
+			}
+			for (const auto& blend : graphicsPipelineInfo.colorBlendStates)
+			{
+				sm::hash_combine(seed, blend.blendEnable);
+				sm::hash_combine(seed, blend.srcColorFactor);
+				sm::hash_combine(seed, blend.dstColorFactor);
+				sm::hash_combine(seed, blend.colorOp);
+				sm::hash_combine(seed, blend.srcAlphaFactor);
+				sm::hash_combine(seed, blend.dstAlphaFactor);
+				sm::hash_combine(seed, blend.alphaOp);
+				sm::hash_combine(seed, blend.colorWriteMask);
+			}
+			sm::hash_combine(seed, graphicsPipelineInfo.depthAttachmentFormat);
+			sm::hash_combine(seed, graphicsPipelineInfo.sampleCount);
+			sm::hash_combine(seed, graphicsPipelineInfo.viewMask);
+			sm::hash_combine(seed, graphicsPipelineInfo.dynamicStates);
+			return seed;
+		}
+	};
+
+	template <>
+	struct hash<sm::gfx::MeshPipelineInfo>
+	{
+		std::size_t operator()(const sm::gfx::MeshPipelineInfo& meshPipelineInfo) const
+		{
+			std::size_t seed{};
+			sm::hash_combine(seed, meshPipelineInfo.taskCode);
+			sm::hash_combine(seed, meshPipelineInfo.meshCode);
+			for (const auto* constants : { &meshPipelineInfo.taskSpecializationConstants, &meshPipelineInfo.meshSpecializationConstants })
+			{
+				for (const auto& constant : *constants)
+				{
+					sm::hash_combine(seed, constant.id);
+					sm::hash_combine(seed, constant.value);
+				}
+				sm::hash_combine(seed, constants->size());
+			}
+			sm::hash_combine(seed, hash<sm::gfx::GraphicsPipelineInfo>{}(meshPipelineInfo.state));
+			return seed;
+		}
+	};
+
 } // namespace std
 
 #endif // GFX_GFX_HPP
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#ifndef GFX_GFX_ASSET_HPP
+#define GFX_GFX_ASSET_HPP
+
+#include "gfx.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+// Loads buffer and texture data on worker threads, each decoded straight into its slice of the device's staging ring, so
+// nothing is decoded into memory of its own first and copied again. Uploads decoded since the last update are flushed
+// together, in one submission on the upload queue:
+//
+//   assetLoader.load_texture(texture, 0, [path](void* dst, std::uint64_t size) { return decode_png(path, dst, size); });
+//   ...
+//   assetLoader.update(0); // Once a frame.
+//
+// Loading scales with the worker threads, while the thread calling update() only hands out staging space and flushes.
+// Requires DeviceInfo::uploadBufferSize.
+namespace sm::gfx
+{
+	class AssetLoader
+	{
+	public:
+		// Writes exactly size bytes to dst, laid out like queue_buffer_upload()'s or queue_texture_upload()'s data. Runs on a
+		// worker thread. Returning false skips the upload.
+		using DecodeFunc = std::function<bool(void* dst, std::uint64_t size)>;
+
+		/**
+		 * @param executor Runs the decodes, eg. an engine's job system. Null runs them on get_task_scheduler(). Must outlive
+		 * the loader.
+		 */
+		explicit AssetLoader(DeviceHandle deviceHandle, TaskScheduler* executor = nullptr);
+		// Waits for the decodes in progress. Loads that have not started are dropped.
+		~AssetLoader();
+
+		GFX_DISABLE_COPY(AssetLoader);
+
+		// Queue a load. May be called from any thread, decoding starts with the next update().
+		void load_buffer(BufferHandle bufferHandle, std::uint64_t size, std::uint64_t offset, DecodeFunc&& decode);
+		void load_texture(TextureHandle textureHandle, std::uint32_t mipLevel, DecodeFunc&& decode);
+
+		/**
+		 * @brief Start decoding queued loads, in order, for as many as the staging ring has room for, and flush those decoded
+		 * since the last update. Never blocks.
+		 * @return Reached once the loads flushed so far are usable on dstQueueIndex.
+		 */
+		auto update(std::uint32_t dstQueueIndex) -> SyncPoint;
+		// Loads queued, decoding, or decoded and not yet flushed.
+		auto get_pending_count() const -> std::size_t;
+
+	private:
+		struct Load
+		{
+			BufferHandle bufferHandle{};   // Either a buffer
+			TextureHandle textureHandle{}; // or a texture.
+			std::uint64_t size{ 0 };
+			std::uint64_t offset{ 0 };
+			std::uint32_t mipLevel{ 0 };
+			DecodeFunc decode{};
+		};
+
+		void decode(const UploadAllocation& allocation, const DecodeFunc& decodeFunc);
+
+		DeviceHandle m_deviceHandle;
+		TaskScheduler* m_executor;
+		std::uint64_t m_uploadBufferSize{ 0 };
+		SyncPoint m_syncPoint{};
+
+		mutable std::mutex m_mutex;
+		std::condition_variable m_condition; // Notified as decodes finish.
+		std::deque<Load> m_queuedLoads;
+		std::size_t m_decodingCount{ 0 };
+		std::size_t m_decodedCount{ 0 }; // Committed or cancelled since the last flush.
+	};
+
+} // namespace sm::gfx
+
+#endif // GFX_GFX_ASSET_HPP
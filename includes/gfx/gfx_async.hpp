@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#ifndef GFX_GFX_ASYNC_HPP
+#define GFX_GFX_ASYNC_HPP
+
+#include "gfx.hpp"
+
+#include <coroutine>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Awaitables for GPU work, so streaming code can be written straight-line with co_await instead of blocking waits or
+// callbacks, in whatever coroutine task type the application uses:
+//
+//   const auto syncPoint = co_await asyncWaiter.upload_texture_async(texture, data, size);
+//   co_await asyncWaiter.pipeline_ready(pipeline);
+//
+// Nothing waits on a thread. Suspended coroutines are kept by an AsyncWaiter until its poll() finds their work done, so
+// thousands can be in flight for the cost of their coroutine frames.
+namespace sm::gfx
+{
+	class AsyncWaiter;
+
+	/**
+	 * @brief Suspends until the GPU reaches a sync point, and evaluates to it. Does not suspend if it already has.
+	 */
+	class SyncPointAwaitable
+	{
+	public:
+		SyncPointAwaitable(AsyncWaiter& waiter, SyncPoint syncPoint) : m_waiter(&waiter), m_syncPoint(syncPoint) {}
+
+		bool await_ready() const;
+		void await_suspend(std::coroutine_handle<> handle) const;
+		auto await_resume() const -> SyncPoint { return m_syncPoint; }
+
+	private:
+		AsyncWaiter* m_waiter;
+		SyncPoint m_syncPoint;
+	};
+
+	/**
+	 * @brief Suspends until a pipeline from create_*_pipeline_async() has compiled, and evaluates to it.
+	 */
+	class PipelineReadyAwaitable
+	{
+	public:
+		PipelineReadyAwaitable(AsyncWaiter& waiter, PipelineHandle pipelineHandle) : m_waiter(&waiter), m_pipelineHandle(pipelineHandle) {}
+
+		bool await_ready() const;
+		void await_suspend(std::coroutine_handle<> handle) const;
+		auto await_resume() const -> PipelineHandle { return m_pipelineHandle; }
+
+	private:
+		AsyncWaiter* m_waiter;
+		PipelineHandle m_pipelineHandle;
+	};
+
+	/**
+	 * @brief Keeps the coroutines suspended on GPU work, and resumes them from poll() once it is done. Thread safe, so
+	 * coroutines on any thread can await through one waiter.
+	 */
+	class AsyncWaiter
+	{
+	public:
+		/**
+		 * @param executor Resumes the coroutines as its tasks, eg. an engine's job system. Null resumes them on the thread
+		 * calling poll(), one after another. Must outlive the waiter.
+		 */
+		explicit AsyncWaiter(TaskScheduler* executor = nullptr);
+
+		GFX_DISABLE_COPY(AsyncWaiter);
+
+		auto wait(SyncPoint syncPoint) -> SyncPointAwaitable { return { *this, syncPoint }; }
+		// Submit now, and await the submission's completion.
+		auto submit_async(const SubmitInfo& submitInfo) -> SyncPointAwaitable;
+		// Upload now, like upload_buffer() and upload_texture(), and await the copy's completion.
+		auto upload_buffer_async(BufferHandle bufferHandle, const void* data, std::uint64_t size, std::uint64_t offset = 0, std::uint32_t queueIndex = 0) -> SyncPointAwaitable;
+		auto upload_texture_async(TextureHandle textureHandle, const void* data, std::uint64_t size, std::uint32_t queueIndex = 0) -> SyncPointAwaitable;
+		// Flush the queued uploads now, like flush_uploads(), and await them being usable on dstQueueIndex.
+		auto flush_uploads_async(DeviceHandle deviceHandle, std::uint32_t dstQueueIndex) -> SyncPointAwaitable;
+		auto pipeline_ready(PipelineHandle pipelineHandle) -> PipelineReadyAwaitable { return { *this, pipelineHandle }; }
+
+		/**
+		 * @brief Resume the coroutines whose work is done, eg. once a frame. Checks each queue's timeline only up to the first
+		 * sync point it has not reached, so the cost follows what completed rather than what is in flight.
+		 * @return How many coroutines were resumed.
+		 */
+		auto poll() -> std::size_t;
+		// Coroutines still suspended. Those left when the waiter is destroyed are never resumed.
+		auto get_pending_count() const -> std::size_t;
+
+	private:
+		friend class SyncPointAwaitable;
+		friend class PipelineReadyAwaitable;
+
+		struct PendingSyncPoint
+		{
+			std::uint64_t value;
+			std::coroutine_handle<> handle;
+		};
+		// The coroutines awaiting one queue's timeline, in a min-heap by value.
+		struct Timeline
+		{
+			DeviceHandle deviceHandle;
+			std::uint32_t queueIndex;
+			std::vector<PendingSyncPoint> pending;
+		};
+		struct PendingPipeline
+		{
+			PipelineHandle pipelineHandle;
+			std::coroutine_handle<> handle;
+		};
+
+		void add(SyncPoint syncPoint, std::coroutine_handle<> handle);
+		void add(PipelineHandle pipelineHandle, std::coroutine_handle<> handle);
+		void resume(std::coroutine_handle<> handle);
+
+		TaskScheduler* m_executor;
+
+		mutable std::mutex m_mutex;
+		std::vector<Timeline> m_timelines;
+		std::vector<PendingPipeline> m_pendingPipelines;
+	};
+
+} // namespace sm::gfx
+
+#endif // GFX_GFX_ASYNC_HPP
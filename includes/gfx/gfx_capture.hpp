@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#ifndef GFX_GFX_CAPTURE_HPP
+#define GFX_GFX_CAPTURE_HPP
+
+#include "gfx.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace sm::gfx
+{
+	/**
+	 * @brief Replays a capture written by begin_capture() and end_capture() on another device, eg. to benchmark its frames
+	 * headlessly and the same way every run. Swap chains are replaced by headless ones of the same size.
+	 */
+	class CaptureReplay
+	{
+	public:
+		CaptureReplay() = default;
+		~CaptureReplay() = default;
+
+		DISABLE_COPY_AND_MOVE(CaptureReplay);
+
+		bool open(std::string_view path);
+		/**
+		 * @brief The DeviceInfo of the captured device, to create the device to replay on with.
+		 */
+		auto get_device_info() const -> const DeviceInfo& { return m_deviceInfo; }
+		/**
+		 * @brief Number of frames (begin_frame() calls) replay_frames() replays.
+		 */
+		auto get_frame_count() const -> std::uint32_t { return m_frameCount; }
+
+		/**
+		 * @brief Replay the calls made before the first captured frame, which create and fill the resources the frames use.
+		 * @param gpuScopes Wrap each command list the frames record in a GPU scope named "gfx_replay", so get_gpu_scope_timings()
+		 * times them. Needs DeviceInfo::gpuScopesPerFrame.
+		 */
+		bool create_resources(DeviceHandle deviceHandle, bool gpuScopes = false);
+		/**
+		 * @brief Replay the captured frames once. Resources they create are created again by every replay, so the captured
+		 * frames should only create transient ones, or destroy what they create.
+		 */
+		bool replay_frames();
+		/**
+		 * @brief Replay the calls made after the last captured frame, then wait for the device to go idle. Resources the
+		 * capture never destroyed live until the device is destroyed.
+		 */
+		void destroy_resources();
+
+	private:
+		struct Call
+		{
+			std::uint32_t op;
+			std::size_t offset; // Of its arguments in m_data.
+			std::uint32_t size;
+		};
+
+		bool replay(std::size_t firstCall, std::size_t endCall);
+		bool replay_call(const Call& call);
+		void map_handle(std::uint64_t capturedHandle, std::uint64_t replayedHandle);
+
+		std::vector<std::byte> m_data;
+		std::vector<Call> m_calls;
+		std::size_t m_framesBegin{ 0 }; // Index of the first frame's begin_frame() call.
+		std::size_t m_framesEnd{ 0 };	// One past the last frame's end_frame() call.
+		std::uint32_t m_frameCount{ 0 };
+		DeviceInfo m_deviceInfo{};
+
+		DeviceHandle m_deviceHandle{};
+		bool m_gpuScopes{ false };
+		bool m_replayingFrames{ false };
+		std::unordered_map<std::uint64_t, std::uint64_t> m_handles; // Captured handle values to the replayed ones.
+		std::unordered_set<std::uint64_t> m_scopedCommandLists;		// Replayed command lists with a "gfx_replay" scope open.
+	};
+
+} // namespace sm::gfx
+
+#endif // GFX_GFX_CAPTURE_HPP
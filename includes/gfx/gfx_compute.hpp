@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#ifndef GFX_GFX_COMPUTE_HPP
+#define GFX_GFX_COMPUTE_HPP
+
+#include "gfx.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Parallel primitives on buffers of 32-bit unsigned integers: exclusive prefix sum, reduction, radix sort and stream
+// compaction. They use subgroup arithmetic where the device supports it in compute shaders, and shared memory otherwise.
+//
+// The shaders are src/shaders/gfx_scan.hlsl, gfx_reduce.hlsl and gfx_radix_sort.hlsl (which include
+// gfx_compute_common.hlsli), compiled like the examples' shaders:
+//   dxc -T cs_6_0 -E "Main" -spirv -fvk-use-dx-layout -fspv-target-env=vulkan1.3 -Fo gfx_scan.spv gfx_scan.hlsl
+//
+// Everything is recorded outside render passes, as compute dispatches separated by memory barriers. The caller makes
+// the inputs visible to compute shader reads beforehand, and the outputs visible to their next use afterwards.
+namespace sm::gfx
+{
+	enum class ReduceOp : std::uint32_t
+	{
+		eAdd, // Wraps on overflow.
+		eMin,
+		eMax,
+	};
+
+	struct ComputePrimitivesInfo
+	{
+		// Code left empty disables the primitives needing it.
+		std::vector<char> scanShaderCode{};		 // scan() and compact(), and sort() for its histograms.
+		std::vector<char> reduceShaderCode{};	 // reduce().
+		std::vector<char> radixSortShaderCode{}; // sort().
+		std::uint32_t maxElements;				 // The most elements of any one call, at most ComputePrimitives::MAX_ELEMENTS.
+	};
+
+	class ComputePrimitives
+	{
+	public:
+		static constexpr std::uint32_t BLOCK_ELEMENTS = 1024; // Elements per workgroup, 256 threads of 4.
+		static constexpr std::uint32_t MAX_ELEMENTS = 65535 * BLOCK_ELEMENTS;
+
+		/**
+		 * @brief The scratch buffers for maxElements are created up front, so the primitives never allocate.
+		 */
+		ComputePrimitives(DeviceHandle deviceHandle, const ComputePrimitivesInfo& primitivesInfo);
+		~ComputePrimitives();
+
+		GFX_DISABLE_COPY(ComputePrimitives);
+
+		bool is_valid() const;
+		// Whether the device runs the subgroup variants of the kernels.
+		bool uses_subgroups() const { return m_useSubgroups; }
+
+		/**
+		 * @brief dst[i] = src[0] + ... + src[i - 1], dst[0] = 0. src and dst may be the same buffer.
+		 */
+		void scan(CommandListHandle commandListHandle, BufferHandle srcBufferHandle, BufferHandle dstBufferHandle, std::uint32_t count);
+
+		/**
+		 * @brief Combine src[0] to src[count - 1] into dst[0].
+		 */
+		void reduce(CommandListHandle commandListHandle, BufferHandle srcBufferHandle, BufferHandle dstBufferHandle, std::uint32_t count, ReduceOp op = ReduceOp::eAdd);
+
+		/**
+		 * @brief Sort keys ascending, in place and stably, carrying values along with them if given.
+		 * @param keyBits Only the low keyBits bits of the keys are sorted on, 4 per pass, eg. 16 for half the passes.
+		 */
+		void sort(CommandListHandle commandListHandle, BufferHandle keyBufferHandle, BufferHandle valueBufferHandle, std::uint32_t count, std::uint32_t keyBits = 32);
+
+		/**
+		 * @brief Copy the values whose flag is not 0 to the front of dst, in order, and their number to countBuffer[0], eg.
+		 * for dispatch_indirect() args built from it.
+		 */
+		void compact(CommandListHandle commandListHandle, BufferHandle valueBufferHandle, BufferHandle flagBufferHandle, std::uint32_t count, BufferHandle dstBufferHandle, BufferHandle countBufferHandle);
+
+	private:
+		static constexpr std::uint32_t RADIX_BITS = 4;
+		static constexpr std::uint32_t RADIX_BINS = 1u << RADIX_BITS;
+
+		/**
+		 * @brief Scan in place or not, with the partial sums of each level of blocks at sumsOffset onwards in m_sumsBuffer.
+		 * @param predicate Scan 1 for every non-zero input instead, as compact() does for its flags.
+		 */
+		void record_scan(CommandListHandle commandListHandle, BufferHandle inputBufferHandle, std::uint32_t inputOffset, BufferHandle outputBufferHandle, std::uint32_t outputOffset, std::uint32_t count, std::uint32_t sumsOffset, bool predicate);
+		void dispatch_scan_pass(CommandListHandle commandListHandle, std::uint32_t pass, BufferHandle inputBufferHandle, std::uint32_t inputOffset, BufferHandle outputBufferHandle, std::uint32_t outputOffset, std::uint32_t count, std::uint32_t sumsOffset, bool predicate);
+
+		DeviceHandle m_deviceHandle;
+		std::uint32_t m_maxElements;
+		bool m_useSubgroups{ false };
+
+		PipelineHandle m_scanPipeline{};
+		PipelineHandle m_reducePipeline{};
+		PipelineHandle m_radixSortPipeline{};
+		DescriptorSetInfo m_scanSetInfo;
+		DescriptorSetInfo m_reduceSetInfo;
+		DescriptorSetInfo m_radixSortSetInfo;
+
+		BufferHandle m_sumsBuffer{};		// Block sums of every level of a scan.
+		BufferHandle m_compactScanBuffer{}; // The scanned flags of compact().
+		BufferHandle m_partialsBuffer{};	// Block results of every level of a reduction.
+		BufferHandle m_histogramBuffer{};	// Digit counts of each block, digit major, scanned into scatter offsets.
+		BufferHandle m_sortKeyBuffer{};		// Sort passes ping-pong between these and the caller's buffers.
+		BufferHandle m_sortValueBuffer{};
+
+		bool m_valid{ false };
+	};
+
+} // namespace sm::gfx
+
+#endif // GFX_GFX_COMPUTE_HPP
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#ifndef GFX_GFX_CPU_CULLING_HPP
+#define GFX_GFX_CPU_CULLING_HPP
+
+#include "gfx.hpp"
+#include "gfx_draw_batch.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// CPU culling, for devices without draw_indexed_indirect_count() that cannot draw what GpuCulling keeps, or for the CPU half
+// of hybrid culling. Bounding spheres are stored as a structure of arrays and tested against the frustum a register at a
+// time, eight with AVX, four with SSE2 or NEON, in chunks spread over a TaskScheduler. Survivors can also be tested against
+// a small depth buffer of occluders rasterized on the CPU. The visible instances go straight to a DrawBatcher:
+//
+//   const auto instance = cpuCulling.add_instance(center, radius, meshIndex, materialIndex, &transform);
+//   ...
+//   cpuCulling.clear_occluders();
+//   cpuCulling.rasterize_occluders(view, occluderVertices, occluderIndices);
+//   cpuCulling.cull(view, drawBatcher);
+//   drawBatcher.flush(commandList, 1);
+//
+// The instruction set is chosen at compile time, AVX where the compiler targets it (eg. -mavx or /arch:AVX).
+namespace sm::gfx
+{
+	struct CpuCullView
+	{
+		std::array<float, 16> viewProjection; // Column major, with Vulkan's 0 to 1 depth range.
+		bool occlusion{ true };				  // Also test against the occluders rasterized since the last clear_occluders().
+		bool reverseZ{ false };				  // Depth is 1 at the near plane.
+	};
+
+	struct CpuCullStats
+	{
+		std::uint32_t instanceCount{ 0 };
+		std::uint32_t frustumVisibleCount{ 0 }; // Inside the frustum.
+		std::uint32_t visibleCount{ 0 };		// Also not occluded.
+	};
+
+	/**
+	 * @brief The instances of a scene with their bounds, culled each frame. Not thread safe, cull() spreads its own work.
+	 */
+	class CpuCulling
+	{
+	public:
+		/**
+		 * @param instanceDataSize Bytes of each instance's data, as given to DrawBatcher::submit().
+		 * @param executor Splits the culling of large scenes across its threads. Null culls on the calling thread.
+		 */
+		explicit CpuCulling(std::uint32_t instanceDataSize, TaskScheduler* executor = nullptr);
+
+		GFX_DISABLE_COPY(CpuCulling);
+
+		/**
+		 * @brief Add an instance, drawn as meshIndex and materialIndex of the DrawBatcher it is culled into.
+		 * @param instanceData instanceDataSize bytes, copied.
+		 * @return Its index, stable until clear().
+		 */
+		auto add_instance(const std::array<float, 3>& center, float radius, std::uint32_t meshIndex, std::uint32_t materialIndex, const void* instanceData) -> std::uint32_t;
+		// For instances that moved.
+		void set_instance_bounds(std::uint32_t instance, const std::array<float, 3>& center, float radius);
+		void set_instance_data(std::uint32_t instance, const void* instanceData);
+		void clear();
+
+		auto get_instance_count() const -> std::uint32_t { return m_count; }
+
+		void clear_occluders();
+		/**
+		 * @brief Draw large, opaque occluders, eg. simplified walls and terrain, into the occlusion buffer. Triangles crossing the
+		 * near plane are skipped, and each covers its pixels with its farthest depth, so the buffer never hides anything visible.
+		 * @param view The view cull() tests with.
+		 * @param indices Three per triangle, into vertices, in world space.
+		 */
+		void rasterize_occluders(const CpuCullView& view, std::span<const std::array<float, 3>> vertices, std::span<const std::uint32_t> indices);
+
+		/**
+		 * @brief Find the visible instances.
+		 * @return Their indices in ascending order, valid until the next cull().
+		 */
+		auto cull(const CpuCullView& view) -> std::span<const std::uint32_t>;
+		/**
+		 * @brief Find the visible instances and submit them to a draw batcher, in ascending order.
+		 */
+		void cull(const CpuCullView& view, DrawBatcher& drawBatcher);
+
+		// Of the last cull().
+		auto get_stats() const -> const CpuCullStats& { return m_stats; }
+
+	private:
+		static constexpr std::uint32_t OCCLUSION_WIDTH = 256;
+		static constexpr std::uint32_t OCCLUSION_HEIGHT = 128;
+
+		void cull_range(const std::array<std::array<float, 4>, 6>& planes, const CpuCullView& view, bool occlusion, std::uint32_t begin, std::uint32_t end, std::vector<std::uint32_t>& outVisible, std::uint32_t& outFrustumVisibleCount) const;
+		bool is_occluded(const CpuCullView& view, std::uint32_t instance) const;
+		void build_occlusion_levels();
+
+		std::uint32_t m_instanceDataSize;
+		TaskScheduler* m_executor;
+
+		// Bounds as a structure of arrays, padded to a whole register with empty spheres.
+		std::uint32_t m_count{ 0 };
+		std::vector<float> m_centerX;
+		std::vector<float> m_centerY;
+		std::vector<float> m_centerZ;
+		std::vector<float> m_radius;
+		std::vector<std::uint32_t> m_meshIndices;
+		std::vector<std::uint32_t> m_materialIndices;
+		std::vector<std::byte> m_instanceData;
+
+		// Nearest occluder depth of each pixel (0 near, 1 far, whatever the view's convention), then the farthest of each 2x2 block of each level below.
+		std::vector<float> m_occlusionDepth;
+		std::vector<std::uint32_t> m_occlusionLevelOffsets;
+		bool m_hasOccluders{ false };
+		bool m_occlusionLevelsDirty{ false };
+
+		std::vector<std::vector<std::uint32_t>> m_chunkVisible;
+		std::vector<std::uint32_t> m_visible;
+		CpuCullStats m_stats{};
+	};
+
+} // namespace sm::gfx
+
+#endif // GFX_GFX_CPU_CULLING_HPP
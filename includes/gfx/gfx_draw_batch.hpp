@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#ifndef GFX_GFX_DRAW_BATCH_HPP
+#define GFX_GFX_DRAW_BATCH_HPP
+
+#include "gfx.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Draw submission above the command list: draws are submitted in any order, as a mesh, a material and the instance's data,
+// then sorted by a 64-bit key of pipeline, material and mesh, so each pipeline and descriptor set is bound once. Draws of the
+// same mesh with the same material become one instanced draw, and runs of meshes sharing their buffers one multi-draw
+// indirect where the device supports it.
+//
+// Instance data is copied into transient memory in sorted order and bound as a VertexInputRate::eInstance binding, so
+// pipelines read it with their vertex attributes:
+//
+//   drawBatcher.submit(meshIndex, materialIndex, &transform);
+//   ...
+//   drawBatcher.flush(commandList, 1);
+//
+// Meshes' vertex buffers are bound as binding 0. Requires DeviceInfo::transientBufferSize.
+namespace sm::gfx
+{
+	/**
+	 * @brief Where a mesh is, eg. its part of a shared BufferArena buffer. Meshes sharing buffers can be drawn together.
+	 */
+	struct DrawMesh
+	{
+		BufferHandle vertexBufferHandle;
+		BufferHandle indexBufferHandle;
+		IndexType indexType{ IndexType::eUInt32 };
+		std::uint32_t indexCount;
+		std::uint32_t firstIndex{ 0 };
+		std::int32_t vertexOffset{ 0 };
+	};
+
+	struct DrawMaterial
+	{
+		PipelineHandle pipelineHandle;
+		DescriptorSetHandle descriptorSetHandle{}; // None is bound if null.
+		std::uint32_t set{ 0 };					   // The set it is bound as.
+	};
+
+	struct DrawBatchStats
+	{
+		std::uint32_t itemCount{ 0 }; // Draws submitted.
+		std::uint32_t drawCount{ 0 }; // Draw calls recorded, counting a multi-draw indirect as one.
+		std::uint32_t pipelineBindCount{ 0 };
+		std::uint32_t descriptorSetBindCount{ 0 };
+	};
+
+	/**
+	 * @brief Collects a frame's draws and records them sorted and merged. Not thread safe, use one per recording thread.
+	 */
+	class DrawBatcher
+	{
+	public:
+		/**
+		 * @param instanceDataSize Bytes of each draw's instance data, the stride of the instance binding.
+		 * @param executor Splits the sort of large batches across its threads. Null sorts on the calling thread.
+		 */
+		explicit DrawBatcher(DeviceHandle deviceHandle, std::uint32_t instanceDataSize, TaskScheduler* executor = nullptr);
+
+		GFX_DISABLE_COPY(DrawBatcher);
+
+		// Meshes and materials are referred to by the index returned, and kept until the batcher is destroyed.
+		auto add_mesh(const DrawMesh& mesh) -> std::uint32_t;
+		auto add_material(const DrawMaterial& material) -> std::uint32_t;
+
+		/**
+		 * @brief Queue a draw of one instance until the next flush().
+		 * @param instanceData instanceDataSize bytes, copied.
+		 */
+		void submit(std::uint32_t meshIndex, std::uint32_t materialIndex, const void* instanceData);
+		/**
+		 * @brief Record the queued draws into a command list inside a render pass, and clear them.
+		 * @param instanceBinding The vertex binding the pipelines read instance data from.
+		 */
+		void flush(CommandListHandle commandListHandle, std::uint32_t instanceBinding);
+
+		// Of the last flush().
+		auto get_stats() const -> const DrawBatchStats& { return m_stats; }
+
+	private:
+		struct SortEntry
+		{
+			std::uint64_t key;
+			std::uint32_t item;
+		};
+
+		void sort();
+
+		DeviceHandle m_deviceHandle;
+		std::uint32_t m_instanceDataSize;
+		TaskScheduler* m_executor;
+		bool m_multiDrawIndirect{ false };
+
+		std::vector<DrawMesh> m_meshes;
+		std::vector<DrawMaterial> m_materials;
+		std::vector<std::uint32_t> m_materialPipelines; // Per material, the rank of its pipeline among the materials'.
+		std::vector<PipelineHandle> m_pipelines;
+
+		std::vector<SortEntry> m_entries; // One per submitted draw, sorted by flush().
+		std::vector<SortEntry> m_sortScratch;
+		std::vector<std::byte> m_instanceData;
+		std::vector<DrawIndexedIndirectCommand> m_commands;
+		DrawBatchStats m_stats{};
+	};
+
+} // namespace sm::gfx
+
+#endif // GFX_GFX_DRAW_BATCH_HPP
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#ifndef GFX_GFX_GPU_CULLING_HPP
+#define GFX_GFX_GPU_CULLING_HPP
+
+#include "gfx.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// GPU-driven culling: instances are tested against the view frustum, and optionally a Hi-Z pyramid of an earlier depth
+// buffer, in a compute shader that writes the survivors' DrawIndexedIndirectCommands back to back with a count, so a whole
+// scene is drawn with one draw_indexed_indirect_count() and the CPU never touches per-instance visibility.
+//
+// The shaders are src/shaders/gpu_cull.hlsl and src/shaders/gpu_hi_z.hlsl, compiled like the examples' shaders:
+//   dxc -T cs_6_0 -E "Main" -spirv -fvk-use-dx-layout -fspv-target-env=vulkan1.3 -Fo gpu_cull.spv gpu_cull.hlsl
+namespace sm::gfx
+{
+	/**
+	 * @brief Bounds of one instance, in world space. Copied from GpuCullInstance arrays into an eStorage buffer.
+	 */
+	struct GpuCullInstance
+	{
+		std::array<float, 3> center;
+		float radius;
+		std::uint32_t drawIndex; // Into the GpuCullDraw buffer, the mesh the instance draws.
+		std::uint32_t padding[3]{};
+	};
+	static_assert(sizeof(GpuCullInstance) == 32);
+
+	/**
+	 * @brief Where a mesh lives in the bound index and vertex buffers, eg. its BufferArena allocations.
+	 */
+	struct GpuCullDraw
+	{
+		std::uint32_t indexCount;
+		std::uint32_t firstIndex;
+		std::int32_t vertexOffset;
+		std::uint32_t padding{};
+	};
+	static_assert(sizeof(GpuCullDraw) == 16);
+
+	struct GpuCullingInfo
+	{
+		std::vector<char> cullShaderCode;
+		std::vector<char> hiZShaderCode{}; // Empty disables occlusion culling.
+		std::uint32_t maxInstances;		   // Also the most draws cull() can write.
+	};
+
+	struct GpuCullView
+	{
+		std::array<float, 16> viewProjection; // Column major, with Vulkan's 0 to 1 depth range.
+		bool occlusion{ true };				  // Also test against the pyramid of the last build_hi_z(), if there is one.
+	};
+
+	/**
+	 * @brief The surviving instances are drawn with their index in the instance buffer as firstInstance, so vertex shaders
+	 * find their transforms through SV_StartInstanceLocation (or gl_BaseInstance) plus SV_InstanceID.
+	 */
+	class GpuCulling
+	{
+	public:
+		GpuCulling(DeviceHandle deviceHandle, const GpuCullingInfo& cullingInfo);
+		~GpuCulling();
+
+		GFX_DISABLE_COPY(GpuCulling);
+
+		bool is_valid() const;
+
+		/**
+		 * @brief Reduce a depth buffer, in TextureState::eShaderRead, into the pyramid of its farthest depths that later
+		 * cull()s test occluders against. Rebuilt each frame from the last frame's depth, or this frame's after a depth
+		 * prepass of last frame's visible instances, with the view projection it was rendered with.
+		 * @param reverseZ The depth buffer has 1 at the near plane.
+		 */
+		void build_hi_z(CommandListHandle commandListHandle, TextureHandle depthTextureHandle, std::uint32_t width, std::uint32_t height, const std::array<float, 16>& viewProjection, bool reverseZ = false);
+
+		/**
+		 * @brief Write the draws of the visible instances, and their count, for draw(). Outside render passes only.
+		 * @param instanceBufferHandle GpuCullInstances, at least instanceCount of them.
+		 * @param drawBufferHandle GpuCullDraws, indexed by GpuCullInstance::drawIndex.
+		 */
+		void cull(CommandListHandle commandListHandle, BufferHandle instanceBufferHandle, std::uint32_t instanceCount, BufferHandle drawBufferHandle, const GpuCullView& view);
+
+		/**
+		 * @brief Draw what the last cull() kept, with the pipeline, index buffer and vertex buffers already bound.
+		 */
+		void draw(CommandListHandle commandListHandle) const;
+
+		// DrawIndexedIndirectCommands and their uint count, eg. to draw them with another stride or read the count back.
+		auto get_draw_buffer() const -> BufferHandle { return m_drawBuffer; }
+		auto get_count_buffer() const -> BufferHandle { return m_countBuffer; }
+
+	private:
+		static constexpr std::uint32_t MAX_HI_Z_LEVELS = 16;
+
+		struct CullParams
+		{
+			std::array<float, 16> viewProjection;
+			std::array<float, 16> hiZViewProjection;
+			std::uint32_t instanceCount;
+			std::uint32_t hiZWidth; // Of level 0, half the depth buffer's size.
+			std::uint32_t hiZHeight;
+			std::uint32_t hiZLevels; // 0 without a pyramid.
+			std::uint32_t flags;
+			std::uint32_t padding[3]{};
+		};
+
+		DeviceHandle m_deviceHandle;
+		std::uint32_t m_maxInstances;
+
+		PipelineHandle m_cullPipeline{};
+		PipelineHandle m_hiZPipeline{};
+		DescriptorSetInfo m_cullSetInfo;
+		DescriptorSetInfo m_hiZSetInfo;
+		SamplerHandle m_depthSampler{};
+
+		BufferHandle m_paramsBuffer{};
+		BufferHandle m_drawBuffer{};
+		BufferHandle m_countBuffer{};
+
+		BufferHandle m_hiZBuffer{}; // Floats, the levels one after another.
+		std::uint64_t m_hiZBufferSize{ 0 };
+		std::uint32_t m_hiZWidth{ 0 };
+		std::uint32_t m_hiZHeight{ 0 };
+		std::uint32_t m_hiZLevels{ 0 };
+		std::array<float, 16> m_hiZViewProjection{};
+		bool m_hiZReverseZ{ false };
+
+		bool m_valid{ false };
+	};
+
+} // namespace sm::gfx
+
+#endif // GFX_GFX_GPU_CULLING_HPP
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#ifndef GFX_GFX_GPU_DECOMPRESS_HPP
+#define GFX_GFX_GPU_DECOMPRESS_HPP
+
+#include "gfx.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+
+// Compressed asset uploads, decompressed by a compute shader so streamed data crosses the bus, and comes off disk, at its
+// compressed size. Assets are compressed offline with compress_for_gpu(), into independent blocks of an LZ format (LZ4-like
+// sequences of literals and matches). At runtime the compressed stream is copied into this frame's transient memory, one
+// workgroup per block decodes it into a scratch buffer, and copies move the result into the final buffers and textures:
+//
+//   decompressor.queue_buffer_upload(vertexBuffer, 0, compressedVertices);
+//   decompressor.queue_texture_upload(texture, { .mipLevel = 0 }, compressedTexels);
+//   decompressor.record(commandList);
+//
+// The shader is src/shaders/gfx_decompress.hlsl, compiled like the examples' shaders:
+//   dxc -T cs_6_0 -E "Main" -spirv -fvk-use-dx-layout -fspv-target-env=vulkan1.3 -Fo gfx_decompress.spv gfx_decompress.hlsl
+namespace sm::gfx
+{
+	// The stream is a GpuCompressedHeader, then the end of each block's data as a std::uint32_t, from the start of the data
+	// after them, then the data. Each block decompresses to GPU_COMPRESSED_BLOCK_SIZE bytes except the last, which holds the rest.
+	// A block whose data is exactly that size is stored uncompressed.
+	constexpr std::uint32_t GPU_COMPRESSED_MAGIC = 0x315A4C47; // "GLZ1"
+	constexpr std::uint32_t GPU_COMPRESSED_BLOCK_SIZE = 16384;	 // Must match BLOCK_SIZE in gfx_decompress.hlsl.
+
+	struct GpuCompressedHeader
+	{
+		std::uint32_t magic;
+		std::uint32_t blockCount;
+		std::uint64_t size; // Decompressed.
+	};
+	static_assert(sizeof(GpuCompressedHeader) == 16);
+
+	/**
+	 * @brief Compress data for GpuDecompressor, eg. in an asset build step. Greedy, so fast rather than as small as possible.
+	 */
+	auto compress_for_gpu(std::span<const std::byte> data) -> std::vector<std::byte>;
+	/**
+	 * @return The decompressed size of a stream, or 0 if it is not one.
+	 */
+	auto get_decompressed_size(std::span<const std::byte> compressed) -> std::uint64_t;
+	/**
+	 * @brief Decompress a stream on the CPU, eg. to validate assets or for data the CPU reads.
+	 * @param dst Exactly get_decompressed_size() bytes.
+	 * @return False if the stream is malformed.
+	 */
+	bool decompress_on_cpu(std::span<std::byte> dst, std::span<const std::byte> compressed);
+
+	struct GpuDecompressorInfo
+	{
+		std::vector<char> shaderCode;
+	};
+
+	class GpuDecompressor
+	{
+	public:
+		GpuDecompressor(DeviceHandle deviceHandle, const GpuDecompressorInfo& decompressorInfo);
+		~GpuDecompressor();
+
+		GFX_DISABLE_COPY(GpuDecompressor);
+
+		bool is_valid() const;
+
+		/**
+		 * @brief Stage a compressed stream in this frame's transient memory, to be decompressed into a buffer by the next record().
+		 * Thread safe, eg. for asset workers.
+		 * @param offset Where the decompressed bytes go in the buffer, which needs room for get_decompressed_size() of them.
+		 */
+		bool queue_buffer_upload(BufferHandle bufferHandle, std::uint64_t offset, std::span<const std::byte> compressed);
+		/**
+		 * @brief As queue_buffer_upload(), for the texels of a region of a texture, laid out as copy_buffer_to_texture() reads
+		 * them. The region's bufferOffset is ignored, and its subresources must be in TextureState::eUploadDst when record() runs.
+		 */
+		bool queue_texture_upload(TextureHandle textureHandle, const BufferTextureCopyRegion& region, std::span<const std::byte> compressed);
+
+		/**
+		 * @brief Decompress everything queued since the last record(), and copy it into place. Needs a queue with compute, the
+		 * same one each time, and must be recorded in the frame the uploads were queued in, before begin_frame() reuses their
+		 * transient memory. The copies' writes are visible to every later command.
+		 */
+		void record(CommandListHandle commandListHandle);
+
+		// Decompressed bytes queued for the next record().
+		auto get_pending_size() const -> std::uint64_t;
+
+	private:
+		// Must match Block in gfx_decompress.hlsl.
+		struct Block
+		{
+			std::uint32_t srcOffset; // In the transient buffer.
+			std::uint32_t srcSize;
+			std::uint32_t dstOffset; // In the scratch buffer.
+			std::uint32_t dstSize;
+		};
+
+		struct Upload
+		{
+			BufferHandle bufferHandle{};
+			std::uint64_t bufferOffset{ 0 };
+			TextureHandle textureHandle{};
+			BufferTextureCopyRegion region{};
+			std::uint64_t scratchOffset{ 0 };
+			std::uint64_t size{ 0 };
+		};
+
+		bool queue_upload(Upload upload, std::span<const std::byte> compressed);
+
+		DeviceHandle m_deviceHandle;
+		DescriptorSetInfo m_setInfo{};
+		PipelineHandle m_pipeline{};
+		BufferHandle m_scratchBuffer{};
+		std::uint64_t m_scratchBufferSize{ 0 };
+		bool m_valid{ false };
+
+		mutable std::mutex m_mutex;
+		BufferHandle m_transientBuffer{};
+		std::vector<Block> m_blocks;
+		std::vector<Upload> m_uploads;
+		std::uint64_t m_pendingSize{ 0 };
+	};
+
+} // namespace sm::gfx
+
+#endif // GFX_GFX_GPU_DECOMPRESS_HPP
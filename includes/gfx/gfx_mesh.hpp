@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#ifndef GFX_GFX_MESH_HPP
+#define GFX_GFX_MESH_HPP
+
+#include "gfx.hpp"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// A binary mesh container: one interleaved vertex stream and one index stream, stored exactly as they are uploaded, with
+// the mesh's bounds. Meshes are baked once from whatever format they were authored in with optimize_mesh() and
+// write_mesh_file(), and a MeshFile memory-maps them at load, so the streams are copied from the page cache straight into
+// the staging buffer with nothing parsed or converted.
+//
+// The file is a MeshFileHeader followed by the vertex and index streams, then optionally the meshlet arrays for mesh
+// shaders and cluster culling, each starting at a multiple of MESH_FILE_ALIGNMENT.
+// Values are little endian.
+namespace sm::gfx
+{
+	constexpr std::uint32_t MESH_FILE_MAGIC = 0x4853454D; // "MESH"
+	constexpr std::uint32_t MESH_FILE_VERSION = 2;
+	constexpr std::uint64_t MESH_FILE_ALIGNMENT = 256;
+
+	constexpr std::uint32_t MAX_MESHLET_VERTICES = 64;
+	constexpr std::uint32_t MAX_MESHLET_TRIANGLES = 124;
+
+	/**
+	 * @brief A cluster of a mesh's triangles, small enough for one mesh shader workgroup.
+	 */
+	struct Meshlet
+	{
+		std::uint32_t vertexOffset;	  // Into MeshletData::vertices.
+		std::uint32_t triangleOffset; // Into MeshletData::triangles.
+		std::uint32_t vertexCount;
+		std::uint32_t triangleCount;
+	};
+	static_assert(sizeof(Meshlet) == 16);
+
+	/**
+	 * @brief What a meshlet's triangles cover, for culling it whole. With a camera at c, every triangle faces away when
+	 * dot(center - c, coneAxis) >= coneCutoff * length(center - c) + radius.
+	 */
+	struct MeshletBounds
+	{
+		std::array<float, 3> center;
+		float radius;
+		std::array<float, 3> coneAxis; // Zero, with coneCutoff 1, when the normals are too spread out to cull by.
+		float coneCutoff;
+	};
+	static_assert(sizeof(MeshletBounds) == 32);
+
+	struct MeshletData
+	{
+		std::vector<Meshlet> meshlets{};
+		std::vector<MeshletBounds> bounds{}; // One per meshlet.
+		std::vector<std::uint32_t> vertices{};	// Mesh vertex indices, each meshlet's own range of them.
+		std::vector<std::uint32_t> triangles{}; // Three meshlet local vertex indices each, packed into bits 0, 8 and 16.
+	};
+
+	/**
+	 * @brief A mesh's meshlets on the GPU, as eStorage buffers laid out like MeshletData's arrays.
+	 */
+	struct MeshletBuffers
+	{
+		BufferHandle meshletBuffer{};
+		BufferHandle boundsBuffer{};
+		BufferHandle vertexBuffer{};
+		BufferHandle triangleBuffer{};
+	};
+
+	struct MeshFileHeader
+	{
+		std::uint32_t magic;
+		std::uint32_t version;
+		std::uint32_t vertexStride; // Bytes per vertex.
+		std::uint32_t vertexCount;
+		std::uint32_t indexCount;
+		IndexType indexType;
+		std::uint64_t vertexOffset; // From the start of the file.
+		std::uint64_t indexOffset;
+		std::array<float, 3> boundsMin; // Of the vertices' positions.
+		std::array<float, 3> boundsMax;
+		std::uint32_t meshletCount{ 0 }; // 0 if the mesh was written without meshlets.
+		std::uint32_t meshletVertexCount{ 0 };
+		std::uint32_t meshletTriangleCount{ 0 };
+		std::uint32_t padding{ 0 };
+		std::uint64_t meshletOffset{ 0 };
+		std::uint64_t meshletBoundsOffset{ 0 };
+		std::uint64_t meshletVertexOffset{ 0 };
+		std::uint64_t meshletTriangleOffset{ 0 };
+	};
+	static_assert(sizeof(MeshFileHeader) == 112);
+
+	/**
+	 * @brief Prepare an indexed triangle list for rendering, eg. before write_mesh_file():
+	 *   - Vertices with identical bytes are merged, and those no triangle uses are dropped.
+	 *   - Triangles are reordered for the post-transform vertex cache, then runs of them for less overdraw, outward facing first.
+	 *   - Vertices are reordered into the order the triangles first use them, for vertex fetch locality.
+	 * Merging compares whole vertices, so any padding in them must be zeroed. Triangles left degenerate by it are removed.
+	 * @param vertexData vertexCount vertices of vertexStride bytes, each starting with its position as three floats. Rewritten
+	 * in place.
+	 * @return The number of vertices left at the start of vertexData.
+	 */
+	auto optimize_mesh(void* vertexData, std::uint32_t vertexStride, std::uint32_t vertexCount, std::vector<std::uint32_t>& indices) -> std::uint32_t;
+
+	/**
+	 * @brief Split a triangle list into meshlets of at most MAX_MESHLET_VERTICES and MAX_MESHLET_TRIANGLES, in triangle order, so
+	 * those of a mesh from optimize_mesh() share most of their vertices.
+	 * @param vertexData vertexCount vertices of vertexStride bytes, each starting with its position as three floats.
+	 */
+	void build_meshlets(MeshletData& outMeshletData, const void* vertexData, std::uint32_t vertexStride, std::uint32_t vertexCount, std::span<const std::uint32_t> indices);
+
+	/**
+	 * @brief How quantize_vertices() stores one attribute of the source vertices.
+	 */
+	struct QuantizedAttribute
+	{
+		std::uint32_t floatCount; // Floats of the attribute in the source vertices.
+		Format format;			  // eRG32, eRGB32 and eRGBA32 keep the floats as they are.
+		bool octahedral{ false }; // Store a unit vector's three floats as two, eg. normals as eRG16Snorm or eRG8Snorm.
+	};
+
+	/**
+	 * @brief Pack float vertices into compact formats, eg. positions as eRGBA16Float, normals as eRGBA8Snorm and texture
+	 * coordinates as eRG16Float, roughly halving vertex bandwidth. Attributes are packed back to back in the order given, as
+	 * GraphicsPipelineInfo lays them out, and components the source lacks are zero. Normalized formats clamp to their range.
+	 * Quantize after optimize_mesh() and build_meshlets(), which read float positions.
+	 * @param vertexData vertexCount vertices, each the floats of every attribute in turn.
+	 * @return The packed vertex stride.
+	 */
+	auto quantize_vertices(std::vector<std::byte>& outVertexData, const float* vertexData, std::uint32_t vertexCount, std::span<const QuantizedAttribute> attributes) -> std::uint32_t;
+
+	/**
+	 * @brief Bake a mesh. Indices are stored as 16-bit when every vertex can be reached with them.
+	 * @param vertexData vertexCount vertices of vertexStride bytes, each starting with its position.
+	 * @param meshletData The mesh's meshlets from build_meshlets(), if it has them.
+	 * @param positionFormat eRGB32, eRGBA32 or eRGBA16Float, the last for vertices from quantize_vertices().
+	 */
+	bool write_mesh_file(const char* filename, const void* vertexData, std::uint32_t vertexStride, std::uint32_t vertexCount, std::span<const std::uint32_t> indices,
+						 const MeshletData* meshletData = nullptr, Format positionFormat = Format::eRGB32);
+
+	/**
+	 * @brief A mesh file mapped read only into memory, for as long as the MeshFile is open.
+	 */
+	class MeshFile
+	{
+	public:
+		MeshFile() = default;
+		~MeshFile();
+
+		GFX_DISABLE_COPY(MeshFile);
+
+		/**
+		 * @brief Map a file from write_mesh_file(), closing any open one first.
+		 * @return False if the file cannot be mapped, or is not a mesh file of this version.
+		 */
+		bool open(const char* filename);
+		void close();
+
+		bool is_open() const { return m_data != nullptr; }
+		auto get_header() const -> const MeshFileHeader& { return *static_cast<const MeshFileHeader*>(m_data); }
+		auto get_vertex_data() const -> std::span<const std::byte>;
+		auto get_index_data() const -> std::span<const std::byte>;
+		// Empty if the mesh was written without meshlets.
+		auto get_meshlets() const -> std::span<const Meshlet>;
+		auto get_meshlet_bounds() const -> std::span<const MeshletBounds>;
+		auto get_meshlet_vertices() const -> std::span<const std::uint32_t>;
+		auto get_meshlet_triangles() const -> std::span<const std::uint32_t>;
+
+		/**
+		 * @brief Create an eVertex and an eIndex buffer for the mesh, and upload the streams to them straight from the mapping.
+		 * @param outSyncPoint Reached once both copies have finished, like upload_buffer(). The file may be closed straight away.
+		 */
+		bool upload(BufferHandle& outVertexBufferHandle, BufferHandle& outIndexBufferHandle, SyncPoint& outSyncPoint, DeviceHandle deviceHandle, std::uint32_t queueIndex = 0) const;
+		/**
+		 * @brief Create the meshlet storage buffers, and upload them like upload(). Fails if the mesh has no meshlets.
+		 */
+		bool upload_meshlets(MeshletBuffers& outMeshletBuffers, SyncPoint& outSyncPoint, DeviceHandle deviceHandle, std::uint32_t queueIndex = 0) const;
+
+	private:
+		void* m_data{ nullptr };
+		std::uint64_t m_size{ 0 };
+	};
+
+} // namespace sm::gfx
+
+#endif // GFX_GFX_MESH_HPP
@@ -9,69 +9,349 @@
 
 #include <memory>
 #include <string>
-#include <functional>
-#include <unordered_map>
+#include <string_view>
+#include <array>
+#include <cstddef>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
-/*
- * Reference: https://logins.github.io/graphics/2021/05/31/RenderGraphs.html
- */
+// Reference: https://logins.github.io/graphics/2021/05/31/RenderGraphs.html
 namespace sm::gfx
 {
+	class WorkerPool;
+
+	/**
+	 * @brief Like std::function, but keeping the callable in place rather than on the heap, so setting it never allocates.
+	 * The callable must fit in Capacity bytes, eg. a lambda capturing a few references or pointers.
+	 */
+	template <typename Signature, std::size_t Capacity = 64>
+	class InplaceFunction;
+
+	template <typename R, typename... Args, std::size_t Capacity>
+	class InplaceFunction<R(Args...), Capacity>
+	{
+	public:
+		InplaceFunction() = default;
+		template <typename F>
+			requires(!std::is_same_v<std::remove_cvref_t<F>, InplaceFunction> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+		InplaceFunction(F&& func)
+		{
+			using Callable = std::decay_t<F>;
+			static_assert(sizeof(Callable) <= Capacity, "Callable is too large, capture less or by reference!");
+			static_assert(alignof(Callable) <= alignof(std::max_align_t), "Callable is over-aligned!");
+			static_assert(std::is_nothrow_move_constructible_v<Callable>, "Callable must be nothrow move constructible!");
+
+			new (m_storage) Callable(std::forward<F>(func));
+			m_invoke = [](void* storage, Args&&... args) -> R {
+				return (*static_cast<Callable*>(storage))(std::forward<Args>(args)...);
+			};
+			m_manage = [](void* storage, void* dstStorage) {
+				auto* callable = static_cast<Callable*>(storage);
+				if (dstStorage != nullptr)
+				{
+					new (dstStorage) Callable(std::move(*callable));
+				}
+				callable->~Callable();
+			};
+		}
+		InplaceFunction(InplaceFunction&& other) noexcept { *this = std::move(other); }
+		~InplaceFunction() { reset(); }
+
+		InplaceFunction(const InplaceFunction&) = delete;
+		auto operator=(const InplaceFunction&) -> InplaceFunction& = delete;
+
+		auto operator=(InplaceFunction&& rhs) noexcept -> InplaceFunction&
+		{
+			if (this != &rhs)
+			{
+				reset();
+				if (rhs.m_manage != nullptr)
+				{
+					rhs.m_manage(rhs.m_storage, m_storage);
+				}
+				m_invoke = std::exchange(rhs.m_invoke, nullptr);
+				m_manage = std::exchange(rhs.m_manage, nullptr);
+			}
+			return *this;
+		}
+
+		void reset()
+		{
+			if (m_manage != nullptr)
+			{
+				m_manage(m_storage, nullptr);
+			}
+			m_invoke = nullptr;
+			m_manage = nullptr;
+		}
+
+		auto operator()(Args... args) -> R { return m_invoke(m_storage, std::forward<Args>(args)...); }
+		explicit operator bool() const { return m_invoke != nullptr; }
+
+	private:
+		alignas(std::max_align_t) std::byte m_storage[Capacity]{};
+		R (*m_invoke)(void*, Args&&...){ nullptr };
+		void (*m_manage)(void*, void*){ nullptr }; // Moves the callable into the second storage if given, then destroys it.
+	};
+
+	// A texture owned by the render graph, see RenderGraph::add_transient_texture().
+	struct RenderGraphTexture
+	{
+		std::uint32_t index;
+	};
+
 	class RenderGraphPass
 	{
 	public:
-		void read(TextureHandle textureHandle);
-		void write(TextureHandle textureHandle);
+		/**
+		 * @brief Declare the textures the pass uses. They order it after the last pass declared before it that writes them,
+		 * and a write also after the passes reading what that pass wrote.
+		 * The graph transitions each texture to the given state before the pass, so the pass should not transition it itself.
+		 * A texture both read and written by the pass is transitioned to its write state. Writes default to
+		 * TextureState::eRenderTarget in graphics passes and TextureState::eStorage in compute passes.
+		 */
+		void read(TextureHandle textureHandle, TextureState state = TextureState::eShaderRead);
+		void write(TextureHandle textureHandle, std::optional<TextureState> state = std::nullopt);
+		void read(RenderGraphTexture texture, TextureState state = TextureState::eShaderRead);
+		void write(RenderGraphTexture texture, std::optional<TextureState> state = std::nullopt);
+
+		/**
+		 * @brief Have the graph begin a render pass on these attachments before on_execute(), and end it after, writing them
+		 * in TextureState::eRenderTarget. Needs at least one color attachment. The load and store ops are inferred: an
+		 * attachment an earlier pass wrote is loaded, otherwise cleared, and it is only stored if a later pass uses it or
+		 * it is exported (or, without exports, it is not transient). Consecutive passes on the same attachments share one
+		 * render pass, unless another texture needs a transition between them.
+		 */
+		void add_color_attachment(TextureHandle textureHandle);
+		void add_color_attachment(RenderGraphTexture texture);
+		void set_depth_attachment(TextureHandle textureHandle);
+		void set_depth_attachment(RenderGraphTexture texture);
+		void set_clear_color(const std::array<float, 4>& clearColor);
+
+		/**
+		 * @brief Mark the pass as needed for its effects outside the graph's textures, eg. writing a buffer for readback or
+		 * uploading data, so compile() never culls it. Its reads are kept too, as are the passes writing them.
+		 */
+		void set_side_effects();
 
 		/***
 		 * @brief Define the function that gets called when the SwapChain is rebuilt (eg. resized).
 		 * @param buildFunc
 		 */
-		void on_build(std::function<void(std::uint32_t width, std::uint32_t height)>&& buildFunc);
+		void on_build(InplaceFunction<void(std::uint32_t width, std::uint32_t height)>&& buildFunc);
 
 		/**
 		 * @brief Define the function that gets called when the pass is actually executed (eg. Draw commands).
 		 * @param executeFunc
 		 */
-		void on_execute(std::function<void(CommandListHandle commandListHandle)>&& executeFunc);
+		void on_execute(InplaceFunction<void(CommandListHandle commandListHandle)>&& executeFunc);
+
+		/* Getters */
+
+		auto get_name() const -> const std::string& { return m_name; }
 
 	private:
 		friend class RenderGraph;
 
 		void build(std::uint32_t width, std::uint32_t height);
 		void execute(CommandListHandle commandListHandle);
+		/**
+		 * @brief Forget the declaration, keeping the capacity of its containers for the next pass declared in its place.
+		 */
+		void clear();
 
 	private:
-		std::vector<TextureHandle> m_reads;
-		std::vector<TextureState> m_readStates;
+		static constexpr std::uint64_t TRANSIENT_TEXTURE_BIT = 1ull << 63u; // Keys RenderGraphTexture indices apart from handles.
+
+		struct TextureAccess
+		{
+			std::uint64_t texture; // A TextureHandle, or TRANSIENT_TEXTURE_BIT | RenderGraphTexture::index.
+			TextureState state;
+		};
+
+		std::vector<TextureAccess> m_reads;
+		std::vector<TextureAccess> m_writes;
+
+		std::optional<std::uint32_t> m_queueIndex; // Unset runs on the queue the graph is executed on.
+		bool m_compute{ false };
+		bool m_sideEffects{ false }; // Never culled, see set_side_effects().
+
+		std::vector<std::uint64_t> m_colorAttachments; // Keyed like TextureAccess::texture.
+		std::optional<std::uint64_t> m_depthAttachment;
+		std::array<float, 4> m_clearColor{ 1.0f, 1.0f, 1.0f, 1.0f };
 
-		std::vector<TextureHandle> m_writes;
-		std::vector<TextureState> m_writeStates;
+		std::string m_name;
 
-		std::function<void(std::uint32_t width, std::uint32_t height)> m_buildFunc;
-		std::function<void(CommandListHandle commandListHandle)> m_executeFunc;
+		InplaceFunction<void(std::uint32_t width, std::uint32_t height)> m_buildFunc;
+		InplaceFunction<void(CommandListHandle commandListHandle)> m_executeFunc;
 	};
 
 	class RenderGraph
 	{
 	public:
-		auto add_graphics_pass(const std::string& passName) -> RenderGraphPass&;
+		RenderGraph();
+		/**
+		 * @brief The device is needed to create transient textures and for execute_parallel().
+		 */
+		explicit RenderGraph(DeviceHandle deviceHandle);
+		~RenderGraph();
+
+		GFX_DISABLE_COPY(RenderGraph);
+
+		/**
+		 * @brief Declare a pass, after those already declared. Passes are identified by declaration order, the name is only
+		 * for debugging. Their storage is kept by reset(), so declaring the same graph again does not allocate.
+		 */
+		auto add_graphics_pass(std::string_view passName) -> RenderGraphPass&;
+		/**
+		 * @brief Add a pass of compute work. Given a queueIndex, eg. of an async compute queue, execute_parallel() submits it
+		 * to that queue, where it overlaps the passes on other queues that it does not depend on. The semaphore waits and
+		 * queue ownership transfers between queues are inserted by the graph. execute() records it like any other pass.
+		 */
+		auto add_compute_pass(std::string_view passName, std::optional<std::uint32_t> queueIndex = std::nullopt) -> RenderGraphPass&;
+
+		/**
+		 * @brief Declare a texture only used within the graph. It is created by compile(), sharing memory with the other
+		 * transient textures that are not used by any of the same range of passes. Its contents are undefined before the
+		 * first pass using it, which should write it. A width and height of 0 follow the graph's size, see resize().
+		 */
+		auto add_transient_texture(const TextureInfo& textureInfo) -> RenderGraphTexture;
+
+		/**
+		 * @brief Get the texture compile() created for a transient texture, eg. to bind it in a pass.
+		 * Not valid if no pass uses the texture.
+		 */
+		auto get_texture(RenderGraphTexture texture) const -> TextureHandle;
+
+		/**
+		 * @brief Mark a texture as an output of the graph, eg. what gets presented or read after execute().
+		 * Once any texture is exported, compile() culls the passes whose writes never reach an exported texture, unless
+		 * they are marked with RenderGraphPass::set_side_effects().
+		 */
+		void export_texture(TextureHandle textureHandle);
+		void export_texture(RenderGraphTexture texture);
+
+		/**
+		 * @brief Clear the declared passes, exports and transient textures, to declare the graph again, eg. every frame.
+		 * The compiled plan and transient textures are kept, for compile() to reuse if the graph comes out the same.
+		 * The graph cannot be executed again until it has been compiled.
+		 */
+		void reset();
+
+		/**
+		 * @brief Set the size of the transient textures declared without one, eg. when the swap chain is rebuilt,
+		 * and call every pass's on_build() function. The next compile() only recreates the transient textures.
+		 */
+		void resize(std::uint32_t width, std::uint32_t height);
 
 		/***
-		 * @brief Compile the render graph.
+		 * @brief Compile the render graph, ordering the passes by the dependencies between their reads and writes. A pass
+		 * is moved next to the pass producing what it reads where possible, otherwise passes keep their declaration order.
+		 * Also works out the texture transitions before each pass: rereading a texture in the state it is in needs none.
+		 * Transient textures are (re)created here, aliased by the range of passes they are used in.
+		 * Passes not contributing to an exported texture, nor to a pass with side effects, are culled, see export_texture().
+		 * Compiling a graph whose passes, exports and transient textures are unchanged since it was last compiled does nothing.
 		 * @return True if the render graph was successfully created.
 		 */
 		bool compile();
 
 		/**
-		 * @brief Execute the render graph.
+		 * @brief Execute the render graph. The transitions before each pass are recorded as one batch of barriers. A transition of
+		 * a texture last used before the previous pass is split instead, begun after that use with an event and waited on before
+		 * the pass, so the passes in between run while it completes.
 		 */
 		void execute(CommandListHandle commandListHandle);
 
+		/**
+		 * @brief Set how many threads execute_parallel() records passes on. 0 (the default) records on the calling thread.
+		 */
+		void set_recording_threads(std::uint32_t threadCount);
+		/**
+		 * @brief Record execute_parallel()'s passes as tasks of an engine's scheduler instead of threads of the graph's own, eg.
+		 * the one given as DeviceInfo::taskScheduler. It must outlive the graph, or be replaced first. Null records on the
+		 * calling thread. Replaces set_recording_threads(), and is replaced by it.
+		 */
+		void set_task_scheduler(TaskScheduler* taskScheduler);
+
+		/**
+		 * @brief Execute the render graph, recording each pass (or passes sharing a render pass) into its own transient
+		 * command list on the recording threads, then submitting them in execution order, one submission per run of passes
+		 * on the same queue. Passes then run concurrently on the CPU, so must not depend on each other's recording, nor
+		 * transition the graph's textures. Call between begin_frame() and end_frame().
+		 * @param batch The waits, applied before the first submission on each queue (semaphores on queueIndex only), and the
+		 * swap chain and signal of the last submission, on queueIndex. So with passes on other queues, only the passes after
+		 * the last one on another queue may render to the swap chain. Its command lists are ignored.
+		 * @return The sync point of the last submission, which waits on every queue, or a complete SyncPoint on failure.
+		 */
+		auto execute_parallel(std::uint32_t queueIndex, const SubmitBatch& batch = {}) -> SyncPoint;
+
 	private:
-		std::unordered_map<std::string, std::unique_ptr<RenderGraphPass>> m_passMap;
+		static constexpr std::size_t NO_PASS = SIZE_MAX;
+
+		enum class TransitionType
+		{
+			eTransition,
+			eAcquire,  // First use of a transient texture, taking over its memory.
+			eTransfer, // Use on another queue than the texture's last user.
+		};
+		struct Transition
+		{
+			std::uint64_t texture; // Keyed like RenderGraphPass::TextureAccess::texture, so recreating transient textures keeps it.
+			TextureState oldState; // eTransfer only.
+			TextureState newState;
+			TransitionType type;
+			std::size_t releasingPass; // eTransfer only. The pass whose queue releases the texture, NO_PASS for the graph's queue before any pass.
+			std::size_t beginAfterPass{ NO_PASS }; // eTransition only. Where execute() begins it split, NO_PASS for a plain barrier.
+		};
+
+		struct RenderPass
+		{
+			bool begins; // Otherwise continues the render pass of the pass before.
+			bool ends;
+			std::array<LoadOp, MAX_COLOR_ATTACHMENTS> colorLoadOps{};
+			std::array<StoreOp, MAX_COLOR_ATTACHMENTS> colorStoreOps{};
+			LoadOp depthLoadOp{ LoadOp::eClear };
+			StoreOp depthStoreOp{ StoreOp::eDontCare };
+		};
+
+		auto add_pass(std::string_view passName) -> RenderGraphPass&;
+		void execute_pass(CommandListHandle commandListHandle, std::size_t pass);
+
+		auto hash_structure() const -> std::size_t;
+		bool plan_passes();
+
+		auto get_transient_texture_info(std::uint32_t index) const -> TextureInfo;
+		auto get_texture_handle(std::uint64_t texture) const -> TextureHandle;
+		bool create_transient_textures();
+		void destroy_transient_textures();
+
+		DeviceHandle m_deviceHandle{};
+		std::uint32_t m_width{ 0 };
+		std::uint32_t m_height{ 0 };
+
+		std::vector<std::unique_ptr<RenderGraphPass>> m_passStorage; // Reused by the passes declared after reset().
+		std::vector<RenderGraphPass*> m_passes;						 // In declaration order, which decides the order of reads and writes.
+		std::vector<std::uint64_t> m_exports;	// Keyed like RenderGraphPass::TextureAccess::texture.
+
+		bool m_compiled{ false };
+		std::size_t m_structureHash{ 0 };
+		std::size_t m_transientHash{ 0 };
+
+		std::vector<std::size_t> m_executionOrder; // Indices into m_passes. Should be decided by the end of compilation. Excludes culled passes.
+		std::vector<std::vector<Transition>> m_transitions; // Before each pass, by execution order.
+		std::vector<std::optional<RenderPass>> m_renderPasses; // By execution order, for passes with attachments.
+		std::vector<std::vector<Transition>> m_splitBegins;	   // Split transitions begun after each pass, by execution order.
+		std::vector<Transition> m_returns;					// Textures from outside the graph handed back to its queue after the last pass.
+
+		std::vector<TextureInfo> m_transientTextureInfos;
+		std::vector<TextureLifetime> m_transientLifetimes; // By execution order.
+		std::vector<TextureHandle> m_transientTextures;	   // Created by compile().
 
-		std::vector<RenderGraphPass*> m_executionOrder; // Should be decided by the end of compilation.
+		std::unique_ptr<WorkerPool> m_recordingPool; // Of set_recording_threads().
+		TaskScheduler* m_taskScheduler{ nullptr };	 // m_recordingPool, or set_task_scheduler()'s.
 	};
 
 } // namespace sm::gfx
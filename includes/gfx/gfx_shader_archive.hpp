@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#ifndef GFX_GFX_SHADER_ARCHIVE_HPP
+#define GFX_GFX_SHADER_ARCHIVE_HPP
+
+#include "gfx.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+// A binary shader container: many SPIR-V modules baked once with write_shader_archive(), each with its name, the stage and
+// entry point its SPIR-V declares, and its hash_shader_code(). A ShaderArchive memory-maps it, and get_code() returns
+// views of the code to put straight in pipeline infos, so loading thousands of shaders is one file mapping rather than a
+// read and a copy each, and the pipeline and shader module caches key them by the stored hash without reading the code:
+//
+//   const auto* entry = shaderArchive.find("triangle.vert");
+//   pipelineInfo.vertexCode = shaderArchive.get_code(*entry);
+//
+// The file is a ShaderArchiveHeader followed by the entries sorted by name, the names and entry points, then the code of
+// each entry starting at a multiple of SHADER_ARCHIVE_ALIGNMENT. Values are little endian.
+namespace sm::gfx
+{
+	constexpr std::uint32_t SHADER_ARCHIVE_MAGIC = 0x52414853; // "SHAR"
+	constexpr std::uint32_t SHADER_ARCHIVE_VERSION = 1;
+	constexpr std::uint64_t SHADER_ARCHIVE_ALIGNMENT = 16;
+
+	struct ShaderArchiveHeader
+	{
+		std::uint32_t magic;
+		std::uint32_t version;
+		std::uint32_t entryCount;
+		std::uint32_t stringSize;	// Bytes of the names and entry points.
+		std::uint64_t entryOffset;	// From the start of the file.
+		std::uint64_t stringOffset; // Null terminated strings, referred to by offset from here.
+	};
+	static_assert(sizeof(ShaderArchiveHeader) == 32);
+
+	struct ShaderArchiveEntry
+	{
+		std::uint64_t codeOffset;  // From the start of the file.
+		std::uint64_t contentHash; // hash_shader_code() of the code.
+		std::uint32_t codeSize;	   // In words.
+		std::uint32_t nameOffset;
+		std::uint32_t nameLength;
+		std::uint32_t entryPointOffset; // Of the first entry point the SPIR-V declares.
+		std::uint32_t entryPointLength;
+		std::uint32_t shaderStage; // The ShaderStageFlags_ of that entry point, 0 for stages gfx has no pipelines for.
+	};
+	static_assert(sizeof(ShaderArchiveEntry) == 40);
+
+	struct ShaderArchiveSource
+	{
+		std::string_view name; // Unique within the archive.
+		std::span<const std::uint32_t> code;
+	};
+
+	/**
+	 * @brief Bake shaders into an archive, reflecting the stage and entry point of each from its SPIR-V.
+	 * @return False if two shaders share a name, one is not SPIR-V, or the file cannot be written.
+	 */
+	bool write_shader_archive(const char* filename, std::span<const ShaderArchiveSource> shaders);
+
+	/**
+	 * @brief A shader archive mapped read only into memory, for as long as the ShaderArchive is open. Code from get_code()
+	 * views the mapping, so the archive must stay open while pipelines created with it exist.
+	 */
+	class ShaderArchive
+	{
+	public:
+		ShaderArchive() = default;
+		~ShaderArchive();
+
+		GFX_DISABLE_COPY(ShaderArchive);
+
+		/**
+		 * @brief Map a file from write_shader_archive(), closing any open one first.
+		 * @return False if the file cannot be mapped, or is not a shader archive of this version.
+		 */
+		bool open(const char* filename);
+		void close();
+
+		bool is_open() const { return m_data != nullptr; }
+		auto get_header() const -> const ShaderArchiveHeader& { return *static_cast<const ShaderArchiveHeader*>(m_data); }
+		auto get_entries() const -> std::span<const ShaderArchiveEntry>;
+		// Binary search by name. Null if the archive has no such shader.
+		auto find(std::string_view name) const -> const ShaderArchiveEntry*;
+
+		auto get_name(const ShaderArchiveEntry& entry) const -> std::string_view;
+		// Null terminated, eg. for ComputePipelineInfo::entryPoint.
+		auto get_entry_point(const ShaderArchiveEntry& entry) const -> std::string_view;
+		// A view of the mapped code with its stored hash.
+		auto get_code(const ShaderArchiveEntry& entry) const -> ShaderCode;
+
+	private:
+		void* m_data{ nullptr };
+		std::uint64_t m_size{ 0 };
+	};
+
+} // namespace sm::gfx
+
+#endif // GFX_GFX_SHADER_ARCHIVE_HPP
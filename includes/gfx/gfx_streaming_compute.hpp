@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#ifndef GFX_GFX_STREAMING_COMPUTE_HPP
+#define GFX_GFX_STREAMING_COMPUTE_HPP
+
+#include "gfx.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+// Streaming compute, for GPGPU batch jobs over more data than fits in VRAM. The input is cut into chunks, each going through
+// one of a ring of slots in three stages: a copy up to the GPU on an upload (ideally transfer) queue, the dispatches on a
+// compute queue, and a copy of the output back to the CPU after them. Stages wait for each other on the GPU through the queues'
+// timeline semaphores, so while one chunk computes the next is uploaded and the one before is read back, and throughput
+// approaches the slower of the bus and the shaders rather than their sum, unlike mapping, dispatching and waiting in turn:
+//
+//   StreamingCompute streaming(deviceHandle, { .pipeline = pipeline, .inputChunkSize = 64 << 20, .outputChunkSize = 64 << 20,
+//       .uploadQueueIndex = transferQueue, .computeQueueIndex = computeQueue, .record = recordChunk, .consume = consumeChunk });
+//   for (const auto& chunk : chunks)
+//       streaming.submit(chunk);
+//   streaming.flush();
+//
+// The pipeline's set 0 is bound to each chunk, with its input as binding 0 and its output as binding 1, both storage buffers.
+namespace sm::gfx
+{
+	struct StreamingChunk
+	{
+		std::uint64_t index{ 0 }; // Counts up from 0 with each submit().
+		std::uint64_t inputSize{ 0 };
+		std::uint64_t outputSize{ 0 };
+	};
+
+	struct StreamingComputeInfo
+	{
+		PipelineHandle pipeline{};
+		std::uint64_t inputChunkSize{ 0 };	// The most input of one chunk.
+		std::uint64_t outputChunkSize{ 0 }; // The most output of one chunk.
+		std::uint32_t slotCount{ 3 };		// Chunks in flight at once. Three keeps every stage busy, more absorbs uneven chunks.
+		// The same queue for both runs the stages of a chunk in one submission, so only separate chunks overlap.
+		std::uint32_t uploadQueueIndex{ 0 };
+		std::uint32_t computeQueueIndex{ 0 };
+		/**
+		 * Records a chunk's dispatches, with the pipeline and its set 0 already bound. The output is read back after them.
+		 */
+		std::function<void(CommandListHandle commandListHandle, const StreamingChunk& chunk)> record;
+		/**
+		 * Receives each chunk's output once it is back, in submission order, on the thread calling submit() or flush().
+		 */
+		std::function<void(const StreamingChunk& chunk, std::span<const std::byte> output)> consume;
+	};
+
+	/**
+	 * @brief A ring of slots streaming chunks through a compute pipeline. Not thread safe.
+	 */
+	class StreamingCompute
+	{
+	public:
+		StreamingCompute(DeviceHandle deviceHandle, const StreamingComputeInfo& streamingInfo);
+		~StreamingCompute();
+
+		GFX_DISABLE_COPY(StreamingCompute);
+
+		bool is_valid() const;
+
+		/**
+		 * @brief Claim the next slot for a chunk, and get its staging memory to write the input into directly, saving the copy
+		 * submit() makes. When every slot is in flight, waits for the oldest and consumes its output first.
+		 * @return inputChunkSize bytes of mapped memory, valid until submit_chunk(). Empty on failure.
+		 */
+		auto begin_chunk() -> std::span<std::byte>;
+		/**
+		 * @brief Upload, compute and read back the chunk claimed by begin_chunk().
+		 * @param inputSize Bytes of input written, at most inputChunkSize.
+		 * @param outputSize Bytes of output read back, at most outputChunkSize. WHOLE_SIZE for outputChunkSize.
+		 */
+		bool submit_chunk(std::uint64_t inputSize, std::uint64_t outputSize = WHOLE_SIZE);
+		/**
+		 * @brief begin_chunk(), a copy of input, then submit_chunk().
+		 */
+		bool submit(std::span<const std::byte> input, std::uint64_t outputSize = WHOLE_SIZE);
+
+		/**
+		 * @brief Wait for every chunk in flight, and consume their output.
+		 */
+		void flush();
+
+		// Chunks submitted whose output has not been consumed yet.
+		auto get_pending_count() const -> std::uint32_t;
+
+	private:
+		struct Slot
+		{
+			BufferHandle stagingBuffer{}; // Written by the CPU.
+			BufferHandle inputBuffer{};
+			BufferHandle outputBuffer{};
+			BufferHandle readbackBuffer{};
+			std::byte* stagingPtr{ nullptr };
+			DescriptorSetHandle descriptorSet{};
+			CommandListHandle uploadCommandList{}; // Only with separate upload and compute queues.
+			CommandListHandle computeCommandList{};
+			ReadbackHandle readbackHandle{};
+			StreamingChunk chunk{};
+		};
+
+		bool create_slot(Slot& slot);
+		void destroy_slot(Slot& slot);
+		// Wait for the slot's chunk to be read back, then consume it.
+		bool complete_slot(Slot& slot);
+
+		DeviceHandle m_deviceHandle;
+		StreamingComputeInfo m_info;
+		bool m_separateUpload{ false };
+		bool m_valid{ false };
+
+		std::vector<Slot> m_slots;
+		std::uint32_t m_nextSlot{ 0 };
+		bool m_chunkBegun{ false };
+		std::uint64_t m_nextChunkIndex{ 0 };
+	};
+
+} // namespace sm::gfx
+
+#endif // GFX_GFX_STREAMING_COMPUTE_HPP
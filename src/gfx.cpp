@@ -5,9 +5,18 @@
 #include "gfx/gfx.hpp"
 #include "gfx_p.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <memory>
 #include <utility>
 #include <functional>
+#include <future>
+#include <limits>
+#include <numeric>
 #include <string_view>
 
 #include <vulkan/vulkan.hpp>
@@ -16,19 +25,45 @@ VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE; // NOLINT
 
 namespace sm::gfx
 {
-	static std::function<void(const char* msg)> s_errorCallback; // NOLINT
-	static std::unique_ptr<Context> s_context;					 // NOLINT
+	/**
+	 * @brief The error callback, swappable while other threads report errors through it.
+	 */
+	class ErrorCallback
+	{
+	public:
+		void set(std::function<void(const char* msg)>&& callback)
+		{
+			m_callback.store(callback ? std::make_shared<const std::function<void(const char* msg)>>(std::move(callback)) : nullptr, std::memory_order_release);
+		}
+
+		void operator()(const char* msg) const
+		{
+			if (const auto callback = m_callback.load(std::memory_order_acquire))
+			{
+				(*callback)(msg);
+			}
+		}
+
+	private:
+		std::atomic<std::shared_ptr<const std::function<void(const char* msg)>>> m_callback{};
+	};
+
+	static ErrorCallback s_errorCallback;	   // NOLINT
+	static std::unique_ptr<Context> s_context; // NOLINT
+	// The background thread of initialise_async(), and what it made, which only it touches until the future is ready.
+	static std::future<bool> s_asyncInitialise;			  // NOLINT
+	static AsyncInitialiseResult s_asyncInitialiseResult; // NOLINT
 
 #pragma region Public Header
 
 	void set_error_callback(std::function<void(const char* msg)> callback)
 	{
-		s_errorCallback = std::move(callback);
+		s_errorCallback.set(std::move(callback));
 	}
 
 	bool initialise(const AppInfo& appInfo)
 	{
-		if (s_context != nullptr)
+		if (s_context != nullptr || s_asyncInitialise.valid())
 		{
 			return false;
 		}
@@ -45,9 +80,68 @@ namespace sm::gfx
 
 	void shutdown()
 	{
+		if (s_asyncInitialise.valid())
+		{
+			s_asyncInitialise.wait();
+			s_asyncInitialise = {};
+			s_asyncInitialiseResult = {};
+		}
 		s_context = nullptr;
 	}
 
+	bool initialise_async(const AppInfo& appInfo, const DeviceInfo& deviceInfo, std::string prewarmManifestPath)
+	{
+		if (s_context != nullptr || s_asyncInitialise.valid())
+		{
+			return false;
+		}
+
+		// The caller makes no other calls until the future is ready, so the thread has the globals to itself, and runs the
+		// same public functions as a synchronous start would.
+		s_asyncInitialise = std::async(std::launch::async, [appInfo, deviceInfo, prewarmManifestPath = std::move(prewarmManifestPath)] {
+			GFX_PROFILE_ZONE("gfx::initialise_async");
+			// Not initialise(), which refuses to run while the future is pending.
+			s_asyncInitialiseResult = {};
+			s_context = std::make_unique<Context>(appInfo);
+			if (!s_context->is_valid())
+			{
+				s_context = nullptr;
+				return false;
+			}
+			if (!create_device(s_asyncInitialiseResult.deviceHandle, deviceInfo))
+			{
+				s_context = nullptr;
+				return false;
+			}
+			if (!prewarmManifestPath.empty())
+			{
+				prewarm_pipelines(s_asyncInitialiseResult.prewarmedPipelines, s_asyncInitialiseResult.deviceHandle, prewarmManifestPath.c_str());
+			}
+			return true;
+		});
+		return true;
+	}
+
+	bool wait_for_initialise(AsyncInitialiseResult& outResult, std::uint64_t timeoutNs)
+	{
+		if (!s_asyncInitialise.valid())
+		{
+			s_errorCallback("GFX - wait_for_initialise() - There is no initialise_async() to wait for!");
+			return false;
+		}
+		if (timeoutNs != INFINITE_TIMEOUT && s_asyncInitialise.wait_for(std::chrono::nanoseconds(timeoutNs)) != std::future_status::ready)
+		{
+			return false;
+		}
+
+		if (!s_asyncInitialise.get())
+		{
+			GFX_LOG_ERR("GFX - Failed to initialise asynchronously!");
+		}
+		outResult = std::exchange(s_asyncInitialiseResult, {});
+		return true;
+	}
+
 	bool create_device(DeviceHandle& outDeviceHandle, const DeviceInfo& deviceInfo)
 	{
 		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
@@ -82,291 +176,134 @@ namespace sm::gfx
 		}
 		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		device->get_device().waitIdle();
+		GFX_CAPTURE(device, eWaitForDeviceIdle);
+		device->wait_for_idle();
 	}
 
-#pragma endregion
-
-#pragma region Utility
-
-	static const std::unordered_map<TextureState, vk::ImageLayout> s_textureStateImageLayoutMap{
-		{ TextureState::eUndefined, vk::ImageLayout::eUndefined },
-		{ TextureState::eUploadDst, vk::ImageLayout::eTransferDstOptimal },
-		{ TextureState::eShaderRead, vk::ImageLayout::eShaderReadOnlyOptimal },
-		{ TextureState::eRenderTarget, vk::ImageLayout::eAttachmentOptimal },
-		{ TextureState::ePresent, vk::ImageLayout::ePresentSrcKHR },
-	};
-	static const std::unordered_map<TextureState, vk::PipelineStageFlagBits2> s_barrierTextureStatePipelineStageMaskMap{
-		{ TextureState::eUndefined, vk::PipelineStageFlagBits2::eTopOfPipe },
-		{ TextureState::eUploadDst, vk::PipelineStageFlagBits2::eTransfer },
-		{ TextureState::eShaderRead, vk::PipelineStageFlagBits2::eFragmentShader },
-		{ TextureState::eRenderTarget, vk::PipelineStageFlagBits2::eColorAttachmentOutput },
-		{ TextureState::ePresent, vk::PipelineStageFlagBits2::eBottomOfPipe },
-	};
-	static const std::unordered_map<TextureState, vk::AccessFlagBits2> s_barrierTextureStateAccessMaskMap{
-		{ TextureState::eUndefined, vk::AccessFlagBits2::eNone },
-		{ TextureState::eUploadDst, vk::AccessFlagBits2::eTransferWrite },
-		{ TextureState::eShaderRead, vk::AccessFlagBits2::eShaderRead },
-		{ TextureState::eRenderTarget, vk::AccessFlagBits2::eColorAttachmentWrite },
-		{ TextureState::ePresent, vk::AccessFlagBits2::eNone },
-	};
-
-	auto convert_shader_stages_to_vk_shader_stage_flags(std::uint32_t shaderStages) -> vk::ShaderStageFlags
+	bool save_pipeline_cache(DeviceHandle deviceHandle)
 	{
-		vk::ShaderStageFlags stageFlags{};
-		if (shaderStages & ShaderStageFlags_Compute)
-		{
-			stageFlags |= vk::ShaderStageFlagBits::eCompute;
-		}
-		if (shaderStages & ShaderStageFlags_Vertex)
-		{
-			stageFlags |= vk::ShaderStageFlagBits::eVertex;
-		}
-		if (shaderStages & ShaderStageFlags_Fragment)
-		{
-			stageFlags |= vk::ShaderStageFlagBits::eFragment;
-		}
-		// #TODO: Convert other shader stages.
-		return stageFlags;
-	}
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
 
-	auto convert_format_to_vk_format(Format format) -> vk::Format
-	{
-		switch (format)
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
 		{
-			case Format::eUndefined:
-				return vk::Format::eUndefined;
-			case Format::eR8:
-				return vk::Format::eR8Unorm;
-			case Format::eRG8:
-				return vk::Format::eR8G8Unorm;
-			case Format::eRG32:
-				return vk::Format::eR32G32Sfloat;
-			case Format::eRGB8:
-				return vk::Format::eR8G8B8Unorm;
-			case Format::eRGB32:
-				return vk::Format::eR32G32B32Sfloat;
-			case Format::eRGBA8:
-				return vk::Format::eR8G8B8A8Unorm;
-			case Format::eRGBA32:
-				return vk::Format::eR32G32B32A32Sfloat;
-			case Format::eDepth16:
-				return vk::Format::eD16Unorm;
-			case Format::eBGRA8:
-				return vk::Format::eB8G8R8A8Srgb;
-			case Format::eDepth24Stencil8:
-				return vk::Format::eD24UnormS8Uint;
-			case Format::eDepth32:
-				return vk::Format::eD32Sfloat;
-			case Format::eDepth32Stencil8:
-				return vk::Format::eD32SfloatS8Uint;
-			default:
-				GFX_ASSERT(false, "Cannot convert unknown Format to vk::Format!");
-				break;
+			s_errorCallback("gfx::save_pipeline_cache() - deviceHandle must be valid!");
+			return false;
 		}
-		return vk::Format::eUndefined;
-	}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-	auto convert_format_to_byte_size(Format format) -> std::uint32_t
-	{
-		switch (format)
-		{
-			case Format::eUndefined:
-				return 0;
-			case Format::eRG8:
-				return 1 * 2;
-			case Format::eRGB8:
-				return 1 * 3;
-			case Format::eRGBA8:
-				return 1 * 4;
-			case Format::eRG32:
-				return 4 * 2;
-			case Format::eRGB32:
-				return 4 * 3;
-			case Format::eRGBA32:
-				return 4 * 4;
-			default:
-				GFX_ASSERT(false, "Cannot convert unknown Format to byte size!");
-				break;
-		}
-		return 0;
+		return device->save_pipeline_cache();
 	}
 
-	auto convert_descriptor_type_to_vk_descriptor_type(DescriptorType descriptorType) -> vk::DescriptorType
+	bool get_device_properties(DeviceProperties& outDeviceProperties, DeviceHandle deviceHandle)
 	{
-		switch (descriptorType)
-		{
-			case DescriptorType::eStorageBuffer:
-				return vk::DescriptorType::eStorageBuffer;
-			case DescriptorType::eUniformBuffer:
-				return vk::DescriptorType::eUniformBuffer;
-			case DescriptorType::eTexture:
-				return vk::DescriptorType::eCombinedImageSampler;
-			default:
-				GFX_ASSERT(false, "Cannot convert unknown DescriptorType to vk::DescriptorType!");
-				break;
-		}
-		return {};
-	}
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
 
-	auto convert_buffer_type_to_vk_usage(BufferType bufferType) -> vk::BufferUsageFlags
-	{
-		switch (bufferType)
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
 		{
-			case BufferType::eVertex:
-				return vk::BufferUsageFlagBits::eVertexBuffer;
-			case BufferType::eIndex:
-				return vk::BufferUsageFlagBits::eIndexBuffer;
-			case BufferType::eUniform:
-				return vk::BufferUsageFlagBits::eUniformBuffer;
-			case BufferType::eStorage:
-				return vk::BufferUsageFlagBits::eStorageBuffer;
-			case BufferType::eUpload:
-				return vk::BufferUsageFlagBits::eTransferSrc;
-			default:
-				GFX_ASSERT(false, "Cannot convert unknown BufferType to vk::BufferUsageFlags!");
-				break;
+			s_errorCallback("gfx::get_device_properties() - deviceHandle must be valid!");
+			return false;
 		}
-		return {};
-	}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-	auto convert_buffer_type_to_descriptor_type(BufferType bufferType) -> vk::DescriptorType
-	{
-		switch (bufferType)
-		{
-			case BufferType::eUniform:
-				return vk::DescriptorType::eUniformBuffer;
-			case BufferType::eStorage:
-				return vk::DescriptorType::eStorageBuffer;
-			case BufferType::eVertex:
-			case BufferType::eIndex:
-			case BufferType::eUpload:
-				break; // These buffer types cannot be used in descriptors.
-			default:
-				GFX_ASSERT(false, "Cannot convert unknown BufferType to vk::DescriptorType!");
-				break;
-		}
-		return {};
+		outDeviceProperties = device->get_properties();
+		return true;
 	}
 
-	auto convert_texture_type_to_vk_image_type(TextureType textureType) -> vk::ImageType
+	auto get_task_scheduler(DeviceHandle deviceHandle) -> TaskScheduler*
 	{
-		switch (textureType)
-		{
-			case TextureType::e1D:
-				return vk::ImageType::e1D;
-			case TextureType::e2D:
-				return vk::ImageType::e2D;
-			case TextureType::e3D:
-				return vk::ImageType::e3D;
-			default:
-				GFX_ASSERT(false, "Cannot convert unknown TextureType to vk::ImageType!");
-				break;
-		}
-		return {};
-	}
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
 
-	auto convert_texture_usage_to_vk_image_usage(TextureUsage textureUsage) -> vk::ImageUsageFlags
-	{
-		switch (textureUsage)
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
 		{
-			case TextureUsage::eTexture:
-				return vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
-			case TextureUsage::eColorAttachment:
-				return vk::ImageUsageFlagBits::eColorAttachment;
-			case TextureUsage::eDepthStencilAttachment:
-				return vk::ImageUsageFlagBits::eDepthStencilAttachment;
-			default:
-				GFX_ASSERT(false, "Cannot convert unknown TextureUsage to vk::ImageUsageFlags!");
-				break;
+			s_errorCallback("gfx::get_task_scheduler() - deviceHandle must be valid!");
+			return nullptr;
 		}
-		return {};
-	}
-
-#pragma endregion
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-#pragma region Device Resources
+		return &device->get_task_scheduler();
+	}
 
-	void wait_on_fence(FenceHandle fenceHandle)
+	bool is_vertex_format_supported(DeviceHandle deviceHandle, Format format)
 	{
 		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
 
 		Device* device{ nullptr };
-		if (!s_context->get_device(device, fenceHandle.deviceHandle))
+		if (!s_context->get_device(device, deviceHandle))
 		{
-			s_errorCallback("gfx::wait_on_fence() - fenceHandle must be valid!");
-			return;
+			s_errorCallback("gfx::is_vertex_format_supported() - deviceHandle must be valid!");
+			return false;
 		}
 		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		device->wait_on_fence(fenceHandle);
+		return device->is_vertex_format_supported(convert_format_to_vk_format(format));
 	}
 
-	void destroy_semaphore(SemaphoreHandle semaphoreHandle)
+	void begin_frame(DeviceHandle deviceHandle)
 	{
 		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
 
 		Device* device{ nullptr };
-		if (!s_context->get_device(device, semaphoreHandle.deviceHandle))
+		if (!s_context->get_device(device, deviceHandle))
 		{
-			s_errorCallback("gfx::destroy_semaphore() - semaphoreHandle must be valid!");
+			s_errorCallback("gfx::begin_frame() - deviceHandle must be valid!");
 			return;
 		}
 		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		device->destroy_semaphore(semaphoreHandle);
+		GFX_CAPTURE(device, eBeginFrame);
+		device->begin_frame();
 	}
 
-	bool create_command_list(CommandListHandle& outCommandListHandle, DeviceHandle deviceHandle, std::uint32_t queueIndex)
+	void end_frame(DeviceHandle deviceHandle)
 	{
 		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
 
 		Device* device{ nullptr };
 		if (!s_context->get_device(device, deviceHandle))
 		{
-			return false;
+			s_errorCallback("gfx::end_frame() - deviceHandle must be valid!");
+			return;
 		}
 		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		return device->create_command_list(outCommandListHandle, queueIndex);
-	}
-
-	void destroy_command_list(DeviceHandle deviceHandle, CommandListHandle commandListHandle)
-	{
+		GFX_CAPTURE(device, eEndFrame);
+		device->end_frame();
 	}
 
-	void submit_command_list(const SubmitInfo& submitInfo, FenceHandle* outFenceHandle, SemaphoreHandle* outSemaphoreHandle)
+	auto allocate_transient(DeviceHandle deviceHandle, std::uint64_t size, std::uint64_t alignment) -> TransientAllocation
 	{
 		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
 
 		Device* device{ nullptr };
-		if (!s_context->get_device(device, submitInfo.commandList.deviceHandle))
+		if (!s_context->get_device(device, deviceHandle))
 		{
-			return;
+			return {};
 		}
 		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		device->submit_command_list(submitInfo, outFenceHandle, outSemaphoreHandle);
+		return device->allocate_transient(size, alignment);
 	}
 
-	bool create_compute_pipeline(PipelineHandle& outPipelineHandle, DeviceHandle deviceHandle, const ComputePipelineInfo& computePipelineInfo)
+	bool begin_defragmentation(DeviceHandle deviceHandle, const DefragmentationInfo& defragmentationInfo)
 	{
 		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
 
 		Device* device{ nullptr };
 		if (!s_context->get_device(device, deviceHandle))
 		{
+			s_errorCallback("gfx::begin_defragmentation() - deviceHandle must be valid!");
 			return false;
 		}
 		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		return device->create_compute_pipeline(outPipelineHandle, computePipelineInfo);
+		return device->get_defragmenter().begin(defragmentationInfo);
 	}
 
-	bool create_graphics_pipeline(PipelineHandle& outPipelineHandle, DeviceHandle deviceHandle, const GraphicsPipelineInfo& graphicsPipelineInfo)
+	bool step_defragmentation(DeviceHandle deviceHandle)
 	{
-		GFX_ASSERT(graphicsPipelineInfo.vertexCode.empty() == false, "Graphics pipeline requires Vertex shader byte code!");
-		GFX_ASSERT(graphicsPipelineInfo.fragmentCode.empty() == false, "Graphics pipeline requires Vertex shader byte code!");
 		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
 
 		Device* device{ nullptr };
@@ -376,1809 +313,19464 @@ namespace sm::gfx
 		}
 		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		return device->create_graphics_pipeline(outPipelineHandle, graphicsPipelineInfo);
-	}
-
-	void destroy_pipeline(PipelineHandle pipelineHandle)
-	{
+		return device->get_defragmenter().step();
 	}
 
-	bool create_descriptor_set(DescriptorSetHandle& outDescriptorSetHandle, DeviceHandle deviceHandle, const DescriptorSetInfo& setInfo)
+	void end_defragmentation(DeviceHandle deviceHandle)
 	{
 		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
 
 		Device* device{ nullptr };
 		if (!s_context->get_device(device, deviceHandle))
 		{
-			return false;
+			return;
 		}
 		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		return device->create_descriptor_set(outDescriptorSetHandle, setInfo);
+		device->get_defragmenter().end();
 	}
 
-	bool create_descriptor_set_from_pipeline(DescriptorSetHandle& outDescriptorSetHandle, PipelineHandle pipelineHandle, std::uint32_t set)
+	bool get_memory_stats(MemoryStats& outMemoryStats, DeviceHandle deviceHandle)
 	{
 		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
 
 		Device* device{ nullptr };
-		if (!s_context->get_device(device, pipelineHandle.deviceHandle))
+		if (!s_context->get_device(device, deviceHandle))
 		{
+			s_errorCallback("gfx::get_memory_stats() - deviceHandle must be valid!");
 			return false;
 		}
 		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		return device->create_descriptor_set_from_pipeline(outDescriptorSetHandle, pipelineHandle, set);
+		device->get_memory_stats(outMemoryStats);
+		return true;
 	}
 
-	void bind_buffer_to_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, BufferHandle bufferHandle)
+	bool dump_memory_report(DeviceHandle deviceHandle, std::string_view path)
 	{
 		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
-		if (descriptorSetHandle.deviceHandle != bufferHandle.deviceHandle)
-		{
-			s_errorCallback("GFX - Buffer must belong to the same device as the descriptor set it is to be bound too!");
-			return;
-		}
 
 		Device* device{ nullptr };
-		if (!s_context->get_device(device, descriptorSetHandle.deviceHandle))
+		if (!s_context->get_device(device, deviceHandle))
 		{
-			return;
+			s_errorCallback("gfx::dump_memory_report() - deviceHandle must be valid!");
+			return false;
 		}
 		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		device->bind_buffer_to_descriptor_set(descriptorSetHandle, binding, bufferHandle);
+		return device->dump_memory_report(path);
 	}
 
-	void bind_texture_to_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, TextureHandle textureHandle, SamplerHandle samplerHandle)
+	bool set_memory_priority(BufferHandle bufferHandle, float memoryPriority)
 	{
 		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
-		if (descriptorSetHandle.deviceHandle != textureHandle.deviceHandle)
-		{
-			s_errorCallback("GFX - Buffer must belong to the same device as the descriptor set it is to be bound too!");
-			return;
-		}
-		if (descriptorSetHandle.deviceHandle != samplerHandle.deviceHandle)
-		{
-			s_errorCallback("GFX - Sampler must belong to the same device as the descriptor set it is to be bound too!");
-			return;
-		}
 
 		Device* device{ nullptr };
-		if (!s_context->get_device(device, descriptorSetHandle.deviceHandle))
+		if (!s_context->get_device(device, bufferHandle.deviceHandle))
 		{
-			return;
+			s_errorCallback("gfx::set_memory_priority() - bufferHandle must be valid!");
+			return false;
 		}
 		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		device->bind_texture_to_descriptor_set(descriptorSetHandle, binding, textureHandle, samplerHandle);
+		return device->set_memory_priority(bufferHandle, memoryPriority);
 	}
 
-	bool create_buffer(BufferHandle& outBufferHandle, DeviceHandle deviceHandle, const BufferInfo& bufferInfo)
+	bool set_memory_priority(TextureHandle textureHandle, float memoryPriority)
 	{
 		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
 
 		Device* device{ nullptr };
-		if (!s_context->get_device(device, deviceHandle))
+		if (!s_context->get_device(device, textureHandle.deviceHandle))
 		{
+			s_errorCallback("gfx::set_memory_priority() - textureHandle must be valid!");
 			return false;
 		}
 		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		return device->create_buffer(outBufferHandle, bufferInfo);
+		return device->set_memory_priority(textureHandle, memoryPriority);
 	}
 
-	void destroy_buffer(BufferHandle bufferHandle)
-	{
-	}
-
-	bool map_buffer(BufferHandle bufferHandle, void*& outBufferPtr)
+	bool get_gpu_scope_timings(GpuScopeTimings& outTimings, DeviceHandle deviceHandle)
 	{
 		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
 
 		Device* device{ nullptr };
-		if (!s_context->get_device(device, bufferHandle.deviceHandle))
+		if (!s_context->get_device(device, deviceHandle))
 		{
+			s_errorCallback("gfx::get_gpu_scope_timings() - deviceHandle must be valid!");
 			return false;
 		}
 		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		return device->map_buffer(bufferHandle, outBufferPtr);
+		device->get_gpu_scope_timings(outTimings);
+		return true;
 	}
 
-	void unmap_buffer(BufferHandle bufferHandle)
+	bool get_gpu_query_results(GpuQueryResults& outResults, DeviceHandle deviceHandle)
 	{
 		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
 
 		Device* device{ nullptr };
-		if (!s_context->get_device(device, bufferHandle.deviceHandle))
+		if (!s_context->get_device(device, deviceHandle))
 		{
-			return;
+			s_errorCallback("gfx::get_gpu_query_results() - deviceHandle must be valid!");
+			return false;
 		}
 		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		device->unmap_buffer(bufferHandle);
+		device->get_gpu_query_results(outResults);
+		return true;
 	}
 
-	bool create_texture(TextureHandle& outTextureHandle, DeviceHandle deviceHandle, const TextureInfo& textureInfo)
+	bool get_frame_stats(FrameStats& outStats, DeviceHandle deviceHandle)
 	{
 		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
 
+#if GFX_FRAME_STATS_ENABLED
 		Device* device{ nullptr };
 		if (!s_context->get_device(device, deviceHandle))
 		{
+			s_errorCallback("gfx::get_frame_stats() - deviceHandle must be valid!");
 			return false;
 		}
 		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		return device->create_texture(outTextureHandle, textureInfo);
-	}
-
-	void destroy_texture(TextureHandle textureHandle)
-	{
+		device->get_frame_stats(outStats);
+		return true;
+#else
+		GFX_UNUSED(outStats);
+		GFX_UNUSED(deviceHandle);
+		s_errorCallback("gfx::get_frame_stats() - gfx was built without the gfx_ENABLE_FRAME_STATS option!");
+		return false;
+#endif
 	}
 
-	bool create_sampler(SamplerHandle& outSamplerHandle, DeviceHandle deviceHandle, const SamplerInfo& samplerInfo)
+	bool begin_capture(DeviceHandle deviceHandle, std::string_view path)
 	{
 		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
 
+#if GFX_CAPTURE_ENABLED
 		Device* device{ nullptr };
 		if (!s_context->get_device(device, deviceHandle))
 		{
+			s_errorCallback("gfx::begin_capture() - deviceHandle must be valid!");
 			return false;
 		}
 		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		return device->create_sampler(outSamplerHandle, samplerInfo);
-	}
-
-	void destroy_sampler(SamplerHandle samplerHandle)
-	{
+		return device->begin_capture(path);
+#else
+		GFX_UNUSED(deviceHandle);
+		GFX_UNUSED(path);
+		s_errorCallback("gfx::begin_capture() - gfx was built without the gfx_ENABLE_CAPTURE option!");
+		return false;
+#endif
 	}
 
-	bool create_swap_chain(SwapChainHandle& outSwapChainHandle, DeviceHandle deviceHandle, const SwapChainInfo& swapChainInfo)
+	bool end_capture(DeviceHandle deviceHandle)
 	{
 		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
 
+#if GFX_CAPTURE_ENABLED
 		Device* device{ nullptr };
 		if (!s_context->get_device(device, deviceHandle))
 		{
+			s_errorCallback("gfx::end_capture() - deviceHandle must be valid!");
 			return false;
 		}
 		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		return device->create_swap_chain(outSwapChainHandle, swapChainInfo);
+		return device->end_capture();
+#else
+		GFX_UNUSED(deviceHandle);
+		s_errorCallback("gfx::end_capture() - gfx was built without the gfx_ENABLE_CAPTURE option!");
+		return false;
+#endif
 	}
 
-	void destroy_swap_chain(SwapChainHandle swapChainHandle)
-	{
-	}
+#pragma endregion
 
-	void present_swap_chain(SwapChainHandle swapChainHandle, std::uint32_t queueIndex, SemaphoreHandle* waitSemaphore)
-	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+#pragma region Utility
 
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, swapChainHandle.deviceHandle))
+	static const std::unordered_map<TextureState, vk::ImageLayout> s_textureStateImageLayoutMap{
+		{ TextureState::eUndefined, vk::ImageLayout::eUndefined },
+		{ TextureState::eUploadDst, vk::ImageLayout::eTransferDstOptimal },
+		{ TextureState::eCopySrc, vk::ImageLayout::eTransferSrcOptimal },
+		{ TextureState::eShaderRead, vk::ImageLayout::eShaderReadOnlyOptimal },
+		{ TextureState::eRenderTarget, vk::ImageLayout::eAttachmentOptimal },
+		{ TextureState::ePresent, vk::ImageLayout::ePresentSrcKHR },
+		{ TextureState::eShadingRate, vk::ImageLayout::eFragmentShadingRateAttachmentOptimalKHR },
+		{ TextureState::eLocalRead, vk::ImageLayout::eRenderingLocalReadKHR },
+		{ TextureState::eStorage, vk::ImageLayout::eGeneral },
+	};
+	// Stages/accesses that must complete before leaving a state. Read-only states have nothing to make available. Stages
+	// cover every queue that may use a state, barriers are narrowed to those of their queue, see get_queue_supported_stages().
+	static const std::unordered_map<TextureState, vk::PipelineStageFlags2> s_barrierTextureStateSrcStageMaskMap{
+		{ TextureState::eUndefined, vk::PipelineStageFlagBits2::eNone },
+		{ TextureState::eUploadDst, vk::PipelineStageFlagBits2::eAllTransfer }, // Copies and generate_mipmaps() blits.
+		{ TextureState::eCopySrc, vk::PipelineStageFlagBits2::eAllTransfer },
+		{ TextureState::eShaderRead, vk::PipelineStageFlagBits2::eFragmentShader | vk::PipelineStageFlagBits2::eComputeShader },
+		{ TextureState::eRenderTarget, vk::PipelineStageFlagBits2::eColorAttachmentOutput },
+		{ TextureState::ePresent, vk::PipelineStageFlagBits2::eColorAttachmentOutput }, // Stage swapchain acquires are waited on.
+		{ TextureState::eShadingRate, vk::PipelineStageFlagBits2::eFragmentShadingRateAttachmentKHR },
+		{ TextureState::eLocalRead, vk::PipelineStageFlagBits2::eColorAttachmentOutput },
+		{ TextureState::eStorage, vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eFragmentShader },
+	};
+	static const std::unordered_map<TextureState, vk::AccessFlags2> s_barrierTextureStateSrcAccessMaskMap{
+		{ TextureState::eUndefined, vk::AccessFlagBits2::eNone },
+		{ TextureState::eUploadDst, vk::AccessFlagBits2::eTransferWrite },
+		{ TextureState::eCopySrc, vk::AccessFlagBits2::eNone },
+		{ TextureState::eShaderRead, vk::AccessFlagBits2::eNone },
+		{ TextureState::eRenderTarget, vk::AccessFlagBits2::eColorAttachmentWrite },
+		{ TextureState::ePresent, vk::AccessFlagBits2::eNone },
+		{ TextureState::eShadingRate, vk::AccessFlagBits2::eNone },
+		{ TextureState::eLocalRead, vk::AccessFlagBits2::eColorAttachmentWrite },
+		{ TextureState::eStorage, vk::AccessFlagBits2::eShaderStorageWrite },
+	};
+	// Stages/accesses that must wait before entering a state.
+	static const std::unordered_map<TextureState, vk::PipelineStageFlags2> s_barrierTextureStateDstStageMaskMap{
+		{ TextureState::eUndefined, vk::PipelineStageFlagBits2::eNone },
+		{ TextureState::eUploadDst, vk::PipelineStageFlagBits2::eAllTransfer },
+		{ TextureState::eCopySrc, vk::PipelineStageFlagBits2::eAllTransfer },
+		{ TextureState::eShaderRead, vk::PipelineStageFlagBits2::eFragmentShader | vk::PipelineStageFlagBits2::eComputeShader },
+		{ TextureState::eRenderTarget, vk::PipelineStageFlagBits2::eColorAttachmentOutput },
+		{ TextureState::ePresent, vk::PipelineStageFlagBits2::eNone }, // Presentation is ordered by the submit's signal semaphore.
+		{ TextureState::eShadingRate, vk::PipelineStageFlagBits2::eFragmentShadingRateAttachmentKHR },
+		{ TextureState::eLocalRead, vk::PipelineStageFlagBits2::eColorAttachmentOutput | vk::PipelineStageFlagBits2::eFragmentShader },
+		{ TextureState::eStorage, vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eFragmentShader },
+	};
+	static const std::unordered_map<TextureState, vk::AccessFlags2> s_barrierTextureStateDstAccessMaskMap{
+		{ TextureState::eUndefined, vk::AccessFlagBits2::eNone },
+		{ TextureState::eUploadDst, vk::AccessFlagBits2::eTransferWrite },
+		{ TextureState::eCopySrc, vk::AccessFlagBits2::eTransferRead },
+		{ TextureState::eShaderRead, vk::AccessFlagBits2::eShaderSampledRead },
+		{ TextureState::eRenderTarget, vk::AccessFlagBits2::eColorAttachmentRead | vk::AccessFlagBits2::eColorAttachmentWrite },
+		{ TextureState::ePresent, vk::AccessFlagBits2::eNone },
+		{ TextureState::eShadingRate, vk::AccessFlagBits2::eFragmentShadingRateAttachmentReadKHR },
+		{ TextureState::eLocalRead, vk::AccessFlagBits2::eColorAttachmentRead | vk::AccessFlagBits2::eColorAttachmentWrite | vk::AccessFlagBits2::eInputAttachmentRead },
+		{ TextureState::eStorage, vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite },
+	};
+
+	auto get_queue_supported_stages(vk::QueueFlags queueFlags) -> vk::PipelineStageFlags2
+	{
+		using Stage = vk::PipelineStageFlagBits2;
+		if (queueFlags & vk::QueueFlagBits::eGraphics)
 		{
-			return;
+			return ~vk::PipelineStageFlags2{};
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		vk::Queue queue{};
-		if (!device->get_queue(queue, queueIndex))
+		vk::PipelineStageFlags2 stages = Stage::eTopOfPipe | Stage::eBottomOfPipe | Stage::eAllCommands | Stage::eHost;
+		if (queueFlags & (vk::QueueFlagBits::eCompute | vk::QueueFlagBits::eTransfer))
 		{
-			return;
+			stages |= Stage::eAllTransfer | Stage::eCopy | Stage::eClear;
 		}
-
-		SwapChain* swapChain{ nullptr };
-		if (!device->get_swap_chain(swapChain, swapChainHandle))
+		if (queueFlags & vk::QueueFlagBits::eCompute)
 		{
-			return;
+			stages |= Stage::eComputeShader | Stage::eDrawIndirect | Stage::eAccelerationStructureBuildKHR | Stage::eAccelerationStructureCopyKHR | Stage::eRayTracingShaderKHR;
 		}
-
-		vk::Semaphore wait_semaphore{};
-		if (waitSemaphore != nullptr)
+		if (queueFlags & vk::QueueFlagBits::eVideoDecodeKHR)
 		{
+			stages |= Stage::eVideoDecodeKHR;
 		}
-
-		swapChain->present(queue, wait_semaphore);
+		return stages;
 	}
 
-	bool get_swap_chain_image(TextureHandle& outTextureHandle, SwapChainHandle swapChainHandle)
+	// Drop the stages a queue does not have from a barrier, and the accesses of a side left with none.
+	template <typename Barrier>
+	void restrict_barrier_stages(Barrier& barrier, vk::PipelineStageFlags2 supportedStages)
 	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
-
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, swapChainHandle.deviceHandle))
+		barrier.srcStageMask &= supportedStages;
+		if (!barrier.srcStageMask)
 		{
-			return false;
+			barrier.srcAccessMask = {};
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
-
-		SwapChain* swapChain{ nullptr };
-		if (!device->get_swap_chain(swapChain, swapChainHandle))
+		barrier.dstStageMask &= supportedStages;
+		if (!barrier.dstStageMask)
 		{
-			return false;
+			barrier.dstAccessMask = {};
 		}
-
-		outTextureHandle = swapChain->get_current_image_handle();
-		return outTextureHandle > 0;
 	}
 
-#pragma endregion
-
-#pragma region Command List Recording
-
-	void reset(CommandListHandle commandListHandle)
+	/**
+	 * @brief The stages and accesses that can use a buffer after a transfer writes it, going by its usage flags.
+	 * Shader-visible buffers may be read by any shader stage, which is as good as all commands.
+	 */
+	void get_buffer_consumers(vk::BufferUsageFlags usage, bool hostVisible, vk::PipelineStageFlags2& outStages, vk::AccessFlags2& outAccess)
 	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
-
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		using Usage = vk::BufferUsageFlagBits;
+		using Stage = vk::PipelineStageFlagBits2;
+		using Access = vk::AccessFlagBits2;
+		if (usage & (Usage::eUniformBuffer | Usage::eStorageBuffer | Usage::eUniformTexelBuffer | Usage::eStorageTexelBuffer | Usage::eShaderDeviceAddress))
 		{
-			return;
+			outStages |= Stage::eAllCommands;
+			outAccess |= Access::eShaderRead | Access::eShaderWrite;
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
-
-		CommandList* commandList{ nullptr };
-		if (!device->get_command_list(commandList, commandListHandle))
+		if (usage & Usage::eVertexBuffer)
 		{
-			return;
+			outStages |= Stage::eVertexAttributeInput;
+			outAccess |= Access::eVertexAttributeRead;
 		}
-
-		commandList->reset();
-	}
-
-	bool begin(CommandListHandle commandListHandle)
-	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
-
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		if (usage & Usage::eIndexBuffer)
 		{
-			return false;
+			outStages |= Stage::eIndexInput;
+			outAccess |= Access::eIndexRead;
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
-
-		CommandList* commandList{ nullptr };
-		if (!device->get_command_list(commandList, commandListHandle))
+		if (usage & Usage::eIndirectBuffer)
 		{
-			return false;
+			outStages |= Stage::eDrawIndirect;
+			outAccess |= Access::eIndirectCommandRead;
 		}
-
-		commandList->begin();
-
-		return true;
-	}
-
-	void end(CommandListHandle commandListHandle)
-	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
-
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		if (usage & (Usage::eTransferSrc | Usage::eTransferDst))
 		{
-			return;
+			outStages |= Stage::eAllTransfer;
+			outAccess |= Access::eTransferRead | Access::eTransferWrite;
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
-
-		CommandList* commandList{ nullptr };
-		if (!device->get_command_list(commandList, commandListHandle))
+		if (usage & Usage::eConditionalRenderingEXT)
 		{
-			return;
+			outStages |= Stage::eConditionalRenderingEXT;
+			outAccess |= Access::eConditionalRenderingReadEXT;
 		}
-
-		commandList->end();
-	}
-
-	void begin_render_pass(CommandListHandle commandListHandle, const RenderPassInfo& renderPassInfo)
-	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
-
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		if (usage & Usage::eAccelerationStructureBuildInputReadOnlyKHR)
 		{
-			return;
+			outStages |= Stage::eAccelerationStructureBuildKHR;
+			outAccess |= Access::eShaderRead;
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
-
-		CommandList* commandList{ nullptr };
-		if (!device->get_command_list(commandList, commandListHandle))
+		if (usage & Usage::eShaderBindingTableKHR)
 		{
-			return;
+			outStages |= Stage::eRayTracingShaderKHR;
+			outAccess |= Access::eShaderRead;
 		}
-
-		std::vector<Texture*> colorAttachments(renderPassInfo.colorAttachments.size());
-		for (auto i = 0; i < colorAttachments.size(); ++i)
+		if (hostVisible)
 		{
-			auto success = device->get_texture(colorAttachments[i], renderPassInfo.colorAttachments[i]);
-			GFX_ASSERT(success, "Failed to get Texture for color attachment from handle!");
+			outStages |= Stage::eHost;
+			outAccess |= Access::eHostRead;
 		}
-
-		Texture* depthAttachment{ nullptr };
-		if (renderPassInfo.depthAttachment != 0)
+		if (!outStages)
 		{
-			auto success = device->get_texture(depthAttachment, renderPassInfo.depthAttachment);
-			GFX_ASSERT(success, "Failed to get Texture for depth attachment from handle!");
+			outStages = Stage::eAllCommands;
+			outAccess = Access::eMemoryRead | Access::eMemoryWrite;
 		}
-
-		commandList->begin_render_pass(colorAttachments, depthAttachment, renderPassInfo.clearColor);
 	}
 
-	void end_render_pass(CommandListHandle commandListHandle)
+	/**
+	 * @brief Records an indirect draw through `record(offset, drawCount)`.
+	 * Without multiDrawIndirect the draw is split into one single-draw command per record, `stride` bytes apart.
+	 */
+	template <typename Record>
+	void record_indirect_draws(bool multiDrawSupported, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride, Record&& record)
 	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
-
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		if (drawCount <= 1 || multiDrawSupported)
 		{
+			record(offset, drawCount);
 			return;
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
-
-		CommandList* commandList{ nullptr };
-		if (!device->get_command_list(commandList, commandListHandle))
+		for (std::uint32_t i = 0; i < drawCount; ++i)
 		{
-			return;
+			record(offset + std::uint64_t(i) * stride, 1u);
 		}
-
-		commandList->end_render_pass();
 	}
 
-	void set_viewport(CommandListHandle commandListHandle, float x, float y, float width, float height, float minDepth, float maxDepth)
+	/**
+	 * @brief Whether moving between two identical states needs no barrier at all.
+	 * Only read-only states qualify; write states still need ordering between consecutive writes.
+	 */
+	auto is_texture_state_read_only(TextureState state) -> bool
 	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+		return state == TextureState::eShaderRead || state == TextureState::eCopySrc || state == TextureState::ePresent || state == TextureState::eShadingRate;
+	}
 
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+	auto get_format_aspect_mask(vk::Format format) -> vk::ImageAspectFlags
+	{
+		switch (format)
 		{
-			return;
+			case vk::Format::eD16Unorm:
+			case vk::Format::eD32Sfloat:
+				return vk::ImageAspectFlagBits::eDepth;
+			case vk::Format::eD24UnormS8Uint:
+			case vk::Format::eD32SfloatS8Uint:
+				return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+			default:
+				return vk::ImageAspectFlagBits::eColor;
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
+	}
 
-		CommandList* commandList{ nullptr };
-		if (!device->get_command_list(commandList, commandListHandle))
+	/**
+	 * @brief Whether a color format holds unsigned or signed integers, which cannot be filtered or averaged.
+	 */
+	auto is_integer_format(vk::Format format) -> bool
+	{
+		switch (format)
 		{
-			return;
+			case vk::Format::eR8Uint:
+			case vk::Format::eR8Sint:
+			case vk::Format::eR8G8Uint:
+			case vk::Format::eR8G8Sint:
+			case vk::Format::eR8G8B8A8Uint:
+			case vk::Format::eR8G8B8A8Sint:
+			case vk::Format::eA2B10G10R10UintPack32:
+			case vk::Format::eR16Uint:
+			case vk::Format::eR16Sint:
+			case vk::Format::eR16G16Uint:
+			case vk::Format::eR16G16Sint:
+			case vk::Format::eR16G16B16A16Uint:
+			case vk::Format::eR16G16B16A16Sint:
+			case vk::Format::eR32Uint:
+			case vk::Format::eR32Sint:
+			case vk::Format::eR32G32Uint:
+			case vk::Format::eR32G32Sint:
+			case vk::Format::eR32G32B32A32Uint:
+			case vk::Format::eR32G32B32A32Sint:
+				return true;
+			default:
+				return false;
 		}
-
-		commandList->set_viewport(x, y, width, height, minDepth, maxDepth);
 	}
 
-	void set_scissor(CommandListHandle commandListHandle, std::int32_t x, std::int32_t y, std::uint32_t width, std::uint32_t height)
+	auto convert_shader_stages_to_vk_shader_stage_flags(std::uint32_t shaderStages) -> vk::ShaderStageFlags
 	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
-
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		vk::ShaderStageFlags stageFlags{};
+		if (shaderStages & ShaderStageFlags_Compute)
 		{
-			return;
+			stageFlags |= vk::ShaderStageFlagBits::eCompute;
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
-
-		CommandList* commandList{ nullptr };
-		if (!device->get_command_list(commandList, commandListHandle))
+		if (shaderStages & ShaderStageFlags_Vertex)
 		{
-			return;
+			stageFlags |= vk::ShaderStageFlagBits::eVertex;
 		}
-
-		commandList->set_scissor(x, y, width, height);
+		if (shaderStages & ShaderStageFlags_Fragment)
+		{
+			stageFlags |= vk::ShaderStageFlagBits::eFragment;
+		}
+		if (shaderStages & ShaderStageFlags_Task)
+		{
+			stageFlags |= vk::ShaderStageFlagBits::eTaskEXT;
+		}
+		if (shaderStages & ShaderStageFlags_Mesh)
+		{
+			stageFlags |= vk::ShaderStageFlagBits::eMeshEXT;
+		}
+		// #TODO: Convert other shader stages.
+		return stageFlags;
 	}
 
-	void bind_pipeline(CommandListHandle commandListHandle, PipelineHandle pipelineHandle)
+	auto convert_pipeline_stages_to_vk_pipeline_stage_flags(std::uint32_t pipelineStages) -> vk::PipelineStageFlags2
 	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
-
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		vk::PipelineStageFlags2 stageFlags{};
+		if (pipelineStages & PipelineStageFlags_DrawIndirect)
 		{
-			return;
+			stageFlags |= vk::PipelineStageFlagBits2::eDrawIndirect;
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
+		if (pipelineStages & PipelineStageFlags_VertexInput)
+		{
+			stageFlags |= vk::PipelineStageFlagBits2::eVertexInput;
+		}
+		if (pipelineStages & PipelineStageFlags_VertexShader)
+		{
+			stageFlags |= vk::PipelineStageFlagBits2::eVertexShader;
+		}
+		if (pipelineStages & PipelineStageFlags_FragmentShader)
+		{
+			stageFlags |= vk::PipelineStageFlagBits2::eFragmentShader;
+		}
+		if (pipelineStages & PipelineStageFlags_DepthStencilAttachment)
+		{
+			stageFlags |= vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests;
+		}
+		if (pipelineStages & PipelineStageFlags_ColorAttachmentOutput)
+		{
+			stageFlags |= vk::PipelineStageFlagBits2::eColorAttachmentOutput;
+		}
+		if (pipelineStages & PipelineStageFlags_ComputeShader)
+		{
+			stageFlags |= vk::PipelineStageFlagBits2::eComputeShader;
+		}
+		if (pipelineStages & PipelineStageFlags_Transfer)
+		{
+			stageFlags |= vk::PipelineStageFlagBits2::eAllTransfer;
+		}
+		if (pipelineStages & PipelineStageFlags_AllCommands)
+		{
+			stageFlags |= vk::PipelineStageFlagBits2::eAllCommands;
+		}
+		if (pipelineStages & PipelineStageFlags_Host)
+		{
+			stageFlags |= vk::PipelineStageFlagBits2::eHost;
+		}
+		if (pipelineStages & PipelineStageFlags_ConditionalRendering)
+		{
+			stageFlags |= vk::PipelineStageFlagBits2::eConditionalRenderingEXT;
+		}
+		return stageFlags;
+	}
+
+	auto convert_access_flags_to_vk_access_flags(std::uint32_t accessFlags) -> vk::AccessFlags2
+	{
+		vk::AccessFlags2 vkAccessFlags{};
+		if (accessFlags & AccessFlags_IndirectCommandRead)
+		{
+			vkAccessFlags |= vk::AccessFlagBits2::eIndirectCommandRead;
+		}
+		if (accessFlags & AccessFlags_IndexRead)
+		{
+			vkAccessFlags |= vk::AccessFlagBits2::eIndexRead;
+		}
+		if (accessFlags & AccessFlags_VertexAttributeRead)
+		{
+			vkAccessFlags |= vk::AccessFlagBits2::eVertexAttributeRead;
+		}
+		if (accessFlags & AccessFlags_UniformRead)
+		{
+			vkAccessFlags |= vk::AccessFlagBits2::eUniformRead;
+		}
+		if (accessFlags & AccessFlags_ShaderRead)
+		{
+			vkAccessFlags |= vk::AccessFlagBits2::eShaderSampledRead | vk::AccessFlagBits2::eShaderStorageRead;
+		}
+		if (accessFlags & AccessFlags_ShaderWrite)
+		{
+			vkAccessFlags |= vk::AccessFlagBits2::eShaderStorageWrite;
+		}
+		if (accessFlags & AccessFlags_TransferRead)
+		{
+			vkAccessFlags |= vk::AccessFlagBits2::eTransferRead;
+		}
+		if (accessFlags & AccessFlags_TransferWrite)
+		{
+			vkAccessFlags |= vk::AccessFlagBits2::eTransferWrite;
+		}
+		if (accessFlags & AccessFlags_HostRead)
+		{
+			vkAccessFlags |= vk::AccessFlagBits2::eHostRead;
+		}
+		if (accessFlags & AccessFlags_HostWrite)
+		{
+			vkAccessFlags |= vk::AccessFlagBits2::eHostWrite;
+		}
+		if (accessFlags & AccessFlags_MemoryRead)
+		{
+			vkAccessFlags |= vk::AccessFlagBits2::eMemoryRead;
+		}
+		if (accessFlags & AccessFlags_MemoryWrite)
+		{
+			vkAccessFlags |= vk::AccessFlagBits2::eMemoryWrite;
+		}
+		if (accessFlags & AccessFlags_ConditionalRenderingRead)
+		{
+			vkAccessFlags |= vk::AccessFlagBits2::eConditionalRenderingReadEXT;
+		}
+		return vkAccessFlags;
+	}
+
+	auto convert_queue_global_priority_to_vk_queue_global_priority(QueueGlobalPriority priority) -> vk::QueueGlobalPriorityEXT
+	{
+		switch (priority)
+		{
+			case QueueGlobalPriority::eLow:
+				return vk::QueueGlobalPriorityEXT::eLow;
+			case QueueGlobalPriority::eHigh:
+				return vk::QueueGlobalPriorityEXT::eHigh;
+			case QueueGlobalPriority::eRealtime:
+				return vk::QueueGlobalPriorityEXT::eRealtime;
+			case QueueGlobalPriority::eDefault:
+			case QueueGlobalPriority::eMedium:
+			default:
+				return vk::QueueGlobalPriorityEXT::eMedium; // The implementation's default.
+		}
+	}
+
+	auto convert_latency_marker_to_vk_latency_marker(LatencyMarker marker) -> vk::LatencyMarkerNV
+	{
+		switch (marker)
+		{
+			case LatencyMarker::eSimulationStart:
+				return vk::LatencyMarkerNV::eSimulationStart;
+			case LatencyMarker::eSimulationEnd:
+				return vk::LatencyMarkerNV::eSimulationEnd;
+			case LatencyMarker::eRenderSubmitStart:
+				return vk::LatencyMarkerNV::eRendersubmitStart;
+			case LatencyMarker::eRenderSubmitEnd:
+				return vk::LatencyMarkerNV::eRendersubmitEnd;
+			case LatencyMarker::eInputSample:
+			default:
+				return vk::LatencyMarkerNV::eInputSample;
+		}
+	}
+
+	/**
+	 * @brief The present modes to try for a PresentMode, in order of preference.
+	 */
+	auto get_vk_present_mode_candidates(PresentMode presentMode) -> std::array<vk::PresentModeKHR, 3>
+	{
+		switch (presentMode)
+		{
+			case PresentMode::eLowestLatency:
+				return { vk::PresentModeKHR::eImmediate, vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eFifo };
+			case PresentMode::eMailbox:
+				return { vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eFifo, vk::PresentModeKHR::eFifo };
+			case PresentMode::eFifoRelaxed:
+				return { vk::PresentModeKHR::eFifoRelaxed, vk::PresentModeKHR::eFifo, vk::PresentModeKHR::eFifo };
+			case PresentMode::eFifo:
+			default:
+				return { vk::PresentModeKHR::eFifo, vk::PresentModeKHR::eFifo, vk::PresentModeKHR::eFifo };
+		}
+	}
+
+	auto convert_format_to_vk_format(Format format) -> vk::Format
+	{
+		switch (format)
+		{
+			case Format::eUndefined:
+				return vk::Format::eUndefined;
+			case Format::eR8:
+				return vk::Format::eR8Unorm;
+			case Format::eRG8:
+				return vk::Format::eR8G8Unorm;
+			case Format::eRG32:
+				return vk::Format::eR32G32Sfloat;
+			case Format::eRGB8:
+				return vk::Format::eR8G8B8Unorm;
+			case Format::eRGB32:
+				return vk::Format::eR32G32B32Sfloat;
+			case Format::eRGBA8:
+				return vk::Format::eR8G8B8A8Unorm;
+			case Format::eRGBA32:
+				return vk::Format::eR32G32B32A32Sfloat;
+			case Format::eDepth16:
+				return vk::Format::eD16Unorm;
+			case Format::eBGRA8:
+				return vk::Format::eB8G8R8A8Srgb;
+			case Format::eDepth24Stencil8:
+				return vk::Format::eD24UnormS8Uint;
+			case Format::eDepth32:
+				return vk::Format::eD32Sfloat;
+			case Format::eDepth32Stencil8:
+				return vk::Format::eD32SfloatS8Uint;
+			case Format::eBC1:
+				return vk::Format::eBc1RgbaUnormBlock;
+			case Format::eBC1Srgb:
+				return vk::Format::eBc1RgbaSrgbBlock;
+			case Format::eBC3:
+				return vk::Format::eBc3UnormBlock;
+			case Format::eBC3Srgb:
+				return vk::Format::eBc3SrgbBlock;
+			case Format::eBC4:
+				return vk::Format::eBc4UnormBlock;
+			case Format::eBC5:
+				return vk::Format::eBc5UnormBlock;
+			case Format::eBC6H:
+				return vk::Format::eBc6HUfloatBlock;
+			case Format::eBC7:
+				return vk::Format::eBc7UnormBlock;
+			case Format::eBC7Srgb:
+				return vk::Format::eBc7SrgbBlock;
+			case Format::eETC2RGB8:
+				return vk::Format::eEtc2R8G8B8UnormBlock;
+			case Format::eETC2RGBA8:
+				return vk::Format::eEtc2R8G8B8A8UnormBlock;
+			case Format::eASTC4x4:
+				return vk::Format::eAstc4x4UnormBlock;
+			case Format::eASTC4x4Srgb:
+				return vk::Format::eAstc4x4SrgbBlock;
+			case Format::eRG16Float:
+				return vk::Format::eR16G16Sfloat;
+			case Format::eRGBA16Float:
+				return vk::Format::eR16G16B16A16Sfloat;
+			case Format::eRG16Snorm:
+				return vk::Format::eR16G16Snorm;
+			case Format::eRGBA16Snorm:
+				return vk::Format::eR16G16B16A16Snorm;
+			case Format::eRG16Unorm:
+				return vk::Format::eR16G16Unorm;
+			case Format::eRGBA16Unorm:
+				return vk::Format::eR16G16B16A16Unorm;
+			case Format::eRG8Snorm:
+				return vk::Format::eR8G8Snorm;
+			case Format::eRGBA8Snorm:
+				return vk::Format::eR8G8B8A8Snorm;
+			case Format::eRGB10A2Unorm:
+				return vk::Format::eA2B10G10R10UnormPack32;
+			case Format::eRGB10A2Snorm:
+				return vk::Format::eA2B10G10R10SnormPack32;
+			case Format::eR8Uint:
+				return vk::Format::eR8Uint;
+			case Format::eR16Unorm:
+				return vk::Format::eR16Unorm;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown Format to vk::Format!");
+				break;
+		}
+		return vk::Format::eUndefined;
+	}
+
+	auto convert_format_to_byte_size(Format format) -> std::uint32_t
+	{
+		switch (format)
+		{
+			case Format::eUndefined:
+				return 0;
+			case Format::eR8:
+			case Format::eR8Uint:
+				return 1;
+			case Format::eRG8:
+			case Format::eRG8Snorm:
+				return 1 * 2;
+			case Format::eR16Unorm:
+				return 2;
+			case Format::eRGB8:
+				return 1 * 3;
+			case Format::eRGBA8:
+			case Format::eRGBA8Snorm:
+			case Format::eRGB10A2Unorm:
+			case Format::eRGB10A2Snorm:
+				return 1 * 4;
+			case Format::eRG16Float:
+			case Format::eRG16Snorm:
+			case Format::eRG16Unorm:
+				return 2 * 2;
+			case Format::eRGBA16Float:
+			case Format::eRGBA16Snorm:
+			case Format::eRGBA16Unorm:
+				return 2 * 4;
+			case Format::eRG32:
+				return 4 * 2;
+			case Format::eRGB32:
+				return 4 * 3;
+			case Format::eRGBA32:
+				return 4 * 4;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown Format to byte size!");
+				break;
+		}
+		return 0;
+	}
+
+	/**
+	 * @brief The texel block of a format as laid out in buffer copies, 1x1 for uncompressed formats.
+	 * Depth/stencil formats give their depth aspect, the only one copies touch.
+	 */
+	struct FormatBlock
+	{
+		std::uint32_t width{ 1 };
+		std::uint32_t height{ 1 };
+		std::uint32_t size{ 0 };
+	};
+	auto get_format_block(vk::Format format) -> FormatBlock
+	{
+		switch (format)
+		{
+			case vk::Format::eR8Unorm:
+			case vk::Format::eR8Uint:
+				return { 1, 1, 1 };
+			case vk::Format::eR8G8Unorm:
+			case vk::Format::eR8G8Snorm:
+			case vk::Format::eR16Unorm:
+			case vk::Format::eD16Unorm:
+				return { 1, 1, 2 };
+			case vk::Format::eR8G8B8Unorm:
+				return { 1, 1, 3 };
+			case vk::Format::eR8G8B8A8Unorm:
+			case vk::Format::eR8G8B8A8Snorm:
+			case vk::Format::eA2B10G10R10UnormPack32:
+			case vk::Format::eA2B10G10R10SnormPack32:
+			case vk::Format::eR16G16Sfloat:
+			case vk::Format::eR16G16Snorm:
+			case vk::Format::eR16G16Unorm:
+			case vk::Format::eB8G8R8A8Srgb:
+			case vk::Format::eD24UnormS8Uint:
+			case vk::Format::eD32Sfloat:
+			case vk::Format::eD32SfloatS8Uint:
+				return { 1, 1, 4 };
+			case vk::Format::eR32G32Sfloat:
+			case vk::Format::eR16G16B16A16Sfloat:
+			case vk::Format::eR16G16B16A16Snorm:
+			case vk::Format::eR16G16B16A16Unorm:
+				return { 1, 1, 8 };
+			case vk::Format::eR32G32B32Sfloat:
+				return { 1, 1, 12 };
+			case vk::Format::eR32G32B32A32Sfloat:
+				return { 1, 1, 16 };
+			case vk::Format::eBc1RgbaUnormBlock:
+			case vk::Format::eBc1RgbaSrgbBlock:
+			case vk::Format::eBc4UnormBlock:
+			case vk::Format::eEtc2R8G8B8UnormBlock:
+				return { 4, 4, 8 };
+			case vk::Format::eBc3UnormBlock:
+			case vk::Format::eBc3SrgbBlock:
+			case vk::Format::eBc5UnormBlock:
+			case vk::Format::eBc6HUfloatBlock:
+			case vk::Format::eBc7UnormBlock:
+			case vk::Format::eBc7SrgbBlock:
+			case vk::Format::eEtc2R8G8B8A8UnormBlock:
+			case vk::Format::eAstc4x4UnormBlock:
+			case vk::Format::eAstc4x4SrgbBlock:
+				return { 4, 4, 16 };
+			default:
+				return {};
+		}
+	}
+
+	auto get_texture_level_size(vk::Format format, std::uint32_t width, std::uint32_t height) -> std::uint64_t
+	{
+		const auto block = get_format_block(format);
+		const std::uint64_t blocksWide = (width + block.width - 1) / block.width;
+		const std::uint64_t blocksHigh = (height + block.height - 1) / block.height;
+		return blocksWide * blocksHigh * block.size;
+	}
+
+	/**
+	 * @brief The RGBA format Device::get_texture_format() promotes an RGB format to, eUndefined for formats it never promotes.
+	 */
+	auto get_promoted_format(vk::Format format) -> vk::Format
+	{
+		switch (format)
+		{
+			case vk::Format::eR8G8B8Unorm: return vk::Format::eR8G8B8A8Unorm;
+			case vk::Format::eR32G32B32Sfloat: return vk::Format::eR32G32B32A32Sfloat;
+			default: return vk::Format::eUndefined;
+		}
+	}
+
+	template <typename Component>
+	void widen_texels(std::byte* dst, const std::byte* src, std::uint64_t texelCount, Component alpha)
+	{
+		// Last to first, so a texel is read before anything is written over it when dst is src.
+		for (auto i = texelCount; i-- > 0;)
+		{
+			std::array<Component, 4> texel{ {} };
+			std::memcpy(texel.data(), src + i * 3 * sizeof(Component), 3 * sizeof(Component));
+			texel[3] = alpha;
+			std::memcpy(dst + i * 4 * sizeof(Component), texel.data(), sizeof(texel));
+		}
+	}
+
+	/**
+	 * @brief Copy texture data in its upload format to staging memory in the texture's format, widening RGB texels to opaque
+	 * RGBA if the format was promoted. dst may be src, for data written where it is staged.
+	 * @param size Bytes of data in the upload format.
+	 */
+	void stage_texels(const Texture& texture, void* dst, const void* src, std::uint64_t size)
+	{
+		auto* dstBytes = static_cast<std::byte*>(dst);
+		const auto* srcBytes = static_cast<const std::byte*>(src);
+		switch (texture.is_format_promoted() ? texture.get_upload_format() : vk::Format::eUndefined)
+		{
+			case vk::Format::eR8G8B8Unorm: widen_texels<std::uint8_t>(dstBytes, srcBytes, size / 3, 0xFF); break;
+			case vk::Format::eR32G32B32Sfloat: widen_texels<float>(dstBytes, srcBytes, size / 12, 1.0f); break;
+			default:
+				if (dst != src)
+				{
+					std::memcpy(dst, src, size);
+				}
+				break;
+		}
+	}
+
+	/**
+	 * @brief The extent a copy region covers, with zeroes resolved to the rest of the level.
+	 */
+	auto get_copy_region_extent(const Texture& texture, const BufferTextureCopyRegion& region) -> vk::Extent3D
+	{
+		const auto extent = texture.get_mip_extent(region.mipLevel);
+		return { region.width != 0 ? region.width : extent.width - region.x, region.height != 0 ? region.height : extent.height - region.y,
+				 region.depth != 0 ? region.depth : extent.depth - region.z };
+	}
+
+	auto get_copy_region_extent(const Texture& srcTexture, const TextureRegionCopy& region) -> vk::Extent3D
+	{
+		const auto extent = srcTexture.get_mip_extent(region.srcMipLevel);
+		return { region.width != 0 ? region.width : extent.width - region.srcX, region.height != 0 ? region.height : extent.height - region.srcY,
+				 region.depth != 0 ? region.depth : extent.depth - region.srcZ };
+	}
+
+	bool validate_texture_copy_subresources(const Texture& texture, std::uint32_t mipLevel, std::uint32_t baseArrayLayer, std::uint32_t layerCount)
+	{
+		if (mipLevel >= texture.get_mip_levels() || layerCount == 0 || baseArrayLayer + layerCount > texture.get_array_layers())
+		{
+			s_errorCallback("GFX - Copy region is outside the texture's subresources!");
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Check a box of texels at an offset into a mip level lies within it. Compressed copies address whole blocks, other
+	 * than where they end at the edge of the level.
+	 */
+	bool validate_texture_copy_box(const Texture& texture, std::uint32_t mipLevel, std::uint32_t x, std::uint32_t y, std::uint32_t z, const vk::Extent3D& extent)
+	{
+		const auto levelExtent = texture.get_mip_extent(mipLevel);
+		if (x >= levelExtent.width || y >= levelExtent.height || z >= levelExtent.depth || extent.width > levelExtent.width - x || extent.height > levelExtent.height - y ||
+			extent.depth > levelExtent.depth - z)
+		{
+			s_errorCallback("GFX - Copy region is outside the mip level!");
+			return false;
+		}
+
+		const auto block = get_format_block(texture.get_format());
+		if (x % block.width != 0 || y % block.height != 0 || (extent.width % block.width != 0 && x + extent.width != levelExtent.width) ||
+			(extent.height % block.height != 0 && y + extent.height != levelExtent.height))
+		{
+			s_errorCallback("GFX - Copy region is not aligned to the format's texel blocks!");
+			return false;
+		}
+		return true;
+	}
+
+	bool validate_buffer_texture_copy_region(const Buffer& buffer, const Texture& texture, const BufferTextureCopyRegion& region)
+	{
+		if (!validate_texture_copy_subresources(texture, region.mipLevel, region.baseArrayLayer, region.layerCount))
+		{
+			return false;
+		}
+		const auto extent = get_copy_region_extent(texture, region);
+		if (!validate_texture_copy_box(texture, region.mipLevel, region.x, region.y, region.z, extent))
+		{
+			return false;
+		}
+
+		const auto block = get_format_block(texture.get_format());
+		if (region.bufferRowLength % block.width != 0 || region.bufferImageHeight % block.height != 0)
+		{
+			s_errorCallback("GFX - Copy region is not aligned to the format's texel blocks!");
+			return false;
+		}
+		if ((region.bufferRowLength != 0 && region.bufferRowLength < extent.width) || (region.bufferImageHeight != 0 && region.bufferImageHeight < extent.height))
+		{
+			s_errorCallback("GFX - Copy region's buffer rows or slices are smaller than the copied extent!");
+			return false;
+		}
+		// Depth/stencil copies need 4 byte alignment whatever the texel size.
+		const std::uint64_t offsetAlignment = (texture.get_aspect_mask() & (vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil)) ? 4 : block.size;
+		if (offsetAlignment != 0 && region.bufferOffset % offsetAlignment != 0)
+		{
+			s_errorCallback("GFX - Copy region's buffer offset is not aligned to the format's texel block size!");
+			return false;
+		}
+
+		// Up to the end of the last row of the last slice, which needs no padding after it.
+		const std::uint64_t rowBlocks = ((region.bufferRowLength != 0 ? region.bufferRowLength : extent.width) + block.width - 1) / block.width;
+		const std::uint64_t sliceRows = ((region.bufferImageHeight != 0 ? region.bufferImageHeight : extent.height) + block.height - 1) / block.height;
+		const std::uint64_t copiedRows = (extent.height + block.height - 1) / block.height;
+		const std::uint64_t copiedRowBlocks = (extent.width + block.width - 1) / block.width;
+		const std::uint64_t slices = std::uint64_t(extent.depth) * region.layerCount;
+		const auto regionSize = (((slices - 1) * sliceRows + copiedRows - 1) * rowBlocks + copiedRowBlocks) * block.size;
+		if (region.bufferOffset > buffer.get_size() || regionSize > buffer.get_size() - region.bufferOffset)
+		{
+			s_errorCallback("GFX - Copy region is out of the buffer's bounds!");
+			return false;
+		}
+		return true;
+	}
+
+	bool validate_buffer_texture_copy_regions(const Buffer& buffer, const Texture& texture, std::span<const BufferTextureCopyRegion> regions)
+	{
+		if (regions.size() > MAX_COPY_REGIONS)
+		{
+			s_errorCallback("GFX - Cannot copy more than MAX_COPY_REGIONS regions at once!");
+			return false;
+		}
+		return std::all_of(regions.begin(), regions.end(), [&](const auto& region) { return validate_buffer_texture_copy_region(buffer, texture, region); });
+	}
+
+	/**
+	 * @brief Checks shared by copies between textures.
+	 */
+	bool validate_texture_to_texture_copy(const Texture& srcTexture, const Texture& dstTexture, std::size_t regionCount)
+	{
+		if (regionCount > MAX_COPY_REGIONS)
+		{
+			s_errorCallback("GFX - Cannot copy more than MAX_COPY_REGIONS regions at once!");
+			return false;
+		}
+		if (srcTexture.is_transient() || dstTexture.is_transient())
+		{
+			s_errorCallback("GFX - Transient textures only live within render passes, they cannot be copied!");
+			return false;
+		}
+		return true;
+	}
+
+	// A subresource cannot be in TextureState::eCopySrc and TextureState::eUploadDst at once.
+	bool is_copy_in_place(const Texture& srcTexture, const Texture& dstTexture, std::uint32_t srcMipLevel, std::uint32_t srcBaseArrayLayer, std::uint32_t dstMipLevel,
+						  std::uint32_t dstBaseArrayLayer, std::uint32_t layerCount)
+	{
+		return &srcTexture == &dstTexture && srcMipLevel == dstMipLevel && srcBaseArrayLayer < dstBaseArrayLayer + layerCount && dstBaseArrayLayer < srcBaseArrayLayer + layerCount;
+	}
+
+	bool validate_texture_copy_regions(const Texture& srcTexture, const Texture& dstTexture, std::span<const TextureRegionCopy> regions)
+	{
+		if (!validate_texture_to_texture_copy(srcTexture, dstTexture, regions.size()))
+		{
+			return false;
+		}
+		for (const auto& region : regions)
+		{
+			if (!validate_texture_copy_subresources(srcTexture, region.srcMipLevel, region.srcBaseArrayLayer, region.layerCount) ||
+				!validate_texture_copy_subresources(dstTexture, region.dstMipLevel, region.dstBaseArrayLayer, region.layerCount))
+			{
+				return false;
+			}
+			if (is_copy_in_place(srcTexture, dstTexture, region.srcMipLevel, region.srcBaseArrayLayer, region.dstMipLevel, region.dstBaseArrayLayer, region.layerCount))
+			{
+				s_errorCallback("GFX - Copy region reads and writes the same subresource!");
+				return false;
+			}
+			const auto extent = get_copy_region_extent(srcTexture, region);
+			if (!validate_texture_copy_box(srcTexture, region.srcMipLevel, region.srcX, region.srcY, region.srcZ, extent) ||
+				!validate_texture_copy_box(dstTexture, region.dstMipLevel, region.dstX, region.dstY, region.dstZ, extent))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool validate_texture_copy(const Texture& srcTexture, const Texture& dstTexture, std::span<const TextureRegionCopy> regions)
+	{
+		const auto srcBlock = get_format_block(srcTexture.get_format());
+		const auto dstBlock = get_format_block(dstTexture.get_format());
+		if (srcTexture.get_format() != dstTexture.get_format() &&
+			(srcBlock.size == 0 || srcBlock.size != dstBlock.size || srcBlock.width != dstBlock.width || srcBlock.height != dstBlock.height))
+		{
+			s_errorCallback("GFX - copy_texture() - The formats must have the same texel block!");
+			return false;
+		}
+		if (srcTexture.get_sample_count() != dstTexture.get_sample_count())
+		{
+			s_errorCallback("GFX - copy_texture() - The textures must have the same sample count!");
+			return false;
+		}
+		return validate_texture_copy_regions(srcTexture, dstTexture, regions);
+	}
+
+	bool validate_texture_resolve(const Texture& srcTexture, const Texture& dstTexture, std::span<const TextureRegionCopy> regions)
+	{
+		if (srcTexture.get_sample_count() == vk::SampleCountFlagBits::e1 || dstTexture.get_sample_count() != vk::SampleCountFlagBits::e1)
+		{
+			s_errorCallback("GFX - resolve_texture() - Can only resolve a multisampled texture into a single sampled one!");
+			return false;
+		}
+		if (srcTexture.get_format() != dstTexture.get_format() || srcTexture.get_aspect_mask() != vk::ImageAspectFlagBits::eColor)
+		{
+			s_errorCallback("GFX - resolve_texture() - The textures must be color textures of the same format!");
+			return false;
+		}
+		return validate_texture_copy_regions(srcTexture, dstTexture, regions);
+	}
+
+	/**
+	 * @brief The corners of a blit box, an axis with both at 0 spanning the whole level. The mip level must exist.
+	 */
+	auto get_blit_offsets(const Texture& texture, std::uint32_t mipLevel, const std::array<std::uint32_t, 3>& begin, const std::array<std::uint32_t, 3>& end)
+		-> std::array<vk::Offset3D, 2>
+	{
+		const auto extent = texture.get_mip_extent(mipLevel);
+		const std::array levelEnd{ extent.width, extent.height, extent.depth };
+		std::array<std::int32_t, 3> resolvedEnd{};
+		for (auto axis = 0; axis < 3; ++axis)
+		{
+			resolvedEnd[axis] = std::int32_t(begin[axis] == 0 && end[axis] == 0 ? levelEnd[axis] : end[axis]);
+		}
+		return { vk::Offset3D{ std::int32_t(begin[0]), std::int32_t(begin[1]), std::int32_t(begin[2]) }, vk::Offset3D{ resolvedEnd[0], resolvedEnd[1], resolvedEnd[2] } };
+	}
+
+	bool validate_texture_blit(const Device& device, const Texture& srcTexture, const Texture& dstTexture, std::span<const TextureBlitRegion> regions, vk::Filter filter)
+	{
+		if (!validate_texture_to_texture_copy(srcTexture, dstTexture, regions.size()))
+		{
+			return false;
+		}
+		if (srcTexture.get_sample_count() != vk::SampleCountFlagBits::e1 || dstTexture.get_sample_count() != vk::SampleCountFlagBits::e1)
+		{
+			s_errorCallback("GFX - blit_texture() - Multisampled textures cannot be blitted, resolve them first!");
+			return false;
+		}
+		const bool isDepthStencil = bool((srcTexture.get_aspect_mask() | dstTexture.get_aspect_mask()) & (vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil));
+		if (isDepthStencil && (srcTexture.get_format() != dstTexture.get_format() || filter != vk::Filter::eNearest))
+		{
+			s_errorCallback("GFX - blit_texture() - Depth/stencil textures can only be blitted to their own format with nearest filtering!");
+			return false;
+		}
+		if (!device.supports_blit(srcTexture.get_format(), dstTexture.get_format(), filter))
+		{
+			s_errorCallback("GFX - blit_texture() - The formats do not support blits with this filter!");
+			return false;
+		}
+
+		const auto is_box_in_level = [](const Texture& texture, std::uint32_t mipLevel, const std::array<vk::Offset3D, 2>& offsets) {
+			const auto extent = texture.get_mip_extent(mipLevel);
+			return std::all_of(offsets.begin(), offsets.end(), [&extent](const vk::Offset3D& offset) {
+				return std::uint32_t(offset.x) <= extent.width && std::uint32_t(offset.y) <= extent.height && std::uint32_t(offset.z) <= extent.depth;
+			});
+		};
+		for (const auto& region : regions)
+		{
+			if (!validate_texture_copy_subresources(srcTexture, region.srcMipLevel, region.srcBaseArrayLayer, region.layerCount) ||
+				!validate_texture_copy_subresources(dstTexture, region.dstMipLevel, region.dstBaseArrayLayer, region.layerCount))
+			{
+				return false;
+			}
+			if (is_copy_in_place(srcTexture, dstTexture, region.srcMipLevel, region.srcBaseArrayLayer, region.dstMipLevel, region.dstBaseArrayLayer, region.layerCount))
+			{
+				s_errorCallback("GFX - Blit region reads and writes the same subresource!");
+				return false;
+			}
+			if (!is_box_in_level(srcTexture, region.srcMipLevel, get_blit_offsets(srcTexture, region.srcMipLevel, region.srcBegin, region.srcEnd)) ||
+				!is_box_in_level(dstTexture, region.dstMipLevel, get_blit_offsets(dstTexture, region.dstMipLevel, region.dstBegin, region.dstEnd)))
+			{
+				s_errorCallback("GFX - Blit region is outside the mip level!");
+				return false;
+			}
+		}
+		return true;
+	}
+
+	auto convert_descriptor_type_to_vk_descriptor_type(DescriptorType descriptorType) -> vk::DescriptorType
+	{
+		switch (descriptorType)
+		{
+			case DescriptorType::eStorageBuffer:
+				return vk::DescriptorType::eStorageBuffer;
+			case DescriptorType::eUniformBuffer:
+				return vk::DescriptorType::eUniformBuffer;
+			case DescriptorType::eUniformBufferDynamic:
+				return vk::DescriptorType::eUniformBufferDynamic;
+			case DescriptorType::eStorageBufferDynamic:
+				return vk::DescriptorType::eStorageBufferDynamic;
+			case DescriptorType::eTexture:
+				return vk::DescriptorType::eCombinedImageSampler;
+			case DescriptorType::eInputAttachment:
+				return vk::DescriptorType::eInputAttachment;
+			case DescriptorType::eInlineUniformBlock:
+				return vk::DescriptorType::eInlineUniformBlock;
+			case DescriptorType::eStorageTexture:
+				return vk::DescriptorType::eStorageImage;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown DescriptorType to vk::DescriptorType!");
+				break;
+		}
+		return {};
+	}
+
+	// Whether descriptors of the type are written with a vk::DescriptorImageInfo rather than a vk::DescriptorBufferInfo.
+	bool is_image_descriptor_type(vk::DescriptorType descriptorType)
+	{
+		return descriptorType == vk::DescriptorType::eCombinedImageSampler || descriptorType == vk::DescriptorType::eInputAttachment ||
+			   descriptorType == vk::DescriptorType::eStorageImage;
+	}
+
+	auto convert_buffer_type_to_vk_usage(BufferType bufferType) -> vk::BufferUsageFlags
+	{
+		switch (bufferType)
+		{
+			case BufferType::eVertex:
+				return vk::BufferUsageFlagBits::eVertexBuffer;
+			case BufferType::eIndex:
+				return vk::BufferUsageFlagBits::eIndexBuffer;
+			case BufferType::eUniform:
+				return vk::BufferUsageFlagBits::eUniformBuffer;
+			case BufferType::eStorage:
+				return vk::BufferUsageFlagBits::eStorageBuffer;
+			case BufferType::eUpload:
+				return vk::BufferUsageFlagBits::eTransferSrc;
+			case BufferType::eIndirect:
+				return vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eStorageBuffer;
+			case BufferType::eTransient:
+				return vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eIndirectBuffer;
+			case BufferType::eReadback:
+				return vk::BufferUsageFlagBits::eTransferDst;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown BufferType to vk::BufferUsageFlags!");
+				break;
+		}
+		return {};
+	}
+
+	auto get_default_buffer_memory(BufferType bufferType) -> BufferMemory
+	{
+		switch (bufferType)
+		{
+			case BufferType::eUpload:
+				return BufferMemory::eUpload;
+			case BufferType::eReadback:
+				return BufferMemory::eReadback;
+			case BufferType::eUniform:
+			case BufferType::eTransient:
+				return BufferMemory::eDynamic;
+			default:
+				return BufferMemory::eGpuOnly;
+		}
+	}
+
+	auto convert_buffer_memory_to_vma_allocation_info(BufferMemory bufferMemory) -> vma::AllocationCreateInfo
+	{
+		vma::AllocationCreateInfo alloc_info{};
+		switch (bufferMemory)
+		{
+			case BufferMemory::eGpuOnly:
+				alloc_info.setUsage(vma::MemoryUsage::eAutoPreferDevice);
+				break;
+			case BufferMemory::eUpload:
+				alloc_info.setUsage(vma::MemoryUsage::eAuto);
+				alloc_info.setFlags(vma::AllocationCreateFlagBits::eHostAccessSequentialWrite);
+				break;
+			case BufferMemory::eReadback:
+				alloc_info.setUsage(vma::MemoryUsage::eAutoPreferHost);
+				alloc_info.setFlags(vma::AllocationCreateFlagBits::eHostAccessRandom);
+				break;
+			case BufferMemory::eDynamic:
+				alloc_info.setUsage(vma::MemoryUsage::eAutoPreferDevice);
+				alloc_info.setFlags(vma::AllocationCreateFlagBits::eHostAccessSequentialWrite);
+				break;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown BufferMemory to vma::AllocationCreateInfo!");
+				break;
+		}
+		return alloc_info;
+	}
+
+	auto get_acceleration_structure_build_flags(const AccelerationStructureInfo& info) -> vk::BuildAccelerationStructureFlagsKHR
+	{
+		vk::BuildAccelerationStructureFlagsKHR flags = info.preferFastBuild ? vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastBuild
+																			: vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace;
+		if (info.allowUpdate)
+		{
+			flags |= vk::BuildAccelerationStructureFlagBitsKHR::eAllowUpdate;
+		}
+		else if (info.compact && info.type == AccelerationStructureType::eBottomLevel)
+		{
+			flags |= vk::BuildAccelerationStructureFlagBitsKHR::eAllowCompaction;
+		}
+		return flags;
+	}
+
+	// Top level instances, read as an array of vk::AccelerationStructureInstanceKHR from a device address.
+	auto get_instance_geometry(vk::DeviceAddress instancesAddress) -> vk::AccelerationStructureGeometryKHR
+	{
+		vk::AccelerationStructureGeometryKHR geometry{};
+		geometry.setGeometryType(vk::GeometryTypeKHR::eInstances);
+		geometry.geometry.setInstances(vk::AccelerationStructureGeometryInstancesDataKHR{ false, instancesAddress });
+		return geometry;
+	}
+
+	auto convert_buffer_type_to_descriptor_type(BufferType bufferType) -> vk::DescriptorType
+	{
+		switch (bufferType)
+		{
+			case BufferType::eUniform:
+				return vk::DescriptorType::eUniformBuffer;
+			case BufferType::eStorage:
+			case BufferType::eIndirect:
+				return vk::DescriptorType::eStorageBuffer;
+			case BufferType::eTransient:
+				return vk::DescriptorType::eUniformBufferDynamic;
+			case BufferType::eVertex:
+			case BufferType::eIndex:
+			case BufferType::eUpload:
+			case BufferType::eReadback:
+				break; // These buffer types cannot be used in descriptors.
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown BufferType to vk::DescriptorType!");
+				break;
+		}
+		return {};
+	}
+
+	auto convert_texture_type_to_vk_image_type(TextureType textureType) -> vk::ImageType
+	{
+		switch (textureType)
+		{
+			case TextureType::e1D:
+				return vk::ImageType::e1D;
+			case TextureType::e2D:
+				return vk::ImageType::e2D;
+			case TextureType::e3D:
+				return vk::ImageType::e3D;
+			case TextureType::eCube:
+				return vk::ImageType::e2D;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown TextureType to vk::ImageType!");
+				break;
+		}
+		return {};
+	}
+
+	auto convert_texture_view_type_to_vk_image_view_type(TextureViewType textureViewType) -> vk::ImageViewType
+	{
+		switch (textureViewType)
+		{
+			case TextureViewType::e1D:
+				return vk::ImageViewType::e1D;
+			case TextureViewType::e1DArray:
+				return vk::ImageViewType::e1DArray;
+			case TextureViewType::e2D:
+				return vk::ImageViewType::e2D;
+			case TextureViewType::e2DArray:
+				return vk::ImageViewType::e2DArray;
+			case TextureViewType::e3D:
+				return vk::ImageViewType::e3D;
+			case TextureViewType::eCube:
+				return vk::ImageViewType::eCube;
+			case TextureViewType::eCubeArray:
+				return vk::ImageViewType::eCubeArray;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown TextureViewType to vk::ImageViewType!");
+				break;
+		}
+		return {};
+	}
+
+	auto convert_sampler_compare_op_to_vk_compare_op(SamplerCompareOp compareOp) -> vk::CompareOp
+	{
+		switch (compareOp)
+		{
+			case SamplerCompareOp::eNever:
+				return vk::CompareOp::eNever;
+			case SamplerCompareOp::eLess:
+				return vk::CompareOp::eLess;
+			case SamplerCompareOp::eEqual:
+				return vk::CompareOp::eEqual;
+			case SamplerCompareOp::eLessOrEqual:
+				return vk::CompareOp::eLessOrEqual;
+			case SamplerCompareOp::eGreater:
+				return vk::CompareOp::eGreater;
+			case SamplerCompareOp::eNotEqual:
+				return vk::CompareOp::eNotEqual;
+			case SamplerCompareOp::eGreaterOrEqual:
+				return vk::CompareOp::eGreaterOrEqual;
+			case SamplerCompareOp::eAlways:
+				return vk::CompareOp::eAlways;
+			case SamplerCompareOp::eNone:
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown SamplerCompareOp to vk::CompareOp!");
+				break;
+		}
+		return {};
+	}
+
+	auto convert_load_op_to_vk_attachment_load_op(LoadOp loadOp) -> vk::AttachmentLoadOp
+	{
+		switch (loadOp)
+		{
+			case LoadOp::eClear:
+				return vk::AttachmentLoadOp::eClear;
+			case LoadOp::eLoad:
+				return vk::AttachmentLoadOp::eLoad;
+			case LoadOp::eDontCare:
+				return vk::AttachmentLoadOp::eDontCare;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown LoadOp to vk::AttachmentLoadOp!");
+				break;
+		}
+		return {};
+	}
+
+	auto convert_store_op_to_vk_attachment_store_op(StoreOp storeOp) -> vk::AttachmentStoreOp
+	{
+		switch (storeOp)
+		{
+			case StoreOp::eStore:
+				return vk::AttachmentStoreOp::eStore;
+			case StoreOp::eDontCare:
+				return vk::AttachmentStoreOp::eDontCare;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown StoreOp to vk::AttachmentStoreOp!");
+				break;
+		}
+		return {};
+	}
+
+	auto convert_render_area_to_vk_rect_2d(const std::array<std::uint32_t, 4>& renderArea) -> vk::Rect2D
+	{
+		return { vk::Offset2D{ std::int32_t(renderArea[0]), std::int32_t(renderArea[1]) }, vk::Extent2D{ renderArea[2], renderArea[3] } };
+	}
+
+	auto convert_shading_rate_to_vk_extent_2d(ShadingRate shadingRate) -> vk::Extent2D
+	{
+		const auto value = std::uint32_t(shadingRate);
+		return { 1u << (value >> 2), 1u << (value & 3) };
+	}
+
+	auto convert_shading_rate_combiner_to_vk_fragment_shading_rate_combiner_op(ShadingRateCombiner combiner) -> vk::FragmentShadingRateCombinerOpKHR
+	{
+		switch (combiner)
+		{
+			case ShadingRateCombiner::eKeep:
+				return vk::FragmentShadingRateCombinerOpKHR::eKeep;
+			case ShadingRateCombiner::eReplace:
+				return vk::FragmentShadingRateCombinerOpKHR::eReplace;
+			case ShadingRateCombiner::eMin:
+				return vk::FragmentShadingRateCombinerOpKHR::eMin;
+			case ShadingRateCombiner::eMax:
+				return vk::FragmentShadingRateCombinerOpKHR::eMax;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown ShadingRateCombiner to vk::FragmentShadingRateCombinerOpKHR!");
+				break;
+		}
+		return {};
+	}
+
+	auto convert_vertex_input_rate_to_vk_vertex_input_rate(VertexInputRate inputRate) -> vk::VertexInputRate
+	{
+		switch (inputRate)
+		{
+			case VertexInputRate::eVertex:
+				return vk::VertexInputRate::eVertex;
+			case VertexInputRate::eInstance:
+				return vk::VertexInputRate::eInstance;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown VertexInputRate to vk::VertexInputRate!");
+				break;
+		}
+		return {};
+	}
+
+	auto convert_primitive_topology_to_vk_primitive_topology(PrimitiveTopology topology) -> vk::PrimitiveTopology
+	{
+		switch (topology)
+		{
+			case PrimitiveTopology::eTriangleList:
+				return vk::PrimitiveTopology::eTriangleList;
+			case PrimitiveTopology::eTriangleStrip:
+				return vk::PrimitiveTopology::eTriangleStrip;
+			case PrimitiveTopology::eLineList:
+				return vk::PrimitiveTopology::eLineList;
+			case PrimitiveTopology::eLineStrip:
+				return vk::PrimitiveTopology::eLineStrip;
+			case PrimitiveTopology::ePointList:
+				return vk::PrimitiveTopology::ePointList;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown PrimitiveTopology to vk::PrimitiveTopology!");
+				break;
+		}
+		return {};
+	}
+
+	auto convert_cull_mode_to_vk_cull_mode(CullMode cullMode) -> vk::CullModeFlags
+	{
+		switch (cullMode)
+		{
+			case CullMode::eNone:
+				return vk::CullModeFlagBits::eNone;
+			case CullMode::eFront:
+				return vk::CullModeFlagBits::eFront;
+			case CullMode::eBack:
+				return vk::CullModeFlagBits::eBack;
+			case CullMode::eFrontAndBack:
+				return vk::CullModeFlagBits::eFrontAndBack;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown CullMode to vk::CullModeFlags!");
+				break;
+		}
+		return {};
+	}
+
+	auto convert_front_face_to_vk_front_face(FrontFace frontFace) -> vk::FrontFace
+	{
+		switch (frontFace)
+		{
+			case FrontFace::eClockwise:
+				return vk::FrontFace::eClockwise;
+			case FrontFace::eCounterClockwise:
+				return vk::FrontFace::eCounterClockwise;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown FrontFace to vk::FrontFace!");
+				break;
+		}
+		return {};
+	}
+
+	auto convert_compare_op_to_vk_compare_op(CompareOp compareOp) -> vk::CompareOp
+	{
+		switch (compareOp)
+		{
+			case CompareOp::eNever:
+				return vk::CompareOp::eNever;
+			case CompareOp::eLess:
+				return vk::CompareOp::eLess;
+			case CompareOp::eEqual:
+				return vk::CompareOp::eEqual;
+			case CompareOp::eLessOrEqual:
+				return vk::CompareOp::eLessOrEqual;
+			case CompareOp::eGreater:
+				return vk::CompareOp::eGreater;
+			case CompareOp::eNotEqual:
+				return vk::CompareOp::eNotEqual;
+			case CompareOp::eGreaterOrEqual:
+				return vk::CompareOp::eGreaterOrEqual;
+			case CompareOp::eAlways:
+				return vk::CompareOp::eAlways;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown CompareOp to vk::CompareOp!");
+				break;
+		}
+		return {};
+	}
+
+	auto convert_stencil_op_to_vk_stencil_op(StencilOp stencilOp) -> vk::StencilOp
+	{
+		switch (stencilOp)
+		{
+			case StencilOp::eKeep:
+				return vk::StencilOp::eKeep;
+			case StencilOp::eZero:
+				return vk::StencilOp::eZero;
+			case StencilOp::eReplace:
+				return vk::StencilOp::eReplace;
+			case StencilOp::eIncrementAndClamp:
+				return vk::StencilOp::eIncrementAndClamp;
+			case StencilOp::eDecrementAndClamp:
+				return vk::StencilOp::eDecrementAndClamp;
+			case StencilOp::eInvert:
+				return vk::StencilOp::eInvert;
+			case StencilOp::eIncrementAndWrap:
+				return vk::StencilOp::eIncrementAndWrap;
+			case StencilOp::eDecrementAndWrap:
+				return vk::StencilOp::eDecrementAndWrap;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown StencilOp to vk::StencilOp!");
+				break;
+		}
+		return {};
+	}
+
+	auto convert_blend_factor_to_vk_blend_factor(BlendFactor blendFactor) -> vk::BlendFactor
+	{
+		switch (blendFactor)
+		{
+			case BlendFactor::eZero:
+				return vk::BlendFactor::eZero;
+			case BlendFactor::eOne:
+				return vk::BlendFactor::eOne;
+			case BlendFactor::eSrcColor:
+				return vk::BlendFactor::eSrcColor;
+			case BlendFactor::eOneMinusSrcColor:
+				return vk::BlendFactor::eOneMinusSrcColor;
+			case BlendFactor::eDstColor:
+				return vk::BlendFactor::eDstColor;
+			case BlendFactor::eOneMinusDstColor:
+				return vk::BlendFactor::eOneMinusDstColor;
+			case BlendFactor::eSrcAlpha:
+				return vk::BlendFactor::eSrcAlpha;
+			case BlendFactor::eOneMinusSrcAlpha:
+				return vk::BlendFactor::eOneMinusSrcAlpha;
+			case BlendFactor::eDstAlpha:
+				return vk::BlendFactor::eDstAlpha;
+			case BlendFactor::eOneMinusDstAlpha:
+				return vk::BlendFactor::eOneMinusDstAlpha;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown BlendFactor to vk::BlendFactor!");
+				break;
+		}
+		return {};
+	}
+
+	auto convert_blend_op_to_vk_blend_op(BlendOp blendOp) -> vk::BlendOp
+	{
+		switch (blendOp)
+		{
+			case BlendOp::eAdd:
+				return vk::BlendOp::eAdd;
+			case BlendOp::eSubtract:
+				return vk::BlendOp::eSubtract;
+			case BlendOp::eReverseSubtract:
+				return vk::BlendOp::eReverseSubtract;
+			case BlendOp::eMin:
+				return vk::BlendOp::eMin;
+			case BlendOp::eMax:
+				return vk::BlendOp::eMax;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown BlendOp to vk::BlendOp!");
+				break;
+		}
+		return {};
+	}
+
+	auto convert_stencil_state_to_vk_stencil_op_state(const StencilState& stencilState) -> vk::StencilOpState
+	{
+		vk::StencilOpState vk_state{};
+		vk_state.setFailOp(convert_stencil_op_to_vk_stencil_op(stencilState.failOp));
+		vk_state.setPassOp(convert_stencil_op_to_vk_stencil_op(stencilState.passOp));
+		vk_state.setDepthFailOp(convert_stencil_op_to_vk_stencil_op(stencilState.depthFailOp));
+		vk_state.setCompareOp(convert_compare_op_to_vk_compare_op(stencilState.compareOp));
+		vk_state.setCompareMask(stencilState.compareMask);
+		vk_state.setWriteMask(stencilState.writeMask);
+		vk_state.setReference(stencilState.reference);
+		return vk_state;
+	}
+
+	/**
+	 * @brief Describe constants to Vulkan in place, their values are read straight from the SpecializationConstant array.
+	 * @param outEntries Must outlive the returned info.
+	 */
+	auto get_vk_specialization_info(std::span<const SpecializationConstant> constants, ScratchVector<vk::SpecializationMapEntry>& outEntries) -> vk::SpecializationInfo
+	{
+		outEntries.resize(constants.size());
+		for (auto i = 0; i < constants.size(); ++i)
+		{
+			outEntries[i] = vk::SpecializationMapEntry{ constants[i].id, std::uint32_t(i * sizeof(SpecializationConstant) + offsetof(SpecializationConstant, value)), sizeof(std::uint32_t) };
+		}
+		return vk::SpecializationInfo{ std::uint32_t(outEntries.size()), outEntries.data(), constants.size_bytes(), constants.data() };
+	}
+
+	/**
+	 * @brief Resolve where each of a binding's attributes is, packing those without an explicit offset after the one before.
+	 * @return The binding's stride.
+	 */
+	auto get_vertex_binding_layout(const VertexBinding& binding, ScratchVector<std::uint32_t>& outOffsets) -> std::uint32_t
+	{
+		outOffsets.resize(binding.attributes.size());
+		std::uint32_t nextOffset{ 0 };
+		std::uint32_t end{ 0 };
+		for (auto i = 0; i < binding.attributes.size(); ++i)
+		{
+			const auto& attribute = binding.attributes[i];
+			outOffsets[i] = attribute.offset != PACKED_VERTEX_OFFSET ? attribute.offset : nextOffset;
+			nextOffset = outOffsets[i] + convert_format_to_byte_size(attribute.format);
+			end = std::max(end, nextOffset);
+		}
+		return binding.stride != 0 ? binding.stride : end;
+	}
+
+	auto convert_blend_state_to_vk_color_blend_attachment_state(const BlendState& blendState) -> vk::PipelineColorBlendAttachmentState
+	{
+		vk::PipelineColorBlendAttachmentState vk_state{};
+		vk_state.setBlendEnable(blendState.blendEnable);
+		vk_state.setSrcColorBlendFactor(convert_blend_factor_to_vk_blend_factor(blendState.srcColorFactor));
+		vk_state.setDstColorBlendFactor(convert_blend_factor_to_vk_blend_factor(blendState.dstColorFactor));
+		vk_state.setColorBlendOp(convert_blend_op_to_vk_blend_op(blendState.colorOp));
+		vk_state.setSrcAlphaBlendFactor(convert_blend_factor_to_vk_blend_factor(blendState.srcAlphaFactor));
+		vk_state.setDstAlphaBlendFactor(convert_blend_factor_to_vk_blend_factor(blendState.dstAlphaFactor));
+		vk_state.setAlphaBlendOp(convert_blend_op_to_vk_blend_op(blendState.alphaOp));
+		vk_state.setColorWriteMask(vk::ColorComponentFlags(blendState.colorWriteMask)); // Same bit order as vk::ColorComponentFlagBits.
+		return vk_state;
+	}
+
+	/**
+	 * @brief Create a graphics pipeline, or library of one, from its stages and the fixed function state of graphicsPipelineInfo.
+	 * @param inputAssemblyState Null for mesh pipelines, which have neither vertex input nor input assembly.
+	 */
+	auto create_vk_graphics_pipeline(vk::Device device, const GraphicsPipelineInfo& graphicsPipelineInfo, std::span<const vk::PipelineShaderStageCreateInfo> stages,
+									 const vk::PipelineVertexInputStateCreateInfo* vertexInputState, const vk::PipelineInputAssemblyStateCreateInfo* inputAssemblyState,
+									 vk::PipelineLayout layout, vk::PipelineCache pipelineCache, vk::PipelineCreateFlags flags, vk::GraphicsPipelineLibraryFlagsEXT libraryParts = {}) -> vk::UniquePipeline
+	{
+		const ScratchScope scratchScope{};
+
+		vk::PipelineViewportStateCreateInfo viewport_state{}; // Counts are dynamic.
+
+		vk::PipelineRasterizationStateCreateInfo rasterisation_state{};
+		rasterisation_state.setPolygonMode(vk::PolygonMode::eFill);	  // TODO: Optional.
+		rasterisation_state.setCullMode(convert_cull_mode_to_vk_cull_mode(graphicsPipelineInfo.cullMode));
+		rasterisation_state.setFrontFace(convert_front_face_to_vk_front_face(graphicsPipelineInfo.frontFace));
+		rasterisation_state.setLineWidth(1.0f); // TODO: Optional.
+
+		vk::PipelineMultisampleStateCreateInfo multisample_state{};
+		multisample_state.setRasterizationSamples(vk::SampleCountFlagBits(graphicsPipelineInfo.sampleCount));
+
+		vk::PipelineDepthStencilStateCreateInfo depth_stencil_state{};
+		depth_stencil_state.setDepthTestEnable(graphicsPipelineInfo.depthTest);
+		depth_stencil_state.setDepthWriteEnable(graphicsPipelineInfo.depthTest && graphicsPipelineInfo.depthWrite);
+		depth_stencil_state.setDepthCompareOp(convert_compare_op_to_vk_compare_op(graphicsPipelineInfo.depthCompareOp));
+		depth_stencil_state.setStencilTestEnable(graphicsPipelineInfo.stencilTest);
+		depth_stencil_state.setFront(convert_stencil_state_to_vk_stencil_op_state(graphicsPipelineInfo.stencilFront));
+		depth_stencil_state.setBack(convert_stencil_state_to_vk_stencil_op_state(graphicsPipelineInfo.stencilBack));
+
+		// Every attachment needs a blend state, those not given one are written opaquely.
+		ScratchVector<vk::PipelineColorBlendAttachmentState> colorBlendAttachments(graphicsPipelineInfo.colorAttachments.size(), convert_blend_state_to_vk_color_blend_attachment_state({}));
+		for (auto i = 0; i < std::min(colorBlendAttachments.size(), graphicsPipelineInfo.colorBlendStates.size()); ++i)
+		{
+			colorBlendAttachments[i] = convert_blend_state_to_vk_color_blend_attachment_state(graphicsPipelineInfo.colorBlendStates[i]);
+		}
+		vk::PipelineColorBlendStateCreateInfo color_blend_state{};
+		color_blend_state.setAttachments(colorBlendAttachments);
+
+		// With their count, as shader objects need, so set_viewport() and set_scissor() work for both.
+		ScratchVector<vk::DynamicState> dynamicStates{
+			vk::DynamicState::eViewportWithCount,
+			vk::DynamicState::eScissorWithCount
+		};
+		const auto dynamicStateFlags = graphicsPipelineInfo.dynamicStates;
+		if (dynamicStateFlags & DynamicStateFlags_CullMode)
+		{
+			dynamicStates.push_back(vk::DynamicState::eCullMode);
+		}
+		if (dynamicStateFlags & DynamicStateFlags_FrontFace)
+		{
+			dynamicStates.push_back(vk::DynamicState::eFrontFace);
+		}
+		if ((dynamicStateFlags & DynamicStateFlags_Topology) && inputAssemblyState != nullptr)
+		{
+			dynamicStates.insert(dynamicStates.end(), { vk::DynamicState::ePrimitiveTopology, vk::DynamicState::ePrimitiveRestartEnable });
+		}
+		if (dynamicStateFlags & DynamicStateFlags_Depth)
+		{
+			dynamicStates.insert(dynamicStates.end(), { vk::DynamicState::eDepthTestEnable, vk::DynamicState::eDepthWriteEnable, vk::DynamicState::eDepthCompareOp });
+		}
+		if (dynamicStateFlags & DynamicStateFlags_Stencil)
+		{
+			dynamicStates.insert(dynamicStates.end(), { vk::DynamicState::eStencilTestEnable, vk::DynamicState::eStencilOp, vk::DynamicState::eStencilCompareMask,
+														vk::DynamicState::eStencilWriteMask, vk::DynamicState::eStencilReference });
+		}
+		if (dynamicStateFlags & DynamicStateFlags_Blend)
+		{
+			dynamicStates.insert(dynamicStates.end(), { vk::DynamicState::eColorBlendEnableEXT, vk::DynamicState::eColorBlendEquationEXT, vk::DynamicState::eColorWriteMaskEXT });
+		}
+		if (dynamicStateFlags & DynamicStateFlags_ShadingRate)
+		{
+			dynamicStates.push_back(vk::DynamicState::eFragmentShadingRateKHR);
+		}
+		vk::PipelineDynamicStateCreateInfo dynamic_state{};
+		dynamic_state.setDynamicStates(dynamicStates);
+
+		ScratchVector<vk::Format> colorAttachmentFormats(graphicsPipelineInfo.colorAttachments.size());
+		for (auto i = 0; i < colorAttachmentFormats.size(); ++i)
+		{
+			colorAttachmentFormats[i] = convert_format_to_vk_format(graphicsPipelineInfo.colorAttachments[i]);
+		}
+
+		vk::PipelineRenderingCreateInfo rendering_info{};
+		rendering_info.setViewMask(graphicsPipelineInfo.viewMask);
+		rendering_info.setColorAttachmentFormats(colorAttachmentFormats);
+		const auto depthFormat = convert_format_to_vk_format(graphicsPipelineInfo.depthAttachmentFormat);
+		if (graphicsPipelineInfo.depthTest || graphicsPipelineInfo.stencilTest)
+		{
+			rendering_info.setDepthAttachmentFormat(depthFormat);
+			if (get_format_aspect_mask(depthFormat) & vk::ImageAspectFlagBits::eStencil)
+			{
+				rendering_info.setStencilAttachmentFormat(depthFormat);
+			}
+		}
+
+		vk::GraphicsPipelineCreateInfo vk_pipeline_info{};
+		vk_pipeline_info.setFlags(flags);
+		vk_pipeline_info.setStages(stages);
+		vk_pipeline_info.setLayout(layout);
+		vk_pipeline_info.setPVertexInputState(vertexInputState);
+		vk_pipeline_info.setPInputAssemblyState(inputAssemblyState);
+		vk_pipeline_info.setPViewportState(&viewport_state);
+		vk_pipeline_info.setPRasterizationState(&rasterisation_state);
+		vk_pipeline_info.setPMultisampleState(&multisample_state);
+		vk_pipeline_info.setPDepthStencilState(&depth_stencil_state);
+		vk_pipeline_info.setPColorBlendState(&color_blend_state);
+		vk_pipeline_info.setPDynamicState(&dynamic_state);
+		vk_pipeline_info.setPNext(&rendering_info);
+
+		// Without it pipelines ignore the shading rate attachment, so it takes over from the default 1x1 rate.
+		vk::PipelineFragmentShadingRateStateCreateInfoKHR shading_rate_state{ vk::Extent2D{ 1, 1 }, { vk::FragmentShadingRateCombinerOpKHR::eKeep, vk::FragmentShadingRateCombinerOpKHR::eReplace } };
+		if (flags & vk::PipelineCreateFlagBits::eRenderingFragmentShadingRateAttachmentKHR)
+		{
+			shading_rate_state.setPNext(vk_pipeline_info.pNext);
+			vk_pipeline_info.setPNext(&shading_rate_state);
+		}
+
+		// State outside the library's parts is ignored. Optimisation info is kept so linked pipelines can be optimised.
+		vk::GraphicsPipelineLibraryCreateInfoEXT library_info{ libraryParts };
+		if (libraryParts)
+		{
+			vk_pipeline_info.setFlags(flags | vk::PipelineCreateFlagBits::eLibraryKHR | vk::PipelineCreateFlagBits::eRetainLinkTimeOptimizationInfoEXT);
+			library_info.setPNext(vk_pipeline_info.pNext);
+			vk_pipeline_info.setPNext(&library_info);
+		}
+
+		return device.createGraphicsPipelineUnique(pipelineCache, vk_pipeline_info).value;
+	}
+
+	auto convert_texture_usage_to_vk_image_usage(TextureUsage textureUsage) -> vk::ImageUsageFlags
+	{
+		switch (textureUsage)
+		{
+			case TextureUsage::eTexture:
+				return vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+			case TextureUsage::eColorAttachment:
+				return vk::ImageUsageFlagBits::eColorAttachment;
+			case TextureUsage::eDepthStencilAttachment:
+				return vk::ImageUsageFlagBits::eDepthStencilAttachment;
+			case TextureUsage::eShadingRate:
+				return vk::ImageUsageFlagBits::eFragmentShadingRateAttachmentKHR | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+			case TextureUsage::eStorage:
+				return vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+			default:
+				GFX_ASSERT(false, "Cannot convert unknown TextureUsage to vk::ImageUsageFlags!");
+				break;
+		}
+		return {};
+	}
+
+	// Resources of one shader stage read from its SPIR-V, for pipelines that leave their layout to reflection.
+	struct ShaderReflection
+	{
+		struct Binding
+		{
+			std::uint32_t set{ 0 };
+			std::uint32_t binding{ 0 };
+			std::optional<DescriptorType> type; // None for resources DescriptorType cannot describe, e.g. separate samplers.
+			std::uint32_t count{ 1 };			// 0 for runtime sized arrays.
+		};
+		std::vector<Binding> bindings;
+		std::uint32_t constantBlockSize{ 0 };
+	};
+
+	/**
+	 * @brief Find the descriptor bindings and push constant block of a SPIR-V module, without compiling it.
+	 * @return False if the code is not SPIR-V.
+	 */
+	bool reflect_spirv(ShaderReflection& outReflection, std::span<const std::uint32_t> code)
+	{
+		constexpr std::uint32_t SPIRV_MAGIC = 0x07230203;
+		constexpr std::uint32_t SPIRV_HEADER_WORDS = 5;
+		if (code.size() < SPIRV_HEADER_WORDS || code[0] != SPIRV_MAGIC)
+		{
+			return false;
+		}
+
+		enum : std::uint32_t
+		{
+			OpDecorate = 71,
+			OpMemberDecorate = 72,
+			OpTypeBool = 20,
+			OpTypeInt = 21,
+			OpTypeFloat = 22,
+			OpTypeVector = 23,
+			OpTypeMatrix = 24,
+			OpTypeImage = 25,
+			OpTypeSampledImage = 27,
+			OpTypeArray = 28,
+			OpTypeRuntimeArray = 29,
+			OpTypeStruct = 30,
+			OpTypePointer = 32,
+			OpConstant = 43,
+			OpVariable = 59,
+
+			DecorationBlock = 2,
+			DecorationBufferBlock = 3,
+			DecorationRowMajor = 4,
+			DecorationArrayStride = 6,
+			DecorationMatrixStride = 7,
+			DecorationBinding = 33,
+			DecorationDescriptorSet = 34,
+			DecorationOffset = 35,
+
+			StorageClassUniformConstant = 0,
+			StorageClassUniform = 2,
+			StorageClassPushConstant = 9,
+			StorageClassStorageBuffer = 12,
+
+			DimBuffer = 5,
+			DimSubpassData = 6,
+			ImageSampledStorage = 2, // OpTypeImage's Sampled operand for images read and written without a sampler.
+		};
+
+		struct Type
+		{
+			std::uint32_t opcode{ 0 };
+			std::vector<std::uint32_t> operands; // After the result id.
+		};
+		struct Decorations
+		{
+			std::optional<std::uint32_t> set;
+			std::optional<std::uint32_t> binding;
+			std::uint32_t arrayStride{ 0 };
+			bool block{ false };
+			bool bufferBlock{ false };
+		};
+		struct MemberDecorations
+		{
+			std::uint32_t offset{ 0 };
+			std::uint32_t matrixStride{ 0 };
+			bool rowMajor{ false };
+		};
+		struct Variable
+		{
+			std::uint32_t id;
+			std::uint32_t pointerType;
+			std::uint32_t storageClass;
+		};
+
+		std::unordered_map<std::uint32_t, Type> types;
+		std::unordered_map<std::uint32_t, std::uint32_t> constants;
+		std::unordered_map<std::uint32_t, Decorations> decorations;
+		std::unordered_map<std::uint64_t, MemberDecorations> memberDecorations; // Keyed by struct id << 32 | member.
+		std::vector<Variable> variables;
+
+		for (auto i = SPIRV_HEADER_WORDS; i < code.size();)
+		{
+			const auto wordCount = code[i] >> 16u;
+			const auto opcode = code[i] & 0xFFFFu;
+			if (wordCount == 0 || i + wordCount > code.size())
+			{
+				return false;
+			}
+			const auto operands = code.subspan(i + 1, wordCount - 1);
+			i += wordCount;
+
+			switch (opcode)
+			{
+				case OpDecorate:
+				{
+					if (operands.size() < 2)
+					{
+						break;
+					}
+					auto& decoration = decorations[operands[0]];
+					const auto value = operands.size() > 2 ? operands[2] : 0;
+					switch (operands[1])
+					{
+						case DecorationBlock:
+							decoration.block = true;
+							break;
+						case DecorationBufferBlock:
+							decoration.bufferBlock = true;
+							break;
+						case DecorationArrayStride:
+							decoration.arrayStride = value;
+							break;
+						case DecorationBinding:
+							decoration.binding = value;
+							break;
+						case DecorationDescriptorSet:
+							decoration.set = value;
+							break;
+						default:
+							break;
+					}
+					break;
+				}
+				case OpMemberDecorate:
+				{
+					if (operands.size() < 3)
+					{
+						break;
+					}
+					auto& decoration = memberDecorations[std::uint64_t(operands[0]) << 32u | operands[1]];
+					const auto value = operands.size() > 3 ? operands[3] : 0;
+					switch (operands[2])
+					{
+						case DecorationOffset:
+							decoration.offset = value;
+							break;
+						case DecorationMatrixStride:
+							decoration.matrixStride = value;
+							break;
+						case DecorationRowMajor:
+							decoration.rowMajor = true;
+							break;
+						default:
+							break;
+					}
+					break;
+				}
+				case OpTypeBool:
+				case OpTypeInt:
+				case OpTypeFloat:
+				case OpTypeVector:
+				case OpTypeMatrix:
+				case OpTypeImage:
+				case OpTypeSampledImage:
+				case OpTypeArray:
+				case OpTypeRuntimeArray:
+				case OpTypeStruct:
+				case OpTypePointer:
+					if (!operands.empty())
+					{
+						types[operands[0]] = Type{ opcode, { operands.begin() + 1, operands.end() } };
+					}
+					break;
+				case OpConstant:
+					if (operands.size() >= 3)
+					{
+						constants[operands[1]] = operands[2]; // The low word is enough for array lengths.
+					}
+					break;
+				case OpVariable:
+					if (operands.size() >= 3)
+					{
+						variables.push_back({ operands[1], operands[0], operands[2] });
+					}
+					break;
+				default:
+					break;
+			}
+		}
+
+		const auto get_type = [&](std::uint32_t id) -> const Type* {
+			const auto it = types.find(id);
+			return it != types.end() ? &it->second : nullptr;
+		};
+		// Bytes a value of the type occupies in an explicitly laid out block.
+		const std::function<std::uint32_t(std::uint32_t, const MemberDecorations*)> get_size = [&](std::uint32_t typeId, const MemberDecorations* member) -> std::uint32_t {
+			const auto* type = get_type(typeId);
+			if (type == nullptr)
+			{
+				return 0;
+			}
+			switch (type->opcode)
+			{
+				case OpTypeBool:
+					return 4;
+				case OpTypeInt:
+				case OpTypeFloat:
+					return type->operands.at(0) / 8;
+				case OpTypeVector:
+					return type->operands.at(1) * get_size(type->operands.at(0), nullptr);
+				case OpTypeMatrix:
+				{
+					const auto columnCount = type->operands.at(1);
+					if (member == nullptr || member->matrixStride == 0)
+					{
+						return columnCount * get_size(type->operands.at(0), nullptr);
+					}
+					// Row major matrices store a row per stride.
+					const auto* column = get_type(type->operands.at(0));
+					const auto vectorCount = member->rowMajor && column != nullptr ? column->operands.at(1) : columnCount;
+					return vectorCount * member->matrixStride;
+				}
+				case OpTypeArray:
+				{
+					const auto length = constants.contains(type->operands.at(1)) ? constants.at(type->operands.at(1)) : 0;
+					const auto stride = decorations.contains(typeId) ? decorations.at(typeId).arrayStride : 0;
+					return length * (stride != 0 ? stride : get_size(type->operands.at(0), member));
+				}
+				case OpTypeStruct:
+				{
+					std::uint32_t size{ 0 };
+					for (auto m = 0u; m < type->operands.size(); ++m)
+					{
+						const auto it = memberDecorations.find(std::uint64_t(typeId) << 32u | m);
+						const auto* memberDecoration = it != memberDecorations.end() ? &it->second : nullptr;
+						const auto offset = memberDecoration != nullptr ? memberDecoration->offset : size;
+						size = std::max(size, offset + get_size(type->operands[m], memberDecoration));
+					}
+					return size;
+				}
+				default:
+					return 0; // Runtime arrays add nothing.
+			}
+		};
+
+		outReflection = {};
+		for (const auto& variable : variables)
+		{
+			const auto* pointer = get_type(variable.pointerType);
+			if (pointer == nullptr || pointer->opcode != OpTypePointer || pointer->operands.size() < 2)
+			{
+				continue;
+			}
+			auto typeId = pointer->operands[1];
+
+			if (variable.storageClass == StorageClassPushConstant)
+			{
+				outReflection.constantBlockSize = std::max(outReflection.constantBlockSize, get_size(typeId, nullptr));
+				continue;
+			}
+			if (variable.storageClass != StorageClassUniformConstant && variable.storageClass != StorageClassUniform && variable.storageClass != StorageClassStorageBuffer)
+			{
+				continue;
+			}
+			const auto decoration = decorations.find(variable.id);
+			if (decoration == decorations.end() || !decoration->second.set || !decoration->second.binding)
+			{
+				continue;
+			}
+
+			ShaderReflection::Binding binding{ *decoration->second.set, *decoration->second.binding };
+			if (const auto* type = get_type(typeId); type != nullptr && (type->opcode == OpTypeArray || type->opcode == OpTypeRuntimeArray))
+			{
+				binding.count = type->opcode == OpTypeArray && constants.contains(type->operands.at(1)) ? constants.at(type->operands.at(1)) : 0;
+				typeId = type->operands.at(0);
+			}
+
+			const auto* type = get_type(typeId);
+			const auto typeDecoration = decorations.find(typeId);
+			const bool bufferBlock = typeDecoration != decorations.end() && typeDecoration->second.bufferBlock;
+			if (variable.storageClass == StorageClassStorageBuffer || (variable.storageClass == StorageClassUniform && bufferBlock))
+			{
+				binding.type = DescriptorType::eStorageBuffer;
+			}
+			else if (variable.storageClass == StorageClassUniform)
+			{
+				binding.type = DescriptorType::eUniformBuffer;
+			}
+			else if (type != nullptr && type->opcode == OpTypeSampledImage)
+			{
+				binding.type = DescriptorType::eTexture;
+			}
+			else if (type != nullptr && type->opcode == OpTypeImage && type->operands.size() > 1 && type->operands[1] == DimSubpassData)
+			{
+				binding.type = DescriptorType::eInputAttachment;
+			}
+			else if (type != nullptr && type->opcode == OpTypeImage && type->operands.size() > 5 && type->operands[1] != DimBuffer && type->operands[5] == ImageSampledStorage)
+			{
+				binding.type = DescriptorType::eStorageTexture;
+			}
+			outReflection.bindings.push_back(binding);
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Fill in the sets a pipeline left empty, and its constant block if it has no size, from what its shaders declare.
+	 * Bindings get exactly the stages that declare them, and are laid out by binding number, so pipelines whose shaders
+	 * declare the same interface get the same (shared) layouts. Binding numbers skipped by the shaders are left unused.
+	 * @param shaders The SPIR-V of each stage, with its ShaderStageFlags_.
+	 */
+	bool reflect_pipeline_layout(std::vector<DescriptorSetInfo>& inOutDescriptorSets, PipelineConstantBlock& inOutConstantBlock, std::span<const std::pair<std::span<const std::uint32_t>, std::uint32_t>> shaders)
+	{
+		const auto isLeftEmpty = [](const DescriptorSetInfo& set) { return set.bindings.empty() && !set.bindlessHeap && !set.push; };
+		const bool reflectConstants = inOutConstantBlock.size == 0;
+		if (!reflectConstants && !inOutDescriptorSets.empty() && std::ranges::none_of(inOutDescriptorSets, isLeftEmpty))
+		{
+			return true;
+		}
+
+		std::vector<bool> reflectedSets{};
+		for (const auto& set : inOutDescriptorSets)
+		{
+			reflectedSets.push_back(isLeftEmpty(set));
+		}
+		PipelineConstantBlock constantBlock{ 0, 0 };
+		for (const auto& [code, shaderStage] : shaders)
+		{
+			if (code.empty())
+			{
+				continue; // The stage is left out, eg. the fragment stage of a depth-only pipeline.
+			}
+
+			ShaderReflection reflection{};
+			if (!reflect_spirv(reflection, code))
+			{
+				s_errorCallback("GFX - Failed to reflect pipeline layout, shader code is not SPIR-V!");
+				return false;
+			}
+
+			if (reflection.constantBlockSize > 0)
+			{
+				constantBlock.size = std::max(constantBlock.size, reflection.constantBlockSize);
+				constantBlock.shaderStages |= shaderStage;
+			}
+			for (const auto& binding : reflection.bindings)
+			{
+				if (binding.set >= MAX_BOUND_DESCRIPTOR_SETS)
+				{
+					s_errorCallback("GFX - Failed to reflect pipeline layout, a shader uses a set past MAX_BOUND_DESCRIPTOR_SETS!");
+					return false;
+				}
+				if (binding.set >= inOutDescriptorSets.size())
+				{
+					inOutDescriptorSets.resize(binding.set + 1);
+					reflectedSets.resize(binding.set + 1, true);
+				}
+				if (!reflectedSets[binding.set])
+				{
+					continue;
+				}
+				if (!binding.type || binding.count == 0)
+				{
+					s_errorCallback("GFX - Failed to reflect pipeline layout, a shader uses a resource only a declared set can describe (eg. a separate sampler or a runtime array)!");
+					return false;
+				}
+
+				auto& bindings = inOutDescriptorSets[binding.set].bindings;
+				if (binding.binding >= bindings.size())
+				{
+					bindings.resize(binding.binding + 1, DescriptorBindingInfo{ DescriptorType::eUniformBuffer, 0, 0 });
+				}
+				auto& bindingInfo = bindings[binding.binding];
+				if (bindingInfo.shaderStages != 0 && (bindingInfo.type != *binding.type || bindingInfo.count != binding.count))
+				{
+					s_errorCallback("GFX - Failed to reflect pipeline layout, shader stages declare a binding differently!");
+					return false;
+				}
+				bindingInfo = { *binding.type, binding.count, bindingInfo.shaderStages | shaderStage };
+			}
+		}
+
+		if (reflectConstants)
+		{
+			inOutConstantBlock = constantBlock;
+		}
+		return true;
+	}
+
+#pragma endregion
+
+#pragma region Device Resources
+
+	bool wait_on_sync_point(SyncPoint syncPoint, std::uint64_t timeoutNs)
+	{
+		return wait_on_sync_points(std::span(&syncPoint, 1), true, timeoutNs);
+	}
+
+	bool wait_on_sync_points(std::span<const SyncPoint> syncPoints, bool waitAll, std::uint64_t timeoutNs)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		// Complete sync points carry no device.
+		const auto it = std::ranges::find_if(syncPoints, [](const SyncPoint& syncPoint) { return syncPoint.value != 0; });
+		if (it == syncPoints.end())
+		{
+			return true;
+		}
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, it->deviceHandle))
+		{
+			s_errorCallback("gfx::wait_on_sync_points() - syncPoints must be valid!");
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		const auto sameDevice = std::ranges::all_of(syncPoints, [&](const SyncPoint& syncPoint) { return syncPoint.value == 0 || syncPoint.deviceHandle == it->deviceHandle; });
+		if (!sameDevice)
+		{
+			s_errorCallback("gfx::wait_on_sync_points() - syncPoints must belong to the same device!");
+			return false;
+		}
+
+		return device->wait_on_sync_points(syncPoints, waitAll, timeoutNs);
+	}
+
+	bool is_sync_point_complete(SyncPoint syncPoint)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		if (syncPoint.value == 0)
+		{
+			return true;
+		}
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, syncPoint.deviceHandle))
+		{
+			s_errorCallback("gfx::is_sync_point_complete() - syncPoint must be valid!");
+			return true;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->is_sync_point_complete(syncPoint);
+	}
+
+	void destroy_semaphore(SemaphoreHandle semaphoreHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, semaphoreHandle.deviceHandle))
+		{
+			s_errorCallback("gfx::destroy_semaphore() - semaphoreHandle must be valid!");
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		device->destroy_semaphore(semaphoreHandle);
+	}
+
+	bool create_command_list(CommandListHandle& outCommandListHandle, DeviceHandle deviceHandle, std::uint32_t queueIndex, std::uint32_t flags)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (!device->create_command_list(outCommandListHandle, queueIndex, flags))
+		{
+			return false;
+		}
+		GFX_CAPTURE(device, eCreateCommandList, static_cast<std::uint64_t>(outCommandListHandle), queueIndex, flags);
+		return true;
+	}
+
+	bool create_secondary_command_list(CommandListHandle& outCommandListHandle, DeviceHandle deviceHandle, std::uint32_t queueIndex, std::uint32_t flags)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_command_list(outCommandListHandle, queueIndex, flags, vk::CommandBufferLevel::eSecondary);
+	}
+
+	bool create_transient_command_list(CommandListHandle& outCommandListHandle, DeviceHandle deviceHandle, std::uint32_t queueIndex)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (!device->create_transient_command_list(outCommandListHandle, queueIndex))
+		{
+			return false;
+		}
+		GFX_CAPTURE(device, eCreateTransientCommandList, static_cast<std::uint64_t>(outCommandListHandle), queueIndex);
+		return true;
+	}
+
+	void destroy_command_list(DeviceHandle deviceHandle, CommandListHandle commandListHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			s_errorCallback("gfx::destroy_command_list() - deviceHandle must be valid!");
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		GFX_CAPTURE(device, eDestroyCommandList, commandListHandle);
+		device->destroy_command_list(commandListHandle);
+	}
+
+	auto submit_command_list(const SubmitInfo& submitInfo, SemaphoreHandle* outSemaphoreHandle) -> SyncPoint
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, submitInfo.commandList.deviceHandle))
+		{
+			return {};
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+#if GFX_CAPTURE_ENABLED
+		if (auto* captureWriter = device->get_capture_writer())
+		{
+			device->capture_mapped_buffers();
+			const auto syncPoint = device->submit_command_list(submitInfo, outSemaphoreHandle);
+			captureWriter->record(CaptureOp::eSubmitCommandList, submitInfo, outSemaphoreHandle != nullptr, outSemaphoreHandle != nullptr ? static_cast<std::uint64_t>(*outSemaphoreHandle) : 0);
+			return syncPoint;
+		}
+#endif
+		return device->submit_command_list(submitInfo, outSemaphoreHandle);
+	}
+
+	auto submit_command_lists(DeviceHandle deviceHandle, std::uint32_t queueIndex, std::span<const SubmitBatch> batches) -> SyncPoint
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return {};
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+#if GFX_CAPTURE_ENABLED
+		if (auto* captureWriter = device->get_capture_writer())
+		{
+			device->capture_mapped_buffers();
+			const auto syncPoint = device->submit_command_lists(queueIndex, batches);
+			std::vector<CaptureSubmitBatch> capturedBatches(batches.size());
+			for (std::size_t i = 0; i < batches.size(); ++i)
+			{
+				const auto& batch = batches[i];
+				capturedBatches[i] = {
+					.commandLists = { batch.commandLists.begin(), batch.commandLists.end() },
+					.waitSemaphores = { batch.waitSemaphores.begin(), batch.waitSemaphores.end() },
+					.signalSemaphore = batch.outSignalSemaphoreHandle != nullptr,
+					.signalSemaphoreHandle = batch.outSignalSemaphoreHandle != nullptr ? static_cast<std::uint64_t>(*batch.outSignalSemaphoreHandle) : 0,
+					.swapChainHandle = batch.swapChainHandle,
+				};
+			}
+			captureWriter->record(CaptureOp::eSubmitCommandLists, queueIndex, capturedBatches);
+			return syncPoint;
+		}
+#endif
+		return device->submit_command_lists(queueIndex, batches);
+	}
+
+	ShaderCode::ShaderCode(const std::vector<char>& bytes) : m_owned(bytes.size() / sizeof(std::uint32_t))
+	{
+		GFX_ASSERT(bytes.size() % sizeof(std::uint32_t) == 0, "SPIR-V must be a whole number of words!");
+		std::memcpy(m_owned.data(), bytes.data(), m_owned.size() * sizeof(std::uint32_t));
+	}
+
+	bool ShaderCode::operator==(const ShaderCode& other) const
+	{
+		const auto words = get_words();
+		const auto otherWords = other.get_words();
+		if (words.data() == otherWords.data() && words.size() == otherWords.size())
+		{
+			return true; // Eg. views of the same archived shader.
+		}
+		if (m_contentHash != 0 && other.m_contentHash != 0 && m_contentHash != other.m_contentHash)
+		{
+			return false;
+		}
+		return std::ranges::equal(words, otherWords);
+	}
+
+	bool create_compute_pipeline(PipelineHandle& outPipelineHandle, DeviceHandle deviceHandle, const ComputePipelineInfo& computePipelineInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (!device->create_compute_pipeline(outPipelineHandle, computePipelineInfo))
+		{
+			return false;
+		}
+		GFX_CAPTURE(device, eCreateComputePipeline, static_cast<std::uint64_t>(outPipelineHandle), computePipelineInfo);
+		return true;
+	}
+
+	bool create_graphics_pipeline(PipelineHandle& outPipelineHandle, DeviceHandle deviceHandle, const GraphicsPipelineInfo& graphicsPipelineInfo)
+	{
+		GFX_ASSERT(graphicsPipelineInfo.vertexCode.empty() == false, "Graphics pipeline requires Vertex shader byte code!");
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (!device->create_graphics_pipeline(outPipelineHandle, graphicsPipelineInfo))
+		{
+			return false;
+		}
+		GFX_CAPTURE(device, eCreateGraphicsPipeline, static_cast<std::uint64_t>(outPipelineHandle), graphicsPipelineInfo);
+		return true;
+	}
+
+	bool create_mesh_pipeline(PipelineHandle& outPipelineHandle, DeviceHandle deviceHandle, const MeshPipelineInfo& meshPipelineInfo)
+	{
+		GFX_ASSERT(meshPipelineInfo.meshCode.empty() == false, "Mesh pipeline requires Mesh shader byte code!");
+		GFX_ASSERT(meshPipelineInfo.state.fragmentCode.empty() == false, "Mesh pipeline requires Fragment shader byte code!");
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (!device->create_mesh_pipeline(outPipelineHandle, meshPipelineInfo))
+		{
+			return false;
+		}
+		GFX_CAPTURE(device, eCreateMeshPipeline, static_cast<std::uint64_t>(outPipelineHandle), meshPipelineInfo);
+		return true;
+	}
+
+	bool create_compute_pipeline_async(PipelineHandle& outPipelineHandle, DeviceHandle deviceHandle, const ComputePipelineInfo& computePipelineInfo, PipelineHandle placeholderHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_compute_pipeline(outPipelineHandle, computePipelineInfo, true, placeholderHandle);
+	}
+
+	bool create_graphics_pipeline_async(PipelineHandle& outPipelineHandle, DeviceHandle deviceHandle, const GraphicsPipelineInfo& graphicsPipelineInfo, PipelineHandle placeholderHandle)
+	{
+		GFX_ASSERT(graphicsPipelineInfo.vertexCode.empty() == false, "Graphics pipeline requires Vertex shader byte code!");
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_graphics_pipeline(outPipelineHandle, graphicsPipelineInfo, true, placeholderHandle);
+	}
+
+	bool is_pipeline_ready(PipelineHandle pipelineHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, pipelineHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->is_pipeline_ready(pipelineHandle);
+	}
+
+	bool prewarm_pipelines(std::vector<PipelineHandle>& outPipelineHandles, DeviceHandle deviceHandle, const char* manifestPath)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		std::vector<PipelineManifest::PipelineInfo> pipelineInfos{};
+		if (!PipelineManifest::load(pipelineInfos, manifestPath))
+		{
+			s_errorCallback("GFX - prewarm_pipelines() - Failed to read the pipeline manifest, or it is of another version of gfx!");
+			return false;
+		}
+
+		// Through the public functions, so a capture in progress records them like any other pipeline.
+		outPipelineHandles.clear();
+		for (const auto& pipelineInfo : pipelineInfos)
+		{
+			PipelineHandle pipelineHandle{};
+			bool created{ false };
+			if (const auto* computeInfo = std::get_if<ComputePipelineInfo>(&pipelineInfo))
+			{
+				created = create_compute_pipeline_async(pipelineHandle, deviceHandle, *computeInfo);
+			}
+			else if (const auto* graphicsInfo = std::get_if<GraphicsPipelineInfo>(&pipelineInfo))
+			{
+				created = create_graphics_pipeline_async(pipelineHandle, deviceHandle, *graphicsInfo);
+			}
+			else
+			{
+				created = create_mesh_pipeline(pipelineHandle, deviceHandle, std::get<MeshPipelineInfo>(pipelineInfo));
+			}
+			if (created)
+			{
+				outPipelineHandles.push_back(pipelineHandle);
+			}
+		}
+		return true;
+	}
+
+	void destroy_pipeline(PipelineHandle pipelineHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, pipelineHandle.deviceHandle))
+		{
+			s_errorCallback("gfx::destroy_pipeline() - pipelineHandle must be valid!");
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		GFX_CAPTURE(device, eDestroyPipeline, pipelineHandle);
+		device->destroy_pipeline(pipelineHandle);
+	}
+
+	bool tune_compute_workgroup_size(std::uint32_t& outWorkgroupSize, DeviceHandle deviceHandle, const ComputeTuningInfo& tuningInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+		GFX_ASSERT(tuningInfo.record, "ComputeTuningInfo::record must be set!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		std::size_t key = std::hash<ComputePipelineInfo>{}(tuningInfo.pipelineInfo);
+		hash_combine(key, tuningInfo.workgroupSizeConstantId);
+		for (const auto candidate : tuningInfo.candidates)
+		{
+			hash_combine(key, candidate);
+		}
+		if (device->find_tuned_workgroup_size(outWorkgroupSize, key))
+		{
+			return true;
+		}
+
+		CommandListHandle commandListHandle{};
+		if (!create_command_list(commandListHandle, deviceHandle, tuningInfo.queueIndex))
+		{
+			return false;
+		}
+
+		const auto& properties = device->get_properties();
+		const auto maxSize = std::min(properties.maxComputeWorkGroupInvocations, properties.maxComputeWorkGroupSize[0]);
+		const auto fullSubgroupSize = tuningInfo.pipelineInfo.requireFullSubgroups ? tuningInfo.pipelineInfo.requiredSubgroupSize : 0u;
+		std::uint32_t bestSize{ 0 };
+		auto bestTime = std::chrono::steady_clock::duration::max();
+		for (const auto candidate : tuningInfo.candidates)
+		{
+			if (candidate == 0 || candidate > maxSize || (fullSubgroupSize != 0 && candidate % fullSubgroupSize != 0))
+			{
+				continue;
+			}
+
+			auto pipelineInfo = tuningInfo.pipelineInfo;
+			std::erase_if(pipelineInfo.specializationConstants, [&](const auto& constant) { return constant.id == tuningInfo.workgroupSizeConstantId; });
+			pipelineInfo.specializationConstants.push_back({ tuningInfo.workgroupSizeConstantId, candidate });
+			PipelineHandle pipelineHandle{};
+			if (!create_compute_pipeline(pipelineHandle, deviceHandle, pipelineInfo))
+			{
+				continue;
+			}
+
+			// The first submission warms caches and clocks, and is not counted.
+			for (std::uint32_t iteration = 0; iteration <= std::max(tuningInfo.iterations, 1u); ++iteration)
+			{
+				reset(commandListHandle);
+				begin(commandListHandle);
+				bind_pipeline(commandListHandle, pipelineHandle);
+				tuningInfo.record(commandListHandle, candidate);
+				end(commandListHandle);
+
+				const auto start = std::chrono::steady_clock::now();
+				wait_on_sync_point(submit_command_list({ .commandList = commandListHandle }));
+				const auto time = std::chrono::steady_clock::now() - start;
+				if (iteration != 0 && time < bestTime)
+				{
+					bestTime = time;
+					bestSize = candidate;
+				}
+			}
+			destroy_pipeline(pipelineHandle);
+		}
+		destroy_command_list(deviceHandle, commandListHandle);
+
+		if (bestSize == 0)
+		{
+			s_errorCallback("gfx::tune_compute_workgroup_size() - No candidate workgroup size could be used!");
+			return false;
+		}
+		device->set_tuned_workgroup_size(key, bestSize);
+		outWorkgroupSize = bestSize;
+		return true;
+	}
+
+	void destroy_descriptor_set(DescriptorSetHandle descriptorSetHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, descriptorSetHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		GFX_CAPTURE(device, eDestroyDescriptorSet, descriptorSetHandle);
+		device->destroy_descriptor_set(descriptorSetHandle);
+	}
+
+	bool create_descriptor_set(DescriptorSetHandle& outDescriptorSetHandle, DeviceHandle deviceHandle, const DescriptorSetInfo& setInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (!device->create_descriptor_set(outDescriptorSetHandle, setInfo))
+		{
+			return false;
+		}
+		GFX_CAPTURE(device, eCreateDescriptorSet, static_cast<std::uint64_t>(outDescriptorSetHandle), setInfo);
+		return true;
+	}
+
+	bool create_descriptor_set_from_pipeline(DescriptorSetHandle& outDescriptorSetHandle, PipelineHandle pipelineHandle, std::uint32_t set)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, pipelineHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (!device->create_descriptor_set_from_pipeline(outDescriptorSetHandle, pipelineHandle, set))
+		{
+			return false;
+		}
+		GFX_CAPTURE(device, eCreateDescriptorSetFromPipeline, static_cast<std::uint64_t>(outDescriptorSetHandle), pipelineHandle, set);
+		return true;
+	}
+
+	bool create_transient_descriptor_set(DescriptorSetHandle& outDescriptorSetHandle, DeviceHandle deviceHandle, const DescriptorSetInfo& setInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (!device->create_transient_descriptor_set(outDescriptorSetHandle, setInfo))
+		{
+			return false;
+		}
+		GFX_CAPTURE(device, eCreateTransientDescriptorSet, static_cast<std::uint64_t>(outDescriptorSetHandle), setInfo);
+		return true;
+	}
+
+	bool get_cached_descriptor_set(DescriptorSetHandle& outDescriptorSetHandle, DeviceHandle deviceHandle, const DescriptorSetInfo& setInfo, std::span<const DescriptorWrite> writes)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->get_cached_descriptor_set(outDescriptorSetHandle, setInfo, writes);
+	}
+
+	auto get_bindless_heap(DeviceHandle deviceHandle) -> DescriptorSetHandle
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return {};
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->get_bindless_heap();
+	}
+
+	auto get_texture_bindless_index(TextureHandle textureHandle) -> std::uint32_t
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, textureHandle.deviceHandle))
+		{
+			return INVALID_BINDLESS_INDEX;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->get_bindless_index(BINDLESS_TEXTURE_BINDING, textureHandle.resourceHandle);
+	}
+
+	auto get_sampler_bindless_index(SamplerHandle samplerHandle) -> std::uint32_t
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, samplerHandle.deviceHandle))
+		{
+			return INVALID_BINDLESS_INDEX;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->get_bindless_index(BINDLESS_SAMPLER_BINDING, samplerHandle.resourceHandle);
+	}
+
+	auto get_buffer_bindless_index(BufferHandle bufferHandle) -> std::uint32_t
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bufferHandle.deviceHandle))
+		{
+			return INVALID_BINDLESS_INDEX;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->get_bindless_index(BINDLESS_STORAGE_BUFFER_BINDING, bufferHandle.resourceHandle);
+	}
+
+	void bind_buffer_to_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t range)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+		if (descriptorSetHandle.deviceHandle != bufferHandle.deviceHandle)
+		{
+			s_errorCallback("GFX - Buffer must belong to the same device as the descriptor set it is to be bound too!");
+			return;
+		}
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, descriptorSetHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		GFX_CAPTURE(device, eBindBufferToDescriptorSet, descriptorSetHandle, binding, bufferHandle, offset, range);
+		device->bind_buffer_to_descriptor_set(descriptorSetHandle, binding, bufferHandle, offset, range);
+	}
+
+	void bind_texture_to_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, TextureHandle textureHandle, SamplerHandle samplerHandle)
+	{
+		bind_texture_view_to_descriptor_set(descriptorSetHandle, binding, { textureHandle, 0 }, samplerHandle);
+	}
+
+	void bind_texture_view_to_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, TextureViewHandle textureViewHandle, SamplerHandle samplerHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+		const auto textureHandle = textureViewHandle.textureHandle;
+		if (descriptorSetHandle.deviceHandle != textureHandle.deviceHandle)
+		{
+			s_errorCallback("GFX - Buffer must belong to the same device as the descriptor set it is to be bound too!");
+			return;
+		}
+		if (descriptorSetHandle.deviceHandle != samplerHandle.deviceHandle)
+		{
+			s_errorCallback("GFX - Sampler must belong to the same device as the descriptor set it is to be bound too!");
+			return;
+		}
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, descriptorSetHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		GFX_CAPTURE(device, eBindTextureToDescriptorSet, descriptorSetHandle, binding, textureHandle, textureViewHandle.viewIndex, samplerHandle);
+		device->bind_texture_to_descriptor_set(descriptorSetHandle, binding, textureHandle, samplerHandle, textureViewHandle.viewIndex);
+	}
+
+	void update_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::span<const DescriptorWrite> writes)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+		const auto isForeign = [&](auto handle) { return std::uint64_t(handle) != 0 && handle.deviceHandle != descriptorSetHandle.deviceHandle; };
+		for (const auto& write : writes)
+		{
+			if (isForeign(write.bufferHandle) || isForeign(write.textureHandle) || isForeign(write.samplerHandle))
+			{
+				s_errorCallback("GFX - Resources must belong to the same device as the descriptor set they are to be written to!");
+				return;
+			}
+		}
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, descriptorSetHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		GFX_CAPTURE(device, eUpdateDescriptorSet, descriptorSetHandle, writes);
+		device->update_descriptor_set(descriptorSetHandle, writes);
+	}
+
+	void write_inline_uniform_block(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, std::uint32_t offset, std::uint32_t size, const void* data)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, descriptorSetHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		GFX_CAPTURE(device, eWriteInlineUniformBlock, descriptorSetHandle, binding, offset, std::span(static_cast<const std::byte*>(data), size));
+		device->write_inline_uniform_block(descriptorSetHandle, binding, offset, size, data);
+	}
+
+	bool create_buffer(BufferHandle& outBufferHandle, DeviceHandle deviceHandle, const BufferInfo& bufferInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (!device->create_buffer(outBufferHandle, bufferInfo))
+		{
+			return false;
+		}
+		GFX_CAPTURE(device, eCreateBuffer, static_cast<std::uint64_t>(outBufferHandle), bufferInfo);
+		return true;
+	}
+
+	bool create_buffers(std::span<BufferHandle> outBufferHandles, DeviceHandle deviceHandle, std::span<const BufferInfo> bufferInfos)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_buffers(outBufferHandles, bufferInfos);
+	}
+
+	void destroy_buffer(BufferHandle bufferHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bufferHandle.deviceHandle))
+		{
+			s_errorCallback("gfx::destroy_buffer() - bufferHandle must be valid!");
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		GFX_CAPTURE(device, eDestroyBuffer, bufferHandle);
+		device->destroy_buffer(bufferHandle);
+	}
+
+	bool create_buffer_arena(BufferArenaHandle& outBufferArenaHandle, DeviceHandle deviceHandle, const BufferArenaInfo& bufferArenaInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_buffer_arena(outBufferArenaHandle, bufferArenaInfo);
+	}
+
+	void destroy_buffer_arena(BufferArenaHandle bufferArenaHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bufferArenaHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		device->destroy_buffer_arena(bufferArenaHandle);
+	}
+
+	bool allocate_from_buffer_arena(BufferAllocation& outAllocation, BufferArenaHandle bufferArenaHandle, std::uint64_t size, std::uint64_t alignment)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bufferArenaHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		BufferArena* bufferArena{ nullptr };
+		if (!device->get_buffer_arena(bufferArena, bufferArenaHandle))
+		{
+			return false;
+		}
+		return bufferArena->allocate(outAllocation, size, alignment);
+	}
+
+	void free_buffer_allocation(BufferArenaHandle bufferArenaHandle, const BufferAllocation& allocation)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bufferArenaHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		BufferArena* bufferArena{ nullptr };
+		if (!device->get_buffer_arena(bufferArena, bufferArenaHandle))
+		{
+			return;
+		}
+		bufferArena->free(allocation);
+	}
+
+	bool create_memory_heap(MemoryHeapHandle& outMemoryHeapHandle, DeviceHandle deviceHandle, const MemoryHeapInfo& memoryHeapInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_memory_heap(outMemoryHeapHandle, memoryHeapInfo);
+	}
+
+	void destroy_memory_heap(MemoryHeapHandle memoryHeapHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, memoryHeapHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		device->destroy_memory_heap(memoryHeapHandle);
+	}
+
+	bool get_placement_requirements(PlacementRequirements& outRequirements, DeviceHandle deviceHandle, const BufferInfo& bufferInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->get_placement_requirements(outRequirements, bufferInfo);
+	}
+
+	bool get_placement_requirements(PlacementRequirements& outRequirements, DeviceHandle deviceHandle, const TextureInfo& textureInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->get_placement_requirements(outRequirements, textureInfo);
+	}
+
+	bool create_buffer_placed(BufferHandle& outBufferHandle, MemoryHeapHandle memoryHeapHandle, std::uint64_t offset, const BufferInfo& bufferInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, memoryHeapHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_buffer_placed(outBufferHandle, memoryHeapHandle, offset, bufferInfo);
+	}
+
+	bool create_texture_placed(TextureHandle& outTextureHandle, MemoryHeapHandle memoryHeapHandle, std::uint64_t offset, const TextureInfo& textureInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, memoryHeapHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_texture_placed(outTextureHandle, memoryHeapHandle, offset, textureInfo);
+	}
+
+	bool allocate_from_memory_heap(MemoryHeapAllocation& outAllocation, MemoryHeapHandle memoryHeapHandle, std::uint64_t size, std::uint64_t alignment)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, memoryHeapHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		MemoryHeap* memoryHeap{ nullptr };
+		if (!device->get_memory_heap(memoryHeap, memoryHeapHandle))
+		{
+			return false;
+		}
+		return memoryHeap->allocate(outAllocation, size, alignment);
+	}
+
+	void free_memory_heap_allocation(MemoryHeapHandle memoryHeapHandle, const MemoryHeapAllocation& allocation)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, memoryHeapHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		MemoryHeap* memoryHeap{ nullptr };
+		if (!device->get_memory_heap(memoryHeap, memoryHeapHandle))
+		{
+			return;
+		}
+		memoryHeap->free(allocation);
+	}
+
+	bool create_buffer_exportable(BufferHandle& outBufferHandle, DeviceHandle deviceHandle, const BufferInfo& bufferInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_buffer_external(outBufferHandle, bufferInfo, nullptr);
+	}
+
+	bool create_texture_exportable(TextureHandle& outTextureHandle, DeviceHandle deviceHandle, const TextureInfo& textureInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_texture_external(outTextureHandle, textureInfo, nullptr);
+	}
+
+	bool export_buffer_memory(ExternalMemory& outMemory, BufferHandle bufferHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bufferHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->export_buffer_memory(outMemory, bufferHandle);
+	}
+
+	bool export_texture_memory(ExternalMemory& outMemory, TextureHandle textureHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, textureHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->export_texture_memory(outMemory, textureHandle);
+	}
+
+	bool import_buffer(BufferHandle& outBufferHandle, DeviceHandle deviceHandle, const ExternalMemory& memory, const BufferInfo& bufferInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_buffer_external(outBufferHandle, bufferInfo, &memory);
+	}
+
+	bool import_texture(TextureHandle& outTextureHandle, DeviceHandle deviceHandle, const ExternalMemory& memory, const TextureInfo& textureInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_texture_external(outTextureHandle, textureInfo, &memory);
+	}
+
+	bool export_queue_timeline(ExternalHandle& outHandle, DeviceHandle deviceHandle, std::uint32_t queueIndex)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->export_queue_timeline(outHandle, queueIndex);
+	}
+
+	bool import_semaphore(SemaphoreHandle& outSemaphoreHandle, DeviceHandle deviceHandle, ExternalHandle handle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->import_semaphore(outSemaphoreHandle, handle);
+	}
+
+	bool create_video_decoder(VideoDecoderHandle& outVideoDecoderHandle, DeviceHandle deviceHandle, const VideoDecoderInfo& decoderInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_video_decoder(outVideoDecoderHandle, decoderInfo);
+	}
+
+	void destroy_video_decoder(VideoDecoderHandle videoDecoderHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, videoDecoderHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		device->destroy_video_decoder(videoDecoderHandle);
+	}
+
+	bool set_video_parameters(VideoDecoderHandle videoDecoderHandle, const VideoParameters& parameters)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, videoDecoderHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		VideoDecoder* videoDecoder{ nullptr };
+		if (!device->get_video_decoder(videoDecoder, videoDecoderHandle))
+		{
+			return false;
+		}
+		return videoDecoder->set_parameters(parameters);
+	}
+
+	auto decode_video_frame(VideoDecoderHandle videoDecoderHandle, const VideoFrameInfo& frameInfo) -> SyncPoint
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, videoDecoderHandle.deviceHandle))
+		{
+			return {};
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		VideoDecoder* videoDecoder{ nullptr };
+		if (!device->get_video_decoder(videoDecoder, videoDecoderHandle))
+		{
+			return {};
+		}
+		return videoDecoder->decode_frame(frameInfo);
+	}
+
+	bool map_buffer(BufferHandle bufferHandle, void*& outBufferPtr)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bufferHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (!device->map_buffer(bufferHandle, outBufferPtr))
+		{
+			return false;
+		}
+#if GFX_CAPTURE_ENABLED
+		if (auto* captureWriter = device->get_capture_writer(); captureWriter != nullptr && device->get_mapped_pointer(bufferHandle) != nullptr)
+		{
+			captureWriter->add_mapped_buffer(bufferHandle);
+		}
+#endif
+		return true;
+	}
+
+	void unmap_buffer(BufferHandle bufferHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bufferHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+#if GFX_CAPTURE_ENABLED
+		device->capture_buffer_contents(bufferHandle, 0, WHOLE_SIZE);
+#endif
+		device->unmap_buffer(bufferHandle);
+	}
+
+	auto upload_buffer(BufferHandle bufferHandle, const void* data, std::uint64_t size, std::uint64_t offset, std::uint32_t queueIndex) -> SyncPoint
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bufferHandle.deviceHandle))
+		{
+			return {};
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		GFX_CAPTURE(device, eUploadBuffer, bufferHandle, offset, queueIndex, std::span(static_cast<const std::byte*>(data), size));
+		return device->upload_buffer(bufferHandle, data, size, offset, queueIndex);
+	}
+
+	bool queue_buffer_upload(BufferHandle bufferHandle, const void* data, std::uint64_t size, std::uint64_t offset)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bufferHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		auto* uploadManager = device->get_upload_manager();
+		if (uploadManager == nullptr)
+		{
+			s_errorCallback("GFX - queue_buffer_upload() - DeviceInfo::uploadBufferSize was not set!");
+			return false;
+		}
+		GFX_CAPTURE(device, eQueueBufferUpload, bufferHandle, offset, std::span(static_cast<const std::byte*>(data), size));
+		return uploadManager->queue_buffer_upload(bufferHandle, data, size, offset);
+	}
+
+	auto get_texture_level_size(Format format, std::uint32_t width, std::uint32_t height) -> std::uint64_t
+	{
+		return get_texture_level_size(convert_format_to_vk_format(format), width, height);
+	}
+
+	auto get_vertex_format_size(Format format) -> std::uint32_t
+	{
+		return convert_format_to_byte_size(format);
+	}
+
+	bool queue_texture_upload(TextureHandle textureHandle, const void* data, std::uint64_t size, std::uint32_t mipLevel)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, textureHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		auto* uploadManager = device->get_upload_manager();
+		if (uploadManager == nullptr)
+		{
+			s_errorCallback("GFX - queue_texture_upload() - DeviceInfo::uploadBufferSize was not set!");
+			return false;
+		}
+		GFX_CAPTURE(device, eQueueTextureUpload, textureHandle, mipLevel, std::span(static_cast<const std::byte*>(data), size));
+		return uploadManager->queue_texture_upload(textureHandle, data, size, mipLevel);
+	}
+
+	auto upload_texture(TextureHandle textureHandle, const void* data, std::uint64_t size, std::uint32_t queueIndex) -> SyncPoint
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, textureHandle.deviceHandle))
+		{
+			return {};
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		GFX_CAPTURE(device, eUploadTexture, textureHandle, queueIndex, std::span(static_cast<const std::byte*>(data), size));
+		return device->upload_texture(textureHandle, data, size, queueIndex);
+	}
+
+	auto flush_uploads(DeviceHandle deviceHandle, std::uint32_t dstQueueIndex) -> SyncPoint
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return {};
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		auto* uploadManager = device->get_upload_manager();
+		if (uploadManager == nullptr)
+		{
+			s_errorCallback("GFX - flush_uploads() - DeviceInfo::uploadBufferSize was not set!");
+			return {};
+		}
+		GFX_CAPTURE(device, eFlushUploads, dstQueueIndex);
+		return uploadManager->flush(dstQueueIndex);
+	}
+
+	bool allocate_buffer_upload(UploadAllocation& outAllocation, BufferHandle bufferHandle, std::uint64_t size, std::uint64_t offset)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		outAllocation = { .size = size };
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bufferHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		auto* uploadManager = device->get_upload_manager();
+		if (uploadManager == nullptr)
+		{
+			s_errorCallback("GFX - allocate_buffer_upload() - DeviceInfo::uploadBufferSize was not set!");
+			return false;
+		}
+		return uploadManager->allocate_buffer_upload(outAllocation, bufferHandle, size, offset);
+	}
+
+	bool allocate_texture_upload(UploadAllocation& outAllocation, TextureHandle textureHandle, std::uint32_t mipLevel)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		outAllocation = {};
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, textureHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		auto* uploadManager = device->get_upload_manager();
+		if (uploadManager == nullptr)
+		{
+			s_errorCallback("GFX - allocate_texture_upload() - DeviceInfo::uploadBufferSize was not set!");
+			return false;
+		}
+		return uploadManager->allocate_texture_upload(outAllocation, textureHandle, mipLevel);
+	}
+
+	void commit_upload(const UploadAllocation& allocation)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		const bool isBuffer = allocation.bufferHandle != 0;
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, isBuffer ? allocation.bufferHandle.deviceHandle : allocation.textureHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		auto* uploadManager = device->get_upload_manager();
+		if (uploadManager == nullptr)
+		{
+			return;
+		}
+		// Replayed as the queued upload it amounts to.
+		const std::span data(static_cast<const std::byte*>(allocation.data), allocation.size);
+		if (isBuffer)
+		{
+			GFX_CAPTURE(device, eQueueBufferUpload, allocation.bufferHandle, allocation.offset, data);
+		}
+		else
+		{
+			GFX_CAPTURE(device, eQueueTextureUpload, allocation.textureHandle, allocation.mipLevel, data);
+		}
+		uploadManager->commit(allocation, true);
+	}
+
+	void cancel_upload(const UploadAllocation& allocation)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		const bool isBuffer = allocation.bufferHandle != 0;
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, isBuffer ? allocation.bufferHandle.deviceHandle : allocation.textureHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (auto* uploadManager = device->get_upload_manager())
+		{
+			uploadManager->commit(allocation, false);
+		}
+	}
+
+	auto get_mapped_pointer(BufferHandle bufferHandle) -> void*
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bufferHandle.deviceHandle))
+		{
+			return nullptr;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		auto* mappedPtr = device->get_mapped_pointer(bufferHandle);
+#if GFX_CAPTURE_ENABLED
+		if (auto* captureWriter = device->get_capture_writer(); captureWriter != nullptr && mappedPtr != nullptr)
+		{
+			captureWriter->add_mapped_buffer(bufferHandle);
+		}
+#endif
+		return mappedPtr;
+	}
+
+	auto get_buffer_device_address(BufferHandle bufferHandle) -> std::uint64_t
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bufferHandle.deviceHandle))
+		{
+			return 0;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->get_buffer_device_address(bufferHandle);
+	}
+
+	void flush_buffer_range(BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t size)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bufferHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+#if GFX_CAPTURE_ENABLED
+		device->capture_buffer_contents(bufferHandle, offset, size);
+#endif
+		device->flush_buffer_range(bufferHandle, offset, size);
+	}
+
+	void invalidate_buffer_range(BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t size)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bufferHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		device->invalidate_buffer_range(bufferHandle, offset, size);
+	}
+
+	bool create_texture(TextureHandle& outTextureHandle, DeviceHandle deviceHandle, const TextureInfo& textureInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (!device->create_texture(outTextureHandle, textureInfo))
+		{
+			return false;
+		}
+		GFX_CAPTURE(device, eCreateTexture, static_cast<std::uint64_t>(outTextureHandle), textureInfo);
+		return true;
+	}
+
+	bool create_textures(std::span<TextureHandle> outTextureHandles, DeviceHandle deviceHandle, std::span<const TextureInfo> textureInfos)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_textures(outTextureHandles, textureInfos);
+	}
+
+	bool create_aliased_textures(std::span<TextureHandle> outTextureHandles, DeviceHandle deviceHandle, std::span<const TextureInfo> textureInfos, std::span<const TextureLifetime> lifetimes)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_aliased_textures(outTextureHandles, textureInfos, lifetimes);
+	}
+
+	void destroy_texture(TextureHandle textureHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, textureHandle.deviceHandle))
+		{
+			s_errorCallback("gfx::destroy_texture() - textureHandle must be valid!");
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		GFX_CAPTURE(device, eDestroyTexture, textureHandle);
+		device->destroy_texture(textureHandle);
+	}
+
+	bool create_texture_view(TextureViewHandle& outTextureViewHandle, TextureHandle textureHandle, const TextureViewInfo& textureViewInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, textureHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		GFX_CAPTURE(device, eCreateTextureView, textureHandle, textureViewInfo);
+		return device->create_texture_view(outTextureViewHandle, textureHandle, textureViewInfo);
+	}
+
+	bool create_streaming_texture(TextureHandle& outTextureHandle, DeviceHandle deviceHandle, const TextureInfo& textureInfo, std::uint32_t firstResidentMip)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_streaming_texture(outTextureHandle, textureInfo, firstResidentMip);
+	}
+
+	auto get_texture_first_resident_mip(TextureHandle textureHandle) -> std::uint32_t
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, textureHandle.deviceHandle))
+		{
+			return 0;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->get_texture_first_resident_mip(textureHandle);
+	}
+
+	auto stream_texture_mips(TextureHandle textureHandle, std::uint32_t firstResidentMip, std::span<const std::span<const std::byte>> levelData, std::uint32_t queueIndex) -> SyncPoint
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, textureHandle.deviceHandle))
+		{
+			return {};
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->stream_texture_mips(textureHandle, firstResidentMip, levelData, queueIndex);
+	}
+
+	auto fit_texture_streaming_budget(DeviceHandle deviceHandle, std::span<TextureStreamingRequest> requests, float budgetFraction) -> std::uint64_t
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return 0;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->fit_texture_streaming_budget(requests, budgetFraction);
+	}
+
+	auto get_sparse_page_size(BufferHandle bufferHandle) -> std::uint64_t
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bufferHandle.deviceHandle))
+		{
+			return 0;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->get_sparse_page_size(bufferHandle);
+	}
+
+	bool get_sparse_texture_properties(SparseTextureProperties& outProperties, TextureHandle textureHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, textureHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->get_sparse_texture_properties(outProperties, textureHandle);
+	}
+
+	auto bind_sparse_buffer_pages(BufferHandle bufferHandle, std::uint32_t queueIndex, std::span<const SparseBufferBind> binds, std::span<const SyncPoint> waitSyncPoints) -> SyncPoint
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bufferHandle.deviceHandle))
+		{
+			return {};
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->bind_sparse_buffer_pages(bufferHandle, queueIndex, binds, waitSyncPoints);
+	}
+
+	auto bind_sparse_texture_tiles(TextureHandle textureHandle, std::uint32_t queueIndex, std::span<const SparseTextureBind> binds, std::span<const SyncPoint> waitSyncPoints) -> SyncPoint
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, textureHandle.deviceHandle))
+		{
+			return {};
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->bind_sparse_texture_tiles(textureHandle, queueIndex, binds, waitSyncPoints);
+	}
+
+	bool create_sampler(SamplerHandle& outSamplerHandle, DeviceHandle deviceHandle, const SamplerInfo& samplerInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (!device->create_sampler(outSamplerHandle, samplerInfo))
+		{
+			return false;
+		}
+		GFX_CAPTURE(device, eCreateSampler, static_cast<std::uint64_t>(outSamplerHandle), samplerInfo);
+		return true;
+	}
+
+	void destroy_sampler(SamplerHandle samplerHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, samplerHandle.deviceHandle))
+		{
+			s_errorCallback("gfx::destroy_sampler() - samplerHandle must be valid!");
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		GFX_CAPTURE(device, eDestroySampler, samplerHandle);
+		device->destroy_sampler(samplerHandle);
+	}
+
+	bool create_swap_chain(SwapChainHandle& outSwapChainHandle, DeviceHandle deviceHandle, const SwapChainInfo& swapChainInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (!device->create_swap_chain(outSwapChainHandle, swapChainInfo))
+		{
+			return false;
+		}
+		GFX_CAPTURE(device, eCreateSwapChain, static_cast<std::uint64_t>(outSwapChainHandle), swapChainInfo);
+		return true;
+	}
+
+	void destroy_swap_chain(SwapChainHandle swapChainHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, swapChainHandle.deviceHandle))
+		{
+			s_errorCallback("gfx::destroy_swap_chain() - swapChainHandle must be valid!");
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		GFX_CAPTURE(device, eDestroySwapChain, swapChainHandle);
+		device->destroy_swap_chain(swapChainHandle);
+	}
+
+	void resize_swap_chain(SwapChainHandle swapChainHandle, std::int32_t width, std::int32_t height)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, swapChainHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		SwapChain* swapChain{ nullptr };
+		if (!device->get_swap_chain(swapChain, swapChainHandle))
+		{
+			return;
+		}
+
+		swapChain->wait_for_present();
+		swapChain->request_resize(static_cast<std::uint32_t>(std::max(width, 0)), static_cast<std::uint32_t>(std::max(height, 0)));
+	}
+
+	void set_swap_chain_image_count(SwapChainHandle swapChainHandle, std::uint32_t imageCount)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, swapChainHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		SwapChain* swapChain{ nullptr };
+		if (!device->get_swap_chain(swapChain, swapChainHandle))
+		{
+			return;
+		}
+
+		swapChain->wait_for_present();
+		swapChain->request_image_count(imageCount);
+	}
+
+	auto get_swap_chain_image_count(SwapChainHandle swapChainHandle) -> std::uint32_t
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, swapChainHandle.deviceHandle))
+		{
+			return 0;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		SwapChain* swapChain{ nullptr };
+		if (!device->get_swap_chain(swapChain, swapChainHandle))
+		{
+			return 0;
+		}
+
+		swapChain->wait_for_present();
+		return swapChain->get_image_count();
+	}
+
+	void set_swap_chain_present_mode(SwapChainHandle swapChainHandle, PresentMode presentMode)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, swapChainHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		SwapChain* swapChain{ nullptr };
+		if (!device->get_swap_chain(swapChain, swapChainHandle))
+		{
+			return;
+		}
+
+		swapChain->wait_for_present();
+		swapChain->set_present_mode(presentMode);
+	}
+
+	auto present_swap_chain(SwapChainHandle swapChainHandle, std::uint32_t queueIndex, SemaphoreHandle* waitSemaphore, std::uint64_t desiredPresentTimeNs) -> std::uint64_t
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, swapChainHandle.deviceHandle))
+		{
+			return 0;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		vk::Queue queue{};
+		if (!device->get_queue(queue, queueIndex))
+		{
+			return 0;
+		}
+
+		SwapChain* swapChain{ nullptr };
+		if (!device->get_swap_chain(swapChain, swapChainHandle))
+		{
+			return 0;
+		}
+
+		vk::Semaphore wait_semaphore{};
+		if (waitSemaphore != nullptr && *waitSemaphore != 0 && !device->get_wait_semaphore(wait_semaphore, *waitSemaphore))
+		{
+			s_errorCallback("gfx::present_swap_chain() - waitSemaphore must be valid!");
+			return 0;
+		}
+
+		GFX_CAPTURE(device, ePresentSwapChain, swapChainHandle, queueIndex, waitSemaphore != nullptr ? *waitSemaphore : SemaphoreHandle{});
+		const auto presentId = device->present_swap_chain(*swapChain, queueIndex, wait_semaphore, desiredPresentTimeNs);
+
+		device->process_deferred_destruction();
+		return presentId;
+	}
+
+	bool present_swap_chains(std::span<const SwapChainHandle> swapChainHandles, std::uint32_t queueIndex, SemaphoreHandle* waitSemaphore, std::span<std::uint64_t> outPresentIds, std::uint64_t desiredPresentTimeNs)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		if (swapChainHandles.empty())
+		{
+			return true;
+		}
+		if (swapChainHandles.size() > SwapChain::MAX_BATCHED_PRESENTS || (!outPresentIds.empty() && outPresentIds.size() < swapChainHandles.size()))
+		{
+			s_errorCallback("gfx::present_swap_chains() - Too many swap chains, or fewer present ids than swap chains!");
+			return false;
+		}
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, swapChainHandles.front().deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		vk::Queue queue{};
+		if (!device->get_queue(queue, queueIndex))
+		{
+			return false;
+		}
+
+		InlineVector<SwapChain*, SwapChain::MAX_BATCHED_PRESENTS> swapChains{};
+		for (const auto swapChainHandle : swapChainHandles)
+		{
+			SwapChain* swapChain{ nullptr };
+			if (swapChainHandle.deviceHandle != swapChainHandles.front().deviceHandle || !device->get_swap_chain(swapChain, swapChainHandle))
+			{
+				s_errorCallback("gfx::present_swap_chains() - Swap chains must be valid and belong to the same device!");
+				return false;
+			}
+			if (std::ranges::find(swapChains, swapChain) != swapChains.end())
+			{
+				s_errorCallback("gfx::present_swap_chains() - A swap chain can only be presented once per call!");
+				return false;
+			}
+			swapChains.push_back(swapChain);
+		}
+
+		vk::Semaphore wait_semaphore{};
+		if (waitSemaphore != nullptr && *waitSemaphore != 0 && !device->get_wait_semaphore(wait_semaphore, *waitSemaphore))
+		{
+			s_errorCallback("gfx::present_swap_chains() - waitSemaphore must be valid!");
+			return false;
+		}
+
+		// Replayed as separate presents, the first of which waits on the semaphore.
+		for (auto i = 0u; i < swapChainHandles.size(); ++i)
+		{
+			GFX_CAPTURE(device, ePresentSwapChain, swapChainHandles[i], queueIndex, i == 0 && waitSemaphore != nullptr ? *waitSemaphore : SemaphoreHandle{});
+		}
+		std::array<std::uint64_t, SwapChain::MAX_BATCHED_PRESENTS> presentIds{};
+		device->present_swap_chains(swapChains, queueIndex, wait_semaphore, desiredPresentTimeNs, std::span(presentIds).first(swapChains.size()));
+		if (!outPresentIds.empty())
+		{
+			std::copy_n(presentIds.begin(), swapChains.size(), outPresentIds.begin());
+		}
+
+		device->process_deferred_destruction();
+		return true;
+	}
+
+	bool wait_for_swap_chain_present(SwapChainHandle swapChainHandle, std::uint64_t presentId, std::uint64_t timeoutNs)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, swapChainHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		SwapChain* swapChain{ nullptr };
+		if (!device->get_swap_chain(swapChain, swapChainHandle))
+		{
+			return false;
+		}
+
+		swapChain->wait_for_present();
+		return swapChain->wait_for_present_id(presentId, timeoutNs);
+	}
+
+	void latency_sleep(SwapChainHandle swapChainHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, swapChainHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		SwapChain* swapChain{ nullptr };
+		if (!device->get_swap_chain(swapChain, swapChainHandle))
+		{
+			return;
+		}
+
+		swapChain->wait_for_present();
+		swapChain->latency_sleep();
+	}
+
+	void set_latency_marker(SwapChainHandle swapChainHandle, LatencyMarker marker)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, swapChainHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		SwapChain* swapChain{ nullptr };
+		if (!device->get_swap_chain(swapChain, swapChainHandle))
+		{
+			return;
+		}
+
+		swapChain->set_latency_marker(marker);
+	}
+
+	bool get_swap_chain_present_timings(std::vector<PresentTiming>& outPresentTimings, SwapChainHandle swapChainHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		outPresentTimings.clear();
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, swapChainHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		SwapChain* swapChain{ nullptr };
+		if (!device->get_swap_chain(swapChain, swapChainHandle))
+		{
+			return false;
+		}
+
+		swapChain->wait_for_present();
+		return swapChain->get_present_timings(outPresentTimings);
+	}
+
+	bool get_swap_chain_refresh_duration(std::uint64_t& outRefreshDurationNs, SwapChainHandle swapChainHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, swapChainHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		SwapChain* swapChain{ nullptr };
+		if (!device->get_swap_chain(swapChain, swapChainHandle))
+		{
+			return false;
+		}
+
+		swapChain->wait_for_present();
+		return swapChain->get_refresh_duration(outRefreshDurationNs);
+	}
+
+	bool get_swap_chain_image(TextureHandle& outTextureHandle, SwapChainHandle swapChainHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, swapChainHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		SwapChain* swapChain{ nullptr };
+		if (!device->get_swap_chain(swapChain, swapChainHandle))
+		{
+			return false;
+		}
+
+		swapChain->wait_for_present();
+		outTextureHandle = swapChain->get_current_image_handle();
+		GFX_CAPTURE(device, eGetSwapChainImage, swapChainHandle, static_cast<std::uint64_t>(outTextureHandle));
+		return outTextureHandle > 0;
+	}
+
+#pragma endregion
+
+#pragma region Command List Recording
+
+	void reset(CommandListHandle commandListHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eReset, commandListHandle);
+		commandList->reset();
+	}
+
+	bool begin(CommandListHandle commandListHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return false;
+		}
+
+		GFX_CAPTURE(device, eBegin, commandListHandle);
+		commandList->begin();
+
+		return true;
+	}
+
+	void end(CommandListHandle commandListHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eEnd, commandListHandle);
+		commandList->end();
+		if (commandList->is_deferred())
+		{
+			device->translate_command_list(*commandList);
+		}
+		else
+		{
+			device->add_frame_stats(commandList->get_frame_stats());
+		}
+	}
+
+	void begin_gpu_scope(CommandListHandle commandListHandle, std::string_view name)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		device->begin_gpu_scope(*commandList, name);
+	}
+
+	void end_gpu_scope(CommandListHandle commandListHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		device->end_gpu_scope(*commandList);
+	}
+
+	void begin_gpu_query(CommandListHandle commandListHandle, GpuQueryType type, std::string_view name)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		device->begin_gpu_query(*commandList, type, name);
+	}
+
+	void end_gpu_query(CommandListHandle commandListHandle, GpuQueryType type)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		device->end_gpu_query(*commandList, type);
+	}
+
+	void push_marker(CommandListHandle commandListHandle, std::string_view name)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, ePushMarker, commandListHandle, std::string(name));
+		commandList->push_marker(name);
+	}
+
+	void pop_marker(CommandListHandle commandListHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, ePopMarker, commandListHandle);
+		commandList->pop_marker();
+	}
+
+	void begin_render_pass(CommandListHandle commandListHandle, const RenderPassInfo& renderPassInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		InlineVector<Texture*, MAX_COLOR_ATTACHMENTS> colorAttachments{};
+		Texture* depthAttachment{ nullptr };
+		InlineVector<Texture*, MAX_COLOR_ATTACHMENTS> resolveAttachments{};
+		ShadingRateAttachment shadingRateAttachment{};
+		if (!device->get_render_pass_attachments(colorAttachments, depthAttachment, renderPassInfo) || !device->get_render_pass_resolve_attachments(resolveAttachments, colorAttachments, renderPassInfo) ||
+			!device->get_render_pass_shading_rate_attachment(shadingRateAttachment, renderPassInfo))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eBeginRenderPass, commandListHandle, renderPassInfo);
+		const AttachmentOps attachmentOps{ renderPassInfo.colorLoadOps, renderPassInfo.colorStoreOps, renderPassInfo.depthLoadOp, renderPassInfo.depthStoreOp, renderPassInfo.localRead };
+		commandList->begin_render_pass(colorAttachments, depthAttachment, renderPassInfo.clearColor, renderPassInfo.secondaryCommandLists,
+										 std::span(renderPassInfo.colorAttachmentViews.data(), colorAttachments.size()), renderPassInfo.depthAttachmentView, resolveAttachments, attachmentOps,
+										 convert_render_area_to_vk_rect_2d(renderPassInfo.renderArea), renderPassInfo.viewMask, shadingRateAttachment);
+	}
+
+	bool begin_secondary(CommandListHandle commandListHandle, const RenderPassInfo& renderPassInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return false;
+		}
+
+		InlineVector<Texture*, MAX_COLOR_ATTACHMENTS> colorAttachments{};
+		Texture* depthAttachment{ nullptr };
+		if (!device->get_render_pass_attachments(colorAttachments, depthAttachment, renderPassInfo))
+		{
+			return false;
+		}
+
+		commandList->begin_secondary(colorAttachments, depthAttachment, renderPassInfo.viewMask);
+		return true;
+	}
+
+	void execute_commands(CommandListHandle commandListHandle, std::span<const CommandListHandle> secondaryCommandLists)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		// Executed in fixed-size batches, so any number of secondaries can be recorded without a heap allocation.
+		InlineVector<vk::CommandBuffer, 16> secondaryCommandBuffers{};
+		for (auto i = 0; i < secondaryCommandLists.size(); ++i)
+		{
+			CommandList* secondaryCommandList{ nullptr };
+			if (!device->get_command_list(secondaryCommandList, secondaryCommandLists[i]))
+			{
+				return;
+			}
+			GFX_ASSERT(secondaryCommandList->is_secondary(), "execute_commands() can only execute secondary command lists!");
+			secondaryCommandBuffers.push_back(secondaryCommandList->get_command_buffer());
+
+			if (secondaryCommandBuffers.size() == secondaryCommandBuffers.capacity())
+			{
+				commandList->execute_commands(secondaryCommandBuffers);
+				secondaryCommandBuffers.clear();
+			}
+		}
+
+		commandList->execute_commands(secondaryCommandBuffers);
+	}
+
+	void end_render_pass(CommandListHandle commandListHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eEndRenderPass, commandListHandle);
+		commandList->end_render_pass();
+	}
+
+	void set_viewport(CommandListHandle commandListHandle, float x, float y, float width, float height, float minDepth, float maxDepth)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eSetViewport, commandListHandle, x, y, width, height, minDepth, maxDepth);
+		commandList->set_viewport(x, y, width, height, minDepth, maxDepth);
+	}
+
+	void set_scissor(CommandListHandle commandListHandle, std::int32_t x, std::int32_t y, std::uint32_t width, std::uint32_t height)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eSetScissor, commandListHandle, x, y, width, height);
+		commandList->set_scissor(x, y, width, height);
+	}
+
+	void set_cull_mode(CommandListHandle commandListHandle, CullMode cullMode)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		commandList->set_cull_mode(convert_cull_mode_to_vk_cull_mode(cullMode));
+	}
+
+	void set_front_face(CommandListHandle commandListHandle, FrontFace frontFace)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		commandList->set_front_face(convert_front_face_to_vk_front_face(frontFace));
+	}
+
+	void set_primitive_topology(CommandListHandle commandListHandle, PrimitiveTopology topology, bool primitiveRestart)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		commandList->set_primitive_topology(convert_primitive_topology_to_vk_primitive_topology(topology), primitiveRestart);
+	}
+
+	void set_depth_state(CommandListHandle commandListHandle, bool depthTest, bool depthWrite, CompareOp depthCompareOp)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		commandList->set_depth_state(depthTest, depthWrite, convert_compare_op_to_vk_compare_op(depthCompareOp));
+	}
+
+	void set_stencil_state(CommandListHandle commandListHandle, bool stencilTest, const StencilState& stencilFront, const StencilState& stencilBack)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		commandList->set_stencil_state(stencilTest, convert_stencil_state_to_vk_stencil_op_state(stencilFront), convert_stencil_state_to_vk_stencil_op_state(stencilBack));
+	}
+
+	void set_blend_states(CommandListHandle commandListHandle, std::uint32_t firstAttachment, std::span<const BlendState> blendStates)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+		if (!device->supports_dynamic_blend_state())
+		{
+			s_errorCallback("GFX - set_blend_states() - Dynamic blend state is not supported by this device!");
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		InlineVector<vk::PipelineColorBlendAttachmentState, MAX_COLOR_ATTACHMENTS> vk_blend_states{};
+		for (const auto& blendState : blendStates)
+		{
+			vk_blend_states.push_back(convert_blend_state_to_vk_color_blend_attachment_state(blendState));
+		}
+		commandList->set_blend_states(firstAttachment, vk_blend_states);
+	}
+
+	void set_shading_rate(CommandListHandle commandListHandle, ShadingRate shadingRate, ShadingRateCombiner attachmentCombiner)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+		if (!device->supports_shading_rate())
+		{
+			s_errorCallback("GFX - set_shading_rate() - Variable rate shading needs DeviceFeatureFlags_ShadingRate!");
+			return;
+		}
+		if ((attachmentCombiner == ShadingRateCombiner::eMin || attachmentCombiner == ShadingRateCombiner::eMax) && !device->get_properties().shadingRateCombiners)
+		{
+			s_errorCallback("GFX - set_shading_rate() - ShadingRateCombiner::eMin and eMax are not supported by this device!");
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		commandList->set_shading_rate(convert_shading_rate_to_vk_extent_2d(shadingRate),
+									  { vk::FragmentShadingRateCombinerOpKHR::eKeep, convert_shading_rate_combiner_to_vk_fragment_shading_rate_combiner_op(attachmentCombiner) });
+	}
+
+	void begin_conditional(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset, bool inverted)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+		GFX_ASSERT(offset % 4 == 0, "Conditional rendering predicates must be 4 byte aligned!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+		if (!device->supports_conditional_rendering())
+		{
+			s_errorCallback("GFX - begin_conditional() - Conditional rendering needs DeviceFeatureFlags_ConditionalRendering!");
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		Buffer* buffer{ nullptr };
+		if (!device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+		if (!(buffer->get_usage_flags() & vk::BufferUsageFlagBits::eConditionalRenderingEXT))
+		{
+			s_errorCallback("GFX - begin_conditional() - The buffer was not created with BufferInfo::predicate!");
+			return;
+		}
+
+		commandList->begin_conditional(buffer, offset, inverted);
+	}
+
+	void end_conditional(CommandListHandle commandListHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		commandList->end_conditional();
+	}
+
+	void local_read_barrier(CommandListHandle commandListHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		commandList->local_read_barrier();
+	}
+
+	void bind_pipeline(CommandListHandle commandListHandle, PipelineHandle pipelineHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Pipeline* pipeline{ nullptr };
+		if (!device->get_bindable_pipeline(pipeline, pipelineHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(pipeline != nullptr, "Pipeline should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eBindPipeline, commandListHandle, pipelineHandle);
+		commandList->bind_pipeline(pipeline);
+	}
+
+	void bind_descriptor_sets(CommandListHandle commandListHandle, std::uint32_t firstSet, std::span<const DescriptorSetHandle> descriptorSets, std::span<const std::uint32_t> dynamicOffsets)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (descriptorSets.size() > MAX_BOUND_DESCRIPTOR_SETS)
+		{
+			s_errorCallback("GFX - Cannot bind more than MAX_BOUND_DESCRIPTOR_SETS descriptor sets at once!");
+			return;
+		}
+		if (dynamicOffsets.size() > MAX_DYNAMIC_OFFSETS)
+		{
+			s_errorCallback("GFX - Cannot bind more than MAX_DYNAMIC_OFFSETS dynamic offsets at once!");
+			return;
+		}
+		if (device->get_descriptor_buffer() != nullptr)
+		{
+			CommandList* commandList{ nullptr };
+			if (device->get_command_list(commandList, commandListHandle))
+			{
+				device->bind_descriptor_buffer_sets(*commandList, firstSet, descriptorSets, dynamicOffsets);
+			}
+			return;
+		}
+
+		InlineVector<vk::DescriptorSet, MAX_BOUND_DESCRIPTOR_SETS> vkDescriptorSets{};
+		vkDescriptorSets.resize(descriptorSets.size());
+		for (auto i = 0; i < descriptorSets.size(); ++i)
+		{
+			auto descriptorSet = descriptorSets[i];
+			if (!device->get_descriptor_set(vkDescriptorSets[i], descriptorSet))
+			{
+				return;
+			}
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eBindDescriptorSets, commandListHandle, firstSet, descriptorSets, dynamicOffsets);
+		commandList->bind_descriptor_sets(firstSet, vkDescriptorSets, dynamicOffsets);
+	}
+
+	void push_descriptors(CommandListHandle commandListHandle, std::uint32_t set, std::span<const DescriptorWrite> writes)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		device->push_descriptors(*commandList, set, writes);
+	}
+
+	void set_constants(CommandListHandle commandListHandle, std::uint32_t shaderStages, std::uint32_t offset, std::uint32_t size, const void* data)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		auto vk_shader_stages = convert_shader_stages_to_vk_shader_stage_flags(shaderStages);
+		GFX_CAPTURE(device, eSetConstants, commandListHandle, shaderStages, offset, std::span(static_cast<const std::byte*>(data), size));
+		commandList->set_constants(vk_shader_stages, offset, size, data);
+	}
+
+	void dispatch(CommandListHandle commandListHandle, std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eDispatch, commandListHandle, groupCountX, groupCountY, groupCountZ);
+		commandList->dispatch(groupCountX, groupCountY, groupCountZ);
+	}
+
+	void dispatch_base(CommandListHandle commandListHandle, std::uint32_t baseGroupX, std::uint32_t baseGroupY, std::uint32_t baseGroupZ, std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		commandList->dispatch_base(baseGroupX, baseGroupY, baseGroupZ, groupCountX, groupCountY, groupCountZ);
+	}
+
+	void set_device_mask(CommandListHandle commandListHandle, std::uint32_t deviceMask)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+		if (deviceMask == 0 || (deviceMask & ~device->get_device_group_mask()) != 0)
+		{
+			s_errorCallback("gfx::set_device_mask() - deviceMask must be a non-empty subset of the device group!");
+			return;
+		}
+
+		commandList->set_device_mask(deviceMask);
+	}
+
+	void dispatch_indirect(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(offset % 4 == 0, "dispatch_indirect() offset must be a multiple of 4!");
+
+		Buffer* buffer{ nullptr };
+		if (!device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eDispatchIndirect, commandListHandle, bufferHandle, offset);
+		commandList->dispatch_indirect(buffer, offset);
+	}
+
+	void bind_index_buffer(CommandListHandle commandListHandle, BufferHandle bufferHandle, IndexType indexType, std::uint64_t offset)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		Buffer* buffer{ nullptr };
+		if (!device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		auto vk_index_type = indexType == IndexType::eUInt16 ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+		GFX_CAPTURE(device, eBindIndexBuffer, commandListHandle, bufferHandle, indexType, offset);
+		commandList->bind_index_buffer(buffer, vk_index_type, offset);
+	}
+
+	void bind_vertex_buffers(CommandListHandle commandListHandle, std::uint32_t firstBinding, std::span<const BufferHandle> buffers, std::span<const std::uint64_t> offsets)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		if (buffers.size() > MAX_VERTEX_BUFFER_BINDINGS)
+		{
+			s_errorCallback("GFX - Cannot bind more than MAX_VERTEX_BUFFER_BINDINGS vertex buffers at once!");
+			return;
+		}
+		if (!offsets.empty() && offsets.size() != buffers.size())
+		{
+			s_errorCallback("GFX - bind_vertex_buffers() - offsets must be empty or match the number of buffers!");
+			return;
+		}
+
+		InlineVector<vk::Buffer, MAX_VERTEX_BUFFER_BINDINGS> vkBuffers{};
+		vkBuffers.resize(buffers.size());
+		for (auto i = 0; i < buffers.size(); ++i)
+		{
+			Buffer* buffer{ nullptr };
+			if (!device->get_buffer(buffer, buffers[i]))
+			{
+				return;
+			}
+			vkBuffers[i] = buffer->get_buffer();
+		}
+
+		GFX_CAPTURE(device, eBindVertexBuffers, commandListHandle, firstBinding, buffers, offsets);
+		commandList->bind_vertex_buffer(firstBinding, vkBuffers, offsets);
+	}
+
+	void draw(CommandListHandle commandListHandle, std::uint32_t vertex_count, std::uint32_t instance_count, std::uint32_t first_vertex, std::uint32_t first_instance)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eDraw, commandListHandle, vertex_count, instance_count, first_vertex, first_instance);
+		commandList->draw(vertex_count, instance_count, first_vertex, first_instance);
+	}
+
+	void draw_indexed(CommandListHandle commandListHandle, std::uint32_t index_count, std::uint32_t instance_count, std::uint32_t first_index, std::int32_t vertex_offset, std::uint32_t first_instance)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eDrawIndexed, commandListHandle, index_count, instance_count, first_index, vertex_offset, first_instance);
+		commandList->draw_indexed(index_count, instance_count, first_index, vertex_offset, first_instance);
+	}
+
+	void draw_indirect(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		Buffer* buffer{ nullptr };
+		if (!device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eDrawIndirect, commandListHandle, bufferHandle, offset, drawCount, stride);
+		record_indirect_draws(device->supports_multi_draw_indirect(), offset, drawCount, stride, [&](std::uint64_t drawOffset, std::uint32_t count) { commandList->draw_indirect(buffer, drawOffset, count, stride); });
+	}
+
+	void draw_indexed_indirect(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		Buffer* buffer{ nullptr };
+		if (!device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eDrawIndexedIndirect, commandListHandle, bufferHandle, offset, drawCount, stride);
+		record_indirect_draws(device->supports_multi_draw_indirect(), offset, drawCount, stride, [&](std::uint64_t drawOffset, std::uint32_t count) { commandList->draw_indexed_indirect(buffer, drawOffset, count, stride); });
+	}
+
+	void draw_indexed_indirect_count(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset, BufferHandle countBufferHandle, std::uint64_t countOffset, std::uint32_t maxDrawCount, std::uint32_t stride)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+		if (!device->supports_draw_indirect_count())
+		{
+			s_errorCallback("GFX - Device does not support draw indirect count!");
+			return;
+		}
+
+		Buffer* buffer{ nullptr };
+		Buffer* countBuffer{ nullptr };
+		if (!device->get_buffer(buffer, bufferHandle) || !device->get_buffer(countBuffer, countBufferHandle))
+		{
+			return;
+		}
+
+		commandList->draw_indexed_indirect_count(buffer, offset, countBuffer, countOffset, maxDrawCount, stride);
+	}
+
+	void draw_mesh_tasks(CommandListHandle commandListHandle, std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device->supports_mesh_shader(), "Device does not support mesh shaders!");
+
+		commandList->draw_mesh_tasks(groupCountX, groupCountY, groupCountZ);
+	}
+
+	void draw_mesh_tasks_indirect(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device->supports_mesh_shader(), "Device does not support mesh shaders!");
+
+		Buffer* buffer{ nullptr };
+		if (!device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		record_indirect_draws(device->supports_multi_draw_indirect(), offset, drawCount, stride, [&](std::uint64_t drawOffset, std::uint32_t count) { commandList->draw_mesh_tasks_indirect(buffer, drawOffset, count, stride); });
+	}
+
+	void draw_mesh_tasks_indirect_count(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset, BufferHandle countBufferHandle, std::uint64_t countOffset, std::uint32_t maxDrawCount, std::uint32_t stride)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device->supports_mesh_shader(), "Device does not support mesh shaders!");
+		if (!device->supports_draw_indirect_count())
+		{
+			s_errorCallback("GFX - Device does not support draw indirect count!");
+			return;
+		}
+
+		Buffer* buffer{ nullptr };
+		Buffer* countBuffer{ nullptr };
+		if (!device->get_buffer(buffer, bufferHandle) || !device->get_buffer(countBuffer, countBufferHandle))
+		{
+			return;
+		}
+
+		commandList->draw_mesh_tasks_indirect_count(buffer, offset, countBuffer, countOffset, maxDrawCount, stride);
+	}
+
+	void transition_texture(CommandListHandle commandListHandle, TextureHandle textureHandle, TextureState oldState, TextureState newState)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Texture* texture{ nullptr };
+		if (!device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eTransitionTexture, commandListHandle, textureHandle, true, oldState, newState);
+		commandList->transition_texture(texture, oldState, newState);
+	}
+
+	void transition_texture(CommandListHandle commandListHandle, TextureHandle textureHandle, TextureState newState)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Texture* texture{ nullptr };
+		if (!device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eTransitionTexture, commandListHandle, textureHandle, false, TextureState::eUndefined, newState);
+		commandList->transition_texture(texture, newState);
+	}
+
+	void transition_texture(CommandListHandle commandListHandle, TextureHandle textureHandle, TextureState newState, const TextureSubresourceRange& range)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Texture* texture{ nullptr };
+		if (!device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+		if (range.baseMipLevel >= texture->get_mip_levels() || range.baseArrayLayer >= texture->get_array_layers())
+		{
+			s_errorCallback("GFX - transition_texture() - Subresource range is out of range!");
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eTransitionTextureRange, commandListHandle, textureHandle, newState, range);
+		commandList->transition_texture(texture, newState, range.baseMipLevel, range.mipLevelCount, range.baseArrayLayer, range.arrayLayerCount);
+	}
+
+	void acquire_aliased_texture(CommandListHandle commandListHandle, TextureHandle textureHandle, TextureState newState)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Texture* texture{ nullptr };
+		if (!device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		commandList->acquire_aliased_texture(texture, newState);
+	}
+
+	void begin_texture_transition(CommandListHandle commandListHandle, TextureHandle textureHandle, TextureState newState)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Texture* texture{ nullptr };
+		if (!device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		commandList->begin_texture_transition(texture, newState);
+	}
+
+	void end_texture_transition(CommandListHandle commandListHandle, TextureHandle textureHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Texture* texture{ nullptr };
+		if (!device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		commandList->end_texture_transition(texture);
+	}
+
+	void transfer_texture_ownership(CommandListHandle commandListHandle, TextureHandle textureHandle, std::uint32_t srcQueueIndex, std::uint32_t dstQueueIndex, TextureState oldState, TextureState newState)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Texture* texture{ nullptr };
+		if (!device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		QueueOwnershipTransfer transfer{};
+		if (!device->get_ownership_transfer(transfer, *commandList, srcQueueIndex, dstQueueIndex))
+		{
+			return;
+		}
+
+		commandList->transfer_texture_ownership(texture, transfer, oldState, newState);
+	}
+
+	void transfer_buffer_ownership(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint32_t srcQueueIndex, std::uint32_t dstQueueIndex)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Buffer* buffer{ nullptr };
+		if (!device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		QueueOwnershipTransfer transfer{};
+		if (!device->get_ownership_transfer(transfer, *commandList, srcQueueIndex, dstQueueIndex))
+		{
+			return;
+		}
+
+		commandList->transfer_buffer_ownership(buffer, transfer);
+	}
+
+	void buffer_barrier(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint32_t srcStages, std::uint32_t dstStages)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Buffer* buffer{ nullptr };
+		if (!device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eBufferBarrier, commandListHandle, bufferHandle, srcStages, dstStages);
+		commandList->buffer_barrier(buffer, convert_pipeline_stages_to_vk_pipeline_stage_flags(srcStages), vk::AccessFlagBits2::eMemoryWrite,
+									convert_pipeline_stages_to_vk_pipeline_stage_flags(dstStages), vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite, 0, VK_WHOLE_SIZE);
+	}
+
+	void buffer_barrier(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint32_t srcStages, std::uint32_t srcAccess, std::uint32_t dstStages, std::uint32_t dstAccess, std::uint64_t offset, std::uint64_t size)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Buffer* buffer{ nullptr };
+		if (!device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eBufferBarrierRange, commandListHandle, bufferHandle, srcStages, srcAccess, dstStages, dstAccess, offset, size);
+		commandList->buffer_barrier(buffer, convert_pipeline_stages_to_vk_pipeline_stage_flags(srcStages), convert_access_flags_to_vk_access_flags(srcAccess),
+									convert_pipeline_stages_to_vk_pipeline_stage_flags(dstStages), convert_access_flags_to_vk_access_flags(dstAccess), offset, size);
+	}
+
+	void memory_barrier(CommandListHandle commandListHandle, std::uint32_t srcStages, std::uint32_t srcAccess, std::uint32_t dstStages, std::uint32_t dstAccess)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eMemoryBarrier, commandListHandle, srcStages, srcAccess, dstStages, dstAccess);
+		commandList->memory_barrier(convert_pipeline_stages_to_vk_pipeline_stage_flags(srcStages), convert_access_flags_to_vk_access_flags(srcAccess),
+									convert_pipeline_stages_to_vk_pipeline_stage_flags(dstStages), convert_access_flags_to_vk_access_flags(dstAccess));
+	}
+
+	void copy_buffer_to_texture(CommandListHandle commandListHandle, BufferHandle bufferHandle, TextureHandle textureHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Buffer* buffer{ nullptr };
+		if (!device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		Texture* texture{ nullptr };
+		if (!device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eCopyBufferToTexture, commandListHandle, bufferHandle, textureHandle);
+		commandList->copy_buffer_to_texture(buffer, texture);
+	}
+
+	void generate_mipmaps(CommandListHandle commandListHandle, TextureHandle textureHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Texture* texture{ nullptr };
+		if (!device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+
+		vk::Filter filter{};
+		if (!device->get_mipmap_filter(texture->get_format(), filter))
+		{
+			s_errorCallback("GFX - Texture format does not support blits, mipmaps cannot be generated!");
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eGenerateMipmaps, commandListHandle, textureHandle);
+		commandList->generate_mipmaps(texture, filter);
+	}
+
+	void copy_buffer(CommandListHandle commandListHandle, BufferHandle srcBufferHandle, BufferHandle dstBufferHandle, std::span<const BufferCopyRegion> regions)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (regions.size() > MAX_COPY_REGIONS)
+		{
+			s_errorCallback("GFX - Cannot copy more than MAX_COPY_REGIONS regions at once!");
+			return;
+		}
+
+		Buffer* srcBuffer{ nullptr };
+		if (!device->get_buffer(srcBuffer, srcBufferHandle))
+		{
+			return;
+		}
+
+		Buffer* dstBuffer{ nullptr };
+		if (!device->get_buffer(dstBuffer, dstBufferHandle))
+		{
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eCopyBuffer, commandListHandle, srcBufferHandle, dstBufferHandle, regions);
+		commandList->copy_buffer(srcBuffer, dstBuffer, regions);
+	}
+
+	void copy_texture_to_buffer(CommandListHandle commandListHandle, TextureHandle srcTextureHandle, BufferHandle dstBufferHandle, std::span<const TextureCopyRegion> regions)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (regions.size() > MAX_COPY_REGIONS)
+		{
+			s_errorCallback("GFX - Cannot copy more than MAX_COPY_REGIONS regions at once!");
+			return;
+		}
+
+		Texture* texture{ nullptr };
+		if (!device->get_texture(texture, srcTextureHandle))
+		{
+			return;
+		}
+
+		Buffer* buffer{ nullptr };
+		if (!device->get_buffer(buffer, dstBufferHandle))
+		{
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		commandList->copy_texture_to_buffer(texture, buffer, regions);
+	}
+
+	void copy_buffer_to_texture(CommandListHandle commandListHandle, BufferHandle srcBufferHandle, TextureHandle dstTextureHandle, std::span<const BufferTextureCopyRegion> regions)
+	{
+		const BufferTextureCopy copy{ .textureHandle = dstTextureHandle, .regions = regions };
+		copy_buffer_to_textures(commandListHandle, srcBufferHandle, { &copy, 1 });
+	}
+
+	void copy_buffer_to_textures(CommandListHandle commandListHandle, BufferHandle srcBufferHandle, std::span<const BufferTextureCopy> copies)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Buffer* buffer{ nullptr };
+		if (!device->get_buffer(buffer, srcBufferHandle))
+		{
+			return;
+		}
+
+		std::vector<Texture*> lookedUpTextures(copies.size(), nullptr);
+		for (auto i = 0; i < copies.size(); ++i)
+		{
+			if (!device->get_texture(lookedUpTextures[i], copies[i].textureHandle) || !validate_buffer_texture_copy_regions(*buffer, *lookedUpTextures[i], copies[i].regions))
+			{
+				return;
+			}
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		for (auto i = 0; i < copies.size(); ++i)
+		{
+			commandList->copy_buffer_to_texture(buffer, lookedUpTextures[i], copies[i].regions);
+		}
+	}
+
+	void copy_texture(CommandListHandle commandListHandle, TextureHandle srcTextureHandle, TextureHandle dstTextureHandle, std::span<const TextureRegionCopy> regions)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Texture* srcTexture{ nullptr };
+		if (!device->get_texture(srcTexture, srcTextureHandle))
+		{
+			return;
+		}
+
+		Texture* dstTexture{ nullptr };
+		if (!device->get_texture(dstTexture, dstTextureHandle))
+		{
+			return;
+		}
+
+		if (!validate_texture_copy(*srcTexture, *dstTexture, regions))
+		{
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eCopyTexture, commandListHandle, srcTextureHandle, dstTextureHandle, regions);
+		commandList->copy_texture(srcTexture, dstTexture, regions);
+	}
+
+	void blit_texture(CommandListHandle commandListHandle, TextureHandle srcTextureHandle, TextureHandle dstTextureHandle, std::span<const TextureBlitRegion> regions, SamplerFilterMode filterMode)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Texture* srcTexture{ nullptr };
+		if (!device->get_texture(srcTexture, srcTextureHandle))
+		{
+			return;
+		}
+
+		Texture* dstTexture{ nullptr };
+		if (!device->get_texture(dstTexture, dstTextureHandle))
+		{
+			return;
+		}
+
+		const auto filter = filterMode == SamplerFilterMode::eLinear ? vk::Filter::eLinear : vk::Filter::eNearest;
+		if (!validate_texture_blit(*device, *srcTexture, *dstTexture, regions, filter))
+		{
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eBlitTexture, commandListHandle, srcTextureHandle, dstTextureHandle, regions, filterMode);
+		commandList->blit_texture(srcTexture, dstTexture, regions, filter);
+	}
+
+	void resolve_texture(CommandListHandle commandListHandle, TextureHandle srcTextureHandle, TextureHandle dstTextureHandle, std::span<const TextureRegionCopy> regions)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Texture* srcTexture{ nullptr };
+		if (!device->get_texture(srcTexture, srcTextureHandle))
+		{
+			return;
+		}
+
+		Texture* dstTexture{ nullptr };
+		if (!device->get_texture(dstTexture, dstTextureHandle))
+		{
+			return;
+		}
+
+		if (!validate_texture_resolve(*srcTexture, *dstTexture, regions))
+		{
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eResolveTexture, commandListHandle, srcTextureHandle, dstTextureHandle, regions);
+		commandList->resolve_texture(srcTexture, dstTexture, regions);
+	}
+
+	void fill_buffer(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t size, std::uint32_t value)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (offset % 4 != 0 || (size != WHOLE_SIZE && size % 4 != 0))
+		{
+			s_errorCallback("GFX - fill_buffer() - offset and size must be multiples of 4, or size WHOLE_SIZE!");
+			return;
+		}
+
+		Buffer* buffer{ nullptr };
+		if (!device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+		if (offset >= buffer->get_size() || (size != WHOLE_SIZE && offset + size > buffer->get_size()))
+		{
+			s_errorCallback("GFX - fill_buffer() - Range is out of bounds!");
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eFillBuffer, commandListHandle, bufferHandle, offset, size, value);
+		commandList->fill_buffer(buffer, offset, size, value);
+	}
+
+	void update_buffer(CommandListHandle commandListHandle, BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t size, const void* data)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		if (size > MAX_UPDATE_BUFFER_SIZE || size % 4 != 0 || offset % 4 != 0)
+		{
+			s_errorCallback("GFX - update_buffer() - size must be at most MAX_UPDATE_BUFFER_SIZE, and size and offset multiples of 4!");
+			return;
+		}
+
+		Buffer* buffer{ nullptr };
+		if (!device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		GFX_CAPTURE(device, eUpdateBuffer, commandListHandle, bufferHandle, offset, std::span(static_cast<const std::byte*>(data), size));
+		commandList->update_buffer(buffer, offset, size, data);
+	}
+
+	auto read_buffer(CommandListHandle commandListHandle, BufferHandle srcBufferHandle, BufferHandle dstBufferHandle, const BufferCopyRegion& region) -> ReadbackHandle
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return {};
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return {};
+		}
+
+		return device->read_buffer(*commandList, srcBufferHandle, dstBufferHandle, region);
+	}
+
+	bool resolve_readback(ReadbackHandle readbackHandle, const void*& outData, std::uint64_t timeoutNs)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, readbackHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->resolve_readback(readbackHandle, outData, timeoutNs);
+	}
+
+	void destroy_readback(ReadbackHandle readbackHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, readbackHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		device->destroy_readback(readbackHandle);
+	}
+
+	bool create_acceleration_structure(AccelerationStructureHandle& outAccelerationStructureHandle, DeviceHandle deviceHandle, const AccelerationStructureInfo& accelerationStructureInfo)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_acceleration_structure(outAccelerationStructureHandle, accelerationStructureInfo);
+	}
+
+	void destroy_acceleration_structure(AccelerationStructureHandle accelerationStructureHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, accelerationStructureHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		device->destroy_acceleration_structure(accelerationStructureHandle);
+	}
+
+	auto get_acceleration_structure_device_address(AccelerationStructureHandle accelerationStructureHandle) -> std::uint64_t
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, accelerationStructureHandle.deviceHandle))
+		{
+			return 0;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->get_acceleration_structure_device_address(accelerationStructureHandle);
+	}
+
+	void build_acceleration_structures(CommandListHandle commandListHandle, std::span<const AccelerationStructureBuild> builds)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return;
+		}
+
+		device->build_acceleration_structures(*commandList, builds);
+	}
+
+#pragma endregion
+
+#pragma region Command Recorder
+
+	auto begin_recording(CommandListHandle commandListHandle) -> CommandRecorder
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return {};
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return {};
+		}
+
+		commandList->begin();
+
+		return CommandRecorder(device, commandList);
+	}
+
+	auto begin_secondary_recording(CommandListHandle commandListHandle, const RenderPassInfo& renderPassInfo) -> CommandRecorder
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return {};
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return {};
+		}
+
+		InlineVector<Texture*, MAX_COLOR_ATTACHMENTS> colorAttachments{};
+		Texture* depthAttachment{ nullptr };
+		if (!device->get_render_pass_attachments(colorAttachments, depthAttachment, renderPassInfo))
+		{
+			return {};
+		}
+
+		commandList->begin_secondary(colorAttachments, depthAttachment, renderPassInfo.viewMask);
+
+		return CommandRecorder(device, commandList);
+	}
+
+	bool create_bundle(BundleHandle& outBundleHandle, DeviceHandle deviceHandle, std::uint32_t queueIndex)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		return device->create_bundle(outBundleHandle, queueIndex);
+	}
+
+	void destroy_bundle(BundleHandle bundleHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bundleHandle.deviceHandle))
+		{
+			return;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		device->destroy_bundle(bundleHandle);
+	}
+
+	auto begin_bundle(BundleHandle bundleHandle, const RenderPassInfo& renderPassInfo) -> CommandRecorder
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bundleHandle.deviceHandle))
+		{
+			return {};
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		InlineVector<Texture*, MAX_COLOR_ATTACHMENTS> colorAttachments{};
+		Texture* depthAttachment{ nullptr };
+		if (!device->get_render_pass_attachments(colorAttachments, depthAttachment, renderPassInfo))
+		{
+			return {};
+		}
+
+		CommandList* commandList{ nullptr };
+		if (!device->begin_bundle(commandList, bundleHandle))
+		{
+			return {};
+		}
+
+		commandList->begin_secondary(colorAttachments, depthAttachment, renderPassInfo.viewMask);
+
+		return CommandRecorder(device, commandList, bundleHandle);
+	}
+
+	bool is_bundle_valid(BundleHandle bundleHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, bundleHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		Bundle* bundle{ nullptr };
+		return device->get_bundle(bundle, bundleHandle) && bundle->is_valid();
+	}
+
+	bool execute_bundle(CommandListHandle commandListHandle, BundleHandle bundleHandle)
+	{
+		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+
+		Device* device{ nullptr };
+		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		{
+			return false;
+		}
+		GFX_ASSERT(device != nullptr, "Device should not be null!");
+
+		CommandList* commandList{ nullptr };
+		if (!device->get_command_list(commandList, commandListHandle))
+		{
+			return false;
+		}
+
+		return CommandRecorder(device, commandList).execute_bundle(bundleHandle);
+	}
+
+	void CommandRecorder::end()
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		const bool ended = m_commandList->end();
+		if (m_bundleHandle != 0)
+		{
+			m_device->end_bundle(m_bundleHandle, *m_commandList, ended);
+		}
+		if (m_commandList->is_deferred())
+		{
+			m_device->translate_command_list(*m_commandList);
+		}
+		else
+		{
+			m_device->add_frame_stats(m_commandList->get_frame_stats());
+		}
+	}
+
+	void CommandRecorder::begin_render_pass(const RenderPassInfo& renderPassInfo)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		InlineVector<Texture*, MAX_COLOR_ATTACHMENTS> colorAttachments{};
+		Texture* depthAttachment{ nullptr };
+		InlineVector<Texture*, MAX_COLOR_ATTACHMENTS> resolveAttachments{};
+		ShadingRateAttachment shadingRateAttachment{};
+		if (!m_device->get_render_pass_attachments(colorAttachments, depthAttachment, renderPassInfo) || !m_device->get_render_pass_resolve_attachments(resolveAttachments, colorAttachments, renderPassInfo) ||
+			!m_device->get_render_pass_shading_rate_attachment(shadingRateAttachment, renderPassInfo))
+		{
+			return;
+		}
+
+		const AttachmentOps attachmentOps{ renderPassInfo.colorLoadOps, renderPassInfo.colorStoreOps, renderPassInfo.depthLoadOp, renderPassInfo.depthStoreOp, renderPassInfo.localRead };
+		m_commandList->begin_render_pass(colorAttachments, depthAttachment, renderPassInfo.clearColor, renderPassInfo.secondaryCommandLists,
+										 std::span(renderPassInfo.colorAttachmentViews.data(), colorAttachments.size()), renderPassInfo.depthAttachmentView, resolveAttachments, attachmentOps,
+										 convert_render_area_to_vk_rect_2d(renderPassInfo.renderArea), renderPassInfo.viewMask, shadingRateAttachment);
+	}
+
+	void CommandRecorder::begin_gpu_scope(std::string_view name)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_device->begin_gpu_scope(*m_commandList, name);
+	}
+
+	void CommandRecorder::end_gpu_scope()
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_device->end_gpu_scope(*m_commandList);
+	}
+
+	void CommandRecorder::begin_gpu_query(GpuQueryType type, std::string_view name)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_device->begin_gpu_query(*m_commandList, type, name);
+	}
+
+	void CommandRecorder::end_gpu_query(GpuQueryType type)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_device->end_gpu_query(*m_commandList, type);
+	}
+
+	void CommandRecorder::push_marker(std::string_view name)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->push_marker(name);
+	}
+
+	void CommandRecorder::pop_marker()
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->pop_marker();
+	}
+
+	void CommandRecorder::end_render_pass()
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->end_render_pass();
+	}
+
+	void CommandRecorder::set_viewport(float x, float y, float width, float height, float minDepth, float maxDepth)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->set_viewport(x, y, width, height, minDepth, maxDepth);
+	}
+
+	void CommandRecorder::set_scissor(std::int32_t x, std::int32_t y, std::uint32_t width, std::uint32_t height)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->set_scissor(x, y, width, height);
+	}
+
+	void CommandRecorder::set_cull_mode(CullMode cullMode)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->set_cull_mode(convert_cull_mode_to_vk_cull_mode(cullMode));
+	}
+
+	void CommandRecorder::set_front_face(FrontFace frontFace)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->set_front_face(convert_front_face_to_vk_front_face(frontFace));
+	}
+
+	void CommandRecorder::set_primitive_topology(PrimitiveTopology topology, bool primitiveRestart)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->set_primitive_topology(convert_primitive_topology_to_vk_primitive_topology(topology), primitiveRestart);
+	}
+
+	void CommandRecorder::set_depth_state(bool depthTest, bool depthWrite, CompareOp depthCompareOp)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->set_depth_state(depthTest, depthWrite, convert_compare_op_to_vk_compare_op(depthCompareOp));
+	}
+
+	void CommandRecorder::set_stencil_state(bool stencilTest, const StencilState& stencilFront, const StencilState& stencilBack)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->set_stencil_state(stencilTest, convert_stencil_state_to_vk_stencil_op_state(stencilFront), convert_stencil_state_to_vk_stencil_op_state(stencilBack));
+	}
+
+	void CommandRecorder::set_blend_states(std::uint32_t firstAttachment, std::span<const BlendState> blendStates)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		if (!m_device->supports_dynamic_blend_state())
+		{
+			s_errorCallback("GFX - set_blend_states() - Dynamic blend state is not supported by this device!");
+			return;
+		}
+
+		InlineVector<vk::PipelineColorBlendAttachmentState, MAX_COLOR_ATTACHMENTS> vk_blend_states{};
+		for (const auto& blendState : blendStates)
+		{
+			vk_blend_states.push_back(convert_blend_state_to_vk_color_blend_attachment_state(blendState));
+		}
+		m_commandList->set_blend_states(firstAttachment, vk_blend_states);
+	}
+
+	void CommandRecorder::set_shading_rate(ShadingRate shadingRate, ShadingRateCombiner attachmentCombiner)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		if (!m_device->supports_shading_rate())
+		{
+			s_errorCallback("GFX - set_shading_rate() - Variable rate shading needs DeviceFeatureFlags_ShadingRate!");
+			return;
+		}
+		if ((attachmentCombiner == ShadingRateCombiner::eMin || attachmentCombiner == ShadingRateCombiner::eMax) && !m_device->get_properties().shadingRateCombiners)
+		{
+			s_errorCallback("GFX - set_shading_rate() - ShadingRateCombiner::eMin and eMax are not supported by this device!");
+			return;
+		}
+
+		m_commandList->set_shading_rate(convert_shading_rate_to_vk_extent_2d(shadingRate),
+										{ vk::FragmentShadingRateCombinerOpKHR::eKeep, convert_shading_rate_combiner_to_vk_fragment_shading_rate_combiner_op(attachmentCombiner) });
+	}
+
+	void CommandRecorder::begin_conditional(BufferHandle bufferHandle, std::uint64_t offset, bool inverted)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		GFX_ASSERT(offset % 4 == 0, "Conditional rendering predicates must be 4 byte aligned!");
+		if (!m_device->supports_conditional_rendering())
+		{
+			s_errorCallback("GFX - begin_conditional() - Conditional rendering needs DeviceFeatureFlags_ConditionalRendering!");
+			return;
+		}
+
+		Buffer* buffer{ nullptr };
+		if (!m_device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+		if (!(buffer->get_usage_flags() & vk::BufferUsageFlagBits::eConditionalRenderingEXT))
+		{
+			s_errorCallback("GFX - begin_conditional() - The buffer was not created with BufferInfo::predicate!");
+			return;
+		}
+
+		m_commandList->begin_conditional(buffer, offset, inverted);
+	}
+
+	void CommandRecorder::end_conditional()
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->end_conditional();
+	}
+
+	void CommandRecorder::local_read_barrier()
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->local_read_barrier();
+	}
+
+	void CommandRecorder::bind_pipeline(PipelineHandle pipelineHandle)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Pipeline* pipeline{ nullptr };
+		if (!m_device->get_bindable_pipeline(pipeline, pipelineHandle))
+		{
+			return;
+		}
+
+		m_commandList->bind_pipeline(pipeline);
+	}
+
+	void CommandRecorder::bind_descriptor_sets(std::uint32_t firstSet, std::span<const DescriptorSetHandle> descriptorSets, std::span<const std::uint32_t> dynamicOffsets)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		if (descriptorSets.size() > MAX_BOUND_DESCRIPTOR_SETS)
+		{
+			s_errorCallback("GFX - Cannot bind more than MAX_BOUND_DESCRIPTOR_SETS descriptor sets at once!");
+			return;
+		}
+		if (dynamicOffsets.size() > MAX_DYNAMIC_OFFSETS)
+		{
+			s_errorCallback("GFX - Cannot bind more than MAX_DYNAMIC_OFFSETS dynamic offsets at once!");
+			return;
+		}
+		if (m_device->get_descriptor_buffer() != nullptr)
+		{
+			m_device->bind_descriptor_buffer_sets(*m_commandList, firstSet, descriptorSets, dynamicOffsets);
+			return;
+		}
+
+		InlineVector<vk::DescriptorSet, MAX_BOUND_DESCRIPTOR_SETS> vkDescriptorSets{};
+		vkDescriptorSets.resize(descriptorSets.size());
+		for (auto i = 0; i < descriptorSets.size(); ++i)
+		{
+			if (!m_device->get_descriptor_set(vkDescriptorSets[i], descriptorSets[i]))
+			{
+				return;
+			}
+		}
+
+		m_commandList->bind_descriptor_sets(firstSet, vkDescriptorSets, dynamicOffsets);
+	}
+
+	void CommandRecorder::push_descriptors(std::uint32_t set, std::span<const DescriptorWrite> writes)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_device->push_descriptors(*m_commandList, set, writes);
+	}
+
+	void CommandRecorder::set_constants(std::uint32_t shaderStages, std::uint32_t offset, std::uint32_t size, const void* data)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->set_constants(convert_shader_stages_to_vk_shader_stage_flags(shaderStages), offset, size, data);
+	}
+
+	void CommandRecorder::dispatch(std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->dispatch(groupCountX, groupCountY, groupCountZ);
+	}
+
+	void CommandRecorder::dispatch_base(std::uint32_t baseGroupX, std::uint32_t baseGroupY, std::uint32_t baseGroupZ, std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->dispatch_base(baseGroupX, baseGroupY, baseGroupZ, groupCountX, groupCountY, groupCountZ);
+	}
+
+	void CommandRecorder::set_device_mask(std::uint32_t deviceMask)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		if (deviceMask == 0 || (deviceMask & ~m_device->get_device_group_mask()) != 0)
+		{
+			s_errorCallback("GFX - set_device_mask() - deviceMask must be a non-empty subset of the device group!");
+			return;
+		}
+
+		m_commandList->set_device_mask(deviceMask);
+	}
+
+	void CommandRecorder::dispatch_indirect(BufferHandle bufferHandle, std::uint64_t offset)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		GFX_ASSERT(offset % 4 == 0, "dispatch_indirect() offset must be a multiple of 4!");
+
+		Buffer* buffer{ nullptr };
+		if (!m_device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		m_commandList->dispatch_indirect(buffer, offset);
+	}
+
+	void CommandRecorder::bind_index_buffer(BufferHandle bufferHandle, IndexType indexType, std::uint64_t offset)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Buffer* buffer{ nullptr };
+		if (!m_device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		m_commandList->bind_index_buffer(buffer, indexType == IndexType::eUInt16 ? vk::IndexType::eUint16 : vk::IndexType::eUint32, offset);
+	}
+
+	void CommandRecorder::bind_vertex_buffers(std::uint32_t firstBinding, std::span<const BufferHandle> buffers, std::span<const std::uint64_t> offsets)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		if (buffers.size() > MAX_VERTEX_BUFFER_BINDINGS)
+		{
+			s_errorCallback("GFX - Cannot bind more than MAX_VERTEX_BUFFER_BINDINGS vertex buffers at once!");
+			return;
+		}
+		if (!offsets.empty() && offsets.size() != buffers.size())
+		{
+			s_errorCallback("GFX - bind_vertex_buffers() - offsets must be empty or match the number of buffers!");
+			return;
+		}
+
+		InlineVector<vk::Buffer, MAX_VERTEX_BUFFER_BINDINGS> vkBuffers{};
+		vkBuffers.resize(buffers.size());
+		for (auto i = 0; i < buffers.size(); ++i)
+		{
+			Buffer* buffer{ nullptr };
+			if (!m_device->get_buffer(buffer, buffers[i]))
+			{
+				return;
+			}
+			vkBuffers[i] = buffer->get_buffer();
+		}
+
+		m_commandList->bind_vertex_buffer(firstBinding, vkBuffers, offsets);
+	}
+
+	void CommandRecorder::draw(std::uint32_t vertex_count, std::uint32_t instance_count, std::uint32_t first_vertex, std::uint32_t first_instance)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->draw(vertex_count, instance_count, first_vertex, first_instance);
+	}
+
+	void CommandRecorder::draw_indexed(std::uint32_t index_count, std::uint32_t instance_count, std::uint32_t first_index, std::int32_t vertex_offset, std::uint32_t first_instance)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->draw_indexed(index_count, instance_count, first_index, vertex_offset, first_instance);
+	}
+
+	void CommandRecorder::draw_indirect(BufferHandle bufferHandle, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Buffer* buffer{ nullptr };
+		if (!m_device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		record_indirect_draws(m_device->supports_multi_draw_indirect(), offset, drawCount, stride, [&](std::uint64_t drawOffset, std::uint32_t count) { m_commandList->draw_indirect(buffer, drawOffset, count, stride); });
+	}
+
+	void CommandRecorder::draw_indexed_indirect(BufferHandle bufferHandle, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Buffer* buffer{ nullptr };
+		if (!m_device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		record_indirect_draws(m_device->supports_multi_draw_indirect(), offset, drawCount, stride, [&](std::uint64_t drawOffset, std::uint32_t count) { m_commandList->draw_indexed_indirect(buffer, drawOffset, count, stride); });
+	}
+
+	void CommandRecorder::draw_indexed_indirect_count(BufferHandle bufferHandle, std::uint64_t offset, BufferHandle countBufferHandle, std::uint64_t countOffset, std::uint32_t maxDrawCount, std::uint32_t stride)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		if (!m_device->supports_draw_indirect_count())
+		{
+			s_errorCallback("GFX - Device does not support draw indirect count!");
+			return;
+		}
+
+		Buffer* buffer{ nullptr };
+		Buffer* countBuffer{ nullptr };
+		if (!m_device->get_buffer(buffer, bufferHandle) || !m_device->get_buffer(countBuffer, countBufferHandle))
+		{
+			return;
+		}
+
+		m_commandList->draw_indexed_indirect_count(buffer, offset, countBuffer, countOffset, maxDrawCount, stride);
+	}
+
+	void CommandRecorder::draw_mesh_tasks(std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		GFX_ASSERT(m_device->supports_mesh_shader(), "Device does not support mesh shaders!");
+
+		m_commandList->draw_mesh_tasks(groupCountX, groupCountY, groupCountZ);
+	}
+
+	void CommandRecorder::draw_mesh_tasks_indirect(BufferHandle bufferHandle, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		GFX_ASSERT(m_device->supports_mesh_shader(), "Device does not support mesh shaders!");
+
+		Buffer* buffer{ nullptr };
+		if (!m_device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		record_indirect_draws(m_device->supports_multi_draw_indirect(), offset, drawCount, stride, [&](std::uint64_t drawOffset, std::uint32_t count) { m_commandList->draw_mesh_tasks_indirect(buffer, drawOffset, count, stride); });
+	}
+
+	void CommandRecorder::draw_mesh_tasks_indirect_count(BufferHandle bufferHandle, std::uint64_t offset, BufferHandle countBufferHandle, std::uint64_t countOffset, std::uint32_t maxDrawCount, std::uint32_t stride)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		GFX_ASSERT(m_device->supports_mesh_shader(), "Device does not support mesh shaders!");
+		if (!m_device->supports_draw_indirect_count())
+		{
+			s_errorCallback("GFX - Device does not support draw indirect count!");
+			return;
+		}
+
+		Buffer* buffer{ nullptr };
+		Buffer* countBuffer{ nullptr };
+		if (!m_device->get_buffer(buffer, bufferHandle) || !m_device->get_buffer(countBuffer, countBufferHandle))
+		{
+			return;
+		}
+
+		m_commandList->draw_mesh_tasks_indirect_count(buffer, offset, countBuffer, countOffset, maxDrawCount, stride);
+	}
+
+	void CommandRecorder::transition_texture(TextureHandle textureHandle, TextureState oldState, TextureState newState)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Texture* texture{ nullptr };
+		if (!m_device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+
+		m_commandList->transition_texture(texture, oldState, newState);
+	}
+
+	void CommandRecorder::transition_texture(TextureHandle textureHandle, TextureState newState)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Texture* texture{ nullptr };
+		if (!m_device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+
+		m_commandList->transition_texture(texture, newState);
+	}
+
+	void CommandRecorder::transition_texture(TextureHandle textureHandle, TextureState newState, const TextureSubresourceRange& range)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Texture* texture{ nullptr };
+		if (!m_device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+		if (range.baseMipLevel >= texture->get_mip_levels() || range.baseArrayLayer >= texture->get_array_layers())
+		{
+			s_errorCallback("GFX - transition_texture() - Subresource range is out of range!");
+			return;
+		}
+
+		m_commandList->transition_texture(texture, newState, range.baseMipLevel, range.mipLevelCount, range.baseArrayLayer, range.arrayLayerCount);
+	}
+
+	void CommandRecorder::acquire_aliased_texture(TextureHandle textureHandle, TextureState newState)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Texture* texture{ nullptr };
+		if (!m_device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+
+		m_commandList->acquire_aliased_texture(texture, newState);
+	}
+
+	void CommandRecorder::begin_texture_transition(TextureHandle textureHandle, TextureState newState)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Texture* texture{ nullptr };
+		if (!m_device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+
+		m_commandList->begin_texture_transition(texture, newState);
+	}
+
+	void CommandRecorder::end_texture_transition(TextureHandle textureHandle)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Texture* texture{ nullptr };
+		if (!m_device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+
+		m_commandList->end_texture_transition(texture);
+	}
+
+	void CommandRecorder::transfer_texture_ownership(TextureHandle textureHandle, std::uint32_t srcQueueIndex, std::uint32_t dstQueueIndex, TextureState oldState, TextureState newState)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Texture* texture{ nullptr };
+		if (!m_device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+
+		QueueOwnershipTransfer transfer{};
+		if (!m_device->get_ownership_transfer(transfer, *m_commandList, srcQueueIndex, dstQueueIndex))
+		{
+			return;
+		}
+
+		m_commandList->transfer_texture_ownership(texture, transfer, oldState, newState);
+	}
+
+	void CommandRecorder::transfer_buffer_ownership(BufferHandle bufferHandle, std::uint32_t srcQueueIndex, std::uint32_t dstQueueIndex)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Buffer* buffer{ nullptr };
+		if (!m_device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		QueueOwnershipTransfer transfer{};
+		if (!m_device->get_ownership_transfer(transfer, *m_commandList, srcQueueIndex, dstQueueIndex))
+		{
+			return;
+		}
+
+		m_commandList->transfer_buffer_ownership(buffer, transfer);
+	}
+
+	void CommandRecorder::buffer_barrier(BufferHandle bufferHandle, std::uint32_t srcStages, std::uint32_t dstStages)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Buffer* buffer{ nullptr };
+		if (!m_device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		m_commandList->buffer_barrier(buffer, convert_pipeline_stages_to_vk_pipeline_stage_flags(srcStages), vk::AccessFlagBits2::eMemoryWrite,
+									  convert_pipeline_stages_to_vk_pipeline_stage_flags(dstStages), vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite, 0, VK_WHOLE_SIZE);
+	}
+
+	void CommandRecorder::buffer_barrier(BufferHandle bufferHandle, std::uint32_t srcStages, std::uint32_t srcAccess, std::uint32_t dstStages, std::uint32_t dstAccess, std::uint64_t offset, std::uint64_t size)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Buffer* buffer{ nullptr };
+		if (!m_device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		m_commandList->buffer_barrier(buffer, convert_pipeline_stages_to_vk_pipeline_stage_flags(srcStages), convert_access_flags_to_vk_access_flags(srcAccess),
+									  convert_pipeline_stages_to_vk_pipeline_stage_flags(dstStages), convert_access_flags_to_vk_access_flags(dstAccess), offset, size);
+	}
+
+	void CommandRecorder::memory_barrier(std::uint32_t srcStages, std::uint32_t srcAccess, std::uint32_t dstStages, std::uint32_t dstAccess)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+		m_commandList->memory_barrier(convert_pipeline_stages_to_vk_pipeline_stage_flags(srcStages), convert_access_flags_to_vk_access_flags(srcAccess),
+									  convert_pipeline_stages_to_vk_pipeline_stage_flags(dstStages), convert_access_flags_to_vk_access_flags(dstAccess));
+	}
+
+	void CommandRecorder::copy_buffer_to_texture(BufferHandle bufferHandle, TextureHandle textureHandle)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Buffer* buffer{ nullptr };
+		if (!m_device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		Texture* texture{ nullptr };
+		if (!m_device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+
+		m_commandList->copy_buffer_to_texture(buffer, texture);
+	}
+
+	void CommandRecorder::generate_mipmaps(TextureHandle textureHandle)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Texture* texture{ nullptr };
+		if (!m_device->get_texture(texture, textureHandle))
+		{
+			return;
+		}
+
+		vk::Filter filter{};
+		if (!m_device->get_mipmap_filter(texture->get_format(), filter))
+		{
+			s_errorCallback("GFX - Texture format does not support blits, mipmaps cannot be generated!");
+			return;
+		}
+
+		m_commandList->generate_mipmaps(texture, filter);
+	}
+
+	void CommandRecorder::copy_buffer(BufferHandle srcBufferHandle, BufferHandle dstBufferHandle, std::span<const BufferCopyRegion> regions)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		if (regions.size() > MAX_COPY_REGIONS)
+		{
+			s_errorCallback("GFX - Cannot copy more than MAX_COPY_REGIONS regions at once!");
+			return;
+		}
+
+		Buffer* srcBuffer{ nullptr };
+		if (!m_device->get_buffer(srcBuffer, srcBufferHandle))
+		{
+			return;
+		}
+
+		Buffer* dstBuffer{ nullptr };
+		if (!m_device->get_buffer(dstBuffer, dstBufferHandle))
+		{
+			return;
+		}
+
+		m_commandList->copy_buffer(srcBuffer, dstBuffer, regions);
+	}
+
+	void CommandRecorder::copy_texture_to_buffer(TextureHandle srcTextureHandle, BufferHandle dstBufferHandle, std::span<const TextureCopyRegion> regions)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		if (regions.size() > MAX_COPY_REGIONS)
+		{
+			s_errorCallback("GFX - Cannot copy more than MAX_COPY_REGIONS regions at once!");
+			return;
+		}
+
+		Texture* texture{ nullptr };
+		if (!m_device->get_texture(texture, srcTextureHandle))
+		{
+			return;
+		}
+
+		Buffer* buffer{ nullptr };
+		if (!m_device->get_buffer(buffer, dstBufferHandle))
+		{
+			return;
+		}
+
+		m_commandList->copy_texture_to_buffer(texture, buffer, regions);
+	}
+
+	void CommandRecorder::copy_buffer_to_texture(BufferHandle srcBufferHandle, TextureHandle dstTextureHandle, std::span<const BufferTextureCopyRegion> regions)
+	{
+		const BufferTextureCopy copy{ .textureHandle = dstTextureHandle, .regions = regions };
+		copy_buffer_to_textures(srcBufferHandle, { &copy, 1 });
+	}
+
+	void CommandRecorder::copy_buffer_to_textures(BufferHandle srcBufferHandle, std::span<const BufferTextureCopy> copies)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Buffer* buffer{ nullptr };
+		if (!m_device->get_buffer(buffer, srcBufferHandle))
+		{
+			return;
+		}
+
+		std::vector<Texture*> textures(copies.size(), nullptr);
+		for (auto i = 0; i < copies.size(); ++i)
+		{
+			if (!m_device->get_texture(textures[i], copies[i].textureHandle) || !validate_buffer_texture_copy_regions(*buffer, *textures[i], copies[i].regions))
+			{
+				return;
+			}
+		}
+
+		for (auto i = 0; i < copies.size(); ++i)
+		{
+			m_commandList->copy_buffer_to_texture(buffer, textures[i], copies[i].regions);
+		}
+	}
+
+	void CommandRecorder::copy_texture(TextureHandle srcTextureHandle, TextureHandle dstTextureHandle, std::span<const TextureRegionCopy> regions)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Texture* srcTexture{ nullptr };
+		if (!m_device->get_texture(srcTexture, srcTextureHandle))
+		{
+			return;
+		}
+
+		Texture* dstTexture{ nullptr };
+		if (!m_device->get_texture(dstTexture, dstTextureHandle))
+		{
+			return;
+		}
+
+		if (!validate_texture_copy(*srcTexture, *dstTexture, regions))
+		{
+			return;
+		}
+
+		m_commandList->copy_texture(srcTexture, dstTexture, regions);
+	}
+
+	void CommandRecorder::blit_texture(TextureHandle srcTextureHandle, TextureHandle dstTextureHandle, std::span<const TextureBlitRegion> regions, SamplerFilterMode filterMode)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Texture* srcTexture{ nullptr };
+		if (!m_device->get_texture(srcTexture, srcTextureHandle))
+		{
+			return;
+		}
+
+		Texture* dstTexture{ nullptr };
+		if (!m_device->get_texture(dstTexture, dstTextureHandle))
+		{
+			return;
+		}
+
+		const auto filter = filterMode == SamplerFilterMode::eLinear ? vk::Filter::eLinear : vk::Filter::eNearest;
+		if (!validate_texture_blit(*m_device, *srcTexture, *dstTexture, regions, filter))
+		{
+			return;
+		}
+
+		m_commandList->blit_texture(srcTexture, dstTexture, regions, filter);
+	}
+
+	void CommandRecorder::resolve_texture(TextureHandle srcTextureHandle, TextureHandle dstTextureHandle, std::span<const TextureRegionCopy> regions)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		Texture* srcTexture{ nullptr };
+		if (!m_device->get_texture(srcTexture, srcTextureHandle))
+		{
+			return;
+		}
+
+		Texture* dstTexture{ nullptr };
+		if (!m_device->get_texture(dstTexture, dstTextureHandle))
+		{
+			return;
+		}
+
+		if (!validate_texture_resolve(*srcTexture, *dstTexture, regions))
+		{
+			return;
+		}
+
+		m_commandList->resolve_texture(srcTexture, dstTexture, regions);
+	}
+
+	void CommandRecorder::fill_buffer(BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t size, std::uint32_t value)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		if (offset % 4 != 0 || (size != WHOLE_SIZE && size % 4 != 0))
+		{
+			s_errorCallback("GFX - fill_buffer() - offset and size must be multiples of 4, or size WHOLE_SIZE!");
+			return;
+		}
+
+		Buffer* buffer{ nullptr };
+		if (!m_device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+		if (offset >= buffer->get_size() || (size != WHOLE_SIZE && offset + size > buffer->get_size()))
+		{
+			s_errorCallback("GFX - fill_buffer() - Range is out of bounds!");
+			return;
+		}
+
+		m_commandList->fill_buffer(buffer, offset, size, value);
+	}
+
+	void CommandRecorder::update_buffer(BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t size, const void* data)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		if (size > MAX_UPDATE_BUFFER_SIZE || size % 4 != 0 || offset % 4 != 0)
+		{
+			s_errorCallback("GFX - update_buffer() - size must be at most MAX_UPDATE_BUFFER_SIZE, and size and offset multiples of 4!");
+			return;
+		}
+
+		Buffer* buffer{ nullptr };
+		if (!m_device->get_buffer(buffer, bufferHandle))
+		{
+			return;
+		}
+
+		m_commandList->update_buffer(buffer, offset, size, data);
+	}
+
+	auto CommandRecorder::read_buffer(BufferHandle srcBufferHandle, BufferHandle dstBufferHandle, const BufferCopyRegion& region) -> ReadbackHandle
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		return m_device->read_buffer(*m_commandList, srcBufferHandle, dstBufferHandle, region);
+	}
+
+	void CommandRecorder::build_acceleration_structures(std::span<const AccelerationStructureBuild> builds)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		m_device->build_acceleration_structures(*m_commandList, builds);
+	}
+
+	void CommandRecorder::execute_commands(std::span<const CommandListHandle> secondaryCommandLists)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		// Executed in fixed-size batches, so any number of secondaries can be recorded without a heap allocation.
+		InlineVector<vk::CommandBuffer, 16> secondaryCommandBuffers{};
+		for (auto i = 0; i < secondaryCommandLists.size(); ++i)
+		{
+			CommandList* secondaryCommandList{ nullptr };
+			if (!m_device->get_command_list(secondaryCommandList, secondaryCommandLists[i]))
+			{
+				return;
+			}
+			GFX_ASSERT(secondaryCommandList->is_secondary(), "execute_commands() can only execute secondary command lists!");
+			secondaryCommandBuffers.push_back(secondaryCommandList->get_command_buffer());
+
+			if (secondaryCommandBuffers.size() == secondaryCommandBuffers.capacity())
+			{
+				m_commandList->execute_commands(secondaryCommandBuffers);
+				secondaryCommandBuffers.clear();
+			}
+		}
+
+		m_commandList->execute_commands(secondaryCommandBuffers);
+	}
+
+	bool CommandRecorder::execute_bundle(BundleHandle bundleHandle)
+	{
+		GFX_ASSERT(is_valid(), "CommandRecorder is not valid!");
+
+		CommandList* bundleCommandList{ nullptr };
+		if (!m_device->get_bundle_command_list(bundleCommandList, bundleHandle))
+		{
+			return false;
+		}
+
+		const vk::CommandBuffer commandBuffer = bundleCommandList->get_command_buffer();
+		m_commandList->execute_commands(std::span(&commandBuffer, 1));
+		return true;
+	}
+
+#pragma endregion
+
+#pragma endregion
+
+#pragma region Private Header
+
+	Context::Context(const AppInfo& appInfo)
+	{
+		auto vkGetInstanceProcAddr = m_loader.getProcAddress<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr");
+		VULKAN_HPP_DEFAULT_DISPATCHER.init(vkGetInstanceProcAddr);
+
+		vk::ApplicationInfo vk_app_info{};
+		vk_app_info.setApiVersion(VK_API_VERSION_1_3);
+		vk_app_info.setPApplicationName(appInfo.appName.c_str());
+		vk_app_info.setPEngineName(appInfo.engineName.c_str());
+
+		m_headless = appInfo.headless;
+		m_debugLevel = appInfo.debugLevel;
+
+		constexpr std::string_view VALIDATION_LAYER_NAME = "VK_LAYER_KHRONOS_validation";
+		if (m_debugLevel >= DebugLevel::eValidation)
+		{
+			const auto layerProperties = vk::enumerateInstanceLayerProperties().value;
+			if (std::ranges::none_of(layerProperties, [&](const vk::LayerProperties& props) { return std::string_view(props.layerName) == VALIDATION_LAYER_NAME; }))
+			{
+				s_errorCallback("GFX - The validation layer is not installed, continuing with DebugLevel::eLabels!");
+				m_debugLevel = DebugLevel::eLabels;
+			}
+		}
+
+		std::vector<const char*> extensions{};
+		std::vector<const char*> layers{};
+		if (m_debugLevel != DebugLevel::eOff)
+		{
+			extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+		}
+		if (m_debugLevel >= DebugLevel::eValidation)
+		{
+			layers.push_back(VALIDATION_LAYER_NAME.data());
+		}
+		if (!m_headless)
+		{
+			extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+#if _WIN32
+			extensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+#elif __linux__
+			extensions.push_back(VK_KHR_WAYLAND_SURFACE_EXTENSION_NAME);
+#endif
+		}
+
+		vk::DebugUtilsMessengerCreateInfoEXT vk_debug_messenger_info{};
+		vk_debug_messenger_info.setMessageSeverity(vk::DebugUtilsMessageSeverityFlagBitsEXT::eError | vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning);
+		vk_debug_messenger_info.setMessageType(vk::DebugUtilsMessageTypeFlagBitsEXT::eValidation);
+		vk_debug_messenger_info.setPfnUserCallback(debug_utils_messenger_callback);
+
+		// The validation layer implements VK_EXT_validation_features, which turns on its optional checks.
+		std::vector<vk::ValidationFeatureEnableEXT> validationFeatures{};
+		if (m_debugLevel == DebugLevel::eSynchronizationValidation)
+		{
+			validationFeatures.push_back(vk::ValidationFeatureEnableEXT::eSynchronizationValidation);
+		}
+		else if (m_debugLevel == DebugLevel::eGpuAssisted)
+		{
+			validationFeatures.push_back(vk::ValidationFeatureEnableEXT::eGpuAssisted);
+			validationFeatures.push_back(vk::ValidationFeatureEnableEXT::eGpuAssistedReserveBindingSlot);
+		}
+		vk::ValidationFeaturesEXT vk_validation_features{};
+		vk_validation_features.setEnabledValidationFeatures(validationFeatures);
+
+		vk::InstanceCreateInfo vk_inst_info{};
+		vk_inst_info.setPApplicationInfo(&vk_app_info);
+		vk_inst_info.setPEnabledLayerNames(layers);
+		// The messenger also reports on instance creation and destruction.
+		if (m_debugLevel != DebugLevel::eOff)
+		{
+			vk_inst_info.setPNext(&vk_debug_messenger_info);
+		}
+		if (!validationFeatures.empty())
+		{
+			extensions.push_back(VK_EXT_VALIDATION_FEATURES_EXTENSION_NAME);
+			vk_validation_features.setPNext(vk_inst_info.pNext);
+			vk_inst_info.setPNext(&vk_validation_features);
+		}
+		vk_inst_info.setPEnabledExtensionNames(extensions);
+		m_instance = vk::createInstanceUnique(vk_inst_info).value;
+		if (!*m_instance)
+		{
+			s_errorCallback("Failed to create Vulkan instance!");
+			return;
+		}
+
+		VULKAN_HPP_DEFAULT_DISPATCHER.init(*m_instance);
+
+		if (m_debugLevel == DebugLevel::eOff)
+		{
+			return;
+		}
+		m_debugMessenger = m_instance->createDebugUtilsMessengerEXTUnique(vk_debug_messenger_info).value;
+		if (!*m_debugMessenger)
+		{
+			s_errorCallback("Failed to create Vulkan debug messenger!");
+		}
+	}
+
+	bool is_debug_utils_enabled()
+	{
+		return s_context != nullptr && s_context->get_debug_level() != DebugLevel::eOff;
+	}
+
+	bool Context::is_valid() const
+	{
+		return *m_instance;
+	}
+
+	auto Context::get_physical_devices() -> const std::vector<PhysicalDeviceInfo>&
+	{
+		std::call_once(m_physicalDevicesOnce, [this] {
+			for (const auto physicalDevice : m_instance->enumeratePhysicalDevices().value)
+			{
+				m_physicalDevices.push_back({ physicalDevice, physicalDevice.getProperties(), physicalDevice.enumerateDeviceExtensionProperties().value });
+			}
+		});
+		return m_physicalDevices;
+	}
+
+	auto Context::create_device(DeviceHandle& outDeviceHandle, const DeviceInfo& deviceInfo) -> bool
+	{
+		std::lock_guard lock(m_deviceMutex);
+		const auto slot = std::uint32_t(std::find(m_ownedDevices.begin(), m_ownedDevices.end(), nullptr) - m_ownedDevices.begin());
+		if (slot == MAX_DEVICES)
+		{
+			s_errorCallback("GFX - Cannot create more than 16 devices at once!");
+			return false;
+		}
+
+		// Generations start at 1, so no handle is 0.
+		const auto deviceHandle = DeviceHandle((m_deviceGenerations[slot] + 1) << DEVICE_SLOT_BITS | slot);
+		auto device = std::make_unique<Device>(*this, deviceHandle, deviceInfo);
+		if (!device->is_valid())
+		{
+			return false;
+		}
+
+		++m_deviceGenerations[slot];
+		m_devices[slot].store(device.get(), std::memory_order_release);
+		m_ownedDevices[slot] = std::move(device);
+
+		outDeviceHandle = deviceHandle;
+		return true;
+	}
+
+	void Context::destroy_device(DeviceHandle deviceHandle)
+	{
+		std::unique_ptr<Device> device{};
+		{
+			std::lock_guard lock(m_deviceMutex);
+			const auto slot = std::uint32_t(deviceHandle) & (MAX_DEVICES - 1);
+			if (m_ownedDevices[slot] == nullptr || m_ownedDevices[slot]->get_handle() != deviceHandle)
+			{
+				return;
+			}
+			m_devices[slot].store(nullptr, std::memory_order_release);
+			device = std::move(m_ownedDevices[slot]);
+		}
+		// Destroyed outside the lock, as waiting for the device to idle can take a while.
+	}
+
+	bool Context::get_device(Device*& outDevice, DeviceHandle deviceHandle) const
+	{
+		auto* device = m_devices[std::uint32_t(deviceHandle) & (MAX_DEVICES - 1)].load(std::memory_order_acquire);
+		if (device == nullptr || device->get_handle() != deviceHandle)
+		{
+			outDevice = nullptr;
+			return false;
+		}
+
+		outDevice = device;
+		return true;
+	}
+
+	Device::Device(Context& context, DeviceHandle deviceHandle, const DeviceInfo& deviceInfo)
+		: m_context(&context), m_deviceHandle(deviceHandle), m_deviceInfo(deviceInfo)
+	{
+		const auto& physicalDevices = m_context->get_physical_devices();
+		if (physicalDevices.empty())
+		{
+			s_errorCallback("GFX - There are no devices!");
+			return;
+		}
+
+		std::uint32_t bestScore = 0;
+		std::uint32_t bestDevice = 0;
+		for (auto i = 0; i < physicalDevices.size(); ++i)
+		{
+			const auto& deviceProperties = physicalDevices[i].properties;
+
+			std::uint32_t score = 0;
+
+			if (deviceInfo.deviceFlags & DeviceFlags_PreferIntegrated && deviceProperties.deviceType == vk::PhysicalDeviceType::eIntegratedGpu)
+			{
+				score += 1000;
+			}
+			if (deviceInfo.deviceFlags & DeviceFlags_PreferDiscrete && deviceProperties.deviceType == vk::PhysicalDeviceType::eDiscreteGpu)
+			{
+				score += 1000;
+			}
+
+			score += deviceProperties.limits.maxImageDimension2D;
+			score += deviceProperties.limits.maxDescriptorSetSampledImages;
+			score += deviceProperties.limits.maxDescriptorSetUniformBuffers;
+			score += deviceProperties.limits.maxBoundDescriptorSets;
+
+			if (score > bestScore)
+			{
+				bestScore = score;
+				bestDevice = i;
+			}
+		}
+
+		m_physicalDevice = physicalDevices[bestDevice].physicalDevice;
+		m_availableExtensions = physicalDevices[bestDevice].extensions;
+		const auto& physicalDeviceProperties = physicalDevices[bestDevice].properties;
+
+		m_deviceGroupPhysicalDevices = { m_physicalDevice };
+		if (deviceInfo.deviceGroup)
+		{
+			// Every GPU of a group is identical, so the one picked above stands for all of them.
+			for (const auto& group : m_context->get_instance().enumeratePhysicalDeviceGroups().value)
+			{
+				const auto groupDevices = std::span(group.physicalDevices.data(), group.physicalDeviceCount);
+				if (std::ranges::find(groupDevices, m_physicalDevice) != groupDevices.end())
+				{
+					m_deviceGroupPhysicalDevices.assign(groupDevices.begin(), groupDevices.end());
+				}
+			}
+			if (m_deviceGroupPhysicalDevices.size() < 2)
+			{
+				s_errorCallback("GFX - The device is not part of a device group, only one GPU will be used!");
+			}
+		}
+
+		// Compute-only devices leave out everything that only rendering needs, along with the queries deciding on it.
+		const bool graphicsEnabled = !deviceInfo.computeOnly;
+		const bool windowSystemEnabled = graphicsEnabled && !m_context->is_headless();
+		std::vector<const char*> extensions{};
+		if (graphicsEnabled)
+		{
+			extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+		}
+		if (windowSystemEnabled)
+		{
+			extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+		}
+
+		auto queueProperties = m_physicalDevice.getQueueFamilyProperties();
+
+		if (deviceInfo.queueFlags.size() > MAX_QUEUES)
+		{
+			s_errorCallback("GFX - Too many queues requested!");
+			return;
+		}
+		if (!graphicsEnabled && std::ranges::any_of(deviceInfo.queueFlags, [](std::uint32_t queueFlags) { return (queueFlags & QueueFlags_Graphics) != 0; }))
+		{
+			s_errorCallback("GFX - Compute-only devices cannot have graphics queues!");
+			return;
+		}
+
+		m_queueFlags = deviceInfo.queueFlags;
+		m_queueFamilies.resize(m_queueFlags.size());
+		m_queues.resize(m_queueFlags.size());
+
+		std::unordered_map<std::uint32_t, std::uint32_t> usedQueueFamilyCounts;
+		for (auto i = 0; i < deviceInfo.queueFlags.size(); ++i)
+		{
+			const auto queueFlags = deviceInfo.queueFlags[i];
+
+			vk::QueueFlags wantedFlags;
+			if (queueFlags & QueueFlags_Graphics)
+			{
+				wantedFlags |= vk::QueueFlagBits::eGraphics;
+			}
+			if (queueFlags & QueueFlags_Compute)
+			{
+				wantedFlags |= vk::QueueFlagBits::eCompute;
+			}
+			if (queueFlags & QueueFlags_Transfer)
+			{
+				wantedFlags |= vk::QueueFlagBits::eTransfer;
+			}
+			if (queueFlags & QueueFlags_SparseBinding)
+			{
+				wantedFlags |= vk::QueueFlagBits::eSparseBinding;
+			}
+			if (queueFlags & QueueFlags_VideoDecode)
+			{
+				wantedFlags |= vk::QueueFlagBits::eVideoDecodeKHR;
+			}
+
+			// Pick the family with spare queues whose capabilities match most exactly, so transfer and compute requests
+			// land on dedicated DMA and async compute families instead of contending with the graphics queue.
+			std::optional<std::uint32_t> bestFamily{};
+			std::uint32_t bestExtraCapabilities{ 0 };
+			for (auto familyIndex = 0; familyIndex < queueProperties.size(); ++familyIndex)
+			{
+				const auto& queueProps = queueProperties[familyIndex];
+				if (usedQueueFamilyCounts[familyIndex] >= queueProps.queueCount)
+				{
+					continue;
+				}
+
+				// Graphics and compute families can always transfer, even when they do not report it.
+				// Sparse binding and video decode only count when asked for, most families support them alongside their main capability.
+				auto capabilities = queueProps.queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute | vk::QueueFlagBits::eTransfer |
+															 (wantedFlags & (vk::QueueFlagBits::eSparseBinding | vk::QueueFlagBits::eVideoDecodeKHR)));
+				if (capabilities & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute))
+				{
+					capabilities |= vk::QueueFlagBits::eTransfer;
+				}
+				if ((capabilities & wantedFlags) != wantedFlags)
+				{
+					continue;
+				}
+
+				const auto extraCapabilities = static_cast<std::uint32_t>(std::popcount(static_cast<VkQueueFlags>(capabilities & ~wantedFlags)));
+				if (!bestFamily || extraCapabilities < bestExtraCapabilities)
+				{
+					bestFamily = familyIndex;
+					bestExtraCapabilities = extraCapabilities;
+				}
+			}
+			if (!bestFamily)
+			{
+				s_errorCallback("GFX - No queue family has a spare queue supporting the requested QueueFlags!");
+				return;
+			}
+
+			usedQueueFamilyCounts[*bestFamily] += 1;
+			m_queueFamilies[i] = *bestFamily;
+		}
+
+		// Queues are retrieved in request order within each family, so their priorities are gathered in the same order.
+		std::unordered_map<std::uint32_t, std::vector<float>> familyQueuePriorities;
+		std::unordered_map<std::uint32_t, QueueGlobalPriority> familyGlobalPriorities;
+		for (auto i = 0; i < m_queueFamilies.size(); ++i)
+		{
+			const auto priority = i < deviceInfo.queuePriorities.size() ? std::clamp(deviceInfo.queuePriorities[i], 0.0f, 1.0f) : 1.0f;
+			familyQueuePriorities[m_queueFamilies[i]].push_back(priority);
+
+			const auto globalPriority = i < deviceInfo.queueGlobalPriorities.size() ? deviceInfo.queueGlobalPriorities[i] : QueueGlobalPriority::eDefault;
+			// eDefault is the implementation's eMedium, so it must not lose to an explicit eLow on the same family.
+			const auto [it, inserted] = familyGlobalPriorities.try_emplace(m_queueFamilies[i], globalPriority);
+			if (!inserted && it->second != globalPriority)
+			{
+				const auto effective = [](QueueGlobalPriority p) { return p == QueueGlobalPriority::eDefault ? QueueGlobalPriority::eMedium : p; };
+				it->second = std::max(effective(it->second), effective(globalPriority));
+			}
+		}
+
+		const bool useGlobalPriority = is_extension_available(VK_EXT_GLOBAL_PRIORITY_EXTENSION_NAME) && std::any_of(familyGlobalPriorities.begin(), familyGlobalPriorities.end(), [](const auto& pair) { return pair.second != QueueGlobalPriority::eDefault; });
+		if (useGlobalPriority)
+		{
+			extensions.push_back(VK_EXT_GLOBAL_PRIORITY_EXTENSION_NAME);
+		}
+
+		std::vector<vk::DeviceQueueCreateInfo> queue_info_vec;
+		std::vector<vk::DeviceQueueGlobalPriorityCreateInfoEXT> global_priority_info_vec;
+		global_priority_info_vec.reserve(familyQueuePriorities.size()); // Chained by pointer, must not reallocate.
+		for (const auto& [family, priorities] : familyQueuePriorities)
+		{
+			auto& queue_info = queue_info_vec.emplace_back();
+			queue_info.setQueueFamilyIndex(family);
+			queue_info.setQueuePriorities(priorities);
+
+			const auto globalPriority = familyGlobalPriorities[family];
+			if (useGlobalPriority && globalPriority != QueueGlobalPriority::eDefault)
+			{
+				auto& global_priority_info = global_priority_info_vec.emplace_back();
+				global_priority_info.setGlobalPriority(convert_queue_global_priority_to_vk_queue_global_priority(globalPriority));
+				queue_info.setPNext(&global_priority_info);
+			}
+		}
+
+		const auto memory_properties = m_physicalDevice.getMemoryProperties();
+		for (auto i = 0; i < memory_properties.memoryTypeCount; ++i)
+		{
+			if (memory_properties.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eLazilyAllocated)
+			{
+				m_lazilyAllocatedMemorySupported = true;
+			}
+		}
+
+		const auto supported_features = m_physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan11Features, vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceVulkan13Features>();
+		m_multiDrawIndirectSupported = supported_features.get<vk::PhysicalDeviceFeatures2>().features.multiDrawIndirect;
+		m_imageCubeArraySupported = supported_features.get<vk::PhysicalDeviceFeatures2>().features.imageCubeArray;
+		if (supported_features.get<vk::PhysicalDeviceFeatures2>().features.samplerAnisotropy)
+		{
+			m_maxSamplerAnisotropy = physicalDeviceProperties.limits.maxSamplerAnisotropy;
+		}
+		m_drawIndirectCountSupported = supported_features.get<vk::PhysicalDeviceVulkan12Features>().drawIndirectCount;
+		m_bufferDeviceAddressSupported = supported_features.get<vk::PhysicalDeviceVulkan12Features>().bufferDeviceAddress;
+		const auto& supported_core_features = supported_features.get<vk::PhysicalDeviceFeatures2>().features;
+		m_sparseBufferSupported = supported_core_features.sparseBinding && supported_core_features.sparseResidencyBuffer;
+		m_sparseTextureSupported = supported_core_features.sparseBinding && supported_core_features.sparseResidencyImage2D;
+		const bool bindlessRequested = deviceInfo.bindlessTextureCount > 0 || deviceInfo.bindlessSamplerCount > 0 || deviceInfo.bindlessStorageBufferCount > 0;
+		if (bindlessRequested)
+		{
+			const auto& supported_vulkan_12_features = supported_features.get<vk::PhysicalDeviceVulkan12Features>();
+			m_bindlessSupported = supported_vulkan_12_features.runtimeDescriptorArray && supported_vulkan_12_features.descriptorBindingPartiallyBound &&
+								  supported_vulkan_12_features.descriptorBindingUpdateUnusedWhilePending &&
+								  supported_vulkan_12_features.descriptorBindingSampledImageUpdateAfterBind &&
+								  supported_vulkan_12_features.descriptorBindingStorageBufferUpdateAfterBind &&
+								  supported_vulkan_12_features.shaderSampledImageArrayNonUniformIndexing &&
+								  supported_vulkan_12_features.shaderStorageBufferArrayNonUniformIndexing;
+			if (!m_bindlessSupported)
+			{
+				s_errorCallback("GFX - Descriptor indexing is not supported by this device, it will have no bindless heap!");
+			}
+		}
+
+		// Present timing is optional, only the feature structs of available extensions may be queried.
+		if (windowSystemEnabled && is_extension_available(VK_KHR_PRESENT_ID_EXTENSION_NAME) && is_extension_available(VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+		{
+			const auto present_features = m_physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDevicePresentIdFeaturesKHR, vk::PhysicalDevicePresentWaitFeaturesKHR>();
+			m_presentWaitSupported = present_features.get<vk::PhysicalDevicePresentIdFeaturesKHR>().presentId && present_features.get<vk::PhysicalDevicePresentWaitFeaturesKHR>().presentWait;
+		}
+		if (m_presentWaitSupported)
+		{
+			extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+			extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+		}
+		m_displayTimingSupported = windowSystemEnabled && is_extension_available(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME);
+		if (m_displayTimingSupported)
+		{
+			extensions.push_back(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME);
+		}
+
+		// Low latency modes are only enabled per swap chain, having the extensions enabled costs nothing.
+		m_lowLatencySupported = m_presentWaitSupported && is_extension_available(VK_NV_LOW_LATENCY_2_EXTENSION_NAME);
+		if (m_lowLatencySupported)
+		{
+			extensions.push_back(VK_NV_LOW_LATENCY_2_EXTENSION_NAME);
+		}
+		if (windowSystemEnabled && is_extension_available(VK_AMD_ANTI_LAG_EXTENSION_NAME))
+		{
+			const auto anti_lag_features = m_physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceAntiLagFeaturesAMD>();
+			m_antiLagSupported = anti_lag_features.get<vk::PhysicalDeviceAntiLagFeaturesAMD>().antiLag;
+		}
+		if (m_antiLagSupported)
+		{
+			extensions.push_back(VK_AMD_ANTI_LAG_EXTENSION_NAME);
+		}
+		m_memoryBudgetSupported = is_extension_available(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		if (m_memoryBudgetSupported)
+		{
+			extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		}
+		if (is_extension_available(VK_EXT_MEMORY_PRIORITY_EXTENSION_NAME))
+		{
+			const auto memory_priority_features = m_physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceMemoryPriorityFeaturesEXT>();
+			m_memoryPrioritySupported = memory_priority_features.get<vk::PhysicalDeviceMemoryPriorityFeaturesEXT>().memoryPriority;
+		}
+		if (m_memoryPrioritySupported)
+		{
+			extensions.push_back(VK_EXT_MEMORY_PRIORITY_EXTENSION_NAME);
+		}
+		// Lets priorities change after allocation, so residency follows use instead of what was guessed at creation.
+		if (m_memoryPrioritySupported && is_extension_available(VK_EXT_PAGEABLE_DEVICE_LOCAL_MEMORY_EXTENSION_NAME))
+		{
+			const auto pageable_memory_features = m_physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDevicePageableDeviceLocalMemoryFeaturesEXT>();
+			m_pageableMemorySupported = pageable_memory_features.get<vk::PhysicalDevicePageableDeviceLocalMemoryFeaturesEXT>().pageableDeviceLocalMemory;
+		}
+		if (m_pageableMemorySupported)
+		{
+			extensions.push_back(VK_EXT_PAGEABLE_DEVICE_LOCAL_MEMORY_EXTENSION_NAME);
+		}
+		if (deviceInfo.gpuScopesPerFrame > 0 || deviceInfo.gpuQueriesPerFrame > 0)
+		{
+			if (supported_features.get<vk::PhysicalDeviceVulkan12Features>().hostQueryReset)
+			{
+				m_gpuScopesPerFrame = deviceInfo.gpuScopesPerFrame;
+				m_gpuQueriesPerFrame = deviceInfo.gpuQueriesPerFrame;
+			}
+			else
+			{
+				s_errorCallback("GFX - hostQueryReset is not supported by this device, GPU scopes and queries are disabled!");
+			}
+		}
+		if (m_gpuQueriesPerFrame > 0)
+		{
+			m_pipelineStatisticsSupported = supported_core_features.pipelineStatisticsQuery;
+			m_occlusionQueryPreciseSupported = supported_core_features.occlusionQueryPrecise;
+		}
+		if (m_gpuScopesPerFrame > 0 && is_extension_available(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME))
+		{
+			// The host domain std::chrono::steady_clock reads.
+#if _WIN32
+			m_hostTimeDomain = vk::TimeDomainEXT::eQueryPerformanceCounter;
+			LARGE_INTEGER frequency{};
+			QueryPerformanceFrequency(&frequency);
+			m_hostTicksPerSecond = std::uint64_t(frequency.QuadPart);
+#else
+			m_hostTimeDomain = vk::TimeDomainEXT::eClockMonotonic;
+#endif
+			const auto timeDomains = m_physicalDevice.getCalibrateableTimeDomainsEXT().value;
+			m_calibratedTimestampsSupported = std::ranges::find(timeDomains, vk::TimeDomainEXT::eDevice) != timeDomains.end() &&
+											  std::ranges::find(timeDomains, m_hostTimeDomain) != timeDomains.end();
+		}
+		if (m_calibratedTimestampsSupported)
+		{
+			extensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+		}
+		if (is_extension_available(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME))
+		{
+			const auto host_image_copy_features = m_physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceHostImageCopyFeaturesEXT>();
+			if (host_image_copy_features.get<vk::PhysicalDeviceHostImageCopyFeaturesEXT>().hostImageCopy)
+			{
+				// Uploads leave textures in the layout they are sampled in, so that has to be one the host can copy to.
+				vk::PhysicalDeviceHostImageCopyPropertiesEXT host_image_copy_properties{};
+				vk::PhysicalDeviceProperties2 properties{};
+				properties.setPNext(&host_image_copy_properties);
+				m_physicalDevice.getProperties2(&properties);
+				std::vector<vk::ImageLayout> copyDstLayouts(host_image_copy_properties.copyDstLayoutCount);
+				host_image_copy_properties.setPCopySrcLayouts(nullptr);
+				host_image_copy_properties.setCopySrcLayoutCount(0);
+				host_image_copy_properties.setPCopyDstLayouts(copyDstLayouts.data());
+				m_physicalDevice.getProperties2(&properties);
+				m_hostImageCopySupported = std::find(copyDstLayouts.begin(), copyDstLayouts.end(), vk::ImageLayout::eShaderReadOnlyOptimal) != copyDstLayouts.end();
+			}
+		}
+		if (m_hostImageCopySupported)
+		{
+			extensions.push_back(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME);
+		}
+		// Descriptors in buffers reference buffers by device address.
+		bool descriptorBufferPushDescriptorsSupported{ false };
+		if (deviceInfo.descriptorBufferSize > 0 && m_bufferDeviceAddressSupported && is_extension_available(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME))
+		{
+			const auto descriptor_buffer_features = m_physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceDescriptorBufferFeaturesEXT>();
+			m_descriptorBufferSupported = descriptor_buffer_features.get<vk::PhysicalDeviceDescriptorBufferFeaturesEXT>().descriptorBuffer;
+			// Push descriptors would otherwise need a descriptor buffer of their own bound.
+			const auto descriptor_buffer_properties = m_physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorBufferPropertiesEXT>();
+			descriptorBufferPushDescriptorsSupported = descriptor_buffer_features.get<vk::PhysicalDeviceDescriptorBufferFeaturesEXT>().descriptorBufferPushDescriptors &&
+													   descriptor_buffer_properties.get<vk::PhysicalDeviceDescriptorBufferPropertiesEXT>().bufferlessPushDescriptors;
+		}
+		if (m_descriptorBufferSupported)
+		{
+			extensions.push_back(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+		}
+		else if (deviceInfo.descriptorBufferSize > 0)
+		{
+			s_errorCallback("GFX - Descriptor buffers are not supported by this device, descriptor pools will be used!");
+		}
+		m_pushDescriptorSupported = is_extension_available(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME) && (!m_descriptorBufferSupported || descriptorBufferPushDescriptorsSupported);
+		if (m_pushDescriptorSupported)
+		{
+			extensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+		}
+		// Extended dynamic state 1 and 2 are core in Vulkan 1.3, only blend state needs the third.
+		if (graphicsEnabled && is_extension_available(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME))
+		{
+			const auto dynamic_state_3_features = m_physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT>();
+			const auto& supported_dynamic_state_3_features = dynamic_state_3_features.get<vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT>();
+			m_dynamicBlendStateSupported = supported_dynamic_state_3_features.extendedDynamicState3ColorBlendEnable &&
+										   supported_dynamic_state_3_features.extendedDynamicState3ColorBlendEquation &&
+										   supported_dynamic_state_3_features.extendedDynamicState3ColorWriteMask;
+		}
+		if (m_dynamicBlendStateSupported)
+		{
+			extensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+		}
+		// Without fast linking, linking libraries can take as long as compiling the whole pipeline.
+		if (graphicsEnabled && is_extension_available(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) && is_extension_available(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME))
+		{
+			const auto library_features = m_physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT>();
+			const auto library_properties = m_physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceGraphicsPipelineLibraryPropertiesEXT>();
+			m_graphicsPipelineLibrarySupported = library_features.get<vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT>().graphicsPipelineLibrary &&
+												 library_properties.get<vk::PhysicalDeviceGraphicsPipelineLibraryPropertiesEXT>().graphicsPipelineLibraryFastLinking;
+		}
+		if (m_graphicsPipelineLibrarySupported)
+		{
+			extensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+			extensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+		}
+		if (graphicsEnabled && deviceInfo.shaderObjects && is_extension_available(VK_EXT_SHADER_OBJECT_EXTENSION_NAME))
+		{
+			const auto shader_object_features = m_physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceShaderObjectFeaturesEXT>();
+			m_shaderObjectsEnabled = shader_object_features.get<vk::PhysicalDeviceShaderObjectFeaturesEXT>().shaderObject;
+		}
+		if (m_shaderObjectsEnabled)
+		{
+			extensions.push_back(VK_EXT_SHADER_OBJECT_EXTENSION_NAME);
+		}
+		else if (deviceInfo.shaderObjects)
+		{
+			s_errorCallback("GFX - Shader objects are not supported by this device, graphics pipelines will be compiled!");
+		}
+		if (graphicsEnabled && is_extension_available(VK_EXT_MESH_SHADER_EXTENSION_NAME))
+		{
+			const auto mesh_shader_features = m_physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceMeshShaderFeaturesEXT>();
+			const auto& supported_mesh_shader_features = mesh_shader_features.get<vk::PhysicalDeviceMeshShaderFeaturesEXT>();
+			m_meshShaderSupported = supported_mesh_shader_features.taskShader && supported_mesh_shader_features.meshShader;
+		}
+		if (m_meshShaderSupported)
+		{
+			extensions.push_back(VK_EXT_MESH_SHADER_EXTENSION_NAME);
+		}
+		if (graphicsEnabled && is_extension_available(VK_EXT_VERTEX_ATTRIBUTE_DIVISOR_EXTENSION_NAME))
+		{
+			const auto divisor_features = m_physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVertexAttributeDivisorFeaturesEXT>();
+			const auto& supported_divisor_features = divisor_features.get<vk::PhysicalDeviceVertexAttributeDivisorFeaturesEXT>();
+			m_vertexAttributeDivisorSupported = supported_divisor_features.vertexAttributeInstanceRateDivisor && supported_divisor_features.vertexAttributeInstanceRateZeroDivisor;
+		}
+		if (m_vertexAttributeDivisorSupported)
+		{
+			extensions.push_back(VK_EXT_VERTEX_ATTRIBUTE_DIVISOR_EXTENSION_NAME);
+		}
+		if (graphicsEnabled && is_extension_available(VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME))
+		{
+			const auto shading_rate_features = m_physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceFragmentShadingRateFeaturesKHR>();
+			const auto& supported_shading_rate_features = shading_rate_features.get<vk::PhysicalDeviceFragmentShadingRateFeaturesKHR>();
+			m_shadingRateSupported = supported_shading_rate_features.pipelineFragmentShadingRate && supported_shading_rate_features.attachmentFragmentShadingRate;
+		}
+		if (m_shadingRateSupported)
+		{
+			extensions.push_back(VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME);
+		}
+		if (is_extension_available(VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME))
+		{
+			const auto conditional_rendering_features = m_physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceConditionalRenderingFeaturesEXT>();
+			m_conditionalRenderingSupported = conditional_rendering_features.get<vk::PhysicalDeviceConditionalRenderingFeaturesEXT>().conditionalRendering;
+		}
+		if (m_conditionalRenderingSupported)
+		{
+			extensions.push_back(VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME);
+		}
+		if (graphicsEnabled && is_extension_available(VK_KHR_DYNAMIC_RENDERING_LOCAL_READ_EXTENSION_NAME))
+		{
+			const auto local_read_features = m_physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceDynamicRenderingLocalReadFeaturesKHR>();
+			m_localReadSupported = local_read_features.get<vk::PhysicalDeviceDynamicRenderingLocalReadFeaturesKHR>().dynamicRenderingLocalRead;
+		}
+		if (m_localReadSupported)
+		{
+			extensions.push_back(VK_KHR_DYNAMIC_RENDERING_LOCAL_READ_EXTENSION_NAME);
+		}
+#if _WIN32
+		m_externalMemorySupported = is_extension_available(VK_KHR_EXTERNAL_MEMORY_WIN32_EXTENSION_NAME) && is_extension_available(VK_KHR_EXTERNAL_SEMAPHORE_WIN32_EXTENSION_NAME);
+#else
+		m_externalMemorySupported = is_extension_available(VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME) && is_extension_available(VK_KHR_EXTERNAL_SEMAPHORE_FD_EXTENSION_NAME);
+#endif
+		m_videoDecodeSupported = is_extension_available(VK_KHR_VIDEO_QUEUE_EXTENSION_NAME) && is_extension_available(VK_KHR_VIDEO_DECODE_QUEUE_EXTENSION_NAME) &&
+								 (is_extension_available(VK_KHR_VIDEO_DECODE_H264_EXTENSION_NAME) || is_extension_available(VK_KHR_VIDEO_DECODE_H265_EXTENSION_NAME) ||
+								  is_extension_available(VK_KHR_VIDEO_DECODE_AV1_EXTENSION_NAME));
+		// Builds need device addresses, and compaction resets its size queries from the host.
+		if (is_extension_available(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME) && is_extension_available(VK_KHR_RAY_QUERY_EXTENSION_NAME) &&
+			is_extension_available(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME) && m_bufferDeviceAddressSupported &&
+			supported_features.get<vk::PhysicalDeviceVulkan12Features>().hostQueryReset)
+		{
+			const auto ray_query_features =
+				m_physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceAccelerationStructureFeaturesKHR, vk::PhysicalDeviceRayQueryFeaturesKHR>();
+			m_rayQuerySupported =
+				ray_query_features.get<vk::PhysicalDeviceAccelerationStructureFeaturesKHR>().accelerationStructure && ray_query_features.get<vk::PhysicalDeviceRayQueryFeaturesKHR>().rayQuery;
+		}
+
+		// Features enabled where supported count as granted whether asked for or not, the rest only when asked for.
+		const auto& supported_vulkan_11_features = supported_features.get<vk::PhysicalDeviceVulkan11Features>();
+		const auto& supported_vulkan_12_features = supported_features.get<vk::PhysicalDeviceVulkan12Features>();
+		const auto& supported_vulkan_13_features = supported_features.get<vk::PhysicalDeviceVulkan13Features>();
+		const std::uint32_t supportedFeatures = (m_multiDrawIndirectSupported ? DeviceFeatureFlags_MultiDrawIndirect : 0u) |
+												(m_drawIndirectCountSupported ? DeviceFeatureFlags_DrawIndirectCount : 0u) |
+												(m_maxSamplerAnisotropy > 0.0f ? DeviceFeatureFlags_SamplerAnisotropy : 0u) |
+												(m_imageCubeArraySupported ? DeviceFeatureFlags_ImageCubeArray : 0u) |
+												(m_bufferDeviceAddressSupported ? DeviceFeatureFlags_BufferDeviceAddress : 0u) |
+												(m_sparseBufferSupported ? DeviceFeatureFlags_SparseBuffers : 0u) |
+												(m_sparseTextureSupported ? DeviceFeatureFlags_SparseTextures : 0u) |
+												(m_meshShaderSupported ? DeviceFeatureFlags_MeshShader : 0u) |
+												(m_vertexAttributeDivisorSupported ? DeviceFeatureFlags_VertexAttributeDivisor : 0u) |
+												(supported_vulkan_11_features.multiview ? DeviceFeatureFlags_Multiview : 0u) |
+												(m_shadingRateSupported ? DeviceFeatureFlags_ShadingRate : 0u) |
+												(m_conditionalRenderingSupported ? DeviceFeatureFlags_ConditionalRendering : 0u) |
+												(m_rayQuerySupported ? DeviceFeatureFlags_RayQuery : 0u) |
+												(m_externalMemorySupported ? DeviceFeatureFlags_ExternalMemory : 0u) |
+												(m_videoDecodeSupported ? DeviceFeatureFlags_VideoDecode : 0u) |
+												(m_localReadSupported ? DeviceFeatureFlags_LocalRead : 0u) |
+												(supported_vulkan_13_features.inlineUniformBlock ? DeviceFeatureFlags_InlineUniformBlock : 0u) |
+												(supported_core_features.shaderInt16 ? DeviceFeatureFlags_ShaderInt16 : 0u) |
+												(supported_core_features.shaderInt64 ? DeviceFeatureFlags_ShaderInt64 : 0u) |
+												(supported_vulkan_12_features.shaderFloat16 ? DeviceFeatureFlags_ShaderFloat16 : 0u) |
+												(supported_vulkan_12_features.shaderInt8 ? DeviceFeatureFlags_ShaderInt8 : 0u) |
+												(supported_vulkan_11_features.storageBuffer16BitAccess && supported_vulkan_11_features.uniformAndStorageBuffer16BitAccess &&
+														 supported_vulkan_11_features.storagePushConstant16
+													 ? DeviceFeatureFlags_Storage16Bit
+													 : 0u) |
+												(supported_vulkan_12_features.storageBuffer8BitAccess && supported_vulkan_12_features.uniformAndStorageBuffer8BitAccess
+													 ? DeviceFeatureFlags_Storage8Bit
+													 : 0u) |
+												(supported_vulkan_12_features.scalarBlockLayout ? DeviceFeatureFlags_ScalarBlockLayout : 0u) |
+												(supported_vulkan_11_features.shaderDrawParameters ? DeviceFeatureFlags_ShaderDrawParameters : 0u) |
+												(supported_vulkan_13_features.subgroupSizeControl && supported_vulkan_13_features.computeFullSubgroups ? DeviceFeatureFlags_SubgroupSizeControl : 0u) |
+												(supported_core_features.independentBlend ? DeviceFeatureFlags_IndependentBlend : 0u) |
+												(supported_core_features.fragmentStoresAndAtomics ? DeviceFeatureFlags_FragmentStoresAndAtomics : 0u) |
+												(supported_core_features.vertexPipelineStoresAndAtomics ? DeviceFeatureFlags_VertexPipelineStoresAndAtomics : 0u) |
+												(supported_core_features.shaderStorageImageWriteWithoutFormat ? DeviceFeatureFlags_StorageImageWriteWithoutFormat : 0u);
+		constexpr std::uint32_t WHERE_SUPPORTED_FEATURES = DeviceFeatureFlags_MultiDrawIndirect | DeviceFeatureFlags_DrawIndirectCount | DeviceFeatureFlags_SamplerAnisotropy |
+														 DeviceFeatureFlags_ImageCubeArray | DeviceFeatureFlags_BufferDeviceAddress | DeviceFeatureFlags_SparseBuffers |
+														 DeviceFeatureFlags_SparseTextures | DeviceFeatureFlags_MeshShader | DeviceFeatureFlags_VertexAttributeDivisor |
+														 DeviceFeatureFlags_Multiview | DeviceFeatureFlags_ShadingRate | DeviceFeatureFlags_ConditionalRendering |
+														 DeviceFeatureFlags_LocalRead | DeviceFeatureFlags_InlineUniformBlock;
+		if ((deviceInfo.requiredFeatures & supportedFeatures) != deviceInfo.requiredFeatures)
+		{
+			s_errorCallback("GFX - The device does not support every feature in DeviceInfo::requiredFeatures!");
+			return;
+		}
+		m_enabledFeatures = supportedFeatures & (deviceInfo.requestedFeatures | deviceInfo.requiredFeatures | WHERE_SUPPORTED_FEATURES);
+		const auto is_feature_enabled = [this](std::uint32_t feature) { return (m_enabledFeatures & feature) != 0; };
+		if (is_feature_enabled(DeviceFeatureFlags_RayQuery))
+		{
+			extensions.push_back(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME);
+			extensions.push_back(VK_KHR_RAY_QUERY_EXTENSION_NAME);
+			extensions.push_back(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME);
+		}
+		if (is_feature_enabled(DeviceFeatureFlags_ExternalMemory))
+		{
+#if _WIN32
+			extensions.push_back(VK_KHR_EXTERNAL_MEMORY_WIN32_EXTENSION_NAME);
+			extensions.push_back(VK_KHR_EXTERNAL_SEMAPHORE_WIN32_EXTENSION_NAME);
+#else
+			extensions.push_back(VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME);
+			extensions.push_back(VK_KHR_EXTERNAL_SEMAPHORE_FD_EXTENSION_NAME);
+#endif
+		}
+		if (is_feature_enabled(DeviceFeatureFlags_VideoDecode))
+		{
+			// Each codec's decoders fail to create where its extension is missing.
+			extensions.push_back(VK_KHR_VIDEO_QUEUE_EXTENSION_NAME);
+			extensions.push_back(VK_KHR_VIDEO_DECODE_QUEUE_EXTENSION_NAME);
+			for (const auto* codecExtension : { VK_KHR_VIDEO_DECODE_H264_EXTENSION_NAME, VK_KHR_VIDEO_DECODE_H265_EXTENSION_NAME, VK_KHR_VIDEO_DECODE_AV1_EXTENSION_NAME })
+			{
+				if (is_extension_available(codecExtension))
+				{
+					extensions.push_back(codecExtension);
+				}
+			}
+		}
+
+		vk::PhysicalDeviceFeatures features{};
+		features.setMultiDrawIndirect(m_multiDrawIndirectSupported);
+		features.setImageCubeArray(m_imageCubeArraySupported);
+		features.setSamplerAnisotropy(m_maxSamplerAnisotropy > 0.0f);
+		features.setSparseBinding(m_sparseBufferSupported || m_sparseTextureSupported);
+		features.setSparseResidencyBuffer(m_sparseBufferSupported);
+		features.setSparseResidencyImage2D(m_sparseTextureSupported);
+		features.setPipelineStatisticsQuery(m_pipelineStatisticsSupported);
+		features.setOcclusionQueryPrecise(m_occlusionQueryPreciseSupported);
+		features.setShaderInt16(is_feature_enabled(DeviceFeatureFlags_ShaderInt16));
+		features.setShaderInt64(is_feature_enabled(DeviceFeatureFlags_ShaderInt64));
+		features.setIndependentBlend(is_feature_enabled(DeviceFeatureFlags_IndependentBlend));
+		features.setFragmentStoresAndAtomics(is_feature_enabled(DeviceFeatureFlags_FragmentStoresAndAtomics));
+		features.setVertexPipelineStoresAndAtomics(is_feature_enabled(DeviceFeatureFlags_VertexPipelineStoresAndAtomics));
+		features.setShaderStorageImageWriteWithoutFormat(is_feature_enabled(DeviceFeatureFlags_StorageImageWriteWithoutFormat));
+		vk::PhysicalDeviceVulkan11Features vulkan_11_features{};
+		vulkan_11_features.setStorageBuffer16BitAccess(is_feature_enabled(DeviceFeatureFlags_Storage16Bit));
+		vulkan_11_features.setUniformAndStorageBuffer16BitAccess(is_feature_enabled(DeviceFeatureFlags_Storage16Bit));
+		vulkan_11_features.setStoragePushConstant16(is_feature_enabled(DeviceFeatureFlags_Storage16Bit));
+		vulkan_11_features.setShaderDrawParameters(is_feature_enabled(DeviceFeatureFlags_ShaderDrawParameters));
+		vulkan_11_features.setMultiview(is_feature_enabled(DeviceFeatureFlags_Multiview));
+		vk::PhysicalDeviceVulkan12Features vulkan_12_features{};
+		vulkan_12_features.setPNext(&vulkan_11_features);
+		vulkan_12_features.setShaderFloat16(is_feature_enabled(DeviceFeatureFlags_ShaderFloat16));
+		vulkan_12_features.setShaderInt8(is_feature_enabled(DeviceFeatureFlags_ShaderInt8));
+		vulkan_12_features.setStorageBuffer8BitAccess(is_feature_enabled(DeviceFeatureFlags_Storage8Bit));
+		vulkan_12_features.setUniformAndStorageBuffer8BitAccess(is_feature_enabled(DeviceFeatureFlags_Storage8Bit));
+		vulkan_12_features.setScalarBlockLayout(is_feature_enabled(DeviceFeatureFlags_ScalarBlockLayout));
+		vulkan_12_features.setTimelineSemaphore(true);
+		vulkan_12_features.setDrawIndirectCount(m_drawIndirectCountSupported);
+		vulkan_12_features.setBufferDeviceAddress(m_bufferDeviceAddressSupported);
+		vulkan_12_features.setRuntimeDescriptorArray(m_bindlessSupported);
+		vulkan_12_features.setDescriptorBindingPartiallyBound(m_bindlessSupported);
+		vulkan_12_features.setDescriptorBindingUpdateUnusedWhilePending(m_bindlessSupported);
+		vulkan_12_features.setDescriptorBindingSampledImageUpdateAfterBind(m_bindlessSupported);
+		vulkan_12_features.setDescriptorBindingStorageBufferUpdateAfterBind(m_bindlessSupported);
+		vulkan_12_features.setShaderSampledImageArrayNonUniformIndexing(m_bindlessSupported);
+		vulkan_12_features.setShaderStorageBufferArrayNonUniformIndexing(m_bindlessSupported);
+		vulkan_12_features.setHostQueryReset(m_gpuScopesPerFrame > 0 || m_gpuQueriesPerFrame > 0 || is_feature_enabled(DeviceFeatureFlags_RayQuery));
+		vk::PhysicalDeviceInlineUniformBlockFeatures inline_uniform_block_features{ is_feature_enabled(DeviceFeatureFlags_InlineUniformBlock), false, &vulkan_12_features };
+		vk::PhysicalDeviceSynchronization2Features sync_2_features{ true, &inline_uniform_block_features };
+		vk::PhysicalDeviceDynamicRenderingFeatures dynamic_rendering_features{ graphicsEnabled, &sync_2_features };
+
+		vk::DeviceCreateInfo vk_device_info{};
+		vk_device_info.setPEnabledExtensionNames(extensions);
+		vk_device_info.setQueueCreateInfos(queue_info_vec);
+		vk_device_info.setPEnabledFeatures(&features);
+		vk_device_info.setPNext(&dynamic_rendering_features);
+
+		vk::PhysicalDevicePresentIdFeaturesKHR present_id_features{ true };
+		vk::PhysicalDevicePresentWaitFeaturesKHR present_wait_features{ true, &present_id_features };
+		if (m_presentWaitSupported)
+		{
+			present_id_features.setPNext(vk_device_info.pNext);
+			vk_device_info.setPNext(&present_wait_features);
+		}
+		vk::PhysicalDeviceAntiLagFeaturesAMD anti_lag_features{ true };
+		if (m_antiLagSupported)
+		{
+			anti_lag_features.setPNext(vk_device_info.pNext);
+			vk_device_info.setPNext(&anti_lag_features);
+		}
+		vk::PhysicalDeviceHostImageCopyFeaturesEXT host_image_copy_features{ true };
+		if (m_hostImageCopySupported)
+		{
+			host_image_copy_features.setPNext(vk_device_info.pNext);
+			vk_device_info.setPNext(&host_image_copy_features);
+		}
+		vk::PhysicalDeviceDescriptorBufferFeaturesEXT descriptor_buffer_features{ true };
+		descriptor_buffer_features.setDescriptorBufferPushDescriptors(m_pushDescriptorSupported);
+		if (m_descriptorBufferSupported)
+		{
+			descriptor_buffer_features.setPNext(vk_device_info.pNext);
+			vk_device_info.setPNext(&descriptor_buffer_features);
+		}
+		vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT dynamic_state_3_features{};
+		dynamic_state_3_features.setExtendedDynamicState3ColorBlendEnable(true);
+		dynamic_state_3_features.setExtendedDynamicState3ColorBlendEquation(true);
+		dynamic_state_3_features.setExtendedDynamicState3ColorWriteMask(true);
+		if (m_dynamicBlendStateSupported)
+		{
+			dynamic_state_3_features.setPNext(vk_device_info.pNext);
+			vk_device_info.setPNext(&dynamic_state_3_features);
+		}
+		vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphics_pipeline_library_features{ true };
+		if (m_graphicsPipelineLibrarySupported)
+		{
+			graphics_pipeline_library_features.setPNext(vk_device_info.pNext);
+			vk_device_info.setPNext(&graphics_pipeline_library_features);
+		}
+		vk::PhysicalDeviceShaderObjectFeaturesEXT shader_object_features{ true };
+		if (m_shaderObjectsEnabled)
+		{
+			shader_object_features.setPNext(vk_device_info.pNext);
+			vk_device_info.setPNext(&shader_object_features);
+		}
+		vk::PhysicalDeviceMeshShaderFeaturesEXT mesh_shader_features{ true, true };
+		if (m_meshShaderSupported)
+		{
+			mesh_shader_features.setPNext(vk_device_info.pNext);
+			vk_device_info.setPNext(&mesh_shader_features);
+		}
+		vk::PhysicalDeviceVertexAttributeDivisorFeaturesEXT divisor_features{ true, true };
+		if (m_vertexAttributeDivisorSupported)
+		{
+			divisor_features.setPNext(vk_device_info.pNext);
+			vk_device_info.setPNext(&divisor_features);
+		}
+		vk::PhysicalDeviceFragmentShadingRateFeaturesKHR shading_rate_features{ true, false, true };
+		if (m_shadingRateSupported)
+		{
+			shading_rate_features.setPNext(vk_device_info.pNext);
+			vk_device_info.setPNext(&shading_rate_features);
+		}
+		vk::PhysicalDeviceConditionalRenderingFeaturesEXT conditional_rendering_features{ true, false };
+		if (m_conditionalRenderingSupported)
+		{
+			conditional_rendering_features.setPNext(vk_device_info.pNext);
+			vk_device_info.setPNext(&conditional_rendering_features);
+		}
+		vk::PhysicalDeviceDynamicRenderingLocalReadFeaturesKHR local_read_features{ true };
+		if (m_localReadSupported)
+		{
+			local_read_features.setPNext(vk_device_info.pNext);
+			vk_device_info.setPNext(&local_read_features);
+		}
+		vk::PhysicalDeviceMemoryPriorityFeaturesEXT memory_priority_features{ true };
+		if (m_memoryPrioritySupported)
+		{
+			memory_priority_features.setPNext(vk_device_info.pNext);
+			vk_device_info.setPNext(&memory_priority_features);
+		}
+		vk::PhysicalDevicePageableDeviceLocalMemoryFeaturesEXT pageable_memory_features{ true };
+		if (m_pageableMemorySupported)
+		{
+			pageable_memory_features.setPNext(vk_device_info.pNext);
+			vk_device_info.setPNext(&pageable_memory_features);
+		}
+		vk::PhysicalDeviceAccelerationStructureFeaturesKHR acceleration_structure_features{ true };
+		vk::PhysicalDeviceRayQueryFeaturesKHR ray_query_features{ true, &acceleration_structure_features };
+		if (is_feature_enabled(DeviceFeatureFlags_RayQuery))
+		{
+			acceleration_structure_features.setPNext(vk_device_info.pNext);
+			vk_device_info.setPNext(&ray_query_features);
+		}
+		// Core in Vulkan 1.3, but its features struct cannot be chained next to the synchronization2 and dynamic rendering ones.
+		vk::PhysicalDeviceSubgroupSizeControlFeatures subgroup_size_control_features{ true, true };
+		if (is_feature_enabled(DeviceFeatureFlags_SubgroupSizeControl))
+		{
+			subgroup_size_control_features.setPNext(vk_device_info.pNext);
+			vk_device_info.setPNext(&subgroup_size_control_features);
+		}
+		vk::DeviceGroupDeviceCreateInfo device_group_info{ m_deviceGroupPhysicalDevices };
+		if (m_deviceGroupPhysicalDevices.size() > 1)
+		{
+			device_group_info.setPNext(vk_device_info.pNext);
+			vk_device_info.setPNext(&device_group_info);
+		}
+		auto device_result = m_physicalDevice.createDeviceUnique(vk_device_info);
+		if (device_result.result == vk::Result::eErrorNotPermittedEXT && useGlobalPriority)
+		{
+			// Elevated global priorities are a request, not a requirement.
+			for (auto& queue_info : queue_info_vec)
+			{
+				queue_info.setPNext(nullptr);
+			}
+			device_result = m_physicalDevice.createDeviceUnique(vk_device_info);
+		}
+		m_device = std::move(device_result.value);
+		if (!*m_device)
+		{
+			s_errorCallback("GFX - Failed to create device!");
+			return;
+		}
+
+		VULKAN_HPP_DEFAULT_DISPATCHER.init(*m_device);
+
+		m_framesInFlight = std::max(deviceInfo.framesInFlight, 1u);
+		m_frameSubmitValues.resize(m_framesInFlight, QueueSubmitValues{});
+		m_frameTransientCommandLists.resize(m_framesInFlight);
+
+		create_gpu_query_frames();
+
+		if (deviceInfo.threadedSubmission)
+		{
+			m_submissionThread = std::make_unique<WorkerPool>(1);
+		}
+
+		std::unordered_map<std::uint32_t, std::uint32_t> queueIndexMap;
+		for (auto i = 0; i < m_queueFamilies.size(); ++i)
+		{
+			auto queueFamily = m_queueFamilies[i];
+
+			auto queueIndex = queueIndexMap[queueFamily];
+			m_queues[i] = m_device->getQueue(queueFamily, queueIndex);
+			queueIndexMap[queueFamily] += 1;
+
+			auto& queueTimeline = m_queueTimelines.emplace_back();
+			queueTimeline.submitMutex = &m_queueMutexes[{ queueFamily, queueIndex }];
+		}
+
+		for (auto i = 0; i < m_queues.size(); ++i)
+		{
+			vk::SemaphoreTypeCreateInfo timeline_semaphore_type_info{ vk::SemaphoreType::eTimeline, 0 };
+			vk::SemaphoreCreateInfo timeline_semaphore_info{};
+			timeline_semaphore_info.setPNext(&timeline_semaphore_type_info);
+			// Lets export_queue_timeline() hand it to other processes.
+			const vk::ExportSemaphoreCreateInfo export_semaphore_info{ EXTERNAL_TIMELINE_HANDLE_TYPE };
+			if (supports_external_memory())
+			{
+				timeline_semaphore_type_info.setPNext(&export_semaphore_info);
+			}
+
+			m_queueTimelines[i].semaphore = m_device->createSemaphoreUnique(timeline_semaphore_info).value;
+		}
+
+		vma::AllocatorCreateInfo allocator_info{};
+		allocator_info.setInstance(m_context->get_instance());
+		allocator_info.setPhysicalDevice(m_physicalDevice);
+		allocator_info.setDevice(m_device.get());
+		allocator_info.setVulkanApiVersion(VK_API_VERSION_1_3);
+		vma::AllocatorCreateFlags allocator_flags{};
+		if (m_memoryBudgetSupported)
+		{
+			// Without it VMA estimates the budget as 80% of each heap, unaware of other processes.
+			allocator_flags |= vma::AllocatorCreateFlagBits::eExtMemoryBudget;
+		}
+		if (m_memoryPrioritySupported)
+		{
+			// Otherwise VMA ignores AllocationCreateInfo::priority.
+			allocator_flags |= vma::AllocatorCreateFlagBits::eExtMemoryPriority;
+		}
+		if (m_bufferDeviceAddressSupported)
+		{
+			// Memory of buffers with eShaderDeviceAddress usage must be allocated with VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT.
+			allocator_flags |= vma::AllocatorCreateFlagBits::eBufferDeviceAddress;
+		}
+		allocator_info.setFlags(allocator_flags);
+		m_allocator = vma::createAllocatorUnique(allocator_info).value;
+
+		// A cache from another device or driver would be rejected or, with buggy drivers, misused, so only matching headers are loaded.
+		m_pipelineCachePath = deviceInfo.pipelineCachePath;
+		std::vector<char> pipelineCacheData{};
+		if (!m_pipelineCachePath.empty())
+		{
+			if (std::ifstream file(m_pipelineCachePath, std::ios::binary); file)
+			{
+				pipelineCacheData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			}
+
+			const auto& properties = physicalDeviceProperties;
+			VkPipelineCacheHeaderVersionOne header{};
+			if (pipelineCacheData.size() >= sizeof(header))
+			{
+				std::memcpy(&header, pipelineCacheData.data(), sizeof(header));
+			}
+			const bool isCompatible = pipelineCacheData.size() >= sizeof(header) && header.headerSize >= sizeof(header) && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+									  header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+									  std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+			if (!isCompatible)
+			{
+				pipelineCacheData.clear();
+			}
+		}
+		vk::PipelineCacheCreateInfo pipeline_cache_info{};
+		pipeline_cache_info.setInitialDataSize(pipelineCacheData.size());
+		pipeline_cache_info.setPInitialData(pipelineCacheData.data());
+		m_pipelineCache = m_device->createPipelineCacheUnique(pipeline_cache_info).value;
+		if (!deviceInfo.pipelineManifestPath.empty())
+		{
+			m_pipelineManifest = std::make_unique<PipelineManifest>();
+			if (!m_pipelineManifest->open(deviceInfo.pipelineManifestPath))
+			{
+				s_errorCallback("GFX - Failed to open the pipeline manifest, pipelines will not be recorded!");
+				m_pipelineManifest.reset();
+			}
+		}
+
+		const bool inlineUniformBlocks = is_feature_enabled(DeviceFeatureFlags_InlineUniformBlock);
+		m_persistentDescriptorAllocator = std::make_unique<DescriptorAllocator>(m_device.get(), 128, inlineUniformBlocks);
+		m_frameDescriptorAllocators.resize(m_framesInFlight);
+		for (auto& frameDescriptorAllocator : m_frameDescriptorAllocators)
+		{
+			frameDescriptorAllocator = std::make_unique<DescriptorAllocator>(m_device.get(), 64, inlineUniformBlocks);
+		}
+		m_frameTransientDescriptorSets.resize(m_framesInFlight);
+		if (m_descriptorBufferSupported)
+		{
+			const auto properties = m_physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorBufferPropertiesEXT>();
+			m_descriptorBuffer = std::make_unique<DescriptorBuffer>(m_device.get(), m_allocator.get(), properties.get<vk::PhysicalDeviceDescriptorBufferPropertiesEXT>(), deviceInfo.descriptorBufferSize, m_framesInFlight);
+		}
+
+		if (m_bindlessSupported)
+		{
+			const auto properties = m_physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorIndexingProperties>();
+			const auto& indexing_properties = properties.get<vk::PhysicalDeviceDescriptorIndexingProperties>();
+			const std::array<std::uint32_t, BindlessHeap::BINDING_COUNT> slotCounts{
+				std::min({ deviceInfo.bindlessTextureCount, indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages, indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages }),
+				std::min({ deviceInfo.bindlessSamplerCount, indexing_properties.maxDescriptorSetUpdateAfterBindSamplers, indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers }),
+				std::min({ deviceInfo.bindlessStorageBufferCount, indexing_properties.maxDescriptorSetUpdateAfterBindStorageBuffers, indexing_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers }),
+			};
+			m_bindlessHeap = std::make_unique<BindlessHeap>(m_device.get(), slotCounts, m_descriptorBuffer.get());
+			m_bindlessHeapHandle = DescriptorSetHandle(m_deviceHandle, m_descriptorSetPool.emplace(m_bindlessHeap->get_set(), m_bindlessHeap->get_binding_types(), m_bindlessHeap->get_layout(),
+																								  m_bindlessHeap->get_descriptor_buffer_offset()));
+		}
+
+		const auto& limits = physicalDeviceProperties.limits;
+		m_minUniformBufferOffsetAlignment = limits.minUniformBufferOffsetAlignment;
+		m_colorSampleCounts = limits.framebufferColorSampleCounts;
+		m_depthSampleCounts = limits.framebufferDepthSampleCounts;
+		m_maxVertexInputAttributeOffset = limits.maxVertexInputAttributeOffset;
+		m_maxVertexInputBindingStride = limits.maxVertexInputBindingStride;
+		init_properties(extensions);
+		if (supports_ray_query())
+		{
+			vk::QueryPoolCreateInfo query_pool_info{};
+			query_pool_info.setQueryType(vk::QueryType::eAccelerationStructureCompactedSizeKHR);
+			query_pool_info.setQueryCount(MAX_COMPACTING_ACCELERATION_STRUCTURES);
+			m_compactionQueryPool = m_device->createQueryPoolUnique(query_pool_info).value;
+			for (auto query = MAX_COMPACTING_ACCELERATION_STRUCTURES; query > 0; --query)
+			{
+				m_freeCompactionQueries.push_back(query - 1);
+			}
+		}
+		if (deviceInfo.transientBufferSize > 0)
+		{
+			m_transientFrameSize = deviceInfo.transientBufferSize;
+			create_buffer(m_transientBufferHandle,
+						  { .type = BufferType::eTransient, .size = m_transientFrameSize * m_framesInFlight, .accelerationStructureInput = supports_ray_query() });
+
+			Buffer* transientBuffer{ nullptr };
+			if (get_buffer(transientBuffer, m_transientBufferHandle))
+			{
+				m_transientBufferPtr = static_cast<std::byte*>(transientBuffer->get_mapped_pointer());
+			}
+		}
+
+		if (deviceInfo.uploadBufferSize > 0)
+		{
+			if (deviceInfo.uploadQueueIndex < m_queues.size())
+			{
+				m_uploadManager = std::make_unique<UploadManager>(*this, deviceInfo.uploadQueueIndex, deviceInfo.uploadBufferSize);
+			}
+			else
+			{
+				s_errorCallback("GFX - DeviceInfo::uploadQueueIndex is not a valid queue index!");
+			}
+		}
+
+		m_defragmenter = std::make_unique<Defragmenter>(*this);
+	}
+
+	Device::~Device()
+	{
+		m_submissionThread.reset();
+		{
+			std::unique_lock lock(m_pendingTasksMutex);
+			m_pendingTasksCondition.wait(lock, [this] { return m_pendingTasks == 0; });
+		}
+		m_workerPool.reset();
+
+		if (m_device)
+		{
+			wait_for_idle();
+			save_pipeline_cache();
+		}
+
+		// Command lists free their command buffers into the per-thread pools, so they go first, then the pools of every thread
+		// that recorded, while the device is still alive.
+		m_commandListPool.clear();
+		m_frameTransientCommandLists.clear();
+		m_commandPools.clear();
+
+		// Nothing is left to signal or wait on the queue timelines once the device is idle.
+		m_queueTimelines.clear();
+	}
+
+	bool Device::save_pipeline_cache()
+	{
+		if (m_pipelineCachePath.empty() || !m_pipelineCache)
+		{
+			return false;
+		}
+
+		const auto data = m_device->getPipelineCacheData(m_pipelineCache.get()).value;
+		// Written next to the file and then renamed over it, so a crash mid-write never leaves a truncated cache.
+		const auto tempPath = m_pipelineCachePath + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file || !file.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size())))
+			{
+				s_errorCallback("GFX - Failed to write the pipeline cache!");
+				return false;
+			}
+		}
+		std::error_code error{};
+		std::filesystem::rename(tempPath, m_pipelineCachePath, error);
+		if (error)
+		{
+			s_errorCallback("GFX - Failed to write the pipeline cache!");
+			return false;
+		}
+		return true;
+	}
+
+	bool Device::is_valid() const
+	{
+		return static_cast<bool>(*m_device);
+	}
+
+	bool Device::get_queue(vk::Queue& outQueue, std::uint32_t queueIndex)
+	{
+		if (queueIndex >= m_queues.size())
+		{
+			return false;
+		}
+
+		outQueue = m_queues.at(queueIndex);
+		return outQueue;
+	}
+
+	bool Device::get_ownership_transfer(QueueOwnershipTransfer& outTransfer, const CommandList& commandList, std::uint32_t srcQueueIndex, std::uint32_t dstQueueIndex) const
+	{
+		const auto is_valid_queue_index = [this](std::uint32_t queueIndex) {
+			return queueIndex < m_queues.size() || (queueIndex == EXTERNAL_QUEUE_INDEX && supports_external_memory());
+		};
+		if (!is_valid_queue_index(srcQueueIndex) || !is_valid_queue_index(dstQueueIndex))
+		{
+			s_errorCallback("GFX - Invalid queue index for ownership transfer!");
+			return false;
+		}
+
+		// The external side records its half with its own API, so only this device's side is checked.
+		const auto queue = commandList.get_queue();
+		const bool onSrcQueue = srcQueueIndex != EXTERNAL_QUEUE_INDEX && queue == m_queues[srcQueueIndex];
+		const bool onDstQueue = dstQueueIndex != EXTERNAL_QUEUE_INDEX && queue == m_queues[dstQueueIndex];
+		if (!onSrcQueue && !onDstQueue)
+		{
+			s_errorCallback("GFX - Ownership transfers must be recorded on a command list of the source or destination queue!");
+			return false;
+		}
+
+		outTransfer.srcQueueFamily = srcQueueIndex == EXTERNAL_QUEUE_INDEX ? VK_QUEUE_FAMILY_EXTERNAL : m_queueFamilies[srcQueueIndex];
+		outTransfer.dstQueueFamily = dstQueueIndex == EXTERNAL_QUEUE_INDEX ? VK_QUEUE_FAMILY_EXTERNAL : m_queueFamilies[dstQueueIndex];
+		outTransfer.release = onSrcQueue;
+		return true;
+	}
+
+	bool Device::is_present_mode_supported(vk::PresentModeKHR presentMode, vk::SurfaceKHR surface) const
+	{
+		auto supportedPresentModes = m_physicalDevice.getSurfacePresentModesKHR(surface).value;
+		return std::ranges::find(supportedPresentModes, presentMode) != supportedPresentModes.end();
+	}
+
+	auto Device::get_first_supported_surface_format(const std::vector<vk::Format>& formats, vk::SurfaceKHR surface) -> vk::Format
+	{
+		const auto supportedSurfaceFormats = m_physicalDevice.getSurfaceFormatsKHR(surface).value;
+		for (const auto& format : formats)
+		{
+			for (const auto& surfaceFormat : supportedSurfaceFormats)
+			{
+				if (surfaceFormat.format == format)
+					return format;
+			}
+		}
+
+		return vk::Format::eUndefined;
+	}
+
+	bool Device::wait_on_sync_points(std::span<const SyncPoint> syncPoints, bool waitAll, std::uint64_t timeoutNs)
+	{
+		// One value per queue timeline. Waiting for all needs the latest value on each queue, waiting for any only the earliest.
+		QueueSubmitValues submitValues{};
+		for (const auto& syncPoint : syncPoints)
+		{
+			if (syncPoint.value == 0)
+			{
+				if (!waitAll)
+				{
+					return true;
+				}
+				continue;
+			}
+			if (syncPoint.queueIndex >= m_queueTimelines.size())
+			{
+				s_errorCallback("GFX - SyncPoint has an invalid queue index!");
+				return false;
+			}
+
+			auto& submitValue = submitValues[syncPoint.queueIndex];
+			submitValue = submitValue == 0 ? syncPoint.value : (waitAll ? std::max(submitValue, syncPoint.value) : std::min(submitValue, syncPoint.value));
+		}
+
+		InlineVector<vk::Semaphore, MAX_QUEUES> semaphores{};
+		InlineVector<std::uint64_t, MAX_QUEUES> values{};
+		for (auto i = 0; i < m_queueTimelines.size(); ++i)
+		{
+			if (submitValues[i] != 0)
+			{
+				semaphores.push_back(m_queueTimelines[i].semaphore.get());
+				values.push_back(submitValues[i]);
+			}
+		}
+		if (semaphores.empty())
+		{
+			return true;
+		}
+
+		vk::SemaphoreWaitInfo wait_info{};
+		wait_info.setFlags(waitAll ? vk::SemaphoreWaitFlags{} : vk::SemaphoreWaitFlagBits::eAny);
+		wait_info.setSemaphores(semaphores);
+		wait_info.setValues(values);
+		return wait_semaphores(wait_info, timeoutNs) == vk::Result::eSuccess;
+	}
+
+	bool Device::is_sync_point_complete(const SyncPoint& syncPoint) const
+	{
+		if (syncPoint.queueIndex >= m_queueTimelines.size())
+		{
+			return true;
+		}
+
+		return get_completed_submit_value(syncPoint.queueIndex) >= syncPoint.value;
+	}
+
+	void Device::wait_for_idle()
+	{
+		flush_submissions();
+		m_device->waitIdle();
+
+		// Everything submitted has completed, so the whole queue can be flushed. Destroying may queue further destroys
+		// (eg. a retired texture's views), which are flushed too, so none are left to run against destroyed command pools.
+		while (true)
+		{
+			std::deque<DeferredDestroy> readyDestroys{};
+			{
+				std::lock_guard lock(m_deferredDestroyMutex);
+				std::swap(readyDestroys, m_deferredDestroyQueue);
+			}
+			if (readyDestroys.empty())
+			{
+				break;
+			}
+			for (auto& deferredDestroy : readyDestroys)
+			{
+				deferredDestroy.destroyFunc();
+			}
+		}
+	}
+
+	void Device::begin_frame()
+	{
+		const auto previousFrameIndex = get_frame_index();
+		if (!m_frameEnded)
+		{
+			m_frameSubmitValues[previousFrameIndex] = get_submit_values();
+		}
+		m_frameEnded = false;
+
+		const auto frameIndex = (previousFrameIndex + 1) % m_framesInFlight;
+		wait_on_submit_values(m_frameSubmitValues[frameIndex]);
+
+		resolve_gpu_queries(frameIndex);
+		reset_frame_command_pools(frameIndex);
+		reset_frame_descriptor_sets(frameIndex);
+		age_cached_descriptor_sets();
+		m_transientHead.store(0, std::memory_order_relaxed);
+		release_retired_acceleration_structures();
+		// Also refreshes VMA's cached heap budgets.
+		m_allocator->setCurrentFrameIndex(++m_frameNumber);
+		m_frameIndex.store(frameIndex, std::memory_order_relaxed);
+		if (!m_gpuQueryFrames.empty())
+		{
+			m_gpuQueryFrames[frameIndex].frameNumber = m_frameNumber;
+		}
+
+#if GFX_FRAME_STATS_ENABLED
+		{
+			std::scoped_lock lock(m_frameStatsMutex);
+			m_frameStats.frameNumber = m_frameNumber - 1;
+			for (const auto counter : s_frameStatCounters)
+			{
+				m_frameStats.*counter = std::atomic_ref<std::uint64_t>(m_currentFrameStats.*counter).exchange(0, std::memory_order_relaxed);
+			}
+		}
+#endif
+	}
+
+	void Device::create_gpu_query_frames()
+	{
+		if (m_gpuScopesPerFrame == 0 && m_gpuQueriesPerFrame == 0)
+		{
+			return;
+		}
+
+		m_timestampPeriod = m_physicalDevice.getProperties().limits.timestampPeriod;
+		for (const auto& queueProps : m_physicalDevice.getQueueFamilyProperties())
+		{
+			m_timestampValidBits.push_back(queueProps.timestampValidBits);
+		}
+
+		// Pools start out needing a reset like the ones begin_frame() resolves.
+		const auto create_query_pool = [&](vk::QueryType queryType, std::uint32_t queryCount, vk::QueryPipelineStatisticFlags statistics) {
+			vk::QueryPoolCreateInfo query_pool_info{};
+			query_pool_info.setQueryType(queryType);
+			query_pool_info.setQueryCount(queryCount);
+			query_pool_info.setPipelineStatistics(statistics);
+			auto queryPool = m_device->createQueryPoolUnique(query_pool_info).value;
+			m_device->resetQueryPool(queryPool.get(), 0, queryCount);
+			return queryPool;
+		};
+		// Results come back in the order of the flag bits, which resolve_gpu_queries() relies on.
+		const vk::QueryPipelineStatisticFlags statistics = vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices | vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations |
+														   vk::QueryPipelineStatisticFlagBits::eClippingInvocations | vk::QueryPipelineStatisticFlagBits::eClippingPrimitives |
+														   vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations | vk::QueryPipelineStatisticFlagBits::eComputeShaderInvocations;
+		m_gpuQueryFrames.resize(m_framesInFlight);
+		for (auto& frame : m_gpuQueryFrames)
+		{
+			if (m_gpuScopesPerFrame > 0)
+			{
+				frame.timestampPool = create_query_pool(vk::QueryType::eTimestamp, m_gpuScopesPerFrame * 2, {});
+			}
+			if (m_gpuQueriesPerFrame > 0)
+			{
+				frame.occlusionPool = create_query_pool(vk::QueryType::eOcclusion, m_gpuQueriesPerFrame, {});
+			}
+			if (m_gpuQueriesPerFrame > 0 && m_pipelineStatisticsSupported)
+			{
+				frame.statisticsPool = create_query_pool(vk::QueryType::ePipelineStatistics, m_gpuQueriesPerFrame, statistics);
+			}
+		}
+	}
+
+	void Device::resolve_gpu_queries(std::uint32_t frameIndex)
+	{
+		if (m_gpuQueryFrames.empty())
+		{
+			return;
+		}
+
+		std::scoped_lock lock(m_gpuQueryMutex);
+		auto& frame = m_gpuQueryFrames[frameIndex];
+		const auto queryCount = std::uint32_t(frame.scopes.size() * 2);
+		m_gpuScopeTimings.scopes.clear();
+		m_gpuScopeTimings.frameNumber = frame.frameNumber;
+		m_gpuScopeTimings.calibrated = m_calibratedTimestampsSupported;
+		if (queryCount > 0)
+		{
+			// The frame's submissions have completed, so this never waits. Queries of command lists that were not submitted
+			// are unavailable (eNotReady), and their scopes skipped.
+			m_gpuScopeResults.resize(std::size_t(queryCount) * 2);
+			const auto result = m_device->getQueryPoolResults(frame.timestampPool.get(), 0, queryCount, m_gpuScopeResults.size() * sizeof(std::uint64_t), m_gpuScopeResults.data(),
+															  sizeof(std::uint64_t) * 2, vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+			if (result != vk::Result::eSuccess && result != vk::Result::eNotReady)
+			{
+				s_errorCallback("GFX - Failed to read back GPU scope timestamps!");
+				m_gpuScopeResults.assign(m_gpuScopeResults.size(), 0);
+			}
+
+			// A device timestamp taken together with a host one maps the device's clock onto the host's.
+			std::uint64_t deviceNow{ 0 };
+			std::uint64_t hostNowNs{ 0 };
+			if (m_calibratedTimestampsSupported)
+			{
+				const std::array<vk::CalibratedTimestampInfoEXT, 2> timestamp_infos{ vk::CalibratedTimestampInfoEXT{ vk::TimeDomainEXT::eDevice }, vk::CalibratedTimestampInfoEXT{ m_hostTimeDomain } };
+				std::array<std::uint64_t, 2> timestamps{};
+				std::uint64_t maxDeviation{ 0 };
+				if (m_device->getCalibratedTimestampsEXT(std::uint32_t(timestamp_infos.size()), timestamp_infos.data(), timestamps.data(), &maxDeviation) == vk::Result::eSuccess)
+				{
+					deviceNow = timestamps[0];
+					hostNowNs = std::uint64_t(double(timestamps[1]) * (1e9 / double(m_hostTicksPerSecond)));
+				}
+				else
+				{
+					m_gpuScopeTimings.calibrated = false;
+				}
+			}
+
+			for (std::size_t i = 0; i < frame.scopes.size(); ++i)
+			{
+				const auto& scope = frame.scopes[i];
+				const auto beginTicks = m_gpuScopeResults[i * 4 + 0];
+				const auto endTicks = m_gpuScopeResults[i * 4 + 2];
+				if (scope.timestampMask == 0 || m_gpuScopeResults[i * 4 + 1] == 0 || m_gpuScopeResults[i * 4 + 3] == 0)
+				{
+					continue;
+				}
+
+				// Differences are taken within the valid bits, so counters that wrapped still give the right duration.
+				const auto durationNs = std::uint64_t(double((endTicks - beginTicks) & scope.timestampMask) * m_timestampPeriod);
+				std::uint64_t beginNs{ 0 };
+				if (m_gpuScopeTimings.calibrated)
+				{
+					beginNs = hostNowNs - std::uint64_t(double((deviceNow - beginTicks) & scope.timestampMask) * m_timestampPeriod);
+				}
+				else
+				{
+					beginNs = std::uint64_t(double(beginTicks & scope.timestampMask) * m_timestampPeriod);
+				}
+				m_gpuScopeTimings.scopes.push_back({ scope.name, scope.depth, beginNs, beginNs + durationNs });
+			}
+#if GFX_TRACY_ENABLED
+			if (m_gpuScopeTimings.calibrated)
+			{
+				emit_tracy_gpu_zones(frame, deviceNow);
+			}
+#endif
+			m_device->resetQueryPool(frame.timestampPool.get(), 0, queryCount);
+		}
+		frame.scopes.clear();
+
+		// Pipeline statistics are written in the order of their flag bits, see create_gpu_query_frames().
+		constexpr std::array<std::uint32_t, 2> QUERY_VALUE_COUNTS{ 1, 6 };
+		m_gpuQueryResults.queries.clear();
+		m_gpuQueryResults.frameNumber = frame.frameNumber;
+		for (std::size_t type = 0; type < QUERY_VALUE_COUNTS.size(); ++type)
+		{
+			const auto count = frame.queryCounts[type];
+			if (count == 0)
+			{
+				continue;
+			}
+
+			auto pool = GpuQueryType(type) == GpuQueryType::eOcclusion ? frame.occlusionPool.get() : frame.statisticsPool.get();
+			const auto stride = QUERY_VALUE_COUNTS[type] + 1;
+			auto& readback = m_gpuQueryReadbacks[type];
+			readback.resize(std::size_t(count) * stride);
+			const auto result = m_device->getQueryPoolResults(pool, 0, count, readback.size() * sizeof(std::uint64_t), readback.data(), sizeof(std::uint64_t) * stride,
+															  vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+			if (result != vk::Result::eSuccess && result != vk::Result::eNotReady)
+			{
+				s_errorCallback("GFX - Failed to read back GPU queries!");
+				readback.assign(readback.size(), 0);
+			}
+			m_device->resetQueryPool(pool, 0, count);
+		}
+		for (const auto& query : frame.queries)
+		{
+			const auto stride = QUERY_VALUE_COUNTS[std::size_t(query.type)] + 1;
+			const auto* values = m_gpuQueryReadbacks[std::size_t(query.type)].data() + std::size_t(query.query) * stride;
+			if (values[stride - 1] == 0)
+			{
+				continue;
+			}
+
+			auto& result = m_gpuQueryResults.queries.emplace_back();
+			result.name = query.name;
+			result.type = query.type;
+			if (query.type == GpuQueryType::eOcclusion)
+			{
+				result.samplesPassed = values[0];
+			}
+			else
+			{
+				result.inputAssemblyVertices = values[0];
+				result.vertexShaderInvocations = values[1];
+				result.clippingInvocations = values[2];
+				result.clippingPrimitives = values[3];
+				result.fragmentShaderInvocations = values[4];
+				result.computeShaderInvocations = values[5];
+			}
+		}
+		frame.queries.clear();
+		frame.queryCounts = {};
+	}
+
+	void Device::get_gpu_scope_timings(GpuScopeTimings& outTimings)
+	{
+		std::scoped_lock lock(m_gpuQueryMutex);
+		outTimings = m_gpuScopeTimings;
+	}
+
+#if GFX_TRACY_ENABLED
+	void Device::emit_tracy_gpu_zones(const GpuQueryFrame& frame, std::uint64_t deviceNow)
+	{
+		if (!m_tracyContext)
+		{
+			m_tracyContext = tracy::GetGpuCtxCounter().fetch_add(1, std::memory_order_relaxed);
+			___tracy_emit_gpu_new_context({ .gpuTime = std::int64_t(deviceNow), .period = m_timestampPeriod, .context = *m_tracyContext, .flags = 0, .type = std::uint8_t(tracy::GpuContextType::Vulkan) });
+			constexpr std::string_view CONTEXT_NAME = "gfx";
+			___tracy_emit_gpu_context_name({ .context = *m_tracyContext, .name = CONTEXT_NAME.data(), .len = std::uint16_t(CONTEXT_NAME.size()) });
+		}
+
+		// Tracy nests zones by the order they begin and end in, so a zone is ended once a scope at its depth or above begins.
+		std::vector<std::uint64_t> openZoneEndTicks{};
+		const auto end_zone = [&] {
+			const auto query = m_tracyQueryId++;
+			___tracy_emit_gpu_zone_end({ .queryId = query, .context = *m_tracyContext });
+			___tracy_emit_gpu_time({ .gpuTime = std::int64_t(openZoneEndTicks.back()), .queryId = query, .context = *m_tracyContext });
+			openZoneEndTicks.pop_back();
+		};
+		for (std::size_t i = 0; i < frame.scopes.size(); ++i)
+		{
+			const auto& scope = frame.scopes[i];
+			if (scope.timestampMask == 0 || m_gpuScopeResults[i * 4 + 1] == 0 || m_gpuScopeResults[i * 4 + 3] == 0)
+			{
+				continue;
+			}
+			while (openZoneEndTicks.size() > scope.depth)
+			{
+				end_zone();
+			}
+
+			const auto sourceLocation = tracy::Profiler::AllocSourceLocation(__LINE__, __FILE__, std::strlen(__FILE__), __func__, std::strlen(__func__), scope.name.data(), scope.name.size());
+			const auto query = m_tracyQueryId++;
+			___tracy_emit_gpu_zone_begin_alloc({ .srcloc = sourceLocation, .queryId = query, .context = *m_tracyContext });
+			___tracy_emit_gpu_time({ .gpuTime = std::int64_t(m_gpuScopeResults[i * 4 + 0]), .queryId = query, .context = *m_tracyContext });
+			openZoneEndTicks.push_back(m_gpuScopeResults[i * 4 + 2]);
+		}
+		while (!openZoneEndTicks.empty())
+		{
+			end_zone();
+		}
+	}
+#endif
+
+	void Device::get_gpu_query_results(GpuQueryResults& outResults)
+	{
+		std::scoped_lock lock(m_gpuQueryMutex);
+		outResults = m_gpuQueryResults;
+	}
+
+	static constexpr std::array s_frameStatCounters{
+		&FrameStats::draws,
+		&FrameStats::dispatches,
+		&FrameStats::pipelineBinds,
+		&FrameStats::descriptorBinds,
+		&FrameStats::barriers,
+		&FrameStats::submits,
+		&FrameStats::descriptorWrites,
+		&FrameStats::uploadBytes,
+		&FrameStats::resourcesCreated,
+	};
+
+	void Device::get_frame_stats(FrameStats& outStats)
+	{
+		std::scoped_lock lock(m_frameStatsMutex);
+		outStats = m_frameStats;
+	}
+
+	void Device::add_frame_stats(FrameStats& stats)
+	{
+#if GFX_FRAME_STATS_ENABLED
+		for (const auto counter : s_frameStatCounters)
+		{
+			if (stats.*counter != 0)
+			{
+				GFX_COUNT_SHARED_STAT(m_currentFrameStats.*counter, stats.*counter);
+			}
+		}
+		stats = {};
+#else
+		GFX_UNUSED(stats);
+#endif
+	}
+
+	void Device::begin_gpu_query(CommandList& commandList, GpuQueryType type, std::string_view name)
+	{
+		auto& activeQuery = commandList.get_active_query(type);
+		if (activeQuery)
+		{
+			s_errorCallback("GFX - begin_gpu_query() - A query of this type is already open on the CommandList!");
+			return;
+		}
+
+		CommandList::GpuScopeQuery query{};
+		if (!m_gpuQueryFrames.empty())
+		{
+			std::scoped_lock lock(m_gpuQueryMutex);
+			auto& frame = m_gpuQueryFrames[get_frame_index()];
+			auto pool = type == GpuQueryType::eOcclusion ? frame.occlusionPool.get() : frame.statisticsPool.get();
+			auto& count = frame.queryCounts[std::size_t(type)];
+			if (pool && count < m_gpuQueriesPerFrame)
+			{
+				frame.queries.push_back({ std::string(name), type, count });
+				query = { pool, count++ };
+			}
+		}
+
+		if (query.queryPool)
+		{
+			vk::QueryControlFlags control_flags{};
+			if (type == GpuQueryType::eOcclusion && m_occlusionQueryPreciseSupported)
+			{
+				control_flags |= vk::QueryControlFlagBits::ePrecise;
+			}
+			commandList.begin_query(query.queryPool, query.beginQuery, control_flags);
+		}
+		activeQuery = query;
+	}
+
+	void Device::end_gpu_query(CommandList& commandList, GpuQueryType type)
+	{
+		auto& activeQuery = commandList.get_active_query(type);
+		if (!activeQuery)
+		{
+			s_errorCallback("GFX - end_gpu_query() - No query of this type is open on the CommandList!");
+			return;
+		}
+		if (activeQuery->queryPool)
+		{
+			commandList.end_query(activeQuery->queryPool, activeQuery->beginQuery);
+		}
+		activeQuery.reset();
+	}
+
+	void Device::begin_gpu_scope(CommandList& commandList, std::string_view name)
+	{
+		CommandList::GpuScopeQuery scopeQuery{};
+		const auto validBits = m_gpuQueryFrames.empty() ? 0u : m_timestampValidBits[commandList.get_queue_family()];
+		if (validBits > 0)
+		{
+			std::scoped_lock lock(m_gpuQueryMutex);
+			auto& frame = m_gpuQueryFrames[get_frame_index()];
+			if (frame.scopes.size() < m_gpuScopesPerFrame)
+			{
+				const auto timestampMask = validBits >= 64 ? UINT64_MAX : (std::uint64_t(1) << validBits) - 1;
+				frame.scopes.push_back({ std::string(name), commandList.get_gpu_scope_depth(), timestampMask });
+				scopeQuery = { frame.timestampPool.get(), std::uint32_t(frame.scopes.size() - 1) * 2 };
+			}
+		}
+
+		if (scopeQuery.queryPool)
+		{
+			commandList.write_timestamp(scopeQuery.queryPool, scopeQuery.beginQuery, vk::PipelineStageFlagBits2::eTopOfPipe);
+		}
+		commandList.push_gpu_scope(scopeQuery);
+	}
+
+	void Device::end_gpu_scope(CommandList& commandList)
+	{
+		CommandList::GpuScopeQuery scopeQuery{};
+		if (!commandList.pop_gpu_scope(scopeQuery))
+		{
+			s_errorCallback("GFX - end_gpu_scope() - No GPU scope is open on the CommandList!");
+			return;
+		}
+		if (scopeQuery.queryPool)
+		{
+			commandList.write_timestamp(scopeQuery.queryPool, scopeQuery.beginQuery + 1, vk::PipelineStageFlagBits2::eBottomOfPipe);
+		}
+	}
+
+	auto Device::allocate_transient(std::uint64_t size, std::uint64_t alignment) -> TransientAllocation
+	{
+		if (m_transientBufferPtr == nullptr)
+		{
+			s_errorCallback("GFX - allocate_transient() - DeviceInfo::transientBufferSize was not set!");
+			return {};
+		}
+		if (alignment == 0)
+		{
+			alignment = m_minUniformBufferOffsetAlignment;
+		}
+
+		// Aligned relative to the buffer, so each frame's part does not need to start aligned.
+		const auto frameOffset = get_frame_index() * m_transientFrameSize;
+		auto head = m_transientHead.load(std::memory_order_relaxed);
+		std::uint64_t offset{ 0 };
+		do
+		{
+			offset = (frameOffset + head + alignment - 1) / alignment * alignment;
+			if (offset + size > frameOffset + m_transientFrameSize)
+			{
+				s_errorCallback("GFX - allocate_transient() - Out of transient memory for this frame!");
+				return {};
+			}
+		} while (!m_transientHead.compare_exchange_weak(head, offset + size - frameOffset, std::memory_order_relaxed));
+
+		return TransientAllocation{ m_transientBufferPtr + offset, m_transientBufferHandle, offset };
+	}
+
+	void Device::end_frame()
+	{
+		m_frameSubmitValues[get_frame_index()] = get_submit_values();
+		m_frameEnded = true;
+
+		process_deferred_destruction();
+	}
+
+	void Device::reset_frame_command_pools(std::uint32_t frameIndex)
+	{
+		std::vector<CommandListHandle> transientCommandLists{};
+		{
+			std::lock_guard lock(m_commandPoolMutex);
+			std::swap(transientCommandLists, m_frameTransientCommandLists[frameIndex]);
+
+			for (auto& [key, commandPool] : m_commandPools)
+			{
+				if (key.transient && key.frameIndex == frameIndex)
+				{
+					commandPool->reset();
+				}
+			}
+		}
+
+		// The GPU is done with them, so there is no need to go through deferred destruction.
+		for (auto commandListHandle : transientCommandLists)
+		{
+			m_commandListPool.erase(commandListHandle.resourceHandle);
+		}
+	}
+
+	void Device::reset_frame_descriptor_sets(std::uint32_t frameIndex)
+	{
+		std::vector<DescriptorSetHandle> transientDescriptorSets{};
+		{
+			std::lock_guard lock(m_descriptorPoolMutex);
+			std::swap(transientDescriptorSets, m_frameTransientDescriptorSets[frameIndex]);
+			if (transientDescriptorSets.empty())
+			{
+				return;
+			}
+			if (m_descriptorBuffer)
+			{
+				m_descriptorBuffer->reset_frame(frameIndex);
+			}
+			else
+			{
+				m_frameDescriptorAllocators[frameIndex]->reset();
+			}
+		}
+
+		for (auto descriptorSetHandle : transientDescriptorSets)
+		{
+			if (const auto* descriptorSet = m_descriptorSetPool.get_checked(descriptorSetHandle.resourceHandle); descriptorSet != nullptr)
+			{
+				invalidate_bundles(get_resource_key(descriptorSet->set));
+			}
+			m_descriptorSetPool.erase(descriptorSetHandle.resourceHandle);
+		}
+		// Their bindings would otherwise be rebound into sets that no longer exist.
+		std::lock_guard lock(m_descriptorBindingMutex);
+		std::erase_if(m_descriptorBindings, [&](const auto& pair) {
+			return std::find(transientDescriptorSets.begin(), transientDescriptorSets.end(), pair.second.descriptorSetHandle) != transientDescriptorSets.end();
+		});
+	}
+
+	void Device::process_deferred_destruction()
+	{
+		// Destroy outside the lock, destroying a resource may queue further destroys (eg. swap chain images).
+		std::vector<std::function<void()>> readyDestroys{};
+		{
+			std::lock_guard lock(m_deferredDestroyMutex);
+			if (m_deferredDestroyQueue.empty())
+			{
+				return;
+			}
+
+			// Queued in submission order, so stop at the first entry that is still in flight.
+			while (!m_deferredDestroyQueue.empty() && are_submit_values_complete(m_deferredDestroyQueue.front().submitValues))
+			{
+				readyDestroys.push_back(std::move(m_deferredDestroyQueue.front().destroyFunc));
+				m_deferredDestroyQueue.pop_front();
+			}
+		}
+		for (auto& destroyFunc : readyDestroys)
+		{
+			destroyFunc();
+		}
+	}
+
+	void Device::destroy_semaphore(SemaphoreHandle semaphoreHandle)
+	{
+		// A pending submission may still wait on or signal it.
+		defer_destroy([this, resourceHandle = semaphoreHandle.resourceHandle] {
+			auto* pooledSemaphore = m_semaphorePool.get_checked(resourceHandle);
+			if (pooledSemaphore != nullptr && !pooledSemaphore->signalPending.load(std::memory_order_relaxed))
+			{
+				std::lock_guard lock(m_freeSemaphoreMutex);
+				m_freeSemaphores.push_back(std::move(pooledSemaphore->semaphore));
+			}
+			m_semaphorePool.erase(resourceHandle);
+		});
+	}
+
+	bool Device::get_wait_semaphore(vk::Semaphore& outSemaphore, SemaphoreHandle semaphoreHandle)
+	{
+		auto* pooledSemaphore = m_semaphorePool.get_checked(semaphoreHandle.resourceHandle);
+		if (pooledSemaphore == nullptr)
+		{
+			outSemaphore = nullptr;
+			return false;
+		}
+
+		pooledSemaphore->signalPending.store(false, std::memory_order_relaxed);
+		outSemaphore = pooledSemaphore->semaphore.get();
+		return true;
+	}
+
+	auto Device::create_command_list(CommandListHandle& outCommandListHandle, std::uint32_t queueIndex, std::uint32_t flags, vk::CommandBufferLevel level) -> bool
+	{
+		if ((flags & CommandListFlags_Deferred) && level == vk::CommandBufferLevel::eSecondary)
+		{
+			s_errorCallback("GFX - Secondary command lists cannot be deferred!");
+			return false;
+		}
+
+		auto queueFamily = m_queueFamilies.at(queueIndex);
+		auto& commandPool = get_thread_command_pool(queueFamily, false);
+		auto queue = m_queues.at(queueIndex);
+
+		outCommandListHandle = CommandListHandle(m_deviceHandle, m_commandListPool.emplace(commandPool, queue, level, flags));
+		if (CAST_HANDLE_TO_INT(outCommandListHandle.resourceHandle) == 0)
+		{
+			return false;
+		}
+		return true;
+	}
+
+	auto Device::create_transient_command_list(CommandListHandle& outCommandListHandle, std::uint32_t queueIndex, vk::CommandBufferLevel level) -> bool
+	{
+		auto queueFamily = m_queueFamilies.at(queueIndex);
+		auto queue = m_queues.at(queueIndex);
+
+		// Handed out under the lock, as begin_frame() resets the transient pools of every thread from its own.
+		std::lock_guard lock(m_commandPoolMutex);
+		const auto frameIndex = get_frame_index();
+		auto& commandPool = get_thread_command_pool_locked(queueFamily, frameIndex, true);
+		outCommandListHandle = CommandListHandle(m_deviceHandle, m_commandListPool.emplace(commandPool, queue, level, commandPool.acquire_transient(level)));
+		if (CAST_HANDLE_TO_INT(outCommandListHandle.resourceHandle) == 0)
+		{
+			return false;
+		}
+		m_frameTransientCommandLists[frameIndex].push_back(outCommandListHandle);
+		return true;
+	}
+
+	void Device::translate_command_list(CommandList& commandList)
+	{
+		// Released once the submissions so far have completed, which covers any still executing the last translation.
+		const auto lastTranslation = commandList.take_command_buffer();
+		if (lastTranslation.second)
+		{
+			defer_destroy([lastTranslation] { lastTranslation.first->release(lastTranslation.second); });
+		}
+		run_task([this, &commandList] {
+			commandList.translate(get_thread_command_pool(commandList.get_queue_family(), false));
+			add_frame_stats(commandList.get_frame_stats());
+		});
+	}
+
+	auto Device::get_task_scheduler() -> TaskScheduler&
+	{
+		if (m_deviceInfo.taskScheduler != nullptr)
+		{
+			return *m_deviceInfo.taskScheduler;
+		}
+		std::call_once(m_workerPoolOnce, [this] {
+			const auto threadCount = m_deviceInfo.workerThreadCount != 0 ? m_deviceInfo.workerThreadCount : std::max(std::thread::hardware_concurrency() / 2u, 1u);
+			m_workerPool = std::make_unique<WorkerPool>(threadCount);
+		});
+		return *m_workerPool;
+	}
+
+	void Device::run_task(std::function<void()>&& task)
+	{
+		{
+			std::lock_guard lock(m_pendingTasksMutex);
+			++m_pendingTasks;
+		}
+		get_task_scheduler().enqueue([this, task = std::move(task)] {
+			task();
+			// Notified under the lock, so ~Device() cannot finish before this task stops touching the device.
+			std::lock_guard lock(m_pendingTasksMutex);
+			if (--m_pendingTasks == 0)
+			{
+				m_pendingTasksCondition.notify_all();
+			}
+		});
+	}
+
+	void Device::destroy_command_list(CommandListHandle commandListHandle)
+	{
+		defer_destroy([this, resourceHandle = commandListHandle.resourceHandle] { m_commandListPool.erase(resourceHandle); });
+	}
+
+	bool Device::get_command_list(CommandList*& outCommandList, CommandListHandle commandListHandle)
+	{
+		outCommandList = m_commandListPool.get_checked(commandListHandle.resourceHandle);
+		return outCommandList != nullptr;
+	}
+
+	auto Device::create_bundle(BundleHandle& outBundleHandle, std::uint32_t queueIndex) -> bool
+	{
+		if (queueIndex >= m_queues.size())
+		{
+			s_errorCallback("GFX - Cannot create bundle for unknown queue!");
+			return false;
+		}
+
+		outBundleHandle = BundleHandle(m_deviceHandle, m_bundlePool.emplace(queueIndex));
+		if (CAST_HANDLE_TO_INT(outBundleHandle.resourceHandle) == 0)
+		{
+			return false;
+		}
+
+		std::lock_guard lock(m_bundleMutex);
+		m_bundles.push_back(outBundleHandle);
+		return true;
+	}
+
+	void Device::destroy_bundle(BundleHandle bundleHandle)
+	{
+		auto* bundle = m_bundlePool.get_checked(bundleHandle.resourceHandle);
+		if (bundle == nullptr)
+		{
+			return;
+		}
+
+		{
+			std::lock_guard lock(m_bundleMutex);
+			std::erase(m_bundles, bundleHandle);
+			if (bundle->get_command_list() != 0)
+			{
+				destroy_command_list(bundle->get_command_list());
+			}
+		}
+
+		defer_destroy([this, resourceHandle = bundleHandle.resourceHandle] { m_bundlePool.erase(resourceHandle); });
+	}
+
+	bool Device::get_bundle(Bundle*& outBundle, BundleHandle bundleHandle)
+	{
+		outBundle = m_bundlePool.get_checked(bundleHandle.resourceHandle);
+		return outBundle != nullptr;
+	}
+
+	bool Device::begin_bundle(CommandList*& outCommandList, BundleHandle bundleHandle)
+	{
+		Bundle* bundle{ nullptr };
+		if (!get_bundle(bundle, bundleHandle))
+		{
+			s_errorCallback("GFX - Cannot begin unknown bundle!");
+			return false;
+		}
+
+		// Submissions may still be executing the previous recording, so it is retired rather than reset.
+		CommandListHandle commandListHandle{};
+		if (!create_command_list(commandListHandle, bundle->get_queue_index(), CommandListFlags_SimultaneousUse | CommandListFlags_TrackResources, vk::CommandBufferLevel::eSecondary))
+		{
+			return false;
+		}
+
+		{
+			std::lock_guard lock(m_bundleMutex);
+			if (bundle->get_command_list() != 0)
+			{
+				destroy_command_list(bundle->get_command_list());
+			}
+			bundle->set_command_list(commandListHandle);
+			// Only executable once end_bundle() sees the recording end.
+			bundle->set_valid(false);
+			bundle->set_recording(true);
+		}
+
+		return get_command_list(outCommandList, commandListHandle);
+	}
+
+	void Device::end_bundle(BundleHandle bundleHandle, const CommandList& commandList, bool ended)
+	{
+		std::lock_guard lock(m_bundleMutex);
+		auto* bundle = m_bundlePool.get_checked(bundleHandle.resourceHandle);
+		CommandList* bundleCommandList{ nullptr };
+		if (bundle == nullptr || !get_command_list(bundleCommandList, bundle->get_command_list()) || bundleCommandList != &commandList)
+		{
+			// Re-recorded or destroyed since, the newer recording decides.
+			return;
+		}
+		bundle->set_valid(ended && bundle->is_recording());
+		bundle->set_recording(false);
+	}
+
+	bool Device::get_bundle_command_list(CommandList*& outCommandList, BundleHandle bundleHandle)
+	{
+		std::lock_guard lock(m_bundleMutex);
+		auto* bundle = m_bundlePool.get_checked(bundleHandle.resourceHandle);
+		if (bundle == nullptr)
+		{
+			return false;
+		}
+		if (!bundle->is_valid())
+		{
+			s_errorCallback("GFX - Bundle is not valid, it must be (re-)recorded with begin_bundle()!");
+			return false;
+		}
+		return get_command_list(outCommandList, bundle->get_command_list());
+	}
+
+	bool Device::create_or_get_descriptor_set_layout(vk::DescriptorSetLayout& outDescriptorSetLayout, const DescriptorSetInfo& descriptorSetInfo)
+	{
+		if (descriptorSetInfo.bindlessHeap)
+		{
+			if (!m_bindlessHeap)
+			{
+				s_errorCallback("GFX - The device has no bindless heap!");
+				return false;
+			}
+			outDescriptorSetLayout = m_bindlessHeap->get_layout();
+			return true;
+		}
+
+		const auto isDynamic = [](const DescriptorBindingInfo& binding) { return binding.type == DescriptorType::eUniformBufferDynamic || binding.type == DescriptorType::eStorageBufferDynamic; };
+		if (m_descriptorBuffer && std::ranges::any_of(descriptorSetInfo.bindings, isDynamic))
+		{
+			s_errorCallback("GFX - Dynamic descriptor types are not available with descriptor buffers!");
+			return false;
+		}
+		for (const auto& binding : descriptorSetInfo.bindings)
+		{
+			if (binding.type == DescriptorType::eInlineUniformBlock &&
+				(binding.count == 0 || binding.count % 4 != 0 || binding.count > m_properties.maxInlineUniformBlockSize || descriptorSetInfo.push))
+			{
+				s_errorCallback("GFX - Inline uniform blocks must be a multiple of 4 bytes up to maxInlineUniformBlockSize, outside push sets!");
+				return false;
+			}
+		}
+		if (descriptorSetInfo.push)
+		{
+			if (!m_pushDescriptorSupported)
+			{
+				s_errorCallback("GFX - Push descriptors are not supported by this device!");
+				return false;
+			}
+			if (std::ranges::any_of(descriptorSetInfo.bindings, isDynamic))
+			{
+				s_errorCallback("GFX - Push descriptor sets cannot have dynamic descriptor types!");
+				return false;
+			}
+			std::uint32_t descriptorCount{ 0 };
+			for (const auto& binding : descriptorSetInfo.bindings)
+			{
+				descriptorCount += binding.count;
+			}
+			if (descriptorCount > MAX_PUSH_DESCRIPTORS)
+			{
+				s_errorCallback("GFX - Push descriptor sets cannot hold more than MAX_PUSH_DESCRIPTORS descriptors!");
+				return false;
+			}
+		}
+
+		const auto hash = std::hash<DescriptorSetInfo>{}(descriptorSetInfo);
+
+		std::lock_guard lock(m_descriptorSetLayoutMutex);
+		const auto [first, last] = m_descriptorSetLayoutCache.equal_range(hash);
+		const auto cached = std::find_if(first, last, [&](const auto& pair) { return pair.second.descriptorSetInfo == descriptorSetInfo; });
+		if (cached != last)
+		{
+			outDescriptorSetLayout = cached->second.descriptorSetLayout.get();
+			return true;
+		}
+
+		const ScratchScope scratchScope{};
+		ScratchVector<vk::DescriptorSetLayoutBinding> vk_bindings(descriptorSetInfo.bindings.size());
+		for (auto i = 0; i < vk_bindings.size(); ++i)
+		{
+			vk_bindings[i] = get_descriptor_set_layout_binding(descriptorSetInfo.bindings.at(i));
+			vk_bindings[i].setBinding(i);
+		}
+
+		vk::DescriptorSetLayoutCreateInfo set_layout_info{};
+		set_layout_info.setBindings(vk_bindings);
+		vk::DescriptorSetLayoutCreateFlags set_layout_flags{};
+		if (m_descriptorBuffer)
+		{
+			set_layout_flags |= vk::DescriptorSetLayoutCreateFlagBits::eDescriptorBufferEXT;
+		}
+		if (descriptorSetInfo.push)
+		{
+			set_layout_flags |= vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR;
+		}
+		set_layout_info.setFlags(set_layout_flags);
+		auto descriptorSetLayout = m_device->createDescriptorSetLayoutUnique(set_layout_info).value;
+		if (descriptorSetInfo.push)
+		{
+			m_pushDescriptorSetLayouts.insert(get_resource_key(descriptorSetLayout.get()));
+		}
+
+		auto& bindingTypes = m_descriptorSetLayoutBindingTypes[get_resource_key(descriptorSetLayout.get())];
+		auto& bindingCounts = m_descriptorSetLayoutBindingCounts[get_resource_key(descriptorSetLayout.get())];
+		for (const auto& vk_binding : vk_bindings)
+		{
+			bindingTypes.push_back(vk_binding.descriptorType);
+			bindingCounts.push_back(vk_binding.descriptorCount);
+		}
+		outDescriptorSetLayout = descriptorSetLayout.get();
+		m_descriptorSetLayoutCache.emplace(hash, CachedDescriptorSetLayout{ descriptorSetInfo, std::move(descriptorSetLayout) });
+		return true;
+	}
+
+	auto Device::create_or_get_pipeline_layout(const std::vector<vk::DescriptorSetLayout>& setLayouts, vk::PushConstantRange constantRange) -> vk::PipelineLayout
+	{
+		const bool hasConstants = constantRange.size > 0 && constantRange.stageFlags != vk::ShaderStageFlags();
+		if (!hasConstants)
+		{
+			constantRange = vk::PushConstantRange{};
+		}
+
+		std::size_t hash{};
+		for (const auto setLayout : setLayouts)
+		{
+			sm::hash_combine(hash, get_resource_key(setLayout));
+		}
+		sm::hash_combine(hash, static_cast<VkShaderStageFlags>(constantRange.stageFlags));
+		sm::hash_combine(hash, constantRange.size);
+
+		std::lock_guard lock(m_pipelineLayoutMutex);
+		const auto [first, last] = m_pipelineLayoutCache.equal_range(hash);
+		const auto cached = std::find_if(first, last, [&](const auto& pair) { return pair.second.setLayouts == setLayouts && pair.second.constantRange == constantRange; });
+		if (cached != last)
+		{
+			return cached->second.pipelineLayout.get();
+		}
+
+		vk::PipelineLayoutCreateInfo pipeline_layout_info{};
+		pipeline_layout_info.setSetLayouts(setLayouts);
+		if (hasConstants)
+		{
+			pipeline_layout_info.setPushConstantRanges(constantRange);
+		}
+		auto pipelineLayout = m_device->createPipelineLayoutUnique(pipeline_layout_info).value;
+		const auto handle = pipelineLayout.get();
+		m_pipelineLayoutCache.emplace(hash, CachedPipelineLayout{ setLayouts, constantRange, std::move(pipelineLayout) });
+		return handle;
+	}
+
+	auto Device::create_or_get_shader_module(const ShaderCode& code) -> vk::ShaderModule
+	{
+		const auto hash = code.get_content_hash();
+
+		std::lock_guard lock(m_shaderModuleMutex);
+		const auto cached = m_shaderModuleCache.find(hash);
+		if (cached != m_shaderModuleCache.end())
+		{
+			return cached->second.get();
+		}
+
+		vk::ShaderModuleCreateInfo module_info{};
+		module_info.setCodeSize(code.size() * sizeof(std::uint32_t));
+		module_info.setPCode(code.data());
+		auto shaderModule = m_device->createShaderModuleUnique(module_info).value;
+		const auto handle = shaderModule.get();
+		m_shaderModuleCache.emplace(hash, std::move(shaderModule));
+		return handle;
+	}
+
+	auto Device::create_or_get_pipeline_library(vk::GraphicsPipelineLibraryFlagBitsEXT part, const GraphicsPipelineInfo& graphicsPipelineInfo, vk::ShaderModule vertexModule,
+												vk::ShaderModule fragmentModule, const std::vector<vk::DescriptorSetLayout>& setLayouts, vk::PipelineLayout pipelineLayout) -> vk::Pipeline
+	{
+		// Only what the part is compiled from, so pipelines differing elsewhere share it. Both shader parts are compiled
+		// against the (shared) layout of the whole pipeline.
+		GraphicsPipelineInfo partInfo{};
+		switch (part)
+		{
+			case vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface:
+				partInfo.vertexInputBindings = graphicsPipelineInfo.vertexInputBindings;
+				partInfo.topology = graphicsPipelineInfo.topology;
+				partInfo.dynamicStates = graphicsPipelineInfo.dynamicStates & DynamicStateFlags_Topology;
+				break;
+			case vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders:
+				partInfo.vertexCode = graphicsPipelineInfo.vertexCode.to_owned();
+				partInfo.vertexSpecializationConstants = graphicsPipelineInfo.vertexSpecializationConstants;
+				partInfo.descriptorSets = graphicsPipelineInfo.descriptorSets;
+				partInfo.constantBlock = graphicsPipelineInfo.constantBlock;
+				partInfo.cullMode = graphicsPipelineInfo.cullMode;
+				partInfo.frontFace = graphicsPipelineInfo.frontFace;
+				partInfo.viewMask = graphicsPipelineInfo.viewMask;
+				partInfo.dynamicStates = graphicsPipelineInfo.dynamicStates & (DynamicStateFlags_CullMode | DynamicStateFlags_FrontFace | DynamicStateFlags_ShadingRate);
+				break;
+			case vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader:
+				partInfo.fragmentCode = graphicsPipelineInfo.fragmentCode.to_owned();
+				partInfo.fragmentSpecializationConstants = graphicsPipelineInfo.fragmentSpecializationConstants;
+				partInfo.descriptorSets = graphicsPipelineInfo.descriptorSets;
+				partInfo.constantBlock = graphicsPipelineInfo.constantBlock;
+				partInfo.depthTest = graphicsPipelineInfo.depthTest;
+				partInfo.depthWrite = graphicsPipelineInfo.depthWrite;
+				partInfo.depthCompareOp = graphicsPipelineInfo.depthCompareOp;
+				partInfo.stencilTest = graphicsPipelineInfo.stencilTest;
+				partInfo.stencilFront = graphicsPipelineInfo.stencilFront;
+				partInfo.stencilBack = graphicsPipelineInfo.stencilBack;
+				partInfo.sampleCount = graphicsPipelineInfo.sampleCount;
+				partInfo.viewMask = graphicsPipelineInfo.viewMask;
+				partInfo.dynamicStates = graphicsPipelineInfo.dynamicStates & (DynamicStateFlags_Depth | DynamicStateFlags_Stencil | DynamicStateFlags_ShadingRate);
+				break;
+			case vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentOutputInterface:
+				partInfo.colorAttachments = graphicsPipelineInfo.colorAttachments;
+				partInfo.colorBlendStates = graphicsPipelineInfo.colorBlendStates;
+				partInfo.depthAttachmentFormat = graphicsPipelineInfo.depthAttachmentFormat;
+				partInfo.depthTest = graphicsPipelineInfo.depthTest;
+				partInfo.stencilTest = graphicsPipelineInfo.stencilTest;
+				partInfo.sampleCount = graphicsPipelineInfo.sampleCount;
+				partInfo.viewMask = graphicsPipelineInfo.viewMask;
+				partInfo.dynamicStates = graphicsPipelineInfo.dynamicStates & DynamicStateFlags_Blend;
+				break;
+		}
+
+		auto hash = std::hash<GraphicsPipelineInfo>{}(partInfo);
+		sm::hash_combine(hash, static_cast<VkGraphicsPipelineLibraryFlagsEXT>(vk::GraphicsPipelineLibraryFlagsEXT(part)));
+
+		std::lock_guard lock(m_pipelineLibraryMutex);
+		const auto [first, last] = m_pipelineLibraryCache.equal_range(hash);
+		const auto cached = std::find_if(first, last, [&](const auto& pair) { return pair.second.part == part && pair.second.partInfo == partInfo; });
+		if (cached != last)
+		{
+			return cached->second.library->get_pipeline();
+		}
+
+		auto library = std::make_unique<GraphicsPipeline>(m_device.get(), partInfo, vertexModule, fragmentModule, setLayouts, pipelineLayout, m_pipelineCache.get(), get_graphics_pipeline_create_flags(), part);
+		const auto handle = library->get_pipeline();
+		m_pipelineLibraryCache.emplace(hash, CachedPipelineLibrary{ part, std::move(partInfo), std::move(library) });
+		return handle;
+	}
+
+	auto Device::submit_command_list(const SubmitInfo& submitInfo, SemaphoreHandle* outSemaphoreHandle) -> SyncPoint
+	{
+		auto* command_list = m_commandListPool.get_checked(submitInfo.commandList.resourceHandle);
+		if (command_list == nullptr)
+		{
+			return {};
+		}
+
+		const SemaphoreWait semaphoreWait{ submitInfo.waitSemaphoreHandle, submitInfo.waitStages };
+		SubmitBatch batch{
+			.commandLists = std::span(&submitInfo.commandList, 1),
+			.waitSyncPoints = std::span(&submitInfo.waitSyncPoint, 1),
+			.waitSyncPointStages = submitInfo.waitStages,
+			.outSignalSemaphoreHandle = outSemaphoreHandle,
+			.swapChainHandle = submitInfo.swapChainHandle,
+			.deviceMask = submitInfo.deviceMask,
+		};
+		if (submitInfo.waitSemaphoreHandle != 0)
+		{
+			batch.waitSemaphores = std::span(&semaphoreWait, 1);
+		}
+		return submit_command_lists(get_queue_index(command_list->get_queue()), std::span(&batch, 1));
+	}
+
+	auto Device::submit_command_lists(std::uint32_t queueIndex, std::span<const SubmitBatch> batches) -> SyncPoint
+	{
+		GFX_PROFILE_ZONE("gfx::Device::submit_command_lists");
+		if (queueIndex >= m_queues.size())
+		{
+			s_errorCallback("GFX - Invalid queue index!");
+			return {};
+		}
+		if (batches.empty())
+		{
+			return {};
+		}
+		if (is_device_lost())
+		{
+			s_errorCallback("GFX - Cannot submit to a lost device!");
+			return {};
+		}
+
+		auto pendingSubmit = prepare_submit(queueIndex, batches);
+		if (pendingSubmit == nullptr)
+		{
+			return {};
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.submits, 1);
+
+		process_deferred_destruction();
+
+		auto& queueTimeline = m_queueTimelines[queueIndex];
+		SyncPoint syncPoint{ m_deviceHandle, queueIndex, 0 };
+
+		if (m_submissionThread != nullptr)
+		{
+			std::lock_guard lock(*queueTimeline.submitMutex);
+			syncPoint.value = queueTimeline.submitValue.load() + 1;
+
+			// Published up front so deferred destruction covers the queued work. If the submit fails the device is lost.
+			queueTimeline.submitValue.store(syncPoint.value);
+			set_readback_sync_points(pendingSubmit->commandLists, syncPoint);
+
+			m_submissionThread->enqueue([this, pendingSubmit, submitValue = syncPoint.value] {
+				for (auto* commandList : pendingSubmit->commandLists)
+				{
+					commandList->wait_for_translation();
+				}
+
+				auto& queueTimeline = m_queueTimelines[pendingSubmit->queueIndex];
+				{
+					// Signalling the value from the host instead would retire work still in flight on earlier values.
+					std::lock_guard lock(*queueTimeline.submitMutex);
+					if (!is_device_lost() && !execute_submit(*pendingSubmit, submitValue))
+					{
+						s_errorCallback("GFX - Failed to submit command lists!");
+						mark_device_lost();
+					}
+				}
+
+				for (const auto commandListHandle : pendingSubmit->fireAndForgetCommandLists)
+				{
+					destroy_command_list(commandListHandle);
+				}
+			});
+			return syncPoint;
+		}
+
+		for (auto* commandList : pendingSubmit->commandLists)
+		{
+			commandList->wait_for_translation();
+		}
+
+		{
+			std::lock_guard lock(*queueTimeline.submitMutex);
+			syncPoint.value = queueTimeline.submitValue.load() + 1;
+			if (!execute_submit(*pendingSubmit, syncPoint.value))
+			{
+				return {};
+			}
+
+			// Only published once submitted, so a snapshot never waits on a value that will not be signalled.
+			queueTimeline.submitValue.store(syncPoint.value);
+		}
+		set_readback_sync_points(pendingSubmit->commandLists, syncPoint);
+
+		// Tagged with this submission's timeline value, so they are freed once the GPU is done without the CPU waiting.
+		for (const auto commandListHandle : pendingSubmit->fireAndForgetCommandLists)
+		{
+			destroy_command_list(commandListHandle);
+		}
+
+		return syncPoint;
+	}
+
+	auto Device::prepare_submit(std::uint32_t queueIndex, std::span<const SubmitBatch> batches) -> std::shared_ptr<PendingSubmit>
+	{
+		auto queue = m_queues[queueIndex];
+
+		std::size_t commandListCount{ 0 };
+		std::size_t waitSemaphoreCount{ 0 };
+		for (const auto& batch : batches)
+		{
+			for (const auto commandListHandle : batch.commandLists)
+			{
+				auto* command_list = m_commandListPool.get_checked(commandListHandle.resourceHandle);
+				if (command_list == nullptr)
+				{
+					s_errorCallback("GFX - Invalid command list in submit batch!");
+					return nullptr;
+				}
+				if (command_list->is_secondary())
+				{
+					s_errorCallback("GFX - Secondary command lists cannot be submitted, use execute_commands() instead!");
+					return nullptr;
+				}
+				if (command_list->get_queue() != queue)
+				{
+					s_errorCallback("GFX - Command list was not created for the queue it is submitted to!");
+					return nullptr;
+				}
+			}
+			for (const auto& semaphoreWait : batch.waitSemaphores)
+			{
+				if (m_semaphorePool.get_checked(semaphoreWait.semaphoreHandle.resourceHandle) == nullptr)
+				{
+					s_errorCallback("GFX - Invalid wait semaphore in submit batch!");
+					return nullptr;
+				}
+			}
+			for (const auto& syncPoint : batch.waitSyncPoints)
+			{
+				if (syncPoint.value != 0 && (syncPoint.deviceHandle != m_deviceHandle || syncPoint.queueIndex >= m_queueTimelines.size()))
+				{
+					s_errorCallback("GFX - Invalid wait sync point in submit batch!");
+					return nullptr;
+				}
+			}
+			SwapChain* swapChain{ nullptr };
+			if (batch.swapChainHandle != 0 && !get_swap_chain(swapChain, batch.swapChainHandle))
+			{
+				s_errorCallback("GFX - Invalid swap chain in submit batch!");
+				return nullptr;
+			}
+			if ((batch.deviceMask & ~get_device_group_mask()) != 0)
+			{
+				s_errorCallback("GFX - Submit batch device mask has GPUs outside of the device group!");
+				return nullptr;
+			}
+			commandListCount += batch.commandLists.size();
+			waitSemaphoreCount += batch.waitSemaphores.size() + batch.waitSyncPoints.size() + 1;
+		}
+
+		auto pendingSubmit = std::make_shared<PendingSubmit>();
+		pendingSubmit->queueIndex = queueIndex;
+
+		// Reserved up front, the submit infos point into these.
+		auto& command_buffer_infos = pendingSubmit->commandBufferInfos;
+		auto& wait_infos = pendingSubmit->waitInfos;
+		auto& signal_infos = pendingSubmit->signalInfos;
+		auto& submit_infos = pendingSubmit->submitInfos;
+		pendingSubmit->commandLists.reserve(commandListCount);
+		command_buffer_infos.reserve(commandListCount);
+		wait_infos.reserve(waitSemaphoreCount);
+		signal_infos.reserve(batches.size() * 2 + 1);
+		submit_infos.resize(batches.size());
+		pendingSubmit->latencyPresentIds.reserve(batches.size());
+
+		for (auto i = 0; i < batches.size(); ++i)
+		{
+			const auto& batch = batches[i];
+			auto& submit_info = submit_infos[i];
+
+			// The command buffers are filled in by execute_submit(), once deferred command lists have been translated.
+			const auto firstCommandBuffer = command_buffer_infos.size();
+			for (const auto commandListHandle : batch.commandLists)
+			{
+				auto* command_list = m_commandListPool.get_checked(commandListHandle.resourceHandle);
+				pendingSubmit->commandLists.push_back(command_list);
+				command_buffer_infos.emplace_back().setDeviceMask(batch.deviceMask);
+				if (command_list->get_flags() & CommandListFlags_FireAndForget)
+				{
+					pendingSubmit->fireAndForgetCommandLists.push_back(commandListHandle);
+				}
+			}
+			submit_info.setCommandBufferInfoCount(std::uint32_t(command_buffer_infos.size() - firstCommandBuffer));
+			submit_info.setPCommandBufferInfos(command_buffer_infos.data() + firstCommandBuffer);
+
+			const auto firstWait = wait_infos.size();
+			for (const auto& semaphoreWait : batch.waitSemaphores)
+			{
+				vk::Semaphore semaphore{};
+				get_wait_semaphore(semaphore, semaphoreWait.semaphoreHandle);
+				wait_infos.emplace_back(semaphore, 0, convert_pipeline_stages_to_vk_pipeline_stage_flags(semaphoreWait.stages));
+			}
+			const auto syncPointStages = convert_pipeline_stages_to_vk_pipeline_stage_flags(batch.waitSyncPointStages);
+			for (const auto& syncPoint : batch.waitSyncPoints)
+			{
+				// A default constructed sync point is always complete, so there is nothing to wait for.
+				if (syncPoint.value != 0)
+				{
+					wait_infos.emplace_back(m_queueTimelines[syncPoint.queueIndex].semaphore.get(), syncPoint.value, syncPointStages);
+				}
+			}
+			SwapChain* swapChain{ nullptr };
+			if (batch.swapChainHandle != 0 && get_swap_chain(swapChain, batch.swapChainHandle))
+			{
+				swapChain->wait_for_present();
+
+				// Tells the driver's latency model which frame the GPU work belongs to.
+				if (swapChain->is_latency_marking_enabled())
+				{
+					auto& latency_present_id = pendingSubmit->latencyPresentIds.emplace_back(swapChain->get_upcoming_present_id());
+					submit_info.setPNext(&latency_present_id);
+				}
+
+				// Only the first batch rendering to the image waits on its acquire.
+				if (auto acquireSemaphore = swapChain->take_acquire_semaphore())
+				{
+					wait_infos.emplace_back(acquireSemaphore, 0, vk::PipelineStageFlagBits2::eColorAttachmentOutput);
+				}
+			}
+			submit_info.setWaitSemaphoreInfoCount(std::uint32_t(wait_infos.size() - firstWait));
+			submit_info.setPWaitSemaphoreInfos(wait_infos.data() + firstWait);
+
+			const auto firstSignal = signal_infos.size();
+			if (batch.outSignalSemaphoreHandle != nullptr)
+			{
+				*batch.outSignalSemaphoreHandle = create_semaphore();
+				if (auto* pooledSemaphore = m_semaphorePool.get_checked(batch.outSignalSemaphoreHandle->resourceHandle); pooledSemaphore != nullptr)
+				{
+					pooledSemaphore->signalPending.store(true, std::memory_order_relaxed);
+					signal_infos.emplace_back(pooledSemaphore->semaphore.get(), 0, vk::PipelineStageFlagBits2::eAllCommands);
+				}
+			}
+			// Signalled by the last batch rendering to the image, which covers the earlier ones.
+			const auto rendersLater = std::any_of(batches.begin() + i + 1, batches.end(), [&](const SubmitBatch& laterBatch) { return laterBatch.swapChainHandle == batch.swapChainHandle; });
+			if (swapChain != nullptr && !swapChain->is_headless() && !rendersLater)
+			{
+				signal_infos.emplace_back(swapChain->signal_present_semaphore(), 0, vk::PipelineStageFlagBits2::eAllCommands);
+			}
+			if (i == batches.size() - 1)
+			{
+				// A signal covers everything earlier in submission order, so only the last batch needs to signal the timeline.
+				signal_infos.emplace_back(m_queueTimelines[queueIndex].semaphore.get(), 0, vk::PipelineStageFlagBits2::eAllCommands);
+			}
+			submit_info.setSignalSemaphoreInfoCount(std::uint32_t(signal_infos.size() - firstSignal));
+			submit_info.setPSignalSemaphoreInfos(signal_infos.data() + firstSignal);
+		}
+
+		return pendingSubmit;
+	}
+
+	bool Device::execute_submit(PendingSubmit& pendingSubmit, std::uint64_t submitValue)
+	{
+		for (auto i = 0; i < pendingSubmit.commandLists.size(); ++i)
+		{
+			pendingSubmit.commandBufferInfos[i].setCommandBuffer(pendingSubmit.commandLists[i]->get_command_buffer());
+		}
+		pendingSubmit.signalInfos.back().setValue(submitValue);
+
+		auto result = m_queues[pendingSubmit.queueIndex].submit2(pendingSubmit.submitInfos);
+		if (result != vk::Result::eSuccess)
+		{
+			s_errorCallback("GFX - Failed to submit command lists!");
+			return false;
+		}
+		return true;
+	}
+
+	auto Device::present_swap_chain(SwapChain& swapChain, std::uint32_t queueIndex, vk::Semaphore waitSemaphore, std::uint64_t desiredPresentTimeNs) -> std::uint64_t
+	{
+		auto queue = m_queues.at(queueIndex);
+		const auto presentId = swapChain.next_present_id(m_frameNumber);
+		if (m_submissionThread != nullptr)
+		{
+			// Queued behind the submits that signal the semaphores it waits on. The next image is acquired on the submission thread too.
+			swapChain.begin_present();
+			m_submissionThread->enqueue([this, &swapChain, queue, queueIndex, waitSemaphore, presentId, desiredPresentTimeNs] {
+				{
+					std::lock_guard lock(get_queue_mutex(queueIndex));
+					swapChain.present(queue, waitSemaphore, presentId, desiredPresentTimeNs);
+				}
+				swapChain.end_present();
+			});
+			return presentId;
+		}
+
+		std::lock_guard lock(get_queue_mutex(queueIndex));
+		swapChain.present(queue, waitSemaphore, presentId, desiredPresentTimeNs);
+		return presentId;
+	}
+
+	void Device::present_swap_chains(std::span<SwapChain* const> swapChains, std::uint32_t queueIndex, vk::Semaphore waitSemaphore, std::uint64_t desiredPresentTimeNs, std::span<std::uint64_t> outPresentIds)
+	{
+		auto queue = m_queues.at(queueIndex);
+		InlineVector<std::uint64_t, SwapChain::MAX_BATCHED_PRESENTS> presentIds{};
+		for (auto i = 0u; i < swapChains.size(); ++i)
+		{
+			presentIds.push_back(swapChains[i]->next_present_id(m_frameNumber));
+			outPresentIds[i] = presentIds[i];
+		}
+		if (m_submissionThread != nullptr)
+		{
+			// As present_swap_chain(), queued behind the submits that signal the semaphores it waits on.
+			InlineVector<SwapChain*, SwapChain::MAX_BATCHED_PRESENTS> batch{};
+			for (auto* swapChain : swapChains)
+			{
+				swapChain->begin_present();
+				batch.push_back(swapChain);
+			}
+			m_submissionThread->enqueue([this, batch, presentIds, queue, queueIndex, waitSemaphore, desiredPresentTimeNs] {
+				{
+					std::lock_guard lock(get_queue_mutex(queueIndex));
+					SwapChain::present_batch(queue, batch, presentIds, waitSemaphore, desiredPresentTimeNs);
+				}
+				for (auto* swapChain : batch)
+				{
+					swapChain->end_present();
+				}
+			});
+			return;
+		}
+
+		std::lock_guard lock(get_queue_mutex(queueIndex));
+		SwapChain::present_batch(queue, swapChains, presentIds, waitSemaphore, desiredPresentTimeNs);
+	}
+
+	bool Device::is_host_image_copy_optimal(const vk::ImageCreateInfo& imageInfo) const
+	{
+		if (!m_hostImageCopySupported)
+		{
+			return false;
+		}
+
+		const vk::PhysicalDeviceImageFormatInfo2 format_info{ imageInfo.format, imageInfo.imageType, imageInfo.tiling, imageInfo.usage, imageInfo.flags };
+		vk::HostImageCopyDevicePerformanceQueryEXT performance_query{};
+		vk::ImageFormatProperties2 format_properties{};
+		format_properties.setPNext(&performance_query);
+		if (m_physicalDevice.getImageFormatProperties2(&format_info, &format_properties) != vk::Result::eSuccess)
+		{
+			return false;
+		}
+		return performance_query.optimalDeviceAccess;
+	}
+
+	bool Device::host_copy_texture_level(Texture& texture, const void* data, std::uint32_t mipLevel)
+	{
+		// Promoted formats are widened while staging instead.
+		if (!texture.supports_host_copy() || texture.is_format_promoted())
+		{
+			return false;
+		}
+		// A level that was never transitioned cannot be in use on the GPU, so the host may write it.
+		const auto arrayLayers = texture.get_array_layers();
+		for (auto layer = 0u; layer < arrayLayers; ++layer)
+		{
+			if (texture.get_state(mipLevel, layer) != TextureState::eUndefined)
+			{
+				return false;
+			}
+		}
+
+		vk::HostImageLayoutTransitionInfoEXT transition_info{};
+		transition_info.setImage(texture.get_image());
+		transition_info.setOldLayout(vk::ImageLayout::eUndefined);
+		transition_info.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+		transition_info.setSubresourceRange({ texture.get_aspect_mask(), mipLevel, 1, 0, arrayLayers });
+		if (m_device->transitionImageLayoutEXT(transition_info) != vk::Result::eSuccess)
+		{
+			return false;
+		}
+
+		vk::MemoryToImageCopyEXT region{};
+		region.setPHostPointer(data);
+		region.setImageSubresource({ texture.get_copy_aspect_mask(), mipLevel, 0, arrayLayers });
+		region.setImageExtent(texture.get_mip_extent(mipLevel));
+
+		vk::CopyMemoryToImageInfoEXT copy_info{};
+		copy_info.setDstImage(texture.get_image());
+		copy_info.setDstImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+		copy_info.setRegions(region);
+		if (m_device->copyMemoryToImageEXT(copy_info) != vk::Result::eSuccess)
+		{
+			s_errorCallback("GFX - Failed to copy texture data from host memory!");
+			return false;
+		}
+
+		texture.set_state(TextureState::eShaderRead, mipLevel, 1, 0, arrayLayers);
+		return true;
+	}
+
+	bool Device::is_extension_available(const char* extensionName) const
+	{
+		return std::any_of(m_availableExtensions.begin(), m_availableExtensions.end(), [extensionName](const auto& extension) {
+			return std::strcmp(extension.extensionName, extensionName) == 0;
+		});
+	}
+
+	void Device::init_properties(std::span<const char* const> enabledExtensions)
+	{
+		const auto properties_chain = m_physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan11Properties, vk::PhysicalDeviceVulkan13Properties>();
+		const auto& properties = properties_chain.get<vk::PhysicalDeviceProperties2>().properties;
+		const auto& vulkan_11_properties = properties_chain.get<vk::PhysicalDeviceVulkan11Properties>();
+		const auto& vulkan_13_properties = properties_chain.get<vk::PhysicalDeviceVulkan13Properties>();
+		const auto& limits = properties.limits;
+
+		auto& props = m_properties;
+		props.deviceName = properties.deviceName.data();
+		switch (properties.deviceType)
+		{
+			case vk::PhysicalDeviceType::eIntegratedGpu:
+				props.deviceType = DeviceType::eIntegrated;
+				break;
+			case vk::PhysicalDeviceType::eDiscreteGpu:
+				props.deviceType = DeviceType::eDiscrete;
+				break;
+			case vk::PhysicalDeviceType::eVirtualGpu:
+				props.deviceType = DeviceType::eVirtual;
+				break;
+			case vk::PhysicalDeviceType::eCpu:
+				props.deviceType = DeviceType::eCpu;
+				break;
+			default:
+				props.deviceType = DeviceType::eOther;
+				break;
+		}
+		props.vendorId = properties.vendorID;
+		props.deviceId = properties.deviceID;
+		props.driverVersion = properties.driverVersion;
+		props.apiVersion = properties.apiVersion;
+		props.deviceGroupSize = std::uint32_t(m_deviceGroupPhysicalDevices.size());
+
+		props.maxImageDimension2D = limits.maxImageDimension2D;
+		props.maxImageDimension3D = limits.maxImageDimension3D;
+		props.maxImageArrayLayers = limits.maxImageArrayLayers;
+		props.maxColorAttachments = limits.maxColorAttachments;
+		props.maxPushConstantsSize = limits.maxPushConstantsSize;
+		props.maxInlineUniformBlockSize = (m_enabledFeatures & DeviceFeatureFlags_InlineUniformBlock) ? vulkan_13_properties.maxInlineUniformBlockSize : 0;
+		props.maxBoundDescriptorSets = limits.maxBoundDescriptorSets;
+		props.maxUniformBufferRange = limits.maxUniformBufferRange;
+		props.maxStorageBufferRange = limits.maxStorageBufferRange;
+		props.minUniformBufferOffsetAlignment = limits.minUniformBufferOffsetAlignment;
+		props.minStorageBufferOffsetAlignment = limits.minStorageBufferOffsetAlignment;
+		props.optimalBufferCopyOffsetAlignment = limits.optimalBufferCopyOffsetAlignment;
+		props.nonCoherentAtomSize = limits.nonCoherentAtomSize;
+		props.maxComputeWorkGroupCount = limits.maxComputeWorkGroupCount;
+		props.maxComputeWorkGroupSize = limits.maxComputeWorkGroupSize;
+		props.maxComputeWorkGroupInvocations = limits.maxComputeWorkGroupInvocations;
+		props.maxComputeSharedMemorySize = limits.maxComputeSharedMemorySize;
+		props.maxDrawIndirectCount = limits.maxDrawIndirectCount;
+		props.maxMultiviewViewCount = (m_enabledFeatures & DeviceFeatureFlags_Multiview) ? vulkan_11_properties.maxMultiviewViewCount : 0;
+		if (m_shadingRateSupported)
+		{
+			// The finest texel size, for the most precise attachments.
+			const auto shading_rate_properties_chain = m_physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceFragmentShadingRatePropertiesKHR>();
+			const auto& shading_rate_properties = shading_rate_properties_chain.get<vk::PhysicalDeviceFragmentShadingRatePropertiesKHR>();
+			m_shadingRateTexelSize = shading_rate_properties.minFragmentShadingRateAttachmentTexelSize;
+			props.shadingRateTexelSize = { m_shadingRateTexelSize.width, m_shadingRateTexelSize.height };
+			props.shadingRateCombiners = shading_rate_properties.fragmentShadingRateNonTrivialCombinerOps;
+		}
+		if (supports_ray_query())
+		{
+			const auto acceleration_structure_properties_chain =
+				m_physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceAccelerationStructurePropertiesKHR>();
+			m_accelerationStructureScratchAlignment =
+				acceleration_structure_properties_chain.get<vk::PhysicalDeviceAccelerationStructurePropertiesKHR>().minAccelerationStructureScratchOffsetAlignment;
+		}
+		props.maxSamplerAnisotropy = m_maxSamplerAnisotropy;
+
+		props.subgroupSize = vulkan_11_properties.subgroupSize;
+		props.minSubgroupSize = vulkan_13_properties.minSubgroupSize;
+		props.maxSubgroupSize = vulkan_13_properties.maxSubgroupSize;
+		const auto requiredSizeStages = vulkan_13_properties.requiredSubgroupSizeStages;
+		props.requiredSubgroupSizeStages = (requiredSizeStages & vk::ShaderStageFlagBits::eCompute ? ShaderStageFlags_Compute : 0u) |
+										   (requiredSizeStages & vk::ShaderStageFlagBits::eTaskEXT ? ShaderStageFlags_Task : 0u) |
+										   (requiredSizeStages & vk::ShaderStageFlagBits::eMeshEXT ? ShaderStageFlags_Mesh : 0u);
+		const auto subgroupStages = vulkan_11_properties.subgroupSupportedStages;
+		props.subgroupStages = (subgroupStages & vk::ShaderStageFlagBits::eCompute ? ShaderStageFlags_Compute : 0u) |
+							   (subgroupStages & vk::ShaderStageFlagBits::eVertex ? ShaderStageFlags_Vertex : 0u) |
+							   (subgroupStages & vk::ShaderStageFlagBits::eFragment ? ShaderStageFlags_Fragment : 0u) |
+							   (subgroupStages & vk::ShaderStageFlagBits::eTaskEXT ? ShaderStageFlags_Task : 0u) |
+							   (subgroupStages & vk::ShaderStageFlagBits::eMeshEXT ? ShaderStageFlags_Mesh : 0u);
+		const auto subgroupOperations = vulkan_11_properties.subgroupSupportedOperations;
+		props.subgroupOperations = (subgroupOperations & vk::SubgroupFeatureFlagBits::eBasic ? SubgroupOperationFlags_Basic : 0u) |
+								   (subgroupOperations & vk::SubgroupFeatureFlagBits::eVote ? SubgroupOperationFlags_Vote : 0u) |
+								   (subgroupOperations & vk::SubgroupFeatureFlagBits::eArithmetic ? SubgroupOperationFlags_Arithmetic : 0u) |
+								   (subgroupOperations & vk::SubgroupFeatureFlagBits::eBallot ? SubgroupOperationFlags_Ballot : 0u) |
+								   (subgroupOperations & vk::SubgroupFeatureFlagBits::eShuffle ? SubgroupOperationFlags_Shuffle : 0u) |
+								   (subgroupOperations & vk::SubgroupFeatureFlagBits::eShuffleRelative ? SubgroupOperationFlags_ShuffleRelative : 0u) |
+								   (subgroupOperations & vk::SubgroupFeatureFlagBits::eClustered ? SubgroupOperationFlags_Clustered : 0u) |
+								   (subgroupOperations & vk::SubgroupFeatureFlagBits::eQuad ? SubgroupOperationFlags_Quad : 0u);
+
+		// Unified memory when no device local type is out of the CPU's reach, resizable BAR when a mappable device local heap
+		// is larger than the 256MiB window.
+		constexpr std::uint64_t BAR_WINDOW_SIZE = 256ull * 1024 * 1024;
+		const auto memory_properties = m_physicalDevice.getMemoryProperties();
+		props.memoryHeaps.resize(memory_properties.memoryHeapCount);
+		for (std::uint32_t i = 0; i < memory_properties.memoryHeapCount; ++i)
+		{
+			props.memoryHeaps[i].size = memory_properties.memoryHeaps[i].size;
+			props.memoryHeaps[i].deviceLocal = bool(memory_properties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+		}
+		bool hasDeviceLocalType{ false };
+		bool allDeviceLocalHostVisible{ true };
+		for (std::uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i)
+		{
+			const auto& memoryType = memory_properties.memoryTypes[i];
+			const bool deviceLocal = bool(memoryType.propertyFlags & vk::MemoryPropertyFlagBits::eDeviceLocal);
+			const bool hostVisible = bool(memoryType.propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible);
+			auto& heap = props.memoryHeaps[memoryType.heapIndex];
+			heap.hostVisible = heap.hostVisible || hostVisible;
+			if (deviceLocal)
+			{
+				hasDeviceLocalType = true;
+				allDeviceLocalHostVisible = allDeviceLocalHostVisible && hostVisible;
+				props.resizableBar = props.resizableBar || (hostVisible && heap.size > BAR_WINDOW_SIZE);
+			}
+		}
+		props.unifiedMemory = hasDeviceLocalType && allDeviceLocalHostVisible;
+		props.resizableBar = props.resizableBar && !props.unifiedMemory;
+		props.uploadBufferSize = m_deviceInfo.uploadBufferSize;
+
+		props.timestampPeriod = limits.timestampPeriod;
+		props.calibratedTimestamps = m_calibratedTimestampsSupported;
+
+		const auto queueFamilyProperties = m_physicalDevice.getQueueFamilyProperties();
+		props.queues.resize(m_queueFamilies.size());
+		for (std::size_t i = 0; i < m_queueFamilies.size(); ++i)
+		{
+			const auto& familyProperties = queueFamilyProperties[m_queueFamilies[i]];
+			auto& queue = props.queues[i];
+			queue.queueFamily = m_queueFamilies[i];
+			queue.queueFlags = (familyProperties.queueFlags & vk::QueueFlagBits::eGraphics ? QueueFlags_Graphics : 0u) |
+							   (familyProperties.queueFlags & vk::QueueFlagBits::eCompute ? QueueFlags_Compute : 0u) |
+							   (familyProperties.queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute | vk::QueueFlagBits::eTransfer) ? QueueFlags_Transfer : 0u) |
+							   (familyProperties.queueFlags & vk::QueueFlagBits::eSparseBinding ? QueueFlags_SparseBinding : 0u) |
+							   (familyProperties.queueFlags & vk::QueueFlagBits::eVideoDecodeKHR ? QueueFlags_VideoDecode : 0u);
+			queue.timestampValidBits = familyProperties.timestampValidBits;
+		}
+
+		props.multiDrawIndirect = m_multiDrawIndirectSupported;
+		props.drawIndirectCount = m_drawIndirectCountSupported;
+		props.imageCubeArray = m_imageCubeArraySupported;
+		props.bufferDeviceAddress = m_bufferDeviceAddressSupported;
+		props.sparseBuffers = m_sparseBufferSupported;
+		props.sparseTextures = m_sparseTextureSupported;
+		props.bindless = m_bindlessSupported;
+		props.descriptorBuffer = m_descriptorBufferSupported;
+		props.pushDescriptors = m_pushDescriptorSupported;
+		props.dynamicBlendState = supports_dynamic_blend_state();
+		props.graphicsPipelineLibrary = m_graphicsPipelineLibrarySupported;
+		props.shaderObjects = m_shaderObjectsEnabled;
+		props.meshShader = m_meshShaderSupported;
+		props.hostImageCopy = m_hostImageCopySupported;
+		props.memoryBudget = m_memoryBudgetSupported;
+		props.memoryPriority = m_memoryPrioritySupported;
+		props.pageableMemory = m_pageableMemorySupported;
+		props.pipelineStatistics = m_pipelineStatisticsSupported;
+		props.presentWait = m_presentWaitSupported;
+		props.lowLatency = m_lowLatencySupported;
+		props.antiLag = m_antiLagSupported;
+
+		props.enabledFeatures = m_enabledFeatures;
+
+		props.enabledExtensions.assign(enabledExtensions.begin(), enabledExtensions.end());
+	}
+
+	void Device::flush_submissions()
+	{
+		if (m_submissionThread == nullptr)
+		{
+			return;
+		}
+
+		std::promise<void> flushed{};
+		auto future = flushed.get_future();
+		m_submissionThread->enqueue([&flushed] { flushed.set_value(); });
+		future.wait();
+	}
+
+	template <typename PipelineInfo>
+	bool Device::find_shared_pipeline(PipelineHandle& outPipelineHandle, std::size_t hash, const PipelineInfo& pipelineInfo, bool async)
+	{
+		{
+			std::lock_guard lock(m_sharedPipelineMutex);
+			const auto [first, last] = m_sharedPipelines.equal_range(hash);
+			const auto shared = std::find_if(first, last, [&](const auto& pair) {
+				const auto* sharedInfo = std::get_if<PipelineInfo>(&pair.second.pipelineInfo);
+				return sharedInfo != nullptr && *sharedInfo == pipelineInfo;
+			});
+			if (shared == last)
+			{
+				return false;
+			}
+			shared->second.refCount += 1;
+			outPipelineHandle = shared->second.pipelineHandle;
+		}
+
+		if (!async)
+		{
+			wait_until_pipeline_ready(outPipelineHandle);
+		}
+		return true;
+	}
+
+	void Device::wait_until_pipeline_ready(PipelineHandle pipelineHandle)
+	{
+		// Shared from an async create or prewarm_pipelines(), its compile may still be running on the worker pool.
+		Pipeline* pipeline{ nullptr };
+		if (get_pipeline(pipeline, pipelineHandle))
+		{
+			pipeline->wait_until_ready();
+		}
+	}
+
+	void Device::share_pipeline(PipelineHandle& inOutPipelineHandle, std::size_t hash, const SharedPipelineInfo& pipelineInfo, bool async)
+	{
+		PipelineHandle duplicateHandle{};
+		{
+			std::lock_guard lock(m_sharedPipelineMutex);
+			const auto [first, last] = m_sharedPipelines.equal_range(hash);
+			const auto shared = std::find_if(first, last, [&](const auto& pair) { return pair.second.pipelineInfo == pipelineInfo; });
+			if (shared == last)
+			{
+				m_sharedPipelines.emplace(hash, SharedPipeline{ pipelineInfo, inOutPipelineHandle, 1 });
+			}
+			else
+			{
+				shared->second.refCount += 1;
+				duplicateHandle = std::exchange(inOutPipelineHandle, shared->second.pipelineHandle);
+			}
+		}
+
+		if (duplicateHandle != 0)
+		{
+			destroy_pipeline(duplicateHandle);
+			if (!async)
+			{
+				wait_until_pipeline_ready(inOutPipelineHandle);
+			}
+		}
+		else if (m_pipelineManifest != nullptr)
+		{
+			m_pipelineManifest->record(hash, pipelineInfo);
+		}
+	}
+
+	bool Device::create_compute_pipeline(PipelineHandle& outPipelineHandle, const ComputePipelineInfo& computePipelineInfo, bool async, PipelineHandle placeholderHandle)
+	{
+		GFX_PROFILE_ZONE("gfx::Device::create_compute_pipeline");
+		const auto hash = std::hash<ComputePipelineInfo>{}(computePipelineInfo);
+		if (find_shared_pipeline(outPipelineHandle, hash, computePipelineInfo, async))
+		{
+			return true;
+		}
+
+		if (computePipelineInfo.requiredSubgroupSize != 0 || computePipelineInfo.requireFullSubgroups)
+		{
+			if (!(m_enabledFeatures & DeviceFeatureFlags_SubgroupSizeControl))
+			{
+				s_errorCallback("GFX - create_compute_pipeline() - Subgroup size control needs DeviceFeatureFlags_SubgroupSizeControl!");
+				return false;
+			}
+			const auto requiredSize = computePipelineInfo.requiredSubgroupSize;
+			if (requiredSize != 0 &&
+				(!std::has_single_bit(requiredSize) || requiredSize < m_properties.minSubgroupSize || requiredSize > m_properties.maxSubgroupSize ||
+				 !(m_properties.requiredSubgroupSizeStages & ShaderStageFlags_Compute)))
+			{
+				s_errorCallback("GFX - create_compute_pipeline() - Required subgroup size is not supported by this device!");
+				return false;
+			}
+		}
+
+		auto descriptorSets = computePipelineInfo.descriptorSets;
+		auto constantBlock = computePipelineInfo.constantBlock;
+		const std::array shaders{ std::pair{ computePipelineInfo.shaderCode.get_words(), ShaderStageFlags_Compute } };
+		if (!reflect_pipeline_layout(descriptorSets, constantBlock, shaders))
+		{
+			return false;
+		}
+
+		std::vector<vk::DescriptorSetLayout> setLayouts(descriptorSets.size());
+		for (auto i = 0; i < setLayouts.size(); ++i)
+		{
+			vk::DescriptorSetLayout setLayout{};
+			if (create_or_get_descriptor_set_layout(setLayout, descriptorSets.at(i)))
+			{
+				setLayouts[i] = setLayout;
+			}
+		}
+
+		vk::PushConstantRange constantRange{
+			convert_shader_stages_to_vk_shader_stage_flags(constantBlock.shaderStages),
+			0,
+			constantBlock.size
+		};
+		const auto pipelineLayout = create_or_get_pipeline_layout(setLayouts, constantRange);
+		const auto shaderModule = create_or_get_shader_module(computePipelineInfo.shaderCode);
+		if (async)
+		{
+			auto pipeline = std::make_unique<Pipeline>(PipelineType::eCompute, setLayouts, pipelineLayout);
+			pipeline->set_pending(placeholderHandle);
+			auto* pendingPipeline = pipeline.get();
+			outPipelineHandle = PipelineHandle(m_deviceHandle, m_pipelinePool.emplace(std::move(pipeline)));
+			if (CAST_HANDLE_TO_INT(outPipelineHandle.resourceHandle) == 0)
+			{
+				return false;
+			}
+			GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+			run_task([this, pendingPipeline, computePipelineInfo, shaderModule, setLayouts, pipelineLayout] {
+				ComputePipeline compiled(m_device.get(), computePipelineInfo, shaderModule, setLayouts, pipelineLayout, m_pipelineCache.get(), get_pipeline_create_flags());
+				set_debug_name(m_device.get(), compiled.get_pipeline(), computePipelineInfo.debugName);
+				pendingPipeline->complete(std::move(compiled));
+			});
+			share_pipeline(outPipelineHandle, hash, computePipelineInfo, async);
+			return true;
+		}
+
+		auto pipeline = std::make_unique<ComputePipeline>(m_device.get(), computePipelineInfo, shaderModule, setLayouts, pipelineLayout, m_pipelineCache.get(), get_pipeline_create_flags());
+		set_debug_name(m_device.get(), pipeline->get_pipeline(), computePipelineInfo.debugName);
+		outPipelineHandle = PipelineHandle(m_deviceHandle, m_pipelinePool.emplace(std::move(pipeline)));
+		if (CAST_HANDLE_TO_INT(outPipelineHandle.resourceHandle) == 0)
+		{
+			return false;
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+		share_pipeline(outPipelineHandle, hash, computePipelineInfo, async);
+		return true;
+	}
+
+	bool Device::create_graphics_pipeline(PipelineHandle& outPipelineHandle, const GraphicsPipelineInfo& graphicsPipelineInfo, bool async, PipelineHandle placeholderHandle)
+	{
+		GFX_PROFILE_ZONE("gfx::Device::create_graphics_pipeline");
+		if (is_compute_only())
+		{
+			s_errorCallback("GFX - create_graphics_pipeline() - Compute-only devices cannot create graphics pipelines!");
+			return false;
+		}
+		const auto hash = std::hash<GraphicsPipelineInfo>{}(graphicsPipelineInfo);
+		if (find_shared_pipeline(outPipelineHandle, hash, graphicsPipelineInfo, async))
+		{
+			return true;
+		}
+
+		// Both stages are reflected together, so a binding either stage uses gets one entry with both stages' flags.
+		auto descriptorSets = graphicsPipelineInfo.descriptorSets;
+		auto constantBlock = graphicsPipelineInfo.constantBlock;
+		const std::array shaders{ std::pair{ graphicsPipelineInfo.vertexCode.get_words(), ShaderStageFlags_Vertex }, std::pair{ graphicsPipelineInfo.fragmentCode.get_words(), ShaderStageFlags_Fragment } };
+		if (!reflect_pipeline_layout(descriptorSets, constantBlock, shaders))
+		{
+			return false;
+		}
+
+		std::vector<vk::DescriptorSetLayout> setLayouts(descriptorSets.size());
+		for (auto i = 0; i < setLayouts.size(); ++i)
+		{
+			vk::DescriptorSetLayout setLayout{};
+			if (create_or_get_descriptor_set_layout(setLayout, descriptorSets.at(i)))
+			{
+				setLayouts[i] = setLayout;
+			}
+		}
+
+		ScratchVector<std::uint32_t> offsets{};
+		for (const auto& binding : graphicsPipelineInfo.vertexInputBindings)
+		{
+			const auto stride = get_vertex_binding_layout(binding, offsets);
+			for (auto i = 0; i < binding.attributes.size(); ++i)
+			{
+				const auto format = binding.attributes[i].format;
+				if (!is_vertex_format_supported(convert_format_to_vk_format(format)))
+				{
+					s_errorCallback("GFX - create_graphics_pipeline() - Vertex attribute format is not supported by this device!");
+					return false;
+				}
+				if (offsets[i] > m_maxVertexInputAttributeOffset || offsets[i] + convert_format_to_byte_size(format) > stride)
+				{
+					s_errorCallback("GFX - create_graphics_pipeline() - Vertex attributes must lie within their binding's stride!");
+					return false;
+				}
+			}
+			if (stride > m_maxVertexInputBindingStride)
+			{
+				s_errorCallback("GFX - create_graphics_pipeline() - Vertex binding stride is larger than this device supports!");
+				return false;
+			}
+			if (binding.divisor != 1 && (binding.inputRate != VertexInputRate::eInstance || !(m_enabledFeatures & DeviceFeatureFlags_VertexAttributeDivisor)))
+			{
+				s_errorCallback("GFX - create_graphics_pipeline() - Vertex binding divisors other than 1 need eInstance and DeviceFeatureFlags_VertexAttributeDivisor!");
+				return false;
+			}
+		}
+		if (!std::has_single_bit(graphicsPipelineInfo.sampleCount) || !(m_colorSampleCounts & vk::SampleCountFlagBits(graphicsPipelineInfo.sampleCount)))
+		{
+			s_errorCallback("GFX - create_graphics_pipeline() - Sample count is not supported by this device!");
+			return false;
+		}
+		if (graphicsPipelineInfo.viewMask != 0 && std::uint32_t(std::bit_width(graphicsPipelineInfo.viewMask)) > m_properties.maxMultiviewViewCount)
+		{
+			s_errorCallback("GFX - create_graphics_pipeline() - View mask needs DeviceFeatureFlags_Multiview and views below DeviceProperties::maxMultiviewViewCount!");
+			return false;
+		}
+		if ((graphicsPipelineInfo.dynamicStates & DynamicStateFlags_Blend) && !supports_dynamic_blend_state())
+		{
+			s_errorCallback("GFX - create_graphics_pipeline() - Dynamic blend state is not supported by this device!");
+			return false;
+		}
+		if ((graphicsPipelineInfo.dynamicStates & DynamicStateFlags_ShadingRate) && !supports_shading_rate())
+		{
+			s_errorCallback("GFX - create_graphics_pipeline() - Dynamic shading rate needs DeviceFeatureFlags_ShadingRate!");
+			return false;
+		}
+
+		vk::PushConstantRange constantRange{
+			convert_shader_stages_to_vk_shader_stage_flags(constantBlock.shaderStages),
+			0,
+			constantBlock.size
+		};
+		const auto pipelineLayout = create_or_get_pipeline_layout(setLayouts, constantRange);
+		if (m_shaderObjectsEnabled)
+		{
+			// Only the shaders are compiled, which is quick enough not to need the worker pool.
+			auto pipeline = std::make_unique<ShaderObjectPipeline>(m_device.get(), graphicsPipelineInfo, setLayouts, pipelineLayout, constantRange, supports_shading_rate());
+			outPipelineHandle = PipelineHandle(m_deviceHandle, m_pipelinePool.emplace(std::move(pipeline)));
+			if (CAST_HANDLE_TO_INT(outPipelineHandle.resourceHandle) == 0)
+			{
+				return false;
+			}
+			GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+			share_pipeline(outPipelineHandle, hash, graphicsPipelineInfo, async);
+			return true;
+		}
+		const auto vertexModule = create_or_get_shader_module(graphicsPipelineInfo.vertexCode);
+		// Depth-only pipelines, eg. for a z-prepass or shadow map, have no fragment stage.
+		const auto fragmentModule = graphicsPipelineInfo.fragmentCode.empty() ? vk::ShaderModule{} : create_or_get_shader_module(graphicsPipelineInfo.fragmentCode);
+		if (async)
+		{
+			auto pipeline = std::make_unique<Pipeline>(PipelineType::eGraphics, setLayouts, pipelineLayout);
+			pipeline->set_pending(placeholderHandle);
+			auto* pendingPipeline = pipeline.get();
+			outPipelineHandle = PipelineHandle(m_deviceHandle, m_pipelinePool.emplace(std::move(pipeline)));
+			if (CAST_HANDLE_TO_INT(outPipelineHandle.resourceHandle) == 0)
+			{
+				return false;
+			}
+			GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+			run_task([this, pendingPipeline, graphicsPipelineInfo, vertexModule, fragmentModule, setLayouts, pipelineLayout] {
+				GraphicsPipeline compiled(m_device.get(), graphicsPipelineInfo, vertexModule, fragmentModule, setLayouts, pipelineLayout, m_pipelineCache.get(), get_graphics_pipeline_create_flags());
+				set_debug_name(m_device.get(), compiled.get_pipeline(), graphicsPipelineInfo.debugName);
+				pendingPipeline->complete(std::move(compiled));
+			});
+			share_pipeline(outPipelineHandle, hash, graphicsPipelineInfo, async);
+			return true;
+		}
+
+		if (m_graphicsPipelineLibrarySupported)
+		{
+			// Fast-linked from the parts' libraries so it is usable straight away, then optimised on the worker pool.
+			std::array<vk::Pipeline, 4> libraries{};
+			constexpr std::array parts{ vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface, vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders,
+										vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader, vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentOutputInterface };
+			for (auto i = 0; i < parts.size(); ++i)
+			{
+				libraries[i] = create_or_get_pipeline_library(parts[i], graphicsPipelineInfo, vertexModule, fragmentModule, setLayouts, pipelineLayout);
+			}
+
+			auto pipeline = std::make_unique<GraphicsPipeline>(m_device.get(), libraries, setLayouts, pipelineLayout, m_pipelineCache.get(), get_graphics_pipeline_create_flags());
+			set_debug_name(m_device.get(), pipeline->get_pipeline(), graphicsPipelineInfo.debugName);
+			pipeline->set_optimizing();
+			auto* linkedPipeline = pipeline.get();
+			outPipelineHandle = PipelineHandle(m_deviceHandle, m_pipelinePool.emplace(std::move(pipeline)));
+			if (CAST_HANDLE_TO_INT(outPipelineHandle.resourceHandle) == 0)
+			{
+				return false;
+			}
+			GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+			run_task([this, linkedPipeline, libraries, setLayouts, pipelineLayout, debugName = graphicsPipelineInfo.debugName] {
+				const auto flags = get_graphics_pipeline_create_flags() | vk::PipelineCreateFlagBits::eLinkTimeOptimizationEXT;
+				GraphicsPipeline optimized(m_device.get(), libraries, setLayouts, pipelineLayout, m_pipelineCache.get(), flags);
+				set_debug_name(m_device.get(), optimized.get_pipeline(), debugName);
+				linkedPipeline->complete_optimization(std::move(optimized));
+			});
+			share_pipeline(outPipelineHandle, hash, graphicsPipelineInfo, async);
+			return true;
+		}
+
+		auto pipeline = std::make_unique<GraphicsPipeline>(m_device.get(), graphicsPipelineInfo, vertexModule, fragmentModule, setLayouts, pipelineLayout, m_pipelineCache.get(), get_graphics_pipeline_create_flags());
+		set_debug_name(m_device.get(), pipeline->get_pipeline(), graphicsPipelineInfo.debugName);
+		outPipelineHandle = PipelineHandle(m_deviceHandle, m_pipelinePool.emplace(std::move(pipeline)));
+		if (CAST_HANDLE_TO_INT(outPipelineHandle.resourceHandle) == 0)
+		{
+			return false;
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+		share_pipeline(outPipelineHandle, hash, graphicsPipelineInfo, async);
+		return true;
+	}
+
+	bool Device::create_mesh_pipeline(PipelineHandle& outPipelineHandle, const MeshPipelineInfo& meshPipelineInfo)
+	{
+		GFX_PROFILE_ZONE("gfx::Device::create_mesh_pipeline");
+		if (!m_meshShaderSupported)
+		{
+			s_errorCallback("GFX - create_mesh_pipeline() - Mesh shaders are not supported by this device!");
+			return false;
+		}
+		if (meshPipelineInfo.state.viewMask != 0)
+		{
+			s_errorCallback("GFX - create_mesh_pipeline() - Multiview is not supported with mesh shaders!");
+			return false;
+		}
+
+		const auto hash = std::hash<MeshPipelineInfo>{}(meshPipelineInfo);
+		if (find_shared_pipeline(outPipelineHandle, hash, meshPipelineInfo, false))
+		{
+			return true;
+		}
+
+		const auto& stateInfo = meshPipelineInfo.state;
+		auto descriptorSets = stateInfo.descriptorSets;
+		auto constantBlock = stateInfo.constantBlock;
+		std::vector shaders{ std::pair{ meshPipelineInfo.meshCode.get_words(), ShaderStageFlags_Mesh }, std::pair{ stateInfo.fragmentCode.get_words(), ShaderStageFlags_Fragment } };
+		if (!meshPipelineInfo.taskCode.empty())
+		{
+			shaders.emplace_back(meshPipelineInfo.taskCode.get_words(), ShaderStageFlags_Task);
+		}
+		if (!reflect_pipeline_layout(descriptorSets, constantBlock, shaders))
+		{
+			return false;
+		}
+
+		std::vector<vk::DescriptorSetLayout> setLayouts(descriptorSets.size());
+		for (auto i = 0; i < setLayouts.size(); ++i)
+		{
+			vk::DescriptorSetLayout setLayout{};
+			if (create_or_get_descriptor_set_layout(setLayout, descriptorSets.at(i)))
+			{
+				setLayouts[i] = setLayout;
+			}
+		}
+
+		if (!std::has_single_bit(stateInfo.sampleCount) || !(m_colorSampleCounts & vk::SampleCountFlagBits(stateInfo.sampleCount)))
+		{
+			s_errorCallback("GFX - create_mesh_pipeline() - Sample count is not supported by this device!");
+			return false;
+		}
+		if ((stateInfo.dynamicStates & DynamicStateFlags_Blend) && !m_dynamicBlendStateSupported)
+		{
+			s_errorCallback("GFX - create_mesh_pipeline() - Dynamic blend state is not supported by this device!");
+			return false;
+		}
+
+		vk::PushConstantRange constantRange{
+			convert_shader_stages_to_vk_shader_stage_flags(constantBlock.shaderStages),
+			0,
+			constantBlock.size
+		};
+		const auto pipelineLayout = create_or_get_pipeline_layout(setLayouts, constantRange);
+		// Always compiled whole, shader objects and pipeline libraries are only used for vertex pipelines.
+		const auto taskModule = meshPipelineInfo.taskCode.empty() ? vk::ShaderModule{} : create_or_get_shader_module(meshPipelineInfo.taskCode);
+		const auto meshModule = create_or_get_shader_module(meshPipelineInfo.meshCode);
+		const auto fragmentModule = create_or_get_shader_module(stateInfo.fragmentCode);
+
+		auto pipeline = std::make_unique<MeshPipeline>(m_device.get(), meshPipelineInfo, taskModule, meshModule, fragmentModule, setLayouts, pipelineLayout, m_pipelineCache.get(), get_graphics_pipeline_create_flags());
+		set_debug_name(m_device.get(), pipeline->get_pipeline(), meshPipelineInfo.debugName);
+		outPipelineHandle = PipelineHandle(m_deviceHandle, m_pipelinePool.emplace(std::move(pipeline)));
+		if (CAST_HANDLE_TO_INT(outPipelineHandle.resourceHandle) == 0)
+		{
+			return false;
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+		share_pipeline(outPipelineHandle, hash, meshPipelineInfo, false);
+		return true;
+	}
+
+	void Device::destroy_pipeline(PipelineHandle pipelineHandle)
+	{
+		{
+			std::lock_guard lock(m_sharedPipelineMutex);
+			const auto shared = std::find_if(m_sharedPipelines.begin(), m_sharedPipelines.end(), [&](const auto& pair) { return pair.second.pipelineHandle == pipelineHandle; });
+			if (shared != m_sharedPipelines.end())
+			{
+				if (--shared->second.refCount > 0)
+				{
+					return;
+				}
+				m_sharedPipelines.erase(shared);
+			}
+		}
+
+		// A pipeline still compiling was never bound, its placeholder was.
+		if (auto* pipeline = m_pipelinePool.get_checked(pipelineHandle.resourceHandle); pipeline != nullptr && *pipeline != nullptr && (*pipeline)->is_ready())
+		{
+			// Bundles may have been recorded with its fast-linked pipeline before the optimised one replaced it.
+			invalidate_bundles(get_resource_key((*pipeline)->get_unoptimized_pipeline()));
+			if ((*pipeline)->get_pipeline() != (*pipeline)->get_unoptimized_pipeline())
+			{
+				invalidate_bundles(get_resource_key((*pipeline)->get_pipeline()));
+			}
+			if ((*pipeline)->get_type() == PipelineType::eGraphicsShaderObjects)
+			{
+				invalidate_bundles(get_resource_key(static_cast<const ShaderObjectPipeline&>(**pipeline).get_state().vertexShader));
+			}
+		}
+		defer_destroy([this, resourceHandle = pipelineHandle.resourceHandle] {
+			// The worker compiling or optimising it still writes to it.
+			if (auto* pipeline = m_pipelinePool.get_checked(resourceHandle); pipeline != nullptr && *pipeline != nullptr)
+			{
+				(*pipeline)->wait_until_ready();
+				(*pipeline)->wait_until_optimized();
+			}
+			m_pipelinePool.erase(resourceHandle);
+		});
+	}
+
+	bool Device::get_pipeline(Pipeline*& outPipeline, PipelineHandle pipelineHandle)
+	{
+		auto* pipeline = m_pipelinePool.get_checked(pipelineHandle.resourceHandle);
+		outPipeline = pipeline != nullptr ? pipeline->get() : nullptr;
+		return outPipeline != nullptr;
+	}
+
+	bool Device::get_bindable_pipeline(Pipeline*& outPipeline, PipelineHandle pipelineHandle)
+	{
+		if (!get_pipeline(outPipeline, pipelineHandle))
+		{
+			return false;
+		}
+		if (outPipeline->is_ready())
+		{
+			return true;
+		}
+
+		const auto placeholderHandle = outPipeline->get_placeholder();
+		if (placeholderHandle == 0 || !get_pipeline(outPipeline, placeholderHandle) || !outPipeline->is_ready())
+		{
+			s_errorCallback("GFX - Cannot bind a pipeline that is still compiling without a compiled placeholder!");
+			outPipeline = nullptr;
+			return false;
+		}
+		return true;
+	}
+
+	bool Device::is_pipeline_ready(PipelineHandle pipelineHandle)
+	{
+		Pipeline* pipeline{ nullptr };
+		return get_pipeline(pipeline, pipelineHandle) && pipeline->is_ready();
+	}
+
+	bool Device::find_tuned_workgroup_size(std::uint32_t& outWorkgroupSize, std::size_t key)
+	{
+		std::lock_guard lock(m_tunedWorkgroupSizesMutex);
+		const auto it = m_tunedWorkgroupSizes.find(key);
+		if (it == m_tunedWorkgroupSizes.end())
+		{
+			return false;
+		}
+		outWorkgroupSize = it->second;
+		return true;
+	}
+
+	void Device::set_tuned_workgroup_size(std::size_t key, std::uint32_t workgroupSize)
+	{
+		std::lock_guard lock(m_tunedWorkgroupSizesMutex);
+		m_tunedWorkgroupSizes[key] = workgroupSize;
+	}
+
+	bool Device::create_descriptor_set(DescriptorSetHandle& outDescriptorSetHandle, const DescriptorSetInfo& setInfo)
+	{
+		vk::DescriptorSetLayout descriptorSetLayout{};
+		if (!create_or_get_descriptor_set_layout(descriptorSetLayout, setInfo))
+		{
+			return false;
+		}
+		// There is only the one heap, which lives as long as the device.
+		if (setInfo.bindlessHeap)
+		{
+			outDescriptorSetHandle = m_bindlessHeapHandle;
+			return true;
+		}
+		if (setInfo.push)
+		{
+			s_errorCallback("GFX - create_descriptor_set() - Push descriptor sets are not allocated, use push_descriptors()!");
+			return false;
+		}
+
+		vk::DescriptorSet descriptorSet{};
+		vk::DeviceSize descriptorBufferOffset{ 0 };
+		std::lock_guard lock(m_descriptorPoolMutex);
+		if (!allocate_persistent_descriptor_set(descriptorSet, descriptorBufferOffset, descriptorSetLayout))
+		{
+			return false;
+		}
+
+		outDescriptorSetHandle = DescriptorSetHandle(m_deviceHandle, m_descriptorSetPool.emplace(descriptorSet, get_descriptor_set_layout_binding_types(descriptorSetLayout), descriptorSetLayout, descriptorBufferOffset));
+		if (CAST_HANDLE_TO_INT(outDescriptorSetHandle.resourceHandle) == 0)
+		{
+			m_freeDescriptorSets[get_resource_key(descriptorSetLayout)].push_back({ descriptorSet, descriptorBufferOffset });
+			return false;
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+		return true;
+	}
+
+	bool Device::create_transient_descriptor_set(DescriptorSetHandle& outDescriptorSetHandle, const DescriptorSetInfo& setInfo)
+	{
+		if (setInfo.bindlessHeap)
+		{
+			s_errorCallback("GFX - create_transient_descriptor_set() - The bindless heap cannot be transient, use get_bindless_heap()!");
+			return false;
+		}
+		if (setInfo.push)
+		{
+			s_errorCallback("GFX - create_transient_descriptor_set() - Push descriptor sets are not allocated, use push_descriptors()!");
+			return false;
+		}
+
+		vk::DescriptorSetLayout descriptorSetLayout{};
+		if (!create_or_get_descriptor_set_layout(descriptorSetLayout, setInfo))
+		{
+			return false;
+		}
+
+		vk::DescriptorSet descriptorSet{};
+		vk::DeviceSize descriptorBufferOffset{ 0 };
+		std::lock_guard lock(m_descriptorPoolMutex);
+		const auto frameIndex = get_frame_index();
+		if (m_descriptorBuffer ? !m_descriptorBuffer->allocate(descriptorBufferOffset, descriptorSetLayout, frameIndex)
+							   : !m_frameDescriptorAllocators[frameIndex]->allocate(descriptorSet, descriptorSetLayout))
+		{
+			return false;
+		}
+
+		outDescriptorSetHandle = DescriptorSetHandle(m_deviceHandle, m_descriptorSetPool.emplace(descriptorSet, get_descriptor_set_layout_binding_types(descriptorSetLayout), descriptorSetLayout, descriptorBufferOffset));
+		if (CAST_HANDLE_TO_INT(outDescriptorSetHandle.resourceHandle) == 0)
+		{
+			return false;
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+		m_frameTransientDescriptorSets[frameIndex].push_back(outDescriptorSetHandle);
+		return true;
+	}
+
+	bool Device::get_cached_descriptor_set(DescriptorSetHandle& outDescriptorSetHandle, const DescriptorSetInfo& setInfo, std::span<const DescriptorWrite> writes)
+	{
+		if (setInfo.bindlessHeap || setInfo.push)
+		{
+			s_errorCallback("GFX - get_cached_descriptor_set() - Only allocated descriptor sets can be cached!");
+			return false;
+		}
+
+		vk::DescriptorSetLayout descriptorSetLayout{};
+		if (!create_or_get_descriptor_set_layout(descriptorSetLayout, setInfo))
+		{
+			return false;
+		}
+
+		std::size_t hash{};
+		sm::hash_combine(hash, get_resource_key(descriptorSetLayout));
+		for (const auto& write : writes)
+		{
+			sm::hash_combine(hash, write.binding);
+			sm::hash_combine(hash, write.arrayElement);
+			sm::hash_combine(hash, std::uint64_t(write.bufferHandle));
+			sm::hash_combine(hash, write.offset);
+			sm::hash_combine(hash, write.range);
+			sm::hash_combine(hash, std::uint64_t(write.textureHandle));
+			sm::hash_combine(hash, write.viewIndex);
+			sm::hash_combine(hash, std::uint64_t(write.samplerHandle));
+		}
+
+		std::lock_guard lock(m_descriptorSetCacheMutex);
+		const auto [first, last] = m_descriptorSetCache.equal_range(hash);
+		const auto cached = std::find_if(first, last, [&](const auto& pair) { return pair.second.layout == descriptorSetLayout && std::ranges::equal(pair.second.writes, writes); });
+		if (cached != last)
+		{
+			cached->second.unusedFrames = 0;
+			outDescriptorSetHandle = cached->second.descriptorSetHandle;
+			return true;
+		}
+
+		DescriptorSetHandle descriptorSetHandle{};
+		if (!create_descriptor_set(descriptorSetHandle, setInfo))
+		{
+			return false;
+		}
+
+		update_descriptor_set(descriptorSetHandle, writes);
+		m_descriptorSetCache.emplace(hash, CachedDescriptorSet{ descriptorSetLayout, { writes.begin(), writes.end() }, descriptorSetHandle });
+		outDescriptorSetHandle = descriptorSetHandle;
+		return true;
+	}
+
+	void Device::age_cached_descriptor_sets()
+	{
+		std::vector<DescriptorSetHandle> evicted{};
+		{
+			std::lock_guard lock(m_descriptorSetCacheMutex);
+			std::erase_if(m_descriptorSetCache, [&](auto& pair) {
+				if (++pair.second.unusedFrames <= CACHED_DESCRIPTOR_SET_LIFETIME)
+				{
+					return false;
+				}
+				evicted.push_back(pair.second.descriptorSetHandle);
+				return true;
+			});
+		}
+		for (const auto descriptorSetHandle : evicted)
+		{
+			destroy_descriptor_set(descriptorSetHandle);
+		}
+	}
+
+	void Device::evict_cached_descriptor_sets(const std::function<bool(const DescriptorWrite&)>& references)
+	{
+		std::vector<DescriptorSetHandle> evicted{};
+		{
+			std::lock_guard lock(m_descriptorSetCacheMutex);
+			std::erase_if(m_descriptorSetCache, [&](const auto& pair) {
+				if (std::ranges::none_of(pair.second.writes, references))
+				{
+					return false;
+				}
+				evicted.push_back(pair.second.descriptorSetHandle);
+				return true;
+			});
+		}
+		for (const auto descriptorSetHandle : evicted)
+		{
+			destroy_descriptor_set(descriptorSetHandle);
+		}
+	}
+
+	void Device::destroy_descriptor_set(DescriptorSetHandle descriptorSetHandle)
+	{
+		if (descriptorSetHandle == m_bindlessHeapHandle)
+		{
+			s_errorCallback("GFX - destroy_descriptor_set() - The bindless heap lives as long as the device!");
+			return;
+		}
+		const auto* descriptorSet = m_descriptorSetPool.get_checked(descriptorSetHandle.resourceHandle);
+		if (descriptorSet == nullptr)
+		{
+			s_errorCallback("GFX - destroy_descriptor_set() - Unknown descriptor set!");
+			return;
+		}
+		{
+			std::lock_guard lock(m_descriptorPoolMutex);
+			const auto isTransient = [&](const auto& frameSets) { return std::ranges::find(frameSets, descriptorSetHandle) != frameSets.end(); };
+			if (std::ranges::any_of(m_frameTransientDescriptorSets, isTransient))
+			{
+				s_errorCallback("GFX - destroy_descriptor_set() - Transient descriptor sets are reset with their frame!");
+				return;
+			}
+		}
+
+		if (descriptorSet->set)
+		{
+			invalidate_bundles(get_resource_key(descriptorSet->set));
+		}
+		{
+			std::lock_guard lock(m_descriptorSetCacheMutex);
+			std::erase_if(m_descriptorSetCache, [&](const auto& pair) { return pair.second.descriptorSetHandle == descriptorSetHandle; });
+		}
+		{
+			// Otherwise moved resources would be rebound into a set that was reused.
+			std::lock_guard lock(m_descriptorBindingMutex);
+			std::erase_if(m_descriptorBindings, [&](const auto& pair) { return pair.second.descriptorSetHandle == descriptorSetHandle; });
+		}
+		defer_destroy([this, resourceHandle = descriptorSetHandle.resourceHandle] {
+			if (const auto* descriptorSet = m_descriptorSetPool.get_checked(resourceHandle); descriptorSet != nullptr)
+			{
+				std::lock_guard lock(m_descriptorPoolMutex);
+				m_freeDescriptorSets[get_resource_key(descriptorSet->layout)].push_back({ descriptorSet->set, descriptorSet->descriptorBufferOffset });
+			}
+			m_descriptorSetPool.erase(resourceHandle);
+		});
+	}
+
+	bool Device::allocate_persistent_descriptor_set(vk::DescriptorSet& outDescriptorSet, vk::DeviceSize& outDescriptorBufferOffset, vk::DescriptorSetLayout descriptorSetLayout)
+	{
+		if (auto it = m_freeDescriptorSets.find(get_resource_key(descriptorSetLayout)); it != m_freeDescriptorSets.end() && !it->second.empty())
+		{
+			outDescriptorSet = it->second.back().set;
+			outDescriptorBufferOffset = it->second.back().descriptorBufferOffset;
+			it->second.pop_back();
+			return true;
+		}
+		return m_descriptorBuffer ? m_descriptorBuffer->allocate(outDescriptorBufferOffset, descriptorSetLayout) : m_persistentDescriptorAllocator->allocate(outDescriptorSet, descriptorSetLayout);
+	}
+
+	bool Device::create_descriptor_set_from_pipeline(DescriptorSetHandle& outDescriptorSetHandle, PipelineHandle pipelineHandle, std::uint32_t set)
+	{
+		Pipeline* pipeline{ nullptr };
+		if (!get_pipeline(pipeline, pipelineHandle))
+		{
+			return false;
+		}
+
+		auto descriptorSetLayout = pipeline->get_set_layout(set);
+		if (m_bindlessHeap && descriptorSetLayout == m_bindlessHeap->get_layout())
+		{
+			outDescriptorSetHandle = m_bindlessHeapHandle;
+			return true;
+		}
+		{
+			std::lock_guard lock(m_descriptorSetLayoutMutex);
+			if (m_pushDescriptorSetLayouts.contains(get_resource_key(descriptorSetLayout)))
+			{
+				s_errorCallback("GFX - create_descriptor_set_from_pipeline() - Push descriptor sets are not allocated, use push_descriptors()!");
+				return false;
+			}
+		}
+
+		vk::DescriptorSet descriptorSet{};
+		vk::DeviceSize descriptorBufferOffset{ 0 };
+		std::lock_guard lock(m_descriptorPoolMutex);
+		if (!allocate_persistent_descriptor_set(descriptorSet, descriptorBufferOffset, descriptorSetLayout))
+		{
+			return false;
+		}
+
+		outDescriptorSetHandle = DescriptorSetHandle(m_deviceHandle, m_descriptorSetPool.emplace(descriptorSet, get_descriptor_set_layout_binding_types(descriptorSetLayout), descriptorSetLayout, descriptorBufferOffset));
+		if (CAST_HANDLE_TO_INT(outDescriptorSetHandle.resourceHandle) == 0)
+		{
+			m_freeDescriptorSets[get_resource_key(descriptorSetLayout)].push_back({ descriptorSet, descriptorBufferOffset });
+			return false;
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+		return true;
+	}
+
+	bool Device::get_descriptor_set(vk::DescriptorSet& outDescriptorSet, DescriptorSetHandle descriptorSetHandle)
+	{
+		auto* descriptorSet = m_descriptorSetPool.get_checked(descriptorSetHandle.resourceHandle);
+		outDescriptorSet = descriptorSet != nullptr ? descriptorSet->set : nullptr;
+		return descriptorSet != nullptr;
+	}
+
+	bool Device::get_descriptor_buffer_offset(vk::DeviceSize& outOffset, DescriptorSetHandle descriptorSetHandle)
+	{
+		auto* descriptorSet = m_descriptorSetPool.get_checked(descriptorSetHandle.resourceHandle);
+		outOffset = descriptorSet != nullptr ? descriptorSet->descriptorBufferOffset : 0;
+		return descriptorSet != nullptr;
+	}
+
+	void Device::push_descriptors(CommandList& commandList, std::uint32_t set, std::span<const DescriptorWrite> writes)
+	{
+		const auto* pipeline = commandList.get_bound_pipeline();
+		if (pipeline == nullptr)
+		{
+			s_errorCallback("GFX - Cannot push descriptors when no pipeline has been bound!");
+			return;
+		}
+		if (set >= pipeline->get_set_layouts().size())
+		{
+			s_errorCallback("GFX - push_descriptors() - The bound pipeline has no such set!");
+			return;
+		}
+		if (writes.size() > MAX_PUSH_DESCRIPTORS)
+		{
+			s_errorCallback("GFX - Cannot push more than MAX_PUSH_DESCRIPTORS descriptors at once!");
+			return;
+		}
+
+		// Looked up once rather than copied, layouts are never erased so the entry outlives the lock.
+		const std::vector<vk::DescriptorType>* bindingTypes{ nullptr };
+		{
+			const auto layoutKey = get_resource_key(pipeline->get_set_layout(set));
+			std::lock_guard lock(m_descriptorSetLayoutMutex);
+			if (m_pushDescriptorSetLayouts.contains(layoutKey))
+			{
+				bindingTypes = &m_descriptorSetLayoutBindingTypes.at(layoutKey);
+			}
+		}
+		if (bindingTypes == nullptr)
+		{
+			s_errorCallback("GFX - push_descriptors() - The set was not declared with DescriptorSetInfo::push!");
+			return;
+		}
+
+		InlineVector<ResolvedDescriptor, MAX_PUSH_DESCRIPTORS> descriptors{};
+		for (const auto& write : writes)
+		{
+			if (write.binding >= bindingTypes->size())
+			{
+				s_errorCallback("GFX - push_descriptors() - The set has no such binding!");
+				return;
+			}
+
+			ResolvedDescriptor descriptor{};
+			if (!resolve_descriptor_write(descriptor, write, (*bindingTypes)[write.binding]))
+			{
+				return;
+			}
+			descriptors.push_back(descriptor);
+		}
+
+		commandList.push_descriptors(set, descriptors);
+	}
+
+	void Device::bind_descriptor_buffer_sets(CommandList& commandList, std::uint32_t firstSet, std::span<const DescriptorSetHandle> descriptorSets, std::span<const std::uint32_t> dynamicOffsets)
+	{
+		if (!dynamicOffsets.empty())
+		{
+			s_errorCallback("GFX - Dynamic offsets are not available with descriptor buffers!");
+			return;
+		}
+
+		InlineVector<vk::DeviceSize, MAX_BOUND_DESCRIPTOR_SETS> offsets{};
+		offsets.resize(descriptorSets.size());
+		for (auto i = 0; i < descriptorSets.size(); ++i)
+		{
+			if (!get_descriptor_buffer_offset(offsets[i], descriptorSets[i]))
+			{
+				return;
+			}
+		}
+
+		commandList.set_descriptor_buffer_offsets(firstSet, offsets, m_descriptorBuffer->get_binding_info());
+	}
+
+	auto Device::get_descriptor_set_layout_binding_types(vk::DescriptorSetLayout descriptorSetLayout) -> std::vector<vk::DescriptorType>
+	{
+		std::lock_guard lock(m_descriptorSetLayoutMutex);
+		const auto it = m_descriptorSetLayoutBindingTypes.find(get_resource_key(descriptorSetLayout));
+		return it != m_descriptorSetLayoutBindingTypes.end() ? it->second : std::vector<vk::DescriptorType>{};
+	}
+
+	void Device::bind_buffer_to_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t range)
+	{
+		const DescriptorWrite write{ .binding = binding, .bufferHandle = bufferHandle, .offset = offset, .range = range };
+		update_descriptor_set(descriptorSetHandle, { &write, 1 });
+	}
+
+	void Device::bind_texture_to_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, TextureHandle textureHandle, SamplerHandle samplerHandle, std::uint32_t viewIndex)
+	{
+		const DescriptorWrite write{ .binding = binding, .textureHandle = textureHandle, .viewIndex = viewIndex, .samplerHandle = samplerHandle };
+		update_descriptor_set(descriptorSetHandle, { &write, 1 });
+	}
+
+	void Device::update_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::span<const DescriptorWrite> writes)
+	{
+		auto* descriptorSetPtr = m_descriptorSetPool.get_checked(descriptorSetHandle.resourceHandle);
+		if (descriptorSetPtr == nullptr)
+		{
+			s_errorCallback("GFX - Cannot update unknown descriptor set!");
+			return;
+		}
+
+		const ScratchScope scratchScope{};
+		const auto& bindingTypes = descriptorSetPtr->bindingTypes;
+		ScratchVector<ResolvedDescriptor> descriptors(writes.size());
+		ScratchVector<bool> writtenBindings(bindingTypes.size(), false);
+		bool coversEveryBinding = writes.size() == bindingTypes.size();
+		for (std::size_t i = 0; i < writes.size(); ++i)
+		{
+			const auto& write = writes[i];
+			if (write.binding >= bindingTypes.size())
+			{
+				s_errorCallback("GFX - Cannot update descriptor set, the set has no such binding!");
+				return;
+			}
+			if (!resolve_descriptor_write(descriptors[i], write, bindingTypes[write.binding]))
+			{
+				return;
+			}
+			coversEveryBinding = coversEveryBinding && write.arrayElement == 0 && !writtenBindings[write.binding];
+			writtenBindings[write.binding] = true;
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.descriptorWrites, writes.size());
+
+		if (m_descriptorBuffer)
+		{
+			for (const auto& descriptor : descriptors)
+			{
+				const vk::DescriptorAddressInfoEXT address_info{ descriptor.address, descriptor.bufferInfo.range };
+				vk::DescriptorGetInfoEXT descriptor_info{};
+				descriptor_info.setType(descriptor.type);
+				if (descriptor.type == vk::DescriptorType::eCombinedImageSampler)
+				{
+					descriptor_info.data.setPCombinedImageSampler(&descriptor.imageInfo);
+				}
+				else if (descriptor.type == vk::DescriptorType::eInputAttachment)
+				{
+					descriptor_info.data.setPInputAttachmentImage(&descriptor.imageInfo);
+				}
+				else if (descriptor.type == vk::DescriptorType::eStorageImage)
+				{
+					descriptor_info.data.setPStorageImage(&descriptor.imageInfo);
+				}
+				else if (descriptor.type == vk::DescriptorType::eUniformBuffer)
+				{
+					descriptor_info.data.setPUniformBuffer(&address_info);
+				}
+				else
+				{
+					descriptor_info.data.setPStorageBuffer(&address_info);
+				}
+				m_descriptorBuffer->write(descriptorSetPtr->descriptorBufferOffset, descriptorSetPtr->layout, descriptor.binding, descriptor.arrayElement, descriptor_info);
+			}
+		}
+		else if (!descriptors.empty())
+		{
+			invalidate_bundles(get_resource_key(descriptorSetPtr->set));
+			if (const auto updateTemplate = coversEveryBinding ? get_descriptor_update_template(descriptorSetPtr->layout) : vk::DescriptorUpdateTemplate{})
+			{
+				// The template reads one record per binding, in binding order.
+				ScratchVector<ResolvedDescriptor> records(descriptors.size());
+				for (const auto& descriptor : descriptors)
+				{
+					records[descriptor.binding] = descriptor;
+				}
+				m_device->updateDescriptorSetWithTemplate(descriptorSetPtr->set, updateTemplate, records.data());
+			}
+			else
+			{
+				ScratchVector<vk::WriteDescriptorSet> vk_writes(descriptors.size());
+				for (std::size_t i = 0; i < descriptors.size(); ++i)
+				{
+					const auto& descriptor = descriptors[i];
+					vk_writes[i].setDstSet(descriptorSetPtr->set);
+					vk_writes[i].setDstBinding(descriptor.binding);
+					vk_writes[i].setDstArrayElement(descriptor.arrayElement);
+					vk_writes[i].setDescriptorCount(1);
+					vk_writes[i].setDescriptorType(descriptor.type);
+					if (is_image_descriptor_type(descriptor.type))
+					{
+						vk_writes[i].setPImageInfo(&descriptor.imageInfo);
+					}
+					else
+					{
+						vk_writes[i].setPBufferInfo(&descriptor.bufferInfo);
+					}
+				}
+				m_device->updateDescriptorSets(vk_writes, {});
+			}
+		}
+
+		std::lock_guard lock(m_descriptorBindingMutex);
+		for (std::size_t i = 0; i < writes.size(); ++i)
+		{
+			const auto& write = writes[i];
+			const auto key = std::uint64_t(CAST_HANDLE_TO_INT(descriptorSetHandle.resourceHandle)) << 32u | std::uint64_t(write.binding) << 16u | write.arrayElement;
+			m_descriptorBindings[key] = { .descriptorSetHandle = descriptorSetHandle, .isTexture = is_image_descriptor_type(descriptors[i].type), .write = write };
+		}
+	}
+
+	void Device::write_inline_uniform_block(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, std::uint32_t offset, std::uint32_t size, const void* data)
+	{
+		const auto* descriptorSetPtr = m_descriptorSetPool.get_checked(descriptorSetHandle.resourceHandle);
+		if (descriptorSetPtr == nullptr)
+		{
+			s_errorCallback("GFX - Cannot write inline uniform block of unknown descriptor set!");
+			return;
+		}
+		if (binding >= descriptorSetPtr->bindingTypes.size() || descriptorSetPtr->bindingTypes[binding] != vk::DescriptorType::eInlineUniformBlock)
+		{
+			s_errorCallback("GFX - write_inline_uniform_block() - The set has no such inline uniform block binding!");
+			return;
+		}
+		std::uint32_t blockSize{ 0 };
+		{
+			std::lock_guard lock(m_descriptorSetLayoutMutex);
+			blockSize = m_descriptorSetLayoutBindingCounts.at(get_resource_key(descriptorSetPtr->layout))[binding];
+		}
+		if (size == 0 || offset % 4 != 0 || size % 4 != 0 || std::uint64_t(offset) + size > blockSize)
+		{
+			s_errorCallback("GFX - write_inline_uniform_block() - Offset and size must be multiples of 4 within the block!");
+			return;
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.descriptorWrites, 1);
+
+		// Stored in the set, so there is nothing to rebind when resources move.
+		if (m_descriptorBuffer)
+		{
+			m_descriptorBuffer->write_inline(descriptorSetPtr->descriptorBufferOffset, descriptorSetPtr->layout, binding, offset, size, data);
+			return;
+		}
+		invalidate_bundles(get_resource_key(descriptorSetPtr->set));
+		const vk::WriteDescriptorSetInlineUniformBlock inline_write{ size, data };
+		vk::WriteDescriptorSet vk_write{};
+		vk_write.setDstSet(descriptorSetPtr->set);
+		vk_write.setDstBinding(binding);
+		vk_write.setDstArrayElement(offset);
+		vk_write.setDescriptorCount(size);
+		vk_write.setDescriptorType(vk::DescriptorType::eInlineUniformBlock);
+		vk_write.setPNext(&inline_write);
+		m_device->updateDescriptorSets(vk_write, {});
+	}
+
+	bool Device::resolve_descriptor_write(ResolvedDescriptor& outDescriptor, const DescriptorWrite& write, vk::DescriptorType descriptorType)
+	{
+		outDescriptor = ResolvedDescriptor{ .binding = write.binding, .arrayElement = write.arrayElement, .type = descriptorType };
+		if (descriptorType == vk::DescriptorType::eInlineUniformBlock)
+		{
+			s_errorCallback("GFX - Inline uniform blocks are written with write_inline_uniform_block(), not bound to resources!");
+			return false;
+		}
+		if (is_image_descriptor_type(descriptorType))
+		{
+			const auto* texture = m_texturePool.get_checked(write.textureHandle.resourceHandle);
+			if (texture == nullptr)
+			{
+				s_errorCallback("GFX - Cannot write unknown texture to descriptor!");
+				return false;
+			}
+			if (write.viewIndex >= texture->get_view_count())
+			{
+				s_errorCallback("GFX - Cannot write unknown texture view to descriptor!");
+				return false;
+			}
+			// Read in place by the pass rendering to it, so without a sampler and in the pass's layout.
+			if (descriptorType == vk::DescriptorType::eInputAttachment)
+			{
+				outDescriptor.imageInfo = vk::DescriptorImageInfo{ {}, texture->get_view(write.viewIndex), vk::ImageLayout::eRenderingLocalReadKHR };
+				return true;
+			}
+			// Read and written without a sampler, in TextureState::eStorage. Storage views cannot span mip levels.
+			if (descriptorType == vk::DescriptorType::eStorageImage)
+			{
+				if (!(texture->get_usage_flags() & vk::ImageUsageFlagBits::eStorage))
+				{
+					s_errorCallback("GFX - Cannot write texture to storage texture descriptor, it is not a TextureUsage::eStorage texture!");
+					return false;
+				}
+				if (texture->get_view_range(write.viewIndex).levelCount != 1)
+				{
+					s_errorCallback("GFX - Cannot write texture view to storage texture descriptor, it must be a single mip level!");
+					return false;
+				}
+				outDescriptor.imageInfo = vk::DescriptorImageInfo{ {}, texture->get_view(write.viewIndex), vk::ImageLayout::eGeneral };
+				return true;
+			}
+			const auto* sampler = m_samplerPool.get_checked(write.samplerHandle.resourceHandle);
+			if (sampler == nullptr)
+			{
+				s_errorCallback("GFX - Cannot write unknown sampler to descriptor!");
+				return false;
+			}
+			outDescriptor.imageInfo = vk::DescriptorImageInfo{ sampler->get(), texture->get_view(write.viewIndex), vk::ImageLayout::eShaderReadOnlyOptimal };
+			return true;
+		}
+
+		const auto* buffer = m_bufferPool.get_checked(write.bufferHandle.resourceHandle);
+		if (buffer == nullptr)
+		{
+			s_errorCallback("GFX - Cannot write unknown buffer to descriptor!");
+			return false;
+		}
+
+		// Written as the type the layout declares so a buffer can back both plain and dynamic descriptors.
+		const bool isUniform = descriptorType == vk::DescriptorType::eUniformBuffer || descriptorType == vk::DescriptorType::eUniformBufferDynamic;
+		const auto requiredUsage = isUniform ? vk::BufferUsageFlagBits::eUniformBuffer : vk::BufferUsageFlagBits::eStorageBuffer;
+		if (!(buffer->get_usage_flags() & requiredUsage))
+		{
+			s_errorCallback("GFX - Cannot write buffer to descriptor, buffer usage does not match the binding's descriptor type!");
+			return false;
+		}
+
+		outDescriptor.bufferInfo = vk::DescriptorBufferInfo{ buffer->get_buffer(), write.offset, write.range == WHOLE_SIZE ? buffer->get_size() - write.offset : write.range };
+		outDescriptor.address = buffer->get_device_address() != 0 ? buffer->get_device_address() + write.offset : 0;
+		return true;
+	}
+
+	auto Device::get_descriptor_update_template(vk::DescriptorSetLayout descriptorSetLayout) -> vk::DescriptorUpdateTemplate
+	{
+		const auto layoutKey = get_resource_key(descriptorSetLayout);
+		std::lock_guard lock(m_descriptorSetLayoutMutex);
+		if (const auto it = m_descriptorUpdateTemplates.find(layoutKey); it != m_descriptorUpdateTemplates.end())
+		{
+			return it->second.get();
+		}
+
+		const auto typesIt = m_descriptorSetLayoutBindingTypes.find(layoutKey);
+		if (typesIt == m_descriptorSetLayoutBindingTypes.end() || typesIt->second.empty())
+		{
+			return {};
+		}
+
+		std::vector<vk::DescriptorUpdateTemplateEntry> entries(typesIt->second.size());
+		for (std::uint32_t binding = 0; binding < entries.size(); ++binding)
+		{
+			const auto type = typesIt->second[binding];
+			const auto infoOffset = is_image_descriptor_type(type) ? offsetof(ResolvedDescriptor, imageInfo) : offsetof(ResolvedDescriptor, bufferInfo);
+			entries[binding] = vk::DescriptorUpdateTemplateEntry{ binding, 0, 1, type, binding * sizeof(ResolvedDescriptor) + infoOffset, sizeof(ResolvedDescriptor) };
+		}
+
+		vk::DescriptorUpdateTemplateCreateInfo template_info{};
+		template_info.setDescriptorUpdateEntries(entries);
+		template_info.setTemplateType(vk::DescriptorUpdateTemplateType::eDescriptorSet);
+		template_info.setDescriptorSetLayout(descriptorSetLayout);
+		auto updateTemplate = m_device->createDescriptorUpdateTemplateUnique(template_info).value;
+		const auto handle = updateTemplate.get();
+		m_descriptorUpdateTemplates.emplace(layoutKey, std::move(updateTemplate));
+		return handle;
+	}
+
+	auto Device::get_bindless_index(std::uint32_t binding, ResourceHandle resourceHandle) -> std::uint32_t
+	{
+		return m_bindlessHeap ? m_bindlessHeap->get_index(binding, resourceHandle) : INVALID_BINDLESS_INDEX;
+	}
+
+	bool Device::create_buffer(BufferHandle& outBufferHandle, const BufferInfo& bufferInfo)
+	{
+		if (!validate_buffer_info(bufferInfo))
+		{
+			return false;
+		}
+
+		const auto resourceHandle = m_bufferPool.emplace(m_device.get(), m_allocator.get(), get_device_buffer_info(bufferInfo));
+		if (CAST_HANDLE_TO_INT(resourceHandle) == 0)
+		{
+			return false;
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+		register_allocation(m_bufferPool.get(resourceHandle)->get_allocation(), resourceHandle, false);
+		if (const auto* buffer = m_bufferPool.get(resourceHandle); m_bindlessHeap && (buffer->get_usage_flags() & vk::BufferUsageFlagBits::eStorageBuffer))
+		{
+			m_bindlessHeap->write_buffer(resourceHandle, buffer->get_buffer(), buffer->get_size(), buffer->get_device_address());
+		}
+		outBufferHandle = BufferHandle(m_deviceHandle, resourceHandle);
+		return true;
+	}
+
+	bool Device::create_buffers(std::span<BufferHandle> outBufferHandles, std::span<const BufferInfo> bufferInfos)
+	{
+		if (outBufferHandles.size() < bufferInfos.size())
+		{
+			s_errorCallback("GFX - create_buffers() - outBufferHandles is smaller than bufferInfos!");
+			return false;
+		}
+
+		if (!std::ranges::all_of(bufferInfos, [this](const BufferInfo& bufferInfo) { return validate_buffer_info(bufferInfo); }))
+		{
+			return false;
+		}
+
+		m_bufferPool.reserve(std::uint32_t(bufferInfos.size()));
+		for (auto i = 0; i < bufferInfos.size(); ++i)
+		{
+			const auto resourceHandle = m_bufferPool.emplace(m_device.get(), m_allocator.get(), get_device_buffer_info(bufferInfos[i]));
+			if (CAST_HANDLE_TO_INT(resourceHandle) == 0)
+			{
+				for (auto j = 0; j < i; ++j)
+				{
+					destroy_buffer(outBufferHandles[j]);
+				}
+				return false;
+			}
+			GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+			register_allocation(m_bufferPool.get(resourceHandle)->get_allocation(), resourceHandle, false);
+			if (const auto* buffer = m_bufferPool.get(resourceHandle); m_bindlessHeap && (buffer->get_usage_flags() & vk::BufferUsageFlagBits::eStorageBuffer))
+			{
+				m_bindlessHeap->write_buffer(resourceHandle, buffer->get_buffer(), buffer->get_size(), buffer->get_device_address());
+			}
+			outBufferHandles[i] = BufferHandle(m_deviceHandle, resourceHandle);
+		}
+		return true;
+	}
+
+	void Device::destroy_buffer(BufferHandle bufferHandle)
+	{
+		evict_cached_descriptor_sets([&](const DescriptorWrite& write) { return write.bufferHandle == bufferHandle; });
+		std::function<void()> destroyFunc = [this, resourceHandle = bufferHandle.resourceHandle] {
+			if (const auto* buffer = m_bufferPool.get_checked(resourceHandle); buffer != nullptr)
+			{
+				unregister_allocation(buffer->get_allocation(), false);
+			}
+			if (m_bindlessHeap)
+			{
+				m_bindlessHeap->remove(BINDLESS_STORAGE_BUFFER_BINDING, resourceHandle);
+			}
+			m_bufferPool.erase(resourceHandle);
+		};
+		if (const auto* buffer = m_bufferPool.get_checked(bufferHandle.resourceHandle); buffer != nullptr)
+		{
+			invalidate_bundles(get_resource_key(buffer->get_buffer()));
+			invalidate_descriptor_set_bundles(bufferHandle.resourceHandle, false);
+			// VMA still owns both ends of a buffer that is being moved, so it has to outlive the pass.
+			if (m_defragmenter && m_defragmenter->postpone_destroy(buffer->get_allocation(), destroyFunc))
+			{
+				return;
+			}
+		}
+		defer_destroy(std::move(destroyFunc));
+	}
+
+	bool Device::get_buffer(Buffer*& outBuffer, BufferHandle bufferHandle)
+	{
+		outBuffer = m_bufferPool.get_checked(bufferHandle.resourceHandle);
+		return outBuffer != nullptr;
+	}
+
+	bool Device::create_buffer_arena(BufferArenaHandle& outBufferArenaHandle, const BufferArenaInfo& bufferArenaInfo)
+	{
+		if (bufferArenaInfo.blockSize == 0)
+		{
+			s_errorCallback("GFX - BufferArenaInfo::blockSize must not be 0!");
+			return false;
+		}
+		outBufferArenaHandle = BufferArenaHandle(m_deviceHandle, m_bufferArenaPool.emplace(*this, bufferArenaInfo));
+		if (CAST_HANDLE_TO_INT(outBufferArenaHandle.resourceHandle) == 0)
+		{
+			return false;
+		}
+		return true;
+	}
+
+	void Device::destroy_buffer_arena(BufferArenaHandle bufferArenaHandle)
+	{
+		auto* bufferArena = m_bufferArenaPool.get_checked(bufferArenaHandle.resourceHandle);
+		if (bufferArena == nullptr)
+		{
+			return;
+		}
+		for (const auto bufferHandle : bufferArena->get_buffers())
+		{
+			destroy_buffer(bufferHandle);
+		}
+		// Only CPU-side bookkeeping is left, which nothing on the GPU refers to.
+		m_bufferArenaPool.erase(bufferArenaHandle.resourceHandle);
+	}
+
+	bool Device::get_buffer_arena(BufferArena*& outBufferArena, BufferArenaHandle bufferArenaHandle)
+	{
+		outBufferArena = m_bufferArenaPool.get_checked(bufferArenaHandle.resourceHandle);
+		return outBufferArena != nullptr;
+	}
+
+	bool Device::create_memory_heap(MemoryHeapHandle& outMemoryHeapHandle, const MemoryHeapInfo& memoryHeapInfo)
+	{
+		if (memoryHeapInfo.size == 0)
+		{
+			s_errorCallback("GFX - create_memory_heap() - MemoryHeapInfo::size must not be 0!");
+			return false;
+		}
+
+		// Automatic memory usages need a whole resource to pick a type for, so ask for the properties directly.
+		VmaAllocationCreateInfo alloc_info{};
+		alloc_info.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+		switch (memoryHeapInfo.type)
+		{
+			case MemoryHeapType::eUpload:
+				// Coherent, so placed buffers need no flushes, which would have to go through the heap's allocation.
+				alloc_info.flags |= VMA_ALLOCATION_CREATE_MAPPED_BIT;
+				alloc_info.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+				break;
+			case MemoryHeapType::eReadback:
+				alloc_info.flags |= VMA_ALLOCATION_CREATE_MAPPED_BIT;
+				alloc_info.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+				alloc_info.preferredFlags = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+				break;
+			case MemoryHeapType::eDeviceLocal:
+			default:
+				alloc_info.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+				break;
+		}
+		alloc_info.priority = std::clamp(memoryHeapInfo.memoryPriority, 0.0f, 1.0f);
+
+		const auto allocator = static_cast<VmaAllocator>(m_allocator.get());
+		std::uint32_t memoryTypeIndex{ 0 };
+		if (vmaFindMemoryTypeIndex(allocator, ~0u, &alloc_info, &memoryTypeIndex) != VK_SUCCESS)
+		{
+			s_errorCallback("GFX - create_memory_heap() - No memory type suits the heap type!");
+			return false;
+		}
+		const VkMemoryRequirements heap_requirements{ memoryHeapInfo.size, 1, 1u << memoryTypeIndex };
+		VmaAllocation allocation{ nullptr };
+		if (vmaAllocateMemory(allocator, &heap_requirements, &alloc_info, &allocation, nullptr) != VK_SUCCESS)
+		{
+			s_errorCallback("GFX - create_memory_heap() - Failed to allocate memory for the heap!");
+			return false;
+		}
+		auto memory = std::make_shared<AliasedMemory>(m_allocator.get(), vma::Allocation(allocation));
+		const auto allocationName = "Memory heap" + (memoryHeapInfo.debugName.empty() ? "" : " " + memoryHeapInfo.debugName);
+		m_allocator->setAllocationName(memory->get_allocation(), allocationName.c_str());
+
+		VmaVirtualBlockCreateInfo block_info{};
+		block_info.size = memoryHeapInfo.size;
+		VmaVirtualBlock virtualBlock{ VK_NULL_HANDLE };
+		if (vmaCreateVirtualBlock(&block_info, &virtualBlock) != VK_SUCCESS)
+		{
+			s_errorCallback("GFX - create_memory_heap() - Failed to create the heap's virtual block!");
+			return false;
+		}
+		outMemoryHeapHandle = MemoryHeapHandle(m_deviceHandle, m_memoryHeapPool.emplace(std::move(memory), memoryTypeIndex, virtualBlock, memoryHeapInfo));
+		if (CAST_HANDLE_TO_INT(outMemoryHeapHandle.resourceHandle) == 0)
+		{
+			vmaDestroyVirtualBlock(virtualBlock);
+			return false;
+		}
+		return true;
+	}
+
+	void Device::destroy_memory_heap(MemoryHeapHandle memoryHeapHandle)
+	{
+		// Resources still placed in the heap, or waiting on the GPU to be destroyed, hold on to its memory.
+		m_memoryHeapPool.erase(memoryHeapHandle.resourceHandle);
+	}
+
+	bool Device::get_memory_heap(MemoryHeap*& outMemoryHeap, MemoryHeapHandle memoryHeapHandle)
+	{
+		outMemoryHeap = m_memoryHeapPool.get_checked(memoryHeapHandle.resourceHandle);
+		if (outMemoryHeap == nullptr)
+		{
+			s_errorCallback("GFX - Invalid memory heap handle!");
+			return false;
+		}
+		return true;
+	}
+
+	bool Device::get_placement_requirements(PlacementRequirements& outRequirements, const BufferInfo& bufferInfo)
+	{
+		if (bufferInfo.sparse)
+		{
+			s_errorCallback("GFX - get_placement_requirements() - Sparse buffers cannot be placed!");
+			return false;
+		}
+		// An unbound buffer describes exactly what the placed one would need.
+		const Buffer buffer(m_device.get(), m_allocator.get(), get_device_buffer_info(bufferInfo), true);
+		const auto requirements = m_device->getBufferMemoryRequirements(buffer.get_buffer());
+		outRequirements = { requirements.size, requirements.alignment };
+		return true;
+	}
+
+	bool Device::get_placement_requirements(PlacementRequirements& outRequirements, const TextureInfo& textureInfo)
+	{
+		if (!validate_texture_info(textureInfo))
+		{
+			return false;
+		}
+		if (textureInfo.sparse)
+		{
+			s_errorCallback("GFX - get_placement_requirements() - Sparse textures cannot be placed!");
+			return false;
+		}
+		const Texture texture(*this, textureInfo, true);
+		const auto requirements = m_device->getImageMemoryRequirements(texture.get_image());
+		outRequirements = { requirements.size, requirements.alignment };
+		return true;
+	}
+
+	bool Device::create_buffer_placed(BufferHandle& outBufferHandle, MemoryHeapHandle memoryHeapHandle, std::uint64_t offset, const BufferInfo& bufferInfo)
+	{
+		MemoryHeap* memoryHeap{ nullptr };
+		if (!get_memory_heap(memoryHeap, memoryHeapHandle))
+		{
+			return false;
+		}
+		if (bufferInfo.sparse)
+		{
+			s_errorCallback("GFX - create_buffer_placed() - Sparse buffers cannot be placed!");
+			return false;
+		}
+		if (!validate_buffer_info(bufferInfo))
+		{
+			return false;
+		}
+
+		// Where the heap lives decides how the buffer is reached.
+		auto deviceBufferInfo = get_device_buffer_info(bufferInfo);
+		deviceBufferInfo.memory = memoryHeap->get_type() == MemoryHeapType::eUpload	   ? BufferMemory::eUpload
+								  : memoryHeap->get_type() == MemoryHeapType::eReadback ? BufferMemory::eReadback
+																						 : BufferMemory::eGpuOnly;
+		Buffer buffer(m_device.get(), m_allocator.get(), deviceBufferInfo, true);
+		if (!memoryHeap->can_place(m_device->getBufferMemoryRequirements(buffer.get_buffer()), offset))
+		{
+			return false;
+		}
+		if (!buffer.bind_aliased_memory(memoryHeap->get_memory(), offset))
+		{
+			s_errorCallback("GFX - create_buffer_placed() - Failed to bind the buffer to the heap's memory!");
+			return false;
+		}
+
+		const auto resourceHandle = m_bufferPool.emplace(std::move(buffer));
+		if (CAST_HANDLE_TO_INT(resourceHandle) == 0)
+		{
+			return false;
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+		if (const auto* placedBuffer = m_bufferPool.get(resourceHandle); m_bindlessHeap && (placedBuffer->get_usage_flags() & vk::BufferUsageFlagBits::eStorageBuffer))
+		{
+			m_bindlessHeap->write_buffer(resourceHandle, placedBuffer->get_buffer(), placedBuffer->get_size(), placedBuffer->get_device_address());
+		}
+		outBufferHandle = BufferHandle(m_deviceHandle, resourceHandle);
+		return true;
+	}
+
+	bool Device::create_texture_placed(TextureHandle& outTextureHandle, MemoryHeapHandle memoryHeapHandle, std::uint64_t offset, const TextureInfo& textureInfo)
+	{
+		MemoryHeap* memoryHeap{ nullptr };
+		if (!get_memory_heap(memoryHeap, memoryHeapHandle))
+		{
+			return false;
+		}
+		if (!validate_texture_info(textureInfo))
+		{
+			return false;
+		}
+		if (textureInfo.sparse || memoryHeap->get_type() != MemoryHeapType::eDeviceLocal)
+		{
+			s_errorCallback("GFX - create_texture_placed() - Placed textures must not be sparse, and need a device local heap!");
+			return false;
+		}
+
+		Texture texture(*this, textureInfo, true);
+		if (!memoryHeap->can_place(m_device->getImageMemoryRequirements(texture.get_image()), offset))
+		{
+			return false;
+		}
+		if (!texture.bind_aliased_memory(memoryHeap->get_memory(), offset))
+		{
+			s_errorCallback("GFX - create_texture_placed() - Failed to bind the texture to the heap's memory!");
+			return false;
+		}
+
+		const auto resourceHandle = m_texturePool.emplace(std::move(texture));
+		if (CAST_HANDLE_TO_INT(resourceHandle) == 0)
+		{
+			return false;
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+		if (m_bindlessHeap && (textureInfo.usage == TextureUsage::eTexture || textureInfo.usage == TextureUsage::eStorage))
+		{
+			m_bindlessHeap->write_texture(resourceHandle, m_texturePool.get(resourceHandle)->get_view());
+		}
+		outTextureHandle = TextureHandle(m_deviceHandle, resourceHandle);
+		return true;
+	}
+
+	bool Device::create_buffer_external(BufferHandle& outBufferHandle, const BufferInfo& bufferInfo, const ExternalMemory* importedMemory)
+	{
+		if (!supports_external_memory())
+		{
+			s_errorCallback("GFX - External buffers need DeviceFeatureFlags_ExternalMemory!");
+			return false;
+		}
+		if (bufferInfo.sparse)
+		{
+			s_errorCallback("GFX - External buffers cannot be sparse!");
+			return false;
+		}
+		if (!validate_buffer_info(bufferInfo))
+		{
+			return false;
+		}
+
+		// Device local, as the memory is allocated outside VMA, with the whole of it dedicated to the buffer.
+		auto deviceBufferInfo = get_device_buffer_info(bufferInfo);
+		deviceBufferInfo.memory = BufferMemory::eGpuOnly;
+		Buffer buffer(m_device.get(), m_allocator.get(), deviceBufferInfo, true, EXTERNAL_MEMORY_HANDLE_TYPE);
+		auto memory = allocate_external_memory(buffer.get_buffer(), {}, m_device->getBufferMemoryRequirements(buffer.get_buffer()), importedMemory);
+		if (memory == nullptr)
+		{
+			return false;
+		}
+		if (!buffer.bind_aliased_memory(std::move(memory), 0))
+		{
+			s_errorCallback("GFX - Failed to bind an external buffer's memory!");
+			return false;
+		}
+
+		const auto resourceHandle = m_bufferPool.emplace(std::move(buffer));
+		if (CAST_HANDLE_TO_INT(resourceHandle) == 0)
+		{
+			return false;
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+		if (const auto* externalBuffer = m_bufferPool.get(resourceHandle); m_bindlessHeap && (externalBuffer->get_usage_flags() & vk::BufferUsageFlagBits::eStorageBuffer))
+		{
+			m_bindlessHeap->write_buffer(resourceHandle, externalBuffer->get_buffer(), externalBuffer->get_size(), externalBuffer->get_device_address());
+		}
+		outBufferHandle = BufferHandle(m_deviceHandle, resourceHandle);
+		return true;
+	}
+
+	bool Device::create_texture_external(TextureHandle& outTextureHandle, const TextureInfo& textureInfo, const ExternalMemory* importedMemory)
+	{
+		if (!supports_external_memory())
+		{
+			s_errorCallback("GFX - External textures need DeviceFeatureFlags_ExternalMemory!");
+			return false;
+		}
+		if (!validate_texture_info(textureInfo))
+		{
+			return false;
+		}
+		if (textureInfo.sparse || textureInfo.memory == TextureMemory::eTransient)
+		{
+			s_errorCallback("GFX - External textures cannot be sparse or transient!");
+			return false;
+		}
+
+		Texture texture(*this, textureInfo, true, EXTERNAL_MEMORY_HANDLE_TYPE);
+		auto memory = allocate_external_memory({}, texture.get_image(), m_device->getImageMemoryRequirements(texture.get_image()), importedMemory);
+		if (memory == nullptr)
+		{
+			return false;
+		}
+		if (!texture.bind_aliased_memory(std::move(memory), 0))
+		{
+			s_errorCallback("GFX - Failed to bind an external texture's memory!");
+			return false;
+		}
+
+		const auto resourceHandle = m_texturePool.emplace(std::move(texture));
+		if (CAST_HANDLE_TO_INT(resourceHandle) == 0)
+		{
+			return false;
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+		if (m_bindlessHeap && (textureInfo.usage == TextureUsage::eTexture || textureInfo.usage == TextureUsage::eStorage))
+		{
+			m_bindlessHeap->write_texture(resourceHandle, m_texturePool.get(resourceHandle)->get_view());
+		}
+		outTextureHandle = TextureHandle(m_deviceHandle, resourceHandle);
+		return true;
+	}
+
+	auto Device::allocate_external_memory(vk::Buffer buffer, vk::Image image, const vk::MemoryRequirements& requirements, const ExternalMemory* importedMemory) -> std::shared_ptr<AliasedMemory>
+	{
+		// Dedicated, which some drivers require of exported images, and which the importer then has to match.
+		vk::MemoryDedicatedAllocateInfo dedicated_info{ image, buffer };
+		vk::MemoryAllocateInfo alloc_info{};
+#if _WIN32
+		vk::ImportMemoryWin32HandleInfoKHR import_info{ EXTERNAL_MEMORY_HANDLE_TYPE, importedMemory != nullptr ? importedMemory->handle : nullptr, nullptr, &dedicated_info };
+#else
+		vk::ImportMemoryFdInfoKHR import_info{ EXTERNAL_MEMORY_HANDLE_TYPE, importedMemory != nullptr ? importedMemory->handle : -1, &dedicated_info };
+#endif
+		vk::ExportMemoryAllocateInfo export_info{ EXTERNAL_MEMORY_HANDLE_TYPE, &dedicated_info };
+		if (importedMemory != nullptr)
+		{
+			// Opaque handles are imported with the size and memory type they were exported with.
+			if (importedMemory->handle == INVALID_EXTERNAL_HANDLE || importedMemory->size < requirements.size ||
+				importedMemory->memoryTypeIndex >= 32 || !(requirements.memoryTypeBits & (1u << importedMemory->memoryTypeIndex)))
+			{
+				s_errorCallback("GFX - Imported memory is invalid, too small, or of a memory type the resource cannot use!");
+				return nullptr;
+			}
+			alloc_info = vk::MemoryAllocateInfo{ importedMemory->size, importedMemory->memoryTypeIndex, &import_info };
+		}
+		else
+		{
+			VmaAllocationCreateInfo memory_type_info{};
+			memory_type_info.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			std::uint32_t memoryTypeIndex{ 0 };
+			if (vmaFindMemoryTypeIndex(static_cast<VmaAllocator>(m_allocator.get()), requirements.memoryTypeBits, &memory_type_info, &memoryTypeIndex) != VK_SUCCESS)
+			{
+				s_errorCallback("GFX - No device local memory type suits the exportable resource!");
+				return nullptr;
+			}
+			alloc_info = vk::MemoryAllocateInfo{ requirements.size, memoryTypeIndex, &export_info };
+		}
+
+		auto deviceMemory = m_device->allocateMemoryUnique(alloc_info);
+		if (deviceMemory.result != vk::Result::eSuccess)
+		{
+			s_errorCallback(importedMemory != nullptr ? "GFX - Failed to import external memory!" : "GFX - Failed to allocate exportable memory!");
+			return nullptr;
+		}
+		return std::make_shared<AliasedMemory>(std::move(deviceMemory.value), alloc_info.allocationSize, alloc_info.memoryTypeIndex, importedMemory == nullptr);
+	}
+
+	bool Device::export_memory(ExternalMemory& outMemory, const AliasedMemory* memory)
+	{
+		if (memory == nullptr || !memory->is_exportable())
+		{
+			s_errorCallback("GFX - Only resources from create_buffer_exportable() or create_texture_exportable() can be exported!");
+			return false;
+		}
+
+#if _WIN32
+		const auto handle = m_device->getMemoryWin32HandleKHR(vk::MemoryGetWin32HandleInfoKHR{ memory->get_device_memory(), EXTERNAL_MEMORY_HANDLE_TYPE });
+#else
+		const auto handle = m_device->getMemoryFdKHR(vk::MemoryGetFdInfoKHR{ memory->get_device_memory(), EXTERNAL_MEMORY_HANDLE_TYPE });
+#endif
+		if (handle.result != vk::Result::eSuccess)
+		{
+			s_errorCallback("GFX - Failed to export memory!");
+			return false;
+		}
+		outMemory = { .handle = handle.value, .size = memory->get_size(), .memoryTypeIndex = memory->get_memory_type_index() };
+		return true;
+	}
+
+	bool Device::export_buffer_memory(ExternalMemory& outMemory, BufferHandle bufferHandle)
+	{
+		const auto* buffer = m_bufferPool.get_checked(bufferHandle.resourceHandle);
+		if (buffer == nullptr)
+		{
+			s_errorCallback("GFX - export_buffer_memory() - Invalid buffer handle!");
+			return false;
+		}
+		return export_memory(outMemory, buffer->get_aliased_memory());
+	}
+
+	bool Device::export_texture_memory(ExternalMemory& outMemory, TextureHandle textureHandle)
+	{
+		const auto* texture = m_texturePool.get_checked(textureHandle.resourceHandle);
+		if (texture == nullptr)
+		{
+			s_errorCallback("GFX - export_texture_memory() - Invalid texture handle!");
+			return false;
+		}
+		return export_memory(outMemory, texture->get_aliased_memory());
+	}
+
+	bool Device::export_queue_timeline(ExternalHandle& outHandle, std::uint32_t queueIndex)
+	{
+		if (!supports_external_memory() || queueIndex >= m_queueTimelines.size())
+		{
+			s_errorCallback("GFX - export_queue_timeline() - Needs DeviceFeatureFlags_ExternalMemory and a valid queue index!");
+			return false;
+		}
+
+		const auto semaphore = m_queueTimelines[queueIndex].semaphore.get();
+#if _WIN32
+		const auto handle = m_device->getSemaphoreWin32HandleKHR(vk::SemaphoreGetWin32HandleInfoKHR{ semaphore, EXTERNAL_TIMELINE_HANDLE_TYPE });
+#else
+		const auto handle = m_device->getSemaphoreFdKHR(vk::SemaphoreGetFdInfoKHR{ semaphore, EXTERNAL_TIMELINE_HANDLE_TYPE });
+#endif
+		if (handle.result != vk::Result::eSuccess)
+		{
+			s_errorCallback("GFX - export_queue_timeline() - Failed to export the queue's timeline semaphore!");
+			return false;
+		}
+		outHandle = handle.value;
+		return true;
+	}
+
+	bool Device::import_semaphore(SemaphoreHandle& outSemaphoreHandle, ExternalHandle handle)
+	{
+		if (!supports_external_memory())
+		{
+			s_errorCallback("GFX - import_semaphore() - Needs DeviceFeatureFlags_ExternalMemory!");
+			return false;
+		}
+
+		// Imported temporarily, so the wait consumes the payload and the pooled semaphore can be recycled as usual afterwards.
+		const auto semaphoreHandle = create_semaphore();
+		auto* pooledSemaphore = m_semaphorePool.get_checked(semaphoreHandle.resourceHandle);
+		if (pooledSemaphore == nullptr)
+		{
+			return false;
+		}
+#if _WIN32
+		const vk::ImportSemaphoreWin32HandleInfoKHR import_info{ pooledSemaphore->semaphore.get(), vk::SemaphoreImportFlagBits::eTemporary, IMPORTED_SEMAPHORE_HANDLE_TYPE, handle };
+		const auto result = m_device->importSemaphoreWin32HandleKHR(import_info);
+#else
+		const vk::ImportSemaphoreFdInfoKHR import_info{ pooledSemaphore->semaphore.get(), vk::SemaphoreImportFlagBits::eTemporary, IMPORTED_SEMAPHORE_HANDLE_TYPE, handle };
+		const auto result = m_device->importSemaphoreFdKHR(import_info);
+#endif
+		if (result != vk::Result::eSuccess)
+		{
+			s_errorCallback("GFX - import_semaphore() - Failed to import the semaphore!");
+			destroy_semaphore(semaphoreHandle);
+			return false;
+		}
+		// Like a signalled one, it is not recycled unless waited on, which would leave the imported payload in the pool.
+		pooledSemaphore->signalPending.store(true, std::memory_order_relaxed);
+		outSemaphoreHandle = semaphoreHandle;
+		return true;
+	}
+
+	bool Device::create_video_decoder(VideoDecoderHandle& outVideoDecoderHandle, const VideoDecoderInfo& decoderInfo)
+	{
+		if (!supports_video_decode())
+		{
+			s_errorCallback("GFX - create_video_decoder() - Needs DeviceFeatureFlags_VideoDecode!");
+			return false;
+		}
+		if (decoderInfo.decodeQueueIndex >= m_queues.size() || decoderInfo.outputQueueIndex >= m_queues.size())
+		{
+			s_errorCallback("GFX - create_video_decoder() - Invalid decode or output queue index!");
+			return false;
+		}
+		if (!(m_physicalDevice.getQueueFamilyProperties()[m_queueFamilies[decoderInfo.decodeQueueIndex]].queueFlags & vk::QueueFlagBits::eVideoDecodeKHR))
+		{
+			s_errorCallback("GFX - create_video_decoder() - The decode queue needs to be created with QueueFlags_VideoDecode!");
+			return false;
+		}
+		if (decoderInfo.maxWidth == 0 || decoderInfo.maxHeight == 0 || decoderInfo.dpbSlotCount == 0 || decoderInfo.maxBitstreamSize == 0 || decoderInfo.framesInFlight == 0)
+		{
+			s_errorCallback("GFX - create_video_decoder() - Needs a size, DPB slots, a bitstream size and at least one frame in flight!");
+			return false;
+		}
+
+		const auto resourceHandle = m_videoDecoderPool.emplace(*this, decoderInfo);
+		if (CAST_HANDLE_TO_INT(resourceHandle) == 0)
+		{
+			return false;
+		}
+		if (!m_videoDecoderPool.get(resourceHandle)->is_valid())
+		{
+			m_videoDecoderPool.erase(resourceHandle);
+			s_errorCallback("GFX - create_video_decoder() - Failed to create the video session!");
+			return false;
+		}
+		outVideoDecoderHandle = VideoDecoderHandle(m_deviceHandle, resourceHandle);
+		return true;
+	}
+
+	void Device::destroy_video_decoder(VideoDecoderHandle videoDecoderHandle)
+	{
+		defer_destroy([this, resourceHandle = videoDecoderHandle.resourceHandle] { m_videoDecoderPool.erase(resourceHandle); });
+	}
+
+	bool Device::get_video_decoder(VideoDecoder*& outVideoDecoder, VideoDecoderHandle videoDecoderHandle)
+	{
+		outVideoDecoder = m_videoDecoderPool.get_checked(videoDecoderHandle.resourceHandle);
+		if (outVideoDecoder == nullptr)
+		{
+			s_errorCallback("GFX - Invalid video decoder handle!");
+			return false;
+		}
+		return true;
+	}
+
+	bool Device::map_buffer(BufferHandle bufferHandle, void*& outBufferPtr)
+	{
+		const auto* buffer = m_bufferPool.get_checked(bufferHandle.resourceHandle);
+		if (buffer == nullptr)
+		{
+			return false;
+		}
+
+		if (!buffer->is_host_visible())
+		{
+			s_errorCallback("GFX - map_buffer() - Buffer is not host visible, use upload_buffer() instead!");
+			return false;
+		}
+		if (buffer->get_mapped_pointer() != nullptr)
+		{
+			outBufferPtr = buffer->get_mapped_pointer();
+			return true;
+		}
+
+		outBufferPtr = m_allocator->mapMemory(buffer->get_allocation()).value;
+		return outBufferPtr != nullptr;
+	}
+
+	void Device::unmap_buffer(BufferHandle bufferHandle)
+	{
+		const auto* buffer = m_bufferPool.get_checked(bufferHandle.resourceHandle);
+		if (buffer == nullptr || buffer->get_mapped_pointer() != nullptr)
+		{
+			return;
+		}
+		m_allocator->unmapMemory(buffer->get_allocation());
+	}
+
+	auto Device::get_mapped_pointer(BufferHandle bufferHandle) -> void*
+	{
+		const auto* buffer = m_bufferPool.get_checked(bufferHandle.resourceHandle);
+		return buffer != nullptr ? buffer->get_mapped_pointer() : nullptr;
+	}
+
+	auto Device::get_buffer_device_address(BufferHandle bufferHandle) -> std::uint64_t
+	{
+		const auto* buffer = m_bufferPool.get_checked(bufferHandle.resourceHandle);
+		if (buffer == nullptr)
+		{
+			return 0;
+		}
+		if (buffer->get_device_address() == 0)
+		{
+			s_errorCallback("GFX - get_buffer_device_address() - Buffer was not created with BufferInfo::deviceAddress!");
+		}
+		return buffer->get_device_address();
+	}
+
+	void Device::flush_buffer_range(BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t size)
+	{
+		// Placed buffers have no allocation of their own, and host visible heaps are coherent.
+		const auto* buffer = m_bufferPool.get_checked(bufferHandle.resourceHandle);
+		if (buffer == nullptr || !buffer->get_allocation())
+		{
+			return;
+		}
+		// VMA skips coherent memory and rounds the range to nonCoherentAtomSize.
+		if (m_allocator->flushAllocation(buffer->get_allocation(), offset, size) != vk::Result::eSuccess)
+		{
+			s_errorCallback("GFX - flush_buffer_range() - Failed to flush buffer range!");
+		}
+	}
+
+	void Device::invalidate_buffer_range(BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t size)
+	{
+		const auto* buffer = m_bufferPool.get_checked(bufferHandle.resourceHandle);
+		if (buffer == nullptr || !buffer->get_allocation())
+		{
+			return;
+		}
+		if (m_allocator->invalidateAllocation(buffer->get_allocation(), offset, size) != vk::Result::eSuccess)
+		{
+			s_errorCallback("GFX - invalidate_buffer_range() - Failed to invalidate buffer range!");
+		}
+	}
+
+	auto Device::read_buffer(CommandList& commandList, BufferHandle srcBufferHandle, BufferHandle dstBufferHandle, const BufferCopyRegion& region) -> ReadbackHandle
+	{
+		if (commandList.is_secondary())
+		{
+			s_errorCallback("GFX - read_buffer() - Readbacks must be recorded on primary command lists!");
+			return {};
+		}
+
+		Buffer* srcBuffer{ nullptr };
+		Buffer* dstBuffer{ nullptr };
+		if (!get_buffer(srcBuffer, srcBufferHandle) || !get_buffer(dstBuffer, dstBufferHandle))
+		{
+			return {};
+		}
+		if (dstBuffer->get_memory() != BufferMemory::eReadback)
+		{
+			s_errorCallback("GFX - read_buffer() - The destination must be a BufferMemory::eReadback buffer!");
+			return {};
+		}
+		if (region.srcOffset + region.size > srcBuffer->get_size() || region.dstOffset + region.size > dstBuffer->get_size())
+		{
+			s_errorCallback("GFX - read_buffer() - Region is out of bounds!");
+			return {};
+		}
+
+		ResourceHandle resourceHandle{};
+		{
+			// Under the lock, a submission may be setting the sync points of other readbacks in the pool.
+			std::lock_guard lock(m_readbackMutex);
+			resourceHandle = m_readbackPool.emplace(Readback{ .dstBufferHandle = dstBufferHandle, .offset = region.dstOffset, .size = region.size });
+		}
+		if (CAST_HANDLE_TO_INT(resourceHandle) == 0)
+		{
+			return {};
+		}
+
+		// The source range is usually written just before, by a shader or a copy, and nothing else orders that before the read.
+		constexpr auto WRITE_STAGES = vk::PipelineStageFlagBits2::eAllCommands;
+		constexpr auto WRITE_ACCESS = vk::AccessFlagBits2::eShaderWrite | vk::AccessFlagBits2::eTransferWrite;
+		commandList.buffer_barrier(srcBuffer, WRITE_STAGES, WRITE_ACCESS, vk::PipelineStageFlagBits2::eAllTransfer, vk::AccessFlagBits2::eTransferRead, region.srcOffset, region.size);
+		commandList.copy_buffer(srcBuffer, dstBuffer, { &region, 1 });
+		commandList.add_readback(resourceHandle);
+		return ReadbackHandle(m_deviceHandle, resourceHandle);
+	}
+
+	bool Device::resolve_readback(ReadbackHandle readbackHandle, const void*& outData, std::uint64_t timeoutNs)
+	{
+		Readback readback{};
+		{
+			// Under the lock, read_buffer() may be adding to the pool.
+			std::lock_guard lock(m_readbackMutex);
+			const auto* pooledReadback = m_readbackPool.get_checked(readbackHandle.resourceHandle);
+			if (pooledReadback == nullptr)
+			{
+				s_errorCallback("GFX - resolve_readback() - Unknown readback!");
+				return false;
+			}
+			if (!pooledReadback->submitted)
+			{
+				return false;
+			}
+			readback = *pooledReadback;
+		}
+		if (!wait_on_sync_points({ &readback.syncPoint, 1 }, true, timeoutNs))
+		{
+			return false;
+		}
+
+		const auto* dstBuffer = m_bufferPool.get_checked(readback.dstBufferHandle.resourceHandle);
+		if (dstBuffer == nullptr)
+		{
+			s_errorCallback("GFX - resolve_readback() - The destination buffer was destroyed!");
+			destroy_readback(readbackHandle);
+			return false;
+		}
+		if (dstBuffer->get_allocation() && m_allocator->invalidateAllocation(dstBuffer->get_allocation(), readback.offset, readback.size) != vk::Result::eSuccess)
+		{
+			s_errorCallback("GFX - resolve_readback() - Failed to invalidate buffer range!");
+		}
+
+		outData = static_cast<const std::byte*>(dstBuffer->get_mapped_pointer()) + readback.offset;
+		destroy_readback(readbackHandle);
+		return true;
+	}
+
+	void Device::destroy_readback(ReadbackHandle readbackHandle)
+	{
+		// Under the lock, a submission may be setting its sync point.
+		std::lock_guard lock(m_readbackMutex);
+		m_readbackPool.erase(readbackHandle.resourceHandle);
+	}
+
+	bool Device::create_acceleration_structure(AccelerationStructureHandle& outAccelerationStructureHandle, const AccelerationStructureInfo& accelerationStructureInfo)
+	{
+		if (!supports_ray_query())
+		{
+			s_errorCallback("GFX - create_acceleration_structure() - Acceleration structures need DeviceFeatureFlags_RayQuery!");
+			return false;
+		}
+		const bool isTopLevel = accelerationStructureInfo.type == AccelerationStructureType::eTopLevel;
+		if (isTopLevel && accelerationStructureInfo.maxInstanceCount == 0)
+		{
+			s_errorCallback("GFX - create_acceleration_structure() - Top levels need a maxInstanceCount!");
+			return false;
+		}
+
+		// Bottom levels without geometries of their own are created by their first build.
+		ScratchVector<vk::AccelerationStructureGeometryKHR> geometries(isTopLevel ? 1 : accelerationStructureInfo.geometries.size());
+		ScratchVector<std::uint32_t> primitiveCounts(geometries.size());
+		if (isTopLevel)
+		{
+			geometries[0] = get_instance_geometry(0);
+			primitiveCounts[0] = accelerationStructureInfo.maxInstanceCount;
+		}
+		else
+		{
+			for (std::size_t i = 0; i < geometries.size(); ++i)
+			{
+				vk::AccelerationStructureBuildRangeInfoKHR range{};
+				if (!get_acceleration_structure_geometry(geometries[i], range, accelerationStructureInfo.geometries[i]))
+				{
+					return false;
+				}
+				primitiveCounts[i] = range.primitiveCount;
+			}
+		}
+
+		AccelerationStructureStorage storage{};
+		if (!geometries.empty())
+		{
+			const auto type = isTopLevel ? vk::AccelerationStructureTypeKHR::eTopLevel : vk::AccelerationStructureTypeKHR::eBottomLevel;
+			vk::AccelerationStructureBuildGeometryInfoKHR build_info{};
+			build_info.setType(type);
+			build_info.setFlags(get_acceleration_structure_build_flags(accelerationStructureInfo));
+			build_info.setGeometries(geometries);
+			const auto sizes = m_device->getAccelerationStructureBuildSizesKHR(vk::AccelerationStructureBuildTypeKHR::eDevice, build_info, primitiveCounts);
+			storage = create_acceleration_structure_storage(type, sizes.accelerationStructureSize, accelerationStructureInfo.debugName);
+			if (!storage.accelerationStructure)
+			{
+				return false;
+			}
+		}
+
+		const auto resourceHandle = m_accelerationStructurePool.emplace(accelerationStructureInfo, std::move(storage));
+		if (CAST_HANDLE_TO_INT(resourceHandle) == 0)
+		{
+			return false;
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+		if (isTopLevel)
+		{
+			std::scoped_lock lock(m_accelerationStructureMutex);
+			m_topLevelAccelerationStructures.push_back(resourceHandle);
+		}
+		outAccelerationStructureHandle = AccelerationStructureHandle(m_deviceHandle, resourceHandle);
+		return true;
+	}
+
+	void Device::destroy_acceleration_structure(AccelerationStructureHandle accelerationStructureHandle)
+	{
+		{
+			std::scoped_lock lock(m_accelerationStructureMutex);
+			auto* accelerationStructure = m_accelerationStructurePool.get_checked(accelerationStructureHandle.resourceHandle);
+			if (accelerationStructure == nullptr)
+			{
+				return;
+			}
+			std::erase(m_topLevelAccelerationStructures, accelerationStructureHandle.resourceHandle);
+			cancel_acceleration_structure_compaction(*accelerationStructure, accelerationStructureHandle.resourceHandle);
+		}
+
+		defer_destroy([this, resourceHandle = accelerationStructureHandle.resourceHandle] {
+			// Builds look up the bottom levels their top levels hold.
+			std::scoped_lock lock(m_accelerationStructureMutex);
+			m_accelerationStructurePool.erase(resourceHandle);
+		});
+	}
+
+	auto Device::get_acceleration_structure_device_address(AccelerationStructureHandle accelerationStructureHandle) -> std::uint64_t
+	{
+		std::scoped_lock lock(m_accelerationStructureMutex);
+		const auto* accelerationStructure = m_accelerationStructurePool.get_checked(accelerationStructureHandle.resourceHandle);
+		return accelerationStructure != nullptr ? accelerationStructure->get_device_address() : 0;
+	}
+
+	void Device::build_acceleration_structures(CommandList& commandList, std::span<const AccelerationStructureBuild> builds)
+	{
+		if (!supports_ray_query())
+		{
+			s_errorCallback("GFX - build_acceleration_structures() - Acceleration structures need DeviceFeatureFlags_RayQuery!");
+			return;
+		}
+		Buffer* transientBuffer{ nullptr };
+		if (!get_buffer(transientBuffer, m_transientBufferHandle))
+		{
+			s_errorCallback("GFX - build_acceleration_structures() - DeviceInfo::transientBufferSize was not set!");
+			return;
+		}
+		const auto transientAddress = transientBuffer->get_device_address();
+		// Already reported when the transient memory runs out.
+		const auto allocate_scratch = [&](std::uint64_t size) -> vk::DeviceAddress {
+			const auto allocation = allocate_transient(size, m_accelerationStructureScratchAlignment);
+			return allocation.ptr != nullptr ? transientAddress + allocation.offset : 0;
+		};
+
+		std::scoped_lock lock(m_accelerationStructureMutex);
+
+		ScratchVector<ResourceHandle> movedBottomLevels{};
+		compact_acceleration_structures(commandList, movedBottomLevels);
+
+		// Every build of a pass is recorded in one command, each with its own part of the geometries and ranges.
+		ScratchVector<vk::AccelerationStructureBuildGeometryInfoKHR> buildInfos{};
+		ScratchVector<vk::AccelerationStructureGeometryKHR> geometries{};
+		ScratchVector<vk::AccelerationStructureBuildRangeInfoKHR> buildRanges{};
+		ScratchVector<ResourceHandle> compactingBottomLevels{};
+		ScratchVector<std::uint32_t> primitiveCounts{};
+		for (const auto& build : builds)
+		{
+			auto* accelerationStructure = m_accelerationStructurePool.get_checked(build.accelerationStructureHandle.resourceHandle);
+			if (accelerationStructure == nullptr)
+			{
+				s_errorCallback("GFX - build_acceleration_structures() - Unknown acceleration structure!");
+				continue;
+			}
+			if (accelerationStructure->is_top_level())
+			{
+				continue;
+			}
+
+			const auto& info = accelerationStructure->get_info();
+			const auto buildGeometries = build.geometries.empty() ? std::span<const AccelerationStructureGeometry>(info.geometries) : build.geometries;
+			const auto firstGeometry = geometries.size();
+			const auto drop_build = [&] {
+				geometries.resize(firstGeometry);
+				buildRanges.resize(firstGeometry);
+			};
+			primitiveCounts.clear();
+			bool isValid = !buildGeometries.empty();
+			for (std::size_t i = 0; i < buildGeometries.size() && isValid; ++i)
+			{
+				isValid = get_acceleration_structure_geometry(geometries.emplace_back(), buildRanges.emplace_back(), buildGeometries[i]);
+				primitiveCounts.push_back(buildRanges.back().primitiveCount);
+			}
+			if (!isValid)
+			{
+				if (buildGeometries.empty())
+				{
+					s_errorCallback("GFX - build_acceleration_structures() - Bottom levels need geometries to build!");
+				}
+				drop_build();
+				continue;
+			}
+			if (build.update && (!info.allowUpdate || !std::ranges::equal(primitiveCounts, accelerationStructure->m_primitiveCounts)))
+			{
+				s_errorCallback("GFX - build_acceleration_structures() - Updates need allowUpdate, and a previous build of the same triangle counts!");
+				drop_build();
+				continue;
+			}
+
+			vk::AccelerationStructureBuildGeometryInfoKHR build_info{};
+			build_info.setType(vk::AccelerationStructureTypeKHR::eBottomLevel);
+			build_info.setFlags(accelerationStructure->get_build_flags());
+			build_info.setMode(build.update ? vk::BuildAccelerationStructureModeKHR::eUpdate : vk::BuildAccelerationStructureModeKHR::eBuild);
+			build_info.setGeometryCount(std::uint32_t(buildGeometries.size()));
+			build_info.setPGeometries(geometries.data() + firstGeometry);
+			const auto sizes = m_device->getAccelerationStructureBuildSizesKHR(vk::AccelerationStructureBuildTypeKHR::eDevice, build_info, primitiveCounts);
+
+			const auto scratchAddress = allocate_scratch(build.update ? sizes.updateScratchSize : sizes.buildScratchSize);
+			if (scratchAddress == 0)
+			{
+				drop_build();
+				continue;
+			}
+			if (!build.update && sizes.accelerationStructureSize > accelerationStructure->get_size())
+			{
+				auto storage = create_acceleration_structure_storage(vk::AccelerationStructureTypeKHR::eBottomLevel, sizes.accelerationStructureSize, info.debugName);
+				if (!storage.accelerationStructure)
+				{
+					drop_build();
+					continue;
+				}
+				retire_acceleration_structure_storage(accelerationStructure->replace_storage(std::move(storage)));
+				movedBottomLevels.push_back(build.accelerationStructureHandle.resourceHandle);
+			}
+			// The compacted size queried for the last build no longer applies.
+			cancel_acceleration_structure_compaction(*accelerationStructure, build.accelerationStructureHandle.resourceHandle);
+
+			build_info.setDstAccelerationStructure(accelerationStructure->get_acceleration_structure());
+			build_info.setSrcAccelerationStructure(build.update ? accelerationStructure->get_acceleration_structure() : vk::AccelerationStructureKHR{});
+			build_info.setScratchData(scratchAddress);
+			buildInfos.push_back(build_info);
+			accelerationStructure->m_primitiveCounts.assign(primitiveCounts.begin(), primitiveCounts.end());
+			if (accelerationStructure->is_compacted_after_build())
+			{
+				compactingBottomLevels.push_back(build.accelerationStructureHandle.resourceHandle);
+			}
+		}
+
+		// Compaction copies and bottom level builds finish before their sizes are written and top levels read them.
+		commandList.build_acceleration_structures(buildInfos, geometries, buildRanges);
+		if (!buildInfos.empty() || !movedBottomLevels.empty())
+		{
+			commandList.memory_barrier(vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR, vk::AccessFlagBits2::eAccelerationStructureWriteKHR,
+									   vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR, vk::AccessFlagBits2::eAccelerationStructureReadKHR);
+		}
+		for (const auto resourceHandle : compactingBottomLevels)
+		{
+			if (m_freeCompactionQueries.empty())
+			{
+				break;
+			}
+			auto* accelerationStructure = m_accelerationStructurePool.get(resourceHandle);
+			accelerationStructure->m_compactionQuery = m_freeCompactionQueries.back();
+			m_freeCompactionQueries.pop_back();
+			m_device->resetQueryPool(m_compactionQueryPool.get(), accelerationStructure->m_compactionQuery, 1);
+			commandList.write_acceleration_structure_size(accelerationStructure->get_acceleration_structure(), m_compactionQueryPool.get(), accelerationStructure->m_compactionQuery);
+			m_compactingAccelerationStructures.push_back(resourceHandle);
+		}
+
+		const bool builtBottomLevels = !buildInfos.empty() || !movedBottomLevels.empty();
+		buildInfos.clear();
+		geometries.clear();
+		buildRanges.clear();
+		ScratchVector<ResourceHandle> builtTopLevels{};
+		const auto add_top_level_build = [&](ResourceHandle resourceHandle, AccelerationStructure& topLevel, std::span<const AccelerationStructureInstance> instances, bool update) {
+			const auto& info = topLevel.get_info();
+			const auto instanceCount = std::uint32_t(instances.size());
+			if (instanceCount > info.maxInstanceCount)
+			{
+				s_errorCallback("GFX - build_acceleration_structures() - More instances than the top level's maxInstanceCount!");
+				return;
+			}
+			if (update && (!info.allowUpdate || topLevel.m_primitiveCounts.size() != 1 || topLevel.m_primitiveCounts[0] != instanceCount))
+			{
+				s_errorCallback("GFX - build_acceleration_structures() - Updates need allowUpdate, and a previous build of the same instance count!");
+				return;
+			}
+
+			const auto instanceAllocation = allocate_transient(std::max(instanceCount, 1u) * sizeof(vk::AccelerationStructureInstanceKHR), 16);
+			if (instanceAllocation.ptr == nullptr)
+			{
+				return;
+			}
+			auto* vk_instances = static_cast<vk::AccelerationStructureInstanceKHR*>(instanceAllocation.ptr);
+			for (std::uint32_t i = 0; i < instanceCount; ++i)
+			{
+				const auto& instance = instances[i];
+				// Instances of destroyed or unbuilt bottom levels reference address 0, which makes them inactive.
+				const auto* bottomLevel = m_accelerationStructurePool.get_checked(instance.bottomLevelHandle.resourceHandle);
+				vk::AccelerationStructureInstanceKHR vk_instance{};
+				std::memcpy(&vk_instance.transform, instance.transform.data(), sizeof(vk::TransformMatrixKHR));
+				vk_instance.setInstanceCustomIndex(instance.customIndex & 0xFFFFFFu);
+				vk_instance.setMask(instance.mask);
+				vk_instance.setFlags(instance.doubleSided ? vk::GeometryInstanceFlagBitsKHR::eTriangleFacingCullDisable : vk::GeometryInstanceFlagsKHR{});
+				vk_instance.setAccelerationStructureReference(bottomLevel != nullptr ? bottomLevel->get_device_address() : 0);
+				vk_instances[i] = vk_instance;
+			}
+
+			const auto firstGeometry = geometries.size();
+			geometries.push_back(get_instance_geometry(transientAddress + instanceAllocation.offset));
+			buildRanges.push_back(vk::AccelerationStructureBuildRangeInfoKHR{ instanceCount, 0, 0, 0 });
+			vk::AccelerationStructureBuildGeometryInfoKHR build_info{};
+			build_info.setType(vk::AccelerationStructureTypeKHR::eTopLevel);
+			build_info.setFlags(topLevel.get_build_flags());
+			build_info.setMode(update ? vk::BuildAccelerationStructureModeKHR::eUpdate : vk::BuildAccelerationStructureModeKHR::eBuild);
+			build_info.setGeometryCount(1);
+			build_info.setPGeometries(geometries.data() + firstGeometry);
+			const auto sizes = m_device->getAccelerationStructureBuildSizesKHR(vk::AccelerationStructureBuildTypeKHR::eDevice, build_info, instanceCount);
+			GFX_ASSERT(sizes.accelerationStructureSize <= topLevel.get_size(), "Top levels are created for their maxInstanceCount!");
+
+			const auto scratchAddress = allocate_scratch(update ? sizes.updateScratchSize : sizes.buildScratchSize);
+			if (scratchAddress == 0)
+			{
+				geometries.resize(firstGeometry);
+				buildRanges.resize(firstGeometry);
+				return;
+			}
+			build_info.setDstAccelerationStructure(topLevel.get_acceleration_structure());
+			build_info.setSrcAccelerationStructure(update ? topLevel.get_acceleration_structure() : vk::AccelerationStructureKHR{});
+			build_info.setScratchData(scratchAddress);
+			buildInfos.push_back(build_info);
+			topLevel.m_primitiveCounts.assign(1, instanceCount);
+			if (instances.data() != topLevel.m_instances.data())
+			{
+				topLevel.m_instances.assign(instances.begin(), instances.end());
+			}
+			builtTopLevels.push_back(resourceHandle);
+		};
+		for (const auto& build : builds)
+		{
+			auto* accelerationStructure = m_accelerationStructurePool.get_checked(build.accelerationStructureHandle.resourceHandle);
+			if (accelerationStructure != nullptr && accelerationStructure->is_top_level())
+			{
+				add_top_level_build(build.accelerationStructureHandle.resourceHandle, *accelerationStructure, build.instances, build.update);
+			}
+		}
+		// Top levels hold the addresses of their bottom levels, so those holding one that moved are rebuilt.
+		for (const auto resourceHandle : m_topLevelAccelerationStructures)
+		{
+			auto* topLevel = m_accelerationStructurePool.get(resourceHandle);
+			if (movedBottomLevels.empty() || topLevel->m_primitiveCounts.empty() || std::ranges::find(builtTopLevels, resourceHandle) != builtTopLevels.end())
+			{
+				continue;
+			}
+			const bool holdsMovedBottomLevel = std::ranges::any_of(topLevel->m_instances, [&](const AccelerationStructureInstance& instance) {
+				return std::ranges::find(movedBottomLevels, instance.bottomLevelHandle.resourceHandle) != movedBottomLevels.end();
+			});
+			if (holdsMovedBottomLevel)
+			{
+				add_top_level_build(resourceHandle, *topLevel, topLevel->m_instances, false);
+			}
+		}
+
+		commandList.build_acceleration_structures(buildInfos, geometries, buildRanges);
+		if (builtBottomLevels || !buildInfos.empty())
+		{
+			commandList.memory_barrier(vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR, vk::AccessFlagBits2::eAccelerationStructureWriteKHR,
+									   vk::PipelineStageFlagBits2::eAllCommands, vk::AccessFlagBits2::eAccelerationStructureReadKHR);
+		}
+	}
+
+	bool Device::get_acceleration_structure_geometry(vk::AccelerationStructureGeometryKHR& outGeometry, vk::AccelerationStructureBuildRangeInfoKHR& outRange,
+													 const AccelerationStructureGeometry& geometry)
+	{
+		Buffer* vertexBuffer{ nullptr };
+		Buffer* indexBuffer{ nullptr };
+		if (!get_buffer(vertexBuffer, geometry.vertexBufferHandle) || (geometry.indexBufferHandle && !get_buffer(indexBuffer, geometry.indexBufferHandle)))
+		{
+			s_errorCallback("GFX - Unknown acceleration structure geometry buffer!");
+			return false;
+		}
+		constexpr auto inputUsage = vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR;
+		if (!(vertexBuffer->get_usage_flags() & inputUsage) || (indexBuffer != nullptr && !(indexBuffer->get_usage_flags() & inputUsage)))
+		{
+			s_errorCallback("GFX - Acceleration structure geometry buffers need BufferInfo::accelerationStructureInput!");
+			return false;
+		}
+		const auto vertexFormat = convert_format_to_vk_format(geometry.vertexFormat);
+		if (!(m_physicalDevice.getFormatProperties(vertexFormat).bufferFeatures & vk::FormatFeatureFlagBits::eAccelerationStructureVertexBufferKHR))
+		{
+			s_errorCallback("GFX - Acceleration structure geometry vertex format is not supported by this device!");
+			return false;
+		}
+		const auto indexSize = geometry.indexType == IndexType::eUInt16 ? 2u : 4u;
+		if (geometry.vertexOffset + std::uint64_t(geometry.vertexCount) * geometry.vertexStride > vertexBuffer->get_size() ||
+			(indexBuffer != nullptr && geometry.indexOffset + std::uint64_t(geometry.triangleCount) * 3 * indexSize > indexBuffer->get_size()))
+		{
+			s_errorCallback("GFX - Acceleration structure geometry is out of bounds!");
+			return false;
+		}
+		if (indexBuffer != nullptr && geometry.indexOffset % indexSize != 0)
+		{
+			s_errorCallback("GFX - Acceleration structure geometry index offset must be a multiple of the index size!");
+			return false;
+		}
+
+		vk::AccelerationStructureGeometryTrianglesDataKHR triangles{};
+		triangles.setVertexFormat(vertexFormat);
+		triangles.setVertexData(vertexBuffer->get_device_address() + geometry.vertexOffset);
+		triangles.setVertexStride(geometry.vertexStride);
+		triangles.setMaxVertex(geometry.vertexCount > 0 ? geometry.vertexCount - 1 : 0);
+		triangles.setIndexType(indexBuffer == nullptr ? vk::IndexType::eNoneKHR : geometry.indexType == IndexType::eUInt16 ? vk::IndexType::eUint16 : vk::IndexType::eUint32);
+		if (indexBuffer != nullptr)
+		{
+			triangles.setIndexData(indexBuffer->get_device_address() + geometry.indexOffset);
+		}
+
+		outGeometry = vk::AccelerationStructureGeometryKHR{};
+		outGeometry.setGeometryType(vk::GeometryTypeKHR::eTriangles);
+		outGeometry.geometry.setTriangles(triangles);
+		// Non-opaque hits are confirmed by the shader, which should see each once.
+		outGeometry.setFlags(geometry.opaque ? vk::GeometryFlagBitsKHR::eOpaque : vk::GeometryFlagBitsKHR::eNoDuplicateAnyHitInvocation);
+		outRange = vk::AccelerationStructureBuildRangeInfoKHR{ geometry.triangleCount, 0, 0, 0 };
+		return true;
+	}
+
+	auto Device::create_acceleration_structure_storage(vk::AccelerationStructureTypeKHR type, std::uint64_t size, std::string_view debugName) -> AccelerationStructureStorage
+	{
+		ScratchVector<std::uint32_t> queueFamilies(m_queueFamilies.begin(), m_queueFamilies.end());
+		std::ranges::sort(queueFamilies);
+		queueFamilies.erase(std::unique(queueFamilies.begin(), queueFamilies.end()), queueFamilies.end());
+
+		vk::BufferCreateInfo buffer_info{};
+		buffer_info.setSize(size);
+		buffer_info.setUsage(vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress);
+		if (queueFamilies.size() > 1)
+		{
+			buffer_info.setSharingMode(vk::SharingMode::eConcurrent);
+			buffer_info.setQueueFamilyIndices(queueFamilies);
+		}
+		auto buffer_result = m_allocator->createBufferUnique(buffer_info, convert_buffer_memory_to_vma_allocation_info(BufferMemory::eGpuOnly));
+		if (buffer_result.result != vk::Result::eSuccess)
+		{
+			s_errorCallback("GFX - Failed to allocate acceleration structure memory!");
+			return {};
+		}
+
+		AccelerationStructureStorage storage{};
+		std::tie(storage.buffer, storage.allocation) = std::move(buffer_result.value);
+		vk::AccelerationStructureCreateInfoKHR acceleration_structure_info{};
+		acceleration_structure_info.setBuffer(storage.buffer.get());
+		acceleration_structure_info.setSize(size);
+		acceleration_structure_info.setType(type);
+		storage.accelerationStructure = m_device->createAccelerationStructureKHRUnique(acceleration_structure_info).value;
+		storage.size = size;
+		storage.deviceAddress = m_device->getAccelerationStructureAddressKHR(vk::AccelerationStructureDeviceAddressInfoKHR{ storage.accelerationStructure.get() });
+		set_debug_name(m_device.get(), storage.accelerationStructure.get(), debugName);
+		return storage;
+	}
+
+	void Device::retire_acceleration_structure_storage(AccelerationStructureStorage&& storage)
+	{
+		if (storage.accelerationStructure)
+		{
+			m_retiredAccelerationStructureStorage.push_back(std::move(storage));
+		}
+	}
+
+	void Device::release_retired_acceleration_structures()
+	{
+		std::vector<AccelerationStructureStorage> retiredStorage{};
+		std::vector<std::uint32_t> retiredQueries{};
+		{
+			std::scoped_lock lock(m_accelerationStructureMutex);
+			retiredStorage.swap(m_retiredAccelerationStructureStorage);
+			retiredQueries.swap(m_retiredCompactionQueries);
+		}
+		if (retiredStorage.empty() && retiredQueries.empty())
+		{
+			return;
+		}
+
+		// Shared, as destroy functions are copyable. The storage is destroyed with the function, after it runs.
+		defer_destroy([this, storage = std::make_shared<std::vector<AccelerationStructureStorage>>(std::move(retiredStorage)), queries = std::move(retiredQueries)] {
+			std::scoped_lock lock(m_accelerationStructureMutex);
+			m_freeCompactionQueries.insert(m_freeCompactionQueries.end(), queries.begin(), queries.end());
+		});
+	}
+
+	void Device::compact_acceleration_structures(CommandList& commandList, ScratchVector<ResourceHandle>& outMovedBottomLevels)
+	{
+		bool hasCopied{ false };
+		for (auto it = m_compactingAccelerationStructures.begin(); it != m_compactingAccelerationStructures.end();)
+		{
+			auto* accelerationStructure = m_accelerationStructurePool.get(*it);
+			std::uint64_t compactedSize{ 0 };
+			const auto result = m_device->getQueryPoolResults(m_compactionQueryPool.get(), accelerationStructure->m_compactionQuery, 1, sizeof(compactedSize), &compactedSize,
+															  sizeof(compactedSize), vk::QueryResultFlagBits::e64);
+			if (result != vk::Result::eSuccess)
+			{
+				++it;
+				continue;
+			}
+
+			// Its build has finished, so its query is free again.
+			m_freeCompactionQueries.push_back(std::exchange(accelerationStructure->m_compactionQuery, AccelerationStructure::NO_QUERY));
+			const auto resourceHandle = *it;
+			it = m_compactingAccelerationStructures.erase(it);
+			if (compactedSize == 0 || compactedSize >= accelerationStructure->get_size())
+			{
+				continue;
+			}
+
+			auto storage = create_acceleration_structure_storage(vk::AccelerationStructureTypeKHR::eBottomLevel, compactedSize, accelerationStructure->get_info().debugName);
+			if (!storage.accelerationStructure)
+			{
+				continue;
+			}
+			if (!hasCopied)
+			{
+				// The builds may have run on another queue.
+				commandList.memory_barrier(vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR, vk::AccessFlagBits2::eAccelerationStructureWriteKHR,
+										   vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR, vk::AccessFlagBits2::eAccelerationStructureReadKHR);
+				hasCopied = true;
+			}
+			commandList.copy_acceleration_structure(accelerationStructure->get_acceleration_structure(), storage.accelerationStructure.get(),
+													vk::CopyAccelerationStructureModeKHR::eCompact);
+			retire_acceleration_structure_storage(accelerationStructure->replace_storage(std::move(storage)));
+			outMovedBottomLevels.push_back(resourceHandle);
+		}
+	}
+
+	void Device::cancel_acceleration_structure_compaction(AccelerationStructure& accelerationStructure, ResourceHandle resourceHandle)
+	{
+		if (accelerationStructure.m_compactionQuery == AccelerationStructure::NO_QUERY)
+		{
+			return;
+		}
+		// A command list writing the query may still be in flight.
+		m_retiredCompactionQueries.push_back(std::exchange(accelerationStructure.m_compactionQuery, AccelerationStructure::NO_QUERY));
+		std::erase(m_compactingAccelerationStructures, resourceHandle);
+	}
+
+	auto Device::get_sparse_page_size(BufferHandle bufferHandle) -> std::uint64_t
+	{
+		const auto* buffer = m_bufferPool.get_checked(bufferHandle.resourceHandle);
+		return buffer != nullptr && buffer->get_sparse_residency() != nullptr ? buffer->get_sparse_residency()->get_page_size() : 0;
+	}
+
+	bool Device::get_sparse_texture_properties(SparseTextureProperties& outProperties, TextureHandle textureHandle)
+	{
+		const auto* texture = m_texturePool.get_checked(textureHandle.resourceHandle);
+		const auto* requirements = texture != nullptr ? get_sparse_texture_requirements(*texture) : nullptr;
+		if (requirements == nullptr)
+		{
+			return false;
+		}
+
+		outProperties.tileWidth = requirements->formatProperties.imageGranularity.width;
+		outProperties.tileHeight = requirements->formatProperties.imageGranularity.height;
+		outProperties.mipTailFirstLevel = std::min(requirements->imageMipTailFirstLod, texture->get_mip_levels());
+		return true;
+	}
+
+	auto Device::bind_sparse_buffer_pages(BufferHandle bufferHandle, std::uint32_t queueIndex, std::span<const SparseBufferBind> binds, std::span<const SyncPoint> waitSyncPoints) -> SyncPoint
+	{
+		const auto* buffer = m_bufferPool.get_checked(bufferHandle.resourceHandle);
+		auto* sparse = buffer != nullptr ? buffer->get_sparse_residency() : nullptr;
+		if (sparse == nullptr)
+		{
+			s_errorCallback("GFX - bind_sparse_buffer_pages() - Buffer was not created with BufferInfo::sparse!");
+			return {};
+		}
+		if (!validate_sparse_bind(queueIndex, waitSyncPoints))
+		{
+			return {};
+		}
+
+		// Validated up front, so a rejected bind changes no residency.
+		const auto pageSize = sparse->get_page_size();
+		for (const auto& bind : binds)
+		{
+			if (bind.offset % pageSize != 0 || bind.offset + bind.size > sparse->get_size())
+			{
+				s_errorCallback("GFX - bind_sparse_buffer_pages() - Binds must start on a page and lie within the buffer!");
+				return {};
+			}
+		}
+
+		auto pendingBind = std::make_shared<PendingSparseBind>();
+		pendingBind->buffer = buffer->get_buffer();
+		pendingBind->residency = sparse;
+		for (const auto& bind : binds)
+		{
+			for (auto pageOffset = bind.offset; pageOffset < bind.offset + bind.size; pageOffset += pageSize)
+			{
+				vk::SparseMemoryBind memory_bind{};
+				memory_bind.setResourceOffset(pageOffset);
+				memory_bind.setSize(std::min(pageSize, sparse->get_size() - pageOffset));
+				if (sparse->update_page(pageOffset / pageSize, memory_bind.size, bind.resident, memory_bind.memory, memory_bind.memoryOffset, pendingBind->pageChanges))
+				{
+					pendingBind->memoryBinds.push_back(memory_bind);
+				}
+			}
+		}
+		return submit_sparse_bind(queueIndex, std::move(pendingBind), waitSyncPoints);
+	}
+
+	auto Device::bind_sparse_texture_tiles(TextureHandle textureHandle, std::uint32_t queueIndex, std::span<const SparseTextureBind> binds, std::span<const SyncPoint> waitSyncPoints) -> SyncPoint
+	{
+		const auto* texture = m_texturePool.get_checked(textureHandle.resourceHandle);
+		const auto* requirements = texture != nullptr ? get_sparse_texture_requirements(*texture) : nullptr;
+		if (requirements == nullptr)
+		{
+			s_errorCallback("GFX - bind_sparse_texture_tiles() - Texture was not created with TextureInfo::sparse!");
+			return {};
+		}
+		if (!validate_sparse_bind(queueIndex, waitSyncPoints))
+		{
+			return {};
+		}
+
+		const auto tileExtent = requirements->formatProperties.imageGranularity;
+		const auto mipTailFirstLevel = std::min(requirements->imageMipTailFirstLod, texture->get_mip_levels());
+		const auto extent = texture->get_extent();
+		for (const auto& bind : binds)
+		{
+			if (bind.mipLevel >= mipTailFirstLevel || bind.arrayLayer >= texture->get_array_layers() || bind.x % tileExtent.width != 0 ||
+				bind.y % tileExtent.height != 0 || bind.x + bind.width > std::max(extent.width >> bind.mipLevel, 1u) ||
+				bind.y + bind.height > std::max(extent.height >> bind.mipLevel, 1u))
+			{
+				s_errorCallback("GFX - bind_sparse_texture_tiles() - Binds must start on a tile and lie within a mip level above the mip tail!");
+				return {};
+			}
+		}
+
+		auto* sparse = texture->get_sparse_residency();
+		auto pendingBind = std::make_shared<PendingSparseBind>();
+		pendingBind->image = texture->get_image();
+		pendingBind->residency = sparse;
+
+		// The packed mip tails (and any metadata) are small and cannot be bound per tile, so they stay resident.
+		if (!sparse->mipTailResident.exchange(true))
+		{
+			pendingBind->claimedMipTail = true;
+			for (const auto& imageRequirements : sparse->imageRequirements)
+			{
+				const bool isMetadata = bool(imageRequirements.formatProperties.aspectMask & vk::ImageAspectFlagBits::eMetadata);
+				if (!isMetadata && imageRequirements.imageMipTailFirstLod >= texture->get_mip_levels())
+				{
+					continue;
+				}
+
+				const bool singleMipTail = bool(imageRequirements.formatProperties.flags & vk::SparseImageFormatFlagBits::eSingleMiptail);
+				const auto mipTailCount = singleMipTail ? 1u : texture->get_array_layers();
+				for (auto layer = 0u; layer < mipTailCount; ++layer)
+				{
+					vk::SparseMemoryBind memory_bind{};
+					memory_bind.setResourceOffset(imageRequirements.imageMipTailOffset + layer * imageRequirements.imageMipTailStride);
+					memory_bind.setSize(imageRequirements.imageMipTailSize);
+					memory_bind.setFlags(isMetadata ? vk::SparseMemoryBindFlagBits::eMetadata : vk::SparseMemoryBindFlags{});
+
+					const auto pageKey = 1ull << 63u | std::uint64_t(isMetadata) << 62u | layer;
+					if (sparse->update_page(pageKey, memory_bind.size, true, memory_bind.memory, memory_bind.memoryOffset, pendingBind->pageChanges))
+					{
+						pendingBind->memoryBinds.push_back(memory_bind);
+					}
+				}
+			}
+		}
+
+		for (const auto& bind : binds)
+		{
+			const auto mipWidth = std::max(extent.width >> bind.mipLevel, 1u);
+			const auto mipHeight = std::max(extent.height >> bind.mipLevel, 1u);
+			for (auto tileY = bind.y / tileExtent.height; tileY * tileExtent.height < bind.y + bind.height; ++tileY)
+			{
+				for (auto tileX = bind.x / tileExtent.width; tileX * tileExtent.width < bind.x + bind.width; ++tileX)
+				{
+					const auto x = tileX * tileExtent.width;
+					const auto y = tileY * tileExtent.height;
+
+					// Tiles on the right and bottom edges may be partial.
+					vk::SparseImageMemoryBind image_bind{};
+					image_bind.setSubresource({ texture->get_aspect_mask(), bind.mipLevel, bind.arrayLayer });
+					image_bind.setOffset({ std::int32_t(x), std::int32_t(y), 0 });
+					image_bind.setExtent({ std::min(tileExtent.width, mipWidth - x), std::min(tileExtent.height, mipHeight - y), 1 });
+
+					const auto pageKey = std::uint64_t(bind.arrayLayer) << 48u | std::uint64_t(bind.mipLevel) << 40u | std::uint64_t(tileY) << 20u | tileX;
+					if (sparse->update_page(pageKey, 0, bind.resident, image_bind.memory, image_bind.memoryOffset, pendingBind->pageChanges))
+					{
+						pendingBind->imageBinds.push_back(image_bind);
+					}
+				}
+			}
+		}
+		return submit_sparse_bind(queueIndex, std::move(pendingBind), waitSyncPoints);
+	}
+
+	auto Device::get_sparse_texture_requirements(const Texture& texture) const -> const vk::SparseImageMemoryRequirements*
+	{
+		const auto* sparse = texture.get_sparse_residency();
+		if (sparse == nullptr)
+		{
+			return nullptr;
+		}
+		for (const auto& requirements : sparse->imageRequirements)
+		{
+			if (requirements.formatProperties.aspectMask & texture.get_aspect_mask())
+			{
+				return &requirements;
+			}
+		}
+		return nullptr;
+	}
+
+	bool Device::supports_sparse_texture(const TextureInfo& textureInfo) const
+	{
+		if (!m_sparseTextureSupported || textureInfo.type != TextureType::e2D || textureInfo.memory == TextureMemory::eTransient)
+		{
+			return false;
+		}
+
+		// Empty for formats and usages without sparse support.
+		const auto usage = convert_texture_usage_to_vk_image_usage(textureInfo.usage) | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+		const auto properties = m_physicalDevice.getSparseImageFormatProperties(get_texture_format(textureInfo), vk::ImageType::e2D, vk::SampleCountFlagBits::e1, usage, vk::ImageTiling::eOptimal);
+		return !properties.empty();
+	}
+
+	auto Device::get_texture_format(const TextureInfo& textureInfo) const -> vk::Format
+	{
+		const auto format = convert_format_to_vk_format(textureInfo.format);
+		const auto promotedFormat = get_promoted_format(format);
+		if (promotedFormat == vk::Format::eUndefined || textureInfo.usage != TextureUsage::eTexture)
+		{
+			return format;
+		}
+
+		constexpr auto REQUIRED_FEATURES = vk::FormatFeatureFlagBits::eSampledImage | vk::FormatFeatureFlagBits::eTransferDst;
+		const auto features = m_physicalDevice.getFormatProperties(format).optimalTilingFeatures;
+		return (features & REQUIRED_FEATURES) == REQUIRED_FEATURES ? format : promotedFormat;
+	}
+
+	bool Device::is_vertex_format_supported(vk::Format format) const
+	{
+		return bool(m_physicalDevice.getFormatProperties(format).bufferFeatures & vk::FormatFeatureFlagBits::eVertexBuffer);
+	}
+
+	bool Device::get_mipmap_filter(vk::Format format, vk::Filter& outFilter) const
+	{
+		const auto features = m_physicalDevice.getFormatProperties(format).optimalTilingFeatures;
+		if (!(features & vk::FormatFeatureFlagBits::eBlitSrc) || !(features & vk::FormatFeatureFlagBits::eBlitDst))
+		{
+			return false;
+		}
+
+		// Depth and integer formats can only be blitted with nearest filtering.
+		outFilter = (features & vk::FormatFeatureFlagBits::eSampledImageFilterLinear) ? vk::Filter::eLinear : vk::Filter::eNearest;
+		return true;
+	}
+
+	bool Device::supports_blit(vk::Format srcFormat, vk::Format dstFormat, vk::Filter filter) const
+	{
+		const auto srcFeatures = m_physicalDevice.getFormatProperties(srcFormat).optimalTilingFeatures;
+		const auto dstFeatures = m_physicalDevice.getFormatProperties(dstFormat).optimalTilingFeatures;
+		return (srcFeatures & vk::FormatFeatureFlagBits::eBlitSrc) && (dstFeatures & vk::FormatFeatureFlagBits::eBlitDst) &&
+			   (filter != vk::Filter::eLinear || (srcFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear));
+	}
+
+	bool Device::validate_sparse_bind(std::uint32_t queueIndex, std::span<const SyncPoint> waitSyncPoints) const
+	{
+		if (queueIndex >= m_queues.size())
+		{
+			s_errorCallback("GFX - Invalid queue index!");
+			return false;
+		}
+		if (!(m_physicalDevice.getQueueFamilyProperties()[m_queueFamilies[queueIndex]].queueFlags & vk::QueueFlagBits::eSparseBinding))
+		{
+			s_errorCallback("GFX - Sparse binds need a queue created with QueueFlags_SparseBinding!");
+			return false;
+		}
+		for (const auto& syncPoint : waitSyncPoints)
+		{
+			if (syncPoint.value != 0 && (syncPoint.deviceHandle != m_deviceHandle || syncPoint.queueIndex >= m_queueTimelines.size()))
+			{
+				s_errorCallback("GFX - Invalid wait sync point for sparse bind!");
+				return false;
+			}
+		}
+		return true;
+	}
+
+	auto Device::submit_sparse_bind(std::uint32_t queueIndex, std::shared_ptr<PendingSparseBind> pendingBind, std::span<const SyncPoint> waitSyncPoints) -> SyncPoint
+	{
+		if (pendingBind->memoryBinds.empty() && pendingBind->imageBinds.empty())
+		{
+			// Only pages whose allocation failed, which update_page() left as they were.
+			finish_sparse_bind(pendingBind, false);
+			return {};
+		}
+		if (is_device_lost())
+		{
+			s_errorCallback("GFX - Cannot bind sparse memory on a lost device!");
+			finish_sparse_bind(pendingBind, false);
+			return {};
+		}
+		for (const auto& syncPoint : waitSyncPoints)
+		{
+			if (syncPoint.value != 0)
+			{
+				pendingBind->waitSemaphores.push_back(m_queueTimelines[syncPoint.queueIndex].semaphore.get());
+				pendingBind->waitValues.push_back(syncPoint.value);
+			}
+		}
+
+		// Signals the queue's timeline like a submission, so it has to be ordered with them.
+		auto& queueTimeline = m_queueTimelines[queueIndex];
+		SyncPoint syncPoint{ m_deviceHandle, queueIndex, 0 };
+		if (m_submissionThread != nullptr)
+		{
+			std::lock_guard lock(*queueTimeline.submitMutex);
+			syncPoint.value = queueTimeline.submitValue.load() + 1;
+			queueTimeline.submitValue.store(syncPoint.value);
+
+			m_submissionThread->enqueue([this, queueIndex, pendingBind, submitValue = syncPoint.value] {
+				auto& queueTimeline = m_queueTimelines[queueIndex];
+				std::lock_guard lock(*queueTimeline.submitMutex);
+				const bool bound = !is_device_lost() && execute_sparse_bind(queueIndex, *pendingBind, submitValue);
+				if (!bound)
+				{
+					// As a failed threaded submit, the published value is never signalled.
+					s_errorCallback("GFX - Failed to bind sparse memory!");
+					mark_device_lost();
+				}
+				finish_sparse_bind(pendingBind, bound);
+			});
+			return syncPoint;
+		}
+
+		std::lock_guard lock(*queueTimeline.submitMutex);
+		syncPoint.value = queueTimeline.submitValue.load() + 1;
+		if (!execute_sparse_bind(queueIndex, *pendingBind, syncPoint.value))
+		{
+			s_errorCallback("GFX - Failed to bind sparse memory!");
+			finish_sparse_bind(pendingBind, false);
+			return {};
+		}
+		queueTimeline.submitValue.store(syncPoint.value);
+		finish_sparse_bind(pendingBind, true);
+		return syncPoint;
+	}
+
+	void Device::finish_sparse_bind(const std::shared_ptr<PendingSparseBind>& pendingBind, bool bound)
+	{
+		auto& pageChanges = pendingBind->pageChanges;
+		if (!bound)
+		{
+			std::vector<vma::Allocation> orphanedAllocations{};
+			pendingBind->residency->revert(pageChanges, orphanedAllocations);
+			if (pendingBind->claimedMipTail)
+			{
+				pendingBind->residency->mipTailResident.store(false);
+			}
+			if (!orphanedAllocations.empty())
+			{
+				defer_destroy([this, orphanedAllocations] { m_allocator->freeMemoryPages(orphanedAllocations); });
+			}
+			return;
+		}
+
+		if (!pageChanges.evicted.empty())
+		{
+			// Tagged with the bind's value too, so the memory outlives both the unbind and any work still reading it.
+			std::vector<vma::Allocation> evictedAllocations{};
+			evictedAllocations.reserve(pageChanges.evicted.size());
+			for (const auto& [pageKey, allocation] : pageChanges.evicted)
+			{
+				evictedAllocations.push_back(allocation);
+			}
+			defer_destroy([this, evictedAllocations] { m_allocator->freeMemoryPages(evictedAllocations); });
+		}
+	}
+
+	bool Device::execute_sparse_bind(std::uint32_t queueIndex, const PendingSparseBind& pendingBind, std::uint64_t signalValue)
+	{
+		const vk::SparseBufferMemoryBindInfo buffer_bind_info{ pendingBind.buffer, pendingBind.memoryBinds };
+		const vk::SparseImageOpaqueMemoryBindInfo opaque_bind_info{ pendingBind.image, pendingBind.memoryBinds };
+		const vk::SparseImageMemoryBindInfo image_bind_info{ pendingBind.image, pendingBind.imageBinds };
+		const auto signal_semaphore = m_queueTimelines[queueIndex].semaphore.get();
+
+		vk::TimelineSemaphoreSubmitInfo timeline_info{};
+		timeline_info.setWaitSemaphoreValues(pendingBind.waitValues);
+		timeline_info.setSignalSemaphoreValues(signalValue);
+
+		vk::BindSparseInfo bind_info{};
+		bind_info.setPNext(&timeline_info);
+		bind_info.setWaitSemaphores(pendingBind.waitSemaphores);
+		bind_info.setSignalSemaphores(signal_semaphore);
+		if (pendingBind.buffer)
+		{
+			bind_info.setBufferBinds(buffer_bind_info);
+		}
+		else
+		{
+			if (!pendingBind.memoryBinds.empty())
+			{
+				bind_info.setImageOpaqueBinds(opaque_bind_info);
+			}
+			if (!pendingBind.imageBinds.empty())
+			{
+				bind_info.setImageBinds(image_bind_info);
+			}
+		}
+		return m_queues[queueIndex].bindSparse(bind_info, nullptr) == vk::Result::eSuccess;
+	}
+
+	void Device::set_readback_sync_points(std::span<CommandList* const> commandLists, const SyncPoint& syncPoint)
+	{
+		std::lock_guard lock(m_readbackMutex);
+		for (auto* commandList : commandLists)
+		{
+			for (const auto resourceHandle : commandList->get_readbacks())
+			{
+				// Destroyed readbacks no longer resolve.
+				if (auto* readback = m_readbackPool.get_checked(resourceHandle); readback != nullptr)
+				{
+					readback->syncPoint = syncPoint;
+					readback->submitted = true;
+				}
+			}
+			commandList->clear_readbacks();
+		}
+	}
+
+	auto Device::upload_buffer(BufferHandle bufferHandle, const void* data, std::uint64_t size, std::uint64_t offset, std::uint32_t queueIndex) -> SyncPoint
+	{
+		Buffer* buffer{ nullptr };
+		if (!get_buffer(buffer, bufferHandle))
+		{
+			return {};
+		}
+		if (offset + size > buffer->get_size())
+		{
+			s_errorCallback("GFX - upload_buffer() - Range is outside of the buffer!");
+			return {};
+		}
+		if (queueIndex >= m_queues.size())
+		{
+			s_errorCallback("GFX - Invalid queue index!");
+			return {};
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.uploadBytes, size);
+
+		const auto write_mapped = [this](const Buffer& dstBuffer, const void* src, std::uint64_t writeSize, std::uint64_t writeOffset) -> bool
+		{
+			if (auto* mapped = static_cast<std::byte*>(dstBuffer.get_mapped_pointer()); mapped != nullptr)
+			{
+				std::memcpy(mapped + writeOffset, src, writeSize);
+			}
+			else
+			{
+				mapped = static_cast<std::byte*>(m_allocator->mapMemory(dstBuffer.get_allocation()).value);
+				if (mapped == nullptr)
+				{
+					return false;
+				}
+				std::memcpy(mapped + writeOffset, src, writeSize);
+				m_allocator->unmapMemory(dstBuffer.get_allocation());
+			}
+			// No-op on coherent memory, which placed buffers' heaps are.
+			return !dstBuffer.get_allocation() || m_allocator->flushAllocation(dstBuffer.get_allocation(), writeOffset, writeSize) == vk::Result::eSuccess;
+		};
+
+		// Nothing to wait for, so the sync point is reached immediately.
+		if (buffer->is_host_visible())
+		{
+			if (!write_mapped(*buffer, data, size, offset))
+			{
+				s_errorCallback("GFX - upload_buffer() - Failed to write to mapped buffer!");
+			}
+			return SyncPoint{ m_deviceHandle, queueIndex, 0 };
+		}
+
+		BufferHandle stagingBufferHandle{};
+		Buffer* stagingBuffer{ nullptr };
+		if (!create_buffer(stagingBufferHandle, { .type = BufferType::eUpload, .size = size }) || !get_buffer(stagingBuffer, stagingBufferHandle))
+		{
+			return {};
+		}
+		if (!write_mapped(*stagingBuffer, data, size, 0))
+		{
+			s_errorCallback("GFX - upload_buffer() - Failed to write to staging buffer!");
+			destroy_buffer(stagingBufferHandle);
+			return {};
+		}
+
+		CommandListHandle commandListHandle{};
+		CommandList* commandList{ nullptr };
+		if (!create_command_list(commandListHandle, queueIndex, CommandListFlags_FireAndForget) || !get_command_list(commandList, commandListHandle))
+		{
+			destroy_buffer(stagingBufferHandle);
+			return {};
+		}
+		commandList->begin();
+		const BufferCopyRegion region{ .srcOffset = 0, .dstOffset = offset, .size = size };
+		commandList->copy_buffer(stagingBuffer, buffer, { &region, 1 });
+		commandList->end();
+
+		const SubmitBatch batch{ .commandLists = { &commandListHandle, 1 } };
+		const auto syncPoint = submit_command_lists(queueIndex, { &batch, 1 });
+
+		// Freed once the frame's work, including the copy, has completed.
+		destroy_buffer(stagingBufferHandle);
+		return syncPoint;
+	}
+
+	auto Device::upload_texture(TextureHandle textureHandle, const void* data, std::uint64_t size, std::uint32_t queueIndex) -> SyncPoint
+	{
+		Texture* texture{ nullptr };
+		if (!get_texture(texture, textureHandle))
+		{
+			return {};
+		}
+		if (queueIndex >= m_queues.size())
+		{
+			s_errorCallback("GFX - Invalid queue index!");
+			return {};
+		}
+		if (size < texture->get_upload_level_size(0))
+		{
+			s_errorCallback("GFX - upload_texture() - Data is smaller than the first mip level!");
+			return {};
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.uploadBytes, size);
+		if (host_copy_texture_level(*texture, data, 0))
+		{
+			return {};
+		}
+
+		// Promoted formats are widened to the first mip level of the texture's own format.
+		const auto dataSize = texture->is_format_promoted() ? texture->get_upload_level_size(0) : size;
+		const auto stagingSize = texture->is_format_promoted() ? texture->get_level_size(0) : size;
+		BufferHandle stagingBufferHandle{};
+		Buffer* stagingBuffer{ nullptr };
+		if (!create_buffer(stagingBufferHandle, { .type = BufferType::eUpload, .size = stagingSize }) || !get_buffer(stagingBuffer, stagingBufferHandle))
+		{
+			return {};
+		}
+		stage_texels(*texture, stagingBuffer->get_mapped_pointer(), data, dataSize);
+		if (m_allocator->flushAllocation(stagingBuffer->get_allocation(), 0, stagingSize) != vk::Result::eSuccess)
+		{
+			s_errorCallback("GFX - upload_texture() - Failed to write to staging buffer!");
+			destroy_buffer(stagingBufferHandle);
+			return {};
+		}
+
+		CommandListHandle commandListHandle{};
+		CommandList* commandList{ nullptr };
+		if (!create_command_list(commandListHandle, queueIndex, CommandListFlags_FireAndForget) || !get_command_list(commandList, commandListHandle))
+		{
+			destroy_buffer(stagingBufferHandle);
+			return {};
+		}
+		commandList->begin();
+		commandList->transition_texture(texture, TextureState::eUploadDst);
+		commandList->copy_buffer_to_texture(stagingBuffer, texture);
+		commandList->transition_texture(texture, TextureState::eShaderRead);
+		commandList->end();
+
+		const SubmitBatch batch{ .commandLists = { &commandListHandle, 1 } };
+		const auto syncPoint = submit_command_lists(queueIndex, { &batch, 1 });
+
+		// Freed once the frame's work, including the copy, has completed.
+		destroy_buffer(stagingBufferHandle);
+		return syncPoint;
+	}
+
+	bool Device::validate_buffer_info(const BufferInfo& bufferInfo) const
+	{
+		if (bufferInfo.sparse && !m_sparseBufferSupported)
+		{
+			s_errorCallback("GFX - Sparse buffers are not supported by this device!");
+			return false;
+		}
+		if (bufferInfo.deviceAddress && !m_bufferDeviceAddressSupported)
+		{
+			s_errorCallback("GFX - Buffer device addresses are not supported by this device!");
+			return false;
+		}
+		if (bufferInfo.predicate && !supports_conditional_rendering())
+		{
+			s_errorCallback("GFX - Predicate buffers need DeviceFeatureFlags_ConditionalRendering!");
+			return false;
+		}
+		if (bufferInfo.accelerationStructureInput && !supports_ray_query())
+		{
+			s_errorCallback("GFX - Acceleration structure input buffers need DeviceFeatureFlags_RayQuery!");
+			return false;
+		}
+		return true;
+	}
+
+	bool Device::validate_texture_info(const TextureInfo& textureInfo) const
+	{
+		if (textureInfo.sparse && !supports_sparse_texture(textureInfo))
+		{
+			s_errorCallback("GFX - Sparse textures of this type and format are not supported by this device!");
+			return false;
+		}
+		if (textureInfo.arrayLayers == 0 || textureInfo.depth == 0)
+		{
+			s_errorCallback("GFX - Textures need at least one array layer and depth slice!");
+			return false;
+		}
+		if (textureInfo.usage == TextureUsage::eShadingRate &&
+			(!supports_shading_rate() || textureInfo.type != TextureType::e2D || textureInfo.format != Format::eR8Uint || textureInfo.sparse || textureInfo.sampleCount != 1))
+		{
+			s_errorCallback("GFX - Shading rate textures must be single-sampled, non-sparse eR8Uint 2D textures, and need DeviceFeatureFlags_ShadingRate!");
+			return false;
+		}
+		if (textureInfo.usage == TextureUsage::eStorage &&
+			!(m_physicalDevice.getFormatProperties(convert_format_to_vk_format(textureInfo.format)).optimalTilingFeatures & vk::FormatFeatureFlagBits::eStorageImage))
+		{
+			s_errorCallback("GFX - Storage textures of this format are not supported by this device!");
+			return false;
+		}
+		if (textureInfo.type == TextureType::e3D ? textureInfo.arrayLayers != 1 : textureInfo.depth != 1)
+		{
+			s_errorCallback("GFX - Only 3D textures have depth, and they cannot be arrays!");
+			return false;
+		}
+		if (textureInfo.type == TextureType::e1D && textureInfo.height != 1)
+		{
+			s_errorCallback("GFX - 1D textures must have a height of 1!");
+			return false;
+		}
+		if (textureInfo.type == TextureType::eCube)
+		{
+			if (textureInfo.width != textureInfo.height)
+			{
+				s_errorCallback("GFX - Cube faces must be square!");
+				return false;
+			}
+			if (textureInfo.arrayLayers > 1 && !m_imageCubeArraySupported)
+			{
+				s_errorCallback("GFX - Cube arrays are not supported by this device!");
+				return false;
+			}
+		}
+		if (textureInfo.sampleCount != 1)
+		{
+			if (textureInfo.type != TextureType::e2D || textureInfo.mipLevels != 1 || textureInfo.sparse || textureInfo.usage == TextureUsage::eTexture || textureInfo.usage == TextureUsage::eStorage)
+			{
+				s_errorCallback("GFX - Multisampled textures must be single level, non-sparse 2D attachments!");
+				return false;
+			}
+			const auto supportedSampleCounts = textureInfo.usage == TextureUsage::eDepthStencilAttachment ? m_depthSampleCounts : m_colorSampleCounts;
+			if (!std::has_single_bit(textureInfo.sampleCount) || !(supportedSampleCounts & vk::SampleCountFlagBits(textureInfo.sampleCount)))
+			{
+				s_errorCallback("GFX - Texture sample count is not supported by this device!");
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool Device::create_texture(TextureHandle& outTextureHandle, const TextureInfo& textureInfo)
+	{
+		if (!validate_texture_info(textureInfo))
+		{
+			return false;
+		}
+
+		const auto resourceHandle = m_texturePool.emplace(*this, textureInfo);
+		if (CAST_HANDLE_TO_INT(resourceHandle) == 0)
+		{
+			return false;
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+		register_allocation(m_texturePool.get(resourceHandle)->get_allocation(), resourceHandle, true);
+		if (m_bindlessHeap && (textureInfo.usage == TextureUsage::eTexture || textureInfo.usage == TextureUsage::eStorage))
+		{
+			m_bindlessHeap->write_texture(resourceHandle, m_texturePool.get(resourceHandle)->get_view());
+		}
+		outTextureHandle = TextureHandle(m_deviceHandle, resourceHandle);
+		return true;
+	}
+
+	bool Device::create_textures(std::span<TextureHandle> outTextureHandles, std::span<const TextureInfo> textureInfos)
+	{
+		if (outTextureHandles.size() < textureInfos.size())
+		{
+			s_errorCallback("GFX - create_textures() - outTextureHandles is smaller than textureInfos!");
+			return false;
+		}
+
+		for (const auto& textureInfo : textureInfos)
+		{
+			if (!validate_texture_info(textureInfo))
+			{
+				return false;
+			}
+		}
+
+		m_texturePool.reserve(std::uint32_t(textureInfos.size()));
+		for (auto i = 0; i < textureInfos.size(); ++i)
+		{
+			const auto resourceHandle = m_texturePool.emplace(*this, textureInfos[i]);
+			if (CAST_HANDLE_TO_INT(resourceHandle) == 0)
+			{
+				for (auto j = 0; j < i; ++j)
+				{
+					destroy_texture(outTextureHandles[j]);
+				}
+				return false;
+			}
+			GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+			register_allocation(m_texturePool.get(resourceHandle)->get_allocation(), resourceHandle, true);
+			if (m_bindlessHeap && (textureInfos[i].usage == TextureUsage::eTexture || textureInfos[i].usage == TextureUsage::eStorage))
+			{
+				m_bindlessHeap->write_texture(resourceHandle, m_texturePool.get(resourceHandle)->get_view());
+			}
+			outTextureHandles[i] = TextureHandle(m_deviceHandle, resourceHandle);
+		}
+		return true;
+	}
+
+	bool Device::create_aliased_textures(std::span<TextureHandle> outTextureHandles, std::span<const TextureInfo> textureInfos, std::span<const TextureLifetime> lifetimes)
+	{
+		if (outTextureHandles.size() < textureInfos.size() || lifetimes.size() != textureInfos.size())
+		{
+			s_errorCallback("GFX - create_aliased_textures() - Needs a handle and a lifetime for every texture!");
+			return false;
+		}
+		for (const auto& textureInfo : textureInfos)
+		{
+			if (!validate_texture_info(textureInfo))
+			{
+				return false;
+			}
+			if (textureInfo.sparse)
+			{
+				s_errorCallback("GFX - create_aliased_textures() - Aliased textures cannot be sparse!");
+				return false;
+			}
+		}
+
+		std::vector<Texture> textures{};
+		textures.reserve(textureInfos.size());
+		std::vector<vk::MemoryRequirements> requirements{};
+		vk::MemoryRequirements blockRequirements{ 0, 1, ~0u };
+		for (const auto& textureInfo : textureInfos)
+		{
+			const auto& texture = textures.emplace_back(*this, textureInfo, true);
+			const auto& textureRequirements = requirements.emplace_back(m_device->getImageMemoryRequirements(texture.get_image()));
+			blockRequirements.alignment = std::max(blockRequirements.alignment, textureRequirements.alignment);
+			blockRequirements.memoryTypeBits &= textureRequirements.memoryTypeBits;
+		}
+		if (blockRequirements.memoryTypeBits == 0)
+		{
+			s_errorCallback("GFX - create_aliased_textures() - The textures have no memory type in common!");
+			return false;
+		}
+
+		// Largest first, each at the lowest offset clear of the placed textures whose lifetimes overlap its own.
+		std::vector<std::size_t> placementOrder(textureInfos.size());
+		std::iota(placementOrder.begin(), placementOrder.end(), 0);
+		std::ranges::stable_sort(placementOrder, std::greater{}, [&](std::size_t i) { return requirements[i].size; });
+		std::vector<vk::DeviceSize> offsets(textureInfos.size(), 0);
+		std::vector<std::size_t> placed{};
+		for (const auto i : placementOrder)
+		{
+			std::vector<std::size_t> overlapping{};
+			for (const auto other : placed)
+			{
+				if (lifetimes[i].first <= lifetimes[other].last && lifetimes[other].first <= lifetimes[i].last)
+				{
+					overlapping.push_back(other);
+				}
+			}
+			std::ranges::sort(overlapping, {}, [&](std::size_t other) { return offsets[other]; });
+
+			const auto alignment = requirements[i].alignment;
+			vk::DeviceSize offset{ 0 };
+			for (const auto other : overlapping)
+			{
+				if ((offset + alignment - 1) / alignment * alignment + requirements[i].size <= offsets[other])
+				{
+					break;
+				}
+				offset = std::max(offset, offsets[other] + requirements[other].size);
+			}
+			offsets[i] = (offset + alignment - 1) / alignment * alignment;
+			blockRequirements.size = std::max(blockRequirements.size, offsets[i] + requirements[i].size);
+			placed.push_back(i);
+		}
+
+		// Automatic memory usages need a whole resource to pick a type for, so ask for device local memory directly.
+		VmaAllocationCreateInfo alloc_info{};
+		alloc_info.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		const VkMemoryRequirements block_requirements = blockRequirements;
+		VmaAllocation allocation{ nullptr };
+		if (vmaAllocateMemory(static_cast<VmaAllocator>(m_allocator.get()), &block_requirements, &alloc_info, &allocation, nullptr) != VK_SUCCESS)
+		{
+			s_errorCallback("GFX - create_aliased_textures() - Failed to allocate memory for the textures!");
+			return false;
+		}
+		const auto memory = std::make_shared<AliasedMemory>(m_allocator.get(), vma::Allocation(allocation));
+		m_allocator->setAllocationName(memory->get_allocation(), "Aliased textures");
+		for (auto i = 0; i < textures.size(); ++i)
+		{
+			if (!textures[i].bind_aliased_memory(memory, offsets[i]))
+			{
+				s_errorCallback("GFX - create_aliased_textures() - Failed to bind a texture to its memory!");
+				return false;
+			}
+		}
+
+		m_texturePool.reserve(std::uint32_t(textures.size()));
+		for (auto i = 0; i < textures.size(); ++i)
+		{
+			const auto resourceHandle = m_texturePool.emplace(std::move(textures[i]));
+			if (CAST_HANDLE_TO_INT(resourceHandle) == 0)
+			{
+				for (auto j = 0; j < i; ++j)
+				{
+					destroy_texture(outTextureHandles[j]);
+				}
+				return false;
+			}
+			GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+			if (m_bindlessHeap && (textureInfos[i].usage == TextureUsage::eTexture || textureInfos[i].usage == TextureUsage::eStorage))
+			{
+				m_bindlessHeap->write_texture(resourceHandle, m_texturePool.get(resourceHandle)->get_view());
+			}
+			outTextureHandles[i] = TextureHandle(m_deviceHandle, resourceHandle);
+		}
+		return true;
+	}
+
+	bool Device::create_texture(TextureHandle& outTextureHandle, vk::Image image, vk::Extent3D extent, vk::Format format)
+	{
+		outTextureHandle = TextureHandle(m_deviceHandle, m_texturePool.emplace(*this, image, extent, format));
+		return CAST_HANDLE_TO_INT(outTextureHandle.resourceHandle) != 0;
+	}
+
+	bool Device::replace_texture_image(TextureHandle textureHandle, vk::Image image, vk::Extent3D extent, vk::Format format)
+	{
+		return replace_texture(textureHandle, Texture(*this, image, extent, format));
+	}
+
+	bool Device::replace_texture(TextureHandle textureHandle, Texture&& texture)
+	{
+		Texture* existingTexture{ nullptr };
+		if (!get_texture(existingTexture, textureHandle))
+		{
+			return false;
+		}
+
+		if (existingTexture->get_allocation())
+		{
+			unregister_allocation(existingTexture->get_allocation(), true);
+		}
+		invalidate_texture_bundles(*existingTexture);
+		auto retiredTexture = std::make_shared<Texture>(std::move(*existingTexture));
+		*existingTexture = std::move(texture);
+		if (existingTexture->get_allocation())
+		{
+			register_allocation(existingTexture->get_allocation(), textureHandle.resourceHandle, true);
+		}
+		defer_destroy([retiredTexture = std::move(retiredTexture)]() mutable { retiredTexture.reset(); });
+		return true;
+	}
+
+	void Device::destroy_texture(TextureHandle textureHandle)
+	{
+		evict_cached_descriptor_sets([&](const DescriptorWrite& write) { return write.textureHandle == textureHandle; });
+		{
+			std::lock_guard lock(m_streamingTextureMutex);
+			m_streamingTextures.erase(textureHandle);
+		}
+		std::function<void()> destroyFunc = [this, resourceHandle = textureHandle.resourceHandle] {
+			if (const auto* texture = m_texturePool.get_checked(resourceHandle); texture != nullptr && texture->get_allocation())
+			{
+				unregister_allocation(texture->get_allocation(), true);
+			}
+			if (m_bindlessHeap)
+			{
+				m_bindlessHeap->remove(BINDLESS_TEXTURE_BINDING, resourceHandle);
+			}
+			m_texturePool.erase(resourceHandle);
+		};
+		if (const auto* texture = m_texturePool.get_checked(textureHandle.resourceHandle); texture != nullptr)
+		{
+			invalidate_texture_bundles(*texture);
+			invalidate_descriptor_set_bundles(textureHandle.resourceHandle, true);
+		}
+		if (const auto* texture = m_texturePool.get_checked(textureHandle.resourceHandle); texture != nullptr && texture->get_allocation())
+		{
+			// VMA still owns both ends of a texture that is being moved, so it has to outlive the pass.
+			if (m_defragmenter && m_defragmenter->postpone_destroy(texture->get_allocation(), destroyFunc))
+			{
+				return;
+			}
+		}
+		defer_destroy(std::move(destroyFunc));
+	}
+
+	bool Device::replace_moved_buffer(BufferHandle bufferHandle, vk::Buffer buffer)
+	{
+		Buffer* movedBuffer{ nullptr };
+		if (!get_buffer(movedBuffer, bufferHandle))
+		{
+			return false;
+		}
+
+		const auto retiredBuffer = movedBuffer->replace_buffer(buffer);
+		invalidate_bundles(get_resource_key(retiredBuffer));
+		rebind_descriptors(bufferHandle.resourceHandle, false);
+		defer_destroy([device = m_device.get(), retiredBuffer] { device.destroyBuffer(retiredBuffer); });
+		return true;
+	}
+
+	bool Device::replace_moved_texture(TextureHandle textureHandle, vk::Image image)
+	{
+		Texture* movedTexture{ nullptr };
+		if (!get_texture(movedTexture, textureHandle))
+		{
+			return false;
+		}
+
+		// Descriptor sets are invalidated by rebinding, push descriptors recorded the retired views themselves.
+		auto [retiredImage, retiredViews] = movedTexture->replace_image(image);
+		for (const auto& retiredView : retiredViews)
+		{
+			invalidate_bundles(get_resource_key(retiredView.get()));
+		}
+		rebind_descriptors(textureHandle.resourceHandle, true);
+		defer_destroy([device = m_device.get(), retiredImage, retiredViews = std::make_shared<std::vector<vk::UniqueImageView>>(std::move(retiredViews))]() mutable {
+			retiredViews.reset();
+			device.destroyImage(retiredImage);
+		});
+		return true;
+	}
+
+	bool Device::get_texture(Texture*& outTexture, TextureHandle textureHandle)
+	{
+		outTexture = m_texturePool.get_checked(textureHandle.resourceHandle);
+		return outTexture != nullptr;
+	}
+
+	bool Device::create_texture_view(TextureViewHandle& outTextureViewHandle, TextureHandle textureHandle, const TextureViewInfo& textureViewInfo)
+	{
+		Texture* texture{ nullptr };
+		if (!get_texture(texture, textureHandle))
+		{
+			s_errorCallback("GFX - create_texture_view() - Unknown texture!");
+			return false;
+		}
+
+		const auto& range = textureViewInfo.range;
+		const auto mipLevels = texture->get_mip_levels();
+		const auto arrayLayers = texture->get_array_layers();
+		if (range.baseMipLevel >= mipLevels || range.baseArrayLayer >= arrayLayers)
+		{
+			s_errorCallback("GFX - create_texture_view() - Subresource range is out of range!");
+			return false;
+		}
+		const auto mipLevelCount = range.mipLevelCount == REMAINING_SUBRESOURCES ? mipLevels - range.baseMipLevel : range.mipLevelCount;
+		const auto arrayLayerCount = range.arrayLayerCount == REMAINING_SUBRESOURCES ? arrayLayers - range.baseArrayLayer : range.arrayLayerCount;
+		if (mipLevelCount == 0 || arrayLayerCount == 0 || mipLevelCount > mipLevels - range.baseMipLevel || arrayLayerCount > arrayLayers - range.baseArrayLayer)
+		{
+			s_errorCallback("GFX - create_texture_view() - Subresource range is out of range!");
+			return false;
+		}
+
+		const auto imageInfo = texture->get_image_create_info();
+		auto format = texture->get_format();
+		// Views in the texture's own format see the promoted one.
+		if (textureViewInfo.format != Format::eUndefined && convert_format_to_vk_format(textureViewInfo.format) != format &&
+			convert_format_to_vk_format(textureViewInfo.format) != texture->get_upload_format())
+		{
+			const auto viewFormat = convert_format_to_vk_format(textureViewInfo.format);
+			const auto textureBlock = get_format_block(format);
+			const auto viewBlock = get_format_block(viewFormat);
+			if (!(imageInfo.flags & vk::ImageCreateFlagBits::eMutableFormat))
+			{
+				s_errorCallback("GFX - create_texture_view() - Reinterpreting the format requires TextureInfo::mutableFormat!");
+				return false;
+			}
+			if (viewBlock.size != textureBlock.size || viewBlock.width != textureBlock.width || viewBlock.height != textureBlock.height)
+			{
+				s_errorCallback("GFX - create_texture_view() - View format must have the same texel block size as the texture's!");
+				return false;
+			}
+			format = viewFormat;
+		}
+
+		const auto isCubeCompatible = bool(imageInfo.flags & vk::ImageCreateFlagBits::eCubeCompatible);
+		vk::ImageViewType viewType{};
+		if (textureViewInfo.type == TextureViewType::eDefault)
+		{
+			switch (imageInfo.imageType)
+			{
+				case vk::ImageType::e1D:
+					viewType = arrayLayerCount > 1 ? vk::ImageViewType::e1DArray : vk::ImageViewType::e1D;
+					break;
+				case vk::ImageType::e3D:
+					viewType = vk::ImageViewType::e3D;
+					break;
+				case vk::ImageType::e2D:
+				default:
+					if (isCubeCompatible && arrayLayerCount % 6 == 0)
+					{
+						viewType = arrayLayerCount > 6 ? vk::ImageViewType::eCubeArray : vk::ImageViewType::eCube;
+					}
+					else
+					{
+						viewType = arrayLayerCount > 1 ? vk::ImageViewType::e2DArray : vk::ImageViewType::e2D;
+					}
+					break;
+			}
+		}
+		else
+		{
+			viewType = convert_texture_view_type_to_vk_image_view_type(textureViewInfo.type);
+		}
+
+		bool validType{ false };
+		switch (viewType)
+		{
+			case vk::ImageViewType::e1D:
+			case vk::ImageViewType::e1DArray:
+				validType = imageInfo.imageType == vk::ImageType::e1D;
+				break;
+			case vk::ImageViewType::e2D:
+			case vk::ImageViewType::e2DArray:
+				validType = imageInfo.imageType == vk::ImageType::e2D;
+				break;
+			case vk::ImageViewType::e3D:
+				validType = imageInfo.imageType == vk::ImageType::e3D;
+				break;
+			case vk::ImageViewType::eCube:
+				validType = isCubeCompatible && arrayLayerCount == 6;
+				break;
+			case vk::ImageViewType::eCubeArray:
+				validType = isCubeCompatible && arrayLayerCount % 6 == 0 && m_imageCubeArraySupported;
+				break;
+			default:
+				break;
+		}
+		const auto isArrayType = viewType == vk::ImageViewType::e1DArray || viewType == vk::ImageViewType::e2DArray || viewType == vk::ImageViewType::eCubeArray;
+		if (!validType || (!isArrayType && viewType != vk::ImageViewType::eCube && arrayLayerCount != 1))
+		{
+			s_errorCallback("GFX - create_texture_view() - View type does not fit the texture or the number of layers!");
+			return false;
+		}
+
+		const vk::ImageSubresourceRange vk_range{ texture->get_copy_aspect_mask(), range.baseMipLevel, mipLevelCount, range.baseArrayLayer, arrayLayerCount };
+		std::lock_guard lock(m_textureViewMutex);
+		outTextureViewHandle = { textureHandle, texture->find_or_add_view(viewType, format, vk_range) };
+		return true;
+	}
+
+	auto Device::get_resident_texture_info(const TextureInfo& textureInfo, std::uint32_t firstResidentMip) -> TextureInfo
+	{
+		auto residentTextureInfo = textureInfo;
+		residentTextureInfo.width = std::max(textureInfo.width >> firstResidentMip, 1u);
+		residentTextureInfo.height = std::max(textureInfo.height >> firstResidentMip, 1u);
+		residentTextureInfo.mipLevels = textureInfo.mipLevels - firstResidentMip;
+		return residentTextureInfo;
+	}
+
+	auto Device::get_resident_size(const TextureInfo& textureInfo, std::uint32_t firstResidentMip) -> std::uint64_t
+	{
+		const auto format = get_texture_format(textureInfo);
+		const auto layerCount = textureInfo.type == TextureType::eCube ? textureInfo.arrayLayers * 6 : textureInfo.arrayLayers;
+		std::uint64_t size{ 0 };
+		for (auto mipLevel = firstResidentMip; mipLevel < textureInfo.mipLevels; ++mipLevel)
+		{
+			size += get_texture_level_size(format, std::max(textureInfo.width >> mipLevel, 1u), std::max(textureInfo.height >> mipLevel, 1u)) * layerCount;
+		}
+		return size;
+	}
+
+	bool Device::create_streaming_texture(TextureHandle& outTextureHandle, const TextureInfo& textureInfo, std::uint32_t firstResidentMip)
+	{
+		if (!validate_texture_info(textureInfo))
+		{
+			return false;
+		}
+		if ((textureInfo.type != TextureType::e2D && textureInfo.type != TextureType::eCube) || textureInfo.usage != TextureUsage::eTexture || textureInfo.sparse ||
+			textureInfo.memory == TextureMemory::eTransient)
+		{
+			s_errorCallback("GFX - create_streaming_texture() - Only sampled 2D and cube textures can be streamed!");
+			return false;
+		}
+
+		StreamingTexture streamingTexture{ textureInfo, firstResidentMip };
+		if (streamingTexture.textureInfo.mipLevels == 0)
+		{
+			streamingTexture.textureInfo.mipLevels = std::bit_width(std::max(textureInfo.width, textureInfo.height));
+		}
+		if (textureInfo.memoryPriority == DEFAULT_MEMORY_PRIORITY)
+		{
+			streamingTexture.textureInfo.memoryPriority = STREAMING_TEXTURE_MEMORY_PRIORITY;
+		}
+		if (firstResidentMip >= streamingTexture.textureInfo.mipLevels)
+		{
+			s_errorCallback("GFX - create_streaming_texture() - First resident mip is out of range!");
+			return false;
+		}
+
+		if (!create_texture(outTextureHandle, get_resident_texture_info(streamingTexture.textureInfo, firstResidentMip)))
+		{
+			return false;
+		}
+		std::lock_guard lock(m_streamingTextureMutex);
+		m_streamingTextures[outTextureHandle] = streamingTexture;
+		return true;
+	}
+
+	auto Device::get_texture_first_resident_mip(TextureHandle textureHandle) -> std::uint32_t
+	{
+		std::lock_guard lock(m_streamingTextureMutex);
+		const auto it = m_streamingTextures.find(textureHandle);
+		return it != m_streamingTextures.end() ? it->second.firstResidentMip : 0;
+	}
+
+	auto Device::stream_texture_mips(TextureHandle textureHandle, std::uint32_t firstResidentMip, std::span<const std::span<const std::byte>> levelData, std::uint32_t queueIndex) -> SyncPoint
+	{
+		StreamingTexture streamingTexture{};
+		{
+			std::lock_guard lock(m_streamingTextureMutex);
+			const auto it = m_streamingTextures.find(textureHandle);
+			if (it == m_streamingTextures.end())
+			{
+				s_errorCallback("GFX - stream_texture_mips() - Texture was not created with create_streaming_texture()!");
+				return {};
+			}
+			streamingTexture = it->second;
+		}
+		Texture* texture{ nullptr };
+		if (!get_texture(texture, textureHandle))
+		{
+			return {};
+		}
+		if (queueIndex >= m_queues.size())
+		{
+			s_errorCallback("GFX - Invalid queue index!");
+			return {};
+		}
+
+		const auto& textureInfo = streamingTexture.textureInfo;
+		const auto oldFirstResidentMip = streamingTexture.firstResidentMip;
+		if (firstResidentMip >= textureInfo.mipLevels)
+		{
+			s_errorCallback("GFX - stream_texture_mips() - First resident mip is out of range!");
+			return {};
+		}
+		if (firstResidentMip == oldFirstResidentMip)
+		{
+			return {};
+		}
+		const auto gainedLevelCount = firstResidentMip < oldFirstResidentMip ? oldFirstResidentMip - firstResidentMip : 0u;
+		if (levelData.size() != gainedLevelCount)
+		{
+			s_errorCallback("GFX - stream_texture_mips() - levelData must hold exactly the levels being made resident!");
+			return {};
+		}
+		for (const auto& level : levelData)
+		{
+			GFX_COUNT_SHARED_STAT(m_currentFrameStats.uploadBytes, level.size());
+		}
+
+		// Gained levels are the first ones of the resident texture, staged back to back aligned for any texel block size.
+		Texture residentTexture(*this, get_resident_texture_info(textureInfo, firstResidentMip));
+		constexpr std::uint64_t ALIGNMENT = 16;
+		std::vector<std::uint64_t> stagingOffsets(gainedLevelCount);
+		std::uint64_t stagingSize{ 0 };
+		for (auto mipLevel = 0u; mipLevel < gainedLevelCount; ++mipLevel)
+		{
+			if (levelData[mipLevel].size() < residentTexture.get_upload_level_size(mipLevel))
+			{
+				s_errorCallback("GFX - stream_texture_mips() - Level data is smaller than its mip level!");
+				return {};
+			}
+			const auto stagedSize = residentTexture.is_format_promoted() ? residentTexture.get_level_size(mipLevel) : levelData[mipLevel].size();
+			stagingOffsets[mipLevel] = stagingSize;
+			stagingSize = (stagingSize + stagedSize + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		}
+
+		BufferHandle stagingBufferHandle{};
+		Buffer* stagingBuffer{ nullptr };
+		if (gainedLevelCount > 0)
+		{
+			if (!create_buffer(stagingBufferHandle, { .type = BufferType::eUpload, .size = stagingSize }) || !get_buffer(stagingBuffer, stagingBufferHandle))
+			{
+				return {};
+			}
+			auto* stagingPtr = static_cast<std::byte*>(stagingBuffer->get_mapped_pointer());
+			for (auto mipLevel = 0u; mipLevel < gainedLevelCount; ++mipLevel)
+			{
+				const auto dataSize = residentTexture.is_format_promoted() ? residentTexture.get_upload_level_size(mipLevel) : levelData[mipLevel].size();
+				stage_texels(residentTexture, stagingPtr + stagingOffsets[mipLevel], levelData[mipLevel].data(), dataSize);
+			}
+			if (m_allocator->flushAllocation(stagingBuffer->get_allocation(), 0, stagingSize) != vk::Result::eSuccess)
+			{
+				s_errorCallback("GFX - stream_texture_mips() - Failed to write to staging buffer!");
+				destroy_buffer(stagingBufferHandle);
+				return {};
+			}
+		}
+
+		CommandListHandle commandListHandle{};
+		CommandList* commandList{ nullptr };
+		if (!create_command_list(commandListHandle, queueIndex, CommandListFlags_FireAndForget) || !get_command_list(commandList, commandListHandle))
+		{
+			if (stagingBuffer != nullptr)
+			{
+				destroy_buffer(stagingBufferHandle);
+			}
+			return {};
+		}
+
+		// Levels resident both before and after are copied over, at their index in each image.
+		const auto keptFirstMip = std::max(firstResidentMip, oldFirstResidentMip);
+		commandList->begin();
+		commandList->transition_texture(&residentTexture, TextureState::eUploadDst);
+		for (auto mipLevel = 0u; mipLevel < gainedLevelCount; ++mipLevel)
+		{
+			commandList->copy_buffer_to_texture(stagingBuffer, &residentTexture, stagingOffsets[mipLevel], mipLevel);
+		}
+		commandList->transition_texture(texture, TextureState::eCopySrc);
+		commandList->copy_texture_levels(texture, keptFirstMip - oldFirstResidentMip, &residentTexture, keptFirstMip - firstResidentMip, textureInfo.mipLevels - keptFirstMip);
+		commandList->transition_texture(texture, TextureState::eShaderRead);
+		commandList->transition_texture(&residentTexture, TextureState::eShaderRead);
+		commandList->end();
+
+		const SubmitBatch batch{ .commandLists = { &commandListHandle, 1 } };
+		const auto syncPoint = submit_command_lists(queueIndex, { &batch, 1 });
+
+		// Swapped in place so the handle stays valid. Work already submitted keeps using the old image until it retires.
+		if (texture->get_allocation())
+		{
+			unregister_allocation(texture->get_allocation(), true);
+		}
+		invalidate_texture_bundles(*texture);
+		auto retiredTexture = std::make_shared<Texture>(std::move(*texture));
+		*texture = std::move(residentTexture);
+		texture->copy_views(*retiredTexture);
+		register_allocation(texture->get_allocation(), textureHandle.resourceHandle, true);
+		// Rather than stalling on every queue to rewrite the descriptors now, the rewrite is queued behind the submissions in
+		// flight, this one included. Until then descriptors keep sampling the retired image, which stays in eShaderRead and
+		// alive until the submissions in flight at the rewrite have retired too.
+		defer_destroy([this, textureHandle, retiredTexture] {
+			if (m_texturePool.get_checked(textureHandle.resourceHandle) != nullptr)
+			{
+				rebind_descriptors(textureHandle.resourceHandle, true, false);
+			}
+			std::function<void()> destroyFunc = [retiredTexture]() mutable { retiredTexture.reset(); };
+			// VMA still owns both ends of a texture that is being moved, so it has to outlive the pass.
+			if (!m_defragmenter || !m_defragmenter->postpone_destroy(retiredTexture->get_allocation(), destroyFunc))
+			{
+				defer_destroy(std::move(destroyFunc));
+			}
+		});
+
+		if (stagingBuffer != nullptr)
+		{
+			destroy_buffer(stagingBufferHandle);
+		}
+		{
+			std::lock_guard lock(m_streamingTextureMutex);
+			if (const auto it = m_streamingTextures.find(textureHandle); it != m_streamingTextures.end())
+			{
+				it->second.firstResidentMip = firstResidentMip;
+			}
+		}
+		return syncPoint;
+	}
+
+	auto Device::fit_texture_streaming_budget(std::span<TextureStreamingRequest> requests, float budgetFraction) -> std::uint64_t
+	{
+		MemoryStats memoryStats{};
+		get_memory_stats(memoryStats);
+		std::uint64_t budget{ 0 };
+		std::uint64_t usage{ 0 };
+		for (const auto& heap : memoryStats.heaps)
+		{
+			if (heap.deviceLocal)
+			{
+				budget += heap.budget;
+				usage += heap.usage;
+			}
+		}
+
+		std::lock_guard lock(m_streamingTextureMutex);
+		std::vector<TextureInfo*> textureInfos(requests.size(), nullptr);
+		std::uint64_t residentBytes{ 0 };
+		std::uint64_t wantedBytes{ 0 };
+		for (auto i = 0; i < requests.size(); ++i)
+		{
+			const auto it = m_streamingTextures.find(requests[i].textureHandle);
+			if (it == m_streamingTextures.end())
+			{
+				continue;
+			}
+			auto& textureInfo = it->second.textureInfo;
+			textureInfos[i] = &textureInfo;
+			requests[i].wantedMip = std::min(requests[i].wantedMip, textureInfo.mipLevels - 1);
+			residentBytes += get_resident_size(textureInfo, it->second.firstResidentMip);
+			wantedBytes += get_resident_size(textureInfo, requests[i].wantedMip);
+		}
+
+		// What the requested textures use now is given back when they are streamed, so it counts as available.
+		const auto otherUsage = usage > residentBytes ? usage - residentBytes : 0;
+		const auto streamingBudget = std::uint64_t(double(budget) * budgetFraction);
+		const auto available = streamingBudget > otherUsage ? streamingBudget - otherUsage : 0;
+		while (wantedBytes > available)
+		{
+			auto victim = requests.size();
+			std::uint64_t victimSaving{ 0 };
+			for (auto i = 0; i < requests.size(); ++i)
+			{
+				if (textureInfos[i] == nullptr || requests[i].wantedMip + 1 >= textureInfos[i]->mipLevels)
+				{
+					continue;
+				}
+				const auto saving = get_resident_size(*textureInfos[i], requests[i].wantedMip) - get_resident_size(*textureInfos[i], requests[i].wantedMip + 1);
+				if (victim == requests.size() || requests[i].priority < requests[victim].priority || (requests[i].priority == requests[victim].priority && saving > victimSaving))
+				{
+					victim = i;
+					victimSaving = saving;
+				}
+			}
+			if (victim == requests.size())
+			{
+				break; // Everything is down to its smallest level.
+			}
+			++requests[victim].wantedMip;
+			wantedBytes -= victimSaving;
+		}
+
+		// The coldest textures get the lowest priorities, so under memory pressure they are paged out first. Kept in the
+		// texture info, so the textures stream_texture_mips() swaps in keep them.
+		if (m_pageableMemorySupported)
+		{
+			float maxPriority{ 0.0f };
+			for (auto i = 0; i < requests.size(); ++i)
+			{
+				if (textureInfos[i] != nullptr)
+				{
+					maxPriority = std::max(maxPriority, requests[i].priority);
+				}
+			}
+			for (auto i = 0; i < requests.size(); ++i)
+			{
+				if (textureInfos[i] == nullptr || maxPriority <= 0.0f)
+				{
+					continue;
+				}
+				const auto memoryPriority = STREAMING_TEXTURE_MEMORY_PRIORITY * std::clamp(requests[i].priority / maxPriority, 0.0f, 1.0f);
+				if (memoryPriority != textureInfos[i]->memoryPriority && set_memory_priority(requests[i].textureHandle, memoryPriority))
+				{
+					textureInfos[i]->memoryPriority = memoryPriority;
+				}
+			}
+		}
+		return wantedBytes;
+	}
+
+	bool Device::create_sampler(SamplerHandle& outSamplerHandle, const SamplerInfo& samplerInfo)
+	{
+		if (samplerInfo.minLod > samplerInfo.maxLod)
+		{
+			s_errorCallback("GFX - create_sampler() - minLod must not be above maxLod!");
+			return false;
+		}
+
+		const auto hash = std::hash<SamplerInfo>{}(samplerInfo);
+		std::lock_guard lock(m_samplerCacheMutex);
+		const auto [first, last] = m_samplerCache.equal_range(hash);
+		for (auto it = first; it != last; ++it)
+		{
+			if (it->second.samplerInfo == samplerInfo)
+			{
+				it->second.refCount += 1;
+				outSamplerHandle = it->second.samplerHandle;
+				return true;
+			}
+		}
+
+		vk::SamplerCreateInfo vk_sampler_info{};
+		vk_sampler_info.setAddressModeU(samplerInfo.addressMode == SamplerAddressMode::eRepeat ? vk::SamplerAddressMode::eRepeat : vk::SamplerAddressMode::eClampToEdge);
+		vk_sampler_info.setAddressModeV(samplerInfo.addressMode == SamplerAddressMode::eRepeat ? vk::SamplerAddressMode::eRepeat : vk::SamplerAddressMode::eClampToEdge);
+		vk_sampler_info.setAddressModeW(samplerInfo.addressMode == SamplerAddressMode::eRepeat ? vk::SamplerAddressMode::eRepeat : vk::SamplerAddressMode::eClampToEdge);
+		vk_sampler_info.setMinFilter(samplerInfo.filterMode == SamplerFilterMode::eLinear ? vk::Filter::eLinear : vk::Filter::eNearest);
+		vk_sampler_info.setMagFilter(samplerInfo.filterMode == SamplerFilterMode::eLinear ? vk::Filter::eLinear : vk::Filter::eNearest);
+		vk_sampler_info.setMipmapMode(samplerInfo.mipFilterMode == SamplerFilterMode::eLinear ? vk::SamplerMipmapMode::eLinear : vk::SamplerMipmapMode::eNearest);
+		vk_sampler_info.setMipLodBias(samplerInfo.mipLodBias);
+		vk_sampler_info.setMinLod(samplerInfo.minLod);
+		vk_sampler_info.setMaxLod(samplerInfo.maxLod);
+		// Without the feature anisotropy is quietly left off, it only affects quality.
+		if (samplerInfo.maxAnisotropy > 1.0f && m_maxSamplerAnisotropy > 0.0f)
+		{
+			vk_sampler_info.setAnisotropyEnable(true);
+			vk_sampler_info.setMaxAnisotropy(std::min(samplerInfo.maxAnisotropy, m_maxSamplerAnisotropy));
+		}
+		if (samplerInfo.compareOp != SamplerCompareOp::eNone)
+		{
+			vk_sampler_info.setCompareEnable(true);
+			vk_sampler_info.setCompareOp(convert_sampler_compare_op_to_vk_compare_op(samplerInfo.compareOp));
+		}
+
+		outSamplerHandle = SamplerHandle(m_deviceHandle, m_samplerPool.emplace(m_device->createSamplerUnique(vk_sampler_info).value));
+		if (CAST_HANDLE_TO_INT(outSamplerHandle.resourceHandle) == 0)
+		{
+			return false;
+		}
+		GFX_COUNT_SHARED_STAT(m_currentFrameStats.resourcesCreated, 1);
+		m_samplerCache.emplace(hash, CachedSampler{ samplerInfo, outSamplerHandle, 1 });
+		if (m_bindlessHeap)
+		{
+			m_bindlessHeap->write_sampler(outSamplerHandle.resourceHandle, m_samplerPool.get_checked(outSamplerHandle.resourceHandle)->get());
+		}
+		return true;
+	}
+
+	void Device::destroy_sampler(SamplerHandle samplerHandle)
+	{
+		{
+			std::lock_guard lock(m_samplerCacheMutex);
+			const auto it = std::find_if(m_samplerCache.begin(), m_samplerCache.end(), [&](const auto& pair) { return pair.second.samplerHandle == samplerHandle; });
+			if (it == m_samplerCache.end())
+			{
+				s_errorCallback("GFX - destroy_sampler() - Unknown sampler!");
+				return;
+			}
+			if (--it->second.refCount > 0)
+			{
+				return;
+			}
+			m_samplerCache.erase(it);
+		}
+		evict_cached_descriptor_sets([&](const DescriptorWrite& write) { return write.samplerHandle == samplerHandle; });
+		defer_destroy([this, resourceHandle = samplerHandle.resourceHandle] {
+			if (m_bindlessHeap)
+			{
+				m_bindlessHeap->remove(BINDLESS_SAMPLER_BINDING, resourceHandle);
+			}
+			m_samplerPool.erase(resourceHandle);
+		});
+	}
+
+	bool Device::create_swap_chain(SwapChainHandle& outSwapChainHandle, const SwapChainInfo& swapChainInfo)
+	{
+		if (is_compute_only())
+		{
+			s_errorCallback("GFX - Compute-only devices cannot create swap chains!");
+			return false;
+		}
+		if (!swapChainInfo.headless && m_context->is_headless())
+		{
+			s_errorCallback("GFX - Only headless swap chains can be created without the window system!");
+			return false;
+		}
+
+		outSwapChainHandle = SwapChainHandle(m_deviceHandle, m_swapChainPool.emplace(*this, swapChainInfo));
+		if (CAST_HANDLE_TO_INT(outSwapChainHandle.resourceHandle) == 0)
+		{
+			return false;
+		}
+		return true;
+	}
+
+	void Device::destroy_swap_chain(SwapChainHandle swapChainHandle)
+	{
+		if (auto* swapChain = m_swapChainPool.get_checked(swapChainHandle.resourceHandle); swapChain != nullptr)
+		{
+			swapChain->wait_for_present();
+		}
+		defer_destroy([this, resourceHandle = swapChainHandle.resourceHandle] { m_swapChainPool.erase(resourceHandle); });
+	}
+
+	bool Device::get_swap_chain(SwapChain*& outSwapChain, SwapChainHandle swapChainHandle)
+	{
+		outSwapChain = m_swapChainPool.get_checked(swapChainHandle.resourceHandle);
+		return outSwapChain != nullptr;
+	}
+
+	bool Device::get_render_pass_attachments(InlineVector<Texture*, MAX_COLOR_ATTACHMENTS>& outColorAttachments, Texture*& outDepthAttachment, const RenderPassInfo& renderPassInfo)
+	{
+		if (is_compute_only())
+		{
+			s_errorCallback("GFX - Compute-only devices cannot begin render passes!");
+			return false;
+		}
+		if (renderPassInfo.viewMask != 0 && std::uint32_t(std::bit_width(renderPassInfo.viewMask)) > m_properties.maxMultiviewViewCount)
+		{
+			s_errorCallback("GFX - RenderPassInfo::viewMask needs DeviceFeatureFlags_Multiview and views below DeviceProperties::maxMultiviewViewCount!");
+			return false;
+		}
+		if (renderPassInfo.localRead && !supports_local_read())
+		{
+			s_errorCallback("GFX - RenderPassInfo::localRead needs DeviceFeatureFlags_LocalRead!");
+			return false;
+		}
+		const auto layerCount = std::max(std::uint32_t(std::bit_width(renderPassInfo.viewMask)), 1u);
+
+		outColorAttachments.clear();
+		for (const auto& colorAttachment : renderPassInfo.colorAttachments)
+		{
+			if (colorAttachment == 0)
+			{
+				break;
+			}
+
+			Texture* texture{ nullptr };
+			if (!get_texture(texture, colorAttachment))
+			{
+				GFX_ASSERT(false, "Failed to get Texture for color attachment from handle!");
+				return false;
+			}
+			if (!is_attachment_view(texture, renderPassInfo.colorAttachmentViews[outColorAttachments.size()], layerCount))
+			{
+				s_errorCallback("GFX - Color attachment view must be a single mip level and layer (or a layer per view) in the texture's format!");
+				return false;
+			}
+			outColorAttachments.push_back(texture);
+		}
+
+		outDepthAttachment = nullptr;
+		if (renderPassInfo.depthAttachment != 0 && !get_texture(outDepthAttachment, renderPassInfo.depthAttachment))
+		{
+			GFX_ASSERT(false, "Failed to get Texture for depth attachment from handle!");
+			return false;
+		}
+		if (outDepthAttachment != nullptr && !is_attachment_view(outDepthAttachment, renderPassInfo.depthAttachmentView, layerCount))
+		{
+			s_errorCallback("GFX - Depth attachment view must be a single mip level and layer (or a layer per view) in the texture's format!");
+			return false;
+		}
+		if (outColorAttachments.empty() && outDepthAttachment == nullptr && (renderPassInfo.renderArea[2] == 0 || renderPassInfo.renderArea[3] == 0))
+		{
+			s_errorCallback("GFX - A render pass without attachments needs RenderPassInfo::renderArea!");
+			return false;
+		}
+
+		return true;
+	}
+
+	bool Device::is_attachment_view(const Texture* texture, std::uint32_t viewIndex, std::uint32_t layerCount)
+	{
+		if (viewIndex == 0)
+		{
+			return layerCount == 1 || texture->get_view_range(0).layerCount >= layerCount; // Multiview renders into the layers from the first.
+		}
+		if (viewIndex >= texture->get_view_count())
+		{
+			return false;
+		}
+		// The secondary command list inheritance and pipelines only know the texture's format.
+		const auto range = texture->get_view_range(viewIndex);
+		const bool coversLayers = layerCount == 1 ? range.layerCount == 1 : range.layerCount >= layerCount;
+		return range.levelCount == 1 && coversLayers && texture->get_view_format(viewIndex) == texture->get_format();
+	}
+
+	bool Device::get_render_pass_shading_rate_attachment(ShadingRateAttachment& outShadingRateAttachment, const RenderPassInfo& renderPassInfo)
+	{
+		outShadingRateAttachment = {};
+		if (renderPassInfo.shadingRateAttachment == 0)
+		{
+			return true;
+		}
+		if (!supports_shading_rate())
+		{
+			s_errorCallback("GFX - A shading rate attachment needs DeviceFeatureFlags_ShadingRate!");
+			return false;
+		}
+
+		Texture* texture{ nullptr };
+		if (!get_texture(texture, renderPassInfo.shadingRateAttachment))
+		{
+			GFX_ASSERT(false, "Failed to get Texture for shading rate attachment from handle!");
+			return false;
+		}
+		if (!(texture->get_usage_flags() & vk::ImageUsageFlagBits::eFragmentShadingRateAttachmentKHR))
+		{
+			s_errorCallback("GFX - Shading rate attachment must be a TextureUsage::eShadingRate texture!");
+			return false;
+		}
+		outShadingRateAttachment = { texture, m_shadingRateTexelSize };
+		return true;
+	}
+
+	bool Device::get_render_pass_resolve_attachments(InlineVector<Texture*, MAX_COLOR_ATTACHMENTS>& outResolveAttachments, std::span<Texture* const> colorAttachments, const RenderPassInfo& renderPassInfo)
+	{
+		outResolveAttachments.clear();
+		const auto hasResolves = std::any_of(renderPassInfo.resolveAttachments.begin(), renderPassInfo.resolveAttachments.begin() + colorAttachments.size(), [](TextureHandle handle) { return handle != 0; });
+		if (!hasResolves)
+		{
+			return true;
+		}
+
+		for (auto i = 0u; i < colorAttachments.size(); ++i)
+		{
+			Texture* resolveTexture{ nullptr };
+			if (renderPassInfo.resolveAttachments[i] != 0)
+			{
+				if (!get_texture(resolveTexture, renderPassInfo.resolveAttachments[i]))
+				{
+					GFX_ASSERT(false, "Failed to get Texture for resolve attachment from handle!");
+					return false;
+				}
+
+				const auto* colorTexture = colorAttachments[i];
+				const auto colorExtent = colorTexture->get_mip_extent(colorTexture->get_view_range(renderPassInfo.colorAttachmentViews[i]).baseMipLevel);
+				const auto resolveExtent = resolveTexture->get_extent();
+				if (colorTexture->get_sample_count() == vk::SampleCountFlagBits::e1 || resolveTexture->get_sample_count() != vk::SampleCountFlagBits::e1)
+				{
+					s_errorCallback("GFX - Only multisampled color attachments can be resolved, into single-sampled textures!");
+					return false;
+				}
+				if (resolveTexture->get_format() != colorTexture->get_format() || resolveExtent.width != colorExtent.width || resolveExtent.height != colorExtent.height)
+				{
+					s_errorCallback("GFX - Resolve attachments must match the format and extent of their color attachment!");
+					return false;
+				}
+			}
+			outResolveAttachments.push_back(resolveTexture);
+		}
+		return true;
+	}
+
+	auto Device::create_semaphore() -> SemaphoreHandle
+	{
+		vk::UniqueSemaphore semaphore{};
+		{
+			std::lock_guard lock(m_freeSemaphoreMutex);
+			if (!m_freeSemaphores.empty())
+			{
+				semaphore = std::move(m_freeSemaphores.back());
+				m_freeSemaphores.pop_back();
+			}
+		}
+		if (!semaphore)
+		{
+			vk::SemaphoreCreateInfo semaphore_info{};
+			semaphore = m_device->createSemaphoreUnique(semaphore_info).value;
+		}
+		const auto resourceHandle = m_semaphorePool.emplace(std::move(semaphore));
+		if (CAST_HANDLE_TO_INT(resourceHandle) == 0)
+		{
+			std::lock_guard lock(m_freeSemaphoreMutex);
+			m_freeSemaphores.push_back(std::move(semaphore));
+			return {};
+		}
+		return SemaphoreHandle(m_deviceHandle, resourceHandle);
+	}
+
+	auto Device::get_queue_index(vk::Queue queue) const -> std::uint32_t
+	{
+		const auto it = std::ranges::find(m_queues, queue);
+		GFX_ASSERT(it != m_queues.end(), "Queue does not belong to this device!");
+		return static_cast<std::uint32_t>(std::distance(m_queues.begin(), it));
+	}
+
+	auto Device::get_submit_values() const -> QueueSubmitValues
+	{
+		QueueSubmitValues submitValues{};
+		for (auto i = 0; i < m_queueTimelines.size(); ++i)
+		{
+			submitValues[i] = m_queueTimelines[i].submitValue.load();
+		}
+		return submitValues;
+	}
+
+	auto Device::get_completed_submit_value(std::uint32_t queueIndex) const -> std::uint64_t
+	{
+		return m_device->getSemaphoreCounterValue(m_queueTimelines[queueIndex].semaphore.get()).value;
+	}
+
+	bool Device::are_submit_values_complete(const QueueSubmitValues& submitValues) const
+	{
+		for (auto i = 0; i < m_queueTimelines.size(); ++i)
+		{
+			if (submitValues[i] != 0 && get_completed_submit_value(i) < submitValues[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void Device::wait_on_submit_values(const QueueSubmitValues& submitValues)
+	{
+		InlineVector<vk::Semaphore, MAX_QUEUES> semaphores{};
+		InlineVector<std::uint64_t, MAX_QUEUES> values{};
+		for (auto i = 0; i < m_queueTimelines.size(); ++i)
+		{
+			if (submitValues[i] != 0)
+			{
+				semaphores.push_back(m_queueTimelines[i].semaphore.get());
+				values.push_back(submitValues[i]);
+			}
+		}
+		if (semaphores.empty())
+		{
+			return;
+		}
+
+		vk::SemaphoreWaitInfo wait_info{};
+		wait_info.setSemaphores(semaphores);
+		wait_info.setValues(values);
+		if (wait_semaphores(wait_info, std::numeric_limits<std::uint64_t>::max()) == vk::Result::eErrorDeviceLost)
+		{
+			// Some of the values will never be signalled, but whatever did reach the queues can still be waited for.
+			auto result = m_device->waitIdle();
+			GFX_UNUSED(result);
+		}
+	}
+
+	auto Device::wait_semaphores(const vk::SemaphoreWaitInfo& waitInfo, std::uint64_t timeoutNs) const -> vk::Result
+	{
+		// Waited in slices, so a wait on a value the device lost is not left blocking forever.
+		constexpr std::uint64_t WAIT_SLICE_NS = 100'000'000;
+		auto remainingNs = timeoutNs;
+		while (!is_device_lost())
+		{
+			const auto sliceNs = std::min(remainingNs, WAIT_SLICE_NS);
+			const auto result = m_device->waitSemaphores(waitInfo, sliceNs);
+			if (result != vk::Result::eTimeout || sliceNs == remainingNs)
+			{
+				return result;
+			}
+			remainingNs -= sliceNs;
+		}
+		return vk::Result::eErrorDeviceLost;
+	}
+
+	void Device::mark_device_lost()
+	{
+		if (!m_deviceLost.exchange(true, std::memory_order_acq_rel))
+		{
+			s_errorCallback("GFX - The device is lost, the device must be destroyed and created again!");
+		}
+	}
+
+	auto Device::get_thread_command_pool(std::uint32_t queueFamily, bool transient) -> CommandPool&
+	{
+		std::lock_guard lock(m_commandPoolMutex);
+		return get_thread_command_pool_locked(queueFamily, get_frame_index(), transient);
+	}
+
+	auto Device::get_thread_command_pool_locked(std::uint32_t queueFamily, std::uint32_t frameIndex, bool transient) -> CommandPool&
+	{
+		const CommandPoolKey key{ std::this_thread::get_id(), queueFamily, frameIndex, transient };
+		auto& commandPool = m_commandPools[key];
+		if (commandPool == nullptr)
+		{
+			commandPool = std::make_unique<CommandPool>(m_device.get(), queueFamily, m_physicalDevice.getQueueFamilyProperties()[queueFamily].queueFlags, transient);
+		}
+		return *commandPool;
+	}
+
+	void Device::invalidate_bundles(std::uint64_t resourceKey)
+	{
+		std::lock_guard lock(m_bundleMutex);
+		for (const auto bundleHandle : m_bundles)
+		{
+			auto* bundle = m_bundlePool.get_checked(bundleHandle.resourceHandle);
+			if (bundle == nullptr || (!bundle->is_valid() && !bundle->is_recording()))
+			{
+				continue;
+			}
+
+			CommandList* commandList{ nullptr };
+			if (get_command_list(commandList, bundle->get_command_list()) && commandList->references_resource(resourceKey))
+			{
+				bundle->set_valid(false);
+				bundle->set_recording(false);
+			}
+		}
+	}
+
+	void Device::invalidate_texture_bundles(const Texture& texture)
+	{
+		for (std::uint32_t i = 0; i < texture.get_view_count(); ++i)
+		{
+			invalidate_bundles(get_resource_key(texture.get_view(i)));
+		}
+	}
+
+	void Device::invalidate_descriptor_set_bundles(ResourceHandle resourceHandle, bool isTexture)
+	{
+		std::vector<std::uint64_t> setKeys{};
+		{
+			std::lock_guard lock(m_descriptorBindingMutex);
+			for (const auto& [key, binding] : m_descriptorBindings)
+			{
+				const auto boundHandle = binding.isTexture ? binding.write.textureHandle.resourceHandle : binding.write.bufferHandle.resourceHandle;
+				const auto* descriptorSet = m_descriptorSetPool.get_checked(binding.descriptorSetHandle.resourceHandle);
+				if (binding.isTexture == isTexture && boundHandle == resourceHandle && descriptorSet != nullptr && descriptorSet->set)
+				{
+					setKeys.push_back(get_resource_key(descriptorSet->set));
+				}
+			}
+		}
+		for (const auto setKey : setKeys)
+		{
+			invalidate_bundles(setKey);
+		}
+	}
+
+	void Device::get_memory_stats(MemoryStats& outMemoryStats) const
+	{
+		const auto* memory_properties = m_allocator->getMemoryProperties();
+		const auto budgets = m_allocator->getHeapBudgets();
+
+		outMemoryStats.heaps.resize(memory_properties->memoryHeapCount);
+		for (auto i = 0u; i < memory_properties->memoryHeapCount; ++i)
+		{
+			const auto& heap = memory_properties->memoryHeaps[i];
+			const auto& budget = budgets[i];
+			auto& heapStats = outMemoryStats.heaps[i];
+			heapStats.deviceLocal = bool(heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+			heapStats.size = heap.size;
+			heapStats.usage = budget.usage;
+			heapStats.budget = budget.budget;
+			heapStats.blockBytes = budget.statistics.blockBytes;
+			heapStats.allocationBytes = budget.statistics.allocationBytes;
+			heapStats.allocationCount = budget.statistics.allocationCount;
+		}
+
+		outMemoryStats.budgetFromDriver = m_memoryBudgetSupported;
+		outMemoryStats.bufferBytes = m_bufferBytes.load(std::memory_order_relaxed);
+		outMemoryStats.bufferCount = m_bufferCount.load(std::memory_order_relaxed);
+		outMemoryStats.textureBytes = m_textureBytes.load(std::memory_order_relaxed);
+		outMemoryStats.textureCount = m_textureCount.load(std::memory_order_relaxed);
+	}
+
+	bool Device::set_memory_priority(BufferHandle bufferHandle, float memoryPriority)
+	{
+		Buffer* buffer{ nullptr };
+		if (!get_buffer(buffer, bufferHandle))
+		{
+			return false;
+		}
+		if (!buffer->has_dedicated_memory())
+		{
+			return false;
+		}
+		return set_allocation_priority(buffer->get_allocation(), memoryPriority);
+	}
+
+	bool Device::set_memory_priority(TextureHandle textureHandle, float memoryPriority)
+	{
+		Texture* texture{ nullptr };
+		if (!get_texture(texture, textureHandle))
+		{
+			return false;
+		}
+		if (!texture->has_dedicated_memory())
+		{
+			return false;
+		}
+		return set_allocation_priority(texture->get_allocation(), memoryPriority);
+	}
+
+	bool Device::set_allocation_priority(vma::Allocation allocation, float memoryPriority)
+	{
+		if (!m_pageableMemorySupported)
+		{
+			return false;
+		}
+		const auto allocation_info = m_allocator->getAllocationInfo(allocation);
+		m_device->setMemoryPriorityEXT(allocation_info.deviceMemory, std::clamp(memoryPriority, 0.0f, 1.0f));
+		return true;
+	}
+
+	bool Device::dump_memory_report(std::string_view path)
+	{
+		MemoryStats memoryStats{};
+		get_memory_stats(memoryStats);
+
+		char* vmaStats = m_allocator->buildStatsString(VK_TRUE);
+		std::ofstream file{ std::filesystem::path(path), std::ios::trunc };
+		file << "{\n\"gfx\": {"
+			 << " \"bufferCount\": " << memoryStats.bufferCount << ", \"bufferBytes\": " << memoryStats.bufferBytes
+			 << ", \"textureCount\": " << memoryStats.textureCount << ", \"textureBytes\": " << memoryStats.textureBytes
+			 << " },\n\"vma\": " << vmaStats << "\n}\n";
+		m_allocator->freeStatsString(vmaStats);
+		if (!file)
+		{
+			s_errorCallback("GFX - dump_memory_report() - Failed to write the report!");
+			return false;
+		}
+		return true;
+	}
+
+	bool Device::begin_capture(std::string_view path)
+	{
+		if (m_captureWriter != nullptr)
+		{
+			s_errorCallback("GFX - begin_capture() - A capture is already being recorded!");
+			return false;
+		}
+		m_captureWriter = std::make_unique<CaptureWriter>(std::string(path));
+		return true;
+	}
+
+	bool Device::end_capture()
+	{
+		if (m_captureWriter == nullptr)
+		{
+			s_errorCallback("GFX - end_capture() - No capture is being recorded!");
+			return false;
+		}
+		const auto captureWriter = std::move(m_captureWriter);
+		if (!captureWriter->save(m_deviceInfo))
+		{
+			s_errorCallback("GFX - end_capture() - Failed to write the capture!");
+			return false;
+		}
+		return true;
+	}
+
+	void Device::capture_buffer_contents(BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t size)
+	{
+		const auto* buffer = m_bufferPool.get_checked(bufferHandle.resourceHandle);
+		if (m_captureWriter == nullptr || buffer == nullptr || !buffer->is_host_visible() || offset >= buffer->get_size())
+		{
+			return;
+		}
+		size = std::min(size, buffer->get_size() - offset);
+
+		auto* mappedPtr = static_cast<const std::byte*>(buffer->get_mapped_pointer());
+		const bool mappedHere = mappedPtr == nullptr;
+		if (mappedHere)
+		{
+			// Mapping is reference counted by VMA, so this returns the application's mapping if it still has one.
+			mappedPtr = static_cast<const std::byte*>(m_allocator->mapMemory(buffer->get_allocation()).value);
+			if (mappedPtr == nullptr)
+			{
+				return;
+			}
+		}
+		m_captureWriter->record(CaptureOp::eWriteBuffer, bufferHandle, offset, std::span(mappedPtr + offset, size));
+		if (mappedHere)
+		{
+			m_allocator->unmapMemory(buffer->get_allocation());
+		}
+	}
+
+	void Device::capture_mapped_buffers()
+	{
+		if (m_captureWriter == nullptr)
+		{
+			return;
+		}
+		// Destroyed buffers are skipped by capture_buffer_contents(), their handles no longer resolve.
+		for (const auto bufferHandle : m_captureWriter->get_mapped_buffers())
+		{
+			capture_buffer_contents(bufferHandle, 0, WHOLE_SIZE);
+		}
+	}
+
+	void Device::register_allocation(vma::Allocation allocation, ResourceHandle resourceHandle, bool isTexture)
+	{
+		// Sparse resources have no allocation of their own.
+		if (!allocation)
+		{
+			return;
+		}
+		m_allocator->setAllocationUserData(allocation, Defragmenter::make_owner_tag(resourceHandle, isTexture));
+
+		// Names the allocation in the detailed map of dump_memory_report().
+		const auto& debugName = isTexture ? m_texturePool.get(resourceHandle)->get_debug_name() : m_bufferPool.get(resourceHandle)->get_debug_name();
+		const auto allocationName = std::string(isTexture ? "Texture" : "Buffer") + (debugName.empty() ? "" : " " + debugName);
+		m_allocator->setAllocationName(allocation, allocationName.c_str());
+
+		const auto size = m_allocator->getAllocationInfo(allocation).size;
+		(isTexture ? m_textureBytes : m_bufferBytes).fetch_add(size, std::memory_order_relaxed);
+		(isTexture ? m_textureCount : m_bufferCount).fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void Device::unregister_allocation(vma::Allocation allocation, bool isTexture)
+	{
+		if (!allocation)
+		{
+			return;
+		}
+		const auto size = m_allocator->getAllocationInfo(allocation).size;
+		(isTexture ? m_textureBytes : m_bufferBytes).fetch_sub(size, std::memory_order_relaxed);
+		(isTexture ? m_textureCount : m_bufferCount).fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	void Device::rebind_descriptors(ResourceHandle resourceHandle, bool isTexture, bool waitForGpu)
+	{
+		std::vector<DescriptorBinding> bindings{};
+		{
+			std::lock_guard lock(m_descriptorBindingMutex);
+			for (const auto& [key, binding] : m_descriptorBindings)
+			{
+				const auto boundHandle = binding.isTexture ? binding.write.textureHandle.resourceHandle : binding.write.bufferHandle.resourceHandle;
+				if (binding.isTexture == isTexture && boundHandle == resourceHandle)
+				{
+					bindings.push_back(binding);
+				}
+			}
+		}
+		const auto heapBinding = isTexture ? BINDLESS_TEXTURE_BINDING : BINDLESS_STORAGE_BUFFER_BINDING;
+		const bool inBindlessHeap = get_bindless_index(heapBinding, resourceHandle) != INVALID_BINDLESS_INDEX;
+		if (bindings.empty() && !inBindlessHeap)
+		{
+			return;
+		}
+
+		// Updating a descriptor set invalidates the command buffers it is bound in, including ones still executing. The
+		// bindless heap's slot is not invalidating, but may be in use.
+		if (waitForGpu)
+		{
+			wait_on_submit_values(get_submit_values());
+		}
+		if (inBindlessHeap)
+		{
+			if (isTexture)
+			{
+				m_bindlessHeap->write_texture(resourceHandle, m_texturePool.get(resourceHandle)->get_view());
+			}
+			else
+			{
+				const auto* buffer = m_bufferPool.get(resourceHandle);
+				m_bindlessHeap->write_buffer(resourceHandle, buffer->get_buffer(), buffer->get_size(), buffer->get_device_address());
+			}
+		}
+		for (const auto& binding : bindings)
+		{
+			update_descriptor_set(binding.descriptorSetHandle, { &binding.write, 1 });
+		}
+	}
+
+	auto Device::get_device_buffer_info(const BufferInfo& bufferInfo) const -> BufferInfo
+	{
+		// Descriptors in a descriptor buffer reference buffers by device address.
+		auto deviceBufferInfo = bufferInfo;
+		if (m_descriptorBuffer && (convert_buffer_type_to_vk_usage(bufferInfo.type) & (vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer)))
+		{
+			deviceBufferInfo.deviceAddress = true;
+		}
+		// Builds read their geometry by device address.
+		if (bufferInfo.accelerationStructureInput)
+		{
+			deviceBufferInfo.deviceAddress = true;
+		}
+		// Device local memory is host visible anyway, so buffers otherwise filled through staging are mapped and written in place.
+		if (m_properties.unifiedMemory && !bufferInfo.sparse &&
+			(bufferInfo.memory == BufferMemory::eDefault ? get_default_buffer_memory(bufferInfo.type) : bufferInfo.memory) == BufferMemory::eGpuOnly)
+		{
+			deviceBufferInfo.memory = BufferMemory::eDynamic;
+		}
+		deviceBufferInfo.memoryPriority = m_memoryPrioritySupported ? std::clamp(bufferInfo.memoryPriority, 0.0f, 1.0f) : DEFAULT_MEMORY_PRIORITY;
+		return deviceBufferInfo;
+	}
+
+	void Device::defer_destroy(std::function<void()>&& destroyFunc)
+	{
+		// Nothing in flight can reference the resource, so skip the queue.
+		const auto submitValues = get_submit_values();
+		if (are_submit_values_complete(submitValues))
+		{
+			destroyFunc();
+			return;
+		}
+
+		std::lock_guard lock(m_deferredDestroyMutex);
+		m_deferredDestroyQueue.push_back({ submitValues, std::move(destroyFunc) });
+	}
+
+	auto Device::get_descriptor_set_layout_binding(const DescriptorBindingInfo& descriptorBindingInfo) -> vk::DescriptorSetLayoutBinding
+	{
+		vk::DescriptorSetLayoutBinding outBinding{};
+		outBinding.setDescriptorType(convert_descriptor_type_to_vk_descriptor_type(descriptorBindingInfo.type));
+		outBinding.setDescriptorCount(descriptorBindingInfo.count);
+		outBinding.setStageFlags(convert_shader_stages_to_vk_shader_stage_flags(descriptorBindingInfo.shaderStages));
+		return outBinding;
+	}
+
+	DescriptorAllocator::DescriptorAllocator(vk::Device device, std::uint32_t initialSetsPerPool, bool inlineUniformBlocks)
+		: m_device(device), m_setsPerPool(initialSetsPerPool), m_inlineUniformBlocks(inlineUniformBlocks)
+	{
+	}
+
+	bool DescriptorAllocator::allocate(vk::DescriptorSet& outDescriptorSet, vk::DescriptorSetLayout descriptorSetLayout)
+	{
+		vk::DescriptorSetAllocateInfo set_alloc_info{};
+		set_alloc_info.setSetLayouts(descriptorSetLayout);
+		set_alloc_info.setDescriptorSetCount(1);
+
+		// A full pool fails with out of pool memory (or fragmented), then the next one is tried. A fresh one failing too
+		// means the set needs more descriptors than any pool holds.
+		while (true)
+		{
+			const bool isNewPool = m_currentPool == m_pools.size();
+			if (isNewPool)
+			{
+				add_pool();
+			}
+			set_alloc_info.setDescriptorPool(m_pools[m_currentPool].get());
+			const auto result = m_device.allocateDescriptorSets(&set_alloc_info, &outDescriptorSet);
+			if (result == vk::Result::eSuccess)
+			{
+				return true;
+			}
+			if ((result != vk::Result::eErrorOutOfPoolMemory && result != vk::Result::eErrorFragmentedPool) || isNewPool)
+			{
+				s_errorCallback("GFX - Failed to allocate descriptor set!");
+				return false;
+			}
+			m_currentPool += 1;
+		}
+	}
+
+	void DescriptorAllocator::reset()
+	{
+		for (auto& pool : m_pools)
+		{
+			m_device.resetDescriptorPool(pool.get());
+		}
+		m_currentPool = 0;
+	}
+
+	void DescriptorAllocator::add_pool()
+	{
+		// Descriptors per set of each type, roughly what a material or pass set holds. Inline uniform blocks count bytes.
+		const std::array<vk::DescriptorPoolSize, 8> descriptor_pool_sizes{ {
+			{ vk::DescriptorType::eStorageBuffer, 2 * m_setsPerPool },
+			{ vk::DescriptorType::eUniformBuffer, 2 * m_setsPerPool },
+			{ vk::DescriptorType::eUniformBufferDynamic, m_setsPerPool },
+			{ vk::DescriptorType::eStorageBufferDynamic, m_setsPerPool },
+			{ vk::DescriptorType::eCombinedImageSampler, 4 * m_setsPerPool },
+			{ vk::DescriptorType::eInputAttachment, m_setsPerPool },
+			{ vk::DescriptorType::eStorageImage, m_setsPerPool },
+			{ vk::DescriptorType::eInlineUniformBlock, 256 * m_setsPerPool },
+		} };
+		vk::DescriptorPoolCreateInfo descriptor_pool_info{};
+		descriptor_pool_info.setMaxSets(m_setsPerPool);
+		descriptor_pool_info.setPoolSizeCount(m_inlineUniformBlocks ? 8 : 7);
+		descriptor_pool_info.setPPoolSizes(descriptor_pool_sizes.data());
+		const vk::DescriptorPoolInlineUniformBlockCreateInfo inline_uniform_block_info{ m_setsPerPool };
+		if (m_inlineUniformBlocks)
+		{
+			descriptor_pool_info.setPNext(&inline_uniform_block_info);
+		}
+		m_pools.push_back(m_device.createDescriptorPoolUnique(descriptor_pool_info).value);
+		m_setsPerPool = std::min(m_setsPerPool * 2, MAX_SETS_PER_POOL);
+	}
+
+	DescriptorBuffer::DescriptorBuffer(vk::Device device, vma::Allocator allocator, const vk::PhysicalDeviceDescriptorBufferPropertiesEXT& properties, std::uint64_t size, std::uint32_t framesInFlight)
+		: m_device(device), m_properties(properties)
+	{
+		// Both kinds of descriptor share one buffer, so only one binding is ever needed.
+		m_usageFlags = vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT | vk::BufferUsageFlagBits::eSamplerDescriptorBufferEXT | vk::BufferUsageFlagBits::eShaderDeviceAddress;
+		size = std::min({ size, m_properties.maxResourceDescriptorBufferRange, m_properties.maxSamplerDescriptorBufferRange });
+
+		vk::BufferCreateInfo vk_buffer_info{};
+		vk_buffer_info.setSize(size);
+		vk_buffer_info.setUsage(m_usageFlags);
+		vma::AllocationCreateInfo alloc_info{};
+		alloc_info.setUsage(vma::MemoryUsage::eAutoPreferDevice);
+		alloc_info.setFlags(vma::AllocationCreateFlagBits::eHostAccessSequentialWrite | vma::AllocationCreateFlagBits::eMapped);
+		// Written with plain memory copies, so there is nothing to flush.
+		alloc_info.setRequiredFlags(vk::MemoryPropertyFlagBits::eHostCoherent);
+		std::tie(m_buffer, m_allocation) = allocator.createBufferUnique(vk_buffer_info, alloc_info).value;
+		m_mappedPtr = static_cast<std::byte*>(allocator.getAllocationInfo(m_allocation.get()).pMappedData);
+		m_address = m_device.getBufferAddress(vk::BufferDeviceAddressInfo{ m_buffer.get() });
+
+		const auto alignment = m_properties.descriptorBufferOffsetAlignment;
+		const auto frameSize = (size / 2 / framesInFlight) / alignment * alignment;
+		m_persistentRegion = { 0, size - frameSize * framesInFlight, 0 };
+		for (auto i = 0u; i < framesInFlight; ++i)
+		{
+			const auto begin = m_persistentRegion.end + frameSize * i;
+			m_frameRegions.push_back({ begin, begin + frameSize, begin });
+		}
+	}
+
+	bool DescriptorBuffer::allocate(vk::DeviceSize& outOffset, vk::DescriptorSetLayout descriptorSetLayout, std::optional<std::uint32_t> frameIndex)
+	{
+		auto& region = frameIndex ? m_frameRegions[*frameIndex] : m_persistentRegion;
+		const auto alignment = m_properties.descriptorBufferOffsetAlignment;
+		const auto offset = (region.head + alignment - 1) / alignment * alignment;
+		const auto size = m_device.getDescriptorSetLayoutSizeEXT(descriptorSetLayout);
+		if (offset + size > region.end)
+		{
+			s_errorCallback(frameIndex ? "GFX - Descriptor buffer is out of memory for transient descriptor sets!" : "GFX - Descriptor buffer is out of memory for descriptor sets!");
+			return false;
+		}
+
+		region.head = offset + size;
+		outOffset = offset;
+		return true;
+	}
+
+	void DescriptorBuffer::reset_frame(std::uint32_t frameIndex)
+	{
+		auto& region = m_frameRegions[frameIndex];
+		region.head = region.begin;
+	}
+
+	void DescriptorBuffer::write(vk::DeviceSize setOffset, vk::DescriptorSetLayout descriptorSetLayout, std::uint32_t binding, std::uint32_t arrayElement, const vk::DescriptorGetInfoEXT& descriptorInfo)
+	{
+		const auto descriptorSize = get_descriptor_size(descriptorInfo.type);
+		const auto bindingOffset = m_device.getDescriptorSetLayoutBindingOffsetEXT(descriptorSetLayout, binding);
+		m_device.getDescriptorEXT(descriptorInfo, descriptorSize, m_mappedPtr + setOffset + bindingOffset + arrayElement * descriptorSize);
+	}
+
+	void DescriptorBuffer::write_inline(vk::DeviceSize setOffset, vk::DescriptorSetLayout descriptorSetLayout, std::uint32_t binding, std::uint32_t offset, std::uint32_t size, const void* data)
+	{
+		const auto bindingOffset = m_device.getDescriptorSetLayoutBindingOffsetEXT(descriptorSetLayout, binding);
+		std::memcpy(m_mappedPtr + setOffset + bindingOffset + offset, data, size);
+	}
+
+	auto DescriptorBuffer::get_binding_info() const -> vk::DescriptorBufferBindingInfoEXT
+	{
+		return vk::DescriptorBufferBindingInfoEXT{ m_address, m_usageFlags };
+	}
+
+	auto DescriptorBuffer::get_descriptor_size(vk::DescriptorType descriptorType) const -> std::size_t
+	{
+		switch (descriptorType)
+		{
+			case vk::DescriptorType::eSampler:
+				return m_properties.samplerDescriptorSize;
+			case vk::DescriptorType::eCombinedImageSampler:
+				return m_properties.combinedImageSamplerDescriptorSize;
+			case vk::DescriptorType::eSampledImage:
+				return m_properties.sampledImageDescriptorSize;
+			case vk::DescriptorType::eInputAttachment:
+				return m_properties.inputAttachmentDescriptorSize;
+			case vk::DescriptorType::eStorageImage:
+				return m_properties.storageImageDescriptorSize;
+			case vk::DescriptorType::eUniformBuffer:
+				return m_properties.uniformBufferDescriptorSize;
+			case vk::DescriptorType::eStorageBuffer:
+				return m_properties.storageBufferDescriptorSize;
+			default:
+				GFX_ASSERT(false, "Descriptor type cannot be stored in a descriptor buffer!");
+				break;
+		}
+		return 0;
+	}
+
+	BindlessHeap::BindlessHeap(vk::Device device, const std::array<std::uint32_t, BINDING_COUNT>& slotCounts, DescriptorBuffer* descriptorBuffer)
+		: m_device(device), m_descriptorBuffer(descriptorBuffer)
+	{
+		std::array<vk::DescriptorSetLayoutBinding, BINDING_COUNT> vk_bindings{};
+		std::array<vk::DescriptorBindingFlags, BINDING_COUNT> vk_binding_flags{};
+		std::vector<vk::DescriptorPoolSize> descriptor_pool_sizes{};
+		for (auto i = 0u; i < BINDING_COUNT; ++i)
+		{
+			m_slots[i].count = slotCounts[i];
+			vk_bindings[i].setBinding(i);
+			vk_bindings[i].setDescriptorType(BINDING_TYPES[i]);
+			vk_bindings[i].setDescriptorCount(slotCounts[i]);
+			vk_bindings[i].setStageFlags(vk::ShaderStageFlagBits::eAll);
+			// Shaders only read the slots they index, so the rest may be unwritten or stale, and written while the set is in use.
+			vk_binding_flags[i] = vk::DescriptorBindingFlagBits::ePartiallyBound;
+			if (m_descriptorBuffer == nullptr)
+			{
+				vk_binding_flags[i] |= vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+			}
+			if (slotCounts[i] > 0)
+			{
+				descriptor_pool_sizes.emplace_back(BINDING_TYPES[i], slotCounts[i]);
+			}
+		}
+
+		vk::DescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{};
+		binding_flags_info.setBindingFlags(vk_binding_flags);
+		vk::DescriptorSetLayoutCreateInfo set_layout_info{};
+		set_layout_info.setFlags(m_descriptorBuffer ? vk::DescriptorSetLayoutCreateFlagBits::eDescriptorBufferEXT : vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool);
+		set_layout_info.setBindings(vk_bindings);
+		set_layout_info.setPNext(&binding_flags_info);
+		m_layout = m_device.createDescriptorSetLayoutUnique(set_layout_info).value;
+
+		if (m_descriptorBuffer)
+		{
+			if (!m_descriptorBuffer->allocate(m_descriptorBufferOffset, m_layout.get()))
+			{
+				s_errorCallback("GFX - Failed to allocate the bindless heap!");
+			}
+			return;
+		}
+
+		vk::DescriptorPoolCreateInfo descriptor_pool_info{};
+		descriptor_pool_info.setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind);
+		descriptor_pool_info.setMaxSets(1);
+		descriptor_pool_info.setPoolSizes(descriptor_pool_sizes);
+		m_pool = m_device.createDescriptorPoolUnique(descriptor_pool_info).value;
+
+		const auto descriptorSetLayout = m_layout.get();
+		vk::DescriptorSetAllocateInfo set_alloc_info{};
+		set_alloc_info.setDescriptorPool(m_pool.get());
+		set_alloc_info.setSetLayouts(descriptorSetLayout);
+		if (m_device.allocateDescriptorSets(&set_alloc_info, &m_set) != vk::Result::eSuccess)
+		{
+			s_errorCallback("GFX - Failed to allocate the bindless heap!");
+		}
+	}
+
+	auto BindlessHeap::get_binding_types() const -> std::vector<vk::DescriptorType>
+	{
+		return { BINDING_TYPES.begin(), BINDING_TYPES.end() };
+	}
+
+	auto BindlessHeap::get_index(std::uint32_t binding, ResourceHandle resourceHandle) -> std::uint32_t
+	{
+		std::lock_guard lock(m_mutex);
+		const auto& indices = m_slots[binding].indices;
+		const auto it = indices.find(CAST_HANDLE_TO_INT(resourceHandle));
+		return it != indices.end() ? it->second : INVALID_BINDLESS_INDEX;
+	}
+
+	void BindlessHeap::write_texture(ResourceHandle resourceHandle, vk::ImageView imageView)
+	{
+		std::lock_guard lock(m_mutex);
+		const auto index = get_or_add_index(BINDLESS_TEXTURE_BINDING, resourceHandle);
+		if (index == INVALID_BINDLESS_INDEX)
+		{
+			return;
+		}
+
+		vk::DescriptorImageInfo image_info{};
+		image_info.setImageView(imageView);
+		image_info.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+		if (m_descriptorBuffer)
+		{
+			vk::DescriptorGetInfoEXT descriptor_info{};
+			descriptor_info.setType(vk::DescriptorType::eSampledImage);
+			descriptor_info.data.setPSampledImage(&image_info);
+			m_descriptorBuffer->write(m_descriptorBufferOffset, m_layout.get(), BINDLESS_TEXTURE_BINDING, index, descriptor_info);
+			return;
+		}
+		write(BINDLESS_TEXTURE_BINDING, index, &image_info, nullptr);
+	}
+
+	void BindlessHeap::write_sampler(ResourceHandle resourceHandle, vk::Sampler sampler)
+	{
+		std::lock_guard lock(m_mutex);
+		const auto index = get_or_add_index(BINDLESS_SAMPLER_BINDING, resourceHandle);
+		if (index == INVALID_BINDLESS_INDEX)
+		{
+			return;
+		}
+
+		if (m_descriptorBuffer)
+		{
+			vk::DescriptorGetInfoEXT descriptor_info{};
+			descriptor_info.setType(vk::DescriptorType::eSampler);
+			descriptor_info.data.setPSampler(&sampler);
+			m_descriptorBuffer->write(m_descriptorBufferOffset, m_layout.get(), BINDLESS_SAMPLER_BINDING, index, descriptor_info);
+			return;
+		}
+		vk::DescriptorImageInfo image_info{};
+		image_info.setSampler(sampler);
+		write(BINDLESS_SAMPLER_BINDING, index, &image_info, nullptr);
+	}
+
+	void BindlessHeap::write_buffer(ResourceHandle resourceHandle, vk::Buffer buffer, vk::DeviceSize size, vk::DeviceAddress address)
+	{
+		std::lock_guard lock(m_mutex);
+		const auto index = get_or_add_index(BINDLESS_STORAGE_BUFFER_BINDING, resourceHandle);
+		if (index == INVALID_BINDLESS_INDEX)
+		{
+			return;
+		}
+
+		if (m_descriptorBuffer)
+		{
+			const vk::DescriptorAddressInfoEXT address_info{ address, size };
+			vk::DescriptorGetInfoEXT descriptor_info{};
+			descriptor_info.setType(vk::DescriptorType::eStorageBuffer);
+			descriptor_info.data.setPStorageBuffer(&address_info);
+			m_descriptorBuffer->write(m_descriptorBufferOffset, m_layout.get(), BINDLESS_STORAGE_BUFFER_BINDING, index, descriptor_info);
+			return;
+		}
+		const vk::DescriptorBufferInfo buffer_info{ buffer, 0, size };
+		write(BINDLESS_STORAGE_BUFFER_BINDING, index, nullptr, &buffer_info);
+	}
+
+	void BindlessHeap::remove(std::uint32_t binding, ResourceHandle resourceHandle)
+	{
+		std::lock_guard lock(m_mutex);
+		auto& slots = m_slots[binding];
+		const auto it = slots.indices.find(CAST_HANDLE_TO_INT(resourceHandle));
+		if (it == slots.indices.end())
+		{
+			return;
+		}
+		// The stale descriptor is left in place. Partially bound slots are only invalid once a shader reads them.
+		slots.freeIndices.push_back(it->second);
+		slots.indices.erase(it);
+	}
+
+	auto BindlessHeap::get_or_add_index(std::uint32_t binding, ResourceHandle resourceHandle) -> std::uint32_t
+	{
+		auto& slots = m_slots[binding];
+		const auto key = CAST_HANDLE_TO_INT(resourceHandle);
+		if (const auto it = slots.indices.find(key); it != slots.indices.end())
+		{
+			return it->second;
+		}
+
+		std::uint32_t index{ INVALID_BINDLESS_INDEX };
+		if (!slots.freeIndices.empty())
+		{
+			index = slots.freeIndices.back();
+			slots.freeIndices.pop_back();
+		}
+		else if (slots.nextIndex < slots.count)
+		{
+			index = slots.nextIndex++;
+		}
+		else
+		{
+			s_errorCallback("GFX - Bindless heap is full, the resource will have no bindless index!");
+			return INVALID_BINDLESS_INDEX;
+		}
+		slots.indices.emplace(key, index);
+		return index;
+	}
+
+	void BindlessHeap::write(std::uint32_t binding, std::uint32_t index, const vk::DescriptorImageInfo* imageInfo, const vk::DescriptorBufferInfo* bufferInfo)
+	{
+		vk::WriteDescriptorSet vk_write{};
+		vk_write.setDstSet(m_set);
+		vk_write.setDstBinding(binding);
+		vk_write.setDstArrayElement(index);
+		vk_write.setDescriptorCount(1);
+		vk_write.setDescriptorType(BINDING_TYPES[binding]);
+		vk_write.setPImageInfo(imageInfo);
+		vk_write.setPBufferInfo(bufferInfo);
+		m_device.updateDescriptorSets(vk_write, {});
+	}
+
+	auto ScratchArena::get() -> ScratchArena&
+	{
+		thread_local ScratchArena arena{};
+		return arena;
+	}
+
+	auto ScratchArena::allocate(std::size_t size, std::size_t alignment) -> void*
+	{
+		// Blocks too small for this allocation are skipped until the next rewind.
+		for (; m_blockIndex < m_blocks.size(); ++m_blockIndex, m_offset = 0)
+		{
+			auto& block = m_blocks[m_blockIndex];
+			const auto offset = (m_offset + alignment - 1) & ~(alignment - 1);
+			if (offset + size <= block.size)
+			{
+				m_offset = offset + size;
+				return block.data.get() + offset;
+			}
+		}
+
+		const auto blockSize = std::max(BLOCK_BYTES, size);
+		m_blocks.push_back({ std::make_unique<std::byte[]>(blockSize), blockSize });
+		m_blockIndex = m_blocks.size() - 1;
+		m_offset = size;
+		return m_blocks.back().data.get(); // New blocks are aligned for any type.
+	}
+
+	void ScratchArena::rewind(Marker marker)
+	{
+		m_blockIndex = marker.blockIndex;
+		m_offset = marker.offset;
+	}
+
+	WorkerPool::WorkerPool(std::uint32_t threadCount)
+	{
+		m_threads.reserve(threadCount);
+		for (auto i = 0u; i < threadCount; ++i)
+		{
+			m_threads.emplace_back([this](std::stop_token stopToken) { run(stopToken); });
+		}
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		for (auto& thread : m_threads)
+		{
+			thread.request_stop();
+		}
+		m_condition.notify_all();
+		m_threads.clear();
+	}
+
+	void WorkerPool::enqueue(std::function<void()>&& job)
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_jobs.push_back(std::move(job));
+		}
+		m_condition.notify_one();
+	}
+
+	void WorkerPool::run(std::stop_token stopToken)
+	{
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock lock(m_mutex);
+				m_condition.wait(lock, stopToken, [this] { return !m_jobs.empty(); });
+				if (m_jobs.empty())
+				{
+					return; // Stop was requested and the queue has drained.
+				}
+				job = std::move(m_jobs.front());
+				m_jobs.pop_front();
+			}
+			job();
+		}
+	}
+
+	UploadManager::UploadManager(Device& device, std::uint32_t queueIndex, std::uint64_t stagingSize)
+		: m_device(&device), m_queueIndex(queueIndex), m_stagingSize(stagingSize)
+	{
+		Buffer* stagingBuffer{ nullptr };
+		if (m_device->create_buffer(m_stagingBufferHandle, { .type = BufferType::eUpload, .size = m_stagingSize }) && m_device->get_buffer(stagingBuffer, m_stagingBufferHandle))
+		{
+			m_stagingPtr = static_cast<std::byte*>(stagingBuffer->get_mapped_pointer());
+		}
+	}
+
+	bool UploadManager::queue_buffer_upload(BufferHandle bufferHandle, const void* data, std::uint64_t size, std::uint64_t offset)
+	{
+		if (auto* dst = get_in_place_upload_ptr(bufferHandle, size, offset); dst != nullptr)
+		{
+			std::memcpy(dst, data, size);
+			m_device->flush_buffer_range(bufferHandle, offset, size);
+			GFX_COUNT_SHARED_STAT(m_device->get_current_frame_stats().uploadBytes, size);
+			return true;
+		}
+
+		std::lock_guard lock(m_mutex);
+
+		std::uint64_t stagingOffset{ 0 };
+		if (!stage(data, size, stagingOffset))
+		{
+			return false;
+		}
+		m_pendingUploads.push_back({ .bufferHandle = bufferHandle, .stagingOffset = stagingOffset, .dstOffset = offset, .size = size });
+		GFX_COUNT_SHARED_STAT(m_device->get_current_frame_stats().uploadBytes, size);
+		return true;
+	}
+
+	bool UploadManager::queue_texture_upload(TextureHandle textureHandle, const void* data, std::uint64_t size, std::uint32_t mipLevel)
+	{
+		Texture* texture{ nullptr };
+		if (!m_device->get_texture(texture, textureHandle))
+		{
+			return false;
+		}
+		if (mipLevel >= texture->get_mip_levels())
+		{
+			s_errorCallback("GFX - queue_texture_upload() - Mip level is out of range!");
+			return false;
+		}
+		if (size < texture->get_upload_level_size(mipLevel))
+		{
+			s_errorCallback("GFX - queue_texture_upload() - Data is smaller than the mip level!");
+			return false;
+		}
+		GFX_COUNT_SHARED_STAT(m_device->get_current_frame_stats().uploadBytes, size);
+		if (m_device->host_copy_texture_level(*texture, data, mipLevel))
+		{
+			return true;
+		}
+
+		std::lock_guard lock(m_mutex);
+
+		std::uint64_t stagingOffset{ 0 };
+		if (texture->is_format_promoted())
+		{
+			size = texture->get_level_size(mipLevel);
+			if (!reserve(size, stagingOffset))
+			{
+				return false;
+			}
+			stage_texels(*texture, m_stagingPtr + stagingOffset, data, texture->get_upload_level_size(mipLevel));
+			m_device->flush_buffer_range(m_stagingBufferHandle, stagingOffset, size);
+		}
+		else if (!stage(data, size, stagingOffset))
+		{
+			return false;
+		}
+		m_pendingUploads.push_back({ .textureHandle = textureHandle, .stagingOffset = stagingOffset, .size = size, .mipLevel = mipLevel });
+		return true;
+	}
+
+	bool UploadManager::allocate_buffer_upload(UploadAllocation& outAllocation, BufferHandle bufferHandle, std::uint64_t size, std::uint64_t offset)
+	{
+		outAllocation = { .size = size, .bufferHandle = bufferHandle, .offset = offset };
+		if (auto* dst = get_in_place_upload_ptr(bufferHandle, size, offset); dst != nullptr)
+		{
+			outAllocation.data = dst;
+			outAllocation.stagingOffset = IN_PLACE_STAGING_OFFSET;
+			return true;
+		}
+
+		std::lock_guard lock(m_mutex);
+		if (!reserve(size, outAllocation.stagingOffset))
+		{
+			return false;
+		}
+		outAllocation.data = m_stagingPtr + outAllocation.stagingOffset;
+		m_pendingUploads.push_back({ .bufferHandle = bufferHandle, .stagingOffset = outAllocation.stagingOffset, .dstOffset = offset, .size = size, .committed = false });
+		return true;
+	}
+
+	bool UploadManager::allocate_texture_upload(UploadAllocation& outAllocation, TextureHandle textureHandle, std::uint32_t mipLevel)
+	{
+		outAllocation = { .textureHandle = textureHandle, .mipLevel = mipLevel };
+
+		Texture* texture{ nullptr };
+		if (!m_device->get_texture(texture, textureHandle))
+		{
+			return false;
+		}
+		if (mipLevel >= texture->get_mip_levels())
+		{
+			s_errorCallback("GFX - allocate_texture_upload() - Mip level is out of range!");
+			return false;
+		}
+		// Promoted formats are written in the upload format at the start of the space the level takes, and widened in place on commit.
+		outAllocation.size = texture->get_upload_level_size(mipLevel);
+		const auto stagedSize = texture->get_level_size(mipLevel);
+
+		std::lock_guard lock(m_mutex);
+		if (!reserve(stagedSize, outAllocation.stagingOffset))
+		{
+			return false;
+		}
+		outAllocation.data = m_stagingPtr + outAllocation.stagingOffset;
+		m_pendingUploads.push_back({ .textureHandle = textureHandle, .stagingOffset = outAllocation.stagingOffset, .size = stagedSize, .mipLevel = mipLevel, .committed = false });
+		return true;
+	}
+
+	void UploadManager::commit(const UploadAllocation& allocation, bool commit)
+	{
+		// Already in the buffer, nothing to flush but the CPU's caches.
+		if (allocation.stagingOffset == IN_PLACE_STAGING_OFFSET)
+		{
+			if (commit)
+			{
+				m_device->flush_buffer_range(allocation.bufferHandle, allocation.offset, allocation.size);
+				GFX_COUNT_SHARED_STAT(m_device->get_current_frame_stats().uploadBytes, allocation.size);
+			}
+			return;
+		}
+		// Before taking the lock, as it touches the whole level.
+		if (Texture* texture{ nullptr }; commit && allocation.textureHandle != 0 && m_device->get_texture(texture, allocation.textureHandle))
+		{
+			stage_texels(*texture, allocation.data, allocation.data, allocation.size);
+		}
+
+		std::lock_guard lock(m_mutex);
+		auto it = std::find_if(m_pendingUploads.begin(), m_pendingUploads.end(), [&](const PendingUpload& upload) {
+			return !upload.committed && upload.stagingOffset == allocation.stagingOffset;
+		});
+		if (it == m_pendingUploads.end())
+		{
+			s_errorCallback("GFX - Upload allocation was already committed or cancelled!");
+			return;
+		}
+
+		it->committed = true;
+		if (commit)
+		{
+			m_device->flush_buffer_range(m_stagingBufferHandle, it->stagingOffset, it->size);
+			GFX_COUNT_SHARED_STAT(m_device->get_current_frame_stats().uploadBytes, it->size);
+		}
+		else
+		{
+			// Still flushed with the others so its space is reclaimed in order, but resolves to nothing.
+			it->bufferHandle = {};
+			it->textureHandle = {};
+		}
+	}
+
+	auto UploadManager::get_in_place_upload_ptr(BufferHandle bufferHandle, std::uint64_t size, std::uint64_t offset) -> std::byte*
+	{
+		// Elsewhere a mapped buffer is host memory the GPU reads across the bus, and staged copies keep the upload ordered with its other work.
+		if (!m_device->get_properties().unifiedMemory)
+		{
+			return nullptr;
+		}
+		Buffer* buffer{ nullptr };
+		if (!m_device->get_buffer(buffer, bufferHandle) || buffer->get_mapped_pointer() == nullptr || offset + size > buffer->get_size())
+		{
+			return nullptr;
+		}
+		return static_cast<std::byte*>(buffer->get_mapped_pointer()) + offset;
+	}
+
+	bool UploadManager::stage(const void* data, std::uint64_t size, std::uint64_t& outOffset)
+	{
+		if (!reserve(size, outOffset))
+		{
+			return false;
+		}
+		std::memcpy(m_stagingPtr + outOffset, data, size);
+		m_device->flush_buffer_range(m_stagingBufferHandle, outOffset, size);
+		return true;
+	}
+
+	bool UploadManager::reserve(std::uint64_t size, std::uint64_t& outOffset)
+	{
+		if (m_stagingPtr == nullptr)
+		{
+			return false;
+		}
+		if (size > m_stagingSize)
+		{
+			s_errorCallback("GFX - Upload is larger than DeviceInfo::uploadBufferSize!");
+			return false;
+		}
+
+		while (!m_inFlightBatches.empty() && m_device->is_sync_point_complete(m_inFlightBatches.front().syncPoint))
+		{
+			m_tail = m_inFlightBatches.front().stagingEnd;
+			m_inFlightBatches.pop_front();
+		}
+		if (m_inFlightBatches.empty() && m_pendingUploads.empty())
+		{
+			m_head = 0;
+			m_tail = 0;
+		}
+
+		// Aligned for any texel block size copy_buffer_to_texture() may need.
+		constexpr std::uint64_t ALIGNMENT = 16;
+		auto offset = (m_head + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		if (m_head >= m_tail)
+		{
+			// Used space is [tail, head), wrap to the start when the end is too small. Never fill up to the tail, so head == tail means empty.
+			if (offset + size > m_stagingSize)
+			{
+				offset = 0;
+				if (size >= m_tail)
+				{
+					return false;
+				}
+			}
+		}
+		else if (offset + size >= m_tail)
+		{
+			return false;
+		}
+
+		m_head = offset + size;
+		outOffset = offset;
+		return true;
+	}
+
+	auto UploadManager::flush(std::uint32_t dstQueueIndex) -> SyncPoint
+	{
+		std::lock_guard lock(m_mutex);
+		if (std::none_of(m_pendingUploads.begin(), m_pendingUploads.end(), [](const PendingUpload& upload) { return upload.committed; }))
+		{
+			return {};
+		}
+
+		Buffer* stagingBuffer{ nullptr };
+		CommandListHandle uploadCommandListHandle{};
+		CommandList* uploadCommandList{ nullptr };
+		QueueOwnershipTransfer release{};
+		if (!m_device->get_buffer(stagingBuffer, m_stagingBufferHandle) ||
+			!m_device->create_command_list(uploadCommandListHandle, m_queueIndex, CommandListFlags_FireAndForget) ||
+			!m_device->get_command_list(uploadCommandList, uploadCommandListHandle) ||
+			!m_device->get_ownership_transfer(release, *uploadCommandList, m_queueIndex, dstQueueIndex))
+		{
+			return {};
+		}
+
+		// Resolved now, resources destroyed since they were queued are skipped.
+		std::vector<Buffer*> buffers{};
+		std::vector<Texture*> textures{};
+		uploadCommandList->begin();
+		for (const auto& upload : m_pendingUploads)
+		{
+			if (!upload.committed)
+			{
+				continue;
+			}
+			Buffer* buffer{ nullptr };
+			Texture* texture{ nullptr };
+			if (m_device->get_buffer(buffer, upload.bufferHandle))
+			{
+				const BufferCopyRegion region{ .srcOffset = upload.stagingOffset, .dstOffset = upload.dstOffset, .size = upload.size };
+				uploadCommandList->copy_buffer(stagingBuffer, buffer, { &region, 1 });
+				uploadCommandList->transfer_buffer_ownership(buffer, release);
+				buffers.push_back(buffer);
+			}
+			else if (m_device->get_texture(texture, upload.textureHandle))
+			{
+				uploadCommandList->transition_texture(texture, TextureState::eUploadDst);
+				uploadCommandList->copy_buffer_to_texture(stagingBuffer, texture, upload.stagingOffset, upload.mipLevel);
+				// Every level of a texture is copied before it is released, once.
+				if (std::find(textures.begin(), textures.end(), texture) == textures.end())
+				{
+					textures.push_back(texture);
+				}
+			}
+		}
+		// On a transfer-only queue the shader stages of eShaderRead are dropped when the barriers are flushed, the acquire on
+		// dstQueueIndex is what orders the shader reads.
+		for (auto* texture : textures)
+		{
+			uploadCommandList->transfer_texture_ownership(texture, release, TextureState::eUploadDst, TextureState::eShaderRead);
+		}
+		uploadCommandList->end();
+
+		const SubmitBatch uploadBatch{ .commandLists = { &uploadCommandListHandle, 1 } };
+		const auto uploadSyncPoint = m_device->submit_command_lists(m_queueIndex, { &uploadBatch, 1 });
+		// Allocations still being written stay pending, and keep the ring from reclaiming their space and anything after it.
+		const auto firstUncommitted = std::find_if(m_pendingUploads.begin(), m_pendingUploads.end(), [](const PendingUpload& upload) { return !upload.committed; });
+		m_inFlightBatches.push_back({ uploadSyncPoint, firstUncommitted != m_pendingUploads.end() ? firstUncommitted->stagingOffset : m_head });
+		std::erase_if(m_pendingUploads, [](const PendingUpload& upload) { return upload.committed; });
+		if (dstQueueIndex == m_queueIndex)
+		{
+			return uploadSyncPoint;
+		}
+
+		// Submitted even without acquire barriers (same queue family), as it carries the destination queue's wait on the copies.
+		CommandListHandle acquireCommandListHandle{};
+		CommandList* acquireCommandList{ nullptr };
+		QueueOwnershipTransfer acquire{};
+		if (!m_device->create_command_list(acquireCommandListHandle, dstQueueIndex, CommandListFlags_FireAndForget) ||
+			!m_device->get_command_list(acquireCommandList, acquireCommandListHandle) ||
+			!m_device->get_ownership_transfer(acquire, *acquireCommandList, m_queueIndex, dstQueueIndex))
+		{
+			return uploadSyncPoint;
+		}
+		acquireCommandList->begin();
+		for (auto* buffer : buffers)
+		{
+			acquireCommandList->transfer_buffer_ownership(buffer, acquire);
+		}
+		for (auto* texture : textures)
+		{
+			acquireCommandList->transfer_texture_ownership(texture, acquire, TextureState::eUploadDst, TextureState::eShaderRead);
+		}
+		acquireCommandList->end();
+
+		const SubmitBatch acquireBatch{ .commandLists = { &acquireCommandListHandle, 1 }, .waitSyncPoints = { &uploadSyncPoint, 1 } };
+		return m_device->submit_command_lists(dstQueueIndex, { &acquireBatch, 1 });
+	}
+
+	AliasedMemory::AliasedMemory(vma::Allocator allocator, vma::Allocation allocation)
+		: m_allocator(allocator), m_allocation(allocation)
+	{
+	}
+
+	AliasedMemory::AliasedMemory(vk::UniqueDeviceMemory&& deviceMemory, vk::DeviceSize size, std::uint32_t memoryTypeIndex, bool exportable)
+		: m_deviceMemory(std::move(deviceMemory)), m_size(size), m_memoryTypeIndex(memoryTypeIndex), m_exportable(exportable)
+	{
+	}
+
+	AliasedMemory::~AliasedMemory()
+	{
+		if (m_allocation)
+		{
+			m_allocator.freeMemory(m_allocation);
+		}
+	}
+
+	SparseResidency::SparseResidency(vma::Allocator allocator, const vk::MemoryRequirements& memoryRequirements)
+		: m_allocator(allocator), m_memoryRequirements(memoryRequirements)
+	{
+	}
+
+	SparseResidency::~SparseResidency()
+	{
+		for (const auto& [pageKey, allocation] : m_pages)
+		{
+			m_allocator.freeMemory(allocation);
+		}
+	}
+
+	bool SparseResidency::update_page(std::uint64_t pageKey, std::uint64_t size, bool resident, vk::DeviceMemory& outMemory, vk::DeviceSize& outMemoryOffset, PageChanges& outChanges)
+	{
+		std::lock_guard lock(m_mutex);
+		const auto it = m_pages.find(pageKey);
+		if (!resident)
+		{
+			if (it == m_pages.end())
+			{
+				return false;
+			}
+			outChanges.evicted.emplace_back(pageKey, it->second);
+			m_pages.erase(it);
+			outMemory = nullptr;
+			outMemoryOffset = 0;
+			return true;
+		}
+		if (it != m_pages.end())
+		{
+			return false;
+		}
+
+		// Automatic memory usages need a whole resource to pick a type for, so ask for device local memory directly.
+		const VkMemoryRequirements page_requirements{ size != 0 ? size : get_page_size(), get_page_size(), m_memoryRequirements.memoryTypeBits };
+		VmaAllocationCreateInfo alloc_info{};
+		alloc_info.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+		// The C API, so running out of memory is reported rather than asserted on.
+		VmaAllocation allocation{ nullptr };
+		VmaAllocationInfo allocation_info{};
+		if (vmaAllocateMemory(static_cast<VmaAllocator>(m_allocator), &page_requirements, &alloc_info, &allocation, &allocation_info) != VK_SUCCESS)
+		{
+			s_errorCallback("GFX - Failed to allocate memory for a sparse page!");
+			return false;
+		}
+		m_pages.emplace(pageKey, allocation);
+		outChanges.allocated.emplace_back(pageKey, allocation);
+		outMemory = allocation_info.deviceMemory;
+		outMemoryOffset = allocation_info.offset;
+		return true;
+	}
+
+	void SparseResidency::revert(const PageChanges& changes, std::vector<vma::Allocation>& outOrphanedAllocations)
+	{
+		std::lock_guard lock(m_mutex);
+		for (const auto& [pageKey, allocation] : changes.allocated)
+		{
+			// Never bound, so free straight away. Unless a later bind evicted the page meanwhile, which then frees it.
+			if (const auto it = m_pages.find(pageKey); it != m_pages.end() && it->second == allocation)
+			{
+				m_allocator.freeMemory(allocation);
+				m_pages.erase(it);
+			}
+		}
+		for (const auto& [pageKey, allocation] : changes.evicted)
+		{
+			// Still bound, as the unbind never happened.
+			if (!m_pages.try_emplace(pageKey, allocation).second)
+			{
+				outOrphanedAllocations.push_back(allocation);
+			}
+		}
+	}
+
+	BufferArena::BufferArena(Device& device, const BufferArenaInfo& bufferArenaInfo)
+		: m_device(&device), m_info(bufferArenaInfo)
+	{
+	}
+
+	BufferArena::~BufferArena()
+	{
+		// Outstanding allocations are dropped along with the blocks, the buffers are destroyed by the device.
+		for (auto& block : m_blocks)
+		{
+			vmaClearVirtualBlock(block.virtualBlock);
+			vmaDestroyVirtualBlock(block.virtualBlock);
+		}
+	}
+
+	bool BufferArena::allocate(BufferAllocation& outAllocation, std::uint64_t size, std::uint64_t alignment)
+	{
+		if (size == 0 || size > m_info.blockSize)
+		{
+			s_errorCallback("GFX - Buffer arena allocation must be non-empty and fit in BufferArenaInfo::blockSize!");
+			return false;
+		}
+
+		VmaVirtualAllocationCreateInfo alloc_info{};
+		alloc_info.size = size;
+		alloc_info.alignment = alignment;
+
+		const auto try_allocate = [&](const Block& block) -> bool
+		{
+			VmaVirtualAllocation allocation{ VK_NULL_HANDLE };
+			VkDeviceSize offset{ 0 };
+			if (vmaVirtualAllocate(block.virtualBlock, &alloc_info, &allocation, &offset) != VK_SUCCESS)
+			{
+				return false;
+			}
+			outAllocation = BufferAllocation{ block.bufferHandle, offset, size, std::bit_cast<std::uint64_t>(allocation) };
+			return true;
+		};
+
+		std::lock_guard lock(m_mutex);
+		for (const auto& block : m_blocks)
+		{
+			if (try_allocate(block))
+			{
+				return true;
+			}
+		}
+
+		Block block{};
+		if (!m_device->create_buffer(block.bufferHandle, { .type = m_info.type, .size = m_info.blockSize, .memory = m_info.memory, .deviceAddress = m_info.deviceAddress }))
+		{
+			return false;
+		}
+		VmaVirtualBlockCreateInfo block_info{};
+		block_info.size = m_info.blockSize;
+		if (vmaCreateVirtualBlock(&block_info, &block.virtualBlock) != VK_SUCCESS)
+		{
+			s_errorCallback("GFX - Failed to create buffer arena block!");
+			m_device->destroy_buffer(block.bufferHandle);
+			return false;
+		}
+		return try_allocate(m_blocks.emplace_back(block));
+	}
+
+	void BufferArena::free(const BufferAllocation& allocation)
+	{
+		std::lock_guard lock(m_mutex);
+		const auto it = std::ranges::find(m_blocks, allocation.bufferHandle, &Block::bufferHandle);
+		if (it == m_blocks.end() || allocation.allocationId == 0)
+		{
+			s_errorCallback("GFX - Allocation does not belong to this buffer arena!");
+			return;
+		}
+		vmaVirtualFree(it->virtualBlock, std::bit_cast<VmaVirtualAllocation>(allocation.allocationId));
+	}
+
+	MemoryHeap::MemoryHeap(std::shared_ptr<AliasedMemory> memory, std::uint32_t memoryTypeIndex, VmaVirtualBlock virtualBlock, const MemoryHeapInfo& memoryHeapInfo)
+		: m_memory(std::move(memory)), m_memoryTypeIndex(memoryTypeIndex), m_virtualBlock(virtualBlock), m_info(memoryHeapInfo)
+	{
+	}
+
+	MemoryHeap::~MemoryHeap()
+	{
+		// Outstanding ranges are dropped with the block, the memory itself goes with the last resource placed in it.
+		vmaClearVirtualBlock(m_virtualBlock);
+		vmaDestroyVirtualBlock(m_virtualBlock);
+	}
+
+	bool MemoryHeap::can_place(const vk::MemoryRequirements& requirements, std::uint64_t offset) const
+	{
+		if (!(requirements.memoryTypeBits & (1u << m_memoryTypeIndex)))
+		{
+			s_errorCallback("GFX - The resource cannot live in the memory heap's memory type!");
+			return false;
+		}
+		if (offset % requirements.alignment != 0)
+		{
+			s_errorCallback("GFX - The placement offset is not a multiple of the resource's alignment!");
+			return false;
+		}
+		if (offset > m_info.size || requirements.size > m_info.size - offset)
+		{
+			s_errorCallback("GFX - The placed resource does not fit in the memory heap!");
+			return false;
+		}
+		return true;
+	}
+
+	bool MemoryHeap::allocate(MemoryHeapAllocation& outAllocation, std::uint64_t size, std::uint64_t alignment)
+	{
+		if (size == 0 || size > m_info.size)
+		{
+			s_errorCallback("GFX - Memory heap allocation must be non-empty and fit in MemoryHeapInfo::size!");
+			return false;
+		}
+
+		VmaVirtualAllocationCreateInfo alloc_info{};
+		alloc_info.size = size;
+		alloc_info.alignment = alignment;
+
+		std::lock_guard lock(m_mutex);
+		VmaVirtualAllocation allocation{ VK_NULL_HANDLE };
+		VkDeviceSize offset{ 0 };
+		if (vmaVirtualAllocate(m_virtualBlock, &alloc_info, &allocation, &offset) != VK_SUCCESS)
+		{
+			return false; // Full, which the application handles like its own pools running out.
+		}
+		outAllocation = MemoryHeapAllocation{ offset, size, std::bit_cast<std::uint64_t>(allocation) };
+		return true;
+	}
+
+	void MemoryHeap::free(const MemoryHeapAllocation& allocation)
+	{
+		if (allocation.allocationId == 0)
+		{
+			s_errorCallback("GFX - Allocation does not belong to this memory heap!");
+			return;
+		}
+		std::lock_guard lock(m_mutex);
+		vmaVirtualFree(m_virtualBlock, std::bit_cast<VmaVirtualAllocation>(allocation.allocationId));
+	}
+
+	auto BufferArena::get_buffers() const -> std::vector<BufferHandle>
+	{
+		std::lock_guard lock(m_mutex);
+		std::vector<BufferHandle> buffers{};
+		buffers.reserve(m_blocks.size());
+		for (const auto& block : m_blocks)
+		{
+			buffers.push_back(block.bufferHandle);
+		}
+		return buffers;
+	}
+
+	Defragmenter::Defragmenter(Device& device)
+		: m_device(&device)
+	{
+	}
+
+	Defragmenter::~Defragmenter()
+	{
+		end();
+	}
+
+	auto Defragmenter::make_owner_tag(ResourceHandle resourceHandle, bool isTexture) -> void*
+	{
+		// The low bit marks the tag as set, allocations made outside the pools keep a null user data.
+		return reinterpret_cast<void*>(std::uintptr_t(CAST_HANDLE_TO_INT(resourceHandle)) << 2u | (isTexture ? 2u : 0u) | 1u);
+	}
+
+	bool Defragmenter::begin(const DefragmentationInfo& defragmentationInfo)
+	{
+		std::lock_guard lock(m_mutex);
+		if (m_context != VK_NULL_HANDLE)
+		{
+			s_errorCallback("GFX - Defragmentation is already in progress!");
+			return false;
+		}
+
+		vk::Queue queue{};
+		if (!m_device->get_queue(queue, defragmentationInfo.queueIndex))
+		{
+			s_errorCallback("GFX - DefragmentationInfo::queueIndex is not a valid queue index!");
+			return false;
+		}
+
+		VmaDefragmentationInfo defrag_info{};
+		defrag_info.maxBytesPerPass = defragmentationInfo.maxBytesPerPass;
+		defrag_info.maxAllocationsPerPass = defragmentationInfo.maxMovesPerPass;
+		if (vmaBeginDefragmentation(static_cast<VmaAllocator>(m_device->get_allocator()), &defrag_info, &m_context) != VK_SUCCESS)
+		{
+			s_errorCallback("GFX - Failed to begin defragmentation!");
+			m_context = VK_NULL_HANDLE;
+			return false;
+		}
+
+		m_info = defragmentationInfo;
+		m_passState = PassState::eIdle;
+		return true;
+	}
+
+	bool Defragmenter::step()
+	{
+		std::lock_guard lock(m_mutex);
+		if (m_context == VK_NULL_HANDLE)
+		{
+			return false;
+		}
+
+		switch (m_passState)
+		{
+			case PassState::eCopying:
+				if (m_device->is_sync_point_complete(m_copySyncPoint))
+				{
+					swap_moved_resources();
+				}
+				return true;
+			case PassState::eRetiring:
+				if (!m_passRetired->load())
+				{
+					return true;
+				}
+				if (end_pass())
+				{
+					finish();
+					return false;
+				}
+				break;
+			case PassState::eIdle:
+			default:
+				break;
+		}
+
+		if (!begin_pass())
+		{
+			finish();
+			return false;
+		}
+		return true;
+	}
+
+	void Defragmenter::end()
+	{
+		std::unique_lock lock(m_mutex);
+		if (m_context == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		if (m_passState == PassState::eCopying)
+		{
+			m_device->wait_on_sync_points({ &m_copySyncPoint, 1 }, true, INFINITE_TIMEOUT);
+			swap_moved_resources();
+		}
+		if (m_passState == PassState::eRetiring)
+		{
+			// Unlocked, as the deferred destruction run by waiting may destroy resources and so call postpone_destroy().
+			lock.unlock();
+			m_device->wait_for_idle();
+			lock.lock();
+			if (m_passState == PassState::eRetiring)
+			{
+				end_pass();
+			}
+		}
+		if (m_context != VK_NULL_HANDLE)
+		{
+			finish();
+		}
+	}
+
+	bool Defragmenter::postpone_destroy(vma::Allocation allocation, std::function<void()>& destroyFunc)
+	{
+		std::lock_guard lock(m_mutex);
+		if (m_passState == PassState::eIdle)
+		{
+			return false;
+		}
+
+		// Ignored moves count too, ending the pass still reads their source allocation.
+		for (auto i = 0u; i < m_passInfo.moveCount; ++i)
+		{
+			if (m_passInfo.pMoves[i].srcAllocation == static_cast<VmaAllocation>(allocation))
+			{
+				m_moves[i].postponedDestroy = std::move(destroyFunc);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool Defragmenter::begin_pass()
+	{
+		const auto allocator = static_cast<VmaAllocator>(m_device->get_allocator());
+		const auto result = vmaBeginDefragmentationPass(allocator, m_context, &m_passInfo);
+		if (result == VK_SUCCESS)
+		{
+			return false;
+		}
+		if (result != VK_INCOMPLETE)
+		{
+			s_errorCallback("GFX - Failed to begin defragmentation pass!");
+			return false;
+		}
+
+		m_moves.assign(m_passInfo.moveCount, {});
+		CommandListHandle commandListHandle{};
+		CommandList* commandList{ nullptr };
+		std::uint32_t copyCount{ 0 };
+		if (m_device->create_command_list(commandListHandle, m_info.queueIndex, CommandListFlags_FireAndForget) && m_device->get_command_list(commandList, commandListHandle))
+		{
+			commandList->begin();
+			for (auto i = 0u; i < m_passInfo.moveCount; ++i)
+			{
+				if (record_move(*commandList, m_passInfo.pMoves[i], m_moves[i]))
+				{
+					++copyCount;
+				}
+				else
+				{
+					m_passInfo.pMoves[i].operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+				}
+			}
+			commandList->end();
+		}
+
+		if (copyCount == 0)
+		{
+			// Everything VMA proposed is pinned, later passes would only propose the same allocations again.
+			for (auto i = 0u; i < m_passInfo.moveCount; ++i)
+			{
+				m_passInfo.pMoves[i].operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+			}
+			if (commandList != nullptr)
+			{
+				m_device->destroy_command_list(commandListHandle);
+			}
+			vmaEndDefragmentationPass(allocator, m_context, &m_passInfo);
+			m_moves.clear();
+			return false;
+		}
+
+		const SubmitBatch batch{ .commandLists = { &commandListHandle, 1 } };
+		m_copySyncPoint = m_device->submit_command_lists(m_info.queueIndex, { &batch, 1 });
+		m_passState = PassState::eCopying;
+		return true;
+	}
+
+	bool Defragmenter::record_move(CommandList& commandList, VmaDefragmentationMove& move, Move& outMove)
+	{
+		const auto allocator = static_cast<VmaAllocator>(m_device->get_allocator());
+		VmaAllocationInfo allocation_info{};
+		vmaGetAllocationInfo(allocator, move.srcAllocation, &allocation_info);
+		const auto tag = reinterpret_cast<std::uintptr_t>(allocation_info.pUserData);
+		if ((tag & 1u) == 0)
+		{
+			return false;
+		}
+		outMove.resourceHandle = ResourceHandle(std::uint32_t(tag >> 2u));
+		outMove.isTexture = bool(tag & 2u);
+
+		const auto device = m_device->get_device();
+		if (outMove.isTexture)
+		{
+			// Attachments and storage images are written by the GPU at any time, the copy would miss those writes.
+			constexpr auto writableUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eStorage;
+			Texture* texture{ nullptr };
+			if (!m_device->get_texture(texture, TextureHandle(m_device->get_handle(), outMove.resourceHandle)) || (texture->get_usage_flags() & writableUsage))
+			{
+				return false;
+			}
+			for (auto layer = 0u; layer < texture->get_array_layers(); ++layer)
+			{
+				for (auto mipLevel = 0u; mipLevel < texture->get_mip_levels(); ++mipLevel)
+				{
+					if (texture->get_state(mipLevel, layer) != TextureState::eShaderRead)
+					{
+						return false;
+					}
+				}
+			}
+
+			outMove.dstImage = device.createImage(texture->get_image_create_info()).value;
+			if (vmaBindImageMemory(allocator, move.dstTmpAllocation, static_cast<VkImage>(outMove.dstImage)) != VK_SUCCESS)
+			{
+				destroy_move_objects(outMove);
+				return false;
+			}
+			commandList.move_texture(texture, outMove.dstImage);
+			return true;
+		}
+
+		// Host visible buffers keep their mapped pointers, storage buffers may be written by the GPU at any time and
+		// device addresses may be stored anywhere, so neither could be patched.
+		Buffer* buffer{ nullptr };
+		if (!m_device->get_buffer(buffer, BufferHandle(m_device->get_handle(), outMove.resourceHandle)) || buffer->is_host_visible() ||
+			(buffer->get_usage_flags() & (vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress)))
+		{
+			return false;
+		}
+
+		outMove.dstBuffer = device.createBuffer(buffer->get_buffer_create_info()).value;
+		if (vmaBindBufferMemory(allocator, move.dstTmpAllocation, static_cast<VkBuffer>(outMove.dstBuffer)) != VK_SUCCESS)
+		{
+			destroy_move_objects(outMove);
+			return false;
+		}
+		commandList.move_buffer(buffer, outMove.dstBuffer);
+		return true;
+	}
+
+	void Defragmenter::swap_moved_resources()
+	{
+		for (auto i = 0u; i < m_passInfo.moveCount; ++i)
+		{
+			auto& move = m_passInfo.pMoves[i];
+			auto& movedResource = m_moves[i];
+			if (move.operation != VMA_DEFRAGMENTATION_MOVE_OPERATION_COPY)
+			{
+				continue;
+			}
+
+			bool swapped{ false };
+			if (!movedResource.postponedDestroy)
+			{
+				swapped = movedResource.isTexture ? m_device->replace_moved_texture(TextureHandle(m_device->get_handle(), movedResource.resourceHandle), movedResource.dstImage)
+												  : m_device->replace_moved_buffer(BufferHandle(m_device->get_handle(), movedResource.resourceHandle), movedResource.dstBuffer);
+			}
+			if (swapped)
+			{
+				// Owned by the resource now.
+				movedResource.dstBuffer = nullptr;
+				movedResource.dstImage = nullptr;
+			}
+			else
+			{
+				// Destroyed while its copy was in flight, so it is freed where it is instead.
+				move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+				destroy_move_objects(movedResource);
+			}
+		}
+
+		// Queued behind everything submitted so far, so it runs once no submission uses the old objects.
+		m_passRetired = std::make_shared<std::atomic<bool>>(false);
+		m_device->defer_destroy([passRetired = m_passRetired] { passRetired->store(true); });
+		m_passState = PassState::eRetiring;
+	}
+
+	bool Defragmenter::end_pass()
+	{
+		const auto result = vmaEndDefragmentationPass(static_cast<VmaAllocator>(m_device->get_allocator()), m_context, &m_passInfo);
+		for (auto& movedResource : m_moves)
+		{
+			if (movedResource.postponedDestroy)
+			{
+				m_device->defer_destroy(std::move(movedResource.postponedDestroy));
+			}
+		}
+		m_moves.clear();
+		m_passState = PassState::eIdle;
+		return result == VK_SUCCESS;
+	}
+
+	void Defragmenter::finish()
+	{
+		vmaEndDefragmentation(static_cast<VmaAllocator>(m_device->get_allocator()), m_context, nullptr);
+		m_context = VK_NULL_HANDLE;
+		m_passState = PassState::eIdle;
+	}
+
+	void Defragmenter::destroy_move_objects(Move& move)
+	{
+		const auto device = m_device->get_device();
+		if (move.dstBuffer)
+		{
+			device.destroyBuffer(move.dstBuffer);
+			move.dstBuffer = nullptr;
+		}
+		if (move.dstImage)
+		{
+			device.destroyImage(move.dstImage);
+			move.dstImage = nullptr;
+		}
+	}
+
+	CommandPool::CommandPool(vk::Device device, std::uint32_t queueFamily, vk::QueueFlags queueFlags, bool transient)
+		: m_device(device), m_queueFamily(queueFamily), m_supportedStages(get_queue_supported_stages(queueFlags)), m_transient(transient)
+	{
+		vk::CommandPoolCreateInfo cmd_pool_info{};
+		cmd_pool_info.setQueueFamilyIndex(queueFamily);
+		if (m_transient)
+		{
+			cmd_pool_info.setFlags(vk::CommandPoolCreateFlagBits::eTransient);
+		}
+		else
+		{
+			cmd_pool_info.setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer);
+		}
+		m_pool = m_device.createCommandPoolUnique(cmd_pool_info).value;
+	}
+
+	auto CommandPool::allocate(vk::CommandBufferLevel level) -> vk::UniqueCommandBuffer
+	{
+		free_released();
+
+		vk::CommandBufferAllocateInfo cmd_alloc_info{};
+		cmd_alloc_info.setCommandPool(m_pool.get());
+		cmd_alloc_info.setCommandBufferCount(1);
+		cmd_alloc_info.setLevel(level);
+		return std::move(m_device.allocateCommandBuffersUnique(cmd_alloc_info).value[0]);
+	}
+
+	auto CommandPool::acquire_transient(vk::CommandBufferLevel level) -> vk::CommandBuffer
+	{
+		GFX_ASSERT(m_transient, "Only transient command pools can hand out transient command buffers!");
+
+		const auto levelIndex = static_cast<std::uint32_t>(level);
+		auto& commandBuffers = m_transientCommandBuffers[levelIndex];
+		auto& usedCount = m_transientUsedCounts[levelIndex];
+		if (usedCount == commandBuffers.size())
+		{
+			vk::CommandBufferAllocateInfo cmd_alloc_info{};
+			cmd_alloc_info.setCommandPool(m_pool.get());
+			cmd_alloc_info.setCommandBufferCount(1);
+			cmd_alloc_info.setLevel(level);
+			commandBuffers.push_back(m_device.allocateCommandBuffers(cmd_alloc_info).value[0]);
+		}
+		return commandBuffers[usedCount++];
+	}
+
+	void CommandPool::reset()
+	{
+		GFX_ASSERT(m_transient, "Only transient command pools can be reset as a whole!");
+
+		// Resets every command buffer allocated from the pool, they are all reusable afterwards.
+		m_device.resetCommandPool(m_pool.get());
+		m_transientUsedCounts = {};
+	}
+
+	void CommandPool::release(vk::CommandBuffer commandBuffer)
+	{
+		std::lock_guard lock(m_releasedMutex);
+		m_released.push_back(commandBuffer);
+	}
+
+	void CommandPool::free_released()
+	{
+		std::lock_guard lock(m_releasedMutex);
+		if (!m_released.empty())
+		{
+			m_device.freeCommandBuffers(m_pool.get(), m_released);
+			m_released.clear();
+		}
+	}
+
+	// Payloads of the CommandListFlags_Deferred command stream packets. Variable-length data follows the payload.
+
+	struct EmptyPacket
+	{
+	};
+	struct PointerPacket
+	{
+		Pipeline* pipeline;
+	};
+	struct CountPacket
+	{
+		std::uint32_t first;
+		std::uint32_t count;
+	};
+	struct DescriptorSetsPacket
+	{
+		std::uint32_t first;
+		std::uint32_t count;
+		std::uint32_t dynamicOffsetCount; // Trailing the descriptor sets.
+	};
+	struct PushDescriptorsPacket
+	{
+		std::uint32_t set;
+		std::uint32_t count; // Of PushDescriptors, trailing the packet.
+	};
+	struct DescriptorBufferOffsetsPacket
+	{
+		std::uint32_t first;
+		std::uint32_t count; // Of offsets, trailing the packet.
+		vk::DeviceAddress descriptorBufferAddress;
+		vk::BufferUsageFlags descriptorBufferUsage;
+	};
+	struct BeginRenderPassPacket
+	{
+		std::uint32_t colorAttachmentCount;
+		bool secondaryContents;
+		std::array<Texture*, MAX_COLOR_ATTACHMENTS> colorAttachments;
+		Texture* depthAttachment;
+		std::array<float, 4> clearColor;
+		std::array<std::uint32_t, MAX_COLOR_ATTACHMENTS> colorAttachmentViews; // Texture view indices, colorAttachmentCount of them.
+		std::uint32_t depthAttachmentView;
+		std::array<Texture*, MAX_COLOR_ATTACHMENTS> resolveAttachments; // Null for attachments that are not resolved.
+		AttachmentOps attachmentOps;
+		vk::Rect2D renderArea;
+		std::uint32_t viewMask;
+		ShadingRateAttachment shadingRateAttachment;
+	};
+	struct ViewportPacket
+	{
+		float x, y, width, height, minDepth, maxDepth;
+	};
+	struct ScissorPacket
+	{
+		std::int32_t x, y;
+		std::uint32_t width, height;
+	};
+	struct ShadingRatePacket
+	{
+		vk::Extent2D fragmentSize;
+		std::array<vk::FragmentShadingRateCombinerOpKHR, 2> combinerOps;
+	};
+	struct ConditionalPacket
+	{
+		Buffer* buffer;
+		std::uint64_t offset;
+		bool inverted;
+	};
+	struct BuildAccelerationStructuresPacket
+	{
+		std::uint32_t buildCount;	 // Build infos, trailing the packet,
+		std::uint32_t geometryCount; // then geometries, then as many build ranges.
+	};
+	struct CopyAccelerationStructurePacket
+	{
+		vk::AccelerationStructureKHR src;
+		vk::AccelerationStructureKHR dst;
+		vk::CopyAccelerationStructureModeKHR mode;
+	};
+	struct AccelerationStructureSizePacket
+	{
+		vk::AccelerationStructureKHR accelerationStructure;
+		vk::QueryPool queryPool;
+		std::uint32_t query;
+	};
+	struct CullModePacket
+	{
+		vk::CullModeFlags cullMode;
+	};
+	struct FrontFacePacket
+	{
+		vk::FrontFace frontFace;
+	};
+	struct PrimitiveTopologyPacket
+	{
+		vk::PrimitiveTopology topology;
+		bool primitiveRestart;
+	};
+	struct DepthStatePacket
+	{
+		bool depthTest;
+		bool depthWrite;
+		vk::CompareOp depthCompareOp;
+	};
+	struct StencilStatePacket
+	{
+		bool stencilTest;
+		vk::StencilOpState stencilFront;
+		vk::StencilOpState stencilBack;
+	};
+	struct ConstantsPacket
+	{
+		vk::ShaderStageFlags shaderStages;
+		std::uint32_t offset;
+		std::uint32_t size;
+	};
+	struct DispatchPacket
+	{
+		std::uint32_t groupCountX, groupCountY, groupCountZ;
+	};
+	struct DispatchBasePacket
+	{
+		std::uint32_t baseGroupX, baseGroupY, baseGroupZ;
+		std::uint32_t groupCountX, groupCountY, groupCountZ;
+	};
+	struct DeviceMaskPacket
+	{
+		std::uint32_t deviceMask;
+	};
+	struct DispatchIndirectPacket
+	{
+		Buffer* buffer;
+		std::uint64_t offset;
+	};
+	struct BindIndexBufferPacket
+	{
+		Buffer* buffer;
+		vk::IndexType indexType;
+		vk::DeviceSize offset;
+	};
+	struct DrawPacket
+	{
+		std::uint32_t vertexCount, instanceCount, firstVertex, firstInstance;
+	};
+	struct DrawIndexedPacket
+	{
+		std::uint32_t indexCount, instanceCount, firstIndex;
+		std::int32_t vertexOffset;
+		std::uint32_t firstInstance;
+	};
+	struct DrawIndirectPacket
+	{
+		Buffer* buffer;
+		std::uint64_t offset;
+		std::uint32_t drawCount;
+		std::uint32_t stride;
+	};
+	struct DrawIndirectCountPacket
+	{
+		Buffer* buffer;
+		std::uint64_t offset;
+		Buffer* countBuffer;
+		std::uint64_t countOffset;
+		std::uint32_t maxDrawCount;
+		std::uint32_t stride;
+	};
+	// Resolved against the tracked texture states while recording, the barriers follow the payload.
+	struct TextureBarriersPacket
+	{
+		Texture* texture;
+		std::uint32_t barrierCount;
+	};
+	struct WriteTimestampPacket
+	{
+		vk::QueryPool queryPool;
+		std::uint32_t query;
+		vk::PipelineStageFlags2 stage;
+	};
+	struct QueryPacket
+	{
+		vk::QueryPool queryPool;
+		std::uint32_t query;
+		vk::QueryControlFlags flags; // eBeginQuery only.
+	};
+	struct TransferBufferOwnershipPacket
+	{
+		Buffer* buffer;
+		QueueOwnershipTransfer transfer;
+	};
+	struct BufferBarrierPacket
+	{
+		Buffer* buffer;
+		vk::PipelineStageFlags2 srcStages;
+		vk::AccessFlags2 srcAccess;
+		vk::PipelineStageFlags2 dstStages;
+		vk::AccessFlags2 dstAccess;
+		vk::DeviceSize offset;
+		vk::DeviceSize size;
+	};
+	struct MemoryBarrierPacket
+	{
+		vk::PipelineStageFlags2 srcStages;
+		vk::AccessFlags2 srcAccess;
+		vk::PipelineStageFlags2 dstStages;
+		vk::AccessFlags2 dstAccess;
+	};
+	struct CopyBufferToTexturePacket
+	{
+		Buffer* buffer;
+		Texture* texture;
+		std::uint64_t bufferOffset;
+		std::uint32_t mipLevel;
+	};
+	struct CopyBufferToTextureRegionsPacket
+	{
+		Buffer* buffer;
+		Texture* texture;
+		std::uint32_t regionCount; // BufferTextureCopyRegions trail the packet.
+	};
+	struct BlitMipLevelPacket
+	{
+		Texture* texture;
+		vk::Filter filter;
+		std::uint32_t mipLevel;
+	};
+	struct CopyBufferPacket
+	{
+		Buffer* srcBuffer;
+		Buffer* dstBuffer;
+		std::uint32_t regionCount; // BufferCopyRegions trail the packet.
+	};
+	struct CopyTextureToBufferPacket
+	{
+		Texture* texture;
+		Buffer* buffer;
+		std::uint32_t regionCount; // TextureCopyRegions trail the packet.
+	};
+	// Also for resolves.
+	struct CopyTexturePacket
+	{
+		Texture* srcTexture;
+		Texture* dstTexture;
+		std::uint32_t regionCount; // TextureRegionCopys trail the packet.
+	};
+	struct BlitTexturePacket
+	{
+		Texture* srcTexture;
+		Texture* dstTexture;
+		vk::Filter filter;
+		std::uint32_t regionCount; // TextureBlitRegions trail the packet.
+	};
+	struct FillBufferPacket
+	{
+		Buffer* buffer;
+		std::uint64_t offset;
+		std::uint64_t size;
+		std::uint32_t value;
+	};
+	struct UpdateBufferPacket
+	{
+		Buffer* buffer;
+		std::uint64_t offset;
+		std::uint64_t size; // Bytes of data trailing the packet.
+	};
+
+	template <typename T>
+	auto read_packet(const std::byte* packet) -> T
+	{
+		T payload;
+		std::memcpy(&payload, packet, sizeof(T));
+		return payload;
+	}
+
+	auto read_texture_barriers(const std::byte* payload, std::uint32_t barrierCount) -> std::vector<vk::ImageMemoryBarrier2>
+	{
+		std::vector<vk::ImageMemoryBarrier2> barriers(barrierCount);
+		std::memcpy(barriers.data(), payload + sizeof(TextureBarriersPacket), barrierCount * sizeof(vk::ImageMemoryBarrier2));
+		return barriers;
+	}
+
+	template <typename T>
+	void CommandList::write_packet(PacketType type, const T& payload, const void* extraData, std::size_t extraSize)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Command stream packets must be trivially copyable!");
+
+		// Packets are kept 8-byte aligned, so handles and pointers in the payloads are never split.
+		const auto size = (sizeof(PacketHeader) + sizeof(T) + extraSize + 7u) & ~std::size_t(7u);
+		const auto offset = m_commandStream.size();
+		m_commandStream.resize(offset + size);
+
+		auto* packet = m_commandStream.data() + offset;
+		const PacketHeader header{ type, std::uint32_t(size) };
+		std::memcpy(packet, &header, sizeof(PacketHeader));
+		std::memcpy(packet + sizeof(PacketHeader), &payload, sizeof(T));
+		if (extraSize != 0)
+		{
+			std::memcpy(packet + sizeof(PacketHeader) + sizeof(T), extraData, extraSize);
+		}
+	}
+
+	void CommandList::translate(CommandPool& commandPool)
+	{
+		GFX_ASSERT(is_deferred(), "Only deferred command lists can be translated!");
+
+		// Command pools are externally synchronised, so each translation records into a buffer from the translating thread's pool.
+		GFX_ASSERT(!m_commandBuffer, "The last translation's command buffer must be taken first!");
+		m_commandPool = &commandPool;
+		m_commandBuffer = m_commandPool->allocate(m_level);
+
+		m_translating = true;
+
+		vk::CommandBufferBeginInfo cmd_begin_info{};
+		cmd_begin_info.setFlags(get_usage_flags());
+		m_commandBuffer->begin(cmd_begin_info);
+		m_boundPipeline = nullptr;
+		reset_bound_state();
+		m_usedEventCount = 0;
+
+		// Replaying through the immediate paths keeps barrier batching and redundant bind elision.
+		const auto* cursor = m_commandStream.data();
+		const auto* streamEnd = cursor + m_commandStream.size();
+		while (cursor < streamEnd)
+		{
+			const auto header = read_packet<PacketHeader>(cursor);
+			const auto* payload = cursor + sizeof(PacketHeader);
+			switch (header.type)
+			{
+				case PacketType::eBeginRenderPass:
+				{
+					const auto packet = read_packet<BeginRenderPassPacket>(payload);
+					begin_render_pass(std::span(packet.colorAttachments.data(), packet.colorAttachmentCount), packet.depthAttachment, packet.clearColor, packet.secondaryContents,
+									  std::span(packet.colorAttachmentViews.data(), packet.colorAttachmentCount), packet.depthAttachmentView,
+									  std::span(packet.resolveAttachments.data(), packet.colorAttachmentCount), packet.attachmentOps, packet.renderArea, packet.viewMask,
+									  packet.shadingRateAttachment);
+					break;
+				}
+				case PacketType::eEndRenderPass:
+					end_render_pass();
+					break;
+				case PacketType::eExecuteCommands:
+				{
+					const auto packet = read_packet<CountPacket>(payload);
+					InlineVector<vk::CommandBuffer, 16> commandBuffers{};
+					commandBuffers.resize(packet.count);
+					std::memcpy(commandBuffers.data(), payload + sizeof(CountPacket), packet.count * sizeof(vk::CommandBuffer));
+					execute_commands(commandBuffers);
+					break;
+				}
+				case PacketType::eSetViewport:
+				{
+					const auto packet = read_packet<ViewportPacket>(payload);
+					set_viewport(packet.x, packet.y, packet.width, packet.height, packet.minDepth, packet.maxDepth);
+					break;
+				}
+				case PacketType::eSetScissor:
+				{
+					const auto packet = read_packet<ScissorPacket>(payload);
+					set_scissor(packet.x, packet.y, packet.width, packet.height);
+					break;
+				}
+				case PacketType::eSetCullMode:
+					set_cull_mode(read_packet<CullModePacket>(payload).cullMode);
+					break;
+				case PacketType::eSetFrontFace:
+					set_front_face(read_packet<FrontFacePacket>(payload).frontFace);
+					break;
+				case PacketType::eSetPrimitiveTopology:
+				{
+					const auto packet = read_packet<PrimitiveTopologyPacket>(payload);
+					set_primitive_topology(packet.topology, packet.primitiveRestart);
+					break;
+				}
+				case PacketType::eSetDepthState:
+				{
+					const auto packet = read_packet<DepthStatePacket>(payload);
+					set_depth_state(packet.depthTest, packet.depthWrite, packet.depthCompareOp);
+					break;
+				}
+				case PacketType::eSetStencilState:
+				{
+					const auto packet = read_packet<StencilStatePacket>(payload);
+					set_stencil_state(packet.stencilTest, packet.stencilFront, packet.stencilBack);
+					break;
+				}
+				case PacketType::eSetBlendStates:
+				{
+					const auto packet = read_packet<CountPacket>(payload);
+					InlineVector<vk::PipelineColorBlendAttachmentState, MAX_COLOR_ATTACHMENTS> blendStates{};
+					blendStates.resize(packet.count);
+					std::memcpy(blendStates.data(), payload + sizeof(CountPacket), packet.count * sizeof(vk::PipelineColorBlendAttachmentState));
+					set_blend_states(packet.first, blendStates);
+					break;
+				}
+				case PacketType::eSetShadingRate:
+				{
+					const auto packet = read_packet<ShadingRatePacket>(payload);
+					set_shading_rate(packet.fragmentSize, packet.combinerOps);
+					break;
+				}
+				case PacketType::eBeginConditional:
+				{
+					const auto packet = read_packet<ConditionalPacket>(payload);
+					begin_conditional(packet.buffer, packet.offset, packet.inverted);
+					break;
+				}
+				case PacketType::eEndConditional:
+					end_conditional();
+					break;
+				case PacketType::eLocalReadBarrier:
+					local_read_barrier();
+					break;
+				case PacketType::eBindPipeline:
+					bind_pipeline(read_packet<PointerPacket>(payload).pipeline);
+					break;
+				case PacketType::eBindDescriptorSets:
+				{
+					const auto packet = read_packet<DescriptorSetsPacket>(payload);
+					InlineVector<vk::DescriptorSet, MAX_BOUND_DESCRIPTOR_SETS> descriptorSets{};
+					descriptorSets.resize(packet.count);
+					std::memcpy(descriptorSets.data(), payload + sizeof(DescriptorSetsPacket), packet.count * sizeof(vk::DescriptorSet));
+					InlineVector<std::uint32_t, MAX_DYNAMIC_OFFSETS> dynamicOffsets{};
+					dynamicOffsets.resize(packet.dynamicOffsetCount);
+					std::memcpy(dynamicOffsets.data(), payload + sizeof(DescriptorSetsPacket) + packet.count * sizeof(vk::DescriptorSet), packet.dynamicOffsetCount * sizeof(std::uint32_t));
+					bind_descriptor_sets(packet.first, descriptorSets, dynamicOffsets);
+					break;
+				}
+				case PacketType::ePushDescriptors:
+				{
+					const auto packet = read_packet<PushDescriptorsPacket>(payload);
+					InlineVector<ResolvedDescriptor, MAX_PUSH_DESCRIPTORS> descriptors{};
+					descriptors.resize(packet.count);
+					std::memcpy(descriptors.data(), payload + sizeof(PushDescriptorsPacket), packet.count * sizeof(ResolvedDescriptor));
+					push_descriptors(packet.set, descriptors);
+					break;
+				}
+				case PacketType::eSetDescriptorBufferOffsets:
+				{
+					const auto packet = read_packet<DescriptorBufferOffsetsPacket>(payload);
+					InlineVector<vk::DeviceSize, MAX_BOUND_DESCRIPTOR_SETS> offsets{};
+					offsets.resize(packet.count);
+					std::memcpy(offsets.data(), payload + sizeof(DescriptorBufferOffsetsPacket), packet.count * sizeof(vk::DeviceSize));
+					set_descriptor_buffer_offsets(packet.first, offsets, vk::DescriptorBufferBindingInfoEXT{ packet.descriptorBufferAddress, packet.descriptorBufferUsage });
+					break;
+				}
+				case PacketType::eSetConstants:
+				{
+					const auto packet = read_packet<ConstantsPacket>(payload);
+					set_constants(packet.shaderStages, packet.offset, packet.size, payload + sizeof(ConstantsPacket));
+					break;
+				}
+				case PacketType::eDispatch:
+				{
+					const auto packet = read_packet<DispatchPacket>(payload);
+					dispatch(packet.groupCountX, packet.groupCountY, packet.groupCountZ);
+					break;
+				}
+				case PacketType::eDispatchBase:
+				{
+					const auto packet = read_packet<DispatchBasePacket>(payload);
+					dispatch_base(packet.baseGroupX, packet.baseGroupY, packet.baseGroupZ, packet.groupCountX, packet.groupCountY, packet.groupCountZ);
+					break;
+				}
+				case PacketType::eSetDeviceMask:
+					set_device_mask(read_packet<DeviceMaskPacket>(payload).deviceMask);
+					break;
+				case PacketType::eDispatchIndirect:
+				{
+					const auto packet = read_packet<DispatchIndirectPacket>(payload);
+					dispatch_indirect(packet.buffer, packet.offset);
+					break;
+				}
+				case PacketType::eBindIndexBuffer:
+				{
+					const auto packet = read_packet<BindIndexBufferPacket>(payload);
+					bind_index_buffer(packet.buffer, packet.indexType, packet.offset);
+					break;
+				}
+				case PacketType::eBindVertexBuffers:
+				{
+					const auto packet = read_packet<CountPacket>(payload);
+					InlineVector<vk::Buffer, MAX_VERTEX_BUFFER_BINDINGS> buffers{};
+					buffers.resize(packet.count);
+					std::memcpy(buffers.data(), payload + sizeof(CountPacket), packet.count * sizeof(vk::Buffer));
+					// Offsets always trail the buffers.
+					InlineVector<vk::DeviceSize, MAX_VERTEX_BUFFER_BINDINGS> offsets{};
+					offsets.resize(packet.count);
+					std::memcpy(offsets.data(), payload + sizeof(CountPacket) + packet.count * sizeof(vk::Buffer), packet.count * sizeof(vk::DeviceSize));
+					bind_vertex_buffer(packet.first, buffers, offsets);
+					break;
+				}
+				case PacketType::eDraw:
+				{
+					const auto packet = read_packet<DrawPacket>(payload);
+					draw(packet.vertexCount, packet.instanceCount, packet.firstVertex, packet.firstInstance);
+					break;
+				}
+				case PacketType::eDrawIndexed:
+				{
+					const auto packet = read_packet<DrawIndexedPacket>(payload);
+					draw_indexed(packet.indexCount, packet.instanceCount, packet.firstIndex, packet.vertexOffset, packet.firstInstance);
+					break;
+				}
+				case PacketType::eDrawIndirect:
+				{
+					const auto packet = read_packet<DrawIndirectPacket>(payload);
+					draw_indirect(packet.buffer, packet.offset, packet.drawCount, packet.stride);
+					break;
+				}
+				case PacketType::eDrawIndexedIndirect:
+				{
+					const auto packet = read_packet<DrawIndirectPacket>(payload);
+					draw_indexed_indirect(packet.buffer, packet.offset, packet.drawCount, packet.stride);
+					break;
+				}
+				case PacketType::eDrawIndexedIndirectCount:
+				{
+					const auto packet = read_packet<DrawIndirectCountPacket>(payload);
+					draw_indexed_indirect_count(packet.buffer, packet.offset, packet.countBuffer, packet.countOffset, packet.maxDrawCount, packet.stride);
+					break;
+				}
+				case PacketType::eDrawMeshTasks:
+				{
+					const auto packet = read_packet<DispatchPacket>(payload);
+					draw_mesh_tasks(packet.groupCountX, packet.groupCountY, packet.groupCountZ);
+					break;
+				}
+				case PacketType::eDrawMeshTasksIndirect:
+				{
+					const auto packet = read_packet<DrawIndirectPacket>(payload);
+					draw_mesh_tasks_indirect(packet.buffer, packet.offset, packet.drawCount, packet.stride);
+					break;
+				}
+				case PacketType::eDrawMeshTasksIndirectCount:
+				{
+					const auto packet = read_packet<DrawIndirectCountPacket>(payload);
+					draw_mesh_tasks_indirect_count(packet.buffer, packet.offset, packet.countBuffer, packet.countOffset, packet.maxDrawCount, packet.stride);
+					break;
+				}
+				case PacketType::eTextureBarriers:
+				{
+					const auto packet = read_packet<TextureBarriersPacket>(payload);
+					for (std::uint32_t i = 0; i < packet.barrierCount; ++i)
+					{
+						add_barrier(read_packet<vk::ImageMemoryBarrier2>(payload + sizeof(TextureBarriersPacket) + i * sizeof(vk::ImageMemoryBarrier2)));
+					}
+					break;
+				}
+				case PacketType::eBeginTextureTransition:
+				{
+					const auto packet = read_packet<TextureBarriersPacket>(payload);
+					record_texture_transition_begin(packet.texture, read_texture_barriers(payload, packet.barrierCount));
+					break;
+				}
+				case PacketType::eEndTextureTransition:
+				{
+					const auto packet = read_packet<TextureBarriersPacket>(payload);
+					end_texture_transition(packet.texture);
+					break;
+				}
+				case PacketType::eWriteTimestamp:
+				{
+					const auto packet = read_packet<WriteTimestampPacket>(payload);
+					write_timestamp(packet.queryPool, packet.query, packet.stage);
+					break;
+				}
+				case PacketType::eBeginQuery:
+				{
+					const auto packet = read_packet<QueryPacket>(payload);
+					begin_query(packet.queryPool, packet.query, packet.flags);
+					break;
+				}
+				case PacketType::eEndQuery:
+				{
+					const auto packet = read_packet<QueryPacket>(payload);
+					end_query(packet.queryPool, packet.query);
+					break;
+				}
+				case PacketType::eBeginDebugLabel:
+				{
+					// The name trails the packet, count is its length.
+					const auto packet = read_packet<CountPacket>(payload);
+					begin_debug_label(std::string_view(reinterpret_cast<const char*>(payload + sizeof(CountPacket)), packet.count));
+					break;
+				}
+				case PacketType::eEndDebugLabel:
+					end_debug_label();
+					break;
+				case PacketType::eCopyBufferToTexture:
+				{
+					const auto packet = read_packet<CopyBufferToTexturePacket>(payload);
+					copy_buffer_to_texture(packet.buffer, packet.texture, packet.bufferOffset, packet.mipLevel);
+					break;
+				}
+				case PacketType::eCopyBufferToTextureRegions:
+				{
+					const auto packet = read_packet<CopyBufferToTextureRegionsPacket>(payload);
+					InlineVector<BufferTextureCopyRegion, MAX_COPY_REGIONS> regions{};
+					regions.resize(packet.regionCount);
+					std::memcpy(regions.data(), payload + sizeof(CopyBufferToTextureRegionsPacket), packet.regionCount * sizeof(BufferTextureCopyRegion));
+					copy_buffer_to_texture(packet.buffer, packet.texture, regions);
+					break;
+				}
+				case PacketType::eBlitMipLevel:
+				{
+					const auto packet = read_packet<BlitMipLevelPacket>(payload);
+					blit_mip_level(packet.texture, packet.mipLevel, packet.filter);
+					break;
+				}
+				case PacketType::eCopyBuffer:
+				{
+					const auto packet = read_packet<CopyBufferPacket>(payload);
+					InlineVector<BufferCopyRegion, MAX_COPY_REGIONS> regions{};
+					regions.resize(packet.regionCount);
+					std::memcpy(regions.data(), payload + sizeof(CopyBufferPacket), packet.regionCount * sizeof(BufferCopyRegion));
+					copy_buffer(packet.srcBuffer, packet.dstBuffer, regions);
+					break;
+				}
+				case PacketType::eCopyTextureToBuffer:
+				{
+					const auto packet = read_packet<CopyTextureToBufferPacket>(payload);
+					InlineVector<TextureCopyRegion, MAX_COPY_REGIONS> regions{};
+					regions.resize(packet.regionCount);
+					std::memcpy(regions.data(), payload + sizeof(CopyTextureToBufferPacket), packet.regionCount * sizeof(TextureCopyRegion));
+					copy_texture_to_buffer(packet.texture, packet.buffer, regions);
+					break;
+				}
+				case PacketType::eCopyTexture:
+				case PacketType::eResolveTexture:
+				{
+					const auto packet = read_packet<CopyTexturePacket>(payload);
+					InlineVector<TextureRegionCopy, MAX_COPY_REGIONS> regions{};
+					regions.resize(packet.regionCount);
+					std::memcpy(regions.data(), payload + sizeof(CopyTexturePacket), packet.regionCount * sizeof(TextureRegionCopy));
+					if (header.type == PacketType::eCopyTexture)
+					{
+						copy_texture(packet.srcTexture, packet.dstTexture, regions);
+					}
+					else
+					{
+						resolve_texture(packet.srcTexture, packet.dstTexture, regions);
+					}
+					break;
+				}
+				case PacketType::eBlitTexture:
+				{
+					const auto packet = read_packet<BlitTexturePacket>(payload);
+					InlineVector<TextureBlitRegion, MAX_COPY_REGIONS> regions{};
+					regions.resize(packet.regionCount);
+					std::memcpy(regions.data(), payload + sizeof(BlitTexturePacket), packet.regionCount * sizeof(TextureBlitRegion));
+					blit_texture(packet.srcTexture, packet.dstTexture, regions, packet.filter);
+					break;
+				}
+				case PacketType::eFillBuffer:
+				{
+					const auto packet = read_packet<FillBufferPacket>(payload);
+					fill_buffer(packet.buffer, packet.offset, packet.size, packet.value);
+					break;
+				}
+				case PacketType::eUpdateBuffer:
+				{
+					const auto packet = read_packet<UpdateBufferPacket>(payload);
+					update_buffer(packet.buffer, packet.offset, packet.size, payload + sizeof(UpdateBufferPacket));
+					break;
+				}
+				case PacketType::eTransferTextureOwnership:
+				{
+					add_ownership_barrier(read_packet<vk::ImageMemoryBarrier2>(payload));
+					break;
+				}
+				case PacketType::eTransferBufferOwnership:
+				{
+					const auto packet = read_packet<TransferBufferOwnershipPacket>(payload);
+					transfer_buffer_ownership(packet.buffer, packet.transfer);
+					break;
+				}
+				case PacketType::eBufferBarrier:
+				{
+					const auto packet = read_packet<BufferBarrierPacket>(payload);
+					buffer_barrier(packet.buffer, packet.srcStages, packet.srcAccess, packet.dstStages, packet.dstAccess, packet.offset, packet.size);
+					break;
+				}
+				case PacketType::eMemoryBarrier:
+				{
+					const auto packet = read_packet<MemoryBarrierPacket>(payload);
+					memory_barrier(packet.srcStages, packet.srcAccess, packet.dstStages, packet.dstAccess);
+					break;
+				}
+				case PacketType::eBuildAccelerationStructures:
+				{
+					const auto packet = read_packet<BuildAccelerationStructuresPacket>(payload);
+					ScratchVector<vk::AccelerationStructureBuildGeometryInfoKHR> buildInfos(packet.buildCount);
+					ScratchVector<vk::AccelerationStructureGeometryKHR> geometries(packet.geometryCount);
+					ScratchVector<vk::AccelerationStructureBuildRangeInfoKHR> buildRanges(packet.geometryCount);
+					const auto* data = payload + sizeof(BuildAccelerationStructuresPacket);
+					std::memcpy(buildInfos.data(), data, packet.buildCount * sizeof(vk::AccelerationStructureBuildGeometryInfoKHR));
+					data += packet.buildCount * sizeof(vk::AccelerationStructureBuildGeometryInfoKHR);
+					std::memcpy(geometries.data(), data, packet.geometryCount * sizeof(vk::AccelerationStructureGeometryKHR));
+					data += packet.geometryCount * sizeof(vk::AccelerationStructureGeometryKHR);
+					std::memcpy(buildRanges.data(), data, packet.geometryCount * sizeof(vk::AccelerationStructureBuildRangeInfoKHR));
+					build_acceleration_structures(buildInfos, geometries, buildRanges);
+					break;
+				}
+				case PacketType::eCopyAccelerationStructure:
+				{
+					const auto packet = read_packet<CopyAccelerationStructurePacket>(payload);
+					copy_acceleration_structure(packet.src, packet.dst, packet.mode);
+					break;
+				}
+				case PacketType::eWriteAccelerationStructureSize:
+				{
+					const auto packet = read_packet<AccelerationStructureSizePacket>(payload);
+					write_acceleration_structure_size(packet.accelerationStructure, packet.queryPool, packet.query);
+					break;
+				}
+				default:
+					GFX_ASSERT(false, "Unknown command stream packet!");
+					break;
+			}
+			cursor += header.size;
+		}
+
+		flush_barriers();
+		m_commandBuffer->end();
+
+		m_translating = false;
+		m_translationPending.store(false, std::memory_order_release);
+		m_translationPending.notify_all();
+	}
+
+	auto CommandList::take_command_buffer() -> std::pair<CommandPool*, vk::CommandBuffer>
+	{
+		return { m_commandPool, m_commandBuffer.release() };
+	}
+
+	void CommandList::wait_for_translation() const
+	{
+		m_translationPending.wait(true, std::memory_order_acquire);
+	}
+
+	CommandList::CommandList(CommandPool& commandPool, vk::Queue queue, vk::CommandBufferLevel level, std::uint32_t flags)
+		: m_commandPool(&commandPool), m_queue(queue), m_level(level), m_flags(flags)
+	{
+		// Deferred command lists get their command buffer when they are translated.
+		if (!is_deferred())
+		{
+			m_commandBuffer = m_commandPool->allocate(m_level);
+		}
+	}
+
+	CommandList::CommandList(CommandPool& commandPool, vk::Queue queue, vk::CommandBufferLevel level, vk::CommandBuffer transientCommandBuffer)
+		: m_commandPool(&commandPool), m_queue(queue), m_level(level), m_flags(CommandListFlags_OneTimeSubmit)
+	{
+		// Owned by the transient pool, so it is never freed through this handle (see ~CommandList()).
+		using PoolFree = vk::PoolFree<vk::Device, vk::CommandPool, VULKAN_HPP_DEFAULT_DISPATCHER_TYPE>;
+		m_commandBuffer = vk::UniqueCommandBuffer(transientCommandBuffer, PoolFree());
+	}
+
+	CommandList::CommandList(CommandList&& other) noexcept
+	{
+		std::swap(m_commandPool, other.m_commandPool);
+		std::swap(m_queue, other.m_queue);
+		std::swap(m_level, other.m_level);
+		std::swap(m_flags, other.m_flags);
+		std::swap(m_commandBuffer, other.m_commandBuffer);
+		std::swap(m_hasBegun, other.m_hasBegun);
+		std::swap(m_boundPipeline, other.m_boundPipeline);
+		std::swap(m_boundState, other.m_boundState);
+		std::swap(m_pendingImageBarriers, other.m_pendingImageBarriers);
+		std::swap(m_pendingBufferBarriers, other.m_pendingBufferBarriers);
+		std::swap(m_pendingTransferWriteBarriers, other.m_pendingTransferWriteBarriers);
+		std::swap(m_pendingMemoryBarrier, other.m_pendingMemoryBarrier);
+		std::swap(m_trackedBarriers, other.m_trackedBarriers);
+		std::swap(m_splitTransitions, other.m_splitTransitions);
+		std::swap(m_events, other.m_events);
+		std::swap(m_usedEventCount, other.m_usedEventCount);
+		std::swap(m_gpuScopes, other.m_gpuScopes);
+		std::swap(m_activeQueries, other.m_activeQueries);
+		std::swap(m_markerDepth, other.m_markerDepth);
+		std::swap(m_stats, other.m_stats);
+		std::swap(m_referencedResources, other.m_referencedResources);
+		std::swap(m_readbacks, other.m_readbacks);
+		std::swap(m_commandStream, other.m_commandStream);
+		std::swap(m_translating, other.m_translating);
+		m_translationPending.store(other.m_translationPending.exchange(false));
+	}
+
+	CommandList::~CommandList()
+	{
+		wait_for_translation();
+
+		if (m_commandPool == nullptr || !m_commandBuffer)
+		{
+			return;
+		}
+
+		if (m_commandPool->is_transient())
+		{
+			// The buffer is recycled when the pool is reset.
+			GFX_UNUSED(m_commandBuffer.release());
+			return;
+		}
+
+		// May run on any thread, so hand the command buffer back for the pool's owning thread to free.
+		m_commandPool->release(m_commandBuffer.release());
+	}
+
+	bool CommandList::is_valid() const
+	{
+		return static_cast<bool>(*m_commandBuffer);
+	}
+
+	auto CommandList::get_usage_flags() const -> vk::CommandBufferUsageFlags
+	{
+		vk::CommandBufferUsageFlags usageFlags{};
+		if (m_flags & (CommandListFlags_OneTimeSubmit | CommandListFlags_FireAndForget))
+		{
+			usageFlags |= vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+		}
+		if (m_flags & CommandListFlags_SimultaneousUse)
+		{
+			usageFlags |= vk::CommandBufferUsageFlagBits::eSimultaneousUse;
+		}
+		return usageFlags;
+	}
+
+	void CommandList::reset()
+	{
+		if (is_transient())
+		{
+			s_errorCallback("GFX - Transient CommandLists cannot be reset, they are recycled by begin_frame()!");
+			return;
+		}
+
+		if (is_deferred())
+		{
+			// The command buffer belongs to the translating thread's pool, so it is replaced by the next translation instead.
+			wait_for_translation();
+			m_commandStream.clear();
+		}
+		else
+		{
+			m_commandBuffer->reset();
+		}
+		m_hasBegun = false;
+		m_boundPipeline = nullptr;
+		reset_bound_state();
+		m_referencedResources.clear();
+		m_pendingImageBarriers.clear();
+		m_pendingBufferBarriers.clear();
+		m_pendingTransferWriteBarriers.clear();
+		m_pendingMemoryBarrier.reset();
+		m_splitTransitions.clear();
+		m_gpuScopes.clear();
+		m_activeQueries = {};
+	}
+
+	void CommandList::begin()
+	{
+		if (m_hasBegun)
+		{
+			s_errorCallback("GFX - CommandList has already begun recording!");
+			return;
+		}
+
+		m_hasBegun = true;
+		reset_bound_state();
+		m_readbacks.clear();
+		m_splitTransitions.clear();
+		m_gpuScopes.clear();
+		m_activeQueries = {};
+		m_markerDepth = 0;
+		if (is_deferred())
+		{
+			m_commandStream.clear();
+			return;
+		}
+
+		vk::CommandBufferBeginInfo cmd_begin_info{};
+		cmd_begin_info.setFlags(get_usage_flags());
+		m_commandBuffer->begin(cmd_begin_info);
+		m_usedEventCount = 0;
+		m_stats = {};
+	}
+
+	bool CommandList::end()
+	{
+		if (!m_hasBegun)
+		{
+			s_errorCallback("GFX - Cannot end() CommandList that has not even begun!");
+			return false;
+		}
+		if (!m_gpuScopes.empty())
+		{
+			s_errorCallback("GFX - CommandList ended with GPU scopes begun but not ended!");
+			m_gpuScopes.clear();
+		}
+		if (std::ranges::any_of(m_activeQueries, [](const auto& query) { return query.has_value(); }))
+		{
+			s_errorCallback("GFX - CommandList ended with GPU queries begun but not ended!");
+			m_activeQueries = {};
+		}
+		while (m_markerDepth > 0)
+		{
+			pop_marker();
+		}
+		if (is_recording_deferred())
+		{
+			// Cleared by translate(), which the Device queues once end() returns.
+			m_translationPending.store(true, std::memory_order_release);
+			return true;
+		}
+
+		if (!m_splitTransitions.empty())
+		{
+			s_errorCallback("GFX - CommandList ended with texture transitions begun but not ended!");
+			m_splitTransitions.clear();
+		}
+
+		flush_barriers();
+		if (m_commandBuffer->end() != vk::Result::eSuccess)
+		{
+			s_errorCallback("GFX - Failed to end command buffer!");
+			return false;
+		}
+		return true;
+	}
+
+	void CommandList::begin_secondary(std::span<Texture* const> colorAttachmentTextures, Texture* depthAttachmentTexture, std::uint32_t viewMask)
+	{
+		if (m_hasBegun)
+		{
+			s_errorCallback("GFX - CommandList has already begun recording!");
+			return;
+		}
+		GFX_ASSERT(is_secondary(), "begin_secondary() requires a secondary command list!");
+
+		InlineVector<vk::Format, MAX_COLOR_ATTACHMENTS> colorFormats{};
+		for (auto* texture : colorAttachmentTextures)
+		{
+			colorFormats.push_back(texture->get_format());
+		}
+
+		vk::CommandBufferInheritanceRenderingInfo inheritance_rendering_info{};
+		inheritance_rendering_info.setViewMask(viewMask);
+		inheritance_rendering_info.setColorAttachmentFormats(colorFormats);
+		if (depthAttachmentTexture != nullptr)
+		{
+			inheritance_rendering_info.setDepthAttachmentFormat(depthAttachmentTexture->get_format());
+			if (get_format_aspect_mask(depthAttachmentTexture->get_format()) & vk::ImageAspectFlagBits::eStencil)
+			{
+				inheritance_rendering_info.setStencilAttachmentFormat(depthAttachmentTexture->get_format());
+			}
+		}
+		const auto* sampledTexture = colorAttachmentTextures.empty() ? depthAttachmentTexture : colorAttachmentTextures.front();
+		inheritance_rendering_info.setRasterizationSamples(sampledTexture != nullptr ? sampledTexture->get_sample_count() : vk::SampleCountFlagBits::e1);
+
+		vk::CommandBufferInheritanceInfo inheritance_info{};
+		inheritance_info.setPNext(&inheritance_rendering_info);
+
+		vk::CommandBufferBeginInfo cmd_begin_info{};
+		cmd_begin_info.setFlags(get_usage_flags() | vk::CommandBufferUsageFlagBits::eRenderPassContinue);
+		cmd_begin_info.setPInheritanceInfo(&inheritance_info);
+		m_commandBuffer->begin(cmd_begin_info);
+		m_hasBegun = true;
+		reset_bound_state();
+	}
+
+	void CommandList::begin_render_pass(std::span<Texture* const> colorAttachmentTextures, Texture* depthAttachmentTexture, const std::array<float, 4>& clearColor, bool secondaryContents,
+										std::span<const std::uint32_t> colorAttachmentViews, std::uint32_t depthAttachmentView, std::span<Texture* const> resolveAttachmentTextures,
+										const AttachmentOps& attachmentOps, const vk::Rect2D& renderArea, std::uint32_t viewMask, const ShadingRateAttachment& shadingRateAttachment)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		GFX_ASSERT(colorAttachmentViews.empty() || colorAttachmentViews.size() == colorAttachmentTextures.size(), "Every color attachment needs a view index!");
+		GFX_ASSERT(resolveAttachmentTextures.empty() || resolveAttachmentTextures.size() == colorAttachmentTextures.size(), "Every color attachment needs a resolve slot!");
+		if (is_recording_deferred())
+		{
+			BeginRenderPassPacket packet{ std::uint32_t(colorAttachmentTextures.size()), secondaryContents, {}, depthAttachmentTexture, clearColor, {}, depthAttachmentView, {}, attachmentOps, renderArea, viewMask, shadingRateAttachment };
+			std::copy(colorAttachmentTextures.begin(), colorAttachmentTextures.end(), packet.colorAttachments.begin());
+			std::copy(colorAttachmentViews.begin(), colorAttachmentViews.end(), packet.colorAttachmentViews.begin());
+			std::copy(resolveAttachmentTextures.begin(), resolveAttachmentTextures.end(), packet.resolveAttachments.begin());
+			write_packet(PacketType::eBeginRenderPass, packet);
+			return;
+		}
+
+		flush_barriers();
+
+		InlineVector<vk::RenderingAttachmentInfo, MAX_COLOR_ATTACHMENTS> colorAttachments{};
+		colorAttachments.resize(colorAttachmentTextures.size());
+		for (auto i = 0; i < colorAttachments.size(); ++i)
+		{
+			auto* texture = colorAttachmentTextures[i];
+			auto& attachment = colorAttachments[i];
+			attachment.setImageView(texture->get_view(colorAttachmentViews.empty() ? 0 : colorAttachmentViews[i]));
+			attachment.setImageLayout(attachmentOps.localRead ? vk::ImageLayout::eRenderingLocalReadKHR : vk::ImageLayout::eAttachmentOptimal);
+			attachment.setLoadOp(convert_load_op_to_vk_attachment_load_op(attachmentOps.colorLoadOps[i]));
+			attachment.setStoreOp(texture->is_transient() ? vk::AttachmentStoreOp::eDontCare : convert_store_op_to_vk_attachment_store_op(attachmentOps.colorStoreOps[i]));
+			attachment.setClearValue(vk::ClearColorValue(clearColor));
+			if (!resolveAttachmentTextures.empty() && resolveAttachmentTextures[i] != nullptr)
+			{
+				// Resolved as the tiles are written out, so a transient multisampled attachment is never stored.
+				// Integer formats cannot be averaged, they keep the first sample instead.
+				attachment.setResolveMode(is_integer_format(texture->get_format()) ? vk::ResolveModeFlagBits::eSampleZero : vk::ResolveModeFlagBits::eAverage);
+				attachment.setResolveImageView(resolveAttachmentTextures[i]->get_view());
+				attachment.setResolveImageLayout(vk::ImageLayout::eAttachmentOptimal);
+			}
+		}
+
+		vk::RenderingAttachmentInfo depthAttachment{};
+		if (depthAttachmentTexture != nullptr)
+		{
+			depthAttachment.setImageView(depthAttachmentTexture->get_view(depthAttachmentView));
+			depthAttachment.setImageLayout(vk::ImageLayout::eAttachmentOptimal);
+			depthAttachment.setLoadOp(convert_load_op_to_vk_attachment_load_op(attachmentOps.depthLoadOp));
+			depthAttachment.setStoreOp(depthAttachmentTexture->is_transient() ? vk::AttachmentStoreOp::eDontCare : convert_store_op_to_vk_attachment_store_op(attachmentOps.depthStoreOp));
+			depthAttachment.setClearValue(vk::ClearDepthStencilValue(1.0f, 0)); // #TODO: Optional.
+		}
+
+		// Rendering into a view of a finer level covers that level only. Depth-only passes, eg. shadow maps, take the depth attachment's.
+		auto passArea = renderArea;
+		if (passArea.extent.width == 0)
+		{
+			const auto* areaTexture = colorAttachmentTextures.empty() ? depthAttachmentTexture : colorAttachmentTextures.front();
+			GFX_ASSERT(areaTexture != nullptr, "A render pass without attachments needs a render area!");
+			const auto areaView = colorAttachmentTextures.empty() ? depthAttachmentView : (colorAttachmentViews.empty() ? 0 : colorAttachmentViews.front());
+			const auto textureExtent = areaTexture->get_mip_extent(areaTexture->get_view_range(areaView).baseMipLevel);
+			passArea = vk::Rect2D{ vk::Offset2D{ 0, 0 }, vk::Extent2D{ textureExtent.width, textureExtent.height } };
+		}
+
+		vk::RenderingInfo rendering_info{};
+		rendering_info.setLayerCount(1); // Ignored by multiview, which renders a layer per view.
+		rendering_info.setViewMask(viewMask);
+		rendering_info.setColorAttachments(colorAttachments);
+		if (depthAttachmentTexture != nullptr)
+		{
+			rendering_info.setPDepthAttachment(&depthAttachment);
+			if (get_format_aspect_mask(depthAttachmentTexture->get_format()) & vk::ImageAspectFlagBits::eStencil)
+			{
+				rendering_info.setPStencilAttachment(&depthAttachment);
+			}
+		}
+		rendering_info.setRenderArea(passArea);
+		vk::RenderingFragmentShadingRateAttachmentInfoKHR shading_rate_attachment_info{};
+		if (shadingRateAttachment.texture != nullptr)
+		{
+			shading_rate_attachment_info.setImageView(shadingRateAttachment.texture->get_view());
+			shading_rate_attachment_info.setImageLayout(vk::ImageLayout::eFragmentShadingRateAttachmentOptimalKHR);
+			shading_rate_attachment_info.setShadingRateAttachmentTexelSize(shadingRateAttachment.texelSize);
+			rendering_info.setPNext(&shading_rate_attachment_info);
+		}
+		if (secondaryContents)
+		{
+			rendering_info.setFlags(vk::RenderingFlagBits::eContentsSecondaryCommandBuffers);
+		}
+
+		m_commandBuffer->beginRendering(rendering_info);
+	}
+
+	void CommandList::end_render_pass()
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eEndRenderPass, EmptyPacket{});
+			return;
+		}
+
+		m_commandBuffer->endRendering();
+	}
+
+	void CommandList::execute_commands(std::span<const vk::CommandBuffer> secondaryCommandBuffers)
+	{
+		if (!m_hasBegun || secondaryCommandBuffers.empty())
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eExecuteCommands, CountPacket{ 0, std::uint32_t(secondaryCommandBuffers.size()) }, secondaryCommandBuffers.data(), secondaryCommandBuffers.size_bytes());
+			return;
+		}
+
+		m_commandBuffer->executeCommands(secondaryCommandBuffers);
+
+		// State bound before executing secondaries is undefined afterwards.
+		m_boundPipeline = nullptr;
+		reset_bound_state();
+	}
+
+	void CommandList::set_viewport(float x, float y, float width, float height, float minDepth, float maxDepth)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eSetViewport, ViewportPacket{ x, y, width, height, minDepth, maxDepth });
+			return;
+		}
+
+		vk::Viewport viewport{ x, y + height, width, -height, minDepth, maxDepth };
+		if (m_boundState.viewport == viewport)
+		{
+			return;
+		}
+
+		m_commandBuffer->setViewportWithCount(viewport);
+		m_boundState.viewport = viewport;
+	}
+
+	void CommandList::set_scissor(std::int32_t x, std::int32_t y, std::uint32_t width, std::uint32_t height)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eSetScissor, ScissorPacket{ x, y, width, height });
+			return;
+		}
+
+		vk::Rect2D scissor{ { x, y }, { width, height } };
+		if (m_boundState.scissor == scissor)
+		{
+			return;
+		}
+
+		m_commandBuffer->setScissorWithCount(scissor);
+		m_boundState.scissor = scissor;
+	}
+
+	void CommandList::set_cull_mode(vk::CullModeFlags cullMode)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eSetCullMode, CullModePacket{ cullMode });
+			return;
+		}
+		if (m_boundState.cullMode == cullMode)
+		{
+			return;
+		}
+
+		m_commandBuffer->setCullMode(cullMode);
+		m_boundState.cullMode = cullMode;
+	}
+
+	void CommandList::set_front_face(vk::FrontFace frontFace)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eSetFrontFace, FrontFacePacket{ frontFace });
+			return;
+		}
+		if (m_boundState.frontFace == frontFace)
+		{
+			return;
+		}
+
+		m_commandBuffer->setFrontFace(frontFace);
+		m_boundState.frontFace = frontFace;
+	}
+
+	void CommandList::set_primitive_topology(vk::PrimitiveTopology topology, bool primitiveRestart)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eSetPrimitiveTopology, PrimitiveTopologyPacket{ topology, primitiveRestart });
+			return;
+		}
+
+		if (m_boundState.topology != topology)
+		{
+			m_commandBuffer->setPrimitiveTopology(topology);
+			m_boundState.topology = topology;
+		}
+		if (m_boundState.primitiveRestart != primitiveRestart)
+		{
+			m_commandBuffer->setPrimitiveRestartEnable(primitiveRestart);
+			m_boundState.primitiveRestart = primitiveRestart;
+		}
+	}
+
+	void CommandList::set_depth_state(bool depthTest, bool depthWrite, vk::CompareOp depthCompareOp)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eSetDepthState, DepthStatePacket{ depthTest, depthWrite, depthCompareOp });
+			return;
+		}
+
+		if (m_boundState.depthTest != depthTest)
+		{
+			m_commandBuffer->setDepthTestEnable(depthTest);
+			m_boundState.depthTest = depthTest;
+		}
+		if (m_boundState.depthWrite != depthWrite)
+		{
+			m_commandBuffer->setDepthWriteEnable(depthWrite);
+			m_boundState.depthWrite = depthWrite;
+		}
+		if (m_boundState.depthCompareOp != depthCompareOp)
+		{
+			m_commandBuffer->setDepthCompareOp(depthCompareOp);
+			m_boundState.depthCompareOp = depthCompareOp;
+		}
+	}
+
+	void CommandList::set_stencil_state(bool stencilTest, const vk::StencilOpState& stencilFront, const vk::StencilOpState& stencilBack)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eSetStencilState, StencilStatePacket{ stencilTest, stencilFront, stencilBack });
+			return;
+		}
+
+		m_commandBuffer->setStencilTestEnable(stencilTest);
+		const std::array faces{ std::pair{ vk::StencilFaceFlagBits::eFront, stencilFront }, std::pair{ vk::StencilFaceFlagBits::eBack, stencilBack } };
+		for (const auto& [face, state] : faces)
+		{
+			m_commandBuffer->setStencilOp(face, state.failOp, state.passOp, state.depthFailOp, state.compareOp);
+			m_commandBuffer->setStencilCompareMask(face, state.compareMask);
+			m_commandBuffer->setStencilWriteMask(face, state.writeMask);
+			m_commandBuffer->setStencilReference(face, state.reference);
+		}
+	}
+
+	void CommandList::set_blend_states(std::uint32_t firstAttachment, std::span<const vk::PipelineColorBlendAttachmentState> blendStates)
+	{
+		if (!m_hasBegun || blendStates.empty())
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eSetBlendStates, CountPacket{ firstAttachment, std::uint32_t(blendStates.size()) }, blendStates.data(), blendStates.size_bytes());
+			return;
+		}
+
+		InlineVector<vk::Bool32, MAX_COLOR_ATTACHMENTS> blendEnables{};
+		InlineVector<vk::ColorBlendEquationEXT, MAX_COLOR_ATTACHMENTS> blendEquations{};
+		InlineVector<vk::ColorComponentFlags, MAX_COLOR_ATTACHMENTS> writeMasks{};
+		for (const auto& blendState : blendStates)
+		{
+			blendEnables.push_back(blendState.blendEnable);
+			blendEquations.push_back(vk::ColorBlendEquationEXT{ blendState.srcColorBlendFactor, blendState.dstColorBlendFactor, blendState.colorBlendOp,
+																blendState.srcAlphaBlendFactor, blendState.dstAlphaBlendFactor, blendState.alphaBlendOp });
+			writeMasks.push_back(blendState.colorWriteMask);
+		}
+		m_commandBuffer->setColorBlendEnableEXT(firstAttachment, blendEnables);
+		m_commandBuffer->setColorBlendEquationEXT(firstAttachment, blendEquations);
+		m_commandBuffer->setColorWriteMaskEXT(firstAttachment, writeMasks);
+	}
+
+	void CommandList::set_shading_rate(vk::Extent2D fragmentSize, const std::array<vk::FragmentShadingRateCombinerOpKHR, 2>& combinerOps)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eSetShadingRate, ShadingRatePacket{ fragmentSize, combinerOps });
+			return;
+		}
+
+		m_commandBuffer->setFragmentShadingRateKHR(fragmentSize, combinerOps);
+	}
+
+	void CommandList::begin_conditional(Buffer* buffer, std::uint64_t offset, bool inverted)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eBeginConditional, ConditionalPacket{ buffer, offset, inverted });
+			return;
+		}
+
+		// Barriers recorded before are flushed outside the block, where they belong.
+		flush_barriers();
+		const vk::ConditionalRenderingBeginInfoEXT begin_info{ buffer->get_buffer(), offset,
+															   inverted ? vk::ConditionalRenderingFlagBitsEXT::eInverted : vk::ConditionalRenderingFlagsEXT{} };
+		m_commandBuffer->beginConditionalRenderingEXT(begin_info);
+		track_resource(get_resource_key(buffer->get_buffer()));
+	}
+
+	void CommandList::end_conditional()
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eEndConditional, EmptyPacket{});
+			return;
+		}
+
+		flush_barriers();
+		m_commandBuffer->endConditionalRenderingEXT();
+	}
+
+	void CommandList::local_read_barrier()
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eLocalReadBarrier, EmptyPacket{});
+			return;
+		}
+
+		// Inside the pass, so by region: each fragment only waits for the writes to its own pixel, which stay on chip.
+		flush_barriers();
+		const vk::MemoryBarrier2 barrier{ vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentWrite, vk::PipelineStageFlagBits2::eFragmentShader,
+										  vk::AccessFlagBits2::eInputAttachmentRead };
+		vk::DependencyInfo dependency_info{};
+		dependency_info.setDependencyFlags(vk::DependencyFlagBits::eByRegion);
+		dependency_info.setMemoryBarriers(barrier);
+		m_commandBuffer->pipelineBarrier2(dependency_info);
+		GFX_COUNT_STAT(m_stats.barriers, 1);
+	}
+
+	void CommandList::build_acceleration_structures(std::span<const vk::AccelerationStructureBuildGeometryInfoKHR> buildInfos, std::span<const vk::AccelerationStructureGeometryKHR> geometries,
+													std::span<const vk::AccelerationStructureBuildRangeInfoKHR> buildRanges)
+	{
+		if (!m_hasBegun || buildInfos.empty())
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			// The pointers into geometries are rebuilt on replay, so the arrays are packed one after the other.
+			const auto infosSize = buildInfos.size_bytes();
+			const auto geometriesSize = geometries.size_bytes();
+			ScratchVector<std::byte> data(infosSize + geometriesSize + buildRanges.size_bytes());
+			std::memcpy(data.data(), buildInfos.data(), infosSize);
+			std::memcpy(data.data() + infosSize, geometries.data(), geometriesSize);
+			std::memcpy(data.data() + infosSize + geometriesSize, buildRanges.data(), buildRanges.size_bytes());
+			write_packet(PacketType::eBuildAccelerationStructures, BuildAccelerationStructuresPacket{ std::uint32_t(buildInfos.size()), std::uint32_t(geometries.size()) }, data.data(),
+						 data.size());
+			return;
+		}
+
+		ScratchVector<vk::AccelerationStructureBuildGeometryInfoKHR> vk_build_infos(buildInfos.begin(), buildInfos.end());
+		ScratchVector<const vk::AccelerationStructureBuildRangeInfoKHR*> vk_build_ranges(buildInfos.size());
+		std::uint32_t firstGeometry{ 0 };
+		for (std::size_t i = 0; i < vk_build_infos.size(); ++i)
+		{
+			vk_build_infos[i].setPGeometries(geometries.data() + firstGeometry);
+			vk_build_ranges[i] = buildRanges.data() + firstGeometry;
+			firstGeometry += vk_build_infos[i].geometryCount;
+		}
+		GFX_ASSERT(firstGeometry == geometries.size() && geometries.size() == buildRanges.size(), "Acceleration structure builds do not match their geometries!");
+
+		flush_barriers();
+		m_commandBuffer->buildAccelerationStructuresKHR(std::uint32_t(vk_build_infos.size()), vk_build_infos.data(), vk_build_ranges.data());
+	}
+
+	void CommandList::copy_acceleration_structure(vk::AccelerationStructureKHR src, vk::AccelerationStructureKHR dst, vk::CopyAccelerationStructureModeKHR mode)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eCopyAccelerationStructure, CopyAccelerationStructurePacket{ src, dst, mode });
+			return;
+		}
+
+		flush_barriers();
+		m_commandBuffer->copyAccelerationStructureKHR(vk::CopyAccelerationStructureInfoKHR{ src, dst, mode });
+	}
 
-		Pipeline* pipeline{ nullptr };
-		if (!device->get_pipeline(pipeline, pipelineHandle))
+	void CommandList::write_acceleration_structure_size(vk::AccelerationStructureKHR accelerationStructure, vk::QueryPool queryPool, std::uint32_t query)
+	{
+		if (!m_hasBegun)
 		{
 			return;
 		}
-		GFX_ASSERT(pipeline != nullptr, "Pipeline should not be null!");
-
-		CommandList* commandList{ nullptr };
-		if (!device->get_command_list(commandList, commandListHandle))
+		if (is_recording_deferred())
 		{
+			write_packet(PacketType::eWriteAccelerationStructureSize, AccelerationStructureSizePacket{ accelerationStructure, queryPool, query });
 			return;
 		}
 
-		commandList->bind_pipeline(pipeline);
+		flush_barriers();
+		m_commandBuffer->writeAccelerationStructuresPropertiesKHR(accelerationStructure, vk::QueryType::eAccelerationStructureCompactedSizeKHR, queryPool, query);
 	}
 
-	void bind_descriptor_sets(CommandListHandle commandListHandle, std::uint32_t firstSet, const std::vector<DescriptorSetHandle>& descriptorSets)
+	void CommandList::bind_pipeline(Pipeline* pipeline)
 	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+		if (pipeline == nullptr)
+		{
+			s_errorCallback("GFX - Command list cannot bind null pipeline!");
+			return;
+		}
 
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		m_boundPipeline = pipeline;
+
+		if (is_recording_deferred())
 		{
+			write_packet(PacketType::eBindPipeline, PointerPacket{ pipeline });
+			return;
+		}
+		if (pipeline->get_type() == PipelineType::eGraphicsShaderObjects)
+		{
+			bind_shader_objects(static_cast<const ShaderObjectPipeline&>(*pipeline));
 			return;
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		std::vector<vk::DescriptorSet> vkDescriptorSets(descriptorSets.size());
-		for (auto i = 0; i < descriptorSets.size(); ++i)
+		const auto bindPointIndex = get_bind_point_index(*pipeline);
+		if (m_boundState.pipelines[bindPointIndex] == pipeline->get_pipeline())
 		{
-			auto descriptorSet = descriptorSets[i];
-			if (!device->get_descriptor_set(vkDescriptorSets[i], descriptorSet))
-			{
-				return;
-			}
+			return;
 		}
 
-		CommandList* commandList{ nullptr };
-		if (!device->get_command_list(commandList, commandListHandle))
+		const vk::PipelineBindPoint bindPoint = pipeline->get_type() == PipelineType::eCompute ? vk::PipelineBindPoint::eCompute : vk::PipelineBindPoint::eGraphics;
+		m_commandBuffer->bindPipeline(bindPoint, pipeline->get_pipeline());
+		GFX_COUNT_STAT(m_stats.pipelineBinds, 1);
+		m_boundState.pipelines[bindPointIndex] = pipeline->get_pipeline();
+		track_resource(get_resource_key(pipeline->get_pipeline()));
+		if (bindPoint == vk::PipelineBindPoint::eGraphics)
+		{
+			m_boundState.vertexShader = vk::ShaderEXT{}; // Binding a pipeline unbinds shader objects of its stages.
+			reset_dynamic_state();
+		}
+
+		// Pipelines with the same interface share a layout, so this only disturbs bound sets when the interface changes.
+		// It is still conservative for layouts that merely share a compatible prefix of sets.
+		if (m_boundState.pipelineLayouts[bindPointIndex] != pipeline->get_pipeline_layout())
+		{
+			m_boundState.pipelineLayouts[bindPointIndex] = pipeline->get_pipeline_layout();
+			m_boundState.descriptorSets[bindPointIndex].fill(vk::DescriptorSet{});
+		}
+	}
+
+	void CommandList::bind_shader_objects(const ShaderObjectPipeline& pipeline)
+	{
+		const auto& state = pipeline.get_state();
+		if (m_boundState.vertexShader == state.vertexShader)
 		{
 			return;
 		}
 
-		commandList->bind_descriptor_sets(firstSet, vkDescriptorSets);
+		// Only the stages the device enables can be bound, and binding them unbinds the graphics pipeline.
+		constexpr std::array stages{ vk::ShaderStageFlagBits::eVertex, vk::ShaderStageFlagBits::eFragment };
+		const std::array shaders{ state.vertexShader, state.fragmentShader };
+		m_commandBuffer->bindShadersEXT(stages, shaders);
+		GFX_COUNT_STAT(m_stats.pipelineBinds, 1);
+		m_boundState.pipelines[get_bind_point_index(pipeline)] = vk::Pipeline{};
+		m_boundState.vertexShader = state.vertexShader;
+		track_resource(get_resource_key(state.vertexShader));
+
+		if (m_boundState.pipelineLayouts[get_bind_point_index(pipeline)] != pipeline.get_pipeline_layout())
+		{
+			m_boundState.pipelineLayouts[get_bind_point_index(pipeline)] = pipeline.get_pipeline_layout();
+			m_boundState.descriptorSets[get_bind_point_index(pipeline)].fill(vk::DescriptorSet{});
+		}
+
+		// Shaders have no static state, every piece of state a draw reads has to be set. Viewport and scissor are left to
+		// the caller as with pipelines.
+		reset_dynamic_state();
+		m_commandBuffer->setVertexInputEXT(state.vertexBindings, state.vertexAttributes);
+		set_primitive_topology(state.topology, false);
+		m_commandBuffer->setRasterizerDiscardEnable(false);
+		m_commandBuffer->setPolygonModeEXT(vk::PolygonMode::eFill);
+		m_commandBuffer->setLineWidth(1.0f);
+		m_commandBuffer->setRasterizationSamplesEXT(state.sampleCount);
+		const vk::SampleMask sampleMask{ ~0u };
+		m_commandBuffer->setSampleMaskEXT(state.sampleCount, sampleMask);
+		m_commandBuffer->setAlphaToCoverageEnableEXT(false);
+		set_cull_mode(state.cullMode);
+		set_front_face(state.frontFace);
+		set_depth_state(state.depthTest, state.depthWrite, state.depthCompareOp);
+		m_commandBuffer->setDepthBiasEnable(false);
+		set_stencil_state(state.stencilTest, state.stencilFront, state.stencilBack);
+		set_blend_states(0, state.blendStates);
+		if (state.shadingRate)
+		{
+			// As pipelines default to, so the pass's shading rate attachment applies.
+			set_shading_rate(vk::Extent2D{ 1, 1 }, { vk::FragmentShadingRateCombinerOpKHR::eKeep, vk::FragmentShadingRateCombinerOpKHR::eReplace });
+		}
 	}
 
-	void set_constants(CommandListHandle commandListHandle, std::uint32_t shaderStages, std::uint32_t offset, std::uint32_t size, const void* data)
+	void CommandList::bind_descriptor_sets(std::uint32_t firstSet, std::span<const vk::DescriptorSet> descriptorSets, std::span<const std::uint32_t> dynamicOffsets)
 	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (m_boundPipeline == nullptr)
+		{
+			s_errorCallback("GFX - Cannot bind descriptor set when no pipeline has been bound!");
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			std::array<std::byte, MAX_BOUND_DESCRIPTOR_SETS * sizeof(vk::DescriptorSet) + MAX_DYNAMIC_OFFSETS * sizeof(std::uint32_t)> extraData{};
+			std::memcpy(extraData.data(), descriptorSets.data(), descriptorSets.size_bytes());
+			std::memcpy(extraData.data() + descriptorSets.size_bytes(), dynamicOffsets.data(), dynamicOffsets.size_bytes());
+			const DescriptorSetsPacket packet{ firstSet, std::uint32_t(descriptorSets.size()), std::uint32_t(dynamicOffsets.size()) };
+			write_packet(PacketType::eBindDescriptorSets, packet, extraData.data(), descriptorSets.size_bytes() + dynamicOffsets.size_bytes());
+			return;
+		}
 
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		// Dynamic offsets usually change between binds of the same sets, so those are never elided.
+		auto& boundSets = m_boundState.descriptorSets[get_bind_point_index(*m_boundPipeline)];
+		const bool isTracked = firstSet + descriptorSets.size() <= boundSets.size();
+		if (isTracked && dynamicOffsets.empty() && std::equal(descriptorSets.begin(), descriptorSets.end(), boundSets.begin() + firstSet))
 		{
 			return;
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		CommandList* commandList{ nullptr };
-		if (!device->get_command_list(commandList, commandListHandle))
+		const vk::PipelineBindPoint bindPoint = m_boundPipeline->get_type() == PipelineType::eCompute ? vk::PipelineBindPoint::eCompute : vk::PipelineBindPoint::eGraphics;
+		const auto pipelineLayout = m_boundPipeline->get_pipeline_layout();
+		m_commandBuffer->bindDescriptorSets(bindPoint, pipelineLayout, firstSet, descriptorSets, dynamicOffsets);
+		GFX_COUNT_STAT(m_stats.descriptorBinds, 1);
+		for (const auto descriptorSet : descriptorSets)
+		{
+			track_resource(get_resource_key(descriptorSet));
+		}
+
+		if (isTracked)
+		{
+			std::copy(descriptorSets.begin(), descriptorSets.end(), boundSets.begin() + firstSet);
+		}
+	}
+
+	void CommandList::push_descriptors(std::uint32_t set, std::span<const ResolvedDescriptor> descriptors)
+	{
+		if (!m_hasBegun || descriptors.empty())
+		{
+			return;
+		}
+		if (m_boundPipeline == nullptr)
+		{
+			s_errorCallback("GFX - Cannot push descriptors when no pipeline has been bound!");
+			return;
+		}
+		if (is_recording_deferred())
 		{
+			write_packet(PacketType::ePushDescriptors, PushDescriptorsPacket{ set, std::uint32_t(descriptors.size()) }, descriptors.data(), descriptors.size_bytes());
 			return;
 		}
 
-		auto vk_shader_stages = convert_shader_stages_to_vk_shader_stage_flags(shaderStages);
-		commandList->set_constants(vk_shader_stages, offset, size, data);
+		InlineVector<vk::WriteDescriptorSet, MAX_PUSH_DESCRIPTORS> writes{};
+		for (const auto& descriptor : descriptors)
+		{
+			vk::WriteDescriptorSet write{};
+			write.setDstBinding(descriptor.binding);
+			write.setDstArrayElement(descriptor.arrayElement);
+			write.setDescriptorCount(1);
+			write.setDescriptorType(descriptor.type);
+			if (is_image_descriptor_type(descriptor.type))
+			{
+				write.setPImageInfo(&descriptor.imageInfo);
+				track_resource(get_resource_key(descriptor.imageInfo.imageView));
+			}
+			else
+			{
+				write.setPBufferInfo(&descriptor.bufferInfo);
+				track_resource(get_resource_key(descriptor.bufferInfo.buffer));
+			}
+			writes.push_back(write);
+		}
+
+		const vk::PipelineBindPoint bindPoint = m_boundPipeline->get_type() == PipelineType::eCompute ? vk::PipelineBindPoint::eCompute : vk::PipelineBindPoint::eGraphics;
+		m_commandBuffer->pushDescriptorSetKHR(bindPoint, m_boundPipeline->get_pipeline_layout(), set, writes);
+		GFX_COUNT_STAT(m_stats.descriptorBinds, 1);
+
+		// Whatever set was bound at this index is replaced.
+		auto& boundSets = m_boundState.descriptorSets[get_bind_point_index(*m_boundPipeline)];
+		if (set < boundSets.size())
+		{
+			boundSets[set] = vk::DescriptorSet{};
+		}
 	}
 
-	void dispatch(CommandListHandle commandListHandle, std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ)
+	void CommandList::set_descriptor_buffer_offsets(std::uint32_t firstSet, std::span<const vk::DeviceSize> offsets, const vk::DescriptorBufferBindingInfoEXT& descriptorBuffer)
 	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (m_boundPipeline == nullptr)
+		{
+			s_errorCallback("GFX - Cannot bind descriptor set when no pipeline has been bound!");
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			const DescriptorBufferOffsetsPacket packet{ firstSet, std::uint32_t(offsets.size()), descriptorBuffer.address, descriptorBuffer.usage };
+			write_packet(PacketType::eSetDescriptorBufferOffsets, packet, offsets.data(), offsets.size_bytes());
+			return;
+		}
 
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		// Offsets index into the bound buffers, which only change between recordings (or after executing secondaries).
+		if (m_boundState.descriptorBuffer != descriptorBuffer.address)
+		{
+			m_commandBuffer->bindDescriptorBuffersEXT(descriptorBuffer);
+			m_boundState.descriptorBuffer = descriptorBuffer.address;
+		}
+
+		InlineVector<std::uint32_t, MAX_BOUND_DESCRIPTOR_SETS> bufferIndices{};
+		bufferIndices.resize(offsets.size()); // All sets are in the one buffer.
+		const vk::PipelineBindPoint bindPoint = m_boundPipeline->get_type() == PipelineType::eCompute ? vk::PipelineBindPoint::eCompute : vk::PipelineBindPoint::eGraphics;
+		m_commandBuffer->setDescriptorBufferOffsetsEXT(bindPoint, m_boundPipeline->get_pipeline_layout(), firstSet, bufferIndices, offsets);
+		GFX_COUNT_STAT(m_stats.descriptorBinds, 1);
+	}
+
+	void CommandList::set_constants(vk::ShaderStageFlags shaderStages, std::uint32_t offset, std::uint32_t size, const void* data)
+	{
+		if (!m_hasBegun)
 		{
 			return;
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eSetConstants, ConstantsPacket{ shaderStages, offset, size }, data, size);
+			return;
+		}
 
-		CommandList* commandList{ nullptr };
-		if (!device->get_command_list(commandList, commandListHandle))
+		const auto pipelineLayout = m_boundPipeline->get_pipeline_layout();
+		m_commandBuffer->pushConstants(pipelineLayout, shaderStages, offset, size, data);
+	}
+
+	void CommandList::dispatch(std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ)
+	{
+		if (!m_hasBegun)
 		{
 			return;
 		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eDispatch, DispatchPacket{ groupCountX, groupCountY, groupCountZ });
+			return;
+		}
 
-		commandList->dispatch(groupCountX, groupCountY, groupCountZ);
+		flush_barriers();
+		m_commandBuffer->dispatch(groupCountX, groupCountY, groupCountZ);
+		GFX_COUNT_STAT(m_stats.dispatches, 1);
 	}
 
-	void bind_index_buffer(CommandListHandle commandListHandle, BufferHandle bufferHandle, IndexType indexType)
+	void CommandList::dispatch_base(std::uint32_t baseGroupX, std::uint32_t baseGroupY, std::uint32_t baseGroupZ, std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ)
 	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eDispatchBase, DispatchBasePacket{ baseGroupX, baseGroupY, baseGroupZ, groupCountX, groupCountY, groupCountZ });
+			return;
+		}
 
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		flush_barriers();
+		m_commandBuffer->dispatchBase(baseGroupX, baseGroupY, baseGroupZ, groupCountX, groupCountY, groupCountZ);
+		GFX_COUNT_STAT(m_stats.dispatches, 1);
+	}
+
+	void CommandList::set_device_mask(std::uint32_t deviceMask)
+	{
+		if (!m_hasBegun)
 		{
 			return;
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eSetDeviceMask, DeviceMaskPacket{ deviceMask });
+			return;
+		}
 
-		CommandList* commandList{ nullptr };
-		if (!device->get_command_list(commandList, commandListHandle))
+		// Barriers batched so far belong to the commands before, on the GPUs they ran on.
+		flush_barriers();
+		m_commandBuffer->setDeviceMask(deviceMask);
+	}
+
+	void CommandList::dispatch_indirect(Buffer* buffer, std::uint64_t offset)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
 		{
+			write_packet(PacketType::eDispatchIndirect, DispatchIndirectPacket{ buffer, offset });
 			return;
 		}
 
-		Buffer* buffer{ nullptr };
-		if (!device->get_buffer(buffer, bufferHandle))
+		// The arguments are typically written by the dispatch before, which nothing else orders before the indirect read.
+		vk::BufferMemoryBarrier2 barrier{};
+		barrier.setBuffer(buffer->get_buffer());
+		barrier.setOffset(offset);
+		barrier.setSize(sizeof(DispatchIndirectCommand));
+		barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eComputeShader);
+		barrier.setSrcAccessMask(vk::AccessFlagBits2::eShaderStorageWrite);
+		barrier.setDstStageMask(vk::PipelineStageFlagBits2::eDrawIndirect);
+		barrier.setDstAccessMask(vk::AccessFlagBits2::eIndirectCommandRead);
+		add_barrier(barrier);
+
+		flush_barriers();
+		m_commandBuffer->dispatchIndirect(buffer->get_buffer(), offset);
+		GFX_COUNT_STAT(m_stats.dispatches, 1);
+		track_resource(get_resource_key(buffer->get_buffer()));
+	}
+
+	void CommandList::bind_index_buffer(Buffer* buffer, vk::IndexType indexType, vk::DeviceSize offset)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
 		{
+			write_packet(PacketType::eBindIndexBuffer, BindIndexBufferPacket{ buffer, indexType, offset });
 			return;
 		}
 
-		auto vk_index_type = indexType == IndexType::eUInt16 ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
-		commandList->bind_index_buffer(buffer, vk_index_type);
+		if (m_boundState.indexBuffer == buffer->get_buffer() && m_boundState.indexBufferOffset == offset && m_boundState.indexType == indexType)
+		{
+			return;
+		}
+
+		m_commandBuffer->bindIndexBuffer(buffer->get_buffer(), offset, indexType);
+		track_resource(get_resource_key(buffer->get_buffer()));
+		m_boundState.indexBuffer = buffer->get_buffer();
+		m_boundState.indexBufferOffset = offset;
+		m_boundState.indexType = indexType;
 	}
 
-	void bind_vertex_buffers(CommandListHandle commandListHandle, std::uint32_t firstBinding, const std::vector<BufferHandle>& buffers)
+	void CommandList::bind_vertex_buffer(std::uint32_t firstBinding, std::span<const vk::Buffer> buffers, std::span<const vk::DeviceSize> offsets)
 	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+		if (!m_hasBegun)
+		{
+			return;
+		}
 
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		static constexpr std::array<vk::DeviceSize, MAX_VERTEX_BUFFER_BINDINGS> zeroOffsets{};
+		GFX_ASSERT(buffers.size() <= zeroOffsets.size(), "Cannot bind more than MAX_VERTEX_BUFFER_BINDINGS vertex buffers at once!");
+		if (offsets.empty())
+		{
+			offsets = std::span(zeroOffsets.data(), buffers.size());
+		}
+
+		if (is_recording_deferred())
 		{
+			std::array<std::byte, MAX_VERTEX_BUFFER_BINDINGS * (sizeof(vk::Buffer) + sizeof(vk::DeviceSize))> extraData{};
+			std::memcpy(extraData.data(), buffers.data(), buffers.size_bytes());
+			std::memcpy(extraData.data() + buffers.size_bytes(), offsets.data(), offsets.size_bytes());
+			write_packet(PacketType::eBindVertexBuffers, CountPacket{ firstBinding, std::uint32_t(buffers.size()) }, extraData.data(), buffers.size_bytes() + offsets.size_bytes());
 			return;
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		CommandList* commandList{ nullptr };
-		if (!device->get_command_list(commandList, commandListHandle))
+		auto& boundBuffers = m_boundState.vertexBuffers;
+		auto& boundOffsets = m_boundState.vertexBufferOffsets;
+		const bool isTracked = firstBinding + buffers.size() <= boundBuffers.size();
+		if (isTracked && std::equal(buffers.begin(), buffers.end(), boundBuffers.begin() + firstBinding) && std::equal(offsets.begin(), offsets.end(), boundOffsets.begin() + firstBinding))
 		{
 			return;
 		}
 
-		std::vector<vk::Buffer> vkBuffers(buffers.size());
-		for (auto i = 0; i < buffers.size(); ++i)
+		m_commandBuffer->bindVertexBuffers(firstBinding, buffers, offsets);
+		for (const auto buffer : buffers)
 		{
-			Buffer* buffer{ nullptr };
-			if (!device->get_buffer(buffer, buffers[i]))
-			{
-				return;
-			}
-			vkBuffers[i] = buffer->get_buffer();
+			track_resource(get_resource_key(buffer));
 		}
 
-		commandList->bind_vertex_buffer(firstBinding, vkBuffers);
+		if (isTracked)
+		{
+			std::copy(buffers.begin(), buffers.end(), boundBuffers.begin() + firstBinding);
+			std::copy(offsets.begin(), offsets.end(), boundOffsets.begin() + firstBinding);
+		}
 	}
 
-	void draw(CommandListHandle commandListHandle, std::uint32_t vertex_count, std::uint32_t instance_count, std::uint32_t first_vertex, std::uint32_t first_instance)
+	void CommandList::draw(std::uint32_t vertex_count, std::uint32_t instance_count, std::uint32_t first_vertex, std::uint32_t first_instance)
 	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eDraw, DrawPacket{ vertex_count, instance_count, first_vertex, first_instance });
+			return;
+		}
 
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		flush_barriers();
+		m_commandBuffer->draw(vertex_count, instance_count, first_vertex, first_instance);
+		GFX_COUNT_STAT(m_stats.draws, 1);
+	}
+
+	void CommandList::draw_indexed(std::uint32_t index_count, std::uint32_t instance_count, std::uint32_t first_index, std::int32_t vertex_offset, std::uint32_t first_instance)
+	{
+		if (!m_hasBegun)
 		{
 			return;
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eDrawIndexed, DrawIndexedPacket{ index_count, instance_count, first_index, vertex_offset, first_instance });
+			return;
+		}
 
-		CommandList* commandList{ nullptr };
-		if (!device->get_command_list(commandList, commandListHandle))
+		flush_barriers();
+		m_commandBuffer->drawIndexed(index_count, instance_count, first_index, vertex_offset, first_instance);
+		GFX_COUNT_STAT(m_stats.draws, 1);
+	}
+
+	void CommandList::draw_indirect(Buffer* buffer, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eDrawIndirect, DrawIndirectPacket{ buffer, offset, drawCount, stride });
+			return;
+		}
+
+		flush_barriers();
+		m_commandBuffer->drawIndirect(buffer->get_buffer(), offset, drawCount, stride);
+		GFX_COUNT_STAT(m_stats.draws, 1);
+		track_resource(get_resource_key(buffer->get_buffer()));
+	}
+
+	void CommandList::draw_indexed_indirect(Buffer* buffer, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eDrawIndexedIndirect, DrawIndirectPacket{ buffer, offset, drawCount, stride });
+			return;
+		}
+
+		flush_barriers();
+		m_commandBuffer->drawIndexedIndirect(buffer->get_buffer(), offset, drawCount, stride);
+		GFX_COUNT_STAT(m_stats.draws, 1);
+		track_resource(get_resource_key(buffer->get_buffer()));
+	}
+
+	void CommandList::draw_indexed_indirect_count(Buffer* buffer, std::uint64_t offset, Buffer* countBuffer, std::uint64_t countOffset, std::uint32_t maxDrawCount, std::uint32_t stride)
+	{
+		if (!m_hasBegun)
 		{
 			return;
 		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eDrawIndexedIndirectCount, DrawIndirectCountPacket{ buffer, offset, countBuffer, countOffset, maxDrawCount, stride });
+			return;
+		}
 
-		commandList->draw(vertex_count, instance_count, first_vertex, first_instance);
+		flush_barriers();
+		m_commandBuffer->drawIndexedIndirectCount(buffer->get_buffer(), offset, countBuffer->get_buffer(), countOffset, maxDrawCount, stride);
+		GFX_COUNT_STAT(m_stats.draws, 1);
+		track_resource(get_resource_key(buffer->get_buffer()));
+		track_resource(get_resource_key(countBuffer->get_buffer()));
 	}
 
-	void draw_indexed(CommandListHandle commandListHandle, std::uint32_t index_count, std::uint32_t instance_count, std::uint32_t first_index, std::int32_t vertex_offset, std::uint32_t first_instance)
+	void CommandList::draw_mesh_tasks(std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ)
 	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
-
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		if (!m_hasBegun)
 		{
 			return;
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
-
-		CommandList* commandList{ nullptr };
-		if (!device->get_command_list(commandList, commandListHandle))
+		if (is_recording_deferred())
 		{
+			write_packet(PacketType::eDrawMeshTasks, DispatchPacket{ groupCountX, groupCountY, groupCountZ });
 			return;
 		}
 
-		commandList->draw_indexed(index_count, instance_count, first_index, vertex_offset, first_instance);
+		flush_barriers();
+		m_commandBuffer->drawMeshTasksEXT(groupCountX, groupCountY, groupCountZ);
+		GFX_COUNT_STAT(m_stats.draws, 1);
 	}
 
-	void transition_texture(CommandListHandle commandListHandle, TextureHandle textureHandle, TextureState oldState, TextureState newState)
+	void CommandList::draw_mesh_tasks_indirect(Buffer* buffer, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride)
 	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
-
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		if (!m_hasBegun)
 		{
 			return;
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
-
-		Texture* texture{ nullptr };
-		if (!device->get_texture(texture, textureHandle))
+		if (is_recording_deferred())
 		{
+			write_packet(PacketType::eDrawMeshTasksIndirect, DrawIndirectPacket{ buffer, offset, drawCount, stride });
 			return;
 		}
 
-		CommandList* commandList{ nullptr };
-		if (!device->get_command_list(commandList, commandListHandle))
+		flush_barriers();
+		m_commandBuffer->drawMeshTasksIndirectEXT(buffer->get_buffer(), offset, drawCount, stride);
+		GFX_COUNT_STAT(m_stats.draws, 1);
+		track_resource(get_resource_key(buffer->get_buffer()));
+	}
+
+	void CommandList::draw_mesh_tasks_indirect_count(Buffer* buffer, std::uint64_t offset, Buffer* countBuffer, std::uint64_t countOffset, std::uint32_t maxDrawCount, std::uint32_t stride)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
 		{
+			write_packet(PacketType::eDrawMeshTasksIndirectCount, DrawIndirectCountPacket{ buffer, offset, countBuffer, countOffset, maxDrawCount, stride });
 			return;
 		}
 
-		commandList->transition_texture(texture, oldState, newState);
+		flush_barriers();
+		m_commandBuffer->drawMeshTasksIndirectCountEXT(buffer->get_buffer(), offset, countBuffer->get_buffer(), countOffset, maxDrawCount, stride);
+		GFX_COUNT_STAT(m_stats.draws, 1);
+		track_resource(get_resource_key(buffer->get_buffer()));
+		track_resource(get_resource_key(countBuffer->get_buffer()));
 	}
 
-	void copy_buffer_to_texture(CommandListHandle commandListHandle, BufferHandle bufferHandle, TextureHandle textureHandle)
+	auto CommandList::get_texture_barrier(Texture* texture, TextureState oldState, TextureState newState, std::uint32_t baseMipLevel, std::uint32_t mipLevelCount, std::uint32_t baseArrayLayer, std::uint32_t arrayLayerCount) -> vk::ImageMemoryBarrier2
 	{
-		GFX_ASSERT(s_context && s_context->is_valid(), "GFX has not been initialised!");
+		GFX_ASSERT(s_textureStateImageLayoutMap.contains(oldState) && s_textureStateImageLayoutMap.contains(newState), "Unable to convert TextureState to vk::ImageLayout for barrier!");
+		GFX_ASSERT(s_barrierTextureStateSrcStageMaskMap.contains(oldState) && s_barrierTextureStateDstStageMaskMap.contains(newState), "Unable to convert TextureState to vk::PipelineStage for barrier!");
+		GFX_ASSERT(s_barrierTextureStateSrcAccessMaskMap.contains(oldState) && s_barrierTextureStateDstAccessMaskMap.contains(newState), "Unable to convert TextureState to vk::Access for barrier!");
 
-		Device* device{ nullptr };
-		if (!s_context->get_device(device, commandListHandle.deviceHandle))
+		if (newState == TextureState::eShaderRead && !(texture->get_usage_flags() & vk::ImageUsageFlagBits::eSampled))
 		{
-			return;
+			s_errorCallback("GFX - Texture cannot be transitioned to eShaderRead, it is not sampled (transient attachments never are)!");
 		}
-		GFX_ASSERT(device != nullptr, "Device should not be null!");
 
-		Buffer* buffer{ nullptr };
-		if (!device->get_buffer(buffer, bufferHandle))
+		vk::ImageSubresourceRange range{};
+		range.setAspectMask(texture->get_aspect_mask());
+		range.setBaseArrayLayer(baseArrayLayer);
+		range.setLayerCount(arrayLayerCount);
+		range.setBaseMipLevel(baseMipLevel);
+		range.setLevelCount(mipLevelCount);
+
+		vk::ImageMemoryBarrier2 barrier{};
+		barrier.setImage(texture->get_image());
+		barrier.setOldLayout(s_textureStateImageLayoutMap.at(oldState));
+		barrier.setNewLayout(s_textureStateImageLayoutMap.at(newState));
+		barrier.setSrcStageMask(s_barrierTextureStateSrcStageMaskMap.at(oldState));
+		barrier.setDstStageMask(s_barrierTextureStateDstStageMaskMap.at(newState));
+		barrier.setSrcAccessMask(s_barrierTextureStateSrcAccessMaskMap.at(oldState));
+		barrier.setDstAccessMask(s_barrierTextureStateDstAccessMaskMap.at(newState));
+		barrier.setSubresourceRange(range);
+
+		// A swap chain image is only available once its acquire semaphore is waited on at colour output, so the layout
+		// transition out of eUndefined must wait on that stage too rather than run ahead of the semaphore wait.
+		if (oldState == TextureState::eUndefined && texture->is_swap_chain_image())
 		{
-			return;
+			barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eColorAttachmentOutput);
 		}
 
-		Texture* texture{ nullptr };
-		if (!device->get_texture(texture, textureHandle))
+		// Depth attachments are written by the fragment tests, not colour output.
+		if (texture->get_aspect_mask() & vk::ImageAspectFlagBits::eDepth)
 		{
-			return;
+			constexpr auto DEPTH_STAGES = vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests;
+			if (oldState == TextureState::eRenderTarget)
+			{
+				barrier.setSrcStageMask(DEPTH_STAGES);
+				barrier.setSrcAccessMask(vk::AccessFlagBits2::eDepthStencilAttachmentWrite);
+			}
+			if (newState == TextureState::eRenderTarget)
+			{
+				barrier.setDstStageMask(DEPTH_STAGES);
+				barrier.setDstAccessMask(vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite);
+			}
 		}
+		return barrier;
+	}
 
-		CommandList* commandList{ nullptr };
-		if (!device->get_command_list(commandList, commandListHandle))
+	void CommandList::transition_texture(Texture* texture, TextureState oldState, TextureState newState)
+	{
+		if (!m_hasBegun)
 		{
 			return;
 		}
 
-		commandList->copy_buffer_to_texture(buffer, texture);
+		// The caller is explicit about the source state (eg. eUndefined to discard contents), so always emit the barrier.
+		const auto barrier = get_texture_barrier(texture, oldState, newState, 0, texture->get_mip_levels(), 0, texture->get_array_layers());
+		texture->set_state(newState, 0, texture->get_mip_levels(), 0, texture->get_array_layers());
+		add_texture_barriers(texture, { &barrier, 1 });
 	}
 
-#pragma endregion
-
-#pragma endregion
-
-#pragma region Private Header
-
-	Context::Context(const AppInfo& appInfo)
+	void CommandList::transition_texture(Texture* texture, TextureState newState, std::uint32_t baseMipLevel, std::uint32_t mipLevelCount, std::uint32_t baseArrayLayer, std::uint32_t arrayLayerCount)
 	{
-		auto vkGetInstanceProcAddr = m_loader.getProcAddress<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr");
-		VULKAN_HPP_DEFAULT_DISPATCHER.init(vkGetInstanceProcAddr);
-
-		vk::ApplicationInfo vk_app_info{};
-		vk_app_info.setApiVersion(VK_API_VERSION_1_3);
-		vk_app_info.setPApplicationName(appInfo.appName.c_str());
-		vk_app_info.setPEngineName(appInfo.engineName.c_str());
+		if (!m_hasBegun)
+		{
+			return;
+		}
 
-		std::vector<const char*> extensions = {
-			VK_EXT_DEBUG_UTILS_EXTENSION_NAME,
-			VK_KHR_SURFACE_EXTENSION_NAME,
-#if _WIN32
-			VK_KHR_WIN32_SURFACE_EXTENSION_NAME,
-#elif __linux__
-			VK_KHR_WAYLAND_SURFACE_EXTENSION_NAME
-#endif
-		};
-		std::vector<const char*> layers = {
-			"VK_LAYER_KHRONOS_validation",
-		};
+		mipLevelCount = std::min(mipLevelCount, texture->get_mip_levels() - baseMipLevel);
+		arrayLayerCount = std::min(arrayLayerCount, texture->get_array_layers() - baseArrayLayer);
 
-		vk::DebugUtilsMessengerCreateInfoEXT vk_debug_messenger_info{};
-		vk_debug_messenger_info.setMessageSeverity(vk::DebugUtilsMessageSeverityFlagBitsEXT::eError | vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning);
-		vk_debug_messenger_info.setMessageType(vk::DebugUtilsMessageTypeFlagBitsEXT::eValidation);
-		vk_debug_messenger_info.setPfnUserCallback(debug_utils_messenger_callback);
+		m_trackedBarriers.clear();
+		get_tracked_texture_barriers(texture, newState, baseMipLevel, mipLevelCount, baseArrayLayer, arrayLayerCount, m_trackedBarriers);
+		texture->set_state(newState, baseMipLevel, mipLevelCount, baseArrayLayer, arrayLayerCount);
+		add_texture_barriers(texture, m_trackedBarriers);
+	}
 
-		vk::InstanceCreateInfo vk_inst_info{};
-		vk_inst_info.setPApplicationInfo(&vk_app_info);
-		vk_inst_info.setPEnabledExtensionNames(extensions);
-		vk_inst_info.setPEnabledLayerNames(layers);
-		vk_inst_info.setPNext(&vk_debug_messenger_info);
-		m_instance = vk::createInstanceUnique(vk_inst_info).value;
-		if (!*m_instance)
+	void CommandList::add_texture_barriers(Texture* texture, std::span<const vk::ImageMemoryBarrier2> barriers)
+	{
+		if (is_recording_deferred())
 		{
-			s_errorCallback("Failed to create Vulkan instance!");
+			// Resolved now, in recording order. Translations run on workers in any order, and would race on the tracked states.
+			if (!barriers.empty())
+			{
+				write_packet(PacketType::eTextureBarriers, TextureBarriersPacket{ texture, std::uint32_t(barriers.size()) }, barriers.data(), barriers.size_bytes());
+			}
 			return;
 		}
-
-		VULKAN_HPP_DEFAULT_DISPATCHER.init(*m_instance);
-
-		m_debugMessenger = m_instance->createDebugUtilsMessengerEXTUnique(vk_debug_messenger_info).value;
-		if (!*m_debugMessenger)
+		for (const auto& barrier : barriers)
 		{
-			s_errorCallback("Failed to create Vulkan debug messenger!");
+			add_barrier(barrier);
 		}
 	}
 
-	bool Context::is_valid() const
+	void CommandList::get_tracked_texture_barriers(Texture* texture, TextureState newState, std::uint32_t baseMipLevel, std::uint32_t mipLevelCount, std::uint32_t baseArrayLayer, std::uint32_t arrayLayerCount,
+												   std::vector<vk::ImageMemoryBarrier2>& outBarriers)
 	{
-		return *m_instance;
+		for (auto layer = baseArrayLayer; layer < baseArrayLayer + arrayLayerCount; ++layer)
+		{
+			auto mip = baseMipLevel;
+			while (mip < baseMipLevel + mipLevelCount)
+			{
+				const auto oldState = texture->get_state(mip, layer);
+				auto runEnd = mip + 1;
+				while (runEnd < baseMipLevel + mipLevelCount && texture->get_state(runEnd, layer) == oldState)
+				{
+					++runEnd;
+				}
+
+				if (oldState != newState || !is_texture_state_read_only(newState))
+				{
+					outBarriers.push_back(get_texture_barrier(texture, oldState, newState, mip, runEnd - mip, layer, 1));
+				}
+				mip = runEnd;
+			}
+		}
 	}
 
-	auto Context::create_device(DeviceHandle& outDeviceHandle, const DeviceInfo& deviceInfo) -> bool
+	void CommandList::acquire_aliased_texture(Texture* texture, TextureState newState)
 	{
-		auto deviceHandle = DeviceHandle(m_nextDeviceId);
-
-		auto device = std::make_unique<Device>(*this, deviceHandle, deviceInfo);
-		if (!device->is_valid())
+		if (!m_hasBegun)
 		{
-			return false;
+			return;
 		}
 
-		m_nextDeviceId++;
-		m_deviceMap[deviceHandle] = std::move(device);
-
-		outDeviceHandle = deviceHandle;
-		return true;
+		// The previous occupant of the memory may have been any texture in any state, so wait on all prior writes.
+		auto barrier = get_texture_barrier(texture, TextureState::eUndefined, newState, 0, texture->get_mip_levels(), 0, texture->get_array_layers());
+		barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+		barrier.setSrcAccessMask(vk::AccessFlagBits2::eMemoryWrite);
+		texture->set_state(newState, 0, texture->get_mip_levels(), 0, texture->get_array_layers());
+		add_texture_barriers(texture, { &barrier, 1 });
 	}
 
-	void Context::destroy_device(DeviceHandle deviceHandle)
+	void CommandList::begin_texture_transition(Texture* texture, TextureState newState)
 	{
-		if (!m_deviceMap.contains(deviceHandle))
+		if (!m_hasBegun)
+		{
 			return;
+		}
 
-		m_deviceMap.erase(deviceHandle);
+		std::vector<vk::ImageMemoryBarrier2> barriers;
+		get_tracked_texture_barriers(texture, newState, 0, texture->get_mip_levels(), 0, texture->get_array_layers(), barriers);
+		texture->set_state(newState, 0, texture->get_mip_levels(), 0, texture->get_array_layers());
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eBeginTextureTransition, TextureBarriersPacket{ texture, std::uint32_t(barriers.size()) }, barriers.data(), barriers.size() * sizeof(vk::ImageMemoryBarrier2));
+			return;
+		}
+		record_texture_transition_begin(texture, std::move(barriers));
 	}
 
-	bool Context::get_device(Device*& outDevice, DeviceHandle deviceHandle)
+	void CommandList::record_texture_transition_begin(Texture* texture, std::vector<vk::ImageMemoryBarrier2>&& barriers)
 	{
-		if (!m_deviceMap.contains(deviceHandle))
+		SplitTransition splitTransition{ texture, {}, std::move(barriers) };
+		for (auto& barrier : splitTransition.barriers)
 		{
-			outDevice = nullptr;
-			return false;
+			restrict_barrier_stages(barrier, m_commandPool->get_supported_stages());
 		}
+		if (!splitTransition.barriers.empty())
+		{
+			// Queued barriers may still be writing the texture, so they go before the signal.
+			flush_barriers();
 
-		outDevice = m_deviceMap.at(deviceHandle).get();
-		return true;
+			splitTransition.event = acquire_event();
+			vk::DependencyInfo dependency_info{};
+			dependency_info.setImageMemoryBarriers(splitTransition.barriers);
+			m_commandBuffer->setEvent2(splitTransition.event, dependency_info);
+		}
+		m_splitTransitions.push_back(std::move(splitTransition));
 	}
 
-	Device::Device(Context& context, DeviceHandle deviceHandle, const DeviceInfo& deviceInfo)
-		: m_context(&context), m_deviceHandle(deviceHandle)
+	void CommandList::end_texture_transition(Texture* texture)
 	{
-		auto physicalDevices = m_context->get_instance().enumeratePhysicalDevices().value;
-		if (physicalDevices.empty())
+		if (!m_hasBegun)
 		{
-			s_errorCallback("GFX - There are no devices!");
 			return;
 		}
-
-		std::uint32_t bestScore = 0;
-		std::uint32_t bestDevice = 0;
-		for (auto i = 0; i < physicalDevices.size(); ++i)
+		if (is_recording_deferred())
 		{
-			const auto& physicalDevice = physicalDevices[i];
-			const auto& deviceProperties = physicalDevice.getProperties();
-
-			std::uint32_t score = 0;
-
-			if (deviceInfo.deviceFlags & DeviceFlags_PreferIntegrated && deviceProperties.deviceType == vk::PhysicalDeviceType::eIntegratedGpu)
-			{
-				score += 1000;
-			}
-			if (deviceInfo.deviceFlags & DeviceFlags_PreferDiscrete && deviceProperties.deviceType == vk::PhysicalDeviceType::eDiscreteGpu)
-			{
-				score += 1000;
-			}
-
-			score += deviceProperties.limits.maxImageDimension2D;
-			score += deviceProperties.limits.maxDescriptorSetSampledImages;
-			score += deviceProperties.limits.maxDescriptorSetUniformBuffers;
-			score += deviceProperties.limits.maxBoundDescriptorSets;
-
-			if (score > bestScore)
-			{
-				bestScore = score;
-				bestDevice = i;
-			}
+			write_packet(PacketType::eEndTextureTransition, TextureBarriersPacket{ texture, 0 });
+			return;
 		}
 
-		m_physicalDevice = physicalDevices[bestDevice];
-
-		std::vector<const char*> extensions = {
-			VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-			VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
-		};
-
-		auto queueProperties = m_physicalDevice.getQueueFamilyProperties();
-
-		m_queueFlags = deviceInfo.queueFlags;
-		m_queueFamilies.resize(m_queueFlags.size());
-		m_queues.resize(m_queueFlags.size());
+		auto it = std::ranges::find(m_splitTransitions, texture, &SplitTransition::texture);
+		if (it == m_splitTransitions.end())
+		{
+			s_errorCallback("GFX - end_texture_transition() - The texture has no transition begun on this CommandList!");
+			return;
+		}
 
-		std::unordered_map<std::uint32_t, std::uint32_t> usedQueueFamilyCounts;
-		for (auto i = 0; i < deviceInfo.queueFlags.size(); ++i)
+		if (it->event)
 		{
-			const auto queueFlags = deviceInfo.queueFlags[i];
+			flush_barriers();
 
-			vk::QueueFlags wantedFlags;
-			if (queueFlags & QueueFlags_Graphics)
-			{
-				wantedFlags |= vk::QueueFlagBits::eGraphics;
-			}
-			if (queueFlags & QueueFlags_Compute)
-			{
-				wantedFlags |= vk::QueueFlagBits::eCompute;
-			}
-			if (queueFlags & QueueFlags_Transfer)
-			{
-				wantedFlags |= vk::QueueFlagBits::eTransfer;
-			}
+			// The wait must repeat the barriers of the signal exactly.
+			vk::DependencyInfo dependency_info{};
+			dependency_info.setImageMemoryBarriers(it->barriers);
+			m_commandBuffer->waitEvents2(it->event, dependency_info);
+			GFX_COUNT_STAT(m_stats.barriers, it->barriers.size());
 
-			for (auto familyIndex = 0; familyIndex < queueProperties.size(); ++familyIndex)
+			// Left empty when every waiting stage was dropped for this queue, then the reset only has to follow the wait.
+			vk::PipelineStageFlags2 dstStages{};
+			for (const auto& barrier : it->barriers)
 			{
-				auto& queueProps = queueProperties[familyIndex];
-				if (queueProps.queueFlags & wantedFlags)
-				{
-					usedQueueFamilyCounts[familyIndex] += 1;
-					m_queueFamilies[i] = familyIndex;
-					break;
-				}
+				dstStages |= barrier.dstStageMask;
 			}
+			m_commandBuffer->resetEvent2(it->event, dstStages ? dstStages : vk::PipelineStageFlagBits2::eAllCommands);
 		}
+		m_splitTransitions.erase(it);
+	}
 
-		const float QUEUE_PRIORITY = 1.0f;
-		std::vector<vk::DeviceQueueCreateInfo> queue_info_vec;
-		for (auto [family, count] : usedQueueFamilyCounts)
+	void CommandList::write_timestamp(vk::QueryPool queryPool, std::uint32_t query, vk::PipelineStageFlags2 stage)
+	{
+		if (!m_hasBegun)
 		{
-			auto& queue_info = queue_info_vec.emplace_back();
-			queue_info.setQueueFamilyIndex(family);
-			queue_info.setQueueCount(count);
-			queue_info.setPQueuePriorities(&QUEUE_PRIORITY);
+			return;
 		}
-
-		vk::PhysicalDeviceFeatures features{};
-		vk::PhysicalDeviceSynchronization2Features sync_2_features{ true };
-		vk::PhysicalDeviceDynamicRenderingFeatures dynamic_rendering_features{ true, &sync_2_features };
-
-		vk::DeviceCreateInfo vk_device_info{};
-		vk_device_info.setPEnabledExtensionNames(extensions);
-		vk_device_info.setQueueCreateInfos(queue_info_vec);
-		vk_device_info.setPEnabledFeatures(&features);
-		vk_device_info.setPNext(&dynamic_rendering_features);
-		m_device = m_physicalDevice.createDeviceUnique(vk_device_info).value;
-		if (!*m_device)
+		if (is_recording_deferred())
 		{
-			s_errorCallback("GFX - Failed to create device!");
+			write_packet(PacketType::eWriteTimestamp, WriteTimestampPacket{ queryPool, query, stage });
 			return;
 		}
 
-		VULKAN_HPP_DEFAULT_DISPATCHER.init(*m_device);
+		// Barriers queued so far belong to the commands before the timestamp.
+		flush_barriers();
+		m_commandBuffer->writeTimestamp2(stage, queryPool, query);
+	}
 
-		std::unordered_map<std::uint32_t, std::uint32_t> queueIndexMap;
-		for (auto i = 0; i < m_queueFamilies.size(); ++i)
+	void CommandList::begin_query(vk::QueryPool queryPool, std::uint32_t query, vk::QueryControlFlags flags)
+	{
+		if (!m_hasBegun)
 		{
-			auto queueFamily = m_queueFamilies[i];
-
-			vk::CommandPoolCreateInfo cmd_pool_info{};
-			cmd_pool_info.setQueueFamilyIndex(queueFamily);
-			cmd_pool_info.setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer);
-			m_queueFamilyCommandPoolMap[queueFamily] = m_device->createCommandPoolUnique(cmd_pool_info).value;
-
-			auto queueIndex = queueIndexMap[queueFamily];
-			m_queues[i] = m_device->getQueue(queueFamily, queueIndex);
-			queueIndexMap[queueFamily] += 1;
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eBeginQuery, QueryPacket{ queryPool, query, flags });
+			return;
 		}
 
-		vma::AllocatorCreateInfo allocator_info{};
-		allocator_info.setInstance(m_context->get_instance());
-		allocator_info.setPhysicalDevice(m_physicalDevice);
-		allocator_info.setDevice(m_device.get());
-		allocator_info.setVulkanApiVersion(VK_API_VERSION_1_3);
-		m_allocator = vma::createAllocatorUnique(allocator_info).value;
-
-		const std::vector<vk::DescriptorPoolSize> descriptor_pool_sizes{
-			{ vk::DescriptorType::eStorageBuffer, 100 },
-			{ vk::DescriptorType::eUniformBuffer, 100 },
-			{ vk::DescriptorType::eCombinedImageSampler, 100 },
-		};
-		vk::DescriptorPoolCreateInfo descriptor_pool_info{};
-		descriptor_pool_info.setMaxSets(100);
-		descriptor_pool_info.setPoolSizes(descriptor_pool_sizes);
-		descriptor_pool_info.setFlags(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet);
-		m_descriptorPool = m_device->createDescriptorPoolUnique(descriptor_pool_info).value;
-	}
-
-	bool Device::is_valid() const
-	{
-		return static_cast<bool>(*m_device);
+		flush_barriers();
+		m_commandBuffer->beginQuery(queryPool, query, flags);
 	}
 
-	bool Device::get_queue(vk::Queue& outQueue, std::uint32_t queueIndex)
+	void CommandList::end_query(vk::QueryPool queryPool, std::uint32_t query)
 	{
-		if (queueIndex > m_queues.size())
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
 		{
-			return false;
+			write_packet(PacketType::eEndQuery, QueryPacket{ queryPool, query, {} });
+			return;
 		}
 
-		outQueue = m_queues.at(queueIndex);
-		return outQueue;
+		flush_barriers();
+		m_commandBuffer->endQuery(queryPool, query);
 	}
 
-	bool Device::is_present_mode_supported(vk::PresentModeKHR presentMode, vk::SurfaceKHR surface) const
+	void CommandList::push_marker(std::string_view name)
 	{
-		auto supportedPresentModes = m_physicalDevice.getSurfacePresentModesKHR(surface).value;
-		return std::ranges::find(supportedPresentModes, presentMode) != supportedPresentModes.end();
+		// Without VK_EXT_debug_utils markers are dropped entirely, deferred lists do not even record them.
+		if (!m_hasBegun || !is_debug_utils_enabled())
+		{
+			return;
+		}
+
+		++m_markerDepth;
+		begin_debug_label(name);
 	}
 
-	auto Device::get_first_supported_surface_format(const std::vector<vk::Format>& formats, vk::SurfaceKHR surface) -> vk::Format
+	void CommandList::pop_marker()
 	{
-		const auto supportedSurfaceFormats = m_physicalDevice.getSurfaceFormatsKHR(surface).value;
-		for (const auto& format : formats)
+		if (!is_debug_utils_enabled())
 		{
-			for (const auto& surfaceFormat : supportedSurfaceFormats)
-			{
-				if (surfaceFormat.format == format)
-					return format;
-			}
+			return;
+		}
+		if (m_markerDepth == 0)
+		{
+			s_errorCallback("GFX - pop_marker() - No marker is pushed on the CommandList!");
+			return;
 		}
 
-		return vk::Format::eUndefined;
+		--m_markerDepth;
+		end_debug_label();
 	}
 
-	void Device::wait_on_fence(FenceHandle fenceHandle)
+	void CommandList::begin_debug_label(std::string_view name)
 	{
-		vk::Fence fence = m_fenceMap.at(fenceHandle.resourceHandle).get();
-		auto result = m_device->waitForFences(fence, VK_TRUE, std::numeric_limits<std::uint64_t>::max());
-		GFX_UNUSED(result);
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eBeginDebugLabel, CountPacket{ 0, std::uint32_t(name.size()) }, name.data(), name.size());
+			return;
+		}
 
-		m_fenceMap.erase(fenceHandle.resourceHandle);
+		// Labels take null-terminated names, long ones are truncated rather than allocating.
+		std::array<char, 256> labelName{};
+		name.copy(labelName.data(), labelName.size() - 1);
+		vk::DebugUtilsLabelEXT label{};
+		label.setPLabelName(labelName.data());
+		m_commandBuffer->beginDebugUtilsLabelEXT(label);
 	}
 
-	void Device::destroy_semaphore(SemaphoreHandle semaphoreHandle)
+	void CommandList::end_debug_label()
 	{
-		m_semaphoreMap.erase(semaphoreHandle.resourceHandle);
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eEndDebugLabel, EmptyPacket{});
+			return;
+		}
+
+		m_commandBuffer->endDebugUtilsLabelEXT();
 	}
 
-	auto Device::create_command_list(CommandListHandle& outCommandListHandle, std::uint32_t queueIndex) -> bool
+	bool CommandList::pop_gpu_scope(GpuScopeQuery& outScope)
 	{
-		auto queueFamily = m_queueFamilies.at(queueIndex);
-		auto commandPool = m_queueFamilyCommandPoolMap.at(queueFamily).get();
-		auto queue = m_queues.at(queueIndex);
-
-		CommandListHandle commandListHandle(m_deviceHandle, ResourceHandle(m_nextCommandListId));
-
-		m_commandListMap[commandListHandle.resourceHandle] = std::make_unique<CommandList>(m_device.get(), commandPool, queue);
-		m_nextCommandListId += 1;
-
-		outCommandListHandle = commandListHandle;
+		if (m_gpuScopes.empty())
+		{
+			return false;
+		}
+		outScope = m_gpuScopes.back();
+		m_gpuScopes.pop_back();
 		return true;
 	}
 
-	bool Device::get_command_list(CommandList*& outCommandList, CommandListHandle commandListHandle)
+	auto CommandList::acquire_event() -> vk::Event
 	{
-		if (!m_commandListMap.contains(commandListHandle.resourceHandle))
+		if (m_usedEventCount == m_events.size())
 		{
-			return false;
+			vk::EventCreateInfo event_info{};
+			event_info.setFlags(vk::EventCreateFlagBits::eDeviceOnly);
+			m_events.push_back(m_commandPool->get_device().createEventUnique(event_info).value);
 		}
-
-		outCommandList = m_commandListMap.at(commandListHandle.resourceHandle).get();
-		return true;
+		return m_events[m_usedEventCount++].get();
 	}
 
-	bool Device::create_or_get_descriptor_set_layout(vk::DescriptorSetLayout& outDescriptorSetLayout, const DescriptorSetInfo& descriptorSetInfo)
+	void CommandList::transfer_texture_ownership(Texture* texture, const QueueOwnershipTransfer& transfer, TextureState oldState, TextureState newState)
 	{
-		const auto hash = std::hash<DescriptorSetInfo>{}(descriptorSetInfo);
-		if (!m_descriptorSetLayoutMap.contains(hash))
+		if (!m_hasBegun)
+		{
+			return;
+		}
+
+		if (transfer.srcQueueFamily == transfer.dstQueueFamily)
 		{
-			std::vector<vk::DescriptorSetLayoutBinding> vk_bindings(descriptorSetInfo.bindings.size());
-			for (auto i = 0; i < vk_bindings.size(); ++i)
+			if (transfer.release)
 			{
-				vk_bindings[i] = get_descriptor_set_layout_binding(descriptorSetInfo.bindings.at(i));
-				vk_bindings[i].setBinding(i);
+				transition_texture(texture, oldState, newState);
 			}
+			return;
+		}
+
+		// Both halves carry the same families and layouts. The release only makes the writes available, the acquire only waits.
+		auto barrier = get_texture_barrier(texture, oldState, newState, 0, texture->get_mip_levels(), 0, texture->get_array_layers());
+		barrier.setSrcQueueFamilyIndex(transfer.srcQueueFamily);
+		barrier.setDstQueueFamilyIndex(transfer.dstQueueFamily);
+		if (transfer.release)
+		{
+			barrier.setDstStageMask(vk::PipelineStageFlagBits2::eNone);
+			barrier.setDstAccessMask(vk::AccessFlagBits2::eNone);
+		}
+		else
+		{
+			barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eNone);
+			barrier.setSrcAccessMask(vk::AccessFlagBits2::eNone);
+		}
 
-			vk::DescriptorSetLayoutCreateInfo set_layout_info{};
-			set_layout_info.setBindings(vk_bindings);
-			m_descriptorSetLayoutMap[hash] = m_device->createDescriptorSetLayoutUnique(set_layout_info).value;
+		texture->set_state(newState, 0, texture->get_mip_levels(), 0, texture->get_array_layers());
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eTransferTextureOwnership, barrier);
+			return;
 		}
+		add_ownership_barrier(barrier);
+	}
 
-		outDescriptorSetLayout = m_descriptorSetLayoutMap.at(hash).get();
-		return true;
+	void CommandList::add_ownership_barrier(const vk::ImageMemoryBarrier2& barrier)
+	{
+		// Never folded into a pending transition, that would drop the queue families, and add_barrier() does not fold later
+		// transitions into it either.
+		flush_barriers();
+		m_pendingImageBarriers.push_back(barrier);
 	}
 
-	bool Device::submit_command_list(const SubmitInfo& submitInfo, FenceHandle* outFenceHandle, SemaphoreHandle* outSemaphoreHandle)
+	void CommandList::transfer_buffer_ownership(Buffer* buffer, const QueueOwnershipTransfer& transfer)
 	{
-		if (!m_commandListMap.contains(submitInfo.commandList.resourceHandle))
+		if (!m_hasBegun || transfer.srcQueueFamily == transfer.dstQueueFamily)
 		{
-			return false;
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eTransferBufferOwnership, TransferBufferOwnershipPacket{ buffer, transfer });
+			return;
 		}
 
-		vk::Fence fence{};
-		if (outFenceHandle != nullptr)
+		vk::BufferMemoryBarrier2 barrier{};
+		barrier.setBuffer(buffer->get_buffer());
+		barrier.setOffset(0);
+		barrier.setSize(VK_WHOLE_SIZE);
+		barrier.setSrcQueueFamilyIndex(transfer.srcQueueFamily);
+		barrier.setDstQueueFamilyIndex(transfer.dstQueueFamily);
+		if (transfer.release)
+		{
+			barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+			barrier.setSrcAccessMask(vk::AccessFlagBits2::eMemoryWrite);
+		}
+		else
 		{
-			*outFenceHandle = create_fence();
-			fence = m_fenceMap.at(outFenceHandle->resourceHandle).get();
+			barrier.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+			barrier.setDstAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite);
 		}
+		add_barrier(barrier);
+	}
 
-		vk::Semaphore signalSemaphore{};
-		if (outSemaphoreHandle != nullptr)
+	void CommandList::buffer_barrier(Buffer* buffer, vk::PipelineStageFlags2 srcStages, vk::AccessFlags2 srcAccess, vk::PipelineStageFlags2 dstStages, vk::AccessFlags2 dstAccess, vk::DeviceSize offset, vk::DeviceSize size)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
 		{
-			*outSemaphoreHandle = create_semaphore();
-			signalSemaphore = m_semaphoreMap.at(outSemaphoreHandle->resourceHandle).get();
+			write_packet(PacketType::eBufferBarrier, BufferBarrierPacket{ buffer, srcStages, srcAccess, dstStages, dstAccess, offset, size });
+			return;
 		}
 
-		const auto& command_list = m_commandListMap.at(submitInfo.commandList.resourceHandle);
-		auto command_buffer = command_list->get_command_buffer();
+		vk::BufferMemoryBarrier2 barrier{};
+		barrier.setBuffer(buffer->get_buffer());
+		barrier.setOffset(offset);
+		barrier.setSize(size);
+		barrier.setSrcStageMask(srcStages);
+		barrier.setSrcAccessMask(srcAccess);
+		barrier.setDstStageMask(dstStages);
+		barrier.setDstAccessMask(dstAccess);
+		add_barrier(barrier);
+	}
 
-		vk::SubmitInfo submit_info{};
-		submit_info.setCommandBuffers(command_buffer);
-		if (signalSemaphore)
+	void CommandList::memory_barrier(vk::PipelineStageFlags2 srcStages, vk::AccessFlags2 srcAccess, vk::PipelineStageFlags2 dstStages, vk::AccessFlags2 dstAccess)
+	{
+		if (!m_hasBegun)
 		{
-			submit_info.setSignalSemaphores(signalSemaphore);
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eMemoryBarrier, MemoryBarrierPacket{ srcStages, srcAccess, dstStages, dstAccess });
+			return;
 		}
 
-		auto queue = command_list->get_queue();
-		queue.submit(submit_info, fence);
-
-		return true;
+		add_barrier(vk::MemoryBarrier2(srcStages, srcAccess, dstStages, dstAccess));
 	}
 
-	bool Device::create_compute_pipeline(PipelineHandle& outPipelineHandle, const ComputePipelineInfo& computePipelineInfo)
+	void CommandList::add_transfer_write_barrier(Buffer* buffer, vk::DeviceSize offset, vk::DeviceSize size)
 	{
-		PipelineHandle pipelineHandle(m_deviceHandle, ResourceHandle(m_nextPipelineId));
-
-		std::vector<vk::DescriptorSetLayout> setLayouts(computePipelineInfo.descriptorSets.size());
-		for (auto i = 0; i < setLayouts.size(); ++i)
+		const auto end = size == VK_WHOLE_SIZE ? VK_WHOLE_SIZE : offset + size;
+		for (auto& pending : m_pendingTransferWriteBarriers)
 		{
-			vk::DescriptorSetLayout setLayout{};
-			if (create_or_get_descriptor_set_layout(setLayout, computePipelineInfo.descriptorSets.at(i)))
+			if (pending.buffer != buffer->get_buffer())
 			{
-				setLayouts[i] = setLayout;
+				continue;
 			}
+
+			// Another write into the same buffer since the last flush, cover both ranges with the one barrier.
+			const auto pendingEnd = pending.size == VK_WHOLE_SIZE ? VK_WHOLE_SIZE : pending.offset + pending.size;
+			const auto mergedEnd = std::max(end, pendingEnd);
+			pending.offset = std::min(pending.offset, offset);
+			pending.size = mergedEnd == VK_WHOLE_SIZE ? VK_WHOLE_SIZE : mergedEnd - pending.offset;
+			return;
 		}
 
-		vk::PushConstantRange constantRange{
-			convert_shader_stages_to_vk_shader_stage_flags(computePipelineInfo.constantBlock.shaderStages),
-			0,
-			computePipelineInfo.constantBlock.size
+		vk::PipelineStageFlags2 dstStages{};
+		vk::AccessFlags2 dstAccess{};
+		get_buffer_consumers(buffer->get_usage_flags(), buffer->is_host_visible(), dstStages, dstAccess);
+
+		vk::BufferMemoryBarrier2 barrier{};
+		barrier.setBuffer(buffer->get_buffer());
+		barrier.setOffset(offset);
+		barrier.setSize(size);
+		barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eAllTransfer);
+		barrier.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite);
+		barrier.setDstStageMask(dstStages);
+		barrier.setDstAccessMask(dstAccess);
+		m_pendingTransferWriteBarriers.push_back(barrier);
+	}
+
+	void CommandList::flush_barriers_for_transfer(const Buffer* srcBuffer, const Buffer* dstBuffer)
+	{
+		const auto touchesTransfer = [&](const vk::BufferMemoryBarrier2& barrier) {
+			return (srcBuffer != nullptr && barrier.buffer == srcBuffer->get_buffer()) || (dstBuffer != nullptr && barrier.buffer == dstBuffer->get_buffer());
 		};
-		m_pipelineMap[pipelineHandle.resourceHandle] = std::make_unique<ComputePipeline>(m_device.get(), computePipelineInfo.shaderCode, setLayouts, constantRange);
-		m_nextPipelineId += 1;
+		if (std::ranges::any_of(m_pendingTransferWriteBarriers, touchesTransfer))
+		{
+			flush_barriers();
+			return;
+		}
 
-		outPipelineHandle = pipelineHandle;
-		return true;
+		// Transfers into other buffers need not wait for the earlier ones, whose barriers go out together with the next flush.
+		auto transferWriteBarriers = std::move(m_pendingTransferWriteBarriers);
+		m_pendingTransferWriteBarriers.clear();
+		flush_barriers();
+		m_pendingTransferWriteBarriers = std::move(transferWriteBarriers);
 	}
 
-	bool Device::create_graphics_pipeline(PipelineHandle& outPipelineHandle, const GraphicsPipelineInfo& graphicsPipelineInfo)
+	void CommandList::add_barrier(const vk::ImageMemoryBarrier2& barrier)
 	{
-		PipelineHandle pipelineHandle(m_deviceHandle, ResourceHandle(m_nextPipelineId));
-
-		std::vector<vk::DescriptorSetLayout> setLayouts(graphicsPipelineInfo.descriptorSets.size());
-		for (auto i = 0; i < setLayouts.size(); ++i)
+		const auto& newRange = barrier.subresourceRange;
+		for (auto& pending : m_pendingImageBarriers)
 		{
-			vk::DescriptorSetLayout setLayout{};
-			if (create_or_get_descriptor_set_layout(setLayout, graphicsPipelineInfo.descriptorSets.at(i)))
+			if (pending.image != barrier.image)
 			{
-				setLayouts[i] = setLayout;
+				continue;
 			}
-		}
 
-		vk::PushConstantRange constantRange{
-			convert_shader_stages_to_vk_shader_stage_flags(graphicsPipelineInfo.constantBlock.shaderStages),
-			0,
-			graphicsPipelineInfo.constantBlock.size
-		};
-		m_pipelineMap[pipelineHandle.resourceHandle] = std::make_unique<GraphicsPipeline>(m_device.get(), graphicsPipelineInfo, setLayouts, constantRange);
-		m_nextPipelineId += 1;
+			const auto& range = pending.subresourceRange;
+			const bool mipsOverlap = newRange.baseMipLevel < range.baseMipLevel + range.levelCount && range.baseMipLevel < newRange.baseMipLevel + newRange.levelCount;
+			const bool layersOverlap = newRange.baseArrayLayer < range.baseArrayLayer + range.layerCount && range.baseArrayLayer < newRange.baseArrayLayer + newRange.layerCount;
+			if (!mipsOverlap || !layersOverlap)
+			{
+				continue;
+			}
 
-		outPipelineHandle = pipelineHandle;
-		return true;
+			// A queued ownership transfer keeps its own layout and stages, folding into its acquire half would make the
+			// later transition happen before the release on the other queue.
+			const bool isOwnershipTransfer = pending.srcQueueFamilyIndex != pending.dstQueueFamilyIndex;
+			if (range == newRange && pending.newLayout == barrier.oldLayout && !isOwnershipTransfer)
+			{
+				// Chained transition of the same subresources (A->B then B->C), fold into a single A->C barrier.
+				pending.setNewLayout(barrier.newLayout);
+				pending.setDstStageMask(barrier.dstStageMask);
+				pending.setDstAccessMask(barrier.dstAccessMask);
+				return;
+			}
+
+			// Barriers within one batch are unordered, so partially overlapping transitions need their own batch.
+			flush_barriers();
+			break;
+		}
+
+		m_pendingImageBarriers.push_back(barrier);
 	}
 
-	void Device::destroy_pipeline(PipelineHandle pipelineHandle)
+	void CommandList::add_barrier(const vk::BufferMemoryBarrier2& barrier)
 	{
+		m_pendingBufferBarriers.push_back(barrier);
 	}
 
-	bool Device::get_pipeline(Pipeline*& outPipeline, PipelineHandle pipelineHandle)
+	void CommandList::add_barrier(const vk::MemoryBarrier2& barrier)
 	{
-		if (!m_pipelineMap.contains(pipelineHandle.resourceHandle))
+		// Global barriers in one batch are unordered and cover everything, so they merge into one.
+		if (!m_pendingMemoryBarrier)
 		{
-			outPipeline = nullptr;
-			return false;
+			m_pendingMemoryBarrier = barrier;
+			return;
 		}
-
-		outPipeline = m_pipelineMap.at(pipelineHandle.resourceHandle).get();
-		return true;
+		m_pendingMemoryBarrier->srcStageMask |= barrier.srcStageMask;
+		m_pendingMemoryBarrier->srcAccessMask |= barrier.srcAccessMask;
+		m_pendingMemoryBarrier->dstStageMask |= barrier.dstStageMask;
+		m_pendingMemoryBarrier->dstAccessMask |= barrier.dstAccessMask;
 	}
 
-	bool Device::create_descriptor_set(DescriptorSetHandle& outDescriptorSetHandle, const DescriptorSetInfo& setInfo)
+	void CommandList::flush_barriers()
 	{
-		vk::DescriptorSetLayout descriptorSetLayout{};
-		if (!create_or_get_descriptor_set_layout(descriptorSetLayout, setInfo))
+		m_pendingBufferBarriers.insert(m_pendingBufferBarriers.end(), m_pendingTransferWriteBarriers.begin(), m_pendingTransferWriteBarriers.end());
+		m_pendingTransferWriteBarriers.clear();
+		if (m_pendingImageBarriers.empty() && m_pendingBufferBarriers.empty() && !m_pendingMemoryBarrier)
 		{
-			return false;
+			return;
 		}
 
-		DescriptorSetHandle descriptorSetHandle(m_deviceHandle, ResourceHandle(m_nextDescriptorSetId));
+		// The state tables name the stages of every queue using a state, eg. fragment shaders reading eShaderRead.
+		const auto supportedStages = m_commandPool->get_supported_stages();
+		for (auto& barrier : m_pendingImageBarriers)
+		{
+			restrict_barrier_stages(barrier, supportedStages);
+		}
+		for (auto& barrier : m_pendingBufferBarriers)
+		{
+			restrict_barrier_stages(barrier, supportedStages);
+		}
+		if (m_pendingMemoryBarrier)
+		{
+			restrict_barrier_stages(*m_pendingMemoryBarrier, supportedStages);
+		}
 
-		vk::DescriptorSetAllocateInfo set_alloc_info{};
-		set_alloc_info.setDescriptorPool(m_descriptorPool.get());
-		set_alloc_info.setSetLayouts(descriptorSetLayout);
-		auto allocatedDescriptorSets = m_device->allocateDescriptorSetsUnique(set_alloc_info).value;
+		vk::DependencyInfo dependency_info{};
+		dependency_info.setImageMemoryBarriers(m_pendingImageBarriers);
+		dependency_info.setBufferMemoryBarriers(m_pendingBufferBarriers);
+		if (m_pendingMemoryBarrier)
+		{
+			dependency_info.setMemoryBarriers(*m_pendingMemoryBarrier);
+		}
+		m_commandBuffer->pipelineBarrier2(dependency_info);
+		GFX_COUNT_STAT(m_stats.barriers, m_pendingImageBarriers.size() + m_pendingBufferBarriers.size() + (m_pendingMemoryBarrier ? 1 : 0));
 
-		m_descriptorSetMap[descriptorSetHandle.resourceHandle] = std::move(allocatedDescriptorSets[0]);
-		m_nextDescriptorSetId += 1;
+		m_pendingImageBarriers.clear();
+		m_pendingBufferBarriers.clear();
+		m_pendingMemoryBarrier.reset();
+	}
 
-		outDescriptorSetHandle = descriptorSetHandle;
-		return true;
+	void CommandList::reset_bound_state()
+	{
+		m_boundState = {};
 	}
 
-	bool Device::create_descriptor_set_from_pipeline(DescriptorSetHandle& outDescriptorSetHandle, PipelineHandle pipelineHandle, std::uint32_t set)
+	void CommandList::reset_dynamic_state()
 	{
-		Pipeline* pipeline{ nullptr };
-		if (!get_pipeline(pipeline, pipelineHandle))
+		m_boundState.cullMode.reset();
+		m_boundState.frontFace.reset();
+		m_boundState.topology.reset();
+		m_boundState.primitiveRestart.reset();
+		m_boundState.depthTest.reset();
+		m_boundState.depthWrite.reset();
+		m_boundState.depthCompareOp.reset();
+	}
+
+	auto CommandList::get_bind_point_index(const Pipeline& pipeline) -> std::size_t
+	{
+		return pipeline.get_type() == PipelineType::eCompute ? 1 : 0;
+	}
+
+	void CommandList::track_resource(std::uint64_t resourceKey)
+	{
+		if (m_flags & CommandListFlags_TrackResources)
 		{
-			return false;
+			m_referencedResources.insert(resourceKey);
 		}
+	}
 
-		auto descriptorSetLayout = pipeline->get_set_layout(set);
-
-		DescriptorSetHandle descriptorSetHandle(m_deviceHandle, ResourceHandle(m_nextDescriptorSetId));
+	bool CommandList::references_resource(std::uint64_t resourceKey) const
+	{
+		return m_referencedResources.contains(resourceKey);
+	}
 
-		vk::DescriptorSetAllocateInfo set_alloc_info{};
-		set_alloc_info.setDescriptorPool(m_descriptorPool.get());
-		set_alloc_info.setSetLayouts(descriptorSetLayout);
-		auto allocatedDescriptorSets = m_device->allocateDescriptorSetsUnique(set_alloc_info).value;
+	void CommandList::copy_buffer_to_texture(Buffer* buffer, Texture* texture, std::uint64_t bufferOffset, std::uint32_t mipLevel)
+	{
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eCopyBufferToTexture, CopyBufferToTexturePacket{ buffer, texture, bufferOffset, mipLevel });
+			return;
+		}
 
-		m_descriptorSetMap[descriptorSetHandle.resourceHandle] = std::move(allocatedDescriptorSets[0]);
-		m_nextDescriptorSetId += 1;
+		// Zero row length and height mean tightly packed, slice after slice and layer after layer. For compressed formats
+		// a whole level's extent may end mid block, which copies accept at the edge of the level.
+		vk::BufferImageCopy2 region{};
+		region.setBufferOffset(bufferOffset);
+		region.setBufferRowLength(0);
+		region.setBufferImageHeight(0);
+		region.setImageExtent(texture->get_mip_extent(mipLevel));
+		region.setImageOffset({});
+		region.imageSubresource.setAspectMask(texture->get_copy_aspect_mask());
+		region.imageSubresource.setBaseArrayLayer(0);
+		region.imageSubresource.setLayerCount(texture->get_array_layers());
+		region.imageSubresource.setMipLevel(mipLevel);
 
-		outDescriptorSetHandle = descriptorSetHandle;
-		return true;
+		vk::CopyBufferToImageInfo2 copy_info{};
+		copy_info.setSrcBuffer(buffer->get_buffer());
+		copy_info.setDstImage(texture->get_image());
+		copy_info.setDstImageLayout(vk::ImageLayout::eTransferDstOptimal);
+		copy_info.setRegions(region);
+		flush_barriers_for_transfer(buffer, nullptr);
+		m_commandBuffer->copyBufferToImage2(copy_info);
 	}
 
-	bool Device::get_descriptor_set(vk::DescriptorSet& outDescriptorSet, DescriptorSetHandle descriptorSetHandle)
+	void CommandList::copy_buffer_to_texture(Buffer* buffer, Texture* texture, std::span<const BufferTextureCopyRegion> regions)
 	{
-		if (!m_descriptorSetMap.contains(descriptorSetHandle.resourceHandle))
+		if (!m_hasBegun || regions.empty())
 		{
-			outDescriptorSet = nullptr;
-			return false;
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eCopyBufferToTextureRegions, CopyBufferToTextureRegionsPacket{ buffer, texture, std::uint32_t(regions.size()) }, regions.data(), regions.size_bytes());
+			return;
 		}
 
-		outDescriptorSet = m_descriptorSetMap.at(descriptorSetHandle.resourceHandle).get();
-		return true;
+		InlineVector<vk::BufferImageCopy2, MAX_COPY_REGIONS> vk_regions{};
+		vk_regions.resize(regions.size());
+		for (auto i = 0; i < regions.size(); ++i)
+		{
+			const auto& region = regions[i];
+			auto& vk_region = vk_regions[i];
+			vk_region.setBufferOffset(region.bufferOffset);
+			vk_region.setBufferRowLength(region.bufferRowLength);
+			vk_region.setBufferImageHeight(region.bufferImageHeight);
+			vk_region.setImageOffset({ std::int32_t(region.x), std::int32_t(region.y), std::int32_t(region.z) });
+			vk_region.setImageExtent(get_copy_region_extent(*texture, region));
+			vk_region.imageSubresource.setAspectMask(texture->get_copy_aspect_mask());
+			vk_region.imageSubresource.setMipLevel(region.mipLevel);
+			vk_region.imageSubresource.setBaseArrayLayer(region.baseArrayLayer);
+			vk_region.imageSubresource.setLayerCount(region.layerCount);
+		}
+
+		vk::CopyBufferToImageInfo2 copy_info{};
+		copy_info.setSrcBuffer(buffer->get_buffer());
+		copy_info.setDstImage(texture->get_image());
+		copy_info.setDstImageLayout(vk::ImageLayout::eTransferDstOptimal);
+		copy_info.setRegions(vk_regions);
+		flush_barriers_for_transfer(buffer, nullptr);
+		m_commandBuffer->copyBufferToImage2(copy_info);
 	}
 
-	void Device::bind_buffer_to_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, BufferHandle bufferHandle)
+	void CommandList::generate_mipmaps(Texture* texture, vk::Filter filter)
 	{
-		if (!m_descriptorSetMap.contains(descriptorSetHandle.resourceHandle))
+		if (!m_hasBegun)
 		{
-			s_errorCallback("GFX - Cannot bind buffer to unknown descriptor set!");
 			return;
 		}
-		const auto descriptorSet = m_descriptorSetMap.at(descriptorSetHandle.resourceHandle).get();
 
-		if (!m_bufferMap.contains(bufferHandle.resourceHandle))
+		// Each level is read as soon as it has been written, so the chain is one barrier pair per level. Deferred lists record
+		// the transitions now, as they resolve the tracked states, and only the blits are replayed.
+		transition_texture(texture, TextureState::eCopySrc, 0, 1);
+		for (std::uint32_t mip = 1; mip < texture->get_mip_levels(); ++mip)
+		{
+			// The level is about to be overwritten, whatever it held is discarded.
+			transition_texture(texture, TextureState::eUploadDst, mip, 1);
+			blit_mip_level(texture, mip, filter);
+			transition_texture(texture, TextureState::eCopySrc, mip, 1);
+		}
+		transition_texture(texture, TextureState::eShaderRead);
+	}
+
+	void CommandList::blit_mip_level(Texture* texture, std::uint32_t mip, vk::Filter filter)
+	{
+		if (is_recording_deferred())
 		{
-			s_errorCallback("GFX - Cannot bind unknown buffer to descriptor set!");
+			write_packet(PacketType::eBlitMipLevel, BlitMipLevelPacket{ texture, filter, mip });
 			return;
 		}
-		const auto& buffer = m_bufferMap.at(bufferHandle.resourceHandle);
 
-		vk::WriteDescriptorSet write{};
-		write.setDstSet(descriptorSet);
-		write.setDstBinding(binding);
-		write.setDescriptorCount(1);
-		write.setDescriptorType(buffer->get_descriptor_type());
-		write.setBufferInfo(buffer->get_descriptor_info());
+		auto get_mip_extent = [texture](std::uint32_t mipLevel) -> vk::Offset3D {
+			const auto extent = texture->get_mip_extent(mipLevel);
+			return { std::int32_t(extent.width), std::int32_t(extent.height), std::int32_t(extent.depth) };
+		};
 
-		m_device->updateDescriptorSets(write, {});
+		vk::ImageBlit2 region{};
+		region.srcSubresource.setAspectMask(texture->get_copy_aspect_mask());
+		region.srcSubresource.setMipLevel(mip - 1);
+		region.srcSubresource.setBaseArrayLayer(0);
+		region.srcSubresource.setLayerCount(texture->get_array_layers());
+		region.srcOffsets[1] = get_mip_extent(mip - 1);
+		region.dstSubresource.setAspectMask(texture->get_copy_aspect_mask());
+		region.dstSubresource.setMipLevel(mip);
+		region.dstSubresource.setBaseArrayLayer(0);
+		region.dstSubresource.setLayerCount(texture->get_array_layers());
+		region.dstOffsets[1] = get_mip_extent(mip);
+
+		vk::BlitImageInfo2 blit_info{};
+		blit_info.setSrcImage(texture->get_image());
+		blit_info.setSrcImageLayout(vk::ImageLayout::eTransferSrcOptimal);
+		blit_info.setDstImage(texture->get_image());
+		blit_info.setDstImageLayout(vk::ImageLayout::eTransferDstOptimal);
+		blit_info.setRegions(region);
+		blit_info.setFilter(filter);
+		flush_barriers();
+		m_commandBuffer->blitImage2(blit_info);
 	}
 
-	void Device::bind_texture_to_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, TextureHandle textureHandle, SamplerHandle samplerHandle)
+	void CommandList::copy_buffer(Buffer* srcBuffer, Buffer* dstBuffer, std::span<const BufferCopyRegion> regions)
 	{
-		if (!m_descriptorSetMap.contains(descriptorSetHandle.resourceHandle))
+		if (!m_hasBegun || regions.empty())
 		{
-			s_errorCallback("GFX - Cannot bind buffer to unknown descriptor set!");
 			return;
 		}
-		const auto descriptorSet = m_descriptorSetMap.at(descriptorSetHandle.resourceHandle).get();
-
-		if (!m_textureMap.contains(textureHandle.resourceHandle))
+		if (is_recording_deferred())
 		{
-			s_errorCallback("GFX - Cannot bind unknown buffer to descriptor set!");
+			write_packet(PacketType::eCopyBuffer, CopyBufferPacket{ srcBuffer, dstBuffer, std::uint32_t(regions.size()) }, regions.data(), regions.size_bytes());
 			return;
 		}
-		const auto& texture = m_textureMap.at(textureHandle.resourceHandle);
 
-		if (!m_samplerMap.contains(samplerHandle.resourceHandle))
+		InlineVector<vk::BufferCopy2, MAX_COPY_REGIONS> vk_regions{};
+		vk_regions.resize(regions.size());
+		vk::DeviceSize writtenBegin{ ~0ull };
+		vk::DeviceSize writtenEnd{ 0 };
+		for (auto i = 0; i < regions.size(); ++i)
 		{
-			s_errorCallback("GFX - Cannot bind unknown sampler to descriptor set!");
-			return;
+			vk_regions[i].setSrcOffset(regions[i].srcOffset);
+			vk_regions[i].setDstOffset(regions[i].dstOffset);
+			vk_regions[i].setSize(regions[i].size);
+			writtenBegin = std::min(writtenBegin, regions[i].dstOffset);
+			writtenEnd = std::max(writtenEnd, regions[i].dstOffset + regions[i].size);
 		}
-		const auto& sampler = m_samplerMap.at(samplerHandle.resourceHandle);
-
-		vk::DescriptorImageInfo image_info{};
-		image_info.setImageView(texture->get_view());
-		image_info.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
-		image_info.setSampler(sampler.get());
 
-		vk::WriteDescriptorSet write{};
-		write.setDstSet(descriptorSet);
-		write.setDstBinding(binding);
-		write.setDescriptorCount(1);
-		write.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
-		write.setImageInfo(image_info);
-
-		m_device->updateDescriptorSets(write, {});
+		vk::CopyBufferInfo2 copy_info{};
+		copy_info.setSrcBuffer(srcBuffer->get_buffer());
+		copy_info.setDstBuffer(dstBuffer->get_buffer());
+		copy_info.setRegions(vk_regions);
+		flush_barriers_for_transfer(srcBuffer, dstBuffer);
+		m_commandBuffer->copyBuffer2(copy_info);
+		add_transfer_write_barrier(dstBuffer, writtenBegin, writtenEnd - writtenBegin);
 	}
 
-	bool Device::create_buffer(BufferHandle& outBufferHandle, const BufferInfo& bufferInfo)
+	void CommandList::copy_texture_to_buffer(Texture* texture, Buffer* buffer, std::span<const TextureCopyRegion> regions)
 	{
-		BufferHandle bufferHandle(m_deviceHandle, ResourceHandle(m_nextBufferId));
+		if (!m_hasBegun || regions.empty())
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eCopyTextureToBuffer, CopyTextureToBufferPacket{ texture, buffer, std::uint32_t(regions.size()) }, regions.data(), regions.size_bytes());
+			return;
+		}
 
-		m_bufferMap[bufferHandle.resourceHandle] = std::make_unique<Buffer>(m_device.get(), m_allocator.get(), bufferInfo);
-		m_nextBufferId += 1;
+		const auto extent = texture->get_extent();
+		InlineVector<vk::BufferImageCopy2, MAX_COPY_REGIONS> vk_regions{};
+		vk_regions.resize(regions.size());
+		vk::DeviceSize writtenBegin{ ~0ull };
+		for (auto i = 0; i < regions.size(); ++i)
+		{
+			const auto& region = regions[i];
+			auto& vk_region = vk_regions[i];
+			vk_region.setBufferOffset(region.bufferOffset);
+			writtenBegin = std::min(writtenBegin, region.bufferOffset);
+			vk_region.setImageOffset({});
+			vk_region.setImageExtent({ std::max(extent.width >> region.mipLevel, 1u), std::max(extent.height >> region.mipLevel, 1u), std::max(extent.depth >> region.mipLevel, 1u) });
+			vk_region.imageSubresource.setAspectMask(texture->get_copy_aspect_mask());
+			vk_region.imageSubresource.setMipLevel(region.mipLevel);
+			vk_region.imageSubresource.setBaseArrayLayer(region.baseArrayLayer);
+			vk_region.imageSubresource.setLayerCount(region.layerCount);
+		}
 
-		outBufferHandle = bufferHandle;
-		return true;
+		vk::CopyImageToBufferInfo2 copy_info{};
+		copy_info.setSrcImage(texture->get_image());
+		copy_info.setSrcImageLayout(vk::ImageLayout::eTransferSrcOptimal);
+		copy_info.setDstBuffer(buffer->get_buffer());
+		copy_info.setRegions(vk_regions);
+		flush_barriers_for_transfer(nullptr, buffer);
+		m_commandBuffer->copyImageToBuffer2(copy_info);
+		add_transfer_write_barrier(buffer, writtenBegin, VK_WHOLE_SIZE);
 	}
 
-	void Device::destroy_buffer(BufferHandle bufferHandle)
+	void CommandList::copy_texture(Texture* srcTexture, Texture* dstTexture, std::span<const TextureRegionCopy> regions)
 	{
+		if (!m_hasBegun || regions.empty())
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eCopyTexture, CopyTexturePacket{ srcTexture, dstTexture, std::uint32_t(regions.size()) }, regions.data(), regions.size_bytes());
+			return;
+		}
+
+		InlineVector<vk::ImageCopy2, MAX_COPY_REGIONS> vk_regions{};
+		vk_regions.resize(regions.size());
+		for (auto i = 0; i < regions.size(); ++i)
+		{
+			const auto& region = regions[i];
+			auto& vk_region = vk_regions[i];
+			vk_region.setSrcSubresource({ srcTexture->get_copy_aspect_mask(), region.srcMipLevel, region.srcBaseArrayLayer, region.layerCount });
+			vk_region.setSrcOffset({ std::int32_t(region.srcX), std::int32_t(region.srcY), std::int32_t(region.srcZ) });
+			vk_region.setDstSubresource({ dstTexture->get_copy_aspect_mask(), region.dstMipLevel, region.dstBaseArrayLayer, region.layerCount });
+			vk_region.setDstOffset({ std::int32_t(region.dstX), std::int32_t(region.dstY), std::int32_t(region.dstZ) });
+			vk_region.setExtent(get_copy_region_extent(*srcTexture, region));
+		}
+
+		vk::CopyImageInfo2 copy_info{};
+		copy_info.setSrcImage(srcTexture->get_image());
+		copy_info.setSrcImageLayout(vk::ImageLayout::eTransferSrcOptimal);
+		copy_info.setDstImage(dstTexture->get_image());
+		copy_info.setDstImageLayout(vk::ImageLayout::eTransferDstOptimal);
+		copy_info.setRegions(vk_regions);
+		flush_barriers();
+		m_commandBuffer->copyImage2(copy_info);
 	}
 
-	bool Device::get_buffer(Buffer*& outBuffer, BufferHandle bufferHandle)
+	void CommandList::blit_texture(Texture* srcTexture, Texture* dstTexture, std::span<const TextureBlitRegion> regions, vk::Filter filter)
 	{
-		if (!m_bufferMap.contains(bufferHandle.resourceHandle))
+		if (!m_hasBegun || regions.empty())
 		{
-			outBuffer = nullptr;
-			return false;
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eBlitTexture, BlitTexturePacket{ srcTexture, dstTexture, filter, std::uint32_t(regions.size()) }, regions.data(), regions.size_bytes());
+			return;
+		}
+
+		InlineVector<vk::ImageBlit2, MAX_COPY_REGIONS> vk_regions{};
+		vk_regions.resize(regions.size());
+		for (auto i = 0; i < regions.size(); ++i)
+		{
+			const auto& region = regions[i];
+			auto& vk_region = vk_regions[i];
+			vk_region.setSrcSubresource({ srcTexture->get_copy_aspect_mask(), region.srcMipLevel, region.srcBaseArrayLayer, region.layerCount });
+			vk_region.setSrcOffsets(get_blit_offsets(*srcTexture, region.srcMipLevel, region.srcBegin, region.srcEnd));
+			vk_region.setDstSubresource({ dstTexture->get_copy_aspect_mask(), region.dstMipLevel, region.dstBaseArrayLayer, region.layerCount });
+			vk_region.setDstOffsets(get_blit_offsets(*dstTexture, region.dstMipLevel, region.dstBegin, region.dstEnd));
 		}
 
-		outBuffer = m_bufferMap.at(bufferHandle.resourceHandle).get();
-		return true;
+		vk::BlitImageInfo2 blit_info{};
+		blit_info.setSrcImage(srcTexture->get_image());
+		blit_info.setSrcImageLayout(vk::ImageLayout::eTransferSrcOptimal);
+		blit_info.setDstImage(dstTexture->get_image());
+		blit_info.setDstImageLayout(vk::ImageLayout::eTransferDstOptimal);
+		blit_info.setRegions(vk_regions);
+		blit_info.setFilter(filter);
+		flush_barriers();
+		m_commandBuffer->blitImage2(blit_info);
 	}
 
-	bool Device::map_buffer(BufferHandle bufferHandle, void*& outBufferPtr)
+	void CommandList::resolve_texture(Texture* srcTexture, Texture* dstTexture, std::span<const TextureRegionCopy> regions)
 	{
-		if (!m_bufferMap.contains(bufferHandle.resourceHandle))
+		if (!m_hasBegun || regions.empty())
 		{
-			return false;
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eResolveTexture, CopyTexturePacket{ srcTexture, dstTexture, std::uint32_t(regions.size()) }, regions.data(), regions.size_bytes());
+			return;
 		}
 
-		const auto& buffer = m_bufferMap.at(bufferHandle.resourceHandle);
+		InlineVector<vk::ImageResolve2, MAX_COPY_REGIONS> vk_regions{};
+		vk_regions.resize(regions.size());
+		for (auto i = 0; i < regions.size(); ++i)
+		{
+			const auto& region = regions[i];
+			auto& vk_region = vk_regions[i];
+			vk_region.setSrcSubresource({ vk::ImageAspectFlagBits::eColor, region.srcMipLevel, region.srcBaseArrayLayer, region.layerCount });
+			vk_region.setSrcOffset({ std::int32_t(region.srcX), std::int32_t(region.srcY), std::int32_t(region.srcZ) });
+			vk_region.setDstSubresource({ vk::ImageAspectFlagBits::eColor, region.dstMipLevel, region.dstBaseArrayLayer, region.layerCount });
+			vk_region.setDstOffset({ std::int32_t(region.dstX), std::int32_t(region.dstY), std::int32_t(region.dstZ) });
+			vk_region.setExtent(get_copy_region_extent(*srcTexture, region));
+		}
 
-		outBufferPtr = m_allocator->mapMemory(buffer->get_allocation()).value;
-		return outBufferPtr != nullptr;
+		vk::ResolveImageInfo2 resolve_info{};
+		resolve_info.setSrcImage(srcTexture->get_image());
+		resolve_info.setSrcImageLayout(vk::ImageLayout::eTransferSrcOptimal);
+		resolve_info.setDstImage(dstTexture->get_image());
+		resolve_info.setDstImageLayout(vk::ImageLayout::eTransferDstOptimal);
+		resolve_info.setRegions(vk_regions);
+		flush_barriers();
+		m_commandBuffer->resolveImage2(resolve_info);
 	}
 
-	void Device::unmap_buffer(BufferHandle bufferHandle)
+	void CommandList::copy_video_plane(vk::Image srcImage, vk::ImageAspectFlagBits srcPlane, std::uint32_t srcArrayLayer, Texture* dstTexture, vk::Extent2D extent)
 	{
-		if (!m_bufferMap.contains(bufferHandle.resourceHandle))
+		if (!m_hasBegun)
 		{
 			return;
 		}
-
-		const auto& buffer = m_bufferMap.at(bufferHandle.resourceHandle);
-		m_allocator->unmapMemory(buffer->get_allocation());
+		GFX_ASSERT(!is_recording_deferred(), "Video planes cannot be copied by deferred command lists!");
+
+		// A plane of a multi-planar image copies as its plane format, e.g. R8 for luma and R8G8 for chroma.
+		vk::ImageCopy2 vk_region{};
+		vk_region.setSrcSubresource({ srcPlane, 0, srcArrayLayer, 1 });
+		vk_region.setDstSubresource({ dstTexture->get_copy_aspect_mask(), 0, 0, 1 });
+		vk_region.setExtent({ extent.width, extent.height, 1 });
+
+		vk::CopyImageInfo2 copy_info{};
+		copy_info.setSrcImage(srcImage);
+		copy_info.setSrcImageLayout(vk::ImageLayout::eTransferSrcOptimal);
+		copy_info.setDstImage(dstTexture->get_image());
+		copy_info.setDstImageLayout(vk::ImageLayout::eTransferDstOptimal);
+		copy_info.setRegions(vk_region);
+		flush_barriers();
+		m_commandBuffer->copyImage2(copy_info);
 	}
 
-	bool Device::create_texture(TextureHandle& outTextureHandle, const TextureInfo& textureInfo)
+	void CommandList::fill_buffer(Buffer* buffer, std::uint64_t offset, std::uint64_t size, std::uint32_t value)
 	{
-		TextureHandle textureHandle(m_deviceHandle, ResourceHandle(m_nextTextureId));
-
-		m_textureMap[textureHandle.resourceHandle] = std::make_unique<Texture>(*this, textureInfo);
-		m_nextTextureId += 1;
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eFillBuffer, FillBufferPacket{ buffer, offset, size, value });
+			return;
+		}
 
-		outTextureHandle = textureHandle;
-		return true;
+		flush_barriers_for_transfer(nullptr, buffer);
+		m_commandBuffer->fillBuffer(buffer->get_buffer(), offset, size, value);
+		add_transfer_write_barrier(buffer, offset, size);
 	}
 
-	bool Device::create_texture(TextureHandle& outTextureHandle, vk::Image image, vk::Extent3D extent, vk::Format format)
+	void CommandList::update_buffer(Buffer* buffer, std::uint64_t offset, std::uint64_t size, const void* data)
 	{
-		TextureHandle textureHandle(m_deviceHandle, ResourceHandle(m_nextTextureId));
-
-		m_textureMap[textureHandle.resourceHandle] = std::make_unique<Texture>(*this, image, extent, format);
-		m_nextTextureId += 1;
-
-		outTextureHandle = textureHandle;
-		return true;
-	}
+		if (!m_hasBegun)
+		{
+			return;
+		}
+		if (is_recording_deferred())
+		{
+			write_packet(PacketType::eUpdateBuffer, UpdateBufferPacket{ buffer, offset, size }, data, size);
+			return;
+		}
 
-	void Device::destroy_texture(TextureHandle textureHandle)
-	{
+		flush_barriers_for_transfer(nullptr, buffer);
+		m_commandBuffer->updateBuffer(buffer->get_buffer(), offset, size, data);
+		add_transfer_write_barrier(buffer, offset, size);
 	}
 
-	bool Device::get_texture(Texture*& outTexture, TextureHandle textureHandle)
+	void CommandList::move_buffer(Buffer* buffer, vk::Buffer dstBuffer)
 	{
-		if (!m_textureMap.contains(textureHandle.resourceHandle))
+		GFX_ASSERT(!is_recording_deferred(), "Defragmentation moves cannot be recorded deferred!");
+		if (!m_hasBegun)
 		{
-			return false;
+			return;
 		}
 
-		outTexture = m_textureMap.at(textureHandle.resourceHandle).get();
-		return true;
+		// Earlier submissions to this queue may still be writing the buffer.
+		vk::BufferMemoryBarrier2 src_barrier{};
+		src_barrier.setBuffer(buffer->get_buffer());
+		src_barrier.setOffset(0);
+		src_barrier.setSize(VK_WHOLE_SIZE);
+		src_barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+		src_barrier.setSrcAccessMask(vk::AccessFlagBits2::eMemoryWrite);
+		src_barrier.setDstStageMask(vk::PipelineStageFlagBits2::eCopy);
+		src_barrier.setDstAccessMask(vk::AccessFlagBits2::eTransferRead);
+		add_barrier(src_barrier);
+
+		vk::BufferCopy2 region{};
+		region.setSize(buffer->get_size());
+
+		vk::CopyBufferInfo2 copy_info{};
+		copy_info.setSrcBuffer(buffer->get_buffer());
+		copy_info.setDstBuffer(dstBuffer);
+		copy_info.setRegions(region);
+		flush_barriers();
+		m_commandBuffer->copyBuffer2(copy_info);
+
+		vk::BufferMemoryBarrier2 dst_barrier{};
+		dst_barrier.setBuffer(dstBuffer);
+		dst_barrier.setOffset(0);
+		dst_barrier.setSize(VK_WHOLE_SIZE);
+		dst_barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eCopy);
+		dst_barrier.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite);
+		dst_barrier.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+		dst_barrier.setDstAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite);
+		add_barrier(dst_barrier);
 	}
 
-	bool Device::create_sampler(SamplerHandle& outSamplerHandle, const SamplerInfo& samplerInfo)
+	void CommandList::move_texture(Texture* texture, vk::Image dstImage)
 	{
-		SamplerHandle samplerHandle(m_deviceHandle, ResourceHandle(m_nextSamplerId));
-
-		vk::SamplerCreateInfo vk_sampler_info{};
-		vk_sampler_info.setAddressModeU(samplerInfo.addressMode == SamplerAddressMode::eRepeat ? vk::SamplerAddressMode::eRepeat : vk::SamplerAddressMode::eClampToEdge);
-		vk_sampler_info.setAddressModeV(samplerInfo.addressMode == SamplerAddressMode::eRepeat ? vk::SamplerAddressMode::eRepeat : vk::SamplerAddressMode::eClampToEdge);
-		vk_sampler_info.setAddressModeW(samplerInfo.addressMode == SamplerAddressMode::eRepeat ? vk::SamplerAddressMode::eRepeat : vk::SamplerAddressMode::eClampToEdge);
-		vk_sampler_info.setMinFilter(samplerInfo.filterMode == SamplerFilterMode::eLinear ? vk::Filter::eLinear : vk::Filter::eNearest);
-		vk_sampler_info.setMagFilter(samplerInfo.filterMode == SamplerFilterMode::eLinear ? vk::Filter::eLinear : vk::Filter::eNearest);
-
-		m_samplerMap[samplerHandle.resourceHandle] = m_device->createSamplerUnique(vk_sampler_info).value;
-		m_nextSamplerId += 1;
+		GFX_ASSERT(!is_recording_deferred(), "Defragmentation moves cannot be recorded deferred!");
+		if (!m_hasBegun)
+		{
+			return;
+		}
 
-		outSamplerHandle = samplerHandle;
-		return true;
-	}
+		const vk::ImageSubresourceRange range{ texture->get_aspect_mask(), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+		transition_texture(texture, TextureState::eCopySrc);
+
+		vk::ImageMemoryBarrier2 dst_barrier{};
+		dst_barrier.setImage(dstImage);
+		dst_barrier.setSubresourceRange(range);
+		dst_barrier.setOldLayout(vk::ImageLayout::eUndefined);
+		dst_barrier.setNewLayout(vk::ImageLayout::eTransferDstOptimal);
+		dst_barrier.setDstStageMask(vk::PipelineStageFlagBits2::eCopy);
+		dst_barrier.setDstAccessMask(vk::AccessFlagBits2::eTransferWrite);
+		add_barrier(dst_barrier);
+
+		const auto extent = texture->get_extent();
+		std::vector<vk::ImageCopy2> regions(texture->get_mip_levels());
+		for (auto mipLevel = 0u; mipLevel < regions.size(); ++mipLevel)
+		{
+			const vk::ImageSubresourceLayers subresource{ texture->get_aspect_mask(), mipLevel, 0, texture->get_array_layers() };
+			regions[mipLevel].setSrcSubresource(subresource);
+			regions[mipLevel].setDstSubresource(subresource);
+			regions[mipLevel].setExtent({ std::max(extent.width >> mipLevel, 1u), std::max(extent.height >> mipLevel, 1u), std::max(extent.depth >> mipLevel, 1u) });
+		}
 
-	void Device::destroy_sampler(SamplerHandle samplerHandle)
-	{
+		vk::CopyImageInfo2 copy_info{};
+		copy_info.setSrcImage(texture->get_image());
+		copy_info.setSrcImageLayout(vk::ImageLayout::eTransferSrcOptimal);
+		copy_info.setDstImage(dstImage);
+		copy_info.setDstImageLayout(vk::ImageLayout::eTransferDstOptimal);
+		copy_info.setRegions(regions);
+		flush_barriers();
+		m_commandBuffer->copyImage2(copy_info);
+
+		// The replacement ends up in the layout the texture is tracked in, so it can be swapped in without a transition.
+		dst_barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+		dst_barrier.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+		dst_barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eCopy);
+		dst_barrier.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite);
+		dst_barrier.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+		dst_barrier.setDstAccessMask(vk::AccessFlagBits2::eMemoryRead);
+		add_barrier(dst_barrier);
+		transition_texture(texture, TextureState::eShaderRead);
 	}
 
-	bool Device::create_swap_chain(SwapChainHandle& outSwapChainHandle, const SwapChainInfo& swapChainInfo)
+	void CommandList::copy_texture_levels(Texture* srcTexture, std::uint32_t srcBaseMipLevel, Texture* dstTexture, std::uint32_t dstBaseMipLevel, std::uint32_t mipLevelCount)
 	{
-		SwapChainHandle swapChainHandle(m_deviceHandle, ResourceHandle(m_nextSwapChainId));
+		GFX_ASSERT(!is_recording_deferred(), "Level copies cannot be recorded deferred!");
+		if (!m_hasBegun || mipLevelCount == 0)
+		{
+			return;
+		}
 
-		m_swapChainMap[swapChainHandle.resourceHandle] = std::make_unique<SwapChain>(*this, swapChainInfo);
-		m_nextSwapChainId += 1;
+		std::vector<vk::ImageCopy2> regions(mipLevelCount);
+		for (auto i = 0u; i < mipLevelCount; ++i)
+		{
+			regions[i].setSrcSubresource({ srcTexture->get_copy_aspect_mask(), srcBaseMipLevel + i, 0, srcTexture->get_array_layers() });
+			regions[i].setDstSubresource({ dstTexture->get_copy_aspect_mask(), dstBaseMipLevel + i, 0, dstTexture->get_array_layers() });
+			regions[i].setExtent(srcTexture->get_mip_extent(srcBaseMipLevel + i));
+		}
 
-		outSwapChainHandle = swapChainHandle;
-		return true;
+		vk::CopyImageInfo2 copy_info{};
+		copy_info.setSrcImage(srcTexture->get_image());
+		copy_info.setSrcImageLayout(vk::ImageLayout::eTransferSrcOptimal);
+		copy_info.setDstImage(dstTexture->get_image());
+		copy_info.setDstImageLayout(vk::ImageLayout::eTransferDstOptimal);
+		copy_info.setRegions(regions);
+		flush_barriers();
+		m_commandBuffer->copyImage2(copy_info);
 	}
 
-	void Device::destroy_swap_chain(SwapChainHandle swapChainHandle)
+	auto CommandList::operator=(CommandList&& rhs) noexcept -> CommandList&
 	{
+		std::swap(m_commandPool, rhs.m_commandPool);
+		std::swap(m_queue, rhs.m_queue);
+		std::swap(m_level, rhs.m_level);
+		std::swap(m_flags, rhs.m_flags);
+		std::swap(m_commandBuffer, rhs.m_commandBuffer);
+		std::swap(m_hasBegun, rhs.m_hasBegun);
+		std::swap(m_boundPipeline, rhs.m_boundPipeline);
+		std::swap(m_boundState, rhs.m_boundState);
+		std::swap(m_pendingImageBarriers, rhs.m_pendingImageBarriers);
+		std::swap(m_pendingBufferBarriers, rhs.m_pendingBufferBarriers);
+		std::swap(m_pendingTransferWriteBarriers, rhs.m_pendingTransferWriteBarriers);
+		std::swap(m_pendingMemoryBarrier, rhs.m_pendingMemoryBarrier);
+		std::swap(m_stats, rhs.m_stats);
+		std::swap(m_referencedResources, rhs.m_referencedResources);
+		std::swap(m_readbacks, rhs.m_readbacks);
+		std::swap(m_commandStream, rhs.m_commandStream);
+		std::swap(m_translating, rhs.m_translating);
+		rhs.m_translationPending.store(m_translationPending.exchange(rhs.m_translationPending.load()));
+		return *this;
 	}
 
-	bool Device::get_swap_chain(SwapChain*& outSwapChain, SwapChainHandle swapChainHandle)
+	Buffer::Buffer(vk::Device device, vma::Allocator allocator, const BufferInfo& bufferInfo, bool aliased, vk::ExternalMemoryHandleTypeFlags externalHandleTypes)
+		: m_device(device), m_allocator(allocator), m_aliased(aliased)
 	{
-		if (!m_swapChainMap.contains(swapChainHandle.resourceHandle))
+		m_size = bufferInfo.size;
+		m_memory = bufferInfo.memory == BufferMemory::eDefault ? get_default_buffer_memory(bufferInfo.type) : bufferInfo.memory;
+		if (bufferInfo.sparse)
 		{
-			outSwapChain = nullptr;
-			return false;
+			m_memory = BufferMemory::eGpuOnly;
 		}
 
-		outSwapChain = m_swapChainMap.at(swapChainHandle.resourceHandle).get();
-		return true;
-	}
-
-	auto Device::create_fence() -> FenceHandle
-	{
-		auto fenceHandle = FenceHandle(m_deviceHandle, ResourceHandle(m_nextFenceId));
-
-		vk::FenceCreateInfo fence_info{};
-		m_fenceMap[fenceHandle.resourceHandle] = m_device->createFenceUnique(fence_info).value;
-
-		m_nextFenceId += 1;
-		return fenceHandle;
-	}
+		// Every buffer can be copied to and from, so eGpuOnly buffers can be filled through staging.
+		m_usageFlags = convert_buffer_type_to_vk_usage(bufferInfo.type) | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst;
+		if (bufferInfo.deviceAddress)
+		{
+			m_usageFlags |= vk::BufferUsageFlagBits::eShaderDeviceAddress;
+		}
+		if (bufferInfo.predicate)
+		{
+			m_usageFlags |= vk::BufferUsageFlagBits::eConditionalRenderingEXT;
+		}
+		if (bufferInfo.accelerationStructureInput)
+		{
+			m_usageFlags |= vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR;
+		}
+		auto vk_buffer_info = get_buffer_create_info();
 
-	auto Device::create_semaphore() -> SemaphoreHandle
-	{
-		auto semaphoreHandle = SemaphoreHandle(m_deviceHandle, ResourceHandle(m_nextSemaphoreId));
+		if (bufferInfo.sparse)
+		{
+			// No memory is bound up front, bind_sparse_buffer_pages() backs the pages that are used.
+			vk_buffer_info.setFlags(vk::BufferCreateFlagBits::eSparseBinding | vk::BufferCreateFlagBits::eSparseResidency);
+			m_buffer = vma::UniqueBuffer(m_device.createBuffer(vk_buffer_info).value, &m_allocator);
+			m_sparse = std::make_unique<SparseResidency>(m_allocator, m_device.getBufferMemoryRequirements(m_buffer.get()));
+		}
+		else if (m_aliased)
+		{
+			const vk::ExternalMemoryBufferCreateInfo external_info{ externalHandleTypes };
+			if (externalHandleTypes)
+			{
+				vk_buffer_info.setPNext(&external_info);
+			}
+			m_buffer = vma::UniqueBuffer(m_device.createBuffer(vk_buffer_info).value, &m_allocator);
+		}
+		else
+		{
+			auto alloc_info = convert_buffer_memory_to_vma_allocation_info(m_memory);
+			if (m_memory != BufferMemory::eGpuOnly)
+			{
+				// Mapped for the buffer's whole lifetime, so CPU writes need no map/unmap calls.
+				alloc_info.flags |= vma::AllocationCreateFlagBits::eMapped;
+			}
+			if (bufferInfo.dedicatedAllocation == DedicatedAllocation::eAlways ||
+				(bufferInfo.dedicatedAllocation == DedicatedAllocation::eAuto && bufferInfo.size >= DEDICATED_BUFFER_THRESHOLD))
+			{
+				alloc_info.flags |= vma::AllocationCreateFlagBits::eDedicatedMemory;
+			}
+			// Device::get_device_buffer_info() resets it to the default where priorities are unsupported.
+			if (bufferInfo.memoryPriority != DEFAULT_MEMORY_PRIORITY)
+			{
+				alloc_info.flags |= vma::AllocationCreateFlagBits::eDedicatedMemory;
+				alloc_info.priority = bufferInfo.memoryPriority;
+			}
+			std::tie(m_buffer, m_allocation) = m_allocator.createBufferUnique(vk_buffer_info, alloc_info).value;
+			m_dedicatedMemory = bool(alloc_info.flags & vma::AllocationCreateFlagBits::eDedicatedMemory);
 
-		vk::SemaphoreCreateInfo semaphore_info{};
-		m_semaphoreMap[semaphoreHandle.resourceHandle] = m_device->createSemaphoreUnique(semaphore_info).value;
+			const auto memory_properties = m_allocator.getAllocationMemoryProperties(m_allocation.get());
+			m_hostVisible = bool(memory_properties & vk::MemoryPropertyFlagBits::eHostVisible);
+			m_mappedPtr = m_allocator.getAllocationInfo(m_allocation.get()).pMappedData;
+		}
+		// Aliased buffers only have an address once bound.
+		if (bufferInfo.deviceAddress && !m_aliased)
+		{
+			m_deviceAddress = m_device.getBufferAddress(vk::BufferDeviceAddressInfo{ m_buffer.get() });
+		}
 
-		m_nextSemaphoreId += 1;
-		return semaphoreHandle;
-	}
+		m_descriptorType = convert_buffer_type_to_descriptor_type(bufferInfo.type);
 
-	auto Device::get_descriptor_set_layout_binding(const DescriptorBindingInfo& descriptorBindingInfo) -> vk::DescriptorSetLayoutBinding
-	{
-		vk::DescriptorSetLayoutBinding outBinding{};
-		outBinding.setDescriptorType(convert_descriptor_type_to_vk_descriptor_type(descriptorBindingInfo.type));
-		outBinding.setDescriptorCount(descriptorBindingInfo.count);
-		outBinding.setStageFlags(convert_shader_stages_to_vk_shader_stage_flags(descriptorBindingInfo.shaderStages));
-		return outBinding;
-	}
+		m_descriptorInfo.setBuffer(m_buffer.get());
+		m_descriptorInfo.setOffset(0);
+		m_descriptorInfo.setRange(bufferInfo.size);
 
-	CommandList::CommandList(vk::Device device, vk::CommandPool commandPool, vk::Queue queue)
-		: m_device(device), m_commandPool(commandPool), m_queue(queue)
-	{
-		vk::CommandBufferAllocateInfo cmd_alloc_info{};
-		cmd_alloc_info.setCommandPool(m_commandPool);
-		cmd_alloc_info.setCommandBufferCount(1);
-		cmd_alloc_info.setLevel(vk::CommandBufferLevel::ePrimary);
-		m_commandBuffer = std::move(m_device.allocateCommandBuffersUnique(cmd_alloc_info).value[0]);
+		m_debugName = bufferInfo.debugName;
+		set_debug_name(m_device, m_buffer.get(), m_debugName);
 	}
 
-	CommandList::CommandList(CommandList&& other) noexcept
+	Buffer::Buffer(Buffer&& other) noexcept
 	{
 		std::swap(m_device, other.m_device);
-		std::swap(m_commandPool, other.m_commandPool);
-		std::swap(m_queue, other.m_queue);
-		std::swap(m_commandBuffer, other.m_commandBuffer);
-		std::swap(m_hasBegun, other.m_hasBegun);
+		std::swap(m_allocator, other.m_allocator);
+		std::swap(m_aliasedMemory, other.m_aliasedMemory);
+		std::swap(m_buffer, other.m_buffer);
+		std::swap(m_allocation, other.m_allocation);
+		std::swap(m_descriptorType, other.m_descriptorType);
+		std::swap(m_descriptorInfo, other.m_descriptorInfo);
+		std::swap(m_usageFlags, other.m_usageFlags);
+		std::swap(m_size, other.m_size);
+		std::swap(m_memory, other.m_memory);
+		std::swap(m_hostVisible, other.m_hostVisible);
+		std::swap(m_mappedPtr, other.m_mappedPtr);
+		std::swap(m_deviceAddress, other.m_deviceAddress);
+		std::swap(m_dedicatedMemory, other.m_dedicatedMemory);
+		std::swap(m_aliased, other.m_aliased);
+		std::swap(m_sparse, other.m_sparse);
+		std::swap(m_debugName, other.m_debugName);
 	}
 
-	bool CommandList::is_valid() const
+	auto Buffer::operator=(Buffer&& rhs) noexcept -> Buffer&
 	{
-		return static_cast<bool>(*m_commandBuffer);
+		std::swap(m_device, rhs.m_device);
+		std::swap(m_allocator, rhs.m_allocator);
+		std::swap(m_aliasedMemory, rhs.m_aliasedMemory);
+		std::swap(m_buffer, rhs.m_buffer);
+		std::swap(m_allocation, rhs.m_allocation);
+		std::swap(m_descriptorType, rhs.m_descriptorType);
+		std::swap(m_descriptorInfo, rhs.m_descriptorInfo);
+		std::swap(m_usageFlags, rhs.m_usageFlags);
+		std::swap(m_size, rhs.m_size);
+		std::swap(m_memory, rhs.m_memory);
+		std::swap(m_hostVisible, rhs.m_hostVisible);
+		std::swap(m_mappedPtr, rhs.m_mappedPtr);
+		std::swap(m_deviceAddress, rhs.m_deviceAddress);
+		std::swap(m_dedicatedMemory, rhs.m_dedicatedMemory);
+		std::swap(m_aliased, rhs.m_aliased);
+		std::swap(m_sparse, rhs.m_sparse);
+		std::swap(m_debugName, rhs.m_debugName);
+		return *this;
 	}
 
-	void CommandList::reset()
+	bool Buffer::bind_aliased_memory(std::shared_ptr<AliasedMemory> memory, vk::DeviceSize offset)
 	{
-		m_commandBuffer->reset();
-		m_hasBegun = false;
-		m_boundPipeline = nullptr;
+		GFX_ASSERT(m_aliased && !m_aliasedMemory, "Only unbound aliased buffers can be bound to aliased memory!");
+		if (!memory->get_allocation())
+		{
+			// External memory is never mapped.
+			if (m_device.bindBufferMemory(m_buffer.get(), memory->get_device_memory(), offset) != vk::Result::eSuccess)
+			{
+				return false;
+			}
+		}
+		else if (vmaBindBufferMemory2(static_cast<VmaAllocator>(m_allocator), static_cast<VmaAllocation>(memory->get_allocation()), offset, m_buffer.get(), nullptr) != VK_SUCCESS)
+		{
+			return false;
+		}
+		else if (auto* mappedPtr = static_cast<std::byte*>(m_allocator.getAllocationInfo(memory->get_allocation()).pMappedData); mappedPtr != nullptr)
+		{
+			m_hostVisible = true;
+			m_mappedPtr = mappedPtr + offset;
+		}
+		if (m_usageFlags & vk::BufferUsageFlagBits::eShaderDeviceAddress)
+		{
+			m_deviceAddress = m_device.getBufferAddress(vk::BufferDeviceAddressInfo{ m_buffer.get() });
+		}
+		m_aliasedMemory = std::move(memory);
+		return true;
 	}
 
-	void CommandList::begin()
+	auto Buffer::get_buffer_create_info() const -> vk::BufferCreateInfo
 	{
-		if (m_hasBegun)
+		vk::BufferCreateInfo vk_buffer_info{};
+		vk_buffer_info.setUsage(m_usageFlags);
+		vk_buffer_info.setSize(m_size);
+		if (m_sparse)
 		{
-			s_errorCallback("GFX - CommandList has already begun recording!");
-			return;
+			vk_buffer_info.setFlags(vk::BufferCreateFlagBits::eSparseBinding | vk::BufferCreateFlagBits::eSparseResidency);
 		}
-
-		vk::CommandBufferBeginInfo cmd_begin_info{};
-		m_commandBuffer->begin(cmd_begin_info);
-		m_hasBegun = true;
+		vk_buffer_info.setSharingMode(vk::SharingMode::eExclusive);
+		//		vk_buffer_info.setQueueFamilyIndices(); // #TODO: Add later?
+		return vk_buffer_info;
 	}
 
-	void CommandList::end()
+	auto Buffer::replace_buffer(vk::Buffer buffer) -> vk::Buffer
 	{
-		if (!m_hasBegun)
-		{
-			s_errorCallback("GFX - Cannot end() CommandList that has not even begun!");
-			return;
-		}
+		// Released rather than reset, the old buffer may still be in use.
+		const auto retiredBuffer = m_buffer.release();
+		m_buffer.reset(buffer);
+		m_descriptorInfo.setBuffer(buffer);
+		set_debug_name(m_device, buffer, m_debugName);
+		return retiredBuffer;
+	}
 
-		m_commandBuffer->end();
+	auto AccelerationStructure::get_build_flags() const -> vk::BuildAccelerationStructureFlagsKHR
+	{
+		return get_acceleration_structure_build_flags(m_info);
 	}
 
-	void CommandList::begin_render_pass(const std::vector<Texture*>& colorAttachmentTextures, Texture* depthAttachmentTexture, const std::array<float, 4>& clearColor)
+	Texture::Texture(Device& device, const TextureInfo& textureInfo, bool aliased, vk::ExternalMemoryHandleTypeFlags externalHandleTypes)
+		: m_device(&device)
 	{
-		if (!m_hasBegun)
+		m_extent = vk::Extent3D(textureInfo.width, textureInfo.height, textureInfo.depth);
+		m_mipLevels = textureInfo.mipLevels != 0 ? textureInfo.mipLevels : std::bit_width(std::max({ textureInfo.width, textureInfo.height, textureInfo.depth }));
+		m_arrayLayers = textureInfo.type == TextureType::eCube ? textureInfo.arrayLayers * 6 : textureInfo.arrayLayers;
+		m_format = device.get_texture_format(textureInfo);
+		m_uploadFormat = convert_format_to_vk_format(textureInfo.format);
+		m_usageFlags = convert_texture_usage_to_vk_image_usage(textureInfo.usage);
+		if (textureInfo.usage == TextureUsage::eColorAttachment && device.supports_local_read())
 		{
-			return;
+			// Any color attachment may be read by a RenderPassInfo::localRead pass, transient ones included.
+			m_usageFlags |= vk::ImageUsageFlagBits::eInputAttachment;
 		}
-
-		std::vector<vk::RenderingAttachmentInfo> colorAttachments(colorAttachmentTextures.size());
-		for (auto i = 0; i < colorAttachments.size(); ++i)
+		m_type = convert_texture_type_to_vk_image_type(textureInfo.type);
+		m_samples = vk::SampleCountFlagBits(textureInfo.sampleCount);
+		switch (textureInfo.type)
 		{
-			auto* texture = colorAttachmentTextures[i];
-			auto& attachment = colorAttachments[i];
-			attachment.setImageView(texture->get_view());
-			attachment.setImageLayout(vk::ImageLayout::eAttachmentOptimal);
-			attachment.setLoadOp(vk::AttachmentLoadOp::eClear); // #TODO: Optional.
-			attachment.setStoreOp(vk::AttachmentStoreOp::eStore);
-			attachment.setClearValue(vk::ClearColorValue(clearColor));
+			case TextureType::e1D:
+				m_viewType = m_arrayLayers > 1 ? vk::ImageViewType::e1DArray : vk::ImageViewType::e1D;
+				break;
+			case TextureType::e3D:
+				m_viewType = vk::ImageViewType::e3D;
+				break;
+			case TextureType::eCube:
+				m_viewType = m_arrayLayers > 6 ? vk::ImageViewType::eCubeArray : vk::ImageViewType::eCube;
+				m_createFlags = vk::ImageCreateFlagBits::eCubeCompatible;
+				break;
+			case TextureType::e2D:
+			default:
+				m_viewType = m_arrayLayers > 1 ? vk::ImageViewType::e2DArray : vk::ImageViewType::e2D;
+				break;
 		}
-
-		vk::RenderingAttachmentInfo depthAttachment{};
-		if (depthAttachmentTexture != nullptr)
+		if (textureInfo.mutableFormat)
 		{
-			depthAttachment.setImageView(depthAttachmentTexture->get_view());
-			depthAttachment.setImageLayout(vk::ImageLayout::eAttachmentOptimal);
-			depthAttachment.setLoadOp(vk::AttachmentLoadOp::eClear);			// #TODO: Optional.
-			depthAttachment.setStoreOp(vk::AttachmentStoreOp::eDontCare);
-			depthAttachment.setClearValue(vk::ClearDepthStencilValue(1.0f, 0)); // #TODO: Optional.
+			m_createFlags |= vk::ImageCreateFlagBits::eMutableFormat;
 		}
-
-		auto textureExtent = colorAttachmentTextures.front()->get_extent();
-		vk::Rect2D renderArea{ vk::Offset2D{ 0, 0 }, vk::Extent2D{ textureExtent.width, textureExtent.height } };
-
-		vk::RenderingInfo rendering_info{};
-		rendering_info.setLayerCount(1);
-		rendering_info.setColorAttachments(colorAttachments);
-		if (depthAttachmentTexture != nullptr)
+		if (textureInfo.memory == TextureMemory::eTransient)
 		{
-			rendering_info.setPDepthAttachment(&depthAttachment);
+			GFX_ASSERT(textureInfo.usage != TextureUsage::eTexture && textureInfo.usage != TextureUsage::eStorage, "Only attachments can be transient!");
+			m_usageFlags |= vk::ImageUsageFlagBits::eTransientAttachment;
 		}
-		rendering_info.setRenderArea(renderArea);
-
-		m_commandBuffer->beginRendering(rendering_info);
-	}
-
-	void CommandList::end_render_pass()
-	{
-		if (!m_hasBegun)
+		else
 		{
-			return;
+			// Lets any texture be copied out with copy_texture_to_buffer(), and render targets be copied, blitted and resolved into.
+			// Transient attachments may only be attachments.
+			m_usageFlags |= vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+			if (textureInfo.usage == TextureUsage::eColorAttachment || textureInfo.usage == TextureUsage::eDepthStencilAttachment)
+			{
+				// Render targets are usually sampled by a later pass, eg. a render graph read() in TextureState::eShaderRead.
+				m_usageFlags |= vk::ImageUsageFlagBits::eSampled;
+			}
 		}
-
-		m_commandBuffer->endRendering();
-	}
-
-	void CommandList::set_viewport(float x, float y, float width, float height, float minDepth, float maxDepth)
-	{
-		if (!m_hasBegun)
+		if (get_subresource_count() > 1)
 		{
-			return;
+			m_subresourceStates.assign(get_subresource_count(), TextureState::eUndefined);
 		}
+		m_aspectMask = get_format_aspect_mask(m_format);
+		m_debugName = textureInfo.debugName;
 
-		vk::Viewport viewport{ x, y + height, width, -height, minDepth, maxDepth };
-		m_commandBuffer->setViewport(0, viewport);
-	}
+		auto image_info = get_image_create_info();
 
-	void CommandList::set_scissor(std::int32_t x, std::int32_t y, std::uint32_t width, std::uint32_t height)
-	{
-		if (!m_hasBegun)
+		if (textureInfo.sparse)
 		{
+			// No memory is bound up front, bind_sparse_texture_tiles() backs the tiles that are used.
+			image_info.setFlags(vk::ImageCreateFlagBits::eSparseBinding | vk::ImageCreateFlagBits::eSparseResidency);
+			const auto device = m_device->get_device();
+			m_image = device.createImage(image_info).value;
+			set_debug_name(device, m_image, m_debugName);
+			m_sparse = std::make_unique<SparseResidency>(m_device->get_allocator(), device.getImageMemoryRequirements(m_image));
+			m_sparse->imageRequirements = device.getImageSparseMemoryRequirements(m_image);
+			create_view();
 			return;
 		}
-
-		vk::Rect2D scissor{ { x, y }, { width, height } };
-		m_commandBuffer->setScissor(0, scissor);
-	}
-
-	void CommandList::bind_pipeline(Pipeline* pipeline)
-	{
-		if (pipeline == nullptr)
+		if (aliased)
 		{
-			s_errorCallback("GFX - Command list cannot bind null pipeline!");
+			// Views need bound memory, so they are created by bind_aliased_memory().
+			const vk::ExternalMemoryImageCreateInfo external_info{ externalHandleTypes };
+			if (externalHandleTypes)
+			{
+				image_info.setPNext(&external_info);
+			}
+			m_image = m_device->get_device().createImage(image_info).value;
+			set_debug_name(m_device->get_device(), m_image, m_debugName);
+			m_aliased = true;
 			return;
 		}
 
-		const vk::PipelineBindPoint bindPoint = pipeline->get_type() == PipelineType::eCompute ? vk::PipelineBindPoint::eCompute : vk::PipelineBindPoint::eGraphics;
-		m_commandBuffer->bindPipeline(bindPoint, pipeline->get_pipeline());
-
-		m_boundPipeline = pipeline;
-	}
+		// Sampled textures the host can write without slowing the GPU down are uploaded without staging buffers.
+		if ((m_usageFlags & vk::ImageUsageFlagBits::eSampled) && m_device->supports_host_image_copy())
+		{
+			auto host_image_info = image_info;
+			host_image_info.setUsage(image_info.usage | vk::ImageUsageFlagBits::eHostTransferEXT);
+			if (m_device->is_host_image_copy_optimal(host_image_info))
+			{
+				m_usageFlags = host_image_info.usage;
+				image_info = host_image_info;
+			}
+		}
 
-	void CommandList::bind_descriptor_sets(std::uint32_t firstSet, const std::vector<vk::DescriptorSet>& descriptorSets)
-	{
-		if (!m_hasBegun)
+		vma::AllocationCreateInfo alloc_info{};
+		switch (textureInfo.memory)
 		{
-			return;
+			case TextureMemory::eTransient:
+				// Desktop GPUs have no lazily allocated memory, the attachment still skips its store.
+				alloc_info.setUsage(m_device->supports_lazily_allocated_memory() ? vma::MemoryUsage::eGpuLazilyAllocated : vma::MemoryUsage::eAutoPreferDevice);
+				break;
+			case TextureMemory::eHostVisible:
+			case TextureMemory::eDeviceLocal:
+			default:
+				alloc_info.setUsage(vma::MemoryUsage::eAutoPreferDevice);
+				break;
 		}
-		if (m_boundPipeline == nullptr)
+		const bool isAttachment = textureInfo.usage == TextureUsage::eColorAttachment || textureInfo.usage == TextureUsage::eDepthStencilAttachment;
+		auto memoryPriority = std::clamp(textureInfo.memoryPriority, 0.0f, 1.0f);
+		if (textureInfo.dedicatedAllocation == DedicatedAllocation::eAlways ||
+			(textureInfo.dedicatedAllocation == DedicatedAllocation::eAuto && isAttachment && std::uint64_t(textureInfo.width) * textureInfo.height >= DEDICATED_ATTACHMENT_TEXELS))
 		{
-			s_errorCallback("GFX - Cannot bind descriptor set when no pipeline has been bound!");
-			return;
+			alloc_info.setFlags(vma::AllocationCreateFlagBits::eDedicatedMemory);
+			if (isAttachment && memoryPriority == DEFAULT_MEMORY_PRIORITY)
+			{
+				// Paging a render target out would stall every frame that draws to it.
+				memoryPriority = 1.0f;
+			}
+		}
+		if (m_device->supports_memory_priority() && memoryPriority != DEFAULT_MEMORY_PRIORITY)
+		{
+			// Blocks shared with other resources keep the default, only an allocation of its own carries a priority.
+			alloc_info.setFlags(alloc_info.flags | vma::AllocationCreateFlagBits::eDedicatedMemory);
+			alloc_info.setPriority(memoryPriority);
 		}
 
-		const vk::PipelineBindPoint bindPoint = m_boundPipeline->get_type() == PipelineType::eCompute ? vk::PipelineBindPoint::eCompute : vk::PipelineBindPoint::eGraphics;
-		const auto pipelineLayout = m_boundPipeline->get_pipeline_layout();
-		m_commandBuffer->bindDescriptorSets(bindPoint, pipelineLayout, firstSet, descriptorSets, {});
+		auto allocator = m_device->get_allocator();
+		std::tie(m_image, m_allocation) = allocator.createImage(image_info, alloc_info).value;
+		m_dedicatedMemory = bool(alloc_info.flags & vma::AllocationCreateFlagBits::eDedicatedMemory);
+		set_debug_name(m_device->get_device(), m_image, m_debugName);
+
+		create_view();
 	}
 
-	void CommandList::set_constants(vk::ShaderStageFlags shaderStages, std::uint32_t offset, std::uint32_t size, const void* data)
+	Texture::Texture(Device& device, vk::Image image, vk::Extent3D extent, vk::Format format)
+		: m_image(image), m_extent(extent), m_format(format), m_aspectMask(get_format_aspect_mask(format)), m_swapChainImage(true), m_device(&device), m_uploadFormat(format)
 	{
-		if (!m_hasBegun)
+		if (get_subresource_count() > 1)
 		{
-			return;
+			m_subresourceStates.assign(get_subresource_count(), TextureState::eUndefined);
 		}
 
-		const auto pipelineLayout = m_boundPipeline->get_pipeline_layout();
-		m_commandBuffer->pushConstants(pipelineLayout, shaderStages, offset, size, data);
+		create_view();
 	}
 
-	void CommandList::dispatch(std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ)
+	Texture::Texture(Texture&& other) noexcept
 	{
-		if (!m_hasBegun)
-		{
-			return;
-		}
-
-		m_commandBuffer->dispatch(groupCountX, groupCountY, groupCountZ);
+		std::swap(m_device, other.m_device);
+		std::swap(m_image, other.m_image);
+		std::swap(m_allocation, other.m_allocation);
+		std::swap(m_extent, other.m_extent);
+		std::swap(m_mipLevels, other.m_mipLevels);
+		std::swap(m_arrayLayers, other.m_arrayLayers);
+		std::swap(m_format, other.m_format);
+		std::swap(m_uploadFormat, other.m_uploadFormat);
+		std::swap(m_aspectMask, other.m_aspectMask);
+		std::swap(m_usageFlags, other.m_usageFlags);
+		std::swap(m_type, other.m_type);
+		std::swap(m_viewType, other.m_viewType);
+		std::swap(m_createFlags, other.m_createFlags);
+		std::swap(m_samples, other.m_samples);
+		std::swap(m_state, other.m_state);
+		std::swap(m_swapChainImage, other.m_swapChainImage);
+		std::swap(m_subresourceStates, other.m_subresourceStates);
+		std::swap(m_view, other.m_view);
+		std::swap(m_defaultView, other.m_defaultView);
+		std::swap(m_customViews, other.m_customViews);
+		std::swap(m_sparse, other.m_sparse);
+		std::swap(m_dedicatedMemory, other.m_dedicatedMemory);
+		std::swap(m_aliased, other.m_aliased);
+		std::swap(m_aliasedMemory, other.m_aliasedMemory);
+		std::swap(m_debugName, other.m_debugName);
 	}
 
-	void CommandList::bind_index_buffer(Buffer* buffer, vk::IndexType indexType)
+	Texture::~Texture()
 	{
-		if (!m_hasBegun)
+		if (m_sparse || m_aliased)
 		{
+			// Destroyed before m_sparse or m_aliasedMemory frees the memory bound to it.
+			m_device->get_device().destroyImage(m_image);
 			return;
 		}
 
-		m_commandBuffer->bindIndexBuffer(buffer->get_buffer(), 0, indexType);
+		const bool was_allocated = m_image && m_allocation;
+		if (was_allocated)
+		{
+			auto allocator = m_device->get_allocator();
+			allocator.destroyImage(m_image, m_allocation);
+		}
 	}
 
-	void CommandList::bind_vertex_buffer(std::uint32_t firstBinding, const std::vector<vk::Buffer>& buffers)
+	auto Texture::get_image_create_info() const -> vk::ImageCreateInfo
 	{
-		if (!m_hasBegun)
+		vk::ImageCreateInfo image_info{};
+		image_info.setExtent(m_extent);
+		image_info.setMipLevels(m_mipLevels);
+		image_info.setFormat(m_format);
+		image_info.setUsage(m_usageFlags);
+		image_info.setImageType(m_type);
+		image_info.setArrayLayers(m_arrayLayers);
+		image_info.setTiling(vk::ImageTiling::eOptimal);
+		image_info.setSamples(m_samples);
+		image_info.setFlags(m_createFlags);
+		if (m_sparse)
 		{
-			return;
+			image_info.setFlags(m_createFlags | vk::ImageCreateFlagBits::eSparseBinding | vk::ImageCreateFlagBits::eSparseResidency);
 		}
+		return image_info;
+	}
 
-		const std::vector<vk::DeviceSize> offsets(buffers.size(), 0);
-		m_commandBuffer->bindVertexBuffers(firstBinding, buffers, offsets);
+	auto Texture::get_mip_extent(std::uint32_t mipLevel) const -> vk::Extent3D
+	{
+		return { std::max(m_extent.width >> mipLevel, 1u), std::max(m_extent.height >> mipLevel, 1u), std::max(m_extent.depth >> mipLevel, 1u) };
 	}
 
-	void CommandList::draw(std::uint32_t vertex_count, std::uint32_t instance_count, std::uint32_t first_vertex, std::uint32_t first_instance)
+	auto Texture::get_level_size(std::uint32_t mipLevel) const -> std::uint64_t
 	{
-		if (!m_hasBegun)
-		{
-			return;
-		}
+		const auto extent = get_mip_extent(mipLevel);
+		return get_texture_level_size(m_format, extent.width, extent.height) * extent.depth * m_arrayLayers;
+	}
 
-		m_commandBuffer->draw(vertex_count, instance_count, first_vertex, first_instance);
+	auto Texture::get_upload_level_size(std::uint32_t mipLevel) const -> std::uint64_t
+	{
+		const auto extent = get_mip_extent(mipLevel);
+		return get_texture_level_size(m_uploadFormat, extent.width, extent.height) * extent.depth * m_arrayLayers;
 	}
 
-	void CommandList::draw_indexed(std::uint32_t index_count, std::uint32_t instance_count, std::uint32_t first_index, std::int32_t vertex_offset, std::uint32_t first_instance)
+	auto Texture::replace_image(vk::Image image) -> std::pair<vk::Image, std::vector<vk::UniqueImageView>>
 	{
-		if (!m_hasBegun)
+		auto retired = std::make_pair(m_image, std::vector<vk::UniqueImageView>{});
+		retired.second.push_back(std::move(m_view));
+		m_image = image;
+		set_debug_name(m_device->get_device(), m_image, m_debugName);
+		create_view();
+		for (auto& customView : m_customViews)
 		{
-			return;
+			retired.second.push_back(std::move(customView.view));
+			customView.view = make_view(customView.viewType, customView.format, customView.range);
 		}
-
-		m_commandBuffer->drawIndexed(index_count, instance_count, first_index, vertex_offset, first_instance);
+		return retired;
 	}
 
-	void CommandList::transition_texture(Texture* texture, TextureState oldState, TextureState newState)
+	bool Texture::bind_aliased_memory(std::shared_ptr<AliasedMemory> memory, vk::DeviceSize offset)
 	{
-		if (!m_hasBegun)
+		GFX_ASSERT(m_aliased && !m_aliasedMemory, "Only unbound aliased textures can be bound to aliased memory!");
+		const auto result = memory->get_allocation()
+								? vk::Result(vmaBindImageMemory2(static_cast<VmaAllocator>(m_device->get_allocator()), static_cast<VmaAllocation>(memory->get_allocation()), offset, m_image, nullptr))
+								: m_device->get_device().bindImageMemory(m_image, memory->get_device_memory(), offset);
+		if (result != vk::Result::eSuccess)
 		{
-			return;
+			return false;
 		}
-
-		GFX_ASSERT(s_textureStateImageLayoutMap.contains(oldState) && s_textureStateImageLayoutMap.contains(newState), "Unable to convert TextureState to vk::ImageLayout for barrier!");
-		GFX_ASSERT(s_barrierTextureStatePipelineStageMaskMap.contains(oldState) && s_barrierTextureStatePipelineStageMaskMap.contains(newState), "Unable to convert TextureState to vk::PipelineStage for barrier!");
-		GFX_ASSERT(s_barrierTextureStateAccessMaskMap.contains(oldState) && s_barrierTextureStateAccessMaskMap.contains(newState), "Unable to convert TextureState to vk::Access for barrier!");
-
-		vk::ImageSubresourceRange range{};
-		range.setAspectMask(vk::ImageAspectFlagBits::eColor); // #TODO: Get from texture.
-		range.setBaseArrayLayer(0);							  // #TODO: Optional.
-		range.setLayerCount(1);								  // #TODO: Optional.
-		range.setBaseMipLevel(0);							  // #TODO: Optional.
-		range.setLevelCount(1);								  // #TODO: Optional.
-
-		auto srcLayout = s_textureStateImageLayoutMap.at(oldState);
-		auto dstLayout = s_textureStateImageLayoutMap.at(newState);
-
-		auto srcStage = s_barrierTextureStatePipelineStageMaskMap.at(oldState);
-		auto dstStage = s_barrierTextureStatePipelineStageMaskMap.at(newState);
-
-		auto srcAccess = s_barrierTextureStateAccessMaskMap.at(oldState);
-		auto dstAccess = s_barrierTextureStateAccessMaskMap.at(newState);
-
-		vk::ImageMemoryBarrier2 barrier{};
-		barrier.setImage(texture->get_image());
-		barrier.setOldLayout(srcLayout);
-		barrier.setNewLayout(dstLayout);
-		barrier.setSrcStageMask(srcStage);
-		barrier.setDstStageMask(dstStage);
-		barrier.setSrcAccessMask(srcAccess);
-		barrier.setDstAccessMask(dstAccess);
-		barrier.setSubresourceRange(range);
-
-		vk::DependencyInfo dependency_info{};
-		dependency_info.setImageMemoryBarriers(barrier);
-
-		m_commandBuffer->pipelineBarrier2(dependency_info);
+		m_aliasedMemory = std::move(memory);
+		create_view();
+		return true;
 	}
 
-	void CommandList::copy_buffer_to_texture(Buffer* buffer, Texture* texture)
+	auto Texture::get_view(std::uint32_t viewIndex) const -> vk::ImageView
 	{
-		if (!m_hasBegun)
+		if (viewIndex == 0)
 		{
-			return;
+			return m_defaultView;
 		}
-
-		vk::BufferImageCopy2 region{};
-		region.setImageExtent(texture->get_extent());
-		region.setImageOffset({});
-		region.imageSubresource.setAspectMask(vk::ImageAspectFlagBits::eColor);
-		region.imageSubresource.setBaseArrayLayer(0);
-		region.imageSubresource.setLayerCount(1);
-		region.imageSubresource.setMipLevel(0);
-
-		vk::CopyBufferToImageInfo2 copy_info{};
-		copy_info.setSrcBuffer(buffer->get_buffer());
-		copy_info.setDstImage(texture->get_image());
-		copy_info.setDstImageLayout(vk::ImageLayout::eTransferDstOptimal);
-		copy_info.setRegions(region);
-		m_commandBuffer->copyBufferToImage2(copy_info);
+		return viewIndex <= m_customViews.size() ? m_customViews[viewIndex - 1].view.get() : vk::ImageView{};
 	}
 
-	auto CommandList::operator=(CommandList&& rhs) noexcept -> CommandList&
+	auto Texture::get_view_format(std::uint32_t viewIndex) const -> vk::Format
 	{
-		std::swap(m_device, rhs.m_device);
-		std::swap(m_commandPool, rhs.m_commandPool);
-		std::swap(m_queue, rhs.m_queue);
-		std::swap(m_commandBuffer, rhs.m_commandBuffer);
-		std::swap(m_hasBegun, rhs.m_hasBegun);
-		return *this;
+		GFX_ASSERT(viewIndex < get_view_count(), "Texture view is out of range!");
+		return viewIndex == 0 ? m_format : m_customViews[viewIndex - 1].format;
 	}
 
-	Buffer::Buffer(vk::Device device, vma::Allocator allocator, const BufferInfo& bufferInfo)
-		: m_device(device), m_allocator(allocator)
+	auto Texture::get_view_range(std::uint32_t viewIndex) const -> vk::ImageSubresourceRange
 	{
-		vk::BufferCreateInfo vk_buffer_info{};
-		vk_buffer_info.setUsage(convert_buffer_type_to_vk_usage(bufferInfo.type));
-		vk_buffer_info.setSize(bufferInfo.size);
-		vk_buffer_info.setSharingMode(vk::SharingMode::eExclusive);
-		//		vk_buffer_info.setQueueFamilyIndices(); // #TODO: Add later?
-
-		vma::AllocationCreateInfo alloc_info{};
-		alloc_info.setUsage(vma::MemoryUsage::eAutoPreferDevice);						// #TODO: Make optional.
-		alloc_info.setFlags(vma::AllocationCreateFlagBits::eHostAccessSequentialWrite); // #TODO: Optional.
-
-		std::tie(m_buffer, m_allocation) = m_allocator.createBufferUnique(vk_buffer_info, alloc_info).value;
+		GFX_ASSERT(viewIndex < get_view_count(), "Texture view is out of range!");
+		return viewIndex == 0 ? get_default_view_range() : m_customViews[viewIndex - 1].range;
+	}
 
-		m_descriptorType = convert_buffer_type_to_descriptor_type(bufferInfo.type);
+	auto Texture::find_or_add_view(vk::ImageViewType viewType, vk::Format format, const vk::ImageSubresourceRange& range) -> std::uint32_t
+	{
+		const auto it = std::find_if(m_customViews.begin(), m_customViews.end(), [&](const CustomView& customView) {
+			return customView.viewType == viewType && customView.format == format && customView.range == range;
+		});
+		if (it != m_customViews.end())
+		{
+			return 1 + std::uint32_t(std::distance(m_customViews.begin(), it));
+		}
 
-		m_descriptorInfo.setBuffer(m_buffer.get());
-		m_descriptorInfo.setOffset(0);
-		m_descriptorInfo.setRange(bufferInfo.size);
+		m_customViews.push_back({ viewType, format, range, make_view(viewType, format, range) });
+		return std::uint32_t(m_customViews.size());
 	}
 
-	Buffer::Buffer(Buffer&& other) noexcept
+	void Texture::copy_views(const Texture& other)
 	{
-		std::swap(m_device, other.m_device);
-		std::swap(m_allocation, other.m_allocation);
-		std::swap(m_buffer, other.m_buffer);
-		std::swap(m_allocation, other.m_allocation);
-		std::swap(m_descriptorType, other.m_descriptorType);
-		std::swap(m_descriptorInfo, other.m_descriptorInfo);
+		m_customViews.clear();
+		for (const auto& otherView : other.m_customViews)
+		{
+			auto range = otherView.range;
+			range.setBaseMipLevel(std::min(range.baseMipLevel, m_mipLevels - 1));
+			range.setLevelCount(std::min(range.levelCount, m_mipLevels - range.baseMipLevel));
+			m_customViews.push_back({ otherView.viewType, otherView.format, range, make_view(otherView.viewType, otherView.format, range) });
+		}
 	}
 
-	auto Buffer::operator=(Buffer&& rhs) noexcept -> Buffer&
+	void Texture::create_view()
 	{
-		std::swap(m_device, rhs.m_device);
-		std::swap(m_allocation, rhs.m_allocation);
-		std::swap(m_buffer, rhs.m_buffer);
-		std::swap(m_allocation, rhs.m_allocation);
-		std::swap(m_descriptorType, rhs.m_descriptorType);
-		std::swap(m_descriptorInfo, rhs.m_descriptorInfo);
-		return *this;
+		// Sampled views cover every mip level and layer. Attachment views must be a single level, and rendering only targets
+		// the first level and layer unless the render pass picks another view.
+		const auto isAttachment = bool(m_usageFlags & (vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment));
+		m_view = make_view(isAttachment ? vk::ImageViewType::e2D : m_viewType, m_format, get_default_view_range());
+		m_defaultView = m_view.get();
 	}
 
-	Texture::Texture(Device& device, const TextureInfo& textureInfo)
-		: m_device(&device)
+	auto Texture::get_default_view_range() const -> vk::ImageSubresourceRange
 	{
-		m_extent = vk::Extent3D(textureInfo.width, textureInfo.height, 1);
-		m_mipLevels = textureInfo.mipLevels;
-		m_format = convert_format_to_vk_format(textureInfo.format);
-		m_usageFlags = convert_texture_usage_to_vk_image_usage(textureInfo.usage);
-		m_type = convert_texture_type_to_vk_image_type(textureInfo.type);
-
-		vk::ImageCreateInfo image_info{};
-		image_info.setExtent(m_extent);
-		image_info.setMipLevels(m_mipLevels);
-		image_info.setFormat(m_format);
-		image_info.setUsage(m_usageFlags);
-		image_info.setImageType(m_type);
-		image_info.setArrayLayers(1);						// #TODO: Optional.
-		image_info.setTiling(vk::ImageTiling::eOptimal);
-		image_info.setSamples(vk::SampleCountFlagBits::e1); // #TODO: Optional.
-
-		vma::AllocationCreateInfo alloc_info{};
-		alloc_info.setUsage(vma::MemoryUsage::eAutoPreferHost); // #TODO: Make optional.
-		//		alloc_info.setFlags(vma::AllocationCreateFlagBits::eHostAccessSequentialWrite); // #TODO: Optional.
-
-		auto allocator = m_device->get_allocator();
-		std::tie(m_image, m_allocation) = allocator.createImage(image_info, alloc_info).value;
-
-		vk::ImageViewCreateInfo view_info{};
-		view_info.setImage(m_image);
-		view_info.setFormat(m_format);
-		view_info.setViewType(vk::ImageViewType::e2D);
-		if (textureInfo.usage == TextureUsage::eDepthStencilAttachment)
-		{
-			view_info.subresourceRange.setAspectMask(vk::ImageAspectFlagBits::eDepth);
-		}
-		else
-		{
-			view_info.subresourceRange.setAspectMask(vk::ImageAspectFlagBits::eColor);
-		}
-		view_info.subresourceRange.setBaseMipLevel(0);
-		view_info.subresourceRange.setLevelCount(1);
-		view_info.subresourceRange.setBaseArrayLayer(0);
-		view_info.subresourceRange.setLayerCount(1);
-		m_view = m_device->get_device().createImageViewUnique(view_info).value;
+		// Attachments keep every aspect, sampled views a single one.
+		const auto isAttachment = bool(m_usageFlags & (vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment));
+		return { isAttachment ? m_aspectMask : get_copy_aspect_mask(), 0, isAttachment ? 1 : m_mipLevels, 0, isAttachment ? 1 : m_arrayLayers };
 	}
 
-	Texture::Texture(Device& device, vk::Image image, vk::Extent3D extent, vk::Format format)
-		: m_device(&device), m_image(image), m_extent(extent), m_format(format)
+	auto Texture::make_view(vk::ImageViewType viewType, vk::Format format, const vk::ImageSubresourceRange& range) const -> vk::UniqueImageView
 	{
 		vk::ImageViewCreateInfo view_info{};
 		view_info.setImage(m_image);
-		view_info.setFormat(m_format);
-		view_info.setViewType(vk::ImageViewType::e2D);
-		view_info.subresourceRange.setAspectMask(vk::ImageAspectFlagBits::eColor);
-		view_info.subresourceRange.setBaseMipLevel(0);
-		view_info.subresourceRange.setLevelCount(1);
-		view_info.subresourceRange.setBaseArrayLayer(0);
-		view_info.subresourceRange.setLayerCount(1);
-		m_view = m_device->get_device().createImageViewUnique(view_info).value;
+		view_info.setViewType(viewType);
+		view_info.setFormat(format);
+		view_info.setSubresourceRange(range);
+		return m_device->get_device().createImageViewUnique(view_info).value;
 	}
 
-	Texture::Texture(Texture&& other) noexcept
+	auto Texture::get_state(std::uint32_t mipLevel, std::uint32_t arrayLayer) const -> TextureState
 	{
-		std::swap(m_device, other.m_device);
-		std::swap(m_image, other.m_image);
-		std::swap(m_allocation, other.m_allocation);
-		std::swap(m_extent, other.m_extent);
-		std::swap(m_mipLevels, other.m_mipLevels);
-		std::swap(m_format, other.m_format);
-		std::swap(m_usageFlags, other.m_usageFlags);
-		std::swap(m_type, other.m_type);
-		std::swap(m_layout, other.m_layout);
+		GFX_ASSERT(mipLevel < m_mipLevels && arrayLayer < m_arrayLayers, "Texture subresource is out of range!");
+		if (m_subresourceStates.empty())
+		{
+			return m_state;
+		}
+		return m_subresourceStates[arrayLayer * m_mipLevels + mipLevel];
 	}
 
-	Texture::~Texture()
+	void Texture::set_state(TextureState state, std::uint32_t baseMipLevel, std::uint32_t mipLevelCount, std::uint32_t baseArrayLayer, std::uint32_t arrayLayerCount)
 	{
-		const bool was_allocated = m_image && m_allocation;
-		if (was_allocated)
+		GFX_ASSERT(baseMipLevel + mipLevelCount <= m_mipLevels && baseArrayLayer + arrayLayerCount <= m_arrayLayers, "Texture subresource is out of range!");
+		if (m_subresourceStates.empty())
 		{
-			auto allocator = m_device->get_allocator();
-			allocator.destroyImage(m_image, m_allocation);
+			m_state = state;
+			return;
+		}
+
+		for (auto layer = baseArrayLayer; layer < baseArrayLayer + arrayLayerCount; ++layer)
+		{
+			auto* layerStates = &m_subresourceStates[layer * m_mipLevels];
+			std::fill(layerStates + baseMipLevel, layerStates + baseMipLevel + mipLevelCount, state);
 		}
 	}
 
@@ -2189,186 +19781,326 @@ namespace sm::gfx
 		std::swap(m_allocation, rhs.m_allocation);
 		std::swap(m_extent, rhs.m_extent);
 		std::swap(m_mipLevels, rhs.m_mipLevels);
+		std::swap(m_arrayLayers, rhs.m_arrayLayers);
 		std::swap(m_format, rhs.m_format);
+		std::swap(m_uploadFormat, rhs.m_uploadFormat);
+		std::swap(m_aspectMask, rhs.m_aspectMask);
 		std::swap(m_usageFlags, rhs.m_usageFlags);
 		std::swap(m_type, rhs.m_type);
-		std::swap(m_layout, rhs.m_layout);
+		std::swap(m_viewType, rhs.m_viewType);
+		std::swap(m_createFlags, rhs.m_createFlags);
+		std::swap(m_samples, rhs.m_samples);
+		std::swap(m_state, rhs.m_state);
+		std::swap(m_swapChainImage, rhs.m_swapChainImage);
+		std::swap(m_subresourceStates, rhs.m_subresourceStates);
+		std::swap(m_view, rhs.m_view);
+		std::swap(m_defaultView, rhs.m_defaultView);
+		std::swap(m_customViews, rhs.m_customViews);
+		std::swap(m_sparse, rhs.m_sparse);
+		std::swap(m_dedicatedMemory, rhs.m_dedicatedMemory);
+		std::swap(m_aliased, rhs.m_aliased);
+		std::swap(m_aliasedMemory, rhs.m_aliasedMemory);
+		std::swap(m_debugName, rhs.m_debugName);
 		return *this;
 	}
 
-	Pipeline::Pipeline(PipelineType pipelineType, const std::vector<vk::DescriptorSetLayout>& setLayouts)
-		: m_pipelineType(pipelineType), m_setLayouts(setLayouts)
+	Pipeline::Pipeline(PipelineType pipelineType, const std::vector<vk::DescriptorSetLayout>& setLayouts, vk::PipelineLayout layout)
+		: m_layout(layout), m_pipelineType(pipelineType), m_setLayouts(setLayouts)
 	{
 	}
 
 	Pipeline::Pipeline(Pipeline&& other) noexcept
 	{
+		std::swap(m_layout, other.m_layout);
 		std::swap(m_pipelineType, other.m_pipelineType);
 		std::swap(m_pipeline, other.m_pipeline);
+		std::swap(m_setLayouts, other.m_setLayouts);
+		m_ready.store(other.is_ready(), std::memory_order_relaxed);
+		std::swap(m_placeholderHandle, other.m_placeholderHandle);
+		std::swap(m_optimizedPipeline, other.m_optimizedPipeline);
+		m_optimized.store(other.m_optimized.load(std::memory_order_acquire), std::memory_order_relaxed);
+		m_optimizing.store(other.m_optimizing.load(std::memory_order_acquire), std::memory_order_relaxed);
 	}
 
 	auto Pipeline::operator=(Pipeline&& rhs) noexcept -> Pipeline&
 	{
+		std::swap(m_layout, rhs.m_layout);
 		std::swap(m_pipelineType, rhs.m_pipelineType);
 		std::swap(m_pipeline, rhs.m_pipeline);
+		std::swap(m_setLayouts, rhs.m_setLayouts);
+		m_ready.store(rhs.is_ready(), std::memory_order_relaxed);
+		std::swap(m_placeholderHandle, rhs.m_placeholderHandle);
+		std::swap(m_optimizedPipeline, rhs.m_optimizedPipeline);
+		m_optimized.store(rhs.m_optimized.load(std::memory_order_acquire), std::memory_order_relaxed);
+		m_optimizing.store(rhs.m_optimizing.load(std::memory_order_acquire), std::memory_order_relaxed);
 		return *this;
 	}
 
-	ComputePipeline::ComputePipeline(vk::Device device, const std::vector<char>& shaderCode, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, vk::PushConstantRange constantRange)
-		: Pipeline(PipelineType::eCompute, descriptorSetLayouts)
+	void Pipeline::set_pending(PipelineHandle placeholderHandle)
 	{
-		vk::PipelineLayoutCreateInfo pipeline_layout_info{};
-		pipeline_layout_info.setSetLayouts(get_set_layouts());
-		if (constantRange.size > 0 && constantRange.stageFlags != vk::ShaderStageFlags())
+		m_placeholderHandle = placeholderHandle;
+		m_ready.store(false, std::memory_order_relaxed);
+	}
+
+	void Pipeline::complete(Pipeline&& compiled)
+	{
+		GFX_ASSERT(!is_ready(), "Pipeline was not pending!");
+		m_pipeline = std::move(compiled.m_pipeline);
+		m_ready.store(true, std::memory_order_release);
+		m_ready.notify_all();
+	}
+
+	void Pipeline::complete_optimization(Pipeline&& optimized)
+	{
+		// A failed optimised link leaves the fast-linked pipeline bound, which is still correct.
+		if (optimized.m_pipeline)
 		{
-			pipeline_layout_info.setPushConstantRanges(constantRange);
+			m_optimizedPipeline = std::move(optimized.m_pipeline);
+			m_optimized.store(true, std::memory_order_release);
 		}
-		m_layout = device.createPipelineLayoutUnique(pipeline_layout_info).value;
+		m_optimizing.store(false, std::memory_order_release);
+		m_optimizing.notify_all();
+	}
 
-		vk::ShaderModuleCreateInfo module_info{};
-		module_info.setCodeSize(shaderCode.size());
-		module_info.setPCode(reinterpret_cast<const std::uint32_t*>(shaderCode.data()));
-		auto module = device.createShaderModuleUnique(module_info).value;
+	ComputePipeline::ComputePipeline(vk::Device device, const ComputePipelineInfo& computePipelineInfo, vk::ShaderModule shaderModule,
+									 const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, vk::PipelineLayout layout, vk::PipelineCache pipelineCache, vk::PipelineCreateFlags flags)
+		: Pipeline(PipelineType::eCompute, descriptorSetLayouts, layout)
+	{
+		const ScratchScope scratchScope{};
+		ScratchVector<vk::SpecializationMapEntry> specialization_entries{};
+		const auto specialization_info = get_vk_specialization_info(computePipelineInfo.specializationConstants, specialization_entries);
 
 		vk::PipelineShaderStageCreateInfo stage_info{};
 		stage_info.setStage(vk::ShaderStageFlagBits::eCompute);
-		stage_info.setModule(module.get());
-		stage_info.setPName("Main");
+		stage_info.setModule(shaderModule);
+		stage_info.setPName(computePipelineInfo.entryPoint.c_str());
+		stage_info.setPSpecializationInfo(&specialization_info);
+
+		const vk::PipelineShaderStageRequiredSubgroupSizeCreateInfo required_subgroup_size_info{ computePipelineInfo.requiredSubgroupSize };
+		if (computePipelineInfo.requiredSubgroupSize != 0)
+		{
+			stage_info.setPNext(&required_subgroup_size_info);
+		}
+		if (computePipelineInfo.requireFullSubgroups)
+		{
+			stage_info.setFlags(vk::PipelineShaderStageCreateFlagBits::eRequireFullSubgroups);
+		}
 
 		vk::ComputePipelineCreateInfo vk_pipeline_info{};
+		vk_pipeline_info.setFlags(flags | vk::PipelineCreateFlagBits::eDispatchBase); // Any compute pipeline can be used with dispatch_base().
 		vk_pipeline_info.setStage(stage_info);
-		vk_pipeline_info.setLayout(m_layout.get());
+		vk_pipeline_info.setLayout(m_layout);
 
-		m_pipeline = device.createComputePipelineUnique({}, vk_pipeline_info).value;
+		m_pipeline = device.createComputePipelineUnique(pipelineCache, vk_pipeline_info).value;
 	}
 
-	GraphicsPipeline::GraphicsPipeline(vk::Device device, const GraphicsPipelineInfo& graphicsPipelineInfo, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, vk::PushConstantRange constantRange)
-		: Pipeline(PipelineType::eGraphics, descriptorSetLayouts)
+	GraphicsPipeline::GraphicsPipeline(vk::Device device, const GraphicsPipelineInfo& graphicsPipelineInfo, vk::ShaderModule vertexModule, vk::ShaderModule fragmentModule,
+									   const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, vk::PipelineLayout layout, vk::PipelineCache pipelineCache, vk::PipelineCreateFlags flags,
+									   vk::GraphicsPipelineLibraryFlagsEXT libraryParts)
+		: Pipeline(PipelineType::eGraphics, descriptorSetLayouts, layout)
 	{
-		vk::PipelineLayoutCreateInfo pipeline_layout_info{};
-		pipeline_layout_info.setSetLayouts(get_set_layouts());
-		if (constantRange.size > 0 && constantRange.stageFlags != vk::ShaderStageFlags())
-		{
-			pipeline_layout_info.setPushConstantRanges(constantRange);
-		}
-		m_layout = device.createPipelineLayoutUnique(pipeline_layout_info).value;
-
-		vk::ShaderModuleCreateInfo vertex_module_info{};
-		vertex_module_info.setCodeSize(graphicsPipelineInfo.vertexCode.size() * sizeof(uint32_t));
-		vertex_module_info.setPCode(graphicsPipelineInfo.vertexCode.data());
-		auto vertex_module = device.createShaderModuleUnique(vertex_module_info).value;
+		const ScratchScope scratchScope{};
+		ScratchVector<vk::SpecializationMapEntry> vertex_specialization_entries{};
+		const auto vertex_specialization_info = get_vk_specialization_info(graphicsPipelineInfo.vertexSpecializationConstants, vertex_specialization_entries);
 		vk::PipelineShaderStageCreateInfo vertex_stage_info{};
 		vertex_stage_info.setStage(vk::ShaderStageFlagBits::eVertex);
-		vertex_stage_info.setModule(vertex_module.get());
+		vertex_stage_info.setModule(vertexModule);
 		vertex_stage_info.setPName("main");
+		vertex_stage_info.setPSpecializationInfo(&vertex_specialization_info);
 
-		vk::ShaderModuleCreateInfo fragment_module_info{};
-		fragment_module_info.setCodeSize(graphicsPipelineInfo.fragmentCode.size() * sizeof(std::uint32_t));
-		fragment_module_info.setPCode(graphicsPipelineInfo.fragmentCode.data());
-		auto fragment_module = device.createShaderModuleUnique(fragment_module_info).value;
+		ScratchVector<vk::SpecializationMapEntry> fragment_specialization_entries{};
+		const auto fragment_specialization_info = get_vk_specialization_info(graphicsPipelineInfo.fragmentSpecializationConstants, fragment_specialization_entries);
 		vk::PipelineShaderStageCreateInfo fragment_stage_info{};
 		fragment_stage_info.setStage(vk::ShaderStageFlagBits::eFragment);
-		fragment_stage_info.setModule(fragment_module.get());
+		fragment_stage_info.setModule(fragmentModule);
 		fragment_stage_info.setPName("main");
+		fragment_stage_info.setPSpecializationInfo(&fragment_specialization_info);
 
-		const std::vector stages = { vertex_stage_info, fragment_stage_info };
+		// A library only has the stages of its parts.
+		ScratchVector<vk::PipelineShaderStageCreateInfo> stages{};
+		if (!libraryParts || (libraryParts & vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders))
+		{
+			stages.push_back(vertex_stage_info);
+		}
+		if (fragmentModule && (!libraryParts || (libraryParts & vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader)))
+		{
+			stages.push_back(fragment_stage_info);
+		}
 
-		std::vector<vk::VertexInputBindingDescription> vk_bindings{};
-		std::vector<vk::VertexInputAttributeDescription> vk_attributes{};
+		ScratchVector<vk::VertexInputBindingDescription> vk_bindings{};
+		ScratchVector<vk::VertexInputAttributeDescription> vk_attributes{};
+		ScratchVector<vk::VertexInputBindingDivisorDescriptionEXT> vk_divisors{};
+		ScratchVector<std::uint32_t> offsets{};
 		for (auto i = 0; i < graphicsPipelineInfo.vertexInputBindings.size(); ++i)
 		{
 			const auto& binding = graphicsPipelineInfo.vertexInputBindings.at(i);
 
-			std::uint32_t stride{ 0 };
-			for (const auto& attribute : binding.attributes)
+			const auto stride = get_vertex_binding_layout(binding, offsets);
+			for (auto j = 0; j < binding.attributes.size(); ++j)
 			{
+				const auto& attribute = binding.attributes[j];
 				auto& vk_attribute = vk_attributes.emplace_back();
 				vk_attribute.setBinding(i);
 				vk_attribute.setLocation(attribute.location);
 				vk_attribute.setFormat(convert_format_to_vk_format(attribute.format));
-				vk_attribute.setOffset(stride);
-
-				stride += convert_format_to_byte_size(attribute.format);
+				vk_attribute.setOffset(offsets[j]);
 			}
 
 			auto& vk_binding = vk_bindings.emplace_back();
 			vk_binding.setBinding(i);
-			vk_binding.setInputRate(vk::VertexInputRate::eVertex);
+			vk_binding.setInputRate(convert_vertex_input_rate_to_vk_vertex_input_rate(binding.inputRate));
 			vk_binding.setStride(stride);
+
+			if (binding.divisor != 1)
+			{
+				vk_divisors.emplace_back(i, binding.divisor);
+			}
 		}
 
 		vk::PipelineVertexInputStateCreateInfo vertex_input_state{};
 		vertex_input_state.setVertexBindingDescriptions(vk_bindings);
 		vertex_input_state.setVertexAttributeDescriptions(vk_attributes);
 
+		// Only chained when used, the extension is not enabled without DeviceFeatureFlags_VertexAttributeDivisor.
+		vk::PipelineVertexInputDivisorStateCreateInfoEXT divisor_state{};
+		divisor_state.setVertexBindingDivisors(vk_divisors);
+		if (!vk_divisors.empty())
+		{
+			vertex_input_state.setPNext(&divisor_state);
+		}
+
 		vk::PipelineInputAssemblyStateCreateInfo input_assembly_state{};
-		input_assembly_state.setTopology(vk::PrimitiveTopology::eTriangleList);
+		input_assembly_state.setTopology(convert_primitive_topology_to_vk_primitive_topology(graphicsPipelineInfo.topology));
 
-		vk::PipelineViewportStateCreateInfo viewport_state{};
-		viewport_state.setViewportCount(1);
-		viewport_state.setScissorCount(1);
+		m_pipeline = create_vk_graphics_pipeline(device, graphicsPipelineInfo, stages, &vertex_input_state, &input_assembly_state, m_layout, pipelineCache, flags, libraryParts);
+	}
 
-		vk::PipelineRasterizationStateCreateInfo rasterisation_state{};
-		rasterisation_state.setPolygonMode(vk::PolygonMode::eFill);	  // TODO: Optional.
-		rasterisation_state.setCullMode(vk::CullModeFlagBits::eNone); // TODO: Optional.
-		rasterisation_state.setFrontFace(vk::FrontFace::eClockwise);  // TODO: Optional.
-		rasterisation_state.setLineWidth(1.0f);						  // TODO: Optional.
+	GraphicsPipeline::GraphicsPipeline(vk::Device device, std::span<const vk::Pipeline> libraries, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, vk::PipelineLayout layout,
+									   vk::PipelineCache pipelineCache, vk::PipelineCreateFlags flags)
+		: Pipeline(PipelineType::eGraphics, descriptorSetLayouts, layout)
+	{
+		vk::PipelineLibraryCreateInfoKHR library_info{};
+		library_info.setLibraries(libraries);
 
-		vk::PipelineMultisampleStateCreateInfo multisample_state{};
-		multisample_state.setRasterizationSamples(vk::SampleCountFlagBits::e1); // #TODO: Optional.
+		vk::GraphicsPipelineCreateInfo vk_pipeline_info{};
+		vk_pipeline_info.setFlags(flags);
+		vk_pipeline_info.setLayout(m_layout);
+		vk_pipeline_info.setPNext(&library_info);
 
-		vk::PipelineDepthStencilStateCreateInfo depth_stencil_state{};
-		depth_stencil_state.setDepthTestEnable(graphicsPipelineInfo.depthTest);	 // #TODO: Optional.
-		depth_stencil_state.setDepthWriteEnable(graphicsPipelineInfo.depthTest); // #TODO: Optional.
-		depth_stencil_state.setStencilTestEnable(false);						 // #TODO: Optional.
-		depth_stencil_state.setDepthCompareOp(vk::CompareOp::eLessOrEqual);
-
-		std::vector<vk::PipelineColorBlendAttachmentState> colorBlendAttachments(1);
-		colorBlendAttachments[0].blendEnable = VK_TRUE;
-		colorBlendAttachments[0].srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
-		colorBlendAttachments[0].dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
-		colorBlendAttachments[0].colorBlendOp = vk::BlendOp::eAdd;
-		colorBlendAttachments[0].srcAlphaBlendFactor = vk::BlendFactor::eOne;
-		colorBlendAttachments[0].dstAlphaBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
-		colorBlendAttachments[0].alphaBlendOp = vk::BlendOp::eAdd;
-		colorBlendAttachments[0].colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
-		vk::PipelineColorBlendStateCreateInfo color_blend_state{};
-		color_blend_state.setAttachments(colorBlendAttachments);
+		m_pipeline = device.createGraphicsPipelineUnique(pipelineCache, vk_pipeline_info).value;
+	}
 
-		std::vector<vk::DynamicState> dynamicStates{
-			vk::DynamicState::eViewport,
-			vk::DynamicState::eScissor
-		};
-		vk::PipelineDynamicStateCreateInfo dynamic_state{};
-		dynamic_state.setDynamicStates(dynamicStates);
+	MeshPipeline::MeshPipeline(vk::Device device, const MeshPipelineInfo& meshPipelineInfo, vk::ShaderModule taskModule, vk::ShaderModule meshModule, vk::ShaderModule fragmentModule,
+							   const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, vk::PipelineLayout layout, vk::PipelineCache pipelineCache, vk::PipelineCreateFlags flags)
+		: Pipeline(PipelineType::eMesh, descriptorSetLayouts, layout)
+	{
+		const ScratchScope scratchScope{};
+		ScratchVector<vk::SpecializationMapEntry> task_specialization_entries{};
+		const auto task_specialization_info = get_vk_specialization_info(meshPipelineInfo.taskSpecializationConstants, task_specialization_entries);
+		vk::PipelineShaderStageCreateInfo task_stage_info{};
+		task_stage_info.setStage(vk::ShaderStageFlagBits::eTaskEXT);
+		task_stage_info.setModule(taskModule);
+		task_stage_info.setPName("main");
+		task_stage_info.setPSpecializationInfo(&task_specialization_info);
+
+		ScratchVector<vk::SpecializationMapEntry> mesh_specialization_entries{};
+		const auto mesh_specialization_info = get_vk_specialization_info(meshPipelineInfo.meshSpecializationConstants, mesh_specialization_entries);
+		vk::PipelineShaderStageCreateInfo mesh_stage_info{};
+		mesh_stage_info.setStage(vk::ShaderStageFlagBits::eMeshEXT);
+		mesh_stage_info.setModule(meshModule);
+		mesh_stage_info.setPName("main");
+		mesh_stage_info.setPSpecializationInfo(&mesh_specialization_info);
+
+		ScratchVector<vk::SpecializationMapEntry> fragment_specialization_entries{};
+		const auto fragment_specialization_info = get_vk_specialization_info(meshPipelineInfo.state.fragmentSpecializationConstants, fragment_specialization_entries);
+		vk::PipelineShaderStageCreateInfo fragment_stage_info{};
+		fragment_stage_info.setStage(vk::ShaderStageFlagBits::eFragment);
+		fragment_stage_info.setModule(fragmentModule);
+		fragment_stage_info.setPName("main");
+		fragment_stage_info.setPSpecializationInfo(&fragment_specialization_info);
 
-		std::vector<vk::Format> colorAttachmentFormats(graphicsPipelineInfo.colorAttachments.size());
-		for (auto i = 0; i < colorAttachmentFormats.size(); ++i)
+		ScratchVector<vk::PipelineShaderStageCreateInfo> stages{};
+		if (taskModule)
+		{
+			stages.push_back(task_stage_info);
+		}
+		stages.push_back(mesh_stage_info);
+		stages.push_back(fragment_stage_info);
+
+		m_pipeline = create_vk_graphics_pipeline(device, meshPipelineInfo.state, stages, nullptr, nullptr, m_layout, pipelineCache, flags);
+	}
+
+	ShaderObjectPipeline::ShaderObjectPipeline(vk::Device device, const GraphicsPipelineInfo& graphicsPipelineInfo, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts,
+											   vk::PipelineLayout layout, vk::PushConstantRange constantRange, bool shadingRate)
+		: Pipeline(PipelineType::eGraphicsShaderObjects, descriptorSetLayouts, layout)
+	{
+		const ScratchScope scratchScope{};
+		ScratchVector<vk::SpecializationMapEntry> vertex_specialization_entries{};
+		const auto vertex_specialization_info = get_vk_specialization_info(graphicsPipelineInfo.vertexSpecializationConstants, vertex_specialization_entries);
+		ScratchVector<vk::SpecializationMapEntry> fragment_specialization_entries{};
+		const auto fragment_specialization_info = get_vk_specialization_info(graphicsPipelineInfo.fragmentSpecializationConstants, fragment_specialization_entries);
+
+		// Linked, so the driver can optimise across the stages as it would for a pipeline. Depth-only pipelines only have the vertex shader.
+		const bool hasFragmentShader = !graphicsPipelineInfo.fragmentCode.empty();
+		std::array<vk::ShaderCreateInfoEXT, 2> shader_infos{};
+		shader_infos[0].setFlags(hasFragmentShader ? vk::ShaderCreateFlagBitsEXT::eLinkStage : vk::ShaderCreateFlagsEXT{});
+		shader_infos[0].setStage(vk::ShaderStageFlagBits::eVertex);
+		shader_infos[0].setNextStage(vk::ShaderStageFlagBits::eFragment);
+		shader_infos[0].setCodeSize(graphicsPipelineInfo.vertexCode.size() * sizeof(std::uint32_t));
+		shader_infos[0].setPCode(graphicsPipelineInfo.vertexCode.data());
+		shader_infos[0].setPSpecializationInfo(&vertex_specialization_info);
+		shader_infos[1].setFlags(vk::ShaderCreateFlagBitsEXT::eLinkStage);
+		shader_infos[1].setStage(vk::ShaderStageFlagBits::eFragment);
+		shader_infos[1].setCodeSize(graphicsPipelineInfo.fragmentCode.size() * sizeof(std::uint32_t));
+		shader_infos[1].setPCode(graphicsPipelineInfo.fragmentCode.data());
+		shader_infos[1].setPSpecializationInfo(&fragment_specialization_info);
+		for (auto& shader_info : shader_infos)
+		{
+			shader_info.setCodeType(vk::ShaderCodeTypeEXT::eSpirv);
+			shader_info.setPName("main");
+			shader_info.setSetLayouts(descriptorSetLayouts);
+			if (constantRange.size > 0 && constantRange.stageFlags != vk::ShaderStageFlags())
+			{
+				shader_info.setPushConstantRanges(constantRange);
+			}
+		}
+		const auto shaderCount = hasFragmentShader ? shader_infos.size() : 1;
+		m_shaders = device.createShadersEXTUnique(std::span(shader_infos.data(), shaderCount)).value;
+		if (m_shaders.size() == shaderCount)
 		{
-			colorAttachmentFormats[i] = convert_format_to_vk_format(graphicsPipelineInfo.colorAttachments[i]);
+			m_state.vertexShader = m_shaders[0].get();
+			m_state.fragmentShader = hasFragmentShader ? m_shaders[1].get() : vk::ShaderEXT{}; // Bound as null, disabling the stage.
 		}
 
-		vk::PipelineRenderingCreateInfo rendering_info{};
-		rendering_info.setColorAttachmentFormats(colorAttachmentFormats);
-		if (graphicsPipelineInfo.depthTest)
+		ScratchVector<std::uint32_t> offsets{};
+		for (auto i = 0; i < graphicsPipelineInfo.vertexInputBindings.size(); ++i)
 		{
-			rendering_info.setDepthAttachmentFormat(convert_format_to_vk_format(graphicsPipelineInfo.depthAttachmentFormat));
+			const auto& binding = graphicsPipelineInfo.vertexInputBindings[i];
+			const auto stride = get_vertex_binding_layout(binding, offsets);
+			for (auto j = 0; j < binding.attributes.size(); ++j)
+			{
+				const auto& attribute = binding.attributes[j];
+				m_state.vertexAttributes.emplace_back(attribute.location, i, convert_format_to_vk_format(attribute.format), offsets[j]);
+			}
+			m_state.vertexBindings.emplace_back(i, stride, convert_vertex_input_rate_to_vk_vertex_input_rate(binding.inputRate), binding.divisor);
 		}
 
-		vk::GraphicsPipelineCreateInfo vk_pipeline_info{};
-		vk_pipeline_info.setStages(stages);
-		vk_pipeline_info.setLayout(m_layout.get());
-		vk_pipeline_info.setPVertexInputState(&vertex_input_state);
-		vk_pipeline_info.setPInputAssemblyState(&input_assembly_state);
-		vk_pipeline_info.setPViewportState(&viewport_state);
-		vk_pipeline_info.setPRasterizationState(&rasterisation_state);
-		vk_pipeline_info.setPMultisampleState(&multisample_state);
-		vk_pipeline_info.setPDepthStencilState(&depth_stencil_state);
-		vk_pipeline_info.setPColorBlendState(&color_blend_state);
-		vk_pipeline_info.setPDynamicState(&dynamic_state);
-		vk_pipeline_info.setPNext(&rendering_info);
-
-		m_pipeline = device.createGraphicsPipelineUnique({}, vk_pipeline_info).value;
+		m_state.topology = convert_primitive_topology_to_vk_primitive_topology(graphicsPipelineInfo.topology);
+		m_state.cullMode = convert_cull_mode_to_vk_cull_mode(graphicsPipelineInfo.cullMode);
+		m_state.frontFace = convert_front_face_to_vk_front_face(graphicsPipelineInfo.frontFace);
+		m_state.depthTest = graphicsPipelineInfo.depthTest;
+		m_state.depthWrite = graphicsPipelineInfo.depthTest && graphicsPipelineInfo.depthWrite;
+		m_state.depthCompareOp = convert_compare_op_to_vk_compare_op(graphicsPipelineInfo.depthCompareOp);
+		m_state.stencilTest = graphicsPipelineInfo.stencilTest;
+		m_state.stencilFront = convert_stencil_state_to_vk_stencil_op_state(graphicsPipelineInfo.stencilFront);
+		m_state.stencilBack = convert_stencil_state_to_vk_stencil_op_state(graphicsPipelineInfo.stencilBack);
+		m_state.sampleCount = vk::SampleCountFlagBits(graphicsPipelineInfo.sampleCount);
+		m_state.blendStates.resize(graphicsPipelineInfo.colorAttachments.size(), convert_blend_state_to_vk_color_blend_attachment_state({}));
+		for (auto i = 0; i < std::min(m_state.blendStates.size(), graphicsPipelineInfo.colorBlendStates.size()); ++i)
+		{
+			m_state.blendStates[i] = convert_blend_state_to_vk_color_blend_attachment_state(graphicsPipelineInfo.colorBlendStates[i]);
+		}
+		m_state.shadingRate = shadingRate;
 	}
 
 	SwapChain::SwapChain(Device& device, const SwapChainInfo& swapChainInfo)
@@ -2379,6 +20111,17 @@ namespace sm::gfx
 		auto vk_instance = context->get_instance();
 		GFX_ASSERT(vk_instance, "vk_instance should be valid!");
 
+		m_presentMode = swapChainInfo.presentMode;
+		m_desiredImageCount = swapChainInfo.imageCountMatchesFramesInFlight ? m_device->get_frames_in_flight() : swapChainInfo.imageCount;
+		m_requestedExtent = vk::Extent2D(std::max(swapChainInfo.initialWidth, 0), std::max(swapChainInfo.initialHeight, 0));
+
+		m_headless = swapChainInfo.headless;
+		if (m_headless)
+		{
+			resize_headless(m_requestedExtent.width, m_requestedExtent.height);
+			return;
+		}
+
 		GFX_ASSERT(swapChainInfo.platformDisplayHandle != nullptr, "platformDisplayHandle not not be nullptr!");
 		GFX_ASSERT(swapChainInfo.platformWindowHandle != nullptr, "platformWindowHandle not not be nullptr!");
 
@@ -2398,8 +20141,24 @@ namespace sm::gfx
 		m_surface = vk_instance.createWaylandSurfaceKHRUnique(surface_info).value;
 #endif
 
-		m_fence = m_device->get_device().createFenceUnique({}).value;
+		// One more than the frames in flight, a semaphore is only reacquired into once the submission that waited on it has retired.
+		// That holds as long as each frame presents once between begin_frame() and end_frame(), next_present_id() asserts it.
+		m_acquireSemaphores.resize(m_device->get_frames_in_flight() + 1);
+		for (auto& acquireSemaphore : m_acquireSemaphores)
+		{
+			acquireSemaphore = m_device->get_device().createSemaphoreUnique({}).value;
+		}
 
+		m_lowLatencyRequested = swapChainInfo.lowLatency;
+		m_lowLatencyEnabled = m_lowLatencyRequested && m_device->supports_low_latency();
+		m_antiLagEnabled = m_lowLatencyRequested && !m_lowLatencyEnabled && m_device->supports_anti_lag();
+		if (m_lowLatencyEnabled)
+		{
+			vk::SemaphoreTypeCreateInfo timeline_semaphore_type_info{ vk::SemaphoreType::eTimeline, 0 };
+			vk::SemaphoreCreateInfo timeline_semaphore_info{};
+			timeline_semaphore_info.setPNext(&timeline_semaphore_type_info);
+			m_latencySleepSemaphore = m_device->get_device().createSemaphoreUnique(timeline_semaphore_info).value;
+		}
 		resize(swapChainInfo.initialWidth, swapChainInfo.initialHeight);
 
 		acquire_next_image_index();
@@ -2407,9 +20166,7 @@ namespace sm::gfx
 
 	SwapChain::SwapChain(SwapChain&& other) noexcept
 	{
-		std::swap(m_device, other.m_device);
-		std::swap(m_surface, other.m_surface);
-		std::swap(m_swapChain, other.m_swapChain);
+		*this = std::move(other);
 	}
 
 	SwapChain::~SwapChain()
@@ -2419,11 +20176,15 @@ namespace sm::gfx
 
 	void SwapChain::resize(std::int32_t width, std::uint32_t height)
 	{
-		cleanup();
+		if (m_headless)
+		{
+			resize_headless(static_cast<std::uint32_t>(std::max(width, 0)), height);
+			return;
+		}
 
 		auto surfaceCapabilities = m_device->get_physical_device().getSurfaceCapabilitiesKHR(m_surface.get()).value;
 
-		std::uint32_t minImageCount = surfaceCapabilities.minImageCount + 1;
+		std::uint32_t minImageCount = m_desiredImageCount != 0 ? std::max(m_desiredImageCount, surfaceCapabilities.minImageCount) : surfaceCapabilities.minImageCount + 1;
 		if (surfaceCapabilities.maxImageCount != 0 && minImageCount > surfaceCapabilities.maxImageCount)
 		{
 			minImageCount = surfaceCapabilities.maxImageCount;
@@ -2434,15 +20195,31 @@ namespace sm::gfx
 		};
 		auto surfaceFormat = vk::SurfaceFormatKHR(m_device->get_first_supported_surface_format(preferredSurfaceFormats, m_surface.get()), vk::ColorSpaceKHR::eSrgbNonlinear);
 
-		m_extent = vk::Extent2D(width, height);
-		m_extent.width = std::clamp(m_extent.width, surfaceCapabilities.minImageExtent.width, surfaceCapabilities.maxImageExtent.width);
-		m_extent.height = std::clamp(m_extent.height, surfaceCapabilities.minImageExtent.height, surfaceCapabilities.maxImageExtent.height);
+		auto extent = vk::Extent2D(width, height);
+		if (surfaceCapabilities.currentExtent.width != std::numeric_limits<std::uint32_t>::max())
+		{
+			// The surface dictates the size (eg. it follows the window).
+			extent = surfaceCapabilities.currentExtent;
+		}
+		extent.width = std::clamp(extent.width, surfaceCapabilities.minImageExtent.width, surfaceCapabilities.maxImageExtent.width);
+		extent.height = std::clamp(extent.height, surfaceCapabilities.minImageExtent.height, surfaceCapabilities.maxImageExtent.height);
+		if (extent.width == 0 || extent.height == 0)
+		{
+			// Minimised. Keep the current swap chain and try again at the next present.
+			m_recreatePending = true;
+			return;
+		}
+		m_extent = extent;
+		m_recreatePending = false;
 
-		auto presentMode = vk::PresentModeKHR::eFifo; // VSync. (FIFI is required to be supported.)
-		const auto preferredPresentMode = m_vsyncEnabled ? vk::PresentModeKHR::eMailbox : vk::PresentModeKHR::eImmediate;
-		if (m_device->is_present_mode_supported(preferredPresentMode, m_surface.get()))
+		auto presentMode = vk::PresentModeKHR::eFifo; // VSync. (FIFO is required to be supported.)
+		for (const auto candidatePresentMode : get_vk_present_mode_candidates(m_presentMode))
 		{
-			presentMode = preferredPresentMode;
+			if (m_device->is_present_mode_supported(candidatePresentMode, m_surface.get()))
+			{
+				presentMode = candidatePresentMode;
+				break;
+			}
 		}
 
 		auto oldSwapChain = std::move(m_swapChain);
@@ -2454,35 +20231,264 @@ namespace sm::gfx
 		swap_chain_info.setImageColorSpace(surfaceFormat.colorSpace);
 		swap_chain_info.setImageExtent(m_extent);
 		swap_chain_info.setImageArrayLayers(1);
-		swap_chain_info.setImageUsage(vk::ImageUsageFlagBits::eColorAttachment);
+		// Blitted into where the surface allows, e.g. to present a render target of another size or format.
+		swap_chain_info.setImageUsage(vk::ImageUsageFlagBits::eColorAttachment | (surfaceCapabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eTransferDst));
 		swap_chain_info.setPresentMode(presentMode);
 		swap_chain_info.setOldSwapchain(oldSwapChain.get());
 
+		vk::SwapchainLatencyCreateInfoNV latency_info{ true };
+		if (m_lowLatencyEnabled)
+		{
+			swap_chain_info.setPNext(&latency_info);
+		}
+
 		auto vk_device = m_device->get_device();
 		m_swapChain = vk_device.createSwapchainKHRUnique(swap_chain_info).value;
 
+		if (m_lowLatencyEnabled && m_swapChain)
+		{
+			const vk::LatencySleepModeInfoNV sleep_mode_info{ true, false, 0 };
+			auto result = vk_device.setLatencySleepModeNV(m_swapChain.get(), sleep_mode_info);
+			GFX_UNUSED(result);
+		}
+
+		// The retired swap chain and its image views may still be used by frames in flight, so they are released like any other resource.
+		if (oldSwapChain)
+		{
+			auto retiredSwapChain = std::make_shared<vk::UniqueSwapchainKHR>(std::move(oldSwapChain));
+			m_device->defer_destroy([retiredSwapChain = std::move(retiredSwapChain)]() mutable { retiredSwapChain.reset(); });
+		}
+
+		// Reuse the existing texture handles, so anything holding them stays valid across the resize.
 		auto images = vk_device.getSwapchainImagesKHR(m_swapChain.get()).value;
-		m_imageHandles.resize(images.size());
 		for (auto i = 0; i < images.size(); ++i)
 		{
-			bool success = m_device->create_texture(m_imageHandles[i], images[i], vk::Extent3D(m_extent, 1), surfaceFormat.format);
+			bool success{ false };
+			if (i < m_imageHandles.size())
+			{
+				success = m_device->replace_texture_image(m_imageHandles[i], images[i], vk::Extent3D(m_extent, 1), surfaceFormat.format);
+			}
+			else
+			{
+				success = m_device->create_texture(m_imageHandles.emplace_back(), images[i], vk::Extent3D(m_extent, 1), surfaceFormat.format);
+			}
 			GFX_ASSERT(success, "Failed to create Texture from SwapChain image!");
 		}
+		while (m_imageHandles.size() > images.size())
+		{
+			m_device->destroy_texture(m_imageHandles.back());
+			m_imageHandles.pop_back();
+		}
+
+		m_presentSemaphores.resize(images.size());
+		for (auto& presentSemaphore : m_presentSemaphores)
+		{
+			if (!presentSemaphore)
+			{
+				presentSemaphore = vk_device.createSemaphoreUnique({}).value;
+			}
+		}
+	}
+
+	void SwapChain::present(vk::Queue queue, vk::Semaphore waitSemaphore, std::uint64_t presentId, std::uint64_t desiredPresentTimeNs)
+	{
+		SwapChain* swapChain = this;
+		present_batch(queue, { &swapChain, 1 }, { &presentId, 1 }, waitSemaphore, desiredPresentTimeNs);
 	}
 
-	void SwapChain::present(vk::Queue queue, vk::Semaphore waitSemaphore)
+	void SwapChain::present_batch(vk::Queue queue, std::span<SwapChain* const> swapChains, std::span<const std::uint64_t> presentIds, vk::Semaphore waitSemaphore, std::uint64_t desiredPresentTimeNs)
 	{
-		vk::PresentInfoKHR present_info{};
-		present_info.setSwapchains(m_swapChain.get());
-		present_info.setImageIndices(m_imageIndex);
+		GFX_PROFILE_ZONE("gfx::SwapChain::present");
+		GFX_ASSERT(!swapChains.empty() && presentIds.size() == swapChains.size() && swapChains.size() <= MAX_BATCHED_PRESENTS, "Invalid present batch!");
+		InlineVector<vk::Semaphore, 1 + MAX_BATCHED_PRESENTS * 2> wait_semaphores{};
 		if (waitSemaphore)
 		{
-			present_info.setWaitSemaphores(waitSemaphore);
+			wait_semaphores.push_back(waitSemaphore);
+		}
+		InlineVector<vk::SwapchainKHR, MAX_BATCHED_PRESENTS> vk_swap_chains{};
+		InlineVector<std::uint32_t, MAX_BATCHED_PRESENTS> image_indices{};
+		InlineVector<std::uint64_t, MAX_BATCHED_PRESENTS> present_ids{};
+		InlineVector<vk::PresentTimeGOOGLE, MAX_BATCHED_PRESENTS> present_times{};
+		InlineVector<SwapChain*, MAX_BATCHED_PRESENTS> presenting{};
+		for (auto i = 0u; i < swapChains.size(); ++i)
+		{
+			auto* swapChain = swapChains[i];
+			if (swapChain->m_presentSemaphorePending)
+			{
+				wait_semaphores.push_back(swapChain->m_presentSemaphores.at(swapChain->m_imageIndex).get());
+				swapChain->m_presentSemaphorePending = false;
+			}
+			if (auto acquireSemaphore = swapChain->take_acquire_semaphore())
+			{
+				// Nothing rendering to the image waited on its acquire, let the present consume it so the semaphore can be reused.
+				wait_semaphores.push_back(acquireSemaphore);
+			}
+			if (swapChain->m_imageAcquired)
+			{
+				vk_swap_chains.push_back(swapChain->m_swapChain.get());
+				image_indices.push_back(swapChain->m_imageIndex);
+				present_ids.push_back(presentIds[i]);
+				present_times.push_back({ static_cast<std::uint32_t>(presentIds[i]), desiredPresentTimeNs });
+				presenting.push_back(swapChain);
+			}
 		}
-		auto result = queue.presentKHR(present_info);
-		GFX_UNUSED(result);
 
-		acquire_next_image_index();
+		if (!presenting.empty())
+		{
+			// One call for every swap chain, so the driver and compositor synchronise once rather than per window.
+			const auto count = std::uint32_t(presenting.size());
+			InlineVector<vk::Result, MAX_BATCHED_PRESENTS> results{};
+			results.resize(count);
+			vk::PresentInfoKHR present_info{};
+			present_info.setSwapchains(vk_swap_chains);
+			present_info.setImageIndices(image_indices);
+			present_info.setResults(results);
+			present_info.setWaitSemaphores(wait_semaphores);
+
+			const auto* device = presenting[0]->m_device;
+			vk::PresentIdKHR present_id_info{ count, present_ids.data() };
+			vk::PresentTimesInfoGOOGLE present_times_info{ count, present_times.data() };
+			if (device->supports_present_wait())
+			{
+				present_id_info.setPNext(present_info.pNext);
+				present_info.setPNext(&present_id_info);
+			}
+			if (device->supports_display_timing())
+			{
+				present_times_info.setPNext(present_info.pNext);
+				present_info.setPNext(&present_times_info);
+			}
+
+			for (auto i = 0u; i < count; ++i)
+			{
+				if (presenting[i]->m_lowLatencyEnabled)
+				{
+					presenting[i]->set_latency_marker(vk::LatencyMarkerNV::ePresentStart, present_ids[i]);
+				}
+				if (presenting[i]->m_antiLagEnabled)
+				{
+					presenting[i]->update_anti_lag(vk::AntiLagStageAMD::ePresent, present_ids[i]);
+				}
+			}
+
+			// Out of date is an expected result here, which vulkan.hpp would assert on.
+			const auto result = static_cast<vk::Result>(VULKAN_HPP_DEFAULT_DISPATCHER.vkQueuePresentKHR(static_cast<VkQueue>(queue), reinterpret_cast<const VkPresentInfoKHR*>(&present_info)));
+			for (auto i = 0u; i < count; ++i)
+			{
+				if (presenting[i]->m_lowLatencyEnabled)
+				{
+					presenting[i]->set_latency_marker(vk::LatencyMarkerNV::ePresentEnd, present_ids[i]);
+				}
+				// Each swap chain's own result says which of them went out of date, the call's is the most severe of them.
+				const auto swapChainResult = count == 1 ? result : results[i];
+				if (swapChainResult == vk::Result::eErrorOutOfDateKHR || swapChainResult == vk::Result::eSuboptimalKHR)
+				{
+					presenting[i]->m_recreatePending = true;
+				}
+			}
+		}
+		else if (!wait_semaphores.empty())
+		{
+			// Nothing to present, but the semaphores still have to be waited on before they can be signalled again.
+			InlineVector<vk::SemaphoreSubmitInfo, 1 + MAX_BATCHED_PRESENTS * 2> wait_infos{};
+			for (auto semaphore : wait_semaphores)
+			{
+				wait_infos.push_back(vk::SemaphoreSubmitInfo(semaphore, 0, vk::PipelineStageFlagBits2::eAllCommands));
+			}
+			vk::SubmitInfo2 submit_info{};
+			submit_info.setWaitSemaphoreInfos(wait_infos);
+			auto result = queue.submit2(submit_info);
+			GFX_UNUSED(result);
+		}
+
+		for (auto* swapChain : swapChains)
+		{
+			if (swapChain->m_headless)
+			{
+				// Nothing is displayed, the next image in the rotation is simply the current one.
+				swapChain->m_imageIndex = (swapChain->m_imageIndex + 1) % swapChain->m_imageHandles.size();
+			}
+			if (swapChain->m_recreatePending)
+			{
+				swapChain->resize(static_cast<std::int32_t>(swapChain->m_requestedExtent.width), swapChain->m_requestedExtent.height);
+			}
+			if (!swapChain->m_headless)
+			{
+				swapChain->acquire_next_image_index();
+			}
+		}
+	}
+
+	void SwapChain::latency_sleep()
+	{
+		if (m_lowLatencyEnabled)
+		{
+			// The driver signals the semaphore when the frame should start.
+			auto vk_device = m_device->get_device();
+			const vk::LatencySleepInfoNV sleep_info{ m_latencySleepSemaphore.get(), ++m_latencySleepValue };
+			if (vk_device.latencySleepNV(m_swapChain.get(), sleep_info) == vk::Result::eSuccess)
+			{
+				vk::SemaphoreWaitInfo wait_info{};
+				wait_info.setSemaphores(sleep_info.signalSemaphore);
+				wait_info.setValues(sleep_info.value);
+				auto result = vk_device.waitSemaphores(wait_info, std::uint64_t(-1));
+				GFX_UNUSED(result);
+			}
+			return;
+		}
+		if (m_antiLagEnabled)
+		{
+			// Sleeps inside the driver when the CPU is running ahead of the GPU.
+			update_anti_lag(vk::AntiLagStageAMD::eInput, get_upcoming_present_id());
+			return;
+		}
+		if (m_lowLatencyRequested && m_lastPresentId > 1)
+		{
+			wait_for_present_id(m_lastPresentId - 1, std::uint64_t(-1));
+		}
+	}
+
+	void SwapChain::set_latency_marker(LatencyMarker marker)
+	{
+		if (m_lowLatencyEnabled)
+		{
+			set_latency_marker(convert_latency_marker_to_vk_latency_marker(marker), get_upcoming_present_id());
+		}
+	}
+
+	void SwapChain::set_latency_marker(vk::LatencyMarkerNV marker, std::uint64_t presentId)
+	{
+		if (!m_swapChain)
+		{
+			return;
+		}
+
+		const vk::SetLatencyMarkerInfoNV marker_info{ presentId, marker };
+		m_device->get_device().setLatencyMarkerNV(m_swapChain.get(), marker_info);
+	}
+
+	void SwapChain::update_anti_lag(vk::AntiLagStageAMD stage, std::uint64_t presentId)
+	{
+		vk::AntiLagPresentationInfoAMD presentation_info{ stage, presentId };
+		vk::AntiLagDataAMD anti_lag_data{ vk::AntiLagModeAMD::eOn, 0, &presentation_info };
+		m_device->get_device().antiLagUpdateAMD(anti_lag_data);
+	}
+
+	void SwapChain::request_resize(std::uint32_t width, std::uint32_t height)
+	{
+		m_requestedExtent = vk::Extent2D(width, height);
+		m_recreatePending = true;
+	}
+
+	void SwapChain::request_image_count(std::uint32_t imageCount)
+	{
+		if (imageCount == m_desiredImageCount)
+		{
+			return;
+		}
+
+		m_desiredImageCount = imageCount;
+		m_recreatePending = true;
 	}
 
 	auto SwapChain::operator=(SwapChain&& rhs) noexcept -> SwapChain&
@@ -2490,9 +20496,162 @@ namespace sm::gfx
 		std::swap(m_device, rhs.m_device);
 		std::swap(m_surface, rhs.m_surface);
 		std::swap(m_swapChain, rhs.m_swapChain);
+		std::swap(m_headless, rhs.m_headless);
+		std::swap(m_extent, rhs.m_extent);
+		std::swap(m_requestedExtent, rhs.m_requestedExtent);
+		std::swap(m_recreatePending, rhs.m_recreatePending);
+		std::swap(m_presentMode, rhs.m_presentMode);
+		std::swap(m_desiredImageCount, rhs.m_desiredImageCount);
+		std::swap(m_imageIndex, rhs.m_imageIndex);
+		std::swap(m_imageAcquired, rhs.m_imageAcquired);
+		std::swap(m_lastPresentId, rhs.m_lastPresentId);
+		std::swap(m_lastPresentFrameNumber, rhs.m_lastPresentFrameNumber);
+		std::swap(m_lowLatencyRequested, rhs.m_lowLatencyRequested);
+		std::swap(m_lowLatencyEnabled, rhs.m_lowLatencyEnabled);
+		std::swap(m_antiLagEnabled, rhs.m_antiLagEnabled);
+		std::swap(m_latencySleepSemaphore, rhs.m_latencySleepSemaphore);
+		std::swap(m_latencySleepValue, rhs.m_latencySleepValue);
+		std::swap(m_acquireSemaphores, rhs.m_acquireSemaphores);
+		std::swap(m_acquireSemaphoreIndex, rhs.m_acquireSemaphoreIndex);
+		std::swap(m_pendingAcquireSemaphore, rhs.m_pendingAcquireSemaphore);
+		std::swap(m_presentSemaphores, rhs.m_presentSemaphores);
+		std::swap(m_presentSemaphorePending, rhs.m_presentSemaphorePending);
+		std::swap(m_imageHandles, rhs.m_imageHandles);
 		return *this;
 	}
 
+	bool SwapChain::wait_for_present_id(std::uint64_t presentId, std::uint64_t timeoutNs)
+	{
+		if (!m_device->supports_present_wait() || !m_swapChain)
+		{
+			return false;
+		}
+
+		const auto result = m_device->get_device().waitForPresentKHR(m_swapChain.get(), presentId, timeoutNs);
+		return result == vk::Result::eSuccess || result == vk::Result::eSuboptimalKHR;
+	}
+
+	bool SwapChain::get_present_timings(std::vector<PresentTiming>& outPresentTimings)
+	{
+		if (!m_device->supports_display_timing() || !m_swapChain)
+		{
+			return false;
+		}
+
+		const auto result = m_device->get_device().getPastPresentationTimingGOOGLE(m_swapChain.get());
+		if (result.result != vk::Result::eSuccess && result.result != vk::Result::eIncomplete)
+		{
+			return false;
+		}
+
+		outPresentTimings.reserve(result.value.size());
+		for (const auto& timing : result.value)
+		{
+			// Display timing ids are 32 bit, so widen them relative to the latest present.
+			const auto lastPresentId = m_lastPresentId;
+			const std::uint32_t idDelta = static_cast<std::uint32_t>(lastPresentId) - timing.presentID;
+			outPresentTimings.push_back(PresentTiming{
+				.presentId = lastPresentId - idDelta,
+				.desiredPresentTimeNs = timing.desiredPresentTime,
+				.actualPresentTimeNs = timing.actualPresentTime,
+				.earliestPresentTimeNs = timing.earliestPresentTime,
+				.presentMarginNs = timing.presentMargin,
+			});
+		}
+		return true;
+	}
+
+	bool SwapChain::get_refresh_duration(std::uint64_t& outRefreshDurationNs)
+	{
+		if (!m_device->supports_display_timing() || !m_swapChain)
+		{
+			return false;
+		}
+
+		const auto result = m_device->get_device().getRefreshCycleDurationGOOGLE(m_swapChain.get());
+		if (result.result != vk::Result::eSuccess)
+		{
+			return false;
+		}
+
+		outRefreshDurationNs = result.value.refreshDuration;
+		return true;
+	}
+
+	void SwapChain::set_present_mode(PresentMode presentMode)
+	{
+		if (presentMode == m_presentMode)
+		{
+			return;
+		}
+
+		m_presentMode = presentMode;
+		if (!m_headless)
+		{
+			recreate();
+		}
+	}
+
+	void SwapChain::recreate()
+	{
+		m_device->wait_for_idle();
+
+		auto vk_device = m_device->get_device();
+		if (auto acquireSemaphore = take_acquire_semaphore())
+		{
+			for (auto& semaphore : m_acquireSemaphores)
+			{
+				if (semaphore.get() == acquireSemaphore)
+				{
+					semaphore = vk_device.createSemaphoreUnique({}).value;
+				}
+			}
+		}
+		if (m_presentSemaphorePending)
+		{
+			m_presentSemaphores.at(m_imageIndex) = vk_device.createSemaphoreUnique({}).value;
+			m_presentSemaphorePending = false;
+		}
+
+		resize(static_cast<std::int32_t>(m_requestedExtent.width), m_requestedExtent.height);
+		acquire_next_image_index();
+	}
+
+	void SwapChain::resize_headless(std::uint32_t width, std::uint32_t height)
+	{
+		m_extent = vk::Extent2D(std::max(width, 1u), std::max(height, 1u));
+		m_recreatePending = false;
+
+		// Enough images that one is never rendered to while an earlier frame in flight still uses it.
+		const auto imageCount = m_desiredImageCount != 0 ? m_desiredImageCount : m_device->get_frames_in_flight() + 1;
+		const TextureInfo textureInfo{
+			.usage = TextureUsage::eColorAttachment,
+			.type = TextureType::e2D,
+			.width = m_extent.width,
+			.height = m_extent.height,
+			.format = Format::eRGBA8,
+		};
+		for (auto i = 0; i < imageCount; ++i)
+		{
+			bool success{ false };
+			if (i < m_imageHandles.size())
+			{
+				success = m_device->replace_texture(m_imageHandles[i], Texture(*m_device, textureInfo));
+			}
+			else
+			{
+				success = m_device->create_texture(m_imageHandles.emplace_back(), textureInfo);
+			}
+			GFX_ASSERT(success, "Failed to create headless SwapChain image!");
+		}
+		while (m_imageHandles.size() > imageCount)
+		{
+			m_device->destroy_texture(m_imageHandles.back());
+			m_imageHandles.pop_back();
+		}
+		m_imageIndex %= imageCount;
+	}
+
 	void SwapChain::cleanup()
 	{
 		for (auto imageHandle : m_imageHandles)
@@ -2502,13 +20661,93 @@ namespace sm::gfx
 		m_imageHandles.clear();
 	}
 
-	void SwapChain::acquire_next_image_index()
+	void SwapChain::begin_present()
+	{
+		std::lock_guard lock(m_presentMutex);
+		m_presentPending = true;
+	}
+
+	void SwapChain::end_present()
+	{
+		{
+			std::lock_guard lock(m_presentMutex);
+			m_presentPending = false;
+		}
+		m_presentCondition.notify_all();
+	}
+
+	void SwapChain::wait_for_present()
 	{
+		std::unique_lock lock(m_presentMutex);
+		m_presentCondition.wait(lock, [this] { return !m_presentPending; });
+	}
+
+	auto SwapChain::next_present_id(std::uint32_t frameNumber) -> std::uint64_t
+	{
+		// Each present acquires into the next semaphore of the ring. framesInFlight + 1 of them is only enough when every present
+		// is in its own begin_frame(), as that is what waits for the submission that last waited on the semaphore being reused.
+		GFX_ASSERT(m_headless || frameNumber != m_lastPresentFrameNumber, "A swap chain can only be presented once between begin_frame() and end_frame()!");
+		m_lastPresentFrameNumber = frameNumber;
+		return ++m_lastPresentId;
+	}
+
+	auto SwapChain::take_acquire_semaphore() -> vk::Semaphore
+	{
+		return std::exchange(m_pendingAcquireSemaphore, nullptr);
+	}
+
+	auto SwapChain::signal_present_semaphore() -> vk::Semaphore
+	{
+		GFX_ASSERT(!m_presentSemaphorePending, "Only one submission per present can render to the swap chain image!");
+		m_presentSemaphorePending = true;
+		return m_presentSemaphores.at(m_imageIndex).get();
+	}
+
+	bool SwapChain::acquire_next_image_index()
+	{
+		GFX_PROFILE_ZONE("gfx::SwapChain::acquire_next_image_index");
+		// Signals a semaphore for the GPU to wait on, instead of blocking the CPU until the image is available.
+		auto acquireSemaphore = m_acquireSemaphores[m_acquireSemaphoreIndex].get();
+
+		// Out of date is an expected result here, which vulkan.hpp would assert on.
 		auto device = m_device->get_device();
-		m_imageIndex = device.acquireNextImageKHR(m_swapChain.get(), std::uint64_t(-1), {}, m_fence.get()).value;
-		auto result = device.waitForFences(m_fence.get(), VK_TRUE, std::uint64_t(-1));
-		GFX_UNUSED(result);
-		device.resetFences(m_fence.get());
+		std::uint32_t imageIndex{ 0 };
+		auto acquire = [&] {
+			if (!m_swapChain)
+			{
+				return vk::Result::eErrorOutOfDateKHR;
+			}
+			return static_cast<vk::Result>(VULKAN_HPP_DEFAULT_DISPATCHER.vkAcquireNextImageKHR(
+				static_cast<VkDevice>(device), static_cast<VkSwapchainKHR>(m_swapChain.get()), std::uint64_t(-1), static_cast<VkSemaphore>(acquireSemaphore), VK_NULL_HANDLE, &imageIndex));
+		};
+
+		auto result = acquire();
+		if (result == vk::Result::eErrorOutOfDateKHR)
+		{
+			resize(static_cast<std::int32_t>(m_requestedExtent.width), m_requestedExtent.height);
+			result = !m_recreatePending ? acquire() : result;
+		}
+		if (result == vk::Result::eSuboptimalKHR)
+		{
+			// The image is still usable, rebuild once it has been presented.
+			m_recreatePending = true;
+		}
+
+		m_imageAcquired = result == vk::Result::eSuccess || result == vk::Result::eSuboptimalKHR;
+		if (!m_imageAcquired)
+		{
+			// The semaphore was not signalled, so it stays first in line for the next acquire.
+			if (result != vk::Result::eErrorOutOfDateKHR)
+			{
+				s_errorCallback("GFX - Failed to acquire swap chain image!");
+			}
+			return false;
+		}
+
+		m_imageIndex = imageIndex;
+		m_acquireSemaphoreIndex = (m_acquireSemaphoreIndex + 1) % m_acquireSemaphores.size();
+		m_pendingAcquireSemaphore = acquireSemaphore;
+		return true;
 	}
 
 	VKAPI_ATTR VkBool32 VKAPI_CALL debug_utils_messenger_callback(
@@ -2517,11 +20756,7 @@ namespace sm::gfx
 		const VkDebugUtilsMessengerCallbackDataEXT* callback_data,
 		void* user_data)
 	{
-		if (s_errorCallback)
-		{
-			s_errorCallback(callback_data->pMessage);
-		}
-
+		s_errorCallback(callback_data->pMessage);
 		return VK_FALSE;
 	}
 
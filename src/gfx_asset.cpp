@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx_asset.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace sm::gfx
+{
+	AssetLoader::AssetLoader(DeviceHandle deviceHandle, TaskScheduler* executor)
+		: m_deviceHandle(deviceHandle), m_executor(executor != nullptr ? executor : get_task_scheduler(deviceHandle))
+	{
+		DeviceProperties properties{};
+		if (get_device_properties(properties, m_deviceHandle))
+		{
+			m_uploadBufferSize = properties.uploadBufferSize;
+		}
+		if (m_uploadBufferSize == 0)
+		{
+			GFX_LOG_ERR("GFX - AssetLoader needs DeviceInfo::uploadBufferSize to be set!");
+		}
+	}
+
+	AssetLoader::~AssetLoader()
+	{
+		std::unique_lock lock(m_mutex);
+		m_condition.wait(lock, [this] { return m_decodingCount == 0; });
+	}
+
+	void AssetLoader::load_buffer(BufferHandle bufferHandle, std::uint64_t size, std::uint64_t offset, DecodeFunc&& decode)
+	{
+		std::lock_guard lock(m_mutex);
+		m_queuedLoads.push_back({ .bufferHandle = bufferHandle, .size = size, .offset = offset, .decode = std::move(decode) });
+	}
+
+	void AssetLoader::load_texture(TextureHandle textureHandle, std::uint32_t mipLevel, DecodeFunc&& decode)
+	{
+		std::lock_guard lock(m_mutex);
+		m_queuedLoads.push_back({ .textureHandle = textureHandle, .mipLevel = mipLevel, .decode = std::move(decode) });
+	}
+
+	auto AssetLoader::update(std::uint32_t dstQueueIndex) -> SyncPoint
+	{
+		std::vector<std::pair<UploadAllocation, DecodeFunc>> started{};
+		std::size_t decodedCount{ 0 };
+		{
+			std::lock_guard lock(m_mutex);
+			while (!m_queuedLoads.empty() && m_uploadBufferSize != 0)
+			{
+				auto& load = m_queuedLoads.front();
+				UploadAllocation allocation{};
+				const bool allocated = load.bufferHandle != 0 ? allocate_buffer_upload(allocation, load.bufferHandle, load.size, load.offset)
+															  : allocate_texture_upload(allocation, load.textureHandle, load.mipLevel);
+				if (!allocated && allocation.size != 0 && allocation.size < m_uploadBufferSize)
+				{
+					break; // Waits for ring space, which later loads would not find either.
+				}
+				if (allocated)
+				{
+					started.emplace_back(allocation, std::move(load.decode));
+					++m_decodingCount;
+				}
+				m_queuedLoads.pop_front(); // Dropped if it can never be allocated, which was reported.
+			}
+			decodedCount = std::exchange(m_decodedCount, 0);
+		}
+
+		// Enqueued outside the lock, as the executor may run a decode inline.
+		for (auto& [allocation, decodeFunc] : started)
+		{
+			m_executor->enqueue([this, allocation, decodeFunc = std::move(decodeFunc)] { decode(allocation, decodeFunc); });
+		}
+
+		if (decodedCount > 0)
+		{
+			const auto syncPoint = flush_uploads(m_deviceHandle, dstQueueIndex);
+			if (syncPoint.value != 0)
+			{
+				m_syncPoint = syncPoint;
+			}
+		}
+		return m_syncPoint;
+	}
+
+	auto AssetLoader::get_pending_count() const -> std::size_t
+	{
+		std::lock_guard lock(m_mutex);
+		return m_queuedLoads.size() + m_decodingCount + m_decodedCount;
+	}
+
+	void AssetLoader::decode(const UploadAllocation& allocation, const DecodeFunc& decodeFunc)
+	{
+		if (decodeFunc(allocation.data, allocation.size))
+		{
+			commit_upload(allocation);
+		}
+		else
+		{
+			cancel_upload(allocation);
+		}
+
+		// Notified under the lock, so ~AssetLoader() cannot finish before this stops touching the loader.
+		std::lock_guard lock(m_mutex);
+		--m_decodingCount;
+		++m_decodedCount;
+		m_condition.notify_all();
+	}
+
+} // namespace sm::gfx
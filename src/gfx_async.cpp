@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx_async.hpp"
+
+#include <algorithm>
+
+namespace sm::gfx
+{
+	namespace
+	{
+		// Orders std::push_heap() and std::pop_heap() so the smallest value is on top.
+		template <typename T>
+		bool greater_value(const T& lhs, const T& rhs)
+		{
+			return lhs.value > rhs.value;
+		}
+	} // namespace
+
+	bool SyncPointAwaitable::await_ready() const
+	{
+		return is_sync_point_complete(m_syncPoint);
+	}
+
+	void SyncPointAwaitable::await_suspend(std::coroutine_handle<> handle) const
+	{
+		m_waiter->add(m_syncPoint, handle);
+	}
+
+	bool PipelineReadyAwaitable::await_ready() const
+	{
+		return is_pipeline_ready(m_pipelineHandle);
+	}
+
+	void PipelineReadyAwaitable::await_suspend(std::coroutine_handle<> handle) const
+	{
+		m_waiter->add(m_pipelineHandle, handle);
+	}
+
+	AsyncWaiter::AsyncWaiter(TaskScheduler* executor) : m_executor(executor) {}
+
+	auto AsyncWaiter::submit_async(const SubmitInfo& submitInfo) -> SyncPointAwaitable
+	{
+		return { *this, submit_command_list(submitInfo) };
+	}
+
+	auto AsyncWaiter::upload_buffer_async(BufferHandle bufferHandle, const void* data, std::uint64_t size, std::uint64_t offset, std::uint32_t queueIndex) -> SyncPointAwaitable
+	{
+		return { *this, upload_buffer(bufferHandle, data, size, offset, queueIndex) };
+	}
+
+	auto AsyncWaiter::upload_texture_async(TextureHandle textureHandle, const void* data, std::uint64_t size, std::uint32_t queueIndex) -> SyncPointAwaitable
+	{
+		return { *this, upload_texture(textureHandle, data, size, queueIndex) };
+	}
+
+	auto AsyncWaiter::flush_uploads_async(DeviceHandle deviceHandle, std::uint32_t dstQueueIndex) -> SyncPointAwaitable
+	{
+		return { *this, flush_uploads(deviceHandle, dstQueueIndex) };
+	}
+
+	auto AsyncWaiter::poll() -> std::size_t
+	{
+		std::vector<std::coroutine_handle<>> ready{};
+		{
+			std::lock_guard lock(m_mutex);
+			for (auto& timeline : m_timelines)
+			{
+				// Values on one timeline complete in order, so only the first unreached one needs checking.
+				while (!timeline.pending.empty() && is_sync_point_complete({ timeline.deviceHandle, timeline.queueIndex, timeline.pending.front().value }))
+				{
+					ready.push_back(timeline.pending.front().handle);
+					std::pop_heap(timeline.pending.begin(), timeline.pending.end(), greater_value<PendingSyncPoint>);
+					timeline.pending.pop_back();
+				}
+			}
+			std::erase_if(m_pendingPipelines, [&](const PendingPipeline& pending) {
+				if (!is_pipeline_ready(pending.pipelineHandle))
+				{
+					return false;
+				}
+				ready.push_back(pending.handle);
+				return true;
+			});
+		}
+
+		// Resumed outside the lock, as the coroutines may await again straight away.
+		for (const auto handle : ready)
+		{
+			resume(handle);
+		}
+		return ready.size();
+	}
+
+	auto AsyncWaiter::get_pending_count() const -> std::size_t
+	{
+		std::lock_guard lock(m_mutex);
+		std::size_t count = m_pendingPipelines.size();
+		for (const auto& timeline : m_timelines)
+		{
+			count += timeline.pending.size();
+		}
+		return count;
+	}
+
+	void AsyncWaiter::add(SyncPoint syncPoint, std::coroutine_handle<> handle)
+	{
+		std::lock_guard lock(m_mutex);
+		auto it = std::find_if(m_timelines.begin(), m_timelines.end(), [&](const Timeline& timeline) {
+			return timeline.deviceHandle == syncPoint.deviceHandle && timeline.queueIndex == syncPoint.queueIndex;
+		});
+		if (it == m_timelines.end())
+		{
+			it = m_timelines.insert(m_timelines.end(), Timeline{ syncPoint.deviceHandle, syncPoint.queueIndex, {} });
+		}
+		it->pending.push_back({ syncPoint.value, handle });
+		std::push_heap(it->pending.begin(), it->pending.end(), greater_value<PendingSyncPoint>);
+	}
+
+	void AsyncWaiter::add(PipelineHandle pipelineHandle, std::coroutine_handle<> handle)
+	{
+		std::lock_guard lock(m_mutex);
+		m_pendingPipelines.push_back({ pipelineHandle, handle });
+	}
+
+	void AsyncWaiter::resume(std::coroutine_handle<> handle)
+	{
+		if (m_executor != nullptr)
+		{
+			m_executor->enqueue([handle] { handle.resume(); });
+		}
+		else
+		{
+			handle.resume();
+		}
+	}
+
+} // namespace sm::gfx
@@ -0,0 +1,894 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx_capture.hpp"
+
+#include "gfx_p.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+namespace sm::gfx
+{
+#pragma region CaptureWriter
+
+	bool CaptureWriter::save(const DeviceInfo& deviceInfo)
+	{
+		std::lock_guard lock(m_mutex);
+
+		// The header is serialized after the calls, and written before them.
+		const auto callsSize = m_data.size();
+		write(CAPTURE_MAGIC);
+		write(CAPTURE_VERSION);
+		write(deviceInfo);
+
+		std::ofstream file{ std::filesystem::path(m_path), std::ios::binary | std::ios::trunc };
+		file.write(reinterpret_cast<const char*>(m_data.data() + callsSize), static_cast<std::streamsize>(m_data.size() - callsSize));
+		file.write(reinterpret_cast<const char*>(m_data.data()), static_cast<std::streamsize>(callsSize));
+		m_data.resize(callsSize);
+		return static_cast<bool>(file);
+	}
+
+	void CaptureWriter::add_mapped_buffer(BufferHandle bufferHandle)
+	{
+		std::lock_guard lock(m_mutex);
+		m_mappedBuffers.insert(static_cast<std::uint64_t>(bufferHandle));
+	}
+
+	auto CaptureWriter::get_mapped_buffers() -> std::vector<BufferHandle>
+	{
+		std::lock_guard lock(m_mutex);
+		std::vector<BufferHandle> bufferHandles{};
+		bufferHandles.reserve(m_mappedBuffers.size());
+		for (const auto value : m_mappedBuffers)
+		{
+			bufferHandles.emplace_back(static_cast<DeviceHandle>(value >> 32u), static_cast<ResourceHandle>(value & 0xFFFFFFFFu));
+		}
+		return bufferHandles;
+	}
+
+#pragma endregion
+
+#pragma region PipelineManifest
+
+	namespace
+	{
+		auto hash_pipeline_info(const PipelineManifest::PipelineInfo& pipelineInfo) -> std::size_t
+		{
+			return std::visit([](const auto& info) { return std::hash<std::decay_t<decltype(info)>>{}(info); }, pipelineInfo);
+		}
+	} // namespace
+
+	bool PipelineManifest::load(std::vector<PipelineInfo>& outPipelineInfos, const std::string& path, std::uint64_t* outSize)
+	{
+		std::ifstream file{ std::filesystem::path(path), std::ios::binary | std::ios::ate };
+		if (!file)
+		{
+			return false;
+		}
+		std::vector<std::byte> data(static_cast<std::size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+		const std::unordered_map<std::uint64_t, std::uint64_t> noHandles{};
+		CaptureReader header(data, {}, noHandles);
+		if (header.read<std::uint32_t>() != PIPELINE_MANIFEST_MAGIC || header.read<std::uint32_t>() != CAPTURE_VERSION || !header.is_valid())
+		{
+			return false;
+		}
+
+		outPipelineInfos.clear();
+		auto offset = header.get_offset();
+		while (data.size() - offset >= sizeof(std::uint32_t) * 2)
+		{
+			std::uint32_t op{};
+			std::uint32_t size{};
+			std::memcpy(&op, data.data() + offset, sizeof(std::uint32_t));
+			std::memcpy(&size, data.data() + offset + sizeof(std::uint32_t), sizeof(std::uint32_t));
+			if (data.size() - offset - sizeof(std::uint32_t) * 2 < size)
+			{
+				break;
+			}
+
+			CaptureReader ar(std::span(data).subspan(offset + sizeof(std::uint32_t) * 2, size), {}, noHandles);
+			switch (static_cast<CaptureOp>(op))
+			{
+				case CaptureOp::eCreateComputePipeline: outPipelineInfos.emplace_back(ar.read<ComputePipelineInfo>()); break;
+				case CaptureOp::eCreateGraphicsPipeline: outPipelineInfos.emplace_back(ar.read<GraphicsPipelineInfo>()); break;
+				case CaptureOp::eCreateMeshPipeline: outPipelineInfos.emplace_back(ar.read<MeshPipelineInfo>()); break;
+				default: break;
+			}
+			if (!ar.is_valid())
+			{
+				outPipelineInfos.pop_back();
+				break;
+			}
+			offset += sizeof(std::uint32_t) * 2 + size;
+		}
+		if (outSize != nullptr)
+		{
+			*outSize = offset;
+		}
+		return true;
+	}
+
+	bool PipelineManifest::open(const std::string& path)
+	{
+		m_path = path;
+		m_recordedHashes.clear();
+
+		std::vector<PipelineInfo> pipelineInfos{};
+		std::uint64_t size{ 0 };
+		if (load(pipelineInfos, path, &size))
+		{
+			for (const auto& pipelineInfo : pipelineInfos)
+			{
+				m_recordedHashes.insert(hash_pipeline_info(pipelineInfo));
+			}
+			// A record cut short by a crash is dropped, or the records appended after it could not be read back.
+			std::error_code error{};
+			std::filesystem::resize_file(path, size, error);
+			return !error;
+		}
+
+		std::ofstream file{ std::filesystem::path(path), std::ios::binary | std::ios::trunc };
+		file.write(reinterpret_cast<const char*>(&PIPELINE_MANIFEST_MAGIC), sizeof(PIPELINE_MANIFEST_MAGIC));
+		file.write(reinterpret_cast<const char*>(&CAPTURE_VERSION), sizeof(CAPTURE_VERSION));
+		return static_cast<bool>(file);
+	}
+
+	void PipelineManifest::record(std::size_t hash, const PipelineInfo& pipelineInfo)
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			if (!m_recordedHashes.insert(hash).second)
+			{
+				return;
+			}
+		}
+
+		CaptureWriter writer({});
+		if (const auto* computeInfo = std::get_if<ComputePipelineInfo>(&pipelineInfo))
+		{
+			writer.record(CaptureOp::eCreateComputePipeline, *computeInfo);
+		}
+		else if (const auto* graphicsInfo = std::get_if<GraphicsPipelineInfo>(&pipelineInfo))
+		{
+			writer.record(CaptureOp::eCreateGraphicsPipeline, *graphicsInfo);
+		}
+		else
+		{
+			writer.record(CaptureOp::eCreateMeshPipeline, std::get<MeshPipelineInfo>(pipelineInfo));
+		}
+
+		// Appended under the lock so records from different threads never interleave, and closed straight away so it is on disk.
+		std::lock_guard lock(m_mutex);
+		const auto data = writer.get_data();
+		std::ofstream file{ std::filesystem::path(m_path), std::ios::binary | std::ios::app };
+		if (!file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size())))
+		{
+			GFX_LOG_ERR("GFX - Failed to record a pipeline to the pipeline manifest!");
+		}
+	}
+
+#pragma endregion
+
+#pragma region CaptureReplay
+
+	bool CaptureReplay::open(std::string_view path)
+	{
+		std::ifstream file{ std::filesystem::path(path), std::ios::binary | std::ios::ate };
+		if (!file)
+		{
+			GFX_LOG_ERR("GFX - CaptureReplay::open() - Failed to open the capture!");
+			return false;
+		}
+		m_data.resize(static_cast<std::size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(m_data.data()), static_cast<std::streamsize>(m_data.size()));
+
+		const std::unordered_map<std::uint64_t, std::uint64_t> noHandles{};
+		CaptureReader header(m_data, {}, noHandles);
+		if (header.read<std::uint32_t>() != CAPTURE_MAGIC || header.read<std::uint32_t>() != CAPTURE_VERSION)
+		{
+			GFX_LOG_ERR("GFX - CaptureReplay::open() - The file is not a capture of this version of gfx!");
+			return false;
+		}
+		m_deviceInfo = header.read<DeviceInfo>();
+		if (!header.is_valid())
+		{
+			GFX_LOG_ERR("GFX - CaptureReplay::open() - The capture is truncated!");
+			return false;
+		}
+
+		m_calls.clear();
+		m_frameCount = 0;
+		std::optional<std::size_t> framesBegin{};
+		std::optional<std::size_t> framesEnd{};
+		auto offset = header.get_offset();
+		while (offset != m_data.size())
+		{
+			Call call{};
+			if (m_data.size() - offset < sizeof(std::uint32_t) * 2)
+			{
+				GFX_LOG_ERR("GFX - CaptureReplay::open() - The capture is truncated!");
+				return false;
+			}
+			std::memcpy(&call.op, m_data.data() + offset, sizeof(std::uint32_t));
+			std::memcpy(&call.size, m_data.data() + offset + sizeof(std::uint32_t), sizeof(std::uint32_t));
+			call.offset = offset + sizeof(std::uint32_t) * 2;
+			if (m_data.size() - call.offset < call.size)
+			{
+				GFX_LOG_ERR("GFX - CaptureReplay::open() - The capture is truncated!");
+				return false;
+			}
+			offset = call.offset + call.size;
+
+			if (static_cast<CaptureOp>(call.op) == CaptureOp::eBeginFrame)
+			{
+				framesBegin = framesBegin.value_or(m_calls.size());
+				++m_frameCount;
+			}
+			else if (static_cast<CaptureOp>(call.op) == CaptureOp::eEndFrame)
+			{
+				framesEnd = m_calls.size() + 1;
+			}
+			m_calls.push_back(call);
+		}
+
+		if (!framesBegin || !framesEnd || *framesEnd < *framesBegin)
+		{
+			GFX_LOG_ERR("GFX - CaptureReplay::open() - The capture holds no whole frame!");
+			return false;
+		}
+		m_framesBegin = *framesBegin;
+		m_framesEnd = *framesEnd;
+		return true;
+	}
+
+	bool CaptureReplay::create_resources(DeviceHandle deviceHandle, bool gpuScopes)
+	{
+		m_deviceHandle = deviceHandle;
+		m_gpuScopes = gpuScopes;
+		m_handles.clear();
+		return replay(0, m_framesBegin);
+	}
+
+	bool CaptureReplay::replay_frames()
+	{
+		m_replayingFrames = true;
+		const bool replayed = replay(m_framesBegin, m_framesEnd);
+		m_replayingFrames = false;
+		return replayed;
+	}
+
+	void CaptureReplay::destroy_resources()
+	{
+		replay(m_framesEnd, m_calls.size());
+		wait_for_device_idle(m_deviceHandle);
+		m_handles.clear();
+		m_scopedCommandLists.clear();
+	}
+
+	bool CaptureReplay::replay(std::size_t firstCall, std::size_t endCall)
+	{
+		for (auto i = firstCall; i < endCall; ++i)
+		{
+			if (!replay_call(m_calls[i]))
+			{
+				GFX_LOG_ERR("GFX - CaptureReplay - Failed to replay a call, the capture is corrupt or from a newer gfx!");
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void CaptureReplay::map_handle(std::uint64_t capturedHandle, std::uint64_t replayedHandle)
+	{
+		m_handles[capturedHandle] = replayedHandle;
+	}
+
+	bool CaptureReplay::replay_call(const Call& call)
+	{
+		const auto arguments = std::span<const std::byte>(m_data).subspan(call.offset, call.size);
+		CaptureReader ar(arguments, m_deviceHandle, m_handles);
+		const auto read_bytes = [&ar] { return ar.read<std::vector<std::byte>>(); };
+
+		switch (static_cast<CaptureOp>(call.op))
+		{
+			case CaptureOp::eBeginFrame:
+				begin_frame(m_deviceHandle);
+				break;
+			case CaptureOp::eEndFrame:
+				end_frame(m_deviceHandle);
+				break;
+			case CaptureOp::eWaitForDeviceIdle:
+				wait_for_device_idle(m_deviceHandle);
+				break;
+			case CaptureOp::eCreateBuffer:
+			{
+				const auto captured = ar.read<std::uint64_t>();
+				const auto info = ar.read<BufferInfo>();
+				BufferHandle bufferHandle{};
+				if (ar.is_valid() && create_buffer(bufferHandle, m_deviceHandle, info))
+				{
+					map_handle(captured, bufferHandle);
+				}
+				break;
+			}
+			case CaptureOp::eDestroyBuffer:
+				destroy_buffer(ar.read<BufferHandle>());
+				break;
+			case CaptureOp::eUploadBuffer:
+			{
+				const auto bufferHandle = ar.read<BufferHandle>();
+				const auto offset = ar.read<std::uint64_t>();
+				const auto queueIndex = ar.read<std::uint32_t>();
+				const auto data = read_bytes();
+				upload_buffer(bufferHandle, data.data(), data.size(), offset, queueIndex);
+				break;
+			}
+			case CaptureOp::eQueueBufferUpload:
+			{
+				const auto bufferHandle = ar.read<BufferHandle>();
+				const auto offset = ar.read<std::uint64_t>();
+				const auto data = read_bytes();
+				queue_buffer_upload(bufferHandle, data.data(), data.size(), offset);
+				break;
+			}
+			case CaptureOp::eWriteBuffer:
+			{
+				const auto bufferHandle = ar.read<BufferHandle>();
+				const auto offset = ar.read<std::uint64_t>();
+				const auto data = read_bytes();
+				void* mappedPtr{ nullptr };
+				if (ar.is_valid() && map_buffer(bufferHandle, mappedPtr))
+				{
+					std::memcpy(static_cast<std::byte*>(mappedPtr) + offset, data.data(), data.size());
+					flush_buffer_range(bufferHandle, offset, data.size());
+					unmap_buffer(bufferHandle);
+				}
+				break;
+			}
+			case CaptureOp::eCreateTexture:
+			{
+				const auto captured = ar.read<std::uint64_t>();
+				const auto info = ar.read<TextureInfo>();
+				TextureHandle textureHandle{};
+				if (ar.is_valid() && create_texture(textureHandle, m_deviceHandle, info))
+				{
+					map_handle(captured, textureHandle);
+				}
+				break;
+			}
+			case CaptureOp::eDestroyTexture:
+				destroy_texture(ar.read<TextureHandle>());
+				break;
+			case CaptureOp::eCreateTextureView:
+			{
+				// Views are numbered per texture in creation order, so replaying them in order gives the captured indices.
+				const auto textureHandle = ar.read<TextureHandle>();
+				const auto info = ar.read<TextureViewInfo>();
+				TextureViewHandle textureViewHandle{};
+				create_texture_view(textureViewHandle, textureHandle, info);
+				break;
+			}
+			case CaptureOp::eUploadTexture:
+			{
+				const auto textureHandle = ar.read<TextureHandle>();
+				const auto queueIndex = ar.read<std::uint32_t>();
+				const auto data = read_bytes();
+				upload_texture(textureHandle, data.data(), data.size(), queueIndex);
+				break;
+			}
+			case CaptureOp::eQueueTextureUpload:
+			{
+				const auto textureHandle = ar.read<TextureHandle>();
+				const auto mipLevel = ar.read<std::uint32_t>();
+				const auto data = read_bytes();
+				queue_texture_upload(textureHandle, data.data(), data.size(), mipLevel);
+				break;
+			}
+			case CaptureOp::eFlushUploads:
+				flush_uploads(m_deviceHandle, ar.read<std::uint32_t>());
+				break;
+			case CaptureOp::eCreateSampler:
+			{
+				const auto captured = ar.read<std::uint64_t>();
+				const auto info = ar.read<SamplerInfo>();
+				SamplerHandle samplerHandle{};
+				if (ar.is_valid() && create_sampler(samplerHandle, m_deviceHandle, info))
+				{
+					map_handle(captured, samplerHandle);
+				}
+				break;
+			}
+			case CaptureOp::eDestroySampler:
+				destroy_sampler(ar.read<SamplerHandle>());
+				break;
+			case CaptureOp::eCreateComputePipeline:
+			{
+				const auto captured = ar.read<std::uint64_t>();
+				const auto info = ar.read<ComputePipelineInfo>();
+				PipelineHandle pipelineHandle{};
+				if (ar.is_valid() && create_compute_pipeline(pipelineHandle, m_deviceHandle, info))
+				{
+					map_handle(captured, pipelineHandle);
+				}
+				break;
+			}
+			case CaptureOp::eCreateGraphicsPipeline:
+			{
+				const auto captured = ar.read<std::uint64_t>();
+				const auto info = ar.read<GraphicsPipelineInfo>();
+				PipelineHandle pipelineHandle{};
+				if (ar.is_valid() && create_graphics_pipeline(pipelineHandle, m_deviceHandle, info))
+				{
+					map_handle(captured, pipelineHandle);
+				}
+				break;
+			}
+			case CaptureOp::eCreateMeshPipeline:
+			{
+				const auto captured = ar.read<std::uint64_t>();
+				const auto info = ar.read<MeshPipelineInfo>();
+				PipelineHandle pipelineHandle{};
+				if (ar.is_valid() && create_mesh_pipeline(pipelineHandle, m_deviceHandle, info))
+				{
+					map_handle(captured, pipelineHandle);
+				}
+				break;
+			}
+			case CaptureOp::eDestroyPipeline:
+				destroy_pipeline(ar.read<PipelineHandle>());
+				break;
+			case CaptureOp::eCreateDescriptorSet:
+			case CaptureOp::eCreateTransientDescriptorSet:
+			{
+				const auto captured = ar.read<std::uint64_t>();
+				const auto info = ar.read<DescriptorSetInfo>();
+				DescriptorSetHandle descriptorSetHandle{};
+				const bool transient = static_cast<CaptureOp>(call.op) == CaptureOp::eCreateTransientDescriptorSet;
+				if (ar.is_valid() && (transient ? create_transient_descriptor_set(descriptorSetHandle, m_deviceHandle, info) : create_descriptor_set(descriptorSetHandle, m_deviceHandle, info)))
+				{
+					map_handle(captured, descriptorSetHandle);
+				}
+				break;
+			}
+			case CaptureOp::eCreateDescriptorSetFromPipeline:
+			{
+				const auto captured = ar.read<std::uint64_t>();
+				const auto pipelineHandle = ar.read<PipelineHandle>();
+				const auto set = ar.read<std::uint32_t>();
+				DescriptorSetHandle descriptorSetHandle{};
+				if (ar.is_valid() && create_descriptor_set_from_pipeline(descriptorSetHandle, pipelineHandle, set))
+				{
+					map_handle(captured, descriptorSetHandle);
+				}
+				break;
+			}
+			case CaptureOp::eDestroyDescriptorSet:
+				destroy_descriptor_set(ar.read<DescriptorSetHandle>());
+				break;
+			case CaptureOp::eBindBufferToDescriptorSet:
+			{
+				const auto descriptorSetHandle = ar.read<DescriptorSetHandle>();
+				const auto binding = ar.read<std::uint32_t>();
+				const auto bufferHandle = ar.read<BufferHandle>();
+				const auto offset = ar.read<std::uint64_t>();
+				const auto range = ar.read<std::uint64_t>();
+				bind_buffer_to_descriptor_set(descriptorSetHandle, binding, bufferHandle, offset, range);
+				break;
+			}
+			case CaptureOp::eBindTextureToDescriptorSet:
+			{
+				const auto descriptorSetHandle = ar.read<DescriptorSetHandle>();
+				const auto binding = ar.read<std::uint32_t>();
+				const auto textureHandle = ar.read<TextureHandle>();
+				const auto viewIndex = ar.read<std::uint32_t>();
+				const auto samplerHandle = ar.read<SamplerHandle>();
+				bind_texture_view_to_descriptor_set(descriptorSetHandle, binding, { textureHandle, viewIndex }, samplerHandle);
+				break;
+			}
+			case CaptureOp::eUpdateDescriptorSet:
+			{
+				const auto descriptorSetHandle = ar.read<DescriptorSetHandle>();
+				const auto writes = ar.read<std::vector<DescriptorWrite>>();
+				update_descriptor_set(descriptorSetHandle, writes);
+				break;
+			}
+			case CaptureOp::eWriteInlineUniformBlock:
+			{
+				const auto descriptorSetHandle = ar.read<DescriptorSetHandle>();
+				const auto binding = ar.read<std::uint32_t>();
+				const auto offset = ar.read<std::uint32_t>();
+				const auto data = read_bytes();
+				write_inline_uniform_block(descriptorSetHandle, binding, offset, std::uint32_t(data.size()), data.data());
+				break;
+			}
+			case CaptureOp::eCopyTexture:
+			case CaptureOp::eResolveTexture:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto srcTextureHandle = ar.read<TextureHandle>();
+				const auto dstTextureHandle = ar.read<TextureHandle>();
+				const auto regions = ar.read<std::vector<TextureRegionCopy>>();
+				if (static_cast<CaptureOp>(call.op) == CaptureOp::eCopyTexture)
+				{
+					copy_texture(commandListHandle, srcTextureHandle, dstTextureHandle, regions);
+				}
+				else
+				{
+					resolve_texture(commandListHandle, srcTextureHandle, dstTextureHandle, regions);
+				}
+				break;
+			}
+			case CaptureOp::eBlitTexture:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto srcTextureHandle = ar.read<TextureHandle>();
+				const auto dstTextureHandle = ar.read<TextureHandle>();
+				const auto regions = ar.read<std::vector<TextureBlitRegion>>();
+				blit_texture(commandListHandle, srcTextureHandle, dstTextureHandle, regions, ar.read<SamplerFilterMode>());
+				break;
+			}
+			case CaptureOp::eCreateCommandList:
+			case CaptureOp::eCreateTransientCommandList:
+			{
+				const auto captured = ar.read<std::uint64_t>();
+				const auto queueIndex = ar.read<std::uint32_t>();
+				CommandListHandle commandListHandle{};
+				bool created{ false };
+				if (static_cast<CaptureOp>(call.op) == CaptureOp::eCreateTransientCommandList)
+				{
+					created = ar.is_valid() && create_transient_command_list(commandListHandle, m_deviceHandle, queueIndex);
+				}
+				else
+				{
+					const auto flags = ar.read<std::uint32_t>();
+					created = ar.is_valid() && create_command_list(commandListHandle, m_deviceHandle, queueIndex, flags);
+				}
+				if (created)
+				{
+					map_handle(captured, commandListHandle);
+				}
+				break;
+			}
+			case CaptureOp::eDestroyCommandList:
+				destroy_command_list(m_deviceHandle, ar.read<CommandListHandle>());
+				break;
+			case CaptureOp::eCreateSwapChain:
+			{
+				const auto captured = ar.read<std::uint64_t>();
+				auto info = ar.read<SwapChainInfo>();
+				info.headless = true;
+				info.lowLatency = false;
+				SwapChainHandle swapChainHandle{};
+				if (ar.is_valid() && create_swap_chain(swapChainHandle, m_deviceHandle, info))
+				{
+					map_handle(captured, swapChainHandle);
+				}
+				break;
+			}
+			case CaptureOp::eDestroySwapChain:
+				destroy_swap_chain(ar.read<SwapChainHandle>());
+				break;
+			case CaptureOp::eGetSwapChainImage:
+			{
+				const auto swapChainHandle = ar.read<SwapChainHandle>();
+				const auto captured = ar.read<std::uint64_t>();
+				TextureHandle textureHandle{};
+				if (ar.is_valid() && get_swap_chain_image(textureHandle, swapChainHandle))
+				{
+					map_handle(captured, textureHandle);
+				}
+				break;
+			}
+			case CaptureOp::ePresentSwapChain:
+			{
+				const auto swapChainHandle = ar.read<SwapChainHandle>();
+				const auto queueIndex = ar.read<std::uint32_t>();
+				auto waitSemaphoreHandle = ar.read<SemaphoreHandle>();
+				present_swap_chain(swapChainHandle, queueIndex, waitSemaphoreHandle != 0 ? &waitSemaphoreHandle : nullptr);
+				break;
+			}
+			case CaptureOp::eSubmitCommandList:
+			{
+				const auto submitInfo = ar.read<SubmitInfo>();
+				const auto signalSemaphore = ar.read<bool>();
+				const auto captured = ar.read<std::uint64_t>();
+				SemaphoreHandle semaphoreHandle{};
+				submit_command_list(submitInfo, signalSemaphore ? &semaphoreHandle : nullptr);
+				if (signalSemaphore)
+				{
+					map_handle(captured, semaphoreHandle);
+				}
+				break;
+			}
+			case CaptureOp::eSubmitCommandLists:
+			{
+				const auto queueIndex = ar.read<std::uint32_t>();
+				const auto capturedBatches = ar.read<std::vector<CaptureSubmitBatch>>();
+				std::vector<SemaphoreHandle> semaphoreHandles(capturedBatches.size());
+				std::vector<SubmitBatch> batches(capturedBatches.size());
+				for (std::size_t i = 0; i < batches.size(); ++i)
+				{
+					const auto& capturedBatch = capturedBatches[i];
+					batches[i] = {
+						.commandLists = capturedBatch.commandLists,
+						.waitSemaphores = capturedBatch.waitSemaphores,
+						.outSignalSemaphoreHandle = capturedBatch.signalSemaphore ? &semaphoreHandles[i] : nullptr,
+						.swapChainHandle = capturedBatch.swapChainHandle,
+					};
+				}
+				submit_command_lists(m_deviceHandle, queueIndex, batches);
+				for (std::size_t i = 0; i < batches.size(); ++i)
+				{
+					if (capturedBatches[i].signalSemaphore)
+					{
+						map_handle(capturedBatches[i].signalSemaphoreHandle, semaphoreHandles[i]);
+					}
+				}
+				break;
+			}
+			case CaptureOp::eReset:
+				reset(ar.read<CommandListHandle>());
+				break;
+			case CaptureOp::eBegin:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				begin(commandListHandle);
+				if (m_gpuScopes && m_replayingFrames)
+				{
+					begin_gpu_scope(commandListHandle, "gfx_replay");
+					m_scopedCommandLists.insert(commandListHandle);
+				}
+				break;
+			}
+			case CaptureOp::eEnd:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				if (m_scopedCommandLists.erase(commandListHandle) != 0)
+				{
+					end_gpu_scope(commandListHandle);
+				}
+				end(commandListHandle);
+				break;
+			}
+			case CaptureOp::eBeginRenderPass:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto renderPassInfo = ar.read<RenderPassInfo>();
+				begin_render_pass(commandListHandle, renderPassInfo);
+				break;
+			}
+			case CaptureOp::eEndRenderPass:
+				end_render_pass(ar.read<CommandListHandle>());
+				break;
+			case CaptureOp::eSetViewport:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				std::array<float, 6> viewport{};
+				ar(viewport);
+				set_viewport(commandListHandle, viewport[0], viewport[1], viewport[2], viewport[3], viewport[4], viewport[5]);
+				break;
+			}
+			case CaptureOp::eSetScissor:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto x = ar.read<std::int32_t>();
+				const auto y = ar.read<std::int32_t>();
+				const auto width = ar.read<std::uint32_t>();
+				const auto height = ar.read<std::uint32_t>();
+				set_scissor(commandListHandle, x, y, width, height);
+				break;
+			}
+			case CaptureOp::eBindPipeline:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				bind_pipeline(commandListHandle, ar.read<PipelineHandle>());
+				break;
+			}
+			case CaptureOp::eBindDescriptorSets:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto firstSet = ar.read<std::uint32_t>();
+				const auto descriptorSets = ar.read<std::vector<DescriptorSetHandle>>();
+				const auto dynamicOffsets = ar.read<std::vector<std::uint32_t>>();
+				bind_descriptor_sets(commandListHandle, firstSet, descriptorSets, dynamicOffsets);
+				break;
+			}
+			case CaptureOp::eSetConstants:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto shaderStages = ar.read<std::uint32_t>();
+				const auto offset = ar.read<std::uint32_t>();
+				const auto data = read_bytes();
+				set_constants(commandListHandle, shaderStages, offset, static_cast<std::uint32_t>(data.size()), data.data());
+				break;
+			}
+			case CaptureOp::eBindIndexBuffer:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto bufferHandle = ar.read<BufferHandle>();
+				const auto indexType = ar.read<IndexType>();
+				const auto offset = ar.read<std::uint64_t>();
+				bind_index_buffer(commandListHandle, bufferHandle, indexType, offset);
+				break;
+			}
+			case CaptureOp::eBindVertexBuffers:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto firstBinding = ar.read<std::uint32_t>();
+				const auto buffers = ar.read<std::vector<BufferHandle>>();
+				const auto offsets = ar.read<std::vector<std::uint64_t>>();
+				bind_vertex_buffers(commandListHandle, firstBinding, buffers, offsets);
+				break;
+			}
+			case CaptureOp::eDraw:
+			case CaptureOp::eDispatch:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				std::array<std::uint32_t, 4> args{};
+				if (static_cast<CaptureOp>(call.op) == CaptureOp::eDraw)
+				{
+					ar(args);
+					draw(commandListHandle, args[0], args[1], args[2], args[3]);
+				}
+				else
+				{
+					ar(args[0], args[1], args[2]);
+					dispatch(commandListHandle, args[0], args[1], args[2]);
+				}
+				break;
+			}
+			case CaptureOp::eDrawIndexed:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto indexCount = ar.read<std::uint32_t>();
+				const auto instanceCount = ar.read<std::uint32_t>();
+				const auto firstIndex = ar.read<std::uint32_t>();
+				const auto vertexOffset = ar.read<std::int32_t>();
+				const auto firstInstance = ar.read<std::uint32_t>();
+				draw_indexed(commandListHandle, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+				break;
+			}
+			case CaptureOp::eDrawIndirect:
+			case CaptureOp::eDrawIndexedIndirect:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto bufferHandle = ar.read<BufferHandle>();
+				const auto offset = ar.read<std::uint64_t>();
+				const auto drawCount = ar.read<std::uint32_t>();
+				const auto stride = ar.read<std::uint32_t>();
+				if (static_cast<CaptureOp>(call.op) == CaptureOp::eDrawIndirect)
+				{
+					draw_indirect(commandListHandle, bufferHandle, offset, drawCount, stride);
+				}
+				else
+				{
+					draw_indexed_indirect(commandListHandle, bufferHandle, offset, drawCount, stride);
+				}
+				break;
+			}
+			case CaptureOp::eDispatchIndirect:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto bufferHandle = ar.read<BufferHandle>();
+				dispatch_indirect(commandListHandle, bufferHandle, ar.read<std::uint64_t>());
+				break;
+			}
+			case CaptureOp::eTransitionTexture:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto textureHandle = ar.read<TextureHandle>();
+				const auto tracked = !ar.read<bool>();
+				const auto oldState = ar.read<TextureState>();
+				const auto newState = ar.read<TextureState>();
+				if (tracked)
+				{
+					transition_texture(commandListHandle, textureHandle, newState);
+				}
+				else
+				{
+					transition_texture(commandListHandle, textureHandle, oldState, newState);
+				}
+				break;
+			}
+			case CaptureOp::eTransitionTextureRange:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto textureHandle = ar.read<TextureHandle>();
+				const auto newState = ar.read<TextureState>();
+				const auto range = ar.read<TextureSubresourceRange>();
+				transition_texture(commandListHandle, textureHandle, newState, range);
+				break;
+			}
+			case CaptureOp::eCopyBuffer:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto srcBufferHandle = ar.read<BufferHandle>();
+				const auto dstBufferHandle = ar.read<BufferHandle>();
+				const auto regions = ar.read<std::vector<BufferCopyRegion>>();
+				copy_buffer(commandListHandle, srcBufferHandle, dstBufferHandle, regions);
+				break;
+			}
+			case CaptureOp::eCopyBufferToTexture:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto bufferHandle = ar.read<BufferHandle>();
+				copy_buffer_to_texture(commandListHandle, bufferHandle, ar.read<TextureHandle>());
+				break;
+			}
+			case CaptureOp::eGenerateMipmaps:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				generate_mipmaps(commandListHandle, ar.read<TextureHandle>());
+				break;
+			}
+			case CaptureOp::eFillBuffer:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto bufferHandle = ar.read<BufferHandle>();
+				const auto offset = ar.read<std::uint64_t>();
+				const auto size = ar.read<std::uint64_t>();
+				fill_buffer(commandListHandle, bufferHandle, offset, size, ar.read<std::uint32_t>());
+				break;
+			}
+			case CaptureOp::eBufferBarrier:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto bufferHandle = ar.read<BufferHandle>();
+				const auto srcStages = ar.read<std::uint32_t>();
+				buffer_barrier(commandListHandle, bufferHandle, srcStages, ar.read<std::uint32_t>());
+				break;
+			}
+			case CaptureOp::eBufferBarrierRange:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto bufferHandle = ar.read<BufferHandle>();
+				const auto srcStages = ar.read<std::uint32_t>();
+				const auto srcAccess = ar.read<std::uint32_t>();
+				const auto dstStages = ar.read<std::uint32_t>();
+				const auto dstAccess = ar.read<std::uint32_t>();
+				const auto offset = ar.read<std::uint64_t>();
+				buffer_barrier(commandListHandle, bufferHandle, srcStages, srcAccess, dstStages, dstAccess, offset, ar.read<std::uint64_t>());
+				break;
+			}
+			case CaptureOp::eMemoryBarrier:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto srcStages = ar.read<std::uint32_t>();
+				const auto srcAccess = ar.read<std::uint32_t>();
+				const auto dstStages = ar.read<std::uint32_t>();
+				memory_barrier(commandListHandle, srcStages, srcAccess, dstStages, ar.read<std::uint32_t>());
+				break;
+			}
+			case CaptureOp::eUpdateBuffer:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				const auto bufferHandle = ar.read<BufferHandle>();
+				const auto offset = ar.read<std::uint64_t>();
+				const auto data = read_bytes();
+				update_buffer(commandListHandle, bufferHandle, offset, data.size(), data.data());
+				break;
+			}
+			case CaptureOp::ePushMarker:
+			{
+				const auto commandListHandle = ar.read<CommandListHandle>();
+				push_marker(commandListHandle, ar.read<std::string>());
+				break;
+			}
+			case CaptureOp::ePopMarker:
+				pop_marker(ar.read<CommandListHandle>());
+				break;
+			default:
+				return false;
+		}
+		return ar.is_valid() && ar.is_at_end();
+	}
+
+#pragma endregion
+
+} // namespace sm::gfx
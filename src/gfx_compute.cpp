@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx_compute.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace sm::gfx
+{
+	namespace
+	{
+		// Must match the pass values of gfx_scan.hlsl and gfx_radix_sort.hlsl.
+		constexpr std::uint32_t ScanPass_ScanBlocks = 0;
+		constexpr std::uint32_t ScanPass_AddBlockSums = 1;
+		constexpr std::uint32_t ScanPass_CompactScatter = 2;
+		constexpr std::uint32_t RadixSortPass_Count = 0;
+		constexpr std::uint32_t RadixSortPass_Scatter = 1;
+
+		// Must match the push constants of the shaders. Offsets are in elements.
+		struct ScanConstants
+		{
+			std::uint32_t count;
+			std::uint32_t inputOffset;
+			std::uint32_t outputOffset;
+			std::uint32_t sumsOffset;
+			std::uint32_t pass;
+			std::uint32_t predicate;
+		};
+		struct ReduceConstants
+		{
+			std::uint32_t count;
+			std::uint32_t inputOffset;
+			std::uint32_t outputOffset;
+			std::uint32_t op;
+		};
+		struct RadixSortConstants
+		{
+			std::uint32_t count;
+			std::uint32_t shift;
+			std::uint32_t pass;
+			std::uint32_t blockCount;
+			std::uint32_t hasValues;
+		};
+
+		auto block_count(std::uint32_t count) -> std::uint32_t
+		{
+			return (count + ComputePrimitives::BLOCK_ELEMENTS - 1) / ComputePrimitives::BLOCK_ELEMENTS;
+		}
+
+		/**
+		 * @brief Elements of scratch for the results of each level of blocks of count elements, down to and including a
+		 * single block when includeLast is set.
+		 */
+		auto level_scratch_size(std::uint32_t count, bool includeLast) -> std::uint64_t
+		{
+			std::uint64_t size = 0;
+			auto blocks = block_count(count);
+			while (blocks > 1)
+			{
+				size += blocks;
+				blocks = block_count(blocks);
+			}
+			return size + (includeLast ? 1 : 0);
+		}
+
+		// Make the writes of one pass visible to the next.
+		void compute_barrier(CommandListHandle commandListHandle)
+		{
+			memory_barrier(commandListHandle, PipelineStageFlags_ComputeShader, AccessFlags_ShaderWrite, PipelineStageFlags_ComputeShader, AccessFlags_ShaderRead | AccessFlags_ShaderWrite);
+		}
+
+		auto make_storage_set_info(std::uint32_t bindingCount) -> DescriptorSetInfo
+		{
+			DescriptorSetInfo setInfo{};
+			setInfo.bindings.assign(bindingCount, { DescriptorType::eStorageBuffer, 1, ShaderStageFlags_Compute });
+			return setInfo;
+		}
+	} // namespace
+
+	ComputePrimitives::ComputePrimitives(DeviceHandle deviceHandle, const ComputePrimitivesInfo& primitivesInfo)
+		: m_deviceHandle(deviceHandle), m_maxElements(primitivesInfo.maxElements)
+	{
+		GFX_ASSERT(m_maxElements > 0 && m_maxElements <= MAX_ELEMENTS, "ComputePrimitivesInfo::maxElements out of range!");
+
+		DeviceProperties properties{};
+		if (!get_device_properties(properties, deviceHandle))
+		{
+			return;
+		}
+		constexpr auto REQUIRED_OPERATIONS = SubgroupOperationFlags_Basic | SubgroupOperationFlags_Arithmetic | SubgroupOperationFlags_Ballot;
+		m_useSubgroups = (properties.subgroupStages & ShaderStageFlags_Compute) != 0 && (properties.subgroupOperations & REQUIRED_OPERATIONS) == REQUIRED_OPERATIONS;
+
+		const auto create_pipeline = [&](PipelineHandle& outPipelineHandle, const std::vector<char>& shaderCode, const DescriptorSetInfo& setInfo, std::uint32_t constantsSize, const char* debugName) {
+			const ComputePipelineInfo pipelineInfo{
+				.shaderCode = shaderCode,
+				.descriptorSets = { setInfo },
+				.constantBlock = { constantsSize, ShaderStageFlags_Compute },
+				.specializationConstants = { { 0, m_useSubgroups ? 1u : 0u } },
+				.debugName = debugName,
+			};
+			return create_compute_pipeline(outPipelineHandle, deviceHandle, pipelineInfo);
+		};
+		const auto create_scratch_buffer = [&](BufferHandle& outBufferHandle, std::uint64_t elementCount, const char* debugName) {
+			return create_buffer(outBufferHandle, deviceHandle, { .type = BufferType::eStorage, .size = elementCount * sizeof(std::uint32_t), .memory = BufferMemory::eGpuOnly, .debugName = debugName });
+		};
+
+		const auto maxBlocks = block_count(m_maxElements);
+		const bool hasScan = !primitivesInfo.scanShaderCode.empty();
+		const bool hasSort = !primitivesInfo.radixSortShaderCode.empty();
+		GFX_ASSERT(!hasSort || hasScan, "ComputePrimitives::sort() needs the scan shader too!");
+		if (hasScan)
+		{
+			m_scanSetInfo = make_storage_set_info(6);
+			// The largest scan is of the elements, or of the digit counts of their blocks when sorting few elements.
+			const auto largestScan = std::max(m_maxElements, hasSort ? RADIX_BINS * maxBlocks : 0u);
+			if (!create_pipeline(m_scanPipeline, primitivesInfo.scanShaderCode, m_scanSetInfo, sizeof(ScanConstants), "gfx_scan") ||
+				!create_scratch_buffer(m_sumsBuffer, level_scratch_size(largestScan, true), "gfx_scan_sums") ||
+				!create_scratch_buffer(m_compactScanBuffer, m_maxElements, "gfx_compact_scan"))
+			{
+				return;
+			}
+		}
+		if (!primitivesInfo.reduceShaderCode.empty())
+		{
+			m_reduceSetInfo = make_storage_set_info(2);
+			if (!create_pipeline(m_reducePipeline, primitivesInfo.reduceShaderCode, m_reduceSetInfo, sizeof(ReduceConstants), "gfx_reduce") ||
+				!create_scratch_buffer(m_partialsBuffer, std::max<std::uint64_t>(level_scratch_size(m_maxElements, false), 1), "gfx_reduce_partials"))
+			{
+				return;
+			}
+		}
+		if (hasSort)
+		{
+			m_radixSortSetInfo = make_storage_set_info(5);
+			if (!create_pipeline(m_radixSortPipeline, primitivesInfo.radixSortShaderCode, m_radixSortSetInfo, sizeof(RadixSortConstants), "gfx_radix_sort") ||
+				!create_scratch_buffer(m_histogramBuffer, std::uint64_t(RADIX_BINS) * maxBlocks, "gfx_radix_sort_histograms") ||
+				!create_scratch_buffer(m_sortKeyBuffer, m_maxElements, "gfx_radix_sort_keys") ||
+				!create_scratch_buffer(m_sortValueBuffer, m_maxElements, "gfx_radix_sort_values"))
+			{
+				return;
+			}
+		}
+
+		m_valid = true;
+	}
+
+	ComputePrimitives::~ComputePrimitives()
+	{
+		for (const auto bufferHandle : { m_sumsBuffer, m_compactScanBuffer, m_partialsBuffer, m_histogramBuffer, m_sortKeyBuffer, m_sortValueBuffer })
+		{
+			if (bufferHandle)
+			{
+				destroy_buffer(bufferHandle);
+			}
+		}
+		for (const auto pipelineHandle : { m_scanPipeline, m_reducePipeline, m_radixSortPipeline })
+		{
+			if (pipelineHandle)
+			{
+				destroy_pipeline(pipelineHandle);
+			}
+		}
+	}
+
+	bool ComputePrimitives::is_valid() const
+	{
+		return m_valid;
+	}
+
+	void ComputePrimitives::scan(CommandListHandle commandListHandle, BufferHandle srcBufferHandle, BufferHandle dstBufferHandle, std::uint32_t count)
+	{
+		GFX_ASSERT(m_valid && m_scanPipeline, "ComputePrimitives was created without the scan shader!");
+		GFX_ASSERT(count > 0 && count <= m_maxElements, "ComputePrimitives::scan() count out of range!");
+
+		record_scan(commandListHandle, srcBufferHandle, 0, dstBufferHandle, 0, count, 0, false);
+	}
+
+	void ComputePrimitives::reduce(CommandListHandle commandListHandle, BufferHandle srcBufferHandle, BufferHandle dstBufferHandle, std::uint32_t count, ReduceOp op)
+	{
+		GFX_ASSERT(m_valid && m_reducePipeline, "ComputePrimitives was created without the reduce shader!");
+		GFX_ASSERT(count > 0 && count <= m_maxElements, "ComputePrimitives::reduce() count out of range!");
+
+		bind_pipeline(commandListHandle, m_reducePipeline);
+
+		// Each level reduces blocks to one partial each, until a single block is left to reduce into dst.
+		auto inputBufferHandle = srcBufferHandle;
+		std::uint32_t inputOffset = 0;
+		std::uint32_t partialsOffset = 0;
+		while (true)
+		{
+			const auto blocks = block_count(count);
+			const auto outputBufferHandle = blocks == 1 ? dstBufferHandle : m_partialsBuffer;
+			const std::array<DescriptorWrite, 2> writes{
+				DescriptorWrite{ .binding = 0, .bufferHandle = inputBufferHandle },
+				DescriptorWrite{ .binding = 1, .bufferHandle = outputBufferHandle },
+			};
+			DescriptorSetHandle descriptorSetHandle{};
+			if (!get_cached_descriptor_set(descriptorSetHandle, m_deviceHandle, m_reduceSetInfo, writes))
+			{
+				return;
+			}
+			const ReduceConstants constants{
+				.count = count,
+				.inputOffset = inputOffset,
+				.outputOffset = blocks == 1 ? 0 : partialsOffset,
+				.op = std::uint32_t(op),
+			};
+			bind_descriptor_sets(commandListHandle, 0, { &descriptorSetHandle, 1 });
+			set_constants(commandListHandle, ShaderStageFlags_Compute, 0, sizeof(ReduceConstants), &constants);
+			dispatch(commandListHandle, blocks, 1, 1);
+			if (blocks == 1)
+			{
+				break;
+			}
+
+			compute_barrier(commandListHandle);
+			inputBufferHandle = m_partialsBuffer;
+			inputOffset = partialsOffset;
+			partialsOffset += blocks;
+			count = blocks;
+		}
+	}
+
+	void ComputePrimitives::sort(CommandListHandle commandListHandle, BufferHandle keyBufferHandle, BufferHandle valueBufferHandle, std::uint32_t count, std::uint32_t keyBits)
+	{
+		GFX_ASSERT(m_valid && m_radixSortPipeline, "ComputePrimitives was created without the radix sort shader!");
+		GFX_ASSERT(count > 0 && count <= m_maxElements, "ComputePrimitives::sort() count out of range!");
+		GFX_ASSERT(keyBits > 0 && keyBits <= 32, "ComputePrimitives::sort() keyBits out of range!");
+
+		const auto blocks = block_count(count);
+		const auto passCount = (keyBits + RADIX_BITS - 1) / RADIX_BITS;
+		const bool hasValues = bool(valueBufferHandle);
+
+		// Stable digit passes, least significant first, ping-ponging between the caller's buffers and the scratch ones.
+		std::array<BufferHandle, 2> keyBuffers{ keyBufferHandle, m_sortKeyBuffer };
+		std::array<BufferHandle, 2> valueBuffers{ hasValues ? valueBufferHandle : keyBufferHandle, hasValues ? m_sortValueBuffer : m_sortKeyBuffer };
+		for (std::uint32_t pass = 0; pass < passCount; ++pass)
+		{
+			const std::array<DescriptorWrite, 5> writes{
+				DescriptorWrite{ .binding = 0, .bufferHandle = keyBuffers[0] },
+				DescriptorWrite{ .binding = 1, .bufferHandle = keyBuffers[1] },
+				DescriptorWrite{ .binding = 2, .bufferHandle = valueBuffers[0] },
+				DescriptorWrite{ .binding = 3, .bufferHandle = valueBuffers[1] },
+				DescriptorWrite{ .binding = 4, .bufferHandle = m_histogramBuffer },
+			};
+			DescriptorSetHandle descriptorSetHandle{};
+			if (!get_cached_descriptor_set(descriptorSetHandle, m_deviceHandle, m_radixSortSetInfo, writes))
+			{
+				return;
+			}
+			RadixSortConstants constants{
+				.count = count,
+				.shift = pass * RADIX_BITS,
+				.pass = RadixSortPass_Count,
+				.blockCount = blocks,
+				.hasValues = hasValues ? 1u : 0u,
+			};
+
+			bind_pipeline(commandListHandle, m_radixSortPipeline);
+			bind_descriptor_sets(commandListHandle, 0, { &descriptorSetHandle, 1 });
+			set_constants(commandListHandle, ShaderStageFlags_Compute, 0, sizeof(RadixSortConstants), &constants);
+			dispatch(commandListHandle, blocks, 1, 1);
+			compute_barrier(commandListHandle);
+
+			// Digit major counts scan into where each block's run of each digit starts.
+			record_scan(commandListHandle, m_histogramBuffer, 0, m_histogramBuffer, 0, RADIX_BINS * blocks, 0, false);
+			compute_barrier(commandListHandle);
+
+			constants.pass = RadixSortPass_Scatter;
+			bind_pipeline(commandListHandle, m_radixSortPipeline);
+			bind_descriptor_sets(commandListHandle, 0, { &descriptorSetHandle, 1 });
+			set_constants(commandListHandle, ShaderStageFlags_Compute, 0, sizeof(RadixSortConstants), &constants);
+			dispatch(commandListHandle, blocks, 1, 1);
+			compute_barrier(commandListHandle);
+
+			std::swap(keyBuffers[0], keyBuffers[1]);
+			std::swap(valueBuffers[0], valueBuffers[1]);
+		}
+
+		if (passCount % 2 != 0)
+		{
+			// The last pass wrote the scratch buffers.
+			memory_barrier(commandListHandle, PipelineStageFlags_ComputeShader, AccessFlags_ShaderWrite, PipelineStageFlags_Transfer, AccessFlags_TransferRead | AccessFlags_TransferWrite);
+			const BufferCopyRegion region{ .size = std::uint64_t(count) * sizeof(std::uint32_t) };
+			copy_buffer(commandListHandle, m_sortKeyBuffer, keyBufferHandle, { &region, 1 });
+			if (hasValues)
+			{
+				copy_buffer(commandListHandle, m_sortValueBuffer, valueBufferHandle, { &region, 1 });
+			}
+			memory_barrier(commandListHandle, PipelineStageFlags_Transfer, AccessFlags_TransferWrite, PipelineStageFlags_ComputeShader, AccessFlags_ShaderRead | AccessFlags_ShaderWrite);
+		}
+	}
+
+	void ComputePrimitives::compact(CommandListHandle commandListHandle, BufferHandle valueBufferHandle, BufferHandle flagBufferHandle, std::uint32_t count, BufferHandle dstBufferHandle, BufferHandle countBufferHandle)
+	{
+		GFX_ASSERT(m_valid && m_scanPipeline, "ComputePrimitives was created without the scan shader!");
+		GFX_ASSERT(count > 0 && count <= m_maxElements, "ComputePrimitives::compact() count out of range!");
+
+		// Each kept value goes to the number of kept values before it.
+		record_scan(commandListHandle, flagBufferHandle, 0, m_compactScanBuffer, 0, count, 0, true);
+		compute_barrier(commandListHandle);
+
+		const std::array<DescriptorWrite, 6> writes{
+			DescriptorWrite{ .binding = 0, .bufferHandle = flagBufferHandle },
+			DescriptorWrite{ .binding = 1, .bufferHandle = m_compactScanBuffer },
+			DescriptorWrite{ .binding = 2, .bufferHandle = m_sumsBuffer },
+			DescriptorWrite{ .binding = 3, .bufferHandle = valueBufferHandle },
+			DescriptorWrite{ .binding = 4, .bufferHandle = dstBufferHandle },
+			DescriptorWrite{ .binding = 5, .bufferHandle = countBufferHandle },
+		};
+		DescriptorSetHandle descriptorSetHandle{};
+		if (!get_cached_descriptor_set(descriptorSetHandle, m_deviceHandle, m_scanSetInfo, writes))
+		{
+			return;
+		}
+		const ScanConstants constants{
+			.count = count,
+			.inputOffset = 0,
+			.outputOffset = 0,
+			.sumsOffset = 0,
+			.pass = ScanPass_CompactScatter,
+			.predicate = 1,
+		};
+		bind_pipeline(commandListHandle, m_scanPipeline);
+		bind_descriptor_sets(commandListHandle, 0, { &descriptorSetHandle, 1 });
+		set_constants(commandListHandle, ShaderStageFlags_Compute, 0, sizeof(ScanConstants), &constants);
+		dispatch(commandListHandle, block_count(count), 1, 1);
+	}
+
+	void ComputePrimitives::record_scan(CommandListHandle commandListHandle, BufferHandle inputBufferHandle, std::uint32_t inputOffset, BufferHandle outputBufferHandle, std::uint32_t outputOffset, std::uint32_t count, std::uint32_t sumsOffset, bool predicate)
+	{
+		// Scan each block, leaving its total in the sums. With more than one block, scan the sums the same way and add each
+		// block's scanned sum to its elements.
+		dispatch_scan_pass(commandListHandle, ScanPass_ScanBlocks, inputBufferHandle, inputOffset, outputBufferHandle, outputOffset, count, sumsOffset, predicate);
+
+		const auto blocks = block_count(count);
+		if (blocks > 1)
+		{
+			compute_barrier(commandListHandle);
+			record_scan(commandListHandle, m_sumsBuffer, sumsOffset, m_sumsBuffer, sumsOffset, blocks, sumsOffset + blocks, false);
+			compute_barrier(commandListHandle);
+			dispatch_scan_pass(commandListHandle, ScanPass_AddBlockSums, outputBufferHandle, outputOffset, outputBufferHandle, outputOffset, count, sumsOffset, false);
+		}
+	}
+
+	void ComputePrimitives::dispatch_scan_pass(CommandListHandle commandListHandle, std::uint32_t pass, BufferHandle inputBufferHandle, std::uint32_t inputOffset, BufferHandle outputBufferHandle, std::uint32_t outputOffset, std::uint32_t count, std::uint32_t sumsOffset, bool predicate)
+	{
+		// The compaction bindings are unused by these passes, but must still hold buffers.
+		const std::array<DescriptorWrite, 6> writes{
+			DescriptorWrite{ .binding = 0, .bufferHandle = inputBufferHandle },
+			DescriptorWrite{ .binding = 1, .bufferHandle = outputBufferHandle },
+			DescriptorWrite{ .binding = 2, .bufferHandle = m_sumsBuffer },
+			DescriptorWrite{ .binding = 3, .bufferHandle = m_sumsBuffer },
+			DescriptorWrite{ .binding = 4, .bufferHandle = m_sumsBuffer },
+			DescriptorWrite{ .binding = 5, .bufferHandle = m_sumsBuffer },
+		};
+		DescriptorSetHandle descriptorSetHandle{};
+		if (!get_cached_descriptor_set(descriptorSetHandle, m_deviceHandle, m_scanSetInfo, writes))
+		{
+			return;
+		}
+		const ScanConstants constants{
+			.count = count,
+			.inputOffset = inputOffset,
+			.outputOffset = outputOffset,
+			.sumsOffset = sumsOffset,
+			.pass = pass,
+			.predicate = predicate ? 1u : 0u,
+		};
+		bind_pipeline(commandListHandle, m_scanPipeline);
+		bind_descriptor_sets(commandListHandle, 0, { &descriptorSetHandle, 1 });
+		set_constants(commandListHandle, ShaderStageFlags_Compute, 0, sizeof(ScanConstants), &constants);
+		dispatch(commandListHandle, block_count(count), 1, 1);
+	}
+
+} // namespace sm::gfx
@@ -0,0 +1,405 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx_cpu_culling.hpp"
+
+#include "gfx_p.hpp"
+
+#if defined(__AVX__)
+	#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define GFX_CPU_CULLING_SSE2
+	#include <emmintrin.h>
+#elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+	#define GFX_CPU_CULLING_NEON
+	#include <arm_neon.h>
+#endif
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace sm::gfx
+{
+	namespace
+	{
+		using Plane = std::array<float, 4>; // Normal and distance, positive inside.
+		using FrustumPlanes = std::array<Plane, 6>;
+
+		// Bounds are padded to the widest register, so whichever a build uses only ever loads whole ones.
+		constexpr std::uint32_t PADDING_WIDTH = 8;
+		// Below this many instances per thread, handing out the work costs more than it saves.
+		constexpr std::uint32_t MIN_PARALLEL_CULL_COUNT = 32 * 1024;
+
+		// Bit i of the result is set if sphere i of the register starting at the pointers is on the inside of every plane.
+#if defined(__AVX__)
+		constexpr std::uint32_t LANE_COUNT = 8;
+
+		auto test_spheres(const float* x, const float* y, const float* z, const float* r, const FrustumPlanes& planes) -> std::uint32_t
+		{
+			const auto centerX = _mm256_loadu_ps(x);
+			const auto centerY = _mm256_loadu_ps(y);
+			const auto centerZ = _mm256_loadu_ps(z);
+			const auto negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(r));
+			auto inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (const auto& plane : planes)
+			{
+				const auto distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(centerX, _mm256_set1_ps(plane[0])), _mm256_mul_ps(centerY, _mm256_set1_ps(plane[1]))),
+													_mm256_add_ps(_mm256_mul_ps(centerZ, _mm256_set1_ps(plane[2])), _mm256_set1_ps(plane[3])));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+			}
+			return std::uint32_t(_mm256_movemask_ps(inside));
+		}
+#elif defined(GFX_CPU_CULLING_SSE2)
+		constexpr std::uint32_t LANE_COUNT = 4;
+
+		auto test_spheres(const float* x, const float* y, const float* z, const float* r, const FrustumPlanes& planes) -> std::uint32_t
+		{
+			const auto centerX = _mm_loadu_ps(x);
+			const auto centerY = _mm_loadu_ps(y);
+			const auto centerZ = _mm_loadu_ps(z);
+			const auto negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(r));
+			auto inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (const auto& plane : planes)
+			{
+				const auto distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(plane[0])), _mm_mul_ps(centerY, _mm_set1_ps(plane[1]))),
+												 _mm_add_ps(_mm_mul_ps(centerZ, _mm_set1_ps(plane[2])), _mm_set1_ps(plane[3])));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+			}
+			return std::uint32_t(_mm_movemask_ps(inside));
+		}
+#elif defined(GFX_CPU_CULLING_NEON)
+		constexpr std::uint32_t LANE_COUNT = 4;
+
+		auto test_spheres(const float* x, const float* y, const float* z, const float* r, const FrustumPlanes& planes) -> std::uint32_t
+		{
+			const auto centerX = vld1q_f32(x);
+			const auto centerY = vld1q_f32(y);
+			const auto centerZ = vld1q_f32(z);
+			const auto negRadius = vnegq_f32(vld1q_f32(r));
+			auto inside = vdupq_n_u32(~0u);
+			for (const auto& plane : planes)
+			{
+				const auto distance = vaddq_f32(vaddq_f32(vmulq_n_f32(centerX, plane[0]), vmulq_n_f32(centerY, plane[1])), vaddq_f32(vmulq_n_f32(centerZ, plane[2]), vdupq_n_f32(plane[3])));
+				inside = vandq_u32(inside, vcgeq_f32(distance, negRadius));
+			}
+			// No movemask, so each lane keeps its own bit and they are summed.
+			constexpr std::uint32_t LANE_BITS[4] = { 1, 2, 4, 8 };
+			return vaddvq_u32(vandq_u32(inside, vld1q_u32(LANE_BITS)));
+		}
+#else
+		constexpr std::uint32_t LANE_COUNT = 1;
+
+		auto test_spheres(const float* x, const float* y, const float* z, const float* r, const FrustumPlanes& planes) -> std::uint32_t
+		{
+			return std::all_of(planes.begin(), planes.end(), [&](const Plane& plane) { return plane[0] * *x + plane[1] * *y + plane[2] * *z + plane[3] >= -*r; }) ? 1u : 0u;
+		}
+#endif
+
+		// Planes from the rows of the view projection (Gribb & Hartmann), near being z >= 0 for Vulkan's depth range.
+		auto get_frustum_planes(const std::array<float, 16>& m) -> FrustumPlanes
+		{
+			const auto row = [&](std::uint32_t i) { return Plane{ m[i], m[4 + i], m[8 + i], m[12 + i] }; };
+			const auto combine = [](const Plane& lhs, const Plane& rhs, float sign) {
+				Plane plane{ lhs[0] + sign * rhs[0], lhs[1] + sign * rhs[1], lhs[2] + sign * rhs[2], lhs[3] + sign * rhs[3] };
+				const auto length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+				for (auto& value : plane)
+				{
+					value /= length;
+				}
+				return plane;
+			};
+			const auto row3 = row(3);
+			return { combine(row3, row(0), 1.0f), combine(row3, row(0), -1.0f), combine(row3, row(1), 1.0f),
+					 combine(row3, row(1), -1.0f), combine({}, row(2), 1.0f), combine(row3, row(2), -1.0f) };
+		}
+
+		auto transform_point(const std::array<float, 16>& m, float x, float y, float z) -> std::array<float, 4>
+		{
+			return { m[0] * x + m[4] * y + m[8] * z + m[12], m[1] * x + m[5] * y + m[9] * z + m[13], m[2] * x + m[6] * y + m[10] * z + m[14],
+					 m[3] * x + m[7] * y + m[11] * z + m[15] };
+		}
+	} // namespace
+
+	CpuCulling::CpuCulling(std::uint32_t instanceDataSize, TaskScheduler* executor)
+		: m_instanceDataSize(instanceDataSize), m_executor(executor)
+	{
+		std::uint32_t size{ 0 };
+		for (std::uint32_t level = 0; (OCCLUSION_WIDTH >> level) > 0 || (OCCLUSION_HEIGHT >> level) > 0; ++level)
+		{
+			m_occlusionLevelOffsets.push_back(size);
+			size += std::max(OCCLUSION_WIDTH >> level, 1u) * std::max(OCCLUSION_HEIGHT >> level, 1u);
+		}
+		m_occlusionDepth.assign(size, 1.0f);
+	}
+
+	auto CpuCulling::add_instance(const std::array<float, 3>& center, float radius, std::uint32_t meshIndex, std::uint32_t materialIndex, const void* instanceData) -> std::uint32_t
+	{
+		const auto instance = m_count++;
+		if (m_centerX.size() < m_count)
+		{
+			const auto paddedCount = (m_count + PADDING_WIDTH - 1) / PADDING_WIDTH * PADDING_WIDTH;
+			m_centerX.resize(paddedCount);
+			m_centerY.resize(paddedCount);
+			m_centerZ.resize(paddedCount);
+			m_radius.resize(paddedCount);
+		}
+		m_meshIndices.push_back(meshIndex);
+		m_materialIndices.push_back(materialIndex);
+		m_instanceData.resize(std::size_t(m_count) * m_instanceDataSize);
+		set_instance_bounds(instance, center, radius);
+		set_instance_data(instance, instanceData);
+		return instance;
+	}
+
+	void CpuCulling::set_instance_bounds(std::uint32_t instance, const std::array<float, 3>& center, float radius)
+	{
+		GFX_ASSERT(instance < m_count, "CPU culling instance index out of range!");
+		m_centerX[instance] = center[0];
+		m_centerY[instance] = center[1];
+		m_centerZ[instance] = center[2];
+		m_radius[instance] = radius;
+	}
+
+	void CpuCulling::set_instance_data(std::uint32_t instance, const void* instanceData)
+	{
+		GFX_ASSERT(instance < m_count, "CPU culling instance index out of range!");
+		std::memcpy(m_instanceData.data() + std::size_t(instance) * m_instanceDataSize, instanceData, m_instanceDataSize);
+	}
+
+	void CpuCulling::clear()
+	{
+		m_count = 0;
+		m_centerX.clear();
+		m_centerY.clear();
+		m_centerZ.clear();
+		m_radius.clear();
+		m_meshIndices.clear();
+		m_materialIndices.clear();
+		m_instanceData.clear();
+	}
+
+	void CpuCulling::clear_occluders()
+	{
+		std::fill_n(m_occlusionDepth.begin(), OCCLUSION_WIDTH * OCCLUSION_HEIGHT, 1.0f);
+		m_hasOccluders = false;
+		m_occlusionLevelsDirty = false;
+	}
+
+	void CpuCulling::rasterize_occluders(const CpuCullView& view, std::span<const std::array<float, 3>> vertices, std::span<const std::uint32_t> indices)
+	{
+		struct ScreenVertex
+		{
+			float x;
+			float y;
+		};
+
+		for (std::size_t triangle = 0; triangle + 2 < indices.size(); triangle += 3)
+		{
+			std::array<ScreenVertex, 3> screen{};
+			float farthest{ 0.0f };
+			bool crossesNear{ false };
+			for (std::uint32_t i = 0; i < 3; ++i)
+			{
+				GFX_ASSERT(indices[triangle + i] < vertices.size(), "Occluder index out of range!");
+				const auto& vertex = vertices[indices[triangle + i]];
+				const auto clip = transform_point(view.viewProjection, vertex[0], vertex[1], vertex[2]);
+				if (clip[3] <= 0.0f)
+				{
+					crossesNear = true;
+					break;
+				}
+				const auto depth = clip[2] / clip[3];
+				screen[i] = { (clip[0] / clip[3] * 0.5f + 0.5f) * OCCLUSION_WIDTH, (clip[1] / clip[3] * 0.5f + 0.5f) * OCCLUSION_HEIGHT };
+				farthest = std::max(farthest, view.reverseZ ? 1.0f - depth : depth);
+			}
+			if (crossesNear)
+			{
+				continue;
+			}
+
+			// Both windings occlude, so counter-clockwise ones are flipped to keep every edge function positive inside.
+			const auto edge = [](const ScreenVertex& a, const ScreenVertex& b, float x, float y) { return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x); };
+			const auto area = edge(screen[0], screen[1], screen[2].x, screen[2].y);
+			if (area == 0.0f)
+			{
+				continue;
+			}
+			if (area < 0.0f)
+			{
+				std::swap(screen[1], screen[2]);
+			}
+
+			const auto minX = std::max(int(std::floor(std::min({ screen[0].x, screen[1].x, screen[2].x }))), 0);
+			const auto maxX = std::min(int(std::ceil(std::max({ screen[0].x, screen[1].x, screen[2].x }))), int(OCCLUSION_WIDTH) - 1);
+			const auto minY = std::max(int(std::floor(std::min({ screen[0].y, screen[1].y, screen[2].y }))), 0);
+			const auto maxY = std::min(int(std::ceil(std::max({ screen[0].y, screen[1].y, screen[2].y }))), int(OCCLUSION_HEIGHT) - 1);
+			for (auto y = minY; y <= maxY; ++y)
+			{
+				const auto pixelY = float(y) + 0.5f;
+				for (auto x = minX; x <= maxX; ++x)
+				{
+					// Only pixels whose center is covered, so partly covered ones stay unoccluded.
+					const auto pixelX = float(x) + 0.5f;
+					if (edge(screen[0], screen[1], pixelX, pixelY) >= 0.0f && edge(screen[1], screen[2], pixelX, pixelY) >= 0.0f && edge(screen[2], screen[0], pixelX, pixelY) >= 0.0f)
+					{
+						auto& depth = m_occlusionDepth[y * OCCLUSION_WIDTH + x];
+						depth = std::min(depth, farthest);
+					}
+				}
+			}
+		}
+		m_hasOccluders = true;
+		m_occlusionLevelsDirty = true;
+	}
+
+	void CpuCulling::build_occlusion_levels()
+	{
+		for (std::uint32_t level = 1; level < m_occlusionLevelOffsets.size(); ++level)
+		{
+			const auto srcWidth = std::max(OCCLUSION_WIDTH >> (level - 1), 1u);
+			const auto srcHeight = std::max(OCCLUSION_HEIGHT >> (level - 1), 1u);
+			const auto width = std::max(OCCLUSION_WIDTH >> level, 1u);
+			const auto height = std::max(OCCLUSION_HEIGHT >> level, 1u);
+			const auto* src = m_occlusionDepth.data() + m_occlusionLevelOffsets[level - 1];
+			auto* dst = m_occlusionDepth.data() + m_occlusionLevelOffsets[level];
+			for (std::uint32_t y = 0; y < height; ++y)
+			{
+				const auto y0 = std::min(y * 2, srcHeight - 1);
+				const auto y1 = std::min(y * 2 + 1, srcHeight - 1);
+				for (std::uint32_t x = 0; x < width; ++x)
+				{
+					const auto x0 = std::min(x * 2, srcWidth - 1);
+					const auto x1 = std::min(x * 2 + 1, srcWidth - 1);
+					dst[y * width + x] = std::max({ src[y0 * srcWidth + x0], src[y0 * srcWidth + x1], src[y1 * srcWidth + x0], src[y1 * srcWidth + x1] });
+				}
+			}
+		}
+		m_occlusionLevelsDirty = false;
+	}
+
+	bool CpuCulling::is_occluded(const CpuCullView& view, std::uint32_t instance) const
+	{
+		// Screen rectangle and nearest depth of the sphere's bounding box.
+		const auto radius = m_radius[instance];
+		std::array<float, 2> uvMin{ 1.0f, 1.0f };
+		std::array<float, 2> uvMax{ 0.0f, 0.0f };
+		float nearest{ 1.0f };
+		for (std::uint32_t corner = 0; corner < 8; ++corner)
+		{
+			const auto clip = transform_point(view.viewProjection, m_centerX[instance] + ((corner & 1u) != 0 ? radius : -radius),
+											  m_centerY[instance] + ((corner & 2u) != 0 ? radius : -radius), m_centerZ[instance] + ((corner & 4u) != 0 ? radius : -radius));
+			if (clip[3] <= 0.0f)
+			{
+				return false; // Crosses the camera plane.
+			}
+			for (std::uint32_t axis = 0; axis < 2; ++axis)
+			{
+				const auto uv = clip[axis] / clip[3] * 0.5f + 0.5f;
+				uvMin[axis] = std::min(uvMin[axis], uv);
+				uvMax[axis] = std::max(uvMax[axis], uv);
+			}
+			const auto depth = clip[2] / clip[3];
+			nearest = std::min(nearest, view.reverseZ ? 1.0f - depth : depth);
+		}
+		for (std::uint32_t axis = 0; axis < 2; ++axis)
+		{
+			uvMin[axis] = std::clamp(uvMin[axis], 0.0f, 1.0f);
+			uvMax[axis] = std::clamp(uvMax[axis], 0.0f, 1.0f);
+		}
+
+		// The level where the rectangle spans at most 2x2 texels, of which the farthest depth bounds everything behind them.
+		const auto extent = std::max((uvMax[0] - uvMin[0]) * OCCLUSION_WIDTH, (uvMax[1] - uvMin[1]) * OCCLUSION_HEIGHT);
+		const auto level = std::min(std::uint32_t(std::ceil(std::log2(std::max(extent, 1.0f)))), std::uint32_t(m_occlusionLevelOffsets.size() - 1));
+		const auto width = std::max(OCCLUSION_WIDTH >> level, 1u);
+		const auto height = std::max(OCCLUSION_HEIGHT >> level, 1u);
+		const auto texelMinX = std::min(std::uint32_t(uvMin[0] * width), width - 1);
+		const auto texelMaxX = std::min(std::uint32_t(uvMax[0] * width), width - 1);
+		const auto texelMinY = std::min(std::uint32_t(uvMin[1] * height), height - 1);
+		const auto texelMaxY = std::min(std::uint32_t(uvMax[1] * height), height - 1);
+
+		const auto* depths = m_occlusionDepth.data() + m_occlusionLevelOffsets[level];
+		float farthest{ 0.0f };
+		for (auto y = texelMinY; y <= texelMaxY; ++y)
+		{
+			for (auto x = texelMinX; x <= texelMaxX; ++x)
+			{
+				farthest = std::max(farthest, depths[y * width + x]);
+			}
+		}
+		return nearest > farthest;
+	}
+
+	void CpuCulling::cull_range(const FrustumPlanes& planes, const CpuCullView& view, bool occlusion, std::uint32_t begin, std::uint32_t end, std::vector<std::uint32_t>& outVisible, std::uint32_t& outFrustumVisibleCount) const
+	{
+		std::uint32_t frustumVisibleCount{ 0 };
+		for (auto first = begin; first < end; first += LANE_COUNT)
+		{
+			auto mask = test_spheres(&m_centerX[first], &m_centerY[first], &m_centerZ[first], &m_radius[first], planes);
+			if (end - first < LANE_COUNT)
+			{
+				mask &= (1u << (end - first)) - 1u; // Past the last instance.
+			}
+			while (mask != 0)
+			{
+				const auto instance = first + std::uint32_t(std::countr_zero(mask));
+				mask &= mask - 1;
+				frustumVisibleCount += 1;
+				if (!occlusion || !is_occluded(view, instance))
+				{
+					outVisible.push_back(instance);
+				}
+			}
+		}
+		outFrustumVisibleCount = frustumVisibleCount;
+	}
+
+	auto CpuCulling::cull(const CpuCullView& view) -> std::span<const std::uint32_t>
+	{
+		m_stats = { .instanceCount = m_count };
+		m_visible.clear();
+		if (m_count == 0)
+		{
+			return {};
+		}
+
+		const bool occlusion = view.occlusion && m_hasOccluders;
+		if (occlusion && m_occlusionLevelsDirty)
+		{
+			build_occlusion_levels();
+		}
+
+		// Chunks start on a whole register, and are found in order so their survivors are too.
+		const auto planes = get_frustum_planes(view.viewProjection);
+		const auto chunkCount = m_executor != nullptr ? std::clamp(m_count / MIN_PARALLEL_CULL_COUNT, 1u, std::max(m_executor->get_thread_count(), 1u)) : 1u;
+		const auto chunkSize = ((m_count + chunkCount - 1) / chunkCount + PADDING_WIDTH - 1) / PADDING_WIDTH * PADDING_WIDTH;
+		m_chunkVisible.resize(chunkCount);
+		std::vector<std::uint32_t> frustumVisibleCounts(chunkCount, 0);
+		run_parallel(m_executor, chunkCount, [&](std::uint32_t chunk) {
+			const auto begin = std::min(chunk * chunkSize, m_count);
+			const auto end = std::min(begin + chunkSize, m_count);
+			m_chunkVisible[chunk].clear();
+			cull_range(planes, view, occlusion, begin, end, m_chunkVisible[chunk], frustumVisibleCounts[chunk]);
+		});
+
+		for (std::uint32_t chunk = 0; chunk < chunkCount; ++chunk)
+		{
+			m_visible.insert(m_visible.end(), m_chunkVisible[chunk].begin(), m_chunkVisible[chunk].end());
+			m_stats.frustumVisibleCount += frustumVisibleCounts[chunk];
+		}
+		m_stats.visibleCount = std::uint32_t(m_visible.size());
+		return m_visible;
+	}
+
+	void CpuCulling::cull(const CpuCullView& view, DrawBatcher& drawBatcher)
+	{
+		for (const auto instance : cull(view))
+		{
+			drawBatcher.submit(m_meshIndices[instance], m_materialIndices[instance], m_instanceData.data() + std::size_t(instance) * m_instanceDataSize);
+		}
+	}
+
+} // namespace sm::gfx
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx_draw_batch.hpp"
+
+#include "gfx_p.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+
+namespace sm::gfx
+{
+	namespace
+	{
+		// Keys are the pipeline's rank, the material and the mesh, from the most significant bits down.
+		constexpr std::uint32_t MATERIAL_SHIFT = 32;
+		constexpr std::uint32_t PIPELINE_SHIFT = 52;
+		constexpr std::uint32_t MAX_MATERIALS = 1u << (PIPELINE_SHIFT - MATERIAL_SHIFT);
+		constexpr std::uint32_t MAX_PIPELINES = 1u << (64 - PIPELINE_SHIFT);
+
+		constexpr std::uint32_t RADIX_BITS = 8;
+		constexpr std::uint32_t RADIX_SIZE = 1u << RADIX_BITS;
+		// Below this many draws per thread, handing out the sort costs more than it saves.
+		constexpr std::size_t MIN_PARALLEL_SORT_COUNT = 16 * 1024;
+	} // namespace
+
+	DrawBatcher::DrawBatcher(DeviceHandle deviceHandle, std::uint32_t instanceDataSize, TaskScheduler* executor)
+		: m_deviceHandle(deviceHandle), m_instanceDataSize(instanceDataSize), m_executor(executor)
+	{
+		DeviceProperties properties{};
+		if (get_device_properties(properties, m_deviceHandle))
+		{
+			m_multiDrawIndirect = properties.multiDrawIndirect;
+		}
+	}
+
+	auto DrawBatcher::add_mesh(const DrawMesh& mesh) -> std::uint32_t
+	{
+		m_meshes.push_back(mesh);
+		return std::uint32_t(m_meshes.size() - 1);
+	}
+
+	auto DrawBatcher::add_material(const DrawMaterial& material) -> std::uint32_t
+	{
+		auto pipelineIt = std::find(m_pipelines.begin(), m_pipelines.end(), material.pipelineHandle);
+		if (pipelineIt == m_pipelines.end())
+		{
+			pipelineIt = m_pipelines.insert(m_pipelines.end(), material.pipelineHandle);
+		}
+		GFX_ASSERT(m_pipelines.size() <= MAX_PIPELINES && m_materials.size() < MAX_MATERIALS, "Too many draw batcher materials!");
+
+		m_materials.push_back(material);
+		m_materialPipelines.push_back(std::uint32_t(pipelineIt - m_pipelines.begin()));
+		return std::uint32_t(m_materials.size() - 1);
+	}
+
+	void DrawBatcher::submit(std::uint32_t meshIndex, std::uint32_t materialIndex, const void* instanceData)
+	{
+		GFX_ASSERT(meshIndex < m_meshes.size() && materialIndex < m_materials.size(), "Draw batcher mesh or material index out of range!");
+
+		const auto key = std::uint64_t(m_materialPipelines[materialIndex]) << PIPELINE_SHIFT | std::uint64_t(materialIndex) << MATERIAL_SHIFT | meshIndex;
+		m_entries.push_back({ key, std::uint32_t(m_entries.size()) });
+
+		const auto offset = m_instanceData.size();
+		m_instanceData.resize(offset + m_instanceDataSize);
+		std::memcpy(m_instanceData.data() + offset, instanceData, m_instanceDataSize);
+	}
+
+	void DrawBatcher::flush(CommandListHandle commandListHandle, std::uint32_t instanceBinding)
+	{
+		m_stats = { .itemCount = std::uint32_t(m_entries.size()) };
+		if (m_entries.empty())
+		{
+			return;
+		}
+
+		sort();
+
+		const auto instanceAllocation = allocate_transient(m_deviceHandle, m_instanceData.size(), 16);
+		if (instanceAllocation.ptr == nullptr)
+		{
+			GFX_LOG_ERR("GFX - DrawBatcher::flush() - Transient memory is exhausted, the draws were dropped!");
+			m_entries.clear();
+			m_instanceData.clear();
+			return;
+		}
+
+		// Instance data in sorted order, so each run of identical draws reads a contiguous range of instances.
+		auto* instanceDst = static_cast<std::byte*>(instanceAllocation.ptr);
+		m_commands.clear();
+		for (std::uint32_t i = 0; i < m_entries.size(); ++i)
+		{
+			std::memcpy(instanceDst + std::size_t(i) * m_instanceDataSize, m_instanceData.data() + std::size_t(m_entries[i].item) * m_instanceDataSize, m_instanceDataSize);
+
+			if (i > 0 && m_entries[i].key == m_entries[i - 1].key)
+			{
+				++m_commands.back().instanceCount;
+				continue;
+			}
+			const auto& mesh = m_meshes[std::uint32_t(m_entries[i].key)];
+			m_commands.push_back({ mesh.indexCount, 1, mesh.firstIndex, mesh.vertexOffset, i });
+		}
+
+		TransientAllocation commandAllocation{};
+		if (m_multiDrawIndirect)
+		{
+			commandAllocation = allocate_transient(m_deviceHandle, m_commands.size() * sizeof(DrawIndexedIndirectCommand), 4);
+			if (commandAllocation.ptr != nullptr)
+			{
+				std::memcpy(commandAllocation.ptr, m_commands.data(), m_commands.size() * sizeof(DrawIndexedIndirectCommand));
+			}
+		}
+
+		const std::array instanceBuffers{ instanceAllocation.bufferHandle };
+		const std::array instanceOffsets{ instanceAllocation.offset };
+		bind_vertex_buffers(commandListHandle, instanceBinding, instanceBuffers, instanceOffsets);
+
+		// The first entry of each command, to look up its mesh and material.
+		std::uint32_t entryIndex{ 0 };
+		const DrawMaterial* boundMaterial{ nullptr };
+		const DrawMesh* boundMesh{ nullptr };
+		for (std::size_t i = 0; i < m_commands.size();)
+		{
+			const auto key = m_entries[entryIndex].key;
+			const auto& material = m_materials[std::uint32_t(key >> MATERIAL_SHIFT) & (MAX_MATERIALS - 1)];
+			const auto& mesh = m_meshes[std::uint32_t(key)];
+
+			if (boundMaterial == nullptr || boundMaterial->pipelineHandle != material.pipelineHandle)
+			{
+				bind_pipeline(commandListHandle, material.pipelineHandle);
+				++m_stats.pipelineBindCount;
+				boundMaterial = nullptr; // Binding a pipeline can disturb descriptor sets of a different layout.
+			}
+			if (material.descriptorSetHandle != 0 && (boundMaterial == nullptr || boundMaterial->descriptorSetHandle != material.descriptorSetHandle || boundMaterial->set != material.set))
+			{
+				bind_descriptor_sets(commandListHandle, material.set, { &material.descriptorSetHandle, 1 });
+				++m_stats.descriptorSetBindCount;
+			}
+			boundMaterial = &material;
+
+			if (boundMesh == nullptr || boundMesh->vertexBufferHandle != mesh.vertexBufferHandle)
+			{
+				bind_vertex_buffers(commandListHandle, 0, { &mesh.vertexBufferHandle, 1 });
+			}
+			if (boundMesh == nullptr || boundMesh->indexBufferHandle != mesh.indexBufferHandle || boundMesh->indexType != mesh.indexType)
+			{
+				bind_index_buffer(commandListHandle, mesh.indexBufferHandle, mesh.indexType);
+			}
+			boundMesh = &mesh;
+
+			// The following commands of the same material whose meshes share these buffers go in the same multi-draw.
+			auto count = 1u;
+			auto nextEntryIndex = entryIndex + m_commands[i].instanceCount;
+			while (commandAllocation.ptr != nullptr && i + count < m_commands.size())
+			{
+				const auto nextKey = m_entries[nextEntryIndex].key;
+				const auto& nextMesh = m_meshes[std::uint32_t(nextKey)];
+				if (nextKey >> MATERIAL_SHIFT != key >> MATERIAL_SHIFT || nextMesh.vertexBufferHandle != mesh.vertexBufferHandle ||
+					nextMesh.indexBufferHandle != mesh.indexBufferHandle || nextMesh.indexType != mesh.indexType)
+				{
+					break;
+				}
+				nextEntryIndex += m_commands[i + count].instanceCount;
+				++count;
+			}
+
+			if (count > 1)
+			{
+				draw_indexed_indirect(commandListHandle, commandAllocation.bufferHandle, commandAllocation.offset + i * sizeof(DrawIndexedIndirectCommand), count);
+			}
+			else
+			{
+				const auto& command = m_commands[i];
+				draw_indexed(commandListHandle, command.indexCount, command.instanceCount, command.firstIndex, command.vertexOffset, command.firstInstance);
+			}
+			++m_stats.drawCount;
+			i += count;
+			entryIndex = nextEntryIndex;
+		}
+
+		m_entries.clear();
+		m_instanceData.clear();
+	}
+
+	void DrawBatcher::sort()
+	{
+		// Digits every key shares cannot reorder anything, and with few pipelines and materials most of the high ones are.
+		std::uint64_t differingBits{ 0 };
+		for (const auto& entry : m_entries)
+		{
+			differingBits |= entry.key ^ m_entries.front().key;
+		}
+
+		const auto count = m_entries.size();
+		const auto chunkCount = m_executor != nullptr ? std::uint32_t(std::max<std::size_t>(std::min<std::size_t>(count / MIN_PARALLEL_SORT_COUNT, m_executor->get_thread_count()), 1)) : 1u;
+		const auto chunkSize = (count + chunkCount - 1) / chunkCount;
+		std::vector<std::array<std::uint32_t, RADIX_SIZE>> offsets(chunkCount);
+		m_sortScratch.resize(count);
+
+		// Least significant digit first, each pass stable, so each chunk scatters its entries in order to its own offsets.
+		for (std::uint32_t shift = 0; shift < 64; shift += RADIX_BITS)
+		{
+			if (((differingBits >> shift) & (RADIX_SIZE - 1)) == 0)
+			{
+				continue;
+			}
+
+			const auto count_digits = [&](std::uint32_t chunk) {
+				auto& histogram = offsets[chunk];
+				histogram.fill(0);
+				const auto end = std::min(count, (chunk + 1) * chunkSize);
+				for (auto i = chunk * chunkSize; i < end; ++i)
+				{
+					++histogram[(m_entries[i].key >> shift) & (RADIX_SIZE - 1)];
+				}
+			};
+			const auto scatter = [&](std::uint32_t chunk) {
+				auto& chunkOffsets = offsets[chunk];
+				const auto end = std::min(count, (chunk + 1) * chunkSize);
+				for (auto i = chunk * chunkSize; i < end; ++i)
+				{
+					m_sortScratch[chunkOffsets[(m_entries[i].key >> shift) & (RADIX_SIZE - 1)]++] = m_entries[i];
+				}
+			};
+
+			run_parallel(m_executor, chunkCount, count_digits);
+			std::uint32_t offset{ 0 };
+			for (std::uint32_t digit = 0; digit < RADIX_SIZE; ++digit)
+			{
+				for (auto& chunkOffsets : offsets)
+				{
+					offset += std::exchange(chunkOffsets[digit], offset);
+				}
+			}
+			run_parallel(m_executor, chunkCount, scatter);
+			m_entries.swap(m_sortScratch);
+		}
+	}
+
+} // namespace sm::gfx
@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx_gpu_culling.hpp"
+
+#include <algorithm>
+
+namespace sm::gfx
+{
+	namespace
+	{
+		constexpr std::uint32_t CULL_GROUP_SIZE = 64;
+		constexpr std::uint32_t HI_Z_GROUP_SIZE = 8;
+
+		constexpr std::uint32_t CullFlags_Occlusion = 1u << 0u;
+		constexpr std::uint32_t CullFlags_ReverseZ = 1u << 1u;
+
+		// Must match HiZConstants in gpu_hi_z.hlsl.
+		struct HiZConstants
+		{
+			std::uint32_t srcWidth;
+			std::uint32_t srcHeight;
+			std::uint32_t srcOffset; // In floats, into the pyramid. Unused when reading the depth texture.
+			std::uint32_t dstWidth;
+			std::uint32_t dstHeight;
+			std::uint32_t dstOffset;
+			std::uint32_t fromTexture;
+			std::uint32_t reverseZ;
+		};
+
+		auto next_level_size(std::uint32_t size) -> std::uint32_t
+		{
+			return std::max(1u, (size + 1) / 2);
+		}
+	} // namespace
+
+	GpuCulling::GpuCulling(DeviceHandle deviceHandle, const GpuCullingInfo& cullingInfo)
+		: m_deviceHandle(deviceHandle), m_maxInstances(cullingInfo.maxInstances)
+	{
+		GFX_ASSERT(cullingInfo.maxInstances > 0, "GpuCulling needs room for at least one instance!");
+
+		m_cullSetInfo.bindings = {
+			{ DescriptorType::eUniformBuffer, 1, ShaderStageFlags_Compute }, // CullParams
+			{ DescriptorType::eStorageBuffer, 1, ShaderStageFlags_Compute }, // Instances
+			{ DescriptorType::eStorageBuffer, 1, ShaderStageFlags_Compute }, // Draws
+			{ DescriptorType::eStorageBuffer, 1, ShaderStageFlags_Compute }, // Output draw commands
+			{ DescriptorType::eStorageBuffer, 1, ShaderStageFlags_Compute }, // Output count
+			{ DescriptorType::eStorageBuffer, 1, ShaderStageFlags_Compute }, // Hi-Z pyramid
+		};
+		const ComputePipelineInfo cullPipelineInfo{
+			.shaderCode = cullingInfo.cullShaderCode,
+			.descriptorSets = { m_cullSetInfo },
+			.debugName = "gpu_cull",
+		};
+		if (!create_compute_pipeline(m_cullPipeline, deviceHandle, cullPipelineInfo))
+		{
+			return;
+		}
+
+		if (!cullingInfo.hiZShaderCode.empty())
+		{
+			m_hiZSetInfo.bindings = {
+				{ DescriptorType::eTexture, 1, ShaderStageFlags_Compute },		 // Depth texture
+				{ DescriptorType::eStorageBuffer, 1, ShaderStageFlags_Compute }, // Hi-Z pyramid
+			};
+			const ComputePipelineInfo hiZPipelineInfo{
+				.shaderCode = cullingInfo.hiZShaderCode,
+				.descriptorSets = { m_hiZSetInfo },
+				.constantBlock = { sizeof(HiZConstants), ShaderStageFlags_Compute },
+				.debugName = "gpu_hi_z",
+			};
+			if (!create_compute_pipeline(m_hiZPipeline, deviceHandle, hiZPipelineInfo) ||
+				!create_sampler(m_depthSampler, deviceHandle, { .addressMode = SamplerAddressMode::eClamp, .filterMode = SamplerFilterMode::eNearest }))
+			{
+				return;
+			}
+		}
+
+		if (!create_buffer(m_paramsBuffer, deviceHandle, { .type = BufferType::eUniform, .size = sizeof(CullParams), .memory = BufferMemory::eGpuOnly, .debugName = "gpu_cull_params" }) ||
+			!create_buffer(m_drawBuffer, deviceHandle, { .type = BufferType::eIndirect, .size = sizeof(DrawIndexedIndirectCommand) * std::uint64_t(m_maxInstances), .debugName = "gpu_cull_draws" }) ||
+			!create_buffer(m_countBuffer, deviceHandle, { .type = BufferType::eIndirect, .size = sizeof(std::uint32_t), .debugName = "gpu_cull_count" }))
+		{
+			return;
+		}
+
+		m_valid = true;
+	}
+
+	GpuCulling::~GpuCulling()
+	{
+		for (const auto bufferHandle : { m_paramsBuffer, m_drawBuffer, m_countBuffer, m_hiZBuffer })
+		{
+			if (bufferHandle)
+			{
+				destroy_buffer(bufferHandle);
+			}
+		}
+		if (m_depthSampler)
+		{
+			destroy_sampler(m_depthSampler);
+		}
+		for (const auto pipelineHandle : { m_cullPipeline, m_hiZPipeline })
+		{
+			if (pipelineHandle)
+			{
+				destroy_pipeline(pipelineHandle);
+			}
+		}
+	}
+
+	bool GpuCulling::is_valid() const
+	{
+		return m_valid;
+	}
+
+	void GpuCulling::build_hi_z(CommandListHandle commandListHandle, TextureHandle depthTextureHandle, std::uint32_t width, std::uint32_t height, const std::array<float, 16>& viewProjection, bool reverseZ)
+	{
+		GFX_ASSERT(m_valid, "GpuCulling is not valid!");
+		GFX_ASSERT(m_hiZPipeline, "GpuCulling was created without a Hi-Z shader!");
+		GFX_ASSERT(width > 0 && height > 0, "Depth texture size must not be 0!");
+
+		// Level 0 is half the depth buffer's size, each level after half the one before, rounding up so no texel is lost.
+		std::array<std::uint32_t, MAX_HI_Z_LEVELS> levelOffsets{};
+		std::uint32_t levelWidth = next_level_size(width);
+		std::uint32_t levelHeight = next_level_size(height);
+		std::uint32_t levelCount = 0;
+		std::uint64_t floatCount = 0;
+		while (levelCount < MAX_HI_Z_LEVELS)
+		{
+			levelOffsets[levelCount++] = std::uint32_t(floatCount);
+			floatCount += std::uint64_t(levelWidth) * levelHeight;
+			if (levelWidth == 1 && levelHeight == 1)
+			{
+				break;
+			}
+			levelWidth = next_level_size(levelWidth);
+			levelHeight = next_level_size(levelHeight);
+		}
+
+		const auto bufferSize = floatCount * sizeof(float);
+		if (bufferSize > m_hiZBufferSize)
+		{
+			if (m_hiZBuffer)
+			{
+				destroy_buffer(m_hiZBuffer);
+			}
+			m_hiZBufferSize = 0;
+			m_hiZLevels = 0;
+			if (!create_buffer(m_hiZBuffer, m_deviceHandle, { .type = BufferType::eStorage, .size = bufferSize, .memory = BufferMemory::eGpuOnly, .debugName = "gpu_hi_z" }))
+			{
+				m_hiZBuffer = {};
+				return;
+			}
+			m_hiZBufferSize = bufferSize;
+		}
+
+		const std::array<DescriptorWrite, 2> writes{
+			DescriptorWrite{ .binding = 0, .textureHandle = depthTextureHandle, .samplerHandle = m_depthSampler },
+			DescriptorWrite{ .binding = 1, .bufferHandle = m_hiZBuffer },
+		};
+		DescriptorSetHandle descriptorSetHandle{};
+		if (!get_cached_descriptor_set(descriptorSetHandle, m_deviceHandle, m_hiZSetInfo, writes))
+		{
+			return;
+		}
+
+		// The last cull() may still be reading the pyramid.
+		buffer_barrier(commandListHandle, m_hiZBuffer, PipelineStageFlags_ComputeShader, AccessFlags_ShaderRead, PipelineStageFlags_ComputeShader, AccessFlags_ShaderWrite);
+		bind_pipeline(commandListHandle, m_hiZPipeline);
+		bind_descriptor_sets(commandListHandle, 0, { &descriptorSetHandle, 1 });
+
+		HiZConstants constants{
+			.srcWidth = width,
+			.srcHeight = height,
+			.srcOffset = 0,
+			.dstWidth = next_level_size(width),
+			.dstHeight = next_level_size(height),
+			.dstOffset = 0,
+			.fromTexture = 1,
+			.reverseZ = reverseZ ? 1u : 0u,
+		};
+		for (std::uint32_t level = 0; level < levelCount; ++level)
+		{
+			if (level != 0)
+			{
+				// Each level reads the one written before it.
+				buffer_barrier(commandListHandle, m_hiZBuffer, PipelineStageFlags_ComputeShader, AccessFlags_ShaderWrite, PipelineStageFlags_ComputeShader, AccessFlags_ShaderRead);
+				constants.srcWidth = constants.dstWidth;
+				constants.srcHeight = constants.dstHeight;
+				constants.srcOffset = levelOffsets[level - 1];
+				constants.dstWidth = next_level_size(constants.dstWidth);
+				constants.dstHeight = next_level_size(constants.dstHeight);
+				constants.dstOffset = levelOffsets[level];
+				constants.fromTexture = 0;
+			}
+			set_constants(commandListHandle, ShaderStageFlags_Compute, 0, sizeof(HiZConstants), &constants);
+			dispatch(commandListHandle, (constants.dstWidth + HI_Z_GROUP_SIZE - 1) / HI_Z_GROUP_SIZE, (constants.dstHeight + HI_Z_GROUP_SIZE - 1) / HI_Z_GROUP_SIZE, 1);
+		}
+		buffer_barrier(commandListHandle, m_hiZBuffer, PipelineStageFlags_ComputeShader, AccessFlags_ShaderWrite, PipelineStageFlags_ComputeShader, AccessFlags_ShaderRead);
+
+		m_hiZWidth = next_level_size(width);
+		m_hiZHeight = next_level_size(height);
+		m_hiZLevels = levelCount;
+		m_hiZViewProjection = viewProjection;
+		m_hiZReverseZ = reverseZ;
+	}
+
+	void GpuCulling::cull(CommandListHandle commandListHandle, BufferHandle instanceBufferHandle, std::uint32_t instanceCount, BufferHandle drawBufferHandle, const GpuCullView& view)
+	{
+		GFX_ASSERT(m_valid, "GpuCulling is not valid!");
+		GFX_ASSERT(instanceCount <= m_maxInstances, "More instances than GpuCullingInfo::maxInstances!");
+
+		const bool occlusion = view.occlusion && m_hiZLevels != 0;
+		const CullParams params{
+			.viewProjection = view.viewProjection,
+			.hiZViewProjection = m_hiZViewProjection,
+			.instanceCount = instanceCount,
+			.hiZWidth = m_hiZWidth,
+			.hiZHeight = m_hiZHeight,
+			.hiZLevels = occlusion ? m_hiZLevels : 0,
+			.flags = (occlusion ? CullFlags_Occlusion : 0u) | (m_hiZReverseZ ? CullFlags_ReverseZ : 0u),
+		};
+
+		// The last draw() and cull() may still be reading what is overwritten here.
+		buffer_barrier(commandListHandle, m_countBuffer, PipelineStageFlags_DrawIndirect, AccessFlags_IndirectCommandRead, PipelineStageFlags_Transfer, AccessFlags_TransferWrite);
+		buffer_barrier(commandListHandle, m_paramsBuffer, PipelineStageFlags_ComputeShader, AccessFlags_UniformRead, PipelineStageFlags_Transfer, AccessFlags_TransferWrite);
+		buffer_barrier(commandListHandle, m_drawBuffer, PipelineStageFlags_DrawIndirect, AccessFlags_IndirectCommandRead, PipelineStageFlags_ComputeShader, AccessFlags_ShaderWrite);
+		fill_buffer(commandListHandle, m_countBuffer, 0, sizeof(std::uint32_t), 0);
+		if (instanceCount == 0)
+		{
+			buffer_barrier(commandListHandle, m_countBuffer, PipelineStageFlags_Transfer, AccessFlags_TransferWrite, PipelineStageFlags_DrawIndirect, AccessFlags_IndirectCommandRead);
+			return;
+		}
+		update_buffer(commandListHandle, m_paramsBuffer, 0, sizeof(CullParams), &params);
+		buffer_barrier(commandListHandle, m_countBuffer, PipelineStageFlags_Transfer, AccessFlags_TransferWrite, PipelineStageFlags_ComputeShader, AccessFlags_ShaderRead | AccessFlags_ShaderWrite);
+		buffer_barrier(commandListHandle, m_paramsBuffer, PipelineStageFlags_Transfer, AccessFlags_TransferWrite, PipelineStageFlags_ComputeShader, AccessFlags_UniformRead);
+
+		// Without a pyramid the binding is never read, but must still hold a buffer.
+		const std::array<DescriptorWrite, 6> writes{
+			DescriptorWrite{ .binding = 0, .bufferHandle = m_paramsBuffer },
+			DescriptorWrite{ .binding = 1, .bufferHandle = instanceBufferHandle },
+			DescriptorWrite{ .binding = 2, .bufferHandle = drawBufferHandle },
+			DescriptorWrite{ .binding = 3, .bufferHandle = m_drawBuffer },
+			DescriptorWrite{ .binding = 4, .bufferHandle = m_countBuffer },
+			DescriptorWrite{ .binding = 5, .bufferHandle = m_hiZBuffer ? m_hiZBuffer : m_countBuffer },
+		};
+		DescriptorSetHandle descriptorSetHandle{};
+		if (!get_cached_descriptor_set(descriptorSetHandle, m_deviceHandle, m_cullSetInfo, writes))
+		{
+			return;
+		}
+
+		bind_pipeline(commandListHandle, m_cullPipeline);
+		bind_descriptor_sets(commandListHandle, 0, { &descriptorSetHandle, 1 });
+		dispatch(commandListHandle, (instanceCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+		buffer_barrier(commandListHandle, m_drawBuffer, PipelineStageFlags_ComputeShader, AccessFlags_ShaderWrite, PipelineStageFlags_DrawIndirect, AccessFlags_IndirectCommandRead);
+		buffer_barrier(commandListHandle, m_countBuffer, PipelineStageFlags_ComputeShader, AccessFlags_ShaderWrite, PipelineStageFlags_DrawIndirect, AccessFlags_IndirectCommandRead);
+	}
+
+	void GpuCulling::draw(CommandListHandle commandListHandle) const
+	{
+		GFX_ASSERT(m_valid, "GpuCulling is not valid!");
+
+		draw_indexed_indirect_count(commandListHandle, m_drawBuffer, 0, m_countBuffer, 0, m_maxInstances);
+	}
+
+} // namespace sm::gfx
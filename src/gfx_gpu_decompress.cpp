@@ -0,0 +1,469 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx_gpu_decompress.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace sm::gfx
+{
+	namespace
+	{
+		// A block is a series of sequences, each a token byte, literals, then a match. The token's high nibble is the literal
+		// count and its low nibble the match length minus MIN_MATCH, 15 in either meaning more bytes follow that are added on
+		// until one is not 255. Literals follow the literal count, then the match's offset back into the block, two bytes little
+		// endian, then the rest of its length. The last sequence ends at its literals, where the block's data ends.
+		constexpr std::uint32_t MIN_MATCH = 4;
+		constexpr std::uint32_t HASH_BITS = 12;
+
+		constexpr std::uint32_t MAX_GROUP_COUNT = 65535; // The least maxComputeWorkGroupCount[0] a device may have.
+		constexpr std::uint64_t SCRATCH_ALIGNMENT = 48; // A multiple of 4 and of every texel block size, for copies into textures.
+
+		// Must match DecompressConstants in gfx_decompress.hlsl.
+		struct DecompressConstants
+		{
+			std::uint32_t tableOffset; // Of the Blocks, in the transient buffer.
+			std::uint32_t firstBlock;
+		};
+
+		static_assert(GPU_COMPRESSED_BLOCK_SIZE <= 65536, "Match offsets are 16 bits!");
+
+		auto align_up(std::uint64_t value, std::uint64_t alignment) -> std::uint64_t
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		auto read_u32(const std::byte* data) -> std::uint32_t
+		{
+			std::uint32_t value{};
+			std::memcpy(&value, data, sizeof(value));
+			return value;
+		}
+
+		auto hash(std::uint32_t value) -> std::uint32_t
+		{
+			return (value * 2654435761u) >> (32u - HASH_BITS);
+		}
+
+		void write_length(std::vector<std::byte>& out, std::uint32_t length)
+		{
+			for (; length >= 255; length -= 255)
+			{
+				out.push_back(std::byte{ 255 });
+			}
+			out.push_back(std::byte(length));
+		}
+
+		/**
+		 * @param matchLength 0 for the last sequence of a block, which has no match.
+		 */
+		void write_sequence(std::vector<std::byte>& out, std::span<const std::byte> literals, std::uint32_t matchLength, std::uint32_t offset)
+		{
+			const auto literalCode = std::min(std::uint32_t(literals.size()), 15u);
+			const auto matchCode = matchLength != 0 ? std::min(matchLength - MIN_MATCH, 15u) : 0u;
+			out.push_back(std::byte((literalCode << 4u) | matchCode));
+			if (literalCode == 15)
+			{
+				write_length(out, std::uint32_t(literals.size()) - 15);
+			}
+			out.insert(out.end(), literals.begin(), literals.end());
+			if (matchLength == 0)
+			{
+				return;
+			}
+			out.push_back(std::byte(offset & 0xFFu));
+			out.push_back(std::byte(offset >> 8u));
+			if (matchCode == 15)
+			{
+				write_length(out, matchLength - MIN_MATCH - 15);
+			}
+		}
+
+		void compress_block(std::vector<std::byte>& out, std::span<const std::byte> block)
+		{
+			const auto start = out.size();
+
+			// The last position each hash of four bytes was seen at.
+			std::array<std::int32_t, 1u << HASH_BITS> positions{};
+			positions.fill(-1);
+
+			std::size_t literalStart = 0;
+			std::size_t pos = 0;
+			while (pos + MIN_MATCH <= block.size())
+			{
+				const auto value = read_u32(&block[pos]);
+				const auto candidate = std::exchange(positions[hash(value)], std::int32_t(pos));
+				if (candidate < 0 || read_u32(&block[candidate]) != value)
+				{
+					++pos;
+					continue;
+				}
+
+				// Matches may overlap the bytes they produce, eg. runs, which the decoder repeats with a period of the offset.
+				auto length = MIN_MATCH;
+				while (pos + length < block.size() && block[candidate + length] == block[pos + length])
+				{
+					++length;
+				}
+				write_sequence(out, block.subspan(literalStart, pos - literalStart), length, std::uint32_t(pos - candidate));
+				pos += length;
+				literalStart = pos;
+			}
+			write_sequence(out, block.subspan(literalStart), 0, 0);
+
+			// Data that does not compress is stored as is, told apart by its size.
+			if (out.size() - start >= block.size())
+			{
+				out.resize(start);
+				out.insert(out.end(), block.begin(), block.end());
+			}
+		}
+
+		bool decompress_block(std::span<std::byte> dst, std::span<const std::byte> src)
+		{
+			if (src.size() == dst.size())
+			{
+				std::memcpy(dst.data(), src.data(), src.size());
+				return true;
+			}
+
+			std::size_t s = 0;
+			std::size_t d = 0;
+			const auto read_length = [&](std::uint32_t& length) {
+				std::uint32_t extra{};
+				do
+				{
+					if (s == src.size())
+					{
+						return false;
+					}
+					extra = std::uint32_t(src[s++]);
+					length += extra;
+				} while (extra == 255);
+				return true;
+			};
+			while (s < src.size())
+			{
+				const auto token = std::uint32_t(src[s++]);
+				std::uint32_t literalLength = token >> 4u;
+				if ((literalLength == 15 && !read_length(literalLength)) || literalLength > src.size() - s || literalLength > dst.size() - d)
+				{
+					return false;
+				}
+				std::memcpy(dst.data() + d, src.data() + s, literalLength);
+				s += literalLength;
+				d += literalLength;
+				if (s == src.size())
+				{
+					break;
+				}
+
+				if (src.size() - s < 2)
+				{
+					return false;
+				}
+				const auto offset = std::uint32_t(src[s]) | (std::uint32_t(src[s + 1]) << 8u);
+				s += 2;
+				std::uint32_t matchLength = (token & 0xFu) + MIN_MATCH;
+				if (((token & 0xFu) == 15 && !read_length(matchLength)) || offset == 0 || offset > d || matchLength > dst.size() - d)
+				{
+					return false;
+				}
+				for (std::uint32_t i = 0; i < matchLength; ++i, ++d)
+				{
+					dst[d] = dst[d - offset];
+				}
+			}
+			return d == dst.size();
+		}
+
+		/**
+		 * @brief Check a stream's header and block table.
+		 * @return Where the block data starts, or 0 if the stream is malformed.
+		 */
+		auto read_stream(GpuCompressedHeader& outHeader, std::span<const std::byte> compressed) -> std::uint64_t
+		{
+			if (compressed.size() < sizeof(GpuCompressedHeader))
+			{
+				return 0;
+			}
+			std::memcpy(&outHeader, compressed.data(), sizeof(GpuCompressedHeader));
+			const auto dataOffset = sizeof(GpuCompressedHeader) + sizeof(std::uint32_t) * std::uint64_t(outHeader.blockCount);
+			if (outHeader.magic != GPU_COMPRESSED_MAGIC || outHeader.size == 0 || outHeader.blockCount != (outHeader.size + GPU_COMPRESSED_BLOCK_SIZE - 1) / GPU_COMPRESSED_BLOCK_SIZE ||
+				dataOffset > compressed.size())
+			{
+				return 0;
+			}
+
+			std::uint32_t blockStart = 0;
+			for (std::uint32_t block = 0; block < outHeader.blockCount; ++block)
+			{
+				const auto blockEnd = read_u32(&compressed[sizeof(GpuCompressedHeader) + sizeof(std::uint32_t) * block]);
+				if (blockEnd <= blockStart)
+				{
+					return 0;
+				}
+				blockStart = blockEnd;
+			}
+			return dataOffset + blockStart == compressed.size() ? dataOffset : 0;
+		}
+
+		auto get_block_end(std::span<const std::byte> compressed, std::uint32_t block) -> std::uint32_t
+		{
+			return read_u32(&compressed[sizeof(GpuCompressedHeader) + sizeof(std::uint32_t) * block]);
+		}
+	} // namespace
+
+	auto compress_for_gpu(std::span<const std::byte> data) -> std::vector<std::byte>
+	{
+		const auto blockCount = std::uint32_t((data.size() + GPU_COMPRESSED_BLOCK_SIZE - 1) / GPU_COMPRESSED_BLOCK_SIZE);
+		const GpuCompressedHeader header{
+			.magic = GPU_COMPRESSED_MAGIC,
+			.blockCount = blockCount,
+			.size = data.size(),
+		};
+		const auto dataOffset = sizeof(GpuCompressedHeader) + sizeof(std::uint32_t) * std::size_t(blockCount);
+
+		std::vector<std::byte> out(dataOffset);
+		out.reserve(dataOffset + data.size());
+		std::memcpy(out.data(), &header, sizeof(header));
+		for (std::uint32_t block = 0; block < blockCount; ++block)
+		{
+			const auto blockOffset = std::size_t(block) * GPU_COMPRESSED_BLOCK_SIZE;
+			compress_block(out, data.subspan(blockOffset, std::min<std::size_t>(GPU_COMPRESSED_BLOCK_SIZE, data.size() - blockOffset)));
+
+			GFX_ASSERT(out.size() - dataOffset <= std::numeric_limits<std::uint32_t>::max(), "Compressed data must be smaller than 4GiB!");
+			const auto blockEnd = std::uint32_t(out.size() - dataOffset);
+			std::memcpy(&out[sizeof(GpuCompressedHeader) + sizeof(std::uint32_t) * block], &blockEnd, sizeof(blockEnd));
+		}
+		return out;
+	}
+
+	auto get_decompressed_size(std::span<const std::byte> compressed) -> std::uint64_t
+	{
+		GpuCompressedHeader header{};
+		return read_stream(header, compressed) != 0 ? header.size : 0;
+	}
+
+	bool decompress_on_cpu(std::span<std::byte> dst, std::span<const std::byte> compressed)
+	{
+		GpuCompressedHeader header{};
+		const auto dataOffset = read_stream(header, compressed);
+		if (dataOffset == 0 || dst.size() != header.size)
+		{
+			GFX_LOG_ERR("GFX - decompress_on_cpu() - Malformed stream, or dst is not its decompressed size!");
+			return false;
+		}
+
+		const auto data = compressed.subspan(dataOffset);
+		std::uint32_t blockStart = 0;
+		for (std::uint32_t block = 0; block < header.blockCount; ++block)
+		{
+			const auto blockEnd = get_block_end(compressed, block);
+			const auto dstOffset = std::size_t(block) * GPU_COMPRESSED_BLOCK_SIZE;
+			if (!decompress_block(dst.subspan(dstOffset, std::min<std::size_t>(GPU_COMPRESSED_BLOCK_SIZE, dst.size() - dstOffset)), data.subspan(blockStart, blockEnd - blockStart)))
+			{
+				GFX_LOG_ERR("GFX - decompress_on_cpu() - Malformed block!");
+				return false;
+			}
+			blockStart = blockEnd;
+		}
+		return true;
+	}
+
+	GpuDecompressor::GpuDecompressor(DeviceHandle deviceHandle, const GpuDecompressorInfo& decompressorInfo)
+		: m_deviceHandle(deviceHandle)
+	{
+		m_setInfo.bindings = {
+			{ DescriptorType::eStorageBuffer, 1, ShaderStageFlags_Compute }, // Compressed blocks and their table, in the transient buffer
+			{ DescriptorType::eStorageBuffer, 1, ShaderStageFlags_Compute }, // Decompressed scratch
+		};
+		const ComputePipelineInfo pipelineInfo{
+			.shaderCode = decompressorInfo.shaderCode,
+			.descriptorSets = { m_setInfo },
+			.constantBlock = { sizeof(DecompressConstants), ShaderStageFlags_Compute },
+			.debugName = "gfx_decompress",
+		};
+		if (!create_compute_pipeline(m_pipeline, deviceHandle, pipelineInfo))
+		{
+			return;
+		}
+
+		m_valid = true;
+	}
+
+	GpuDecompressor::~GpuDecompressor()
+	{
+		if (m_scratchBuffer)
+		{
+			destroy_buffer(m_scratchBuffer);
+		}
+		if (m_pipeline)
+		{
+			destroy_pipeline(m_pipeline);
+		}
+	}
+
+	bool GpuDecompressor::is_valid() const
+	{
+		return m_valid;
+	}
+
+	bool GpuDecompressor::queue_buffer_upload(BufferHandle bufferHandle, std::uint64_t offset, std::span<const std::byte> compressed)
+	{
+		return queue_upload({ .bufferHandle = bufferHandle, .bufferOffset = offset }, compressed);
+	}
+
+	bool GpuDecompressor::queue_texture_upload(TextureHandle textureHandle, const BufferTextureCopyRegion& region, std::span<const std::byte> compressed)
+	{
+		return queue_upload({ .textureHandle = textureHandle, .region = region }, compressed);
+	}
+
+	bool GpuDecompressor::queue_upload(Upload upload, std::span<const std::byte> compressed)
+	{
+		GFX_ASSERT(m_valid, "GpuDecompressor is not valid!");
+
+		GpuCompressedHeader header{};
+		const auto dataOffset = read_stream(header, compressed);
+		if (dataOffset == 0)
+		{
+			GFX_LOG_ERR("GFX - GpuDecompressor - Can only upload streams from compress_for_gpu()!");
+			return false;
+		}
+
+		// Only the blocks' data crosses to the GPU, their table is rebuilt in record() with where everything ended up.
+		const auto data = compressed.subspan(dataOffset);
+		const auto allocation = allocate_transient(m_deviceHandle, data.size(), sizeof(std::uint32_t));
+		if (allocation.ptr == nullptr)
+		{
+			GFX_LOG_ERR("GFX - GpuDecompressor - Out of transient memory for compressed uploads this frame!");
+			return false;
+		}
+		std::memcpy(allocation.ptr, data.data(), data.size());
+
+		std::lock_guard lock{ m_mutex };
+		upload.scratchOffset = align_up(m_pendingSize, SCRATCH_ALIGNMENT);
+		upload.size = header.size;
+		if (allocation.offset + data.size() > std::numeric_limits<std::uint32_t>::max() || upload.scratchOffset + upload.size > std::numeric_limits<std::uint32_t>::max())
+		{
+			GFX_LOG_ERR("GFX - GpuDecompressor - More than 4GiB queued for one record()!");
+			return false;
+		}
+
+		std::uint32_t blockStart = 0;
+		for (std::uint32_t block = 0; block < header.blockCount; ++block)
+		{
+			const auto blockEnd = get_block_end(compressed, block);
+			const auto dstOffset = std::uint64_t(block) * GPU_COMPRESSED_BLOCK_SIZE;
+			m_blocks.push_back({
+				.srcOffset = std::uint32_t(allocation.offset + blockStart),
+				.srcSize = blockEnd - blockStart,
+				.dstOffset = std::uint32_t(upload.scratchOffset + dstOffset),
+				.dstSize = std::uint32_t(std::min<std::uint64_t>(GPU_COMPRESSED_BLOCK_SIZE, header.size - dstOffset)),
+			});
+			blockStart = blockEnd;
+		}
+		m_transientBuffer = allocation.bufferHandle;
+		m_uploads.push_back(upload);
+		m_pendingSize = upload.scratchOffset + upload.size;
+		return true;
+	}
+
+	void GpuDecompressor::record(CommandListHandle commandListHandle)
+	{
+		GFX_ASSERT(m_valid, "GpuDecompressor is not valid!");
+
+		std::lock_guard lock{ m_mutex };
+		if (m_uploads.empty())
+		{
+			return;
+		}
+		const auto clear_pending = [&] {
+			m_blocks.clear();
+			m_uploads.clear();
+			m_pendingSize = 0;
+		};
+
+		// Blocks write whole words, so the last may write up to 3 bytes past its end.
+		const auto scratchSize = align_up(m_pendingSize, sizeof(std::uint32_t));
+		if (scratchSize > m_scratchBufferSize)
+		{
+			if (m_scratchBuffer)
+			{
+				destroy_buffer(m_scratchBuffer);
+			}
+			m_scratchBufferSize = 0;
+			if (!create_buffer(m_scratchBuffer, m_deviceHandle, { .type = BufferType::eStorage, .size = scratchSize, .memory = BufferMemory::eGpuOnly, .debugName = "gfx_decompress_scratch" }))
+			{
+				m_scratchBuffer = {};
+				clear_pending();
+				return;
+			}
+			m_scratchBufferSize = scratchSize;
+		}
+
+		const auto table = allocate_transient(m_deviceHandle, sizeof(Block) * m_blocks.size(), sizeof(Block));
+		if (table.ptr == nullptr || table.offset > std::numeric_limits<std::uint32_t>::max())
+		{
+			GFX_LOG_ERR("GFX - GpuDecompressor - Out of transient memory for the block table, the queued uploads are dropped!");
+			clear_pending();
+			return;
+		}
+		std::memcpy(table.ptr, m_blocks.data(), sizeof(Block) * m_blocks.size());
+
+		const std::array<DescriptorWrite, 2> writes{
+			DescriptorWrite{ .binding = 0, .bufferHandle = m_transientBuffer },
+			DescriptorWrite{ .binding = 1, .bufferHandle = m_scratchBuffer },
+		};
+		DescriptorSetHandle descriptorSetHandle{};
+		if (!get_cached_descriptor_set(descriptorSetHandle, m_deviceHandle, m_setInfo, writes))
+		{
+			clear_pending();
+			return;
+		}
+
+		// The last record()'s copies may still be reading the scratch buffer.
+		buffer_barrier(commandListHandle, m_scratchBuffer, PipelineStageFlags_Transfer, AccessFlags_TransferRead, PipelineStageFlags_ComputeShader, AccessFlags_ShaderWrite);
+		bind_pipeline(commandListHandle, m_pipeline);
+		bind_descriptor_sets(commandListHandle, 0, { &descriptorSetHandle, 1 });
+		const auto blockCount = std::uint32_t(m_blocks.size());
+		for (std::uint32_t firstBlock = 0; firstBlock < blockCount; firstBlock += MAX_GROUP_COUNT)
+		{
+			const DecompressConstants constants{
+				.tableOffset = std::uint32_t(table.offset),
+				.firstBlock = firstBlock,
+			};
+			set_constants(commandListHandle, ShaderStageFlags_Compute, 0, sizeof(DecompressConstants), &constants);
+			dispatch(commandListHandle, std::min(MAX_GROUP_COUNT, blockCount - firstBlock), 1, 1);
+		}
+		buffer_barrier(commandListHandle, m_scratchBuffer, PipelineStageFlags_ComputeShader, AccessFlags_ShaderWrite, PipelineStageFlags_Transfer, AccessFlags_TransferRead);
+
+		for (const auto& upload : m_uploads)
+		{
+			if (upload.bufferHandle)
+			{
+				const BufferCopyRegion region{ .srcOffset = upload.scratchOffset, .dstOffset = upload.bufferOffset, .size = upload.size };
+				copy_buffer(commandListHandle, m_scratchBuffer, upload.bufferHandle, { &region, 1 });
+			}
+			else
+			{
+				auto region = upload.region;
+				region.bufferOffset = upload.scratchOffset;
+				copy_buffer_to_texture(commandListHandle, m_scratchBuffer, upload.textureHandle, { &region, 1 });
+			}
+		}
+		clear_pending();
+	}
+
+	auto GpuDecompressor::get_pending_size() const -> std::uint64_t
+	{
+		std::lock_guard lock{ m_mutex };
+		return m_pendingSize;
+	}
+
+} // namespace sm::gfx
@@ -0,0 +1,890 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx_mesh.hpp"
+
+#if _WIN32
+	#define NOMINMAX
+	#define WIN32_LEAN_AND_MEAN
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace sm::gfx
+{
+	namespace
+	{
+		auto align_up(std::uint64_t value, std::uint64_t alignment) -> std::uint64_t
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		auto get_index_size(IndexType indexType) -> std::uint64_t
+		{
+			return indexType == IndexType::eUInt16 ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+		}
+
+		// Pad the stream up to the next offset, which is never before its end.
+		void write_padding(std::ofstream& file, std::uint64_t offset)
+		{
+			static constexpr std::array<char, MESH_FILE_ALIGNMENT> ZEROS{};
+			file.write(ZEROS.data(), std::streamsize(offset - std::uint64_t(file.tellp())));
+		}
+
+		auto float_to_half(float value) -> std::uint16_t
+		{
+			const auto bits = std::bit_cast<std::uint32_t>(value);
+			const auto sign = std::uint16_t((bits >> 16) & 0x8000);
+			const auto magnitude = bits & 0x7FFFFFFF;
+			if (magnitude >= 0x7F800000)
+			{
+				return sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 : 0); // Infinity, or a quiet NaN.
+			}
+			if (magnitude >= 0x477FF000)
+			{
+				return sign | 0x7C00; // Rounds past the largest half, 65504.
+			}
+			if (magnitude < 0x38800000)
+			{
+				// Subnormal halves are multiples of 2^-24.
+				return sign | std::uint16_t(std::nearbyint(std::bit_cast<float>(magnitude) * 16777216.0f));
+			}
+			// Rebias the exponent from 127 to 15, and round the 13 dropped mantissa bits to nearest even.
+			auto half = (magnitude - 0x38000000) >> 13;
+			const auto remainder = magnitude & 0x1FFF;
+			if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1) != 0))
+			{
+				++half;
+			}
+			return sign | std::uint16_t(half);
+		}
+
+		auto half_to_float(std::uint16_t half) -> float
+		{
+			const auto sign = std::uint32_t(half & 0x8000) << 16;
+			const std::uint32_t exponent = (half >> 10) & 0x1F;
+			const std::uint32_t mantissa = half & 0x3FF;
+			if (exponent == 0)
+			{
+				const auto magnitude = float(mantissa) / 16777216.0f;
+				return sign != 0 ? -magnitude : magnitude;
+			}
+			if (exponent == 0x1F)
+			{
+				return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
+			}
+			return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+		}
+
+		auto to_snorm(float value, float scale) -> std::int32_t
+		{
+			return std::int32_t(std::round(std::clamp(value, -1.0f, 1.0f) * scale));
+		}
+
+		auto to_unorm(float value, float scale) -> std::uint32_t
+		{
+			return std::uint32_t(std::round(std::clamp(value, 0.0f, 1.0f) * scale));
+		}
+
+		template <typename T>
+		void write_components(std::byte* dst, const std::array<float, 4>& values, std::uint32_t componentCount, auto convert)
+		{
+			for (std::uint32_t i = 0; i < componentCount; ++i)
+			{
+				const auto component = T(convert(values[i]));
+				std::memcpy(dst + i * sizeof(T), &component, sizeof(T));
+			}
+		}
+
+		// Octahedral mapping of a unit vector onto the -1 to 1 square, folding the lower hemisphere over the upper.
+		auto encode_octahedral(const std::array<float, 4>& vector) -> std::array<float, 4>
+		{
+			const auto sum = std::abs(vector[0]) + std::abs(vector[1]) + std::abs(vector[2]);
+			if (sum <= 0.0f)
+			{
+				return {};
+			}
+			auto x = vector[0] / sum;
+			auto y = vector[1] / sum;
+			if (vector[2] < 0.0f)
+			{
+				const auto foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+				y = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+				x = foldedX;
+			}
+			return { x, y, 0.0f, 0.0f };
+		}
+
+		void write_attribute(std::byte* dst, Format format, const std::array<float, 4>& values)
+		{
+			switch (format)
+			{
+				case Format::eRG32:
+				case Format::eRGB32:
+				case Format::eRGBA32:
+					std::memcpy(dst, values.data(), get_vertex_format_size(format));
+					break;
+				case Format::eRG16Float:
+				case Format::eRGBA16Float:
+					write_components<std::uint16_t>(dst, values, format == Format::eRG16Float ? 2 : 4, float_to_half);
+					break;
+				case Format::eRG16Snorm:
+				case Format::eRGBA16Snorm:
+					write_components<std::int16_t>(dst, values, format == Format::eRG16Snorm ? 2 : 4, [](float value) { return to_snorm(value, 32767.0f); });
+					break;
+				case Format::eRG16Unorm:
+				case Format::eRGBA16Unorm:
+					write_components<std::uint16_t>(dst, values, format == Format::eRG16Unorm ? 2 : 4, [](float value) { return to_unorm(value, 65535.0f); });
+					break;
+				case Format::eRG8Snorm:
+				case Format::eRGBA8Snorm:
+					write_components<std::int8_t>(dst, values, format == Format::eRG8Snorm ? 2 : 4, [](float value) { return to_snorm(value, 127.0f); });
+					break;
+				case Format::eR8:
+				case Format::eRG8:
+				case Format::eRGB8:
+				case Format::eRGBA8:
+					write_components<std::uint8_t>(dst, values, get_vertex_format_size(format), [](float value) { return to_unorm(value, 255.0f); });
+					break;
+				case Format::eRGB10A2Unorm:
+				{
+					const auto packed = to_unorm(values[0], 1023.0f) | to_unorm(values[1], 1023.0f) << 10 | to_unorm(values[2], 1023.0f) << 20 | to_unorm(values[3], 3.0f) << 30;
+					std::memcpy(dst, &packed, sizeof(packed));
+					break;
+				}
+				case Format::eRGB10A2Snorm:
+				{
+					const auto packed = (std::uint32_t(to_snorm(values[0], 511.0f)) & 0x3FF) | (std::uint32_t(to_snorm(values[1], 511.0f)) & 0x3FF) << 10 |
+										(std::uint32_t(to_snorm(values[2], 511.0f)) & 0x3FF) << 20 | (std::uint32_t(to_snorm(values[3], 1.0f)) & 0x3) << 30;
+					std::memcpy(dst, &packed, sizeof(packed));
+					break;
+				}
+				default:
+					GFX_ASSERT(false, "Format cannot be used for quantized vertices!");
+					break;
+			}
+		}
+
+		auto read_position(const std::byte* vertex, Format positionFormat) -> std::array<float, 3>
+		{
+			if (positionFormat == Format::eRGBA16Float)
+			{
+				std::array<std::uint16_t, 3> halves{};
+				std::memcpy(halves.data(), vertex, sizeof(halves));
+				return { half_to_float(halves[0]), half_to_float(halves[1]), half_to_float(halves[2]) };
+			}
+			GFX_ASSERT(positionFormat == Format::eRGB32 || positionFormat == Format::eRGBA32, "Mesh positions must be floats or half floats!");
+			std::array<float, 3> position{};
+			std::memcpy(position.data(), vertex, sizeof(position));
+			return position;
+		}
+
+		constexpr std::uint32_t VERTEX_CACHE_SIZE = 32;
+		constexpr std::uint32_t MAX_CLUSTER_TRIANGLES = 512; // Overdraw sorting granularity, each split costs a cache refill.
+
+		auto get_position(const std::byte* vertexData, std::uint32_t vertexStride, std::uint32_t vertex) -> std::array<float, 3>
+		{
+			std::array<float, 3> position{};
+			std::memcpy(position.data(), vertexData + std::uint64_t(vertex) * vertexStride, sizeof(position));
+			return position;
+		}
+
+		auto get_vertex_score(std::int32_t cachePosition, std::uint32_t remainingTriangles) -> float
+		{
+			if (remainingTriangles == 0)
+			{
+				return -1.0f;
+			}
+			float score{ 0.0f };
+			if (cachePosition >= 0)
+			{
+				// The last triangle's vertices score the same, so it is not favoured to use them again straight away.
+				score = cachePosition < 3 ? 0.75f : std::pow(1.0f - float(cachePosition - 3) / float(VERTEX_CACHE_SIZE - 3), 1.5f);
+			}
+			// Favour vertices with few triangles left, so they are finished off rather than left to be fetched again.
+			return score + 2.0f / std::sqrt(float(remainingTriangles));
+		}
+
+		/**
+		 * @brief Reorder triangles for the post-transform cache, with Tom Forsyth's linear-speed optimisation. Where no cached
+		 * vertex has triangles left, it carries on from the first triangle not yet emitted.
+		 * @return The first triangle of each run that starts with a cold cache.
+		 */
+		auto optimize_vertex_cache(std::vector<std::uint32_t>& indices, std::uint32_t vertexCount) -> std::vector<std::uint32_t>
+		{
+			const auto triangleCount = std::uint32_t(indices.size() / 3);
+
+			// The triangles of each vertex not yet emitted, at triangleOffsets[v] onwards.
+			std::vector<std::uint32_t> triangleOffsets(vertexCount + 1, 0);
+			for (const auto index : indices)
+			{
+				++triangleOffsets[index + 1];
+			}
+			for (std::uint32_t v = 0; v < vertexCount; ++v)
+			{
+				triangleOffsets[v + 1] += triangleOffsets[v];
+			}
+			std::vector<std::uint32_t> remainingTriangles(vertexCount, 0);
+			std::vector<std::uint32_t> vertexTriangles(indices.size());
+			for (std::uint32_t i = 0; i < indices.size(); ++i)
+			{
+				const auto v = indices[i];
+				vertexTriangles[triangleOffsets[v] + remainingTriangles[v]++] = i / 3;
+			}
+
+			std::vector<std::int32_t> cachePositions(vertexCount, -1);
+			std::vector<float> vertexScores(vertexCount);
+			for (std::uint32_t v = 0; v < vertexCount; ++v)
+			{
+				vertexScores[v] = get_vertex_score(-1, remainingTriangles[v]);
+			}
+
+			std::vector<bool> emitted(triangleCount, false);
+			std::vector<std::uint32_t> output(indices.size());
+			std::vector<std::uint32_t> runStarts{};
+			std::array<std::uint32_t, VERTEX_CACHE_SIZE + 3> cache{};
+			std::uint32_t cacheCount{ 0 };
+			std::uint32_t nextTriangle{ 0 };
+			std::int64_t best{ -1 };
+			for (std::uint32_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+			{
+				if (best < 0)
+				{
+					while (emitted[nextTriangle])
+					{
+						++nextTriangle;
+					}
+					best = nextTriangle;
+					runStarts.push_back(emittedCount);
+				}
+
+				const auto triangle = std::uint32_t(best);
+				emitted[triangle] = true;
+				std::array<std::uint32_t, VERTEX_CACHE_SIZE + 3> newCache{};
+				std::uint32_t newCacheCount{ 0 };
+				for (auto k = 0; k < 3; ++k)
+				{
+					const auto v = indices[triangle * 3 + k];
+					output[emittedCount * 3 + k] = v;
+					newCache[newCacheCount++] = v;
+
+					auto* first = vertexTriangles.data() + triangleOffsets[v];
+					auto* last = first + remainingTriangles[v];
+					std::iter_swap(std::find(first, last, triangle), last - 1);
+					--remainingTriangles[v];
+				}
+
+				// The triangle's vertices move to the front of the cache, pushing the oldest out of the end.
+				for (std::uint32_t i = 0; i < cacheCount; ++i)
+				{
+					if (std::find(newCache.begin(), newCache.begin() + 3, cache[i]) == newCache.begin() + 3)
+					{
+						newCache[newCacheCount++] = cache[i];
+					}
+				}
+				for (std::uint32_t i = 0; i < newCacheCount; ++i)
+				{
+					const auto v = newCache[i];
+					cachePositions[v] = i < VERTEX_CACHE_SIZE ? std::int32_t(i) : -1;
+					vertexScores[v] = get_vertex_score(cachePositions[v], remainingTriangles[v]);
+				}
+				cache = newCache;
+				cacheCount = std::min(newCacheCount, VERTEX_CACHE_SIZE);
+
+				// Only the cached vertices' scores changed, so the next triangle is the best of theirs.
+				best = -1;
+				float bestScore{ 0.0f };
+				for (std::uint32_t i = 0; i < cacheCount; ++i)
+				{
+					const auto v = cache[i];
+					for (auto j = triangleOffsets[v]; j < triangleOffsets[v] + remainingTriangles[v]; ++j)
+					{
+						const auto candidate = vertexTriangles[j];
+						const auto score = vertexScores[indices[candidate * 3]] + vertexScores[indices[candidate * 3 + 1]] + vertexScores[indices[candidate * 3 + 2]];
+						if (best < 0 || score > bestScore)
+						{
+							best = candidate;
+							bestScore = score;
+						}
+					}
+				}
+			}
+
+			indices = std::move(output);
+			return runStarts;
+		}
+
+		/**
+		 * @brief Draw runs of triangles facing away from the mesh's centre first, as those are the most likely to occlude the
+		 * rest. Runs start where the cache was cold anyway, or every MAX_CLUSTER_TRIANGLES, so little cache efficiency is lost.
+		 */
+		void optimize_overdraw(std::vector<std::uint32_t>& indices, const std::byte* vertexData, std::uint32_t vertexStride, std::span<const std::uint32_t> runStarts)
+		{
+			struct Cluster
+			{
+				std::uint32_t firstTriangle;
+				std::uint32_t triangleCount;
+				std::array<float, 3> centroid{}; // Area weighted, and normal is the summed area vectors, both divided out below.
+				std::array<float, 3> normal{};
+				float area{ 0.0f };
+				float sortKey{ 0.0f };
+			};
+
+			const auto triangleCount = std::uint32_t(indices.size() / 3);
+			std::vector<Cluster> clusters{};
+			for (std::size_t run = 0; run < runStarts.size(); ++run)
+			{
+				const auto runEnd = run + 1 < runStarts.size() ? runStarts[run + 1] : triangleCount;
+				for (auto first = runStarts[run]; first < runEnd; first += MAX_CLUSTER_TRIANGLES)
+				{
+					clusters.push_back({ .firstTriangle = first, .triangleCount = std::min(MAX_CLUSTER_TRIANGLES, runEnd - first) });
+				}
+			}
+
+			std::array<float, 3> meshCentroid{};
+			float meshArea{ 0.0f };
+			for (auto& cluster : clusters)
+			{
+				for (auto t = cluster.firstTriangle; t < cluster.firstTriangle + cluster.triangleCount; ++t)
+				{
+					const auto p0 = get_position(vertexData, vertexStride, indices[t * 3]);
+					const auto p1 = get_position(vertexData, vertexStride, indices[t * 3 + 1]);
+					const auto p2 = get_position(vertexData, vertexStride, indices[t * 3 + 2]);
+					const std::array<float, 3> e0{ p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+					const std::array<float, 3> e1{ p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+					const std::array<float, 3> normal{ e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+					const auto area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+					for (auto axis = 0; axis < 3; ++axis)
+					{
+						cluster.centroid[axis] += (p0[axis] + p1[axis] + p2[axis]) / 3.0f * area;
+						cluster.normal[axis] += normal[axis];
+					}
+					cluster.area += area;
+				}
+				for (auto axis = 0; axis < 3; ++axis)
+				{
+					meshCentroid[axis] += cluster.centroid[axis];
+				}
+				meshArea += cluster.area;
+			}
+			if (meshArea <= 0.0f)
+			{
+				return;
+			}
+
+			for (auto& cluster : clusters)
+			{
+				const auto normalLength = std::sqrt(cluster.normal[0] * cluster.normal[0] + cluster.normal[1] * cluster.normal[1] + cluster.normal[2] * cluster.normal[2]);
+				if (cluster.area <= 0.0f || normalLength <= 0.0f)
+				{
+					continue;
+				}
+				for (auto axis = 0; axis < 3; ++axis)
+				{
+					cluster.sortKey += (cluster.centroid[axis] / cluster.area - meshCentroid[axis] / meshArea) * cluster.normal[axis] / normalLength;
+				}
+			}
+			std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& lhs, const Cluster& rhs) { return lhs.sortKey > rhs.sortKey; });
+
+			std::vector<std::uint32_t> output{};
+			output.reserve(indices.size());
+			for (const auto& cluster : clusters)
+			{
+				output.insert(output.end(), indices.begin() + cluster.firstTriangle * 3, indices.begin() + (cluster.firstTriangle + cluster.triangleCount) * 3);
+			}
+			indices = std::move(output);
+		}
+	} // namespace
+
+	auto optimize_mesh(void* vertexData, std::uint32_t vertexStride, std::uint32_t vertexCount, std::vector<std::uint32_t>& indices) -> std::uint32_t
+	{
+		GFX_ASSERT(vertexStride >= sizeof(float) * 3, "Mesh vertices must start with their position!");
+		GFX_ASSERT(indices.size() % 3 == 0, "Mesh indices must be a triangle list!");
+		auto* vertexBytes = static_cast<std::byte*>(vertexData);
+
+		// Merge identical vertices into the first of them.
+		std::vector<std::uint32_t> remap(vertexCount);
+		std::unordered_map<std::string_view, std::uint32_t> uniqueVertices{};
+		uniqueVertices.reserve(vertexCount);
+		for (std::uint32_t v = 0; v < vertexCount; ++v)
+		{
+			const std::string_view bytes{ reinterpret_cast<const char*>(vertexBytes + std::uint64_t(v) * vertexStride), vertexStride };
+			remap[v] = uniqueVertices.emplace(bytes, v).first->second;
+		}
+		std::vector<std::uint32_t> remappedIndices{};
+		remappedIndices.reserve(indices.size());
+		for (std::size_t i = 0; i < indices.size(); i += 3)
+		{
+			const auto a = remap[indices[i]];
+			const auto b = remap[indices[i + 1]];
+			const auto c = remap[indices[i + 2]];
+			if (a != b && b != c && c != a)
+			{
+				remappedIndices.insert(remappedIndices.end(), { a, b, c });
+			}
+		}
+		indices = std::move(remappedIndices);
+
+		const auto runStarts = optimize_vertex_cache(indices, vertexCount);
+		optimize_overdraw(indices, vertexBytes, vertexStride, runStarts);
+
+		// Renumber the vertices in the order they are first used, which also drops unused ones.
+		std::vector<std::uint32_t> newIndices(vertexCount, ~0u);
+		std::uint32_t newVertexCount{ 0 };
+		for (auto& index : indices)
+		{
+			if (newIndices[index] == ~0u)
+			{
+				newIndices[index] = newVertexCount++;
+			}
+			index = newIndices[index];
+		}
+		std::vector<std::byte> newVertexData(std::uint64_t(newVertexCount) * vertexStride);
+		for (std::uint32_t v = 0; v < vertexCount; ++v)
+		{
+			if (newIndices[v] != ~0u)
+			{
+				std::memcpy(newVertexData.data() + std::uint64_t(newIndices[v]) * vertexStride, vertexBytes + std::uint64_t(v) * vertexStride, vertexStride);
+			}
+		}
+		std::memcpy(vertexBytes, newVertexData.data(), newVertexData.size());
+		return newVertexCount;
+	}
+
+	void build_meshlets(MeshletData& outMeshletData, const void* vertexData, std::uint32_t vertexStride, std::uint32_t vertexCount, std::span<const std::uint32_t> indices)
+	{
+		GFX_ASSERT(vertexStride >= sizeof(float) * 3, "Mesh vertices must start with their position!");
+		GFX_ASSERT(indices.size() % 3 == 0, "Mesh indices must be a triangle list!");
+		const auto* vertexBytes = static_cast<const std::byte*>(vertexData);
+
+		outMeshletData = {};
+		// The meshlet local index of each mesh vertex, valid for those added since the current meshlet started.
+		std::vector<std::uint32_t> localIndices(vertexCount, 0);
+		std::vector<std::uint32_t> localMeshlets(vertexCount, ~0u);
+		Meshlet meshlet{};
+		const auto finish_meshlet = [&] {
+			if (meshlet.triangleCount == 0)
+			{
+				return;
+			}
+			outMeshletData.meshlets.push_back(meshlet);
+			meshlet = { .vertexOffset = std::uint32_t(outMeshletData.vertices.size()), .triangleOffset = std::uint32_t(outMeshletData.triangles.size()), .vertexCount = 0, .triangleCount = 0 };
+		};
+		for (std::size_t i = 0; i < indices.size(); i += 3)
+		{
+			const auto meshletIndex = std::uint32_t(outMeshletData.meshlets.size());
+			std::uint32_t newVertices{ 0 };
+			for (auto k = 0; k < 3; ++k)
+			{
+				newVertices += localMeshlets[indices[i + k]] != meshletIndex ? 1 : 0;
+			}
+			if (meshlet.vertexCount + newVertices > MAX_MESHLET_VERTICES || meshlet.triangleCount == MAX_MESHLET_TRIANGLES)
+			{
+				finish_meshlet();
+			}
+
+			std::uint32_t packedTriangle{ 0 };
+			for (auto k = 0; k < 3; ++k)
+			{
+				const auto v = indices[i + k];
+				if (localMeshlets[v] != std::uint32_t(outMeshletData.meshlets.size()))
+				{
+					localMeshlets[v] = std::uint32_t(outMeshletData.meshlets.size());
+					localIndices[v] = meshlet.vertexCount++;
+					outMeshletData.vertices.push_back(v);
+				}
+				packedTriangle |= localIndices[v] << (k * 8);
+			}
+			outMeshletData.triangles.push_back(packedTriangle);
+			++meshlet.triangleCount;
+		}
+		finish_meshlet();
+
+		outMeshletData.bounds.reserve(outMeshletData.meshlets.size());
+		for (const auto& m : outMeshletData.meshlets)
+		{
+			const auto get_meshlet_position = [&](std::uint32_t localIndex) {
+				return get_position(vertexBytes, vertexStride, outMeshletData.vertices[m.vertexOffset + localIndex]);
+			};
+
+			// The sphere around the centre of the box, which is close enough to minimal for clusters this small.
+			std::array<float, 3> boxMin = get_meshlet_position(0);
+			std::array<float, 3> boxMax = boxMin;
+			for (std::uint32_t v = 1; v < m.vertexCount; ++v)
+			{
+				const auto position = get_meshlet_position(v);
+				for (auto axis = 0; axis < 3; ++axis)
+				{
+					boxMin[axis] = std::min(boxMin[axis], position[axis]);
+					boxMax[axis] = std::max(boxMax[axis], position[axis]);
+				}
+			}
+			MeshletBounds bounds{};
+			for (auto axis = 0; axis < 3; ++axis)
+			{
+				bounds.center[axis] = (boxMin[axis] + boxMax[axis]) * 0.5f;
+			}
+			for (std::uint32_t v = 0; v < m.vertexCount; ++v)
+			{
+				const auto position = get_meshlet_position(v);
+				const std::array<float, 3> offset{ position[0] - bounds.center[0], position[1] - bounds.center[1], position[2] - bounds.center[2] };
+				bounds.radius = std::max(bounds.radius, std::sqrt(offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]));
+			}
+
+			// The cone's axis is the mean triangle normal, and its half angle reaches the furthest normal from it.
+			std::vector<std::array<float, 3>> normals{};
+			normals.reserve(m.triangleCount);
+			std::array<float, 3> axis{};
+			for (std::uint32_t t = 0; t < m.triangleCount; ++t)
+			{
+				const auto packedTriangle = outMeshletData.triangles[m.triangleOffset + t];
+				const auto p0 = get_meshlet_position(packedTriangle & 0xFF);
+				const auto p1 = get_meshlet_position((packedTriangle >> 8) & 0xFF);
+				const auto p2 = get_meshlet_position((packedTriangle >> 16) & 0xFF);
+				const std::array<float, 3> e0{ p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+				const std::array<float, 3> e1{ p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+				const std::array<float, 3> normal{ e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+				const auto length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+				if (length > 0.0f)
+				{
+					normals.push_back({ normal[0] / length, normal[1] / length, normal[2] / length });
+					for (auto a = 0; a < 3; ++a)
+					{
+						axis[a] += normals.back()[a];
+					}
+				}
+			}
+			const auto axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+			float minDot{ 1.0f };
+			for (const auto& normal : normals)
+			{
+				minDot = std::min(minDot, (normal[0] * axis[0] + normal[1] * axis[1] + normal[2] * axis[2]) / axisLength);
+			}
+			if (axisLength > 0.0f && minDot > 0.0f)
+			{
+				bounds.coneAxis = { axis[0] / axisLength, axis[1] / axisLength, axis[2] / axisLength };
+				bounds.coneCutoff = std::sqrt(1.0f - minDot * minDot); // sin of the half angle, the cos of the view angle that sees none of them.
+			}
+			else
+			{
+				bounds.coneCutoff = 1.0f;
+			}
+			outMeshletData.bounds.push_back(bounds);
+		}
+	}
+
+	auto quantize_vertices(std::vector<std::byte>& outVertexData, const float* vertexData, std::uint32_t vertexCount, std::span<const QuantizedAttribute> attributes) -> std::uint32_t
+	{
+		std::uint32_t srcStride{ 0 };
+		std::uint32_t dstStride{ 0 };
+		for (const auto& attribute : attributes)
+		{
+			GFX_ASSERT(attribute.floatCount <= 4, "Quantized attributes can have at most 4 floats!");
+			GFX_ASSERT(!attribute.octahedral || attribute.floatCount == 3, "Octahedral attributes must be 3 float vectors!");
+			srcStride += attribute.floatCount;
+			dstStride += get_vertex_format_size(attribute.format);
+		}
+
+		outVertexData.assign(std::uint64_t(dstStride) * vertexCount, std::byte{ 0 });
+		for (std::uint32_t v = 0; v < vertexCount; ++v)
+		{
+			const auto* src = vertexData + std::uint64_t(v) * srcStride;
+			auto* dst = outVertexData.data() + std::uint64_t(v) * dstStride;
+			for (const auto& attribute : attributes)
+			{
+				std::array<float, 4> values{};
+				std::copy_n(src, attribute.floatCount, values.begin());
+				write_attribute(dst, attribute.format, attribute.octahedral ? encode_octahedral(values) : values);
+				src += attribute.floatCount;
+				dst += get_vertex_format_size(attribute.format);
+			}
+		}
+		return dstStride;
+	}
+
+	bool write_mesh_file(const char* filename, const void* vertexData, std::uint32_t vertexStride, std::uint32_t vertexCount, std::span<const std::uint32_t> indices,
+						 const MeshletData* meshletData, Format positionFormat)
+	{
+		GFX_ASSERT(vertexStride >= get_vertex_format_size(positionFormat), "Mesh vertices must start with their position!");
+
+		const auto vertexOffset = align_up(sizeof(MeshFileHeader), MESH_FILE_ALIGNMENT);
+		MeshFileHeader header{
+			.magic = MESH_FILE_MAGIC,
+			.version = MESH_FILE_VERSION,
+			.vertexStride = vertexStride,
+			.vertexCount = vertexCount,
+			.indexCount = std::uint32_t(indices.size()),
+			.indexType = vertexCount <= std::numeric_limits<std::uint16_t>::max() + 1u ? IndexType::eUInt16 : IndexType::eUInt32,
+			.vertexOffset = vertexOffset,
+			.indexOffset = align_up(vertexOffset + std::uint64_t(vertexStride) * vertexCount, MESH_FILE_ALIGNMENT),
+			.boundsMin = {},
+			.boundsMax = {},
+		};
+		if (meshletData != nullptr)
+		{
+			header.meshletCount = std::uint32_t(meshletData->meshlets.size());
+			header.meshletVertexCount = std::uint32_t(meshletData->vertices.size());
+			header.meshletTriangleCount = std::uint32_t(meshletData->triangles.size());
+			header.meshletOffset = align_up(header.indexOffset + get_index_size(header.indexType) * header.indexCount, MESH_FILE_ALIGNMENT);
+			header.meshletBoundsOffset = align_up(header.meshletOffset + sizeof(Meshlet) * header.meshletCount, MESH_FILE_ALIGNMENT);
+			header.meshletVertexOffset = align_up(header.meshletBoundsOffset + sizeof(MeshletBounds) * header.meshletCount, MESH_FILE_ALIGNMENT);
+			header.meshletTriangleOffset = align_up(header.meshletVertexOffset + sizeof(std::uint32_t) * header.meshletVertexCount, MESH_FILE_ALIGNMENT);
+		}
+
+		const auto* vertexBytes = static_cast<const std::byte*>(vertexData);
+		for (std::uint32_t i = 0; i < vertexCount; ++i)
+		{
+			const auto position = read_position(vertexBytes + std::uint64_t(i) * vertexStride, positionFormat);
+			for (auto axis = 0; axis < 3; ++axis)
+			{
+				header.boundsMin[axis] = i == 0 ? position[axis] : std::min(header.boundsMin[axis], position[axis]);
+				header.boundsMax[axis] = i == 0 ? position[axis] : std::max(header.boundsMax[axis], position[axis]);
+			}
+		}
+
+		std::ofstream file{ filename, std::ios::binary | std::ios::trunc };
+		if (!file)
+		{
+			GFX_LOG_ERR("GFX - Failed to create mesh file!");
+			return false;
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		write_padding(file, header.vertexOffset);
+		file.write(static_cast<const char*>(vertexData), std::streamsize(std::uint64_t(vertexStride) * vertexCount));
+		write_padding(file, header.indexOffset);
+		if (header.indexType == IndexType::eUInt16)
+		{
+			const std::vector<std::uint16_t> shortIndices(indices.begin(), indices.end());
+			file.write(reinterpret_cast<const char*>(shortIndices.data()), std::streamsize(shortIndices.size() * sizeof(std::uint16_t)));
+		}
+		else
+		{
+			file.write(reinterpret_cast<const char*>(indices.data()), std::streamsize(indices.size_bytes()));
+		}
+		if (meshletData != nullptr)
+		{
+			write_padding(file, header.meshletOffset);
+			file.write(reinterpret_cast<const char*>(meshletData->meshlets.data()), std::streamsize(sizeof(Meshlet) * header.meshletCount));
+			write_padding(file, header.meshletBoundsOffset);
+			file.write(reinterpret_cast<const char*>(meshletData->bounds.data()), std::streamsize(sizeof(MeshletBounds) * header.meshletCount));
+			write_padding(file, header.meshletVertexOffset);
+			file.write(reinterpret_cast<const char*>(meshletData->vertices.data()), std::streamsize(sizeof(std::uint32_t) * header.meshletVertexCount));
+			write_padding(file, header.meshletTriangleOffset);
+			file.write(reinterpret_cast<const char*>(meshletData->triangles.data()), std::streamsize(sizeof(std::uint32_t) * header.meshletTriangleCount));
+		}
+
+		if (!file)
+		{
+			GFX_LOG_ERR("GFX - Failed to write mesh file!");
+			return false;
+		}
+		return true;
+	}
+
+	MeshFile::~MeshFile()
+	{
+		close();
+	}
+
+	bool MeshFile::open(const char* filename)
+	{
+		close();
+
+#if _WIN32
+		const auto file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			GFX_LOG_ERR("GFX - Failed to open mesh file!");
+			return false;
+		}
+		LARGE_INTEGER fileSize{};
+		const auto mapping = GetFileSizeEx(file, &fileSize) ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+		// The view keeps the file mapped once the handles are closed.
+		m_data = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		m_size = std::uint64_t(fileSize.QuadPart);
+		if (mapping != nullptr)
+		{
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+#else
+		const auto file = ::open(filename, O_RDONLY);
+		if (file < 0)
+		{
+			GFX_LOG_ERR("GFX - Failed to open mesh file!");
+			return false;
+		}
+		struct stat fileStat{};
+		if (fstat(file, &fileStat) == 0 && fileStat.st_size > 0)
+		{
+			m_size = std::uint64_t(fileStat.st_size);
+			m_data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (m_data == MAP_FAILED)
+			{
+				m_data = nullptr;
+			}
+			else
+			{
+				madvise(m_data, m_size, MADV_SEQUENTIAL);
+			}
+		}
+		::close(file);
+#endif
+		if (m_data == nullptr)
+		{
+			GFX_LOG_ERR("GFX - Failed to map mesh file!");
+			return false;
+		}
+
+		const auto& header = get_header();
+		if (m_size < sizeof(MeshFileHeader) || header.magic != MESH_FILE_MAGIC || header.version != MESH_FILE_VERSION)
+		{
+			GFX_LOG_ERR("GFX - Not a mesh file of this version!");
+			close();
+			return false;
+		}
+		if (header.vertexOffset + std::uint64_t(header.vertexStride) * header.vertexCount > m_size ||
+			header.indexOffset + get_index_size(header.indexType) * header.indexCount > m_size ||
+			(header.meshletCount > 0 && header.meshletTriangleOffset + sizeof(std::uint32_t) * header.meshletTriangleCount > m_size))
+		{
+			GFX_LOG_ERR("GFX - Mesh file is truncated!");
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	void MeshFile::close()
+	{
+		if (m_data == nullptr)
+		{
+			return;
+		}
+#if _WIN32
+		UnmapViewOfFile(m_data);
+#else
+		munmap(m_data, m_size);
+#endif
+		m_data = nullptr;
+		m_size = 0;
+	}
+
+	auto MeshFile::get_vertex_data() const -> std::span<const std::byte>
+	{
+		GFX_ASSERT(is_open(), "MeshFile is not open!");
+		const auto& header = get_header();
+		return { static_cast<const std::byte*>(m_data) + header.vertexOffset, std::uint64_t(header.vertexStride) * header.vertexCount };
+	}
+
+	auto MeshFile::get_index_data() const -> std::span<const std::byte>
+	{
+		GFX_ASSERT(is_open(), "MeshFile is not open!");
+		const auto& header = get_header();
+		return { static_cast<const std::byte*>(m_data) + header.indexOffset, get_index_size(header.indexType) * header.indexCount };
+	}
+
+	auto MeshFile::get_meshlets() const -> std::span<const Meshlet>
+	{
+		GFX_ASSERT(is_open(), "MeshFile is not open!");
+		const auto& header = get_header();
+		return { reinterpret_cast<const Meshlet*>(static_cast<const std::byte*>(m_data) + header.meshletOffset), header.meshletCount };
+	}
+
+	auto MeshFile::get_meshlet_bounds() const -> std::span<const MeshletBounds>
+	{
+		GFX_ASSERT(is_open(), "MeshFile is not open!");
+		const auto& header = get_header();
+		return { reinterpret_cast<const MeshletBounds*>(static_cast<const std::byte*>(m_data) + header.meshletBoundsOffset), header.meshletCount };
+	}
+
+	auto MeshFile::get_meshlet_vertices() const -> std::span<const std::uint32_t>
+	{
+		GFX_ASSERT(is_open(), "MeshFile is not open!");
+		const auto& header = get_header();
+		return { reinterpret_cast<const std::uint32_t*>(static_cast<const std::byte*>(m_data) + header.meshletVertexOffset), header.meshletVertexCount };
+	}
+
+	auto MeshFile::get_meshlet_triangles() const -> std::span<const std::uint32_t>
+	{
+		GFX_ASSERT(is_open(), "MeshFile is not open!");
+		const auto& header = get_header();
+		return { reinterpret_cast<const std::uint32_t*>(static_cast<const std::byte*>(m_data) + header.meshletTriangleOffset), header.meshletTriangleCount };
+	}
+
+	bool MeshFile::upload(BufferHandle& outVertexBufferHandle, BufferHandle& outIndexBufferHandle, SyncPoint& outSyncPoint, DeviceHandle deviceHandle, std::uint32_t queueIndex) const
+	{
+		GFX_ASSERT(is_open(), "MeshFile is not open!");
+		const auto vertexData = get_vertex_data();
+		const auto indexData = get_index_data();
+
+		BufferHandle vertexBufferHandle{};
+		BufferHandle indexBufferHandle{};
+		if (!create_buffer(vertexBufferHandle, deviceHandle, { .type = BufferType::eVertex, .size = vertexData.size() }))
+		{
+			return false;
+		}
+		if (!create_buffer(indexBufferHandle, deviceHandle, { .type = BufferType::eIndex, .size = indexData.size() }))
+		{
+			destroy_buffer(vertexBufferHandle);
+			return false;
+		}
+
+		// Both on one queue, so the second sync point covers the first copy too.
+		upload_buffer(vertexBufferHandle, vertexData.data(), vertexData.size(), 0, queueIndex);
+		outSyncPoint = upload_buffer(indexBufferHandle, indexData.data(), indexData.size(), 0, queueIndex);
+		outVertexBufferHandle = vertexBufferHandle;
+		outIndexBufferHandle = indexBufferHandle;
+		return true;
+	}
+
+	bool MeshFile::upload_meshlets(MeshletBuffers& outMeshletBuffers, SyncPoint& outSyncPoint, DeviceHandle deviceHandle, std::uint32_t queueIndex) const
+	{
+		GFX_ASSERT(is_open(), "MeshFile is not open!");
+		if (get_header().meshletCount == 0)
+		{
+			GFX_LOG_ERR("GFX - Mesh file has no meshlets!");
+			return false;
+		}
+
+		const std::array<std::span<const std::byte>, 4> arrays{
+			std::as_bytes(get_meshlets()),
+			std::as_bytes(get_meshlet_bounds()),
+			std::as_bytes(get_meshlet_vertices()),
+			std::as_bytes(get_meshlet_triangles()),
+		};
+		std::array<BufferHandle, 4> bufferHandles{};
+		for (std::size_t i = 0; i < arrays.size(); ++i)
+		{
+			if (!create_buffer(bufferHandles[i], deviceHandle, { .type = BufferType::eStorage, .size = arrays[i].size() }))
+			{
+				for (std::size_t j = 0; j < i; ++j)
+				{
+					destroy_buffer(bufferHandles[j]);
+				}
+				return false;
+			}
+		}
+		for (std::size_t i = 0; i < arrays.size(); ++i)
+		{
+			outSyncPoint = upload_buffer(bufferHandles[i], arrays[i].data(), arrays[i].size(), 0, queueIndex);
+		}
+		outMeshletBuffers = { bufferHandles[0], bufferHandles[1], bufferHandles[2], bufferHandles[3] };
+		return true;
+	}
+
+} // namespace sm::gfx
@@ -22,8 +22,54 @@
 #define VMA_IMPLEMENTATION
 #include <vk_mem_alloc.hpp>
 
+#if GFX_TRACY_ENABLED
+	#include <tracy/TracyC.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <latch>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+// Counting into FrameStats, compiled out without GFX_FRAME_STATS_ENABLED. The shared form is for the Device's counters, which any thread may add to.
+#if GFX_FRAME_STATS_ENABLED
+	#define GFX_COUNT_STAT(_counter, _amount) ((_counter) += (_amount))
+	#define GFX_COUNT_SHARED_STAT(_counter, _amount) std::atomic_ref<std::uint64_t>(_counter).fetch_add((_amount), std::memory_order_relaxed)
+#else
+	#define GFX_COUNT_STAT(_counter, _amount) ((void)0)
+	#define GFX_COUNT_SHARED_STAT(_counter, _amount) ((void)0)
+#endif
+
+// Recording a call into the device's capture, see begin_capture(). Compiled out, arguments included, without GFX_CAPTURE_ENABLED.
+#if GFX_CAPTURE_ENABLED
+	#define GFX_CAPTURE(_device, _op, ...)                                            \
+		do                                                                            \
+		{                                                                             \
+			if (auto* captureWriter_ = (_device)->get_capture_writer())               \
+			{                                                                         \
+				captureWriter_->record(CaptureOp::_op __VA_OPT__(, ) __VA_ARGS__);    \
+			}                                                                         \
+		}                                                                             \
+		while (false)
+#else
+	#define GFX_CAPTURE(_device, _op, ...) ((void)0)
+#endif
 
 namespace sm::gfx
 {
@@ -33,8 +79,438 @@ namespace sm::gfx
 		const VkDebugUtilsMessengerCallbackDataEXT* callback_data,
 		void* user_data);
 
+	/**
+	 * @brief Whether the context enabled VK_EXT_debug_utils, which AppInfo::debugLevel eOff leaves out.
+	 */
+	bool is_debug_utils_enabled();
+
+	/**
+	 * @brief Name a Vulkan object for debuggers and GPU profilers through VK_EXT_debug_utils. Empty names are skipped.
+	 */
+	template <typename T>
+	void set_debug_name(vk::Device device, T object, std::string_view name)
+	{
+		if (name.empty() || !object || !is_debug_utils_enabled())
+		{
+			return;
+		}
+
+		const std::string nameString(name);
+		vk::DebugUtilsObjectNameInfoEXT name_info{};
+		name_info.setObjectType(T::objectType);
+		name_info.setObjectHandle(std::uint64_t(static_cast<typename T::CType>(object)));
+		name_info.setPObjectName(nameString.c_str());
+		auto result = device.setDebugUtilsObjectNameEXT(name_info);
+		GFX_UNUSED(result);
+	}
+
+	/**
+	 * @brief Fixed-capacity vector with inline storage, used for per-command scratch arrays so recording never heap allocates.
+	 */
+	template <typename T, std::size_t Capacity>
+	class InlineVector
+	{
+	public:
+		void push_back(const T& value)
+		{
+			GFX_ASSERT(m_size < Capacity, "InlineVector capacity exceeded!");
+			m_data[m_size++] = value;
+		}
+
+		void resize(std::size_t size)
+		{
+			GFX_ASSERT(size <= Capacity, "InlineVector capacity exceeded!");
+			m_size = size;
+		}
+
+		void clear() { m_size = 0; }
+
+		auto size() const -> std::size_t { return m_size; }
+		bool empty() const { return m_size == 0; }
+		static constexpr auto capacity() -> std::size_t { return Capacity; }
+
+		auto data() -> T* { return m_data.data(); }
+		auto data() const -> const T* { return m_data.data(); }
+
+		auto begin() -> T* { return data(); }
+		auto end() -> T* { return data() + m_size; }
+		auto begin() const -> const T* { return data(); }
+		auto end() const -> const T* { return data() + m_size; }
+
+		auto operator[](std::size_t index) -> T& { return m_data[index]; }
+		auto operator[](std::size_t index) const -> const T& { return m_data[index]; }
+
+		operator std::span<const T>() const { return { data(), m_size }; }
+
+	private:
+		std::array<T, Capacity> m_data{};
+		std::size_t m_size{ 0 };
+	};
+
+	/**
+	 * @brief Per-thread linear allocator for the transient arrays of calls too variable for an InlineVector, eg. pipeline and
+	 * descriptor set layout creation. Allocating bumps an offset into blocks that are kept for the thread's next call, and
+	 * nothing is freed on its own: a ScratchScope gives back everything allocated since it was opened.
+	 */
+	class ScratchArena
+	{
+	public:
+		struct Marker
+		{
+			std::size_t blockIndex;
+			std::size_t offset;
+		};
+
+		// The calling thread's arena.
+		static auto get() -> ScratchArena&;
+
+		auto allocate(std::size_t size, std::size_t alignment) -> void*;
+
+		auto get_marker() const -> Marker { return { m_blockIndex, m_offset }; }
+		void rewind(Marker marker);
+
+	private:
+		static constexpr std::size_t BLOCK_BYTES = 64 * 1024;
+
+		struct Block
+		{
+			std::unique_ptr<std::byte[]> data;
+			std::size_t size;
+		};
+
+		std::vector<Block> m_blocks{};
+		std::size_t m_blockIndex{ 0 };
+		std::size_t m_offset{ 0 };
+	};
+
+	/**
+	 * @brief Rewinds the calling thread's ScratchArena when it goes out of scope. Open it before the ScratchVectors it frees,
+	 * and do not grow those while a nested scope is open, as that scope would give their new storage back.
+	 */
+	class ScratchScope
+	{
+	public:
+		ScratchScope() : m_arena(ScratchArena::get()), m_marker(m_arena.get_marker()) {}
+		~ScratchScope() { m_arena.rewind(m_marker); }
+
+		GFX_DISABLE_COPY(ScratchScope);
+
+	private:
+		ScratchArena& m_arena;
+		ScratchArena::Marker m_marker;
+	};
+
+	template <typename T>
+	class ScratchAllocator
+	{
+	public:
+		using value_type = T;
+
+		ScratchAllocator() = default;
+		template <typename U>
+		ScratchAllocator(const ScratchAllocator<U>&)
+		{
+		}
+
+		auto allocate(std::size_t count) -> T* { return static_cast<T*>(ScratchArena::get().allocate(count * sizeof(T), alignof(T))); }
+		void deallocate(T*, std::size_t) {}
+
+		template <typename U>
+		bool operator==(const ScratchAllocator<U>&) const
+		{
+			return true;
+		}
+	};
+
+	// A std::vector in the calling thread's ScratchArena. Must not outlive the enclosing ScratchScope, or leave the thread.
+	template <typename T>
+	using ScratchVector = std::vector<T, ScratchAllocator<T>>;
+
+	/**
+	 * @brief Run fn(0..count - 1), spreading all but the first over the executor, and wait for them.
+	 */
+	template <typename Fn>
+	void run_parallel(TaskScheduler* executor, std::uint32_t count, const Fn& fn)
+	{
+		std::latch done(count - 1);
+		for (std::uint32_t i = 1; i < count; ++i)
+		{
+			executor->enqueue([&, i] {
+				fn(i);
+				done.count_down();
+			});
+		}
+		fn(0);
+		done.wait();
+	}
+
+	/**
+	 * @brief Generational slot-map used for the per-device resource tables.
+	 *
+	 * A ResourceHandle packs a slot index (low bits) and the generation of that slot (high bits). Slots are stored by value
+	 * in fixed-size pages which are never reallocated, so pointers returned by get() stay valid until the resource is erased.
+	 * Generations start at 1, so a valid handle is never 0.
+	 *
+	 * Thread-safe: only slot allocation and release take the pool lock, resources are constructed and destroyed outside it,
+	 * and get() is lock-free. Looking up a handle while another thread erases that same handle is still a usage error.
+	 */
+	template <typename T>
+	class ResourcePool
+	{
+	public:
+		static constexpr std::uint32_t INDEX_BITS = 20u;
+		static constexpr std::uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1u;
+		static constexpr std::uint32_t GENERATION_MASK = (1u << (32u - INDEX_BITS)) - 1u;
+		static constexpr std::uint32_t PAGE_SIZE = 1024u;
+		static constexpr std::uint32_t MAX_PAGES = (INDEX_MASK + 1u) / PAGE_SIZE;
+
+		ResourcePool() = default;
+		~ResourcePool() = default;
+		DISABLE_COPY_AND_MOVE(ResourcePool);
+
+		/**
+		 * @brief Construct a resource in a free slot. Returns a null handle, leaving `args` untouched, once all slots are in use.
+		 */
+		template <typename... Args>
+		auto emplace(Args&&... args) -> ResourceHandle
+		{
+			const auto index = acquire_slot();
+			if (index > INDEX_MASK)
+			{
+				s_errorCallback("GFX - ResourcePool has run out of slots!");
+				return {};
+			}
+
+			// The slot is exclusively ours until the handle is returned, so construct without holding the lock.
+			auto& slot = get_slot(index);
+			slot.value.emplace(std::forward<Args>(args)...);
+			m_count.fetch_add(1, std::memory_order_relaxed);
+			return make_handle(index, slot.generation.load(std::memory_order_relaxed));
+		}
+
+		/**
+		 * @brief Resolve a handle to its resource, or nullptr if the handle is stale or invalid.
+		 * When validation is compiled out the handle is trusted, and only null handles resolve to nullptr, so handles that
+		 * arrive through the public API go through get_checked() instead.
+		 */
+		auto get(ResourceHandle handle) -> T*
+		{
+#if GFX_VALIDATION_ENABLED
+			return get_checked(handle);
+#else
+			if (CAST_HANDLE_TO_INT(handle) == 0)
+			{
+				return nullptr;
+			}
+			return &*get_slot(get_index(handle)).value;
+#endif
+		}
+
+		// Always validates the handle, regardless of the build configuration.
+		auto get_checked(ResourceHandle handle) -> T*
+		{
+			const auto index = get_index(handle);
+			if (index >= m_nextIndex.load(std::memory_order_acquire))
+			{
+				return nullptr;
+			}
+
+			auto& slot = get_slot(index);
+			if (slot.generation.load(std::memory_order_acquire) != get_generation(handle) || !slot.value.has_value())
+			{
+				return nullptr;
+			}
+			return &slot.value.value();
+		}
+
+		// Stale handles must never release a slot twice, so contains() and erase() always validate.
+		bool contains(ResourceHandle handle) { return get_checked(handle) != nullptr; }
+
+		/**
+		 * @brief Make sure the next `count` emplaces will not need to allocate pages.
+		 */
+		void reserve(std::uint32_t count)
+		{
+			std::lock_guard lock(m_mutex);
+			if (count <= m_freeList.size())
+			{
+				return;
+			}
+
+			const auto nextIndex = m_nextIndex.load(std::memory_order_relaxed);
+			const auto lastIndex = std::min(nextIndex + count - std::uint32_t(m_freeList.size()), INDEX_MASK + 1u) - 1u;
+			for (auto page = nextIndex / PAGE_SIZE; page <= lastIndex / PAGE_SIZE; ++page)
+			{
+				if (m_pages[page] == nullptr)
+				{
+					m_pages[page] = std::make_unique<Page>();
+				}
+			}
+		}
+
+		/**
+		 * @brief Destroy the resource and release its slot. The slot's generation is bumped so stale handles no longer resolve.
+		 */
+		bool erase(ResourceHandle handle)
+		{
+			if (!contains(handle))
+			{
+				return false;
+			}
+
+			const auto index = get_index(handle);
+			auto& slot = get_slot(index);
+
+			auto generation = (slot.generation.load(std::memory_order_relaxed) + 1u) & GENERATION_MASK;
+			if (generation == 0)
+			{
+				generation = 1;
+			}
+			slot.generation.store(generation, std::memory_order_release);
+			slot.value.reset();
+			m_count.fetch_sub(1, std::memory_order_relaxed);
+
+			std::lock_guard lock(m_mutex);
+			m_freeList.push_back(index);
+			return true;
+		}
+
+		/**
+		 * @brief Destroy every resource and release all slots, eg. to control the order of teardown. No handle resolves afterwards.
+		 */
+		void clear()
+		{
+			std::lock_guard lock(m_mutex);
+			const auto nextIndex = m_nextIndex.load(std::memory_order_relaxed);
+			for (std::uint32_t index = 0; index < nextIndex; ++index)
+			{
+				auto& slot = get_slot(index);
+				if (!slot.value.has_value())
+				{
+					continue;
+				}
+
+				auto generation = (slot.generation.load(std::memory_order_relaxed) + 1u) & GENERATION_MASK;
+				slot.generation.store(generation == 0 ? 1 : generation, std::memory_order_release);
+				slot.value.reset();
+				m_freeList.push_back(index);
+			}
+			m_count.store(0, std::memory_order_relaxed);
+		}
+
+		auto size() const -> std::uint32_t { return m_count.load(std::memory_order_relaxed); }
+
+		static auto get_index(ResourceHandle handle) -> std::uint32_t { return CAST_HANDLE_TO_INT(handle) & INDEX_MASK; }
+		static auto get_generation(ResourceHandle handle) -> std::uint32_t { return CAST_HANDLE_TO_INT(handle) >> INDEX_BITS; }
+		static auto make_handle(std::uint32_t index, std::uint32_t generation) -> ResourceHandle { return ResourceHandle((generation << INDEX_BITS) | (index & INDEX_MASK)); }
+
+	private:
+		struct Slot
+		{
+			std::atomic<std::uint32_t> generation{ 1 };
+			std::optional<T> value{};
+		};
+		using Page = std::array<Slot, PAGE_SIZE>;
+
+		// Returns an index past INDEX_MASK once every slot is in use.
+		auto acquire_slot() -> std::uint32_t
+		{
+			std::lock_guard lock(m_mutex);
+			if (!m_freeList.empty())
+			{
+				const auto index = m_freeList.back();
+				m_freeList.pop_back();
+				return index;
+			}
+
+			const auto index = m_nextIndex.load(std::memory_order_relaxed);
+			if (index > INDEX_MASK)
+			{
+				return index;
+			}
+			if (m_pages[index / PAGE_SIZE] == nullptr)
+			{
+				m_pages[index / PAGE_SIZE] = std::make_unique<Page>();
+			}
+			// Publishes the page to lock-free readers in get().
+			m_nextIndex.store(index + 1, std::memory_order_release);
+			return index;
+		}
+
+		auto get_slot(std::uint32_t index) -> Slot& { return (*m_pages[index / PAGE_SIZE])[index % PAGE_SIZE]; }
+
+	private:
+		std::mutex m_mutex;
+		std::array<std::unique_ptr<Page>, MAX_PAGES> m_pages{};
+		std::vector<std::uint32_t> m_freeList{};
+		std::atomic<std::uint32_t> m_nextIndex{ 0 };
+		std::atomic<std::uint32_t> m_count{ 0 };
+	};
+
+	/**
+	 * @brief Command pool owned by a single recording thread for a single frame in flight.
+	 *
+	 * Only the owning thread allocates from the pool or records into its command buffers, so neither needs a lock.
+	 * Command buffers released from other threads (eg. by deferred destruction) are queued and freed by the owner on its
+	 * next allocation.
+	 *
+	 * Transient pools never free individual command buffers. They are reset as a whole with vkResetCommandPool once their
+	 * frame has retired, and the command buffers are handed out again in the next use of that frame.
+	 */
+	class CommandPool
+	{
+	public:
+		CommandPool() = default;
+		explicit CommandPool(vk::Device device, std::uint32_t queueFamily, vk::QueueFlags queueFlags, bool transient);
+		~CommandPool() = default;
+		DISABLE_COPY_AND_MOVE(CommandPool);
+
+		auto allocate(vk::CommandBufferLevel level) -> vk::UniqueCommandBuffer;
+		void release(vk::CommandBuffer commandBuffer);
+
+		auto acquire_transient(vk::CommandBufferLevel level) -> vk::CommandBuffer;
+		void reset();
+
+		/* Getters */
+
+		auto get_device() const -> vk::Device { return m_device; }
+		auto get_pool() const -> vk::CommandPool { return m_pool.get(); }
+		auto get_queue_family() const -> std::uint32_t { return m_queueFamily; }
+		// The pipeline stages barriers recorded on the family's queues may name.
+		auto get_supported_stages() const -> vk::PipelineStageFlags2 { return m_supportedStages; }
+		bool is_transient() const { return m_transient; }
+
+	private:
+		void free_released();
+
+	private:
+		vk::Device m_device;
+		vk::UniqueCommandPool m_pool;
+		std::uint32_t m_queueFamily{ 0 };
+		vk::PipelineStageFlags2 m_supportedStages{};
+		bool m_transient{ false };
+
+		std::mutex m_releasedMutex;
+		std::vector<vk::CommandBuffer> m_released;
+
+		// Indexed by vk::CommandBufferLevel.
+		std::array<std::vector<vk::CommandBuffer>, 2> m_transientCommandBuffers;
+		std::array<std::uint32_t, 2> m_transientUsedCounts{};
+	};
+
 	class Device;
 
+	struct PhysicalDeviceInfo
+	{
+		vk::PhysicalDevice physicalDevice;
+		vk::PhysicalDeviceProperties properties;
+		std::vector<vk::ExtensionProperties> extensions;
+	};
+
+	/**
+	 * @brief Owns the instance and the devices. Device lookups are lock free, so threads using different devices, or the same
+	 * one, never contend on the context. A device must not be used while another thread destroys it.
+	 */
 	class Context
 	{
 	public:
@@ -47,33 +523,1220 @@ namespace sm::gfx
 
 		auto create_device(DeviceHandle& outDeviceHandle, const DeviceInfo& deviceInfo) -> bool;
 		void destroy_device(DeviceHandle deviceHandle);
-		bool get_device(Device*& outDevice, DeviceHandle deviceHandle);
+		bool get_device(Device*& outDevice, DeviceHandle deviceHandle) const;
 
 		/* Getters */
 
 		auto get_instance() const -> vk::Instance { return m_instance.get(); }
+		bool is_headless() const { return m_headless; }
+		/**
+		 * @brief The level in effect, lower than requested if the validation layer is not installed.
+		 */
+		auto get_debug_level() const -> DebugLevel { return m_debugLevel; }
+		/**
+		 * @brief The GPUs with their properties and extensions, queried from the driver by the first call only, so devices
+		 * created one after another skip the enumeration.
+		 */
+		auto get_physical_devices() -> const std::vector<PhysicalDeviceInfo>&;
 
 	private:
 		vk::DynamicLoader m_loader;
 		vk::UniqueInstance m_instance;
 		vk::UniqueDebugUtilsMessengerEXT m_debugMessenger;
+		bool m_headless{ false };
+		DebugLevel m_debugLevel{ DebugLevel::eOff };
+
+		std::once_flag m_physicalDevicesOnce;
+		std::vector<PhysicalDeviceInfo> m_physicalDevices;
+
+		// A DeviceHandle is its slot in the low bits and the slot's generation above, so stale handles are not mistaken for
+		// the slot's next device.
+		static constexpr std::uint32_t DEVICE_SLOT_BITS = 4;
+		static constexpr std::uint32_t MAX_DEVICES = 1u << DEVICE_SLOT_BITS;
 
-		std::unordered_map<DeviceHandle, std::unique_ptr<Device>> m_deviceMap;
-		std::uint32_t m_nextDeviceId{ 1 };
+		std::mutex m_deviceMutex; // Serialises creating and destroying devices, not lookups.
+		std::array<std::unique_ptr<Device>, MAX_DEVICES> m_ownedDevices{};
+		std::array<std::uint32_t, MAX_DEVICES> m_deviceGenerations{};
+		std::array<std::atomic<Device*>, MAX_DEVICES> m_devices{}; // Published once constructed, read by get_device().
 	};
 
 	class CommandList;
 	class Pipeline;
+	class GraphicsPipeline;
+	class ShaderObjectPipeline;
 	class Buffer;
 	class Texture;
 	class SwapChain;
 
+	// Internal CommandListFlags_*.
+	constexpr std::uint32_t CommandListFlags_TrackResources = 1u << 31u; // Remember referenced resources, so bundles can be invalidated.
+
+	constexpr std::uint32_t CACHED_DESCRIPTOR_SET_LIFETIME = 8; // Frames a cached descriptor set may go unused before it is evicted.
+	constexpr std::uint64_t DEDICATED_BUFFER_THRESHOLD = 32ull * 1024 * 1024; // Bytes from which DedicatedAllocation::eAuto buffers get their own allocation.
+	constexpr std::uint64_t DEDICATED_ATTACHMENT_TEXELS = 1024ull * 1024;	 // Texels from which eAuto attachments get theirs, covering swap chain sized targets.
+
+	// Handle types of external memory and semaphores, see gfx::ExternalHandle. Imported semaphores are sync files on Linux.
+#if _WIN32
+	constexpr auto EXTERNAL_MEMORY_HANDLE_TYPE = vk::ExternalMemoryHandleTypeFlagBits::eOpaqueWin32;
+	constexpr auto EXTERNAL_TIMELINE_HANDLE_TYPE = vk::ExternalSemaphoreHandleTypeFlagBits::eOpaqueWin32;
+	constexpr auto IMPORTED_SEMAPHORE_HANDLE_TYPE = vk::ExternalSemaphoreHandleTypeFlagBits::eOpaqueWin32;
+#else
+	constexpr auto EXTERNAL_MEMORY_HANDLE_TYPE = vk::ExternalMemoryHandleTypeFlagBits::eOpaqueFd;
+	constexpr auto EXTERNAL_TIMELINE_HANDLE_TYPE = vk::ExternalSemaphoreHandleTypeFlagBits::eOpaqueFd;
+	constexpr auto IMPORTED_SEMAPHORE_HANDLE_TYPE = vk::ExternalSemaphoreHandleTypeFlagBits::eSyncFd;
+#endif
+
+	/**
+	 * @brief The load and store ops of a render pass's attachments, see RenderPassInfo.
+	 */
+	struct AttachmentOps
+	{
+		std::array<LoadOp, MAX_COLOR_ATTACHMENTS> colorLoadOps{};
+		std::array<StoreOp, MAX_COLOR_ATTACHMENTS> colorStoreOps{};
+		LoadOp depthLoadOp{ LoadOp::eClear };
+		StoreOp depthStoreOp{ StoreOp::eDontCare };
+		bool localRead{ false }; // Color attachments in vk::ImageLayout::eRenderingLocalReadKHR, see RenderPassInfo::localRead.
+	};
+
+	/**
+	 * @brief A render pass's shading rate attachment, see RenderPassInfo::shadingRateAttachment.
+	 */
+	struct ShadingRateAttachment
+	{
+		Texture* texture{ nullptr }; // Null for none.
+		vk::Extent2D texelSize{};
+	};
+
+	/**
+	 * @brief The buffer an acceleration structure lives in, and the structure itself, destroyed first.
+	 */
+	struct AccelerationStructureStorage
+	{
+		vma::UniqueBuffer buffer;
+		vma::UniqueAllocation allocation;
+		vk::UniqueAccelerationStructureKHR accelerationStructure;
+		std::uint64_t size{ 0 };
+		std::uint64_t deviceAddress{ 0 };
+	};
+
+	/**
+	 * @brief One half of a queue family ownership transfer, as recorded by a particular command list.
+	 */
+	struct QueueOwnershipTransfer
+	{
+		std::uint32_t srcQueueFamily;
+		std::uint32_t dstQueueFamily;
+		bool release; // Recorded on the source queue, otherwise the acquire on the destination queue.
+	};
+
+	/**
+	 * @brief A DescriptorWrite resolved to Vulkan objects, self-contained so deferred command lists can copy it. Also the record
+	 * type of descriptor update templates, which read bufferInfo or imageInfo of one record per binding.
+	 */
+	struct ResolvedDescriptor
+	{
+		std::uint32_t binding{ 0 };
+		std::uint32_t arrayElement{ 0 };
+		vk::DescriptorType type{};
+		vk::DescriptorBufferInfo bufferInfo{}; // Buffer descriptor types.
+		vk::DescriptorImageInfo imageInfo{};   // eCombinedImageSampler.
+		vk::DeviceAddress address{ 0 };		   // Of bufferInfo's offset, for descriptor buffers.
+	};
+
+	/**
+	 * @brief Identify a Vulkan object by its handle value, e.g. to match the resources referenced by a bundle.
+	 */
+	template <typename VkHandle>
+	auto get_resource_key(VkHandle handle) -> std::uint64_t
+	{
+		return std::bit_cast<std::uint64_t>(static_cast<typename VkHandle::CType>(handle));
+	}
+
+	/**
+	 * @brief A pre-recorded secondary command list which is replayed with execute_bundle().
+	 * Each recording gets a fresh command list, so the previous one can retire through deferred destruction.
+	 */
+	class Bundle
+	{
+	public:
+		explicit Bundle(std::uint32_t queueIndex) : m_queueIndex(queueIndex) {}
+		~Bundle() = default;
+
+		DISABLE_COPY_AND_MOVE(Bundle);
+
+		auto get_queue_index() const -> std::uint32_t { return m_queueIndex; }
+		// The command list and recording state are guarded by the device's bundle mutex.
+		auto get_command_list() const -> CommandListHandle { return m_commandListHandle; }
+		bool is_valid() const { return m_valid.load(std::memory_order_acquire); }
+		bool is_recording() const { return m_recording; }
+
+		void set_command_list(CommandListHandle commandListHandle) { m_commandListHandle = commandListHandle; }
+		void set_valid(bool valid) { m_valid.store(valid, std::memory_order_release); }
+		void set_recording(bool recording) { m_recording = recording; }
+
+	private:
+		std::uint32_t m_queueIndex{ 0 };
+		CommandListHandle m_commandListHandle{};
+		std::atomic<bool> m_valid{ false };
+		bool m_recording{ false }; // Between begin_bundle() and end_bundle(), cleared by an invalidation meanwhile.
+	};
+
+	/**
+	 * @brief Small fixed-size thread pool, the scheduler used when none is given. Jobs still queued when the pool is destroyed
+	 * are run before the threads join.
+	 */
+	class WorkerPool final : public TaskScheduler
+	{
+	public:
+		explicit WorkerPool(std::uint32_t threadCount);
+		~WorkerPool() override;
+
+		DISABLE_COPY_AND_MOVE(WorkerPool);
+
+		void enqueue(std::function<void()>&& job) override;
+		auto get_thread_count() const -> std::uint32_t override { return std::uint32_t(m_threads.size()); }
+
+	private:
+		void run(std::stop_token stopToken);
+
+	private:
+		std::mutex m_mutex;
+		std::condition_variable_any m_condition;
+		std::deque<std::function<void()>> m_jobs;
+		std::vector<std::jthread> m_threads; // Last, so the threads join before the queue is destroyed.
+	};
+
+	/**
+	 * @brief Hands out descriptor sets from a chain of pools, adding a larger pool whenever the current ones run out.
+	 * Sets are never freed one at a time, so the pools skip eFreeDescriptorSet and the driver can allocate linearly.
+	 * Not thread safe.
+	 */
+	class DescriptorAllocator
+	{
+	public:
+		/**
+		 * @param inlineUniformBlocks Give the pools room for inline uniform blocks, which needs the device feature.
+		 */
+		explicit DescriptorAllocator(vk::Device device, std::uint32_t initialSetsPerPool, bool inlineUniformBlocks);
+		~DescriptorAllocator() = default;
+
+		DISABLE_COPY_AND_MOVE(DescriptorAllocator);
+
+		bool allocate(vk::DescriptorSet& outDescriptorSet, vk::DescriptorSetLayout descriptorSetLayout);
+		/**
+		 * @brief Return every set to the pools at once, keeping the pools for reuse. No set may still be in use.
+		 */
+		void reset();
+
+	private:
+		void add_pool();
+
+	private:
+		static constexpr std::uint32_t MAX_SETS_PER_POOL = 4096;
+
+		vk::Device m_device;
+		std::uint32_t m_setsPerPool{ 0 }; // Of the next pool added, doubling each time.
+		bool m_inlineUniformBlocks{ false };
+		std::vector<vk::UniqueDescriptorPool> m_pools;
+		std::size_t m_currentPool{ 0 }; // Earlier pools are full, until reset().
+	};
+
+	/**
+	 * @brief Descriptor memory for VK_EXT_descriptor_buffer: one persistently mapped buffer that sets are sub-allocated from
+	 * and descriptors are written into with plain memory copies, with no pools or driver descriptor updates involved.
+	 * Persistent sets are allocated from the first half. The second half is split between the frames in flight for transient
+	 * sets, each part reset at once like a descriptor pool.
+	 */
+	class DescriptorBuffer
+	{
+	public:
+		explicit DescriptorBuffer(vk::Device device, vma::Allocator allocator, const vk::PhysicalDeviceDescriptorBufferPropertiesEXT& properties, std::uint64_t size, std::uint32_t framesInFlight);
+		~DescriptorBuffer() = default;
+
+		DISABLE_COPY_AND_MOVE(DescriptorBuffer);
+
+		/**
+		 * @param frameIndex The frame in flight to allocate a transient set for, or none for a persistent set.
+		 */
+		bool allocate(vk::DeviceSize& outOffset, vk::DescriptorSetLayout descriptorSetLayout, std::optional<std::uint32_t> frameIndex = std::nullopt);
+		/**
+		 * @brief Free the frame's transient sets. None may still be in use.
+		 */
+		void reset_frame(std::uint32_t frameIndex);
+
+		/**
+		 * @brief Write a descriptor into a set allocated at setOffset. The GPU must not be using the descriptor.
+		 */
+		void write(vk::DeviceSize setOffset, vk::DescriptorSetLayout descriptorSetLayout, std::uint32_t binding, std::uint32_t arrayElement, const vk::DescriptorGetInfoEXT& descriptorInfo);
+		/**
+		 * @brief Write constants into an inline uniform block binding, whose data is stored in the buffer as is.
+		 */
+		void write_inline(vk::DeviceSize setOffset, vk::DescriptorSetLayout descriptorSetLayout, std::uint32_t binding, std::uint32_t offset, std::uint32_t size, const void* data);
+
+		auto get_binding_info() const -> vk::DescriptorBufferBindingInfoEXT;
+
+	private:
+		auto get_descriptor_size(vk::DescriptorType descriptorType) const -> std::size_t;
+
+	private:
+		vk::Device m_device;
+		vk::PhysicalDeviceDescriptorBufferPropertiesEXT m_properties;
+		vma::UniqueBuffer m_buffer;
+		vma::UniqueAllocation m_allocation;
+		std::byte* m_mappedPtr{ nullptr };
+		vk::DeviceAddress m_address{ 0 };
+		vk::BufferUsageFlags m_usageFlags{};
+
+		struct Region
+		{
+			vk::DeviceSize begin{ 0 };
+			vk::DeviceSize end{ 0 };
+			vk::DeviceSize head{ 0 };
+		};
+		Region m_persistentRegion{};
+		std::vector<Region> m_frameRegions;
+	};
+
+	/**
+	 * @brief One update-after-bind descriptor set with an array per bindless binding, and the slot each resource holds in them.
+	 * Slots are only ever written while unused by the GPU (new or freed once their resource retired), which the set's
+	 * eUpdateUnusedWhilePending bindings allow even while command lists using the set execute. Thread safe.
+	 * With a descriptor buffer the set lives in it instead, where writes to unused slots are always allowed.
+	 */
+	class BindlessHeap
+	{
+	public:
+		static constexpr std::uint32_t BINDING_COUNT = 3;
+
+		explicit BindlessHeap(vk::Device device, const std::array<std::uint32_t, BINDING_COUNT>& slotCounts, DescriptorBuffer* descriptorBuffer);
+		~BindlessHeap() = default;
+
+		DISABLE_COPY_AND_MOVE(BindlessHeap);
+
+		auto get_layout() const -> vk::DescriptorSetLayout { return m_layout.get(); }
+		auto get_set() const -> vk::DescriptorSet { return m_set; }
+		auto get_descriptor_buffer_offset() const -> vk::DeviceSize { return m_descriptorBufferOffset; }
+		auto get_binding_types() const -> std::vector<vk::DescriptorType>;
+
+		auto get_index(std::uint32_t binding, ResourceHandle resourceHandle) -> std::uint32_t;
+		/**
+		 * @brief Give a resource a slot and write it. Writing a resource that already has one, e.g. after it was moved, rewrites
+		 * it in place, which the GPU must not be using.
+		 */
+		void write_texture(ResourceHandle resourceHandle, vk::ImageView imageView);
+		void write_sampler(ResourceHandle resourceHandle, vk::Sampler sampler);
+		void write_buffer(ResourceHandle resourceHandle, vk::Buffer buffer, vk::DeviceSize size, vk::DeviceAddress address);
+		/**
+		 * @brief Free a resource's slot for reuse. The GPU must be done with it.
+		 */
+		void remove(std::uint32_t binding, ResourceHandle resourceHandle);
+
+	private:
+		// Slot of the resource in the binding, assigned if it has none. INVALID_BINDLESS_INDEX when the array is full.
+		auto get_or_add_index(std::uint32_t binding, ResourceHandle resourceHandle) -> std::uint32_t;
+		void write(std::uint32_t binding, std::uint32_t index, const vk::DescriptorImageInfo* imageInfo, const vk::DescriptorBufferInfo* bufferInfo);
+
+	private:
+		static constexpr std::array<vk::DescriptorType, BINDING_COUNT> BINDING_TYPES = {
+			vk::DescriptorType::eSampledImage,
+			vk::DescriptorType::eSampler,
+			vk::DescriptorType::eStorageBuffer,
+		};
+
+		vk::Device m_device;
+		vk::UniqueDescriptorSetLayout m_layout;
+		vk::UniqueDescriptorPool m_pool;
+		vk::DescriptorSet m_set;
+		DescriptorBuffer* m_descriptorBuffer{ nullptr }; // Replaces the pool and set when set.
+		vk::DeviceSize m_descriptorBufferOffset{ 0 };
+
+		struct Slots
+		{
+			std::uint32_t count{ 0 };
+			std::uint32_t nextIndex{ 0 }; // Slots from here on were never used.
+			std::vector<std::uint32_t> freeIndices;
+			std::unordered_map<std::uint32_t, std::uint32_t> indices; // Keyed by resource handle.
+		};
+		std::array<Slots, BINDING_COUNT> m_slots;
+		std::mutex m_mutex;
+	};
+
+	/**
+	 * @brief Batches buffer and texture uploads through a staging ring buffer into one submission on the upload queue.
+	 * Ring space is reclaimed as submissions complete, so neither queueing nor flushing ever waits on the GPU.
+	 */
+	class UploadManager
+	{
+	public:
+		explicit UploadManager(Device& device, std::uint32_t queueIndex, std::uint64_t stagingSize);
+		~UploadManager() = default;
+
+		DISABLE_COPY_AND_MOVE(UploadManager);
+
+		bool queue_buffer_upload(BufferHandle bufferHandle, const void* data, std::uint64_t size, std::uint64_t offset);
+		bool queue_texture_upload(TextureHandle textureHandle, const void* data, std::uint64_t size, std::uint32_t mipLevel);
+		bool allocate_buffer_upload(UploadAllocation& outAllocation, BufferHandle bufferHandle, std::uint64_t size, std::uint64_t offset);
+		bool allocate_texture_upload(UploadAllocation& outAllocation, TextureHandle textureHandle, std::uint32_t mipLevel);
+		/**
+		 * @brief Make an allocation's upload part of the next flush, or skip it if not commit.
+		 */
+		void commit(const UploadAllocation& allocation, bool commit);
+		auto flush(std::uint32_t dstQueueIndex) -> SyncPoint;
+
+	private:
+		/**
+		 * @brief Copy data into the ring, after reclaiming the space of completed submissions. The mutex must be held.
+		 */
+		bool stage(const void* data, std::uint64_t size, std::uint64_t& outOffset);
+		/**
+		 * @brief Find room in the ring without writing it, like stage(). The mutex must be held.
+		 */
+		bool reserve(std::uint64_t size, std::uint64_t& outOffset);
+		/**
+		 * @brief Where an upload to a mapped buffer is written in place, skipping the ring, or null. Only with unified memory.
+		 * The write happens immediately rather than at the next flush, so the range must not be in use by the GPU.
+		 */
+		auto get_in_place_upload_ptr(BufferHandle bufferHandle, std::uint64_t size, std::uint64_t offset) -> std::byte*;
+
+		// UploadAllocation::stagingOffset of allocations written in place.
+		static constexpr std::uint64_t IN_PLACE_STAGING_OFFSET = ~0ull;
+
+		struct PendingUpload
+		{
+			BufferHandle bufferHandle{};   // Either a buffer
+			TextureHandle textureHandle{}; // or a texture.
+			std::uint64_t stagingOffset{ 0 };
+			std::uint64_t dstOffset{ 0 };
+			std::uint64_t size{ 0 };
+			std::uint32_t mipLevel{ 0 };
+			bool committed{ true }; // False while an allocation is still being written.
+		};
+		struct InFlightBatch
+		{
+			SyncPoint syncPoint;
+			std::uint64_t stagingEnd{ 0 }; // The ring's tail once syncPoint is reached.
+		};
+
+		Device* m_device{ nullptr };
+		std::uint32_t m_queueIndex{ 0 };
+
+		BufferHandle m_stagingBufferHandle{};
+		std::byte* m_stagingPtr{ nullptr };
+		std::uint64_t m_stagingSize{ 0 };
+		std::uint64_t m_head{ 0 }; // Next free byte.
+		std::uint64_t m_tail{ 0 }; // Oldest byte still used by a pending or in flight upload.
+
+		std::vector<PendingUpload> m_pendingUploads;
+		std::deque<InFlightBatch> m_inFlightBatches;
+		std::mutex m_mutex;
+	};
+
+	/**
+	 * @brief One allocation shared by aliased textures or placed resources, each bound at its own offset. Freed with the last of them.
+	 */
+	class AliasedMemory
+	{
+	public:
+		explicit AliasedMemory(vma::Allocator allocator, vma::Allocation allocation);
+		/**
+		 * @brief Memory allocated outside VMA, exported to or imported from another process or API.
+		 */
+		explicit AliasedMemory(vk::UniqueDeviceMemory&& deviceMemory, vk::DeviceSize size, std::uint32_t memoryTypeIndex, bool exportable);
+		~AliasedMemory();
+
+		GFX_DISABLE_COPY(AliasedMemory);
+
+		// Null for memory allocated outside VMA, which is bound through get_device_memory() instead.
+		auto get_allocation() const -> vma::Allocation { return m_allocation; }
+		auto get_device_memory() const -> vk::DeviceMemory { return m_deviceMemory.get(); }
+		auto get_size() const -> vk::DeviceSize { return m_size; }
+		auto get_memory_type_index() const -> std::uint32_t { return m_memoryTypeIndex; }
+		bool is_exportable() const { return m_exportable; }
+
+	private:
+		vma::Allocator m_allocator;
+		vma::Allocation m_allocation;
+
+		vk::UniqueDeviceMemory m_deviceMemory;
+		vk::DeviceSize m_size{ 0 };
+		std::uint32_t m_memoryTypeIndex{ 0 };
+		bool m_exportable{ false };
+	};
+
+	/**
+	 * @brief Memory backing the resident pages of a sparse buffer or texture.
+	 * Each page has its own allocation, so pages can be made resident and evicted in any order.
+	 */
+	class SparseResidency
+	{
+	public:
+		explicit SparseResidency(vma::Allocator allocator, const vk::MemoryRequirements& memoryRequirements);
+		~SparseResidency();
+
+		GFX_DISABLE_COPY(SparseResidency);
+
+		auto get_page_size() const -> std::uint64_t { return m_memoryRequirements.alignment; }
+		auto get_size() const -> std::uint64_t { return m_memoryRequirements.size; }
+
+		// The pages update_page() allocated and evicted for one bind, to retire once it completes or revert if it fails.
+		struct PageChanges
+		{
+			std::vector<std::pair<std::uint64_t, vma::Allocation>> allocated;
+			std::vector<std::pair<std::uint64_t, vma::Allocation>> evicted;
+		};
+
+		/**
+		 * @brief Allocate memory for a page (size bytes, or a page if 0) or evict it, if it is not in that state already.
+		 * @param outMemory, outMemoryOffset What to bind the page to, null when evicted.
+		 * @param outChanges Receives the page's new or evicted memory.
+		 * @return Whether the page needs binding. False if unchanged, or if allocating failed.
+		 */
+		bool update_page(std::uint64_t pageKey, std::uint64_t size, bool resident, vk::DeviceMemory& outMemory, vk::DeviceSize& outMemoryOffset, PageChanges& outChanges);
+		/**
+		 * @brief Undo the changes of a bind that was never made. The memory it allocated is freed, and what it evicted is resident again.
+		 * @param outOrphanedAllocations Evicted memory whose page a later bind has made resident since, to free once that bind has completed.
+		 */
+		void revert(const PageChanges& changes, std::vector<vma::Allocation>& outOrphanedAllocations);
+
+		// Textures only, from getImageSparseMemoryRequirements().
+
+		std::vector<vk::SparseImageMemoryRequirements> imageRequirements;
+		std::atomic<bool> mipTailResident{ false };
+
+	private:
+		vma::Allocator m_allocator;
+		vk::MemoryRequirements m_memoryRequirements;
+		std::unordered_map<std::uint64_t, vma::Allocation> m_pages;
+		std::mutex m_mutex;
+	};
+
+	/**
+	 * @brief Sub-allocates ranges of a few large buffers using VMA's virtual (TLSF) allocator.
+	 * The buffers themselves belong to the device's buffer pool, so destroy_buffer_arena() retires them through deferred destruction.
+	 */
+	class BufferArena
+	{
+	public:
+		explicit BufferArena(Device& device, const BufferArenaInfo& bufferArenaInfo);
+		~BufferArena();
+
+		DISABLE_COPY_AND_MOVE(BufferArena);
+
+		bool allocate(BufferAllocation& outAllocation, std::uint64_t size, std::uint64_t alignment);
+		void free(const BufferAllocation& allocation);
+
+		/**
+		 * @brief Hand back the arena's buffers, so they can be destroyed.
+		 */
+		auto get_buffers() const -> std::vector<BufferHandle>;
+
+	private:
+		// Driven through VMA's C API, the C++ bindings treat a full block as a failed result rather than a normal outcome.
+		struct Block
+		{
+			BufferHandle bufferHandle{};
+			VmaVirtualBlock virtualBlock{ VK_NULL_HANDLE };
+		};
+
+		Device* m_device{ nullptr };
+		BufferArenaInfo m_info{};
+
+		std::vector<Block> m_blocks;
+		mutable std::mutex m_mutex;
+	};
+
+	/**
+	 * @brief An application managed heap, see gfx::create_memory_heap(). Resources placed in it share its memory, which is
+	 * freed once the heap and all of them are destroyed.
+	 */
+	class MemoryHeap
+	{
+	public:
+		/**
+		 * @param virtualBlock Tracks the ranges handed out by allocate(), owned by the heap.
+		 */
+		explicit MemoryHeap(std::shared_ptr<AliasedMemory> memory, std::uint32_t memoryTypeIndex, VmaVirtualBlock virtualBlock, const MemoryHeapInfo& memoryHeapInfo);
+		~MemoryHeap();
+
+		DISABLE_COPY_AND_MOVE(MemoryHeap);
+
+		auto get_memory() const -> const std::shared_ptr<AliasedMemory>& { return m_memory; }
+		auto get_type() const -> MemoryHeapType { return m_info.type; }
+		/**
+		 * @brief Whether a resource with these requirements can be placed at offset, reporting why not.
+		 */
+		bool can_place(const vk::MemoryRequirements& requirements, std::uint64_t offset) const;
+
+		bool allocate(MemoryHeapAllocation& outAllocation, std::uint64_t size, std::uint64_t alignment);
+		void free(const MemoryHeapAllocation& allocation);
+
+	private:
+		std::shared_ptr<AliasedMemory> m_memory;
+		std::uint32_t m_memoryTypeIndex;
+		VmaVirtualBlock m_virtualBlock;
+		MemoryHeapInfo m_info;
+		std::mutex m_mutex; // Guards m_virtualBlock.
+	};
+
+	/**
+	 * @brief A Vulkan Video decode session for one stream, see gfx::create_video_decoder(). Implemented in gfx_video.cpp.
+	 * Pictures live in the layers of one DPB image, shared by the decode and output queue families, and are copied out of it
+	 * (or out of a separate output image, where the device cannot decode into the DPB directly) into the frames' textures.
+	 * Video layouts are only ever set on the decode queue, which leaves shown pictures ready to copy.
+	 */
+	class VideoDecoder
+	{
+	public:
+		explicit VideoDecoder(Device& device, const VideoDecoderInfo& decoderInfo);
+		~VideoDecoder() = default;
+
+		DISABLE_COPY_AND_MOVE(VideoDecoder);
+
+		bool is_valid() const { return m_valid; }
+
+		bool set_parameters(const VideoParameters& parameters);
+		auto decode_frame(const VideoFrameInfo& frameInfo) -> SyncPoint;
+
+	private:
+		// A multi-planar image of pictures, one per layer, with a view of every layer.
+		struct PictureImage
+		{
+			vma::UniqueImage image;
+			vma::UniqueAllocation allocation;
+			vk::UniqueImageView view;
+		};
+
+		// Fill the profile chain, which everything created for the session points to.
+		bool init_profile();
+		bool create_session();
+		bool create_picture_image(PictureImage& outImage, vk::ImageUsageFlags usage, std::uint32_t layerCount);
+		bool create_images();
+		bool create_bitstream_buffer();
+
+		bool validate_frame(const VideoFrameInfo& frameInfo) const;
+		bool get_output_texture(Texture*& outTexture, TextureHandle textureHandle, vk::Format format, vk::Extent2D extent) const;
+		// Bring the slots the frame uses into the DPB layout, and the output image into the decode one.
+		void record_pre_decode_barriers(vk::CommandBuffer commandBuffer, const VideoFrameInfo& frameInfo);
+		void record_decode(vk::CommandBuffer commandBuffer, const VideoFrameInfo& frameInfo, vk::DeviceSize bitstreamOffset, vk::DeviceSize bitstreamRange);
+		// Leave the decoded picture ready to be copied on the output queue.
+		void record_post_decode_barriers(vk::CommandBuffer commandBuffer, const VideoFrameInfo& frameInfo);
+		// Copy the decoded picture's planes into the frame's textures, on the output queue.
+		void record_output(CommandList& commandList, const VideoFrameInfo& frameInfo, Texture* lumaTexture, Texture* chromaTexture);
+
+		Device& m_device;
+		VideoDecoderInfo m_info;
+		vma::Allocator m_allocator; // The VMA unique handles keep a pointer to it.
+		bool m_valid{ false };
+
+		vk::VideoDecodeH264ProfileInfoKHR m_h264Profile{};
+		vk::VideoDecodeH265ProfileInfoKHR m_h265Profile{};
+		vk::VideoDecodeAV1ProfileInfoKHR m_av1Profile{};
+		vk::VideoProfileInfoKHR m_profile{};
+		vk::VideoProfileListInfoKHR m_profileList{};
+
+		vk::VideoCapabilitiesKHR m_capabilities{};
+		vk::VideoDecodeCapabilitiesKHR m_decodeCapabilities{};
+		vk::Extent2D m_maxCodedExtent{};
+		std::uint32_t m_maxActiveReferences{ 0 };
+
+		std::vector<vma::UniqueAllocation> m_sessionMemory;
+		vk::UniqueVideoSessionKHR m_session;
+		vk::UniqueVideoSessionParametersKHR m_parameters;
+		bool m_sessionReset{ false }; // Sessions start in an undefined state, reset by their first decode.
+
+		vk::Format m_pictureFormat{};
+		bool m_dpbIsOutput{ false }; // Frames are decoded into their DPB slot, and copied out of it.
+		PictureImage m_dpb;
+		std::vector<vk::ImageLayout> m_dpbLayouts; // Of each slot, as the last decode left it.
+		PictureImage m_output;					   // Only without m_dpbIsOutput.
+
+		vma::UniqueBuffer m_bitstreamBuffer; // framesInFlight slots, each written by the CPU before its frame's decode.
+		vma::UniqueAllocation m_bitstreamAllocation;
+		std::byte* m_bitstreamPtr{ nullptr };
+		vk::DeviceSize m_bitstreamSlotSize{ 0 };
+		std::vector<SyncPoint> m_bitstreamSyncPoints; // The decode last reading each slot.
+		std::uint32_t m_nextBitstreamSlot{ 0 };
+		SyncPoint m_lastOutputSyncPoint{}; // The last copy out of the DPB, which the next decode waits for before overwriting it.
+	};
+
+	/**
+	 * @brief Runs VMA's incremental defragmentation, one pass at a time across frames.
+	 * A moved buffer or texture keeps its handle, its Vulkan object is swapped in place once the copy has completed.
+	 */
+	class Defragmenter
+	{
+	public:
+		explicit Defragmenter(Device& device);
+		~Defragmenter();
+
+		DISABLE_COPY_AND_MOVE(Defragmenter);
+
+		bool begin(const DefragmentationInfo& defragmentationInfo);
+		bool step();
+		void end();
+
+		/**
+		 * @brief Hold back the destruction of a resource whose allocation is part of the pass in flight, until the pass ends.
+		 * @return False if the allocation is not being moved, so destroyFunc was not taken.
+		 */
+		bool postpone_destroy(vma::Allocation allocation, std::function<void()>& destroyFunc);
+
+		/**
+		 * @brief Tag an allocation with its owner's pool slot, so a move proposed by VMA can be traced back to the resource.
+		 */
+		static auto make_owner_tag(ResourceHandle resourceHandle, bool isTexture) -> void*;
+
+	private:
+		// Driven through VMA's C API, the C++ bindings treat VK_INCOMPLETE (more passes to go) as a failed result.
+		enum class PassState
+		{
+			eIdle,
+			eCopying,  // Copies submitted, the resources still use their old objects.
+			eRetiring, // Moved objects swapped in, waiting for the GPU to finish with the old ones.
+		};
+		struct Move
+		{
+			ResourceHandle resourceHandle{};
+			bool isTexture{ false };
+			vk::Buffer dstBuffer; // Bound to the move's destination memory, owned here until swapped in.
+			vk::Image dstImage;
+			std::function<void()> postponedDestroy;
+		};
+
+		/**
+		 * @brief Record and submit the copies of the next pass.
+		 * @return False once there is nothing left VMA can move. The mutex must be held.
+		 */
+		bool begin_pass();
+		bool record_move(CommandList& commandList, VmaDefragmentationMove& move, Move& outMove);
+		void swap_moved_resources();
+		/**
+		 * @brief Hand the pass back to VMA, which releases the old memory.
+		 * @return True if defragmentation is complete.
+		 */
+		bool end_pass();
+		/**
+		 * @brief End VMA's defragmentation context. No pass may be in flight.
+		 */
+		void finish();
+		void destroy_move_objects(Move& move);
+
+		Device* m_device{ nullptr };
+		DefragmentationInfo m_info{};
+
+		VmaDefragmentationContext m_context{ VK_NULL_HANDLE };
+		VmaDefragmentationPassMoveInfo m_passInfo{};
+		std::vector<Move> m_moves; // Parallel to m_passInfo.pMoves.
+		PassState m_passState{ PassState::eIdle };
+		SyncPoint m_copySyncPoint{};
+		std::shared_ptr<std::atomic<bool>> m_passRetired; // Set through deferred destruction, once no submission uses the old objects.
+		std::mutex m_mutex;
+	};
+
+	// Capture files (see begin_capture()) are a header, the DeviceInfo of the captured device and then one record per captured
+	// call: its CaptureOp, the size of its arguments and the arguments. Arguments go through the same serialize() overloads when
+	// writing and reading, so CaptureWriter and CaptureReader cannot drift apart. Handles are stored as their 64-bit value, and
+	// the reader maps each to the handle created for it when replaying.
+	constexpr std::uint32_t CAPTURE_MAGIC = 0x43584647; // "GFXC"
+	constexpr std::uint32_t CAPTURE_VERSION = 12;
+	// Pipeline manifests (see DeviceInfo::pipelineManifestPath) are this and CAPTURE_VERSION, then one record per pipeline like a capture's create calls.
+	constexpr std::uint32_t PIPELINE_MANIFEST_MAGIC = 0x4E414D50; // "PMAN"
+
+	enum class CaptureOp : std::uint32_t
+	{
+		eBeginFrame,
+		eEndFrame,
+		eWaitForDeviceIdle,
+		eCreateBuffer,
+		eDestroyBuffer,
+		eUploadBuffer,
+		eQueueBufferUpload,
+		eWriteBuffer, // Contents of mapped memory, when it is unmapped, flushed or (for persistent mappings) submitted.
+		eCreateTexture,
+		eDestroyTexture,
+		eCreateTextureView,
+		eUploadTexture,
+		eQueueTextureUpload,
+		eFlushUploads,
+		eCreateSampler,
+		eDestroySampler,
+		eCreateComputePipeline,
+		eCreateGraphicsPipeline,
+		eCreateMeshPipeline,
+		eDestroyPipeline,
+		eCreateDescriptorSet,
+		eCreateDescriptorSetFromPipeline,
+		eCreateTransientDescriptorSet,
+		eDestroyDescriptorSet,
+		eBindBufferToDescriptorSet,
+		eBindTextureToDescriptorSet,
+		eUpdateDescriptorSet,
+		eCreateCommandList,
+		eCreateTransientCommandList,
+		eDestroyCommandList,
+		eCreateSwapChain,
+		eDestroySwapChain,
+		eGetSwapChainImage,
+		ePresentSwapChain,
+		eSubmitCommandList,
+		eSubmitCommandLists,
+		eReset,
+		eBegin,
+		eEnd,
+		eBeginRenderPass,
+		eEndRenderPass,
+		eSetViewport,
+		eSetScissor,
+		eBindPipeline,
+		eBindDescriptorSets,
+		eSetConstants,
+		eBindIndexBuffer,
+		eBindVertexBuffers,
+		eDraw,
+		eDrawIndexed,
+		eDrawIndirect,
+		eDrawIndexedIndirect,
+		eDispatch,
+		eDispatchIndirect,
+		eTransitionTexture,
+		eTransitionTextureRange,
+		eCopyBuffer,
+		eCopyBufferToTexture,
+		eGenerateMipmaps,
+		eFillBuffer,
+		eUpdateBuffer,
+		ePushMarker,
+		ePopMarker,
+		eBufferBarrier,
+		eBufferBarrierRange,
+		eMemoryBarrier,
+		eWriteInlineUniformBlock,
+		eCopyTexture,
+		eBlitTexture,
+		eResolveTexture,
+	};
+
+	/**
+	 * @brief One batch of submit_command_lists(), with the spans copied and the signalled semaphore known.
+	 */
+	struct CaptureSubmitBatch
+	{
+		std::vector<CommandListHandle> commandLists;
+		std::vector<SemaphoreWait> waitSemaphores;
+		bool signalSemaphore{ false };			  // The batch was given an outSignalSemaphoreHandle.
+		std::uint64_t signalSemaphoreHandle{ 0 }; // Value of the handle it received.
+		SwapChainHandle swapChainHandle{};
+	};
+
+	template <typename T>
+	concept CaptureResourceHandle = requires(T handle) {
+		handle.deviceHandle;
+		handle.resourceHandle;
+	};
+	template <typename T>
+	struct IsCaptureArray : std::false_type
+	{
+	};
+	template <typename T, std::size_t N>
+	struct IsCaptureArray<std::array<T, N>> : std::true_type
+	{
+	};
+	template <typename T>
+	struct IsCaptureSpan : std::false_type
+	{
+	};
+	template <typename T, std::size_t N>
+	struct IsCaptureSpan<std::span<T, N>> : std::true_type
+	{
+	};
+	// Strings and vectors, stored with their size.
+	template <typename T>
+	concept CaptureSequence = requires(T sequence) {
+		sequence.resize(0);
+		sequence.data();
+		typename T::value_type;
+	};
+
+	/**
+	 * @brief Serializes the captured calls of one device into memory, written to the file by save().
+	 * Any thread may record, calls are ordered by when they were recorded.
+	 */
+	class CaptureWriter
+	{
+	public:
+		explicit CaptureWriter(std::string path) : m_path(std::move(path)) {}
+
+		DISABLE_COPY_AND_MOVE(CaptureWriter);
+
+		template <typename... Args>
+		void record(CaptureOp op, const Args&... args)
+		{
+			std::lock_guard lock(m_mutex);
+			write(static_cast<std::uint32_t>(op));
+			const auto sizeOffset = m_data.size();
+			write(std::uint32_t{ 0 });
+			(write(args), ...);
+			const auto size = static_cast<std::uint32_t>(m_data.size() - sizeOffset - sizeof(std::uint32_t));
+			std::memcpy(m_data.data() + sizeOffset, &size, sizeof(size));
+		}
+		/**
+		 * @brief Write the header, deviceInfo and the recorded calls to the file.
+		 */
+		bool save(const DeviceInfo& deviceInfo);
+
+		/**
+		 * @brief Persistently mapped buffers handed to the application, whose contents are recorded before each submission.
+		 */
+		void add_mapped_buffer(BufferHandle bufferHandle);
+		auto get_mapped_buffers() -> std::vector<BufferHandle>;
+
+		// The calls recorded so far, eg. of a writer only used to serialize.
+		auto get_data() const -> std::span<const std::byte> { return m_data; }
+
+		// Used by the serialize() overloads.
+		template <typename... Args>
+		void operator()(const Args&... args)
+		{
+			(write(args), ...);
+		}
+
+	private:
+		template <typename T>
+		void write(const T& value)
+		{
+			if constexpr (CaptureResourceHandle<T>)
+			{
+				write(static_cast<std::uint64_t>(value));
+			}
+			else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>)
+			{
+				const auto* bytes = reinterpret_cast<const std::byte*>(&value);
+				m_data.insert(m_data.end(), bytes, bytes + sizeof(T));
+			}
+			else if constexpr (CaptureSequence<T> || IsCaptureSpan<T>::value)
+			{
+				write(static_cast<std::uint64_t>(value.size()));
+				using Element = std::remove_cv_t<typename T::value_type>;
+				if constexpr (std::is_arithmetic_v<Element> || std::is_same_v<Element, std::byte>)
+				{
+					const auto* bytes = reinterpret_cast<const std::byte*>(value.data());
+					m_data.insert(m_data.end(), bytes, bytes + value.size() * sizeof(Element));
+				}
+				else
+				{
+					for (const auto& element : value)
+					{
+						write(element);
+					}
+				}
+			}
+			else if constexpr (IsCaptureArray<T>::value)
+			{
+				for (const auto& element : value)
+				{
+					write(element);
+				}
+			}
+			else
+			{
+				// The overloads take their struct by reference to also read into it, but only read from it here.
+				serialize(*this, const_cast<T&>(value));
+			}
+		}
+
+		std::string m_path;
+		std::vector<std::byte> m_data;
+		std::unordered_set<std::uint64_t> m_mappedBuffers;
+		std::mutex m_mutex;
+	};
+
+	/**
+	 * @brief Reads the arguments of a captured call back, mapping captured handles to the ones created by the replay.
+	 * Handles that were never mapped, eg. null ones, read as null. Reading past the end of the call zero fills and fails.
+	 */
+	class CaptureReader
+	{
+	public:
+		CaptureReader(std::span<const std::byte> data, DeviceHandle deviceHandle, const std::unordered_map<std::uint64_t, std::uint64_t>& handles)
+			: m_data(data), m_deviceHandle(deviceHandle), m_handles(handles)
+		{
+		}
+
+		bool is_valid() const { return !m_failed; }
+		bool is_at_end() const { return m_offset == m_data.size(); }
+		auto get_offset() const -> std::size_t { return m_offset; }
+
+		template <typename... Args>
+		void operator()(Args&... args)
+		{
+			(read(args), ...);
+		}
+
+		template <typename T>
+		auto read() -> T
+		{
+			T value{};
+			read(value);
+			return value;
+		}
+
+	private:
+		template <typename T>
+		void read(T& value)
+		{
+			if constexpr (CaptureResourceHandle<T>)
+			{
+				const auto captured = read<std::uint64_t>();
+				const auto it = m_handles.find(captured);
+				const auto replayed = it != m_handles.end() ? it->second : 0;
+				value = replayed != 0 ? T(static_cast<DeviceHandle>(replayed >> 32u), static_cast<ResourceHandle>(replayed & 0xFFFFFFFFu)) : T{};
+			}
+			else if constexpr (std::is_same_v<T, DeviceHandle>)
+			{
+				read_bytes(&value, sizeof(T));
+				value = m_deviceHandle;
+			}
+			else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>)
+			{
+				read_bytes(&value, sizeof(T));
+			}
+			else if constexpr (CaptureSequence<T>)
+			{
+				const auto size = read<std::uint64_t>();
+				using Element = typename T::value_type;
+				if (size > m_data.size() - m_offset)
+				{
+					m_failed = true;
+					return;
+				}
+				value.resize(size);
+				if constexpr (std::is_arithmetic_v<Element> || std::is_same_v<Element, std::byte>)
+				{
+					read_bytes(value.data(), size * sizeof(Element));
+				}
+				else
+				{
+					for (auto& element : value)
+					{
+						read(element);
+					}
+				}
+			}
+			else if constexpr (IsCaptureArray<T>::value)
+			{
+				for (auto& element : value)
+				{
+					read(element);
+				}
+			}
+			else
+			{
+				serialize(*this, value);
+			}
+		}
+		void read_bytes(void* dst, std::size_t size)
+		{
+			if (m_failed || size > m_data.size() - m_offset)
+			{
+				m_failed = true;
+				std::memset(dst, 0, size);
+				return;
+			}
+			std::memcpy(dst, m_data.data() + m_offset, size);
+			m_offset += size;
+		}
+
+		std::span<const std::byte> m_data;
+		std::size_t m_offset{ 0 };
+		DeviceHandle m_deviceHandle;
+		const std::unordered_map<std::uint64_t, std::uint64_t>& m_handles;
+		bool m_failed{ false };
+	};
+
+	// The members of each argument struct, in the order they are stored.
+	template <typename Archive>
+	void serialize(Archive& ar, DeviceInfo& info)
+	{
+		// The pipeline cache path is left out, a replay should not share the captured application's cache.
+		ar(info.deviceFlags, info.queueFlags, info.queuePriorities, info.queueGlobalPriorities, info.framesInFlight, info.threadedSubmission,
+		   info.transientBufferSize, info.uploadBufferSize, info.uploadQueueIndex, info.bindlessTextureCount, info.bindlessSamplerCount,
+		   info.bindlessStorageBufferCount, info.descriptorBufferSize, info.shaderObjects, info.gpuScopesPerFrame, info.gpuQueriesPerFrame,
+		   info.workerThreadCount);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, BufferInfo& info)
+	{
+		ar(info.type, info.size, info.memory, info.deviceAddress, info.sparse, info.predicate, info.accelerationStructureInput, info.memoryPriority, info.debugName);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, TextureInfo& info)
+	{
+		ar(info.usage, info.type, info.width, info.height, info.format, info.depth, info.arrayLayers, info.mipLevels, info.memory, info.sparse,
+		   info.mutableFormat, info.sampleCount, info.memoryPriority, info.debugName);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, SamplerInfo& info)
+	{
+		ar(info.addressMode, info.filterMode, info.mipFilterMode, info.maxAnisotropy, info.mipLodBias, info.minLod, info.maxLod, info.compareOp);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, DescriptorBindingInfo& info)
+	{
+		ar(info.type, info.count, info.shaderStages);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, DescriptorSetInfo& info)
+	{
+		ar(info.bindings, info.bindlessHeap, info.push);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, PipelineConstantBlock& block)
+	{
+		ar(block.size, block.shaderStages);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, SpecializationConstant& constant)
+	{
+		ar(constant.id, constant.value);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, ShaderCode& code)
+	{
+		// Stored as words either way, so a replay owns its code rather than viewing an archive it does not have.
+		if constexpr (std::is_same_v<Archive, CaptureReader>)
+		{
+			std::vector<std::uint32_t> words{};
+			ar(words);
+			code = std::move(words);
+		}
+		else
+		{
+			ar(code.get_words());
+		}
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, ComputePipelineInfo& info)
+	{
+		ar(info.shaderCode, info.descriptorSets, info.constantBlock, info.specializationConstants, info.entryPoint, info.requiredSubgroupSize, info.requireFullSubgroups, info.debugName);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, VertexAttribute& attribute)
+	{
+		ar(attribute.name, attribute.location, attribute.format, attribute.offset);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, VertexBinding& binding)
+	{
+		ar(binding.name, binding.attributes, binding.stride, binding.inputRate, binding.divisor);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, StencilState& state)
+	{
+		ar(state.failOp, state.passOp, state.depthFailOp, state.compareOp, state.compareMask, state.writeMask, state.reference);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, BlendState& state)
+	{
+		ar(state.blendEnable, state.srcColorFactor, state.dstColorFactor, state.colorOp, state.srcAlphaFactor, state.dstAlphaFactor, state.alphaOp,
+		   state.colorWriteMask);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, GraphicsPipelineInfo& info)
+	{
+		ar(info.vertexCode, info.fragmentCode, info.vertexSpecializationConstants, info.fragmentSpecializationConstants, info.vertexInputBindings,
+		   info.descriptorSets, info.constantBlock, info.topology, info.cullMode, info.frontFace, info.depthTest, info.depthWrite, info.depthCompareOp,
+		   info.stencilTest, info.stencilFront, info.stencilBack, info.colorAttachments, info.colorBlendStates, info.dynamicStates,
+		   info.depthAttachmentFormat, info.sampleCount, info.viewMask, info.debugName);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, MeshPipelineInfo& info)
+	{
+		ar(info.taskCode, info.meshCode, info.taskSpecializationConstants, info.meshSpecializationConstants, info.state, info.debugName);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, DescriptorWrite& write)
+	{
+		ar(write.binding, write.arrayElement, write.bufferHandle, write.offset, write.range, write.textureHandle, write.viewIndex, write.samplerHandle);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, RenderPassInfo& info)
+	{
+		ar(info.colorAttachments, info.depthAttachment, info.colorAttachmentViews, info.depthAttachmentView, info.resolveAttachments, info.clearColor,
+		   info.secondaryCommandLists, info.colorLoadOps, info.colorStoreOps, info.depthLoadOp, info.depthStoreOp, info.renderArea, info.viewMask, info.shadingRateAttachment,
+		   info.localRead);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, SwapChainInfo& info)
+	{
+		// The platform handles mean nothing to a replay, which renders headless.
+		ar(info.initialWidth, info.initialHeight, info.presentMode, info.imageCount, info.imageCountMatchesFramesInFlight, info.lowLatency, info.headless);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, TextureSubresourceRange& range)
+	{
+		ar(range.baseMipLevel, range.mipLevelCount, range.baseArrayLayer, range.arrayLayerCount);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, TextureViewInfo& info)
+	{
+		ar(info.format, info.type, info.range);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, BufferCopyRegion& region)
+	{
+		ar(region.srcOffset, region.dstOffset, region.size);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, SemaphoreWait& wait)
+	{
+		ar(wait.semaphoreHandle, wait.stages);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, SubmitInfo& info)
+	{
+		ar(info.commandList, info.waitSemaphoreHandle, info.waitStages, info.swapChainHandle);
+	}
+	template <typename Archive>
+	void serialize(Archive& ar, CaptureSubmitBatch& batch)
+	{
+		ar(batch.commandLists, batch.waitSemaphores, batch.signalSemaphore, batch.signalSemaphoreHandle, batch.swapChainHandle);
+	}
+
+	/**
+	 * @brief The file of DeviceInfo::pipelineManifestPath: every distinct pipeline a device created, in this run and earlier
+	 * ones. Each is appended as it is first created, so a run that crashes keeps the pipelines it got to.
+	 */
+	class PipelineManifest
+	{
+	public:
+		using PipelineInfo = std::variant<ComputePipelineInfo, GraphicsPipelineInfo, MeshPipelineInfo>;
+
+		/**
+		 * @brief Read the pipelines of a manifest, up to a record cut short by a crash.
+		 * @param outSize Bytes of the file holding whole records.
+		 * @return False if the file cannot be read or is not a manifest of this version.
+		 */
+		static bool load(std::vector<PipelineInfo>& outPipelineInfos, const std::string& path, std::uint64_t* outSize = nullptr);
+
+		// Open a manifest to record to, keeping the pipelines it has. One that cannot be loaded is started again.
+		bool open(const std::string& path);
+		// Append a pipeline unless it is recorded already. Thread safe.
+		void record(std::size_t hash, const PipelineInfo& pipelineInfo);
+
+	private:
+		std::string m_path;
+		std::unordered_set<std::size_t> m_recordedHashes;
+		std::mutex m_mutex;
+	};
+
 	class Device
 	{
 	public:
+		using SharedPipelineInfo = std::variant<ComputePipelineInfo, GraphicsPipelineInfo, MeshPipelineInfo>;
+
 		Device() = default;
 		Device(Context& context, DeviceHandle deviceHandle, const DeviceInfo& deviceInfo);
-		~Device() = default;
+		~Device();
 		DISABLE_COPY_AND_MOVE(Device);
 
 		bool is_valid() const;
@@ -82,42 +1745,350 @@ namespace sm::gfx
 		auto get_physical_device() const -> vk::PhysicalDevice { return m_physicalDevice; }
 		auto get_device() const -> vk::Device { return m_device.get(); }
 		auto get_allocator() const -> vma::Allocator { return m_allocator.get(); }
+		bool supports_multi_draw_indirect() const { return m_multiDrawIndirectSupported; }
+		bool supports_draw_indirect_count() const { return m_drawIndirectCountSupported; }
+		bool supports_buffer_device_address() const { return m_bufferDeviceAddressSupported; }
+		bool supports_sparse_buffers() const { return m_sparseBufferSupported; }
+		bool supports_sparse_textures() const { return m_sparseTextureSupported; }
+		bool is_vertex_format_supported(vk::Format format) const;
+		bool supports_present_wait() const { return m_presentWaitSupported; }
+		bool supports_display_timing() const { return m_displayTimingSupported; }
+		bool supports_low_latency() const { return m_lowLatencySupported; }
+		bool supports_anti_lag() const { return m_antiLagSupported; }
+		bool supports_lazily_allocated_memory() const { return m_lazilyAllocatedMemorySupported; }
+		bool supports_memory_budget() const { return m_memoryBudgetSupported; }
+		bool supports_memory_priority() const { return m_memoryPrioritySupported; }
+		bool supports_pageable_memory() const { return m_pageableMemorySupported; }
+		bool supports_host_image_copy() const { return m_hostImageCopySupported; }
+		bool supports_bindless() const { return m_bindlessSupported; }
+		bool supports_dynamic_blend_state() const { return m_dynamicBlendStateSupported || m_shaderObjectsEnabled; } // Shader objects have the commands too.
+		bool supports_graphics_pipeline_library() const { return m_graphicsPipelineLibrarySupported; }
+		bool supports_mesh_shader() const { return m_meshShaderSupported; }
+		bool supports_shading_rate() const { return (m_enabledFeatures & DeviceFeatureFlags_ShadingRate) != 0; }
+		bool supports_conditional_rendering() const { return (m_enabledFeatures & DeviceFeatureFlags_ConditionalRendering) != 0; }
+		bool supports_ray_query() const { return (m_enabledFeatures & DeviceFeatureFlags_RayQuery) != 0; }
+		bool supports_local_read() const { return (m_enabledFeatures & DeviceFeatureFlags_LocalRead) != 0; }
+		bool supports_external_memory() const { return (m_enabledFeatures & DeviceFeatureFlags_ExternalMemory) != 0; }
+		bool supports_video_decode() const { return (m_enabledFeatures & DeviceFeatureFlags_VideoDecode) != 0; }
+		bool is_compute_only() const { return m_deviceInfo.computeOnly; }
+		auto get_device_group_mask() const -> std::uint32_t { return (1u << m_deviceGroupPhysicalDevices.size()) - 1; }
+		/**
+		 * @brief What the device was created with, see gfx::get_device_properties().
+		 */
+		auto get_properties() const -> const DeviceProperties& { return m_properties; }
+		/**
+		 * @return nullptr unless DeviceInfo::descriptorBufferSize was set and VK_EXT_descriptor_buffer is supported, in which case every set is stored in it.
+		 */
+		auto get_descriptor_buffer() const -> DescriptorBuffer* { return m_descriptorBuffer.get(); }
+		/**
+		 * @brief Whether adding host transfer usage to an image keeps it as fast for the GPU to access, e.g. compression.
+		 */
+		bool is_host_image_copy_optimal(const vk::ImageCreateInfo& imageInfo) const;
+		/**
+		 * @brief Write a whole mip level from host memory with VK_EXT_host_image_copy, leaving it in TextureState::eShaderRead.
+		 * Only for textures created with host transfer usage whose level was never used, so the GPU cannot be accessing it.
+		 * @return False if the level has to be staged instead.
+		 */
+		bool host_copy_texture_level(Texture& texture, const void* data, std::uint32_t mipLevel);
+		bool is_extension_available(const char* extensionName) const;
+		/**
+		 * @brief Fill m_properties, once the device has been created with these extensions.
+		 */
+		void init_properties(std::span<const char* const> enabledExtensions);
 		bool get_queue(vk::Queue& outQueue, std::uint32_t queueIndex);
+		auto get_queue_family(std::uint32_t queueIndex) const -> std::uint32_t { return m_queueFamilies.at(queueIndex); }
+		/**
+		 * @brief Queues must be externally synchronised, anything submitting or presenting to a queue holds its mutex.
+		 */
+		auto get_queue_mutex(std::uint32_t queueIndex) -> std::mutex& { return *m_queueTimelines.at(queueIndex).submitMutex; }
+		/**
+		 * @brief Resolve the families of an ownership transfer between two queues, and which half the command list records.
+		 * Fails if the command list belongs to neither queue.
+		 */
+		bool get_ownership_transfer(QueueOwnershipTransfer& outTransfer, const CommandList& commandList, std::uint32_t srcQueueIndex, std::uint32_t dstQueueIndex) const;
+
+		auto get_handle() const -> DeviceHandle { return m_deviceHandle; }
 
 		bool is_present_mode_supported(vk::PresentModeKHR presentMode, vk::SurfaceKHR surface) const;
 		auto get_first_supported_surface_format(const std::vector<vk::Format>& formats, vk::SurfaceKHR surface) -> vk::Format;
 
-		void wait_on_fence(FenceHandle fenceHandle);
+		bool wait_on_sync_points(std::span<const SyncPoint> syncPoints, bool waitAll, std::uint64_t timeoutNs);
+		bool is_sync_point_complete(const SyncPoint& syncPoint) const;
+		void wait_for_idle();
+		bool save_pipeline_cache();
+
+		/**
+		 * @brief Advance to the next frame in flight, command lists created afterwards use that frame's command pools.
+		 * Waits for the GPU to retire the last use of that frame, then resets its transient command pools in one go.
+		 */
+		void begin_frame();
+		void end_frame();
+		auto get_frames_in_flight() const -> std::uint32_t { return m_framesInFlight; }
+		auto get_frame_index() const -> std::uint32_t { return m_frameIndex.load(std::memory_order_relaxed); }
+
+		/**
+		 * @brief Bump allocate from the current frame's part of the transient ring buffer, which begin_frame() rewinds.
+		 */
+		auto allocate_transient(std::uint64_t size, std::uint64_t alignment) -> TransientAllocation;
+
+		/**
+		 * @brief Destroy all resources queued for deferred destruction whose submissions the GPU has completed.
+		 * Cheap to call every frame - it only polls the submission timeline counter.
+		 */
+		void process_deferred_destruction();
+		/**
+		 * @brief Run destroyFunc once the GPU has finished everything submitted so far, straight away if it already has.
+		 */
+		void defer_destroy(std::function<void()>&& destroyFunc);
 
 		void destroy_semaphore(SemaphoreHandle semaphoreHandle);
-
-		auto create_command_list(CommandListHandle& outCommandListHandle, std::uint32_t queueIndex) -> bool;
+		/**
+		 * @brief Resolve a semaphore that is about to be waited on, which leaves it unsignalled and so safe to recycle.
+		 */
+		bool get_wait_semaphore(vk::Semaphore& outSemaphore, SemaphoreHandle semaphoreHandle);
+
+		/**
+		 * @brief Create a command list from the calling thread's command pool for the current frame.
+		 * The command list should only be recorded on the thread that created it.
+		 */
+		auto create_command_list(CommandListHandle& outCommandListHandle, std::uint32_t queueIndex, std::uint32_t flags = 0, vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary) -> bool;
+		/**
+		 * @brief Queue the command stream of an ended CommandListFlags_Deferred command list for translation on a worker thread.
+		 */
+		void translate_command_list(CommandList& commandList);
+		/**
+		 * @brief Threads for CPU work such as command list translation and pipeline compilation, created on first use.
+		 */
+		/**
+		 * @brief DeviceInfo::taskScheduler, or a WorkerPool of workerThreadCount threads started on first use.
+		 */
+		auto get_task_scheduler() -> TaskScheduler&;
+		/**
+		 * @brief Run a task on the task scheduler. ~Device() waits for the tasks still running, as they reference the device.
+		 */
+		void run_task(std::function<void()>&& task);
+		/**
+		 * @brief Create a command list that only lives for the current frame. It is recycled by the next begin_frame() for this frame.
+		 */
+		auto create_transient_command_list(CommandListHandle& outCommandListHandle, std::uint32_t queueIndex, vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary) -> bool;
+		void destroy_command_list(CommandListHandle commandListHandle);
 		bool get_command_list(CommandList*& outCommandList, CommandListHandle commandListHandle);
-		bool submit_command_list(const SubmitInfo& submitInfo, FenceHandle* outFenceHandle, SemaphoreHandle* outSemaphoreHandle);
 
-		bool create_or_get_descriptor_set_layout(vk::DescriptorSetLayout& outDescriptorSetLayout, const DescriptorSetInfo& descriptorSetInfo);
+		auto create_bundle(BundleHandle& outBundleHandle, std::uint32_t queueIndex) -> bool;
+		void destroy_bundle(BundleHandle bundleHandle);
+		bool get_bundle(Bundle*& outBundle, BundleHandle bundleHandle);
+		/**
+		 * @brief Retire the bundle's previous recording and return a fresh secondary command list to record it into.
+		 */
+		bool begin_bundle(CommandList*& outCommandList, BundleHandle bundleHandle);
+		/**
+		 * @brief Make the bundle executable once its command list has ended, unless it was invalidated while it was recorded.
+		 */
+		void end_bundle(BundleHandle bundleHandle, const CommandList& commandList, bool ended);
+		/**
+		 * @brief The command list of a valid bundle, looked up under the bundle mutex as begin_bundle() may replace it.
+		 */
+		bool get_bundle_command_list(CommandList*& outCommandList, BundleHandle bundleHandle);
+		auto submit_command_list(const SubmitInfo& submitInfo, SemaphoreHandle* outSemaphoreHandle) -> SyncPoint;
+		/**
+		 * @brief Submit every batch to the queue in a single vkQueueSubmit2, only the last batch signals the queue's timeline.
+		 */
+		auto submit_command_lists(std::uint32_t queueIndex, std::span<const SubmitBatch> batches) -> SyncPoint;
+		/**
+		 * @brief Present on the submission thread when there is one, which also acquires the next image.
+		 */
+		auto present_swap_chain(SwapChain& swapChain, std::uint32_t queueIndex, vk::Semaphore waitSemaphore, std::uint64_t desiredPresentTimeNs) -> std::uint64_t;
+		/**
+		 * @param outPresentIds One per swap chain.
+		 */
+		void present_swap_chains(std::span<SwapChain* const> swapChains, std::uint32_t queueIndex, vk::Semaphore waitSemaphore, std::uint64_t desiredPresentTimeNs, std::span<std::uint64_t> outPresentIds);
 
-		bool create_compute_pipeline(PipelineHandle& outPipelineHandle, const ComputePipelineInfo& computePipelineInfo);
-		bool create_graphics_pipeline(PipelineHandle& outPipelineHandle, const GraphicsPipelineInfo& graphicsPipelineInfo);
+		bool create_or_get_descriptor_set_layout(vk::DescriptorSetLayout& outDescriptorSetLayout, const DescriptorSetInfo& descriptorSetInfo);
+		auto create_or_get_pipeline_layout(const std::vector<vk::DescriptorSetLayout>& setLayouts, vk::PushConstantRange constantRange) -> vk::PipelineLayout;
+		/**
+		 * @brief Get the module of some SPIR-V, creating it the first time it is seen. It lives until the device is destroyed.
+		 */
+		auto create_or_get_shader_module(const ShaderCode& code) -> vk::ShaderModule;
+		/**
+		 * @brief Get the library of one part of a graphics pipeline, compiling it the first time that part is seen.
+		 */
+		auto create_or_get_pipeline_library(vk::GraphicsPipelineLibraryFlagBitsEXT part, const GraphicsPipelineInfo& graphicsPipelineInfo, vk::ShaderModule vertexModule,
+											vk::ShaderModule fragmentModule, const std::vector<vk::DescriptorSetLayout>& setLayouts, vk::PipelineLayout pipelineLayout) -> vk::Pipeline;
+
+		/**
+		 * @param async Compile on the worker pool, binding placeholderHandle until it is done (see create_compute_pipeline_async()).
+		 */
+		bool create_compute_pipeline(PipelineHandle& outPipelineHandle, const ComputePipelineInfo& computePipelineInfo, bool async = false, PipelineHandle placeholderHandle = {});
+		bool create_graphics_pipeline(PipelineHandle& outPipelineHandle, const GraphicsPipelineInfo& graphicsPipelineInfo, bool async = false, PipelineHandle placeholderHandle = {});
+		bool create_mesh_pipeline(PipelineHandle& outPipelineHandle, const MeshPipelineInfo& meshPipelineInfo);
 		void destroy_pipeline(PipelineHandle pipelineHandle);
 		bool get_pipeline(Pipeline*& outPipeline, PipelineHandle pipelineHandle);
+		/**
+		 * @brief Take another reference to a live pipeline created from the same info, see m_sharedPipelines.
+		 * Unless async, waits for it to finish compiling, so synchronous creates always return a bindable pipeline.
+		 */
+		template <typename PipelineInfo>
+		bool find_shared_pipeline(PipelineHandle& outPipelineHandle, std::size_t hash, const PipelineInfo& pipelineInfo, bool async);
+		/**
+		 * @brief Register a newly created pipeline for sharing. If another thread created the same pipeline meanwhile, that one is
+		 * used instead and the new one destroyed, waited for like find_shared_pipeline().
+		 */
+		void share_pipeline(PipelineHandle& inOutPipelineHandle, std::size_t hash, const SharedPipelineInfo& pipelineInfo, bool async);
+		void wait_until_pipeline_ready(PipelineHandle pipelineHandle);
+		/**
+		 * @brief The pipeline to bind for a handle, its placeholder while it is still compiling.
+		 */
+		bool get_bindable_pipeline(Pipeline*& outPipeline, PipelineHandle pipelineHandle);
+		bool is_pipeline_ready(PipelineHandle pipelineHandle);
+		// Results of tune_compute_workgroup_size(), see m_tunedWorkgroupSizes.
+		bool find_tuned_workgroup_size(std::uint32_t& outWorkgroupSize, std::size_t key);
+		void set_tuned_workgroup_size(std::size_t key, std::uint32_t workgroupSize);
 
 		bool create_descriptor_set(DescriptorSetHandle& outDescriptorSetHandle, const DescriptorSetInfo& setInfo);
+		bool create_transient_descriptor_set(DescriptorSetHandle& outDescriptorSetHandle, const DescriptorSetInfo& setInfo);
+		bool get_cached_descriptor_set(DescriptorSetHandle& outDescriptorSetHandle, const DescriptorSetInfo& setInfo, std::span<const DescriptorWrite> writes);
+		void destroy_descriptor_set(DescriptorSetHandle descriptorSetHandle);
 		bool create_descriptor_set_from_pipeline(DescriptorSetHandle& outDescriptorSetHandle, PipelineHandle pipelineHandle, std::uint32_t set);
 		bool get_descriptor_set(vk::DescriptorSet& outDescriptorSet, DescriptorSetHandle descriptorSetHandle);
-		void bind_buffer_to_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, BufferHandle bufferHandle);
-		void bind_texture_to_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, TextureHandle textureHandle, SamplerHandle samplerHandle);
+		bool get_descriptor_buffer_offset(vk::DeviceSize& outOffset, DescriptorSetHandle descriptorSetHandle);
+		/**
+		 * @brief bind_descriptor_sets() for sets stored in the descriptor buffer.
+		 */
+		void bind_descriptor_buffer_sets(CommandList& commandList, std::uint32_t firstSet, std::span<const DescriptorSetHandle> descriptorSets, std::span<const std::uint32_t> dynamicOffsets);
+		/**
+		 * @brief Resolve the writes against the push set of the command list's bound pipeline, and record them.
+		 */
+		void push_descriptors(CommandList& commandList, std::uint32_t set, std::span<const DescriptorWrite> writes);
+		auto get_descriptor_set_layout_binding_types(vk::DescriptorSetLayout descriptorSetLayout) -> std::vector<vk::DescriptorType>;
+		void bind_buffer_to_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t range);
+		void bind_texture_to_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, TextureHandle textureHandle, SamplerHandle samplerHandle, std::uint32_t viewIndex = 0);
+		void update_descriptor_set(DescriptorSetHandle descriptorSetHandle, std::span<const DescriptorWrite> writes);
+		void write_inline_uniform_block(DescriptorSetHandle descriptorSetHandle, std::uint32_t binding, std::uint32_t offset, std::uint32_t size, const void* data);
+
+		auto get_bindless_heap() const -> DescriptorSetHandle { return m_bindlessHeapHandle; }
+		auto get_bindless_index(std::uint32_t binding, ResourceHandle resourceHandle) -> std::uint32_t;
 
 		bool create_buffer(BufferHandle& outBufferHandle, const BufferInfo& bufferInfo);
+		bool create_buffers(std::span<BufferHandle> outBufferHandles, std::span<const BufferInfo> bufferInfos);
 		void destroy_buffer(BufferHandle bufferHandle);
 		bool get_buffer(Buffer*& outBuffer, BufferHandle bufferHandle);
+
+		bool create_buffer_arena(BufferArenaHandle& outBufferArenaHandle, const BufferArenaInfo& bufferArenaInfo);
+		void destroy_buffer_arena(BufferArenaHandle bufferArenaHandle);
+		bool get_buffer_arena(BufferArena*& outBufferArena, BufferArenaHandle bufferArenaHandle);
+
+		bool create_memory_heap(MemoryHeapHandle& outMemoryHeapHandle, const MemoryHeapInfo& memoryHeapInfo);
+		void destroy_memory_heap(MemoryHeapHandle memoryHeapHandle);
+		bool get_memory_heap(MemoryHeap*& outMemoryHeap, MemoryHeapHandle memoryHeapHandle);
+		bool get_placement_requirements(PlacementRequirements& outRequirements, const BufferInfo& bufferInfo);
+		bool get_placement_requirements(PlacementRequirements& outRequirements, const TextureInfo& textureInfo);
+		bool create_buffer_placed(BufferHandle& outBufferHandle, MemoryHeapHandle memoryHeapHandle, std::uint64_t offset, const BufferInfo& bufferInfo);
+		bool create_texture_placed(TextureHandle& outTextureHandle, MemoryHeapHandle memoryHeapHandle, std::uint64_t offset, const TextureInfo& textureInfo);
+
+		/**
+		 * @brief Exported and imported resources are aliased ones, bound to memory allocated outside VMA and dedicated to them.
+		 * @param importedMemory The memory to import, or null to allocate exportable memory.
+		 */
+		bool create_buffer_external(BufferHandle& outBufferHandle, const BufferInfo& bufferInfo, const ExternalMemory* importedMemory);
+		bool create_texture_external(TextureHandle& outTextureHandle, const TextureInfo& textureInfo, const ExternalMemory* importedMemory);
+		bool export_buffer_memory(ExternalMemory& outMemory, BufferHandle bufferHandle);
+		bool export_texture_memory(ExternalMemory& outMemory, TextureHandle textureHandle);
+		bool export_queue_timeline(ExternalHandle& outHandle, std::uint32_t queueIndex);
+		bool import_semaphore(SemaphoreHandle& outSemaphoreHandle, ExternalHandle handle);
+		bool create_video_decoder(VideoDecoderHandle& outVideoDecoderHandle, const VideoDecoderInfo& decoderInfo);
+		void destroy_video_decoder(VideoDecoderHandle videoDecoderHandle);
+		bool get_video_decoder(VideoDecoder*& outVideoDecoder, VideoDecoderHandle videoDecoderHandle);
 		bool map_buffer(BufferHandle bufferHandle, void*& outBufferPtr);
 		void unmap_buffer(BufferHandle bufferHandle);
+		auto upload_buffer(BufferHandle bufferHandle, const void* data, std::uint64_t size, std::uint64_t offset, std::uint32_t queueIndex) -> SyncPoint;
+		auto upload_texture(TextureHandle textureHandle, const void* data, std::uint64_t size, std::uint32_t queueIndex) -> SyncPoint;
+		auto get_mapped_pointer(BufferHandle bufferHandle) -> void*;
+		auto get_buffer_device_address(BufferHandle bufferHandle) -> std::uint64_t;
+
+		auto read_buffer(CommandList& commandList, BufferHandle srcBufferHandle, BufferHandle dstBufferHandle, const BufferCopyRegion& region) -> ReadbackHandle;
+		bool resolve_readback(ReadbackHandle readbackHandle, const void*& outData, std::uint64_t timeoutNs);
+		void destroy_readback(ReadbackHandle readbackHandle);
+
+		bool create_acceleration_structure(AccelerationStructureHandle& outAccelerationStructureHandle, const AccelerationStructureInfo& accelerationStructureInfo);
+		void destroy_acceleration_structure(AccelerationStructureHandle accelerationStructureHandle);
+		auto get_acceleration_structure_device_address(AccelerationStructureHandle accelerationStructureHandle) -> std::uint64_t;
+		/**
+		 * @brief See gfx::build_acceleration_structures(). Compacts the bottom levels whose compacted sizes are known first.
+		 */
+		void build_acceleration_structures(CommandList& commandList, std::span<const AccelerationStructureBuild> builds);
+
+		auto get_sparse_page_size(BufferHandle bufferHandle) -> std::uint64_t;
+		bool get_sparse_texture_properties(SparseTextureProperties& outProperties, TextureHandle textureHandle);
+		auto bind_sparse_buffer_pages(BufferHandle bufferHandle, std::uint32_t queueIndex, std::span<const SparseBufferBind> binds, std::span<const SyncPoint> waitSyncPoints) -> SyncPoint;
+		auto bind_sparse_texture_tiles(TextureHandle textureHandle, std::uint32_t queueIndex, std::span<const SparseTextureBind> binds, std::span<const SyncPoint> waitSyncPoints) -> SyncPoint;
+		void flush_buffer_range(BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t size);
+		void invalidate_buffer_range(BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t size);
+		/**
+		 * @return nullptr unless DeviceInfo::uploadBufferSize was set.
+		 */
+		auto get_upload_manager() const -> UploadManager* { return m_uploadManager.get(); }
+
+		auto get_defragmenter() -> Defragmenter& { return *m_defragmenter; }
+		void get_memory_stats(MemoryStats& outMemoryStats) const;
+		bool dump_memory_report(std::string_view path);
+		bool set_memory_priority(BufferHandle bufferHandle, float memoryPriority);
+		bool set_memory_priority(TextureHandle textureHandle, float memoryPriority);
+		void get_gpu_scope_timings(GpuScopeTimings& outTimings);
+
+		/**
+		 * @brief Take a scope from the current frame's query pool and write its begin timestamp, or just track the nesting
+		 * when it cannot be timed.
+		 */
+		void begin_gpu_scope(CommandList& commandList, std::string_view name);
+		void end_gpu_scope(CommandList& commandList);
+		void get_gpu_query_results(GpuQueryResults& outResults);
+		void begin_gpu_query(CommandList& commandList, GpuQueryType type, std::string_view name);
+		void end_gpu_query(CommandList& commandList, GpuQueryType type);
+		void get_frame_stats(FrameStats& outStats);
+		/**
+		 * @brief Add the counts to the current frame's and zero them, for command lists handing over what they recorded.
+		 */
+		void add_frame_stats(FrameStats& stats);
+		auto get_current_frame_stats() -> FrameStats& { return m_currentFrameStats; }
+		bool begin_capture(std::string_view path);
+		bool end_capture();
+		/**
+		 * @return nullptr unless a capture is being recorded.
+		 */
+		auto get_capture_writer() const -> CaptureWriter* { return m_captureWriter.get(); }
+		/**
+		 * @brief Record the current contents of part of a host visible buffer, mapping it if it has no persistent mapping.
+		 */
+		void capture_buffer_contents(BufferHandle bufferHandle, std::uint64_t offset, std::uint64_t size);
+		/**
+		 * @brief Record the contents of every persistently mapped buffer handed out during the capture, before a submission reads them.
+		 */
+		void capture_mapped_buffers();
+		/**
+		 * @brief Swap in a buffer bound to the new memory of a defragmentation move, keeping the handle.
+		 * Bundles recorded with the old buffer are invalidated, and descriptor sets it was bound to are rewritten.
+		 * @return False if the buffer no longer exists, buffer is not taken.
+		 */
+		bool replace_moved_buffer(BufferHandle bufferHandle, vk::Buffer buffer);
+		bool replace_moved_texture(TextureHandle textureHandle, vk::Image image);
 
 		bool create_texture(TextureHandle& outTextureHandle, const TextureInfo& textureInfo);
+		bool create_textures(std::span<TextureHandle> outTextureHandles, std::span<const TextureInfo> textureInfos);
+		bool create_aliased_textures(std::span<TextureHandle> outTextureHandles, std::span<const TextureInfo> textureInfos, std::span<const TextureLifetime> lifetimes);
 		bool create_texture(TextureHandle& outTextureHandle, vk::Image image, vk::Extent3D extent, vk::Format format);
+		/**
+		 * @brief Point an existing texture handle at another (swap chain) image. The old view is destroyed once the GPU is done with it.
+		 */
+		bool replace_texture_image(TextureHandle textureHandle, vk::Image image, vk::Extent3D extent, vk::Format format);
+		bool replace_texture(TextureHandle textureHandle, Texture&& texture);
 		void destroy_texture(TextureHandle textureHandle);
 		bool get_texture(Texture*& outTexture, TextureHandle textureHandle);
+		bool create_texture_view(TextureViewHandle& outTextureViewHandle, TextureHandle textureHandle, const TextureViewInfo& textureViewInfo);
+
+		bool create_streaming_texture(TextureHandle& outTextureHandle, const TextureInfo& textureInfo, std::uint32_t firstResidentMip);
+		auto get_texture_first_resident_mip(TextureHandle textureHandle) -> std::uint32_t;
+		auto stream_texture_mips(TextureHandle textureHandle, std::uint32_t firstResidentMip, std::span<const std::span<const std::byte>> levelData, std::uint32_t queueIndex) -> SyncPoint;
+		auto fit_texture_streaming_budget(std::span<TextureStreamingRequest> requests, float budgetFraction) -> std::uint64_t;
 
 		bool create_sampler(SamplerHandle& outSamplerHandle, const SamplerInfo& samplerInfo);
 		void destroy_sampler(SamplerHandle samplerHandle);
@@ -126,11 +2097,195 @@ namespace sm::gfx
 		void destroy_swap_chain(SwapChainHandle swapChainHandle);
 		bool get_swap_chain(SwapChain*& outSwapChain, SwapChainHandle swapChainHandle);
 
+		/**
+		 * @brief Resolve the attachment handles of a render pass to textures, checking their views can be rendered to.
+		 */
+		bool get_render_pass_attachments(InlineVector<Texture*, MAX_COLOR_ATTACHMENTS>& outColorAttachments, Texture*& outDepthAttachment, const RenderPassInfo& renderPassInfo);
+		// layerCount is the layers a multiview pass renders, 1 otherwise.
+		static bool is_attachment_view(const Texture* texture, std::uint32_t viewIndex, std::uint32_t layerCount);
+		bool get_render_pass_shading_rate_attachment(ShadingRateAttachment& outShadingRateAttachment, const RenderPassInfo& renderPassInfo);
+		/**
+		 * @brief Resolve the resolve attachment handles of a render pass, empty when it has none or one per color attachment.
+		 */
+		bool get_render_pass_resolve_attachments(InlineVector<Texture*, MAX_COLOR_ATTACHMENTS>& outResolveAttachments, std::span<Texture* const> colorAttachments, const RenderPassInfo& renderPassInfo);
+
 	private:
-		auto create_fence() -> FenceHandle;
 		auto create_semaphore() -> SemaphoreHandle;
+		/**
+		 * @brief Allocate memory dedicated to a buffer or an image, exportable or imported.
+		 * @return Null on failure, having reported why.
+		 */
+		auto allocate_external_memory(vk::Buffer buffer, vk::Image image, const vk::MemoryRequirements& requirements, const ExternalMemory* importedMemory) -> std::shared_ptr<AliasedMemory>;
+		bool export_memory(ExternalMemory& outMemory, const AliasedMemory* memory);
+
+		static constexpr std::uint32_t MAX_QUEUES = 8;
+		// The last submit value of each queue's timeline, indexed by queue index.
+		using QueueSubmitValues = std::array<std::uint64_t, MAX_QUEUES>;
+
+		auto get_queue_index(vk::Queue queue) const -> std::uint32_t;
+		auto get_submit_values() const -> QueueSubmitValues;
+		auto get_completed_submit_value(std::uint32_t queueIndex) const -> std::uint64_t;
+		bool are_submit_values_complete(const QueueSubmitValues& submitValues) const;
+		void wait_on_submit_values(const QueueSubmitValues& submitValues);
+		/**
+		 * @brief vk::Device::waitSemaphores(), giving up with eErrorDeviceLost once the device is marked lost.
+		 */
+		auto wait_semaphores(const vk::SemaphoreWaitInfo& waitInfo, std::uint64_t timeoutNs) const -> vk::Result;
+		/**
+		 * @brief Called when work whose submit value was already published fails to reach its queue. That value is never
+		 * signalled, so nothing more is submitted and waits fall back to the device going idle.
+		 */
+		void mark_device_lost();
+		bool is_device_lost() const { return m_deviceLost.load(std::memory_order_acquire); }
+		auto get_thread_command_pool(std::uint32_t queueFamily, bool transient) -> CommandPool&;
+		/**
+		 * @brief m_commandPoolMutex must be held.
+		 */
+		auto get_thread_command_pool_locked(std::uint32_t queueFamily, std::uint32_t frameIndex, bool transient) -> CommandPool&;
+		void reset_frame_command_pools(std::uint32_t frameIndex);
+		void reset_frame_descriptor_sets(std::uint32_t frameIndex);
+		/**
+		 * @brief Evict cached descriptor sets that went unused for too long, see get_cached_descriptor_set().
+		 */
+		void age_cached_descriptor_sets();
+		/**
+		 * @brief Evict cached descriptor sets with a write the predicate matches, eg. one referencing a resource being destroyed.
+		 */
+		void evict_cached_descriptor_sets(const std::function<bool(const DescriptorWrite&)>& references);
+		/**
+		 * @brief Allocate a persistent set, reusing the memory of a destroyed set of the same layout if there is one.
+		 * m_descriptorPoolMutex must be held.
+		 */
+		bool allocate_persistent_descriptor_set(vk::DescriptorSet& outDescriptorSet, vk::DeviceSize& outDescriptorBufferOffset, vk::DescriptorSetLayout descriptorSetLayout);
+
+		/**
+		 * @brief Invalidate every bundle that was recorded with the given resource (see get_resource_key()).
+		 */
+		void invalidate_bundles(std::uint64_t resourceKey);
+		/**
+		 * @brief Invalidate every bundle that was recorded with one of the texture's views, which push descriptors reference directly.
+		 */
+		void invalidate_texture_bundles(const Texture& texture);
+		/**
+		 * @brief Invalidate every bundle binding a descriptor set the resource is written to. Bundles track the sets they bind,
+		 * not what the sets point at.
+		 */
+		void invalidate_descriptor_set_bundles(ResourceHandle resourceHandle, bool isTexture);
+
+		/**
+		 * @brief Rewrite every descriptor set binding of a buffer or texture, after its Vulkan objects were replaced.
+		 * @param waitForGpu Wait for every submission so far first. Without, the caller ensures nothing in flight uses the sets.
+		 */
+		void rebind_descriptors(ResourceHandle resourceHandle, bool isTexture, bool waitForGpu = true);
+		/**
+		 * @brief Look up the buffer, or texture view and sampler, of a write to a binding of the given type.
+		 */
+		bool resolve_descriptor_write(ResolvedDescriptor& outDescriptor, const DescriptorWrite& write, vk::DescriptorType descriptorType);
+		/**
+		 * @brief Template writing element 0 of every binding of a layout from one ResolvedDescriptor per binding, created on first use.
+		 */
+		auto get_descriptor_update_template(vk::DescriptorSetLayout descriptorSetLayout) -> vk::DescriptorUpdateTemplate;
+		/**
+		 * @brief The info a buffer is created with, which with a descriptor buffer gives every buffer usable in descriptors a device address.
+		 */
+		auto get_device_buffer_info(const BufferInfo& bufferInfo) const -> BufferInfo;
+		/**
+		 * @brief Pipelines must know whether their sets are in a descriptor buffer.
+		 */
+		auto get_pipeline_create_flags() const -> vk::PipelineCreateFlags { return m_descriptorBuffer ? vk::PipelineCreateFlagBits::eDescriptorBufferEXT : vk::PipelineCreateFlags{}; }
+		// Graphics pipelines can also be used in passes with a shading rate attachment where the device supports them.
+		auto get_graphics_pipeline_create_flags() const -> vk::PipelineCreateFlags
+		{
+			return get_pipeline_create_flags() | (supports_shading_rate() ? vk::PipelineCreateFlagBits::eRenderingFragmentShadingRateAttachmentKHR : vk::PipelineCreateFlags{});
+		}
+
+		/**
+		 * @brief Tag a buffer's or texture's allocation for defragmentation and count it in the memory stats.
+		 */
+		void register_allocation(vma::Allocation allocation, ResourceHandle resourceHandle, bool isTexture);
+		void unregister_allocation(vma::Allocation allocation, bool isTexture);
+
+		// A submission built on the calling thread. The submit infos point into the other vectors, so it is shared rather than copied.
+		struct PendingSubmit
+		{
+			std::uint32_t queueIndex{ 0 };
+			std::vector<CommandList*> commandLists;
+			std::vector<CommandListHandle> fireAndForgetCommandLists;
+			std::vector<vk::CommandBufferSubmitInfo> commandBufferInfos; // Parallel to commandLists.
+			std::vector<vk::SemaphoreSubmitInfo> waitInfos;
+			std::vector<vk::SemaphoreSubmitInfo> signalInfos; // The queue's timeline is last.
+			std::vector<vk::SubmitInfo2> submitInfos;
+			std::vector<vk::LatencySubmissionPresentIdNV> latencyPresentIds; // Chained onto batches rendering to low latency swap chains.
+		};
+		auto prepare_submit(std::uint32_t queueIndex, std::span<const SubmitBatch> batches) -> std::shared_ptr<PendingSubmit>;
+		/**
+		 * @brief Hand the readbacks recorded on the command lists the sync point of the submission they are part of.
+		 */
+		void set_readback_sync_points(std::span<CommandList* const> commandLists, const SyncPoint& syncPoint);
+
+		struct PendingSparseBind
+		{
+			vk::Buffer buffer;
+			vk::Image image;
+			std::vector<vk::SparseMemoryBind> memoryBinds; // Of the buffer, or of the image's mip tails and metadata.
+			std::vector<vk::SparseImageMemoryBind> imageBinds;
+			SparseResidency* residency{ nullptr };
+			SparseResidency::PageChanges pageChanges; // Only kept once the bind has been made.
+			bool claimedMipTail{ false };
+			std::vector<vk::Semaphore> waitSemaphores;
+			std::vector<std::uint64_t> waitValues;
+		};
+		/**
+		 * @brief The requirements of a sparse texture's own aspect, or nullptr if it is not sparse.
+		 */
+		auto get_sparse_texture_requirements(const Texture& texture) const -> const vk::SparseImageMemoryRequirements*;
+		bool supports_sparse_texture(const TextureInfo& textureInfo) const;
+		/**
+		 * @brief The format a texture is created in: TextureInfo::format, or the RGBA format it is promoted to when the device
+		 * cannot sample optimally tiled images of an RGB one. Its data is still uploaded as RGB and widened while staging.
+		 */
+		auto get_texture_format(const TextureInfo& textureInfo) const -> vk::Format;
+		/**
+		 * @brief Check a BufferInfo against the device's features, reporting the first one it needs but lacks.
+		 */
+		bool validate_buffer_info(const BufferInfo& bufferInfo) const;
+		bool validate_texture_info(const TextureInfo& textureInfo) const;
+		/**
+		 * @brief The filter generate_mipmaps() blits a format with, linear where the format supports it.
+		 * @return False if optimally tiled images of the format cannot be blitted at all.
+		 */
+		bool get_mipmap_filter(vk::Format format, vk::Filter& outFilter) const;
+		/**
+		 * @brief Whether optimally tiled images can be blitted between the formats with the filter.
+		 */
+		bool supports_blit(vk::Format srcFormat, vk::Format dstFormat, vk::Filter filter) const;
+		bool validate_sparse_bind(std::uint32_t queueIndex, std::span<const SyncPoint> waitSyncPoints) const;
+		/**
+		 * @brief Queue the binds on the queue's timeline, ordered with its submissions, and retire evicted memory after them.
+		 */
+		auto submit_sparse_bind(std::uint32_t queueIndex, std::shared_ptr<PendingSparseBind> pendingBind, std::span<const SyncPoint> waitSyncPoints) -> SyncPoint;
+		/**
+		 * @brief The queue's submit mutex must be held.
+		 */
+		bool execute_sparse_bind(std::uint32_t queueIndex, const PendingSparseBind& pendingBind, std::uint64_t signalValue);
+		/**
+		 * @brief Retire the memory a bind evicted once it has completed, or revert its residency changes if it failed.
+		 */
+		void finish_sparse_bind(const std::shared_ptr<PendingSparseBind>& pendingBind, bool bound);
+		/**
+		 * @brief Submit to the queue, signalling its timeline with submitValue. The queue's submit mutex must be held.
+		 */
+		bool execute_submit(PendingSubmit& pendingSubmit, std::uint64_t submitValue);
+		/**
+		 * @brief Block until the submission thread has run everything queued so far.
+		 */
+		void flush_submissions();
 
 		static auto get_descriptor_set_layout_binding(const DescriptorBindingInfo& descriptorBindingInfo) -> vk::DescriptorSetLayoutBinding;
+		/**
+		 * @brief Reprioritise the device memory of a dedicated allocation. False without pageable device local memory.
+		 */
+		bool set_allocation_priority(vma::Allocation allocation, float memoryPriority);
 
 	private:
 		Context* m_context{ nullptr };
@@ -140,49 +2295,421 @@ namespace sm::gfx
 		vk::UniqueDevice m_device;
 		vma::UniqueAllocator m_allocator;
 
+		std::vector<vk::ExtensionProperties> m_availableExtensions;
+		bool m_multiDrawIndirectSupported{ false };
+		bool m_imageCubeArraySupported{ false };
+		float m_maxSamplerAnisotropy{ 0.0f }; // 0 without the samplerAnisotropy feature.
+		vk::SampleCountFlags m_colorSampleCounts{ vk::SampleCountFlagBits::e1 }; // Supported by color and depth attachments.
+		vk::SampleCountFlags m_depthSampleCounts{ vk::SampleCountFlagBits::e1 };
+		std::uint32_t m_maxVertexInputAttributeOffset{ 2047 }; // The minimums Vulkan guarantees.
+		std::uint32_t m_maxVertexInputBindingStride{ 2048 };
+		bool m_drawIndirectCountSupported{ false };
+		bool m_bufferDeviceAddressSupported{ false };
+		bool m_sparseBufferSupported{ false };	// sparseBinding and sparseResidencyBuffer
+		bool m_sparseTextureSupported{ false }; // sparseBinding and sparseResidencyImage2D
+		bool m_presentWaitSupported{ false };	// VK_KHR_present_id and VK_KHR_present_wait
+		bool m_displayTimingSupported{ false }; // VK_GOOGLE_display_timing
+		bool m_lowLatencySupported{ false };	// VK_NV_low_latency2
+		bool m_antiLagSupported{ false };		// VK_AMD_anti_lag
+		bool m_lazilyAllocatedMemorySupported{ false };
+		bool m_memoryBudgetSupported{ false }; // VK_EXT_memory_budget
+		bool m_memoryPrioritySupported{ false }; // VK_EXT_memory_priority
+		bool m_pageableMemorySupported{ false }; // VK_EXT_pageable_device_local_memory, priorities changeable after allocation
+		bool m_hostImageCopySupported{ false }; // VK_EXT_host_image_copy, able to write sampled textures in their read layout
+		bool m_bindlessSupported{ false };		// Descriptor indexing of update-after-bind, partially bound, runtime sized arrays
+		bool m_descriptorBufferSupported{ false }; // VK_EXT_descriptor_buffer, only enabled when DeviceInfo::descriptorBufferSize is set
+		bool m_pushDescriptorSupported{ false };   // VK_KHR_push_descriptor, also usable with the descriptor buffer if that is enabled
+		bool m_dynamicBlendStateSupported{ false }; // VK_EXT_extended_dynamic_state3 color blend enable, equation and write mask
+		bool m_graphicsPipelineLibrarySupported{ false }; // VK_EXT_graphics_pipeline_library with fast linking
+		bool m_meshShaderSupported{ false };			  // VK_EXT_mesh_shader with task and mesh shaders
+		bool m_vertexAttributeDivisorSupported{ false };  // VK_EXT_vertex_attribute_divisor with instance rate and zero divisors
+		bool m_shadingRateSupported{ false };			  // VK_KHR_fragment_shading_rate with pipeline and attachment rates
+		vk::Extent2D m_shadingRateTexelSize{};
+		bool m_conditionalRenderingSupported{ false };	  // VK_EXT_conditional_rendering, without inheritance by secondaries
+		bool m_rayQuerySupported{ false };				  // VK_KHR_acceleration_structure and VK_KHR_ray_query, only enabled when asked for
+		bool m_localReadSupported{ false };				  // VK_KHR_dynamic_rendering_local_read
+		bool m_externalMemorySupported{ false };		  // VK_KHR_external_memory_fd and _semaphore_fd (_win32 on Windows), only enabled when asked for
+		bool m_videoDecodeSupported{ false };			  // VK_KHR_video_decode_queue and at least one codec, only enabled when asked for
+		std::uint64_t m_accelerationStructureScratchAlignment{ 0 };
+		bool m_shaderObjectsEnabled{ false };			  // VK_EXT_shader_object, only enabled when DeviceInfo::shaderObjects is set
+		bool m_calibratedTimestampsSupported{ false };	  // VK_EXT_calibrated_timestamps, with the device and m_hostTimeDomain domains
+		std::uint32_t m_enabledFeatures{ 0 }; // DeviceFeatureFlags_
+		std::vector<vk::PhysicalDevice> m_deviceGroupPhysicalDevices; // m_physicalDevice alone without DeviceInfo::deviceGroup.
+		DeviceProperties m_properties;
+
 		std::vector<std::uint32_t> m_queueFlags;
 		std::vector<std::uint32_t> m_queueFamilies;
 		std::vector<vk::Queue> m_queues;
-		std::unordered_map<std::uint32_t, vk::UniqueCommandPool> m_queueFamilyCommandPoolMap;
-
-		vk::UniqueDescriptorPool m_descriptorPool;
-
-		std::unordered_map<ResourceHandle, vk::UniqueFence> m_fenceMap;
-		std::uint32_t m_nextFenceId{ 1 };
-		std::unordered_map<ResourceHandle, vk::UniqueSemaphore> m_semaphoreMap;
-		std::uint32_t m_nextSemaphoreId{ 1 };
-
-		std::unordered_map<ResourceHandle, std::unique_ptr<CommandList>> m_commandListMap;
-		std::uint32_t m_nextCommandListId{ 1 };
-
-		std::unordered_map<std::size_t, vk::UniqueDescriptorSetLayout> m_descriptorSetLayoutMap;
 
-		std::unordered_map<ResourceHandle, std::unique_ptr<Pipeline>> m_pipelineMap;
-		std::uint32_t m_nextPipelineId{ 1 };
-
-		std::unordered_map<ResourceHandle, vk::UniqueDescriptorSet> m_descriptorSetMap;
-		std::uint32_t m_nextDescriptorSetId{ 1 };
-
-		std::unordered_map<ResourceHandle, std::unique_ptr<Buffer>> m_bufferMap;
-		std::uint32_t m_nextBufferId{ 1 };
-
-		std::unordered_map<ResourceHandle, std::unique_ptr<Texture>> m_textureMap;
-		std::uint32_t m_nextTextureId{ 1 };
-
-		std::unordered_map<ResourceHandle, vk::UniqueSampler> m_samplerMap;
-		std::uint32_t m_nextSamplerId{ 1 };
+		// Command pools are created lazily per (recording thread, queue family, frame in flight).
+		struct CommandPoolKey
+		{
+			std::thread::id threadId;
+			std::uint32_t queueFamily;
+			std::uint32_t frameIndex;
+			bool transient;
+
+			bool operator==(const CommandPoolKey&) const = default;
+		};
+		struct CommandPoolKeyHash
+		{
+			auto operator()(const CommandPoolKey& key) const -> std::size_t
+			{
+				std::size_t seed = std::hash<std::thread::id>{}(key.threadId);
+				seed ^= std::hash<std::uint32_t>{}(key.queueFamily) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+				seed ^= std::hash<std::uint32_t>{}(key.frameIndex) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+				seed ^= std::hash<bool>{}(key.transient) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+				return seed;
+			}
+		};
+		std::unordered_map<CommandPoolKey, std::unique_ptr<CommandPool>, CommandPoolKeyHash> m_commandPools;
+		std::mutex m_commandPoolMutex;
+
+		std::uint32_t m_framesInFlight{ 2 };
+		std::atomic<std::uint32_t> m_frameIndex{ 0 };
+		bool m_frameEnded{ false }; // end_frame() already recorded the current frame's submit values.
+		std::uint32_t m_frameNumber{ 0 }; // Frames begun so far, VMA's frame index.
+		std::vector<QueueSubmitValues> m_frameSubmitValues;						 // Last submit values of each frame in flight.
+		std::vector<std::vector<CommandListHandle>> m_frameTransientCommandLists; // Guarded by m_commandPoolMutex.
+
+		// GPU scopes and queries, with query pools per frame in flight: a begin and end timestamp per scope, and one query per
+		// occlusion or pipeline statistics query. Each frame's are resolved and the pools reset (from the host) by the
+		// begin_frame() reusing it.
+		struct PendingGpuScope
+		{
+			std::string name;
+			std::uint32_t depth;
+			std::uint64_t timestampMask; // Of the valid bits of the command list's queue family.
+		};
+		struct PendingGpuQuery
+		{
+			std::string name;
+			GpuQueryType type;
+			std::uint32_t query; // In the pool of its type.
+		};
+		struct GpuQueryFrame
+		{
+			vk::UniqueQueryPool timestampPool;
+			vk::UniqueQueryPool occlusionPool;
+			vk::UniqueQueryPool statisticsPool;
+			std::vector<PendingGpuScope> scopes;
+			std::vector<PendingGpuQuery> queries;
+			std::array<std::uint32_t, 2> queryCounts{}; // By GpuQueryType.
+			std::uint32_t frameNumber{ 0 };
+		};
+		/**
+		 * @brief Read back the frame's queries, which its completed submissions have written, into m_gpuScopeTimings and m_gpuQueryResults.
+		 */
+		void resolve_gpu_queries(std::uint32_t frameIndex);
+		void create_gpu_query_frames();
+		std::uint32_t m_gpuScopesPerFrame{ 0 };
+		std::uint32_t m_gpuQueriesPerFrame{ 0 };
+		bool m_pipelineStatisticsSupported{ false };
+		bool m_occlusionQueryPreciseSupported{ false };
+		std::vector<GpuQueryFrame> m_gpuQueryFrames;
+		std::vector<std::uint32_t> m_timestampValidBits; // By queue family.
+		float m_timestampPeriod{ 1.0f };				 // Nanoseconds per tick.
+		vk::TimeDomainEXT m_hostTimeDomain{ vk::TimeDomainEXT::eClockMonotonic };
+		std::uint64_t m_hostTicksPerSecond{ 1'000'000'000 };
+		// Scratch for resolve_gpu_queries(), the values of each query followed by its availability.
+		std::vector<std::uint64_t> m_gpuScopeResults;
+		std::array<std::vector<std::uint64_t>, 2> m_gpuQueryReadbacks; // By GpuQueryType.
+		GpuScopeTimings m_gpuScopeTimings;
+		GpuQueryResults m_gpuQueryResults;
+		std::mutex m_gpuQueryMutex;
+#if GFX_TRACY_ENABLED
+		/**
+		 * @brief Hand the frame's resolved scopes to Tracy as GPU zones, nested by their depths. deviceNow is the device
+		 * timestamp calibrated against the host when the frame was resolved, which the Tracy context is created at.
+		 */
+		void emit_tracy_gpu_zones(const GpuQueryFrame& frame, std::uint64_t deviceNow);
+		std::optional<std::uint8_t> m_tracyContext;
+		std::uint16_t m_tracyQueryId{ 0 }; // Wraps, zones' times are sent with them so ids are never outstanding for long.
+#endif
 
-		std::unordered_map<ResourceHandle, std::unique_ptr<SwapChain>> m_swapChainMap;
-		std::uint32_t m_nextSwapChainId{ 1 };
+		// Counted with GFX_COUNT_SHARED_STAT() through the frame, then moved into m_frameStats by begin_frame().
+		FrameStats m_currentFrameStats{};
+		FrameStats m_frameStats{};
+		std::mutex m_frameStatsMutex;
+
+		DeviceInfo m_deviceInfo{}; // As created, e.g. for the header of captures.
+		std::unique_ptr<CaptureWriter> m_captureWriter;
+
+		// One persistently mapped buffer, split into a part per frame in flight for allocate_transient().
+		BufferHandle m_transientBufferHandle{};
+		std::byte* m_transientBufferPtr{ nullptr };
+		std::uint64_t m_transientFrameSize{ 0 };
+		std::atomic<std::uint64_t> m_transientHead{ 0 }; // Bytes used of the current frame's part.
+		std::uint64_t m_minUniformBufferOffsetAlignment{ 1 };
+
+		// Destroyed persistent sets are kept for reuse by their layout, as pools only free memory all at once. Each frame in flight's
+		// transient sets are reset by the begin_frame() reusing it.
+		std::unique_ptr<DescriptorAllocator> m_persistentDescriptorAllocator;
+		struct FreeDescriptorSet
+		{
+			vk::DescriptorSet set;
+			vk::DeviceSize descriptorBufferOffset;
+		};
+		std::unordered_map<std::uint64_t, std::vector<FreeDescriptorSet>> m_freeDescriptorSets; // Keyed by set layout. Guarded by m_descriptorPoolMutex.
+		std::vector<std::unique_ptr<DescriptorAllocator>> m_frameDescriptorAllocators;
+		std::vector<std::vector<DescriptorSetHandle>> m_frameTransientDescriptorSets; // Guarded by m_descriptorPoolMutex.
+		std::unique_ptr<DescriptorBuffer> m_descriptorBuffer; // Used instead of both kinds of allocator when set. Guarded by m_descriptorPoolMutex.
+
+		// Null without DeviceInfo::bindless*Count or descriptor indexing. Its set is in m_descriptorSetPool, so it binds like any other.
+		std::unique_ptr<BindlessHeap> m_bindlessHeap;
+		DescriptorSetHandle m_bindlessHeapHandle{};
+
+		// Each queue signals its own timeline with an incrementing value on every submission, so resource lifetimes can be tied to GPU progress.
+		struct QueueTimeline
+		{
+			vk::UniqueSemaphore semaphore;
+			std::atomic<std::uint64_t> submitValue{ 0 };
+			std::mutex* submitMutex{ nullptr }; // Held across incrementing submitValue and submitting, so signalled values are strictly increasing.
+		};
+		std::deque<QueueTimeline> m_queueTimelines;
+		// One per (queue family, index in family), as VkQueue access must be externally synchronised whichever queue index reaches it.
+		std::map<std::pair<std::uint32_t, std::uint32_t>, std::mutex> m_queueMutexes;
+
+		struct DeferredDestroy
+		{
+			QueueSubmitValues submitValues{};
+			std::function<void()> destroyFunc;
+		};
+		std::deque<DeferredDestroy> m_deferredDestroyQueue;
+		std::mutex m_deferredDestroyMutex;
+
+		// Descriptor pools must be externally synchronised.
+		std::mutex m_descriptorPoolMutex;
+
+		// Binary semaphores are recycled once retired. One that was signalled but never waited on cannot be reused, so it is destroyed instead.
+		struct PooledSemaphore
+		{
+			explicit PooledSemaphore(vk::UniqueSemaphore&& semaphore) : semaphore(std::move(semaphore)) {}
+
+			vk::UniqueSemaphore semaphore;
+			std::atomic<bool> signalPending{ false };
+		};
+		ResourcePool<PooledSemaphore> m_semaphorePool;
+		std::vector<vk::UniqueSemaphore> m_freeSemaphores;
+		std::mutex m_freeSemaphoreMutex;
+
+		ResourcePool<CommandList> m_commandListPool;
+
+		ResourcePool<Bundle> m_bundlePool;
+		std::vector<BundleHandle> m_bundles;
+		std::mutex m_bundleMutex;
+
+		// Set layouts by description, checked for equality as different descriptions may share a hash. Never destroyed before the device.
+		struct CachedDescriptorSetLayout
+		{
+			DescriptorSetInfo descriptorSetInfo;
+			vk::UniqueDescriptorSetLayout descriptorSetLayout;
+		};
+		std::unordered_multimap<std::size_t, CachedDescriptorSetLayout> m_descriptorSetLayoutCache;
+		// Descriptor type of each binding, keyed by set layout (see get_resource_key()).
+		std::unordered_map<std::uint64_t, std::vector<vk::DescriptorType>> m_descriptorSetLayoutBindingTypes;
+		std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> m_descriptorSetLayoutBindingCounts; // In bytes for inline uniform blocks.
+		std::unordered_set<std::uint64_t> m_pushDescriptorSetLayouts; // Which of them are push layouts, that sets cannot be allocated with.
+		std::unordered_map<std::uint64_t, vk::UniqueDescriptorUpdateTemplate> m_descriptorUpdateTemplates;
+		std::mutex m_descriptorSetLayoutMutex;
+
+		// Pipeline layouts by set layouts and constant range, shared by every pipeline with the same interface so that switching
+		// between them keeps bound sets. Never destroyed before the device.
+		struct CachedPipelineLayout
+		{
+			std::vector<vk::DescriptorSetLayout> setLayouts;
+			vk::PushConstantRange constantRange;
+			vk::UniquePipelineLayout pipelineLayout;
+		};
+		std::unordered_multimap<std::size_t, CachedPipelineLayout> m_pipelineLayoutCache;
+		std::mutex m_pipelineLayoutMutex;
+
+		// Shader modules by hash_shader_code() of their SPIR-V, shared by every pipeline using the same stage so that it is only
+		// parsed once. The hash alone is trusted, so archived code is never copied. Never destroyed before the device.
+		std::unordered_map<std::uint64_t, vk::UniqueShaderModule> m_shaderModuleCache;
+		std::mutex m_shaderModuleMutex;
+
+		// Graphics pipeline libraries by part, keyed by the pipeline info reduced to what that part is compiled from.
+		// Pipelines are linked from them and keep referencing them, so they are never destroyed before the device.
+		struct CachedPipelineLibrary
+		{
+			vk::GraphicsPipelineLibraryFlagBitsEXT part;
+			GraphicsPipelineInfo partInfo;
+			std::unique_ptr<GraphicsPipeline> library;
+		};
+		std::unordered_multimap<std::size_t, CachedPipelineLibrary> m_pipelineLibraryCache;
+		std::mutex m_pipelineLibraryMutex;
+
+		// Every pipeline is compiled through it. Vulkan synchronises it internally, so no lock is needed.
+		vk::UniquePipelineCache m_pipelineCache;
+		std::string m_pipelineCachePath; // Empty if it is not persisted.
+		std::unique_ptr<PipelineManifest> m_pipelineManifest; // Null unless DeviceInfo::pipelineManifestPath is set.
+
+		// Workgroup sizes found by tune_compute_workgroup_size(), by hash of the pipeline info, constant id and candidates.
+		std::unordered_map<std::size_t, std::uint32_t> m_tunedWorkgroupSizes;
+		std::mutex m_tunedWorkgroupSizesMutex;
+
+		// Sets of get_cached_descriptor_set() by layout and writes. Evicted sets are destroyed, so their memory is reused per layout.
+		struct CachedDescriptorSet
+		{
+			vk::DescriptorSetLayout layout;
+			std::vector<DescriptorWrite> writes;
+			DescriptorSetHandle descriptorSetHandle;
+			std::uint32_t unusedFrames{ 0 };
+		};
+		std::unordered_multimap<std::size_t, CachedDescriptorSet> m_descriptorSetCache;
+		std::mutex m_descriptorSetCacheMutex;
+
+		// Live samplers by description, shared by every create_sampler() of it until the last destroy_sampler().
+		struct CachedSampler
+		{
+			SamplerInfo samplerInfo;
+			SamplerHandle samplerHandle;
+			std::uint32_t refCount{ 0 };
+		};
+		std::unordered_multimap<std::size_t, CachedSampler> m_samplerCache;
+		std::mutex m_samplerCacheMutex;
+
+		ResourcePool<std::unique_ptr<Pipeline>> m_pipelinePool;
+
+		// Live pipelines by create info, shared by every identical create until the last destroy_pipeline().
+		struct SharedPipeline
+		{
+			SharedPipelineInfo pipelineInfo;
+			PipelineHandle pipelineHandle;
+			std::uint32_t refCount{ 0 };
+		};
+		std::unordered_multimap<std::size_t, SharedPipeline> m_sharedPipelines;
+		std::mutex m_sharedPipelineMutex;
+
+		struct DescriptorSet
+		{
+			vk::DescriptorSet set; // Owned by its allocator's pools.
+			std::vector<vk::DescriptorType> bindingTypes;
+			vk::DescriptorSetLayout layout{}; // With a descriptor buffer, set is null and the set is stored at descriptorBufferOffset.
+			vk::DeviceSize descriptorBufferOffset{ 0 };
+		};
+		ResourcePool<DescriptorSet> m_descriptorSetPool;
+
+		// What each descriptor set binding was last bound to, keyed by set, binding and array element, so a moved resource can be rebound.
+		struct DescriptorBinding
+		{
+			DescriptorSetHandle descriptorSetHandle{};
+			bool isTexture{ false };
+			DescriptorWrite write{};
+		};
+		std::unordered_map<std::uint64_t, DescriptorBinding> m_descriptorBindings;
+		std::mutex m_descriptorBindingMutex;
+
+		// The whole chain of each streaming texture, keyed by texture handle. The texture itself only holds the resident part.
+		struct StreamingTexture
+		{
+			TextureInfo textureInfo{}; // mipLevels resolved.
+			std::uint32_t firstResidentMip{ 0 };
+		};
+		/**
+		 * @brief Describes the texture holding the levels from firstResidentMip down.
+		 */
+		static auto get_resident_texture_info(const TextureInfo& textureInfo, std::uint32_t firstResidentMip) -> TextureInfo;
+		/**
+		 * @brief Bytes of the levels from firstResidentMip down, every layer.
+		 */
+		static auto get_resident_size(const TextureInfo& textureInfo, std::uint32_t firstResidentMip) -> std::uint64_t;
+		std::unordered_map<std::uint64_t, StreamingTexture> m_streamingTextures;
+		std::mutex m_streamingTextureMutex;
+		std::mutex m_textureViewMutex; // Serialises adding views, so the same view is never created twice.
+
+		ResourcePool<Buffer> m_bufferPool;
+		ResourcePool<BufferArena> m_bufferArenaPool;
+		ResourcePool<MemoryHeap> m_memoryHeapPool;
+		ResourcePool<VideoDecoder> m_videoDecoderPool;
+
+		struct Readback
+		{
+			BufferHandle dstBufferHandle{};
+			std::uint64_t offset{ 0 };
+			std::uint64_t size{ 0 };
+			SyncPoint syncPoint{};	// Only valid once submitted.
+			bool submitted{ false };
+		};
+		ResourcePool<Readback> m_readbackPool;
+		std::mutex m_readbackMutex; // Guards syncPoint and submitted, which are set by the submitting thread.
+
+		ResourcePool<Texture> m_texturePool;
+
+		/**
+		 * @brief Resolve a bottom level's geometry for a build, and its range, validating its buffers and format.
+		 */
+		bool get_acceleration_structure_geometry(vk::AccelerationStructureGeometryKHR& outGeometry, vk::AccelerationStructureBuildRangeInfoKHR& outRange, const AccelerationStructureGeometry& geometry);
+		/**
+		 * @brief Create a structure of a size from the build sizes, in a buffer shared by every queue family, so it can be built on
+		 * one queue and traced on another without ownership transfers.
+		 */
+		auto create_acceleration_structure_storage(vk::AccelerationStructureTypeKHR type, std::uint64_t size, std::string_view debugName) -> AccelerationStructureStorage;
+		/**
+		 * @brief Keep replaced storage alive until the next begin_frame(), by when the command lists still using it are submitted,
+		 * then destroy it once the GPU is done with it.
+		 */
+		void retire_acceleration_structure_storage(AccelerationStructureStorage&& storage);
+		// Called by begin_frame(), for the storage and cancelled compaction queries retired since the last.
+		void release_retired_acceleration_structures();
+		/**
+		 * @brief Copy the bottom levels whose compacted sizes have been written into storage of that size, and swap it in.
+		 * @param outMovedBottomLevels The bottom levels now at another address.
+		 */
+		void compact_acceleration_structures(CommandList& commandList, ScratchVector<ResourceHandle>& outMovedBottomLevels);
+		/**
+		 * @brief Stop waiting on a bottom level's compacted size, eg. as it is rebuilt. Its query is reused once no longer in flight.
+		 */
+		void cancel_acceleration_structure_compaction(AccelerationStructure& accelerationStructure, ResourceHandle resourceHandle);
+
+		ResourcePool<AccelerationStructure> m_accelerationStructurePool;
+		// Serialises recording builds with the compaction moving bottom levels, and reading their addresses.
+		std::mutex m_accelerationStructureMutex;
+		std::vector<ResourceHandle> m_topLevelAccelerationStructures; // Rebuilt when a bottom level they hold moves.
+		std::vector<ResourceHandle> m_compactingAccelerationStructures; // Bottom levels waiting on their compacted size.
+		vk::UniqueQueryPool m_compactionQueryPool;						// Of MAX_COMPACTING_ACCELERATION_STRUCTURES compacted size queries.
+		std::vector<std::uint32_t> m_freeCompactionQueries;
+		std::vector<AccelerationStructureStorage> m_retiredAccelerationStructureStorage;
+		std::vector<std::uint32_t> m_retiredCompactionQueries;
+		static constexpr std::uint32_t MAX_COMPACTING_ACCELERATION_STRUCTURES = 1024; // Builds past this are left uncompacted.
+
+		// Allocation totals of the live buffers and textures, see register_allocation().
+		std::atomic<std::uint64_t> m_bufferBytes{ 0 };
+		std::atomic<std::uint32_t> m_bufferCount{ 0 };
+		std::atomic<std::uint64_t> m_textureBytes{ 0 };
+		std::atomic<std::uint32_t> m_textureCount{ 0 };
+
+		ResourcePool<vk::UniqueSampler> m_samplerPool;
+
+		ResourcePool<SwapChain> m_swapChainPool;
+
+		// Created on first use, unless DeviceInfo::taskScheduler is given.
+		std::once_flag m_workerPoolOnce;
+		std::unique_ptr<WorkerPool> m_workerPool;
+		// Tasks of run_task() not finished yet. Waited for first in ~Device(), as they reference the resources above.
+		std::uint32_t m_pendingTasks{ 0 };
+		std::mutex m_pendingTasksMutex;
+		std::condition_variable m_pendingTasksCondition;
+
+		// Single thread that submits and presents in queue order, when DeviceInfo::threadedSubmission is set.
+		std::unique_ptr<WorkerPool> m_submissionThread;
+		std::atomic<bool> m_deviceLost{ false }; // See mark_device_lost().
+
+		std::unique_ptr<UploadManager> m_uploadManager;
+
+		// Destroyed before the pools, it may still have to complete a pass. Swap chains destroyed after it see it as null.
+		std::unique_ptr<Defragmenter> m_defragmenter;
 	};
 
 	class CommandList
 	{
 	public:
 		CommandList() = default;
-		explicit CommandList(vk::Device device, vk::CommandPool commandPool, vk::Queue queue);
+		explicit CommandList(CommandPool& commandPool, vk::Queue queue, vk::CommandBufferLevel level, std::uint32_t flags = 0);
+		explicit CommandList(CommandPool& commandPool, vk::Queue queue, vk::CommandBufferLevel level, vk::CommandBuffer transientCommandBuffer);
 		CommandList(CommandList&& other) noexcept;
-		~CommandList() = default;
+		~CommandList();
 
 		GFX_DISABLE_COPY(CommandList);
 
@@ -191,60 +2718,438 @@ namespace sm::gfx
 		void reset();
 
 		void begin();
-		void end();
-
-		void begin_render_pass(const std::vector<Texture*>& colorAttachmentTextures, Texture* depthAttachmentTexture, const std::array<float, 4>& clearColor);
+		/**
+		 * @brief Begin a secondary command list that continues a render pass with the given attachments.
+		 */
+		void begin_secondary(std::span<Texture* const> colorAttachmentTextures, Texture* depthAttachmentTexture, std::uint32_t viewMask = 0);
+		/**
+		 * @return False if the command buffer failed to end, and so cannot be submitted or executed.
+		 */
+		bool end();
+
+		/**
+		 * @param colorAttachmentViews Texture view index of each color attachment, empty for all default views.
+		 * @param renderArea Empty for the extent of the first color attachment, or else the depth attachment.
+		 */
+		void begin_render_pass(std::span<Texture* const> colorAttachmentTextures, Texture* depthAttachmentTexture, const std::array<float, 4>& clearColor, bool secondaryContents = false,
+							   std::span<const std::uint32_t> colorAttachmentViews = {}, std::uint32_t depthAttachmentView = 0, std::span<Texture* const> resolveAttachmentTextures = {},
+							   const AttachmentOps& attachmentOps = {}, const vk::Rect2D& renderArea = {}, std::uint32_t viewMask = 0, const ShadingRateAttachment& shadingRateAttachment = {});
 		void end_render_pass();
 
+		void execute_commands(std::span<const vk::CommandBuffer> secondaryCommandBuffers);
+
 		void set_viewport(float x, float y, float width, float height, float minDepth, float maxDepth);
 		void set_scissor(std::int32_t x, std::int32_t y, std::uint32_t width, std::uint32_t height);
 
+		void set_cull_mode(vk::CullModeFlags cullMode);
+		void set_front_face(vk::FrontFace frontFace);
+		void set_primitive_topology(vk::PrimitiveTopology topology, bool primitiveRestart);
+		void set_depth_state(bool depthTest, bool depthWrite, vk::CompareOp depthCompareOp);
+		void set_stencil_state(bool stencilTest, const vk::StencilOpState& stencilFront, const vk::StencilOpState& stencilBack);
+		void set_blend_states(std::uint32_t firstAttachment, std::span<const vk::PipelineColorBlendAttachmentState> blendStates);
+		void set_shading_rate(vk::Extent2D fragmentSize, const std::array<vk::FragmentShadingRateCombinerOpKHR, 2>& combinerOps);
+
+		void begin_conditional(Buffer* buffer, std::uint64_t offset, bool inverted);
+		void end_conditional();
+		/**
+		 * @brief Order the attachment writes so far before input attachment reads at the same pixel, see gfx::local_read_barrier().
+		 */
+		void local_read_barrier();
+
 		void bind_pipeline(Pipeline* pipeline);
-		void bind_descriptor_sets(std::uint32_t firstSet, const std::vector<vk::DescriptorSet>& descriptorSets);
+		void bind_shader_objects(const ShaderObjectPipeline& pipeline);
+		void bind_descriptor_sets(std::uint32_t firstSet, std::span<const vk::DescriptorSet> descriptorSets, std::span<const std::uint32_t> dynamicOffsets = {});
+		/**
+		 * @brief Write descriptors of a push set of the bound pipeline, see ResolvedDescriptor.
+		 */
+		void push_descriptors(std::uint32_t set, std::span<const ResolvedDescriptor> descriptors);
+		/**
+		 * @brief Bind sets stored in a descriptor buffer by their offsets into it. The buffer itself is bound on first use.
+		 */
+		void set_descriptor_buffer_offsets(std::uint32_t firstSet, std::span<const vk::DeviceSize> offsets, const vk::DescriptorBufferBindingInfoEXT& descriptorBuffer);
 		void set_constants(vk::ShaderStageFlags shaderStages, std::uint32_t offset, std::uint32_t size, const void* data);
 
 		void dispatch(std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ);
+		void dispatch_base(std::uint32_t baseGroupX, std::uint32_t baseGroupY, std::uint32_t baseGroupZ, std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ);
+		void dispatch_indirect(Buffer* buffer, std::uint64_t offset);
+		void set_device_mask(std::uint32_t deviceMask);
 
-		void bind_index_buffer(Buffer* buffer, vk::IndexType indexType);
-		void bind_vertex_buffer(std::uint32_t firstBinding, const std::vector<vk::Buffer>& buffers);
+		void bind_index_buffer(Buffer* buffer, vk::IndexType indexType, vk::DeviceSize offset = 0);
+		/**
+		 * @param offsets Empty, or one per buffer.
+		 */
+		void bind_vertex_buffer(std::uint32_t firstBinding, std::span<const vk::Buffer> buffers, std::span<const vk::DeviceSize> offsets = {});
 
 		void draw(std::uint32_t vertex_count, std::uint32_t instance_count, std::uint32_t first_vertex, std::uint32_t first_instance);
 		void draw_indexed(std::uint32_t index_count, std::uint32_t instance_count, std::uint32_t first_index, std::int32_t vertex_offset, std::uint32_t first_instance);
+		void draw_indirect(Buffer* buffer, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride);
+		void draw_indexed_indirect(Buffer* buffer, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride);
+		void draw_indexed_indirect_count(Buffer* buffer, std::uint64_t offset, Buffer* countBuffer, std::uint64_t countOffset, std::uint32_t maxDrawCount, std::uint32_t stride);
+		void draw_mesh_tasks(std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ);
+		void draw_mesh_tasks_indirect(Buffer* buffer, std::uint64_t offset, std::uint32_t drawCount, std::uint32_t stride);
+		void draw_mesh_tasks_indirect_count(Buffer* buffer, std::uint64_t offset, Buffer* countBuffer, std::uint64_t countOffset, std::uint32_t maxDrawCount, std::uint32_t stride);
 
 		void transition_texture(Texture* texture, TextureState oldState, TextureState newState);
-		void copy_buffer_to_texture(Buffer* buffer, Texture* texture);
+		/**
+		 * @brief Transition a subresource range from its tracked state, skipping subresources that need no barrier.
+		 * Tracking happens at record time, so command lists touching the same texture must be submitted in recording order.
+		 */
+		void transition_texture(Texture* texture, TextureState newState, std::uint32_t baseMipLevel = 0, std::uint32_t mipLevelCount = VK_REMAINING_MIP_LEVELS, std::uint32_t baseArrayLayer = 0, std::uint32_t arrayLayerCount = VK_REMAINING_ARRAY_LAYERS);
+		void acquire_aliased_texture(Texture* texture, TextureState newState);
+		/**
+		 * @brief Split a tracked transition of the whole texture into a vkCmdSetEvent2 here and a vkCmdWaitEvents2 at the end,
+		 * with the same barriers. Both halves are recorded outside render passes, and the texture is not used in between.
+		 */
+		void begin_texture_transition(Texture* texture, TextureState newState);
+		void end_texture_transition(Texture* texture);
+
+		void write_timestamp(vk::QueryPool queryPool, std::uint32_t query, vk::PipelineStageFlags2 stage);
+		/**
+		 * @brief The GPU scopes open on the command list, tracked at record time. An untimed scope has no query pool.
+		 */
+		struct GpuScopeQuery
+		{
+			vk::QueryPool queryPool;
+			std::uint32_t beginQuery;
+		};
+		void push_gpu_scope(const GpuScopeQuery& scope) { m_gpuScopes.push_back(scope); }
+		bool pop_gpu_scope(GpuScopeQuery& outScope);
+		auto get_gpu_scope_depth() const -> std::uint32_t { return std::uint32_t(m_gpuScopes.size()); }
+		/**
+		 * @brief The query of a type open on the command list, tracked at record time, as only one of each type can be active.
+		 * Its beginQuery is the query itself, an untracked one has no query pool.
+		 */
+		auto get_active_query(GpuQueryType type) -> std::optional<GpuScopeQuery>& { return m_activeQueries[std::size_t(type)]; }
+		void begin_query(vk::QueryPool queryPool, std::uint32_t query, vk::QueryControlFlags flags);
+		/**
+		 * @brief Begin a debug label, tracking the nesting at record time so end() can pop any left open.
+		 */
+		void push_marker(std::string_view name);
+		void pop_marker();
+		void begin_debug_label(std::string_view name);
+		void end_debug_label();
+		/**
+		 * @brief The commands counted since begin(), or since the Device last took them with add_frame_stats().
+		 */
+		auto get_frame_stats() -> FrameStats& { return m_stats; }
+		void end_query(vk::QueryPool queryPool, std::uint32_t query);
+		/**
+		 * @brief Copy one whole mip level, tightly packed from bufferOffset. The level must be in TextureState::eUploadDst.
+		 */
+		void copy_buffer_to_texture(Buffer* buffer, Texture* texture, std::uint64_t bufferOffset = 0, std::uint32_t mipLevel = 0);
+		/**
+		 * @brief Copy regions, already validated with validate_buffer_texture_copy_region().
+		 */
+		void copy_buffer_to_texture(Buffer* buffer, Texture* texture, std::span<const BufferTextureCopyRegion> regions);
+		/**
+		 * @brief Fill every mip level past the first by blitting each one down from the level above.
+		 * The levels are transitioned from their tracked states, and the whole texture ends in TextureState::eShaderRead.
+		 */
+		void generate_mipmaps(Texture* texture, vk::Filter filter);
+		// Transfers that write a buffer also queue a barrier, making the writes visible to every later command and the host.
+
+		void copy_buffer(Buffer* srcBuffer, Buffer* dstBuffer, std::span<const BufferCopyRegion> regions);
+		void copy_texture_to_buffer(Texture* texture, Buffer* buffer, std::span<const TextureCopyRegion> regions);
+		/**
+		 * @brief Copy, blit or resolve regions already validated, from TextureState::eCopySrc to TextureState::eUploadDst.
+		 */
+		void copy_texture(Texture* srcTexture, Texture* dstTexture, std::span<const TextureRegionCopy> regions);
+		void blit_texture(Texture* srcTexture, Texture* dstTexture, std::span<const TextureBlitRegion> regions, vk::Filter filter);
+		void resolve_texture(Texture* srcTexture, Texture* dstTexture, std::span<const TextureRegionCopy> regions);
+		/**
+		 * @brief Copy a plane of a video picture, in eTransferSrcOptimal, into a texture in TextureState::eUploadDst. Not deferrable.
+		 */
+		void copy_video_plane(vk::Image srcImage, vk::ImageAspectFlagBits srcPlane, std::uint32_t srcArrayLayer, Texture* dstTexture, vk::Extent2D extent);
+		void fill_buffer(Buffer* buffer, std::uint64_t offset, std::uint64_t size, std::uint32_t value);
+		void update_buffer(Buffer* buffer, std::uint64_t offset, std::uint64_t size, const void* data);
+		/**
+		 * @brief Copy the whole of a buffer, or of a texture in TextureState::eShaderRead, into its replacement at a defragmentation
+		 * move's destination. The replacement is left ready for the same use. Never recorded deferred.
+		 */
+		void move_buffer(Buffer* buffer, vk::Buffer dstBuffer);
+		void move_texture(Texture* texture, vk::Image dstImage);
+		/**
+		 * @brief Copy levels between textures of the same format and layers, from TextureState::eCopySrc to TextureState::eUploadDst.
+		 * Never recorded deferred.
+		 */
+		void copy_texture_levels(Texture* srcTexture, std::uint32_t srcBaseMipLevel, Texture* dstTexture, std::uint32_t dstBaseMipLevel, std::uint32_t mipLevelCount);
+		/**
+		 * @brief Record the release or acquire half of an ownership transfer. Within one family it is a plain transition on the release side.
+		 */
+		void transfer_texture_ownership(Texture* texture, const QueueOwnershipTransfer& transfer, TextureState oldState, TextureState newState);
+		void transfer_buffer_ownership(Buffer* buffer, const QueueOwnershipTransfer& transfer);
+		void buffer_barrier(Buffer* buffer, vk::PipelineStageFlags2 srcStages, vk::AccessFlags2 srcAccess, vk::PipelineStageFlags2 dstStages, vk::AccessFlags2 dstAccess, vk::DeviceSize offset, vk::DeviceSize size);
+		void memory_barrier(vk::PipelineStageFlags2 srcStages, vk::AccessFlags2 srcAccess, vk::PipelineStageFlags2 dstStages, vk::AccessFlags2 dstAccess);
+		/**
+		 * @brief Build acceleration structures in one command. Each build info's geometries are the next geometryCount of
+		 * geometries, and of buildRanges, so its pGeometries is ignored.
+		 */
+		void build_acceleration_structures(std::span<const vk::AccelerationStructureBuildGeometryInfoKHR> buildInfos, std::span<const vk::AccelerationStructureGeometryKHR> geometries,
+										   std::span<const vk::AccelerationStructureBuildRangeInfoKHR> buildRanges);
+		void copy_acceleration_structure(vk::AccelerationStructureKHR src, vk::AccelerationStructureKHR dst, vk::CopyAccelerationStructureModeKHR mode);
+		void write_acceleration_structure_size(vk::AccelerationStructureKHR accelerationStructure, vk::QueryPool queryPool, std::uint32_t query);
+
+		/**
+		 * @brief Readbacks recorded since begin(), resolved by the next submission. Handles into the device's readback pool.
+		 */
+		void add_readback(ResourceHandle readbackHandle) { m_readbacks.push_back(readbackHandle); }
+		auto get_readbacks() const -> std::span<const ResourceHandle> { return m_readbacks; }
+		void clear_readbacks() { m_readbacks.clear(); }
 
 		/* Getters */
 
 		auto get_queue() const -> vk::Queue { return m_queue; }
+		auto get_flags() const -> std::uint32_t { return m_flags; }
+		auto get_usage_flags() const -> vk::CommandBufferUsageFlags;
+		/**
+		 * @brief Whether the resource was referenced while recording. Only tracked with CommandListFlags_TrackResources.
+		 */
+		bool references_resource(std::uint64_t resourceKey) const;
+		auto is_secondary() const -> bool { return m_level == vk::CommandBufferLevel::eSecondary; }
+		auto is_transient() const -> bool { return m_commandPool != nullptr && m_commandPool->is_transient(); }
+		auto is_deferred() const -> bool { return m_flags & CommandListFlags_Deferred; }
+		auto get_queue_family() const -> std::uint32_t { return m_commandPool->get_queue_family(); }
 		auto get_command_buffer() const -> vk::CommandBuffer { return m_commandBuffer.get(); }
+		auto get_bound_pipeline() const -> Pipeline* { return m_boundPipeline; }
 
 		/* Operators */
 
 		auto operator=(CommandList&& rhs) noexcept -> CommandList&;
 
+		/**
+		 * @brief Translate the recorded command stream into a new command buffer allocated from commandPool.
+		 * Must be given a pool owned by the calling thread.
+		 */
+		void translate(CommandPool& commandPool);
+		/**
+		 * @brief Give up the command buffer of the last translation, and the pool it goes back to, as the GPU may still be
+		 * executing it when the next translation starts.
+		 */
+		auto take_command_buffer() -> std::pair<CommandPool*, vk::CommandBuffer>;
+		/**
+		 * @brief Block until a pending translation has finished, so the command buffer can be used.
+		 */
+		void wait_for_translation() const;
+
 	private:
-		vk::Device m_device;
-		vk::CommandPool m_commandPool;
+		/**
+		 * @brief Queue a barrier to be recorded with the next flush_barriers().
+		 * Barriers are flushed lazily before the next draw, dispatch, copy, render pass begin or end().
+		 */
+		void add_barrier(const vk::ImageMemoryBarrier2& barrier);
+		void add_barrier(const vk::BufferMemoryBarrier2& barrier);
+		void add_barrier(const vk::MemoryBarrier2& barrier);
+		void flush_barriers();
+		/**
+		 * @brief flush_barriers() before a transfer command. The write barriers of earlier transfers stay queued unless this
+		 * one reads or writes their buffers, so back-to-back copies into different buffers are not serialised.
+		 */
+		void flush_barriers_for_transfer(const Buffer* srcBuffer, const Buffer* dstBuffer);
+		// Make a transfer's writes to a range of the buffer visible to whatever its usage allows to consume them.
+		void add_transfer_write_barrier(Buffer* buffer, vk::DeviceSize offset, vk::DeviceSize size);
+
+		static auto get_texture_barrier(Texture* texture, TextureState oldState, TextureState newState, std::uint32_t baseMipLevel, std::uint32_t mipLevelCount, std::uint32_t baseArrayLayer, std::uint32_t arrayLayerCount) -> vk::ImageMemoryBarrier2;
+		/**
+		 * @brief Append the barriers taking a subresource range from its tracked states to newState, one per run of consecutive
+		 * mips sharing a state. Matching read-only states need none.
+		 */
+		static void get_tracked_texture_barriers(Texture* texture, TextureState newState, std::uint32_t baseMipLevel, std::uint32_t mipLevelCount, std::uint32_t baseArrayLayer, std::uint32_t arrayLayerCount, std::vector<vk::ImageMemoryBarrier2>& outBarriers);
+		/**
+		 * @brief Queue texture barriers already resolved against the tracked states, which the texture has been moved on from.
+		 * Deferred lists write them to the command stream, so translation never reads or writes the tracked states.
+		 */
+		void add_texture_barriers(Texture* texture, std::span<const vk::ImageMemoryBarrier2> barriers);
+		void add_ownership_barrier(const vk::ImageMemoryBarrier2& barrier);
+		void record_texture_transition_begin(Texture* texture, std::vector<vk::ImageMemoryBarrier2>&& barriers);
+		// Blit mip - 1 into mip, both already in the copy layouts.
+		void blit_mip_level(Texture* texture, std::uint32_t mip, vk::Filter filter);
+
+		/**
+		 * @brief An event for a split transition, reset after its wait, so reused by every recording of the command list.
+		 */
+		auto acquire_event() -> vk::Event;
+
+		/**
+		 * @brief Forget all shadowed state, so the next bind of each kind is always recorded.
+		 * Required whenever the command buffer state becomes undefined (begin, reset, execute_commands).
+		 */
+		void reset_bound_state();
+		/**
+		 * @brief Forget shadowed dynamic pipeline state, which a different graphics pipeline or shaders may have invalidated.
+		 */
+		void reset_dynamic_state();
+
+		static auto get_bind_point_index(const Pipeline& pipeline) -> std::size_t;
+
+		void track_resource(std::uint64_t resourceKey);
+
+		enum class PacketType : std::uint32_t
+		{
+			eBeginRenderPass,
+			eEndRenderPass,
+			eExecuteCommands,
+			eSetViewport,
+			eSetScissor,
+			eSetCullMode,
+			eSetFrontFace,
+			eSetPrimitiveTopology,
+			eSetDepthState,
+			eSetStencilState,
+			eSetBlendStates,
+			eSetShadingRate,
+			eBeginConditional,
+			eEndConditional,
+			eLocalReadBarrier,
+			eBindPipeline,
+			eBindDescriptorSets,
+			eSetDescriptorBufferOffsets,
+			ePushDescriptors,
+			eSetConstants,
+			eDispatch,
+			eDispatchBase,
+			eDispatchIndirect,
+			eSetDeviceMask,
+			eBindIndexBuffer,
+			eBindVertexBuffers,
+			eDraw,
+			eDrawIndexed,
+			eDrawIndirect,
+			eDrawIndexedIndirect,
+			eDrawIndexedIndirectCount,
+			eDrawMeshTasks,
+			eDrawMeshTasksIndirect,
+			eDrawMeshTasksIndirectCount,
+			eTextureBarriers,
+			eBeginTextureTransition,
+			eEndTextureTransition,
+			eWriteTimestamp,
+			eBeginQuery,
+			eEndQuery,
+			eBeginDebugLabel,
+			eEndDebugLabel,
+			eCopyBufferToTexture,
+			eCopyBufferToTextureRegions,
+			eBlitMipLevel,
+			eCopyBuffer,
+			eCopyTextureToBuffer,
+			eCopyTexture,
+			eBlitTexture,
+			eResolveTexture,
+			eFillBuffer,
+			eUpdateBuffer,
+			eTransferTextureOwnership,
+			eTransferBufferOwnership,
+			eBufferBarrier,
+			eMemoryBarrier,
+			eBuildAccelerationStructures,
+			eCopyAccelerationStructure,
+			eWriteAccelerationStructureSize,
+		};
+		struct PacketHeader
+		{
+			PacketType type;
+			std::uint32_t size; // Of the whole packet, including this header and any trailing data.
+		};
+
+		/**
+		 * @brief Whether commands go to the command stream rather than straight to Vulkan.
+		 */
+		bool is_recording_deferred() const { return is_deferred() && !m_translating; }
+
+		/**
+		 * @brief Append a packet of a trivially copyable payload, optionally followed by extraSize bytes of extraData.
+		 */
+		template <typename T>
+		void write_packet(PacketType type, const T& payload, const void* extraData = nullptr, std::size_t extraSize = 0);
+
+	private:
+		/**
+		 * @brief Shadow of the state last recorded into the command buffer, used to elide redundant binds.
+		 * Pipelines and descriptor sets are tracked per bind point (graphics, compute).
+		 */
+		struct BoundState
+		{
+			std::array<vk::Pipeline, 2> pipelines{};
+			std::array<vk::PipelineLayout, 2> pipelineLayouts{};
+			std::array<std::array<vk::DescriptorSet, MAX_BOUND_DESCRIPTOR_SETS>, 2> descriptorSets{};
+			vk::DeviceAddress descriptorBuffer{ 0 };
+
+			vk::Buffer indexBuffer{};
+			vk::DeviceSize indexBufferOffset{ 0 };
+			vk::IndexType indexType{ vk::IndexType::eUint16 };
+			std::array<vk::Buffer, MAX_VERTEX_BUFFER_BINDINGS> vertexBuffers{};
+			std::array<vk::DeviceSize, MAX_VERTEX_BUFFER_BINDINGS> vertexBufferOffsets{};
+
+			std::optional<vk::Viewport> viewport;
+			std::optional<vk::Rect2D> scissor;
+
+			vk::ShaderEXT vertexShader{}; // Of the bound ShaderObjectPipeline, identifying it.
+
+			// Dynamic pipeline state, forgotten whenever the graphics pipeline changes as one without it invalidates it.
+			std::optional<vk::CullModeFlags> cullMode;
+			std::optional<vk::FrontFace> frontFace;
+			std::optional<vk::PrimitiveTopology> topology;
+			std::optional<bool> primitiveRestart;
+			std::optional<bool> depthTest;
+			std::optional<bool> depthWrite;
+			std::optional<vk::CompareOp> depthCompareOp;
+		};
+
+		CommandPool* m_commandPool{ nullptr };
 		vk::Queue m_queue;
+		vk::CommandBufferLevel m_level{ vk::CommandBufferLevel::ePrimary };
+		std::uint32_t m_flags{ 0 };
 
 		vk::UniqueCommandBuffer m_commandBuffer;
 
 		bool m_hasBegun{ false };
 		Pipeline* m_boundPipeline{ nullptr };
+		BoundState m_boundState{};
+
+		std::unordered_set<std::uint64_t> m_referencedResources;
+		std::vector<ResourceHandle> m_readbacks;
+
+		// CommandListFlags_Deferred. The stream keeps its capacity between recordings, so steady-state recording does not allocate.
+		std::vector<std::byte> m_commandStream;
+		bool m_translating{ false };
+		std::atomic<bool> m_translationPending{ false };
+
+		std::vector<vk::ImageMemoryBarrier2> m_pendingImageBarriers;
+		std::vector<vk::BufferMemoryBarrier2> m_pendingBufferBarriers;
+		std::vector<vk::BufferMemoryBarrier2> m_pendingTransferWriteBarriers; // One per buffer, joined into the next flush.
+		std::optional<vk::MemoryBarrier2> m_pendingMemoryBarrier;
+		std::vector<vk::ImageMemoryBarrier2> m_trackedBarriers; // Scratch for the tracked transition_texture().
+
+		struct SplitTransition
+		{
+			Texture* texture;
+			vk::Event event; // Null when the texture needed no barrier.
+			std::vector<vk::ImageMemoryBarrier2> barriers;
+		};
+		std::vector<SplitTransition> m_splitTransitions; // Begun but not yet ended.
+		std::vector<vk::UniqueEvent> m_events;
+		std::uint32_t m_usedEventCount{ 0 };
+
+		std::vector<GpuScopeQuery> m_gpuScopes;
+		std::array<std::optional<GpuScopeQuery>, 2> m_activeQueries{}; // By GpuQueryType.
+		std::uint32_t m_markerDepth{ 0 };
+
+		FrameStats m_stats{}; // Only the command counts, kept unshared as a command list records on one thread.
 	};
 
 	enum class PipelineType
 	{
 		eCompute,
-		eGraphics
+		eGraphics,
+		eGraphicsShaderObjects, // A ShaderObjectPipeline, bound to the graphics bind point.
+		eMesh,					// A MeshPipeline, bound to the graphics bind point.
 	};
 
 	class Pipeline
 	{
 	public:
 		Pipeline() = default;
-		explicit Pipeline(PipelineType pipelineType, const std::vector<vk::DescriptorSetLayout>& setLayouts);
+		explicit Pipeline(PipelineType pipelineType, const std::vector<vk::DescriptorSetLayout>& setLayouts, vk::PipelineLayout layout);
 		Pipeline(Pipeline&& other) noexcept;
 		virtual ~Pipeline() = default;
 
@@ -254,28 +3159,62 @@ namespace sm::gfx
 
 		auto get_set_layouts() const -> const std::vector<vk::DescriptorSetLayout>& { return m_setLayouts; }
 		auto get_set_layout(std::uint32_t set) const -> vk::DescriptorSetLayout { return m_setLayouts.at(set); }
-		auto get_pipeline_layout() const -> vk::PipelineLayout { return m_layout.get(); }
-		auto get_pipeline() const -> vk::Pipeline { return m_pipeline.get(); }
+		auto get_pipeline_layout() const -> vk::PipelineLayout { return m_layout; }
+		auto get_pipeline() const -> vk::Pipeline { return m_optimized.load(std::memory_order_acquire) ? m_optimizedPipeline.get() : m_pipeline.get(); }
+		auto get_unoptimized_pipeline() const -> vk::Pipeline { return m_pipeline.get(); }
 		auto get_type() const -> PipelineType { return m_pipelineType; }
+		auto get_placeholder() const -> PipelineHandle { return m_placeholderHandle; }
+
+		// Asynchronous compilation
+
+		/**
+		 * @brief Mark a pipeline that has its layout but no pipeline yet, until complete() is called from another thread.
+		 */
+		void set_pending(PipelineHandle placeholderHandle);
+		/**
+		 * @brief Take the pipeline of one compiled with the same layout, after which is_ready() is true.
+		 */
+		void complete(Pipeline&& compiled);
+		auto is_ready() const -> bool { return m_ready.load(std::memory_order_acquire); }
+		void wait_until_ready() const { m_ready.wait(false, std::memory_order_acquire); }
+
+		// Link-time optimisation, of a pipeline fast-linked from libraries
+
+		/**
+		 * @brief Mark a usable pipeline as being optimised on another thread, until complete_optimization() is called.
+		 */
+		void set_optimizing() { m_optimizing.store(true, std::memory_order_relaxed); }
+		/**
+		 * @brief Bind the pipeline of an optimised link of the same libraries from now on. The fast-linked one is kept, as
+		 * command buffers may still use it.
+		 */
+		void complete_optimization(Pipeline&& optimized);
+		void wait_until_optimized() const { m_optimizing.wait(true, std::memory_order_acquire); }
 
 		/* Operators */
 
 		auto operator=(Pipeline&& rhs) noexcept -> Pipeline&;
 
 	protected:
-		vk::UniquePipelineLayout m_layout;
+		vk::PipelineLayout m_layout; // Owned by the device's pipeline layout cache.
 		vk::UniquePipeline m_pipeline;
 
 	private:
 		PipelineType m_pipelineType{};
 		std::vector<vk::DescriptorSetLayout> m_setLayouts;
+		std::atomic<bool> m_ready{ true }; // m_pipeline may only be read once set.
+		PipelineHandle m_placeholderHandle{};
+		vk::UniquePipeline m_optimizedPipeline;
+		std::atomic<bool> m_optimized{ false }; // m_optimizedPipeline may only be read once set.
+		std::atomic<bool> m_optimizing{ false };
 	};
 
 	class ComputePipeline final : public Pipeline
 	{
 	public:
 		ComputePipeline() = default;
-		ComputePipeline(vk::Device device, const std::vector<char>& shaderCode, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, vk::PushConstantRange constantRange);
+		ComputePipeline(vk::Device device, const ComputePipelineInfo& computePipelineInfo, vk::ShaderModule shaderModule,
+						const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, vk::PipelineLayout layout, vk::PipelineCache pipelineCache, vk::PipelineCreateFlags flags = {});
 		~ComputePipeline() override = default;
 
 	private:
@@ -285,18 +3224,82 @@ namespace sm::gfx
 	{
 	public:
 		GraphicsPipeline() = default;
-		GraphicsPipeline(vk::Device device, const GraphicsPipelineInfo& graphicsPipelineInfo, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, vk::PushConstantRange constantRange);
+		/**
+		 * @param libraryParts If set, compile only these parts as a library to link pipelines from.
+		 */
+		GraphicsPipeline(vk::Device device, const GraphicsPipelineInfo& graphicsPipelineInfo, vk::ShaderModule vertexModule, vk::ShaderModule fragmentModule,
+						 const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, vk::PipelineLayout layout, vk::PipelineCache pipelineCache, vk::PipelineCreateFlags flags = {},
+						 vk::GraphicsPipelineLibraryFlagsEXT libraryParts = {});
+		/**
+		 * @brief Link a complete pipeline from libraries, a fast link unless flags has vk::PipelineCreateFlagBits::eLinkTimeOptimizationEXT.
+		 */
+		GraphicsPipeline(vk::Device device, std::span<const vk::Pipeline> libraries, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, vk::PipelineLayout layout,
+						 vk::PipelineCache pipelineCache, vk::PipelineCreateFlags flags = {});
 		~GraphicsPipeline() override = default;
 
 	private:
 		vk::UniqueDescriptorSetLayout m_setLayout;
 	};
 
+	/**
+	 * @brief Graphics pipeline of task (optional), mesh and fragment shaders, with no vertex input or input assembly.
+	 */
+	class MeshPipeline final : public Pipeline
+	{
+	public:
+		MeshPipeline() = default;
+		MeshPipeline(vk::Device device, const MeshPipelineInfo& meshPipelineInfo, vk::ShaderModule taskModule, vk::ShaderModule meshModule, vk::ShaderModule fragmentModule,
+					 const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, vk::PipelineLayout layout, vk::PipelineCache pipelineCache, vk::PipelineCreateFlags flags = {});
+		~MeshPipeline() override = default;
+	};
+
+	/**
+	 * @brief Graphics pipeline made of VK_EXT_shader_object shaders, one per stage, and the state to draw them with.
+	 * There is no vk::Pipeline: binding it binds the shaders and sets all of the state dynamically.
+	 */
+	class ShaderObjectPipeline final : public Pipeline
+	{
+	public:
+		struct State
+		{
+			vk::ShaderEXT vertexShader;
+			vk::ShaderEXT fragmentShader;
+			std::vector<vk::VertexInputBindingDescription2EXT> vertexBindings;
+			std::vector<vk::VertexInputAttributeDescription2EXT> vertexAttributes;
+			vk::PrimitiveTopology topology;
+			vk::CullModeFlags cullMode;
+			vk::FrontFace frontFace;
+			bool depthTest;
+			bool depthWrite;
+			vk::CompareOp depthCompareOp;
+			bool stencilTest;
+			vk::StencilOpState stencilFront;
+			vk::StencilOpState stencilBack;
+			vk::SampleCountFlagBits sampleCount;
+			std::vector<vk::PipelineColorBlendAttachmentState> blendStates; // One per color attachment.
+			bool shadingRate; // The shading rate has to be set, as DeviceFeatureFlags_ShadingRate is enabled.
+		};
+
+		ShaderObjectPipeline(vk::Device device, const GraphicsPipelineInfo& graphicsPipelineInfo, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, vk::PipelineLayout layout,
+							 vk::PushConstantRange constantRange, bool shadingRate);
+		~ShaderObjectPipeline() override = default;
+
+		auto get_state() const -> const State& { return m_state; }
+
+	private:
+		std::vector<vk::UniqueShaderEXT> m_shaders;
+		State m_state{};
+	};
+
 	class Buffer
 	{
 	public:
 		Buffer() = default;
-		explicit Buffer(vk::Device device, vma::Allocator allocator, const BufferInfo& bufferInfo);
+		/**
+		 * @param aliased Create the buffer without memory, to be bound with bind_aliased_memory().
+		 * @param externalHandleTypes Handle types the memory of an aliased buffer is exported or imported with.
+		 */
+		explicit Buffer(vk::Device device, vma::Allocator allocator, const BufferInfo& bufferInfo, bool aliased = false, vk::ExternalMemoryHandleTypeFlags externalHandleTypes = {});
 		Buffer(Buffer&& other) noexcept;
 		~Buffer() = default;
 
@@ -310,6 +3313,43 @@ namespace sm::gfx
 		auto get_descriptor_type() const -> auto { return m_descriptorType; }
 		auto get_descriptor_info() const -> const vk::DescriptorBufferInfo& { return m_descriptorInfo; }
 
+		auto get_size() const -> std::uint64_t { return m_size; }
+		auto get_memory() const -> BufferMemory { return m_memory; }
+		bool is_host_visible() const { return m_hostVisible; }
+		/**
+		 * @brief The persistent mapping, or nullptr for eGpuOnly buffers, which are mapped on demand if host visible.
+		 */
+		auto get_mapped_pointer() const -> void* { return m_mappedPtr; }
+		/**
+		 * @brief 0 unless created with BufferInfo::deviceAddress.
+		 */
+		auto get_device_address() const -> std::uint64_t { return m_deviceAddress; }
+		// The allocation owns its device memory, so its priority can change without affecting other resources.
+		bool has_dedicated_memory() const { return m_dedicatedMemory; }
+		// Wraps a swap chain image, whose layout transitions must wait on the acquire semaphore's stage.
+		bool is_swap_chain_image() const { return m_swapChainImage; }
+		/**
+		 * @brief Resident pages of a BufferInfo::sparse buffer, otherwise null.
+		 */
+		auto get_sparse_residency() const -> SparseResidency* { return m_sparse.get(); }
+
+		auto get_usage_flags() const -> vk::BufferUsageFlags { return m_usageFlags; }
+		/**
+		 * @brief Describes an identical buffer, eg. to recreate it at the new location of a defragmentation move.
+		 */
+		auto get_buffer_create_info() const -> vk::BufferCreateInfo;
+		/**
+		 * @brief Swap in a buffer bound to this buffer's allocation after it was moved.
+		 * @return The old buffer, which the caller destroys once the GPU no longer uses it.
+		 */
+		auto replace_buffer(vk::Buffer buffer) -> vk::Buffer;
+		/**
+		 * @brief Bind an aliased buffer at offset in memory shared with other resources. Mapped heap memory maps the buffer too.
+		 */
+		bool bind_aliased_memory(std::shared_ptr<AliasedMemory> memory, vk::DeviceSize offset);
+		auto get_aliased_memory() const -> const AliasedMemory* { return m_aliasedMemory.get(); }
+		auto get_debug_name() const -> const std::string& { return m_debugName; }
+
 		/* Operators */
 
 		auto operator=(Buffer&& rhs) noexcept -> Buffer&;
@@ -318,11 +3358,65 @@ namespace sm::gfx
 		vk::Device m_device;
 		vma::Allocator m_allocator;
 
+		std::shared_ptr<AliasedMemory> m_aliasedMemory; // Instead of m_allocation for aliased buffers, outliving m_buffer.
 		vma::UniqueBuffer m_buffer;
 		vma::UniqueAllocation m_allocation;
 
 		vk::DescriptorType m_descriptorType;
 		vk::DescriptorBufferInfo m_descriptorInfo;
+
+		vk::BufferUsageFlags m_usageFlags;
+		std::uint64_t m_size{ 0 };
+		BufferMemory m_memory{ BufferMemory::eGpuOnly };
+		bool m_hostVisible{ false }; // Of the memory type VMA picked, eGpuOnly buffers may still end up host visible on UMA devices.
+		void* m_mappedPtr{ nullptr };
+		std::uint64_t m_deviceAddress{ 0 };
+		bool m_dedicatedMemory{ false };
+		bool m_aliased{ false };
+		std::unique_ptr<SparseResidency> m_sparse;
+		std::string m_debugName; // Given again to the buffers of defragmentation moves.
+	};
+
+	/**
+	 * @brief A bottom or top level acceleration structure. Its storage is replaced when a build needs more than it has, or by
+	 * a compacted copy, which moves it to another address.
+	 */
+	class AccelerationStructure
+	{
+	public:
+		static constexpr std::uint32_t NO_QUERY = ~0u;
+
+		explicit AccelerationStructure(const AccelerationStructureInfo& info, AccelerationStructureStorage&& storage) : m_info(info), m_storage(std::move(storage)) {}
+		~AccelerationStructure() = default;
+
+		GFX_DISABLE_COPY(AccelerationStructure);
+
+		/* Getters */
+
+		auto get_info() const -> const AccelerationStructureInfo& { return m_info; }
+		bool is_top_level() const { return m_info.type == AccelerationStructureType::eTopLevel; }
+		auto get_acceleration_structure() const -> vk::AccelerationStructureKHR { return m_storage.accelerationStructure.get(); }
+		auto get_size() const -> std::uint64_t { return m_storage.size; }
+		auto get_device_address() const -> std::uint64_t { return m_storage.deviceAddress; }
+		/**
+		 * @brief What every build of it uses, as updates and compaction need those of the build they start from.
+		 */
+		auto get_build_flags() const -> vk::BuildAccelerationStructureFlagsKHR;
+		bool is_compacted_after_build() const { return !is_top_level() && m_info.compact && !m_info.allowUpdate; }
+
+		/**
+		 * @return The old storage, which the caller keeps alive until the GPU no longer uses it.
+		 */
+		auto replace_storage(AccelerationStructureStorage&& storage) -> AccelerationStructureStorage { return std::exchange(m_storage, std::move(storage)); }
+
+		// Primitives per geometry of the last build, or the instance count of a top level. Updates have to match them.
+		std::vector<std::uint32_t> m_primitiveCounts;
+		std::vector<AccelerationStructureInstance> m_instances; // Of the last build of a top level.
+		std::uint32_t m_compactionQuery{ NO_QUERY };				// Holds its compacted size once the build has run.
+
+	private:
+		AccelerationStructureInfo m_info;
+		AccelerationStructureStorage m_storage;
 	};
 
 	// #TODO: Proper view system.
@@ -330,7 +3424,11 @@ namespace sm::gfx
 	{
 	public:
 		Texture() = default;
-		explicit Texture(Device& device, const TextureInfo& textureInfo);
+		/**
+		 * @param aliased Create the image without memory, to be bound with bind_aliased_memory().
+		 * @param externalHandleTypes Handle types the memory of an aliased image is exported or imported with.
+		 */
+		explicit Texture(Device& device, const TextureInfo& textureInfo, bool aliased = false, vk::ExternalMemoryHandleTypeFlags externalHandleTypes = {});
 		explicit Texture(Device& device, vk::Image image, vk::Extent3D extent, vk::Format format);
 		Texture(Texture&& other) noexcept;
 		~Texture();
@@ -344,30 +3442,130 @@ namespace sm::gfx
 
 		auto get_extent() const -> vk::Extent3D { return m_extent; }
 		auto get_format() const -> vk::Format { return m_format; }
-
-		auto get_layout() const -> vk::ImageLayout { return m_layout; }
-
-		auto get_view() const -> vk::ImageView { return m_view.get(); }
+		// The format texel data is uploaded in, TextureInfo::format. Narrower than get_format() if the device promoted it.
+		auto get_upload_format() const -> vk::Format { return m_uploadFormat; }
+		bool is_format_promoted() const { return m_uploadFormat != m_format; }
+		// Every aspect of the format, as barriers take.
+		auto get_aspect_mask() const -> vk::ImageAspectFlags { return m_aspectMask; }
+		// The single aspect copies, blits and sampled views use, depth for depth/stencil formats.
+		auto get_copy_aspect_mask() const -> vk::ImageAspectFlags
+		{
+			return (m_aspectMask & vk::ImageAspectFlagBits::eDepth) ? vk::ImageAspectFlagBits::eDepth : m_aspectMask;
+		}
+
+		auto get_mip_levels() const -> std::uint32_t { return m_mipLevels; }
+		auto get_array_layers() const -> std::uint32_t { return m_arrayLayers; }
+		auto get_sample_count() const -> vk::SampleCountFlagBits { return m_samples; }
+		/**
+		 * @brief Extent of a mip level, depth included for 3D textures.
+		 */
+		auto get_mip_extent(std::uint32_t mipLevel) const -> vk::Extent3D;
+		/**
+		 * @brief Bytes of a whole mip level tightly packed, every slice of every layer.
+		 */
+		auto get_level_size(std::uint32_t mipLevel) const -> std::uint64_t;
+		/**
+		 * @brief Bytes of a whole mip level in the upload format, as the upload functions take it.
+		 */
+		auto get_upload_level_size(std::uint32_t mipLevel) const -> std::uint64_t;
+
+		// Last state recorded for a subresource.
+		auto get_state(std::uint32_t mipLevel = 0, std::uint32_t arrayLayer = 0) const -> TextureState;
+		void set_state(TextureState state, std::uint32_t baseMipLevel, std::uint32_t mipLevelCount, std::uint32_t baseArrayLayer, std::uint32_t arrayLayerCount);
+
+		auto get_view() const -> vk::ImageView { return m_defaultView; }
+		// View 0 is the default view, the others come from find_or_add_view(). Null past the last view.
+		auto get_view(std::uint32_t viewIndex) const -> vk::ImageView;
+		auto get_view_count() const -> std::uint32_t { return 1 + std::uint32_t(m_customViews.size()); }
+		auto get_view_format(std::uint32_t viewIndex) const -> vk::Format;
+		auto get_view_range(std::uint32_t viewIndex) const -> vk::ImageSubresourceRange;
+		/**
+		 * @brief Index of the view with these parameters, creating it on first use. They must already be valid for this texture.
+		 */
+		auto find_or_add_view(vk::ImageViewType viewType, vk::Format format, const vk::ImageSubresourceRange& range) -> std::uint32_t;
+		/**
+		 * @brief Recreate another texture's custom views at the same indices, with their mip ranges clamped to this texture's.
+		 */
+		void copy_views(const Texture& other);
+		// Contents never leave the render pass, so they are not stored.
+		bool is_transient() const { return bool(m_usageFlags & vk::ImageUsageFlagBits::eTransientAttachment); }
+		auto get_usage_flags() const -> vk::ImageUsageFlags { return m_usageFlags; }
+		bool supports_host_copy() const { return bool(m_usageFlags & vk::ImageUsageFlagBits::eHostTransferEXT); }
+		/**
+		 * @brief Resident tiles of a TextureInfo::sparse texture, otherwise null.
+		 */
+		auto get_sparse_residency() const -> SparseResidency* { return m_sparse.get(); }
+		// See Buffer::has_dedicated_memory().
+		bool has_dedicated_memory() const { return m_dedicatedMemory; }
+
+		/**
+		 * @brief Describes an identical image, eg. to recreate it at the new location of a defragmentation move.
+		 */
+		auto get_image_create_info() const -> vk::ImageCreateInfo;
+		/**
+		 * @brief Swap in an image bound to this texture's allocation after it was moved, recreating the views.
+		 * @return The old image and views, which the caller destroys once the GPU no longer uses them.
+		 */
+		auto replace_image(vk::Image image) -> std::pair<vk::Image, std::vector<vk::UniqueImageView>>;
+		/**
+		 * @brief Bind an aliased texture's image at offset in memory shared with other textures, and create its views.
+		 */
+		bool bind_aliased_memory(std::shared_ptr<AliasedMemory> memory, vk::DeviceSize offset);
+		auto get_aliased_memory() const -> const AliasedMemory* { return m_aliasedMemory.get(); }
+		auto get_debug_name() const -> const std::string& { return m_debugName; }
 
 		/* Operators */
 
 		auto operator=(Texture&& rhs) noexcept -> Texture&;
 
 	private:
-		Device* m_device{ nullptr };
+		auto get_subresource_count() const -> std::uint32_t { return m_mipLevels * m_arrayLayers; }
+		void create_view();
+		auto get_default_view_range() const -> vk::ImageSubresourceRange;
+		auto make_view(vk::ImageViewType viewType, vk::Format format, const vk::ImageSubresourceRange& range) const -> vk::UniqueImageView;
+
+		struct CustomView
+		{
+			vk::ImageViewType viewType;
+			vk::Format format;
+			vk::ImageSubresourceRange range;
+			vk::UniqueImageView view;
+		};
 
-		vk::Image m_image;
-		vma::Allocation m_allocation;
+	private:
+		// Hot fields - everything barrier and render pass setup reads, packed into the first cache line.
+		// Textures are stored by value in the device's pool pages, so neighbouring textures are contiguous too.
 
+		vk::Image m_image;
+		vk::ImageView m_defaultView; // Non-owning copy of m_view.
 		vk::Extent3D m_extent;
-		std::uint32_t m_mipLevels;
 		vk::Format m_format;
+		vk::ImageAspectFlags m_aspectMask{ vk::ImageAspectFlagBits::eColor };
+		std::uint32_t m_mipLevels{ 1 };
+		std::uint32_t m_arrayLayers{ 1 };
+		TextureState m_state{ TextureState::eUndefined }; // Used instead of m_subresourceStates when there is a single subresource.
+		bool m_swapChainImage{ false };
+
+		// Cold fields
+
+		Device* m_device{ nullptr };
+		vma::Allocation m_allocation;
 		vk::ImageUsageFlags m_usageFlags;
-		vk::ImageType m_type;
+		vk::ImageType m_type{ vk::ImageType::e2D };
+		vk::ImageViewType m_viewType{ vk::ImageViewType::e2D };
+		vk::ImageCreateFlags m_createFlags; // Cube compatibility. Sparse flags come from m_sparse.
+		vk::SampleCountFlagBits m_samples{ vk::SampleCountFlagBits::e1 };
+		vk::Format m_uploadFormat; // m_format, unless Device::get_texture_format() promoted it.
 
-		vk::ImageLayout m_layout;
+		std::vector<TextureState> m_subresourceStates; // Indexed by arrayLayer * m_mipLevels + mipLevel.
 
 		vk::UniqueImageView m_view;
+		std::deque<CustomView> m_customViews; // View i + 1. A deque, so adding a view leaves the others in place.
+		std::unique_ptr<SparseResidency> m_sparse;
+		bool m_dedicatedMemory{ false };
+		bool m_aliased{ false };						// Owns its image but not its memory (m_aliasedMemory once bound).
+		std::shared_ptr<AliasedMemory> m_aliasedMemory; // Instead of m_allocation, for aliased textures.
+		std::string m_debugName;						// Given again to the images of defragmentation moves.
 	};
 
 	class SwapChain
@@ -381,15 +3579,67 @@ namespace sm::gfx
 		GFX_DISABLE_COPY(SwapChain);
 
 		void resize(std::int32_t width, std::uint32_t height);
-		void present(vk::Queue queue, vk::Semaphore waitSemaphore);
+		void present(vk::Queue queue, vk::Semaphore waitSemaphore, std::uint64_t presentId, std::uint64_t desiredPresentTimeNs);
+		/**
+		 * @brief Present several swap chains of the same device with a single vkQueuePresentKHR, then acquire their next images.
+		 * @param presentIds One per swap chain.
+		 */
+		static void present_batch(vk::Queue queue, std::span<SwapChain* const> swapChains, std::span<const std::uint64_t> presentIds, vk::Semaphore waitSemaphore, std::uint64_t desiredPresentTimeNs);
+		static constexpr std::uint32_t MAX_BATCHED_PRESENTS = 16;
+
+		/**
+		 * @brief Reserve the id of the next present. Called when the present is queued, which may be before it executes.
+		 * @param frameNumber The device's begin_frame() count, a swap chain is presented at most once per frame.
+		 */
+		auto next_present_id(std::uint32_t frameNumber) -> std::uint64_t;
+		auto get_upcoming_present_id() const -> std::uint64_t { return m_lastPresentId + 1; }
+
+		// Low latency mode, enabled when SwapChainInfo::lowLatency was set and the driver supports it.
+		bool is_latency_marking_enabled() const { return m_lowLatencyEnabled; }
+		void latency_sleep();
+		void set_latency_marker(LatencyMarker marker);
+		bool wait_for_present_id(std::uint64_t presentId, std::uint64_t timeoutNs);
+		bool get_present_timings(std::vector<PresentTiming>& outPresentTimings);
+		bool get_refresh_duration(std::uint64_t& outRefreshDurationNs);
+
+		void set_present_mode(PresentMode presentMode);
+		/**
+		 * @brief Resize at the next present, after the current image was presented.
+		 */
+		void request_resize(std::uint32_t width, std::uint32_t height);
+		/**
+		 * @brief Change the wanted image count at the next present, after the current image was presented.
+		 */
+		void request_image_count(std::uint32_t imageCount);
+		auto get_image_count() const -> std::uint32_t { return std::uint32_t(m_imageHandles.size()); }
 
 		/* Getters */
 
 		auto get_surface() const -> vk::SurfaceKHR { return m_surface.get(); }
 		auto get_swap_chain() const -> vk::SwapchainKHR { return m_swapChain.get(); }
 
+		bool is_headless() const { return m_headless; }
 		auto get_image_index() const -> std::uint32_t { return m_imageIndex; }
-		auto get_current_image_handle() const -> TextureHandle { return m_imageHandles.at(m_imageIndex); }
+		// Null while no image is held, eg. after an acquire failed or found the swap chain out of date.
+		auto get_current_image_handle() const -> TextureHandle
+		{
+			const bool held = m_headless || m_imageAcquired;
+			return held && m_imageIndex < m_imageHandles.size() ? m_imageHandles[m_imageIndex] : TextureHandle{};
+		}
+
+		/**
+		 * @brief The semaphore the current image's acquire signals, the first time it is asked for. Null afterwards.
+		 */
+		auto take_acquire_semaphore() -> vk::Semaphore;
+		/**
+		 * @brief The semaphore a submission rendering to the current image signals, present() will wait on it.
+		 */
+		auto signal_present_semaphore() -> vk::Semaphore;
+
+		// Presents queued on the submission thread. The current image is only known once the present has acquired the next one.
+		void begin_present();
+		void end_present();
+		void wait_for_present();
 
 		/* Operators */
 
@@ -397,20 +3647,58 @@ namespace sm::gfx
 
 	protected:
 		void cleanup();
-
-		void acquire_next_image_index();
+		/**
+		 * @brief Rebuild the swap chain with its current settings once the GPU is idle, then acquire a fresh image.
+		 * Semaphores that were signalled but never waited on are replaced, as they cannot be signalled again.
+		 */
+		void recreate();
+		/**
+		 * @brief (Re)create the offscreen images of a headless swap chain, reusing their handles.
+		 */
+		void resize_headless(std::uint32_t width, std::uint32_t height);
+
+		void set_latency_marker(vk::LatencyMarkerNV marker, std::uint64_t presentId);
+		void update_anti_lag(vk::AntiLagStageAMD stage, std::uint64_t presentId);
+
+		/**
+		 * @brief Acquire the next image without blocking the CPU, the GPU waits on the acquire semaphore instead.
+		 * On failure no image is held and no semaphore is pending, so nothing waits on a semaphore that never signals.
+		 */
+		bool acquire_next_image_index();
 
 	private:
 		Device* m_device{ nullptr };
 
 		vk::UniqueSurfaceKHR m_surface;
 		vk::UniqueSwapchainKHR m_swapChain;
+		bool m_headless{ false }; // No surface or swap chain, the images are plain textures.
 
 		vk::Extent2D m_extent;
-		bool m_vsyncEnabled{};
+		vk::Extent2D m_requestedExtent;
+		bool m_recreatePending{ false }; // Out of date, suboptimal or resized. Rebuilt after the next present.
+		PresentMode m_presentMode{ PresentMode::eFifo };
+		std::uint32_t m_desiredImageCount{ 0 };
 
 		std::uint32_t m_imageIndex{};
-		vk::UniqueFence m_fence;
+		bool m_imageAcquired{ false };
+		std::uint64_t m_lastPresentId{ 0 };
+		std::uint32_t m_lastPresentFrameNumber{ ~0u };
+
+		bool m_lowLatencyRequested{ false };
+		bool m_lowLatencyEnabled{ false }; // VK_NV_low_latency2
+		bool m_antiLagEnabled{ false };	   // VK_AMD_anti_lag
+		vk::UniqueSemaphore m_latencySleepSemaphore;
+		std::uint64_t m_latencySleepValue{ 0 };
+
+		std::vector<vk::UniqueSemaphore> m_acquireSemaphores;
+		std::uint32_t m_acquireSemaphoreIndex{};
+		vk::Semaphore m_pendingAcquireSemaphore{};			 // Signalled by the last acquire and not yet waited on.
+		std::vector<vk::UniqueSemaphore> m_presentSemaphores; // One per image.
+		bool m_presentSemaphorePending{};
+
+		std::mutex m_presentMutex;
+		std::condition_variable m_presentCondition;
+		bool m_presentPending{ false };
 
 		std::vector<TextureHandle> m_imageHandles;
 	};
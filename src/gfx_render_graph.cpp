@@ -4,30 +4,80 @@
 
 #include "gfx/gfx_render_graph.hpp"
 
+#include "gfx_p.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <latch>
+#include <unordered_map>
+#include <unordered_set>
+
 namespace sm::gfx
 {
 #pragma region RenderGraphPass
 
-	void gfx::RenderGraphPass::read(TextureHandle textureHandle)
+	void gfx::RenderGraphPass::read(TextureHandle textureHandle, TextureState state)
+	{
+		m_reads.push_back({ textureHandle, state });
+	}
+
+	void gfx::RenderGraphPass::write(TextureHandle textureHandle, std::optional<TextureState> state)
+	{
+		m_writes.push_back({ textureHandle, state.value_or(m_compute ? TextureState::eStorage : TextureState::eRenderTarget) });
+	}
+
+	void RenderGraphPass::read(RenderGraphTexture texture, TextureState state)
+	{
+		m_reads.push_back({ TRANSIENT_TEXTURE_BIT | texture.index, state });
+	}
+
+	void RenderGraphPass::write(RenderGraphTexture texture, std::optional<TextureState> state)
+	{
+		m_writes.push_back({ TRANSIENT_TEXTURE_BIT | texture.index, state.value_or(m_compute ? TextureState::eStorage : TextureState::eRenderTarget) });
+	}
+
+	void RenderGraphPass::add_color_attachment(TextureHandle textureHandle)
+	{
+		write(textureHandle, TextureState::eRenderTarget);
+		m_colorAttachments.push_back(textureHandle);
+	}
+
+	void RenderGraphPass::add_color_attachment(RenderGraphTexture texture)
+	{
+		write(texture, TextureState::eRenderTarget);
+		m_colorAttachments.push_back(TRANSIENT_TEXTURE_BIT | texture.index);
+	}
+
+	void RenderGraphPass::set_depth_attachment(TextureHandle textureHandle)
+	{
+		write(textureHandle, TextureState::eRenderTarget);
+		m_depthAttachment = textureHandle;
+	}
+
+	void RenderGraphPass::set_depth_attachment(RenderGraphTexture texture)
+	{
+		write(texture, TextureState::eRenderTarget);
+		m_depthAttachment = TRANSIENT_TEXTURE_BIT | texture.index;
+	}
+
+	void RenderGraphPass::set_clear_color(const std::array<float, 4>& clearColor)
 	{
-		m_reads.push_back(textureHandle);
-		m_readStates.push_back(TextureState::eUndefined);
+		m_clearColor = clearColor;
 	}
 
-	void gfx::RenderGraphPass::write(TextureHandle textureHandle)
+	void RenderGraphPass::set_side_effects()
 	{
-		m_writes.push_back(textureHandle);
-		m_writeStates.push_back(TextureState::eUndefined);
+		m_sideEffects = true;
 	}
 
-	void gfx::RenderGraphPass::on_build(std::function<void(std::uint32_t, std::uint32_t)>&& buildFunc)
+	void gfx::RenderGraphPass::on_build(InplaceFunction<void(std::uint32_t, std::uint32_t)>&& buildFunc)
 	{
-		m_buildFunc = buildFunc;
+		m_buildFunc = std::move(buildFunc);
 	}
 
-	void gfx::RenderGraphPass::on_execute(std::function<void(CommandListHandle)>&& executeFunc)
+	void gfx::RenderGraphPass::on_execute(InplaceFunction<void(CommandListHandle)>&& executeFunc)
 	{
-		m_executeFunc = executeFunc;
+		m_executeFunc = std::move(executeFunc);
 	}
 
 	void RenderGraphPass::execute(CommandListHandle commandListHandle)
@@ -40,23 +90,497 @@ namespace sm::gfx
 		m_buildFunc(width, height);
 	}
 
+	void RenderGraphPass::clear()
+	{
+		m_reads.clear();
+		m_writes.clear();
+		m_queueIndex.reset();
+		m_compute = false;
+		m_sideEffects = false;
+		m_colorAttachments.clear();
+		m_depthAttachment.reset();
+		m_clearColor = { 1.0f, 1.0f, 1.0f, 1.0f };
+		m_name.clear();
+		m_buildFunc.reset();
+		m_executeFunc.reset();
+	}
+
 #pragma endregion
 
 #pragma region RenderGraph
 
-	auto RenderGraph::add_graphics_pass(const std::string& passName) -> RenderGraphPass&
+	RenderGraph::RenderGraph() = default;
+
+	RenderGraph::RenderGraph(DeviceHandle deviceHandle) : m_deviceHandle(deviceHandle) {}
+
+	RenderGraph::~RenderGraph()
 	{
-		m_passMap[passName] = std::make_unique<RenderGraphPass>();
-		return *m_passMap.at(passName);
+		destroy_transient_textures();
+	}
+
+	auto RenderGraph::add_graphics_pass(std::string_view passName) -> RenderGraphPass&
+	{
+		return add_pass(passName);
+	}
+
+	auto RenderGraph::add_compute_pass(std::string_view passName, std::optional<std::uint32_t> queueIndex) -> RenderGraphPass&
+	{
+		auto& pass = add_pass(passName);
+		pass.m_queueIndex = queueIndex;
+		pass.m_compute = true;
+		return pass;
+	}
+
+	auto RenderGraph::add_pass(std::string_view passName) -> RenderGraphPass&
+	{
+		// Passes are only allocated the first time the graph grows this large, their addresses stay stable.
+		if (m_passes.size() == m_passStorage.size())
+		{
+			m_passStorage.push_back(std::make_unique<RenderGraphPass>());
+		}
+		auto& pass = *m_passStorage[m_passes.size()];
+		pass.m_name = passName;
+		m_passes.push_back(&pass);
+		return pass;
+	}
+
+	auto RenderGraph::add_transient_texture(const TextureInfo& textureInfo) -> RenderGraphTexture
+	{
+		m_transientTextureInfos.push_back(textureInfo);
+		return { std::uint32_t(m_transientTextureInfos.size() - 1) };
+	}
+
+	auto RenderGraph::get_texture(RenderGraphTexture texture) const -> TextureHandle
+	{
+		return texture.index < m_transientTextures.size() ? m_transientTextures[texture.index] : TextureHandle{};
+	}
+
+	auto RenderGraph::get_transient_texture_info(std::uint32_t index) const -> TextureInfo
+	{
+		auto textureInfo = m_transientTextureInfos[index];
+		if (textureInfo.width == 0 && textureInfo.height == 0)
+		{
+			textureInfo.width = m_width;
+			textureInfo.height = m_height;
+		}
+		return textureInfo;
+	}
+
+	auto RenderGraph::get_texture_handle(std::uint64_t texture) const -> TextureHandle
+	{
+		if (texture & RenderGraphPass::TRANSIENT_TEXTURE_BIT)
+		{
+			return m_transientTextures[texture & ~RenderGraphPass::TRANSIENT_TEXTURE_BIT];
+		}
+		return TextureHandle{ DeviceHandle(texture >> 32u), ResourceHandle(texture & UINT32_MAX) };
+	}
+
+	void RenderGraph::export_texture(TextureHandle textureHandle)
+	{
+		m_exports.push_back(textureHandle);
+	}
+
+	void RenderGraph::export_texture(RenderGraphTexture texture)
+	{
+		m_exports.push_back(RenderGraphPass::TRANSIENT_TEXTURE_BIT | texture.index);
+	}
+
+	void RenderGraph::reset()
+	{
+		for (auto* pass : m_passes)
+		{
+			pass->clear();
+		}
+		m_passes.clear();
+		m_exports.clear();
+		m_transientTextureInfos.clear();
+	}
+
+	void RenderGraph::resize(std::uint32_t width, std::uint32_t height)
+	{
+		m_width = width;
+		m_height = height;
+		for (auto* pass : m_passes)
+		{
+			if (pass->m_buildFunc)
+			{
+				pass->build(width, height);
+			}
+		}
 	}
 
 	bool RenderGraph::compile()
 	{
+		GFX_PROFILE_ZONE("gfx::RenderGraph::compile");
+		// Rebuilding an unchanged graph reuses its plan. When only the transient textures changed, eg. by resize(), they
+		// are recreated without planning the passes again.
+		const auto structureHash = hash_structure();
+		const bool replan = !m_compiled || structureHash != m_structureHash;
+		if (replan)
+		{
+			m_compiled = false;
+			if (!plan_passes())
+			{
+				return false;
+			}
+			m_structureHash = structureHash;
+		}
+
+		std::size_t transientHash{};
+		for (std::uint32_t i = 0; i < m_transientTextureInfos.size(); ++i)
+		{
+			sm::hash_combine(transientHash, get_transient_texture_info(i));
+		}
+		if (replan || transientHash != m_transientHash)
+		{
+			m_compiled = false;
+			if (!create_transient_textures())
+			{
+				return false;
+			}
+			m_transientHash = transientHash;
+		}
+
+		m_compiled = true;
+		return true;
+	}
+
+	auto RenderGraph::hash_structure() const -> std::size_t
+	{
+		// Only what the plan depends on: the passes' accesses and queues, in declaration order, the exports and the number
+		// of transient textures.
+		std::size_t seed{};
+		for (const auto* pass : m_passes)
+		{
+			for (const auto* accesses : { &pass->m_reads, &pass->m_writes })
+			{
+				for (const auto& access : *accesses)
+				{
+					sm::hash_combine(seed, access.texture);
+					sm::hash_combine(seed, access.state);
+				}
+				sm::hash_combine(seed, accesses->size());
+			}
+			sm::hash_combine(seed, pass->m_queueIndex.value_or(UINT32_MAX));
+			sm::hash_combine(seed, pass->m_sideEffects);
+			for (const auto texture : pass->m_colorAttachments)
+			{
+				sm::hash_combine(seed, texture);
+			}
+			sm::hash_combine(seed, pass->m_colorAttachments.size());
+			sm::hash_combine(seed, pass->m_depthAttachment.value_or(0));
+		}
+		sm::hash_combine(seed, m_passes.size());
+		for (const auto texture : m_exports)
+		{
+			sm::hash_combine(seed, texture);
+		}
+		sm::hash_combine(seed, m_exports.size());
+		sm::hash_combine(seed, m_transientTextureInfos.size());
+		return seed;
+	}
+
+	bool RenderGraph::plan_passes()
+	{
+		// Walking back from the exports, a pass is needed if it has side effects, or writes a texture that is exported or read
+		// by a needed pass declared after it. Earlier writers are kept too, as a write need not overwrite the whole texture.
+		const auto passCount = m_passes.size();
+		std::vector<bool> culled(passCount, false);
+		if (!m_exports.empty())
+		{
+			std::unordered_set<std::uint64_t> neededTextures(m_exports.begin(), m_exports.end());
+			for (auto i = passCount; i-- > 0;)
+			{
+				const auto& pass = *m_passes[i];
+				culled[i] = !pass.m_sideEffects &&
+							std::ranges::none_of(pass.m_writes, [&](const auto& write) { return neededTextures.contains(write.texture); });
+				if (!culled[i])
+				{
+					std::ranges::for_each(pass.m_reads, [&](const auto& read) { neededTextures.insert(read.texture); });
+				}
+			}
+		}
+
+		// Dependencies only point forward in declaration order, so the graph is acyclic.
+		std::vector<std::vector<std::size_t>> consumers(passCount); // Ascending, as they are added in declaration order.
+		std::vector<std::uint32_t> dependencyCounts(passCount, 0);
+		const auto add_dependency = [&](std::size_t producer, std::size_t consumer) {
+			if (producer != consumer && std::ranges::find(consumers[producer], consumer) == consumers[producer].end())
+			{
+				consumers[producer].push_back(consumer);
+				++dependencyCounts[consumer];
+			}
+		};
+
+		std::unordered_map<std::uint64_t, std::size_t> lastWriters{};
+		std::unordered_map<std::uint64_t, std::vector<std::size_t>> readersSinceWrite{};
+		for (std::size_t i = 0; i < passCount; ++i)
+		{
+			if (culled[i])
+			{
+				continue;
+			}
+			const auto& pass = *m_passes[i];
+			for (const auto& read : pass.m_reads)
+			{
+				if (const auto writer = lastWriters.find(read.texture); writer != lastWriters.end())
+				{
+					add_dependency(writer->second, i);
+				}
+				readersSinceWrite[read.texture].push_back(i);
+			}
+			for (const auto& write : pass.m_writes)
+			{
+				if (const auto writer = lastWriters.find(write.texture); writer != lastWriters.end())
+				{
+					add_dependency(writer->second, i);
+				}
+				for (const auto reader : readersSinceWrite[write.texture])
+				{
+					add_dependency(reader, i);
+				}
+				readersSinceWrite[write.texture].clear();
+				lastWriters[write.texture] = i;
+			}
+		}
+
 		m_executionOrder.clear();
-		for (const auto& [name, pass] : m_passMap)
+		std::vector<std::size_t> ready{};
+		for (std::size_t i = 0; i < passCount; ++i)
+		{
+			if (dependencyCounts[i] == 0 && !culled[i])
+			{
+				ready.push_back(i);
+			}
+		}
+		std::size_t previous{ 0 };
+		while (!ready.empty())
+		{
+			// Prefer a consumer of the pass just scheduled, so what it wrote is read while still in cache (or tile memory).
+			auto next = std::ranges::min_element(ready);
+			if (!m_executionOrder.empty())
+			{
+				for (const auto consumer : consumers[previous])
+				{
+					if (const auto readyConsumer = std::ranges::find(ready, consumer); readyConsumer != ready.end())
+					{
+						next = readyConsumer;
+						break;
+					}
+				}
+			}
+
+			const auto passIndex = *next;
+			ready.erase(next);
+			m_executionOrder.push_back(passIndex);
+			previous = passIndex;
+			for (const auto consumer : consumers[passIndex])
+			{
+				if (--dependencyCounts[consumer] == 0)
+				{
+					ready.push_back(consumer);
+				}
+			}
+		}
+
+		if (m_executionOrder.size() != std::size_t(std::ranges::count(culled, false)))
+		{
+			return false;
+		}
+		const auto executedCount = std::uint32_t(m_executionOrder.size());
+
+		// Transient textures live from the first to the last pass using them, in execution order. Unused ones are not created.
+		// Execution order is only submission order within a queue, and passes on other queues only wait for the ownership
+		// transfers of what they use. So textures used on another queue live for the whole graph, and never share memory.
+		const auto transientCount = m_transientTextureInfos.size();
+		auto& lifetimes = m_transientLifetimes;
+		lifetimes.assign(transientCount, { UINT32_MAX, 0 });
+		std::vector<bool> usedOnOtherQueue(transientCount, false);
+		for (std::uint32_t i = 0; i < executedCount; ++i)
+		{
+			const auto& pass = *m_passes[m_executionOrder[i]];
+			const auto extend_lifetime = [&](const RenderGraphPass::TextureAccess& access) {
+				if (access.texture & RenderGraphPass::TRANSIENT_TEXTURE_BIT)
+				{
+					const auto transient = access.texture & ~RenderGraphPass::TRANSIENT_TEXTURE_BIT;
+					auto& lifetime = lifetimes[transient];
+					lifetime.first = std::min(lifetime.first, i);
+					lifetime.last = std::max(lifetime.last, i);
+					if (pass.m_queueIndex)
+					{
+						usedOnOtherQueue[transient] = true;
+					}
+				}
+			};
+			std::ranges::for_each(pass.m_reads, extend_lifetime);
+			std::ranges::for_each(pass.m_writes, extend_lifetime);
+		}
+		for (std::size_t i = 0; i < transientCount; ++i)
+		{
+			if (usedOnOtherQueue[i])
+			{
+				lifetimes[i] = { 0, executedCount - 1 };
+			}
+		}
+
+		// Within the graph each texture's state is known from the pass before, its first use is a tracked transition from
+		// whatever state it was left in. A write always needs a barrier, even without a layout change.
+		// A transient texture's first use acquires it instead, as another transient texture may have just used its memory.
+		// Using a texture on another queue than its last user transfers its ownership. Textures from outside the graph
+		// start owned by the graph's queue, and are handed back to it after the last pass.
+		m_transitions.assign(executedCount, {});
+		m_returns.clear();
+		std::unordered_map<std::uint64_t, TextureState> states{};
+		std::unordered_map<std::uint64_t, std::size_t> lastUsers{};
+		for (std::size_t i = 0; i < executedCount; ++i)
+		{
+			const auto& pass = *m_passes[m_executionOrder[i]];
+			auto& transitions = m_transitions[i];
+			std::vector<std::uint64_t> used{};
+			const auto use_texture = [&](std::uint64_t texture, TextureState newState, bool write) {
+				if (std::ranges::find(used, texture) != used.end())
+				{
+					return;
+				}
+				used.push_back(texture);
+
+				const auto lastUser = lastUsers.find(texture);
+				const auto state = states.find(texture);
+				std::optional<std::uint32_t> owner{};
+				if (lastUser != lastUsers.end())
+				{
+					owner = m_passes[m_executionOrder[lastUser->second]]->m_queueIndex;
+				}
+
+				if ((texture & RenderGraphPass::TRANSIENT_TEXTURE_BIT) && lastUser == lastUsers.end())
+				{
+					transitions.push_back({ texture, newState, newState, TransitionType::eAcquire, NO_PASS });
+				}
+				else if (owner != pass.m_queueIndex)
+				{
+					const auto oldState = state != states.end() ? state->second : newState;
+					transitions.push_back({ texture, oldState, newState, TransitionType::eTransfer, lastUser != lastUsers.end() ? lastUser->second : NO_PASS });
+				}
+				else if (write || state == states.end() || state->second != newState)
+				{
+					transitions.push_back({ texture, newState, newState, TransitionType::eTransition, NO_PASS, lastUser != lastUsers.end() ? lastUser->second : NO_PASS });
+				}
+				lastUsers[texture] = i;
+				states[texture] = newState;
+			};
+			// A texture both read and written by the pass is transitioned to its write state.
+			for (const auto& write : pass.m_writes)
+			{
+				use_texture(write.texture, write.state, true);
+			}
+			for (const auto& read : pass.m_reads)
+			{
+				use_texture(read.texture, read.state, false);
+			}
+		}
+		for (const auto& [texture, lastUser] : lastUsers)
+		{
+			if (!(texture & RenderGraphPass::TRANSIENT_TEXTURE_BIT) && m_passes[m_executionOrder[lastUser]]->m_queueIndex)
+			{
+				m_returns.push_back({ texture, states[texture], states[texture], TransitionType::eTransfer, lastUser });
+			}
+		}
+
+		// Consecutive passes on the same attachments share a render pass, unless something else needs a barrier between
+		// them, as barriers cannot be recorded inside one. The render pass orders the writes to its attachments itself.
+		m_renderPasses.assign(executedCount, std::nullopt);
+		for (std::size_t i = 0; i < executedCount; ++i)
+		{
+			const auto& pass = *m_passes[m_executionOrder[i]];
+			if (pass.m_colorAttachments.empty())
+			{
+				continue;
+			}
+			if (i > 0 && m_renderPasses[i - 1])
+			{
+				const auto& previous = *m_passes[m_executionOrder[i - 1]];
+				const bool sameAttachments = previous.m_colorAttachments == pass.m_colorAttachments && previous.m_depthAttachment == pass.m_depthAttachment && previous.m_queueIndex == pass.m_queueIndex;
+				if (sameAttachments && std::ranges::all_of(m_transitions[i], [&](const Transition& transition) {
+						return transition.type == TransitionType::eTransition && (std::ranges::find(pass.m_colorAttachments, transition.texture) != pass.m_colorAttachments.end() || pass.m_depthAttachment == transition.texture);
+					}))
+				{
+					m_transitions[i].clear();
+					m_renderPasses[i - 1]->ends = false;
+					m_renderPasses[i] = RenderPass{ .begins = false, .ends = true };
+					continue;
+				}
+			}
+			m_renderPasses[i] = RenderPass{ .begins = true, .ends = true };
+		}
+
+		// A transition whose texture was last used before the pass before is split, begun after that use (or the render pass it
+		// is in) and ended before this pass, so execute() lets the passes in between overlap it.
+		m_splitBegins.assign(executedCount, {});
+		for (std::size_t i = 0; i < executedCount; ++i)
 		{
-			//			pass->build();
-			m_executionOrder.push_back(pass.get());
+			for (auto& transition : m_transitions[i])
+			{
+				if (transition.type != TransitionType::eTransition || transition.beginAfterPass == NO_PASS)
+				{
+					continue;
+				}
+				while (m_renderPasses[transition.beginAfterPass] && !m_renderPasses[transition.beginAfterPass]->ends)
+				{
+					++transition.beginAfterPass;
+				}
+				if (transition.beginAfterPass + 1 < i)
+				{
+					m_splitBegins[transition.beginAfterPass].push_back(transition);
+				}
+				else
+				{
+					transition.beginAfterPass = NO_PASS;
+				}
+			}
+		}
+
+		// An attachment is loaded if an earlier pass wrote it, otherwise cleared. It is only stored if a later pass uses it,
+		// it is exported, or, without exports, it is not a transient texture.
+		std::unordered_map<std::uint64_t, std::size_t> firstWriters{};
+		for (std::size_t i = 0; i < executedCount; ++i)
+		{
+			for (const auto& write : m_passes[m_executionOrder[i]]->m_writes)
+			{
+				firstWriters.try_emplace(write.texture, i);
+			}
+		}
+		for (std::size_t first = 0; first < executedCount; ++first)
+		{
+			if (!m_renderPasses[first] || !m_renderPasses[first]->begins)
+			{
+				continue;
+			}
+			auto last = first;
+			while (!m_renderPasses[last]->ends)
+			{
+				++last;
+			}
+			const auto get_load_op = [&](std::uint64_t texture) {
+				return firstWriters.at(texture) < first ? LoadOp::eLoad : LoadOp::eClear;
+			};
+			const auto get_store_op = [&](std::uint64_t texture) {
+				const bool stored = lastUsers.at(texture) > last || std::ranges::find(m_exports, texture) != m_exports.end() ||
+									(m_exports.empty() && !(texture & RenderGraphPass::TRANSIENT_TEXTURE_BIT));
+				return stored ? StoreOp::eStore : StoreOp::eDontCare;
+			};
+
+			const auto& pass = *m_passes[m_executionOrder[first]];
+			auto& renderPass = *m_renderPasses[first];
+			for (std::size_t attachment = 0; attachment < pass.m_colorAttachments.size(); ++attachment)
+			{
+				renderPass.colorLoadOps[attachment] = get_load_op(pass.m_colorAttachments[attachment]);
+				renderPass.colorStoreOps[attachment] = get_store_op(pass.m_colorAttachments[attachment]);
+			}
+			if (pass.m_depthAttachment)
+			{
+				renderPass.depthLoadOp = get_load_op(*pass.m_depthAttachment);
+				renderPass.depthStoreOp = get_store_op(*pass.m_depthAttachment);
+			}
 		}
 
 		return true;
@@ -64,10 +588,349 @@ namespace sm::gfx
 
 	void RenderGraph::execute(CommandListHandle commandListHandle)
 	{
-		for (auto& pass : m_executionOrder)
+		for (std::size_t i = 0; i < m_executionOrder.size(); ++i)
+		{
+			// Transitions only queue barriers, the command list records them together before the pass's first command.
+			// Everything runs on the one queue, so ownership transfers are plain transitions.
+			for (const auto& transition : m_transitions[i])
+			{
+				if (transition.type == TransitionType::eAcquire)
+				{
+					acquire_aliased_texture(commandListHandle, get_texture_handle(transition.texture), transition.newState);
+				}
+				else if (transition.type == TransitionType::eTransition && transition.beginAfterPass != NO_PASS)
+				{
+					end_texture_transition(commandListHandle, get_texture_handle(transition.texture));
+				}
+				else
+				{
+					transition_texture(commandListHandle, get_texture_handle(transition.texture), transition.newState);
+				}
+			}
+			execute_pass(commandListHandle, i);
+			for (const auto& transition : m_splitBegins[i])
+			{
+				begin_texture_transition(commandListHandle, get_texture_handle(transition.texture), transition.newState);
+			}
+		}
+	}
+
+	void RenderGraph::execute_pass(CommandListHandle commandListHandle, std::size_t pass)
+	{
+		const auto& renderPass = m_renderPasses[pass];
+		if (renderPass && renderPass->begins)
+		{
+			// Passes sharing the render pass have the same attachments, the first's clear color is used.
+			const auto& graphPass = *m_passes[m_executionOrder[pass]];
+			RenderPassInfo renderPassInfo{};
+			for (std::size_t attachment = 0; attachment < graphPass.m_colorAttachments.size(); ++attachment)
+			{
+				renderPassInfo.colorAttachments[attachment] = get_texture_handle(graphPass.m_colorAttachments[attachment]);
+			}
+			if (graphPass.m_depthAttachment)
+			{
+				renderPassInfo.depthAttachment = get_texture_handle(*graphPass.m_depthAttachment);
+			}
+			renderPassInfo.clearColor = graphPass.m_clearColor;
+			renderPassInfo.colorLoadOps = renderPass->colorLoadOps;
+			renderPassInfo.colorStoreOps = renderPass->colorStoreOps;
+			renderPassInfo.depthLoadOp = renderPass->depthLoadOp;
+			renderPassInfo.depthStoreOp = renderPass->depthStoreOp;
+			begin_render_pass(commandListHandle, renderPassInfo);
+		}
+		// Inside the render pass, so the markers of passes sharing one still nest within it.
+		auto& executedPass = *m_passes[m_executionOrder[pass]];
+		push_marker(commandListHandle, executedPass.get_name());
+		executedPass.execute(commandListHandle);
+		pop_marker(commandListHandle);
+		if (renderPass && renderPass->ends)
+		{
+			end_render_pass(commandListHandle);
+		}
+	}
+
+	void RenderGraph::set_recording_threads(std::uint32_t threadCount)
+	{
+		m_recordingPool = threadCount > 0 ? std::make_unique<WorkerPool>(threadCount) : nullptr;
+		m_taskScheduler = m_recordingPool.get();
+	}
+
+	void RenderGraph::set_task_scheduler(TaskScheduler* taskScheduler)
+	{
+		m_recordingPool = nullptr;
+		m_taskScheduler = taskScheduler;
+	}
+
+	auto RenderGraph::execute_parallel(std::uint32_t queueIndex, const SubmitBatch& batch) -> SyncPoint
+	{
+		const auto passCount = m_executionOrder.size();
+		const auto get_queue = [&](std::size_t pass) {
+			return pass == NO_PASS ? queueIndex : m_passes[m_executionOrder[pass]]->m_queueIndex.value_or(queueIndex);
+		};
+
+		std::atomic<bool> failed{ false };
+		const auto begin_command_list = [&](CommandListHandle& commandList, std::uint32_t queue) {
+			if (std::uint64_t(commandList) == 0 && (!create_transient_command_list(commandList, m_deviceHandle, queue) || !begin(commandList)))
+			{
+				failed.store(true, std::memory_order_relaxed);
+				commandList = {};
+				return false;
+			}
+			return true;
+		};
+
+		// Transitions update the textures' tracked states, which is not thread safe. So they are recorded here, in order, into
+		// command lists of their own before each pass, with the releases of ownership transfers in lists after the releasing
+		// pass (or before any pass, for textures from outside the graph). Each recording thread allocates from its own command pool.
+		std::vector<CommandListHandle> preCommandLists(passCount);
+		std::vector<CommandListHandle> passCommandLists(passCount);
+		std::vector<CommandListHandle> postCommandLists(passCount);
+		CommandListHandle prologueCommandList{};
+		CommandListHandle epilogueCommandList{};
+
+		// Passes sharing a render pass are recorded together, into the first's command list.
+		std::vector<std::size_t> firstPasses{};
+		for (std::size_t i = 0; i < passCount; ++i)
+		{
+			if (!m_renderPasses[i] || m_renderPasses[i]->begins)
+			{
+				firstPasses.push_back(i);
+			}
+		}
+		std::latch recorded{ std::ptrdiff_t(firstPasses.size()) };
+		for (std::size_t group = 0; group < firstPasses.size(); ++group)
+		{
+			const auto first = firstPasses[group];
+			const auto last = group + 1 < firstPasses.size() ? firstPasses[group + 1] : passCount;
+			auto record_passes = [&, first, last] {
+				if (begin_command_list(passCommandLists[first], get_queue(first)))
+				{
+					for (auto i = first; i < last; ++i)
+					{
+						execute_pass(passCommandLists[first], i);
+					}
+					end(passCommandLists[first]);
+				}
+				recorded.count_down();
+			};
+			if (m_taskScheduler)
+			{
+				m_taskScheduler->enqueue(std::move(record_passes));
+			}
+			else
+			{
+				record_passes();
+			}
+		}
+
+		for (std::size_t i = 0; i < passCount; ++i)
+		{
+			for (const auto& transition : m_transitions[i])
+			{
+				if (!begin_command_list(preCommandLists[i], get_queue(i)))
+				{
+					break;
+				}
+				if (transition.type == TransitionType::eAcquire)
+				{
+					acquire_aliased_texture(preCommandLists[i], get_texture_handle(transition.texture), transition.newState);
+				}
+				else if (transition.type == TransitionType::eTransition)
+				{
+					transition_texture(preCommandLists[i], get_texture_handle(transition.texture), transition.newState);
+				}
+				else
+				{
+					auto& releaseCommandList = transition.releasingPass == NO_PASS ? prologueCommandList : postCommandLists[transition.releasingPass];
+					const auto srcQueue = get_queue(transition.releasingPass);
+					if (!begin_command_list(releaseCommandList, srcQueue))
+					{
+						break;
+					}
+					if (transition.releasingPass == NO_PASS)
+					{
+						// The state of a texture from outside the graph is only tracked, so it changes before the transfer.
+						transition_texture(releaseCommandList, get_texture_handle(transition.texture), transition.newState);
+					}
+					transfer_texture_ownership(releaseCommandList, get_texture_handle(transition.texture), srcQueue, get_queue(i), transition.oldState, transition.newState);
+					transfer_texture_ownership(preCommandLists[i], get_texture_handle(transition.texture), srcQueue, get_queue(i), transition.oldState, transition.newState);
+				}
+			}
+			if (std::uint64_t(preCommandLists[i]) != 0)
+			{
+				end(preCommandLists[i]);
+			}
+		}
+
+		// The graph's last submission is on its queue, so its sync point covers the whole graph.
+		const bool needsEpilogue = passCount == 0 || get_queue(passCount - 1) != queueIndex;
+		if (needsEpilogue || !m_returns.empty())
+		{
+			begin_command_list(epilogueCommandList, queueIndex);
+		}
+		for (const auto& transition : m_returns)
+		{
+			const auto srcQueue = get_queue(transition.releasingPass);
+			if (begin_command_list(postCommandLists[transition.releasingPass], srcQueue) && std::uint64_t(epilogueCommandList) != 0)
+			{
+				transfer_texture_ownership(postCommandLists[transition.releasingPass], get_texture_handle(transition.texture), srcQueue, queueIndex, transition.oldState, transition.newState);
+				transfer_texture_ownership(epilogueCommandList, get_texture_handle(transition.texture), srcQueue, queueIndex, transition.oldState, transition.newState);
+			}
+		}
+		recorded.wait();
+
+		for (auto commandList : { prologueCommandList, epilogueCommandList })
+		{
+			if (std::uint64_t(commandList) != 0)
+			{
+				end(commandList);
+			}
+		}
+		for (auto commandList : postCommandLists)
+		{
+			if (std::uint64_t(commandList) != 0)
+			{
+				end(commandList);
+			}
+		}
+		if (failed.load(std::memory_order_relaxed))
+		{
+			return {};
+		}
+
+		// Consecutive passes on one queue are submitted together, waiting on the submissions on other queues they take
+		// textures from. The first submission on each queue takes the batch's waits, the last on the graph's queue its
+		// swap chain and signal, and waits on every other queue.
+		std::unordered_map<std::uint32_t, SyncPoint> lastSyncPoints{};
+		const auto submit = [&](std::uint32_t queue, std::span<const CommandListHandle> commandLists, std::vector<SyncPoint> waits, bool last) {
+			SubmitBatch submitBatch{};
+			submitBatch.commandLists = commandLists;
+			if (!lastSyncPoints.contains(queue))
+			{
+				waits.insert(waits.end(), batch.waitSyncPoints.begin(), batch.waitSyncPoints.end());
+				if (queue == queueIndex)
+				{
+					submitBatch.waitSemaphores = batch.waitSemaphores;
+				}
+			}
+			if (last)
+			{
+				for (const auto& [otherQueue, syncPoint] : lastSyncPoints)
+				{
+					if (otherQueue != queue)
+					{
+						waits.push_back(syncPoint);
+					}
+				}
+				submitBatch.swapChainHandle = batch.swapChainHandle;
+				submitBatch.outSignalSemaphoreHandle = batch.outSignalSemaphoreHandle;
+			}
+			submitBatch.waitSyncPoints = waits;
+			lastSyncPoints[queue] = submit_command_lists(m_deviceHandle, queue, { &submitBatch, 1 });
+			return lastSyncPoints[queue];
+		};
+
+		SyncPoint prologueSyncPoint{};
+		if (std::uint64_t(prologueCommandList) != 0)
+		{
+			prologueSyncPoint = submit(queueIndex, { &prologueCommandList, 1 }, {}, false);
+		}
+		std::vector<SyncPoint> passSyncPoints(passCount);
+		for (std::size_t first = 0; first < passCount;)
+		{
+			const auto queue = get_queue(first);
+			auto last = first;
+			while (last < passCount && get_queue(last) == queue)
+			{
+				++last;
+			}
+			const bool isLast = last == passCount && queue == queueIndex;
+
+			std::vector<CommandListHandle> commandLists{};
+			std::vector<SyncPoint> waits{};
+			if (isLast && std::uint64_t(epilogueCommandList) != 0)
+			{
+				commandLists.push_back(epilogueCommandList); // Only acquires textures no pass here uses.
+			}
+			for (auto i = first; i < last; ++i)
+			{
+				for (const auto& transition : m_transitions[i])
+				{
+					if (transition.type != TransitionType::eTransfer || get_queue(transition.releasingPass) == queue)
+					{
+						continue;
+					}
+					const auto wait = transition.releasingPass == NO_PASS ? prologueSyncPoint : passSyncPoints[transition.releasingPass];
+					if (std::ranges::none_of(waits, [&](const SyncPoint& syncPoint) { return syncPoint.queueIndex == wait.queueIndex && syncPoint.value == wait.value; }))
+					{
+						waits.push_back(wait);
+					}
+				}
+				for (auto commandList : { preCommandLists[i], passCommandLists[i], postCommandLists[i] })
+				{
+					if (std::uint64_t(commandList) != 0)
+					{
+						commandLists.push_back(commandList);
+					}
+				}
+			}
+
+			const auto syncPoint = submit(queue, commandLists, std::move(waits), isLast);
+			std::fill(passSyncPoints.begin() + first, passSyncPoints.begin() + last, syncPoint);
+			first = last;
+		}
+		if (needsEpilogue)
+		{
+			return submit(queueIndex, { &epilogueCommandList, 1 }, {}, true);
+		}
+		return lastSyncPoints[queueIndex];
+	}
+
+	bool RenderGraph::create_transient_textures()
+	{
+		destroy_transient_textures();
+
+		const auto transientCount = m_transientTextureInfos.size();
+		m_transientTextures.assign(transientCount, {});
+		std::vector<std::uint32_t> usedTransients{};
+		std::vector<TextureInfo> usedInfos{};
+		std::vector<TextureLifetime> usedLifetimes{};
+		for (std::uint32_t i = 0; i < transientCount; ++i)
+		{
+			if (m_transientLifetimes[i].first != UINT32_MAX)
+			{
+				usedTransients.push_back(i);
+				usedInfos.push_back(get_transient_texture_info(i));
+				usedLifetimes.push_back(m_transientLifetimes[i]);
+			}
+		}
+		if (usedTransients.empty())
+		{
+			return true;
+		}
+
+		std::vector<TextureHandle> handles(usedTransients.size());
+		if (!create_aliased_textures(handles, m_deviceHandle, usedInfos, usedLifetimes))
+		{
+			return false;
+		}
+		for (std::size_t i = 0; i < usedTransients.size(); ++i)
+		{
+			m_transientTextures[usedTransients[i]] = handles[i];
+		}
+		return true;
+	}
+
+	void RenderGraph::destroy_transient_textures()
+	{
+		for (const auto textureHandle : m_transientTextures)
 		{
-			pass->execute(commandListHandle);
+			if (std::uint64_t(textureHandle) != 0)
+			{
+				destroy_texture(textureHandle);
+			}
 		}
+		m_transientTextures.clear();
 	}
 
 #pragma endregion
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx_shader_archive.hpp"
+
+#if _WIN32
+	#define NOMINMAX
+	#define WIN32_LEAN_AND_MEAN
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <numeric>
+#include <vector>
+
+namespace sm::gfx
+{
+	namespace
+	{
+		auto align_up(std::uint64_t value, std::uint64_t alignment) -> std::uint64_t
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		void write_padding(std::ofstream& file, std::uint64_t offset)
+		{
+			static constexpr std::array<char, SHADER_ARCHIVE_ALIGNMENT> ZEROS{};
+			file.write(ZEROS.data(), std::streamsize(offset - std::uint64_t(file.tellp())));
+		}
+
+		struct EntryPoint
+		{
+			std::string_view name{};
+			std::uint32_t shaderStage{ 0 };
+		};
+
+		/**
+		 * @brief Find the first entry point a SPIR-V module declares. Modules without one, eg. libraries, get an empty name.
+		 * @return False if the code is not SPIR-V.
+		 */
+		bool reflect_entry_point(EntryPoint& outEntryPoint, std::span<const std::uint32_t> code)
+		{
+			constexpr std::uint32_t SPIRV_MAGIC = 0x07230203;
+			constexpr std::uint32_t SPIRV_HEADER_WORDS = 5;
+			constexpr std::uint32_t OP_ENTRY_POINT = 15;
+			if (code.size() < SPIRV_HEADER_WORDS || code[0] != SPIRV_MAGIC)
+			{
+				return false;
+			}
+
+			for (std::size_t i = SPIRV_HEADER_WORDS; i < code.size();)
+			{
+				const auto wordCount = code[i] >> 16u;
+				if (wordCount == 0 || i + wordCount > code.size())
+				{
+					return false;
+				}
+				if ((code[i] & 0xFFFFu) == OP_ENTRY_POINT && wordCount > 3)
+				{
+					// OP_ENTRY_POINT ExecutionModel, Id, Name
+					switch (code[i + 1])
+					{
+						case 0: outEntryPoint.shaderStage = ShaderStageFlags_Vertex; break;
+						case 4: outEntryPoint.shaderStage = ShaderStageFlags_Fragment; break;
+						case 5: outEntryPoint.shaderStage = ShaderStageFlags_Compute; break;
+						case 5267:
+						case 5364: outEntryPoint.shaderStage = ShaderStageFlags_Task; break;
+						case 5268:
+						case 5365: outEntryPoint.shaderStage = ShaderStageFlags_Mesh; break;
+						default: break;
+					}
+					const auto* name = reinterpret_cast<const char*>(&code[i + 3]);
+					const auto* nameEnd = name + std::size_t(wordCount - 3) * sizeof(std::uint32_t);
+					outEntryPoint.name = std::string_view(name, std::find(name, nameEnd, '\0'));
+					return true;
+				}
+				i += wordCount;
+			}
+			return true;
+		}
+	} // namespace
+
+	bool write_shader_archive(const char* filename, std::span<const ShaderArchiveSource> shaders)
+	{
+		std::vector<std::uint32_t> order(shaders.size());
+		std::iota(order.begin(), order.end(), 0u);
+		std::ranges::sort(order, [&](auto lhs, auto rhs) { return shaders[lhs].name < shaders[rhs].name; });
+		if (std::ranges::adjacent_find(order, [&](auto lhs, auto rhs) { return shaders[lhs].name == shaders[rhs].name; }) != order.end())
+		{
+			GFX_LOG_ERR("GFX - Shader archive names must be unique!");
+			return false;
+		}
+
+		ShaderArchiveHeader header{
+			.magic = SHADER_ARCHIVE_MAGIC,
+			.version = SHADER_ARCHIVE_VERSION,
+			.entryCount = std::uint32_t(shaders.size()),
+			.stringSize = 0,
+			.entryOffset = sizeof(ShaderArchiveHeader),
+			.stringOffset = sizeof(ShaderArchiveHeader) + sizeof(ShaderArchiveEntry) * shaders.size(),
+		};
+
+		std::vector<ShaderArchiveEntry> entries(shaders.size());
+		std::vector<char> strings{};
+		const auto add_string = [&](std::string_view string) {
+			const auto offset = std::uint32_t(strings.size());
+			strings.insert(strings.end(), string.begin(), string.end());
+			strings.push_back('\0');
+			return offset;
+		};
+		for (std::size_t i = 0; i < order.size(); ++i)
+		{
+			const auto& shader = shaders[order[i]];
+			EntryPoint entryPoint{};
+			if (!reflect_entry_point(entryPoint, shader.code))
+			{
+				GFX_LOG_ERR("GFX - Shader archive code is not SPIR-V!");
+				return false;
+			}
+
+			auto& entry = entries[i];
+			entry.contentHash = hash_shader_code(shader.code);
+			entry.codeSize = std::uint32_t(shader.code.size());
+			entry.nameOffset = add_string(shader.name);
+			entry.nameLength = std::uint32_t(shader.name.size());
+			entry.entryPointOffset = add_string(entryPoint.name);
+			entry.entryPointLength = std::uint32_t(entryPoint.name.size());
+			entry.shaderStage = entryPoint.shaderStage;
+		}
+		header.stringSize = std::uint32_t(strings.size());
+
+		auto codeOffset = header.stringOffset + header.stringSize;
+		for (std::size_t i = 0; i < order.size(); ++i)
+		{
+			codeOffset = align_up(codeOffset, SHADER_ARCHIVE_ALIGNMENT);
+			entries[i].codeOffset = codeOffset;
+			codeOffset += shaders[order[i]].code.size_bytes();
+		}
+
+		std::ofstream file{ filename, std::ios::binary | std::ios::trunc };
+		if (!file)
+		{
+			GFX_LOG_ERR("GFX - Failed to create shader archive!");
+			return false;
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(entries.data()), std::streamsize(sizeof(ShaderArchiveEntry) * entries.size()));
+		file.write(strings.data(), std::streamsize(strings.size()));
+		for (std::size_t i = 0; i < order.size(); ++i)
+		{
+			const auto code = shaders[order[i]].code;
+			write_padding(file, entries[i].codeOffset);
+			file.write(reinterpret_cast<const char*>(code.data()), std::streamsize(code.size_bytes()));
+		}
+
+		if (!file)
+		{
+			GFX_LOG_ERR("GFX - Failed to write shader archive!");
+			return false;
+		}
+		return true;
+	}
+
+	ShaderArchive::~ShaderArchive()
+	{
+		close();
+	}
+
+	bool ShaderArchive::open(const char* filename)
+	{
+		close();
+
+#if _WIN32
+		const auto file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			GFX_LOG_ERR("GFX - Failed to open shader archive!");
+			return false;
+		}
+		LARGE_INTEGER fileSize{};
+		const auto mapping = GetFileSizeEx(file, &fileSize) ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+		// The view keeps the file mapped once the handles are closed.
+		m_data = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		m_size = std::uint64_t(fileSize.QuadPart);
+		if (mapping != nullptr)
+		{
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+#else
+		const auto file = ::open(filename, O_RDONLY);
+		if (file < 0)
+		{
+			GFX_LOG_ERR("GFX - Failed to open shader archive!");
+			return false;
+		}
+		struct stat fileStat{};
+		if (fstat(file, &fileStat) == 0 && fileStat.st_size > 0)
+		{
+			m_size = std::uint64_t(fileStat.st_size);
+			m_data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (m_data == MAP_FAILED)
+			{
+				m_data = nullptr;
+			}
+		}
+		::close(file);
+#endif
+		if (m_data == nullptr)
+		{
+			GFX_LOG_ERR("GFX - Failed to map shader archive!");
+			return false;
+		}
+
+		const auto& header = get_header();
+		if (m_size < sizeof(ShaderArchiveHeader) || header.magic != SHADER_ARCHIVE_MAGIC || header.version != SHADER_ARCHIVE_VERSION)
+		{
+			GFX_LOG_ERR("GFX - Not a shader archive of this version!");
+			close();
+			return false;
+		}
+		const bool truncated = header.entryOffset + sizeof(ShaderArchiveEntry) * header.entryCount > m_size || header.stringOffset + header.stringSize > m_size ||
+							   std::ranges::any_of(get_entries(), [&](const ShaderArchiveEntry& entry) {
+								   return entry.codeOffset % sizeof(std::uint32_t) != 0 || entry.codeOffset + sizeof(std::uint32_t) * std::uint64_t(entry.codeSize) > m_size ||
+										  std::uint64_t(entry.nameOffset) + entry.nameLength >= header.stringSize ||
+										  std::uint64_t(entry.entryPointOffset) + entry.entryPointLength >= header.stringSize;
+							   });
+		if (truncated)
+		{
+			GFX_LOG_ERR("GFX - Shader archive is truncated!");
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	void ShaderArchive::close()
+	{
+		if (m_data == nullptr)
+		{
+			return;
+		}
+#if _WIN32
+		UnmapViewOfFile(m_data);
+#else
+		munmap(m_data, m_size);
+#endif
+		m_data = nullptr;
+		m_size = 0;
+	}
+
+	auto ShaderArchive::get_entries() const -> std::span<const ShaderArchiveEntry>
+	{
+		GFX_ASSERT(is_open(), "ShaderArchive is not open!");
+		const auto& header = get_header();
+		return { reinterpret_cast<const ShaderArchiveEntry*>(static_cast<const std::byte*>(m_data) + header.entryOffset), header.entryCount };
+	}
+
+	auto ShaderArchive::find(std::string_view name) const -> const ShaderArchiveEntry*
+	{
+		const auto entries = get_entries();
+		const auto it = std::ranges::lower_bound(entries, name, {}, [&](const ShaderArchiveEntry& entry) { return get_name(entry); });
+		return it != entries.end() && get_name(*it) == name ? &*it : nullptr;
+	}
+
+	auto ShaderArchive::get_name(const ShaderArchiveEntry& entry) const -> std::string_view
+	{
+		GFX_ASSERT(is_open(), "ShaderArchive is not open!");
+		return { static_cast<const char*>(m_data) + get_header().stringOffset + entry.nameOffset, entry.nameLength };
+	}
+
+	auto ShaderArchive::get_entry_point(const ShaderArchiveEntry& entry) const -> std::string_view
+	{
+		GFX_ASSERT(is_open(), "ShaderArchive is not open!");
+		return { static_cast<const char*>(m_data) + get_header().stringOffset + entry.entryPointOffset, entry.entryPointLength };
+	}
+
+	auto ShaderArchive::get_code(const ShaderArchiveEntry& entry) const -> ShaderCode
+	{
+		GFX_ASSERT(is_open(), "ShaderArchive is not open!");
+		return { std::span(reinterpret_cast<const std::uint32_t*>(static_cast<const std::byte*>(m_data) + entry.codeOffset), entry.codeSize), entry.contentHash };
+	}
+
+} // namespace sm::gfx
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx_streaming_compute.hpp"
+
+#include <cstring>
+#include <utility>
+
+namespace sm::gfx
+{
+	StreamingCompute::StreamingCompute(DeviceHandle deviceHandle, const StreamingComputeInfo& streamingInfo)
+		: m_deviceHandle(deviceHandle), m_info(streamingInfo), m_separateUpload(streamingInfo.uploadQueueIndex != streamingInfo.computeQueueIndex)
+	{
+		if (!m_info.pipeline || m_info.inputChunkSize == 0 || m_info.outputChunkSize == 0 || m_info.slotCount == 0 || !m_info.record)
+		{
+			GFX_LOG_ERR("GFX - StreamingCompute - Needs a pipeline, chunk sizes, at least one slot and a record function!");
+			return;
+		}
+
+		m_slots.resize(m_info.slotCount);
+		for (auto& slot : m_slots)
+		{
+			if (!create_slot(slot))
+			{
+				return;
+			}
+		}
+
+		m_valid = true;
+	}
+
+	StreamingCompute::~StreamingCompute()
+	{
+		// Outputs still in flight are not consumed, but their slots must be idle before being destroyed.
+		for (auto& slot : m_slots)
+		{
+			if (slot.readbackHandle)
+			{
+				const void* data{ nullptr };
+				if (!resolve_readback(slot.readbackHandle, data, INFINITE_TIMEOUT))
+				{
+					destroy_readback(slot.readbackHandle);
+				}
+			}
+			destroy_slot(slot);
+		}
+	}
+
+	bool StreamingCompute::is_valid() const
+	{
+		return m_valid;
+	}
+
+	auto StreamingCompute::begin_chunk() -> std::span<std::byte>
+	{
+		GFX_ASSERT(m_valid, "StreamingCompute is not valid!");
+
+		auto& slot = m_slots[m_nextSlot];
+		if (!m_chunkBegun)
+		{
+			// Slots are reused in order, so this is the oldest chunk in flight, and outputs are consumed in order.
+			if (!complete_slot(slot))
+			{
+				return {};
+			}
+			m_chunkBegun = true;
+		}
+		return { slot.stagingPtr, m_info.inputChunkSize };
+	}
+
+	bool StreamingCompute::submit_chunk(std::uint64_t inputSize, std::uint64_t outputSize)
+	{
+		GFX_ASSERT(m_valid, "StreamingCompute is not valid!");
+		GFX_ASSERT(m_chunkBegun, "StreamingCompute - submit_chunk() needs a begin_chunk() first!");
+
+		outputSize = outputSize == WHOLE_SIZE ? m_info.outputChunkSize : outputSize;
+		if (inputSize == 0 || inputSize > m_info.inputChunkSize || outputSize == 0 || outputSize > m_info.outputChunkSize)
+		{
+			GFX_LOG_ERR("GFX - StreamingCompute - Chunks must have input and output, within the chunk sizes!");
+			return false;
+		}
+
+		auto& slot = m_slots[m_nextSlot];
+		slot.chunk = StreamingChunk{ .index = m_nextChunkIndex, .inputSize = inputSize, .outputSize = outputSize };
+		const BufferCopyRegion uploadRegion{ .size = inputSize };
+
+		// The input crosses families with a release here and an acquire on the compute queue. It is not handed back, as each
+		// upload overwrites it, and the slot only comes round again once its last chunk has been read back.
+		SyncPoint uploadSyncPoint{};
+		if (m_separateUpload)
+		{
+			reset(slot.uploadCommandList);
+			if (!begin(slot.uploadCommandList))
+			{
+				return false;
+			}
+			copy_buffer(slot.uploadCommandList, slot.stagingBuffer, slot.inputBuffer, { &uploadRegion, 1 });
+			transfer_buffer_ownership(slot.uploadCommandList, slot.inputBuffer, m_info.uploadQueueIndex, m_info.computeQueueIndex);
+			end(slot.uploadCommandList);
+			uploadSyncPoint = submit_command_list({ .commandList = slot.uploadCommandList });
+		}
+
+		reset(slot.computeCommandList);
+		if (!begin(slot.computeCommandList))
+		{
+			return false;
+		}
+		if (m_separateUpload)
+		{
+			transfer_buffer_ownership(slot.computeCommandList, slot.inputBuffer, m_info.uploadQueueIndex, m_info.computeQueueIndex);
+		}
+		else
+		{
+			copy_buffer(slot.computeCommandList, slot.stagingBuffer, slot.inputBuffer, { &uploadRegion, 1 });
+			buffer_barrier(slot.computeCommandList, slot.inputBuffer, PipelineStageFlags_Transfer, PipelineStageFlags_ComputeShader);
+		}
+		bind_pipeline(slot.computeCommandList, m_info.pipeline);
+		bind_descriptor_sets(slot.computeCommandList, 0, { &slot.descriptorSet, 1 });
+		m_info.record(slot.computeCommandList, slot.chunk);
+		buffer_barrier(slot.computeCommandList, slot.outputBuffer, PipelineStageFlags_ComputeShader, PipelineStageFlags_Transfer);
+		slot.readbackHandle = read_buffer(slot.computeCommandList, slot.outputBuffer, slot.readbackBuffer, { .size = outputSize });
+		end(slot.computeCommandList);
+		if (!slot.readbackHandle)
+		{
+			return false;
+		}
+		submit_command_list({ .commandList = slot.computeCommandList, .waitSyncPoint = uploadSyncPoint });
+
+		m_chunkBegun = false;
+		m_nextSlot = (m_nextSlot + 1) % m_info.slotCount;
+		++m_nextChunkIndex;
+		return true;
+	}
+
+	bool StreamingCompute::submit(std::span<const std::byte> input, std::uint64_t outputSize)
+	{
+		if (input.size() > m_info.inputChunkSize)
+		{
+			GFX_LOG_ERR("GFX - StreamingCompute - Input is larger than the chunk size!");
+			return false;
+		}
+
+		const auto staging = begin_chunk();
+		if (staging.empty())
+		{
+			return false;
+		}
+		std::memcpy(staging.data(), input.data(), input.size());
+		return submit_chunk(input.size(), outputSize);
+	}
+
+	void StreamingCompute::flush()
+	{
+		GFX_ASSERT(m_valid, "StreamingCompute is not valid!");
+
+		// Oldest first, from the slot the next chunk would reuse.
+		for (std::uint32_t i = 0; i < m_info.slotCount; ++i)
+		{
+			complete_slot(m_slots[(m_nextSlot + i) % m_info.slotCount]);
+		}
+	}
+
+	auto StreamingCompute::get_pending_count() const -> std::uint32_t
+	{
+		std::uint32_t count = 0;
+		for (const auto& slot : m_slots)
+		{
+			count += slot.readbackHandle ? 1 : 0;
+		}
+		return count;
+	}
+
+	bool StreamingCompute::create_slot(Slot& slot)
+	{
+		if (!create_buffer(slot.stagingBuffer, m_deviceHandle, { .type = BufferType::eUpload, .size = m_info.inputChunkSize, .debugName = "StreamingCompute Staging" }) ||
+			!create_buffer(slot.inputBuffer, m_deviceHandle, { .type = BufferType::eStorage, .size = m_info.inputChunkSize, .debugName = "StreamingCompute Input" }) ||
+			!create_buffer(slot.outputBuffer, m_deviceHandle, { .type = BufferType::eStorage, .size = m_info.outputChunkSize, .debugName = "StreamingCompute Output" }) ||
+			!create_buffer(slot.readbackBuffer, m_deviceHandle, { .type = BufferType::eReadback, .size = m_info.outputChunkSize, .debugName = "StreamingCompute Readback" }))
+		{
+			return false;
+		}
+		slot.stagingPtr = static_cast<std::byte*>(get_mapped_pointer(slot.stagingBuffer));
+		if (slot.stagingPtr == nullptr)
+		{
+			GFX_LOG_ERR("GFX - StreamingCompute - Staging buffer is not mapped!");
+			return false;
+		}
+
+		if (!create_descriptor_set_from_pipeline(slot.descriptorSet, m_info.pipeline, 0))
+		{
+			return false;
+		}
+		bind_buffer_to_descriptor_set(slot.descriptorSet, 0, slot.inputBuffer);
+		bind_buffer_to_descriptor_set(slot.descriptorSet, 1, slot.outputBuffer);
+
+		if (m_separateUpload && !create_command_list(slot.uploadCommandList, m_deviceHandle, m_info.uploadQueueIndex, CommandListFlags_OneTimeSubmit))
+		{
+			return false;
+		}
+		return create_command_list(slot.computeCommandList, m_deviceHandle, m_info.computeQueueIndex, CommandListFlags_OneTimeSubmit);
+	}
+
+	void StreamingCompute::destroy_slot(Slot& slot)
+	{
+		if (slot.computeCommandList)
+		{
+			destroy_command_list(m_deviceHandle, slot.computeCommandList);
+		}
+		if (slot.uploadCommandList)
+		{
+			destroy_command_list(m_deviceHandle, slot.uploadCommandList);
+		}
+		if (slot.descriptorSet)
+		{
+			destroy_descriptor_set(slot.descriptorSet);
+		}
+		for (const auto bufferHandle : { slot.stagingBuffer, slot.inputBuffer, slot.outputBuffer, slot.readbackBuffer })
+		{
+			if (bufferHandle)
+			{
+				destroy_buffer(bufferHandle);
+			}
+		}
+		slot = {};
+	}
+
+	bool StreamingCompute::complete_slot(Slot& slot)
+	{
+		if (!slot.readbackHandle)
+		{
+			return true;
+		}
+
+		// The readback is copied after the dispatches, which waited for the upload, so the whole slot is idle once it resolves.
+		const void* data{ nullptr };
+		const auto readbackHandle = std::exchange(slot.readbackHandle, ReadbackHandle{});
+		if (!resolve_readback(readbackHandle, data, INFINITE_TIMEOUT))
+		{
+			GFX_LOG_ERR("GFX - StreamingCompute - Failed to read back a chunk's output!");
+			destroy_readback(readbackHandle);
+			return false;
+		}
+		if (m_info.consume)
+		{
+			m_info.consume(slot.chunk, { static_cast<const std::byte*>(data), slot.chunk.outputSize });
+		}
+		return true;
+	}
+
+} // namespace sm::gfx
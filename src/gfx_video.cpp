@@ -0,0 +1,732 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx_p.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+namespace sm::gfx
+{
+	namespace
+	{
+		// The most parameter sets of each kind a stream can have, by their id ranges.
+		constexpr std::uint32_t MAX_H264_SPS_COUNT = 32;
+		constexpr std::uint32_t MAX_H264_PPS_COUNT = 256;
+		constexpr std::uint32_t MAX_H265_VPS_COUNT = 16;
+		constexpr std::uint32_t MAX_H265_SPS_COUNT = 16;
+		constexpr std::uint32_t MAX_H265_PPS_COUNT = 64;
+
+		auto round_up(vk::DeviceSize size, vk::DeviceSize alignment) -> vk::DeviceSize
+		{
+			return alignment > 1 ? (size + alignment - 1) / alignment * alignment : size;
+		}
+
+		auto get_std_reference_info(VideoCodec codec, const VideoReference& reference) -> const void*
+		{
+			switch (codec)
+			{
+				case VideoCodec::eH264:
+					return reference.h264ReferenceInfo;
+				case VideoCodec::eH265:
+					return reference.h265ReferenceInfo;
+				case VideoCodec::eAV1:
+					return reference.av1ReferenceInfo;
+			}
+			return nullptr;
+		}
+
+		auto get_std_picture_info(VideoCodec codec, const VideoFrameInfo& frameInfo) -> const void*
+		{
+			switch (codec)
+			{
+				case VideoCodec::eH264:
+					return frameInfo.h264PictureInfo;
+				case VideoCodec::eH265:
+					return frameInfo.h265PictureInfo;
+				case VideoCodec::eAV1:
+					return frameInfo.av1PictureInfo;
+			}
+			return nullptr;
+		}
+
+		template <typename CodecCapabilities>
+		bool get_video_capabilities(vk::PhysicalDevice physicalDevice, const vk::VideoProfileInfoKHR& profile, vk::VideoCapabilitiesKHR& outCapabilities, vk::VideoDecodeCapabilitiesKHR& outDecodeCapabilities)
+		{
+			const auto capabilities_result = physicalDevice.getVideoCapabilitiesKHR<vk::VideoCapabilitiesKHR, vk::VideoDecodeCapabilitiesKHR, CodecCapabilities>(profile);
+			if (capabilities_result.result != vk::Result::eSuccess)
+			{
+				return false;
+			}
+			// Copied out of the chain, so their pNexts would dangle.
+			outCapabilities = capabilities_result.value.template get<vk::VideoCapabilitiesKHR>();
+			outCapabilities.setPNext(nullptr);
+			outDecodeCapabilities = capabilities_result.value.template get<vk::VideoDecodeCapabilitiesKHR>();
+			outDecodeCapabilities.setPNext(nullptr);
+			return true;
+		}
+
+		auto get_picture_resource(vk::ImageView view, std::uint32_t layer, vk::Extent2D extent) -> vk::VideoPictureResourceInfoKHR
+		{
+			vk::VideoPictureResourceInfoKHR picture_resource{};
+			picture_resource.setCodedExtent(extent);
+			picture_resource.setBaseArrayLayer(layer);
+			picture_resource.setImageViewBinding(view);
+			return picture_resource;
+		}
+
+		auto get_picture_barrier(vk::Image image, std::uint32_t layer, vk::ImageLayout oldLayout, vk::ImageLayout newLayout) -> vk::ImageMemoryBarrier2
+		{
+			vk::ImageMemoryBarrier2 barrier{};
+			barrier.setImage(image);
+			barrier.setOldLayout(oldLayout);
+			barrier.setNewLayout(newLayout);
+			// Planes are not disjoint, so the colour aspect covers them all.
+			barrier.setSubresourceRange({ vk::ImageAspectFlagBits::eColor, 0, 1, layer, 1 });
+			return barrier;
+		}
+
+	} // namespace
+
+	VideoDecoder::VideoDecoder(Device& device, const VideoDecoderInfo& decoderInfo)
+		: m_device(device), m_info(decoderInfo), m_allocator(device.get_allocator())
+	{
+		m_valid = init_profile() && create_session() && create_images() && create_bitstream_buffer();
+	}
+
+	bool VideoDecoder::set_parameters(const VideoParameters& parameters)
+	{
+		vk::VideoSessionParametersCreateInfoKHR parameters_info{};
+		parameters_info.setVideoSession(m_session.get());
+
+		vk::VideoDecodeH264SessionParametersAddInfoKHR h264_add_info{};
+		vk::VideoDecodeH264SessionParametersCreateInfoKHR h264_info{};
+		vk::VideoDecodeH265SessionParametersAddInfoKHR h265_add_info{};
+		vk::VideoDecodeH265SessionParametersCreateInfoKHR h265_info{};
+		vk::VideoDecodeAV1SessionParametersCreateInfoKHR av1_info{};
+		switch (m_info.codec)
+		{
+			case VideoCodec::eH264:
+				h264_add_info.setStdSPSCount(parameters.h264SpsCount);
+				h264_add_info.setPStdSPSs(parameters.h264Sps);
+				h264_add_info.setStdPPSCount(parameters.h264PpsCount);
+				h264_add_info.setPStdPPSs(parameters.h264Pps);
+				h264_info.setMaxStdSPSCount(MAX_H264_SPS_COUNT);
+				h264_info.setMaxStdPPSCount(MAX_H264_PPS_COUNT);
+				h264_info.setPParametersAddInfo(&h264_add_info);
+				parameters_info.setPNext(&h264_info);
+				// Sets not given again are inherited from the parameters being replaced.
+				parameters_info.setVideoSessionParametersTemplate(m_parameters.get());
+				break;
+			case VideoCodec::eH265:
+				h265_add_info.setStdVPSCount(parameters.h265VpsCount);
+				h265_add_info.setPStdVPSs(parameters.h265Vps);
+				h265_add_info.setStdSPSCount(parameters.h265SpsCount);
+				h265_add_info.setPStdSPSs(parameters.h265Sps);
+				h265_add_info.setStdPPSCount(parameters.h265PpsCount);
+				h265_add_info.setPStdPPSs(parameters.h265Pps);
+				h265_info.setMaxStdVPSCount(MAX_H265_VPS_COUNT);
+				h265_info.setMaxStdSPSCount(MAX_H265_SPS_COUNT);
+				h265_info.setMaxStdPPSCount(MAX_H265_PPS_COUNT);
+				h265_info.setPParametersAddInfo(&h265_add_info);
+				parameters_info.setPNext(&h265_info);
+				parameters_info.setVideoSessionParametersTemplate(m_parameters.get());
+				break;
+			case VideoCodec::eAV1:
+				if (parameters.av1SequenceHeader == nullptr)
+				{
+					GFX_LOG_ERR("GFX - set_video_parameters() - AV1 parameters need a sequence header!");
+					return false;
+				}
+				av1_info.setPStdSequenceHeader(parameters.av1SequenceHeader);
+				parameters_info.setPNext(&av1_info);
+				break;
+		}
+
+		auto parameters_result = m_device.get_device().createVideoSessionParametersKHRUnique(parameters_info);
+		if (parameters_result.result != vk::Result::eSuccess)
+		{
+			GFX_LOG_ERR("GFX - set_video_parameters() - Failed to create the video session parameters!");
+			return false;
+		}
+
+		// Frames already submitted keep decoding with the parameters they were recorded with.
+		auto retiredParameters = std::make_shared<vk::UniqueVideoSessionParametersKHR>(std::exchange(m_parameters, std::move(parameters_result.value)));
+		m_device.defer_destroy([retiredParameters]() mutable { retiredParameters->reset(); });
+		return true;
+	}
+
+	auto VideoDecoder::decode_frame(const VideoFrameInfo& frameInfo) -> SyncPoint
+	{
+		if (!validate_frame(frameInfo))
+		{
+			return {};
+		}
+
+		const bool shown = frameInfo.lumaTexture || frameInfo.chromaTexture;
+		Texture* lumaTexture{ nullptr };
+		Texture* chromaTexture{ nullptr };
+		if (shown)
+		{
+			const bool wide = m_info.bitDepth > 8;
+			const vk::Extent2D chromaExtent{ (frameInfo.width + 1) / 2, (frameInfo.height + 1) / 2 };
+			if (!get_output_texture(lumaTexture, frameInfo.lumaTexture, wide ? vk::Format::eR16Unorm : vk::Format::eR8Unorm, { frameInfo.width, frameInfo.height }) ||
+				!get_output_texture(chromaTexture, frameInfo.chromaTexture, wide ? vk::Format::eR16G16Unorm : vk::Format::eR8G8Unorm, chromaExtent))
+			{
+				return {};
+			}
+		}
+
+		// Only waits once every slot is in flight, for the oldest frame to have read its bitstream.
+		auto& bitstreamSyncPoint = m_bitstreamSyncPoints[m_nextBitstreamSlot];
+		if (bitstreamSyncPoint.value != 0 && !m_device.wait_on_sync_points({ &bitstreamSyncPoint, 1 }, true, INFINITE_TIMEOUT))
+		{
+			GFX_LOG_ERR("GFX - decode_video_frame() - Failed to wait for a bitstream slot!");
+			return {};
+		}
+		const auto bitstreamOffset = m_nextBitstreamSlot * m_bitstreamSlotSize;
+		const auto bitstreamRange = round_up(frameInfo.bitstreamSize, m_capabilities.minBitstreamBufferSizeAlignment);
+		std::memcpy(m_bitstreamPtr + bitstreamOffset, frameInfo.bitstream, frameInfo.bitstreamSize);
+		std::memset(m_bitstreamPtr + bitstreamOffset + frameInfo.bitstreamSize, 0, bitstreamRange - frameInfo.bitstreamSize);
+
+		CommandListHandle decodeCommandListHandle{};
+		CommandList* decodeCommandList{ nullptr };
+		if (!m_device.create_command_list(decodeCommandListHandle, m_info.decodeQueueIndex, CommandListFlags_FireAndForget) ||
+			!m_device.get_command_list(decodeCommandList, decodeCommandListHandle))
+		{
+			return {};
+		}
+		decodeCommandList->begin();
+		const auto commandBuffer = decodeCommandList->get_command_buffer();
+		record_pre_decode_barriers(commandBuffer, frameInfo);
+		record_decode(commandBuffer, frameInfo, bitstreamOffset, bitstreamRange);
+		record_post_decode_barriers(commandBuffer, frameInfo);
+		decodeCommandList->end();
+
+		// The last copy out of the pictures has to finish before this decode re-lays out or overwrites them.
+		const SubmitBatch decodeBatch{ .commandLists = { &decodeCommandListHandle, 1 }, .waitSyncPoints = { &m_lastOutputSyncPoint, 1 } };
+		const auto decodeSyncPoint = m_device.submit_command_lists(m_info.decodeQueueIndex, { &decodeBatch, 1 });
+		if (decodeSyncPoint.value == 0)
+		{
+			GFX_LOG_ERR("GFX - decode_video_frame() - Failed to submit the decode!");
+			return {};
+		}
+		bitstreamSyncPoint = decodeSyncPoint;
+		m_nextBitstreamSlot = (m_nextBitstreamSlot + 1) % m_info.framesInFlight;
+		if (!shown)
+		{
+			return decodeSyncPoint;
+		}
+
+		CommandListHandle outputCommandListHandle{};
+		CommandList* outputCommandList{ nullptr };
+		if (!m_device.create_command_list(outputCommandListHandle, m_info.outputQueueIndex, CommandListFlags_FireAndForget) ||
+			!m_device.get_command_list(outputCommandList, outputCommandListHandle))
+		{
+			return {};
+		}
+		outputCommandList->begin();
+		record_output(*outputCommandList, frameInfo, lumaTexture, chromaTexture);
+		outputCommandList->end();
+
+		// The textures' own transitions overlap the decode, only the copies wait for it.
+		const SubmitBatch outputBatch{ .commandLists = { &outputCommandListHandle, 1 }, .waitSyncPoints = { &decodeSyncPoint, 1 }, .waitSyncPointStages = PipelineStageFlags_Transfer };
+		const auto outputSyncPoint = m_device.submit_command_lists(m_info.outputQueueIndex, { &outputBatch, 1 });
+		if (outputSyncPoint.value == 0)
+		{
+			GFX_LOG_ERR("GFX - decode_video_frame() - Failed to submit the copy of a decoded frame!");
+			return {};
+		}
+		m_lastOutputSyncPoint = outputSyncPoint;
+		return outputSyncPoint;
+	}
+
+	bool VideoDecoder::init_profile()
+	{
+		if (m_info.bitDepth != 8 && m_info.bitDepth != 10)
+		{
+			GFX_LOG_ERR("GFX - VideoDecoder - Only 8 and 10 bit streams can be decoded!");
+			return false;
+		}
+
+		vk::VideoCodecOperationFlagBitsKHR codecOperation{};
+		const char* codecExtension{ nullptr };
+		switch (m_info.codec)
+		{
+			case VideoCodec::eH264:
+				// Interlaced streams would need field pictures, which are not supported.
+				m_h264Profile.setStdProfileIdc(static_cast<StdVideoH264ProfileIdc>(m_info.profile));
+				m_h264Profile.setPictureLayout(vk::VideoDecodeH264PictureLayoutFlagBitsKHR::eProgressive);
+				m_profile.setPNext(&m_h264Profile);
+				codecOperation = vk::VideoCodecOperationFlagBitsKHR::eDecodeH264;
+				codecExtension = VK_KHR_VIDEO_DECODE_H264_EXTENSION_NAME;
+				break;
+			case VideoCodec::eH265:
+				m_h265Profile.setStdProfileIdc(static_cast<StdVideoH265ProfileIdc>(m_info.profile));
+				m_profile.setPNext(&m_h265Profile);
+				codecOperation = vk::VideoCodecOperationFlagBitsKHR::eDecodeH265;
+				codecExtension = VK_KHR_VIDEO_DECODE_H265_EXTENSION_NAME;
+				break;
+			case VideoCodec::eAV1:
+				m_av1Profile.setStdProfile(static_cast<StdVideoAV1Profile>(m_info.profile));
+				m_av1Profile.setFilmGrainSupport(false);
+				m_profile.setPNext(&m_av1Profile);
+				codecOperation = vk::VideoCodecOperationFlagBitsKHR::eDecodeAv1;
+				codecExtension = VK_KHR_VIDEO_DECODE_AV1_EXTENSION_NAME;
+				break;
+		}
+		if (!m_device.is_extension_available(codecExtension))
+		{
+			GFX_LOG_ERR_FMT("GFX - VideoDecoder - The device does not support {}!", codecExtension);
+			return false;
+		}
+
+		const auto bitDepth = m_info.bitDepth == 8 ? vk::VideoComponentBitDepthFlagBitsKHR::e8 : vk::VideoComponentBitDepthFlagBitsKHR::e10;
+		m_profile.setVideoCodecOperation(codecOperation);
+		m_profile.setChromaSubsampling(vk::VideoChromaSubsamplingFlagBitsKHR::e420);
+		m_profile.setLumaBitDepth(bitDepth);
+		m_profile.setChromaBitDepth(bitDepth);
+		m_profileList.setProfiles(m_profile);
+
+		const auto queueFamily = m_device.get_queue_family(m_info.decodeQueueIndex);
+		const auto queueFamilyProperties = m_device.get_physical_device().getQueueFamilyProperties2<vk::StructureChain<vk::QueueFamilyProperties2, vk::QueueFamilyVideoPropertiesKHR>>();
+		if (!(queueFamilyProperties[queueFamily].get<vk::QueueFamilyVideoPropertiesKHR>().videoCodecOperations & codecOperation))
+		{
+			GFX_LOG_ERR("GFX - VideoDecoder - The decode queue's family cannot decode the codec!");
+			return false;
+		}
+		return true;
+	}
+
+	bool VideoDecoder::create_session()
+	{
+		const auto physicalDevice = m_device.get_physical_device();
+		bool hasCapabilities{ false };
+		switch (m_info.codec)
+		{
+			case VideoCodec::eH264:
+				hasCapabilities = get_video_capabilities<vk::VideoDecodeH264CapabilitiesKHR>(physicalDevice, m_profile, m_capabilities, m_decodeCapabilities);
+				break;
+			case VideoCodec::eH265:
+				hasCapabilities = get_video_capabilities<vk::VideoDecodeH265CapabilitiesKHR>(physicalDevice, m_profile, m_capabilities, m_decodeCapabilities);
+				break;
+			case VideoCodec::eAV1:
+				hasCapabilities = get_video_capabilities<vk::VideoDecodeAV1CapabilitiesKHR>(physicalDevice, m_profile, m_capabilities, m_decodeCapabilities);
+				break;
+		}
+		if (!hasCapabilities)
+		{
+			GFX_LOG_ERR("GFX - VideoDecoder - The device cannot decode the profile or bit depth!");
+			return false;
+		}
+
+		// Pictures are accessed in blocks of the granularity, so the session covers whole blocks.
+		const auto granularity = m_capabilities.pictureAccessGranularity;
+		m_maxCodedExtent = vk::Extent2D{ std::uint32_t(round_up(m_info.maxWidth, granularity.width)), std::uint32_t(round_up(m_info.maxHeight, granularity.height)) };
+		if (m_maxCodedExtent.width > m_capabilities.maxCodedExtent.width || m_maxCodedExtent.height > m_capabilities.maxCodedExtent.height)
+		{
+			GFX_LOG_ERR_FMT("GFX - VideoDecoder - The device decodes at most {}x{}!", m_capabilities.maxCodedExtent.width, m_capabilities.maxCodedExtent.height);
+			return false;
+		}
+		if (m_info.dpbSlotCount == 0 || m_info.dpbSlotCount > m_capabilities.maxDpbSlots)
+		{
+			GFX_LOG_ERR_FMT("GFX - VideoDecoder - The device has at most {} DPB slots!", m_capabilities.maxDpbSlots);
+			return false;
+		}
+		m_maxActiveReferences = std::min(m_info.dpbSlotCount - 1, m_capabilities.maxActiveReferencePictures);
+		m_pictureFormat = m_info.bitDepth == 8 ? vk::Format::eG8B8R82Plane420Unorm : vk::Format::eG10X6B10X6R10X62Plane420Unorm3Pack16;
+
+		vk::VideoSessionCreateInfoKHR session_info{};
+		session_info.setQueueFamilyIndex(m_device.get_queue_family(m_info.decodeQueueIndex));
+		session_info.setPVideoProfile(&m_profile);
+		session_info.setPictureFormat(m_pictureFormat);
+		session_info.setMaxCodedExtent(m_maxCodedExtent);
+		session_info.setReferencePictureFormat(m_pictureFormat);
+		session_info.setMaxDpbSlots(m_info.dpbSlotCount);
+		session_info.setMaxActiveReferencePictures(m_maxActiveReferences);
+		session_info.setPStdHeaderVersion(&m_capabilities.stdHeaderVersion);
+		auto session_result = m_device.get_device().createVideoSessionKHRUnique(session_info);
+		if (session_result.result != vk::Result::eSuccess)
+		{
+			GFX_LOG_ERR("GFX - VideoDecoder - Failed to create the video session!");
+			return false;
+		}
+		m_session = std::move(session_result.value);
+
+		const auto requirements_result = m_device.get_device().getVideoSessionMemoryRequirementsKHR(m_session.get());
+		if (requirements_result.result != vk::Result::eSuccess)
+		{
+			GFX_LOG_ERR("GFX - VideoDecoder - Failed to get the video session's memory requirements!");
+			return false;
+		}
+		std::vector<vk::BindVideoSessionMemoryInfoKHR> bind_infos;
+		for (const auto& requirements : requirements_result.value)
+		{
+			vma::AllocationCreateInfo alloc_info{};
+			alloc_info.setPreferredFlags(vk::MemoryPropertyFlagBits::eDeviceLocal);
+			vma::AllocationInfo allocation_info{};
+			auto allocation_result = m_allocator.allocateMemoryUnique(requirements.memoryRequirements, alloc_info, allocation_info);
+			if (allocation_result.result != vk::Result::eSuccess)
+			{
+				GFX_LOG_ERR("GFX - VideoDecoder - Failed to allocate the video session's memory!");
+				return false;
+			}
+			m_sessionMemory.push_back(std::move(allocation_result.value));
+			bind_infos.emplace_back(requirements.memoryBindIndex, allocation_info.deviceMemory, allocation_info.offset, allocation_info.size);
+		}
+		if (m_device.get_device().bindVideoSessionMemoryKHR(m_session.get(), bind_infos) != vk::Result::eSuccess)
+		{
+			GFX_LOG_ERR("GFX - VideoDecoder - Failed to bind the video session's memory!");
+			return false;
+		}
+		return true;
+	}
+
+	bool VideoDecoder::create_picture_image(PictureImage& outImage, vk::ImageUsageFlags usage, std::uint32_t layerCount)
+	{
+		const auto physicalDevice = m_device.get_physical_device();
+		const auto formats_result = physicalDevice.getVideoFormatPropertiesKHR(vk::PhysicalDeviceVideoFormatInfoKHR{ usage, &m_profileList });
+		if (formats_result.result != vk::Result::eSuccess)
+		{
+			return false;
+		}
+		const auto formatIt = std::ranges::find_if(formats_result.value,
+												   [&](const vk::VideoFormatPropertiesKHR& properties)
+												   { return properties.format == m_pictureFormat && (properties.imageUsageFlags & usage) == usage; });
+		if (formatIt == formats_result.value.end())
+		{
+			return false;
+		}
+
+		const std::array queueFamilies{ m_device.get_queue_family(m_info.decodeQueueIndex), m_device.get_queue_family(m_info.outputQueueIndex) };
+		vk::ImageCreateInfo image_info{};
+		image_info.setPNext(&m_profileList);
+		image_info.setImageType(formatIt->imageType);
+		image_info.setFormat(m_pictureFormat);
+		image_info.setExtent({ m_maxCodedExtent.width, m_maxCodedExtent.height, 1 });
+		image_info.setMipLevels(1);
+		image_info.setArrayLayers(layerCount);
+		image_info.setTiling(formatIt->imageTiling);
+		image_info.setUsage(usage);
+		image_info.setInitialLayout(vk::ImageLayout::eUndefined);
+		// Copied out on the output queue, with no ownership transfers between the two.
+		if (queueFamilies[0] != queueFamilies[1])
+		{
+			image_info.setSharingMode(vk::SharingMode::eConcurrent);
+			image_info.setQueueFamilyIndices(queueFamilies);
+		}
+		vma::AllocationCreateInfo alloc_info{};
+		alloc_info.setUsage(vma::MemoryUsage::eAutoPreferDevice);
+		auto image_result = m_allocator.createImageUnique(image_info, alloc_info);
+		if (image_result.result != vk::Result::eSuccess)
+		{
+			return false;
+		}
+		std::tie(outImage.image, outImage.allocation) = std::move(image_result.value);
+
+		// The view is only used by the decoder, while the image's transfer usage is for the copies.
+		vk::ImageViewUsageCreateInfo view_usage_info{ usage & (vk::ImageUsageFlagBits::eVideoDecodeDpbKHR | vk::ImageUsageFlagBits::eVideoDecodeDstKHR) };
+		vk::ImageViewCreateInfo view_info{};
+		view_info.setPNext(&view_usage_info);
+		view_info.setImage(outImage.image.get());
+		view_info.setViewType(vk::ImageViewType::e2DArray);
+		view_info.setFormat(m_pictureFormat);
+		view_info.setSubresourceRange({ vk::ImageAspectFlagBits::eColor, 0, 1, 0, layerCount });
+		auto view_result = m_device.get_device().createImageViewUnique(view_info);
+		if (view_result.result != vk::Result::eSuccess)
+		{
+			return false;
+		}
+		outImage.view = std::move(view_result.value);
+		return true;
+	}
+
+	bool VideoDecoder::create_images()
+	{
+		constexpr auto DPB = vk::ImageUsageFlagBits::eVideoDecodeDpbKHR;
+		constexpr auto DST = vk::ImageUsageFlagBits::eVideoDecodeDstKHR;
+		constexpr auto TRANSFER_SRC = vk::ImageUsageFlagBits::eTransferSrc;
+
+		// Decoding straight into the DPB saves a picture sized image and writing each frame twice.
+		m_dpbIsOutput = bool(m_decodeCapabilities.flags & vk::VideoDecodeCapabilityFlagBitsKHR::eDpbAndOutputCoincide) &&
+						create_picture_image(m_dpb, DPB | DST | TRANSFER_SRC, m_info.dpbSlotCount);
+		if (!m_dpbIsOutput)
+		{
+			if (!(m_decodeCapabilities.flags & vk::VideoDecodeCapabilityFlagBitsKHR::eDpbAndOutputDistinct) ||
+				!create_picture_image(m_dpb, DPB, m_info.dpbSlotCount) || !create_picture_image(m_output, DST | TRANSFER_SRC, 1))
+			{
+				GFX_LOG_ERR("GFX - VideoDecoder - Failed to create the decoded picture images!");
+				return false;
+			}
+		}
+		m_dpbLayouts.assign(m_info.dpbSlotCount, vk::ImageLayout::eUndefined);
+		return true;
+	}
+
+	bool VideoDecoder::create_bitstream_buffer()
+	{
+		m_bitstreamSlotSize = round_up(round_up(m_info.maxBitstreamSize, m_capabilities.minBitstreamBufferSizeAlignment), m_capabilities.minBitstreamBufferOffsetAlignment);
+
+		vk::BufferCreateInfo buffer_info{};
+		buffer_info.setPNext(&m_profileList);
+		buffer_info.setSize(m_bitstreamSlotSize * m_info.framesInFlight);
+		buffer_info.setUsage(vk::BufferUsageFlagBits::eVideoDecodeSrcKHR);
+		vma::AllocationCreateInfo alloc_info{};
+		alloc_info.setUsage(vma::MemoryUsage::eAutoPreferDevice);
+		alloc_info.setFlags(vma::AllocationCreateFlagBits::eHostAccessSequentialWrite | vma::AllocationCreateFlagBits::eMapped);
+		// Written with plain copies, so there is nothing to flush.
+		alloc_info.setRequiredFlags(vk::MemoryPropertyFlagBits::eHostCoherent);
+		auto buffer_result = m_allocator.createBufferUnique(buffer_info, alloc_info);
+		if (buffer_result.result != vk::Result::eSuccess)
+		{
+			GFX_LOG_ERR("GFX - VideoDecoder - Failed to create the bitstream buffer!");
+			return false;
+		}
+		std::tie(m_bitstreamBuffer, m_bitstreamAllocation) = std::move(buffer_result.value);
+		m_bitstreamPtr = static_cast<std::byte*>(m_allocator.getAllocationInfo(m_bitstreamAllocation.get()).pMappedData);
+		m_bitstreamSyncPoints.resize(m_info.framesInFlight);
+		return true;
+	}
+
+	bool VideoDecoder::validate_frame(const VideoFrameInfo& frameInfo) const
+	{
+		if (!m_parameters)
+		{
+			GFX_LOG_ERR("GFX - decode_video_frame() - set_video_parameters() has not been called yet!");
+			return false;
+		}
+		if (frameInfo.bitstream == nullptr || frameInfo.bitstreamSize == 0 || frameInfo.bitstreamSize > m_info.maxBitstreamSize)
+		{
+			GFX_LOG_ERR("GFX - decode_video_frame() - The bitstream must be set, and at most VideoDecoderInfo::maxBitstreamSize!");
+			return false;
+		}
+		if (frameInfo.width < m_capabilities.minCodedExtent.width || frameInfo.height < m_capabilities.minCodedExtent.height ||
+			frameInfo.width > m_maxCodedExtent.width || frameInfo.height > m_maxCodedExtent.height)
+		{
+			GFX_LOG_ERR("GFX - decode_video_frame() - The frame's size is outside of what the decoder was created for!");
+			return false;
+		}
+		if (get_std_picture_info(m_info.codec, frameInfo) == nullptr || frameInfo.sliceOffsets.empty() ||
+			(m_info.codec == VideoCodec::eAV1 && frameInfo.av1TileSizes.size() != frameInfo.sliceOffsets.size()))
+		{
+			GFX_LOG_ERR("GFX - decode_video_frame() - Frames need the codec's picture info and their slice or tile offsets (and AV1 tile sizes)!");
+			return false;
+		}
+
+		const auto isValidReference = [this](const VideoReference& reference)
+		{ return reference.dpbSlot < m_info.dpbSlotCount && get_std_reference_info(m_info.codec, reference) != nullptr; };
+		if (!isValidReference(frameInfo.setupReference) || !std::ranges::all_of(frameInfo.references, isValidReference))
+		{
+			GFX_LOG_ERR("GFX - decode_video_frame() - References need a DPB slot below dpbSlotCount and the codec's reference info!");
+			return false;
+		}
+		if (frameInfo.references.size() > m_maxActiveReferences)
+		{
+			GFX_LOG_ERR_FMT("GFX - decode_video_frame() - The decoder references at most {} pictures per frame!", m_maxActiveReferences);
+			return false;
+		}
+		return true;
+	}
+
+	bool VideoDecoder::get_output_texture(Texture*& outTexture, TextureHandle textureHandle, vk::Format format, vk::Extent2D extent) const
+	{
+		if (textureHandle.deviceHandle != m_device.get_handle() || !m_device.get_texture(outTexture, textureHandle))
+		{
+			GFX_LOG_ERR("GFX - decode_video_frame() - Frames shown need both a valid luma and chroma texture!");
+			return false;
+		}
+		const auto textureExtent = outTexture->get_extent();
+		if (outTexture->get_format() != format || textureExtent.width < extent.width || textureExtent.height < extent.height)
+		{
+			GFX_LOG_ERR("GFX - decode_video_frame() - A plane texture's format or size does not fit the frame!");
+			return false;
+		}
+		return true;
+	}
+
+	void VideoDecoder::record_pre_decode_barriers(vk::CommandBuffer commandBuffer, const VideoFrameInfo& frameInfo)
+	{
+		// Earlier decodes wrote the pictures this one references, and may still be writing the slot it overwrites.
+		vk::MemoryBarrier2 memory_barrier{};
+		memory_barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eVideoDecodeKHR);
+		memory_barrier.setSrcAccessMask(vk::AccessFlagBits2::eVideoDecodeWriteKHR);
+		memory_barrier.setDstStageMask(vk::PipelineStageFlagBits2::eVideoDecodeKHR);
+		memory_barrier.setDstAccessMask(vk::AccessFlagBits2::eVideoDecodeReadKHR | vk::AccessFlagBits2::eVideoDecodeWriteKHR);
+
+		// Slots start undefined, and shown ones were left for their copy. The copies were waited for by the submission.
+		std::vector<vk::ImageMemoryBarrier2> image_barriers;
+		const auto add_slot_barrier = [&](std::uint32_t slot)
+		{
+			if (m_dpbLayouts[slot] == vk::ImageLayout::eVideoDecodeDpbKHR)
+			{
+				return;
+			}
+			auto& barrier = image_barriers.emplace_back(get_picture_barrier(m_dpb.image.get(), slot, m_dpbLayouts[slot], vk::ImageLayout::eVideoDecodeDpbKHR));
+			barrier.setDstStageMask(vk::PipelineStageFlagBits2::eVideoDecodeKHR);
+			barrier.setDstAccessMask(vk::AccessFlagBits2::eVideoDecodeReadKHR | vk::AccessFlagBits2::eVideoDecodeWriteKHR);
+			m_dpbLayouts[slot] = vk::ImageLayout::eVideoDecodeDpbKHR;
+		};
+		for (const auto& reference : frameInfo.references)
+		{
+			add_slot_barrier(reference.dpbSlot);
+		}
+		add_slot_barrier(frameInfo.setupReference.dpbSlot);
+		if (!m_dpbIsOutput)
+		{
+			// Overwritten whole by each frame.
+			auto& barrier = image_barriers.emplace_back(get_picture_barrier(m_output.image.get(), 0, vk::ImageLayout::eUndefined, vk::ImageLayout::eVideoDecodeDstKHR));
+			barrier.setDstStageMask(vk::PipelineStageFlagBits2::eVideoDecodeKHR);
+			barrier.setDstAccessMask(vk::AccessFlagBits2::eVideoDecodeWriteKHR);
+		}
+
+		vk::DependencyInfo dependency_info{};
+		dependency_info.setMemoryBarriers(memory_barrier);
+		dependency_info.setImageMemoryBarriers(image_barriers);
+		commandBuffer.pipelineBarrier2(dependency_info);
+	}
+
+	void VideoDecoder::record_decode(vk::CommandBuffer commandBuffer, const VideoFrameInfo& frameInfo, vk::DeviceSize bitstreamOffset, vk::DeviceSize bitstreamRange)
+	{
+		const vk::Extent2D extent{ frameInfo.width, frameInfo.height };
+
+		// The frame's references, then its setup slot last. Sized up front, as the slot infos point into each other.
+		struct SlotInfo
+		{
+			vk::VideoPictureResourceInfoKHR pictureResource{};
+			vk::VideoDecodeH264DpbSlotInfoKHR h264{};
+			vk::VideoDecodeH265DpbSlotInfoKHR h265{};
+			vk::VideoDecodeAV1DpbSlotInfoKHR av1{};
+		};
+		const auto referenceCount = frameInfo.references.size();
+		std::vector<SlotInfo> slot_infos(referenceCount + 1);
+		std::vector<vk::VideoReferenceSlotInfoKHR> reference_slots(referenceCount + 1);
+		const auto fill_slot = [&](std::size_t index, const VideoReference& reference)
+		{
+			auto& slot_info = slot_infos[index];
+			auto& reference_slot = reference_slots[index];
+			slot_info.pictureResource = get_picture_resource(m_dpb.view.get(), reference.dpbSlot, extent);
+			reference_slot.setSlotIndex(std::int32_t(reference.dpbSlot));
+			reference_slot.setPPictureResource(&slot_info.pictureResource);
+			switch (m_info.codec)
+			{
+				case VideoCodec::eH264:
+					slot_info.h264.setPStdReferenceInfo(reference.h264ReferenceInfo);
+					reference_slot.setPNext(&slot_info.h264);
+					break;
+				case VideoCodec::eH265:
+					slot_info.h265.setPStdReferenceInfo(reference.h265ReferenceInfo);
+					reference_slot.setPNext(&slot_info.h265);
+					break;
+				case VideoCodec::eAV1:
+					slot_info.av1.setPStdReferenceInfo(reference.av1ReferenceInfo);
+					reference_slot.setPNext(&slot_info.av1);
+					break;
+			}
+		};
+		for (std::size_t i = 0; i < referenceCount; ++i)
+		{
+			fill_slot(i, frameInfo.references[i]);
+		}
+		fill_slot(referenceCount, frameInfo.setupReference);
+
+		// The setup slot's picture is bound without activating the slot, which the decode does.
+		std::vector<vk::VideoReferenceSlotInfoKHR> bound_slots(reference_slots.begin(), reference_slots.end());
+		bound_slots.back().setSlotIndex(-1);
+		vk::VideoBeginCodingInfoKHR begin_info{};
+		begin_info.setVideoSession(m_session.get());
+		begin_info.setVideoSessionParameters(m_parameters.get());
+		begin_info.setReferenceSlots(bound_slots);
+		commandBuffer.beginVideoCodingKHR(begin_info);
+		if (!m_sessionReset)
+		{
+			commandBuffer.controlVideoCodingKHR(vk::VideoCodingControlInfoKHR{ vk::VideoCodingControlFlagBitsKHR::eReset });
+			m_sessionReset = true;
+		}
+
+		vk::VideoDecodeInfoKHR decode_info{};
+		decode_info.setSrcBuffer(m_bitstreamBuffer.get());
+		decode_info.setSrcBufferOffset(bitstreamOffset);
+		decode_info.setSrcBufferRange(bitstreamRange);
+		decode_info.setDstPictureResource(m_dpbIsOutput ? slot_infos.back().pictureResource : get_picture_resource(m_output.view.get(), 0, extent));
+		decode_info.setPSetupReferenceSlot(&reference_slots.back());
+		decode_info.setReferenceSlotCount(std::uint32_t(referenceCount));
+		decode_info.setPReferenceSlots(reference_slots.data());
+
+		const auto sliceCount = std::uint32_t(frameInfo.sliceOffsets.size());
+		vk::VideoDecodeH264PictureInfoKHR h264_picture_info{};
+		vk::VideoDecodeH265PictureInfoKHR h265_picture_info{};
+		vk::VideoDecodeAV1PictureInfoKHR av1_picture_info{};
+		switch (m_info.codec)
+		{
+			case VideoCodec::eH264:
+				h264_picture_info.setPStdPictureInfo(frameInfo.h264PictureInfo);
+				h264_picture_info.setSliceCount(sliceCount);
+				h264_picture_info.setPSliceOffsets(frameInfo.sliceOffsets.data());
+				decode_info.setPNext(&h264_picture_info);
+				break;
+			case VideoCodec::eH265:
+				h265_picture_info.setPStdPictureInfo(frameInfo.h265PictureInfo);
+				h265_picture_info.setSliceSegmentCount(sliceCount);
+				h265_picture_info.setPSliceSegmentOffsets(frameInfo.sliceOffsets.data());
+				decode_info.setPNext(&h265_picture_info);
+				break;
+			case VideoCodec::eAV1:
+				av1_picture_info.setPStdPictureInfo(frameInfo.av1PictureInfo);
+				av1_picture_info.setReferenceNameSlotIndices(frameInfo.av1ReferenceNameSlots);
+				av1_picture_info.setFrameHeaderOffset(frameInfo.av1FrameHeaderOffset);
+				av1_picture_info.setTileCount(sliceCount);
+				av1_picture_info.setPTileOffsets(frameInfo.sliceOffsets.data());
+				av1_picture_info.setPTileSizes(frameInfo.av1TileSizes.data());
+				decode_info.setPNext(&av1_picture_info);
+				break;
+		}
+		commandBuffer.decodeVideoKHR(decode_info);
+		commandBuffer.endVideoCodingKHR(vk::VideoEndCodingInfoKHR{});
+	}
+
+	void VideoDecoder::record_post_decode_barriers(vk::CommandBuffer commandBuffer, const VideoFrameInfo& frameInfo)
+	{
+		if (!frameInfo.lumaTexture)
+		{
+			return;
+		}
+
+		// The copy's queue waits for this submission, which makes the decode's writes visible to it.
+		vk::ImageMemoryBarrier2 barrier{};
+		if (m_dpbIsOutput)
+		{
+			const auto slot = frameInfo.setupReference.dpbSlot;
+			barrier = get_picture_barrier(m_dpb.image.get(), slot, vk::ImageLayout::eVideoDecodeDpbKHR, vk::ImageLayout::eTransferSrcOptimal);
+			m_dpbLayouts[slot] = vk::ImageLayout::eTransferSrcOptimal;
+		}
+		else
+		{
+			barrier = get_picture_barrier(m_output.image.get(), 0, vk::ImageLayout::eVideoDecodeDstKHR, vk::ImageLayout::eTransferSrcOptimal);
+		}
+		barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eVideoDecodeKHR);
+		barrier.setSrcAccessMask(vk::AccessFlagBits2::eVideoDecodeWriteKHR);
+
+		vk::DependencyInfo dependency_info{};
+		dependency_info.setImageMemoryBarriers(barrier);
+		commandBuffer.pipelineBarrier2(dependency_info);
+	}
+
+	void VideoDecoder::record_output(CommandList& commandList, const VideoFrameInfo& frameInfo, Texture* lumaTexture, Texture* chromaTexture)
+	{
+		const auto srcImage = m_dpbIsOutput ? m_dpb.image.get() : m_output.image.get();
+		const auto srcLayer = m_dpbIsOutput ? frameInfo.setupReference.dpbSlot : 0;
+		const vk::Extent2D lumaExtent{ frameInfo.width, frameInfo.height };
+		const vk::Extent2D chromaExtent{ (frameInfo.width + 1) / 2, (frameInfo.height + 1) / 2 };
+
+		commandList.transition_texture(lumaTexture, TextureState::eUploadDst, 0, 1, 0, 1);
+		commandList.transition_texture(chromaTexture, TextureState::eUploadDst, 0, 1, 0, 1);
+		commandList.copy_video_plane(srcImage, vk::ImageAspectFlagBits::ePlane0, srcLayer, lumaTexture, lumaExtent);
+		commandList.copy_video_plane(srcImage, vk::ImageAspectFlagBits::ePlane1, srcLayer, chromaTexture, chromaExtent);
+		commandList.transition_texture(lumaTexture, TextureState::eShaderRead, 0, 1, 0, 1);
+		commandList.transition_texture(chromaTexture, TextureState::eShaderRead, 0, 1, 0, 1);
+	}
+
+} // namespace sm::gfx
@@ -0,0 +1,74 @@
+// Shared by the ComputePrimitives kernels: 256 threads per group, each owning 4 consecutive elements of a 1024 element block.
+
+#define GROUP_SIZE 256
+#define ELEMENTS_PER_THREAD 4
+#define BLOCK_SIZE (GROUP_SIZE * ELEMENTS_PER_THREAD)
+
+// Set by ComputePrimitives when the device has subgroup basic, arithmetic and ballot operations in compute shaders.
+[[vk::constant_id(0)]] const bool UseSubgroups = false;
+
+groupshared uint GroupScratch[GROUP_SIZE];
+groupshared uint GroupTotal;
+
+// The subgroup path scans the subgroup totals within the first subgroup, so needs at most as many subgroups as lanes.
+bool use_subgroups()
+{
+    return UseSubgroups && WaveGetLaneCount() * WaveGetLaneCount() >= GROUP_SIZE;
+}
+
+// Exclusive prefix sum of one value per thread, in thread order, and the group's total. Every thread must call it.
+uint group_exclusive_sum(uint value, uint threadIndex, out uint groupTotal)
+{
+    uint result;
+    if (use_subgroups())
+    {
+        uint laneCount = WaveGetLaneCount();
+        uint lane = WaveGetLaneIndex();
+        uint wave = threadIndex / laneCount;
+        uint wavePrefix = WavePrefixSum(value);
+        if (lane == laneCount - 1)
+        {
+            GroupScratch[wave] = wavePrefix + value;
+        }
+        GroupMemoryBarrierWithGroupSync();
+        if (wave == 0)
+        {
+            uint waveCount = GROUP_SIZE / laneCount;
+            uint waveTotal = lane < waveCount ? GroupScratch[lane] : 0;
+            uint wavesBefore = WavePrefixSum(waveTotal);
+            if (lane < waveCount)
+            {
+                GroupScratch[lane] = wavesBefore;
+            }
+            if (lane == waveCount - 1)
+            {
+                GroupTotal = wavesBefore + waveTotal;
+            }
+        }
+        GroupMemoryBarrierWithGroupSync();
+        result = GroupScratch[wave] + wavePrefix;
+    }
+    else
+    {
+        // Hillis-Steele over shared memory.
+        GroupScratch[threadIndex] = value;
+        GroupMemoryBarrierWithGroupSync();
+        for (uint offset = 1; offset < GROUP_SIZE; offset <<= 1)
+        {
+            uint add = threadIndex >= offset ? GroupScratch[threadIndex - offset] : 0;
+            GroupMemoryBarrierWithGroupSync();
+            GroupScratch[threadIndex] += add;
+            GroupMemoryBarrierWithGroupSync();
+        }
+        result = GroupScratch[threadIndex] - value;
+        if (threadIndex == GROUP_SIZE - 1)
+        {
+            GroupTotal = GroupScratch[threadIndex];
+        }
+        GroupMemoryBarrierWithGroupSync();
+    }
+    groupTotal = GroupTotal;
+    // Leave the scratch free for the next call.
+    GroupMemoryBarrierWithGroupSync();
+    return result;
+}
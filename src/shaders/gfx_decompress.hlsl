@@ -0,0 +1,142 @@
+// Decompresses the blocks of streams from compress_for_gpu(), one workgroup per block. Every thread parses the block's
+// sequences in step, as they all read the same bytes, while literals and matches are copied a byte per thread into
+// groupshared memory, written out a word per thread once the block is done. The format is described in gfx_gpu_decompress.cpp.
+
+#define GROUP_SIZE 64
+#define BLOCK_SIZE 16384
+#define MIN_MATCH 4
+
+struct DecompressConstants
+{
+    uint tableOffset;
+    uint firstBlock;
+};
+[[vk::push_constant]] DecompressConstants Constants;
+
+struct Block
+{
+    uint srcOffset;
+    uint srcSize;
+    uint dstOffset;
+    uint dstSize;
+};
+
+[[vk::binding(0, 0)]] ByteAddressBuffer Input;
+[[vk::binding(1, 0)]] RWByteAddressBuffer Output;
+
+groupshared uint Decompressed[BLOCK_SIZE / 4];
+
+uint read_input(uint address)
+{
+    return (Input.Load(address & ~3u) >> ((address & 3u) * 8u)) & 0xFFu;
+}
+
+// Blocks start at any byte of the transient buffer, and only the bytes within the block are read.
+uint read_input_word(uint address, uint remaining)
+{
+    uint word = 0;
+    for (uint i = 0; i < min(remaining, 4u); ++i)
+    {
+        word |= read_input(address + i) << (i * 8u);
+    }
+    return word;
+}
+
+uint read_length(inout uint src, uint srcEnd)
+{
+    uint length = 0;
+    uint extra = 255u;
+    while (extra == 255u && src < srcEnd)
+    {
+        extra = read_input(src++);
+        length += extra;
+    }
+    return length;
+}
+
+uint read_decompressed(uint address)
+{
+    return (Decompressed[address >> 2u] >> ((address & 3u) * 8u)) & 0xFFu;
+}
+
+// Neighbouring threads write bytes of the same word.
+void write_decompressed(uint address, uint value)
+{
+    InterlockedOr(Decompressed[address >> 2u], value << ((address & 3u) * 8u));
+}
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void Main(uint3 GId : SV_GroupID, uint GI : SV_GroupIndex)
+{
+    uint4 entry = Input.Load4(Constants.tableOffset + (Constants.firstBlock + GId.x) * 16u);
+    Block block = { entry.x, entry.y, entry.z, entry.w };
+    uint wordCount = (block.dstSize + 3u) / 4u;
+
+    // Stored uncompressed.
+    if (block.srcSize == block.dstSize)
+    {
+        for (uint word = GI; word < wordCount; word += GROUP_SIZE)
+        {
+            Output.Store(block.dstOffset + word * 4u, read_input_word(block.srcOffset + word * 4u, block.srcSize - word * 4u));
+        }
+        return;
+    }
+
+    for (uint word = GI; word < wordCount; word += GROUP_SIZE)
+    {
+        Decompressed[word] = 0;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // Lengths are clamped and malformed offsets end the block, so bad data cannot write outside it or loop forever.
+    uint src = block.srcOffset;
+    uint srcEnd = block.srcOffset + block.srcSize;
+    uint dst = 0;
+    while (src < srcEnd)
+    {
+        uint token = read_input(src++);
+        uint literalLength = token >> 4u;
+        if (literalLength == 15u)
+        {
+            literalLength += read_length(src, srcEnd);
+        }
+        literalLength = min(literalLength, min(srcEnd - src, block.dstSize - dst));
+        for (uint i = GI; i < literalLength; i += GROUP_SIZE)
+        {
+            write_decompressed(dst + i, read_input(src + i));
+        }
+        src += literalLength;
+        dst += literalLength;
+        if (src + 2u > srcEnd)
+        {
+            break;
+        }
+
+        uint offset = read_input(src) | (read_input(src + 1u) << 8u);
+        src += 2u;
+        uint matchLength = (token & 0xFu) + MIN_MATCH;
+        if ((token & 0xFu) == 15u)
+        {
+            matchLength += read_length(src, srcEnd);
+        }
+        if (offset == 0u || offset > dst)
+        {
+            break;
+        }
+        matchLength = min(matchLength, block.dstSize - dst);
+
+        // The match reads what earlier sequences wrote. When it overlaps itself, it repeats its first offset bytes.
+        GroupMemoryBarrierWithGroupSync();
+        for (uint i = GI; i < matchLength; i += GROUP_SIZE)
+        {
+            write_decompressed(dst + i, read_decompressed(dst - offset + i % offset));
+        }
+        dst += matchLength;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint word = GI; word < wordCount; word += GROUP_SIZE)
+    {
+        Output.Store(block.dstOffset + word * 4u, Decompressed[word]);
+    }
+}
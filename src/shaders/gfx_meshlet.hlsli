@@ -0,0 +1,33 @@
+// The meshlet layouts of MeshletBuffers (includes/gfx/gfx_mesh.hpp), for mesh, task and culling shaders to include.
+
+#define MAX_MESHLET_VERTICES 64
+#define MAX_MESHLET_TRIANGLES 124
+
+struct Meshlet
+{
+    uint vertexOffset;   // Into the meshlet vertex buffer.
+    uint triangleOffset; // Into the meshlet triangle buffer.
+    uint vertexCount;
+    uint triangleCount;
+};
+
+struct MeshletBounds
+{
+    float3 center;
+    float radius;
+    float3 coneAxis;
+    float coneCutoff;
+};
+
+// The meshlet local vertex indices of a packed triangle.
+uint3 unpack_meshlet_triangle(uint packedTriangle)
+{
+    return uint3(packedTriangle & 0xFF, (packedTriangle >> 8) & 0xFF, (packedTriangle >> 16) & 0xFF);
+}
+
+// True when every triangle of the meshlet faces away from a camera at cameraPosition, in the bounds' space.
+bool is_meshlet_backfacing(MeshletBounds bounds, float3 cameraPosition)
+{
+    float3 toCenter = bounds.center - cameraPosition;
+    return dot(toCenter, bounds.coneAxis) >= bounds.coneCutoff * length(toCenter) + bounds.radius;
+}
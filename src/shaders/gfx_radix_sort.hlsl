@@ -0,0 +1,116 @@
+// One 4-bit digit pass of a stable least significant digit radix sort of uint keys, with optional uint values. The count
+// pass writes each block's digit counts digit major, ComputePrimitives scans them into where each block's run of each
+// digit starts, and the scatter pass ranks the block's keys within their digit and moves them there.
+
+#include "gfx_compute_common.hlsli"
+
+#define RADIX_BINS 16
+
+static const uint Pass_Count = 0;
+static const uint Pass_Scatter = 1;
+
+struct RadixSortConstants
+{
+    uint count;
+    uint shift;
+    uint pass;
+    uint blockCount;
+    uint hasValues;
+};
+[[vk::push_constant]] RadixSortConstants Constants;
+
+[[vk::binding(0, 0)]] RWStructuredBuffer<uint> KeysIn;
+[[vk::binding(1, 0)]] RWStructuredBuffer<uint> KeysOut;
+[[vk::binding(2, 0)]] RWStructuredBuffer<uint> ValuesIn;
+[[vk::binding(3, 0)]] RWStructuredBuffer<uint> ValuesOut;
+[[vk::binding(4, 0)]] RWStructuredBuffer<uint> Histograms;
+
+groupshared uint Bins[RADIX_BINS];
+
+void count_digits(uint groupIndex, uint threadIndex)
+{
+    if (threadIndex < RADIX_BINS)
+    {
+        Bins[threadIndex] = 0;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    uint first = groupIndex * BLOCK_SIZE + threadIndex * ELEMENTS_PER_THREAD;
+    for (uint i = 0; i < ELEMENTS_PER_THREAD; ++i)
+    {
+        if (first + i < Constants.count)
+        {
+            uint digit = (KeysIn[first + i] >> Constants.shift) & (RADIX_BINS - 1);
+            InterlockedAdd(Bins[digit], 1);
+        }
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (threadIndex < RADIX_BINS)
+    {
+        Histograms[threadIndex * Constants.blockCount + groupIndex] = Bins[threadIndex];
+    }
+}
+
+void scatter(uint groupIndex, uint threadIndex)
+{
+    uint first = groupIndex * BLOCK_SIZE + threadIndex * ELEMENTS_PER_THREAD;
+    uint keys[ELEMENTS_PER_THREAD];
+    uint digits[ELEMENTS_PER_THREAD];
+    uint destinations[ELEMENTS_PER_THREAD];
+    for (uint i = 0; i < ELEMENTS_PER_THREAD; ++i)
+    {
+        bool valid = first + i < Constants.count;
+        keys[i] = valid ? KeysIn[first + i] : 0;
+        digits[i] = valid ? (keys[i] >> Constants.shift) & (RADIX_BINS - 1) : RADIX_BINS;
+        destinations[i] = 0;
+    }
+
+    // Rank each key among the block's keys of its digit: those of earlier threads, then earlier ones of this thread.
+    for (uint digit = 0; digit < RADIX_BINS; ++digit)
+    {
+        uint threadCount = 0;
+        for (uint j = 0; j < ELEMENTS_PER_THREAD; ++j)
+        {
+            threadCount += digits[j] == digit ? 1 : 0;
+        }
+        uint digitTotal;
+        uint rank = group_exclusive_sum(threadCount, threadIndex, digitTotal);
+        if (threadCount != 0)
+        {
+            rank += Histograms[digit * Constants.blockCount + groupIndex];
+            for (uint k = 0; k < ELEMENTS_PER_THREAD; ++k)
+            {
+                if (digits[k] == digit)
+                {
+                    destinations[k] = rank++;
+                }
+            }
+        }
+    }
+
+    for (uint m = 0; m < ELEMENTS_PER_THREAD; ++m)
+    {
+        if (digits[m] != RADIX_BINS)
+        {
+            KeysOut[destinations[m]] = keys[m];
+            if (Constants.hasValues != 0)
+            {
+                ValuesOut[destinations[m]] = ValuesIn[first + m];
+            }
+        }
+    }
+}
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void Main(uint3 GId : SV_GroupID, uint3 GTId : SV_GroupThreadID)
+{
+    if (Constants.pass == Pass_Count)
+    {
+        count_digits(GId.x, GTId.x);
+    }
+    else
+    {
+        scatter(GId.x, GTId.x);
+    }
+}
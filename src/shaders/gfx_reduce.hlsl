@@ -0,0 +1,100 @@
+// Reduces each 1024 element block of uints to one value. See ComputePrimitives::reduce() for how the levels combine.
+
+#include "gfx_compute_common.hlsli"
+
+static const uint Op_Add = 0;
+static const uint Op_Min = 1;
+static const uint Op_Max = 2;
+
+struct ReduceConstants
+{
+    uint count;
+    uint inputOffset;
+    uint outputOffset;
+    uint op;
+};
+[[vk::push_constant]] ReduceConstants Constants;
+
+[[vk::binding(0, 0)]] RWStructuredBuffer<uint> Input;
+[[vk::binding(1, 0)]] RWStructuredBuffer<uint> Output;
+
+uint identity()
+{
+    return Constants.op == Op_Min ? 0xFFFFFFFF : 0;
+}
+
+uint combine(uint a, uint b)
+{
+    if (Constants.op == Op_Min)
+    {
+        return min(a, b);
+    }
+    if (Constants.op == Op_Max)
+    {
+        return max(a, b);
+    }
+    return a + b;
+}
+
+uint wave_combine(uint value)
+{
+    if (Constants.op == Op_Min)
+    {
+        return WaveActiveMin(value);
+    }
+    if (Constants.op == Op_Max)
+    {
+        return WaveActiveMax(value);
+    }
+    return WaveActiveSum(value);
+}
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void Main(uint3 GId : SV_GroupID, uint3 GTId : SV_GroupThreadID)
+{
+    uint threadIndex = GTId.x;
+    uint first = GId.x * BLOCK_SIZE + threadIndex * ELEMENTS_PER_THREAD;
+    uint value = identity();
+    for (uint i = 0; i < ELEMENTS_PER_THREAD; ++i)
+    {
+        if (first + i < Constants.count)
+        {
+            value = combine(value, Input[Constants.inputOffset + first + i]);
+        }
+    }
+
+    if (use_subgroups())
+    {
+        uint laneCount = WaveGetLaneCount();
+        uint waveCount = GROUP_SIZE / laneCount;
+        value = wave_combine(value);
+        if (WaveIsFirstLane())
+        {
+            GroupScratch[threadIndex / laneCount] = value;
+        }
+        GroupMemoryBarrierWithGroupSync();
+        if (threadIndex < laneCount)
+        {
+            value = wave_combine(threadIndex < waveCount ? GroupScratch[threadIndex] : identity());
+        }
+    }
+    else
+    {
+        GroupScratch[threadIndex] = value;
+        GroupMemoryBarrierWithGroupSync();
+        for (uint stride = GROUP_SIZE / 2; stride > 0; stride >>= 1)
+        {
+            if (threadIndex < stride)
+            {
+                GroupScratch[threadIndex] = combine(GroupScratch[threadIndex], GroupScratch[threadIndex + stride]);
+            }
+            GroupMemoryBarrierWithGroupSync();
+        }
+        value = GroupScratch[0];
+    }
+
+    if (threadIndex == 0)
+    {
+        Output[Constants.outputOffset + GId.x] = value;
+    }
+}
@@ -0,0 +1,110 @@
+// Exclusive prefix sum of uints, one 1024 element block per group, and the scatter of stream compaction. See
+// ComputePrimitives::record_scan() for how the passes combine.
+
+#include "gfx_compute_common.hlsli"
+
+static const uint Pass_ScanBlocks = 0;
+static const uint Pass_AddBlockSums = 1;
+static const uint Pass_CompactScatter = 2;
+
+struct ScanConstants
+{
+    uint count;
+    uint inputOffset;
+    uint outputOffset;
+    uint sumsOffset;
+    uint pass;
+    uint predicate; // Scan 1 for each non-zero input.
+};
+[[vk::push_constant]] ScanConstants Constants;
+
+[[vk::binding(0, 0)]] RWStructuredBuffer<uint> Input;  // Compaction flags in Pass_CompactScatter.
+[[vk::binding(1, 0)]] RWStructuredBuffer<uint> Output; // Scanned compaction flags in Pass_CompactScatter.
+[[vk::binding(2, 0)]] RWStructuredBuffer<uint> Sums;
+[[vk::binding(3, 0)]] RWStructuredBuffer<uint> Values;
+[[vk::binding(4, 0)]] RWStructuredBuffer<uint> Compacted;
+[[vk::binding(5, 0)]] RWStructuredBuffer<uint> CompactCount;
+
+uint load_input(uint index)
+{
+    uint value = Input[Constants.inputOffset + index];
+    return Constants.predicate != 0 ? (value != 0 ? 1 : 0) : value;
+}
+
+void scan_blocks(uint groupIndex, uint threadIndex)
+{
+    uint first = groupIndex * BLOCK_SIZE + threadIndex * ELEMENTS_PER_THREAD;
+    uint prefixes[ELEMENTS_PER_THREAD];
+    uint threadTotal = 0;
+    for (uint i = 0; i < ELEMENTS_PER_THREAD; ++i)
+    {
+        prefixes[i] = threadTotal;
+        threadTotal += first + i < Constants.count ? load_input(first + i) : 0;
+    }
+
+    uint blockTotal;
+    uint threadPrefix = group_exclusive_sum(threadTotal, threadIndex, blockTotal);
+    for (uint j = 0; j < ELEMENTS_PER_THREAD; ++j)
+    {
+        if (first + j < Constants.count)
+        {
+            Output[Constants.outputOffset + first + j] = threadPrefix + prefixes[j];
+        }
+    }
+    if (threadIndex == 0)
+    {
+        Sums[Constants.sumsOffset + groupIndex] = blockTotal;
+    }
+}
+
+void add_block_sums(uint groupIndex, uint threadIndex)
+{
+    uint blockPrefix = Sums[Constants.sumsOffset + groupIndex];
+    uint first = groupIndex * BLOCK_SIZE + threadIndex * ELEMENTS_PER_THREAD;
+    for (uint i = 0; i < ELEMENTS_PER_THREAD; ++i)
+    {
+        if (first + i < Constants.count)
+        {
+            Output[Constants.outputOffset + first + i] += blockPrefix;
+        }
+    }
+}
+
+void compact_scatter(uint groupIndex, uint threadIndex)
+{
+    uint first = groupIndex * BLOCK_SIZE + threadIndex * ELEMENTS_PER_THREAD;
+    for (uint i = 0; i < ELEMENTS_PER_THREAD; ++i)
+    {
+        uint index = first + i;
+        if (index < Constants.count)
+        {
+            uint kept = Input[index] != 0 ? 1 : 0;
+            uint destination = Output[index];
+            if (kept != 0)
+            {
+                Compacted[destination] = Values[index];
+            }
+            if (index == Constants.count - 1)
+            {
+                CompactCount[0] = destination + kept;
+            }
+        }
+    }
+}
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void Main(uint3 GId : SV_GroupID, uint3 GTId : SV_GroupThreadID)
+{
+    if (Constants.pass == Pass_ScanBlocks)
+    {
+        scan_blocks(GId.x, GTId.x);
+    }
+    else if (Constants.pass == Pass_AddBlockSums)
+    {
+        add_block_sums(GId.x, GTId.x);
+    }
+    else
+    {
+        compact_scatter(GId.x, GTId.x);
+    }
+}
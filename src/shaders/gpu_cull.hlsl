@@ -0,0 +1,160 @@
+// Tests each instance's bounding sphere against the view frustum, and optionally against a Hi-Z pyramid from gpu_hi_z.hlsl,
+// appending a DrawIndexedIndirectCommand for each survivor. The order of the draws is not deterministic.
+
+struct CullParams
+{
+    float4x4 viewProjection;
+    float4x4 hiZViewProjection;
+    uint instanceCount;
+    uint hiZWidth;
+    uint hiZHeight;
+    uint hiZLevels;
+    uint flags;
+};
+
+struct Instance
+{
+    float3 center;
+    float radius;
+    uint drawIndex;
+    uint3 padding;
+};
+
+struct Draw
+{
+    uint indexCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint padding;
+};
+
+struct DrawIndexedIndirectCommand
+{
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+static const uint CullFlags_Occlusion = 1u << 0u;
+static const uint CullFlags_ReverseZ = 1u << 1u;
+
+[[vk::binding(0, 0)]] ConstantBuffer<CullParams> Params;
+[[vk::binding(1, 0)]] StructuredBuffer<Instance> Instances;
+[[vk::binding(2, 0)]] StructuredBuffer<Draw> Draws;
+[[vk::binding(3, 0)]] RWStructuredBuffer<DrawIndexedIndirectCommand> DrawCommands;
+[[vk::binding(4, 0)]] RWStructuredBuffer<uint> DrawCount;
+[[vk::binding(5, 0)]] StructuredBuffer<float> HiZ;
+
+bool is_in_frustum(float3 center, float radius)
+{
+    // Planes from the rows of the view projection (Gribb & Hartmann), near being z >= 0 for Vulkan's depth range.
+    float4x4 m = Params.viewProjection;
+    float4 planes[6] = {
+        m[3] + m[0],
+        m[3] - m[0],
+        m[3] + m[1],
+        m[3] - m[1],
+        m[2],
+        m[3] - m[2],
+    };
+    for (uint i = 0; i < 6; ++i)
+    {
+        float4 plane = planes[i] / length(planes[i].xyz);
+        if (dot(plane.xyz, center) + plane.w < -radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint level_offset(uint level, out uint2 levelSize)
+{
+    uint offset = 0;
+    levelSize = uint2(Params.hiZWidth, Params.hiZHeight);
+    for (uint i = 0; i < level; ++i)
+    {
+        offset += levelSize.x * levelSize.y;
+        levelSize = max(uint2(1, 1), (levelSize + 1) / 2);
+    }
+    return offset;
+}
+
+bool is_occluded(float3 center, float radius)
+{
+    bool reverseZ = (Params.flags & CullFlags_ReverseZ) != 0;
+
+    // Screen rectangle and nearest depth of the sphere's bounding box.
+    float2 uvMin = float2(1, 1);
+    float2 uvMax = float2(0, 0);
+    float nearest = reverseZ ? 0.0 : 1.0;
+    for (uint corner = 0; corner < 8; ++corner)
+    {
+        float3 offset = float3((corner & 1) != 0 ? radius : -radius, (corner & 2) != 0 ? radius : -radius, (corner & 4) != 0 ? radius : -radius);
+        float4 clip = mul(Params.hiZViewProjection, float4(center + offset, 1.0));
+        if (clip.w <= 0.0)
+        {
+            return false; // Crosses the camera plane.
+        }
+        float3 ndc = clip.xyz / clip.w;
+        float2 uv = ndc.xy * 0.5 + 0.5;
+        uvMin = min(uvMin, uv);
+        uvMax = max(uvMax, uv);
+        nearest = reverseZ ? max(nearest, ndc.z) : min(nearest, ndc.z);
+    }
+    uvMin = saturate(uvMin);
+    uvMax = saturate(uvMax);
+
+    // The level where the rectangle spans at most 2x2 texels, of which the farthest depth bounds everything behind them.
+    float2 extent = (uvMax - uvMin) * float2(Params.hiZWidth, Params.hiZHeight);
+    uint level = min(uint(ceil(log2(max(max(extent.x, extent.y), 1.0)))), Params.hiZLevels - 1);
+    uint2 levelSize;
+    uint offset = level_offset(level, levelSize);
+    uint2 texelMin = min(uint2(uvMin * float2(levelSize)), levelSize - 1);
+    uint2 texelMax = min(uint2(uvMax * float2(levelSize)), levelSize - 1);
+
+    float farthest = HiZ[offset + texelMin.y * levelSize.x + texelMin.x];
+    for (uint y = texelMin.y; y <= texelMax.y; ++y)
+    {
+        for (uint x = texelMin.x; x <= texelMax.x; ++x)
+        {
+            float depth = HiZ[offset + y * levelSize.x + x];
+            farthest = reverseZ ? min(farthest, depth) : max(farthest, depth);
+        }
+    }
+    return reverseZ ? nearest < farthest : nearest > farthest;
+}
+
+[numthreads(64, 1, 1)]
+void Main(uint3 DTId : SV_DispatchThreadID)
+{
+    uint instanceIndex = DTId.x;
+    if (instanceIndex >= Params.instanceCount)
+    {
+        return;
+    }
+
+    Instance instance = Instances[instanceIndex];
+    if (!is_in_frustum(instance.center, instance.radius))
+    {
+        return;
+    }
+    if ((Params.flags & CullFlags_Occlusion) != 0 && is_occluded(instance.center, instance.radius))
+    {
+        return;
+    }
+
+    Draw draw = Draws[instance.drawIndex];
+    uint drawIndex;
+    InterlockedAdd(DrawCount[0], 1, drawIndex);
+
+    DrawIndexedIndirectCommand command;
+    command.indexCount = draw.indexCount;
+    command.instanceCount = 1;
+    command.firstIndex = draw.firstIndex;
+    command.vertexOffset = draw.vertexOffset;
+    command.firstInstance = instanceIndex;
+    DrawCommands[drawIndex] = command;
+}
@@ -0,0 +1,57 @@
+// Reduces a depth buffer into a pyramid of the farthest depth of each 2x2 block, one level per dispatch, into a buffer of
+// floats holding the levels one after another. Sizes are halved rounding up, so with odd sizes the last row or column of a
+// level covers a single row or column of the one below.
+
+struct HiZConstants
+{
+    uint srcWidth;
+    uint srcHeight;
+    uint srcOffset;
+    uint dstWidth;
+    uint dstHeight;
+    uint dstOffset;
+    uint fromTexture;
+    uint reverseZ;
+};
+[[vk::push_constant]] HiZConstants Constants;
+
+[[vk::combinedImageSampler]] [[vk::binding(0, 0)]] Texture2D<float> DepthTexture;
+[[vk::combinedImageSampler]] [[vk::binding(0, 0)]] SamplerState DepthSampler;
+[[vk::binding(1, 0)]] RWStructuredBuffer<float> HiZ;
+
+float read_src(uint2 texel)
+{
+    if (Constants.fromTexture != 0)
+    {
+        float2 uv = (float2(texel) + 0.5) / float2(Constants.srcWidth, Constants.srcHeight);
+        return DepthTexture.SampleLevel(DepthSampler, uv, 0);
+    }
+    return HiZ[Constants.srcOffset + texel.y * Constants.srcWidth + texel.x];
+}
+
+float farthest(float a, float b)
+{
+    return Constants.reverseZ != 0 ? min(a, b) : max(a, b);
+}
+
+[numthreads(8, 8, 1)]
+void Main(uint3 DTId : SV_DispatchThreadID)
+{
+    if (DTId.x >= Constants.dstWidth || DTId.y >= Constants.dstHeight)
+    {
+        return;
+    }
+
+    uint2 first = DTId.xy * 2;
+    uint2 last = min(first + 1, uint2(Constants.srcWidth, Constants.srcHeight) - 1);
+
+    float depth = read_src(first);
+    for (uint y = first.y; y <= last.y; ++y)
+    {
+        for (uint x = first.x; x <= last.x; ++x)
+        {
+            depth = farthest(depth, read_src(uint2(x, y)));
+        }
+    }
+    HiZ[Constants.dstOffset + DTId.y * Constants.dstWidth + DTId.x] = depth;
+}
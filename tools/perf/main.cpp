@@ -0,0 +1,700 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Headless performance regression runner. Runs the Google Benchmark benchmarks (see benchmarks/) as child processes, then
+// its own stress scenes on a headless device, and writes every result as one flat JSON object of metrics, lower being
+// better for all of them:
+// - <benchmark>.<name>.real_ns / cpu_ns:             time per iteration.
+// - scene.<scene>.cpu_ms.p50 / p95:                  CPU time recording and submitting a frame.
+// - scene.<scene>.gpu_ms.p50 / p95:                  GPU time of the frame, from a GPU scope around it.
+// - scene.<scene>.peak_device_local_bytes:           process usage of the device local heaps, see get_memory_stats().
+// - scene.<scene>.peak_resource_bytes:               live buffers and textures.
+// - scene.<scene>.frame.<counter>:                   get_frame_stats() per frame, with the gfx_ENABLE_FRAME_STATS option.
+// Given a baseline written by an earlier run, metrics that grew by more than their threshold are reported as regressions
+// and the exit code is non-zero. Timings are noisy so get a relative threshold, memory and counters are deterministic so any
+// growth past theirs (0 by default) counts.
+// Usage: gfx_perf [--out gfx_perf.json] [--baseline <file>] [--threshold 0.1] [--counter-threshold 0] [--frames 300]
+//                 [--bench-dir <dir>] [--scenes-only]
+
+using namespace sm;
+
+namespace
+{
+	constexpr std::uint32_t GRAPHICS_QUEUE = 0;
+	constexpr std::uint32_t WARMUP_FRAMES = 10; // Left out of the timings, while pools and caches fill.
+	constexpr std::uint32_t FRAMES_IN_FLIGHT = 2;
+	constexpr std::uint32_t TARGET_SIZE = 256;
+
+	// The Google Benchmark executables, the pipeline creation benchmark prints its own text report so is not run.
+	constexpr std::array BENCHMARK_NAMES{ "gfx_bench", "gfx_bench_upload", "gfx_bench_compute", "gfx_bench_render_graph", "gfx_bench_descriptors" };
+
+	using Metrics = std::map<std::string, double>;
+
+	struct Options
+	{
+		std::string outPath{ "gfx_perf.json" };
+		std::string baselinePath{};
+		double threshold{ 0.1 };
+		double counterThreshold{ 0.0 };
+		std::uint32_t frameCount{ 300 };
+		std::filesystem::path benchDir{ GFX_PERF_BENCH_DIR };
+		bool scenesOnly{ false };
+	};
+
+	bool parse_options(Options& outOptions, int argc, char** argv)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string_view arg{ argv[i] };
+			const bool hasValue = i + 1 < argc;
+			if (arg == "--scenes-only")
+			{
+				outOptions.scenesOnly = true;
+			}
+			else if (arg == "--out" && hasValue)
+			{
+				outOptions.outPath = argv[++i];
+			}
+			else if (arg == "--baseline" && hasValue)
+			{
+				outOptions.baselinePath = argv[++i];
+			}
+			else if (arg == "--threshold" && hasValue)
+			{
+				outOptions.threshold = std::atof(argv[++i]);
+			}
+			else if (arg == "--counter-threshold" && hasValue)
+			{
+				outOptions.counterThreshold = std::atof(argv[++i]);
+			}
+			else if (arg == "--frames" && hasValue)
+			{
+				outOptions.frameCount = std::max(WARMUP_FRAMES + 1, std::uint32_t(std::max(0, std::atoi(argv[++i]))));
+			}
+			else if (arg == "--bench-dir" && hasValue)
+			{
+				outOptions.benchDir = argv[++i];
+			}
+			else
+			{
+				std::cout << "Usage: gfx_perf [--out gfx_perf.json] [--baseline <file>] [--threshold 0.1] [--counter-threshold 0]"
+							 " [--frames 300] [--bench-dir <dir>] [--scenes-only]"
+						  << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	auto read_shader_file(const char* filename) -> std::vector<std::uint32_t>
+	{
+		if (std::ifstream file{ filename, std::ios::binary | std::ios::ate })
+		{
+			const std::streamsize fileSize = file.tellg();
+			file.seekg(0);
+			std::vector<std::uint32_t> shaderBinary(fileSize / sizeof(std::uint32_t));
+			file.read(reinterpret_cast<char*>(shaderBinary.data()), fileSize);
+			return shaderBinary;
+		}
+
+		GFX_LOG_ERR_FMT("gfx_perf - Failed to read shader file: {}", filename);
+		return {};
+	}
+
+#pragma region JSON
+
+	/**
+	 * @brief Read a "key": value pair from a line of pretty-printed JSON, as Google Benchmark and write_metrics() write it.
+	 * @return False if the line holds no such pair. String values are returned without their quotes.
+	 */
+	bool parse_json_line(const std::string& line, std::string& outKey, std::string& outValue)
+	{
+		const auto keyBegin = line.find('"');
+		const auto keyEnd = keyBegin == std::string::npos ? std::string::npos : line.find('"', keyBegin + 1);
+		const auto colon = keyEnd == std::string::npos ? std::string::npos : line.find(':', keyEnd);
+		if (colon == std::string::npos)
+		{
+			return false;
+		}
+		outKey = line.substr(keyBegin + 1, keyEnd - keyBegin - 1);
+
+		auto valueBegin = line.find_first_not_of(" \t", colon + 1);
+		auto valueEnd = line.find_last_not_of(" \t\r,");
+		if (valueBegin == std::string::npos || valueEnd < valueBegin)
+		{
+			return false;
+		}
+		if (line[valueBegin] == '"' && line[valueEnd] == '"' && valueEnd > valueBegin)
+		{
+			++valueBegin;
+			--valueEnd;
+		}
+		outValue = line.substr(valueBegin, valueEnd + 1 - valueBegin);
+		return true;
+	}
+
+	bool read_metrics(Metrics& outMetrics, const std::string& path)
+	{
+		std::ifstream file{ path };
+		if (!file)
+		{
+			GFX_LOG_ERR_FMT("gfx_perf - Failed to read baseline: {}", path);
+			return false;
+		}
+
+		bool inMetrics{ false };
+		std::string line{};
+		std::string key{};
+		std::string value{};
+		while (std::getline(file, line))
+		{
+			if (!inMetrics)
+			{
+				inMetrics = line.find("\"metrics\"") != std::string::npos;
+			}
+			else if (line.find('}') != std::string::npos)
+			{
+				break;
+			}
+			else if (parse_json_line(line, key, value))
+			{
+				outMetrics[key] = std::atof(value.c_str());
+			}
+		}
+		return inMetrics;
+	}
+
+	bool write_metrics(const Metrics& metrics, const Options& options)
+	{
+		std::ofstream file{ options.outPath };
+		if (!file)
+		{
+			GFX_LOG_ERR_FMT("gfx_perf - Failed to write results: {}", options.outPath);
+			return false;
+		}
+
+		file << std::setprecision(10);
+		file << "{\n";
+		file << "  \"version\": 1,\n";
+		file << "  \"frames\": " << options.frameCount << ",\n";
+		file << "  \"metrics\": {\n";
+		std::size_t written{ 0 };
+		for (const auto& [name, value] : metrics)
+		{
+			file << "    \"" << name << "\": " << value << (++written < metrics.size() ? ",\n" : "\n");
+		}
+		file << "  }\n";
+		file << "}\n";
+		return true;
+	}
+
+#pragma endregion
+
+#pragma region Benchmarks
+
+	/**
+	 * @brief Run a Google Benchmark executable from its own directory, where it finds its shaders, and add the time per
+	 * iteration of each of its benchmarks.
+	 */
+	void run_benchmark(Metrics& metrics, const std::filesystem::path& relativeBenchDir, const char* benchName)
+	{
+		const auto benchDir = std::filesystem::absolute(relativeBenchDir);
+		const auto executablePath = benchDir / benchName;
+		if (!std::filesystem::exists(executablePath) && !std::filesystem::exists(std::filesystem::path(executablePath).replace_extension(".exe")))
+		{
+			std::cout << "gfx_perf - Skipping " << benchName << ", not found in " << benchDir.string() << std::endl;
+			return;
+		}
+
+		const auto outPath = std::string("gfx_perf_") + benchName + ".json";
+		const auto command = "\"" + executablePath.string() + "\" --benchmark_out=" + outPath + " --benchmark_out_format=json";
+		std::error_code error{};
+		const auto workingDir = std::filesystem::current_path();
+		std::filesystem::current_path(benchDir, error);
+		const int exitCode = error ? -1 : std::system(command.c_str());
+		std::ifstream file{ benchDir / outPath };
+		std::filesystem::current_path(workingDir, error);
+		if (exitCode != 0 || !file)
+		{
+			std::cout << "gfx_perf - " << benchName << " failed" << std::endl;
+			return;
+		}
+
+		// Each benchmark's fields follow its "name", the time_unit after the times.
+		std::string line{};
+		std::string key{};
+		std::string value{};
+		std::string name{};
+		double realTime{ 0.0 };
+		double cpuTime{ 0.0 };
+		while (std::getline(file, line))
+		{
+			if (!parse_json_line(line, key, value))
+			{
+				continue;
+			}
+			if (key == "name")
+			{
+				name = value;
+			}
+			else if (key == "real_time")
+			{
+				realTime = std::atof(value.c_str());
+			}
+			else if (key == "cpu_time")
+			{
+				cpuTime = std::atof(value.c_str());
+			}
+			else if (key == "time_unit" && !name.empty())
+			{
+				const double toNs = value == "s" ? 1e9 : value == "ms" ? 1e6 : value == "us" ? 1e3 : 1.0;
+				const auto prefix = std::string(benchName) + "." + name;
+				metrics[prefix + ".real_ns"] = realTime * toNs;
+				metrics[prefix + ".cpu_ns"] = cpuTime * toNs;
+				name.clear();
+			}
+		}
+		file.close();
+		std::filesystem::remove(benchDir / outPath, error);
+	}
+
+#pragma endregion
+
+#pragma region SCENES
+
+	struct SceneContext
+	{
+		gfx::DeviceHandle device{};
+		gfx::PipelineHandle pipeline{};
+		std::array<gfx::DescriptorSetHandle, 2> descriptorSets{};
+		std::array<gfx::BufferHandle, 2> buffers{};
+		std::array<gfx::BufferHandle, FRAMES_IN_FLIGHT> stagingBuffers{}; // By frame, so a frame never writes one the GPU reads.
+		gfx::TextureHandle renderTarget{};
+	} s_scene{};
+
+	// Every scene creates what it needs, records one frame of work into a command list and destroys it all again, so its
+	// memory peak is its own.
+	struct Scene
+	{
+		const char* name;
+		bool (*create)();
+		void (*record)(gfx::CommandListHandle commandListHandle, std::uint32_t frame);
+	};
+
+	void destroy_scene()
+	{
+		gfx::wait_for_device_idle(s_scene.device);
+		for (auto& descriptorSetHandle : s_scene.descriptorSets)
+		{
+			if (std::uint64_t(descriptorSetHandle) != 0)
+			{
+				gfx::destroy_descriptor_set(descriptorSetHandle);
+			}
+		}
+		for (auto* bufferHandles : { &s_scene.buffers, &s_scene.stagingBuffers })
+		{
+			for (auto& bufferHandle : *bufferHandles)
+			{
+				if (std::uint64_t(bufferHandle) != 0)
+				{
+					gfx::destroy_buffer(bufferHandle);
+				}
+			}
+		}
+		if (std::uint64_t(s_scene.renderTarget) != 0)
+		{
+			gfx::destroy_texture(s_scene.renderTarget);
+		}
+		if (std::uint64_t(s_scene.pipeline) != 0)
+		{
+			gfx::destroy_pipeline(s_scene.pipeline);
+		}
+		s_scene = { .device = s_scene.device };
+	}
+
+	// Draw-call bound: DRAW_COUNT small draws in one render pass, each with its own constants.
+	constexpr std::uint32_t DRAW_COUNT = 20000;
+
+	bool create_draws_scene()
+	{
+		gfx::GraphicsPipelineInfo pipelineInfo{
+			.vertexCode = read_shader_file("bench.vert.spv"),
+			.fragmentCode = read_shader_file("bench.frag.spv"),
+			.descriptorSets = {
+				gfx::DescriptorSetInfo{ .bindings = {
+											{ gfx::DescriptorType::eUniformBuffer, 1, gfx::ShaderStageFlags_Vertex },
+										} },
+			},
+			.constantBlock = { sizeof(float) * 4, gfx::ShaderStageFlags_Vertex },
+			.depthTest = false,
+			.colorAttachments = { gfx::Format::eRGBA8 },
+			.debugName = "gfx_perf",
+		};
+		if (!gfx::create_graphics_pipeline(s_scene.pipeline, s_scene.device, pipelineInfo))
+		{
+			return false;
+		}
+		if (!gfx::create_buffer(s_scene.buffers[0], s_scene.device, { .type = gfx::BufferType::eUniform, .size = sizeof(float) * 4 }))
+		{
+			return false;
+		}
+		if (!gfx::create_descriptor_set(s_scene.descriptorSets[0], s_scene.device, pipelineInfo.descriptorSets[0]))
+		{
+			return false;
+		}
+		gfx::bind_buffer_to_descriptor_set(s_scene.descriptorSets[0], 0, s_scene.buffers[0]);
+
+		gfx::TextureInfo renderTargetInfo{
+			.usage = gfx::TextureUsage::eColorAttachment,
+			.type = gfx::TextureType::e2D,
+			.width = TARGET_SIZE,
+			.height = TARGET_SIZE,
+			.format = gfx::Format::eRGBA8,
+		};
+		return gfx::create_texture(s_scene.renderTarget, s_scene.device, renderTargetInfo);
+	}
+
+	void record_draws_scene(gfx::CommandListHandle commandListHandle, std::uint32_t)
+	{
+		gfx::transition_texture(commandListHandle, s_scene.renderTarget, gfx::TextureState::eRenderTarget);
+		gfx::begin_render_pass(commandListHandle, { .colorAttachments = { s_scene.renderTarget } });
+		gfx::set_viewport(commandListHandle, 0, 0, TARGET_SIZE, TARGET_SIZE);
+		gfx::set_scissor(commandListHandle, 0, 0, TARGET_SIZE, TARGET_SIZE);
+		gfx::bind_pipeline(commandListHandle, s_scene.pipeline);
+		gfx::bind_descriptor_sets(commandListHandle, 0, { &s_scene.descriptorSets[0], 1 });
+		for (std::uint32_t i = 0; i < DRAW_COUNT; ++i)
+		{
+			const std::array<float, 4> offset{ float(i % 100) / 100.0f - 0.5f, float(i / 100 % 100) / 100.0f - 0.5f, 0.0f, 0.0f };
+			gfx::set_constants(commandListHandle, gfx::ShaderStageFlags_Vertex, 0, sizeof(offset), offset.data());
+			gfx::draw(commandListHandle, 3, 1, 0, 0);
+		}
+		gfx::end_render_pass(commandListHandle);
+	}
+
+	// Barrier bound: DISPATCH_COUNT small dispatches, each reading what the one before wrote.
+	constexpr std::uint32_t DISPATCH_COUNT = 1024;
+	constexpr std::uint32_t ELEMENT_COUNT = 64;
+
+	bool create_dispatches_scene()
+	{
+		gfx::ComputePipelineInfo pipelineInfo{
+			.shaderCode = read_shader_file("compute.spv"),
+			.descriptorSets = {
+				gfx::DescriptorSetInfo{ .bindings = {
+											{ gfx::DescriptorType::eStorageBuffer, 1, gfx::ShaderStageFlags_Compute },
+											{ gfx::DescriptorType::eStorageBuffer, 1, gfx::ShaderStageFlags_Compute },
+										} },
+			},
+		};
+		if (!gfx::create_compute_pipeline(s_scene.pipeline, s_scene.device, pipelineInfo))
+		{
+			return false;
+		}
+		for (auto& bufferHandle : s_scene.buffers)
+		{
+			if (!gfx::create_buffer(bufferHandle, s_scene.device, { .type = gfx::BufferType::eStorage, .size = sizeof(std::int32_t) * ELEMENT_COUNT, .memory = gfx::BufferMemory::eGpuOnly }))
+			{
+				return false;
+			}
+		}
+		for (std::uint32_t i = 0; i < 2; ++i)
+		{
+			if (!gfx::create_descriptor_set_from_pipeline(s_scene.descriptorSets[i], s_scene.pipeline, 0))
+			{
+				return false;
+			}
+			gfx::bind_buffer_to_descriptor_set(s_scene.descriptorSets[i], 0, s_scene.buffers[i]);
+			gfx::bind_buffer_to_descriptor_set(s_scene.descriptorSets[i], 1, s_scene.buffers[1 - i]);
+		}
+		return true;
+	}
+
+	void record_dispatches_scene(gfx::CommandListHandle commandListHandle, std::uint32_t)
+	{
+		gfx::bind_pipeline(commandListHandle, s_scene.pipeline);
+		for (std::uint32_t i = 0; i < DISPATCH_COUNT; ++i)
+		{
+			if (i != 0)
+			{
+				gfx::buffer_barrier(commandListHandle, s_scene.buffers[i % 2], gfx::PipelineStageFlags_ComputeShader, gfx::PipelineStageFlags_ComputeShader);
+			}
+			gfx::bind_descriptor_sets(commandListHandle, 0, { &s_scene.descriptorSets[i % 2], 1 });
+			gfx::dispatch(commandListHandle, ELEMENT_COUNT, 1, 1);
+		}
+	}
+
+	// Bandwidth bound: UPLOAD_BYTES written to a staging buffer and copied to device local memory every frame.
+	constexpr std::uint64_t UPLOAD_BYTES = 16ull * 1024 * 1024;
+	std::vector<std::byte> s_uploadData{};
+
+	bool create_uploads_scene()
+	{
+		s_uploadData.assign(UPLOAD_BYTES, std::byte{ 0x5a });
+		for (auto& bufferHandle : s_scene.stagingBuffers)
+		{
+			if (!gfx::create_buffer(bufferHandle, s_scene.device, { .type = gfx::BufferType::eUpload, .size = UPLOAD_BYTES, .memory = gfx::BufferMemory::eUpload }))
+			{
+				return false;
+			}
+		}
+		return gfx::create_buffer(s_scene.buffers[0], s_scene.device, { .type = gfx::BufferType::eStorage, .size = UPLOAD_BYTES, .memory = gfx::BufferMemory::eGpuOnly });
+	}
+
+	void record_uploads_scene(gfx::CommandListHandle commandListHandle, std::uint32_t frame)
+	{
+		const auto stagingBufferHandle = s_scene.stagingBuffers[frame % FRAMES_IN_FLIGHT];
+		std::memcpy(gfx::get_mapped_pointer(stagingBufferHandle), s_uploadData.data(), UPLOAD_BYTES);
+		gfx::flush_buffer_range(stagingBufferHandle);
+
+		const gfx::BufferCopyRegion region{ .size = UPLOAD_BYTES };
+		gfx::copy_buffer(commandListHandle, stagingBufferHandle, s_scene.buffers[0], { &region, 1 });
+	}
+
+	constexpr std::array SCENES{
+		Scene{ "draws", create_draws_scene, record_draws_scene },
+		Scene{ "dispatches", create_dispatches_scene, record_dispatches_scene },
+		Scene{ "uploads", create_uploads_scene, record_uploads_scene },
+	};
+
+	/**
+	 * @return The value at fraction (0 to 1) through the sorted samples.
+	 */
+	auto percentile(std::vector<double> samples, double fraction) -> double
+	{
+		if (samples.empty())
+		{
+			return 0.0;
+		}
+		std::ranges::sort(samples);
+		return samples[std::min(samples.size() - 1, std::size_t(fraction * double(samples.size())))];
+	}
+
+	bool run_scene(Metrics& metrics, const Scene& scene, std::uint32_t frameCount)
+	{
+		if (!scene.create())
+		{
+			std::cout << "gfx_perf - Failed to create scene " << scene.name << std::endl;
+			destroy_scene();
+			return false;
+		}
+
+		std::vector<double> cpuFrameMs{};
+		std::vector<double> gpuFrameMs{};
+		std::uint64_t peakDeviceLocalBytes{ 0 };
+		std::uint64_t peakResourceBytes{ 0 };
+		gfx::FrameStats frameStatTotals{};
+		std::uint32_t frameStatCount{ 0 };
+		std::uint32_t lastGpuFrame{ 0 };
+		bool failed{ false };
+		for (std::uint32_t frame = 0; frame < frameCount && !failed; ++frame)
+		{
+			gfx::begin_frame(s_scene.device);
+
+			// Only the latest resolved frame can be read, so not every frame's GPU time is sampled.
+			gfx::GpuScopeTimings gpuTimings{};
+			if (gfx::get_gpu_scope_timings(gpuTimings, s_scene.device) && gpuTimings.frameNumber != lastGpuFrame && gpuTimings.frameNumber > WARMUP_FRAMES)
+			{
+				lastGpuFrame = gpuTimings.frameNumber;
+				for (const auto& gpuScope : gpuTimings.scopes)
+				{
+					if (gpuScope.depth == 0 && gpuScope.name == scene.name)
+					{
+						gpuFrameMs.push_back(double(gpuScope.endNs - gpuScope.beginNs) / 1'000'000.0);
+					}
+				}
+			}
+			gfx::FrameStats frameStats{};
+			if (frame > WARMUP_FRAMES && gfx::get_frame_stats(frameStats, s_scene.device))
+			{
+				frameStatTotals.draws += frameStats.draws;
+				frameStatTotals.dispatches += frameStats.dispatches;
+				frameStatTotals.pipelineBinds += frameStats.pipelineBinds;
+				frameStatTotals.descriptorBinds += frameStats.descriptorBinds;
+				frameStatTotals.barriers += frameStats.barriers;
+				frameStatTotals.submits += frameStats.submits;
+				frameStatTotals.descriptorWrites += frameStats.descriptorWrites;
+				frameStatTotals.uploadBytes += frameStats.uploadBytes;
+				frameStatTotals.resourcesCreated += frameStats.resourcesCreated;
+				++frameStatCount;
+			}
+			gfx::MemoryStats memoryStats{};
+			if (gfx::get_memory_stats(memoryStats, s_scene.device))
+			{
+				std::uint64_t deviceLocalBytes{ 0 };
+				for (const auto& heap : memoryStats.heaps)
+				{
+					deviceLocalBytes += heap.deviceLocal ? heap.usage : 0;
+				}
+				peakDeviceLocalBytes = std::max(peakDeviceLocalBytes, deviceLocalBytes);
+				peakResourceBytes = std::max(peakResourceBytes, memoryStats.bufferBytes + memoryStats.textureBytes);
+			}
+
+			const auto start = std::chrono::steady_clock::now();
+			gfx::CommandListHandle commandListHandle{};
+			if (!gfx::create_transient_command_list(commandListHandle, s_scene.device, GRAPHICS_QUEUE) || !gfx::begin(commandListHandle))
+			{
+				failed = true;
+			}
+			else
+			{
+				gfx::begin_gpu_scope(commandListHandle, scene.name);
+				scene.record(commandListHandle, frame);
+				gfx::end_gpu_scope(commandListHandle);
+				gfx::end(commandListHandle);
+				gfx::submit_command_list({ .commandList = commandListHandle });
+				if (frame >= WARMUP_FRAMES)
+				{
+					cpuFrameMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+				}
+			}
+
+			gfx::end_frame(s_scene.device);
+		}
+		destroy_scene();
+		if (failed)
+		{
+			std::cout << "gfx_perf - Failed to record scene " << scene.name << std::endl;
+			return false;
+		}
+
+		const auto prefix = std::string("scene.") + scene.name;
+		metrics[prefix + ".cpu_ms.p50"] = percentile(cpuFrameMs, 0.5);
+		metrics[prefix + ".cpu_ms.p95"] = percentile(cpuFrameMs, 0.95);
+		if (!gpuFrameMs.empty())
+		{
+			metrics[prefix + ".gpu_ms.p50"] = percentile(gpuFrameMs, 0.5);
+			metrics[prefix + ".gpu_ms.p95"] = percentile(gpuFrameMs, 0.95);
+		}
+		metrics[prefix + ".peak_device_local_bytes"] = double(peakDeviceLocalBytes);
+		metrics[prefix + ".peak_resource_bytes"] = double(peakResourceBytes);
+		if (frameStatCount != 0)
+		{
+			const auto perFrame = [&](std::uint64_t total) { return double(total) / double(frameStatCount); };
+			metrics[prefix + ".frame.draws"] = perFrame(frameStatTotals.draws);
+			metrics[prefix + ".frame.dispatches"] = perFrame(frameStatTotals.dispatches);
+			metrics[prefix + ".frame.pipeline_binds"] = perFrame(frameStatTotals.pipelineBinds);
+			metrics[prefix + ".frame.descriptor_binds"] = perFrame(frameStatTotals.descriptorBinds);
+			metrics[prefix + ".frame.barriers"] = perFrame(frameStatTotals.barriers);
+			metrics[prefix + ".frame.submits"] = perFrame(frameStatTotals.submits);
+			metrics[prefix + ".frame.descriptor_writes"] = perFrame(frameStatTotals.descriptorWrites);
+			metrics[prefix + ".frame.upload_bytes"] = perFrame(frameStatTotals.uploadBytes);
+			metrics[prefix + ".frame.resources_created"] = perFrame(frameStatTotals.resourcesCreated);
+		}
+		std::cout << "gfx_perf - " << scene.name << ": " << metrics[prefix + ".cpu_ms.p50"] << " CPU ms/frame (p50)" << std::endl;
+		return true;
+	}
+
+#pragma endregion
+
+	/**
+	 * @return The number of metrics that grew past their threshold over the baseline.
+	 */
+	auto compare_to_baseline(const Metrics& metrics, const Metrics& baseline, const Options& options) -> std::uint32_t
+	{
+		std::uint32_t regressionCount{ 0 };
+		for (const auto& [name, baseValue] : baseline)
+		{
+			const auto it = metrics.find(name);
+			if (it == metrics.end())
+			{
+				std::cout << "MISSING     " << name << std::endl;
+				continue;
+			}
+
+			const bool isTiming = name.ends_with("_ns") || name.find("_ms.") != std::string::npos;
+			const auto threshold = isTiming ? options.threshold : options.counterThreshold;
+			const auto value = it->second;
+			const auto change = baseValue != 0.0 ? (value - baseValue) / baseValue : (value != 0.0 ? 1.0 : 0.0);
+			const char* verdict = change > threshold ? "REGRESSION  " : change < -threshold ? "IMPROVEMENT " : nullptr;
+			if (verdict != nullptr)
+			{
+				std::cout << verdict << name << ": " << baseValue << " -> " << value << " (" << std::showpos << std::fixed << std::setprecision(1)
+						  << change * 100.0 << "%)" << std::noshowpos << std::defaultfloat << std::setprecision(6) << std::endl;
+			}
+			regressionCount += change > threshold ? 1 : 0;
+		}
+		return regressionCount;
+	}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	Options options{};
+	if (!parse_options(options, argc, argv))
+	{
+		return EXIT_FAILURE;
+	}
+
+	Metrics baseline{};
+	if (!options.baselinePath.empty() && !read_metrics(baseline, options.baselinePath))
+	{
+		return EXIT_FAILURE;
+	}
+
+	Metrics metrics{};
+	if (!options.scenesOnly)
+	{
+		// Before this process creates its device, so the benchmarks have the GPU to themselves.
+		for (const auto* benchName : BENCHMARK_NAMES)
+		{
+			run_benchmark(metrics, options.benchDir, benchName);
+		}
+	}
+
+	gfx::set_error_callback([](const char* msg) { GFX_LOG_ERR(msg); });
+
+	gfx::AppInfo appInfo{ .appName = "gfx_perf", .headless = true, .debugLevel = gfx::DebugLevel::eOff };
+	if (!gfx::initialise(appInfo))
+	{
+		return EXIT_FAILURE;
+	}
+
+	gfx::DeviceInfo deviceInfo{
+		.deviceFlags = gfx::DeviceFlags_PreferDiscrete,
+		.queueFlags = { gfx::QueueFlags_Graphics },
+		.framesInFlight = FRAMES_IN_FLIGHT,
+		.gpuScopesPerFrame = 4,
+	};
+	bool scenesRan{ false };
+	if (gfx::create_device(s_scene.device, deviceInfo))
+	{
+		scenesRan = true;
+		for (const auto& scene : SCENES)
+		{
+			scenesRan = run_scene(metrics, scene, options.frameCount) && scenesRan;
+		}
+		gfx::destroy_device(s_scene.device);
+	}
+	gfx::shutdown();
+
+	if (!write_metrics(metrics, options) || !scenesRan)
+	{
+		return EXIT_FAILURE;
+	}
+	std::cout << "gfx_perf - Wrote " << metrics.size() << " metrics to " << options.outPath << std::endl;
+
+	if (!options.baselinePath.empty())
+	{
+		const auto regressionCount = compare_to_baseline(metrics, baseline, options);
+		std::cout << "gfx_perf - " << regressionCount << " regressions against " << options.baselinePath << std::endl;
+		return regressionCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) Stuart Millman 2023.
+ */
+
+#include "gfx/gfx.hpp"
+#include "gfx/gfx_capture.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace sm;
+
+struct Timings
+{
+	double min{ 0.0 };
+	double avg{ 0.0 };
+	double max{ 0.0 };
+};
+
+auto summarise(const std::vector<double>& samples) -> Timings
+{
+	if (samples.empty())
+	{
+		return {};
+	}
+
+	Timings timings{ samples.front(), 0.0, samples.front() };
+	for (const auto sample : samples)
+	{
+		timings.min = std::min(timings.min, sample);
+		timings.max = std::max(timings.max, sample);
+		timings.avg += sample;
+	}
+	timings.avg /= double(samples.size());
+	return timings;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cout << "Usage: gfx_replay <capture> [loops=100]" << std::endl;
+		return EXIT_FAILURE;
+	}
+	const std::uint32_t loopCount = argc > 2 ? std::max(1, std::atoi(argv[2])) : 100;
+
+	gfx::set_error_callback([](const char* msg) { GFX_LOG_ERR(msg); });
+
+	gfx::CaptureReplay replay{};
+	if (!replay.open(argv[1]))
+	{
+		return EXIT_FAILURE;
+	}
+
+	gfx::AppInfo appInfo{ .appName = "gfx_replay", .headless = true, .debugLevel = gfx::DebugLevel::eOff };
+	if (!gfx::initialise(appInfo))
+	{
+		return EXIT_FAILURE;
+	}
+
+	auto deviceInfo = replay.get_device_info();
+	deviceInfo.gpuScopesPerFrame = std::max(deviceInfo.gpuScopesPerFrame, 256u);
+	gfx::DeviceHandle deviceHandle{};
+	if (!gfx::create_device(deviceHandle, deviceInfo))
+	{
+		gfx::shutdown();
+		return EXIT_FAILURE;
+	}
+
+	if (!replay.create_resources(deviceHandle, true))
+	{
+		gfx::destroy_device(deviceHandle);
+		gfx::shutdown();
+		return EXIT_FAILURE;
+	}
+
+	std::vector<double> cpuLoopMs{};
+	std::vector<double> gpuFrameMs{};
+	std::uint32_t lastGpuFrame{ 0 };
+	for (std::uint32_t i = 0; i < loopCount; ++i)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		if (!replay.replay_frames())
+		{
+			break;
+		}
+		cpuLoopMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+		// Only the latest resolved frame can be read, so not every replayed frame is sampled.
+		gfx::GpuScopeTimings gpuTimings{};
+		if (gfx::get_gpu_scope_timings(gpuTimings, deviceHandle) && gpuTimings.frameNumber != lastGpuFrame && !gpuTimings.scopes.empty())
+		{
+			lastGpuFrame = gpuTimings.frameNumber;
+			std::uint64_t frameNs{ 0 };
+			for (const auto& scope : gpuTimings.scopes)
+			{
+				if (scope.depth == 0 && scope.name == "gfx_replay")
+				{
+					frameNs += scope.endNs - scope.beginNs;
+				}
+			}
+			gpuFrameMs.push_back(double(frameNs) / 1'000'000.0);
+		}
+	}
+
+	const auto cpu = summarise(cpuLoopMs);
+	const auto gpu = summarise(gpuFrameMs);
+	std::cout << "Replayed " << cpuLoopMs.size() << " loops of " << replay.get_frame_count() << " frames" << std::endl;
+	std::cout << "CPU per loop (ms):  min " << cpu.min << "  avg " << cpu.avg << "  max " << cpu.max << std::endl;
+	std::cout << "GPU per frame (ms): min " << gpu.min << "  avg " << gpu.avg << "  max " << gpu.max << "  (" << gpuFrameMs.size() << " frames sampled)" << std::endl;
+
+	replay.destroy_resources();
+	gfx::destroy_device(deviceHandle);
+	gfx::shutdown();
+
+	return EXIT_SUCCESS;
+}